@@ -4,6 +4,7 @@
 #include <functional>
 #include <thread>
 
+#include "coop/chan/batcher.h"
 #include "coop/chan/channel.h"
 #include "coop/chan/passage.h"
 #include "coop/context.h"
@@ -272,6 +273,60 @@ static void BM_Channel_SendAll_Drain(benchmark::State& state)
 }
 BENCHMARK(BM_Channel_SendAll_Drain)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(64);
 
+// ---------------------------------------------------------------------------
+// BM_Channel_SendBatch_RecvBatch — the same curve through the span batch API
+// ---------------------------------------------------------------------------
+//
+// SendBatch fills whatever room the buffer has and wakes the consumer once;
+// RecvBatch blocks for the first item and takes the rest in the same call. The
+// gap to BM_Channel_SendAll_Drain is the per-item coordinator bookkeeping that
+// SendAll still does inside its loop.
+//
+static void BM_Channel_SendBatch_RecvBatch(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        const int cap = static_cast<int>(state.range(0));
+        std::vector<int> buf(cap);
+        coop::chan::Channel<int> ch(ctx, buf.data(), cap);
+
+        constexpr int BATCH = 4096;
+        std::vector<int> sendBuf(BATCH);
+        std::vector<int> recvBuf(BATCH);
+        int64_t totalItems = 0;
+
+        ctx->GetCooperator()->Spawn([&](coop::Context*)
+        {
+            while (true)
+            {
+                std::span<int> pending(sendBuf);
+                while (!pending.empty())
+                {
+                    size_t n = ch.SendBatch(pending);
+                    if (n == 0) return;
+                    pending = pending.subspan(n);
+                }
+            }
+        });
+
+        for (auto _ : state)
+        {
+            size_t received = 0;
+            while (received < BATCH)
+            {
+                size_t n = ch.RecvBatch(std::span(recvBuf).subspan(received));
+                benchmark::DoNotOptimize(n);
+                received += n;
+            }
+            totalItems += BATCH;
+        }
+
+        ch.Shutdown();
+        state.SetItemsProcessed(totalItems);
+    });
+}
+BENCHMARK(BM_Channel_SendBatch_RecvBatch)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(64);
+
 // ---------------------------------------------------------------------------
 // Pipeline benchmarks — multi-stage channel chains
 // ---------------------------------------------------------------------------
@@ -514,6 +569,64 @@ static void BM_Passage_Throughput(benchmark::State& state)
 }
 BENCHMARK(BM_Passage_Throughput)->Arg(64)->Arg(256)->Arg(1024)->Arg(4096);
 
+// ---------------------------------------------------------------------------
+// BM_Passage_CrossCooperator — the producer is a context on a second cooperator
+// ---------------------------------------------------------------------------
+//
+// Same shape as BM_Passage_Throughput, but each wake is an IORING_OP_MSG_RING post onto the
+// receiver's ring whose CQE releases the receiver inline -- no eventfd, no SubmissionDrainer, no
+// wake context. The gap to BM_Passage_Throughput is what that path saves per batch.
+//
+
+static void BM_Passage_CrossCooperator(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        constexpr size_t RING = 256;
+        const int BATCH = static_cast<int>(state.range(0));
+
+        coop::chan::Passage<int, RING> passage(ctx, ctx->GetCooperator());
+
+        std::atomic<bool> stop{false};
+
+        coop::Cooperator producer;
+        coop::Thread producerThread(&producer);
+        producer.Submit([&](coop::Context* sender)
+        {
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                for (int i = 0; i < BATCH; i++)
+                {
+                    if (stop.load(std::memory_order_relaxed)) break;
+                    while (!passage.Send(i) && !stop.load(std::memory_order_relaxed))
+                    {
+                        sender->Yield();
+                    }
+                }
+            }
+            producer.Shutdown();
+        });
+
+        int64_t totalItems = 0;
+        for (auto _ : state)
+        {
+            for (int i = 0; i < BATCH; i++)
+            {
+                int v;
+                passage.Recv(v);
+                benchmark::DoNotOptimize(v);
+            }
+            totalItems += BATCH;
+        }
+
+        stop.store(true, std::memory_order_release);
+        passage.Shutdown();
+
+        state.SetItemsProcessed(totalItems);
+    });
+}
+BENCHMARK(BM_Passage_CrossCooperator)->Arg(64)->Arg(256)->Arg(1024)->Arg(4096);
+
 // ---------------------------------------------------------------------------
 // BM_SpscPassage_Throughput — single producer specialized ring
 // ---------------------------------------------------------------------------
@@ -617,3 +730,38 @@ static void BM_Passage_NProducers(benchmark::State& state)
     });
 }
 BENCHMARK(BM_Passage_NProducers)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+// ---------------------------------------------------------------------------
+// BM_Batcher_Add — per-item cost of batching into a flush context
+// ---------------------------------------------------------------------------
+//
+// One producer adds as fast as it can into a Batcher<int, 64> whose flush only sums the batch.
+// Every 64th Add fills a batch and wakes the flush context, so the wake and swap are amortized
+// across the batch; the rest are an append and a compare.
+//
+static void BM_Batcher_Add(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        int64_t sum = 0;
+        coop::chan::Batcher<int, 64> batcher(ctx, std::chrono::milliseconds(1),
+            [&](coop::Context*, std::span<int> batch)
+            {
+                for (int v : batch)
+                {
+                    sum += v;
+                }
+            });
+
+        for (auto _ : state)
+        {
+            batcher.Add(ctx, 1);
+        }
+        batcher.Stop();
+        benchmark::DoNotOptimize(sum);
+        state.SetItemsProcessed(state.iterations());
+        state.counters["per_batch"] = batcher.GetStats().batches
+            ? double(batcher.GetStats().items) / double(batcher.GetStats().batches) : 0;
+    });
+}
+BENCHMARK(BM_Batcher_Add);
@@ -121,3 +121,52 @@ static void BM_Continuation_FireThenAwait(benchmark::State& state)
     });
 }
 BENCHMARK(BM_Continuation_FireThenAwait);
+
+// Two continuations joined by WhenAll, and two raced by WhenAny, each fired from one drain. The
+// combinator is frame-hosted like its inputs, so against two BM_Continuation_Fire stages this is
+// the combinator's own cost: observing, counting down or cancelling the loser, and its latch.
+//
+static void BM_Continuation_WhenAll(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        coop::Coordinator c1, c2;
+        auto* co = ctx->GetCooperator();
+        for (auto _ : state)
+        {
+            c1.TryAcquire(ctx);
+            c2.TryAcquire(ctx);
+            auto a = c1.Continue([](coop::Coordinator*) { return 1; });
+            auto b = c2.Continue([](coop::Coordinator*) { return 2; });
+            auto both = coop::WhenAll(a, b);
+            c1.Release(ctx, false /* schedule */);
+            c2.Release(ctx, false /* schedule */);
+            co->DrainContinuations();
+            both.Await();                               // fired -> no switch
+            benchmark::DoNotOptimize(a.Take() + b.Take());
+        }
+    });
+}
+BENCHMARK(BM_Continuation_WhenAll);
+
+static void BM_Continuation_WhenAny(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        coop::Coordinator c1, c2;
+        auto* co = ctx->GetCooperator();
+        for (auto _ : state)
+        {
+            c1.TryAcquire(ctx);
+            c2.TryAcquire(ctx);
+            auto a = c1.Continue([](coop::Coordinator*) { return 1; });
+            auto b = c2.Continue([](coop::Coordinator*) { return 2; });
+            auto first = coop::WhenAny(a, b);
+            c1.Release(ctx, false /* schedule */);      // a wins; b is cancelled when it fires
+            co->DrainContinuations();
+            benchmark::DoNotOptimize(first.Await());
+            c2.Release(ctx, false /* schedule */);      // nothing registered: a plain release
+        }
+    });
+}
+BENCHMARK(BM_Continuation_WhenAny);
@@ -2,6 +2,7 @@
 
 #include <benchmark/benchmark.h>
 
+#include "coop/barging_coordinator.h"
 #include "coop/context.h"
 #include "coop/coordinate_with.h"
 #include "coop/cooperator.h"
@@ -300,6 +301,98 @@ static void BM_PingPong_CoordinateWithKill(benchmark::State& state)
 }
 BENCHMARK(BM_PingPong_CoordinateWithKill);
 
+// ---------------------------------------------------------------------------
+// Contended lock: N contexts on one lock
+// ---------------------------------------------------------------------------
+//
+// Every context loops acquire / increment / release, yields inside the lock every 8th round (the
+// critical section awaiting IO now and then) and outside it every 4th. The measuring context is
+// one of the N; items are total acquisitions across all of them. With FIFO handoff a releaser
+// coming back for the lock finds it owned by a waiter that has not run, so once a queue forms
+// every acquire blocks; barging lets it keep the lock, bounded by the starvation limit.
+//
+
+struct FifoLock
+{
+    void Acquire(coop::Context* ctx) { coord.Acquire(ctx); }
+    void Release(coop::Context* ctx) { coord.Release(ctx, false); }
+
+    coop::Coordinator coord;
+};
+
+struct BargingLock
+{
+    void Acquire(coop::Context* ctx) { coord.Acquire(ctx); }
+    void Release(coop::Context*) { coord.Release(); }
+
+    coop::BargingCoordinator coord;
+};
+
+template<typename Lock>
+static void AcquireReleaseContended(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        Lock lock;
+        int64_t total = 0;
+        int running = 0;
+        bool done = false;
+
+        auto round = [&](coop::Context* self, int64_t i)
+        {
+            lock.Acquire(self);
+            total++;
+            if (i % 8 == 0)
+            {
+                self->Yield();
+            }
+            lock.Release(self);
+            if (i % 4 == 1)
+            {
+                self->Yield();
+            }
+        };
+
+        for (int64_t c = 1; c < state.range(0); c++)
+        {
+            running++;
+            ctx->GetCooperator()->Spawn([&, c](coop::Context* child)
+            {
+                for (int64_t i = c; !done; i++)
+                {
+                    round(child, i);
+                }
+                running--;
+            });
+        }
+
+        int64_t i = 0;
+        for (auto _ : state)
+        {
+            round(ctx, i++);
+        }
+
+        done = true;
+        while (running)
+        {
+            ctx->Yield();
+        }
+        state.SetItemsProcessed(total);
+    });
+}
+
+static void BM_AcquireRelease_Contended(benchmark::State& state)
+{
+    AcquireReleaseContended<FifoLock>(state);
+}
+BENCHMARK(BM_AcquireRelease_Contended)->Arg(2)->Arg(4)->Arg(16);
+
+static void BM_AcquireRelease_Contended_Barging(benchmark::State& state)
+{
+    AcquireReleaseContended<BargingLock>(state);
+}
+BENCHMARK(BM_AcquireRelease_Contended_Barging)->Arg(2)->Arg(4)->Arg(16);
+
 // ---------------------------------------------------------------------------
 // Kill signal
 // ---------------------------------------------------------------------------
@@ -328,7 +421,7 @@ static void BM_SpawnAndKill(benchmark::State& state)
 
             // Yield to let the killed child run its cleanup and exit.
             //
-            ctx->Yield(true);
+            ctx->Yield();
 
             coord.Release(ctx, false);
         }
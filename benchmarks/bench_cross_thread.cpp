@@ -0,0 +1,719 @@
+// Cross-cooperator handoff bench -- the bridges a pipeline stage can hand an item to another
+// cooperator through, head to head under one load shape:
+//
+//   submit           Cooperator::Submit from the producer thread; a context per item
+//   submit-sync      Cooperator::SubmitSync; the producer blocks until the item has run
+//   passage          chan::Passage (MPSC ring) into one receiving context
+//   spsc-passage     chan::SpscPassage; one producer only
+//   guarded-passage  a chan::FixedGuardedPassage per producer, polled by one context
+//   grid-shed        Shed into a work::Grid the producer and consumer cooperators share
+//
+// Producers are threads pinned per the placement; for grid-shed they are cooperators, since Shed
+// pushes onto the calling cooperator's own shard. Each cell runs two phases:
+//   - throughput: every producer sends its share of --items back to back. Reports items/s, the
+//     process's CPU time per item (producers, consumer, idle stealers: everything the bridge
+//     costs) and the consumer thread's.
+//   - latency: every producer sends its share of --latency-items, --gap us apart, spinning and
+//     then yielding the cpu between sends. Reports the one-way latency, stamped at the send and
+//     read where the item runs, with percentiles from a perf::Histogram.
+//
+// Placements come from coop::GetTopology(), relative to the consumer's cpu: same-core (the
+// producers share its cpu), smt (its hardware siblings), same-node (other physical cores of its
+// NUMA node, round-robin) and cross-node (another node's cpus). One the machine cannot provide
+// is skipped.
+//
+// In grid-shed the producer context does not yield while it sheds, so its own stealer takes
+// nothing until the phase's sends are done and whatever is left when it yields runs locally. The
+// note column gives the share the consumer ran: a measure of how much the grid forwarded, not
+// a failure.
+//
+// Usage: bench_cross_thread [--bridges=submit,...] [--producers=1,2,8,32]
+//                           [--placements=same-core,smt,same-node,cross-node]
+//                           [--items=200000] [--latency-items=20000] [--gap=20]
+//
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <pthread.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "coop/chan/guarded_passage.h"
+#include "coop/chan/passage.h"
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator.hpp"
+#include "coop/perf/histogram.h"
+#include "coop/thread.h"
+#include "coop/time/now.h"
+#include "coop/topology.h"
+#include "coop/work/grid.h"
+
+using namespace coop;
+
+namespace
+{
+
+constexpr size_t kRing = 1024;
+
+// Where items arrive: one per thread that runs consumer code (the consumer, and for grid-shed
+// each producer cooperator, whose stealer may run its own leftovers). Written only by that
+// thread; `received` is a plain store so the main thread can poll it.
+//
+struct alignas(64) Sink
+{
+    perf::Histogram       latency;
+    uint64_t              count = 0;
+    std::atomic<uint64_t> received{0};
+};
+
+thread_local Sink* t_sink = nullptr;
+std::atomic<bool>  g_recordLatency{false};
+
+inline int64_t NowNs()
+{
+    return time::MonotonicNanos();
+}
+
+// A wait on a full ring or a pacing deadline. Past a short spin it gives the cpu away, so a
+// same-core placement measures the bridge rather than a producer spinning out its timeslice.
+//
+inline void Backoff(int& spins)
+{
+    if (++spins < 64)
+    {
+        chan::detail::SpinPause();
+    }
+    else
+    {
+        std::this_thread::yield();
+    }
+}
+
+inline void Arrive(uint64_t stamp)
+{
+    Sink* sink = t_sink;
+    if (g_recordLatency.load(std::memory_order_relaxed))
+    {
+        const int64_t elapsed = NowNs() - static_cast<int64_t>(stamp);
+        sink->latency.Record(elapsed > 0 ? static_cast<uint64_t>(elapsed) : 0);
+    }
+    sink->received.store(++sink->count, std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// Bridges
+// ---------------------------------------------------------------------------
+
+struct Bridge
+{
+    virtual ~Bridge() = default;
+
+    virtual bool Supports(int producers) const { return producers >= 1; }
+
+    // Whether producers run as contexts on their own cooperators rather than on plain threads
+    //
+    virtual bool OnCooperators() const { return false; }
+
+    // Set up the consumer side, on the main thread, before any producer starts. producerCoops
+    // is empty unless OnCooperators.
+    //
+    virtual void Open(Cooperator* consumer, std::vector<Cooperator*> const& producerCoops,
+                      int producers) = 0;
+
+    // Hand one item over, on producer p's thread
+    //
+    virtual void Send(int p, uint64_t stamp) = 0;
+
+    // Tear the consumer side down, on the main thread, once every item has arrived
+    //
+    virtual void Close() {}
+};
+
+struct SubmitBridge : Bridge
+{
+    void Open(Cooperator* consumer, std::vector<Cooperator*> const&, int) override
+    {
+        m_consumer = consumer;
+    }
+
+    void Send(int, uint64_t stamp) override
+    {
+        m_consumer->Submit([stamp](Context*) { Arrive(stamp); });
+    }
+
+    Cooperator* m_consumer = nullptr;
+};
+
+struct SubmitSyncBridge : SubmitBridge
+{
+    void Send(int, uint64_t stamp) override
+    {
+        m_consumer->SubmitSync([stamp](Context*) { Arrive(stamp); });
+    }
+};
+
+// One receiving context on the consumer drains the passage. It is built there, since a Passage
+// takes its receiver's context, and freed by Close once that context has seen it shut down.
+//
+template<typename Passage>
+struct PassageBridge : Bridge
+{
+    explicit PassageBridge(bool singleProducer) : m_singleProducer(singleProducer) {}
+
+    bool Supports(int producers) const override
+    {
+        return producers == 1 || (!m_singleProducer && producers > 1);
+    }
+
+    void Open(Cooperator* consumer, std::vector<Cooperator*> const&, int) override
+    {
+        consumer->Submit([this](Context* ctx)
+        {
+            auto* passage = new Passage(ctx, ctx->GetCooperator());
+            m_passage.store(passage, std::memory_order_release);
+            uint64_t stamp;
+            while (passage->Recv(stamp))
+            {
+                Arrive(stamp);
+            }
+            m_done.store(true, std::memory_order_release);
+        });
+        while (!m_passage.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    void Send(int, uint64_t stamp) override
+    {
+        Passage* passage = m_passage.load(std::memory_order_relaxed);
+        for (int spins = 0; !passage->Send(stamp); )
+        {
+            Backoff(spins);
+        }
+    }
+
+    void Close() override
+    {
+        Passage* passage = m_passage.load(std::memory_order_relaxed);
+        passage->Shutdown();
+        while (!m_done.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+        delete passage;
+    }
+
+    bool                  m_singleProducer;
+    std::atomic<Passage*> m_passage{nullptr};
+    std::atomic<bool>     m_done{false};
+};
+
+// A passage per producer, swept round-robin by one context that yields after a sweep that found
+// nothing: the guarded passage has no wake of its own, so its consumer polls
+//
+struct GuardedPassageBridge : Bridge
+{
+    using Ring = chan::FixedGuardedPassage<uint64_t, kRing>;
+
+    void Open(Cooperator* consumer, std::vector<Cooperator*> const&, int producers) override
+    {
+        for (int p = 0; p < producers; p++)
+        {
+            m_rings.push_back(std::make_unique<Ring>());
+        }
+        consumer->Submit([this](Context* ctx)
+        {
+            std::vector<chan::RecvSide<uint64_t>> sides;
+            sides.reserve(m_rings.size());
+            for (auto& ring : m_rings)
+            {
+                sides.emplace_back(*ring);
+            }
+            m_ready.store(true, std::memory_order_release);
+
+            for (;;)
+            {
+                bool any = false;
+                uint64_t stamp;
+                for (auto& side : sides)
+                {
+                    while (side.TryPop(stamp))
+                    {
+                        Arrive(stamp);
+                        any = true;
+                    }
+                }
+                if (!any)
+                {
+                    if (m_stop.load(std::memory_order_acquire))
+                    {
+                        break;
+                    }
+                    ctx->Yield();
+                }
+            }
+            sides.clear();
+            m_done.store(true, std::memory_order_release);
+        });
+        while (!m_ready.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+        for (auto& ring : m_rings)
+        {
+            m_sends.emplace_back(*ring);
+        }
+    }
+
+    void Send(int p, uint64_t stamp) override
+    {
+        for (int spins = 0; !m_sends[p].TryPush(stamp); )
+        {
+            Backoff(spins);
+        }
+    }
+
+    void Close() override
+    {
+        m_stop.store(true, std::memory_order_release);
+        while (!m_done.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+        m_sends.clear();
+        m_rings.clear();
+    }
+
+    std::vector<std::unique_ptr<Ring>>    m_rings;
+    std::vector<chan::SendSide<uint64_t>> m_sends;
+    std::atomic<bool>                     m_ready{false};
+    std::atomic<bool>                     m_stop{false};
+    std::atomic<bool>                     m_done{false};
+};
+
+// The grid outlives the cooperators: RunCell destroys the bridge after them
+//
+struct GridShedBridge : Bridge
+{
+    bool OnCooperators() const override { return true; }
+
+    void Open(Cooperator* consumer, std::vector<Cooperator*> const& producerCoops,
+              int producers) override
+    {
+        m_grid.Init(producers + 1);
+        m_grid.Join(consumer);
+        for (auto* co : producerCoops)
+        {
+            m_grid.Join(co);
+        }
+
+        // Let the stealers start and publish their placement
+        //
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+    }
+
+    void Send(int, uint64_t stamp) override
+    {
+        Shed([stamp] { Arrive(stamp); });
+    }
+
+    work::Grid m_grid;
+};
+
+std::unique_ptr<Bridge> MakeBridge(std::string const& name)
+{
+    if (name == "submit") return std::make_unique<SubmitBridge>();
+    if (name == "submit-sync") return std::make_unique<SubmitSyncBridge>();
+    if (name == "passage")
+        return std::make_unique<PassageBridge<chan::Passage<uint64_t, kRing>>>(false);
+    if (name == "spsc-passage")
+        return std::make_unique<PassageBridge<chan::SpscPassage<uint64_t, kRing>>>(true);
+    if (name == "guarded-passage") return std::make_unique<GuardedPassageBridge>();
+    if (name == "grid-shed") return std::make_unique<GridShedBridge>();
+    return nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Placement
+// ---------------------------------------------------------------------------
+
+// The consumer's cpu and the cpus producers are dealt onto, or false when the topology has no
+// such pair
+//
+bool Place(std::string const& placement, int& consumerCpu, std::vector<int>& producerCpus)
+{
+    auto const& topo = GetTopology();
+    producerCpus.clear();
+    for (auto const& consumer : topo.cpus)
+    {
+        consumerCpu = consumer.cpu_id;
+        if (placement == "same-core")
+        {
+            producerCpus.push_back(consumerCpu);
+            return true;
+        }
+        for (auto const& other : topo.cpus)
+        {
+            if (other.cpu_id == consumerCpu)
+            {
+                continue;
+            }
+            const bool sibling = consumer.core_id >= 0 && other.core_id == consumer.core_id;
+            const bool sameNode = other.numa_node == consumer.numa_node;
+            if ((placement == "smt" && sibling) ||
+                (placement == "same-node" && sameNode && !sibling) ||
+                (placement == "cross-node" && !sameNode))
+            {
+                producerCpus.push_back(other.cpu_id);
+            }
+        }
+        if (!producerCpus.empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t ThreadCpuNs(pthread_t thread)
+{
+    clockid_t clock;
+    struct timespec ts;
+    if (pthread_getcpuclockid(thread, &clock) != 0 || clock_gettime(clock, &ts) != 0)
+    {
+        return 0;
+    }
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+int64_t ProcessCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+// Running a cell
+// ---------------------------------------------------------------------------
+
+struct Options
+{
+    std::vector<std::string> bridges = {"submit", "submit-sync", "passage", "spsc-passage",
+                                        "guarded-passage", "grid-shed"};
+    std::vector<int>         producers = {1, 2, 8, 32};
+    std::vector<std::string> placements = {"same-core", "smt", "same-node", "cross-node"};
+    int                      items = 200000;
+    int                      latencyItems = 20000;
+    int64_t                  gapNs = 20000;
+};
+
+struct Result
+{
+    bool            timedOut = false;
+    double          itemsPerSec = 0;
+    double          cpuNsPerItem = 0;
+    double          consumerNsPerItem = 0;
+    perf::Histogram latency;
+    double          consumerShare = 1.0;
+};
+
+// Producer p's share of a phase: count items, gapNs apart, or back to back for 0
+//
+void Produce(Bridge& bridge, int p, int count, int64_t gapNs)
+{
+    int64_t next = NowNs();
+    for (int i = 0; i < count; i++)
+    {
+        if (gapNs)
+        {
+            next += gapNs;
+            for (int spins = 0; NowNs() < next; )
+            {
+                Backoff(spins);
+            }
+        }
+        bridge.Send(p, static_cast<uint64_t>(NowNs()));
+    }
+}
+
+struct Phase
+{
+    int64_t wallNs;
+    int64_t cpuNs;
+    int64_t consumerNs;
+    bool    timedOut;
+};
+
+Phase RunPhase(Bridge& bridge, std::vector<Cooperator*> const& producerCoops,
+               std::vector<int> const& producerCpus, Sink* sinks, size_t sinkCount,
+               pthread_t consumerThread, int producers, int total, int64_t gapNs)
+{
+    const int share = total / producers;
+    const uint64_t expected = static_cast<uint64_t>(share) * producers;
+    uint64_t before = 0;
+    for (size_t s = 0; s < sinkCount; s++)
+    {
+        before += sinks[s].received.load(std::memory_order_relaxed);
+    }
+
+    std::atomic<bool> go{false};
+    std::atomic<bool> phaseDone{false};
+    std::atomic<int>  finished{0};
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < producers; p++)
+    {
+        if (bridge.OnCooperators())
+        {
+            producerCoops[p]->Submit([&, p](Context* ctx)
+            {
+                t_sink = &sinks[1 + p];
+                while (!go.load(std::memory_order_acquire))
+                {
+                    ctx->Yield();
+                }
+                Produce(bridge, p, share, gapNs);
+
+                // Now the local stealer may run what the consumer has not taken
+                //
+                while (!phaseDone.load(std::memory_order_acquire))
+                {
+                    ctx->Yield();
+                }
+                finished.fetch_add(1, std::memory_order_release);
+            });
+        }
+        else
+        {
+            threads.emplace_back([&, p]
+            {
+                PinThread(producerCpus[p % producerCpus.size()]);
+                while (!go.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+                Produce(bridge, p, share, gapNs);
+                finished.fetch_add(1, std::memory_order_release);
+            });
+        }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    const int64_t cpu0 = ProcessCpuNs();
+    const int64_t consumer0 = ThreadCpuNs(consumerThread);
+    const int64_t t0 = NowNs();
+    go.store(true, std::memory_order_release);
+
+    bool timedOut = false;
+    for (;;)
+    {
+        uint64_t received = 0;
+        for (size_t s = 0; s < sinkCount; s++)
+        {
+            received += sinks[s].received.load(std::memory_order_relaxed);
+        }
+        if (received - before >= expected)
+        {
+            break;
+        }
+        if (NowNs() - t0 > 30 * 1000000000LL)
+        {
+            timedOut = true;
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    Phase phase;
+    phase.wallNs = NowNs() - t0;
+    phase.cpuNs = ProcessCpuNs() - cpu0;
+    phase.consumerNs = ThreadCpuNs(consumerThread) - consumer0;
+    phase.timedOut = timedOut;
+
+    phaseDone.store(true, std::memory_order_release);
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    while (finished.load(std::memory_order_acquire) < producers)
+    {
+        std::this_thread::yield();
+    }
+    return phase;
+}
+
+Result RunCell(Options const& o, std::string const& bridgeName, int producers,
+               int consumerCpu, std::vector<int> const& producerCpus)
+{
+    Result result;
+    std::unique_ptr<Bridge> bridge = MakeBridge(bridgeName);
+
+    const size_t sinkCount = 1 + (bridge->OnCooperators() ? producers : 0);
+    std::unique_ptr<Sink[]> sinks(new Sink[sinkCount]);
+
+    {
+        Cooperator consumer;
+        Thread consumerThread(&consumer);
+        consumerThread.PinToCore(consumerCpu);
+        consumer.SubmitSync([&](Context*) { t_sink = &sinks[0]; });
+
+        std::vector<std::unique_ptr<Cooperator>> coops;
+        std::vector<std::unique_ptr<Thread>> coopThreads;
+        std::vector<Cooperator*> producerCoops;
+        if (bridge->OnCooperators())
+        {
+            for (int p = 0; p < producers; p++)
+            {
+                coops.push_back(std::make_unique<Cooperator>());
+                coopThreads.push_back(std::make_unique<Thread>(coops.back().get()));
+                coopThreads.back()->PinToCore(producerCpus[p % producerCpus.size()]);
+                producerCoops.push_back(coops.back().get());
+            }
+        }
+
+        bridge->Open(&consumer, producerCoops, producers);
+        const pthread_t handle = consumerThread.m_thread.native_handle();
+
+        g_recordLatency.store(false, std::memory_order_relaxed);
+        Phase throughput = RunPhase(*bridge, producerCoops, producerCpus, sinks.get(), sinkCount,
+                                    handle, producers, o.items, 0);
+
+        g_recordLatency.store(true, std::memory_order_relaxed);
+        Phase latency = RunPhase(*bridge, producerCoops, producerCpus, sinks.get(), sinkCount,
+                                 handle, producers, o.latencyItems, o.gapNs);
+        g_recordLatency.store(false, std::memory_order_relaxed);
+
+        bridge->Close();
+        for (auto& co : coops)
+        {
+            co->Shutdown();
+        }
+        coopThreads.clear();
+        coops.clear();
+        consumer.Shutdown();
+
+        const double items = static_cast<double>(o.items / producers * producers);
+        result.timedOut = throughput.timedOut || latency.timedOut;
+        result.itemsPerSec = items * 1e9 / static_cast<double>(throughput.wallNs);
+        result.cpuNsPerItem = static_cast<double>(throughput.cpuNs) / items;
+        result.consumerNsPerItem = static_cast<double>(throughput.consumerNs) / items;
+    }
+
+    uint64_t all = 0;
+    for (size_t s = 0; s < sinkCount; s++)
+    {
+        result.latency.Merge(sinks[s].latency);
+        all += sinks[s].count;
+    }
+    result.consumerShare = all ? static_cast<double>(sinks[0].count) / all : 1.0;
+    return result;
+}
+
+template<typename T, typename Parse>
+std::vector<T> SplitList(const char* s, Parse parse)
+{
+    std::vector<T> out;
+    std::string item;
+    for (const char* p = s;; p++)
+    {
+        if (*p == ',' || !*p)
+        {
+            if (!item.empty()) out.push_back(parse(item));
+            item.clear();
+            if (!*p) break;
+        }
+        else
+        {
+            item += *p;
+        }
+    }
+    return out;
+}
+
+} // end anonymous namespace
+
+int main(int argc, char** argv)
+{
+    Options o;
+    for (int i = 1; i < argc; i++)
+    {
+        auto eq = [&](const char* k) { return strncmp(argv[i], k, strlen(k)) == 0; };
+        auto value = [&] { return strchr(argv[i], '=') + 1; };
+        auto asString = [](std::string const& s) { return s; };
+        auto asInt = [](std::string const& s) { return atoi(s.c_str()); };
+        if (eq("--bridges=")) o.bridges = SplitList<std::string>(value(), asString);
+        else if (eq("--producers=")) o.producers = SplitList<int>(value(), asInt);
+        else if (eq("--placements=")) o.placements = SplitList<std::string>(value(), asString);
+        else if (eq("--items=")) o.items = atoi(value());
+        else if (eq("--latency-items=")) o.latencyItems = atoi(value());
+        else if (eq("--gap=")) o.gapNs = strtoll(value(), nullptr, 10) * 1000;
+        else
+        {
+            fprintf(stderr, "unknown option %s (see the comment at the top of "
+                    "bench_cross_thread.cpp)\n", argv[i]);
+            return 2;
+        }
+    }
+    for (auto const& name : o.bridges)
+    {
+        if (!MakeBridge(name))
+        {
+            fprintf(stderr, "unknown bridge %s\n", name.c_str());
+            return 2;
+        }
+    }
+
+    printf("%-16s %-10s %4s %10s %10s %10s %9s %9s %9s %9s %10s  %s\n", "bridge", "placement",
+           "prod", "Mitems/s", "cpu ns/it", "cons ns/it", "p50 us", "p90 us", "p99 us",
+           "p999 us", "max us", "note");
+
+    for (auto const& placement : o.placements)
+    {
+        int consumerCpu;
+        std::vector<int> producerCpus;
+        if (!Place(placement, consumerCpu, producerCpus))
+        {
+            printf("%-16s %-10s  skipped: the topology has no such cpu pair\n", "*",
+                   placement.c_str());
+            continue;
+        }
+        for (auto const& name : o.bridges)
+        {
+            for (int producers : o.producers)
+            {
+                if (producers < 1 || !MakeBridge(name)->Supports(producers))
+                {
+                    continue;
+                }
+                Result r = RunCell(o, name, producers, consumerCpu, producerCpus);
+                perf::Histogram const& h = r.latency;
+                char note[64] = "";
+                if (r.timedOut)
+                {
+                    snprintf(note, sizeof(note), "timed out");
+                }
+                else if (name == "grid-shed")
+                {
+                    snprintf(note, sizeof(note), "consumer ran %.0f%%", r.consumerShare * 100);
+                }
+                printf("%-16s %-10s %4d %10.3f %10.1f %10.1f %9.2f %9.2f %9.2f %9.2f %10.2f  %s\n",
+                       name.c_str(), placement.c_str(), producers, r.itemsPerSec / 1e6,
+                       r.cpuNsPerItem, r.consumerNsPerItem, h.Quantile(0.5) / 1000.0,
+                       h.Quantile(0.9) / 1000.0, h.Quantile(0.99) / 1000.0,
+                       h.Quantile(0.999) / 1000.0, h.max / 1000.0, note);
+                fflush(stdout);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,292 @@
+// Shared-table read scaling harness: coop::ConcurrentHashMap (epoch-protected, lock-free reads)
+// against the two things a session or routing table is built from today.
+//
+//   chm      ConcurrentHashMap over one epoch::Domain; every cooperator is a Participant
+//   mutex    one std::unordered_map behind one std::mutex
+//   sharded  one std::unordered_map per cooperator, each behind its own std::mutex, with a key
+//            owned by shard (hash % cooperators) -- the per-cooperator sharding a table gets when
+//            each core keeps its slice, still reachable from every core
+//
+// Each cooperator runs one context doing --ops operations over --keys keys, --reads percent of
+// them lookups and the rest InsertOrAssign, yielding every 64 ops so the scheduler loop (and the
+// domain's quiescing) keeps turning. Throughput is total ops over the makespan.
+//
+// Usage:
+//   bench_epoch [--mode=chm|mutex|sharded|all] [--coops=1,2,4,8,16,32,64] [--keys=65536]
+//               [--ops=1000000] [--reads=95] [--nopin]
+//
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "coop/concurrent_hash_map.h"
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator.hpp"
+#include "coop/epoch/domain.h"
+#include "coop/thread.h"
+
+using Clock = std::chrono::steady_clock;
+
+static uint64_t g_keys = 65536, g_ops = 1000000;
+static uint32_t g_reads = 95;
+
+static inline uint64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+}
+
+// xorshift: cheap enough not to dominate a lookup
+//
+static inline uint64_t Next(uint64_t& s)
+{
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return s;
+}
+
+struct Route
+{
+    uint64_t backend;
+    uint64_t generation;
+};
+
+// The three tables behind one interface: Setup on the cooperator before the clock starts, then
+// Read/Write from the timed loop
+//
+struct ChmTable
+{
+    coop::epoch::Domain                                     domain;
+    coop::ConcurrentHashMap<uint64_t, Route>                map{domain, g_keys};
+
+    struct Local
+    {
+        explicit Local(ChmTable& t) : participant(t.domain) {}
+        coop::epoch::Participant participant;
+    };
+
+    bool Read(Local& local, uint64_t key)
+    {
+        coop::epoch::DomainGuard guard(local.participant);
+        return map.Find(guard, key) != nullptr;
+    }
+
+    void Write(Local& local, uint64_t key, uint64_t gen)
+    {
+        map.InsertOrAssign(local.participant, key, Route{key, gen});
+    }
+};
+
+struct MutexTable
+{
+    std::mutex                              lock;
+    std::unordered_map<uint64_t, Route>     map;
+
+    struct Local
+    {
+        explicit Local(MutexTable&) {}
+    };
+
+    bool Read(Local&, uint64_t key)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return map.find(key) != map.end();
+    }
+
+    void Write(Local&, uint64_t key, uint64_t gen)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        map[key] = Route{key, gen};
+    }
+};
+
+struct ShardedTable
+{
+    struct alignas(64) Shard
+    {
+        std::mutex                              lock;
+        std::unordered_map<uint64_t, Route>     map;
+    };
+
+    explicit ShardedTable(size_t shards) : shards(shards) {}
+
+    std::vector<Shard> shards;
+
+    struct Local
+    {
+        explicit Local(ShardedTable&) {}
+    };
+
+    Shard& For(uint64_t key) { return shards[key % shards.size()]; }
+
+    bool Read(Local&, uint64_t key)
+    {
+        auto& shard = For(key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        return shard.map.find(key) != shard.map.end();
+    }
+
+    void Write(Local&, uint64_t key, uint64_t gen)
+    {
+        auto& shard = For(key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.map[key] = Route{key, gen};
+    }
+};
+
+template<typename Table>
+static double Run(Table& table, int coops, bool pin)
+{
+    std::vector<std::unique_ptr<coop::Cooperator>> cooperators;
+    std::vector<std::unique_ptr<coop::Thread>> threads;
+    for (int i = 0; i < coops; i++)
+    {
+        cooperators.push_back(std::make_unique<coop::Cooperator>());
+        threads.push_back(std::make_unique<coop::Thread>(cooperators.back().get()));
+        if (pin) threads.back()->PinToCore(i);
+    }
+
+    // Fill from the first cooperator, then start everyone together
+    //
+    std::atomic<int> ready{0}, done{0};
+    std::atomic<bool> go{false};
+    std::atomic<uint64_t> hits{0};
+
+    for (int c = 0; c < coops; c++)
+    {
+        cooperators[c]->Submit([&, c](coop::Context* ctx)
+        {
+            typename Table::Local local(table);
+            if (c == 0)
+            {
+                for (uint64_t k = 0; k < g_keys; k++)
+                {
+                    table.Write(local, k, 0);
+                }
+            }
+            ready++;
+            while (!go.load(std::memory_order_acquire))
+            {
+                ctx->Yield();
+            }
+
+            uint64_t seed = 0x9E3779B97F4A7C15ull * (c + 1);
+            uint64_t found = 0;
+            for (uint64_t i = 0; i < g_ops; i++)
+            {
+                uint64_t r = Next(seed);
+                uint64_t key = r % g_keys;
+                if ((r >> 40) % 100 < g_reads)
+                {
+                    found += table.Read(local, key);
+                }
+                else
+                {
+                    table.Write(local, key, i);
+                }
+                if ((i & 63) == 63)
+                {
+                    ctx->Yield();
+                }
+            }
+            hits += found;
+            done++;
+
+            // Stay joined until everyone is done, so no participant leaves mid-run
+            //
+            while (done.load(std::memory_order_acquire) < coops)
+            {
+                ctx->Yield();
+            }
+        });
+    }
+
+    while (ready.load(std::memory_order_acquire) < coops)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    const uint64_t t0 = NowNs();
+    go.store(true, std::memory_order_release);
+    while (done.load(std::memory_order_acquire) < coops)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    const uint64_t t1 = NowNs();
+
+    for (auto& c : cooperators) c->Shutdown();
+    threads.clear();
+    cooperators.clear();
+
+    if (hits.load() == 0)
+    {
+        fprintf(stderr, "no lookup hit -- the table was not filled\n");
+    }
+    return double(coops) * double(g_ops) / (double(t1 - t0) / 1e9);
+}
+
+static void Report(const char* mode, int coops, double opsPerSec)
+{
+    printf("mode=%-8s coops=%-3d keys=%llu reads=%u%% | thru=%8.2fM ops/s per-coop=%7.2fM ops/s\n",
+           mode, coops, (unsigned long long)g_keys, g_reads, opsPerSec / 1e6,
+           opsPerSec / 1e6 / coops);
+}
+
+int main(int argc, char** argv)
+{
+    std::string mode = "all";
+    std::vector<int> coopCounts = {1, 2, 4, 8, 16, 32, 64};
+    bool pin = true;
+    for (int i = 1; i < argc; i++)
+    {
+        auto eq = [&](const char* k){ return strncmp(argv[i], k, strlen(k)) == 0; };
+        if (eq("--mode=")) mode = argv[i] + 7;
+        else if (eq("--keys=")) g_keys = strtoull(argv[i] + 7, nullptr, 10);
+        else if (eq("--ops=")) g_ops = strtoull(argv[i] + 6, nullptr, 10);
+        else if (eq("--reads=")) g_reads = atoi(argv[i] + 8);
+        else if (eq("--nopin")) pin = false;
+        else if (eq("--coops="))
+        {
+            coopCounts.clear();
+            for (char* p = argv[i] + 8; *p;)
+            {
+                coopCounts.push_back(strtol(p, &p, 10));
+                if (*p == ',') p++;
+            }
+        }
+    }
+
+    const unsigned cores = std::thread::hardware_concurrency();
+    for (int coops : coopCounts)
+    {
+        // Pinning past the core count would stack cooperators on the last cores
+        //
+        const bool pinned = pin && unsigned(coops) <= cores;
+        if (mode == "all" || mode == "chm")
+        {
+            ChmTable table;
+            Report("chm", coops, Run(table, coops, pinned));
+        }
+        if (mode == "all" || mode == "mutex")
+        {
+            MutexTable table;
+            Report("mutex", coops, Run(table, coops, pinned));
+        }
+        if (mode == "all" || mode == "sharded")
+        {
+            ShardedTable table(coops);
+            Report("sharded", coops, Run(table, coops, pinned));
+        }
+    }
+    return 0;
+}
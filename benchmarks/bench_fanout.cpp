@@ -1,6 +1,8 @@
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include <benchmark/benchmark.h>
@@ -187,3 +189,56 @@ static void BM_FanOut_AdvanceStage_Context(benchmark::State& state)
     });
 }
 BENCHMARK(BM_FanOut_AdvanceStage_Context)->RangeMultiplier(8)->Range(64, 4096)->UseRealTime();
+
+// ---------------------------------------------------------------------------
+// High fan-in: P producer threads flooding one cooperator with Submit, each submission a task that
+// bumps a counter. Measures the cross-thread submission path end to end -- entry allocation, the
+// queue push, the wake, and the drain that spawns the task -- under the producer contention that
+// convoyed on the old submission mutex. Run at 1, 8 and 32 producers.
+// ---------------------------------------------------------------------------
+
+static void BM_FanIn_Submit(benchmark::State& state)
+{
+    const int producers = static_cast<int>(state.range(0));
+    constexpr int PER_PRODUCER = 4096;
+
+    coop::Cooperator cooperator;
+    coop::Thread t(&cooperator);
+
+    std::atomic<int64_t> done{0};
+    int64_t expected = 0;
+
+    for (auto _ : state)
+    {
+        expected += static_cast<int64_t>(producers) * PER_PRODUCER;
+
+        std::vector<std::thread> threads;
+        threads.reserve(producers);
+        for (int p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&cooperator, &done]
+            {
+                for (int i = 0; i < PER_PRODUCER; ++i)
+                {
+                    cooperator.Submit([&done](coop::Context*)
+                    {
+                        done.fetch_add(1, std::memory_order_relaxed);
+                    });
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        while (done.load(std::memory_order_acquire) < expected)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    state.SetItemsProcessed(expected);
+    state.counters["producers"] = producers;
+    cooperator.Shutdown();
+}
+BENCHMARK(BM_FanIn_Submit)->Arg(1)->Arg(8)->Arg(32)->UseRealTime();
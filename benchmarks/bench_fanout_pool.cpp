@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -176,6 +177,20 @@ struct GridPipeline final : coop::work::Erg
     };
 };
 
+// POOL_PINCORES=spread or pack: leave the pin to the cooperators' own placement
+// policy (SpreadPhysicalFirst or PackLLC) rather than one cpu per index.
+//
+bool PoolPlacement(coop::PlacementPolicy* policy)
+{
+    const char* s = getenv("POOL_PINCORES");
+    if (!s) return false;
+    const std::string v(s);
+    if (v == "spread") *policy = coop::PlacementPolicy::SpreadPhysicalFirst;
+    else if (v == "pack") *policy = coop::PlacementPolicy::PackLLC;
+    else return false;
+    return true;
+}
+
 // Core the i-th cooperator pins to. The makespan demands one dedicated physical
 // core per cooperator, so by default cooperator i pins to cpu i. Two overrides:
 // POOL_PINCORES is a comma-separated cpu list (pin to a chosen set, e.g. to
@@ -183,6 +198,7 @@ struct GridPipeline final : coop::work::Erg
 // -1, leaving the threads unpinned so the OS scheduler places them on whatever
 // cores are free -- the right choice on a contended box, where a hard pin onto a
 // busy core starves a cooperator and serializes the makespan behind it.
+// PoolPlacement's policies also return -1 here.
 //
 int PinCore(int i)
 {
@@ -190,7 +206,8 @@ int PinCore(int i)
     {
         std::vector<int> v;
         const char* s = getenv("POOL_PINCORES");
-        if (s && std::string(s) == "none")
+        coop::PlacementPolicy policy;
+        if ((s && std::string(s) == "none") || PoolPlacement(&policy))
         {
             v.push_back(-1);
             return v;
@@ -216,9 +233,11 @@ struct Fabric
 {
     explicit Fabric(int m) : coops(m), threads(m)
     {
+        coop::CooperatorConfiguration config = coop::s_defaultCooperatorConfiguration;
+        PoolPlacement(&config.placement);
         for (int i = 0; i < m; i++)
         {
-            coops[i] = new coop::Cooperator();
+            coops[i] = new coop::Cooperator(config);
             threads[i] = new coop::Thread(coops[i]);
             const int core = PinCore(i);
             if (core >= 0)
@@ -418,3 +437,121 @@ BENCHMARK(BM_FanOut_Pool_StaticShard)
     ->Args({3, 1})
     ->UseManualTime()
     ->Unit(benchmark::kMillisecond);
+
+// -- Erg allocation: slab vs heap under cross-thread free ---------------------
+//
+// Fine-grained fan-out: cooperator 0 sheds kMorsels near-empty transient Ergs in waves that fit its
+// shard, and the other stealers take most of them. Nearly every Erg is freed on a different core than
+// the one that allocated it. That is the allocator's worst case, and the cost the per-cooperator
+// ErgSlab exists to remove. arg 1 == 1 sheds through Shed(fn) (the owner's slab; remote frees ride
+// its return list). arg 1 == 0 sheds MakeErg(fn) heap Ergs through Shed(Erg*) (new / cross-thread
+// delete). Same grid, same morsels; only the allocator differs.
+//
+namespace
+{
+
+constexpr int kMorsels = 200000;
+constexpr int kWave    = 4096;         // stays under the per-shard deque capacity
+
+struct alignas(64) PaddedCount
+{
+    std::atomic<int64_t> n{0};
+};
+
+struct AllocDriver
+{
+    PaddedCount ran[8];
+
+    int64_t Total() const
+    {
+        int64_t t = 0;
+        for (auto const& c : ran) t += c.n.load(std::memory_order_relaxed);
+        return t;
+    }
+};
+
+} // namespace
+
+static void BM_FanOut_Pool_ErgAlloc(benchmark::State& state)
+{
+    const int  M       = static_cast<int>(state.range(0));
+    const bool useSlab = state.range(1) != 0;
+
+    for (auto _ : state)
+    {
+        // The grid (and with it cooperator 0's slab) is declared first so it outlives the fabric: the
+        // last morsels are still being freed into the slab after the final count is observed.
+        //
+        coop::work::Grid grid;
+        grid.Init(M);
+        AllocDriver drv;
+        Fabric fab(M);
+        for (int m = 0; m < M; m++)
+        {
+            grid.Join(fab.coops[m]);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+
+        std::atomic<bool> finished{false};
+        const auto t0 = Clock::now();
+
+        fab.coops[0]->Submit([&drv, &finished, useSlab](coop::Context* ctx)
+        {
+            for (int shed = 0; shed < kMorsels; )
+            {
+                const int wave = std::min(kWave, kMorsels - shed);
+                for (int i = 0; i < wave; i++)
+                {
+                    auto morsel = [&drv]
+                    {
+                        const int shard = coop::GetCooperator()->m_participation->shard;
+                        drv.ran[shard].n.fetch_add(1, std::memory_order_relaxed);
+                    };
+                    if (useSlab)
+                    {
+                        coop::Shed(morsel);
+                    }
+                    else
+                    {
+                        coop::Shed(coop::work::MakeErg(morsel));
+                    }
+                }
+                shed += wave;
+
+                // Let the local stealer and the thieves drain this wave before shedding the next
+                //
+                while (drv.Total() < shed)
+                {
+                    ctx->Yield();
+                }
+            }
+            finished.store(true, std::memory_order_release);
+        });
+
+        while (!finished.load(std::memory_order_acquire))
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        const auto t1 = Clock::now();
+        state.SetIterationTime(std::chrono::duration<double>(t1 - t0).count());
+
+        if (getenv("POOL_DEBUG"))
+        {
+            fprintf(stderr, "[ergalloc M=%d slab=%d] %.1fms returns=%lu ranOn=", M, useSlab ? 1 : 0,
+                std::chrono::duration<double, std::milli>(t1 - t0).count(),
+                (unsigned long)fab.coops[0]->m_participation->slab->RemoteReturns());
+            for (int m = 0; m < M; m++)
+                fprintf(stderr, "%ld ", (long)drv.ran[m].n.load(std::memory_order_relaxed));
+            fprintf(stderr, "\n");
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * int64_t{kMorsels});
+    state.counters["M"] = M;
+    state.counters["slab"] = useSlab ? 1 : 0;
+}
+BENCHMARK(BM_FanOut_Pool_ErgAlloc)
+    ->Args({3, 0})
+    ->Args({3, 1})
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,759 @@
+// Memory footprint bench -- what an idle keep-alive connection costs the server, by mode:
+//
+//   plain        http::RunServer: a context per connection parked in its recv
+//   stackless    http::RunStacklessServer: an idle connection is its socket and one poll
+//   buffer-ring  RunServer with multishotRecv on a BufferRing: no recv buffer while idle
+//   tls          http::RunTlsServer: memory-BIO OpenSSL, pooled staging buffers
+//   ktls         socket-BIO OpenSSL with EnableKTLS, records framed by the kernel once it takes
+//                both directions (the note says how many connections it did)
+//   ws           RunServer with a route that upgrades and parks in ws::Connection::NextFrame
+//
+// Each cell forks a server process and a client process, so neither's memory shows in the
+// other's. The server samples itself once listening, the client opens --connections sockets
+// across 127.0.0.x (a new address every 20000, for port space), sends one request (a GET, or the
+// WebSocket upgrade) on each and parks, and the server samples again after --settle ms. Deltas
+// over the connections that came up:
+//
+//   rss, anon    Rss and Anonymous from /proc/self/smaps_rollup: everything the process holds
+//   ctx          server contexts per connection
+//   stack        committed (resident) stack pages of the server's contexts
+//   heap         their bump heaps' high-water marks, connection objects and buffers included
+//   tagged       the HttpConnection, WsConnection, TlsConnection and TlsStaging accounts of
+//                coop/memory_accounting.h -- a subset of heap, plus the staging pool
+//   tcp          kernel TCP buffer pages from /proc/net/sockstat: both ends, not in rss
+//
+// and, last, the StackPool's cached bytes after the run. Whatever rss holds beyond stack and
+// heap is OpenSSL's heap, malloc slack and the uring.
+//
+// Usage: bench_footprint [--modes=plain,stackless,buffer-ring,tls,ktls,ws]
+//                        [--connections=10000,100000] [--settle=500] [--port=18480]
+//                        [--client-threads=4] [--inflight=256]
+//                        [--cert=test_cert.pem] [--key=test_key.pem]
+//
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "coop/alloc.h"
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator.hpp"
+#include "coop/coordinate_with.h"
+#include "coop/coordinator.h"
+#include "coop/memory_accounting.h"
+#include "coop/self.h"
+#include "coop/semaphore.h"
+#include "coop/thread.h"
+#include "coop/http/connection.h"
+#include "coop/http/server.h"
+#include "coop/http/tls_transport.h"
+#include "coop/http/transport.h"
+#include "coop/io/accept.h"
+#include "coop/io/connect.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/recv.h"
+#include "coop/io/send.h"
+#include "coop/io/ssl/connection.h"
+#include "coop/io/ssl/context.h"
+#include "coop/io/ssl/recv.h"
+#include "coop/io/ssl/send.h"
+#include "coop/time/sleep.h"
+#include "coop/ws/connection.h"
+#include "coop/ws/upgrade.h"
+
+using namespace coop;
+
+namespace
+{
+
+constexpr int kPerAddress = 20000;
+
+struct Options
+{
+    std::vector<std::string> modes = {"plain", "stackless", "buffer-ring", "tls", "ktls", "ws"};
+    std::vector<int>         connections = {10000, 100000};
+    int                      settleMs = 500;
+    int                      port = 18480;
+    int                      clientThreads = 4;
+    int                      inflight = 256;
+    std::string              cert = "test_cert.pem";
+    std::string              key = "test_key.pem";
+};
+
+bool IsTls(std::string const& mode)
+{
+    return mode == "tls" || mode == "ktls";
+}
+
+// ---------------------------------------------------------------------------
+// Sampling
+// ---------------------------------------------------------------------------
+
+struct Sample
+{
+    size_t        rssKb = 0;
+    size_t        anonKb = 0;
+    size_t        tcpPages = 0;
+    ContextMemory contexts;
+    size_t        stackPoolBytes = 0;
+    int64_t       taggedBytes = 0;
+};
+
+void ReadRollup(Sample& s)
+{
+    FILE* f = fopen("/proc/self/smaps_rollup", "r");
+    if (!f)
+    {
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f))
+    {
+        size_t kb;
+        if (sscanf(line, "Rss: %zu kB", &kb) == 1) s.rssKb = kb;
+        else if (sscanf(line, "Anonymous: %zu kB", &kb) == 1) s.anonKb = kb;
+    }
+    fclose(f);
+}
+
+void ReadSockstat(Sample& s)
+{
+    FILE* f = fopen("/proc/net/sockstat", "r");
+    if (!f)
+    {
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f))
+    {
+        int inuse, orphan, tw, alloc;
+        size_t mem;
+        if (sscanf(line, "TCP: inuse %d orphan %d tw %d alloc %d mem %zu", &inuse, &orphan, &tw,
+                   &alloc, &mem) == 5)
+        {
+            s.tcpPages = mem;
+        }
+    }
+    fclose(f);
+}
+
+// The process from outside, the cooperator from its own thread
+//
+Sample TakeSample(Cooperator& co)
+{
+    Sample s;
+    co.SubmitSync([&](Context*)
+    {
+        auto m = AccountCooperatorMemory(&co);
+        s.contexts = m.contexts;
+        s.stackPoolBytes = m.stackPoolBytes;
+        for (auto const& tagged : m.tagged)
+        {
+            s.taggedBytes += tagged.bytes;
+        }
+    });
+    ReadRollup(s);
+    ReadSockstat(s);
+    return s;
+}
+
+bool RaiseFdLimit(int needed)
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0)
+    {
+        return false;
+    }
+    if (limit.rlim_cur >= static_cast<rlim_t>(needed))
+    {
+        return true;
+    }
+    if (limit.rlim_max < static_cast<rlim_t>(needed))
+    {
+        return false;
+    }
+    limit.rlim_cur = needed;
+    return setrlimit(RLIMIT_NOFILE, &limit) == 0;
+}
+
+bool LoadFile(std::string const& path, std::vector<char>& out)
+{
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f)
+    {
+        return false;
+    }
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    {
+        out.insert(out.end(), buf, buf + n);
+    }
+    fclose(f);
+    return !out.empty();
+}
+
+// ---------------------------------------------------------------------------
+// Server process
+// ---------------------------------------------------------------------------
+
+std::atomic<int> g_ktlsActive{0};
+
+void HandleHello(http::ConnectionBase& conn)
+{
+    conn.Send(200, "text/plain", "ok\n", 3);
+}
+
+// Upgrade and sit in NextFrame until the client goes away: the parked WebSocket handler
+//
+void HandleWs(http::ConnectionBase& conn)
+{
+    if (!ws::Upgrade(conn))
+    {
+        return;
+    }
+    using Ws = ws::Connection<http::PlaintextTransport>;
+    http::PlaintextTransport transport(conn.GetDescriptor());
+    auto ws = coop::Allocate<Ws>(Ws::ExtraBytes(), transport, coop::Self(),
+                                 ws::ConnectionBase::DEFAULT_RECV_BUFFER_SIZE,
+                                 ws::ConnectionBase::DEFAULT_SEND_BUFFER_SIZE,
+                                 std::chrono::seconds(0), conn.LeftoverData(),
+                                 conn.LeftoverSize());
+    while (ws->NextFrame())
+    {
+    }
+}
+
+const http::Route s_routes[] = {
+    {"/", HandleHello},
+    {"/ws", HandleWs},
+};
+
+constexpr int kRouteCount = sizeof(s_routes) / sizeof(s_routes[0]);
+
+int ListenOn(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(fd, 4096) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// RunTlsServer handshakes through memory BIOs, which kTLS cannot take over, so the ktls mode
+// has its own accept loop: socket BIO, and an http::Connection over the TlsTransport as
+// RunTlsServer's connections have
+//
+void ServeKtls(Context* ctx, int port, io::ssl::Context& sslCtx)
+{
+    ctx->SetName("FootprintKtlsServer");
+    int listenFd = ListenOn(port);
+    if (listenFd < 0)
+    {
+        return;
+    }
+
+    auto* co = ctx->GetCooperator();
+    io::Descriptor listener(listenFd);
+    for (;;)
+    {
+        int fd = io::Accept(listener);
+        if (fd < 0)
+        {
+            return;
+        }
+        co->Spawn({.priority = 0, .stackSize = 65536}, [fd, &sslCtx](Context* c)
+        {
+            c->SetName("FootprintKtlsConnection");
+            io::Descriptor desc(fd);
+            io::ssl::Connection ssl(sslCtx, desc, io::ssl::SocketBio{});
+            if (ssl.HandshakeKill() != 0)
+            {
+                return;
+            }
+            g_ktlsActive.fetch_add(ssl.m_ktlsTx && ssl.m_ktlsRx, std::memory_order_relaxed);
+
+            using Conn = http::Connection<http::TlsTransport>;
+            http::TlsTransport transport(ssl, desc);
+            auto conn = c->Allocate<Conn>(Conn::ExtraBytes(), transport, c, c->GetCooperator(),
+                                          http::ConnectionBase::DEFAULT_BUFFER_SIZE,
+                                          http::ConnectionBase::DEFAULT_SEND_BUFFER_SIZE,
+                                          std::chrono::seconds(0));
+            while (conn->GetRequestLine())
+            {
+                conn->SkipHeaders();
+                HandleHello(*conn);
+                if (conn->SendError() || !conn->KeepAlive())
+                {
+                    return;
+                }
+                conn->SkipBody();
+                conn->Reset();
+            }
+        });
+    }
+}
+
+struct Report
+{
+    Sample base;
+    Sample idle;
+    int    ktlsActive;
+    bool   ok;
+};
+
+void WriteAll(int fd, void const* buf, size_t size)
+{
+    auto* p = static_cast<char const*>(buf);
+    while (size)
+    {
+        ssize_t n = write(fd, p, size);
+        if (n <= 0)
+        {
+            return;
+        }
+        p += n;
+        size -= n;
+    }
+}
+
+bool ReadAll(int fd, void* buf, size_t size)
+{
+    auto* p = static_cast<char*>(buf);
+    while (size)
+    {
+        ssize_t n = read(fd, p, size);
+        if (n <= 0)
+        {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Signal ready on `out` once listening, sample on each byte from `in`, then wait to be killed
+//
+int ServerMain(Options const& o, std::string const& mode, int connections, int port, int in,
+               int out)
+{
+    Report report = {};
+    report.ok = RaiseFdLimit(connections + 1024);
+
+    std::vector<char> cert, key;
+    io::ssl::Context sslCtx(io::ssl::Mode::Server);
+    if (IsTls(mode))
+    {
+        report.ok = report.ok && LoadFile(o.cert, cert) && LoadFile(o.key, key);
+        if (report.ok)
+        {
+            sslCtx.LoadCertificate(cert.data(), cert.size());
+            sslCtx.LoadPrivateKey(key.data(), key.size());
+        }
+        if (mode == "ktls")
+        {
+            sslCtx.EnableKTLS();
+        }
+    }
+    if (!report.ok)
+    {
+        WriteAll(out, &report, sizeof(report));
+        return 1;
+    }
+
+    CooperatorConfiguration config;
+    if (mode == "buffer-ring")
+    {
+        config.uring.bufferRingEntries = 4096;
+    }
+    Cooperator co(config);
+    Thread thread(&co);
+
+    const auto noTimeout = std::chrono::seconds(0);
+    co.Submit([&](Context* ctx)
+    {
+        if (mode == "plain")
+            http::RunServer(ctx, port, s_routes, kRouteCount, "FootprintServer", nullptr,
+                            noTimeout);
+        else if (mode == "stackless")
+            http::RunStacklessServer(ctx, port, s_routes, kRouteCount, "FootprintServer",
+                                     nullptr, noTimeout);
+        else if (mode == "buffer-ring")
+            http::RunServer(ctx, port, s_routes, kRouteCount, "FootprintServer", nullptr,
+                            noTimeout, false, false, true);
+        else if (mode == "tls")
+            http::RunTlsServer(ctx, port, s_routes, kRouteCount, sslCtx, "FootprintServer",
+                               nullptr, noTimeout);
+        else if (mode == "ktls")
+            ServeKtls(ctx, port, sslCtx);
+        else if (mode == "ws")
+            http::RunServer(ctx, port, s_routes, kRouteCount, "FootprintServer", nullptr,
+                            noTimeout);
+    });
+
+    // Let the listener come up before the baseline, so it is not counted against the connections
+    //
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    report.base = TakeSample(co);
+    char go = 1;
+    WriteAll(out, &go, 1);
+
+    if (ReadAll(in, &go, 1))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(o.settleMs));
+        report.idle = TakeSample(co);
+        report.ktlsActive = g_ktlsActive.load(std::memory_order_relaxed);
+        WriteAll(out, &report, sizeof(report));
+    }
+
+    // The orchestrator kills this process: tearing 100K connections down is not what is measured
+    //
+    while (read(in, &go, 1) > 0)
+    {
+    }
+    _exit(0);
+}
+
+// ---------------------------------------------------------------------------
+// Client process
+// ---------------------------------------------------------------------------
+
+struct ClientReport
+{
+    int connected;
+    int failed;
+};
+
+std::atomic<int> g_connected{0};
+std::atomic<int> g_failed{0};
+
+const char s_get[] = "GET / HTTP/1.1\r\nHost: footprint\r\n\r\n";
+const char s_upgrade[] =
+    "GET /ws HTTP/1.1\r\n"
+    "Host: footprint\r\n"
+    "Upgrade: websocket\r\n"
+    "Connection: Upgrade\r\n"
+    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+    "Sec-WebSocket-Version: 13\r\n"
+    "\r\n";
+
+bool Answered(char const* buf, int n, bool upgrade)
+{
+    const char* expect = upgrade ? "HTTP/1.1 101" : "HTTP/1.1 200";
+    return n >= 12 && memcmp(buf, expect, 12) == 0;
+}
+
+// One connection: request, answer, then park on `never` with the socket (and TLS state) held
+//
+void Session(Context* ctx, std::string const& mode, io::ssl::Context& sslCtx, int index,
+             int port, Semaphore& inflight, Coordinator& never)
+{
+    char host[32];
+    snprintf(host, sizeof(host), "127.0.0.%d", 1 + index / kPerAddress);
+
+    bool ok = false;
+    int fd = io::ConnectAny(host, port, std::chrono::seconds(10));
+    if (fd >= 0)
+    {
+        io::Descriptor desc(fd);
+        char buf[512];
+        if (IsTls(mode))
+        {
+            io::ssl::Connection ssl(sslCtx, desc, io::ssl::SocketBio{});
+            ok = ssl.HandshakeKill() == 0 &&
+                 io::ssl::SendAll(ssl, s_get, sizeof(s_get) - 1) == int(sizeof(s_get) - 1) &&
+                 Answered(buf, io::ssl::Recv(ssl, buf, sizeof(buf)), false);
+            if (ok)
+            {
+                g_connected.fetch_add(1, std::memory_order_relaxed);
+                inflight.Release();
+                CoordinateWithKill(ctx, &never);
+                return;
+            }
+        }
+        else
+        {
+            const bool upgrade = mode == "ws";
+            const char* req = upgrade ? s_upgrade : s_get;
+            const size_t len = upgrade ? sizeof(s_upgrade) - 1 : sizeof(s_get) - 1;
+            ok = io::SendAll(desc, req, len) == int(len) &&
+                 Answered(buf, io::Recv(desc, buf, sizeof(buf)), upgrade);
+            if (ok)
+            {
+                g_connected.fetch_add(1, std::memory_order_relaxed);
+                inflight.Release();
+                CoordinateWithKill(ctx, &never);
+                return;
+            }
+        }
+    }
+    g_failed.fetch_add(1, std::memory_order_relaxed);
+    inflight.Release();
+}
+
+// Open `connections` across --client-threads cooperators, at most --inflight coming up at once
+// on each, report on `out` once every one is up or has failed, then wait to be killed
+//
+int ClientMain(Options const& o, std::string const& mode, int connections, int port, int out)
+{
+    if (!RaiseFdLimit(connections + 1024))
+    {
+        ClientReport report = {0, connections};
+        WriteAll(out, &report, sizeof(report));
+        return 1;
+    }
+
+    // Verifies nothing: the server's certificate is the self-signed test one
+    //
+    io::ssl::Context sslCtx(io::ssl::Mode::Client);
+
+    const int threads = std::max(1, std::min(o.clientThreads, connections));
+    std::vector<std::unique_ptr<Cooperator>> coops;
+    std::vector<std::unique_ptr<Thread>> coopThreads;
+    for (int t = 0; t < threads; t++)
+    {
+        coops.push_back(std::make_unique<Cooperator>());
+        coopThreads.push_back(std::make_unique<Thread>(coops.back().get()));
+
+        const int first = connections * t / threads;
+        const int last = connections * (t + 1) / threads;
+        coops.back()->Submit([&, first, last](Context* ctx)
+        {
+            auto* co = ctx->GetCooperator();
+            Semaphore inflight(o.inflight);
+            Coordinator never(ctx);
+            const SpawnConfiguration session = {
+                .priority = 0, .stackSize = IsTls(mode) ? 65536u : 16384u};
+            for (int i = first; i < last; i++)
+            {
+                inflight.Acquire(ctx);
+                co->Spawn(session, [&, i](Context* c)
+                {
+                    Session(c, mode, sslCtx, i, port, inflight, never);
+                });
+            }
+
+            // Holding never keeps the sessions parked; this context only has to outlive them
+            //
+            while (!ctx->IsKilled())
+            {
+                time::Sleep(ctx, std::chrono::seconds(1));
+            }
+        });
+    }
+
+    while (g_connected.load() + g_failed.load() < connections)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ClientReport report = {g_connected.load(), g_failed.load()};
+    WriteAll(out, &report, sizeof(report));
+    pause();
+    _exit(0);
+}
+
+// ---------------------------------------------------------------------------
+// Orchestration
+// ---------------------------------------------------------------------------
+
+void RunCell(Options const& o, std::string const& mode, int connections, int port)
+{
+    int toServer[2], fromServer[2], fromClient[2];
+    if (pipe(toServer) < 0 || pipe(fromServer) < 0 || pipe(fromClient) < 0)
+    {
+        printf("%-12s %8d  failed: pipe: %s\n", mode.c_str(), connections, strerror(errno));
+        return;
+    }
+    fflush(stdout);
+
+    pid_t server = fork();
+    if (server == 0)
+    {
+        close(toServer[1]);
+        close(fromServer[0]);
+        close(fromClient[0]);
+        close(fromClient[1]);
+        _exit(ServerMain(o, mode, connections, port, toServer[0], fromServer[1]));
+    }
+    close(toServer[0]);
+    close(fromServer[1]);
+
+    Report report = {};
+    ClientReport clients = {};
+    pid_t client = -1;
+    char ready;
+    if (ReadAll(fromServer[0], &ready, 1))
+    {
+        client = fork();
+        if (client == 0)
+        {
+            close(toServer[1]);
+            close(fromServer[0]);
+            close(fromClient[0]);
+            _exit(ClientMain(o, mode, connections, port, fromClient[1]));
+        }
+        close(fromClient[1]);
+        ReadAll(fromClient[0], &clients, sizeof(clients));
+        char go = 1;
+        WriteAll(toServer[1], &go, 1);
+        ReadAll(fromServer[0], &report, sizeof(report));
+    }
+    else
+    {
+        ReadAll(fromServer[0], &report, sizeof(report));
+        close(fromClient[1]);
+    }
+
+    for (pid_t pid : {client, server})
+    {
+        if (pid > 0)
+        {
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+        }
+    }
+    close(toServer[1]);
+    close(fromServer[0]);
+    close(fromClient[0]);
+
+    if (!report.ok || clients.connected == 0)
+    {
+        printf("%-12s %8d  failed: %s\n", mode.c_str(), connections,
+               !report.ok ? "server setup (fd limit, or --cert/--key unreadable)"
+                          : "no connection came up");
+        return;
+    }
+
+    const double n = clients.connected;
+    Sample const& b = report.base;
+    Sample const& i = report.idle;
+    auto per = [n](double after, double before) { return (after - before) / n; };
+    const double page = static_cast<double>(sysconf(_SC_PAGESIZE));
+
+    char note[64] = "";
+    if (clients.failed)
+    {
+        snprintf(note, sizeof(note), "%d failed", clients.failed);
+    }
+    else if (mode == "ktls")
+    {
+        snprintf(note, sizeof(note), "kTLS on %d/%d", report.ktlsActive, clients.connected);
+    }
+    printf("%-12s %8d %8d %9.0f %9.0f %6.2f %9.0f %9.0f %9.0f %9.0f %10.0f  %s\n", mode.c_str(),
+           connections, clients.connected, per(i.rssKb * 1024.0, b.rssKb * 1024.0),
+           per(i.anonKb * 1024.0, b.anonKb * 1024.0),
+           per(i.contexts.contexts, b.contexts.contexts),
+           per(i.contexts.stackCommitted, b.contexts.stackCommitted),
+           per(i.contexts.heapHighWater, b.contexts.heapHighWater),
+           per(i.taggedBytes, b.taggedBytes), per(i.tcpPages * page, b.tcpPages * page),
+           i.stackPoolBytes / 1024.0, note);
+    fflush(stdout);
+}
+
+template<typename T, typename Parse>
+std::vector<T> SplitList(const char* s, Parse parse)
+{
+    std::vector<T> out;
+    std::string item;
+    for (const char* p = s;; p++)
+    {
+        if (*p == ',' || !*p)
+        {
+            if (!item.empty()) out.push_back(parse(item));
+            item.clear();
+            if (!*p) break;
+        }
+        else
+        {
+            item += *p;
+        }
+    }
+    return out;
+}
+
+} // end anonymous namespace
+
+int main(int argc, char** argv)
+{
+    Options o;
+    for (int i = 1; i < argc; i++)
+    {
+        auto eq = [&](const char* k) { return strncmp(argv[i], k, strlen(k)) == 0; };
+        auto value = [&] { return strchr(argv[i], '=') + 1; };
+        auto asString = [](std::string const& s) { return s; };
+        auto asInt = [](std::string const& s) { return atoi(s.c_str()); };
+        if (eq("--modes=")) o.modes = SplitList<std::string>(value(), asString);
+        else if (eq("--connections=")) o.connections = SplitList<int>(value(), asInt);
+        else if (eq("--settle=")) o.settleMs = atoi(value());
+        else if (eq("--port=")) o.port = atoi(value());
+        else if (eq("--client-threads=")) o.clientThreads = atoi(value());
+        else if (eq("--inflight=")) o.inflight = std::max(1, atoi(value()));
+        else if (eq("--cert=")) o.cert = value();
+        else if (eq("--key=")) o.key = value();
+        else
+        {
+            fprintf(stderr, "unknown option %s (see the comment at the top of "
+                    "bench_footprint.cpp)\n", argv[i]);
+            return 2;
+        }
+    }
+    const char* known[] = {"plain", "stackless", "buffer-ring", "tls", "ktls", "ws"};
+    for (auto const& mode : o.modes)
+    {
+        if (std::find_if(std::begin(known), std::end(known),
+                         [&](const char* k) { return mode == k; }) == std::end(known))
+        {
+            fprintf(stderr, "unknown mode %s\n", mode.c_str());
+            return 2;
+        }
+    }
+
+    printf("%-12s %8s %8s %9s %9s %6s %9s %9s %9s %9s %10s  %s\n", "mode", "conns", "up",
+           "rss B/c", "anon B/c", "ctx/c", "stack B/c", "heap B/c", "tagged", "tcp B/c",
+           "pool KiB", "note");
+
+    // A port per cell: the last cell's connections may still hold the previous one in TIME_WAIT
+    //
+    int port = o.port;
+    for (auto const& mode : o.modes)
+    {
+        for (int connections : o.connections)
+        {
+            if (connections > 0)
+            {
+                RunCell(o, mode, connections, port++);
+            }
+        }
+    }
+    return 0;
+}
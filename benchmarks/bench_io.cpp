@@ -1,6 +1,7 @@
 #include <cassert>
 #include <deque>
 #include <functional>
+#include <sys/resource.h>
 #include <sys/socket.h>
 #include <vector>
 
@@ -12,7 +13,9 @@
 #include "coop/self.h"
 #include "coop/thread.h"
 
+#include "coop/io/completion.h"
 #include "coop/io/descriptor.h"
+#include "coop/io/handle.h"
 #include "coop/io/recv.h"
 #include "coop/io/send.h"
 
@@ -200,7 +203,7 @@ static void BM_IO_PingPong_Impl(benchmark::State& state)
         //
         done = true;
         coop::io::Send(a, msg, MSG_SIZE);
-        while (!pongerExited) ctx->Yield(true);
+        while (!pongerExited) ctx->Yield();
     });
 }
 
@@ -285,7 +288,7 @@ static void BM_IO_PingPong_Scale_Impl(benchmark::State& state)
         done = true;
         for (int i = 0; i < N; i++)
             coop::io::Send(writers[i], msg, MSG_SIZE);
-        while (exited < N) ctx->Yield(true);
+        while (exited < N) ctx->Yield();
     });
 }
 
@@ -432,3 +435,148 @@ static void BM_IO_SequentialSend(benchmark::State& state)
 }
 BENCHMARK(BM_IO_SequentialSend)
     ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32);
+
+// ---------------------------------------------------------------------------
+// 6. Echo server at scale: a context per connection vs a continuation per connection
+// ---------------------------------------------------------------------------
+//
+// N socketpairs, each with an echo server on one end: a context looping blocking Recv -> Send, or
+// a stackless EchoMachine whose continuation-driven Handle runs it inline from the reap loop. Each
+// iteration the client sends one message on every connection, then reads every echo back, so all
+// N servers are in flight at once. items/s = echoes/s. The continuation design parks no stack and
+// switches no context; the difference is what a context per connection costs at this fan-out.
+//
+struct EchoMachine final : coop::Continuation
+{
+    explicit EchoMachine(int fd, int* closed)
+    : m_desc(fd)
+    , m_handle(m_desc, static_cast<coop::Continuation*>(this))
+    , m_closed(closed)
+    {
+        coop::io::Recv(m_handle, m_buf, MSG_SIZE);
+    }
+
+    void Run() final
+    {
+        int r = m_handle.Result();
+        if (r <= 0)
+        {
+            ++*m_closed;
+            return;
+        }
+        m_receiving = !m_receiving;
+        if (m_receiving)
+        {
+            coop::io::Recv(m_handle, m_buf, MSG_SIZE);
+        }
+        else
+        {
+            coop::io::Send(m_handle, m_buf, r);
+        }
+    }
+
+    coop::io::Descriptor m_desc;
+    coop::io::Handle     m_handle;
+    int*                 m_closed;
+    bool                 m_receiving = true;
+    char                 m_buf[MSG_SIZE];
+};
+
+// Two fds per connection plus headroom; false if the hard limit does not allow it
+//
+static bool RaiseFdLimit(int connections)
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0)
+    {
+        return false;
+    }
+    rlim_t want = 2 * static_cast<rlim_t>(connections) + 256;
+    if (limit.rlim_cur >= want)
+    {
+        return true;
+    }
+    if (limit.rlim_max < want)
+    {
+        return false;
+    }
+    limit.rlim_cur = want;
+    return setrlimit(RLIMIT_NOFILE, &limit) == 0;
+}
+
+template<bool Continuations>
+static void BM_IO_Echo_Impl(benchmark::State& state)
+{
+    const int N = state.range(0);
+    if (!RaiseFdLimit(N))
+    {
+        state.SkipWithError("RLIMIT_NOFILE too low for this many connections");
+        return;
+    }
+
+    RunBenchmark(state, [N](coop::Context* ctx, benchmark::State& state)
+    {
+        std::deque<coop::io::Descriptor> clients;
+        std::deque<EchoMachine> machines;
+        int closed = 0;
+
+        static constexpr coop::SpawnConfiguration config = {.priority = 0, .stackSize = 8192};
+        for (int i = 0; i < N; i++)
+        {
+            int fds[2];
+            MakeSocketPair(fds);
+            clients.emplace_back(fds[0]);
+            if constexpr (Continuations)
+            {
+                machines.emplace_back(fds[1], &closed);
+            }
+            else
+            {
+                int fd = fds[1];
+                ctx->GetCooperator()->Spawn(config, [&closed, fd](coop::Context*)
+                {
+                    coop::io::Descriptor desc(fd);
+                    char buf[MSG_SIZE];
+                    int r;
+                    while ((r = coop::io::Recv(desc, buf, MSG_SIZE)) > 0)
+                    {
+                        coop::io::Send(desc, buf, r);
+                    }
+                    ++closed;
+                });
+            }
+        }
+
+        char msg[MSG_SIZE] = {};
+        char buf[MSG_SIZE] = {};
+        for (auto _ : state)
+        {
+            for (int i = 0; i < N; i++)
+            {
+                coop::io::Send(clients[i], msg, MSG_SIZE);
+            }
+            for (int i = 0; i < N; i++)
+            {
+                coop::io::Recv(clients[i], buf, MSG_SIZE);
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * N);
+
+        // Half-close every client; each server sees end of stream and stops
+        //
+        for (auto& client : clients)
+        {
+            ::shutdown(client.m_fd, SHUT_WR);
+        }
+        while (closed < N)
+        {
+            ctx->Yield();
+        }
+    });
+}
+
+static void BM_IO_Echo_Contexts(benchmark::State& s) { BM_IO_Echo_Impl<false>(s); }
+BENCHMARK(BM_IO_Echo_Contexts)->Arg(100)->Arg(1000)->Arg(10000)->UseRealTime();
+
+static void BM_IO_Echo_Continuations(benchmark::State& s) { BM_IO_Echo_Impl<true>(s); }
+BENCHMARK(BM_IO_Echo_Continuations)->Arg(100)->Arg(1000)->Arg(10000)->UseRealTime();
@@ -8,6 +8,8 @@
 
 #include <benchmark/benchmark.h>
 
+#include "coroutine_uring.h"
+
 static constexpr int MSG_SIZE = 64;
 
 // ---------------------------------------------------------------------------
@@ -463,3 +465,124 @@ static void BM_Epoll_PingPong_Scale(benchmark::State& state)
 }
 BENCHMARK(BM_Epoll_PingPong_Scale)
     ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Arg(64)->Arg(128)->Arg(256);
+
+// ---------------------------------------------------------------------------
+// 4. C++20 coroutines + io_uring (single-threaded, coroutine_uring.h)
+// ---------------------------------------------------------------------------
+//
+// The stackless counterpart to coop's BM_IO_RoundTrip and ping-pong: the same uring ops, awaited
+// from coroutines on a loop with nothing else on it. The gap to coop is what a stackful context,
+// its scheduler and Descriptor cost over the bare minimum.
+//
+
+static coro::Task RoundTripLoop(benchmark::State& state, int writer, int reader)
+{
+    char msg[MSG_SIZE] = {};
+    char buf[MSG_SIZE] = {};
+    for (auto _ : state)
+    {
+        int n = co_await coro::Send(writer, msg, MSG_SIZE);
+        assert(n == MSG_SIZE);
+        n = co_await coro::Recv(reader, buf, MSG_SIZE);
+        assert(n == MSG_SIZE);
+        (void)n;
+    }
+}
+
+// One coroutine. send + recv per iteration, each a submit and a completion.
+//
+static void BM_Coroutine_RoundTrip(benchmark::State& state)
+{
+    int fds[2];
+    MakeSocketPair(fds);
+
+    coro::Loop loop;
+    loop.Spawn(RoundTripLoop(state, fds[0], fds[1]));
+    loop.Run();
+
+    close(fds[0]);
+    close(fds[1]);
+}
+BENCHMARK(BM_Coroutine_RoundTrip);
+
+// Echo whatever arrives until the peer shuts its side down
+//
+static coro::Task EchoLoop(int fd)
+{
+    char buf[MSG_SIZE];
+    for (;;)
+    {
+        int n = co_await coro::Recv(fd, buf, MSG_SIZE);
+        if (n <= 0)
+        {
+            break;
+        }
+        co_await coro::Send(fd, buf, n);
+    }
+}
+
+static coro::Task PingLoop(benchmark::State& state, std::vector<int> const& writers)
+{
+    char msg[MSG_SIZE] = {};
+    char buf[MSG_SIZE] = {};
+    for (auto _ : state)
+    {
+        for (int fd : writers)
+        {
+            co_await coro::Send(fd, msg, MSG_SIZE);
+            int n = co_await coro::Recv(fd, buf, MSG_SIZE);
+            assert(n == MSG_SIZE);
+            (void)n;
+        }
+    }
+    for (int fd : writers)
+    {
+        shutdown(fd, SHUT_WR);
+    }
+}
+
+// N echo coroutines, each on its own socketpair; the driver coroutine goes round them in turn
+//
+static void RunCoroutinePingPong(benchmark::State& state, int N)
+{
+    std::vector<int> writerFds(N);
+    std::vector<int> readerFds(N);
+    for (int i = 0; i < N; i++)
+    {
+        int fds[2];
+        MakeSocketPair(fds);
+        writerFds[i] = fds[0];
+        readerFds[i] = fds[1];
+    }
+
+    {
+        coro::Loop loop;
+        for (int fd : readerFds)
+        {
+            loop.Spawn(EchoLoop(fd));
+        }
+        loop.Spawn(PingLoop(state, writerFds));
+        loop.Run();
+    }
+
+    for (int i = 0; i < N; i++)
+    {
+        close(writerFds[i]);
+        close(readerFds[i]);
+    }
+}
+
+// Two coroutines. Driver: send -> recv. Echo: recv -> send.
+//
+static void BM_Coroutine_PingPong(benchmark::State& state)
+{
+    RunCoroutinePingPong(state, 1);
+}
+BENCHMARK(BM_Coroutine_PingPong);
+
+static void BM_Coroutine_PingPong_Scale(benchmark::State& state)
+{
+    RunCoroutinePingPong(state, state.range(0));
+}
+BENCHMARK(BM_Coroutine_PingPong_Scale)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Arg(64)->Arg(128)->Arg(256);
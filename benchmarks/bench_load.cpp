@@ -0,0 +1,491 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <new>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "coop/cooperator.h"
+#include "coop/cooperator_configuration.h"
+#include "coop/launchable.h"
+#include "coop/thread.h"
+#include "coop/http/client.h"
+#include "coop/http/tls_transport.h"
+#include "coop/http/transport.h"
+#include "coop/io/connect.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/ssl/connection.h"
+#include "coop/io/ssl/context.h"
+#include "coop/perf/histogram.h"
+#include "coop/time/now.h"
+#include "coop/time/sleep.h"
+
+// Open-loop HTTP load generator. Unlike bench_client (and wrk), which send the next request when
+// the last one answers, this one sends on a fixed schedule: the target rate is split evenly over
+// the connections, and connection k sends its i-th request at start + (i + k / connections) *
+// period. A request's latency runs from that intended send time, not from when it went out, so a
+// server stall is charged to every request that should have been sent during it -- the
+// coordinated-omission correction wrk2 makes. A connection that has fallen behind sends at once
+// until it catches up; those requests are counted as behind schedule.
+//
+// Modes: keep-alive (the default) holds each connection for the whole run; --churn N closes it
+// after N requests and reconnects at the next intended send time, so the connect (and with --tls,
+// the handshake) is in the latency of the first request on it. --churn 1 is a connection per
+// request.
+//
+// Results go to stdout: a summary with percentiles, --hdr adds the percentile spectrum in
+// HdrHistogram's text layout, and --json replaces both with a single JSON object for scripts
+// (benchmarks/macro.sh). Progress goes to stderr.
+//
+//   bench_load --rate 50000 -c 64 --workers 2 --first-core 4 -d 10 --warmup 2 --path /plaintext
+//
+
+using namespace coop;
+
+namespace
+{
+
+struct Options
+{
+    const char* host = "127.0.0.1";
+    int         port = 8080;
+    const char* path = "/plaintext";
+    int64_t     rate = 10000;               // requests per second over all connections
+    int         connections = 64;
+    int         workers = 1;
+    int         firstCore = -1;             // pin worker w to firstCore + w; -1 leaves them
+    int         duration = 10;              // measured seconds
+    int         warmup = 2;                 // unmeasured seconds before them
+    int         churn = 0;                  // requests per connection; 0 for keep-alive
+    int         timeoutMs = 2000;           // per request, and per connect
+    bool        tls = false;
+    bool        hdr = false;
+    bool        json = false;
+};
+
+Options s_options;
+io::ssl::Context* s_sslContext = nullptr;
+
+// The schedule, CLOCK_MONOTONIC ns: sends start at s_startNs, are measured from s_measureNs, and
+// stop at s_endNs. s_periodNs is one connection's interval between sends.
+//
+int64_t s_startNs;
+int64_t s_measureNs;
+int64_t s_endNs;
+int64_t s_periodNs;
+
+std::atomic<int64_t> g_requests{0};
+std::atomic<int64_t> g_errors{0};
+std::atomic<int>     g_live{0};
+
+// One worker cooperator's results, written only by its connections and read after it is joined
+//
+struct WorkerStats
+{
+    perf::Histogram latency;                // ns from intended send to the response's end
+    uint64_t        requests = 0;           // measured and answered 2xx
+    uint64_t        errors = 0;             // measured and failed: connect, send, recv or status
+    uint64_t        behind = 0;             // measured and sent a period or more late
+    uint64_t        connects = 0;
+};
+
+// One connection's schedule, reconnecting as the mode or the server requires
+//
+struct LoadConnection : Launchable
+{
+    LoadConnection(Context* ctx, WorkerStats* stats, int index)
+    : Launchable(ctx)
+    , m_stats(stats)
+    , m_next(s_startNs + s_periodNs * index / s_options.connections)
+    {
+        ctx->SetName("LoadConnection");
+        ctx->Detach();
+    }
+
+    virtual void Launch() final
+    {
+        bool reconnect = false;
+        while (m_next < s_endNs && !GetContext()->IsKilled())
+        {
+            // A reconnect waits for its request's send time, so the connect is part of it
+            //
+            if (reconnect && !WaitUntil(m_next))
+            {
+                break;
+            }
+            Session();
+            reconnect = true;
+        }
+        g_live.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+  private:
+    bool Measured() const { return m_next >= s_measureNs; }
+
+    bool WaitUntil(int64_t ns)
+    {
+        const int64_t now = time::MonotonicNanos();
+        if (ns - now < 1000)
+        {
+            return !GetContext()->IsKilled();
+        }
+        return time::Sleep(GetContext(), time::Interval((ns - now) / 1000)) ==
+               time::SleepResult::Ok;
+    }
+
+    // The request at m_next failed
+    //
+    void Fail()
+    {
+        if (Measured())
+        {
+            m_stats->errors++;
+            g_errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_next += s_periodNs;
+    }
+
+    void Session()
+    {
+        const time::Interval timeout = std::chrono::milliseconds(s_options.timeoutMs);
+        int fd = io::ConnectAny(s_options.host, s_options.port, timeout);
+        if (fd < 0)
+        {
+            Fail();
+            return;
+        }
+        m_stats->connects++;
+
+        io::Descriptor desc(fd);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        if (!s_options.tls)
+        {
+            Exchange(http::PlaintextTransport(desc));
+            return;
+        }
+
+        io::ssl::Connection ssl(*s_sslContext, desc, io::ssl::SocketBio{});
+        in6_addr addr;
+        if (inet_pton(AF_INET, s_options.host, &addr) != 1 &&
+            inet_pton(AF_INET6, s_options.host, &addr) != 1)
+        {
+            SSL_set_tlsext_host_name(ssl.m_ssl, s_options.host);
+        }
+        if (ssl.HandshakeKill() != 0)
+        {
+            Fail();
+            return;
+        }
+        Exchange(http::TlsTransport(ssl, desc));
+    }
+
+    // Send on schedule until the run ends, the connection fails or closes, or churn retires it
+    //
+    template<typename Transport>
+    void Exchange(Transport transport)
+    {
+        using Client = http::ClientConnection<Transport>;
+        void* mem = std::malloc(sizeof(Client) + Client::ExtraBytes());
+        auto* conn = new (mem) Client(transport, s_options.host, Client::DEFAULT_RECV_SIZE,
+                                      Client::DEFAULT_SEND_SIZE,
+                                      std::chrono::milliseconds(s_options.timeoutMs));
+
+        int served = 0;
+        while (m_next < s_endNs && WaitUntil(m_next))
+        {
+            const int64_t sent = time::MonotonicNanos();
+            http::ResponseLine* response = nullptr;
+            if (!conn->Get(s_options.path) || !(response = conn->GetResponseLine()))
+            {
+                Fail();
+                break;
+            }
+            conn->SkipBody();
+            if (response->status < 200 || response->status >= 300)
+            {
+                Fail();
+            }
+            else
+            {
+                const int64_t done = time::MonotonicNanos();
+                if (Measured())
+                {
+                    m_stats->latency.Record(static_cast<uint64_t>(done - m_next));
+                    m_stats->requests++;
+                    m_stats->behind += sent - m_next >= s_periodNs;
+                    g_requests.fetch_add(1, std::memory_order_relaxed);
+                }
+                m_next += s_periodNs;
+            }
+
+            if (!conn->KeepAlive() || (s_options.churn && ++served >= s_options.churn))
+            {
+                break;
+            }
+            conn->Reset();
+        }
+
+        conn->~Client();
+        std::free(mem);
+    }
+
+    WorkerStats* m_stats;
+    int64_t      m_next;        // the intended send time of this connection's next request
+};
+
+bool LoadFile(const char* path, std::vector<char>& out)
+{
+    FILE* f = fopen(path, "r");
+    if (!f)
+    {
+        return false;
+    }
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    {
+        out.insert(out.end(), buf, buf + n);
+    }
+    fclose(f);
+    return true;
+}
+
+double Micros(uint64_t ns)
+{
+    return static_cast<double>(ns) / 1000.0;
+}
+
+constexpr double kQuantiles[] = {0.5, 0.75, 0.9, 0.99, 0.999, 0.9999};
+constexpr const char* kQuantileNames[] = {"p50", "p75", "p90", "p99", "p999", "p9999"};
+
+// Each occupied bucket's top, as wrk2 and HdrHistogram print their percentile spectrum
+//
+void PrintSpectrum(perf::Histogram const& h)
+{
+    printf("\n%12s %14s %12s %14s\n\n", "Value(us)", "Percentile", "TotalCount",
+           "1/(1-Percentile)");
+    uint64_t seen = 0;
+    for (size_t i = 0; i < perf::Histogram::kBuckets; i++)
+    {
+        if (!h.buckets[i])
+        {
+            continue;
+        }
+        seen += h.buckets[i];
+        const uint64_t value = std::min(perf::Histogram::BucketHigh(i), h.max);
+        const double percentile = static_cast<double>(seen) / static_cast<double>(h.count);
+        if (seen < h.count)
+        {
+            printf("%12.3f %14.12f %12lu %14.2f\n", Micros(value), percentile, seen,
+                   1.0 / (1.0 - percentile));
+        }
+        else
+        {
+            printf("%12.3f %14.12f %12lu %14s\n", Micros(value), percentile, seen, "inf");
+        }
+    }
+    printf("#[Mean    = %12.3f, Max     = %12.3f]\n", Micros(h.Mean()), Micros(h.max));
+    printf("#[Buckets = %12zu, SubBuckets = %8u]\n", perf::Histogram::kBuckets,
+           perf::Histogram::kSubBuckets);
+}
+
+void Usage()
+{
+    fprintf(stderr,
+            "usage: bench_load [--host H] [--port P] [--path /p] [--rate R] [-c N] [--workers W]\n"
+            "                  [--first-core C] [-d S] [--warmup S] [--churn N] [--timeout MS]\n"
+            "                  [--tls] [--hdr] [--json]\n");
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    Options& o = s_options;
+    for (int i = 1; i < argc; i++)
+    {
+        const bool more = i + 1 < argc;
+        if (strcmp(argv[i], "--host") == 0 && more) o.host = argv[++i];
+        else if (strcmp(argv[i], "--port") == 0 && more) o.port = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--path") == 0 && more) o.path = argv[++i];
+        else if (strcmp(argv[i], "--rate") == 0 && more) o.rate = atoll(argv[++i]);
+        else if (strcmp(argv[i], "-c") == 0 && more) o.connections = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--workers") == 0 && more) o.workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--first-core") == 0 && more) o.firstCore = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-d") == 0 && more) o.duration = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--warmup") == 0 && more) o.warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--churn") == 0 && more) o.churn = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--timeout") == 0 && more) o.timeoutMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--tls") == 0) o.tls = true;
+        else if (strcmp(argv[i], "--hdr") == 0) o.hdr = true;
+        else if (strcmp(argv[i], "--json") == 0) o.json = true;
+        else
+        {
+            Usage();
+            return 2;
+        }
+    }
+
+    if (o.rate < 1 || o.connections < 1 || o.duration < 1 || o.warmup < 0)
+    {
+        Usage();
+        return 2;
+    }
+    o.workers = std::max(1, std::min(o.workers, o.connections));
+
+    // The client side of a TLS run verifies nothing: the bench server's certificate is the
+    // self-signed test one
+    //
+    io::ssl::Context sslContext(io::ssl::Mode::Client);
+    s_sslContext = &sslContext;
+
+    s_periodNs = static_cast<int64_t>(o.connections) * 1000000000 / o.rate;
+    if (s_periodNs < 1)
+    {
+        s_periodNs = 1;
+    }
+
+    fprintf(stderr, "bench_load: %ld req/s over %d connection%s on %d worker%s, %s%s, "
+            "%ds + %ds warmup, %s:%d%s\n", o.rate, o.connections, o.connections > 1 ? "s" : "",
+            o.workers, o.workers > 1 ? "s" : "", o.churn ? "churn" : "keep-alive",
+            o.tls ? " TLS" : "", o.duration, o.warmup, o.host, o.port, o.path);
+
+    // The first sends wait out the time the connections take to come up
+    //
+    s_startNs = time::MonotonicNanos() + 200 * 1000000LL;
+    s_measureNs = s_startNs + o.warmup * 1000000000LL;
+    s_endNs = s_measureNs + o.duration * 1000000000LL;
+
+    struct Worker
+    {
+        Cooperator* cooperator;
+        Thread*     thread;
+    };
+
+    std::vector<WorkerStats> stats(o.workers);
+    std::vector<Worker> pool;
+    pool.reserve(o.workers);
+    g_live.store(o.connections, std::memory_order_relaxed);
+
+    for (int w = 0; w < o.workers; w++)
+    {
+        char nameBuf[32];
+        snprintf(nameBuf, sizeof(nameBuf), "load-%d", w);
+
+        CooperatorConfiguration config = s_defaultCooperatorConfiguration;
+        config.SetName(nameBuf);
+
+        auto* co = new Cooperator(config);
+        auto* th = new Thread(co);
+        if (o.firstCore >= 0)
+        {
+            th->PinToCore(o.firstCore + w);
+        }
+        pool.push_back({co, th});
+
+        // Connections dealt round-robin, so their phases interleave across workers
+        //
+        WorkerStats* workerStats = &stats[w];
+        const int workers = o.workers;
+        co->Submit([=](Context* ctx) {
+            static constexpr SpawnConfiguration connectionConfig =
+                {.priority = 0, .stackSize = 65536};
+            for (int c = w; c < s_options.connections; c += workers)
+            {
+                ctx->GetCooperator()->Launch<LoadConnection>(connectionConfig, workerStats, c);
+            }
+        });
+    }
+
+    // Progress each second of the measured window, then a grace of one timeout for the last
+    // responses
+    //
+    int reported = 0;
+    int64_t prevRequests = 0;
+    const int64_t graceNs = s_endNs + o.timeoutMs * 1000000LL;
+    while (g_live.load(std::memory_order_relaxed) > 0 && time::MonotonicNanos() < graceNs)
+    {
+        usleep(100000);
+        if (reported < o.duration &&
+            time::MonotonicNanos() >= s_measureNs + (reported + 1) * 1000000000LL)
+        {
+            reported++;
+            const int64_t cur = g_requests.load(std::memory_order_relaxed);
+            fprintf(stderr, "  [%2d/%ds]  %8ld req/s  errors: %ld\n", reported, o.duration,
+                    cur - prevRequests, g_errors.load(std::memory_order_relaxed));
+            prevRequests = cur;
+        }
+    }
+
+    for (auto& w : pool)
+    {
+        w.cooperator->Shutdown();
+    }
+    for (auto& w : pool)
+    {
+        delete w.thread;
+        delete w.cooperator;
+    }
+
+    WorkerStats total;
+    for (auto const& s : stats)
+    {
+        total.latency.Merge(s.latency);
+        total.requests += s.requests;
+        total.errors += s.errors;
+        total.behind += s.behind;
+        total.connects += s.connects;
+    }
+    const double achieved = static_cast<double>(total.requests) / o.duration;
+    perf::Histogram const& h = total.latency;
+
+    if (o.json)
+    {
+        printf("{\"rate\":%ld,\"achieved\":%.1f,\"connections\":%d,\"workers\":%d,"
+               "\"mode\":\"%s\",\"churn\":%d,\"tls\":%s,\"duration\":%d,\"requests\":%lu,"
+               "\"errors\":%lu,\"behind\":%lu,\"connects\":%lu,\"latency_us\":{\"mean\":%.3f",
+               o.rate, achieved, o.connections, o.workers, o.churn ? "churn" : "keep-alive",
+               o.churn, o.tls ? "true" : "false", o.duration, total.requests, total.errors,
+               total.behind, total.connects, Micros(h.Mean()));
+        for (size_t q = 0; q < sizeof(kQuantiles) / sizeof(kQuantiles[0]); q++)
+        {
+            printf(",\"%s\":%.3f", kQuantileNames[q], Micros(h.Quantile(kQuantiles[q])));
+        }
+        printf(",\"max\":%.3f}}\n", Micros(h.max));
+        return 0;
+    }
+
+    printf("  Target:     %ld req/s\n", o.rate);
+    printf("  Achieved:   %.1f req/s (%lu requests in %ds)\n", achieved, total.requests,
+           o.duration);
+    printf("  Errors:     %lu\n", total.errors);
+    printf("  Behind:     %lu sent a period or more late\n", total.behind);
+    printf("  Connects:   %lu\n", total.connects);
+    printf("  Latency (us, from intended send):\n   ");
+    for (size_t q = 0; q < sizeof(kQuantiles) / sizeof(kQuantiles[0]); q++)
+    {
+        printf(" %s %.1f", kQuantileNames[q], Micros(h.Quantile(kQuantiles[q])));
+    }
+    printf(" max %.1f mean %.1f\n", Micros(h.max), Micros(h.Mean()));
+    if (total.behind * 10 > total.requests)
+    {
+        printf("  Warning: over a tenth of the requests went out late; the server is saturated "
+               "or the generator needs more --workers\n");
+    }
+    if (o.hdr)
+    {
+        PrintSpectrum(h);
+    }
+    return 0;
+}
@@ -1,3 +1,4 @@
+#include <atomic>
 #include <functional>
 
 #include <benchmark/benchmark.h>
@@ -9,6 +10,7 @@
 #include "coop/thread.h"
 #include "coop/perf/counters.h"
 #include "coop/perf/patch.h"
+#include "coop/sharded_counter.h"
 
 // ---------------------------------------------------------------------------
 // Helper: run a benchmark body inside a cooperator
@@ -55,7 +57,7 @@ static void BM_Perf_Yield(benchmark::State& state)
     {
         for (auto _ : state)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
     });
 }
@@ -76,7 +78,7 @@ static void BM_Perf_Yield_Enabled(benchmark::State& state)
     {
         for (auto _ : state)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
     });
 
@@ -157,16 +159,51 @@ static void BM_Perf_YieldScaled(benchmark::State& state)
         {
             co->Spawn([](coop::Context* c)
             {
-                while (!c->IsKilled()) c->Yield(true);
+                while (!c->IsKilled()) c->Yield();
             });
         }
 
-        ctx->Yield(true);
+        ctx->Yield();
 
         for (auto _ : state)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
     });
 }
 BENCHMARK(BM_Perf_YieldScaled)->Arg(4)->Arg(16)->Arg(64);
+
+// ---------------------------------------------------------------------------
+// BM_Counter_Sharded / BM_Counter_SharedAtomic — an application counter bumped from N threads
+// ---------------------------------------------------------------------------
+//
+// Every benchmark thread runs its own cooperator and adds to one counter as fast as it can. The
+// sharded counter writes a slot in its own cooperator's storage; the shared atomic is one
+// fetch_add on one cacheline, which every core takes turns owning. The gap widens with threads.
+//
+static coop::ShardedCounter s_benchCounter("bench_counter", "BM_Counter_Sharded adds");
+static std::atomic<uint64_t> s_benchAtomic{0};
+
+static void BM_Counter_Sharded(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context*, benchmark::State& state)
+    {
+        for (auto _ : state)
+        {
+            s_benchCounter.Add();
+        }
+    });
+}
+BENCHMARK(BM_Counter_Sharded)->Threads(1)->Threads(4)->Threads(16);
+
+static void BM_Counter_SharedAtomic(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context*, benchmark::State& state)
+    {
+        for (auto _ : state)
+        {
+            s_benchAtomic.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+}
+BENCHMARK(BM_Counter_SharedAtomic)->Threads(1)->Threads(4)->Threads(16);
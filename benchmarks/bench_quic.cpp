@@ -0,0 +1,203 @@
+#include <arpa/inet.h>
+#include <cassert>
+#include <functional>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/self.h"
+#include "coop/thread.h"
+#include "coop/wait_group.h"
+
+#include "coop/io/descriptor.h"
+#include "coop/io/recv.h"
+#include "coop/io/send.h"
+#include "coop/quic/endpoint.h"
+#include "coop/quic/packet.h"
+
+// ---------------------------------------------------------------------------
+// QUIC endpoint benchmarks
+//
+// Naming: BM_Quic_{Operation}_{Variant}
+// ---------------------------------------------------------------------------
+
+struct BenchmarkArgs
+{
+    benchmark::State* state;
+    std::function<void(coop::Context*, benchmark::State&)>* fn;
+};
+
+static void RunBenchmark(benchmark::State& state,
+    std::function<void(coop::Context*, benchmark::State&)> fn)
+{
+    coop::Cooperator cooperator;
+    coop::Thread t(&cooperator);
+
+    BenchmarkArgs args;
+    args.state = &state;
+    args.fn = &fn;
+
+    cooperator.Submit([](coop::Context* ctx, void* arg)
+    {
+        auto* a = static_cast<BenchmarkArgs*>(arg);
+        (*a->fn)(ctx, *a->state);
+        ctx->GetCooperator()->Shutdown();
+    }, &args);
+}
+
+static std::vector<uint8_t> ShortPacket(size_t size)
+{
+    std::vector<uint8_t> packet(size, 0xab);
+    packet[0] = 0x40;
+    return packet;
+}
+
+static sockaddr_in Loopback()
+{
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+// The design the endpoint replaces: a one-shot recvmsg and a sendmsg per datagram
+//
+static void NaiveEcho(coop::io::Descriptor& desc, bool const& stop)
+{
+    std::vector<uint8_t> buf(2048);
+    sockaddr_in6 peer;
+    while (!stop)
+    {
+        iovec iov{buf.data(), buf.size()};
+        msghdr msg{};
+        msg.msg_name = &peer;
+        msg.msg_namelen = sizeof(peer);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        int n = coop::io::RecvMsg(desc, &msg, 0, std::chrono::milliseconds(100));
+        if (n == -ETIMEDOUT)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return;
+        }
+        iov.iov_len = size_t(n);
+        coop::io::SendMsg(desc, &msg);
+    }
+}
+
+// Echo bursts of state.range(0) 1200-byte datagrams off a server socket on its own context
+//
+static void RunEcho(coop::Context* ctx, benchmark::State& state, bool naive)
+{
+    sockaddr_in addr = Loopback();
+    std::vector<int> fds;
+    if (coop::quic::OpenSteered((sockaddr*)&addr, sizeof(addr), 1, &fds) < 0)
+    {
+        state.SkipWithError("cannot open a UDP socket");
+        return;
+    }
+    sockaddr_in serverAddr{};
+    socklen_t len = sizeof(serverAddr);
+    getsockname(fds[0], (sockaddr*)&serverAddr, &len);
+    coop::io::Descriptor server(fds[0]);
+    coop::quic::Endpoint endpoint(ctx, server, 0, 1);
+
+    bool stop = false;
+    coop::WaitGroup running;
+    running.Spawn([&](coop::Context*)
+    {
+        if (naive)
+        {
+            NaiveEcho(server, stop);
+            return;
+        }
+        endpoint.Run([](coop::quic::Endpoint& self, coop::quic::Datagram const& d, void*)
+        {
+            self.Send(d.peer, d.peerLength, d.data, d.size);
+        }, nullptr);
+    });
+
+    coop::io::Descriptor client(socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0));
+    bind(client.m_fd, (sockaddr*)&addr, sizeof(addr));
+    auto packet = ShortPacket(1200);
+    std::vector<uint8_t> reply(2048);
+    int64_t burst = state.range(0);
+    for (auto _ : state)
+    {
+        for (int64_t i = 0; i < burst; i++)
+        {
+            ::sendto(client.m_fd, packet.data(), packet.size(), 0, (sockaddr*)&serverAddr,
+                     sizeof(serverAddr));
+        }
+        for (int64_t i = 0; i < burst; i++)
+        {
+            int n = coop::io::Recv(client, reply.data(), reply.size(), 0,
+                                   std::chrono::milliseconds(500));
+            if (n <= 0)
+            {
+                state.SkipWithError("lost a datagram");
+                break;
+            }
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * burst);
+
+    stop = true;
+    endpoint.Stop();
+    running.Wait(ctx);
+    if (naive)
+    {
+        return;
+    }
+    auto const& stats = endpoint.GetStats();
+    state.counters["per_completion"] = stats.completions
+        ? double(stats.received) / double(stats.completions) : 0;
+    state.counters["per_send"] = stats.sends ? double(stats.sent) / double(stats.sends) : 0;
+}
+
+// ---------------------------------------------------------------------------
+// ParseHeader: the routing work done for every datagram received
+// ---------------------------------------------------------------------------
+
+static void BM_Quic_ParseHeader_Short(benchmark::State& state)
+{
+    auto packet = ShortPacket(1200);
+    coop::quic::Header header;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(coop::quic::ParseHeader(packet.data(), packet.size(), 8,
+                                                         &header));
+        benchmark::DoNotOptimize(header);
+    }
+}
+BENCHMARK(BM_Quic_ParseHeader_Short);
+
+// ---------------------------------------------------------------------------
+// Loopback echo of a burst, by the endpoint (multishot recvmsg with GRO, GSO trains) or by the
+// naive design (a recvmsg and a sendmsg each). Reported per datagram.
+// ---------------------------------------------------------------------------
+
+static void BM_Quic_Loopback_Echo(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        RunEcho(ctx, state, false);
+    });
+}
+BENCHMARK(BM_Quic_Loopback_Echo)->Arg(1)->Arg(16)->Arg(64);
+
+static void BM_Quic_Loopback_EchoNaive(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        RunEcho(ctx, state, true);
+    });
+}
+BENCHMARK(BM_Quic_Loopback_EchoNaive)->Arg(1)->Arg(16)->Arg(64);
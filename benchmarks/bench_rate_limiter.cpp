@@ -0,0 +1,79 @@
+#include <functional>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/rate_limiter.h"
+#include "coop/thread.h"
+
+// ---------------------------------------------------------------------------
+// RateLimiter benchmarks
+//
+// Naming: BM_RateLimiter_{Operation}_{Variant}
+// ---------------------------------------------------------------------------
+
+struct BenchmarkArgs
+{
+    benchmark::State* state;
+    std::function<void(coop::Context*, benchmark::State&)>* fn;
+};
+
+static void RunBenchmark(benchmark::State& state,
+    std::function<void(coop::Context*, benchmark::State&)> fn)
+{
+    coop::Cooperator cooperator;
+    coop::Thread t(&cooperator);
+
+    BenchmarkArgs args;
+    args.state = &state;
+    args.fn = &fn;
+
+    cooperator.Submit([](coop::Context* ctx, void* arg)
+    {
+        auto* a = static_cast<BenchmarkArgs*>(arg);
+        (*a->fn)(ctx, *a->state);
+        ctx->GetCooperator()->Shutdown();
+    }, &args);
+}
+
+// A limit high enough never to refuse, so what is measured is the cost of asking
+//
+static constexpr coop::RateLimiterConfiguration OPEN = {
+    .rate = 1000000000, .burst = 1000000000, .lease = 0};
+
+// ---------------------------------------------------------------------------
+// TryAcquire on an owner, spending its lease, against a caller that is not an owner and so goes
+// to the shared pool every time -- the single-atomic bucket the leases stand in front of
+// ---------------------------------------------------------------------------
+
+static void BM_RateLimiter_TryAcquire_Leased(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        coop::RateLimiter limiter(std::vector<coop::Cooperator*>{ctx->GetCooperator()},
+                                  {.rate = OPEN.rate, .burst = OPEN.burst,
+                                   .lease = uint64_t(state.range(0))});
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(limiter.TryAcquire());
+        }
+        auto stats = limiter.GetStats();
+        state.counters["per_lease"] = stats.leases ? double(stats.admitted) / stats.leases : 0;
+    });
+}
+BENCHMARK(BM_RateLimiter_TryAcquire_Leased)->Arg(1)->Arg(64)->Arg(4096);
+
+static void BM_RateLimiter_TryAcquire_Pool(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context*, benchmark::State& state)
+    {
+        coop::RateLimiter limiter(std::vector<coop::Cooperator*>{}, OPEN);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(limiter.TryAcquire());
+        }
+    });
+}
+BENCHMARK(BM_RateLimiter_TryAcquire_Pool);
@@ -0,0 +1,234 @@
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "coop/context.h"
+#include "coop/coordinator.h"
+#include "coop/cooperator.h"
+#include "coop/self.h"
+#include "coop/thread.h"
+
+#include "coop/io/descriptor.h"
+#include "coop/io/recv.h"
+#include "coop/io/send.h"
+#include "coop/http/transport.h"
+#include "coop/resp/protocol.h"
+#include "coop/resp/server.h"
+
+// ---------------------------------------------------------------------------
+// RESP benchmarks
+//
+// Naming: BM_Resp_{Operation}_{Variant}
+// ---------------------------------------------------------------------------
+
+struct BenchmarkArgs
+{
+    benchmark::State* state;
+    std::function<void(coop::Context*, benchmark::State&)>* fn;
+};
+
+static void RunBenchmark(benchmark::State& state,
+    std::function<void(coop::Context*, benchmark::State&)> fn)
+{
+    coop::Cooperator cooperator;
+    coop::Thread t(&cooperator);
+
+    BenchmarkArgs args;
+    args.state = &state;
+    args.fn = &fn;
+
+    cooperator.Submit([](coop::Context* ctx, void* arg)
+    {
+        auto* a = static_cast<BenchmarkArgs*>(arg);
+        (*a->fn)(ctx, *a->state);
+        ctx->GetCooperator()->Shutdown();
+    }, &args);
+}
+
+static std::string Encode(std::vector<std::string> const& args)
+{
+    std::string out = "*" + std::to_string(args.size()) + "\r\n";
+    for (auto const& arg : args)
+    {
+        out += "$" + std::to_string(arg.size()) + "\r\n" + arg + "\r\n";
+    }
+    return out;
+}
+
+// A pipeline of depth GETs over 64 keys, each holding a 32-byte value, and the size of its replies
+//
+static std::string Pipeline(size_t depth, size_t* replyBytes)
+{
+    std::string wire;
+    *replyBytes = 0;
+    for (size_t i = 0; i < depth; i++)
+    {
+        wire += Encode({"GET", "key:" + std::to_string(i % 64)});
+        *replyBytes += 5 + 32 + 2;
+    }
+    return wire;
+}
+
+static void Populate(coop::Context* ctx, coop::resp::Cache& cache)
+{
+    for (int i = 0; i < 64; i++)
+    {
+        cache.Put(ctx, "key:" + std::to_string(i), std::string(32, 'v'));
+    }
+}
+
+// The design the engine replaces: each command is executed on a context of its own and answered
+// with a send of its own, the connection waiting for one before parsing the next
+//
+static void NaiveServe(coop::Context* ctx, coop::io::Descriptor& desc, coop::resp::Cache& cache)
+{
+    std::string buf(16 * 1024, '\0');
+    size_t len = 0;
+    coop::resp::Command command;
+    while (!ctx->IsKilled())
+    {
+        int n = coop::io::Recv(desc, buf.data() + len, buf.size() - len, 0);
+        if (n <= 0)
+        {
+            return;
+        }
+        len += size_t(n);
+
+        size_t pos = 0;
+        const char* error = nullptr;
+        ptrdiff_t used;
+        while ((used = coop::resp::ParseCommand(buf.data() + pos, len - pos, &command, &error)) > 0)
+        {
+            pos += size_t(used);
+            std::string key(command[1]);
+            coop::Coordinator done(ctx);
+            ctx->GetCooperator()->Spawn([&](coop::Context* child)
+            {
+                std::string reply;
+                if (auto value = cache.Get(child, key))
+                {
+                    coop::resp::AppendBulk(&reply, *value);
+                }
+                else
+                {
+                    coop::resp::AppendNull(&reply);
+                }
+                coop::io::SendAll(desc, reply.data(), reply.size());
+                done.Release(child, false);
+            });
+            done.Acquire(ctx);
+            done.Release(ctx, false);
+        }
+        buf.erase(0, pos);
+        buf.resize(16 * 1024);
+        len -= pos;
+    }
+}
+
+// Send the pipeline and read back every reply, with the server on its own context
+//
+static void RunPipeline(coop::Context* ctx, benchmark::State& state, bool naive)
+{
+    coop::resp::Cache cache(ctx, std::vector<coop::Cooperator*>{ctx->GetCooperator()});
+    Populate(ctx, cache);
+
+    int fds[2];
+    int ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    assert(ret == 0);
+    (void)ret;
+    auto* uring = coop::GetUring();
+    coop::io::Descriptor client(fds[0], uring);
+    coop::io::Descriptor server(fds[1], uring);
+
+    coop::Coordinator exited;
+    ctx->GetCooperator()->Spawn([&](coop::Context* serverCtx)
+    {
+        exited.Acquire(serverCtx);
+        if (naive)
+        {
+            NaiveServe(serverCtx, server, cache);
+        }
+        else
+        {
+            coop::resp::Serve(serverCtx, coop::http::PlaintextTransport(server), cache);
+        }
+        exited.Release(serverCtx, false);
+    });
+
+    size_t replyBytes;
+    std::string wire = Pipeline(static_cast<size_t>(state.range(0)), &replyBytes);
+    std::string reply(64 * 1024, '\0');
+    for (auto _ : state)
+    {
+        coop::io::SendAll(client, wire.data(), wire.size());
+        size_t got = 0;
+        while (got < replyBytes)
+        {
+            int n = coop::io::Recv(client, reply.data(), reply.size(), 0);
+            assert(n > 0);
+            got += size_t(n);
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+
+    client.Close();
+    exited.Acquire(ctx);
+    exited.Release(ctx, false);
+}
+
+// ---------------------------------------------------------------------------
+// Parse: a 64-command pipeline, in place
+// ---------------------------------------------------------------------------
+
+static void BM_Resp_Parse_Pipeline(benchmark::State& state)
+{
+    size_t replyBytes;
+    std::string wire = Pipeline(64, &replyBytes);
+    coop::resp::Command command;
+    const char* error = nullptr;
+
+    for (auto _ : state)
+    {
+        size_t pos = 0;
+        ptrdiff_t n;
+        while ((n = coop::resp::ParseCommand(wire.data() + pos, wire.size() - pos, &command,
+                                             &error)) > 0)
+        {
+            pos += size_t(n);
+        }
+        benchmark::DoNotOptimize(pos);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * 64);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * wire.size()));
+}
+BENCHMARK(BM_Resp_Parse_Pipeline);
+
+// ---------------------------------------------------------------------------
+// Pipelined GETs, answered by the engine (one batched lookup and one send per pipeline) or by
+// the naive design (a context and a send per command). Reported per command.
+// ---------------------------------------------------------------------------
+
+static void BM_Resp_Unix_Pipeline(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        RunPipeline(ctx, state, false);
+    });
+}
+BENCHMARK(BM_Resp_Unix_Pipeline)->Arg(1)->Arg(16)->Arg(128);
+
+static void BM_Resp_Unix_PipelineNaive(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        RunPipeline(ctx, state, true);
+    });
+}
+BENCHMARK(BM_Resp_Unix_PipelineNaive)->Arg(1)->Arg(16)->Arg(128);
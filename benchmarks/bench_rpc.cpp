@@ -0,0 +1,180 @@
+#include <cassert>
+#include <functional>
+#include <optional>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "coop/context.h"
+#include "coop/coordinator.h"
+#include "coop/cooperator.h"
+#include "coop/self.h"
+#include "coop/thread.h"
+
+#include "coop/io/descriptor.h"
+#include "coop/http/transport.h"
+#include "coop/rpc/client.h"
+#include "coop/rpc/server.h"
+
+// ---------------------------------------------------------------------------
+// RPC benchmarks
+//
+// Naming: BM_Rpc_{Operation}_{Variant}
+// ---------------------------------------------------------------------------
+
+struct BenchmarkArgs
+{
+    benchmark::State* state;
+    std::function<void(coop::Context*, benchmark::State&)>* fn;
+};
+
+static void RunBenchmark(benchmark::State& state,
+    std::function<void(coop::Context*, benchmark::State&)> fn)
+{
+    coop::Cooperator cooperator;
+    coop::Thread t(&cooperator);
+
+    BenchmarkArgs args;
+    args.state = &state;
+    args.fn = &fn;
+
+    cooperator.Submit([](coop::Context* ctx, void* arg)
+    {
+        auto* a = static_cast<BenchmarkArgs*>(arg);
+        (*a->fn)(ctx, *a->state);
+        ctx->GetCooperator()->Shutdown();
+    }, &args);
+}
+
+static void Echo(coop::rpc::Call& call)
+{
+    call.Reply(call.Request().data(), call.Request().size());
+}
+
+static void Noop(coop::rpc::Call& call)
+{
+    call.Reply(nullptr, 0);
+}
+
+static constexpr coop::rpc::MethodTable s_methods = {
+    {1, &Echo},
+    {2, &Noop},
+    {3, &Noop},
+    {7, &Noop},
+    {129, &Noop},
+};
+
+using RpcClient = coop::rpc::Client<coop::http::PlaintextTransport>;
+
+// A client and a server on the two ends of a socket pair, each on its own context
+//
+struct Loop
+{
+    Loop(coop::Context* ctx)
+    {
+        int ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+        assert(ret == 0);
+        (void)ret;
+
+        auto* uring = coop::GetUring();
+        client.emplace(fds[0], uring);
+        server.emplace(fds[1], uring);
+        ctx->GetCooperator()->Spawn([this](coop::Context* serverCtx)
+        {
+            done.Acquire(serverCtx);
+            coop::rpc::Serve(serverCtx, coop::http::PlaintextTransport(*server), s_methods);
+            done.Release(serverCtx, false);
+        });
+        rpc.emplace(coop::http::PlaintextTransport(*client));
+        rpc->Start(ctx);
+    }
+
+    void Stop(coop::Context* ctx)
+    {
+        rpc->Close(ctx);
+        client->Close();
+        done.Acquire(ctx);
+        done.Release(ctx, false);
+    }
+
+    int                                 fds[2];
+    std::optional<coop::io::Descriptor> client;
+    std::optional<coop::io::Descriptor> server;
+    std::optional<RpcClient>            rpc;
+    coop::Coordinator                   done;
+};
+
+// ---------------------------------------------------------------------------
+// MethodTable: the dispatch lookup every request pays
+// ---------------------------------------------------------------------------
+
+static void BM_Rpc_MethodTable_Find(benchmark::State& state)
+{
+    uint16_t ids[] = {1, 2, 3, 7, 129, 99};
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(s_methods.Find(ids[i++ % 6]));
+    }
+}
+BENCHMARK(BM_Rpc_MethodTable_Find);
+
+// ---------------------------------------------------------------------------
+// One call at a time: the round trip through framing, dispatch and the reader context
+// ---------------------------------------------------------------------------
+
+static void BM_Rpc_Unix_Echo(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        Loop loop(ctx);
+        std::string request(static_cast<size_t>(state.range(0)), 'r');
+        std::string response;
+
+        for (auto _ : state)
+        {
+            int rc = loop.rpc->Call(ctx, 1, request.data(), request.size(), &response);
+            assert(rc == 0);
+            (void)rc;
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * request.size() * 2);
+        loop.Stop(ctx);
+    });
+}
+BENCHMARK(BM_Rpc_Unix_Echo)->Arg(16)->Arg(1024)->Arg(64 * 1024)->Arg(1 << 20);
+
+// ---------------------------------------------------------------------------
+// Many callers on one connection: requests queued while a send is in flight leave together, and
+// the server answers each batch in one send. Reported per call.
+// ---------------------------------------------------------------------------
+
+static void BM_Rpc_Unix_Concurrent(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        Loop loop(ctx);
+        const int callers = static_cast<int>(state.range(0));
+
+        for (auto _ : state)
+        {
+            int finished = 0;
+            for (int i = 0; i < callers; i++)
+            {
+                ctx->GetCooperator()->Spawn([&](coop::Context* child)
+                {
+                    loop.rpc->Call(child, 2, "x", 1, nullptr);
+                    finished++;
+                });
+            }
+            while (finished < callers)
+            {
+                ctx->Yield();
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * callers);
+        loop.Stop(ctx);
+    });
+}
+BENCHMARK(BM_Rpc_Unix_Concurrent)->Arg(1)->Arg(8)->Arg(64);
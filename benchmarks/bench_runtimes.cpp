@@ -0,0 +1,692 @@
+// Cross-runtime comparison: the same workloads on coop, Boost.Context, Boost.Fiber and a C++20
+// coroutine loop over raw io_uring (coroutine_uring.h), one thread each, so a row of one runtime
+// lines up with the same row of the others.
+//
+//   Yield     one task yields to one other runnable task and back
+//   Spawn     start a task that exits at once and run it to completion
+//   Channel   ping-pong through two one-slot channels: send, then receive the reply
+//   Echo      64 bytes to an echoing task over a socketpair and back
+//   Http      a keep-alive GET over loopback TCP to a hello handler, and its response read
+//
+// Boost.Context has no scheduler, so its Yield is a resume of the peer and back, its Spawn a
+// fiber created, resumed and finished, and it has no Channel row. Neither Boost library has an IO
+// reactor -- a fiber in recv blocks its thread -- so Echo and Http compare coop with the coroutine
+// loop only. coop's Http handler runs the real http::Connection (parser, Date header, response
+// writer); the coroutine one scans for the blank line and sends a canned response, which is the
+// floor any HTTP stack sits on.
+//
+// Stacks are COOP_DEFAULT_STACK_SIZE for every stackful runtime, pooled for Spawn (coop's
+// StackPool, Boost's pooled_fixedsize_stack). Time is wall-clock per op, CPU the benchmark
+// thread's, and proc_cpu_ns the whole process's CPU per op: with everything on one thread it
+// differs from CPU by the kernel threads' and idle runtime threads' share.
+//
+// Built only when Boost's context and fiber libraries are found (see CMakeLists.txt).
+//
+#include <cassert>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include <boost/context/fiber.hpp>
+#include <boost/context/fixedsize_stack.hpp>
+#include <boost/context/pooled_fixedsize_stack.hpp>
+#include <boost/fiber/buffered_channel.hpp>
+#include <boost/fiber/fiber.hpp>
+#include <boost/fiber/operations.hpp>
+#include <boost/fiber/pooled_fixedsize_stack.hpp>
+
+#include "coop/alloc.h"
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator.hpp"
+#include "coop/self.h"
+#include "coop/spawn_configuration.h"
+#include "coop/thread.h"
+#include "coop/chan/channel.h"
+#include "coop/http/connection.h"
+#include "coop/http/transport.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/recv.h"
+#include "coop/io/send.h"
+
+#include "coroutine_uring.h"
+
+namespace bctx = boost::context;
+namespace bfib = boost::fibers;
+
+static constexpr int MSG_SIZE = 64;
+static const size_t kStackSize = coop::s_defaultConfiguration.stackSize;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static void RunCoop(benchmark::State& state,
+    std::function<void(coop::Context*, benchmark::State&)> fn)
+{
+    coop::Cooperator cooperator;
+    coop::Thread t(&cooperator);
+
+    struct Args
+    {
+        benchmark::State* state;
+        std::function<void(coop::Context*, benchmark::State&)>* fn;
+    } args { &state, &fn };
+
+    cooperator.Submit([](coop::Context* ctx, void* arg)
+    {
+        auto* a = static_cast<Args*>(arg);
+        (*a->fn)(ctx, *a->state);
+        ctx->GetCooperator()->Shutdown();
+    }, &args);
+}
+
+static void RunCoroutines(std::initializer_list<std::function<coro::Task()>> tasks)
+{
+    coro::Loop loop;
+    for (auto const& task : tasks)
+    {
+        loop.Spawn(task());
+    }
+    loop.Run();
+}
+
+// Process CPU time over the measured loop, reported per iteration as proc_cpu_ns
+//
+struct ProcessCpu
+{
+    explicit ProcessCpu(benchmark::State& state)
+    : m_state(state)
+    , m_start(Now())
+    {
+    }
+
+    void Stop()
+    {
+        m_state.counters["proc_cpu_ns"] = benchmark::Counter(
+            static_cast<double>(Now() - m_start), benchmark::Counter::kAvgIterations);
+    }
+
+    static int64_t Now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    benchmark::State& m_state;
+    int64_t           m_start;
+};
+
+static void MakeSocketPair(int fds[2])
+{
+    int ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    assert(ret == 0);
+    (void)ret;
+}
+
+// A connected loopback TCP pair with Nagle off: fds[0] the accepted (server) end
+//
+static void MakeTcpPair(int fds[2])
+{
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(listenFd >= 0);
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    int ret = bind(listenFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    assert(ret == 0);
+    ret = listen(listenFd, 1);
+    assert(ret == 0);
+
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd, reinterpret_cast<struct sockaddr*>(&addr), &len);
+
+    fds[1] = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fds[1] >= 0);
+    ret = connect(fds[1], reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    assert(ret == 0);
+    fds[0] = accept(listenFd, nullptr, nullptr);
+    assert(fds[0] >= 0);
+    close(listenFd);
+
+    int on = 1;
+    setsockopt(fds[0], IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    setsockopt(fds[1], IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    (void)ret;
+}
+
+static const char REQ_HELLO[] =
+    "GET / HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "\r\n";
+
+static const char RESP_BODY[] = "ok\n";
+
+static const char RESP_CANNED[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 3\r\n"
+    "\r\n"
+    "ok\n";
+
+// A response is complete once its body, which comes last, has arrived
+//
+static bool ResponseComplete(char const* buf, size_t len)
+{
+    const size_t body = sizeof(RESP_BODY) - 1;
+    return len >= body && memcmp(buf + len - body, RESP_BODY, body) == 0;
+}
+
+// ---------------------------------------------------------------------------
+// Yield
+// ---------------------------------------------------------------------------
+//
+// One op: the measured task gives the cpu up, a peer that does nothing but yield runs, and the
+// measured task runs again. For coop and Boost.Fiber that is a trip through the scheduler's run
+// queue; for the coroutine loop a trip through its ready FIFO.
+//
+
+static void BM_Runtime_Yield_Coop(benchmark::State& state)
+{
+    RunCoop(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        bool done = false;
+        ctx->GetCooperator()->Spawn([&](coop::Context* peer)
+        {
+            while (!done)
+            {
+                peer->Yield();
+            }
+        });
+
+        ProcessCpu cpu(state);
+        for (auto _ : state)
+        {
+            ctx->Yield();
+        }
+        cpu.Stop();
+        done = true;
+        ctx->Yield();
+    });
+}
+BENCHMARK(BM_Runtime_Yield_Coop)->UseRealTime();
+
+static void BM_Runtime_Yield_BoostContext(benchmark::State& state)
+{
+    bool done = false;
+    bctx::fiber peer{std::allocator_arg, bctx::fixedsize_stack(kStackSize),
+                     [&](bctx::fiber&& main)
+    {
+        while (!done)
+        {
+            main = std::move(main).resume();
+        }
+        return std::move(main);
+    }};
+    peer = std::move(peer).resume();
+
+    ProcessCpu cpu(state);
+    for (auto _ : state)
+    {
+        peer = std::move(peer).resume();
+    }
+    cpu.Stop();
+    done = true;
+    std::move(peer).resume();
+}
+BENCHMARK(BM_Runtime_Yield_BoostContext)->UseRealTime();
+
+static void BM_Runtime_Yield_BoostFiber(benchmark::State& state)
+{
+    bool done = false;
+    bfib::fiber peer(std::allocator_arg, bfib::fixedsize_stack(kStackSize), [&]
+    {
+        while (!done)
+        {
+            boost::this_fiber::yield();
+        }
+    });
+
+    ProcessCpu cpu(state);
+    for (auto _ : state)
+    {
+        boost::this_fiber::yield();
+    }
+    cpu.Stop();
+    done = true;
+    peer.join();
+}
+BENCHMARK(BM_Runtime_Yield_BoostFiber)->UseRealTime();
+
+static coro::Task YieldPeer(bool const& done)
+{
+    while (!done)
+    {
+        co_await coro::Yield{};
+    }
+}
+
+static coro::Task YieldDriver(benchmark::State& state, bool& done)
+{
+    ProcessCpu cpu(state);
+    for (auto _ : state)
+    {
+        co_await coro::Yield{};
+    }
+    cpu.Stop();
+    done = true;
+}
+
+static void BM_Runtime_Yield_Coroutine(benchmark::State& state)
+{
+    bool done = false;
+    RunCoroutines({
+        [&] { return YieldPeer(done); },
+        [&] { return YieldDriver(state, done); },
+    });
+}
+BENCHMARK(BM_Runtime_Yield_Coroutine)->UseRealTime();
+
+// ---------------------------------------------------------------------------
+// Spawn
+// ---------------------------------------------------------------------------
+//
+// One op: a task created, run until it returns, and torn down, its stack (or frame) back where
+// the next spawn takes it from. coop runs a spawned context at once; the others are resumed or
+// joined straight after creation to match.
+//
+
+static void BM_Runtime_Spawn_Coop(benchmark::State& state)
+{
+    RunCoop(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        auto* co = ctx->GetCooperator();
+        ProcessCpu cpu(state);
+        for (auto _ : state)
+        {
+            co->Spawn([](coop::Context*) {});
+        }
+        cpu.Stop();
+    });
+}
+BENCHMARK(BM_Runtime_Spawn_Coop)->UseRealTime();
+
+static void BM_Runtime_Spawn_BoostContext(benchmark::State& state)
+{
+    bctx::pooled_fixedsize_stack stacks(kStackSize);
+
+    ProcessCpu cpu(state);
+    for (auto _ : state)
+    {
+        bctx::fiber f{std::allocator_arg, stacks, [](bctx::fiber&& main)
+        {
+            return std::move(main);
+        }};
+        std::move(f).resume();
+    }
+    cpu.Stop();
+}
+BENCHMARK(BM_Runtime_Spawn_BoostContext)->UseRealTime();
+
+static void BM_Runtime_Spawn_BoostFiber(benchmark::State& state)
+{
+    bfib::pooled_fixedsize_stack stacks(kStackSize);
+
+    ProcessCpu cpu(state);
+    for (auto _ : state)
+    {
+        bfib::fiber f(std::allocator_arg, stacks, [] {});
+        f.join();
+    }
+    cpu.Stop();
+}
+BENCHMARK(BM_Runtime_Spawn_BoostFiber)->UseRealTime();
+
+static coro::Task Empty()
+{
+    co_return;
+}
+
+static coro::Task SpawnDriver(benchmark::State& state)
+{
+    ProcessCpu cpu(state);
+    for (auto _ : state)
+    {
+        co_await Empty();
+    }
+    cpu.Stop();
+}
+
+static void BM_Runtime_Spawn_Coroutine(benchmark::State& state)
+{
+    RunCoroutines({[&] { return SpawnDriver(state); }});
+}
+BENCHMARK(BM_Runtime_Spawn_Coroutine)->UseRealTime();
+
+// ---------------------------------------------------------------------------
+// Channel
+// ---------------------------------------------------------------------------
+//
+// One op: the driver sends on ping, which wakes the peer, and receives on pong, which parks it
+// until the peer has answered. Two switches, each through the runtime's wake path.
+//
+
+static void BM_Runtime_Channel_Coop(benchmark::State& state)
+{
+    RunCoop(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        int pingBuf[1];
+        int pongBuf[1];
+        coop::chan::Channel<int> ping(ctx, pingBuf, 1);
+        coop::chan::Channel<int> pong(ctx, pongBuf, 1);
+
+        ctx->GetCooperator()->Spawn([&](coop::Context*)
+        {
+            int v;
+            while (ping.Recv(v) && pong.Send(v))
+            {
+            }
+        });
+
+        ProcessCpu cpu(state);
+        for (auto _ : state)
+        {
+            int v;
+            ping.Send(1);
+            pong.Recv(v);
+            benchmark::DoNotOptimize(v);
+        }
+        cpu.Stop();
+        ping.Shutdown();
+        ctx->Yield();
+        pong.Shutdown();
+    });
+}
+BENCHMARK(BM_Runtime_Channel_Coop)->UseRealTime();
+
+static void BM_Runtime_Channel_BoostFiber(benchmark::State& state)
+{
+    // Capacity is a power of two and holds one fewer: two gives the one slot the others have
+    //
+    bfib::buffered_channel<int> ping(2);
+    bfib::buffered_channel<int> pong(2);
+
+    bfib::fiber peer(std::allocator_arg, bfib::fixedsize_stack(kStackSize), [&]
+    {
+        int v;
+        while (ping.pop(v) == bfib::channel_op_status::success &&
+               pong.push(v) == bfib::channel_op_status::success)
+        {
+        }
+    });
+
+    ProcessCpu cpu(state);
+    for (auto _ : state)
+    {
+        int v;
+        ping.push(1);
+        pong.pop(v);
+        benchmark::DoNotOptimize(v);
+    }
+    cpu.Stop();
+    ping.close();
+    peer.join();
+}
+BENCHMARK(BM_Runtime_Channel_BoostFiber)->UseRealTime();
+
+static coro::Task ChannelPeer(coro::Channel<int>& ping, coro::Channel<int>& pong)
+{
+    int v;
+    while (co_await ping.Recv(v) && co_await pong.Send(v))
+    {
+    }
+}
+
+static coro::Task ChannelDriver(benchmark::State& state, coro::Channel<int>& ping,
+                                coro::Channel<int>& pong)
+{
+    ProcessCpu cpu(state);
+    for (auto _ : state)
+    {
+        int v;
+        co_await ping.Send(1);
+        co_await pong.Recv(v);
+        benchmark::DoNotOptimize(v);
+    }
+    cpu.Stop();
+    ping.Close();
+}
+
+static void BM_Runtime_Channel_Coroutine(benchmark::State& state)
+{
+    coro::Channel<int> ping;
+    coro::Channel<int> pong;
+    RunCoroutines({
+        [&] { return ChannelPeer(ping, pong); },
+        [&] { return ChannelDriver(state, ping, pong); },
+    });
+}
+BENCHMARK(BM_Runtime_Channel_Coroutine)->UseRealTime();
+
+// ---------------------------------------------------------------------------
+// Echo
+// ---------------------------------------------------------------------------
+//
+// One op: the driver sends MSG_SIZE bytes on a socketpair and reads them back from an echoing
+// task on the other end -- two sends and two recvs through the ring.
+//
+
+static void BM_Runtime_Echo_Coop(benchmark::State& state)
+{
+    RunCoop(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        int fds[2];
+        MakeSocketPair(fds);
+
+        bool done = false;
+        ctx->GetCooperator()->Spawn([&, fd = fds[1]](coop::Context*)
+        {
+            coop::io::Descriptor desc(fd);
+            char buf[MSG_SIZE];
+            int n;
+            while ((n = coop::io::Recv(desc, buf, MSG_SIZE)) > 0)
+            {
+                coop::io::SendAll(desc, buf, n);
+            }
+            done = true;
+        });
+
+        coop::io::Descriptor desc(fds[0]);
+        char msg[MSG_SIZE] = {};
+        char buf[MSG_SIZE];
+
+        ProcessCpu cpu(state);
+        for (auto _ : state)
+        {
+            coop::io::SendAll(desc, msg, MSG_SIZE);
+            int n = coop::io::Recv(desc, buf, MSG_SIZE);
+            assert(n == MSG_SIZE);
+            (void)n;
+        }
+        cpu.Stop();
+
+        shutdown(fds[0], SHUT_WR);
+        while (!done)
+        {
+            ctx->Yield();
+        }
+    });
+}
+BENCHMARK(BM_Runtime_Echo_Coop)->UseRealTime();
+
+static coro::Task EchoPeer(int fd)
+{
+    char buf[MSG_SIZE];
+    int n;
+    while ((n = co_await coro::Recv(fd, buf, MSG_SIZE)) > 0)
+    {
+        co_await coro::Send(fd, buf, n);
+    }
+}
+
+static coro::Task EchoDriver(benchmark::State& state, int fd)
+{
+    char msg[MSG_SIZE] = {};
+    char buf[MSG_SIZE];
+
+    ProcessCpu cpu(state);
+    for (auto _ : state)
+    {
+        co_await coro::Send(fd, msg, MSG_SIZE);
+        int n = co_await coro::Recv(fd, buf, MSG_SIZE);
+        assert(n == MSG_SIZE);
+        (void)n;
+    }
+    cpu.Stop();
+    shutdown(fd, SHUT_WR);
+}
+
+static void BM_Runtime_Echo_Coroutine(benchmark::State& state)
+{
+    int fds[2];
+    MakeSocketPair(fds);
+    RunCoroutines({
+        [&] { return EchoPeer(fds[1]); },
+        [&] { return EchoDriver(state, fds[0]); },
+    });
+    close(fds[0]);
+    close(fds[1]);
+}
+BENCHMARK(BM_Runtime_Echo_Coroutine)->UseRealTime();
+
+// ---------------------------------------------------------------------------
+// Http
+// ---------------------------------------------------------------------------
+//
+// One op: a keep-alive GET sent over loopback TCP, parsed and answered by the server task, and
+// the response read back by the driver. Both ends are tasks on the one runtime.
+//
+
+static void BM_Runtime_Http_Coop(benchmark::State& state)
+{
+    using HttpConn = coop::http::Connection<coop::http::PlaintextTransport>;
+
+    RunCoop(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        int fds[2];
+        MakeTcpPair(fds);
+
+        bool done = false;
+        ctx->GetCooperator()->Spawn([&, fd = fds[0]](coop::Context* server)
+        {
+            coop::io::Descriptor desc(fd);
+            coop::http::PlaintextTransport transport(desc);
+            auto conn = server->Allocate<HttpConn>(
+                HttpConn::ExtraBytes(), transport, server, server->GetCooperator(),
+                coop::http::ConnectionBase::DEFAULT_BUFFER_SIZE,
+                coop::http::ConnectionBase::DEFAULT_SEND_BUFFER_SIZE, std::chrono::seconds(0));
+            while (conn->GetRequestLine())
+            {
+                conn->SkipHeaders();
+                conn->Send(200, "text/plain", RESP_BODY, sizeof(RESP_BODY) - 1);
+                conn->SkipBody();
+                conn->Reset();
+            }
+            done = true;
+        });
+
+        coop::io::Descriptor desc(fds[1]);
+        char buf[1024];
+
+        ProcessCpu cpu(state);
+        for (auto _ : state)
+        {
+            coop::io::SendAll(desc, REQ_HELLO, sizeof(REQ_HELLO) - 1);
+            size_t len = 0;
+            while (!ResponseComplete(buf, len))
+            {
+                int n = coop::io::Recv(desc, buf + len, sizeof(buf) - len);
+                assert(n > 0);
+                len += n;
+            }
+        }
+        cpu.Stop();
+
+        shutdown(fds[1], SHUT_WR);
+        while (!done)
+        {
+            ctx->Yield();
+        }
+    });
+}
+BENCHMARK(BM_Runtime_Http_Coop)->UseRealTime();
+
+// Answer each request, found by its blank line, with the canned response
+//
+static coro::Task HttpPeer(int fd)
+{
+    char buf[2048];
+    size_t len = 0;
+    for (;;)
+    {
+        int n = co_await coro::Recv(fd, buf + len, sizeof(buf) - len);
+        if (n <= 0)
+        {
+            break;
+        }
+        len += n;
+
+        void* end;
+        while ((end = memmem(buf, len, "\r\n\r\n", 4)))
+        {
+            size_t used = static_cast<char*>(end) - buf + 4;
+            co_await coro::Send(fd, RESP_CANNED, sizeof(RESP_CANNED) - 1);
+            memmove(buf, buf + used, len - used);
+            len -= used;
+        }
+    }
+}
+
+static coro::Task HttpDriver(benchmark::State& state, int fd)
+{
+    char buf[1024];
+
+    ProcessCpu cpu(state);
+    for (auto _ : state)
+    {
+        co_await coro::Send(fd, REQ_HELLO, sizeof(REQ_HELLO) - 1);
+        size_t len = 0;
+        while (!ResponseComplete(buf, len))
+        {
+            int n = co_await coro::Recv(fd, buf + len, sizeof(buf) - len);
+            assert(n > 0);
+            len += n;
+        }
+    }
+    cpu.Stop();
+    shutdown(fd, SHUT_WR);
+}
+
+static void BM_Runtime_Http_Coroutine(benchmark::State& state)
+{
+    int fds[2];
+    MakeTcpPair(fds);
+    RunCoroutines({
+        [&] { return HttpPeer(fds[0]); },
+        [&] { return HttpDriver(state, fds[1]); },
+    });
+    close(fds[0]);
+    close(fds[1]);
+}
+BENCHMARK(BM_Runtime_Http_Coroutine)->UseRealTime();
@@ -1,12 +1,20 @@
+#include <algorithm>
+#include <atomic>
 #include <functional>
+#include <thread>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 
 #include "coop/context.h"
 #include "coop/cooperator.h"
+#include "coop/cooperator_group.h"
 #include "coop/coordinator.h"
+#include "coop/launchable.h"
 #include "coop/self.h"
+#include "coop/spawn_template.h"
 #include "coop/thread.h"
+#include "coop/time/now.h"
 
 // ---------------------------------------------------------------------------
 // Helper: run a benchmark body inside a cooperator
@@ -57,7 +65,7 @@ static void BM_Scheduler_Yield(benchmark::State& state)
     {
         for (auto _ : state)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
     });
 }
@@ -67,7 +75,7 @@ BENCHMARK(BM_Scheduler_Yield);
 // BM_Scheduler_Yield_Scaled — yield throughput vs context count
 // ---------------------------------------------------------------------------
 //
-// Spawns N-1 additional contexts each doing Yield(true) forever, then runs the benchmark loop on
+// Spawns N-1 additional contexts each doing Yield() forever, then runs the benchmark loop on
 // the original context. Measures how yield throughput degrades as the scheduler has more contexts
 // to round-robin through. Each benchmark iteration is one yield of the measured context, but the
 // scheduler processes all N contexts between iterations.
@@ -86,17 +94,17 @@ static void BM_Scheduler_Yield_Scaled(benchmark::State& state)
         {
             co->Spawn([](coop::Context* c)
             {
-                while (!c->IsKilled()) c->Yield(true);
+                while (!c->IsKilled()) c->Yield();
             });
         }
 
         // Let them all start
         //
-        ctx->Yield(true);
+        ctx->Yield();
 
         for (auto _ : state)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
     });
 }
@@ -136,17 +144,17 @@ static void BM_Scheduler_Yield_Direct(benchmark::State& state)
         {
             co->Spawn([](coop::Context* c)
             {
-                while (!c->IsKilled()) c->Yield(true);
+                while (!c->IsKilled()) c->Yield();
             });
         }
 
         // Let them all reach their first yield before timing.
         //
-        ctx->Yield(true);
+        ctx->Yield();
 
         for (auto _ : state)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         // The scheduler cycles all N contexts between two yields of the measured one, so each
@@ -179,7 +187,7 @@ static void BM_Scheduler_SpawnYieldExit(benchmark::State& state)
             coop::Coordinator coord(ctx);
             co->Spawn([&](coop::Context* child)
             {
-                child->Yield(true);
+                child->Yield();
                 coord.Release(child, false);
             });
             coord.Acquire(ctx);
@@ -187,3 +195,198 @@ static void BM_Scheduler_SpawnYieldExit(benchmark::State& state)
     });
 }
 BENCHMARK(BM_Scheduler_SpawnYieldExit);
+
+// ---------------------------------------------------------------------------
+// BM_Scheduler_LaunchExit / _Template — a connection-style Launch site, direct vs SpawnTemplate
+// ---------------------------------------------------------------------------
+//
+// Launch a Launchable that exits at once, as a short-lived connection would: per-Launch cost of
+// Cooperator::Launch (class search, layout per call) against one SpawnTemplate resolved up front.
+//
+struct ExitAtOnce : coop::Launchable
+{
+    ExitAtOnce(coop::Context* ctx, int* launched)
+    : coop::Launchable(ctx)
+    , m_launched(launched)
+    {
+    }
+
+    void Launch() final { (*m_launched)++; }
+
+    int* m_launched;
+};
+
+static constexpr coop::SpawnConfiguration s_launchConfig = {.priority = 0, .stackSize = 32768};
+
+static void BM_Scheduler_LaunchExit(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        auto* co = ctx->GetCooperator();
+        int launched = 0;
+        for (auto _ : state)
+        {
+            co->Launch<ExitAtOnce>(s_launchConfig, &launched);
+        }
+        benchmark::DoNotOptimize(launched);
+    });
+}
+BENCHMARK(BM_Scheduler_LaunchExit);
+
+static void BM_Scheduler_LaunchExit_Template(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        coop::SpawnTemplate<ExitAtOnce> site(ctx->GetCooperator(), s_launchConfig);
+        int launched = 0;
+        for (auto _ : state)
+        {
+            site.Launch(&launched);
+        }
+        benchmark::DoNotOptimize(launched);
+    });
+}
+BENCHMARK(BM_Scheduler_LaunchExit_Template);
+
+// ---------------------------------------------------------------------------
+// BM_Scheduler_HugePages_Yield / _SpawnWave — 64K contexts, stacks with and without arenas
+// ---------------------------------------------------------------------------
+//
+// At tens of thousands of live contexts every switch lands on a different 4KB stack page and the
+// TLB, not the switch itself, sets the cost. These price StackPoolConfiguration::hugePages, which
+// carves the default 16KB class out of 2MB arenas so ~120 stacks share one TLB entry.
+//
+// arg0 selects hugePages None(0) / Transparent(1) / Explicit(2, which falls back to Transparent
+// when no hugetlbfs pages are reserved -- check HugePages_Free in /proc/meminfo); arg1 is the
+// context count. Yield keeps arg1 - 1 background yielders runnable and reports switches/s, as in
+// Yield_Direct. SpawnWave spawns arg1 contexts per iteration, each yielding once then exiting, so
+// all of them are live at once; it reports spawns/s. Note the None rows also pay malloc/free for
+// segments past the class cap, while arena segments are always recycled -- that is part of what
+// the arena buys at this scale.
+//
+static coop::CooperatorConfiguration HugePagesConfig(int64_t mode)
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.stackPool.hugePages = static_cast<coop::HugePages>(mode);
+    return cfg;
+}
+
+static void BM_Scheduler_HugePages_Yield(benchmark::State& state)
+{
+    const int n = static_cast<int>(state.range(1));
+
+    RunBenchmarkCfg(state, HugePagesConfig(state.range(0)), [n](coop::Context* ctx, benchmark::State& state)
+    {
+        auto* co = ctx->GetCooperator();
+        for (int i = 0; i < n - 1; i++)
+        {
+            co->Spawn([](coop::Context* c)
+            {
+                while (!c->IsKilled()) c->Yield();
+            });
+        }
+        ctx->Yield();
+
+        for (auto _ : state)
+        {
+            ctx->Yield();
+        }
+        state.SetItemsProcessed(state.iterations() * n);
+    });
+}
+BENCHMARK(BM_Scheduler_HugePages_Yield)
+    ->Args({0, 65536})->Args({1, 65536})->Args({2, 65536});
+
+static void BM_Scheduler_HugePages_SpawnWave(benchmark::State& state)
+{
+    const int n = static_cast<int>(state.range(1));
+
+    RunBenchmarkCfg(state, HugePagesConfig(state.range(0)), [n](coop::Context* ctx, benchmark::State& state)
+    {
+        auto* co = ctx->GetCooperator();
+        for (auto _ : state)
+        {
+            int remaining = n;
+            coop::Coordinator coord(ctx);
+            for (int i = 0; i < n; i++)
+            {
+                co->Spawn([&](coop::Context* child)
+                {
+                    child->Yield();
+                    if (--remaining == 0) coord.Release(child, false);
+                });
+            }
+            coord.Acquire(ctx);
+        }
+        state.SetItemsProcessed(state.iterations() * n);
+    });
+}
+BENCHMARK(BM_Scheduler_HugePages_SpawnWave)
+    ->Args({0, 65536})->Args({1, 65536})->Args({2, 65536});
+
+// ---------------------------------------------------------------------------
+// CooperatorGroup placement under skewed work: every 7th job spins 100us, the rest return at once.
+// Blind round robin parks short jobs behind long ones on the same member; SubmitAny steers them
+// to members whose load is lower. Reports each job's submit-to-finish latency.
+// ---------------------------------------------------------------------------
+
+static void RunSkewedGroup(benchmark::State& state, bool loadAware)
+{
+    constexpr int kJobs = 256;
+    coop::CooperatorGroup group(4);
+    std::vector<int64_t> latency(kJobs);
+    std::vector<int64_t> all;
+    std::atomic<int> done{0};
+
+    int next = 0;
+    for (auto _ : state)
+    {
+        done.store(0, std::memory_order_relaxed);
+        for (int j = 0; j < kJobs; j++)
+        {
+            int64_t sent = coop::time::MonotonicNanos();
+            auto job = [&, j, sent](coop::Context*)
+            {
+                if (j % 7 == 0)
+                {
+                    int64_t until = coop::time::MonotonicNanos() + 100'000;
+                    while (coop::time::MonotonicNanos() < until)
+                    {
+                    }
+                }
+                latency[j] = coop::time::MonotonicNanos() - sent;
+                done.fetch_add(1, std::memory_order_release);
+            };
+            if (loadAware)
+            {
+                group.SubmitAny(job);
+            }
+            else
+            {
+                group.SubmitTo(next++ % group.Size(), job);
+            }
+        }
+        while (done.load(std::memory_order_acquire) < kJobs)
+        {
+            std::this_thread::yield();
+        }
+        all.insert(all.end(), latency.begin(), latency.end());
+    }
+
+    std::sort(all.begin(), all.end());
+    state.counters["p50_us"] = all[all.size() / 2] / 1e3;
+    state.counters["p99_us"] = all[all.size() * 99 / 100] / 1e3;
+    state.SetItemsProcessed(state.iterations() * kJobs);
+}
+
+static void BM_Group_Skewed_RoundRobin(benchmark::State& state)
+{
+    RunSkewedGroup(state, false);
+}
+BENCHMARK(BM_Group_Skewed_RoundRobin)->UseRealTime();
+
+static void BM_Group_Skewed_SubmitAny(benchmark::State& state)
+{
+    RunSkewedGroup(state, true);
+}
+BENCHMARK(BM_Group_Skewed_SubmitAny)->UseRealTime();
@@ -12,6 +12,7 @@
 #include "coop/http/server.h"
 #include "coop/http/connection.h"
 #include "coop/http/status.h"
+#include "coop/io/sqpoll_pool.h"
 #include "coop/io/ssl/context.h"
 
 using namespace coop;
@@ -38,6 +39,11 @@ static constexpr int APP_ROUTE_COUNT = sizeof(s_appRoutes) / sizeof(s_appRoutes[
 static http::Route s_routes[APP_ROUTE_COUNT + 16];
 static int s_routeCount = 0;
 static const char* const* s_searchPaths = nullptr;
+static bool s_multishotAccept = false;
+static bool s_fixedBuffers = false;
+static bool s_multishotRecv = false;
+static const char* s_certPath = "test_cert.pem";
+static const char* s_keyPath = "test_key.pem";
 
 struct TlsArgs
 {
@@ -53,8 +59,16 @@ int main(int argc, char* argv[])
     bool status = false;
     bool sqpoll = false;
     bool shareSqpoll = false;
+    int sqpollPollers = 1;
     bool tls = false;
+    bool directYield = false;
+    TimerMode timerMode = TimerMode::KernelPerTimer;
     int workers = 1;
+    int firstCore = 0;
+    int fixedBuffers = 0;
+    int bufferRing = 0;
+    int busyPollUs = 0;
+    int adaptiveSpinUs = 0;
     const char* certPath = nullptr;
     const char* keyPath = nullptr;
 
@@ -62,11 +76,26 @@ int main(int argc, char* argv[])
     {
         if (strcmp(argv[i], "--sqpoll") == 0) sqpoll = true;
         else if (strcmp(argv[i], "--share-sqpoll") == 0) { sqpoll = true; shareSqpoll = true; }
+        else if (strcmp(argv[i], "--sqpoll-pollers") == 0 && i + 1 < argc) sqpollPollers = atoi(argv[++i]);
         else if (strcmp(argv[i], "--tls") == 0) tls = true;
+        else if (strcmp(argv[i], "--direct-yield") == 0) directYield = true;
+        else if (strcmp(argv[i], "--timer-mode") == 0 && i + 1 < argc)
+        {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "queue") == 0) timerMode = TimerMode::UserspaceQueue;
+            else if (strcmp(mode, "wheel") == 0) timerMode = TimerMode::Wheel;
+            else timerMode = TimerMode::KernelPerTimer;
+        }
         else if (strcmp(argv[i], "--cert") == 0 && i + 1 < argc) certPath = argv[++i];
         else if (strcmp(argv[i], "--key") == 0 && i + 1 < argc) keyPath = argv[++i];
         else if (strcmp(argv[i], "--status") == 0) status = true;
+        else if (strcmp(argv[i], "--multishot-accept") == 0) s_multishotAccept = true;
+        else if (strcmp(argv[i], "--fixed-buffers") == 0 && i + 1 < argc) fixedBuffers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--multishot-recv") == 0 && i + 1 < argc) bufferRing = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--busy-poll") == 0 && i + 1 < argc) busyPollUs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--adaptive-spin") == 0 && i + 1 < argc) adaptiveSpinUs = atoi(argv[++i]);
         else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--first-core") == 0 && i + 1 < argc) firstCore = atoi(argv[++i]);
         else port = atoi(argv[i]);
     }
 
@@ -79,6 +108,49 @@ int main(int argc, char* argv[])
         config.uring.coopTaskrun = false;
         config.uring.entries = 1024;
     }
+    config.directYield = directYield;
+    config.timerMode = timerMode;
+
+    // --share-sqpoll: the workers share --sqpoll-pollers (default 1) SQPOLL threads per NUMA node,
+    // attaching to them as their rings come up, instead of running one each
+    //
+    io::SqpollPool sqpollPool(sqpollPollers);
+    if (shareSqpoll)
+    {
+        sqpollPool.Configure(config.uring);
+    }
+
+    // --fixed-buffers N: N registered 4KB buffers per worker, one per live connection
+    //
+    if (fixedBuffers > 0)
+    {
+        config.uring.fixedBuffers = fixedBuffers;
+        config.uring.fixedBufferSize = 4096;
+        s_fixedBuffers = true;
+    }
+
+    // --multishot-recv N: a provided buffer ring of N 4KB buffers per worker, shared by every
+    // connection, which holds a recv buffer only while a request is in flight
+    //
+    if (bufferRing > 0)
+    {
+        config.uring.bufferRingEntries = bufferRing;
+        config.uring.bufferRingBufSize = 4096;
+        s_multishotRecv = true;
+    }
+
+    // --busy-poll US: each worker busy-polls US microseconds before sleeping (NAPI where the
+    // kernel has it), on its ring and on the listener's sockets
+    //
+    if (busyPollUs > 0)
+    {
+        config.uring.busyPollUs = busyPollUs;
+        config.uring.preferBusyPoll = true;
+    }
+
+    // --adaptive-spin US: spin before sleeping for as long as recent waits took, up to US
+    //
+    config.uring.adaptiveSpinMaxUs = adaptiveSpinUs > 0 ? adaptiveSpinUs : 0;
 
     // Build shared route table
     //
@@ -113,42 +185,27 @@ int main(int argc, char* argv[])
         CooperatorConfiguration wConfig = config;
         wConfig.SetName(nameBuf);
 
-        // For shared SQPOLL: workers 1+ attach to worker 0's kernel polling thread.
-        // We need worker 0's uring to be initialized first.
-        //
-        if (shareSqpoll && w > 0)
-        {
-            // Wait for worker 0's uring to be initialized (ring_fd becomes valid)
-            //
-            auto* firstUring = pool[0].cooperator->GetUring();
-            while (firstUring->RingFd() == 0)
-            {
-                usleep(100);
-            }
-            wConfig.uring.attachSqFd = firstUring->RingFd();
-        }
-
         auto* co = new Cooperator(wConfig);
         auto* th = new Thread(co);
-        th->PinToCore(w);
+        th->PinToCore(firstCore + w);
         pool.push_back({co, th});
 
         if (tls)
         {
-            if (!certPath) certPath = "test_cert.pem";
-            if (!keyPath) keyPath = "test_key.pem";
+            if (certPath) s_certPath = certPath;
+            if (keyPath) s_keyPath = keyPath;
 
             SpawnConfiguration tlsConfig = {.priority = 0, .stackSize = 65536};
             co->Submit([](Context* ctx, void* arg) {
                 int port = static_cast<int>(reinterpret_cast<intptr_t>(arg));
 
                 char certBuf[8192], keyBuf[8192];
-                FILE* f = fopen("test_cert.pem", "r");
+                FILE* f = fopen(s_certPath, "r");
                 if (!f) { fprintf(stderr, "Failed to open cert file\n"); return; }
                 size_t certLen = fread(certBuf, 1, sizeof(certBuf), f);
                 fclose(f);
 
-                f = fopen("test_key.pem", "r");
+                f = fopen(s_keyPath, "r");
                 if (!f) { fprintf(stderr, "Failed to open key file\n"); return; }
                 size_t keyLen = fread(keyBuf, 1, sizeof(keyBuf), f);
                 fclose(f);
@@ -159,7 +216,7 @@ int main(int argc, char* argv[])
                 sslCtx.EnableKTLS();
 
                 http::RunTlsServer(ctx, port, s_routes, s_routeCount, sslCtx, "BenchTlsServer",
-                                   s_searchPaths, std::chrono::seconds(0));
+                                   s_searchPaths, std::chrono::seconds(0), s_multishotAccept);
             }, reinterpret_cast<void*>(static_cast<intptr_t>(port)), tlsConfig);
         }
         else
@@ -167,7 +224,8 @@ int main(int argc, char* argv[])
             co->Submit([](Context* ctx, void* arg) {
                 int port = static_cast<int>(reinterpret_cast<intptr_t>(arg));
                 http::RunServer(ctx, port, s_routes, s_routeCount, "BenchServer",
-                                s_searchPaths, std::chrono::seconds(0));
+                                s_searchPaths, std::chrono::seconds(0), s_multishotAccept,
+                                s_fixedBuffers, s_multishotRecv);
             }, reinterpret_cast<void*>(static_cast<intptr_t>(port)));
         }
     }
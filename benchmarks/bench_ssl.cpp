@@ -1,6 +1,8 @@
 #include <cassert>
+#include <cerrno>
 #include <functional>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
@@ -204,12 +206,74 @@ static void BM_SSL_Handshake(benchmark::State& state)
 
             [[maybe_unused]] int r = clientConn.Handshake();
             assert(r == 0);
-            while (!serverDone) ctx->Yield(true);
+            while (!serverDone) ctx->Yield();
         }
     });
 }
 BENCHMARK(BM_SSL_Handshake);
 
+// ---------------------------------------------------------------------------
+// Shape: HandshakeResumed
+//
+// As Handshake, but the server issues tickets (ssl::TicketKeys) and the
+// client keeps them (EnableSessionResumption), so every handshake after the
+// first resumes: no certificate, no signature. Each iteration also trades one
+// byte each way -- TLS 1.3 tickets arrive after the handshake, read by the
+// client's Recv. Compare with BM_SSL_Handshake for what resumption saves.
+// ---------------------------------------------------------------------------
+
+static void BM_SSL_HandshakeResumed(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        SSLContextPair ssl;
+        coop::io::ssl::TicketKeys keys;
+        ssl.server.EnableSessionTickets(&keys);
+        ssl.client.EnableSessionResumption();
+
+        int64_t resumed = 0;
+        for (auto _ : state)
+        {
+            int fds[2];
+            MakeSocketPair(fds);
+
+            coop::io::Descriptor serverDesc(fds[0]);
+            coop::io::Descriptor clientDesc(fds[1]);
+
+            char serverBuf[coop::io::ssl::Connection::BUFFER_SIZE];
+            char clientBuf[coop::io::ssl::Connection::BUFFER_SIZE];
+
+            coop::io::ssl::Connection serverConn(
+                ssl.server, serverDesc, serverBuf, sizeof(serverBuf));
+            coop::io::ssl::Connection clientConn(
+                ssl.client, clientDesc, clientBuf, sizeof(clientBuf));
+            clientConn.SetResumptionKey("bench");
+
+            bool serverDone = false;
+            ctx->GetCooperator()->Spawn(s_tlsSpawnConfig, [&](coop::Context*)
+            {
+                [[maybe_unused]] int r = serverConn.Handshake();
+                assert(r == 0);
+                char b;
+                coop::io::ssl::Recv(serverConn, &b, 1);
+                coop::io::ssl::Send(serverConn, &b, 1);
+                serverDone = true;
+            });
+
+            [[maybe_unused]] int r = clientConn.Handshake();
+            assert(r == 0);
+            char b = 0;
+            coop::io::ssl::Send(clientConn, &b, 1);
+            coop::io::ssl::Recv(clientConn, &b, 1);
+            resumed += clientConn.SessionReused();
+            while (!serverDone) ctx->Yield();
+        }
+        state.counters["resumed"] = benchmark::Counter(
+            static_cast<double>(resumed), benchmark::Counter::kAvgIterations);
+    });
+}
+BENCHMARK(BM_SSL_HandshakeResumed);
+
 // ---------------------------------------------------------------------------
 // Shape: PingPong (the natural TLS shape)
 //
@@ -276,11 +340,68 @@ static void BM_SSL_PingPong(benchmark::State& state)
         //
         done = true;
         coop::io::ssl::Send(clientConn, msg, MSG_SIZE);
-        while (!responderExited) ctx->Yield(true);
+        while (!responderExited) ctx->Yield();
     });
 }
 BENCHMARK(BM_SSL_PingPong);
 
+// PingPong with pooled staging: each flush and read borrows a cooperator buffer, reads try a
+// nonblocking recv() before parking, and SSL_MODE_RELEASE_BUFFERS is on. Compare with
+// BM_SSL_PingPong for what idle-connection memory costs on the hot path.
+//
+static void BM_SSL_PingPong_PooledStaging(benchmark::State& state)
+{
+    RunBenchmark(state, [](coop::Context* ctx, benchmark::State& state)
+    {
+        SSLContextPair ssl;
+
+        int fds[2];
+        MakeSocketPair(fds);
+
+        coop::io::Descriptor serverDesc(fds[0]);
+        coop::io::Descriptor clientDesc(fds[1]);
+
+        coop::io::ssl::Connection serverConn(ssl.server, serverDesc);
+        coop::io::ssl::Connection clientConn(ssl.client, clientDesc);
+
+        bool done = false;
+        bool responderExited = false;
+
+        ctx->GetCooperator()->Spawn(s_tlsSpawnConfig, [&](coop::Context*)
+        {
+            [[maybe_unused]] int r = serverConn.Handshake();
+            assert(r == 0);
+
+            char buf[MSG_SIZE] = {};
+            while (!done)
+            {
+                int n = coop::io::ssl::Recv(serverConn, buf, MSG_SIZE);
+                if (done || n <= 0) break;
+                coop::io::ssl::Send(serverConn, buf, n);
+            }
+
+            responderExited = true;
+        });
+
+        [[maybe_unused]] int r = clientConn.Handshake();
+        assert(r == 0);
+
+        char msg[MSG_SIZE] = {};
+        char buf[MSG_SIZE] = {};
+
+        for (auto _ : state)
+        {
+            coop::io::ssl::Send(clientConn, msg, MSG_SIZE);
+            coop::io::ssl::Recv(clientConn, buf, MSG_SIZE);
+        }
+
+        done = true;
+        coop::io::ssl::Send(clientConn, msg, MSG_SIZE);
+        while (!responderExited) ctx->Yield();
+    });
+}
+BENCHMARK(BM_SSL_PingPong_PooledStaging);
+
 // ---------------------------------------------------------------------------
 // Shape: PingPong with varying message sizes
 //
@@ -357,7 +478,7 @@ static void BM_SSL_PingPong_MsgSize(benchmark::State& state)
 
         done = true;
         coop::io::ssl::Send(clientConn, msg.data(), 1);
-        while (!responderExited) ctx->Yield(true);
+        while (!responderExited) ctx->Yield();
     });
 }
 BENCHMARK(BM_SSL_PingPong_MsgSize)
@@ -433,7 +554,7 @@ static void BM_Plaintext_PingPong_MsgSize(benchmark::State& state)
 
         done = true;
         coop::io::Send(a, msg.data(), 1);
-        while (!responderExited) ctx->Yield(true);
+        while (!responderExited) ctx->Yield();
     });
 }
 BENCHMARK(BM_Plaintext_PingPong_MsgSize)
@@ -502,11 +623,101 @@ static void BM_SSL_PingPong_kTLS(benchmark::State& state)
 
         done = true;
         coop::io::ssl::Send(clientConn, msg, MSG_SIZE);
-        while (!responderExited) ctx->Yield(true);
+        while (!responderExited) ctx->Yield();
     });
 }
 BENCHMARK(BM_SSL_PingPong_kTLS);
 
+// kTLS PingPong varying only how the client hands plaintext to the kernel, to measure what io_uring
+// costs on the kTLS data path: 0 = write() + io::Poll on EAGAIN (the old ssl::Send), 1 = io::Send
+// (an SQE and CQE every op), 2 = io::SendFastpath (send() first, io_uring on EAGAIN; ssl::Send
+// today). The responder and the client's receive are ssl::Recv throughout.
+//
+static void BM_SSL_PingPong_kTLS_SendPath(benchmark::State& state)
+{
+    const int64_t path = state.range(0);
+
+    RunBenchmark(state, [path](coop::Context* ctx, benchmark::State& state)
+    {
+        SSLContextPair ssl;
+        ssl.server.EnableKTLS();
+        ssl.client.EnableKTLS();
+
+        int fds[2];
+        MakeTcpPair(fds);
+
+        coop::io::Descriptor serverDesc(fds[0]);
+        coop::io::Descriptor clientDesc(fds[1]);
+
+        coop::io::ssl::Connection serverConn(
+            ssl.server, serverDesc, coop::io::ssl::SocketBio{});
+        coop::io::ssl::Connection clientConn(
+            ssl.client, clientDesc, coop::io::ssl::SocketBio{});
+
+        bool done = false;
+        bool responderExited = false;
+
+        ctx->GetCooperator()->Spawn(s_tlsSpawnConfig, [&](coop::Context*)
+        {
+            [[maybe_unused]] int r = serverConn.Handshake();
+            assert(r == 0);
+
+            char buf[MSG_SIZE] = {};
+            while (!done)
+            {
+                int n = coop::io::ssl::Recv(serverConn, buf, MSG_SIZE);
+                if (done || n <= 0) break;
+                coop::io::ssl::Send(serverConn, buf, n);
+            }
+
+            responderExited = true;
+        });
+
+        [[maybe_unused]] int r = clientConn.Handshake();
+        assert(r == 0);
+
+        char msg[MSG_SIZE] = {};
+        char buf[MSG_SIZE] = {};
+
+        auto send = [&]()
+        {
+            switch (path)
+            {
+            case 0:
+                while (::write(clientDesc.m_fd, msg, MSG_SIZE) < 0 && errno == EAGAIN)
+                {
+                    coop::io::Poll(clientDesc, POLLOUT);
+                }
+                break;
+            case 1:
+                coop::io::Send(clientDesc, msg, MSG_SIZE);
+                break;
+            default:
+                coop::io::SendFastpath(clientDesc, msg, MSG_SIZE);
+                break;
+            }
+        };
+
+        if (!clientConn.m_ktlsTx)
+        {
+            state.SkipWithError("kTLS TX not active");
+        }
+        else
+        {
+            for (auto _ : state)
+            {
+                send();
+                coop::io::ssl::Recv(clientConn, buf, MSG_SIZE);
+            }
+        }
+
+        done = true;
+        coop::io::ssl::Send(clientConn, msg, MSG_SIZE);
+        while (!responderExited) ctx->Yield();
+    });
+}
+BENCHMARK(BM_SSL_PingPong_kTLS_SendPath)->Arg(0)->Arg(1)->Arg(2);
+
 // kTLS PingPong with varying message sizes — primary throughput benchmark.
 //
 static void BM_SSL_PingPong_MsgSize_kTLS(benchmark::State& state)
@@ -573,7 +784,7 @@ static void BM_SSL_PingPong_MsgSize_kTLS(benchmark::State& state)
 
         done = true;
         coop::io::ssl::Send(clientConn, msg.data(), 1);
-        while (!responderExited) ctx->Yield(true);
+        while (!responderExited) ctx->Yield();
     });
 }
 BENCHMARK(BM_SSL_PingPong_MsgSize_kTLS)
@@ -646,7 +857,7 @@ static void BM_SSL_PingPong_SocketBio(benchmark::State& state)
 
         done = true;
         coop::io::ssl::Send(clientConn, msg.data(), 1);
-        while (!responderExited) ctx->Yield(true);
+        while (!responderExited) ctx->Yield();
     });
 }
 BENCHMARK(BM_SSL_PingPong_SocketBio)
@@ -731,7 +942,7 @@ static void BM_SSL_Throughput_MemBio(benchmark::State& state)
         // Close client side to unblock drainer
         //
         SSL_shutdown(clientConn.m_ssl);
-        while (!drainerExited) ctx->Yield(true);
+        while (!drainerExited) ctx->Yield();
     });
 }
 BENCHMARK(BM_SSL_Throughput_MemBio)
@@ -800,7 +1011,7 @@ static void BM_SSL_Throughput_kTLS(benchmark::State& state)
 
         done = true;
         SSL_shutdown(clientConn.m_ssl);
-        while (!drainerExited) ctx->Yield(true);
+        while (!drainerExited) ctx->Yield();
     });
 }
 BENCHMARK(BM_SSL_Throughput_kTLS)
@@ -867,7 +1078,7 @@ static void BM_SSL_Throughput_SocketBio(benchmark::State& state)
 
         done = true;
         SSL_shutdown(clientConn.m_ssl);
-        while (!drainerExited) ctx->Yield(true);
+        while (!drainerExited) ctx->Yield();
     });
 }
 BENCHMARK(BM_SSL_Throughput_SocketBio)
@@ -921,7 +1132,7 @@ static void BM_Plaintext_Throughput(benchmark::State& state)
         // Close sender to unblock drainer
         //
         coop::io::Close(a);
-        while (!drainerExited) ctx->Yield(true);
+        while (!drainerExited) ctx->Yield();
     });
 }
 BENCHMARK(BM_Plaintext_Throughput)
@@ -19,8 +19,18 @@
 // userspace insert + remove, and only the single nearest timer ever reaches the kernel. This is the
 // regime where the queue's kernel hrtimer count collapses from O(N) to O(1).
 //
-// Usage: bench_timer_fanout <kernel|queue> [fire|cancel] [N] [rounds] [windowUs] [baseUs]
+// A third, `idle`, models connection-idle timers at counts too large for a context each: one
+// context arms N timers with deadlines seconds out, then cancels them all, round after round, and
+// reports the cost per timer. It drives the cooperator's timer API directly (what a Sleeper does
+// underneath), so it is the structures being compared -- the heap's O(log n) delete against the
+// wheel's O(1) unlink -- and, in kernel mode, an IORING_OP_TIMEOUT and its cancel per timer.
+// `compare` runs it in every mode at 1K, 100K and 1M timers.
+//
+// Usage: bench_timer_fanout <kernel|queue|wheel> [fire|cancel] [N] [rounds] [windowUs] [baseUs]
+//        bench_timer_fanout <kernel|queue|wheel> idle [N] [rounds]
+//        bench_timer_fanout compare
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -40,17 +50,40 @@
 #include "coop/thread.h"
 #include "coop/time/sleep.h"
 
+#include "coop/io/handle.h"
+#include "coop/io/timeout.h"
+#include "coop/time/now.h"
+#include "coop/time/timer_queue.h"
+
 #include <memory>
+#include <optional>
 
 using namespace coop;
 
+static const char* ModeName(TimerMode mode)
+{
+    switch (mode)
+    {
+    case TimerMode::UserspaceQueue: return "queue";
+    case TimerMode::Wheel:          return "wheel";
+    default:                        return "kernel";
+    }
+}
+
+static TimerMode ParseMode(const char* arg)
+{
+    if (strcmp(arg, "queue") == 0) return TimerMode::UserspaceQueue;
+    if (strcmp(arg, "wheel") == 0) return TimerMode::Wheel;
+    return TimerMode::KernelPerTimer;
+}
+
 // Pipeline workload: a context per pipeline, each looping [tiny compute -> Sleep], many pipelines
 // per cooperator, across several cooperators OS-scheduled on separate cores. This reproduces the
 // high-swappiness IO-fanout profile that motivated the design, where the kernel hrtimer machinery
 // (lapic_next_deadline / timerqueue_add / __hrtimer_*) showed up as the largest non-compute cost.
 // perf record this binary to read the hrtimer symbols' share of cycles in each mode.
 //
-static double RunPipeline(bool useQueue, int cores, int pipelines, int iters, int sleepUs,
+static double RunPipeline(TimerMode mode, int cores, int pipelines, int iters, int sleepUs,
                           int computeIters)
 {
     std::vector<std::unique_ptr<Cooperator>> coops;
@@ -61,7 +94,7 @@ static double RunPipeline(bool useQueue, int cores, int pipelines, int iters, in
     for (int m = 0; m < cores; m++)
     {
         CooperatorConfiguration cfg;
-        cfg.timerMode = useQueue ? TimerMode::UserspaceQueue : TimerMode::KernelPerTimer;
+        cfg.timerMode = mode;
         cfg.cpuAffinity = 1 + m;                 // cores 1..cores
         cfg.SetName("pipeline");
         coops.push_back(std::make_unique<Cooperator>(cfg));
@@ -108,33 +141,158 @@ static double RunPipeline(bool useQueue, int cores, int pipelines, int iters, in
     return std::chrono::duration<double, std::milli>(wall1 - wall0).count();
 }
 
+// Idle workload: N timers armed seconds out and cancelled unfired, `rounds` times over, from a
+// single context. Returns the mean cost of one arm plus its cancel, and the cooperator thread's
+// voluntary context switches. Kernel mode cancels the whole batch before reaping any of it, as a
+// fan-out of killed sleepers would.
+//
+struct IdleResult
+{
+    double  nsPerTimer;
+    long    nvcsw;
+};
+
+static IdleResult RunIdle(TimerMode mode, int N, int rounds)
+{
+    struct UserTimer
+    {
+        Coordinator     coord;
+        time::TimerNode node;
+    };
+
+    struct KernelTimer
+    {
+        Coordinator                 coord;
+        std::optional<io::Handle>   handle;
+    };
+
+    CooperatorConfiguration cfg;
+    cfg.timerMode = mode;
+    cfg.SetName("timer_idle");
+
+    Cooperator co(cfg);
+    IdleResult result{};
+    {
+        Thread t(&co);
+        co.Submit([&](Context* ctx)
+        {
+            Cooperator* self = ctx->GetCooperator();
+            const bool kernelMode = mode == TimerMode::KernelPerTimer;
+            std::vector<UserTimer> user(kernelMode ? 0 : N);
+            std::vector<KernelTimer> kernel(kernelMode ? N : 0);
+
+            struct rusage ru0;
+            getrusage(RUSAGE_THREAD, &ru0);
+            auto wall0 = std::chrono::steady_clock::now();
+
+            for (int r = 0; r < rounds; r++)
+            {
+                // Deadlines spread from one to thirty seconds out, like idle timeouts armed at
+                // different moments
+                //
+                const int64_t baseUs = time::MonotonicMicros() + 1'000'000;
+                for (int i = 0; i < N; i++)
+                {
+                    const int64_t offsetUs = int64_t(i) * 29'000'000 / N;
+                    if (kernelMode)
+                    {
+                        auto& timer = kernel[i];
+                        timer.handle.emplace(ctx, self->GetUring(), &timer.coord);
+                        io::Timeout(*timer.handle,
+                                    std::chrono::microseconds(1'000'000 + offsetUs));
+                    }
+                    else
+                    {
+                        self->RegisterTimer(&user[i].node, baseUs + offsetUs, &user[i].coord);
+                    }
+                }
+
+                for (int i = 0; i < N; i++)
+                {
+                    if (kernelMode)
+                    {
+                        kernel[i].handle->Cancel();
+                    }
+                    else
+                    {
+                        self->CancelTimer(&user[i].node);
+                    }
+                }
+                for (auto& timer : kernel)
+                {
+                    timer.handle->Wait();               // the timeout's CQE and the cancel's
+                    timer.handle.reset();
+                }
+            }
+
+            auto wall1 = std::chrono::steady_clock::now();
+            struct rusage ru1;
+            getrusage(RUSAGE_THREAD, &ru1);
+
+            result.nsPerTimer = std::chrono::duration<double, std::nano>(wall1 - wall0).count()
+                / (double(N) * rounds);
+            result.nvcsw = ru1.ru_nvcsw - ru0.ru_nvcsw;
+            self->Shutdown();
+        });
+    }
+    return result;
+}
+
 int main(int argc, char** argv)
 {
     if (argc < 2)
     {
         fprintf(stderr,
-            "usage: %s <kernel|queue> [fire|cancel|pipeline] [N] [rounds] [windowUs] [baseUs]\n",
-            argv[0]);
+            "usage: %s <kernel|queue|wheel> [fire|cancel|pipeline|idle] [N] [rounds] [windowUs] "
+            "[baseUs]\n"
+            "       %s compare\n",
+            argv[0], argv[0]);
         return 2;
     }
 
+    if (strcmp(argv[1], "compare") == 0)
+    {
+        for (int N : {1'000, 100'000, 1'000'000})
+        {
+            const int rounds = std::max(1, 2'000'000 / N);
+            for (auto mode : {TimerMode::KernelPerTimer, TimerMode::UserspaceQueue,
+                              TimerMode::Wheel})
+            {
+                auto r = RunIdle(mode, N, rounds);
+                printf("mode=%-6s workload=idle N=%-7d rounds=%-4d  ->  %.1f ns/timer  nvcsw=%ld\n",
+                       ModeName(mode), N, rounds, r.nsPerTimer, r.nvcsw);
+            }
+        }
+        return 0;
+    }
+
+    const TimerMode mode = ParseMode(argv[1]);
+
+    if (argc > 2 && strcmp(argv[2], "idle") == 0)
+    {
+        const int N      = argc > 3 ? atoi(argv[3]) : 100'000;
+        const int rounds = argc > 4 ? atoi(argv[4]) : 20;
+        auto r = RunIdle(mode, N, rounds);
+        printf("mode=%-6s workload=idle N=%d rounds=%d  ->  %.1f ns/timer  nvcsw=%ld\n",
+               ModeName(mode), N, rounds, r.nsPerTimer, r.nvcsw);
+        return 0;
+    }
+
     if (argc > 2 && strcmp(argv[2], "pipeline") == 0)
     {
-        const bool useQueue     = strcmp(argv[1], "queue") == 0;
         const int  cores        = argc > 3 ? atoi(argv[3]) : 3;
         const int  pipelines    = argc > 4 ? atoi(argv[4]) : 500;
         const int  iters        = argc > 5 ? atoi(argv[5]) : 400;
         const int  sleepUs      = argc > 6 ? atoi(argv[6]) : 200;
         const int  computeIters = argc > 7 ? atoi(argv[7]) : 200;
-        double ms = RunPipeline(useQueue, cores, pipelines, iters, sleepUs, computeIters);
+        double ms = RunPipeline(mode, cores, pipelines, iters, sleepUs, computeIters);
         printf("mode=%-6s workload=pipeline cores=%d pipelines/core=%d iters=%d sleepUs=%d  ->  "
                "makespan=%.1f ms  (sleeps=%lld)\n",
-               useQueue ? "queue" : "kernel", cores, pipelines, iters, sleepUs, ms,
+               ModeName(mode), cores, pipelines, iters, sleepUs, ms,
                (long long)cores * pipelines * iters);
         return 0;
     }
 
-    const bool useQueue   = strcmp(argv[1], "queue") == 0;
     const bool cancelMode = argc > 2 && strcmp(argv[2], "cancel") == 0;
     const int  N        = argc > 3 ? atoi(argv[3]) : 500;
     const int  rounds   = argc > 4 ? atoi(argv[4]) : 200;
@@ -142,7 +300,7 @@ int main(int argc, char** argv)
     const int  baseUs   = argc > 6 ? atoi(argv[6]) : 1000;    // floor
 
     CooperatorConfiguration cfg;
-    cfg.timerMode = useQueue ? TimerMode::UserspaceQueue : TimerMode::KernelPerTimer;
+    cfg.timerMode = mode;
     cfg.SetName("timer_fanout");
 
     Cooperator co(cfg);
@@ -200,7 +358,7 @@ int main(int argc, char** argv)
                 // fires. Each kill cancels the timer: an io_uring async-cancel of a real hrtimer in
                 // kernel mode, a userspace node removal in queue mode.
                 //
-                ctx->Yield(true);
+                ctx->Yield();
                 for (int i = 0; i < N; i++)
                 {
                     handles[i].Kill();
@@ -229,7 +387,7 @@ int main(int argc, char** argv)
 
     printf("mode=%-6s workload=%-6s N=%d rounds=%d  ->  makespan=%.1f ms  "
            "nvcsw=%ld nivcsw=%ld  sleeps=%lu\n",
-           useQueue ? "queue" : "kernel", cancelMode ? "cancel" : "fire", N, rounds,
+           ModeName(mode), cancelMode ? "cancel" : "fire", N, rounds,
            makespanMs, nvcsw, nivcsw, (unsigned long)totalSleeps);
     return 0;
 }
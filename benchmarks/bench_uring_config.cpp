@@ -1,7 +1,12 @@
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <deque>
 #include <functional>
+#include <memory>
+#include <sys/resource.h>
 #include <sys/socket.h>
+#include <thread>
 #include <vector>
 
 #include <benchmark/benchmark.h>
@@ -14,6 +19,7 @@
 #include "coop/io/descriptor.h"
 #include "coop/io/recv.h"
 #include "coop/io/send.h"
+#include "coop/io/sqpoll_pool.h"
 
 // ---------------------------------------------------------------------------
 // Uring configuration benchmarks
@@ -23,8 +29,8 @@
 // the kernel-side flag behavior.
 //
 // Naming: BM_Uring_{Shape}_{Config}
-//   Shape:  RoundTrip, PingPong
-//   Config: Bare, CoopTaskrun, DeferTaskrun
+//   Shape:  RoundTrip, PingPong, Fleet
+//   Config: Bare, CoopTaskrun, DeferTaskrun; Fleet adds Sqpoll, SqpollShared
 // ---------------------------------------------------------------------------
 
 static constexpr int MSG_SIZE = 64;
@@ -191,7 +197,7 @@ static void PingPongBody(coop::Context* ctx, benchmark::State& state)
 
     done = true;
     coop::io::Send(a, msg, MSG_SIZE);
-    while (!pongerExited) ctx->Yield(true);
+    while (!pongerExited) ctx->Yield();
 }
 
 static void BM_Uring_PingPong_Bare(benchmark::State& s)
@@ -266,7 +272,7 @@ static void PingPongScaleBody(coop::Context* ctx, benchmark::State& state, int N
     done = true;
     for (int i = 0; i < N; i++)
         coop::io::Send(writers[i], msg, MSG_SIZE);
-    while (exited < N) ctx->Yield(true);
+    while (exited < N) ctx->Yield();
 }
 
 static void BM_Uring_PingPong_Scale_Bare(benchmark::State& s)
@@ -286,3 +292,153 @@ static void BM_Uring_PingPong_Scale_DeferTaskrun(benchmark::State& s)
         { PingPongScaleBody(c, st, s.range(0)); }, s_deferTaskrun); }
 BENCHMARK(BM_Uring_PingPong_Scale_DeferTaskrun)
     ->Arg(1)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+
+// ---------------------------------------------------------------------------
+// Shape: Fleet
+//
+// N cooperators, each running its own PingPong for a fixed window. Reports
+// throughput against the CPU the whole process consumed doing it -- SQPOLL
+// threads included, since they belong to the process (5.12+) and so to
+// RUSAGE_SELF -- which is where one poller per cooperator and one shared
+// poller differ: per-ring SQPOLL buys its throughput with an extra core each.
+//
+// Counters: msgs_per_sec, cpu_cores (CPU seconds per wall second), and
+// msgs_per_cpu_sec, the figure of merit.
+// ---------------------------------------------------------------------------
+
+static constexpr auto FLEET_WINDOW = std::chrono::milliseconds(200);
+
+static double CpuSeconds()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+struct FleetState
+{
+    std::atomic<int> running{0};
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> messages{0};
+};
+
+static void FleetMember(coop::Context* ctx, FleetState* fleet)
+{
+    int fds[2];
+    MakeSocketPair(fds);
+
+    coop::io::Descriptor a(fds[0]);
+
+    bool done = false;
+    bool pongerExited = false;
+
+    ctx->GetCooperator()->Spawn([&done, &pongerExited, fd = fds[1]](coop::Context*)
+    {
+        coop::io::Descriptor b(fd);
+
+        char buf[MSG_SIZE] = {};
+        while (!done)
+        {
+            int r = coop::io::Recv(b, buf, MSG_SIZE);
+            if (done || r <= 0) break;
+            coop::io::Send(b, buf, r);
+        }
+
+        pongerExited = true;
+    });
+
+    char msg[MSG_SIZE] = {};
+    char buf[MSG_SIZE] = {};
+
+    fleet->running.fetch_add(1);
+    uint64_t count = 0;
+    while (!fleet->stop.load(std::memory_order_relaxed))
+    {
+        coop::io::Send(a, msg, MSG_SIZE);
+        coop::io::Recv(a, buf, MSG_SIZE);
+        count++;
+    }
+    fleet->messages.fetch_add(count);
+
+    done = true;
+    coop::io::Send(a, msg, MSG_SIZE);
+    while (!pongerExited) ctx->Yield();
+}
+
+static void RunFleet(benchmark::State& state, coop::CooperatorConfiguration const& config,
+    int pollersPerNode)
+{
+    const int n = static_cast<int>(state.range(0));
+    double messages = 0;
+    double cpu = 0;
+    double wall = 0;
+
+    for (auto _ : state)
+    {
+        FleetState fleet;
+        coop::io::SqpollPool pool(pollersPerNode);
+        std::vector<std::unique_ptr<coop::Cooperator>> cooperators;
+        std::vector<std::unique_ptr<coop::Thread>> threads;
+
+        for (int i = 0; i < n; i++)
+        {
+            coop::CooperatorConfiguration memberConfig = config;
+            if (pollersPerNode > 0)
+            {
+                pool.Configure(memberConfig.uring);
+            }
+            cooperators.push_back(std::make_unique<coop::Cooperator>(memberConfig));
+            threads.push_back(std::make_unique<coop::Thread>(cooperators.back().get()));
+            cooperators.back()->Submit([](coop::Context* ctx, void* arg)
+            {
+                FleetMember(ctx, static_cast<FleetState*>(arg));
+            }, &fleet);
+        }
+        while (fleet.running.load() < n)
+        {
+            std::this_thread::yield();
+        }
+
+        double cpuStart = CpuSeconds();
+        auto wallStart = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(FLEET_WINDOW);
+        fleet.stop.store(true);
+        for (auto& co : cooperators)
+        {
+            co->Shutdown();
+        }
+        threads.clear();
+        cpu += CpuSeconds() - cpuStart;
+        wall += std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        messages += fleet.messages.load();
+    }
+
+    state.counters["msgs_per_sec"] = messages / wall;
+    state.counters["cpu_cores"] = cpu / wall;
+    state.counters["msgs_per_cpu_sec"] = messages / cpu;
+}
+
+// Sqpoll: every ring its own polling thread. SqpollShared: one per NUMA node, via SqpollPool.
+//
+static coop::CooperatorConfiguration SqpollConfiguration()
+{
+    coop::CooperatorConfiguration config = s_bare;
+    config.uring.sqpoll = true;
+    return config;
+}
+
+static void BM_Uring_Fleet_CoopTaskrun(benchmark::State& s)
+    { RunFleet(s, s_coopTaskrun, 0); }
+BENCHMARK(BM_Uring_Fleet_CoopTaskrun)
+    ->Arg(2)->Arg(4)->Iterations(3)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_Uring_Fleet_Sqpoll(benchmark::State& s)
+    { RunFleet(s, SqpollConfiguration(), 0); }
+BENCHMARK(BM_Uring_Fleet_Sqpoll)
+    ->Arg(2)->Arg(4)->Iterations(3)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_Uring_Fleet_SqpollShared(benchmark::State& s)
+    { RunFleet(s, SqpollConfiguration(), 1); }
+BENCHMARK(BM_Uring_Fleet_SqpollShared)
+    ->Arg(2)->Arg(4)->Iterations(3)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -108,7 +108,7 @@ int main(int argc, char** argv)
                     for (uint64_t i = 0; i < iters; i++)
                     {
                         BusyFor(work);
-                        if (!pure) ctx->Yield(true);
+                        if (!pure) ctx->Yield();
                     }
                     remaining.fetch_sub(1, std::memory_order_acq_rel);
                 });
@@ -0,0 +1,49 @@
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "coop/ws/mask.h"
+
+// ---------------------------------------------------------------------------
+// WebSocket benchmarks
+//
+// Naming: BM_WS_{Operation}_{Variant}
+// ---------------------------------------------------------------------------
+
+static const uint8_t MASK_KEY[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+
+// ---------------------------------------------------------------------------
+// Unmask: XOR a client payload with its masking key in place, byte loop vs vector path. The
+// payload starts one byte into its buffer and one byte into the key, as a chunk following a
+// frame header does, so neither the loads nor the key phase are aligned. Sizes span a chat
+// message to a large market-data frame.
+// ---------------------------------------------------------------------------
+
+static void BM_WS_Unmask_Scalar(benchmark::State& state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    std::vector<char> buf(size + 1, 'A');
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(coop::ws::detail::UnmaskScalar(buf.data() + 1, size, MASK_KEY, 1));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * size);
+}
+BENCHMARK(BM_WS_Unmask_Scalar)->RangeMultiplier(8)->Range(16, 1 << 20);
+
+static void BM_WS_Unmask_Simd(benchmark::State& state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    std::vector<char> buf(size + 1, 'A');
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(coop::ws::detail::Unmask(buf.data() + 1, size, MASK_KEY, 1));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * size);
+}
+BENCHMARK(BM_WS_Unmask_Simd)->RangeMultiplier(8)->Range(16, 1 << 20);
@@ -103,10 +103,10 @@ int main(int argc, char** argv)
             coop::Spawn([&done, work](coop::Context* c)
             {
                 c->Detach();
-                while (!done) { BusyFor(work); c->Yield(true); }
+                while (!done) { BusyFor(work); c->Yield(); }
             });
 
-        ctx->Yield(true);  // let the spinners reach their loop
+        ctx->Yield();  // let the spinners reach their loop
 
         // Probe: sleep, then measure how far past the deadline the wake actually landed.
         //
@@ -120,7 +120,7 @@ int main(int argc, char** argv)
         }
 
         done = true;
-        for (uint32_t i = 0; i < ctxs * 8; i++) ctx->Yield(true);  // let spinners observe done + exit
+        for (uint32_t i = 0; i < ctxs * 8; i++) ctx->Yield();  // let spinners observe done + exit
 
         std::sort(lat.begin(), lat.end());
         auto pct = [&](double p){ return lat[(size_t)(p * (lat.size() - 1))] / 1000.0; };
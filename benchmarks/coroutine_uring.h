@@ -0,0 +1,293 @@
+#pragma once
+
+// A C++20-coroutine runtime over raw liburing, the stackless baseline bench_io_baseline.cpp and
+// bench_runtimes.cpp measure coop against. It is as small as it can be and still run their
+// workloads: one thread, a FIFO of ready coroutines, recv and send as awaitable uring ops
+// submitted in one batch per loop turn, and a one-slot channel. No timers, no cancellation, no
+// error handling beyond returning the cqe's result.
+//
+//   coro::Loop loop;
+//   loop.Spawn([](int fd) -> coro::Task { co_await coro::Send(fd, "hi", 2); }(fd));
+//   loop.Run();                                       // until every spawned task finished
+//
+// A Task is lazy and co_await runs it to completion, child first through symmetric transfer --
+// the nearest thing to a coop Spawn, which runs the child at once. Ops and wakes go through the
+// ready FIFO, as coop's do through its run queue.
+//
+
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <utility>
+#include <vector>
+
+#include <liburing.h>
+
+namespace coro
+{
+
+struct Loop;
+
+inline thread_local Loop* t_loop = nullptr;
+
+struct Task
+{
+    struct promise_type
+    {
+        std::coroutine_handle<> continuation;
+        bool                    done = false;
+
+        Task get_return_object()
+        {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct Final
+        {
+            bool await_ready() noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
+            {
+                auto& p = h.promise();
+                p.done = true;
+                return p.continuation ? p.continuation : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        Final final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit Task(std::coroutine_handle<promise_type> h) : m_handle(h) {}
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    Task(Task const&) = delete;
+
+    ~Task()
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+        }
+    }
+
+    bool Done() const { return m_handle.promise().done; }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+
+    void await_resume() noexcept {}
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+struct Loop
+{
+    Loop(Loop const&) = delete;
+
+    explicit Loop(unsigned entries = 256)
+    {
+        io_uring_queue_init(entries, &m_ring, 0);
+        t_loop = this;
+    }
+
+    ~Loop()
+    {
+        m_tasks.clear();
+        io_uring_queue_exit(&m_ring);
+        t_loop = nullptr;
+    }
+
+    void Spawn(Task task)
+    {
+        m_ready.push_back(task.m_handle);
+        m_tasks.push_back(std::move(task));
+    }
+
+    void Post(std::coroutine_handle<> h) { m_ready.push_back(h); }
+
+    // Run until every spawned task has finished, or nothing is runnable and nothing in flight
+    //
+    void Run()
+    {
+        for (;;)
+        {
+            while (!m_ready.empty())
+            {
+                auto h = m_ready.front();
+                m_ready.pop_front();
+                h.resume();
+            }
+            if (m_inFlight == 0)
+            {
+                break;
+            }
+            io_uring_submit_and_wait(&m_ring, 1);
+            Reap();
+        }
+        m_tasks.clear();
+    }
+
+    io_uring_sqe* Sqe()
+    {
+        io_uring_sqe* sqe = io_uring_get_sqe(&m_ring);
+        if (!sqe)
+        {
+            io_uring_submit(&m_ring);
+            sqe = io_uring_get_sqe(&m_ring);
+        }
+        return sqe;
+    }
+
+    struct Op;
+
+    void Reap();
+
+    io_uring                             m_ring;
+    std::deque<std::coroutine_handle<>>  m_ready;
+    std::vector<Task>                    m_tasks;
+    size_t                               m_inFlight = 0;
+};
+
+// One uring op, prepared on construction and submitted with the loop's next batch
+//
+struct Loop::Op
+{
+    bool await_ready() noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> h) noexcept
+    {
+        m_handle = h;
+        io_uring_sqe_set_data(m_sqe, this);
+        t_loop->m_inFlight++;
+    }
+
+    int await_resume() noexcept { return m_result; }
+
+    io_uring_sqe*           m_sqe;
+    int                     m_result = 0;
+    std::coroutine_handle<> m_handle;
+};
+
+inline void Loop::Reap()
+{
+    unsigned head;
+    unsigned seen = 0;
+    io_uring_cqe* cqe;
+    io_uring_for_each_cqe(&m_ring, head, cqe)
+    {
+        auto* op = static_cast<Op*>(io_uring_cqe_get_data(cqe));
+        op->m_result = cqe->res;
+        m_ready.push_back(op->m_handle);
+        m_inFlight--;
+        seen++;
+    }
+    io_uring_cq_advance(&m_ring, seen);
+}
+
+inline Loop::Op Recv(int fd, void* buf, size_t size)
+{
+    io_uring_sqe* sqe = t_loop->Sqe();
+    io_uring_prep_recv(sqe, fd, buf, size, 0);
+    return Loop::Op{sqe};
+}
+
+inline Loop::Op Send(int fd, void const* buf, size_t size)
+{
+    io_uring_sqe* sqe = t_loop->Sqe();
+    io_uring_prep_send(sqe, fd, buf, size, 0);
+    return Loop::Op{sqe};
+}
+
+// To the back of the ready FIFO
+//
+struct Yield
+{
+    bool await_ready() noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) noexcept { t_loop->Post(h); }
+    void await_resume() noexcept {}
+};
+
+// One slot, one waiter per side. Send and Recv return false once the channel is closed.
+//
+template<typename T>
+struct Channel
+{
+    struct SendOp
+    {
+        bool await_ready() noexcept { return !m_channel.m_full || m_channel.m_closed; }
+        void await_suspend(std::coroutine_handle<> h) noexcept { m_channel.m_sender = h; }
+
+        bool await_resume() noexcept
+        {
+            if (m_channel.m_closed)
+            {
+                return false;
+            }
+            m_channel.m_value = std::move(m_value);
+            m_channel.m_full = true;
+            m_channel.Wake(m_channel.m_receiver);
+            return true;
+        }
+
+        Channel& m_channel;
+        T        m_value;
+    };
+
+    struct RecvOp
+    {
+        bool await_ready() noexcept { return m_channel.m_full || m_channel.m_closed; }
+        void await_suspend(std::coroutine_handle<> h) noexcept { m_channel.m_receiver = h; }
+
+        bool await_resume() noexcept
+        {
+            if (!m_channel.m_full)
+            {
+                return false;
+            }
+            m_out = std::move(m_channel.m_value);
+            m_channel.m_full = false;
+            m_channel.Wake(m_channel.m_sender);
+            return true;
+        }
+
+        Channel& m_channel;
+        T&       m_out;
+    };
+
+    SendOp Send(T value) { return SendOp{*this, std::move(value)}; }
+    RecvOp Recv(T& out) { return RecvOp{*this, out}; }
+
+    void Close()
+    {
+        m_closed = true;
+        Wake(m_sender);
+        Wake(m_receiver);
+    }
+
+    void Wake(std::coroutine_handle<>& waiter)
+    {
+        if (waiter)
+        {
+            t_loop->Post(std::exchange(waiter, {}));
+        }
+    }
+
+    T                       m_value{};
+    bool                    m_full = false;
+    bool                    m_closed = false;
+    std::coroutine_handle<> m_sender;
+    std::coroutine_handle<> m_receiver;
+};
+
+} // end namespace coro
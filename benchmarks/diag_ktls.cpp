@@ -2,11 +2,12 @@
 //
 // Tests:
 // 1. Plaintext baseline (no TLS) — establishes floor
-// 2. kTLS TLS 1.3 (TX-only) — SSL_read RX, write() TX
+// 2. kTLS TLS 1.3 — write() TX; read() RX where the kernel takes TLS 1.3 RX, else SSL_read
 // 3. kTLS TLS 1.2 (hopefully TX+RX) — read()/write() both directions
 // 4. kTLS TLS 1.2 TX-only fallback — if RX doesn't activate
 
 #include <cassert>
+#include <cerrno>
 #include <chrono>
 #include <cstdio>
 #include <cstring>
@@ -71,6 +72,17 @@ static void MakeTcpPair(int fds[2], bool nodelay = false)
 
 static int RecvPosixPoll(io::ssl::Connection& conn, void* buf, size_t size)
 {
+    // Once the kernel owns RX (TLS 1.2, or TLS 1.3 installed by the connection), OpenSSL must not
+    // read the socket
+    //
+    while (conn.m_ktlsRx)
+    {
+        ssize_t ret = ::read(conn.m_desc.m_fd, buf, size);
+        if (ret >= 0) return (int)ret;
+        if (errno != EAGAIN) return -1;
+        struct pollfd pfd = {conn.m_desc.m_fd, POLLIN, 0};
+        ::poll(&pfd, 1, -1);
+    }
     for (;;)
     {
         int ret = SSL_read(conn.m_ssl, buf, size);
@@ -280,7 +292,7 @@ int main()
             });
             [[maybe_unused]] int r = clientConn.Handshake();
             assert(r == 0);
-            while (!serverReady) ctx->Yield(true);
+            while (!serverReady) ctx->Yield();
 
             printf("  Server ktls_tx=%d rx=%d, Client ktls_tx=%d rx=%d\n",
                 serverConn.m_ktlsTx, serverConn.m_ktlsRx,
@@ -382,7 +394,7 @@ int main()
             });
             [[maybe_unused]] int r = clientConn.Handshake();
             assert(r == 0);
-            while (!serverReady) ctx->Yield(true);
+            while (!serverReady) ctx->Yield();
 
             printf("  Server ktls_tx=%d rx=%d, Client ktls_tx=%d rx=%d\n",
                 serverConn.m_ktlsTx, serverConn.m_ktlsRx,
@@ -487,7 +499,7 @@ int main()
             });
             [[maybe_unused]] int r = clientConn.Handshake();
             assert(r == 0);
-            while (!serverReady) ctx->Yield(true);
+            while (!serverReady) ctx->Yield();
 
             printf("  Server ktls_tx=%d rx=%d, Client ktls_tx=%d rx=%d\n",
                 serverConn.m_ktlsTx, serverConn.m_ktlsRx,
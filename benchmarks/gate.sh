@@ -0,0 +1,375 @@
+#!/bin/bash
+# ---------------------------------------------------------------------------
+# gate.sh — Benchmark regression gate: run the hot-path subset and fail on
+# regression against a checked-in baseline.
+#
+# Usage:
+#   ./benchmarks/gate.sh [options]
+#   cmake --build build/release --target coop_bench_gate
+#
+# Options:
+#   --update            Record this run as the new baseline instead of checking
+#   --baseline=PATH     Baseline file (default: benchmarks/baselines/gate_<arch>.json)
+#   --reps=N            Repetitions per benchmark (default: 10)
+#   --min-time=TIME     Minimum time per repetition (default: 0.2s)
+#   --cpus=LIST         taskset cpu list to pin to (default: the last two cpus;
+#                       "none" to leave placement to the scheduler)
+#   --retries=N         Re-runs of a regressed benchmark before it fails (default: 1)
+#   --floor=PCT         With --update, the smallest noise band recorded (default: 5)
+#   --bench=PATH        Benchmark binary to run (skips the build step)
+#   --no-build          Skip release build step
+#   --json=PATH         Also keep the run's raw JSON at PATH
+#
+# Exit status:
+#   0  every gated benchmark is within its noise band
+#   1  at least one benchmark regressed
+#   2  setup error: no baseline, build failure, a gated benchmark did not run
+#
+# A benchmark regresses when the median real time of its repetitions exceeds
+# the baseline median by more than the baseline's band for it. The band is
+# recorded with the baseline: the larger of the floor and three times the
+# coefficient of variation the recording run saw, so a noisy benchmark gets
+# a wide band and a steady one a tight band. Bands may be edited by hand.
+# ---------------------------------------------------------------------------
+
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_ROOT="$(cd "$SCRIPT_DIR/.." && pwd)"
+
+# The gated subset: one benchmark per hot path. Names are anchored, so a
+# parameterized benchmark is gated at every argument it registers.
+#
+GATED=(
+    BM_Scheduler_Yield              # context switch through the scheduler
+    BM_AcquireRelease               # uncontended Coordinator
+    BM_Continuation_Fire            # continuation fire and resume
+    BM_IO_RoundTrip                 # io_uring submit/complete round trip
+    BM_IO_PingPong                  # socket round trip between two contexts
+    BM_Http_ScanHeaders_Simd        # HTTP header scan
+    BM_Http_Tcp_MinimalGet          # HTTP parse and respond over TCP
+    BM_Channel_Uncontended          # channel send/recv, no blocking
+    BM_Channel_PingPong             # channel send/recv, blocking each way
+)
+
+ARCH=$(uname -m)
+
+# Defaults.
+#
+UPDATE=0
+BASELINE=""
+REPS=10
+MIN_TIME="0.2s"
+CPUS=""
+RETRIES=1
+FLOOR=5
+BENCH_BIN=""
+NO_BUILD=0
+KEEP_JSON=""
+
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+        --update)       UPDATE=1 ;;
+        --baseline=*)   BASELINE="${1#*=}" ;;
+        --reps=*)       REPS="${1#*=}" ;;
+        --min-time=*)   MIN_TIME="${1#*=}" ;;
+        --cpus=*)       CPUS="${1#*=}" ;;
+        --retries=*)    RETRIES="${1#*=}" ;;
+        --floor=*)      FLOOR="${1#*=}" ;;
+        --bench=*)      BENCH_BIN="${1#*=}"; NO_BUILD=1 ;;
+        --no-build)     NO_BUILD=1 ;;
+        --json=*)       KEEP_JSON="${1#*=}" ;;
+        -h|--help)
+            sed -n '2,/^# ----/{ /^# ----/d; s/^# \?//p }' "$0"
+            exit 0
+            ;;
+        *)
+            echo "Unknown option: $1 (try --help)" >&2
+            exit 2
+            ;;
+    esac
+    shift
+done
+
+[[ -z "$BASELINE" ]] && BASELINE="$SCRIPT_DIR/baselines/gate_${ARCH}.json"
+
+if ! command -v python3 &>/dev/null; then
+    echo "error: python3 required" >&2
+    exit 2
+fi
+
+if [[ $UPDATE -eq 0 && ! -f "$BASELINE" ]]; then
+    echo "error: no baseline at $BASELINE" >&2
+    echo "Record one on a quiet machine with: $0 --update" >&2
+    exit 2
+fi
+
+# ---------------------------------------------------------------------------
+# Build release if needed.
+# ---------------------------------------------------------------------------
+
+[[ -z "$BENCH_BIN" ]] && BENCH_BIN="$PROJECT_ROOT/build/release/bin/coop_benchmarks"
+
+if [[ $NO_BUILD -eq 0 ]]; then
+    if [[ ! -f "$PROJECT_ROOT/build/release/CMakeCache.txt" ]]; then
+        echo "==> Configuring release build..."
+        cmake -S "$PROJECT_ROOT" -B "$PROJECT_ROOT/build/release" \
+              -DCMAKE_BUILD_TYPE=Release -DCMAKE_EXPORT_COMPILE_COMMANDS=OFF \
+              >/dev/null 2>&1
+    fi
+    echo "==> Building coop_benchmarks..."
+    if ! cmake --build "$PROJECT_ROOT/build/release" --target coop_benchmarks \
+               -j"$(nproc)" 2>&1; then
+        echo "error: release build failed" >&2
+        exit 2
+    fi
+fi
+
+if [[ ! -x "$BENCH_BIN" ]]; then
+    echo "error: benchmark binary not found: $BENCH_BIN" >&2
+    exit 2
+fi
+
+# ---------------------------------------------------------------------------
+# Pinning and environment checks.
+# ---------------------------------------------------------------------------
+
+# The last two cpus by default: one for the cooperator, one for the benchmark
+# thread, and the ones least likely to carry interrupt affinity.
+#
+NCPU=$(nproc 2>/dev/null || echo 1)
+if [[ -z "$CPUS" ]]; then
+    if [[ $NCPU -ge 2 ]]; then
+        CPUS="$((NCPU - 2)),$((NCPU - 1))"
+    else
+        CPUS="none"
+    fi
+fi
+
+PIN=()
+if [[ "$CPUS" != "none" ]]; then
+    if command -v taskset &>/dev/null; then
+        PIN=(taskset -c "$CPUS")
+    else
+        echo "WARNING: taskset not found; running unpinned" >&2
+        CPUS="none"
+    fi
+fi
+
+# A scaling governor moves the clock under the benchmark. Only a warning:
+# containers and VMs often cannot change it.
+#
+GOVERNORS=$(cat /sys/devices/system/cpu/cpu*/cpufreq/scaling_governor 2>/dev/null \
+            | sort -u | paste -sd',' || true)
+if [[ -n "$GOVERNORS" && "$GOVERNORS" != "performance" ]]; then
+    echo "WARNING: cpufreq governor is '$GOVERNORS', not 'performance'; expect wider noise" >&2
+fi
+
+CPU_MODEL=$(lscpu 2>/dev/null | grep -i "model name" | sed 's/.*: *//' | head -1 || true)
+[[ -z "$CPU_MODEL" ]] && CPU_MODEL="unknown"
+GIT_REV=$(git -C "$PROJECT_ROOT" rev-parse --short HEAD 2>/dev/null || echo "unknown")
+if ! git -C "$PROJECT_ROOT" diff --quiet 2>/dev/null; then
+    GIT_REV="${GIT_REV}-dirty"
+fi
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+# ---------------------------------------------------------------------------
+# Run: one pass over the names given, N repetitions each, into a JSON file.
+# ---------------------------------------------------------------------------
+
+run_subset() {
+    local out="$1"
+    shift
+    local filter
+    filter="^($(IFS='|'; echo "$*"))(/.*)?\$"
+    "${PIN[@]}" "$BENCH_BIN" \
+        --benchmark_filter="$filter" \
+        --benchmark_repetitions="$REPS" \
+        --benchmark_min_time="$MIN_TIME" \
+        --benchmark_enable_random_interleaving=true \
+        --benchmark_format=json \
+        --benchmark_out="$out" \
+        --benchmark_out_format=json \
+        >/dev/null
+}
+
+echo "=== Benchmark Gate ==="
+echo "  Git:      ${GIT_REV}"
+echo "  CPU:      ${CPU_MODEL}"
+echo "  Pinned:   ${CPUS}"
+echo "  Reps:     ${REPS} x ${MIN_TIME}"
+echo "  Baseline: ${BASELINE}"
+echo ""
+
+RUN_JSON="$WORK_DIR/run.json"
+if ! run_subset "$RUN_JSON" "${GATED[@]}"; then
+    echo "error: benchmark run failed" >&2
+    exit 2
+fi
+[[ -n "$KEEP_JSON" ]] && cp "$RUN_JSON" "$KEEP_JSON"
+
+# ---------------------------------------------------------------------------
+# Record or check.
+# ---------------------------------------------------------------------------
+
+if [[ $UPDATE -eq 1 ]]; then
+    mkdir -p "$(dirname "$BASELINE")"
+    python3 - "$RUN_JSON" "$BASELINE" "$FLOOR" "$ARCH" "$CPU_MODEL" "$GIT_REV" "$REPS" \
+              "$MIN_TIME" << 'PYSCRIPT'
+import json, sys, datetime
+
+run_path, out_path, floor, arch, cpu, rev, reps, min_time = sys.argv[1:9]
+floor = float(floor)
+
+with open(run_path) as f:
+    data = json.load(f)
+
+# Medians and CVs by benchmark name, from gbench's aggregates.
+#
+stats = {}
+for b in data.get("benchmarks", []):
+    agg = b.get("aggregate_name")
+    if agg not in ("median", "cv"):
+        continue
+    name = b["run_name"]
+    stats.setdefault(name, {})[agg] = b["real_time"]
+
+benchmarks = {}
+for name in sorted(stats):
+    s = stats[name]
+    if "median" not in s:
+        continue
+    cv_pct = s.get("cv", 0) * 100
+    benchmarks[name] = {
+        "real_time": round(s["median"], 3),
+        "cv_pct": round(cv_pct, 2),
+        "band_pct": round(max(floor, 3 * cv_pct), 1),
+    }
+
+baseline = {
+    "schema": 1,
+    "arch": arch,
+    "cpu": cpu,
+    "git": rev,
+    "recorded": datetime.datetime.now().astimezone().isoformat(timespec="seconds"),
+    "repetitions": int(reps),
+    "min_time": min_time,
+    "time_unit": "ns",
+    "benchmarks": benchmarks,
+}
+with open(out_path, "w") as f:
+    json.dump(baseline, f, indent=2, sort_keys=False)
+    f.write("\n")
+
+for name, b in benchmarks.items():
+    print(f"  {name:<40} {b['real_time']:>12.1f} ns  cv {b['cv_pct']:>5.2f}%"
+          f"  band {b['band_pct']:>5.1f}%")
+print(f"\nRecorded {len(benchmarks)} benchmarks to {out_path}")
+PYSCRIPT
+    exit 0
+fi
+
+# check_run <run.json> <regressed-file> <name>...: print the verdict table
+# for the gated names given; write the ones that regressed to <regressed-file>.
+# Returns 0 clean, 1 regressions, 2 a baseline benchmark did not run.
+#
+check_run() {
+    local run="$1" regressed="$2"
+    shift 2
+    python3 - "$BASELINE" "$run" "$regressed" "$CPU_MODEL" "$@" << 'PYSCRIPT'
+import json, sys
+
+baseline_path, run_path, regressed_path, cpu = sys.argv[1:5]
+scope = set(sys.argv[5:])
+
+with open(baseline_path) as f:
+    baseline = json.load(f)
+with open(run_path) as f:
+    data = json.load(f)
+
+if baseline.get("cpu") not in (None, "", cpu):
+    print(f"WARNING: baseline was recorded on '{baseline['cpu']}', this is '{cpu}'",
+          file=sys.stderr)
+
+stats = {}
+for b in data.get("benchmarks", []):
+    agg = b.get("aggregate_name")
+    if agg in ("median", "cv"):
+        stats.setdefault(b["run_name"], {})[agg] = b["real_time"]
+
+# Only the gated names in scope count; a name this run has and the baseline
+# lacks (a benchmark new to the subset, a new argument) is shown, not checked.
+#
+base = {n: b for n, b in baseline["benchmarks"].items() if n.split("/")[0] in scope}
+names = sorted(set(stats) | set(base))
+
+regressed, missing = [], []
+width = max([len(n) for n in names] + [9])
+print(f"{'Benchmark':<{width}}  {'Baseline':>10}  {'Now':>10}  {'Delta':>8}  {'Band':>6}"
+      f"  {'CV':>6}")
+print(f"{'-'*width}  {'-'*10}  {'-'*10}  {'-'*8}  {'-'*6}  {'-'*6}")
+for name in names:
+    if name not in stats:
+        missing.append(name)
+        continue
+    now = stats[name]["median"]
+    cv = stats[name].get("cv", 0) * 100
+    if name not in base:
+        print(f"{name:<{width}}  {'-':>10}  {now:>10.1f}  {'new':>8}  {'-':>6}  {cv:>5.1f}%")
+        continue
+    was = base[name]["real_time"]
+    band = base[name]["band_pct"]
+    delta = (now - was) / was * 100 if was else 0
+    verdict = ""
+    if delta > band:
+        regressed.append(name)
+        verdict = "  \033[31mREGRESSED\033[0m"
+    elif delta < -band:
+        verdict = "  \033[32mfaster\033[0m"
+    if cv > band:
+        verdict += "  (noisy: cv above band)"
+    print(f"{name:<{width}}  {was:>10.1f}  {now:>10.1f}  {delta:>+7.1f}%  {band:>5.1f}%"
+          f"  {cv:>5.1f}%{verdict}")
+
+with open(regressed_path, "w") as f:
+    f.write("\n".join(sorted({n.split("/")[0] for n in regressed})))
+
+if missing:
+    print(f"\nIn the baseline but not run ({len(missing)}): " + ", ".join(missing))
+    sys.exit(2)
+sys.exit(1 if regressed else 0)
+PYSCRIPT
+}
+
+# A regression must reproduce: a benchmark over its band is re-run on its
+# own, up to RETRIES times, and fails only if every run is over.
+#
+REGRESSED_FILE="$WORK_DIR/regressed"
+CHECK=0
+check_run "$RUN_JSON" "$REGRESSED_FILE" "${GATED[@]}" || CHECK=$?
+
+ATTEMPT=0
+while [[ $CHECK -eq 1 && $ATTEMPT -lt $RETRIES ]]; do
+    ATTEMPT=$((ATTEMPT + 1))
+    mapfile -t AGAIN < "$REGRESSED_FILE"
+    echo ""
+    echo "==> Re-running ${AGAIN[*]} (retry ${ATTEMPT}/${RETRIES})"
+    echo ""
+    RETRY_JSON="$WORK_DIR/retry_${ATTEMPT}.json"
+    if ! run_subset "$RETRY_JSON" "${AGAIN[@]}"; then
+        echo "error: benchmark run failed" >&2
+        exit 2
+    fi
+    CHECK=0
+    check_run "$RETRY_JSON" "$REGRESSED_FILE" "${AGAIN[@]}" || CHECK=$?
+done
+
+echo ""
+case $CHECK in
+    0) echo "PASS: no regressions against ${BASELINE##*/}" ;;
+    1) echo "FAIL: regressed: $(paste -sd' ' "$REGRESSED_FILE")" ;;
+    *) echo "ERROR: the run does not cover the baseline; --update if the subset changed" ;;
+esac
+exit $CHECK
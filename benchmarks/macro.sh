@@ -0,0 +1,285 @@
+#!/bin/bash
+# ---------------------------------------------------------------------------
+# macro.sh — End-to-end HTTP macro benchmark: bench_server on one set of
+# cores, the open-loop bench_load generator on another, once per server
+# configuration, with a p50/p99/p999 table at the end.
+#
+# Usage:
+#   ./benchmarks/macro.sh [options]
+#   cmake --build build/release --target coop_bench_macro
+#
+# Options:
+#   --configs=LIST      Server configurations, comma separated (default: all)
+#                         base          defaults
+#                         sqpoll        --sqpoll
+#                         shared-sqpoll --share-sqpoll
+#                         direct-yield  --direct-yield
+#                         buffer-ring   --multishot-recv 256
+#                         timer-queue   --timer-mode queue
+#                         timer-wheel   --timer-mode wheel
+#                         busy-poll     --busy-poll 50
+#                         adaptive-spin --adaptive-spin 50
+#   --modes=LIST        keep-alive,churn (default: keep-alive)
+#   --transports=LIST   plain,tls (default: plain)
+#   --rate=R            Target requests per second (default: 50000)
+#   --connections=N     Generator connections (default: 64)
+#   --churn=N           Requests per connection in churn mode (default: 1)
+#   --duration=S        Measured seconds per run (default: 10)
+#   --warmup=S          Unmeasured seconds before them (default: 2)
+#   --path=PATH         Request path (default: /plaintext)
+#   --port=P            Server port (default: 18080)
+#   --server-cpus=A-B   Cores for the server, one worker each (default: 0-1)
+#   --load-cpus=A-B     Cores for the generator, one worker each (default: 2-3)
+#   --bin-dir=DIR       Where bench_server and bench_load are (skips the build)
+#   --no-build          Skip release build step
+#   --out=PATH          Also keep every run's JSON result, one per line
+#
+# Each run starts a fresh server, so one configuration's connections and
+# caches do not carry into the next. Latencies are from each request's
+# intended send time (see bench_load.cpp), so a run whose "achieved" falls
+# short of the target measured a saturated server, not its latency.
+# ---------------------------------------------------------------------------
+
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_ROOT="$(cd "$SCRIPT_DIR/.." && pwd)"
+
+ALL_CONFIGS="base,sqpoll,shared-sqpoll,direct-yield,buffer-ring,timer-queue,timer-wheel,busy-poll,adaptive-spin"
+
+# Defaults.
+#
+CONFIGS="$ALL_CONFIGS"
+MODES="keep-alive"
+TRANSPORTS="plain"
+RATE=50000
+CONNECTIONS=64
+CHURN=1
+DURATION=10
+WARMUP=2
+REQ_PATH="/plaintext"
+PORT=18080
+SERVER_CPUS="0-1"
+LOAD_CPUS="2-3"
+BIN_DIR=""
+NO_BUILD=0
+KEEP_JSON=""
+
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+        --configs=*)        CONFIGS="${1#*=}" ;;
+        --modes=*)          MODES="${1#*=}" ;;
+        --transports=*)     TRANSPORTS="${1#*=}" ;;
+        --rate=*)           RATE="${1#*=}" ;;
+        --connections=*)    CONNECTIONS="${1#*=}" ;;
+        --churn=*)          CHURN="${1#*=}" ;;
+        --duration=*)       DURATION="${1#*=}" ;;
+        --warmup=*)         WARMUP="${1#*=}" ;;
+        --path=*)           REQ_PATH="${1#*=}" ;;
+        --port=*)           PORT="${1#*=}" ;;
+        --server-cpus=*)    SERVER_CPUS="${1#*=}" ;;
+        --load-cpus=*)      LOAD_CPUS="${1#*=}" ;;
+        --bin-dir=*)        BIN_DIR="${1#*=}"; NO_BUILD=1 ;;
+        --no-build)         NO_BUILD=1 ;;
+        --out=*)            KEEP_JSON="${1#*=}" ;;
+        -h|--help)
+            sed -n '2,/^# ----/{ /^# ----/d; s/^# \?//p }' "$0"
+            exit 0
+            ;;
+        *)
+            echo "Unknown option: $1 (try --help)" >&2
+            exit 2
+            ;;
+    esac
+    shift
+done
+
+if ! command -v python3 &>/dev/null; then
+    echo "error: python3 required" >&2
+    exit 2
+fi
+if ! command -v taskset &>/dev/null; then
+    echo "error: taskset required to keep the server and generator apart" >&2
+    exit 2
+fi
+
+# A cpu range, A-B or A, as its first cpu and its count
+#
+range_first() { echo "${1%-*}"; }
+range_count() {
+    local first="${1%-*}" last="${1#*-}"
+    echo $((last - first + 1))
+}
+
+for range in "$SERVER_CPUS" "$LOAD_CPUS"; do
+    if [[ ! "$range" =~ ^[0-9]+(-[0-9]+)?$ || $(range_count "$range") -lt 1 ]]; then
+        echo "error: cpu range '$range' is not A-B" >&2
+        exit 2
+    fi
+done
+
+server_flags() {
+    case "$1" in
+        base)           echo "" ;;
+        sqpoll)         echo "--sqpoll" ;;
+        shared-sqpoll)  echo "--share-sqpoll" ;;
+        direct-yield)   echo "--direct-yield" ;;
+        buffer-ring)    echo "--multishot-recv 256" ;;
+        timer-queue)    echo "--timer-mode queue" ;;
+        timer-wheel)    echo "--timer-mode wheel" ;;
+        busy-poll)      echo "--busy-poll 50" ;;
+        adaptive-spin)  echo "--adaptive-spin 50" ;;
+        *)              return 1 ;;
+    esac
+}
+
+IFS=',' read -r -a CONFIG_LIST <<< "$CONFIGS"
+IFS=',' read -r -a MODE_LIST <<< "$MODES"
+IFS=',' read -r -a TRANSPORT_LIST <<< "$TRANSPORTS"
+
+for config in "${CONFIG_LIST[@]}"; do
+    if ! server_flags "$config" >/dev/null; then
+        echo "error: unknown configuration '$config' (one of $ALL_CONFIGS)" >&2
+        exit 2
+    fi
+done
+
+# ---------------------------------------------------------------------------
+# Build release if needed.
+# ---------------------------------------------------------------------------
+
+[[ -z "$BIN_DIR" ]] && BIN_DIR="$PROJECT_ROOT/build/release/bin"
+
+if [[ $NO_BUILD -eq 0 ]]; then
+    if [[ ! -f "$PROJECT_ROOT/build/release/CMakeCache.txt" ]]; then
+        echo "==> Configuring release build..."
+        cmake -S "$PROJECT_ROOT" -B "$PROJECT_ROOT/build/release" \
+              -DCMAKE_BUILD_TYPE=Release -DCMAKE_EXPORT_COMPILE_COMMANDS=OFF \
+              >/dev/null 2>&1
+    fi
+    echo "==> Building bench_server and bench_load..."
+    if ! cmake --build "$PROJECT_ROOT/build/release" \
+               --target bench_server bench_load test-certs -j"$(nproc)" 2>&1; then
+        echo "error: release build failed" >&2
+        exit 2
+    fi
+fi
+
+for bin in bench_server bench_load; do
+    if [[ ! -x "$BIN_DIR/$bin" ]]; then
+        echo "error: $bin not found in $BIN_DIR" >&2
+        exit 2
+    fi
+done
+
+GOVERNORS=$(cat /sys/devices/system/cpu/cpu*/cpufreq/scaling_governor 2>/dev/null \
+            | sort -u | paste -sd',' || true)
+if [[ -n "$GOVERNORS" && "$GOVERNORS" != "performance" ]]; then
+    echo "WARNING: cpufreq governor is '$GOVERNORS', not 'performance'; expect wider noise" >&2
+fi
+
+WORK_DIR=$(mktemp -d)
+SERVER_PID=""
+cleanup() {
+    if [[ -n "$SERVER_PID" ]]; then
+        kill "$SERVER_PID" 2>/dev/null || true
+        wait "$SERVER_PID" 2>/dev/null || true
+    fi
+    rm -rf "$WORK_DIR"
+}
+trap cleanup EXIT
+
+RESULTS="$WORK_DIR/results.jsonl"
+: > "$RESULTS"
+
+# ---------------------------------------------------------------------------
+# One run: a fresh server, the generator against it, the server stopped.
+# ---------------------------------------------------------------------------
+
+wait_for_port() {
+    for _ in $(seq 1 50); do
+        if (exec 3<>"/dev/tcp/127.0.0.1/$PORT") 2>/dev/null; then
+            return 0
+        fi
+        sleep 0.1
+    done
+    return 1
+}
+
+run_one() {
+    local config="$1" mode="$2" transport="$3"
+    local flags load_flags=()
+    flags=$(server_flags "$config")
+    [[ "$mode" == "churn" ]] && load_flags+=(--churn "$CHURN")
+    if [[ "$transport" == "tls" ]]; then
+        flags="$flags --tls --cert cert.pem --key key.pem"
+        load_flags+=(--tls)
+    fi
+
+    # shellcheck disable=SC2086
+    (cd "$BIN_DIR" && exec taskset -c "$SERVER_CPUS" ./bench_server \
+        --workers "$(range_count "$SERVER_CPUS")" --first-core "$(range_first "$SERVER_CPUS")" \
+        $flags "$PORT") 2>"$WORK_DIR/server.log" &
+    SERVER_PID=$!
+
+    if ! wait_for_port; then
+        echo "error: bench_server ($config, $transport) did not listen on $PORT" >&2
+        cat "$WORK_DIR/server.log" >&2
+        exit 2
+    fi
+
+    local line
+    if ! line=$(taskset -c "$LOAD_CPUS" "$BIN_DIR/bench_load" --json \
+                --port "$PORT" --path "$REQ_PATH" --rate "$RATE" -c "$CONNECTIONS" \
+                --workers "$(range_count "$LOAD_CPUS")" --first-core "$(range_first "$LOAD_CPUS")" \
+                -d "$DURATION" --warmup "$WARMUP" "${load_flags[@]}" 2>"$WORK_DIR/load.log"); then
+        echo "error: bench_load failed ($config, $mode, $transport)" >&2
+        cat "$WORK_DIR/load.log" >&2
+        exit 2
+    fi
+
+    kill "$SERVER_PID" 2>/dev/null || true
+    wait "$SERVER_PID" 2>/dev/null || true
+    SERVER_PID=""
+
+    echo "{\"config\":\"$config\",\"transport\":\"$transport\",${line#\{}" >> "$RESULTS"
+}
+
+echo "=== HTTP Macro Benchmark ==="
+echo "  Server:   cpus $SERVER_CPUS    Generator: cpus $LOAD_CPUS"
+echo "  Load:     $RATE req/s over $CONNECTIONS connections, ${DURATION}s + ${WARMUP}s warmup"
+echo ""
+
+for transport in "${TRANSPORT_LIST[@]}"; do
+    for mode in "${MODE_LIST[@]}"; do
+        for config in "${CONFIG_LIST[@]}"; do
+            echo "==> $config / $mode / $transport"
+            run_one "$config" "$mode" "$transport"
+        done
+    done
+done
+
+[[ -n "$KEEP_JSON" ]] && cp "$RESULTS" "$KEEP_JSON"
+
+# ---------------------------------------------------------------------------
+# Report.
+# ---------------------------------------------------------------------------
+
+python3 - "$RESULTS" <<'PYEOF'
+import json
+import sys
+
+rows = [json.loads(line) for line in open(sys.argv[1]) if line.strip()]
+
+print()
+print(f"{'Config':<14} {'Mode':<11} {'TLS':<4} {'Target':>9} {'Achieved':>10} "
+      f"{'Errors':>7} {'p50 us':>9} {'p99 us':>9} {'p999 us':>9} {'max us':>10}")
+print("-" * 100)
+for r in rows:
+    lat = r["latency_us"]
+    short = r["achieved"] < 0.97 * r["rate"]
+    print(f"{r['config']:<14} {r['mode']:<11} {'yes' if r['tls'] else 'no':<4} "
+          f"{r['rate']:>9} {r['achieved']:>10.0f} {r['errors']:>7} "
+          f"{lat['p50']:>9.1f} {lat['p99']:>9.1f} {lat['p999']:>9.1f} {lat['max']:>10.1f}"
+          f"{'  (saturated)' if short else ''}")
+PYEOF
@@ -0,0 +1,82 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "size_class_allocator.h"
+#include "detail/bump.h"
+
+namespace coop
+{
+
+static_assert(Arena::kChunkBytes == SizeClassAllocator::kMaxClass,
+              "Arena chunks should be the allocator's largest pooled class");
+
+Arena::Arena(Context* ctx, size_t heapBytes)
+: m_ctx(ctx)
+{
+    const size_t bytes = std::min(heapBytes, detail::BumpHeadroom(ctx) / 2) & ~size_t(15);
+    if (bytes >= kMinHeapBytes)
+    {
+        m_heapBase = reinterpret_cast<uintptr_t>(detail::BumpAlloc(ctx, bytes));
+        m_heapEnd = m_heapBase + bytes;
+    }
+    m_cursor = m_heapBase;
+    m_end = m_heapEnd;
+}
+
+Arena::~Arena()
+{
+    Reset();
+    if (m_heapBase)
+    {
+        detail::BumpFree(m_ctx, reinterpret_cast<void*>(m_heapBase));
+    }
+}
+
+void Arena::Reset()
+{
+    while (auto* chunk = m_chunks)
+    {
+        m_chunks = chunk->next;
+        SizeClassAllocator::Release(chunk, chunk->size);
+    }
+    m_chunkCount = 0;
+    m_cursor = m_heapBase;
+    m_end = m_heapEnd;
+}
+
+void* Arena::AllocateSlow(size_t n, size_t align)
+{
+    auto* allocator = SizeClassAllocator::Current();
+    assert(allocator && "coop::Arena used off a cooperator thread");
+
+    // Chunks are aligned to the header at least; past that, leave room to align by hand
+    //
+    const size_t need = sizeof(Chunk) + n + (align > alignof(Chunk) ? align : 0);
+
+    // A large allocation gets a chunk to itself, so the current chunk's tail stays in use
+    //
+    const bool dedicated = need > kChunkBytes / 4;
+    const size_t size = dedicated ? need : kChunkBytes;
+
+    void* memory = allocator->Allocate(size);
+    if (!memory)
+    {
+        return nullptr;
+    }
+    auto* chunk = new (memory) Chunk{m_chunks, size};
+    m_chunks = chunk;
+    m_chunkCount++;
+
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(chunk + 1);
+    const uintptr_t p = (begin + align - 1) & ~(align - 1);
+    if (!dedicated)
+    {
+        m_cursor = p + n;
+        m_end = reinterpret_cast<uintptr_t>(chunk) + size;
+    }
+    return reinterpret_cast<void*>(p);
+}
+
+} // end namespace coop
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+#include "context.h"
+#include "self.h"
+
+namespace coop
+{
+
+// Request-scoped monotonic arena. Where Alloc<T> is strictly LIFO -- so a container that grows,
+// or two buffers freed out of order, has to go to malloc -- an Arena hands out any mix of sizes
+// and frees nothing until Reset, which releases everything at once. One per request:
+//
+//   coop::Arena arena;                                     // on the handling context
+//   coop::ArenaResource resource(arena);
+//   std::pmr::vector<Header> headers(&resource);
+//   std::pmr::string body(&resource);
+//   ...
+//   arena.Reset();                                         // or let it go out of scope
+//
+// The arena starts in a region bump-allocated from the context's segment heap, so a small request
+// never leaves the segment. The region is capped at half the room left between the heap and the
+// constructing frame, leaving the stack the rest; on a segment with no room for one the arena
+// starts straight in chunks. When the region is used up, 4KB chunks come from the cooperator's
+// SizeClassAllocator (pooled, so steady-state requests do not call malloc); an allocation too big
+// for a chunk to carry gets a chunk of its own, sized to it, without abandoning the current one.
+//
+// The heap region makes an Arena an RAII bump allocation like Alloc<T>: strictly LIFO with respect
+// to other bump allocations on its context. It must be built on, used on and destroyed on that
+// context, and is neither copyable nor movable.
+//
+// Neither Reset nor the destructor runs destructors: the arena frees memory, not objects. pmr
+// containers destroy their own elements; New<T> is for trivially destructible types, or ones the
+// caller destroys.
+//
+struct Arena
+{
+    static constexpr size_t kDefaultHeapBytes   = 4096;
+    static constexpr size_t kMinHeapBytes       = 256;          // a smaller region is not worth it
+    static constexpr size_t kChunkBytes         = 4096;         // SizeClassAllocator::kMaxClass
+
+    Arena(Arena const&) = delete;
+    Arena(Arena&&) = delete;
+
+    // Take up to heapBytes of ctx's segment heap for the first region; zero for none
+    //
+    explicit Arena(Context* ctx = Self(), size_t heapBytes = kDefaultHeapBytes);
+    ~Arena();
+
+    // n bytes aligned to align (a power of two), or null if no chunk could be had
+    //
+    void* Allocate(size_t n, size_t align = alignof(std::max_align_t))
+    {
+        uintptr_t p = (m_cursor + align - 1) & ~(align - 1);
+        if (p + n <= m_end && p) [[likely]]
+        {
+            m_cursor = p + n;
+            return reinterpret_cast<void*>(p);
+        }
+        return AllocateSlow(n, align);
+    }
+
+    template<typename T, typename... Args>
+    T* New(Args&&... args)
+    {
+        void* memory = Allocate(sizeof(T), alignof(T));
+        return memory ? new (memory) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    // Free every allocation: chunks go back to the cooperator's allocator and the heap region is
+    // rewound for reuse
+    //
+    void Reset();
+
+    // ---- Statistics ----
+
+    // Bytes of the segment heap the arena holds, zero if it started in chunks
+    //
+    size_t HeapBytes() const { return m_heapEnd - m_heapBase; }
+
+    // Chunks taken since the last Reset
+    //
+    size_t ChunkCount() const { return m_chunkCount; }
+
+  private:
+    struct alignas(std::max_align_t) Chunk
+    {
+        Chunk*  next;
+        size_t  size;
+    };
+
+    void* AllocateSlow(size_t n, size_t align);
+
+    Context*    m_ctx;
+    uintptr_t   m_cursor{0};
+    uintptr_t   m_end{0};
+    uintptr_t   m_heapBase{0};
+    uintptr_t   m_heapEnd{0};
+    Chunk*      m_chunks{nullptr};
+    size_t      m_chunkCount{0};
+};
+
+// std::pmr adaptor over an Arena. Deallocation is a no-op, the memory coming back at the arena's
+// Reset; two resources are equal only if they are the same object.
+//
+struct ArenaResource : std::pmr::memory_resource
+{
+    explicit ArenaResource(Arena& arena) : m_arena(arena) {}
+
+    Arena& GetArena() const { return m_arena; }
+
+  private:
+    void* do_allocate(size_t bytes, size_t align) override
+    {
+        void* memory = m_arena.Allocate(bytes, align);
+        if (!memory)
+        {
+            throw std::bad_alloc();                 // the memory_resource contract
+        }
+        return memory;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    Arena& m_arena;
+};
+
+} // end namespace coop
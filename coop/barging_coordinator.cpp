@@ -0,0 +1,91 @@
+#include "barging_coordinator.h"
+
+#include <cassert>
+
+#include "shared_stack.h"
+
+namespace coop
+{
+
+BargingCoordinator::BargingCoordinator(
+    uint32_t starvationLimit /* = BARGING_STARVATION_LIMIT_DEFAULT */)
+: m_starvationLimit(starvationLimit)
+{
+}
+
+BargingCoordinator::~BargingCoordinator()
+{
+    assert((m_waiters.IsEmpty() || detail::CooperatorIsShuttingDown())
+           && "barging coordinator destroyed with waiters still queued");
+}
+
+bool BargingCoordinator::TryAcquire()
+{
+    if (m_held)
+    {
+        return false;
+    }
+    m_held = true;
+    return true;
+}
+
+void BargingCoordinator::Acquire(Context* ctx)
+{
+    if (TryAcquire())
+    {
+        return;
+    }
+
+    // The waiter stays on the list, at the head once it gets there, until it owns the lock: a
+    // waiter that loses the race waits again without giving up its place
+    //
+    detail::WaitStorage<Waiter> stored(ctx, ctx);
+    Waiter& waiter = *stored.Get();
+    m_waiters.Push(&waiter);
+    for (;;)
+    {
+        waiter.coord.Acquire(ctx);
+        if (waiter.granted)
+        {
+            break;
+        }
+
+        m_woken = false;
+        if (TryAcquire())
+        {
+            m_waiters.Remove(&waiter);
+            break;
+        }
+        m_lost++;
+        m_barges++;
+    }
+    m_lost = 0;
+}
+
+void BargingCoordinator::Release()
+{
+    assert(m_held);
+    m_held = false;
+    if (m_woken || m_waiters.IsEmpty())
+    {
+        return;
+    }
+
+    // The head goes on the run queue either way; at the bound it wakes owning the lock
+    //
+    auto* head = m_waiters.Peek();
+    if (m_lost >= m_starvationLimit)
+    {
+        m_waiters.Pop();
+        m_held = true;
+        m_handoffs++;
+        head->granted = true;
+    }
+    else
+    {
+        m_woken = true;
+    }
+    head->coord.Release(nullptr, false);
+}
+
+} // end namespace coop
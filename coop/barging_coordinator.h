@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+#include "context.h"
+#include "coordinator.h"
+#include "detail/embedded_list.h"
+
+namespace coop
+{
+
+// How many times the woken head waiter may lose the lock to a barger before the next Release
+// hands it over directly
+//
+static constexpr uint32_t BARGING_STARVATION_LIMIT_DEFAULT = 4;
+
+// BargingCoordinator is a lock for the contexts of one cooperator that trades Coordinator's strict
+// FIFO handoff for throughput under contention.
+//
+//  coop::BargingCoordinator lock;
+//
+//  lock.Acquire(ctx);
+//  table.Insert(...);
+//  lock.Release();
+//
+// Coordinator::Release hands ownership to the head waiter, so a hot lock convoys: the releaser,
+// coming straight back for it, finds it held by a waiter that has not even run yet and blocks
+// behind it, and every acquire from then on pays a block and a wake. Here Release only marks the
+// lock free and wakes the head waiter; whoever runs first takes it. The head waiter, when it runs,
+// takes the lock if it is still free, and otherwise goes back to waiting, still at the head.
+//
+// The starvation bound caps how often that can happen: once the head has lost starvationLimit
+// times, the next Release hands the lock to it, as Coordinator's would. 0 hands over at every
+// Release, which is Coordinator's FIFO. One woken waiter is outstanding at a time, so a release
+// that finds the head already woken wakes nobody new.
+//
+// Not a Coordinator: it cannot be passed to CoordinateWith, and Acquire is not kill-aware, like
+// Coordinator::Acquire. Release wakes without switching, so it is safe from continuations too.
+//
+struct BargingCoordinator
+{
+    BargingCoordinator(BargingCoordinator const&) = delete;
+    BargingCoordinator(BargingCoordinator&&) = delete;
+
+    explicit BargingCoordinator(uint32_t starvationLimit = BARGING_STARVATION_LIMIT_DEFAULT);
+
+    // Waiters would be left parked on a wait list that no longer exists
+    //
+    ~BargingCoordinator();
+
+    bool IsHeld() const { return m_held; }
+
+    // Takes the lock whenever it is free, waiters or not: the barge
+    //
+    bool TryAcquire();
+
+    void Acquire(Context* ctx);
+
+    void Release();
+
+    // Times a woken waiter found the lock taken, and Releases that handed it over at the bound
+    //
+    uint64_t Barges() const { return m_barges; }
+    uint64_t Handoffs() const { return m_handoffs; }
+
+  private:
+    struct Waiter : EmbeddedListHookups<Waiter>
+    {
+        explicit Waiter(Context* ctx) : coord(ctx) {}
+
+        Coordinator     coord;              // held, so Acquire on it parks the waiter
+        bool            granted = false;    // handed the lock at the starvation bound
+    };
+
+    bool                    m_held = false;
+    bool                    m_woken = false;    // the head is woken and has not run yet
+    uint32_t                m_starvationLimit;
+    uint32_t                m_lost = 0;         // times the current head lost
+    uint64_t                m_barges = 0;
+    uint64_t                m_handoffs = 0;
+    EmbeddedList<Waiter>    m_waiters;
+};
+
+} // end namespace coop
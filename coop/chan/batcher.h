@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+#include "coop/coordinate_with.h"
+#include "coop/coordinator.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator.hpp"
+#include "coop/self.h"
+#include "coop/time/interval.h"
+#include "coop/time/now.h"
+#include "coop/time/sleep.h"
+
+// Batcher collects items until there are N of them or maxDelay has passed since the first, then
+// hands them to a flush function as one contiguous span. It turns a per-item cost (a syscall, a
+// round trip, a DB statement) into a per-batch one without every caller writing its own
+// count-or-deadline loop.
+//
+//   coop::chan::Batcher<Metric, 256> metrics(ctx, std::chrono::milliseconds(5),
+//       [&](coop::Context* flushCtx, std::span<Metric> batch)
+//       {
+//           Ship(flushCtx, batch);                  // may block: IO, a channel send, ...
+//       });
+//
+//   metrics.Add(ctx, m);                            // from any context on this cooperator
+//
+// The flush runs on a context of the batcher's own, so it may block. While it does, producers
+// fill a second buffer; when that one is full too, Add blocks until the flush returns and the
+// buffers swap -- a slow consumer holds its producers back rather than growing a queue. TryAdd
+// refuses instead.
+//
+// The deadline is armed once per batch, when the first item lands: the flush context parks on a
+// Sleeper in the cooperator's timer queue (per its TimerMode) and on a wake that a full batch,
+// Flush() or Stop() releases. An idle batcher has no timer in flight.
+//
+// The span belongs to the batcher once flush returns; flush may move items out of it. Single
+// cooperator: the batcher, its producers, and the flush context share one. Stop() (and
+// ~Batcher()) flushes what is buffered, then waits for the flush context to exit.
+//
+
+namespace coop
+{
+namespace chan
+{
+
+template<typename T, size_t N>
+struct Batcher
+{
+    static_assert(N > 0, "Batcher capacity N must be at least 1.");
+
+    Batcher(Batcher const&) = delete;
+    Batcher(Batcher&&)      = delete;
+
+    template<typename Fn>
+    Batcher(Context* ctx, time::Interval maxDelay, Fn flush);
+
+    ~Batcher() { Stop(); }
+
+    // Add an item to the batch, blocking while both buffers are full. Returns false once the
+    // batcher is stopped or ctx is killed, leaving value with the caller.
+    //
+    bool Add(Context* ctx, T value);
+
+    // Add without blocking: false when both buffers are full or the batcher is stopped
+    //
+    bool TryAdd(T value);
+
+    // Flush what is buffered now, without waiting for N items or the deadline
+    //
+    void Flush();
+
+    // Flush what is buffered, refuse further items, and wait for the flush context to exit.
+    // Must be called from a cooperating context. Idempotent.
+    //
+    void Stop();
+
+    size_t Buffered() const { return m_size; }
+
+    struct Stats
+    {
+        uint64_t batches = 0;
+        uint64_t items = 0;
+        uint64_t full = 0;          // batches flushed at N items
+        uint64_t expired = 0;       // batches flushed at the deadline
+    };
+
+    Stats const& GetStats() const { return m_stats; }
+
+  private:
+    void Put(T&& value);
+    void Wake();
+
+    // Wait out the current batch and swap it for the other buffer. Returns the batch, empty when
+    // there is nothing left to flush and the batcher is stopping.
+    //
+    std::span<T> Next(Context* ctx);
+
+    time::Interval              m_maxDelay;
+    std::array<T, N>            m_buffers[2];
+    size_t                      m_fill = 0;             // which buffer producers write
+    size_t                      m_size = 0;             // items in it
+    int64_t                     m_firstUs = 0;          // when its first item landed
+    bool                        m_flushNow = false;
+    bool                        m_stopping = false;
+    Stats                       m_stats;
+
+    // Held while the flush context has nothing to do. Released (latched if it is busy) when a
+    // batch starts, fills, or is flushed early.
+    //
+    Coordinator m_wake;
+
+    // Held while the buffer being filled is full: producers in Add queue on it
+    //
+    Coordinator m_space;
+
+    // Held by the flush context while it runs; Stop() Flashes it
+    //
+    Coordinator m_exit;
+};
+
+template<typename T, size_t N>
+template<typename Fn>
+Batcher<T, N>::Batcher(Context* ctx, time::Interval maxDelay, Fn flush)
+: m_maxDelay(maxDelay)
+, m_wake(ctx)
+{
+    // Spawn switches to the flush context at once; it holds m_exit and parks on m_wake before
+    // the constructor returns.
+    //
+    Spawn([this, flush = std::move(flush)](Context* flushCtx) mutable
+    {
+        m_exit.Acquire(flushCtx);
+        for (;;)
+        {
+            auto batch = Next(flushCtx);
+            if (batch.empty())
+            {
+                break;
+            }
+            flush(flushCtx, batch);
+        }
+
+        // Producers still queued for space are refused
+        //
+        if (m_space.IsHeld())
+        {
+            m_space.Release(flushCtx, false);
+        }
+        m_exit.Release(flushCtx);
+    });
+}
+
+template<typename T, size_t N>
+bool Batcher<T, N>::Add(Context* ctx, T value)
+{
+    if (m_size < N && !m_stopping)
+    {
+        Put(std::move(value));
+        return true;
+    }
+
+    // Full: queue on m_space. Whoever wins it holds it, and passes it on if there is still room
+    // once its item is in, as a channel's sender does m_send.
+    //
+    for (;;)
+    {
+        if (m_stopping)
+        {
+            if (m_space.IsHeld())
+            {
+                m_space.Release(ctx, false);
+            }
+            return false;
+        }
+        if (m_size < N)
+        {
+            break;
+        }
+        if (CoordinateWithKill(ctx, &m_space).Killed())
+        {
+            return false;
+        }
+    }
+
+    Put(std::move(value));
+    if (m_size < N && m_space.IsHeld())
+    {
+        m_space.Release(ctx, false);
+    }
+    return true;
+}
+
+template<typename T, size_t N>
+bool Batcher<T, N>::TryAdd(T value)
+{
+    if (m_size == N || m_stopping)
+    {
+        return false;
+    }
+    Put(std::move(value));
+    return true;
+}
+
+template<typename T, size_t N>
+void Batcher<T, N>::Put(T&& value)
+{
+    if (m_size == 0)
+    {
+        m_firstUs = time::MonotonicMicros();
+    }
+    m_buffers[m_fill][m_size++] = std::move(value);
+
+    if (m_size == 1 || m_size == N)
+    {
+        Wake();
+    }
+    if (m_size == N)
+    {
+        m_space.TryAcquire();
+    }
+}
+
+template<typename T, size_t N>
+void Batcher<T, N>::Wake()
+{
+    if (m_wake.IsHeld())
+    {
+        m_wake.Release(Self(), false);
+    }
+}
+
+template<typename T, size_t N>
+void Batcher<T, N>::Flush()
+{
+    if (m_size > 0)
+    {
+        m_flushNow = true;
+        Wake();
+    }
+}
+
+template<typename T, size_t N>
+void Batcher<T, N>::Stop()
+{
+    m_stopping = true;
+    if (m_exit.IsHeld())
+    {
+        Wake();
+        m_exit.Flash(Self());
+    }
+}
+
+template<typename T, size_t N>
+std::span<T> Batcher<T, N>::Next(Context* ctx)
+{
+    // A wake latched while the last flush ran is stale by now; the loops below recheck the state
+    // and park again.
+    //
+    while (m_size == 0 && !m_stopping)
+    {
+        if (CoordinateWithKill(ctx, &m_wake).Killed())
+        {
+            m_stopping = true;
+        }
+    }
+
+    // One deadline per batch, measured from its first item, on the cooperator's own timers: with
+    // a queue TimerMode it rides the one kernel timeout the cooperator keeps armed. A Sleeper that
+    // cannot arm flushes now rather than late.
+    //
+    auto waiting = [this] { return m_size > 0 && m_size < N && !m_flushNow && !m_stopping; };
+    bool expired = false;
+    if (waiting())
+    {
+        int64_t remaining = m_firstUs + m_maxDelay.count() - time::MonotonicMicros();
+        time::Sleeper deadline(ctx, time::Interval(std::max<int64_t>(remaining, 0)));
+        if (remaining <= 0 || !deadline.Arm())
+        {
+            expired = true;
+        }
+        while (!expired && waiting())
+        {
+            auto r = CoordinateWithKill(ctx, &m_wake, deadline.GetCoordinator());
+            if (r.Killed())
+            {
+                m_stopping = true;
+            }
+            else if (r == deadline.GetCoordinator())
+            {
+                expired = true;
+            }
+        }
+    }
+
+    std::span<T> batch(m_buffers[m_fill].data(), m_size);
+    m_fill ^= 1;
+    m_size = 0;
+    m_flushNow = false;
+    if (m_space.IsHeld())
+    {
+        m_space.Release(ctx, false);
+    }
+
+    if (!batch.empty())
+    {
+        m_stats.batches++;
+        m_stats.items += batch.size();
+        m_stats.full += batch.size() == N;
+        m_stats.expired += expired;
+    }
+    return batch;
+}
+
+} // end namespace chan
+} // end namespace coop
@@ -0,0 +1,568 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "coop/chan/subscribe.h"
+#include "coop/coordinate_with.h"
+#include "coop/coordinator.h"
+#include "coop/detail/coordinator_extension.h"
+#include "coop/detail/embedded_list.h"
+#include "coop/self.h"
+#include "coop/thunk.h"
+
+// Broadcast is the fan-out counterpart to Subscribe's fan-in: one writer, many readers, and every
+// item stored once. The writer appends to a ring of N slots; each reader is a Cursor holding its
+// own position in that ring, so a Send costs one slot write however many readers there are.
+//
+//   coop::chan::Broadcast<Quote, 256> quotes;
+//
+//   coop::chan::Broadcast<Quote, 256>::Reader rx(quotes, coop::chan::Lag::DropOldest);
+//   Quote q;
+//   while (rx.Recv(q)) { ... }
+//
+//   auto book = coop::chan::Listen(ctx, quotes, [&](Quote const& q) { ... });
+//
+//   quotes.Send(q);
+//
+// A Reader copies items out and blocks in Recv like a channel's receiver. A Listener is the
+// continuation form, after Subscribe's arms: no parked context, and its handler sees each item in
+// place as a const reference. The handler is a Thunk and must not suspend; it may take a Control
+// and Stop() to retire the listener.
+//
+// A cursor N items behind the writer is in the way of the next Send, which is where its Lag policy
+// applies (see Lag). Cursors start at the writer's position: they see what is sent after they
+// attach, not what came before.
+//
+// Single cooperator: the writer, the cursors, and the Broadcast share one. Shutdown lets the
+// cursors read what is left first; destroying the Broadcast detaches them at once.
+//
+
+namespace coop
+{
+namespace chan
+{
+
+static constexpr int BROADCAST_LIST_CURSORS = 0;
+static constexpr int BROADCAST_LIST_WAITING = 1;
+
+// What a Send does about a cursor it would overrun
+//
+enum class Lag : uint8_t
+{
+    Block,          // wait for the cursor to read (TrySend fails instead)
+    DropOldest,     // move the cursor past its oldest unread item
+    Disconnect,     // cut the cursor off; it reports shutdown from then on
+};
+
+template<typename T, size_t N = 64>
+struct Broadcast
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "Broadcast capacity N must be a power of 2.");
+
+    struct Cursor;
+    struct Reader;
+    template<typename H>
+    struct Listener;
+
+    Broadcast() = default;
+    Broadcast(Broadcast const&) = delete;
+    Broadcast(Broadcast&&)      = delete;
+
+    ~Broadcast();
+
+    // Append value for every cursor, blocking while a Block cursor is N items behind. Returns
+    // false once the broadcast is shut down.
+    //
+    bool Send(T value);
+
+    // As Send, but returns false rather than wait for a Block cursor
+    //
+    bool TrySend(T value);
+
+    // Idempotent. Cursors read what is left, then report shutdown.
+    //
+    void Shutdown();
+
+    bool IsShutdown() const { return m_shutdown; }
+    size_t Readers() const { return m_count; }
+    uint64_t Sent() const { return m_tail; }
+
+  private:
+    using CursorList  = EmbeddedList<Cursor, int, BROADCAST_LIST_CURSORS>;
+    using WaitingList = EmbeddedList<Cursor, int, BROADCAST_LIST_WAITING>;
+
+    // Settle every cursor the next item would overrun. False if a Block cursor is among them, in
+    // which case nothing is changed.
+    //
+    bool MakeRoom();
+    void Publish(T&& value);
+    void WakeWaiting();
+    void WakeWriter();
+
+    void Attach(Cursor* cursor);
+    void Detach(Cursor* cursor);
+
+    T               m_slots[N]{};
+    uint64_t        m_tail = 0;
+    uint64_t        m_floor = 0;        // no cursor is behind this
+    CursorList      m_cursors;
+    WaitingList     m_waiting;          // cursors that have read everything, with m_ready held
+    size_t          m_count = 0;
+    bool            m_shutdown = false;
+    bool            m_writerWaiting = false;
+    Coordinator     m_space;            // the writer blocks on it while a Block cursor lags
+};
+
+// A reader's position in the ring. Reader and Listener build on it.
+//
+template<typename T, size_t N>
+struct Broadcast<T, N>::Cursor
+    : EmbeddedListHookups<Cursor, int, BROADCAST_LIST_CURSORS>
+    , EmbeddedListHookups<Cursor, int, BROADCAST_LIST_WAITING>
+{
+    Cursor(Broadcast& broadcast, Lag lag)
+    : m_lag(lag)
+    {
+        broadcast.Attach(this);
+    }
+
+    ~Cursor()
+    {
+        if (m_broadcast)
+        {
+            m_broadcast->Detach(this);
+        }
+    }
+
+    Cursor(Cursor const&) = delete;
+    Cursor(Cursor&&)      = delete;
+
+    // Items sent and not yet read
+    //
+    size_t Pending() const { return m_broadcast ? m_broadcast->m_tail - m_next : 0; }
+
+    uint64_t Dropped() const { return m_dropped; }
+    bool IsDisconnected() const { return m_disconnected; }
+
+  protected:
+    friend struct Broadcast;
+
+    // The next unread item, or nullptr if there is none
+    //
+    T const* Peek() const
+    {
+        if (!m_broadcast || m_next == m_broadcast->m_tail)
+        {
+            return nullptr;
+        }
+        return &m_broadcast->m_slots[m_next & (N - 1)];
+    }
+
+    // Past the item Peek returned. A writer waiting for room re-checks; this may have made it.
+    //
+    void Advance()
+    {
+        m_next++;
+        if (m_lag == Lag::Block)
+        {
+            m_broadcast->WakeWriter();
+        }
+    }
+
+    // Nothing more will come: detached, disconnected, or shut down with everything read
+    //
+    bool Finished() const
+    {
+        return !m_broadcast || (m_broadcast->m_shutdown && m_next == m_broadcast->m_tail);
+    }
+
+    // Wait for the next Send: m_ready held and on the waiting list, which Send releases
+    //
+    void Park()
+    {
+        if (!m_ready.IsHeld())
+        {
+            m_ready.TryAcquire();
+        }
+        if (!m_parked)
+        {
+            m_broadcast->m_waiting.Push(this);
+            m_parked = true;
+        }
+    }
+
+    Broadcast*      m_broadcast = nullptr;
+    uint64_t        m_next = 0;
+    uint64_t        m_dropped = 0;
+    Lag             m_lag;
+    bool            m_disconnected = false;
+    bool            m_parked = false;
+    Coordinator     m_ready;
+};
+
+// A cursor read from a context: Recv copies the next item out, blocking until there is one
+//
+template<typename T, size_t N>
+struct Broadcast<T, N>::Reader final : Cursor
+{
+    explicit Reader(Broadcast& broadcast, Lag lag = Lag::Block)
+    : Cursor(broadcast, lag)
+    {
+    }
+
+    bool TryRecv(T& value /* out */)
+    {
+        T const* item = Cursor::Peek();
+        if (!item)
+        {
+            return false;
+        }
+        value = *item;
+        Cursor::Advance();
+        return true;
+    }
+
+    // False once the broadcast is shut down and read, destroyed, or has disconnected us
+    //
+    bool Recv(T& value /* out */)
+    {
+        Context* ctx = Self();
+        for (;;)
+        {
+            if (TryRecv(value))
+            {
+                return true;
+            }
+            if (Cursor::Finished())
+            {
+                return false;
+            }
+            Cursor::Park();
+            Cursor::m_ready.Acquire(ctx);
+        }
+    }
+
+    // As Recv, but the wait is kill-aware: false as well when the context is killed first
+    //
+    bool RecvKill(T& value /* out */)
+    {
+        Context* ctx = Self();
+        for (;;)
+        {
+            if (TryRecv(value))
+            {
+                return true;
+            }
+            if (Cursor::Finished())
+            {
+                return false;
+            }
+            Cursor::Park();
+            if (CoordinateWithKill(ctx, &this->m_ready).Killed())
+            {
+                return false;
+            }
+        }
+    }
+};
+
+// A cursor read by a continuation: the handler runs for each item, in place, from the cooperator's
+// continuation drain after the Send that woke it. It retires when the handler Stops, on Cancel, or
+// when the broadcast is finished; Wait joins that.
+//
+template<typename T, size_t N>
+template<typename H>
+struct Broadcast<T, N>::Listener final : Cursor, Continuation
+{
+    Listener(Context* ctx, Broadcast& broadcast, H handler, Lag lag = Lag::DropOldest)
+    : Cursor(broadcast, lag)
+    , m_coordinated(static_cast<Continuation*>(this))
+    , m_handler(std::move(handler))
+    , m_done(ctx)
+    {
+        Arm();
+    }
+
+    ~Listener()
+    {
+        Cancel();
+    }
+
+    // Retire now. Idempotent.
+    //
+    void Cancel()
+    {
+        if (m_listed)
+        {
+            m_coordinated.Pop();
+            m_listed = false;
+        }
+        Retire();
+    }
+
+    // Join: block until the listener retires
+    //
+    void Wait()
+    {
+        Context* ctx = Self();
+        CoordinateWith(ctx, &m_done);
+        m_done.Release(ctx);
+    }
+
+    bool IsRetired() const { return m_retired; }
+
+  private:
+    void Run() final
+    {
+        m_listed = false;
+        if (m_retired)
+        {
+            return;
+        }
+
+        Control ctl;
+        {
+            ::coop::detail::ThunkScope inThunk;
+            while (T const* item = Cursor::Peek())
+            {
+                detail::Dispatch(m_handler, *item, ctl);
+                Cursor::Advance();
+                if (ctl.m_stop || ctl.m_cancelAll)
+                {
+                    break;
+                }
+            }
+        }
+
+        if (ctl.m_stop || ctl.m_cancelAll)
+        {
+            Retire();
+            return;
+        }
+        Arm();
+    }
+
+    void Arm()
+    {
+        if (Cursor::Finished())
+        {
+            Retire();
+            return;
+        }
+        Cursor::Park();
+        CoordinatorExtension().AddAsBlocked(&this->m_ready, &m_coordinated);
+        m_listed = true;
+    }
+
+    // Off the broadcast, so a Block listener no longer holds the writer, and release Wait
+    //
+    void Retire()
+    {
+        if (m_retired)
+        {
+            return;
+        }
+        m_retired = true;
+        if (Cursor::m_broadcast)
+        {
+            Cursor::m_broadcast->Detach(this);
+        }
+        m_done.Release(nullptr, false);
+    }
+
+    Coordinated     m_coordinated;
+    H               m_handler;
+    Coordinator     m_done;             // held until retired
+    bool            m_listed = false;
+    bool            m_retired = false;
+};
+
+// Listen(ctx, broadcast, handler[, lag]) -- a Listener with the handler type deduced. Bind it to a
+// named local that outlives the traffic.
+//
+template<typename T, size_t N, typename H>
+[[nodiscard]] typename Broadcast<T, N>::template Listener<H>
+Listen(Context* ctx, Broadcast<T, N>& broadcast, H handler, Lag lag = Lag::DropOldest)
+{
+    return typename Broadcast<T, N>::template Listener<H>(ctx, broadcast, std::move(handler), lag);
+}
+
+// ---------------------------------------------------------------------------
+// Broadcast
+// ---------------------------------------------------------------------------
+
+template<typename T, size_t N>
+Broadcast<T, N>::~Broadcast()
+{
+    Shutdown();
+    while (Cursor* cursor = m_cursors.Pop())
+    {
+        cursor->m_broadcast = nullptr;
+    }
+    m_count = 0;
+}
+
+template<typename T, size_t N>
+bool Broadcast<T, N>::Send(T value)
+{
+    Context* ctx = Self();
+    while (!m_shutdown && !MakeRoom())
+    {
+        m_writerWaiting = true;
+        if (!m_space.IsHeld())
+        {
+            m_space.TryAcquire();
+        }
+        m_space.Acquire(ctx);
+    }
+    if (m_shutdown)
+    {
+        return false;
+    }
+    Publish(std::move(value));
+    return true;
+}
+
+template<typename T, size_t N>
+bool Broadcast<T, N>::TrySend(T value)
+{
+    if (m_shutdown || !MakeRoom())
+    {
+        return false;
+    }
+    Publish(std::move(value));
+    return true;
+}
+
+template<typename T, size_t N>
+void Broadcast<T, N>::Shutdown()
+{
+    if (m_shutdown)
+    {
+        return;
+    }
+    m_shutdown = true;
+    WakeWaiting();
+    WakeWriter();
+}
+
+// The slot for item m_tail last held item m_tail - N; a cursor still short of that is in the way.
+// The floor spares the walk until some cursor could be.
+//
+template<typename T, size_t N>
+bool Broadcast<T, N>::MakeRoom()
+{
+    if (m_tail - m_floor < N)
+    {
+        return true;
+    }
+
+    for (Cursor* cursor : m_cursors)
+    {
+        if (cursor->m_lag == Lag::Block && m_tail - cursor->m_next >= N)
+        {
+            return false;
+        }
+    }
+
+    uint64_t floor = m_tail;
+    for (auto it = m_cursors.begin(); it != m_cursors.end();)
+    {
+        Cursor* cursor = *it;
+        ++it;
+
+        if (m_tail - cursor->m_next >= N)
+        {
+            if (cursor->m_lag == Lag::Disconnect)
+            {
+                Detach(cursor);
+                cursor->m_disconnected = true;
+                continue;
+            }
+            cursor->m_dropped += (m_tail - N + 1) - cursor->m_next;
+            cursor->m_next = m_tail - N + 1;
+        }
+        if (cursor->m_next < floor)
+        {
+            floor = cursor->m_next;
+        }
+    }
+    m_floor = floor;
+    return true;
+}
+
+template<typename T, size_t N>
+void Broadcast<T, N>::Publish(T&& value)
+{
+    m_slots[m_tail & (N - 1)] = std::move(value);
+    m_tail++;
+    WakeWaiting();
+}
+
+// Every parked cursor has something to read now. schedule=false: readers run once the writer
+// yields, and a Send from a continuation has no context to switch from.
+//
+template<typename T, size_t N>
+void Broadcast<T, N>::WakeWaiting()
+{
+    while (Cursor* cursor = m_waiting.Pop())
+    {
+        cursor->m_parked = false;
+        if (cursor->m_ready.IsHeld())
+        {
+            cursor->m_ready.Release(nullptr, false);
+        }
+    }
+}
+
+template<typename T, size_t N>
+void Broadcast<T, N>::WakeWriter()
+{
+    if (!m_writerWaiting)
+    {
+        return;
+    }
+    m_writerWaiting = false;
+    if (m_space.IsHeld())
+    {
+        m_space.Release(nullptr, false);
+    }
+}
+
+template<typename T, size_t N>
+void Broadcast<T, N>::Attach(Cursor* cursor)
+{
+    cursor->m_broadcast = this;
+    cursor->m_next = m_tail;
+    m_cursors.Push(cursor);
+    m_count++;
+}
+
+// Off both lists. A parked cursor is woken, so its reader sees that it is finished.
+//
+template<typename T, size_t N>
+void Broadcast<T, N>::Detach(Cursor* cursor)
+{
+    m_cursors.Remove(cursor);
+    m_count--;
+    if (cursor->m_parked)
+    {
+        m_waiting.Remove(cursor);
+        cursor->m_parked = false;
+        if (cursor->m_ready.IsHeld())
+        {
+            cursor->m_ready.Release(nullptr, false);
+        }
+    }
+    cursor->m_broadcast = nullptr;
+    if (cursor->m_lag == Lag::Block)
+    {
+        WakeWriter();
+    }
+}
+
+} // end namespace chan
+} // end namespace coop
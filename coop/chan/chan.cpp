@@ -6,7 +6,7 @@ namespace coop
 namespace chan
 {
 
-bool BaseChannel::Shutdown()
+bool BaseChannel::Shutdown(bool schedule /* = true */)
 {
     if (m_shutdown)
     {
@@ -18,11 +18,11 @@ bool BaseChannel::Shutdown()
 
     if (m_recv.IsHeld())
     {
-        m_recv.Release(ctx);
+        m_recv.Release(ctx, schedule);
     }
     if (m_send.IsHeld())
     {
-        m_send.Release(ctx);
+        m_send.Release(ctx, schedule);
     }
 
     return true;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <span>
 #include <utility>
 
 #include "coop/coordinator.h"
@@ -73,7 +74,10 @@ struct BaseChannel
         return m_shutdown;
     }
 
-    bool Shutdown();
+    // schedule is passed to the releases that wake waiters: false from a context-free caller (a
+    // continuation, a CQE dispatch), which has nothing to switch from.
+    //
+    bool Shutdown(bool schedule = true);
 
     Coordinator m_recv;
     Coordinator m_send;
@@ -258,6 +262,62 @@ struct RecvChannel : virtual TypedBaseChannel<T>
         return n;
     }
 
+    // Receive up to out.size() items, blocking only until at least one is available. Returns the
+    // number received, or 0 once the channel is shut down and empty. Each coordinator changes
+    // state at most once per batch: the blocked sender a full channel had is released once, with
+    // schedule=false, however many slots the batch frees.
+    //
+    size_t RecvBatch(std::span<T> out)
+    {
+        if (out.empty()) return 0;
+
+        Context* ctx = Self();
+        bool holding = false;
+
+        if (Base::IsEmpty())
+        {
+            if (Base::IsShutdown())
+            {
+                if (Base::m_recv.IsHeld())
+                    Base::m_recv.Release(ctx);
+                return 0;
+            }
+
+            // Same spurious-wakeup loop as Recv
+            //
+            Base::m_recv.Acquire(ctx);
+            while (Base::IsEmpty())
+            {
+                if (Base::IsShutdown())
+                {
+                    Base::m_recv.Release(ctx);
+                    return 0;
+                }
+                Base::m_recv.Acquire(ctx);
+            }
+            holding = true;
+        }
+
+        size_t n = 0;
+        while (n < out.size() && RecvImpl(out[n]))
+            n++;
+
+        if (holding)
+        {
+            if (!Base::IsEmpty() || Base::IsShutdown())
+                Base::m_recv.Release(ctx);
+        }
+        else if (Base::IsEmpty() && !Base::IsShutdown())
+        {
+            Base::m_recv.Acquire(ctx);
+        }
+
+        if (Base::m_send.IsHeld() && !Base::IsFull())
+            Base::m_send.Release(ctx, false);
+
+        return n;
+    }
+
     // Complete a recv after m_recv has been acquired externally via CoordinateWith. The caller
     // is responsible for having acquired m_recv (the invariant that m_recv not held ↔ non-empty
     // guarantees RecvImpl will succeed unless the channel was shut down).
@@ -431,6 +491,56 @@ struct SendChannel : virtual TypedBaseChannel<T>
         return true;
     }
 
+    // Move as many of items into the channel as fit, blocking only while it has no room at all.
+    // Returns the number sent -- a prefix of items, which is left moved-from -- or 0 on shutdown.
+    // However many items go in, a blocked receiver is released once, after the whole batch.
+    //
+    size_t SendBatch(std::span<T> items)
+    {
+        if (items.empty() || Base::IsShutdown()) return 0;
+
+        Context* ctx = Self();
+        bool holding = false;
+
+        if (Base::IsFull())
+        {
+            Base::m_send.Acquire(ctx);
+            if (Base::IsShutdown())
+            {
+                Base::m_send.Release(ctx);
+                return 0;
+            }
+            holding = true;
+        }
+
+        bool wasEmpty = Base::IsEmpty();
+        size_t n = 0;
+        while (n < items.size() && !Base::IsFull())
+        {
+            [[maybe_unused]] bool ok = SendImpl(std::move(items[n++]));
+            assert(ok);
+        }
+
+        // Settle m_send before waking the receiver: the acquire below marks an unheld coordinator
+        // and cannot block, and a receiver switched to by the release must find m_send as full
+        // as the channel is.
+        //
+        if (holding)
+        {
+            if (!Base::IsFull())
+                Base::m_send.Release(ctx, false);
+        }
+        else if (Base::IsFull())
+        {
+            Base::m_send.Acquire(ctx);
+        }
+
+        if (wasEmpty && Base::m_recv.IsHeld())
+            Base::m_recv.Release(ctx);
+
+        return n;
+    }
+
     // Complete a send after m_send has been acquired externally via CoordinateWith. The caller
     // is responsible for having acquired m_send (the invariant that m_send not held ↔ non-full
     // guarantees SendImpl will succeed unless the channel was shut down).
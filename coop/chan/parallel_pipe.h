@@ -0,0 +1,267 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "coop/chan/channel.h"
+#include "coop/coordinate_with.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator.hpp"
+#include "coop/self.h"
+#include "coop/work/grid.h"
+
+// ParallelPipe is Pipe for CPU-heavy stages (parse, compress, hash): a Pipe runs its transform on
+// its own context, which bounds the whole pipeline to one core. A ParallelPipe's context only
+// moves items -- each item's transform is shed as an Erg into the cooperator's work::Grid and runs
+// on whichever participant steals it -- and results are put back in source order before they
+// reach the output channel:
+//
+//   auto parsed = coop::chan::ParallelPipe<16>(ctx, lines, [](std::string s) { return Parse(s); },
+//       /*parallelism=*/8);
+//   auto stored = coop::chan::Pipe(ctx, parsed.Chan(), [&](Record r) { return Store(r); });
+//
+// parallelism bounds the items in flight (shed and not yet forwarded). Every in-flight item owns
+// one slot of a sequence-numbered reorder buffer; a result that completes early waits in its slot
+// until everything before it has been forwarded. The pipe stops taking from the source while the
+// window is full, so a slow item, or a full output channel, back-pressures the source rather than
+// growing a queue.
+//
+// fn is bound by the Erg contract: it runs on any participating cooperator, concurrently with
+// itself, and must run to completion without suspending. On a cooperator that has not joined a
+// Grid, Shed falls back to Spawn and the transform runs on this cooperator, one item at a time.
+//
+// Shutdown and Stop() work as Pipe's, and the pipe context waits for its in-flight items to come
+// back -- their results are dropped -- before it lets go of the handle. Like PipeHandle, the
+// returned handle is non-movable and constructed in place (mandatory RVO).
+//
+
+namespace coop
+{
+namespace chan
+{
+
+template<typename Out, size_t N>
+struct ParallelPipeHandle;
+
+namespace detail
+{
+
+template<size_t N, typename T, typename Out, typename Fn>
+void SpawnParallelPipe(ParallelPipeHandle<Out, N>& handle, RecvChannel<T>& src, Fn fn);
+
+} // namespace detail
+
+template<typename Out, size_t N>
+struct ParallelPipeHandle
+{
+    ParallelPipeHandle(const ParallelPipeHandle&) = delete;
+    ParallelPipeHandle(ParallelPipeHandle&&)      = delete;
+
+    // Stop the pipe, wait for its context (and so its in-flight items) to finish, then shut down
+    // the output channel. Idempotent.
+    //
+    void Stop();
+
+    ~ParallelPipeHandle() { Stop(); }
+
+    operator Channel<Out>&() { return m_ch; }
+
+    Channel<Out>& Chan() { return m_ch; }
+
+    size_t Parallelism() const { return m_slots.size(); }
+
+  private:
+    // A result waiting for its turn. Written by the Erg on whichever cooperator ran it; `ready`
+    // is set on the pipe's cooperator once the result has been handed back there.
+    //
+    struct Slot
+    {
+        std::optional<Out> value;
+        bool               ready = false;
+    };
+
+    template<typename T, typename Fn>
+    ParallelPipeHandle(Context* ctx, RecvChannel<T>& src, Fn fn, size_t parallelism)
+    : m_ch(ctx)
+    , m_stop(ctx)
+    , m_arrived(ctx)
+    , m_origin(ctx->GetCooperator())
+    , m_slots(parallelism ? parallelism : 1)
+    {
+        detail::SpawnParallelPipe<N>(*this, src, std::move(fn));
+    }
+
+    Slot& At(uint64_t seq) { return m_slots[seq % m_slots.size()]; }
+
+    // Any cooperator, from the Erg, as its last touch of the handle: store the result and hand it
+    // back to the pipe's cooperator, as ParallelJob::Retire does
+    //
+    void Complete(uint64_t seq, Out&& value)
+    {
+        At(seq).value.emplace(std::move(value));
+        if (Cooperator::thread_cooperator == m_origin)
+        {
+            Arrive(seq);
+            return;
+        }
+        m_origin->Cooperate([this, seq](Context*) { Arrive(seq); });
+    }
+
+    // The pipe's cooperator. m_arrived is a latch: released here, re-held by the pipe context when
+    // it waits, so an arrival while the pipe is busy forwarding is not lost.
+    //
+    void Arrive(uint64_t seq)
+    {
+        At(seq).ready = true;
+        m_arrived.Release(Self(), /*schedule=*/false);
+    }
+
+    template<size_t N2, typename T2, typename Out2, typename Fn2>
+    friend void detail::SpawnParallelPipe(ParallelPipeHandle<Out2, N2>&, RecvChannel<T2>&, Fn2);
+
+    template<size_t N2, typename T, typename Fn>
+    friend auto ParallelPipe(Context*, RecvChannel<T>&, Fn, size_t)
+        -> ParallelPipeHandle<std::invoke_result_t<Fn const&, T>, N2>;
+
+    FixedChannel<Out, N> m_ch;
+    Coordinator          m_stop;      // starts held; Stop() releases to wake the pipe
+    Coordinator          m_exit;      // held by the pipe while running; Flash to wait for exit
+    Coordinator          m_arrived;   // starts held; released when a result comes back
+    Cooperator*          m_origin;
+    std::vector<Slot>    m_slots;
+
+    // Sequence numbers: the next item to shed, and the next result to forward. The window is
+    // everything in between.
+    //
+    uint64_t m_shed = 0;
+    uint64_t m_forwarded = 0;
+};
+
+namespace detail
+{
+
+template<size_t N, typename T, typename Out, typename Fn>
+void SpawnParallelPipe(ParallelPipeHandle<Out, N>& handle, RecvChannel<T>& src, Fn fn)
+{
+    Spawn([&handle, &src, fn = std::move(fn)](Context* pipeCtx)
+    {
+        handle.m_exit.Acquire(pipeCtx);
+
+        const uint64_t window = handle.m_slots.size();
+        bool open = true;
+        bool stopped = false;
+
+        while (!stopped)
+        {
+            // Forward whatever is ready at the head of the window, in sequence order. Blocks if
+            // the output channel is full.
+            //
+            while (handle.m_forwarded < handle.m_shed && handle.At(handle.m_forwarded).ready)
+            {
+                auto& slot = handle.At(handle.m_forwarded);
+                Out value = std::move(*slot.value);
+                slot.value.reset();
+                slot.ready = false;
+                handle.m_forwarded++;
+                if (!handle.m_ch.Send(std::move(value)))
+                {
+                    stopped = true;
+                    break;
+                }
+            }
+            if (stopped)
+            {
+                break;
+            }
+
+            const uint64_t inFlight = handle.m_shed - handle.m_forwarded;
+            if (!open && !inFlight)
+            {
+                break;
+            }
+
+            // Wait for: kill | explicit stop | a result | source data, the last only while the
+            // window has room. Results come first, so the window drains before it refills.
+            //
+            CoordinationResult r = open && inFlight < window
+                ? CoordinateWithKill(pipeCtx, &handle.m_stop, &handle.m_arrived, &src.m_recv)
+                : CoordinateWithKill(pipeCtx, &handle.m_stop, &handle.m_arrived);
+            if (r.Killed() || r == &handle.m_stop)
+            {
+                break;
+            }
+            if (r == &handle.m_arrived)
+            {
+                continue;
+            }
+
+            T val{};
+            if (!src.RecvAcquired(val))
+            {
+                open = false;
+                continue;
+            }
+
+            const uint64_t seq = handle.m_shed++;
+            Shed([&handle, &fn, seq, v = std::move(val)]() mutable
+            {
+                handle.Complete(seq, std::invoke(std::as_const(fn), std::move(v)));
+            });
+        }
+
+        // Shut the output down first, so a receiver blocked on it wakes, as Pipe does
+        //
+        handle.m_ch.Shutdown();
+
+        // The in-flight Ergs still reference the handle and fn. Wait for every one of them,
+        // dropping their results.
+        //
+        while (handle.m_forwarded < handle.m_shed)
+        {
+            auto& slot = handle.At(handle.m_forwarded);
+            if (!slot.ready)
+            {
+                handle.m_arrived.Acquire(pipeCtx);
+                continue;
+            }
+            slot.value.reset();
+            slot.ready = false;
+            handle.m_forwarded++;
+        }
+
+        handle.m_exit.Release(pipeCtx);
+    });
+}
+
+} // namespace detail
+
+// Out is deduced from fn's return type. parallelism is the in-flight window (at least 1); N is the
+// output channel's capacity, as for Pipe.
+//
+template<size_t N = 1, typename T, typename Fn>
+auto ParallelPipe(Context* ctx, RecvChannel<T>& src, Fn fn, size_t parallelism)
+    -> ParallelPipeHandle<std::invoke_result_t<Fn const&, T>, N>
+{
+    using Out = std::invoke_result_t<Fn const&, T>;
+    return ParallelPipeHandle<Out, N>(ctx, src, std::move(fn), parallelism);
+}
+
+template<typename Out, size_t N>
+void ParallelPipeHandle<Out, N>::Stop()
+{
+    if (m_exit.IsHeld())
+    {
+        m_stop.Release(Self());
+        m_exit.Flash(Self());
+    }
+    m_ch.Shutdown();
+}
+
+} // namespace chan
+} // namespace coop
@@ -5,6 +5,7 @@
 #include <cassert>
 #include <memory>
 #include <mutex>
+#include <span>
 #include <thread>
 #include <type_traits>
 #include <utility>
@@ -13,8 +14,13 @@
 #include "coop/coordinator.h"
 #include "coop/cooperator.h"
 #include "coop/cooperator.hpp"
+#include "coop/detail/ring_message.h"
+#include "coop/perf/counters.h"
+#include "coop/perf/probe.h"
+#include "coop/perf/usdt.h"
 #include "coop/self.h"
 #include "coop/time/interval.h"
+#include "coop/time/now.h"
 
 // Passage is a thread-safe queue bridge from external threads (or other cooperators) to a
 // designated receiver cooperator.
@@ -51,9 +57,9 @@ struct MpscRing
             m_slots[i].m_seq.store(i, std::memory_order_relaxed);
     }
 
-    // Wait-free for producers. Returns false if the ring is full.
+    // Wait-free for producers. Returns false if the ring is full, leaving value untouched.
     //
-    bool Push(T value)
+    bool Push(T&& value)
     {
         size_t pos = m_tail.load(std::memory_order_relaxed);
 
@@ -132,10 +138,13 @@ struct MpscRing
 // One producer thread calls Push(); one consumer (the target cooperator thread)
 // calls Pop() / IsEmpty(). This removes producer-side CAS from the hot path.
 // N must be a power of 2.
+//
+// CheckProducer adds the debug-build single-producer assertion. Its thread id and mutex are
+// process-local, so a ring in shared memory (ShmPassage) goes without.
 // ---------------------------------------------------------------------------
 
-template<typename T, size_t N>
-struct SpscRing
+template<typename T, size_t N, bool CheckProducer>
+struct BasicSpscRing
 {
     static_assert(N > 0 && (N & (N - 1)) == 0,
         "SpscRing capacity N must be a power of 2.");
@@ -144,10 +153,13 @@ struct SpscRing
     static_assert(std::is_move_assignable_v<T>,
         "Passage value type T must be move-assignable.");
 
-    bool Push(T value)
+    bool Push(T&& value)
     {
 #ifndef NDEBUG
-        AssertSingleProducer();
+        if constexpr (CheckProducer)
+        {
+            AssertSingleProducer();
+        }
 #endif
 
         const size_t tail = m_tail.load(std::memory_order_relaxed);
@@ -208,6 +220,28 @@ struct SpscRing
     alignas(64) std::atomic<size_t>    m_head{0};  // consumer writes
 };
 
+template<typename T, size_t N>
+using SpscRing = BasicSpscRing<T, N, true>;
+
+// ---------------------------------------------------------------------------
+
+namespace detail
+{
+
+// One spin-wait step: tell the core we are busy-polling so it can back off the pipeline (and a
+// hyperthread sibling gets the cycles)
+//
+inline void SpinPause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+} // end namespace coop::chan::detail
+
 // ---------------------------------------------------------------------------
 
 template<typename T, size_t N, template<typename, size_t> class Ring>
@@ -216,8 +250,13 @@ struct BasicPassage
     BasicPassage(const BasicPassage&) = delete;
     BasicPassage(BasicPassage&&)      = delete;
 
+    // How Recv waits on an empty ring (see DESIGN.md, "The wait policy"). spinMaxUs caps the
+    // busy-poll on a cooperator with nothing else to run (0 never spins); yieldThreshold caps
+    // the yields taken while other contexts are runnable; the timeouts drive the park.
+    //
     struct RecvTuning
     {
+        int64_t spinMaxUs{4};
         int     yieldThreshold{8};
         int64_t timeoutInitialUs{10};
         int64_t timeoutMaxUs{10000};
@@ -228,15 +267,17 @@ struct BasicPassage
     // target: the cooperator that runs the consumer (typically ctx->GetCooperator()).
     //
     explicit BasicPassage(Context* ctx, Cooperator* target, RecvTuning tuning = {})
-    : m_state(std::make_shared<State>(ctx))
+    : m_state(std::make_shared<State>(ctx, target))
     , m_target(target)
     , m_tuning(tuning)
     , m_recvTimeoutUs(tuning.timeoutInitialUs)
+    , m_expectedWaitUs(tuning.timeoutInitialUs)
     {
         assert(ctx && "Passage: ctx must be non-null");
         assert(target && "Passage: target must be non-null");
         assert(ctx->GetCooperator() == target
                && "Passage: ctx must belong to target cooperator");
+        assert(m_tuning.spinMaxUs >= 0);
         assert(m_tuning.yieldThreshold >= 0);
         assert(m_tuning.timeoutInitialUs > 0);
         assert(m_tuning.timeoutMaxUs >= m_tuning.timeoutInitialUs);
@@ -250,6 +291,12 @@ struct BasicPassage
     //
     bool Send(T value);
 
+    // Thread-safe. Push as many of items as the ring has room for, waking the receiver once for
+    // the lot. Returns the number pushed -- a prefix of items, left moved-from -- or 0 if the
+    // passage is shut down or the ring is full.
+    //
+    size_t SendBatch(std::span<T> items);
+
     // Receiver-only, non-blocking pop. Returns false if no item is currently available.
     //
     bool TryRecv(T& value);
@@ -263,36 +310,114 @@ struct BasicPassage
     //
     bool Recv(T& value);
 
+    // Receive up to out.size() items, blocking as Recv does until the first arrives and taking
+    // whatever else is already in the ring. Returns 0 when the passage is shut down and empty.
+    //
+    size_t RecvBatch(std::span<T> out);
+
+    // Receiver-only. Recv's running estimate of how long an empty ring stays empty, the basis of
+    // its spin/yield/park decision.
+    //
+    int64_t ExpectedWaitUs() const { return m_expectedWaitUs; }
+
     // Thread-safe, idempotent shutdown.
     //
     void Shutdown();
 
   private:
-    struct State
+    // The ring and its coordinator, shared with in-flight wakes. Also the RingMessage a producer
+    // on another cooperator posts onto the target's ring to wake the receiver; m_inflight keeps
+    // the state alive while that message is in flight (one at most, under m_wakePending).
+    //
+    struct State : coop::detail::RingMessage
     {
-        explicit State(Context* ctx)
+        State(Context* ctx, Cooperator* target)
         : m_recv(ctx)
+        , m_target(target)
         {
+            deliver = &Deliver;
+            undelivered = &Undelivered;
         }
 
-        Ring<T, N>        m_ring;
-        Coordinator       m_recv;          // held <-> ring empty
-        std::atomic<bool> m_shutdown{false};
-        std::atomic<bool> m_wakePending{false};
+        Ring<T, N>              m_ring;
+        Coordinator             m_recv;          // held <-> ring empty
+        std::atomic<bool>       m_shutdown{false};
+        std::atomic<bool>       m_wakePending{false};
+        Cooperator*             m_target;
+        std::shared_ptr<State>  m_inflight;
     };
 
+    static void Wake(State& state, bool releaseOnEmpty, Context* ctx);
+    static void Deliver(coop::detail::RingMessage* message);
+    static void Undelivered(coop::detail::RingMessage* message);
+
     std::shared_ptr<State>  m_state;
     Cooperator*             m_target;
     RecvTuning              m_tuning;
 
-    // Receiver-local adaptive Recv state.
+    // Receiver-local adaptive Recv state: the park timeout, and an average (weight 1/4) of the
+    // recent waits, a Recv that found an item waiting counting as zero.
     //
-    int     m_recvDryCount{0};
     int64_t m_recvTimeoutUs{0};
+    int64_t m_expectedWaitUs{0};
+
+    void Arrived(int64_t waitedUs);
+    bool Spin();
 
     bool SubmitWake(bool releaseOnEmpty);
 };
 
+// ---------------------------------------------------------------------------
+// BasicPassage::Wake / Deliver / Undelivered
+// ---------------------------------------------------------------------------
+
+// The wake itself, on the target cooperator: from a spawned wake context (ctx), or inline from
+// the CQE dispatch of a posted message (no context, so the release only schedules the receiver).
+//
+template<typename T, size_t N, template<typename, size_t> class Ring>
+void BasicPassage<T, N, Ring>::Wake(State& state, bool releaseOnEmpty, Context* ctx)
+{
+    state.m_wakePending.store(false, std::memory_order_seq_cst);
+
+    // Release on explicit wake requests, non-empty ring, or shutdown.
+    //
+    bool released = (releaseOnEmpty
+                     || state.m_shutdown.load(std::memory_order_acquire)
+                     || !state.m_ring.IsEmpty())
+                    && state.m_recv.IsHeld();
+    if (released)
+    {
+        state.m_recv.Release(ctx, ctx != nullptr);
+    }
+    COOP_USDT(passage_wake, &state, released);
+}
+
+// A posted wake arrived. Shutdown's release-on-empty request needs no flag of its own here: it
+// only follows m_shutdown, which Wake checks.
+//
+template<typename T, size_t N, template<typename, size_t> class Ring>
+void BasicPassage<T, N, Ring>::Deliver(coop::detail::RingMessage* message)
+{
+    auto state = std::move(static_cast<State*>(message)->m_inflight);
+    Wake(*state, false, nullptr);
+}
+
+// The kernel refused the post (on the producer's cooperator): hand the wake over as a submission
+//
+template<typename T, size_t N, template<typename, size_t> class Ring>
+void BasicPassage<T, N, Ring>::Undelivered(coop::detail::RingMessage* message)
+{
+    auto state = std::move(static_cast<State*>(message)->m_inflight);
+    bool submitted = state->m_target->Cooperate([state](Context* ctx)
+    {
+        Wake(*state, false, ctx);
+    });
+    if (!submitted)
+    {
+        state->m_wakePending.store(false, std::memory_order_seq_cst);
+    }
+}
+
 // ---------------------------------------------------------------------------
 // BasicPassage::SubmitWake
 // ---------------------------------------------------------------------------
@@ -309,22 +434,26 @@ bool BasicPassage<T, N, Ring>::SubmitWake(bool releaseOnEmpty)
         return true;  // wake already queued/in-flight
     }
 
-    auto wakeFn = [state, releaseOnEmpty](Context* ctx)
+    // From another cooperator, post the wake onto the target's ring: its CQE dispatch releases
+    // m_recv inline, with no eventfd, drainer, or wake context in between.
+    //
+    auto* self = Cooperator::thread_cooperator;
+    if (self && self != m_target)
     {
-        state->m_wakePending.store(false, std::memory_order_seq_cst);
-
-        // Release on explicit wake requests, non-empty ring, or shutdown.
-        //
-        if ((releaseOnEmpty
-             || state->m_shutdown.load(std::memory_order_acquire)
-             || !state->m_ring.IsEmpty())
-            && state->m_recv.IsHeld())
+        state->m_inflight = state;
+        if (m_target->PostMessage(state.get()))
         {
-            state->m_recv.Release(ctx);
+            return true;
         }
+        state->m_inflight.reset();
+    }
+
+    auto wakeFn = [state, releaseOnEmpty](Context* ctx)
+    {
+        Wake(*state, releaseOnEmpty, ctx);
     };
 
-    bool submitted = Cooperator::thread_cooperator
+    bool submitted = self
         ? m_target->Cooperate(std::move(wakeFn))
         : m_target->Submit(std::move(wakeFn));
 
@@ -378,6 +507,47 @@ bool BasicPassage<T, N, Ring>::Send(T value)
     return true;
 }
 
+// ---------------------------------------------------------------------------
+// BasicPassage::SendBatch
+// ---------------------------------------------------------------------------
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+size_t BasicPassage<T, N, Ring>::SendBatch(std::span<T> items)
+{
+    auto state = m_state;
+
+    if (items.empty() || state->m_shutdown.load(std::memory_order_acquire))
+        return 0;
+
+    if (m_target->IsShuttingDown())
+    {
+        state->m_shutdown.store(true, std::memory_order_release);
+        return 0;
+    }
+
+    size_t n = 0;
+    while (n < items.size() && state->m_ring.Push(std::move(items[n])))
+        n++;
+
+    if (n == 0)
+        return 0;  // ring full
+
+    // One wake covers the batch: the receiver drains the ring each time it runs.
+    //
+    if (!SubmitWake(false))
+    {
+        state->m_shutdown.store(true, std::memory_order_release);
+        return 0;
+    }
+
+    if (m_target->IsShuttingDown())
+    {
+        state->m_shutdown.store(true, std::memory_order_release);
+    }
+
+    return n;
+}
+
 // ---------------------------------------------------------------------------
 // BasicPassage::TryRecv
 // ---------------------------------------------------------------------------
@@ -392,7 +562,6 @@ bool BasicPassage<T, N, Ring>::TryRecv(T& value)
     if (!m_state->m_ring.Pop(value))
         return false;
 
-    m_recvDryCount  = 0;
     m_recvTimeoutUs = m_tuning.timeoutInitialUs;
 
     if (m_state->m_ring.IsEmpty() && !m_state->m_recv.IsHeld())
@@ -422,7 +591,6 @@ size_t BasicPassage<T, N, Ring>::Drain(T* out, size_t maxCount)
     if (n == 0)
         return 0;
 
-    m_recvDryCount  = 0;
     m_recvTimeoutUs = m_tuning.timeoutInitialUs;
 
     if (m_state->m_ring.IsEmpty() && !m_state->m_recv.IsHeld())
@@ -441,12 +609,25 @@ bool BasicPassage<T, N, Ring>::Recv(T& value)
     assert(Cooperator::thread_cooperator == m_target
            && "Passage::Recv must run on the target cooperator");
 
+    if (TryRecv(value))
+    {
+        Arrived(0);
+        return true;
+    }
+
     Context* ctx = Self();
+    [[maybe_unused]] auto& perf = m_target->GetPerfCounters();
+    int64_t const waitStart = time::MonotonicMicros();
+    bool spun = false;
+    int yields = 0;
 
     while (true)
     {
         if (TryRecv(value))
+        {
+            Arrived(time::MonotonicMicros() - waitStart);
             return true;
+        }
 
         if (m_state->m_shutdown.load(std::memory_order_acquire))
         {
@@ -460,16 +641,36 @@ bool BasicPassage<T, N, Ring>::Recv(T& value)
         if (!m_state->m_recv.IsHeld())
             m_state->m_recv.Acquire(ctx);
 
-        // Give Poll() a chance to process the wake submission before timed wait.
+        // Nothing else to run and the producer has been keeping up: poll the ring itself, which
+        // sees a push before its wake has even been submitted. Once per wait -- a miss means the
+        // estimate was wrong and the next sample will say so.
         //
-        if (m_recvDryCount < m_tuning.yieldThreshold)
+        if (!spun && m_tuning.spinMaxUs > 0 && m_expectedWaitUs <= m_tuning.spinMaxUs
+            && m_target->YieldedCount() == 0)
         {
-            m_recvDryCount++;
+            spun = true;
+            if (Spin())
+            {
+                COOP_PERF_INC(perf, perf::Counter::PassageSpin);
+                continue;
+            }
+            COOP_PERF_INC(perf, perf::Counter::PassageSpinMiss);
+        }
+
+        // Other contexts are runnable: each yield lets them run and the cooperator Poll() for the
+        // wake, which on a loaded cooperator usually lands within a few. With nothing else to
+        // run a yield would come straight back, so go to the park instead.
+        //
+        if (yields < m_tuning.yieldThreshold && m_target->YieldedCount() > 0)
+        {
+            yields++;
+            COOP_PERF_INC(perf, perf::Counter::PassageYield);
             Yield();
             continue;
         }
 
-        m_recvDryCount = 0;
+        yields = 0;
+        COOP_PERF_INC(perf, perf::Counter::PassagePark);
 
         auto r = CoordinateWithKill(ctx, &m_state->m_recv,
                                     time::Interval(m_recvTimeoutUs));
@@ -493,17 +694,66 @@ bool BasicPassage<T, N, Ring>::Recv(T& value)
             if (!m_state->m_ring.IsEmpty())
                 m_state->m_recv.Release(ctx);
 
+            Arrived(time::MonotonicMicros() - waitStart);
             return true;
         }
 
         // Timeout: grow adaptively and retry.
         //
+        COOP_PERF_INC(perf, perf::Counter::PassageParkTimeout);
         m_recvTimeoutUs = std::min(
             m_recvTimeoutUs * static_cast<int64_t>(m_tuning.timeoutBackoff),
             m_tuning.timeoutMaxUs);
     }
 }
 
+// ---------------------------------------------------------------------------
+// BasicPassage::Arrived / Spin
+// ---------------------------------------------------------------------------
+
+// Fold one wait into the estimate. Clamped to the longest park, so one idle stretch doesn't keep
+// a bridge parking long after its producer has picked up again.
+//
+template<typename T, size_t N, template<typename, size_t> class Ring>
+void BasicPassage<T, N, Ring>::Arrived(int64_t waitedUs)
+{
+    waitedUs = std::min(waitedUs, m_tuning.timeoutMaxUs);
+    m_expectedWaitUs += (waitedUs - m_expectedWaitUs) / 4;
+}
+
+// Busy-poll the ring for a little over the expected wait, capped at spinMaxUs. True if an item
+// (or shutdown) turned up in time.
+//
+template<typename T, size_t N, template<typename, size_t> class Ring>
+bool BasicPassage<T, N, Ring>::Spin()
+{
+    int64_t const budget = std::min(2 * m_expectedWaitUs + 1, m_tuning.spinMaxUs);
+    int64_t const start = time::MonotonicMicros();
+
+    while (m_state->m_ring.IsEmpty() && !m_state->m_shutdown.load(std::memory_order_acquire))
+    {
+        if (time::MonotonicMicros() - start >= budget)
+            return false;
+
+        for (int i = 0; i < 16; i++)
+            detail::SpinPause();
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// BasicPassage::RecvBatch
+// ---------------------------------------------------------------------------
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+size_t BasicPassage<T, N, Ring>::RecvBatch(std::span<T> out)
+{
+    if (out.empty() || !Recv(out[0]))
+        return 0;
+
+    return 1 + Drain(out.data() + 1, out.size() - 1);
+}
+
 // ---------------------------------------------------------------------------
 // BasicPassage::Shutdown
 // ---------------------------------------------------------------------------
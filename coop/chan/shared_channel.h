@@ -0,0 +1,509 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include "coop/chan/channel.h"
+#include "coop/context.h"
+#include "coop/coordinator.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator.hpp"
+#include "coop/detail/coordinator_extension.h"
+#include "coop/detail/embedded_list.h"
+#include "coop/detail/ring_message.h"
+#include "coop/self.h"
+
+// SharedChannel is a bounded MPMC queue across cooperators: the worker-pool shape, where one
+// queue feeds consumers on several cooperators and whichever is free takes the next item.
+//
+//   coop::chan::SharedChannel<Job, 1024> jobs;
+//
+//   // on each worker cooperator
+//   coop::chan::SharedChannel<Job, 1024>::Receiver rx(ctx, jobs);
+//   Job job;
+//   while (rx.Recv(job)) { ... }
+//
+//   // anywhere: any thread, any cooperator
+//   jobs.Send(std::move(job));
+//
+// Coordinators belong to one cooperator, so the shared queue cannot offer an m_recv of its own.
+// Each consumer cooperator holds a Receiver instead: a RecvChannel<T> over a small local buffer
+// (prefetch items, one by default) that the Receiver keeps filled from the shared ring. Anything
+// that takes a RecvChannel -- Recv, Select's On, Subscribe's Drain -- takes a Receiver.
+//
+// A Receiver whose buffer has room and finds the ring empty parks on the channel's idle list. Send
+// pushes onto the ring and wakes the longest-parked Receiver -- just the one, so a burst of idle
+// workers does not stampede for a single item. The wake runs on the Receiver's cooperator: inline
+// when the sender is on it, as a ring message (IORING_OP_MSG_RING) from another cooperator, or as
+// a submission from a plain thread. A Receiver with a full buffer is not parked; the consumer's
+// next recv frees a slot, and a continuation on the buffer's m_send refills it then.
+//
+// Larger prefetch batches the refills (one wake can fill many slots) at the cost of balance: items
+// in a Receiver's buffer wait for its consumer, however idle the others are. Destroying a Receiver
+// hands its buffered items back to the ring. Receivers must not outlive the channel.
+//
+
+namespace coop
+{
+namespace chan
+{
+
+// ---------------------------------------------------------------------------
+// MpmcRing<T, N> — Dmitry Vyukov's bounded MPMC queue.
+//
+// Producers and consumers both claim positions with a CAS (on m_tail and m_head respectively);
+// each slot's sequence number says whose turn it is. N must be a power of 2.
+// ---------------------------------------------------------------------------
+
+template<typename T, size_t N>
+struct MpmcRing
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0,
+        "MpmcRing capacity N must be a power of 2.");
+    static_assert(std::is_default_constructible_v<T>,
+        "SharedChannel value type T must be default-constructible.");
+    static_assert(std::is_move_assignable_v<T>,
+        "SharedChannel value type T must be move-assignable.");
+
+    MpmcRing()
+    {
+        for (size_t i = 0; i < N; i++)
+            m_slots[i].m_seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Returns false if the ring is full.
+    //
+    bool Push(T value)
+    {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            Slot& slot = m_slots[pos & (N - 1)];
+            size_t seq = slot.m_seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+            if (diff == 0)
+            {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;  // full
+            }
+            else
+            {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        Slot& slot = m_slots[pos & (N - 1)];
+        slot.m_value = std::move(value);
+        slot.m_seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false if empty, or if the next item is claimed but not yet committed -- its
+    // producer is about to finish.
+    //
+    bool Pop(T& value)
+    {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            Slot& slot = m_slots[pos & (N - 1)];
+            size_t seq = slot.m_seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+
+            if (diff == 0)
+            {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;  // empty
+            }
+            else
+            {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+
+        Slot& slot = m_slots[pos & (N - 1)];
+        value = std::move(slot.m_value);
+        slot.m_seq.store(pos + N, std::memory_order_release);
+        return true;
+    }
+
+    // True unless the next item is committed. A hint under concurrent pops.
+    //
+    bool IsEmpty() const
+    {
+        size_t pos = m_head.load(std::memory_order_acquire);
+        const Slot& slot = m_slots[pos & (N - 1)];
+        size_t seq = slot.m_seq.load(std::memory_order_acquire);
+        return static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) != 0;
+    }
+
+  private:
+    struct Slot
+    {
+        std::atomic<size_t> m_seq{0};
+        T                   m_value{};
+    };
+
+    alignas(64) Slot                m_slots[N];
+    alignas(64) std::atomic<size_t> m_tail{0};
+    alignas(64) std::atomic<size_t> m_head{0};
+};
+
+// ---------------------------------------------------------------------------
+
+template<typename T, size_t N = 64>
+struct SharedChannel
+{
+    struct Receiver;
+
+    SharedChannel() = default;
+    SharedChannel(SharedChannel const&) = delete;
+    SharedChannel(SharedChannel&&)      = delete;
+
+    ~SharedChannel()
+    {
+        Shutdown();
+    }
+
+    // Thread-safe. Returns false if the channel is shut down or the ring is full.
+    //
+    bool Send(T value);
+
+    // Thread-safe, idempotent. Receivers drain what is queued, then report shutdown like any
+    // channel.
+    //
+    void Shutdown();
+
+    bool IsShutdown() const { return m_shutdown.load(std::memory_order_acquire); }
+
+  private:
+    friend struct Receiver;
+
+    using IdleList = EmbeddedList<Receiver>;
+
+    // Wake the longest-parked Receiver, if any
+    //
+    void WakeOne();
+
+    void Park(Receiver* receiver);
+    bool Unpark(Receiver* receiver);
+
+    MpmcRing<T, N>          m_ring;
+    std::atomic<bool>       m_shutdown{false};
+
+    // Receivers with room and nothing to fill it. m_idle mirrors the list's size so a Send that
+    // finds no one parked skips the lock.
+    //
+    alignas(64) std::atomic<size_t> m_idle{0};
+    std::mutex              m_idleLock;
+    IdleList                m_idleList;
+};
+
+// One consumer cooperator's end of a SharedChannel. Construct, use, and destroy it on that
+// cooperator.
+//
+template<typename T, size_t N>
+struct SharedChannel<T, N>::Receiver final
+    : RecvChannel<T>
+    , EmbeddedListHookups<Receiver>
+    , Continuation
+    , coop::detail::RingMessage
+{
+    using Base = TypedBaseChannel<T>;
+
+    Receiver(Context* ctx, SharedChannel& shared, size_t prefetch = 1)
+    : TypedBaseChannel<T>(ctx, new T[prefetch], prefetch)
+    , m_shared(shared)
+    , m_cooperator(ctx->GetCooperator())
+    , m_feed(static_cast<Continuation*>(this))
+    {
+        assert(prefetch > 0);
+        deliver = &Deliver;
+        undelivered = &Undelivered;
+        Feed();
+    }
+
+    ~Receiver() final;
+
+    Receiver(Receiver const&) = delete;
+    Receiver(Receiver&&)      = delete;
+
+  private:
+    friend struct SharedChannel;
+
+    // Fill the buffer from the ring, then hold m_send and wait on it (full), shut down (the
+    // channel is, and the ring is empty), or park (the ring is empty). Runs on our cooperator,
+    // from a context or not, and never suspends.
+    //
+    void Feed();
+
+    // A continuation on m_send: the consumer took from a full buffer
+    //
+    void Run() final
+    {
+        m_feedListed = false;
+        Feed();
+    }
+
+    // Called by a waker that took us off the idle list, from any thread
+    //
+    void Wake();
+    void Woken();
+
+    static void Deliver(coop::detail::RingMessage* message);
+    static void Undelivered(coop::detail::RingMessage* message);
+
+    void PushLocal(T value)
+    {
+        Base::m_buffer[Base::m_tail++] = std::move(value);
+        if (Base::m_tail == Base::m_capacity)
+        {
+            Base::m_tail = 0;
+        }
+        Base::m_size++;
+    }
+
+    SharedChannel&      m_shared;
+    Cooperator*         m_cooperator;
+    Coordinated         m_feed;
+    bool                m_feedListed = false;
+
+    bool                m_parked = false;           // under m_shared.m_idleLock
+    std::atomic<bool>   m_wakeInflight{false};
+};
+
+// ---------------------------------------------------------------------------
+// SharedChannel
+// ---------------------------------------------------------------------------
+
+template<typename T, size_t N>
+bool SharedChannel<T, N>::Send(T value)
+{
+    if (m_shutdown.load(std::memory_order_acquire))
+        return false;
+
+    if (!m_ring.Push(std::move(value)))
+        return false;  // ring full
+
+    // Pairs with the fence in Feed: either we see the Receiver that parked, or it sees our item
+    //
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_idle.load(std::memory_order_relaxed) > 0)
+    {
+        WakeOne();
+    }
+    return true;
+}
+
+template<typename T, size_t N>
+void SharedChannel<T, N>::Shutdown()
+{
+    if (m_shutdown.exchange(true, std::memory_order_acq_rel))
+        return;
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (m_idle.load(std::memory_order_relaxed) > 0)
+    {
+        WakeOne();
+    }
+}
+
+template<typename T, size_t N>
+void SharedChannel<T, N>::WakeOne()
+{
+    Receiver* receiver;
+    {
+        std::lock_guard<std::mutex> lock(m_idleLock);
+        receiver = m_idleList.Pop();
+        if (!receiver)
+            return;
+        receiver->m_parked = false;
+        receiver->m_wakeInflight.store(true, std::memory_order_relaxed);
+        m_idle.fetch_sub(1, std::memory_order_relaxed);
+    }
+    receiver->Wake();
+}
+
+template<typename T, size_t N>
+void SharedChannel<T, N>::Park(Receiver* receiver)
+{
+    std::lock_guard<std::mutex> lock(m_idleLock);
+    if (receiver->m_parked)
+        return;
+    receiver->m_parked = true;
+    m_idleList.Push(receiver);
+    m_idle.fetch_add(1, std::memory_order_relaxed);
+}
+
+// False if a waker took the Receiver off the list first; its wake is on the way
+//
+template<typename T, size_t N>
+bool SharedChannel<T, N>::Unpark(Receiver* receiver)
+{
+    std::lock_guard<std::mutex> lock(m_idleLock);
+    if (!receiver->m_parked)
+        return false;
+    receiver->m_parked = false;
+    m_idleList.Remove(receiver);
+    m_idle.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// SharedChannel::Receiver
+// ---------------------------------------------------------------------------
+
+template<typename T, size_t N>
+SharedChannel<T, N>::Receiver::~Receiver()
+{
+    m_shared.Unpark(this);
+
+    // A wake already on its way runs on this cooperator; let it land before we go
+    //
+    while (m_wakeInflight.load(std::memory_order_acquire))
+    {
+        Yield();
+    }
+
+    if (m_feedListed)
+    {
+        m_feed.Pop();
+        m_feedListed = false;
+    }
+
+    // Hand what was prefetched but never taken back to the other Receivers
+    //
+    T value;
+    while (RecvChannel<T>::RecvImpl(value))
+    {
+        if (!m_shared.m_ring.Push(std::move(value)))
+            break;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_shared.WakeOne();
+    }
+
+    delete[] Base::m_buffer;
+}
+
+template<typename T, size_t N>
+void SharedChannel<T, N>::Receiver::Feed()
+{
+    for (;;)
+    {
+        bool wasEmpty = Base::IsEmpty();
+
+        T value;
+        while (!Base::IsFull() && m_shared.m_ring.Pop(value))
+        {
+            PushLocal(std::move(value));
+        }
+
+        if (wasEmpty && !Base::IsEmpty() && Base::m_recv.IsHeld())
+        {
+            Base::m_recv.Release(nullptr, false);
+        }
+
+        if (Base::IsFull())
+        {
+            Base::m_send.TryAcquire();
+            CoordinatorExtension().AddAsBlocked(&this->m_send, &m_feed);
+            m_feedListed = true;
+            return;
+        }
+
+        if (m_shared.IsShutdown() && m_shared.m_ring.IsEmpty())
+        {
+            Base::Shutdown(false);
+            return;
+        }
+
+        m_shared.Park(this);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_shared.m_ring.IsEmpty() && !m_shared.IsShutdown())
+        {
+            return;
+        }
+        if (!m_shared.Unpark(this))
+        {
+            return;
+        }
+    }
+}
+
+template<typename T, size_t N>
+void SharedChannel<T, N>::Receiver::Woken()
+{
+    m_wakeInflight.store(false, std::memory_order_release);
+    if (!Base::IsShutdown())
+    {
+        Feed();
+    }
+}
+
+template<typename T, size_t N>
+void SharedChannel<T, N>::Receiver::Wake()
+{
+    auto* self = Cooperator::thread_cooperator;
+    if (self == m_cooperator)
+    {
+        Woken();
+        return;
+    }
+    if (self && m_cooperator->PostMessage(this))
+    {
+        return;
+    }
+
+    auto wakeFn = [this](Context*)
+    {
+        Woken();
+    };
+    bool submitted = self
+        ? m_cooperator->Cooperate(std::move(wakeFn))
+        : m_cooperator->Submit(std::move(wakeFn));
+    if (!submitted)
+    {
+        m_wakeInflight.store(false, std::memory_order_release);
+    }
+}
+
+template<typename T, size_t N>
+void SharedChannel<T, N>::Receiver::Deliver(coop::detail::RingMessage* message)
+{
+    static_cast<Receiver*>(message)->Woken();
+}
+
+// The kernel refused the post (on the waker's cooperator): hand the wake over as a submission
+//
+template<typename T, size_t N>
+void SharedChannel<T, N>::Receiver::Undelivered(coop::detail::RingMessage* message)
+{
+    auto* receiver = static_cast<Receiver*>(message);
+    bool submitted = receiver->m_cooperator->Cooperate([receiver](Context*)
+    {
+        receiver->Woken();
+    });
+    if (!submitted)
+    {
+        receiver->m_wakeInflight.store(false, std::memory_order_release);
+    }
+}
+
+} // namespace chan
+} // namespace coop
@@ -0,0 +1,126 @@
+#include "shm_passage.h"
+
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace coop
+{
+namespace chan
+{
+
+namespace detail
+{
+
+// The default huge page; MFD_HUGETLB without a size flag takes it
+//
+static constexpr size_t kHugePageSize = size_t(2) << 20;
+
+static int CreateMapping(ShmMapping& mapping, const char* name, size_t size, bool hugePages)
+{
+    const size_t page = hugePages ? kHugePageSize : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size = (size + page - 1) & ~(page - 1);
+
+    int fd = memfd_create(name, MFD_CLOEXEC | (hugePages ? MFD_HUGETLB : 0));
+    if (fd < 0)
+    {
+        return -errno;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) < 0)
+    {
+        int err = -errno;
+        close(fd);
+        return err;
+    }
+
+    // Populated up front: a huge-page shortage shows here, not as a SIGBUS on first touch
+    //
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        int err = -errno;
+        close(fd);
+        return err;
+    }
+
+    mapping.fd = fd;
+    mapping.base = base;
+    mapping.size = size;
+    return 0;
+}
+
+int ShmMapping::Create(const char* name, size_t bytes, bool hugePages)
+{
+    assert(!base);
+    int err = CreateMapping(*this, name, bytes, hugePages);
+    if (err < 0 && hugePages)
+    {
+        err = CreateMapping(*this, name, bytes, false);
+    }
+    return err;
+}
+
+int ShmMapping::Map(int mapFd)
+{
+    assert(!base);
+    struct stat st;
+    if (fstat(mapFd, &st) < 0)
+    {
+        int err = -errno;
+        close(mapFd);
+        return err;
+    }
+
+    void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, mapFd, 0);
+    if (mapped == MAP_FAILED)
+    {
+        int err = -errno;
+        close(mapFd);
+        return err;
+    }
+
+    fd = mapFd;
+    base = mapped;
+    size = static_cast<size_t>(st.st_size);
+    return 0;
+}
+
+void ShmMapping::Unmap()
+{
+    if (base)
+    {
+        munmap(base, size);
+        base = nullptr;
+        size = 0;
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+}
+
+// The sender's half of Park's handshake: the push is published before the flag is read
+//
+void WakeShmReceiver(ShmPassageHeader& header, bool force)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!force && !header.sleeping.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    if (header.sleeping.exchange(0, std::memory_order_relaxed) == 0 && !force)
+    {
+        return;     // another sender got there first
+    }
+
+    header.wakeSeq.fetch_add(1, std::memory_order_release);
+    io::FutexWake(&header.wakeSeq, 1);
+}
+
+} // end namespace coop::chan::detail
+
+} // namespace chan
+} // namespace coop
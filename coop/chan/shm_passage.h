@@ -0,0 +1,526 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "coop/chan/passage.h"
+#include "coop/context.h"
+#include "coop/coordinator.h"
+#include "coop/cooperator.h"
+#include "coop/io/futex.h"
+#include "coop/io/handle.h"
+#include "coop/self.h"
+#include "coop/time/interval.h"
+#include "coop/time/now.h"
+#include "coop/time/sleep.h"
+
+// ShmPassage is Passage across a process boundary: the same MPSC (or SPSC) ring, placed in a
+// memfd mapping that the receiving process creates and hands to its producers -- over a unix
+// socket with io::SendFds / io::ReceiveFds, or by inheritance across fork. A front-end process
+// handing work to a worker then pays a ring push and, only when the worker is parked, one futex
+// wake, instead of a socket round trip:
+//
+//   // worker, on its cooperator
+//   coop::chan::ShmPassage<Job, 1024> jobs(ctx, {.name = "jobs"});
+//   int fd = jobs.Fd();
+//   coop::io::SendFds(control, &fd, 1);
+//   Job job;
+//   while (jobs.Recv(job)) Run(job);
+//
+//   // front end, any thread
+//   int fd;
+//   coop::io::ReceiveFds(control, &fd, 1);
+//   coop::chan::ShmPassage<Job, 1024>::Sender jobs(fd);
+//   jobs.Send(job);
+//
+// T crosses the boundary byte for byte, so it must be trivially copyable, and anything it points
+// at is meaningless on the other side. Both ends must be built with the same T, N and ring; the
+// sender checks the header it maps and refuses a mismatch.
+//
+// Wakes: a receiver about to park advertises it in the header and waits on the header's futex
+// word through the ring (io::FutexWait, kernel 6.7+); a sender that finds the flag set clears it
+// and wakes the word with one futex(2) syscall, so senders into a busy receiver make no syscall
+// at all. The park is bounded by parkTimeoutUs regardless, and on a kernel without the futex
+// opcode it falls back to timed polling. Before it parks, Recv spins and yields as Passage's does.
+//
+// The receiver is single-cooperator and owns the mapping; senders may be any thread of any
+// process. A sender outliving the receiver keeps the pages mapped, and sees shutdown.
+//
+
+namespace coop
+{
+namespace chan
+{
+
+struct ShmPassageConfiguration
+{
+    // The memfd's name, as it shows in /proc/<pid>/fd; only for debugging
+    //
+    const char* name = "coop-passage";
+
+    // Back the ring with huge pages (MFD_HUGETLB), falling back to normal pages when none are
+    // available. Only worth it for large rings.
+    //
+    bool hugePages = false;
+
+    // Recv's wait: busy-poll for up to spinMaxUs while nothing else is runnable, yield up to
+    // yieldThreshold times while something is, then park for at most parkTimeoutUs at a time
+    //
+    int64_t spinMaxUs = 4;
+    int     yieldThreshold = 8;
+    int64_t parkTimeoutUs = 100000;
+};
+
+namespace detail
+{
+
+// The first cache line of the mapping; the ring follows. Both ends check it describes the same
+// Layout.
+//
+struct ShmPassageHeader
+{
+    static constexpr uint64_t MAGIC = 0x65676173'73617043ull;   // "Cpassage"
+    static constexpr uint32_t VERSION = 1;
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t ringKind;            // 1 MPSC, 2 SPSC
+    uint64_t valueSize;
+    uint64_t capacity;
+    uint64_t mappingSize;
+
+    alignas(64) std::atomic<uint32_t> wakeSeq{0};   // the futex word; bumped by every wake
+    std::atomic<uint32_t> sleeping{0};              // receiver is (about to be) parked on it
+    std::atomic<uint32_t> shutdown{0};
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free
+              && std::atomic<size_t>::is_always_lock_free,
+              "a shared-memory ring needs address-free atomics");
+
+// A shared mapping and the memfd behind it. Create makes a fresh one of size bytes (rounded up to
+// the page, or huge page, size); Map maps an existing one, taking ownership of fd. Both return 0 or
+// a negative errno.
+//
+struct ShmMapping
+{
+    ShmMapping() = default;
+    ShmMapping(ShmMapping const&) = delete;
+    ShmMapping& operator=(ShmMapping const&) = delete;
+    ~ShmMapping() { Unmap(); }
+
+    int Create(const char* name, size_t size, bool hugePages);
+    int Map(int fd);
+    void Unmap();
+
+    int    fd = -1;
+    void*  base = nullptr;
+    size_t size = 0;
+};
+
+// Clear the receiver's parked flag and wake it, if it was set -- or unconditionally, for shutdown
+//
+void WakeShmReceiver(ShmPassageHeader& header, bool force);
+
+template<typename T, size_t N>
+using UncheckedSpscRing = BasicSpscRing<T, N, false>;
+
+} // end namespace coop::chan::detail
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+struct BasicShmPassage
+{
+    static_assert(std::is_trivially_copyable_v<T>,
+        "ShmPassage moves T between processes byte for byte; it must be trivially copyable.");
+
+    static constexpr uint32_t RING_KIND =
+        std::is_same_v<Ring<T, N>, MpscRing<T, N>> ? 1 : 2;
+
+    // What lives in the mapping: the header, then the ring on its own cache lines
+    //
+    struct Layout
+    {
+        detail::ShmPassageHeader header;
+        alignas(64) Ring<T, N>   ring;
+    };
+
+    // The producing end, in any process that holds the mapping's fd. Thread-safe for an MPSC
+    // ring; one thread only for SPSC.
+    //
+    struct Sender
+    {
+        // Takes ownership of fd. Check IsOpen: the mapping may be missing, or not a passage of
+        // this T, N and ring.
+        //
+        explicit Sender(int fd);
+
+        Sender(Sender const&) = delete;
+        Sender& operator=(Sender const&) = delete;
+
+        bool IsOpen() const { return m_layout != nullptr; }
+        int Error() const { return m_error; }
+
+        // Returns false if the passage is shut down or the ring is full
+        //
+        bool Send(T value);
+
+        // Push as many of items as fit, with at most one wake for the lot. Returns the number
+        // pushed.
+        //
+        size_t SendBatch(std::span<T> items);
+
+        // Shut the passage down from this end: the receiver drains what is queued, then its Recv
+        // returns false
+        //
+        void Shutdown();
+
+        bool IsShutdown() const;
+
+      private:
+        detail::ShmMapping m_mapping;
+        Layout*            m_layout = nullptr;
+        int                m_error = 0;
+    };
+
+    // ctx: a context on the receiving cooperator. Check IsOpen; Error has the memfd's errno.
+    //
+    explicit BasicShmPassage(Context* ctx, ShmPassageConfiguration const& config = {});
+
+    ~BasicShmPassage() { Shutdown(); }
+
+    BasicShmPassage(BasicShmPassage const&) = delete;
+    BasicShmPassage(BasicShmPassage&&) = delete;
+
+    bool IsOpen() const { return m_layout != nullptr; }
+    int Error() const { return m_error; }
+
+    // The memfd to hand to a producer (io::SendFds, or inherited across fork). The passage keeps
+    // its own copy; a receiving process builds a Sender from its copy.
+    //
+    int Fd() const { return m_mapping.fd; }
+
+    // Receiver-only, non-blocking
+    //
+    bool TryRecv(T& value);
+    size_t Drain(T* out, size_t maxCount);
+
+    // Receive one item, waiting as described above. Returns false when the passage is shut down
+    // and the ring is empty, or the context is killed.
+    //
+    bool Recv(T& value);
+
+    size_t RecvBatch(std::span<T> out);
+
+    // Idempotent. Senders see it at their next Send.
+    //
+    void Shutdown();
+
+    // Parks so far, and how many of them a sender's wake ended (the rest timed out or raced)
+    //
+    uint64_t Parks() const { return m_parks; }
+    uint64_t Wakes() const { return m_wakes; }
+
+  private:
+    bool Spin();
+    bool Park(Context* ctx);
+
+    detail::ShmMapping      m_mapping;
+    Layout*                 m_layout = nullptr;
+    int                     m_error = 0;
+    Cooperator*             m_cooperator;
+    ShmPassageConfiguration m_config;
+
+    // False once a futex wait came back -EINVAL: the kernel predates the opcode, and parks poll
+    //
+    bool     m_futex = true;
+    uint64_t m_parks = 0;
+    uint64_t m_wakes = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Receiver
+// ---------------------------------------------------------------------------
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+BasicShmPassage<T, N, Ring>::BasicShmPassage(Context* ctx,
+    ShmPassageConfiguration const& config /* = {} */)
+: m_cooperator(ctx->GetCooperator())
+, m_config(config)
+{
+    assert(m_config.parkTimeoutUs > 0);
+
+    m_error = m_mapping.Create(m_config.name, sizeof(Layout), m_config.hugePages);
+    if (m_error < 0)
+    {
+        return;
+    }
+
+    // The ring is constructed once, here, before any producer can map it
+    //
+    m_layout = new (m_mapping.base) Layout{};
+    auto& header = m_layout->header;
+    header.magic = detail::ShmPassageHeader::MAGIC;
+    header.version = detail::ShmPassageHeader::VERSION;
+    header.ringKind = RING_KIND;
+    header.valueSize = sizeof(T);
+    header.capacity = N;
+    header.mappingSize = sizeof(Layout);
+}
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+bool BasicShmPassage<T, N, Ring>::TryRecv(T& value)
+{
+    assert(Cooperator::thread_cooperator == m_cooperator
+           && "ShmPassage is received from on its own cooperator");
+    return m_layout && m_layout->ring.Pop(value);
+}
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+size_t BasicShmPassage<T, N, Ring>::Drain(T* out, size_t maxCount)
+{
+    size_t n = 0;
+    while (n < maxCount && TryRecv(out[n]))
+    {
+        n++;
+    }
+    return n;
+}
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+bool BasicShmPassage<T, N, Ring>::Recv(T& value)
+{
+    if (TryRecv(value))
+    {
+        return true;
+    }
+    if (!m_layout)
+    {
+        return false;
+    }
+
+    Context* ctx = Self();
+    auto& header = m_layout->header;
+    bool spun = false;
+    int yields = 0;
+
+    while (true)
+    {
+        if (TryRecv(value))
+        {
+            return true;
+        }
+        if (header.shutdown.load(std::memory_order_acquire) || ctx->IsKilled())
+        {
+            // One more look: a sender's last push may have landed before its shutdown
+            //
+            return TryRecv(value);
+        }
+
+        if (!spun && m_config.spinMaxUs > 0 && m_cooperator->YieldedCount() == 0)
+        {
+            spun = true;
+            if (Spin())
+            {
+                continue;
+            }
+        }
+
+        if (yields < m_config.yieldThreshold && m_cooperator->YieldedCount() > 0)
+        {
+            yields++;
+            Yield();
+            continue;
+        }
+
+        yields = 0;
+        if (!Park(ctx))
+        {
+            return false;
+        }
+    }
+}
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+size_t BasicShmPassage<T, N, Ring>::RecvBatch(std::span<T> out)
+{
+    if (out.empty() || !Recv(out[0]))
+    {
+        return 0;
+    }
+    return 1 + Drain(out.data() + 1, out.size() - 1);
+}
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+void BasicShmPassage<T, N, Ring>::Shutdown()
+{
+    if (m_layout)
+    {
+        m_layout->header.shutdown.store(1, std::memory_order_release);
+    }
+}
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+bool BasicShmPassage<T, N, Ring>::Spin()
+{
+    auto& header = m_layout->header;
+    int64_t const start = time::MonotonicMicros();
+    while (m_layout->ring.IsEmpty() && !header.shutdown.load(std::memory_order_acquire))
+    {
+        if (time::MonotonicMicros() - start >= m_config.spinMaxUs)
+        {
+            return false;
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            detail::SpinPause();
+        }
+    }
+    return true;
+}
+
+// One bounded park. The flag goes up before the last emptiness check and a sender looks at it
+// after its push, with a full fence on each side, so either the receiver sees the item or the
+// sender sees the flag. A wake that lands between the check and the wait's arming changes wakeSeq
+// under it, and the wait returns -EAGAIN at once. False only when the context was killed.
+//
+template<typename T, size_t N, template<typename, size_t> class Ring>
+bool BasicShmPassage<T, N, Ring>::Park(Context* ctx)
+{
+    auto& header = m_layout->header;
+    const uint32_t seq = header.wakeSeq.load(std::memory_order_acquire);
+    header.sleeping.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!m_layout->ring.IsEmpty() || header.shutdown.load(std::memory_order_acquire))
+    {
+        header.sleeping.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    m_parks++;
+    const time::Interval timeout(m_config.parkTimeoutUs);
+    bool killed = false;
+    if (m_futex)
+    {
+        Coordinator coord;
+        io::Handle handle(ctx, m_cooperator->GetUring(), &coord);
+        if (io::FutexWait(handle, &header.wakeSeq, seq, timeout))
+        {
+            int result = handle.WaitKill();
+            killed = ctx->IsKilled();
+            if (result == -EINVAL && !handle.TimedOut())
+            {
+                m_futex = false;
+            }
+        }
+        else
+        {
+            Yield();   // no SQE to be had; let the ring drain
+        }
+    }
+    else
+    {
+        killed = time::Sleep(ctx, std::min(timeout, time::Interval(1000)))
+                 == time::SleepResult::Killed;
+    }
+
+    // A sender that cleared the flag did the wake; otherwise it is still ours to clear
+    //
+    if (header.sleeping.exchange(0, std::memory_order_relaxed) == 0)
+    {
+        m_wakes++;
+    }
+    return !killed;
+}
+
+// ---------------------------------------------------------------------------
+// Sender
+// ---------------------------------------------------------------------------
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+BasicShmPassage<T, N, Ring>::Sender::Sender(int fd)
+{
+    m_error = m_mapping.Map(fd);
+    if (m_error < 0)
+    {
+        return;
+    }
+
+    auto* layout = std::launder(static_cast<Layout*>(m_mapping.base));
+    auto const& header = layout->header;
+    if (m_mapping.size < sizeof(Layout)
+        || header.magic != detail::ShmPassageHeader::MAGIC
+        || header.version != detail::ShmPassageHeader::VERSION
+        || header.ringKind != RING_KIND
+        || header.valueSize != sizeof(T)
+        || header.capacity != N
+        || header.mappingSize != sizeof(Layout))
+    {
+        m_error = -EPROTO;
+        m_mapping.Unmap();
+        return;
+    }
+    m_layout = layout;
+}
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+bool BasicShmPassage<T, N, Ring>::Sender::Send(T value)
+{
+    if (IsShutdown() || !m_layout->ring.Push(std::move(value)))
+    {
+        return false;
+    }
+    detail::WakeShmReceiver(m_layout->header, false);
+    return true;
+}
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+size_t BasicShmPassage<T, N, Ring>::Sender::SendBatch(std::span<T> items)
+{
+    if (items.empty() || IsShutdown())
+    {
+        return 0;
+    }
+
+    size_t n = 0;
+    while (n < items.size() && m_layout->ring.Push(std::move(items[n])))
+    {
+        n++;
+    }
+    if (n)
+    {
+        detail::WakeShmReceiver(m_layout->header, false);
+    }
+    return n;
+}
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+void BasicShmPassage<T, N, Ring>::Sender::Shutdown()
+{
+    if (m_layout && !m_layout->header.shutdown.exchange(1, std::memory_order_acq_rel))
+    {
+        detail::WakeShmReceiver(m_layout->header, true);
+    }
+}
+
+template<typename T, size_t N, template<typename, size_t> class Ring>
+bool BasicShmPassage<T, N, Ring>::Sender::IsShutdown() const
+{
+    return !m_layout || m_layout->header.shutdown.load(std::memory_order_acquire);
+}
+
+template<typename T, size_t N = 64>
+using ShmPassage = BasicShmPassage<T, N, MpscRing>;
+
+template<typename T, size_t N = 64>
+using ShmSpscPassage = BasicShmPassage<T, N, detail::UncheckedSpscRing>;
+
+} // namespace chan
+} // namespace coop
@@ -0,0 +1,168 @@
+#include "slab.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+#include "coop/cooperator.h"
+
+namespace coop
+{
+namespace chan
+{
+
+namespace detail
+{
+
+// What a Slab and its outstanding buffers share. m_live counts the Slab itself plus every buffer
+// that is out; whoever brings it to zero frees the memory, so the slab can go before its buffers.
+//
+struct SlabCore
+{
+    SlabCore(size_t bufferSize, size_t count)
+    : m_home(Cooperator::thread_cooperator)
+    , m_bufferSize(bufferSize)
+    , m_count(count)
+    , m_stride((sizeof(SlabBlock) + bufferSize + alignof(SlabBlock) - 1) &
+               ~(alignof(SlabBlock) - 1))
+    {
+        m_memory = static_cast<char*>(::operator new(m_stride * count,
+                                                     std::align_val_t(alignof(SlabBlock))));
+
+        // Built back to front so the first Acquire takes the lowest address
+        //
+        for (size_t i = count; i-- > 0;)
+        {
+            auto* block = new (m_memory + i * m_stride) SlabBlock;
+            block->slab = this;
+            block->next = m_free;
+            m_free = block;
+        }
+    }
+
+    ~SlabCore()
+    {
+        for (size_t i = 0; i < m_count; i++)
+        {
+            reinterpret_cast<SlabBlock*>(m_memory + i * m_stride)->~SlabBlock();
+        }
+        ::operator delete(m_memory, std::align_val_t(alignof(SlabBlock)));
+    }
+
+    void Return(SlabBlock* block)
+    {
+        if (Cooperator::thread_cooperator == m_home)
+        {
+            block->next = m_free;
+            m_free = block;
+        }
+        else
+        {
+            SlabBlock* head = m_returned.load(std::memory_order_relaxed);
+            do
+            {
+                block->next = head;
+            }
+            while (!m_returned.compare_exchange_weak(head, block, std::memory_order_release,
+                                                     std::memory_order_relaxed));
+        }
+        Unref();
+    }
+
+    void Unref()
+    {
+        if (m_live.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this;
+        }
+    }
+
+    Cooperator*                 m_home;
+    size_t                      m_bufferSize;
+    size_t                      m_count;
+    size_t                      m_stride;
+    char*                       m_memory = nullptr;
+    SlabBlock*                  m_free = nullptr;           // home cooperator only
+
+    alignas(64) std::atomic<SlabBlock*> m_returned{nullptr};   // released on other threads
+    std::atomic<size_t>         m_live{1};
+};
+
+void ReturnBlock(SlabBlock* block)
+{
+    block->slab->Return(block);
+}
+
+} // end namespace coop::chan::detail
+
+// ---------------------------------------------------------------------------
+// Message
+// ---------------------------------------------------------------------------
+
+void Message::SetSize(size_t size)
+{
+    assert(m_block);
+    assert(size <= m_block->slab->m_bufferSize);
+    m_block->size = static_cast<uint32_t>(size);
+}
+
+size_t Message::Capacity() const
+{
+    return m_block ? m_block->slab->m_bufferSize : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Slab
+// ---------------------------------------------------------------------------
+
+Slab::Slab(size_t bufferSize, size_t count)
+: m_core(new detail::SlabCore(bufferSize, count))
+{
+    assert(Cooperator::thread_cooperator && "Slab: construct on its home cooperator");
+    assert(bufferSize <= UINT32_MAX);
+}
+
+Slab::~Slab()
+{
+    m_core->Unref();
+}
+
+Message Slab::Acquire()
+{
+    assert(Cooperator::thread_cooperator == m_core->m_home);
+
+    if (!m_core->m_free)
+    {
+        m_core->m_free = m_core->m_returned.exchange(nullptr, std::memory_order_acquire);
+        if (!m_core->m_free)
+        {
+            return Message();
+        }
+    }
+
+    auto* block = m_core->m_free;
+    m_core->m_free = block->next;
+    block->next = nullptr;
+    block->size = 0;
+    block->refs.store(1, std::memory_order_relaxed);
+    m_core->m_live.fetch_add(1, std::memory_order_relaxed);
+    return Message(block);
+}
+
+size_t Slab::BufferSize() const
+{
+    return m_core->m_bufferSize;
+}
+
+size_t Slab::Count() const
+{
+    return m_core->m_count;
+}
+
+size_t Slab::Outstanding() const
+{
+    return m_core->m_live.load(std::memory_order_acquire) - 1;
+}
+
+} // end namespace coop::chan
+} // end namespace coop
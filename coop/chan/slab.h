@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Slab and Message -- zero-copy handoff of large buffers between pipeline stages.
+//
+//   coop::chan::Slab slab(64 << 10, 32);          // 32 buffers of 64KB, on this cooperator
+//
+//   coop::chan::Message m = slab.Acquire();       // empty if all 32 are out
+//   size_t n = read(fd, m.Data(), m.Capacity());
+//   m.SetSize(n);
+//   ch.Send(std::move(m));                        // a pointer moves, not the payload
+//
+// A Slab is a pool of fixed-size buffers owned by the cooperator that built it (its home). A
+// Message is a refcounted handle to one of them, the size of a pointer, so it moves through a
+// Channel, a Passage ring, or a Pipe stage as cheaply as the pointer it is -- and, unlike a raw
+// pointer, says who owns the bytes. Copying a Message shares the buffer; the last copy to go
+// returns it to its slab, from whichever thread that happens on.
+//
+// Acquire runs on the home cooperator only, which is what lets the free list be a plain list. A
+// buffer released on another thread goes onto the slab's return stack (a lock-free push), and the
+// home cooperator takes the whole stack back the next time its free list runs dry -- no wake, no
+// submission, one exchange per refill.
+//
+// Write through a Message only while it is the only one (IsShared false): copies share the bytes.
+// A Slab may be destroyed while its buffers are still out; its memory goes when the last one
+// comes back.
+//
+
+namespace coop
+{
+namespace chan
+{
+
+namespace detail
+{
+
+struct SlabCore;
+
+// The header in front of each buffer. A cache line, so the bytes start on one.
+//
+struct alignas(64) SlabBlock
+{
+    char* Data() { return reinterpret_cast<char*>(this + 1); }
+
+    SlabCore*               slab;
+    std::atomic<uint32_t>   refs{0};
+    uint32_t                size = 0;
+    SlabBlock*              next = nullptr;
+};
+
+// Hand a block whose last reference just dropped back to its slab, from any thread
+//
+void ReturnBlock(SlabBlock* block);
+
+} // end namespace coop::chan::detail
+
+struct Message
+{
+    Message() = default;
+
+    Message(Message const& other)
+    : m_block(other.m_block)
+    {
+        if (m_block)
+        {
+            m_block->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    Message(Message&& other) noexcept
+    : m_block(std::exchange(other.m_block, nullptr))
+    {
+    }
+
+    Message& operator=(Message const& other)
+    {
+        Message copy(other);
+        std::swap(m_block, copy.m_block);
+        return *this;
+    }
+
+    Message& operator=(Message&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            m_block = std::exchange(other.m_block, nullptr);
+        }
+        return *this;
+    }
+
+    ~Message()
+    {
+        Reset();
+    }
+
+    explicit operator bool() const { return m_block != nullptr; }
+
+    char* Data() { return m_block->Data(); }
+    const char* Data() const { return m_block->Data(); }
+
+    // Bytes in use, set by whoever fills the buffer; Capacity is the slab's buffer size
+    //
+    size_t Size() const { return m_block ? m_block->size : 0; }
+    void SetSize(size_t size);
+    size_t Capacity() const;
+
+    bool IsShared() const
+    {
+        return m_block && m_block->refs.load(std::memory_order_acquire) > 1;
+    }
+
+    // Drop this reference, returning the buffer to its slab if it was the last
+    //
+    void Reset();
+
+  private:
+    friend struct Slab;
+
+    explicit Message(detail::SlabBlock* block)
+    : m_block(block)
+    {
+    }
+
+    detail::SlabBlock* m_block = nullptr;
+};
+
+static_assert(sizeof(Message) == sizeof(void*), "Message must stay pointer-sized");
+
+// A sole owner skips the atomic decrement: no copy can appear without a reference to copy from
+//
+inline void Message::Reset()
+{
+    if (!m_block)
+    {
+        return;
+    }
+    if (m_block->refs.load(std::memory_order_acquire) == 1 ||
+        m_block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        detail::ReturnBlock(m_block);
+    }
+    m_block = nullptr;
+}
+
+struct Slab
+{
+    // count buffers of bufferSize bytes each, owned by the calling cooperator
+    //
+    Slab(size_t bufferSize, size_t count);
+    ~Slab();
+
+    Slab(Slab const&) = delete;
+    Slab& operator=(Slab const&) = delete;
+
+    // A free buffer, or an empty Message when every buffer is out. Home cooperator only.
+    //
+    Message Acquire();
+
+    size_t BufferSize() const;
+    size_t Count() const;
+
+    // Buffers acquired and not yet returned. Callable from any thread.
+    //
+    size_t Outstanding() const;
+
+  private:
+    detail::SlabCore* m_core;
+};
+
+} // end namespace coop::chan
+} // end namespace coop
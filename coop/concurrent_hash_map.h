@@ -0,0 +1,383 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "epoch/domain.h"
+
+namespace coop
+{
+
+// ConcurrentHashMap is a hash map every cooperator can read without taking a lock: session and
+// routing tables that each core consults on every request. Reads walk the buckets with acquire
+// loads under an epoch::DomainGuard; writes take one of a fixed set of bucket-stripe locks, unlink
+// or replace a node, and retire what they removed through the caller's epoch::Participant, so a
+// node is freed only once no reader can still hold it.
+//
+//  coop::epoch::Domain domain;                                     // process-wide
+//  coop::ConcurrentHashMap<uint64_t, Route> routes(domain);
+//
+//  coop::epoch::Participant participant(domain);                   // per cooperator
+//  {
+//      coop::epoch::DomainGuard guard(participant);
+//      if (Route const* route = routes.Find(guard, id)) { ... }    // valid while guard lives
+//  }
+//  routes.InsertOrAssign(participant, id, route);
+//
+// Separate chaining over a power-of-two bucket array. A stripe lock covers every bucket whose
+// index agrees with it in the low bits, so a bucket's writers always take the same lock whatever
+// the table size. Nodes are immutable once published except for their link: InsertOrAssign
+// replaces the node rather than writing the value under a reader's feet.
+//
+// Growing doubles the table once a stripe's share of the entries passes kMaxLoad per bucket. The
+// grower takes every stripe lock, copies each entry into a new node of the new table, publishes
+// the table, and retires the old table and nodes -- readers already on them finish undisturbed.
+// That needs K and V copy-constructible; it is rare and amortized, and it never shrinks.
+//
+// Writers block on a std::mutex held for a handful of pointer writes (or a grow), never across a
+// yield. Reclamation follows the domain: see epoch::Domain for its rules, including that the
+// domain outlives the map's participants. The map itself may go away before the domain; retired
+// nodes carry their own reclaim function. Destruction must not race any reader or writer.
+//
+template<typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+struct ConcurrentHashMap
+{
+    static constexpr size_t kStripes = 64;
+    static constexpr size_t kMaxLoad = 2;
+
+    ConcurrentHashMap(ConcurrentHashMap const&) = delete;
+    ConcurrentHashMap(ConcurrentHashMap&&) = delete;
+
+    // buckets is rounded up to a power of two, and to at least kStripes
+    //
+    explicit ConcurrentHashMap(epoch::Domain& domain, size_t buckets = 1024);
+    ~ConcurrentHashMap();
+
+    // ---- Reads (lock-free) ----
+
+    // The value for key, or null. The pointer stays valid for as long as guard is held.
+    //
+    V const* Find(epoch::DomainGuard const& guard, K const& key) const;
+
+    // A copy of the value for key, pinned internally
+    //
+    std::optional<V> Get(epoch::Participant& participant, K const& key) const;
+
+    // ---- Writes ----
+
+    // Adds key unless it is already present (false)
+    //
+    bool Insert(epoch::Participant& participant, K key, V value);
+
+    // Adds key or replaces its value; the replaced node is retired. True if it was added.
+    //
+    bool InsertOrAssign(epoch::Participant& participant, K key, V value);
+
+    // Removes key, retiring its node. False if it was not present.
+    //
+    bool Erase(epoch::Participant& participant, K const& key);
+
+    // A snapshot sum across the stripes
+    //
+    size_t Size() const;
+
+    size_t BucketCount() const { return m_table.load(std::memory_order_acquire)->mask + 1; }
+
+  private:
+    struct Node : epoch::RetireEntry
+    {
+        Node(size_t h, K&& k, V&& v)
+        : hash(h)
+        , key(std::move(k))
+        , value(std::move(v))
+        {
+            reclaim = &Node::Free;
+        }
+
+        static void Free(epoch::RetireEntry* entry) { delete static_cast<Node*>(entry); }
+
+        std::atomic<Node*>  next{nullptr};
+        size_t const        hash;
+        K const             key;
+        V const             value;
+    };
+
+    struct Table : epoch::RetireEntry
+    {
+        explicit Table(size_t buckets)
+        : mask(buckets - 1)
+        , heads(new std::atomic<Node*>[buckets]())
+        {
+            reclaim = &Table::Free;
+        }
+
+        static void Free(epoch::RetireEntry* entry) { delete static_cast<Table*>(entry); }
+
+        size_t const                            mask;
+        std::unique_ptr<std::atomic<Node*>[]>   heads;
+    };
+
+    struct alignas(64) Stripe
+    {
+        std::mutex  lock;
+        size_t      count = 0;      // under lock
+    };
+
+    Stripe& StripeFor(size_t hash) { return m_stripes[hash & (kStripes - 1)]; }
+
+    // Under the hash's stripe lock: the link that points at key's node, or the bucket's tail link
+    //
+    std::atomic<Node*>* FindLink(Table* table, size_t hash, K const& key);
+
+    bool Upsert(epoch::Participant& participant, K&& key, V&& value, bool assign);
+
+    // Double the table if it is still the one the caller saw (called with no stripe held)
+    //
+    void Grow(epoch::Participant& participant, Table* seen);
+
+    epoch::Domain&          m_domain;
+    Hash                    m_hash;
+    KeyEqual                m_equal;
+    std::atomic<Table*>     m_table;
+    mutable Stripe          m_stripes[kStripes];
+};
+
+// ---------------------------------------------------------------------------------------------
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+ConcurrentHashMap<K, V, Hash, KeyEqual>::ConcurrentHashMap(epoch::Domain& domain, size_t buckets)
+: m_domain(domain)
+{
+    size_t size = kStripes;
+    while (size < buckets)
+    {
+        size <<= 1;
+    }
+    m_table.store(new Table(size), std::memory_order_release);
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+ConcurrentHashMap<K, V, Hash, KeyEqual>::~ConcurrentHashMap()
+{
+    Table* table = m_table.load(std::memory_order_acquire);
+    for (size_t i = 0; i <= table->mask; i++)
+    {
+        Node* node = table->heads[i].load(std::memory_order_relaxed);
+        while (node)
+        {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+    delete table;
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+V const* ConcurrentHashMap<K, V, Hash, KeyEqual>::Find(epoch::DomainGuard const& guard,
+                                                       K const& key) const
+{
+    assert(&guard.GetParticipant().GetDomain() == &m_domain && "guard pins another domain");
+    (void)guard;
+
+    const size_t hash = m_hash(key);
+    Table* table = m_table.load(std::memory_order_acquire);
+    Node* node = table->heads[hash & table->mask].load(std::memory_order_acquire);
+    for (; node; node = node->next.load(std::memory_order_acquire))
+    {
+        if (node->hash == hash && m_equal(node->key, key))
+        {
+            return &node->value;
+        }
+    }
+    return nullptr;
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+std::optional<V> ConcurrentHashMap<K, V, Hash, KeyEqual>::Get(epoch::Participant& participant,
+                                                              K const& key) const
+{
+    epoch::DomainGuard guard(participant);
+    if (V const* value = Find(guard, key))
+    {
+        return *value;
+    }
+    return std::nullopt;
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+std::atomic<typename ConcurrentHashMap<K, V, Hash, KeyEqual>::Node*>*
+ConcurrentHashMap<K, V, Hash, KeyEqual>::FindLink(Table* table, size_t hash, K const& key)
+{
+    std::atomic<Node*>* link = &table->heads[hash & table->mask];
+    for (Node* node = link->load(std::memory_order_relaxed); node;
+         node = link->load(std::memory_order_relaxed))
+    {
+        if (node->hash == hash && m_equal(node->key, key))
+        {
+            break;
+        }
+        link = &node->next;
+    }
+    return link;
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+bool ConcurrentHashMap<K, V, Hash, KeyEqual>::Insert(epoch::Participant& participant, K key,
+                                                     V value)
+{
+    return Upsert(participant, std::move(key), std::move(value), false);
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+bool ConcurrentHashMap<K, V, Hash, KeyEqual>::InsertOrAssign(epoch::Participant& participant,
+                                                             K key, V value)
+{
+    return Upsert(participant, std::move(key), std::move(value), true);
+}
+
+// The stripe lock is what pins the table: a grower holds every stripe, so the table loaded under
+// one is current until it is released
+//
+template<typename K, typename V, typename Hash, typename KeyEqual>
+bool ConcurrentHashMap<K, V, Hash, KeyEqual>::Upsert(epoch::Participant& participant, K&& key,
+                                                     V&& value, bool assign)
+{
+    assert(&participant.GetDomain() == &m_domain && "participant of another domain");
+
+    const size_t hash = m_hash(key);
+    Stripe& stripe = StripeFor(hash);
+    Table* grow = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(stripe.lock);
+        Table* table = m_table.load(std::memory_order_relaxed);
+        std::atomic<Node*>* link = FindLink(table, hash, key);
+        Node* existing = link->load(std::memory_order_relaxed);
+        if (existing && !assign)
+        {
+            return false;
+        }
+
+        Node* node = new Node(hash, std::move(key), std::move(value));
+        if (existing)
+        {
+            node->next.store(existing->next.load(std::memory_order_relaxed),
+                             std::memory_order_relaxed);
+            link->store(node, std::memory_order_release);
+            participant.Retire(existing);
+            return false;
+        }
+        link->store(node, std::memory_order_release);
+
+        // Each stripe covers (mask + 1) / kStripes buckets
+        //
+        if (++stripe.count > kMaxLoad * ((table->mask + 1) / kStripes))
+        {
+            grow = table;
+        }
+    }
+
+    if (grow)
+    {
+        Grow(participant, grow);
+    }
+    return true;
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+bool ConcurrentHashMap<K, V, Hash, KeyEqual>::Erase(epoch::Participant& participant, K const& key)
+{
+    assert(&participant.GetDomain() == &m_domain && "participant of another domain");
+
+    const size_t hash = m_hash(key);
+    Stripe& stripe = StripeFor(hash);
+    std::lock_guard<std::mutex> lock(stripe.lock);
+    Table* table = m_table.load(std::memory_order_relaxed);
+    std::atomic<Node*>* link = FindLink(table, hash, key);
+    Node* node = link->load(std::memory_order_relaxed);
+    if (!node)
+    {
+        return false;
+    }
+
+    // Readers already on node keep a valid next and walk on past it
+    //
+    link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+    participant.Retire(node);
+    stripe.count--;
+    return true;
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+size_t ConcurrentHashMap<K, V, Hash, KeyEqual>::Size() const
+{
+    size_t size = 0;
+    for (auto& stripe : m_stripes)
+    {
+        std::lock_guard<std::mutex> lock(stripe.lock);
+        size += stripe.count;
+    }
+    return size;
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+void ConcurrentHashMap<K, V, Hash, KeyEqual>::Grow(epoch::Participant& participant, Table* seen)
+{
+    // In stripe order, so two growers cannot deadlock; the second finds the table already replaced
+    //
+    for (auto& stripe : m_stripes)
+    {
+        stripe.lock.lock();
+    }
+
+    Table* old = m_table.load(std::memory_order_relaxed);
+    if (old == seen)
+    {
+        auto* table = new Table((old->mask + 1) * 2);
+        for (size_t i = 0; i <= old->mask; i++)
+        {
+            Node* node = old->heads[i].load(std::memory_order_relaxed);
+            while (node)
+            {
+                Node* next = node->next.load(std::memory_order_relaxed);
+                K key = node->key;
+                V value = node->value;
+                auto* copy = new Node(node->hash, std::move(key), std::move(value));
+                auto& head = table->heads[node->hash & table->mask];
+                copy->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                head.store(copy, std::memory_order_relaxed);
+                node = next;
+            }
+        }
+
+        // Publishes the new table and every node in it. Only then may the old ones be retired:
+        // their stamp must postdate the last moment a reader could newly reach them.
+        //
+        m_table.store(table, std::memory_order_release);
+        for (size_t i = 0; i <= old->mask; i++)
+        {
+            Node* node = old->heads[i].load(std::memory_order_relaxed);
+            while (node)
+            {
+                Node* next = node->next.load(std::memory_order_relaxed);
+                participant.Retire(node);
+                node = next;
+            }
+        }
+        participant.Retire(old);
+    }
+
+    for (auto& stripe : m_stripes)
+    {
+        stripe.lock.unlock();
+    }
+}
+
+} // end namespace coop
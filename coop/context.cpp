@@ -2,6 +2,10 @@
 #include "thunk.h"
 #include "cooperator.h"
 #include "debug_borrow.h"
+#include "detail/run_queue.h"
+#include "scheduling_group.h"
+#include "io/cork.h"
+#include "io/descriptor.h"
 
 namespace coop
 {
@@ -15,10 +19,16 @@ Context::Context(
 , m_handle(handle)
 , m_state(SchedulerState::YIELDED)
 , m_priority(config.priority)
-, m_currentPriority(config.priority)
+, m_runClass(static_cast<uint8_t>(detail::PriorityClassIndex(config.priority)))
+, m_group(config.group ? config.group : parent ? parent->m_group : nullptr)
+, m_deadlineUs(config.deadlineUs)
+, m_ioDeadlineUs(parent ? parent->m_ioDeadlineUs : 0)
 , m_cooperator(cooperator)
 , m_killedSignal(this)
+, m_sharedStack(config.sharedStack ? cooperator->m_sharedTop : nullptr)
 {
+    assert(!config.sharedStack || m_sharedStack);
+
     if (m_handle)
     {
         m_handle->m_context = this;
@@ -30,6 +40,10 @@ Context::Context(
         m_parent->m_children.Push(this);
         m_parent->m_lastChild.TryAcquire(this);
     }
+    if (m_group)
+    {
+        m_group->Join(this);
+    }
     m_segment.m_size = config.stackSize;
     m_entry = nullptr;
 
@@ -39,6 +53,16 @@ Context::Context(
     m_statistics.ioSubmits = 0;
     m_statistics.ioCompletes = 0;
     m_statistics.samples = 0;
+    m_statistics.blockedTicks = 0;
+    m_statistics.ioReads = 0;
+    m_statistics.ioWrites = 0;
+    m_statistics.ioReadBytes = 0;
+    m_statistics.ioWriteBytes = 0;
+    m_statistics.ioWaitTicks = 0;
+    m_statistics.pmuCycles = 0;
+    m_statistics.pmuInstructions = 0;
+    m_statistics.pmuLlcMisses = 0;
+    m_statistics.pmuBranchMisses = 0;
     m_lastRdtsc = 0;
 }
 
@@ -65,27 +89,133 @@ Context::~Context()
     //
     m_lastChild.Acquire(this);
     m_cooperator->m_contexts.Remove(this);
+    if (m_group)
+    {
+        m_group->Leave(this);
+    }
 }
 
-bool Context::Yield(const bool force /* = false */)
+bool Context::Yield()
 {
-    if (!force && !--m_currentPriority)
+    assert(m_epochState.traversal.IsUnpinned()
+           && "cannot Yield while traversal epoch is pinned");
+    detail::AssertNotInThunk();
+    debug::AssertNoOutstandingBorrows(this);
+
+    ++m_statistics.yields;
+
+    if (m_corks)
     {
-        return false;
+        io::Cork::FlushAll(this);
     }
+    m_cooperator->YieldFrom(this);
+    return true;
+}
 
+bool Context::YieldTo(Context* target)
+{
     assert(m_epochState.traversal.IsUnpinned()
            && "cannot Yield while traversal epoch is pinned");
     detail::AssertNotInThunk();
     debug::AssertNoOutstandingBorrows(this);
 
     ++m_statistics.yields;
-    m_currentPriority = m_priority;
 
-    m_cooperator->YieldFrom(this);
+    if (m_corks)
+    {
+        io::Cork::FlushAll(this);
+    }
+    m_cooperator->YieldTo(this, target);
     return true;
 }
 
+void Context::SetDeadline(int64_t deadlineUs)
+{
+    // A context already waiting in the run queue is keyed by its old deadline; re-queue it so the
+    // new one takes effect on the next pop rather than the one after it next yields.
+    //
+    if (m_state == SchedulerState::YIELDED)
+    {
+        m_cooperator->m_yielded.Remove(this);
+        m_deadlineUs = deadlineUs;
+        m_cooperator->m_yielded.Push(this);
+        return;
+    }
+    m_deadlineUs = deadlineUs;
+}
+
+bool Context::CanMigrate() const
+{
+    return !m_parent
+        && m_children.IsEmpty()
+        && !m_handle
+        && !IsKilled()
+        && !m_killedSignal.HasWaiters()
+        && m_statistics.ioSubmits == m_statistics.ioCompletes
+        && m_epochState.traversal.IsUnpinned()
+        && m_epochState.application.IsUnpinned()
+        && m_segment.m_backing != StackBacking::Arena
+        && !m_sharedStack;
+}
+
+bool Context::MigrateTo(Cooperator* target, std::initializer_list<io::Descriptor*> carry /* = {} */)
+{
+    assert(m_cooperator->Scheduled() == this);
+    assert(target);
+    detail::AssertNotInThunk();
+    debug::AssertNoOutstandingBorrows(this);
+
+    if (target == m_cooperator)
+    {
+        return true;
+    }
+    if (!CanMigrate())
+    {
+        return false;
+    }
+
+    // Descriptors are unbound here, on the source thread, and rebound after the switch to whichever
+    // cooperator we wake up on -- the target, or this one again if the target refused us.
+    //
+    assert(carry.size() <= 64);
+    uint64_t registered = 0;
+    size_t i = 0;
+    for (auto* desc : carry)
+    {
+        if (desc->Unbind())
+        {
+            registered |= uint64_t(1) << i;
+        }
+        i++;
+    }
+
+    m_cooperator->MigrateFrom(this, target);
+
+    i = 0;
+    for (auto* desc : carry)
+    {
+        desc->Rebind(m_cooperator->GetUring(), registered & (uint64_t(1) << i));
+        i++;
+    }
+    return m_cooperator == target;
+}
+
+bool Context::Rebalance(std::initializer_list<io::Descriptor*> carry /* = {} */)
+{
+    auto policy = m_cooperator->m_config.migrationPolicy;
+    if (!policy)
+    {
+        return false;
+    }
+
+    auto* target = policy(this);
+    if (!target || target == m_cooperator)
+    {
+        return false;
+    }
+    return MigrateTo(target, carry);
+}
+
 void Context::Detach()
 {
     assert(m_parent);
@@ -101,6 +231,11 @@ void Context::Block()
 {
     detail::AssertNotInThunk();
     ++m_statistics.blocks;
+
+    if (m_corks)
+    {
+        io::Cork::FlushAll(this);
+    }
     m_cooperator->Block(this);
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <initializer_list>
 
 #include "coordinator.h"
 #include "epoch/epoch.h"
@@ -8,6 +9,8 @@
 #include "detail/embedded_list.h"
 #include "detail/scheduler_state.h"
 #include "spawn_configuration.h"
+#include "stack_pool_configuration.h"
+#include "time/timer_queue.h"
 
 namespace coop
 {
@@ -17,7 +20,8 @@ struct AllocBuffer;
 
 struct Segment
 {
-    size_t m_size;
+    size_t       m_size;
+    StackBacking m_backing;     // how StackPool allocated it (see StackPool::Free)
     uint8_t    m_bottom[0] __attribute__((aligned(128)));
     
     size_t Size() const
@@ -40,6 +44,11 @@ struct Coordinator;
 struct CoordinatorExtension;
 struct Cooperator;
 
+struct SchedulingGroup;
+
+namespace detail { struct RunQueue; struct BumpChunk; }
+namespace io { struct Cork; struct Descriptor; }
+
 // Three different groups of mutually exclusive lists are kept for contexts:
 // - the list of all contexts for a given cooperator
 // - the list of all contexts in a given state for a given cooperator
@@ -51,9 +60,13 @@ static constexpr int CONTEXT_LIST_CHILDREN = 2;
 
 // An Context is what code runs "in," in cooperation with a Cooperator. Each
 //
+// The time::TimerNode base is the context's hookup into the cooperator's deadline heap when the
+// cooperator runs in SchedulingMode::EarliestDeadline (see detail::RunQueue); it is unused otherwise.
+//
 struct Context : EmbeddedListHookups<Context, int, CONTEXT_LIST_ALL>
                , EmbeddedListHookups<Context, int, CONTEXT_LIST_STATE>
                , EmbeddedListHookups<Context, int, CONTEXT_LIST_CHILDREN>
+               , private time::TimerNode
 {
     // Embedded lists for tracking the set of lists that contexts can never be in more
     // than one of, e.g. there are multiple `ContextStateList`s in the cooperator, but contexts are
@@ -77,15 +90,92 @@ struct Context : EmbeddedListHookups<Context, int, CONTEXT_LIST_ALL>
 
     ~Context();
 
-    // Return control to the cooperator so that it can schedule other contexts
+    // Return control to the cooperator so that it can schedule other contexts. Always yields and
+    // returns true.
+    //
+    bool Yield();
+
+    // Yield to target: switch straight into it, skipping the run queue, when it is runnable
+    // (yielded, not blocked) on this cooperator. A producer that knows which consumer runs next
+    // pays one switch instead of two plus a queue trip. The handoff spends the same budget and
+    // passes the same IO governor as CooperatorConfiguration::directYield, whether or not that is
+    // set; once the budget is spent, or when target cannot run, this is a plain Yield(). The
+    // yielding context goes on the run queue either way.
     //
-    bool Yield(bool force = false);
+    bool YieldTo(Context* target);
+
+    // Run-queue priority class this context was spawned with (SpawnConfiguration::priority, see
+    // PRIORITY_* in spawn_configuration.h). Children spawned without an explicit configuration
+    // inherit it.
+    //
+    int GetPriority() const
+    {
+        return m_priority;
+    }
+
+    // Absolute deadline (time::MonotonicMicros) used by SchedulingMode::EarliestDeadline to order
+    // this context among runnable ones; 0 clears it. Takes effect immediately, including for a
+    // context already waiting in the run queue. Ignored by cooperators in the default mode.
+    //
+    void SetDeadline(int64_t deadlineUs);
+
+    int64_t GetDeadline() const
+    {
+        return m_deadlineUs;
+    }
 
     Cooperator* GetCooperator()
     {
         return m_cooperator;
     }
 
+    // Move this (running) context to another cooperator's run queue. The stack travels with it; on
+    // return the context is executing on the target cooperator's thread. Returns false, leaving the
+    // context where it was, when the context is not migratable (see CanMigrate) or the target is
+    // shutting down.
+    //
+    // `carry` lists the descriptors the context keeps using after the move. Each is unhooked from
+    // this cooperator's ring before the switch and rebound to the new ring on arrival, including
+    // its fixed-file registration (re-registered on the target, best effort: a full table leaves it
+    // unregistered). They must have no IO in flight. Any descriptor not listed stays bound to the
+    // old ring and must not be used again from this context.
+    //
+    // Anything the context cached about its cooperator -- a Cooperator* or io::Uring* held in a
+    // local, a CooperatorVar reference, Self()-derived state -- is stale after a successful return
+    // and must be re-read. ContextVars live in the segment and move with it.
+    //
+    bool MigrateTo(Cooperator* target, std::initializer_list<io::Descriptor*> carry = {});
+
+    // Automatic counterpart to MigrateTo: ask the cooperator's migration policy
+    // (CooperatorConfiguration::migrationPolicy) for a target and migrate there if it names one.
+    // Intended to be called at natural quiescent points, e.g. between requests on a keep-alive
+    // connection. Returns true if the context moved.
+    //
+    bool Rebalance(std::initializer_list<io::Descriptor*> carry = {});
+
+    // Whether MigrateTo could move this context right now: it is detached with no children (the
+    // parent/child tree and m_lastChild coordinator are cooperator-local), not killed, holds no Handle
+    // (a Handle-side kill during the hand-off would race the transit), has no kill-signal waiters,
+    // no outstanding io::Handle operation, no pinned epoch, and its stack was not carved from its
+    // cooperator's huge-page arena (which only that cooperator's StackPool can recycle). A
+    // shared-stack context never migrates: its frames live on its own cooperator's shared stack.
+    //
+    bool CanMigrate() const;
+
+    // Whether this context's frames run on the cooperator's shared stack (shared_stack.h)
+    //
+    bool IsSharedStack() const
+    {
+        return !!m_sharedStack;
+    }
+
+    // The top of the stack this context's frames run on: its segment's, or the shared stack's
+    //
+    void* StackTop()
+    {
+        return m_sharedStack ? m_sharedStack : m_segment.Top();
+    }
+
     // The Killed system for contexts uses a Signal that starts armed and is notified on kill.
     //
     bool IsKilled() const
@@ -133,6 +223,7 @@ struct Context : EmbeddedListHookups<Context, int, CONTEXT_LIST_ALL>
 
   private:
     friend struct Cooperator;
+    friend struct detail::RunQueue;
     friend struct Coordinator;
     friend struct CoordinatorExtension;
     friend struct Signal;
@@ -160,14 +251,38 @@ struct Context : EmbeddedListHookups<Context, int, CONTEXT_LIST_ALL>
     Handle* m_handle;
     SchedulerState m_state;
     int m_priority;
-    int m_currentPriority;
+
+    // Index of this context's run list in the cooperator's detail::RunQueue, derived once from
+    // m_priority at construction.
+    //
+    uint8_t m_runClass;
+
+    // The fair-share group this context is charged to and queued in (scheduling_group.h), or
+    // nullptr
+    //
+    SchedulingGroup* m_group;
+
+    // See SetDeadline. 0 when the context has no deadline.
+    //
+    int64_t m_deadlineUs;
+
+    // Absolute time::MonotonicMicros bound on this context's IO, set by DeadlineScope and copied
+    // from the parent at spawn (see deadline_scope.h). 0 when unbounded. Unrelated to m_deadlineUs,
+    // which only orders the run queue.
+    //
+    int64_t m_ioDeadlineUs;
+
+    // The io::Corks open on this context, most recent first, flushed at every Yield and Block
+    // (see io/cork.h). nullptr when none, which is all the hot path checks.
+    //
+    io::Cork* m_corks{nullptr};
     Cooperator* m_cooperator;
     Signal m_killedSignal;
     ContextChildrenList m_children;
     Coordinator m_lastChild;
     const char* m_name;
 
-    struct
+    struct Statistics
     {
         size_t ticks;
         size_t yields;
@@ -175,9 +290,44 @@ struct Context : EmbeddedListHookups<Context, int, CONTEXT_LIST_ALL>
         size_t ioSubmits;
         size_t ioCompletes;
         size_t samples;
+        size_t blockedTicks;    // off-CPU profiler (perf/sampler.h): time blocked, block to wake
+
+        // CooperatorConfiguration::trackContextIo: finalized read and write ops (recv and send
+        // count as such), the bytes they moved, and the ticks from submit to finalize over all
+        // accounted ops. Zero unless the cooperator tracks IO.
+        //
+        size_t ioReads;
+        size_t ioWrites;
+        size_t ioReadBytes;
+        size_t ioWriteBytes;
+        size_t ioWaitTicks;
+
+        // CooperatorConfiguration::trackContextPmu: hardware counts while this context ran (user
+        // space only). Zero unless the cooperator's PMU group is open.
+        //
+        size_t pmuCycles;
+        size_t pmuInstructions;
+        size_t pmuLlcMisses;
+        size_t pmuBranchMisses;
     } m_statistics;
     int64_t m_lastRdtsc;
 
+    // When the context last entered the run queue, for the RunQueueWait histogram; 0 when not
+    // timing (see COOP_PERF_STAMP)
+    //
+    int64_t m_readyNs{0};
+
+    // When the context last entered the run queue, in ReadTsc ticks, for the scheduling delay
+    // (CooperatorConfiguration::trackSchedulingDelay); 0 until it first does
+    //
+    int64_t m_readyTsc{0};
+
+    // Off-CPU profiler (perf/sampler.h): when the context was last woken from a block and by which
+    // Coordinator's release, stamped only while the profiler runs
+    //
+    int64_t m_wakeTsc{0};
+    Coordinator const* m_wokenBy{nullptr};
+
     // Per-context epoch participation: traversal pin (Guard-managed) and application pin
     // (transaction-managed). Both default to Epoch::Unpinned() (zero). Written and read only
     // on the owning cooperator thread; the cooperator's m_epochWatermark atomic is the sole
@@ -191,10 +341,33 @@ struct Context : EmbeddedListHookups<Context, int, CONTEXT_LIST_ALL>
     //
     void* m_heapTop{nullptr};
 
+    // Stack-depth telemetry (CooperatorConfiguration::trackStackDepth): where painting began, or
+    // nullptr if this segment was not painted, and the highest watermark a BumpFree retreated from.
+    // Together they bound the region the exit scan may treat as stack.
+    //
+    void* m_paintBase{nullptr};
+    void* m_heapHigh{nullptr};
+
+    // Checked bump heap (CooperatorConfiguration::bumpReserve): the bytes BumpAlloc keeps clear
+    // below the calling frame, zero for the unchecked path; the overflow chunks taken when an
+    // allocation would have cut into them, most recent first; and how many were taken.
+    //
+    uint32_t m_bumpReserve{0};
+    uint32_t m_bumpOverflows{0};
+    detail::BumpChunk* m_bumpOverflow{nullptr};
+
     // Saved stack pointer — the 'bookmark' to switch back to when the context is resumed.
     //
     void* m_sp{nullptr};
 
+    // SpawnConfiguration::sharedStack: the top of the cooperator's shared stack, or nullptr when
+    // the frames run at the top of this context's own segment. While another shared context holds
+    // the stack, this one's live bytes [m_sp, m_sharedStack) wait in m_savedStack.
+    //
+    void* m_sharedStack{nullptr};
+    void* m_savedStack{nullptr};
+    size_t m_savedBytes{0};
+
     // Entry function to call when the context first starts executing. Set by Spawn/Launch before
     // calling EnterContext, which uses it from the makecontext trampoline.
     //
@@ -7,6 +7,7 @@
 
 #include "self.h"
 #include "context.h"
+#include "size_class_allocator.h"
 
 namespace coop
 {
@@ -28,6 +29,8 @@ namespace coop
 // ContextVar destructors must not do cooperative work (no yields, no blocks). They run after
 // the task and its Launchable have been destructed but before ~Context().
 //
+// For state most contexts never touch, LazyContextVar (below) reserves only a pointer.
+//
 // Usage:
 //
 //   // file scope
@@ -186,4 +189,82 @@ private:
     size_t m_offset;
 };
 
+// LazyContextVar<T> is a ContextVar for state few contexts touch: every context carries only a
+// pointer slot, nulled at spawn, and T is constructed on a context's first access and destroyed
+// at its teardown only if it was. Spawn cost stays one store however large T is.
+//
+// T comes from the cooperator's SizeClassAllocator rather than the context's bump heap: the
+// bump heap is LIFO, and a T allocated on first access would sit above allocations that a later
+// BumpFree can retreat past. The allocator's local path takes no lock or atomic, and a context
+// that migrates frees to its birth cooperator's remote queue. First access must be on a
+// cooperator thread; the access after is a load and a branch. Same teardown rules as ContextVar.
+//
+//   static LazyContextVar<ReplayLog> s_replay;
+//
+//   s_replay->Append(entry);                // constructs on this context's first use
+//   if (auto* log = s_replay.Peek()) ...    // nullptr while untouched; never constructs
+//
+template<typename T>
+struct LazyContextVar
+{
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "LazyContextVar<T> does not serve over-aligned types");
+
+    T* operator->()             { return Get(); }
+    T& operator*()              { return *Get(); }
+
+    T* Get()
+    {
+        return Get(Self());
+    }
+
+    T* Get(Context* ctx)
+    {
+        Slot* slot = m_slot.Get(ctx);
+        if (!slot->p) [[unlikely]]
+        {
+            slot->p = Construct();
+        }
+        return slot->p;
+    }
+
+    // The context's T if it has been constructed, else nullptr
+    //
+    T* Peek() const
+    {
+        return Peek(Self());
+    }
+
+    T* Peek(Context* ctx) const
+    {
+        return m_slot.Get(ctx)->p;
+    }
+
+private:
+    [[gnu::noinline]] static T* Construct()
+    {
+        SizeClassAllocator* allocator = SizeClassAllocator::Current();
+        assert(allocator && "LazyContextVar first accessed off a cooperator thread");
+        return new (allocator->Allocate(sizeof(T))) T();
+    }
+
+    // The slot's own construct / destruct, run for every context by the registry
+    //
+    struct Slot
+    {
+        ~Slot()
+        {
+            if (p)
+            {
+                p->~T();
+                SizeClassAllocator::Release(p, sizeof(T));
+            }
+        }
+
+        T* p = nullptr;
+    };
+
+    ContextVar<Slot> m_slot;
+};
+
 } // end namespace coop
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <cassert>
+#include <cstddef>
 #include <new>
 #include <type_traits>
 #include <utility>
@@ -8,6 +11,7 @@
 #include "cooperator.h"
 #include "detail/coordinator_extension.h"
 #include "self.h"
+#include "trace.h"
 
 namespace coop
 {
@@ -62,6 +66,53 @@ struct CompletionLatch
     bool     m_fired = false;
 };
 
+// ContinuationFuture is the frame-hosted, one-shot half every structured continuation shares --
+// Coordinator::Continue's result and the Then / WhenAll / WhenAny combinators below -- and what
+// the combinators compose through. It fires once, waking its awaiter (if any) through its latch,
+// and then runs its observer: the one combinator watching it, as a function call in the same
+// drain. Each future has at most one observer, so a future feeds one combinator.
+//
+struct ContinuationFuture : Continuation
+{
+    bool Fired() const
+    {
+        return m_latch.Fired();
+    }
+
+    // Detach so the future never fires. False once fired or already cancelled. In-cooperator only.
+    //
+    virtual bool Cancel() = 0;
+
+    // For combinators: observer->Run() is called once this fires. Null to stop observing.
+    //
+    void Observe(Continuation* observer)
+    {
+        assert((!observer || !m_observer) && "a ContinuationFuture feeds at most one combinator");
+        m_observer = observer;
+    }
+
+  protected:
+    // Fire: wake the awaiter, then the observing combinator
+    //
+    void Complete()
+    {
+        m_latch.Fire();
+        if (m_observer)
+        {
+            m_observer->Run();
+        }
+    }
+
+    void Wait()
+    {
+        m_latch.Wait(Self());
+    }
+
+  private:
+    CompletionLatch m_latch;
+    Continuation*   m_observer = nullptr;
+};
+
 // Lambda-backed continuation. Registered on a Coordinator via Coordinator::Continue; when that
 // coordinator is Released, Resume runs `fn` to completion as a function call (no context switch)
 // on the releasing cooperator. The caller frame owns this object (it carries intrusive wait-list
@@ -72,7 +123,7 @@ struct CompletionLatch
 // detaches it early. There is no kill special-casing — a kill-aware caller cancels if it cares.
 //
 template<typename Fn>
-struct ContinuationImpl final : Continuation
+struct ContinuationImpl final : ContinuationFuture
 {
     using Result = std::invoke_result_t<Fn&, Coordinator*>;
     static constexpr bool kVoid = std::is_void_v<Result>;
@@ -82,6 +133,7 @@ struct ContinuationImpl final : Continuation
     : m_coordinated(static_cast<Continuation*>(this))
     , m_coord(coord)
     , m_fn(std::move(fn))
+    , m_trace(trace::Capture())
     {
         // Register on the target coordinator's wait list. Cooperative scheduling means no
         // completion can be processed before the current context yields, so this races nothing.
@@ -94,7 +146,7 @@ struct ContinuationImpl final : Continuation
 
     ~ContinuationImpl() final
     {
-        if (m_latch.Fired())                  // already fired ⇒ drop the (uncollected) result
+        if (Fired())                          // already fired ⇒ drop the (uncollected) result
         {
             if constexpr (!kVoid)
             {
@@ -109,26 +161,30 @@ struct ContinuationImpl final : Continuation
     {
         // Runs from the cooperator loop's continuation drain — there is no current context, so
         // m_coord (the coordinator this fired on) is passed to fn, and the latch wake is
-        // context-free (Fire routes through the cooperator, schedule=false).
+        // context-free (Fire routes through the cooperator, schedule=false). fn runs under the
+        // trace context captured when it was registered.
         //
-        if constexpr (kVoid)
         {
-            m_fn(m_coord);
-        }
-        else
-        {
-            new (&m_storage) Stored(m_fn(m_coord));
+            trace::ContextScope traced(m_trace);
+            if constexpr (kVoid)
+            {
+                m_fn(m_coord);
+            }
+            else
+            {
+                new (&m_storage) Stored(m_fn(m_coord));
+            }
         }
 
-        m_latch.Fire();
+        Complete();
     }
 
     // Detach an unfired continuation from its coordinator so it will never fire. No-op once
     // fired. In-cooperator only (cooperative scheduling makes this race-free).
     //
-    bool Cancel()
+    bool Cancel() final
     {
-        if (m_latch.Fired() || m_cancelled)
+        if (Fired() || m_cancelled)
         {
             return false;
         }
@@ -141,7 +197,16 @@ struct ContinuationImpl final : Continuation
     //
     Result Await()
     {
-        m_latch.Wait(Self());
+        Wait();
+        return Take();
+    }
+
+    // The result of a fired continuation, without waiting. For combinators, and for collecting
+    // the inputs of a WhenAll or WhenAny that has fired.
+    //
+    Result Take()
+    {
+        assert(Fired());
         if constexpr (!kVoid)
         {
             return std::move(*Stored_ptr());
@@ -154,11 +219,11 @@ struct ContinuationImpl final : Continuation
         return std::launder(reinterpret_cast<Stored*>(&m_storage));
     }
 
-    Coordinated     m_coordinated;
-    CompletionLatch m_latch;
-    Coordinator*    m_coord;
-    Fn              m_fn;
-    bool            m_cancelled = false;
+    Coordinated        m_coordinated;
+    Coordinator*       m_coord;
+    Fn                 m_fn;
+    trace::SpanContext m_trace;
+    bool               m_cancelled = false;
     alignas(Stored) unsigned char m_storage[sizeof(Stored)];
 };
 
@@ -171,6 +236,343 @@ auto Coordinator::Continue(Fn&& fn)
     return ContinuationImpl<std::decay_t<Fn>>(this, std::forward<Fn>(fn));
 }
 
+// ---- Combinators ----------------------------------------------------------------------------
+//
+// Then, WhenAll and WhenAny compose ContinuationFutures into a multi-step flow without a context
+// to host it. Like Continue's result each is frame-hosted (guaranteed copy elision; no heap) and
+// fires from the loop drain, as a function call straight out of the input that completed it.
+// Inputs are the caller's: declare them before the combinator that takes them, so they outlive
+// it. Destroying or cancelling a combinator that has not fired cancels its unfired inputs.
+//
+//   auto header = readDone.Continue([&](Coordinator*) { return ParseHeader(buf); });
+//   auto length = Then(header, [](Header h) { return h.length; });
+//   auto expired = timer.Continue([](Coordinator*) {});
+//   auto first = WhenAny(length, expired);        // the loser is cancelled when the other fires
+//   if (first.Await() == 0) Use(length.Take());
+//
+// Cancelling a loser detaches its continuation; the operation behind it (the IO, the timer) is
+// still the caller's to cancel or let finish.
+//
+
+namespace detail
+{
+    template<typename Fn, typename Arg>
+    struct ThenResult
+    {
+        using type = std::invoke_result_t<Fn&, Arg>;
+    };
+
+    template<typename Fn>
+    struct ThenResult<Fn, void>
+    {
+        using type = std::invoke_result_t<Fn&>;
+    };
+}
+
+// Then(prev, fn): fn runs on prev's result (moved out of prev) as soon as prev fires, in the
+// same drain; for a void prev, fn takes no argument. If prev has already fired, fn runs now.
+//
+template<typename Prev, typename Fn>
+struct ThenImpl final : ContinuationFuture
+{
+    using PrevResult = typename Prev::Result;
+    using Result = typename detail::ThenResult<Fn, PrevResult>::type;
+    static constexpr bool kVoid = std::is_void_v<Result>;
+    using Stored = std::conditional_t<kVoid, detail::Void, Result>;
+
+    ThenImpl(Prev& prev, Fn fn)
+    : m_prev(&prev)
+    , m_fn(std::move(fn))
+    , m_trace(trace::Capture())
+    {
+        if (prev.Fired())
+        {
+            Invoke();
+            return;
+        }
+        prev.Observe(this);
+    }
+
+    ThenImpl(ThenImpl const&) = delete;
+    ThenImpl(ThenImpl&&) = delete;
+
+    ~ThenImpl() final
+    {
+        if (Fired())
+        {
+            if constexpr (!kVoid)
+            {
+                Stored_ptr()->~Stored();
+            }
+            return;
+        }
+        Cancel();
+    }
+
+    void Run() final
+    {
+        trace::ContextScope traced(m_trace);
+        Invoke();
+    }
+
+    // Cancel prev along with this
+    //
+    bool Cancel() final
+    {
+        if (Fired() || m_cancelled)
+        {
+            return false;
+        }
+        m_cancelled = true;
+        m_prev->Observe(nullptr);
+        m_prev->Cancel();
+        return true;
+    }
+
+    Result Await()
+    {
+        Wait();
+        return Take();
+    }
+
+    Result Take()
+    {
+        assert(Fired());
+        if constexpr (!kVoid)
+        {
+            return std::move(*Stored_ptr());
+        }
+    }
+
+  private:
+    void Invoke()
+    {
+        if constexpr (std::is_void_v<PrevResult>)
+        {
+            m_prev->Take();
+            Store([&] { return m_fn(); });
+        }
+        else
+        {
+            Store([&] { return m_fn(m_prev->Take()); });
+        }
+        Complete();
+    }
+
+    template<typename Call>
+    void Store(Call const& call)
+    {
+        if constexpr (kVoid)
+        {
+            call();
+        }
+        else
+        {
+            new (&m_storage) Stored(call());
+        }
+    }
+
+    Stored* Stored_ptr()
+    {
+        return std::launder(reinterpret_cast<Stored*>(&m_storage));
+    }
+
+    Prev*              m_prev;
+    Fn                 m_fn;
+    trace::SpanContext m_trace;
+    bool               m_cancelled = false;
+    alignas(Stored) unsigned char m_storage[sizeof(Stored)];
+};
+
+template<typename Prev, typename Fn>
+auto Then(Prev& prev, Fn&& fn)
+{
+    static_assert(std::is_base_of_v<ContinuationFuture, Prev>);
+    return ThenImpl<Prev, std::decay_t<Fn>>(prev, std::forward<Fn>(fn));
+}
+
+// WhenAll(inputs...): fires once every input has. Its result is void; collect each input's with
+// Take() (or Await(), which no longer waits).
+//
+template<size_t N>
+struct WhenAllImpl final : ContinuationFuture
+{
+    using Result = void;
+
+    template<typename... Inputs>
+    explicit WhenAllImpl(Inputs&... inputs)
+    : m_inputs{&inputs...}
+    {
+        for (auto* input : m_inputs)
+        {
+            if (!input->Fired())
+            {
+                m_remaining++;
+                input->Observe(this);
+            }
+        }
+        if (m_remaining == 0)
+        {
+            Complete();
+        }
+    }
+
+    WhenAllImpl(WhenAllImpl const&) = delete;
+    WhenAllImpl(WhenAllImpl&&) = delete;
+
+    ~WhenAllImpl() final
+    {
+        Cancel();
+    }
+
+    // One input fired
+    //
+    void Run() final
+    {
+        assert(m_remaining > 0);
+        if (--m_remaining == 0)
+        {
+            Complete();
+        }
+    }
+
+    bool Cancel() final
+    {
+        if (Fired() || m_cancelled)
+        {
+            return false;
+        }
+        m_cancelled = true;
+        for (auto* input : m_inputs)
+        {
+            if (!input->Fired())
+            {
+                input->Observe(nullptr);
+                input->Cancel();
+            }
+        }
+        return true;
+    }
+
+    void Await()
+    {
+        Wait();
+    }
+
+    void Take()
+    {
+        assert(Fired());
+    }
+
+  private:
+    std::array<ContinuationFuture*, N> m_inputs;
+    size_t m_remaining = 0;
+    bool   m_cancelled = false;
+};
+
+template<typename... Inputs>
+auto WhenAll(Inputs&... inputs)
+{
+    static_assert(sizeof...(Inputs) > 0);
+    static_assert((std::is_base_of_v<ContinuationFuture, Inputs> && ...));
+    return WhenAllImpl<sizeof...(Inputs)>(inputs...);
+}
+
+// WhenAny(inputs...): fires with the first input to, and cancels the rest. Its result is the
+// winner's index in the argument list; collect the winner's own result with its Take().
+//
+template<size_t N>
+struct WhenAnyImpl final : ContinuationFuture
+{
+    using Result = size_t;
+
+    template<typename... Inputs>
+    explicit WhenAnyImpl(Inputs&... inputs)
+    : m_inputs{&inputs...}
+    {
+        for (auto* input : m_inputs)
+        {
+            if (input->Fired())
+            {
+                Run();
+                return;
+            }
+        }
+        for (auto* input : m_inputs)
+        {
+            input->Observe(this);
+        }
+    }
+
+    WhenAnyImpl(WhenAnyImpl const&) = delete;
+    WhenAnyImpl(WhenAnyImpl&&) = delete;
+
+    ~WhenAnyImpl() final
+    {
+        Cancel();
+    }
+
+    // An input fired. Inputs fire one at a time and the first one completes this, so the winner
+    // is the lowest-indexed input that has fired.
+    //
+    void Run() final
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            if (m_inputs[i]->Fired() && m_winner == N)
+            {
+                m_winner = i;
+            }
+            m_inputs[i]->Observe(nullptr);
+        }
+        for (auto* input : m_inputs)
+        {
+            input->Cancel();
+        }
+        Complete();
+    }
+
+    bool Cancel() final
+    {
+        if (Fired() || m_cancelled)
+        {
+            return false;
+        }
+        m_cancelled = true;
+        for (auto* input : m_inputs)
+        {
+            input->Observe(nullptr);
+            input->Cancel();
+        }
+        return true;
+    }
+
+    size_t Await()
+    {
+        Wait();
+        return Take();
+    }
+
+    size_t Take()
+    {
+        assert(Fired());
+        return m_winner;
+    }
+
+  private:
+    std::array<ContinuationFuture*, N> m_inputs;
+    size_t m_winner = N;
+    bool   m_cancelled = false;
+};
+
+template<typename... Inputs>
+auto WhenAny(Inputs&... inputs)
+{
+    static_assert(sizeof...(Inputs) > 0);
+    static_assert((std::is_base_of_v<ContinuationFuture, Inputs> && ...));
+    return WhenAnyImpl<sizeof...(Inputs)>(inputs...);
+}
+
 // Detached (hoisted) continuation: owns itself rather than living on a caller frame, so there is
 // no parked context awaiting it — the high-fan-out win. Registered on a coordinator at creation,
 // it fires once from the loop drain, runs fn to completion, and frees itself. fn is terminal
@@ -202,20 +604,25 @@ struct DetachedContinuationImpl final : Continuation
     : m_coordinated(static_cast<Continuation*>(this))
     , m_coord(coord)
     , m_fn(std::move(fn))
+    , m_trace(trace::Capture())
     {
         CoordinatorExtension().AddAsBlocked(coord, &m_coordinated);
     }
 
     void Run() final
     {
-        m_fn(m_coord);
+        {
+            trace::ContextScope traced(m_trace);
+            m_fn(m_coord);
+        }
         delete this;            // self-free once fired (its node was already popped by the drain)
     }
 
   private:
-    Coordinated  m_coordinated;
-    Coordinator* m_coord;
-    Fn           m_fn;
+    Coordinated        m_coordinated;
+    Coordinator*       m_coord;
+    Fn                 m_fn;
+    trace::SpanContext m_trace;
 };
 
 template<typename Fn>
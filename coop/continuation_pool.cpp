@@ -28,7 +28,7 @@ void* ContinuationPool::Allocate(size_t n)
 void ContinuationPool::Free(void* p, size_t n)
 {
     const size_t c = ClassFor(n);
-    if (c == kClasses || m_count[c] >= kCap)
+    if (c == kClasses || m_count[c] >= m_cap)
     {
         std::free(p);                           // unpooled, or bucket already full
         return;
@@ -40,6 +40,23 @@ void ContinuationPool::Free(void* p, size_t n)
     ++m_count[c];
 }
 
+size_t ContinuationPool::Relieve(size_t batch)
+{
+    size_t freed = 0;
+    for (size_t c = kClasses; c-- > 0 && freed < batch;)
+    {
+        while (m_count[c] > m_floor && freed < batch)
+        {
+            FreeNode* node = m_free[c];
+            m_free[c] = node->next;
+            --m_count[c];
+            std::free(node);
+            freed++;
+        }
+    }
+    return freed;
+}
+
 ContinuationPool::~ContinuationPool()
 {
     for (size_t c = 0; c < kClasses; ++c)
@@ -10,12 +10,18 @@ namespace coop
 // fired, and freed entirely on one cooperator's thread (the single-cooperator invariant), so the
 // pool needs no atomics. Blocks are bucketed into size classes with an intrusive free-list overlaid
 // on dead blocks; allocations larger than the biggest class fall back to malloc/free. Each bucket
-// is capped so a burst of frees does not retain memory unboundedly.
+// is capped so a burst of frees does not retain memory unboundedly, and under memory pressure
+// Relieve frees a bucket down to its floor.
 //
 class ContinuationPool
 {
   public:
-    ContinuationPool() = default;
+    explicit ContinuationPool(uint32_t cap = kDefaultCap, uint32_t floor = 0)
+    : m_cap(cap)
+    , m_floor(floor < cap ? floor : cap)
+    {
+    }
+
     ContinuationPool(const ContinuationPool&) = delete;
     ContinuationPool& operator=(const ContinuationPool&) = delete;
     ~ContinuationPool();
@@ -26,10 +32,28 @@ class ContinuationPool
     void* Allocate(size_t n);
     void  Free(void* p, size_t n);
 
+    // Free up to batch retained blocks above the floor, largest class first. Returns blocks
+    // freed: 0 once every class is at its floor.
+    //
+    size_t Relieve(size_t batch);
+
+    // Bytes held in free blocks, for memory accounting
+    //
+    size_t RetainedBytes() const
+    {
+        size_t bytes = 0;
+        for (size_t i = 0; i < kClasses; ++i)
+        {
+            bytes += m_count[i] * kSizes[i];
+        }
+        return bytes;
+    }
+
+    static constexpr uint32_t kDefaultCap = 256;    // max retained free blocks per class
+
   private:
     static constexpr size_t   kClasses = 4;
     static constexpr size_t   kSizes[kClasses] = {64, 128, 256, 512};
-    static constexpr uint32_t kCap = 256;       // max retained free blocks per class
 
     struct FreeNode
     {
@@ -50,6 +74,8 @@ class ContinuationPool
         return kClasses;
     }
 
+    uint32_t  m_cap;
+    uint32_t  m_floor;
     FreeNode* m_free[kClasses] = {};
     uint32_t  m_count[kClasses] = {};
 };
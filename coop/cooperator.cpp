@@ -1,28 +1,42 @@
+#include <algorithm>
 #include <functional>
 #include <liburing.h>
 #include <mutex>
 #include <new>
 #include <pthread.h>
 #include <sys/eventfd.h>
+#include <sys/mman.h>
 #include <thread>
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string_view>
 
 #include "cooperator.h"
 #include "cooperate.h"
 #include "context_var.h"
+#include "coordinate_with.h"
+#include "detail/bump.h"
 #include "detail/context_switch.h"
 #include "detail/memory_order.h"
+#include "detail/tsc.h"
 #include "io/descriptor.h"
+#include "io/futex.h"
+#include "io/handle.h"
 #include "io/read.h"
 #include "launchable.h"
 #include "perf/patch.h"
 #include "perf/probe.h"
 #include "perf/sampler.h"
+#include "perf/usdt.h"
+#include "perf/watchdog.h"
+#include "preempt.h"
+#include "sharded_counter.h"
 #include "detail/timer_tag.h"
 #include "time/now.h"
+#include "trace.h"
+#include "work/grid.h"
 
 namespace coop
 {
@@ -54,9 +68,9 @@ bool InThunk()
 }
 #endif
 
-std::atomic<bool>        Cooperator::s_registryShutdown{false};
-std::mutex               Cooperator::s_registryMutex;
-Cooperator::RegistryList Cooperator::s_registry;
+std::atomic<bool>           Cooperator::s_registryShutdown{false};
+std::mutex                  Cooperator::s_registryMutex;
+detail::CooperatorRegistry  Cooperator::s_registry;
 
 Cooperator::Cooperator(CooperatorConfiguration const& config)
 : m_lastRdtsc(0)
@@ -65,9 +79,16 @@ Cooperator::Cooperator(CooperatorConfiguration const& config)
 , m_shutdown(false)
 , m_uring(config.uring)
 , m_scheduled(nullptr)
+, m_stackPool(config.stackPool)
 , m_name{}
 , m_submitFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+, m_submitHead(&m_submitStub)
+, m_futexWake(config.futexWake)
+, m_submitTail(&m_submitStub)
+, m_submitSlab(config.submissionSlots)
 , m_epochMgr(this)
+, m_yielded(config.priorityStarvationLimit, config.schedulingMode, config.trackSchedulingDelay)
+, m_continuationPool(config.continuationPoolCap, config.continuationPoolFloor)
 {
     assert(m_submitFd >= 0);
     memcpy(m_name, config.name, sizeof(m_name));
@@ -76,6 +97,18 @@ Cooperator::Cooperator(CooperatorConfiguration const& config)
     assert(registry.TotalSize() <= LOCAL_STORAGE_SIZE
            && "CooperatorVar registrations exceed LOCAL_STORAGE_SIZE");
     registry.ConstructAll(m_localStorage);
+
+    if (config.statusSnapshot.maxContexts)
+    {
+        m_statusSlot = std::make_unique<StatusSlot>(config.statusSnapshot.maxContexts);
+    }
+
+    m_doorbell.owner = this;
+    m_doorbell.deliver = [](detail::RingMessage*) {};
+    m_doorbell.undelivered = [](detail::RingMessage* message)
+    {
+        static_cast<Doorbell*>(message)->owner->WakeDrainer();
+    };
 }
 
 Cooperator::~Cooperator()
@@ -90,9 +123,14 @@ Cooperator::~Cooperator()
         close(m_submitFd);
     }
 
+    if (m_sharedMapping)
+    {
+        munmap(m_sharedMapping, m_sharedMappingBytes);
+    }
+
     // The run loop already removed us on exit (the common path); a cooperator destroyed without
-    // running never registered. Disconnected() is debug-only now, so check membership by walking the
-    // registry -- O(n) in the (small) cooperator count, paid once at teardown.
+    // running never registered. Check membership by walking the registry -- O(n) in the (small)
+    // cooperator count, paid once at teardown.
     //
     std::lock_guard<std::mutex> lock(s_registryMutex);
     if (s_registry.Contains(this))
@@ -123,6 +161,84 @@ void Cooperator::ShutdownAll()
     });
 }
 
+bool Cooperator::Drain(time::Interval grace)
+{
+    return Submit([grace](Context* ctx)
+    {
+        ctx->SetName("Drain");
+        ctx->GetCooperator()->RunDrain(ctx, grace);
+    });
+}
+
+void Cooperator::DrainAll(time::Interval grace)
+{
+    s_registryShutdown.store(true, detail::kStoreFlag);
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    s_registry.Visit([grace](Cooperator* co) -> bool
+    {
+        co->Drain(grace);
+        return true;
+    });
+}
+
+void Cooperator::RunDrain(Context* ctx, time::Interval grace)
+{
+    if (m_draining.exchange(true, std::memory_order_acq_rel))
+    {
+        return;
+    }
+
+    while (auto* hook = m_drainHooks.Pop())
+    {
+        hook->m_hooked = false;
+        hook->OnDrain();
+    }
+
+    // Whoever is woken by the last hold's release owns m_drainHeld, and keeps it when a new hold
+    // came in before it ran -- that hold's TryAcquire found it taken -- so it stays held exactly
+    // while holds remain
+    //
+    int64_t deadline = time::MonotonicMicros() + grace.count();
+    while (m_drainHolds > 0)
+    {
+        int64_t left = deadline - time::MonotonicMicros();
+        if (left <= 0)
+        {
+            break;
+        }
+        auto result = CoordinateWithKill(ctx, &m_drainHeld, time::Interval(left));
+        if (result.Killed() || result.TimedOut())
+        {
+            break;
+        }
+        if (m_drainHolds == 0)
+        {
+            m_drainHeld.Release(ctx, false);
+        }
+    }
+
+    Shutdown();
+}
+
+size_t Cooperator::Relieve(size_t batch)
+{
+    size_t freed = m_stackPool.Relieve(batch);
+    if (freed < batch)
+    {
+        freed += m_continuationPool.Relieve(batch - freed);
+    }
+    if (freed < batch)
+    {
+        m_pressureHooks.Visit([&](PressureHook* hook) -> bool
+        {
+            freed += hook->OnPressure(batch - freed);
+            return freed < batch;
+        });
+    }
+    return freed;
+}
+
 void Cooperator::ResetGlobalShutdown()
 {
     std::lock_guard<std::mutex> lock(s_registryMutex);
@@ -140,26 +256,108 @@ bool Cooperator::Submit(
 
 void Cooperator::PushSubmission(SubmissionEntry* entry)
 {
-    std::lock_guard<std::mutex> lock(m_submissionLock);
-    entry->m_next = nullptr;
-    if (m_submissionTail)
+    entry->m_next.store(nullptr, std::memory_order_relaxed);
+    auto* prev = m_submitHead.exchange(entry, std::memory_order_acq_rel);
+    prev->m_next.store(entry, std::memory_order_release);
+
+    if (!m_hasSubmissions.exchange(true, std::memory_order_acq_rel))
     {
-        m_submissionTail->m_next = entry;
+        WakeCooperator();
     }
-    else
+}
+
+// Vyukov's pop, consumer side only. nullptr when the list is empty, or when it ends at a producer
+// that has exchanged itself in but not linked yet.
+//
+Cooperator::SubmissionEntry* Cooperator::PopSubmission()
+{
+    auto* tail = m_submitTail;
+    auto* next = tail->m_next.load(std::memory_order_acquire);
+    if (tail == &m_submitStub)
     {
-        m_submissionHead = entry;
+        if (!next)
+        {
+            return nullptr;
+        }
+        m_submitTail = next;
+        tail = next;
+        next = next->m_next.load(std::memory_order_acquire);
+    }
+    if (next)
+    {
+        m_submitTail = next;
+        return tail;
     }
-    m_submissionTail = entry;
-    m_hasSubmissions.store(true, std::memory_order_release);
+    if (tail != m_submitHead.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+
+    // tail is the last entry: put the stub behind it so tail can leave
+    //
+    m_submitStub.m_next.store(nullptr, std::memory_order_relaxed);
+    auto* prev = m_submitHead.exchange(&m_submitStub, std::memory_order_acq_rel);
+    prev->m_next.store(&m_submitStub, std::memory_order_release);
+
+    next = tail->m_next.load(std::memory_order_acquire);
+    if (next)
+    {
+        m_submitTail = next;
+        return tail;
+    }
+    return nullptr;
 }
 
 void Cooperator::WakeCooperator()
 {
+    // With futexWake, a loop that is not parked drains on its next pass and needs no wake. The
+    // fence pairs with the one in the loop's park: either this sees the flag up, or the loop sees
+    // the submission (or shutdown) before it sleeps.
+    //
+    if (m_config.futexWake)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!m_loopParked.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+
+    // From another cooperator, ring the doorbell as a CQE on our ring: the loop wakes from
+    // WaitAndPoll and drains, with no eventfd write and no drainer context. Only the submission
+    // that set m_hasSubmissions gets here, so a burst rings once.
+    //
+    auto* self = thread_cooperator;
+    if (self && self != this && PostMessage(&m_doorbell))
+    {
+        return;
+    }
+    WakeDrainer();
+}
+
+void Cooperator::WakeDrainer()
+{
+    if (m_futexWake.load(std::memory_order_acquire))
+    {
+        m_wakeWord.fetch_add(1, std::memory_order_release);
+        io::FutexWake(&m_wakeWord, 1, io::FutexScope::Private);
+        return;
+    }
     uint64_t val = 1;
     [[maybe_unused]] auto ret = write(m_submitFd, &val, sizeof(val));
 }
 
+bool Cooperator::PostMessage(detail::RingMessage* message)
+{
+    auto* self = thread_cooperator;
+    if (!self || self == this || !m_acceptsMessages.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    auto data = reinterpret_cast<uintptr_t>(message) | detail::kMessageTag;
+    return self->m_uring.SendMessage(m_uring, data, data | detail::kMessageAckTag);
+}
+
 void Cooperator::DrainSubmissions()
 {
     if (!m_hasSubmissions.load(std::memory_order_acquire))
@@ -167,19 +365,47 @@ void Cooperator::DrainSubmissions()
         return;
     }
 
-    SubmissionEntry* head;
+    m_hasSubmissions.exchange(false, std::memory_order_acq_rel);
+
+    Context::ContextStateList adopted;
     {
-        std::lock_guard<std::mutex> lock(m_submissionLock);
-        head = m_submissionHead;
-        m_submissionHead = nullptr;
-        m_submissionTail = nullptr;
-        m_hasSubmissions.store(false, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(m_adoptLock);
+        adopted.Steal(m_adopted);
+    }
+
+    // Migrated contexts arrive switched out and owned by no cooperator; from here on they are ours.
+    //
+    while (auto* ctx = adopted.Pop())
+    {
+        ctx->m_cooperator = this;
+        ctx->m_state = SchedulerState::YIELDED;
+        m_contexts.Push(ctx);
+        m_yielded.Push(ctx);
+    }
+
+    // Take what is queued before spawning any of it, so work the spawns submit waits for the next
+    // drain. Popped entries are ours, and their links free to chain.
+    //
+    SubmissionEntry* head = nullptr;
+    SubmissionEntry* last = nullptr;
+    while (auto* entry = PopSubmission())
+    {
+        entry->m_next.store(nullptr, std::memory_order_relaxed);
+        if (last)
+        {
+            last->m_next.store(entry, std::memory_order_relaxed);
+        }
+        else
+        {
+            head = entry;
+        }
+        last = entry;
     }
 
     while (head)
     {
         auto* entry = head;
-        head = head->m_next;
+        head = head->m_next.load(std::memory_order_relaxed);
         SpawnFromSubmission(entry);
     }
 }
@@ -210,13 +436,12 @@ void Cooperator::SpawnFromSubmission(SubmissionEntry* entry)
             // Push completion notification back to caller's cooperator so Signal::Notify
             // runs in the caller's thread (Signal is local to that cooperator).
             //
-            auto* notifEntry = new TypedSubmission<std::function<void(Context*)>>(
+            auto* notifEntry = callerCoop->NewSubmission(
                 [handle](Context* ctx)
                 {
                     handle->m_signal.Notify(ctx, false);
                 }, s_defaultConfiguration);
             callerCoop->PushSubmission(notifEntry);
-            callerCoop->WakeCooperator();
         }
         return;
     }
@@ -255,15 +480,12 @@ void Cooperator::SpawnFromSubmission(SubmissionEntry* entry)
 
 void Cooperator::DrainRemainingSubmissions()
 {
-    std::lock_guard<std::mutex> lock(m_submissionLock);
-    auto* head = m_submissionHead;
-    m_submissionHead = nullptr;
-    m_submissionTail = nullptr;
-    while (head)
     {
-        auto* entry = head;
-        head = head->m_next;
-
+        std::lock_guard<std::mutex> lock(m_adoptLock);
+        assert(m_adoptClosed && m_adopted.IsEmpty());
+    }
+    while (auto* entry = PopSubmission())
+    {
         bool isCooperate = (reinterpret_cast<uintptr_t>(entry->m_completion) & 1) != 0;
         if (isCooperate)
         {
@@ -274,13 +496,12 @@ void Cooperator::DrainRemainingSubmissions()
             if (handle && callerCoop)
             {
                 handle->m_spawnOk = false;
-                auto* notifEntry = new TypedSubmission<std::function<void(Context*)>>(
+                auto* notifEntry = callerCoop->NewSubmission(
                     [handle](Context* ctx)
                     {
                         handle->m_signal.Notify(ctx, false);
                     }, s_defaultConfiguration);
                 callerCoop->PushSubmission(notifEntry);
-                callerCoop->WakeCooperator();
             }
 
             entry->m_destroy(entry);
@@ -301,6 +522,9 @@ void Cooperator::DrainRemainingSubmissions()
 
 void Cooperator::HandleCooperatorResumption(const SchedulerJumpResult res)
 {
+    AdvanceSlice(1, nullptr);
+    COOP_PERF_RECORD_SINCE(m_histograms, perf::Hist::RunSlice, m_sliceNs);
+
     // Charge elapsed time to the context that was running, then mark the cooperator's timestamp
     // for its own accounting. This single rdtsc serves both purposes. It is gated behind
     // trackContextCycles because the rdtsc is the dominant per-resume cost and the ticks it feeds
@@ -312,6 +536,7 @@ void Cooperator::HandleCooperatorResumption(const SchedulerJumpResult res)
         m_scheduled->m_statistics.ticks += now - m_scheduled->m_lastRdtsc;
         m_lastRdtsc = now;
     }
+    ChargePmu(m_scheduled);
 
     switch (res)
     {
@@ -327,7 +552,21 @@ void Cooperator::HandleCooperatorResumption(const SchedulerJumpResult res)
         case SchedulerJumpResult::EXITED:
         {
             COOP_PERF_INC(m_perf, perf::Counter::ContextExit);
-            m_stackPool.Free(m_scheduled, m_scheduled->m_segment.Size());
+            COOP_USDT(context_exit, m_scheduled, m_scheduled->GetName());
+            if (m_scheduled->m_paintBase && m_config.trackStackDepth)
+            {
+                RecordStackDepth(m_scheduled);
+            }
+            if (m_pmu.IsOpen())
+            {
+                RecordContextPmu(m_scheduled);
+            }
+            if (m_sharedHolder == m_scheduled)
+            {
+                m_sharedHolder = nullptr;
+            }
+            m_stackPool.Free(m_scheduled, m_scheduled->m_segment.Size(),
+                             m_scheduled->m_segment.m_backing);
             break;
         }
         case SchedulerJumpResult::YIELDED:
@@ -344,21 +583,90 @@ void Cooperator::HandleCooperatorResumption(const SchedulerJumpResult res)
             m_blocked.Push(m_scheduled);
             break;
         }
+        case SchedulerJumpResult::MIGRATED:
+        {
+            // Once Adopt accepts the context the target thread may resume it at any moment, so it
+            // must already be off every list of ours and must not be touched afterwards. A refusal
+            // (target shutting down) leaves it here as an ordinary yield; MigrateTo tells the two
+            // apart by which cooperator it wakes up on.
+            //
+            auto* ctx = m_scheduled;
+            auto* target = m_migrateTarget;
+            m_migrateTarget = nullptr;
+
+            m_contexts.Remove(ctx);
+            if (ctx->m_group)
+            {
+                ctx->m_group->Leave(ctx);
+            }
+            ctx->m_state = SchedulerState::YIELDED;
+            if (target->Adopt(ctx))
+            {
+                COOP_PERF_INC(m_perf, perf::Counter::ContextMigrate);
+                break;
+            }
+            m_contexts.Push(ctx);
+            m_yielded.Push(ctx);
+            break;
+        }
     }
     m_scheduled = nullptr;
 }
 
+void Cooperator::MigrateFrom(Context* ctx, Cooperator* target)
+{
+    assert(m_scheduled == ctx);
+    assert(target != this);
+    assert(!ctx->m_sharedStack);
+
+    // Always trampoline through the loop rather than direct-switching: the hand-off has to happen
+    // after this stack is switched out, and only the loop's resumption runs post-switch.
+    //
+    m_migrateTarget = target;
+    auto ret = ContextSwitch(&ctx->m_sp, m_sp, static_cast<int>(SchedulerJumpResult::MIGRATED));
+    assert(static_cast<SchedulerJumpResult>(ret) == SchedulerJumpResult::RESUMED);
+}
+
+bool Cooperator::Adopt(Context* ctx)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_adoptLock);
+        if (m_adoptClosed)
+        {
+            return false;
+        }
+        m_adopted.Push(ctx);
+    }
+    if (!m_hasSubmissions.exchange(true, std::memory_order_acq_rel))
+    {
+        WakeCooperator();
+    }
+    return true;
+}
+
+void Cooperator::MarkReady()
+{
+    m_readyNs.store(std::max<int64_t>(time::MonotonicNanos(), 1), std::memory_order_release);
+    m_readyNs.notify_all();
+}
+
 void Cooperator::Launch()
 {
+    m_launchNs = time::MonotonicNanos();
     {
         std::lock_guard<std::mutex> lock(s_registryMutex);
         if (s_registryShutdown.load(detail::kLoadFlag))
         {
             Shutdown();
+            MarkReady();
             return;
         }
         s_registry.Push(this);
     }
+    if (m_config.timeSliceUs)
+    {
+        detail::StartPreemptTicker();
+    }
 
     // The thread-cooperator binding is valid only for Launch's dynamic extent and is cleared on
     // exit. A stale binding is not a benign leak: thread-identity checks (BoundarySafeKill's
@@ -368,29 +676,56 @@ void Cooperator::Launch()
     //
     assert(Cooperator::thread_cooperator == nullptr);
     Cooperator::thread_cooperator = this;
+    m_thread = pthread_self();
+    m_coarseMicros = time::MonotonicMicros();
     epoch::SetManager(&m_epochMgr);
     pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, nullptr);
 
     // Pin this thread to a CPU core. If the config specifies a core, use it; otherwise
-    // auto-assign round-robin across available cores. COOP_NO_PIN=1 disables pinning.
+    // auto-assign by the configured placement policy. COOP_NO_PIN=1 disables pinning.
     //
     if (!PinningDisabled())
     {
-        int cpu = m_config.cpuAffinity;
-        if (cpu < 0)
-        {
-            cpu = NextRoundRobinCpu();
-        }
+        int cpu = PlaceCpu(m_config.placement, m_config.cpuAffinity);
         if (cpu >= 0 && PinThread(cpu) == 0)
         {
             m_cpuId = cpu;
             m_numaNode = GetTopology().NumaNodeForCpu(cpu);
         }
+        else
+        {
+            ReleaseCpu(cpu);
+        }
     }
 
     m_lastRdtsc = rdtsc();
+    m_tscOrigin = m_lastRdtsc;
+    m_nsOrigin = time::MonotonicNanos();
+
+    // After pinning, on the thread it will count: everything from here on is charged to the loop
+    // or to a context
+    //
+    if (m_config.trackContextPmu)
+    {
+        m_pmuError = m_pmu.Open();
+        m_pmu.Read(m_pmuLast);
+    }
+
+    // After pinning, so the cached stacks are allocated from this thread's node
+    //
+    if (m_numaNode >= 0 && GetTopology().nodes.size() > 1)
+    {
+        m_stackPool.BindToNode(m_numaNode);
+    }
+    m_stackPool.Prewarm();
 
     m_uring.Init();
+    m_acceptsMessages.store(m_uring.SupportsMessages(), std::memory_order_release);
+    if (m_config.storage.entries > 0)
+    {
+        m_storage.emplace(m_config.storage);
+        m_storage->Init();
+    }
 
     // Spawn a detached context that reads the eventfd and drains cross-thread submissions.
     // The eventfd is just another fd with a normal io_uring read — no special-case CQE handling
@@ -403,6 +738,28 @@ void Cooperator::Launch()
 
         io::Descriptor desc(io::borrowed, m_submitFd);
 
+        // futexWake: wait on m_wakeWord instead. The wait is kill-aware, so the shutdown sweep
+        // ends it without a wake. A kernel without the opcode fails the first wait with -EINVAL;
+        // the drainer then goes back to the eventfd, and so do the wakers.
+        //
+        while (m_futexWake.load(std::memory_order_relaxed) && !ctx->IsKilled())
+        {
+            const uint32_t seq = m_wakeWord.load(std::memory_order_acquire);
+            Coordinator coord;
+            io::Handle handle(ctx, &m_uring, &coord);
+            if (!io::FutexWait(handle, &m_wakeWord, seq, io::FutexScope::Private))
+            {
+                ctx->Yield();   // no SQE to be had; let the ring drain
+                continue;
+            }
+            if (handle.WaitKill() == -EINVAL)
+            {
+                m_futexWake.store(false, std::memory_order_release);
+            }
+            if (ctx->IsKilled()) break;
+            DrainSubmissions();
+        }
+
         while (!ctx->IsKilled())
         {
             uint64_t val;
@@ -412,8 +769,10 @@ void Cooperator::Launch()
         }
     });
 
-    // Check COOP_PERF=1 env var to enable dynamic perf probes at startup (mode 2 only).
-    // Static local ensures this runs once even with multiple cooperators.
+    // Check COOP_PERF=1 env var to enable dynamic perf probes at startup (mode 2 only), and
+    // COOP_SAMPLE=<hz> / COOP_OFFCPU=1 for the samplers, COOP_TRACE_SAMPLE=<rate> for tracing and
+    // COOP_WATCHDOG_MS=<ms> for the stall watchdog. Static local ensures this runs once even with
+    // multiple cooperators.
     //
     static bool envChecked = []{
         const char* perfEnv = getenv("COOP_PERF");
@@ -425,21 +784,37 @@ void Cooperator::Launch()
             int hz = atoi(sampleEnv);
             if (hz > 0) perf::StartSampling(hz);
         }
+
+        const char* offCpuEnv = getenv("COOP_OFFCPU");
+        if (offCpuEnv && offCpuEnv[0] == '1') perf::StartOffCpuProfiling();
+
+        const char* traceEnv = getenv("COOP_TRACE_SAMPLE");
+        if (traceEnv) trace::SetSampleRate(atof(traceEnv));
+
+        const char* watchdogEnv = getenv("COOP_WATCHDOG_MS");
+        if (watchdogEnv && atoi(watchdogEnv) > 0)
+        {
+            perf::StartWatchdog({.threshold = std::chrono::milliseconds(atoi(watchdogEnv))});
+        }
         return true;
     }();
     (void)envChecked;
 
+    MarkReady();
+
     bool shutdownKillDone = false;
 
     while (!m_yielded.IsEmpty() || !m_shutdown.load(detail::kLoadFlag)
                                  || !shutdownKillDone
                                  || !m_pendingContinuations.IsEmpty()
-                                 || m_uring.PendingOps() > 0)
+                                 || m_uring.PendingOps() > 0
+                                 || StorageBusy())
     {
         if (m_hasSubmissions.load(std::memory_order_acquire))
         {
             DrainSubmissions();
         }
+        PublishLoad();
 
         // When shutdown is requested, kill all live contexts from within the cooperator's
         // thread so they can exit naturally. This only needs to happen once; killed contexts
@@ -448,21 +823,25 @@ void Cooperator::Launch()
         if (m_shutdown.load(detail::kLoadFlag) && !shutdownKillDone)
         {
             shutdownKillDone = true;
+
+            // Close the door to migrations before the final drain, so every context that will ever
+            // arrive is in m_contexts by the time the kill sweep below walks it
+            //
+            {
+                std::lock_guard<std::mutex> lock(m_adoptLock);
+                m_adoptClosed = true;
+            }
             DrainSubmissions();
+            m_shutdownStats.startNs = time::MonotonicNanos();
+            m_shutdownStats.cqOverflows = m_uring.GetRingStatistics().cqOverflow;
             Spawn([this](Context* killCtx)
             {
-                m_contexts.Visit([&](Context* c) -> bool
-                {
-                    if (c != killCtx && !c->IsKilled())
-                    {
-                        killCtx->Kill(c, false /* schedule */);
-                    }
-                    return true;
-                });
+                KillForShutdown(killCtx);
             });
 
             // Wake the eventfd so the submission drainer's io::Read completes. The drainer
-            // uses non-kill-aware IO; it checks IsKilled() after each read returns.
+            // uses non-kill-aware IO; it checks IsKilled() after each read returns. (Its futex
+            // wait is kill-aware, and from the loop itself this is a no-op under futexWake.)
             //
             WakeCooperator();
         }
@@ -470,12 +849,17 @@ void Cooperator::Launch()
         if (m_yielded.IsEmpty())
         {
             m_uring.Poll();
+            if (StorageBusy())
+            {
+                m_storage->Poll();
+            }
 
             // Release any sleeps whose deadline has passed (the timer CQE, if it fired, was just
             // dispatched by Poll, clearing m_timerArmed). Woken sleepers join the yielded list, so
             // the m_yielded check below picks them up before the loop considers blocking.
             //
             ServiceExpiredTimers();
+            QuiesceEpochParticipants();
 
             if (m_hasSubmissions.load(std::memory_order_acquire))
             {
@@ -517,6 +901,15 @@ void Cooperator::Launch()
                 continue;
             }
 
+            // Storage IO in flight on an IOPOLL ring completes only when polled, so sleeping on the
+            // cooperator's ring now could strand it. Loop instead: each pass polls the device once
+            // and the cooperator's ring without blocking, until the storage ring drains.
+            //
+            if (StorageBusy())
+            {
+                continue;
+            }
+
             // No runnable contexts. Sleep in io_uring until the next CQE instead of spinning.
             // The submission drainer's eventfd read is an ordinary in-flight uring op, so
             // cross-thread Submit() also wakes this path via CQE delivery.
@@ -527,7 +920,34 @@ void Cooperator::Launch()
                 // wait wakes when the soonest sleep comes due. WaitAndPoll submits the SQE.
                 //
                 ArmNearestTimer();
+                if (m_stackPool.TrimEnabled())
+                {
+                    m_stackPool.Trim(time::NowCoarse());
+                }
+                if (EpochReclaimEnabled())
+                {
+                    ReclaimEpoch(false);
+                }
+                ParkEpochParticipants();
+                PublishLoad();
+                PublishStatus();
+
+                // futexWake: flag the park for WakeCooperator, then look once more for what a
+                // producer that saw the flag down left for us (see WakeCooperator)
+                //
+                if (m_config.futexWake)
+                {
+                    m_loopParked.store(true, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (m_hasSubmissions.load(std::memory_order_relaxed)
+                        || (m_shutdown.load(detail::kLoadFlag) && !shutdownKillDone))
+                    {
+                        m_loopParked.store(false, std::memory_order_relaxed);
+                        continue;
+                    }
+                }
                 m_uring.WaitAndPoll();
+                m_loopParked.store(false, std::memory_order_relaxed);
                 continue;
             }
 
@@ -602,29 +1022,131 @@ void Cooperator::Launch()
         //
         m_uring.Poll();
 
+        // The storage ring's reap, once per batch like the flush above: a batch is at most 16
+        // resumes, which bounds how long a storage completion waits on a busy cooperator
+        //
+        if (StorageBusy())
+        {
+            m_storage->Poll();
+        }
+
         // Service due sleeps on the busy path too. A loop that never goes idle would otherwise only
         // service timers in the idle branch above; here the loop's own iteration rate is the clock,
         // and no kernel timer is needed while there is other work to run.
         //
         ServiceExpiredTimers();
+        QuiesceEpochParticipants();
+        PublishStatus();
+
+        // A cooperator that never goes idle never reaches the reclaim before WaitAndPoll; once its
+        // epoch backlog reaches the watermark, a budgeted pass per batch keeps it bounded.
+        //
+        if (EpochReclaimEnabled() && EpochBacklogOverWatermark()) [[unlikely]]
+        {
+            ReclaimEpoch(true);
+        }
     }
 
+    m_shutdownStats.drainNs = time::MonotonicNanos() - m_shutdownStats.startNs;
+    m_shutdownStats.bulkCancelled = m_uring.GetCancelStatistics().bulkCancelled;
+    m_shutdownStats.cqOverflows = m_uring.GetRingStatistics().cqOverflow
+                                - m_shutdownStats.cqOverflows;
+
     epoch::SetManager(nullptr);
+    m_acceptsMessages.store(false, std::memory_order_release);
 
     // Signal any SubmitSync callers that arrived after the loop exited
     //
     DrainRemainingSubmissions();
 
+    // Removal waits out the readers already visiting us, so once it returns nothing still reads
+    // this cooperator through the registry
+    //
     {
         std::lock_guard<std::mutex> lock(s_registryMutex);
+        detail::RetireShardedSlots(this);
         s_registry.Remove(this);
     }
+    if (m_config.timeSliceUs)
+    {
+        detail::StopPreemptTicker();
+    }
 
+    m_storage.reset();
+    m_pmu.Close();
+    ReleaseCpu(m_cpuId);
     Cooperator::thread_cooperator = nullptr;
 }
 
+void Cooperator::KillForShutdown(Context* killCtx)
+{
+    using AllHookups = EmbeddedListHookups<Context, int, CONTEXT_LIST_ALL>;
+
+    // Fired all at once, the kills of a 100K-context tree are one long turn of this context, and
+    // what they set off -- every killed context's Handles cancelling -- floods the CQ past its
+    // overflow. In batches the loop runs in between, resuming the killed contexts and reaping
+    // their cancels, so neither the turn nor the flood outgrows a batch.
+    //
+    size_t batch = std::max<size_t>(m_uring.CqEntries() / 4, 1);
+    if (m_config.shutdownKillBatch)
+    {
+        batch = std::min<size_t>(batch, m_config.shutdownKillBatch);
+    }
+
+    // Our own place in the list is the cursor, which survives the yields: the contexts ahead of it
+    // are still to be looked at, and those behind it -- which may exit meanwhile -- are done. The
+    // walk goes newest first, children before their parents, as Context::Kill's post-order does.
+    // New contexts land behind the cursor, so passes repeat until one kills nothing.
+    //
+    auto* cursor = static_cast<AllHookups*>(killCtx);
+    size_t inBatch = 0;
+    uint64_t killed;
+    do
+    {
+        killed = m_shutdownStats.killed;
+        m_shutdownStats.passes++;
+        m_contexts.Remove(cursor);
+        m_contexts.Push(cursor);
+
+        while (Context* c = m_contexts.Prev(cursor))
+        {
+            m_contexts.Remove(cursor);
+            cursor->InsertBefore(static_cast<AllHookups*>(c));
+            if (c->IsKilled())
+            {
+                continue;
+            }
+
+            c->m_killedSignal.Notify(c, false /* schedule */);
+            m_shutdownStats.killed++;
+            if (++inBatch == batch)
+            {
+                inBatch = 0;
+                m_shutdownStats.batches++;
+                killCtx->Yield();
+            }
+        }
+
+        if (inBatch)
+        {
+            inBatch = 0;
+            m_shutdownStats.batches++;
+            killCtx->Yield();
+        }
+    } while (m_shutdownStats.killed != killed);
+
+    m_shutdownStats.killNs = time::MonotonicNanos() - m_shutdownStats.startNs;
+
+    if (m_config.shutdownBulkCancel)
+    {
+        m_uring.CancelWaiting();
+    }
+}
+
 void Cooperator::YieldFrom(Context* ctx)
 {
+    COOP_USDT(context_yield, ctx, ctx->GetName());
+
     // Direct-yield fastpath: when another context is already runnable, switch straight into it
     // instead of trampolining back through the cooperator loop (which would cost a second switch
     // plus HandleCooperatorResumption). The yielding context takes the place the loop would have
@@ -635,38 +1157,7 @@ void Cooperator::YieldFrom(Context* ctx)
     //
     if (m_config.directYield && m_directYieldsRemaining > 0 && !m_yielded.IsEmpty())
     {
-        // IO governor. The loop's hot path (ReapOnly) never enters the kernel, so a fastpath that
-        // keeps deferring the loop leaves queued SQEs unsubmitted (a timer never arms) and task_work
-        // completions undelivered -- IO latency balloons toward the batch-boundary poll, 16*budget
-        // switches away. The fix is to enter inline when work is pending: a real Poll submits queued
-        // SQEs AND reaps completions in one io_uring_enter (the enter runs task_work, materializing
-        // the completions the same call reaps -- the harvest rides the submit for free).
-        //
-        // Submissions are urgent and cheap to detect: an unsubmitted SQE is work that has not STARTED,
-        // strictly worse than a completion merely waiting, and HasPendingSubmissions is a field read,
-        // so check it EVERY yield. Completions (and cross-thread submissions handed in via
-        // m_hasSubmissions, acquire-ordered to match the loop) are lazier -- the work already
-        // happened, and the submit-enter harvests task_work anyway -- so only SAMPLE those reads once
-        // every kStride yields (a power of two, so the gate is a bitmask). After entering, clamp the
-        // budget to ioPresentLimit so a steady completion stream keeps polling promptly.
-        // ioPresentLimit == 0 disables the governor (pure count budget) for a known-CPU-bound workload.
-        //
-        constexpr int kStride = 4;
-        if (m_config.ioPresentLimit > 0)
-        {
-            const bool sample = (m_directYieldsRemaining & (kStride - 1)) == 0;
-            if (m_uring.HasPendingSubmissions() ||
-                (sample && (m_uring.HasPendingCompletions() ||
-                            m_hasSubmissions.load(std::memory_order_acquire))))
-            {
-                m_uring.Poll();
-
-                if (m_directYieldsRemaining > m_config.ioPresentLimit)
-                    m_directYieldsRemaining = m_config.ioPresentLimit;
-            }
-        }
-
-        if (m_directYieldsRemaining == 0)
+        if (!TakeDirectYield())
         {
             auto ret = ContextSwitch(&ctx->m_sp, m_sp,
                                      static_cast<int>(SchedulerJumpResult::YIELDED));
@@ -674,34 +1165,138 @@ void Cooperator::YieldFrom(Context* ctx)
             return;
         }
 
-        --m_directYieldsRemaining;
+        SwitchDirect(ctx, m_yielded.Pop());
+        return;
+    }
 
-        Context* next = m_yielded.Pop();
+    auto ret = ContextSwitch(&ctx->m_sp, m_sp, static_cast<int>(SchedulerJumpResult::YIELDED));
+    assert(static_cast<SchedulerJumpResult>(ret) == SchedulerJumpResult::RESUMED);
+}
 
-        if (m_config.trackContextCycles)
+void Cooperator::YieldTo(Context* ctx, Context* target)
+{
+    // A handoff names its successor, so it skips the run queue's pick but not its bounds: the
+    // same budget and IO governor as the directYield fastpath keep a ping-pong pair from starving
+    // the loop's polls. It does not need directYield set -- the caller asked for the switch.
+    //
+    if (target == ctx || target->m_cooperator != this
+        || target->m_state != SchedulerState::YIELDED || m_directYieldsRemaining <= 0)
+    {
+        YieldFrom(ctx);
+        return;
+    }
+
+    COOP_USDT(context_yield, ctx, ctx->GetName());
+
+    // The governor's poll only moves woken contexts onto the yielded list, so target is still there
+    //
+    if (!TakeDirectYield())
+    {
+        auto ret = ContextSwitch(&ctx->m_sp, m_sp, static_cast<int>(SchedulerJumpResult::YIELDED));
+        assert(static_cast<SchedulerJumpResult>(ret) == SchedulerJumpResult::RESUMED);
+        return;
+    }
+
+    COOP_PERF_INC(m_perf, perf::Counter::ContextYieldTo);
+    m_yielded.Remove(target);
+    SwitchDirect(ctx, target);
+}
+
+bool Cooperator::TakeDirectYield()
+{
+    // IO governor. The loop's hot path (ReapOnly) never enters the kernel, so a fastpath that
+    // keeps deferring the loop leaves queued SQEs unsubmitted (a timer never arms) and task_work
+    // completions undelivered -- IO latency balloons toward the batch-boundary poll, 16*budget
+    // switches away. The fix is to enter inline when work is pending: a real Poll submits queued
+    // SQEs AND reaps completions in one io_uring_enter (the enter runs task_work, materializing
+    // the completions the same call reaps -- the harvest rides the submit for free).
+    //
+    // Submissions are urgent and cheap to detect: an unsubmitted SQE is work that has not STARTED,
+    // strictly worse than a completion merely waiting, and HasPendingSubmissions is a field read,
+    // so check it EVERY yield. Completions (and cross-thread submissions handed in via
+    // m_hasSubmissions, acquire-ordered to match the loop) are lazier -- the work already
+    // happened, and the submit-enter harvests task_work anyway -- so only SAMPLE those reads once
+    // every kStride yields (a power of two, so the gate is a bitmask). After entering, clamp the
+    // budget to ioPresentLimit so a steady completion stream keeps polling promptly.
+    // ioPresentLimit == 0 disables the governor (pure count budget) for a known-CPU-bound workload.
+    //
+    constexpr int kStride = 4;
+    if (m_config.ioPresentLimit > 0)
+    {
+        const bool sample = (m_directYieldsRemaining & (kStride - 1)) == 0;
+        if (m_uring.HasPendingSubmissions() ||
+            (sample && (m_uring.HasPendingCompletions() ||
+                        m_hasSubmissions.load(std::memory_order_acquire))))
         {
-            auto now = rdtsc();
-            ctx->m_statistics.ticks += now - ctx->m_lastRdtsc;
-            next->m_lastRdtsc = now;
+            m_uring.Poll();
+
+            if (m_directYieldsRemaining > m_config.ioPresentLimit)
+                m_directYieldsRemaining = m_config.ioPresentLimit;
         }
+    }
 
-        ctx->m_state = SchedulerState::YIELDED;
-        m_yielded.Push(ctx);
+    if (m_directYieldsRemaining == 0)
+    {
+        return false;
+    }
 
-        next->m_state = SchedulerState::RUNNING;
-        m_scheduled = next;
+    --m_directYieldsRemaining;
+    return true;
+}
 
-        auto ret = ContextSwitch(&ctx->m_sp, next->m_sp,
-                                 static_cast<int>(SchedulerJumpResult::RESUMED));
+void Cooperator::SwitchDirect(Context* ctx, Context* next)
+{
+    if (NeedsHandoff(ctx, next))
+    {
+        assert(!m_handoff);
+        m_handoff = next;
+        auto ret = ContextSwitch(&ctx->m_sp, m_sp, static_cast<int>(SchedulerJumpResult::YIELDED));
         assert(static_cast<SchedulerJumpResult>(ret) == SchedulerJumpResult::RESUMED);
         return;
     }
 
-    auto ret = ContextSwitch(&ctx->m_sp, m_sp, static_cast<int>(SchedulerJumpResult::YIELDED));
+    if (m_config.trackContextCycles)
+    {
+        auto now = rdtsc();
+        ctx->m_statistics.ticks += now - ctx->m_lastRdtsc;
+        next->m_lastRdtsc = now;
+    }
+    ChargePmu(ctx);
+    COOP_PERF_RECORD_SINCE(m_histograms, perf::Hist::RunSlice, m_sliceNs);
+    COOP_PERF_RECORD_SINCE(m_histograms, perf::Hist::RunQueueWait, next->m_readyNs);
+    RecordSchedulingDelay(next);
+    COOP_PERF_STAMP(perf::Hist::RunSlice, m_sliceNs);
+    COOP_USDT(context_resume, next, next->GetName(), this);
+
+    ctx->m_state = SchedulerState::YIELDED;
+    m_yielded.Push(ctx);
+
+    next->m_state = SchedulerState::RUNNING;
+    m_scheduled = next;
+    AdvanceSlice(2, m_scheduled);
+    if (next->m_sharedStack)
+    {
+        AdoptSharedStack(next);
+    }
+
+    auto ret = ContextSwitch(&ctx->m_sp, next->m_sp,
+                             static_cast<int>(SchedulerJumpResult::RESUMED));
     assert(static_cast<SchedulerJumpResult>(ret) == SchedulerJumpResult::RESUMED);
 }
 
 void Cooperator::Resume(Context* ctx)
+{
+    // A shared-stack context that switched toward another one parked through here and left it
+    // in m_handoff: run it now, as the direct switch would have
+    //
+    do
+    {
+        ResumeOne(ctx);
+        ctx = std::exchange(m_handoff, nullptr);
+    } while (ctx);
+}
+
+void Cooperator::ResumeOne(Context* ctx)
 {
     // We must be running this from "within" the cooperator vs with a running context
     //
@@ -718,6 +1313,22 @@ void Cooperator::Resume(Context* ctx)
     m_directYieldsRemaining = m_config.directYieldBudget;
 
     COOP_PERF_INC(m_perf, perf::Counter::ContextResume);
+    COOP_PERF_RECORD_SINCE(m_histograms, perf::Hist::RunQueueWait, ctx->m_readyNs);
+    RecordSchedulingDelay(ctx);
+    COOP_PERF_STAMP(perf::Hist::RunSlice, m_sliceNs);
+    COOP_USDT(context_resume, ctx, ctx->GetName(), this);
+    ChargePmu(nullptr);
+    AdvanceSlice(1, m_scheduled);
+    if (ctx->m_sharedStack)
+    {
+        // A child spawned by a shared context starts here, handed off before its first switch
+        //
+        AdoptSharedStack(ctx);
+        if (!ctx->m_sp)
+        {
+            ctx->m_sp = ContextInit(m_sharedTop, ctx);
+        }
+    }
     auto ret = ContextSwitch(&m_sp, ctx->m_sp, static_cast<int>(SchedulerJumpResult::RESUMED));
     HandleCooperatorResumption(static_cast<SchedulerJumpResult>(ret));
 }
@@ -736,6 +1347,13 @@ void Cooperator::Block(Context* ctx)
         return;
     }
 
+    COOP_USDT(context_block, ctx, ctx->GetName());
+
+    // Captures the blocking stack if the off-CPU profiler is on, and records the sample when this
+    // context is resumed and the scope unwinds
+    //
+    perf::OffCpuScope offCpu(ctx);
+
     // The currently running context is placing itself into a blocked state. Direct-switch fastpath:
     // park it in the blocked list and switch straight into the next runnable, skipping the loop
     // trampoline (a second switch + HandleCooperatorResumption). The block/wake path is the bulk of a
@@ -754,20 +1372,40 @@ void Cooperator::Block(Context* ctx)
     {
         --m_directYieldsRemaining;
 
+        Context* next = m_yielded.Pop();
+        if (NeedsHandoff(ctx, next))
+        {
+            assert(!m_handoff);
+            m_handoff = next;
+            auto ret = ContextSwitch(&ctx->m_sp, m_sp,
+                                     static_cast<int>(SchedulerJumpResult::BLOCKED));
+            assert(static_cast<SchedulerJumpResult>(ret) == SchedulerJumpResult::RESUMED);
+            return;
+        }
+
         ctx->m_state = SchedulerState::BLOCKED;
         m_blocked.Push(ctx);
 
-        Context* next = m_yielded.Pop();
-
         if (m_config.trackContextCycles)
         {
             auto now = rdtsc();
             ctx->m_statistics.ticks += now - ctx->m_lastRdtsc;
             next->m_lastRdtsc = now;
         }
+        ChargePmu(ctx);
+        COOP_PERF_RECORD_SINCE(m_histograms, perf::Hist::RunSlice, m_sliceNs);
+        COOP_PERF_RECORD_SINCE(m_histograms, perf::Hist::RunQueueWait, next->m_readyNs);
+        RecordSchedulingDelay(next);
+        COOP_PERF_STAMP(perf::Hist::RunSlice, m_sliceNs);
+        COOP_USDT(context_resume, next, next->GetName(), this);
 
         next->m_state = SchedulerState::RUNNING;
         m_scheduled = next;
+        AdvanceSlice(2, m_scheduled);
+        if (next->m_sharedStack)
+        {
+            AdoptSharedStack(next);
+        }
 
         auto ret = ContextSwitch(&ctx->m_sp, next->m_sp,
                                  static_cast<int>(SchedulerJumpResult::RESUMED));
@@ -798,6 +1436,11 @@ void Cooperator::Unblock(Context* ctx, const bool schedule)
 
     m_blocked.Remove(ctx);
 
+    if (perf::IsOffCpuProfiling()) [[unlikely]]
+    {
+        ctx->m_wakeTsc = rdtsc();
+    }
+
     // If we are not scheduling it immediately, place it into the yielded state to be
     // scheduled organically later
     //
@@ -814,24 +1457,43 @@ void Cooperator::Unblock(Context* ctx, const bool schedule)
 
     auto* prev = m_scheduled;
 
+    if (NeedsHandoff(prev, ctx))
+    {
+        assert(!m_handoff);
+        ctx->m_state = SchedulerState::YIELDED;
+        m_handoff = ctx;
+        auto ret = ContextSwitch(&prev->m_sp, m_sp, static_cast<int>(SchedulerJumpResult::YIELDED));
+        assert(static_cast<SchedulerJumpResult>(ret) == SchedulerJumpResult::RESUMED);
+        return;
+    }
+
     if (m_config.trackContextCycles)
     {
         auto now = rdtsc();
         prev->m_statistics.ticks += now - prev->m_lastRdtsc;
         ctx->m_lastRdtsc = now;
     }
+    ChargePmu(prev);
+    COOP_PERF_RECORD_SINCE(m_histograms, perf::Hist::RunSlice, m_sliceNs);
+    COOP_PERF_STAMP(perf::Hist::RunSlice, m_sliceNs);
 
     prev->m_state = SchedulerState::YIELDED;
     m_yielded.Push(prev);
 
     ctx->m_state = SchedulerState::RUNNING;
     m_scheduled = ctx;
+    AdvanceSlice(2, m_scheduled);
+    if (ctx->m_sharedStack)
+    {
+        AdoptSharedStack(ctx);
+    }
 
     auto ret = ContextSwitch(&prev->m_sp, ctx->m_sp, static_cast<int>(SchedulerJumpResult::RESUMED));
     assert(static_cast<SchedulerJumpResult>(ret) == SchedulerJumpResult::RESUMED);
 }
 
-void Cooperator::WakeWaiter(Coordinated* waiter, const bool schedule)
+void Cooperator::WakeWaiter(Coordinated* waiter, const bool schedule,
+                            Coordinator const* coordinator /* = nullptr */)
 {
     waiter->Satisfy();
 
@@ -844,6 +1506,10 @@ void Cooperator::WakeWaiter(Coordinated* waiter, const bool schedule)
     }
     else
     {
+        if (perf::IsOffCpuProfiling()) [[unlikely]]
+        {
+            waiter->GetContext()->m_wokenBy = coordinator;
+        }
         Unblock(waiter->GetContext(), schedule);
     }
 }
@@ -910,20 +1576,64 @@ void Cooperator::DrainContinuationsPaced()
 void Cooperator::ServiceExpiredTimers()
 {
     // Release every sleep whose deadline has passed. schedule=false moves each woken context to the
-    // yielded list rather than switching to it mid-loop. Reads the clock once, and only when there
-    // is something to service. Each released coordinator's waiter is the blocked sleeping context;
-    // the popped node is already unlinked, so the matching Sleeper destructor is a no-op.
+    // yielded list rather than switching to it mid-loop. Both call sites follow a Poll, so this is
+    // also where the loop refreshes time::NowCoarse: one clock read per iteration, shared with the
+    // service gate. Each released coordinator's waiter is the blocked sleeping context;
+    // the popped node is already unlinked, so the matching Sleeper destructor is a no-op. Nodes
+    // without a coordinator are coarse IO deadlines (see ExpireTimer).
     //
-    if (m_timers.Empty())
+    const int64_t now = m_coarseMicros = time::MonotonicMicros();
+    if (m_timers.Empty() && m_wheel.Empty())
     {
         return;
     }
 
-    const int64_t now = time::MonotonicMicros();
     while (auto* node = m_timers.PopExpired(now))
     {
-        node->GetCoordinator()->Release(nullptr, false /* schedule */);
+        ExpireTimer(node);
+    }
+    while (auto* node = m_wheel.PopExpired(now))
+    {
+        ExpireTimer(node);
+    }
+}
+
+void Cooperator::ExpireTimer(time::TimerNode* node)
+{
+    // A node without a coordinator is an io::Handle's coarse IO deadline, which cancels the
+    // operation rather than waking anyone directly
+    //
+    if (auto* coord = node->GetCoordinator())
+    {
+        coord->Release(nullptr, false /* schedule */);
+        return;
     }
+    io::Handle::OnDeadline(node);
+}
+
+void Cooperator::ReclaimEpoch(bool forced)
+{
+    // The budget bounds reclaim callbacks, not how far behind the queue is; whatever is left rides
+    // the next pass. Reclaim(maxEntries, maxNanos) walks the registry for SafeEpoch, so an empty
+    // queue returns before counting a pass at all.
+    //
+    const size_t pending = m_epochMgr.PendingCount();
+    if (pending == 0)
+    {
+        return;
+    }
+
+    COOP_PERF_INC(m_perf, perf::Counter::DrainCycles);
+    COOP_PERF_ADD(m_perf, perf::Counter::EpochBacklog, pending);
+    if (forced)
+    {
+        COOP_PERF_INC(m_perf, perf::Counter::EpochReclaimForced);
+    }
+
+    auto const& budget = m_config.epochReclaim;
+    size_t reclaimed = m_epochMgr.Reclaim(budget.maxEntries, budget.maxNanos);
+    COOP_PERF_ADD(m_perf, perf::Counter::DrainReclaimed, reclaimed);
+    (void)reclaimed;
 }
 
 void Cooperator::ArmTimerKernel(int64_t deadlineUs, bool update)
@@ -969,12 +1679,15 @@ void Cooperator::ArmNearestTimer()
     // is no later than the nearest queued deadline. Arming earlier than needed is a harmless spurious
     // wake that re-arms; arming later would let a sleep fire late, which the invariant forbids.
     //
-    if (m_timers.Empty())
+    // The wheel's next expiry may be the start of a slot on its way to cascading rather than a
+    // deadline, so this can arm early, never late.
+    //
+    if (m_timers.Empty() && m_wheel.Empty())
     {
         return;
     }
 
-    const int64_t nearest = m_timers.MinDeadlineUs();
+    const int64_t nearest = m_timers.Empty() ? m_wheel.NextExpiryUs() : m_timers.MinDeadlineUs();
     if (!m_timerArmed)
     {
         ArmTimerKernel(nearest, false /* update */);
@@ -988,6 +1701,17 @@ void Cooperator::ArmNearestTimer()
     }
 }
 
+void Cooperator::OnPeerWake()
+{
+    // A wake can trail the participation it was meant for (the peer read a stale sleeping flag), and
+    // a released doorbell is only a "do not sleep" latch, so a late or duplicate wake is harmless.
+    //
+    if (m_participation)
+    {
+        m_participation->doorbell.Release(nullptr, false /* schedule */);
+    }
+}
+
 void Cooperator::SanityCheck()
 {
     int yielded = 0;
@@ -1047,6 +1771,13 @@ extern "C" void CoopContextEntry(coop::Context* ctx)
     //
     coop::detail::ContextVarRegistry::Instance().DestructAll(ctx->m_segment.Bottom());
 
+    // Overflow chunks the context never freed were, like its segment heap, its until exit
+    //
+    if (ctx->m_bumpOverflow)
+    {
+        coop::detail::BumpReleaseOverflow(ctx);
+    }
+
     // Context destructor must run while we're still on this context's stack so that kill signals
     // can context-switch to waiters safely.
     //
@@ -1062,6 +1793,231 @@ extern "C" void CoopContextEntry(coop::Context* ctx)
 namespace coop
 {
 
+namespace
+{
+
+constexpr uint64_t kStackPaint = 0x5afec0de5afec0deULL;
+
+} // end anonymous namespace
+
+void Cooperator::PaintStack(Context* ctx)
+{
+    uintptr_t base = (reinterpret_cast<uintptr_t>(ctx->m_heapTop) + 7) & ~uintptr_t(7);
+    auto* p = reinterpret_cast<uint64_t*>(base);
+    auto* top = static_cast<uint64_t*>(ctx->m_segment.Top());
+    while (p < top)
+    {
+        *p++ = kStackPaint;
+    }
+    ctx->m_paintBase = reinterpret_cast<void*>(base);
+}
+
+// Runs on the exit path, after ~Context: like the segment size the pool is about to read, the
+// telemetry fields and name pointer are plain data still sitting in the dead segment.
+//
+void Cooperator::RecordStackDepth(Context* ctx)
+{
+    // Scan up from above the bump heap's highest watermark; the first overwritten word is the
+    // deepest the stack reached. Untouched words within it (the odd unwritten buffer) only make
+    // the estimate conservative by the amount of the gap below them.
+    //
+    uintptr_t from = reinterpret_cast<uintptr_t>(ctx->m_paintBase);
+    from = std::max(from, reinterpret_cast<uintptr_t>(ctx->m_heapTop));
+    from = std::max(from, reinterpret_cast<uintptr_t>(ctx->m_heapHigh));
+    auto* p = reinterpret_cast<uint64_t*>((from + 7) & ~uintptr_t(7));
+    auto* top = static_cast<uint64_t*>(ctx->m_segment.Top());
+    while (p < top && *p == kStackPaint)
+    {
+        p++;
+    }
+
+    const size_t size = ctx->m_segment.Size();
+    const size_t stackBytes = reinterpret_cast<uintptr_t>(top) - reinterpret_cast<uintptr_t>(p);
+    const size_t untouched = reinterpret_cast<uintptr_t>(p) - ((from + 7) & ~uintptr_t(7));
+    const size_t usedBytes = size - untouched;
+    const size_t heapBytes =
+        std::max(reinterpret_cast<uintptr_t>(ctx->m_heapTop),
+                 reinterpret_cast<uintptr_t>(ctx->m_heapHigh))
+        - reinterpret_cast<uintptr_t>(ctx->m_segment.Bottom());
+
+    auto& depth = m_stackDepths[ctx->GetName()];
+    depth.exits++;
+    depth.stackSize = std::max(depth.stackSize, size);
+    depth.maxStackBytes = std::max(depth.maxStackBytes, stackBytes);
+    depth.totalStackBytes += stackBytes;
+    depth.maxUsedBytes = std::max(depth.maxUsedBytes, usedBytes);
+    depth.maxHeapBytes = std::max(depth.maxHeapBytes, heapBytes);
+    depth.bumpOverflows += ctx->m_bumpOverflows;
+}
+
+bool Cooperator::MapSharedStack()
+{
+    if (m_sharedMapping)
+    {
+        return true;
+    }
+
+    static const size_t kPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t bytes = (m_config.sharedStackSize + kPageSize - 1) & ~(kPageSize - 1);
+    bytes += kPageSize;
+
+    void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+    mprotect(mapping, kPageSize, PROT_NONE);
+
+    m_sharedMapping = mapping;
+    m_sharedMappingBytes = bytes;
+    m_sharedTop = static_cast<char*>(mapping) + bytes;
+    return true;
+}
+
+void Cooperator::AdoptSharedStack(Context* ctx)
+{
+    assert(ctx->m_sharedStack == m_sharedTop);
+    if (m_sharedHolder == ctx)
+    {
+        return;
+    }
+
+    // Copying over the stack we are running on would be the end of us
+    //
+    auto* top = static_cast<char*>(m_sharedTop);
+    assert(static_cast<char*>(__builtin_frame_address(0)) < static_cast<char*>(m_sharedMapping)
+           || static_cast<char*>(__builtin_frame_address(0)) >= top);
+    if (auto* holder = m_sharedHolder)
+    {
+        size_t bytes = top - static_cast<char*>(holder->m_sp);
+        void* saved = bytes <= SizeClassAllocator::kMaxClass ? m_allocator.Allocate(bytes)
+                                                              : malloc(bytes);
+        if (!saved)
+        {
+            std::abort();                   // the frames have nowhere else to go
+        }
+        memcpy(saved, holder->m_sp, bytes);
+        holder->m_savedStack = saved;
+        holder->m_savedBytes = bytes;
+
+        m_sharedStats.saves++;
+        m_sharedStats.bytesCopied += bytes;
+        m_sharedStats.savedBytes += bytes;
+        m_sharedStats.savedContexts++;
+    }
+
+    m_sharedHolder = ctx;
+    if (ctx->m_savedStack)
+    {
+        size_t bytes = ctx->m_savedBytes;
+        assert(static_cast<size_t>(top - static_cast<char*>(ctx->m_sp)) == bytes);
+        memcpy(ctx->m_sp, ctx->m_savedStack, bytes);
+        if (bytes <= SizeClassAllocator::kMaxClass)
+        {
+            SizeClassAllocator::Release(ctx->m_savedStack, bytes);
+        }
+        else
+        {
+            free(ctx->m_savedStack);
+        }
+        ctx->m_savedStack = nullptr;
+        ctx->m_savedBytes = 0;
+
+        m_sharedStats.restores++;
+        m_sharedStats.bytesCopied += bytes;
+        m_sharedStats.savedBytes -= bytes;
+        m_sharedStats.savedContexts--;
+    }
+}
+
+void Cooperator::ChargePmuSlow(Context* ctx)
+{
+    perf::PmuSample now;
+    m_pmu.Read(now);
+    auto delta = [&](perf::PmuEvent event) { return now[event] - m_pmuLast[event]; };
+
+    if (ctx)
+    {
+        auto& s = ctx->m_statistics;
+        s.pmuCycles += delta(perf::PmuEvent::Cycles);
+        s.pmuInstructions += delta(perf::PmuEvent::Instructions);
+        s.pmuLlcMisses += delta(perf::PmuEvent::LlcMisses);
+        s.pmuBranchMisses += delta(perf::PmuEvent::BranchMisses);
+    }
+    else
+    {
+        m_loopPmu.cycles += delta(perf::PmuEvent::Cycles);
+        m_loopPmu.instructions += delta(perf::PmuEvent::Instructions);
+        m_loopPmu.llcMisses += delta(perf::PmuEvent::LlcMisses);
+        m_loopPmu.branchMisses += delta(perf::PmuEvent::BranchMisses);
+    }
+    m_pmuLast = now;
+}
+
+void Cooperator::AddPmu(ContextPmu& to, Context const* ctx)
+{
+    to.cycles += ctx->m_statistics.pmuCycles;
+    to.instructions += ctx->m_statistics.pmuInstructions;
+    to.llcMisses += ctx->m_statistics.pmuLlcMisses;
+    to.branchMisses += ctx->m_statistics.pmuBranchMisses;
+}
+
+// On the exit path, like RecordStackDepth: the statistics and name are still readable in the dead
+// segment
+//
+void Cooperator::RecordContextPmu(Context* ctx)
+{
+    const char* name = ctx->GetName();
+    auto it = m_pmuByName.find(std::string_view(name));
+    if (it == m_pmuByName.end())
+    {
+        it = m_pmuByName.try_emplace(name).first;
+    }
+    it->second.exits++;
+    AddPmu(it->second, ctx);
+}
+
+void Cooperator::RecordSchedulingDelaySlow(Context* ctx)
+{
+    const int64_t delay = rdtsc() - ctx->m_readyTsc;
+    const uint64_t ticks = delay > 0 ? static_cast<uint64_t>(delay) : 0;
+    m_schedulingDelay.Record(ticks);
+
+    if (m_config.schedulingDelayByName)
+    {
+        // Heterogeneous lookup: only a name's first delay copies it into a key
+        //
+        const char* name = ctx->GetName();
+        auto it = m_schedulingDelays.find(std::string_view(name));
+        if (it == m_schedulingDelays.end())
+        {
+            it = m_schedulingDelays.try_emplace(name).first;
+        }
+        it->second.Record(ticks);
+    }
+}
+
+void Cooperator::ChargeSlice(Context* next)
+{
+    // The loop's own time between a context stopping and the next resume is charged to no one
+    //
+    const int64_t now = rdtsc();
+    if (m_charged)
+    {
+        m_yielded.Charge(m_charged, now - m_chargeTsc, now);
+    }
+    m_charged = next;
+    m_chargeTsc = now;
+}
+
+double Cooperator::NanosPerTick() const
+{
+    const int64_t ticks = rdtsc() - m_tscOrigin;
+    const int64_t nanos = time::MonotonicNanos() - m_nsOrigin;
+    return ticks > 0 && nanos > 0 ? static_cast<double>(nanos) / static_cast<double>(ticks) : 0.0;
+}
+
 void Cooperator::EnterContext(Context* ctx)
 {
     COOP_PERF_INC(m_perf, perf::Counter::ContextSpawn);
@@ -1071,6 +2027,18 @@ void Cooperator::EnterContext(Context* ctx)
     void** save_sp = lastCtx ? &lastCtx->m_sp : &m_sp;
     bool isSelf = !lastCtx;
 
+    // A shared context spawning another cannot lay the child out under its own frames: it parks
+    // through the loop, which starts the child from off the shared stack (see ResumeOne)
+    //
+    if (NeedsHandoff(lastCtx, ctx))
+    {
+        assert(!m_handoff);
+        m_handoff = ctx;
+        auto ret = ContextSwitch(save_sp, m_sp, static_cast<int>(SchedulerJumpResult::YIELDED));
+        assert(static_cast<SchedulerJumpResult>(ret) == SchedulerJumpResult::RESUMED);
+        return;
+    }
+
     if (lastCtx)
     {
         if (m_config.trackContextCycles)
@@ -1085,10 +2053,13 @@ void Cooperator::EnterContext(Context* ctx)
     {
         m_ticks += now - m_lastRdtsc;
     }
+    ChargePmu(lastCtx);
 
     ctx->m_state = SchedulerState::RUNNING;
     m_scheduled = ctx;
     ctx->m_lastRdtsc = now;
+    COOP_PERF_RECORD_SINCE(m_histograms, perf::Hist::RunSlice, m_sliceNs);
+    COOP_PERF_STAMP(perf::Hist::RunSlice, m_sliceNs);
 
 #ifndef NDEBUG
     SanityCheck();
@@ -1096,12 +2067,21 @@ void Cooperator::EnterContext(Context* ctx)
 
     // Prepare the new context's stack for first entry via ContextSwitch
     //
-    void* init_sp = ContextInit(ctx->m_segment.Top(), ctx);
+    if (ctx->m_sharedStack)
+    {
+        AdoptSharedStack(ctx);
+    }
+    void* init_sp = ContextInit(ctx->StackTop(), ctx);
+    AdvanceSlice(isSelf ? 1 : 2, m_scheduled);
     auto ret = ContextSwitch(save_sp, init_sp, 0);
 
     if (isSelf)
     {
         HandleCooperatorResumption(static_cast<SchedulerJumpResult>(ret));
+        if (m_handoff)
+        {
+            Resume(std::exchange(m_handoff, nullptr));
+        }
     }
     else
     {
@@ -1234,24 +2214,7 @@ void Cooperator::PrintContextTree(Context* ctx /* = nullptr */, int indent /* =
 
 int64_t Cooperator::rdtsc() const
 {
-#if defined(__x86_64__)
-    uint32_t hi, lo;
-// cpuid forces a partial barrier preventing reordering, but we don't use rdtsc in a way that
-// remotely cares about that.
-//
-#ifdef __NEVER__
-    __asm__ __volatile__(
-       "xorl %%eax,%%eax \n        cpuid" ::: "%rax", "%rcx", "%rdx");
-#endif
-    __asm__ __volatile__("rdtsc" : "=a"(lo),"=d"(hi));
-    return static_cast<int64_t>((uint64_t)hi << 32 | lo);
-#elif defined(__aarch64__)
-    uint64_t val;
-    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(val));
-    return static_cast<int64_t>(val);
-#else
-#error "Unsupported architecture for rdtsc"
-#endif
+    return detail::ReadTsc();
 }
 
 thread_local Cooperator* Cooperator::thread_cooperator;
@@ -3,22 +3,39 @@
 #include <atomic>
 #include <cassert>
 #include <linux/time_types.h>
+#include <map>
 #include <mutex>
+#include <optional>
+#include <pthread.h>
 #include <semaphore>
+#include <string>
 
+#include "detail/cooperator_registry.h"
 #include "detail/embedded_list.h"
 #include "detail/memory_order.h"
+#include "detail/ring_message.h"
+#include "detail/run_queue.h"
+#include "detail/submission_slab.h"
 #include "context.h"
 #include "continuation_pool.h"
 #include "coordinator.h"
+#include "drain.h"
+#include "memory_pressure.h"
+#include "epoch/domain.h"
 #include "epoch/epoch.h"
 #include "cooperator_configuration.h"
 #include "cooperator_var.h"
 #include "spawn_configuration.h"
+#include "size_class_allocator.h"
 #include "stack_pool.h"
+#include "status_snapshot.h"
 #include "perf/counters.h"
+#include "perf/histogram.h"
+#include "perf/pmu.h"
 #include "io/uring.h"
+#include "time/now.h"
 #include "time/timer_queue.h"
+#include "time/timer_wheel.h"
 #include "topology.h"
 
 extern "C" void CoopContextEntry(coop::Context* ctx);
@@ -33,20 +50,19 @@ enum class SchedulerJumpResult
     YIELDED,
     BLOCKED,
     RESUMED,
+    MIGRATED,
 };
 
 struct Launchable;
 struct CooperateHandle;
+template<typename T> struct SpawnTemplate;
 
 namespace work { struct Participation; }
 
-static constexpr int COOPERATOR_LIST_REGISTRY = 0;
-
 // A Cooperator manages multiple contexts
 //
-struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTRY>
+struct Cooperator
 {
-    using RegistryList = EmbeddedList<Cooperator, int, COOPERATOR_LIST_REGISTRY>;
     thread_local static Cooperator* thread_cooperator;
 
     static constexpr size_t LOCAL_STORAGE_SIZE = 4096;
@@ -126,7 +142,8 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
                    SpawnConfiguration const& config = s_defaultConfiguration);
 
     // Submit queues work from an external thread onto this cooperator. The cooperator wakes via
-    // eventfd and spawns a context to execute the lambda. Fire-and-forget — the lambda is
+    // eventfd -- or, submitted from another cooperator, a MSG_RING doorbell on its ring (see
+    // PostMessage) -- and spawns a context to execute the lambda. Fire-and-forget — the lambda is
     // heap-allocated and freed after execution. Returns false if the cooperator is shutting down.
     //
     template<typename Fn>
@@ -155,6 +172,11 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
     //
     void YieldFrom(Context* ctx);
 
+    // The other half of `YieldTo()`: switch into target if it is runnable here and the
+    // direct-yield budget allows, else yield as YieldFrom does
+    //
+    void YieldTo(Context* ctx, Context* target);
+
     void Block(Context* ctx);
 
     void Unblock(Context* ctx, const bool schedule);
@@ -162,9 +184,11 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
     // Shared wake dispatch for a Coordinated waiter, used by every site that wakes one
     // (Coordinator::Release, Signal::Notify): a continuation waiter is queued to fire from the
     // loop's drain (DrainContinuationsPaced); a context waiter is Unblock'd. Routing all wakes here is
-    // what makes continuations work with any coordinator-backed primitive, not just one.
+    // what makes continuations work with any coordinator-backed primitive, not just one. The
+    // coordinator doing the waking, if any, is what the off-CPU profiler attributes the wait to.
     //
-    void WakeWaiter(Coordinated* waiter, const bool schedule);
+    void WakeWaiter(Coordinated* waiter, const bool schedule,
+                    Coordinator const* coordinator = nullptr);
 
     // Run *all* queued continuations to completion as function calls (no context switch), leaving
     // the pending list empty on return. Iterative, so a continuation that queues another is
@@ -206,6 +230,11 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
         m_continuationPool.Free(p, n);
     }
 
+    // The application-facing object allocator (coop::Pool, coop::PoolAllocator): this
+    // cooperator's size-classed slabs, allocated from on this thread only
+    //
+    SizeClassAllocator& GetAllocator() { return m_allocator; }
+
 #ifndef NDEBUG
     // Debug-only: set (via detail::ThunkScope) while a Thunk -- a Continuation or an Erg -- runs, so
     // that suspending operations can assert at the misuse site. Compiled out in release. See thunk.h.
@@ -219,6 +248,11 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
     //
     work::Participation* m_participation = nullptr;
 
+    // time::NowCoarse's reading, taken at launch and once per scheduler loop iteration, after the
+    // Poll (ServiceExpiredTimers)
+    //
+    int64_t m_coarseMicros = 0;
+
     // Continuation-drain pacing. The drain otherwise runs the pending list strictly to empty before
     // the scheduler loop returns to its top -- and therefore to the next io_uring Poll. That is
     // ideal for the usual IO-paced chain (each stage waits on a CQE, so the list empties naturally)
@@ -265,23 +299,88 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
         return m_shutdown.load(detail::kLoadFlag);
     }
 
+    // Shut down gracefully (drain.h): tell this cooperator's DrainHooks to stop taking new work,
+    // wait up to grace for its DrainHolds to go, then Shutdown. Callable from any thread; the drain
+    // runs as a context submitted here, so it returns false, doing nothing, when the cooperator is
+    // already shutting down. A second Drain while one runs is a no-op; Shutdown cuts one short.
+    //
+    bool Drain(time::Interval grace);
+
+    // Drain every live cooperator, closing the registry as ShutdownAll does: one launched after
+    // this shuts down at once
+    //
+    static void DrainAll(time::Interval grace);
+
+    // How this cooperator's shutdown went: when the kill sweep started, how long it took to reach
+    // every live context and how long until the loop exited with nothing left in flight, and what
+    // it did meanwhile (CooperatorConfiguration::shutdownKillBatch, shutdownBulkCancel). Written
+    // on the cooperator's thread and readable cross-thread like the stack pool's stats; final once
+    // the thread has exited.
+    //
+    struct ShutdownStats
+    {
+        int64_t  startNs;       // monotonic; 0 until the sweep starts
+        int64_t  killNs;        // from the start until the last kill
+        int64_t  drainNs;       // from the start until the loop exited
+        uint64_t killed;        // contexts the sweep killed
+        uint64_t passes;        // walks of the context list, the last of which killed nothing
+        uint64_t batches;       // yields to the loop between kills
+        uint64_t bulkCancelled; // operations the bulk cancel took
+        uint64_t cqOverflows;   // Polls that found the CQ overflowed, from the start until exit
+    };
+
+    ShutdownStats GetShutdownStats() const { return m_shutdownStats; }
+
+    // Whether a drain has started. From any thread.
+    //
+    bool IsDraining() const
+    {
+        return m_draining.load(detail::kLoadFlag);
+    }
+
     io::Uring* GetUring()
     {
         return &m_uring;
     }
 
+    // The dedicated storage ring (CooperatorConfiguration::storage), or nullptr when none is
+    // configured
+    //
+    io::Uring* GetStorageUring()
+    {
+        return m_storage ? &*m_storage : nullptr;
+    }
+
+    // Post message onto this cooperator's ring from another cooperator's thread (IORING_OP_MSG_RING
+    // on the caller's ring, flushed at its next Poll). False -- post some other way -- off a
+    // cooperator, onto the caller's own cooperator, when either kernel ring lacks MSG_RING, or
+    // before this cooperator's ring is up and after its loop has exited.
+    //
+    bool PostMessage(detail::RingMessage* message);
+
     // Per-cooperator timer queue (docs/timer_wheel_001.md). A Sleeper registers its absolute
     // deadline and the coordinator to Release on expiry, instead of arming its own kernel timer; the
     // scheduler services the queue and keeps a single IORING_OP_TIMEOUT armed for the nearest
-    // deadline. Both run on this cooperator's thread only — no synchronization.
+    // deadline. Both run on this cooperator's thread only — no synchronization. TimerMode::Wheel
+    // keeps the deadlines in the timing wheel rather than the heap.
     //
     void RegisterTimer(time::TimerNode* node, int64_t deadlineUs, Coordinator* coord)
     {
+        if (m_config.timerMode == TimerMode::Wheel)
+        {
+            m_wheel.Insert(node, deadlineUs, coord);
+            return;
+        }
         m_timers.Insert(node, deadlineUs, coord);
     }
 
     void CancelTimer(time::TimerNode* node)
     {
+        if (m_config.timerMode == TimerMode::Wheel)
+        {
+            m_wheel.Remove(node);
+            return;
+        }
         m_timers.Remove(node);
     }
 
@@ -291,17 +390,205 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
     //
     void OnTimerExpired() { m_timerArmed = false; }
 
-    // Whether pure-timer deadlines on this cooperator use the userspace queue (one kernel timer for
-    // the nearest deadline) or the default kernel-per-timer path. Selected by
-    // CooperatorConfiguration::timerMode. Read by Sleeper to choose its backing.
+    // A peer cooperator rang this one's work::Grid doorbell across threads (detail::kWakeTag CQE,
+    // see work::Grid). Releases the local stealer's doorbell so it leaves its indefinite idle park.
+    //
+    void OnPeerWake();
+
+    // Whether pure-timer deadlines on this cooperator use a userspace structure (the heap or the
+    // wheel, with one kernel timer for the nearest deadline) or the default kernel-per-timer path.
+    // Selected by CooperatorConfiguration::timerMode. Read by Sleeper to choose its backing.
     //
-    bool UsesTimerQueue() const { return m_config.timerMode == TimerMode::UserspaceQueue; }
+    bool UsesTimerQueue() const { return m_config.timerMode != TimerMode::KernelPerTimer; }
 
     int CpuId() const { return m_cpuId; }
     int NumaNode() const { return m_numaNode; }
 
+    // When Launch had this cooperator ready for work -- pinned, its stacks prewarmed, its ring set
+    // up -- on the monotonic clock, or 0 while it is still getting there; StartupNanos is how long
+    // that took. A Launch that finds the registry closed reports too, having given up. Readable
+    // from any thread, and WaitReady blocks until it is set.
+    //
+    int64_t ReadyNanos() const { return m_readyNs.load(std::memory_order_acquire); }
+
+    int64_t StartupNanos() const
+    {
+        int64_t ready = ReadyNanos();
+        return ready ? ready - m_launchNs : 0;
+    }
+
+    void WaitReady() const
+    {
+        while (m_readyNs.load(std::memory_order_acquire) == 0)
+        {
+            m_readyNs.wait(0, std::memory_order_acquire);
+        }
+    }
+
+    // For the stall watchdog (perf/watchdog.h), which reads them from its own thread. The slice
+    // epoch advances at every context switch and is odd while a context runs, so an odd epoch
+    // that holds still is one slice running on. Thread is the cooperator's thread, valid while it
+    // is registered; Stalls counts the slices the watchdog reported.
+    //
+    uint64_t SliceEpoch() const { return m_sliceEpoch.load(std::memory_order_relaxed); }
+    pthread_t Thread() const { return m_thread; }
+    uint64_t Stalls() const { return m_stalls.load(std::memory_order_relaxed); }
+    void CountStall() { m_stalls.fetch_add(1, std::memory_order_relaxed); }
+
+    // For the preemption ticker (preempt.h), on the same footing: it stores the epoch of a slice
+    // that ran past CooperatorConfiguration::timeSliceUs, and the slice has expired while the
+    // epoch still matches. The next switch moves the epoch on, so nothing needs clearing.
+    // Preemptions counts the MaybeYield calls that yielded.
+    //
+    uint32_t TimeSliceUs() const { return m_config.timeSliceUs; }
+    void ExpireSlice(uint64_t epoch) { m_preemptEpoch.store(epoch, std::memory_order_relaxed); }
+    bool SliceExpired() const
+    {
+        return m_preemptEpoch.load(std::memory_order_relaxed)
+            == m_sliceEpoch.load(std::memory_order_relaxed);
+    }
+    uint64_t Preemptions() const { return m_preemptions.load(std::memory_order_relaxed); }
+    void CountPreemption() { m_preemptions.fetch_add(1, std::memory_order_relaxed); }
+
     perf::Counters& GetPerfCounters() { return m_perf; }
 
+    // Occupancy of the cooperator's stack cache. Like the counters, readable cross-thread for
+    // observability: each field is a plain word the owning thread updates.
+    //
+    StackPool::Stats GetStackPoolStats() const { return m_stackPool.GetStats(); }
+
+    // Free up to batch cached stacks and continuation blocks above their pressure floors (see
+    // memory_pressure.h). Owning thread only. Returns how many were freed, 0 once all are at
+    // their floors.
+    //
+    size_t Relieve(size_t batch);
+
+    // Shared-stack mode (shared_stack.h): how often the shared stack changed hands and what the
+    // contexts parked off it hold. Owning thread, or cross-thread for observability like the
+    // stack pool's.
+    //
+    struct SharedStackStats
+    {
+        uint64_t saves;         // a holder's live frames copied out
+        uint64_t restores;      // copied back in
+        uint64_t bytesCopied;   // both ways
+        uint64_t savedBytes;    // held in buffers now
+        uint64_t savedContexts; // holding one now
+    };
+
+    SharedStackStats GetSharedStackStats() const { return m_sharedStats; }
+
+    // For memory accounting (memory_accounting.h): the shared stack's mapping, null until the
+    // first shared context is spawned, and the bytes the continuation pool caches. Owning thread.
+    //
+    void const* SharedStackMapping() const { return m_sharedMapping; }
+    size_t SharedStackMappedBytes() const { return m_sharedMappingBytes; }
+    size_t ContinuationPoolBytes() const { return m_continuationPool.RetainedBytes(); }
+
+    // Latency histograms (perf/histogram.h): written on this cooperator's thread only, and like
+    // the counters readable cross-thread for observability
+    //
+    perf::Histograms& GetPerfHistograms() { return m_histograms; }
+
+    // Stack-depth telemetry for one context name (CooperatorConfiguration::trackStackDepth).
+    // stackBytes is how far the stack grew down from the segment top; usedBytes also counts the
+    // launch data and bump heap at the bottom, so stackSize - maxUsedBytes is headroom no context
+    // of that name ever touched. heapBytes is the bump heap's high-water mark from the segment
+    // bottom (launch data included), and bumpOverflows the allocations the checked heap
+    // (CooperatorConfiguration::bumpReserve) sent to overflow chunks instead.
+    //
+    struct StackDepth
+    {
+        uint64_t exits           = 0;
+        size_t   stackSize       = 0;   // largest segment seen for the name
+        size_t   maxStackBytes   = 0;
+        uint64_t totalStackBytes = 0;
+        size_t   maxUsedBytes    = 0;
+        size_t   maxHeapBytes    = 0;
+        uint64_t bumpOverflows   = 0;
+    };
+
+    bool TracksStackDepth() const { return m_config.trackStackDepth; }
+
+    // Scheduling delay (CooperatorConfiguration::trackSchedulingDelay): how long contexts sat
+    // runnable before being resumed, in ReadTsc ticks; NanosPerTick converts. Cooperator thread
+    // only, like the per-name visit.
+    //
+    bool TracksSchedulingDelay() const { return m_config.trackSchedulingDelay; }
+
+    bool TracksContextIo() const { return m_config.trackContextIo; }
+    perf::Histogram const& GetSchedulingDelay() const { return m_schedulingDelay; }
+
+    // fn(const char* name, perf::Histogram const&), in name order; empty unless
+    // schedulingDelayByName is set
+    //
+    template<typename Fn>
+    void VisitSchedulingDelays(Fn const& fn) const
+    {
+        for (auto const& [name, histogram] : m_schedulingDelays)
+        {
+            fn(name.c_str(), histogram);
+        }
+    }
+
+    // The tick rate, measured against CLOCK_MONOTONIC over the cooperator's life so far
+    //
+    double NanosPerTick() const;
+
+    // Visit the per-name aggregates, in name order: fn(const char* name, StackDepth const&).
+    // Cooperator thread only.
+    //
+    template<typename Fn>
+    void VisitStackDepths(Fn const& fn) const
+    {
+        for (auto const& [name, depth] : m_stackDepths)
+        {
+            fn(name.c_str(), depth);
+        }
+    }
+
+    // Hardware counters (CooperatorConfiguration::trackContextPmu) summed over one context name:
+    // contexts that exited, plus those live when visited. The loop's own share (polling,
+    // continuations, drains) is GetLoopPmu.
+    //
+    struct ContextPmu
+    {
+        uint64_t exits         = 0;
+        uint64_t live          = 0;
+        uint64_t cycles        = 0;
+        uint64_t instructions  = 0;
+        uint64_t llcMisses     = 0;
+        uint64_t branchMisses  = 0;
+    };
+
+    // Whether the PMU group is open and being charged; PmuError is the negative errno when
+    // trackContextPmu is set and the open failed, else 0
+    //
+    bool TracksContextPmu() const { return m_pmu.IsOpen(); }
+    bool PmuUsesRdpmc() const { return m_pmu.UsesRdpmc(); }
+    int PmuError() const { return m_pmuError; }
+    ContextPmu const& GetLoopPmu() const { return m_loopPmu; }
+
+    // fn(const char* name, ContextPmu const&), in name order. Cooperator thread only: it walks the
+    // live contexts.
+    //
+    template<typename Fn>
+    void VisitContextPmu(Fn const& fn)
+    {
+        std::map<std::string, ContextPmu, std::less<>> byName = m_pmuByName;
+        VisitContexts([&](Context* ctx) -> bool
+        {
+            auto& pmu = byName[ctx->GetName()];
+            pmu.live++;
+            AddPmu(pmu, ctx);
+            return true;
+        });
+        for (auto const& [name, pmu] : byName)
+        {
+            fn(name.c_str(), pmu);
+        }
+    }
+
     epoch::Manager& GetEpochManager() { return m_epochMgr; }
 
     // Read the epoch watermark. Safe to call cross-thread (atomic load).
@@ -313,16 +600,28 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
 
     const char* GetName() const { return m_name; }
 
-    // Visit all registered cooperators under the registry lock. The callback receives each
-    // cooperator pointer. Return false from the callback to stop iteration early.
+    // Visit all registered cooperators, from any thread, without a lock (see
+    // detail::CooperatorRegistry). A cooperator visited cannot finish exiting until the visit
+    // returns, so the callback may read its cross-thread state. Return false from the callback to
+    // stop iteration early.
     //
     template<typename Fn>
     static void VisitRegistry(Fn const& fn)
     {
-        std::lock_guard<std::mutex> lock(s_registryMutex);
         s_registry.Visit(fn);
     }
 
+    // The latest snapshot of this cooperator's context tree and counters
+    // (CooperatorConfiguration::statusSnapshot), from any thread while it is registered -- from a
+    // VisitRegistry callback, say. False when snapshots are off or none is published yet.
+    //
+    bool ReadStatusSnapshot(CooperatorSnapshot& out) const
+    {
+        return m_statusSlot && m_statusSlot->Read(out);
+    }
+
+    bool PublishesStatus() const { return m_statusSlot != nullptr; }
+
     size_t ContextsCount() const
     {
         return m_contexts.Size();
@@ -338,6 +637,16 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
         return m_blocked.Size();
     }
 
+    // Runnable contexts plus in-flight io_uring ops, as the scheduler loop last published it: at
+    // the top of every iteration and before it sleeps, so an idle cooperator reads low. An idle one
+    // still counts its own standing ops (the submission drainer's read, among others). From any
+    // thread; for placement (CooperatorGroup::SubmitAny), not accounting.
+    //
+    uint32_t Load() const
+    {
+        return m_publishedLoad.load(std::memory_order_relaxed);
+    }
+
     template<typename Fn>
     void VisitContexts(Fn const& fn) { m_contexts.Visit(fn); }
 
@@ -356,12 +665,13 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
     //
     struct SubmissionEntry
     {
-        SubmissionEntry* m_next{nullptr};
+        std::atomic<SubmissionEntry*> m_next{nullptr};
         void (*m_invoke)(SubmissionEntry*, Context*);
         void (*m_destroy)(SubmissionEntry*);
         SpawnConfiguration m_config;
         std::binary_semaphore* m_completion{nullptr};
         bool* m_completionOk{nullptr};
+        detail::SubmissionSlab* m_slab{nullptr};      // the slab whose slot holds the entry, if any
     };
 
   private:
@@ -373,12 +683,129 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
 
     void HandleCooperatorResumption(const SchedulerJumpResult res);
 
+    // The direct-yield fastpath's halves. TakeDirectYield runs the IO governor and spends one
+    // switch of the budget, false once it is spent; SwitchDirect parks the running context on the
+    // yielded list and switches into next, which the caller took off it.
+    //
+    bool TakeDirectYield();
+    void SwitchDirect(Context* ctx, Context* next);
+
+    // One resume from the loop; Resume runs it for ctx and then for any handoff it leaves
+    //
+    void ResumeOne(Context* ctx);
+
+    // Shared-stack mode (shared_stack.h). MapSharedStack maps the stack on first use, false if it
+    // cannot. AdoptSharedStack gives it to ctx before a switch into it -- saving the holder's live
+    // frames and restoring ctx's -- and must run off the shared stack. A switch between two shared
+    // contexts goes through the loop instead: the running one parks as usual and leaves the
+    // target in m_handoff, which Resume runs next, ahead of the run queue.
+    //
+    bool MapSharedStack();
+    void AdoptSharedStack(Context* ctx);
+
+    static bool NeedsHandoff(Context* from, Context* to)
+    {
+        return from && from->m_sharedStack && to->m_sharedStack;
+    }
+
+    // A shared context's heap runs to the top of its segment, which only the checked bump path
+    // bounds, so it always takes that path (see detail/bump.h)
+    //
+    uint32_t BumpReserveFor(SpawnConfiguration const& config) const
+    {
+        return config.sharedStack && !m_config.bumpReserve ? 1 : m_config.bumpReserve;
+    }
+
+    // Stack-depth telemetry: paint a freshly spawned segment above its launch data, and fold an
+    // exiting context's high-water mark into m_stackDepths.
+    //
+    void PaintStack(Context* ctx);
+    void RecordStackDepth(Context* ctx);
+
+    // Fold a context's time on the run queue into the scheduling-delay histograms, when it is
+    // resumed
+    //
+    void RecordSchedulingDelay(Context* ctx)
+    {
+        if (m_config.trackSchedulingDelay && ctx->m_readyTsc) [[unlikely]]
+        {
+            RecordSchedulingDelaySlow(ctx);
+        }
+    }
+    void RecordSchedulingDelaySlow(Context* ctx);
+
+    // trackContextPmu, at every switch: read the group and charge what it counted since the last
+    // switch to whoever was running -- ctx, or the loop itself when ctx is null
+    //
+    void ChargePmu(Context* ctx)
+    {
+        if (m_pmu.IsOpen()) [[unlikely]]
+        {
+            ChargePmuSlow(ctx);
+        }
+    }
+    void ChargePmuSlow(Context* ctx);
+    void RecordContextPmu(Context* ctx);
+    static void AddPmu(ContextPmu& to, Context const* ctx);
+
+    // Context migration (Context::MigrateTo). MigrateFrom switches the running context out to the
+    // loop, whose MIGRATED resumption hands it to m_migrateTarget via Adopt. Adopt is the inbound
+    // half, called from the source cooperator's thread: it queues the context on m_adopted for the
+    // next DrainSubmissions, or refuses once this cooperator has begun its shutdown sweep.
+    //
+    void MigrateFrom(Context* ctx, Cooperator* target);
+    bool Adopt(Context* ctx);
+
     // Timer-queue servicing and the single kernel timer. ServiceExpiredTimers releases every sleep
     // whose deadline has passed; ArmNearestTimer keeps one IORING_OP_TIMEOUT armed (or rescheduled
     // via IORING_TIMEOUT_UPDATE) for the nearest deadline before the loop blocks. See
     // docs/timer_wheel_001.md.
     //
     void ServiceExpiredTimers();
+    void ExpireTimer(time::TimerNode* node);
+
+    // Quiesce every epoch::Participant on this cooperator: the per-iteration point at which shared
+    // epoch domains advance and reclaim. Called alongside ServiceExpiredTimers.
+    //
+    void QuiesceEpochParticipants()
+    {
+        if (!m_epochParticipants.IsEmpty()) [[unlikely]]
+        {
+            m_epochParticipants.Visit([](epoch::Participant* participant) -> bool
+            {
+                participant->Quiesce();
+                return true;
+            });
+        }
+    }
+
+    // One budgeted pass over m_epochMgr's retire queue (CooperatorConfiguration::epochReclaim):
+    // forced at a batch boundary once the queue reaches the watermark, otherwise at the idle point
+    // before WaitAndPoll.
+    //
+    bool EpochReclaimEnabled() const { return m_config.epochReclaim.maxEntries > 0; }
+    bool EpochBacklogOverWatermark() const
+    {
+        return m_config.epochReclaim.watermark > 0
+            && m_epochMgr.PendingCount() >= m_config.epochReclaim.watermark;
+    }
+    void ReclaimEpoch(bool forced);
+
+    // Before sleeping in WaitAndPoll: let epoch::Holder pins go, so a cooperator idle in the kernel
+    // does not hold a shared domain's epoch back
+    //
+    void ParkEpochParticipants()
+    {
+        if (!m_epochParticipants.IsEmpty()) [[unlikely]]
+        {
+            m_epochParticipants.Visit([](epoch::Participant* participant) -> bool
+            {
+                participant->Park();
+                return true;
+            });
+        }
+    }
+
     void ArmNearestTimer();
     void ArmTimerKernel(int64_t deadlineUs, bool update);
 
@@ -387,64 +814,248 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
     int64_t m_lastRdtsc;
     int64_t m_ticks;
 
+    // Calibration origin for NanosPerTick, taken when the cooperator thread starts
+    //
+    int64_t m_tscOrigin{0};
+    int64_t m_nsOrigin{0};
+
+    // Launch's start, written before m_readyNs publishes it
+    //
+    void MarkReady();
+
+    int64_t              m_launchNs{0};
+    std::atomic<int64_t> m_readyNs{0};
+
     int m_cpuId{-1};
     int m_numaNode{-1};
+    pthread_t m_thread{};
+    std::atomic<uint64_t> m_stalls{0};
+    std::atomic<uint64_t> m_preemptions{0};
     CooperatorConfiguration m_config;
 
     std::atomic<bool> m_shutdown;
     Context*        m_scheduled;
 
+    // Drain state (drain.h). The hooks and hold count are cooperator-local; m_drainHeld is held
+    // while any hold is, for the drain context to wait on.
+    //
+    void RunDrain(Context* ctx, time::Interval grace);
+
+    std::atomic<bool>       m_draining{false};
+    EmbeddedList<DrainHook> m_drainHooks;
+    size_t                  m_drainHolds{0};
+    Coordinator             m_drainHeld;
+
+    // Application pools that Relieve trims after the built-in ones (memory_pressure.h)
+    //
+    EmbeddedList<PressureHook> m_pressureHooks;
+
+    // The shared stack's mapping (guard page included) and top, the context whose frames are on
+    // it, and the shared context a handoff is waiting to resume
+    //
+    void*            m_sharedMapping{nullptr};
+    size_t           m_sharedMappingBytes{0};
+    void*            m_sharedTop{nullptr};
+    Context*         m_sharedHolder{nullptr};
+    Context*         m_handoff{nullptr};
+    SharedStackStats m_sharedStats{};
+
+    // The shutdown sweep: kill every context in batches, then bulk cancel (see ShutdownStats)
+    //
+    void KillForShutdown(Context* killCtx);
+
+    ShutdownStats m_shutdownStats{};
+
     // Remaining direct yields before the next one falls back through the cooperator loop to poll
     // io_uring (see CooperatorConfiguration::directYield). Reset to directYieldBudget each time the
     // loop resumes a context; decremented by each direct yield. Unused when directYield is off.
     //
     int m_directYieldsRemaining{0};
 
+    // Target of the in-progress MigrateFrom, consumed by the MIGRATED resumption.
+    //
+    Cooperator* m_migrateTarget{nullptr};
+
     io::Uring       m_uring;
 
-    // Deadline-ordered queue of in-flight sleeps and the bookkeeping for the one kernel timer that
+    // The storage ring, set up on the cooperator thread when configured. An IOPOLL ring posts no
+    // completion on its own, so the loop polls it whenever StorageBusy().
+    //
+    std::optional<io::Uring> m_storage;
+
+    bool StorageBusy() const
+    {
+        return m_storage && m_storage->PendingOps() > 0;
+    }
+
+    // Deadline-ordered queue of in-flight sleeps (or, under TimerMode::Wheel, the wheel that holds
+    // them instead; the other stays empty) and the bookkeeping for the one kernel timer that
     // backs them. m_timerArmed says whether an IORING_OP_TIMEOUT is in flight; m_timerDeadlineUs is
     // the absolute deadline it is set to; m_timerTs backs the in-flight SQE's timespec (the kernel
     // copies it at submit, so a single member suffices). All cooperator-thread-local.
     //
     time::TimerQueue m_timers;
+    time::TimerWheel m_wheel{time::MonotonicMicros()};
     bool             m_timerArmed{false};
     int64_t          m_timerDeadlineUs{0};
     struct __kernel_timespec m_timerTs{};
 
     StackPool       m_stackPool;
+    std::map<std::string, StackDepth> m_stackDepths;
+    perf::PmuGroup  m_pmu;
+    perf::PmuSample m_pmuLast;
+    int             m_pmuError{0};
+    ContextPmu      m_loopPmu;
+    std::map<std::string, ContextPmu, std::less<>> m_pmuByName;
+    perf::Histogram m_schedulingDelay;
+    std::map<std::string, perf::Histogram, std::less<>> m_schedulingDelays;
     perf::Counters  m_perf;
+    perf::Histograms m_histograms;
+
+    // When the running context was switched in, for the RunSlice histogram; 0 when not timing
+    //
+    int64_t         m_sliceNs{0};
+
+    // CooperatorConfiguration::statusSnapshot: nullptr when off, and when the next publish is due
+    //
+    std::unique_ptr<StatusSlot> m_statusSlot;
+    int64_t         m_statusDueUs{0};
     char            m_name[COOPERATOR_NAME_MAX];
 
     // Cache-line partitioning of the Cooperator's hottest fields. m_sp is written on every
     // context switch (the scheduler saves its own stack pointer here before resuming a context).
-    // The submission quartet below is dirtied by external producer threads on every cross-thread
+    // The submission head below is dirtied by external producer threads on every cross-thread
     // Submit, and m_epochWatermark is read cross-thread by peers computing the reclamation
     // horizon. Left adjacent, a producer's Submit (or a peer's epoch-horizon read) would
     // invalidate the very line the owner needs for its next context switch — false sharing on the
     // single hottest write in the runtime. The alignas(64) markers isolate three distinct access
-    // groups onto their own lines: owner-hot (m_sp), cross-thread-inbound (the submission
-    // quartet), and cross-thread-published (m_epochWatermark). The effect grows on weak-memory
-    // architectures (aarch64), where remote-line acquisition is costlier than on x86 TSO.
+    // groups onto their own lines: owner-hot (m_sp), cross-thread-inbound (the submission head;
+    // the queue's consumer end has a line of its own), and cross-thread-published
+    // (m_epochWatermark). The effect grows on weak-memory architectures (aarch64), where
+    // remote-line acquisition is costlier than on x86 TSO.
     //
     alignas(64) void*       m_sp{nullptr};
 
+    // See SliceEpoch: written with m_sp, on the same line. The watchdog's read of it every few
+    // milliseconds costs the owner one line transfer per poll, not per switch.
+    //
+    std::atomic<uint64_t>   m_sliceEpoch{0};
+
+    // See SliceExpired: on the same line, so the check is one line the owner already holds. The
+    // ticker stores it at most once per overrun slice; the initial value is one no epoch reaches.
+    //
+    std::atomic<uint64_t>   m_preemptEpoch{~uint64_t(0)};
+
+    // See Load. Its own line, read by submitters on other threads; stored only when it changes.
+    //
+    alignas(64) std::atomic<uint32_t> m_publishedLoad{0};
+
+    // At batch boundaries and before sleeping: one pointer test while snapshots are off
+    //
+    void PublishStatus()
+    {
+        if (m_statusSlot) [[unlikely]]
+        {
+            int64_t now = time::NowCoarse();
+            if (now >= m_statusDueUs)
+            {
+                m_statusDueUs = now + m_config.statusSnapshot.intervalMicros;
+                m_statusSlot->Publish(this);
+            }
+        }
+    }
+
+    void PublishLoad()
+    {
+        uint32_t load = static_cast<uint32_t>(m_yielded.Size() + m_uring.PendingOps());
+        if (load != m_publishedLoad.load(std::memory_order_relaxed))
+        {
+            m_publishedLoad.store(load, std::memory_order_relaxed);
+        }
+    }
+
+    // Called at every switch: next is the context that runs now, nullptr when the loop does
+    //
+    void AdvanceSlice(uint64_t by, Context* next)
+    {
+        m_sliceEpoch.store(m_sliceEpoch.load(std::memory_order_relaxed) + by,
+                           std::memory_order_relaxed);
+        if (m_yielded.Charging()) [[unlikely]]
+        {
+            ChargeSlice(next);
+        }
+    }
+
+    // Fair-share accounting (scheduling_group.h): charge the slice m_charged just ran, and start
+    // timing next's
+    //
+    void ChargeSlice(Context* next);
+
+    template<typename Fn>
+    SubmissionEntry* NewSubmission(Fn&& fn, SpawnConfiguration const& config);
+
     void PushSubmission(SubmissionEntry* entry);
+    SubmissionEntry* PopSubmission();
     void WakeCooperator();
+    void WakeDrainer();
     void DrainSubmissions();
     void SpawnFromSubmission(SubmissionEntry* entry);
     void DrainRemainingSubmissions();
 
+    // The submission queue: an intrusive Vyukov MPSC list. A producer exchanges itself in as
+    // m_submitHead and then links its predecessor to it, with no lock for a convoy of producers
+    // to form on; the loop pops from m_submitTail. m_submitStub keeps the list non-empty, so a
+    // push never touches the consumer's end. Between a producer's exchange and its link the list
+    // reads as ending early -- the pop stops there, and that producer's wake comes after.
+    //
+    // m_hasSubmissions doubles as the wake coalescer: the producer that flips it false -> true
+    // wakes the loop, every later one finds it set and leaves the wake to the first. The drain
+    // clears it (an exchange, ordering the pushes it saw) before popping, so a push the pop misses
+    // flips it again.
+    //
     alignas(64) int         m_submitFd;
-    std::mutex              m_submissionLock;
-    SubmissionEntry*        m_submissionHead{nullptr};
-    SubmissionEntry*        m_submissionTail{nullptr};
+    std::atomic<SubmissionEntry*>       m_submitHead;
     std::atomic<bool>                   m_hasSubmissions{false};
 
+    // futexWake (see CooperatorConfiguration): the drainer's futex word, whether the drainer is
+    // still on it (cleared on a kernel without the opcode), and whether the loop is in, or about
+    // to enter, WaitAndPoll
+    //
+    std::atomic<uint32_t>               m_wakeWord{0};
+    std::atomic<bool>                   m_futexWake{false};
+    std::atomic<bool>                   m_loopParked{false};
+    alignas(64) SubmissionEntry*        m_submitTail;
+    SubmissionEntry                     m_submitStub{};
+
+    // Preallocated entries for Submit, so a producer does not pay a malloc (and the loop a
+    // cross-thread free) per submission
+    //
+    detail::SubmissionSlab              m_submitSlab;
+
+    // The doorbell another cooperator rings instead of the eventfd: a RingMessage whose delivery
+    // does nothing but wake the loop, which drains submissions after every Poll. m_acceptsMessages
+    // is set while the ring can take them (from Init until the loop exits).
+    //
+    struct Doorbell : detail::RingMessage
+    {
+        Cooperator* owner = nullptr;
+    };
+
+    Doorbell                            m_doorbell;
+    std::atomic<bool>                   m_acceptsMessages{false};
+
+    // Contexts migrating in from other cooperators (see Adopt), guarded by m_adoptLock and drained
+    // alongside the submission queue. m_adoptClosed is set, also under the lock, when the
+    // shutdown sweep starts so no context arrives after the sweep has run.
+    //
+    std::mutex                          m_adoptLock;
+    Context::ContextStateList           m_adopted;
+    bool                                m_adoptClosed{false};
+
     // Minimum pinned epoch across all contexts on this cooperator. Written by the cooperator
     // thread (via epoch::Manager::PublishWatermark) after each pin/unpin. Read cross-thread by
     // epoch::Manager::SafeEpoch() on other cooperators to compute the global reclamation horizon.
-    // On its own line so peers' horizon reads do not ping-pong the submission quartet.
+    // On its own line so peers' horizon reads do not ping-pong the submission head.
     //
     alignas(64) std::atomic<epoch::Epoch> m_epochWatermark{epoch::Epoch::Alive()};
 
@@ -454,6 +1065,11 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
     //
     epoch::Manager                      m_epochMgr;
 
+    // This cooperator's memberships in cross-cooperator epoch::Domains, pushed and removed by the
+    // Participant itself
+    //
+    epoch::Participant::CooperatorList  m_epochParticipants;
+
     // TODO this is a super dirty thing where the context removes itself from the
     // contexts list when it destructs.
     //
@@ -463,16 +1079,31 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
     //
     friend struct Context;
     friend struct epoch::Manager;
+    friend struct epoch::Participant;
+    friend struct DrainHook;
+    friend struct DrainHold;
+    friend struct PressureHook;
     friend void ::CoopContextEntry(::coop::Context*);
 
     template<typename T>
     friend struct CooperatorVar;
 
+    template<typename T>
+    friend struct SpawnTemplate;
+
+    // Launch through a SpawnTemplate's resolved layout (spawn_template.h)
+    //
+    template<typename T, typename... Args>
+    T* LaunchFrom(SpawnTemplate<T> const& site, Context::Handle* handle, Args&&... args);
+
     Context::AllContextsList    m_contexts;
-    Context::ContextStateList   m_yielded;
+    detail::RunQueue            m_yielded;
+    Context*                    m_charged{nullptr};     // see ChargeSlice
+    int64_t                     m_chargeTsc{0};
     Context::ContextStateList   m_blocked;
     Coordinated::List           m_pendingContinuations;
     ContinuationPool            m_continuationPool;
+    SizeClassAllocator          m_allocator;
     Context::ContextStateList   m_zombie;
 
     // Per-cooperator extensible storage for higher layers without
@@ -481,11 +1112,22 @@ struct Cooperator : EmbeddedListHookups<Cooperator, int, COOPERATOR_LIST_REGISTR
     //
     alignas(64) char m_localStorage[LOCAL_STORAGE_SIZE];
 
-    static std::atomic<bool> s_registryShutdown;
-    static std::mutex        s_registryMutex;
-    static RegistryList      s_registry;
+    static std::atomic<bool>            s_registryShutdown;
+    static std::mutex                   s_registryMutex;    // writers: launch, exit, ShutdownAll
+    static detail::CooperatorRegistry   s_registry;
 };
 
+namespace time
+{
+
+inline int64_t NowCoarse()
+{
+    Cooperator* co = Cooperator::thread_cooperator;
+    return co && co->m_coarseMicros ? co->m_coarseMicros : MonotonicMicros();
+}
+
+} // end namespace coop::time
+
 } // end namespace coop
 
 #include "cooperator.hpp"
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <new>
 #include <type_traits>
 
 #include "context.h"
@@ -51,7 +52,11 @@ bool Cooperator::Spawn(Fn const& fn, Context::Handle* handle /* = nullptr */)
     {
         SpawnConfiguration inherited = {
             .priority = m_scheduled->m_priority,
-            .stackSize = m_scheduled->m_segment.Size()
+            .stackSize = m_scheduled->m_sharedStack ? s_defaultConfiguration.stackSize
+                                                    : m_scheduled->m_segment.Size(),
+            .deadlineUs = m_scheduled->m_deadlineUs,
+            .group = m_scheduled->m_group,
+            .sharedStack = false,
         };
         return Spawn(inherited, fn, handle);
     }
@@ -65,9 +70,13 @@ bool Cooperator::Spawn(SpawnConfiguration const& config, Fn const& fn, Context::
     {
         return false;
     }
+    if (config.sharedStack && !MapSharedStack())
+    {
+        return false;
+    }
 
     SpawnConfiguration actual = config;
-    actual.stackSize = StackPool::RoundUpStackSize(config.stackSize);
+    actual.stackSize = m_stackPool.RoundUpStackSize(config.stackSize);
     assert(actual.stackSize >= sizeof(Context));
 
     auto* alloc = m_stackPool.Allocate(actual.stackSize);
@@ -77,6 +86,7 @@ bool Cooperator::Spawn(SpawnConfiguration const& config, Fn const& fn, Context::
     }
 
     auto* spawnCtx = new (alloc) Context(m_scheduled /* parent */, actual, handle, this);
+    spawnCtx->m_segment.m_backing = m_stackPool.Backing(actual.stackSize);
     m_contexts.Push(spawnCtx);
 
     size_t varSize = ContextVarTotalSize();
@@ -89,6 +99,11 @@ bool Cooperator::Spawn(SpawnConfiguration const& config, Fn const& fn, Context::
     uintptr_t heapStart = reinterpret_cast<uintptr_t>(launchBase) + sizeof(Fn);
     heapStart = (heapStart + 15) & ~uintptr_t(15);
     spawnCtx->m_heapTop = reinterpret_cast<void*>(heapStart);
+    spawnCtx->m_bumpReserve = BumpReserveFor(actual);
+    if (m_config.trackStackDepth && !actual.sharedStack)
+    {
+        PaintStack(spawnCtx);
+    }
 
     spawnCtx->m_entry = &SpawnTrampoline<Fn>;
     spawnCtx->m_cleanup = &LaunchCleanup<Fn>;
@@ -105,9 +120,13 @@ T* Cooperator::Launch(SpawnConfiguration const& config, Context::Handle* handle,
     {
         return nullptr;
     }
+    if (config.sharedStack && !MapSharedStack())
+    {
+        return nullptr;
+    }
 
     SpawnConfiguration actual = config;
-    actual.stackSize = StackPool::RoundUpStackSize(config.stackSize);
+    actual.stackSize = m_stackPool.RoundUpStackSize(config.stackSize);
     assert(actual.stackSize >= sizeof(Context));
 
     auto* alloc = m_stackPool.Allocate(actual.stackSize);
@@ -117,6 +136,7 @@ T* Cooperator::Launch(SpawnConfiguration const& config, Context::Handle* handle,
     }
 
     auto* spawnCtx = new (alloc) Context(m_scheduled /* parent */, actual, handle, this);
+    spawnCtx->m_segment.m_backing = m_stackPool.Backing(actual.stackSize);
     m_contexts.Push(spawnCtx);
 
     size_t varSize = ContextVarTotalSize();
@@ -132,6 +152,11 @@ T* Cooperator::Launch(SpawnConfiguration const& config, Context::Handle* handle,
     uintptr_t heapStart = reinterpret_cast<uintptr_t>(launchBase) + sizeof(T);
     heapStart = (heapStart + 15) & ~uintptr_t(15);
     spawnCtx->m_heapTop = reinterpret_cast<void*>(heapStart);
+    spawnCtx->m_bumpReserve = BumpReserveFor(actual);
+    if (m_config.trackStackDepth && !actual.sharedStack)
+    {
+        PaintStack(spawnCtx);
+    }
 
     spawnCtx->m_entry = &LaunchTrampoline<T>;
     spawnCtx->m_cleanup = &LaunchCleanup<T>;
@@ -139,8 +164,9 @@ T* Cooperator::Launch(SpawnConfiguration const& config, Context::Handle* handle,
     return launchable;
 }
 
-// Type-erased submission entry that owns a lambda of type Fn. Allocated on the heap by Submit,
-// freed after the cooperator spawns and executes the contained lambda.
+// Type-erased submission entry that owns a lambda of type Fn. Placed in a slot of the target's
+// SubmissionSlab when one is free and the entry fits, else on the heap; freed after the
+// cooperator spawns and executes the contained lambda.
 //
 template<typename Fn>
 struct TypedSubmission : Cooperator::SubmissionEntry
@@ -157,11 +183,33 @@ struct TypedSubmission : Cooperator::SubmissionEntry
         };
         m_destroy = [](SubmissionEntry* self)
         {
-            delete static_cast<TypedSubmission*>(self);
+            auto* typed = static_cast<TypedSubmission*>(self);
+            auto* slab = typed->m_slab;
+            if (!slab)
+            {
+                delete typed;
+                return;
+            }
+            typed->~TypedSubmission();
+            slab->Release(typed);
         };
     }
 };
 
+template<typename Fn>
+Cooperator::SubmissionEntry* Cooperator::NewSubmission(Fn&& fn, SpawnConfiguration const& config)
+{
+    using Entry = TypedSubmission<std::decay_t<Fn>>;
+    void* slot = m_submitSlab.Acquire(sizeof(Entry), alignof(Entry));
+    if (!slot)
+    {
+        return new Entry(std::forward<Fn>(fn), config);
+    }
+    auto* entry = new (slot) Entry(std::forward<Fn>(fn), config);
+    entry->m_slab = &m_submitSlab;
+    return entry;
+}
+
 template<typename Fn>
 bool Cooperator::Cooperate(Fn&& fn, CooperateHandle* handle,
                            SpawnConfiguration const& config)
@@ -186,8 +234,7 @@ bool Cooperator::Cooperate(Fn&& fn, CooperateHandle* handle,
     if (m_shutdown.load(std::memory_order_relaxed))
         return false;
 
-    using DecayFn = std::decay_t<Fn>;
-    auto* entry = new TypedSubmission<DecayFn>(std::forward<Fn>(fn), config);
+    auto* entry = NewSubmission(std::forward<Fn>(fn), config);
 
     if (handle)
     {
@@ -200,7 +247,6 @@ bool Cooperator::Cooperate(Fn&& fn, CooperateHandle* handle,
     }
 
     PushSubmission(entry);
-    WakeCooperator();
     return true;
 }
 
@@ -212,10 +258,7 @@ bool Cooperator::Submit(Fn&& fn, SpawnConfiguration const& config)
         return false;
     }
 
-    using DecayFn = std::decay_t<Fn>;
-    auto* entry = new TypedSubmission<DecayFn>(std::forward<Fn>(fn), config);
-    PushSubmission(entry);
-    WakeCooperator();
+    PushSubmission(NewSubmission(std::forward<Fn>(fn), config));
     return true;
 }
 
@@ -230,12 +273,10 @@ bool Cooperator::SubmitSync(Fn&& fn, SpawnConfiguration const& config)
     std::binary_semaphore done(0);
     bool completionOk = false;
 
-    using DecayFn = std::decay_t<Fn>;
-    auto* entry = new TypedSubmission<DecayFn>(std::forward<Fn>(fn), config);
+    auto* entry = NewSubmission(std::forward<Fn>(fn), config);
     entry->m_completion = &done;
     entry->m_completionOk = &completionOk;
     PushSubmission(entry);
-    WakeCooperator();
 
     done.acquire();
     return completionOk;
@@ -4,12 +4,23 @@
 #include <cstring>
 
 #include "io/uring_configuration.h"
+#include "stack_pool_configuration.h"
+#include "topology.h"
 
 namespace coop
 {
 
 static constexpr int COOPERATOR_NAME_MAX = 64;
 
+struct Context;
+struct Cooperator;
+
+// Picks the cooperator a context asking to Rebalance should move to, or nullptr to stay put. Called
+// on the context's current cooperator thread, so it may consult that cooperator's own state freely;
+// anything it reads about other cooperators is a cross-thread snapshot.
+//
+using MigrationPolicy = Cooperator* (*)(Context*);
+
 // How a cooperator backs the deadlines of pure timers (Sleep, the Grid stealer's recheck park; IO
 // operation timeouts are always exact and out of scope -- see docs/timer_wheel_001.md).
 //
@@ -22,6 +33,11 @@ static constexpr int COOPERATOR_NAME_MAX = 64;
 // churn at fan-out, but is the newer, less-proven-at-scale path, so it is opt-in and lands disabled
 // by default.
 //
+// Wheel is UserspaceQueue with a hierarchical timing wheel (time::TimerWheel) in place of the
+// pairing heap: insert and cancel are O(1) rather than an amortized O(log n) delete, at the price
+// of a few early kernel wakes as a far deadline cascades down the wheel. It is for the largest
+// counts -- hundreds of thousands of idle timers, nearly all cancelled -- and is opt-in too.
+//
 // No auto-switch is provided; the modes are explicit. Choosing between them: a high count of
 // concurrent timers whose timeouts are mostly NOT hit -- registered then cancelled before firing --
 // strongly favors UserspaceQueue, which pays only a cheap insert and cancel for a never-fired timer.
@@ -31,6 +47,63 @@ enum class TimerMode : uint8_t
 {
     KernelPerTimer,
     UserspaceQueue,
+    Wheel,
+};
+
+// How a cooperator orders its runnable contexts.
+//
+// Priority is the default: one FIFO list per SpawnConfiguration::priority class, highest class
+// first, with a starvation guard for the lower classes.
+//
+// EarliestDeadline additionally keeps every runnable context that carries a deadline
+// (SpawnConfiguration::deadlineUs / Context::SetDeadline) in an intrusive heap and resumes the
+// earliest deadline first, ahead of all deadline-less contexts, which keep their priority order.
+// Under overload EDF spends the cooperator on the requests that can still meet their SLO rather than
+// on whichever arrived first. The heap costs O(log n) per yield instead of O(1), so it is opt-in.
+//
+enum class SchedulingMode : uint8_t
+{
+    Priority,
+    EarliestDeadline,
+};
+
+// Scheduler-driven reclamation for the cooperator's own epoch::Manager. The manager is
+// policy-free, so an application calling Reclaim whenever it gets to it can free thousands of
+// retired objects in one go, inside a request. With maxEntries set, the cooperator does it instead,
+// in bounded passes at the points where it has nothing else to run: just before it sleeps in the
+// kernel, it reclaims up to maxEntries entries or maxNanos of work, whichever runs out first
+// (epoch::Manager::Reclaim(maxEntries, maxNanos)), and leaves the rest for its next sleep.
+//
+// A cooperator that never goes idle would never reclaim, so watermark adds a forced pass: while
+// the retire queue holds at least watermark entries, each batch boundary of the scheduler loop runs
+// one budgeted pass too. That one spends request time -- one budget per batch of up to 16 resumes
+// -- but only after the idle passes have fallen behind. 0 leaves reclamation to the idle passes.
+//
+// Lands off (maxEntries 0, which also ignores watermark): an application already reclaiming on
+// its own cadence keeps it.
+//
+struct EpochReclaimConfiguration
+{
+    uint32_t maxEntries = 0;
+    int64_t  maxNanos   = 50000;
+    size_t   watermark  = 0;
+};
+
+// Published status snapshots (status_snapshot.h). A cooperator's context tree is its own to walk,
+// so a status server on another cooperator cannot show it; with maxContexts set, the cooperator
+// records its tree and counters into a StatusSlot of that many contexts, and readers on any thread
+// copy the latest out of it (Cooperator::ReadStatusSnapshot). It publishes from its loop, at the
+// first batch boundary or sleep once intervalMicros have passed (against time::NowCoarse), so a
+// busy cooperator's snapshot lags by up to an interval, and a sleeping one's keeps its last
+// publish, which may miss up to an interval of activity before the sleep.
+//
+// Lands off (maxContexts 0): a walk of the whole tree per interval is paid only by whoever wants
+// the other cooperators' trees on the dashboard.
+//
+struct StatusSnapshotConfiguration
+{
+    uint32_t maxContexts    = 0;
+    int64_t  intervalMicros = 100000;
 };
 
 struct CooperatorConfiguration
@@ -55,8 +128,13 @@ struct CooperatorConfiguration
     //
     int cpuAffinity = -1;
 
+    // How an auto-assigned cooperator picks its core (see PlacementPolicy). The default keeps the
+    // round-robin order; SpreadPhysicalFirst and PackLLC avoid doubling up on an SMT core.
+    //
+    PlacementPolicy placement = PlacementPolicy::RoundRobin;
+
     // Backing strategy for pure-timer deadlines. Defaults to the proven kernel-per-timer path; the
-    // userspace deadline queue is opt-in (see TimerMode).
+    // userspace deadline queue and wheel are opt-in (see TimerMode).
     //
     TimerMode timerMode = TimerMode::KernelPerTimer;
 
@@ -69,6 +147,57 @@ struct CooperatorConfiguration
     //
     bool trackContextCycles = false;
 
+    // Per-spawn-site stack-depth telemetry. When set, every spawn paints its segment's free region
+    // with a known word, and every exit scans for the deepest word the context overwrote. The
+    // results are aggregated per context name (Context::SetName) and surfaced by /api/status as
+    // measurements for sizing SpawnConfiguration::stackSize. Painting touches the whole segment on
+    // every spawn, which costs a memset and defeats lazy commit of mapped stacks, so it is a
+    // measurement mode and lands off by default.
+    //
+    bool trackStackDepth = false;
+
+    // Scheduling-delay accounting. When set, every push onto the run queue (a yield, a release
+    // from blocked, a queued launch) stamps the cycle counter trackContextCycles reads, and the
+    // resume that takes the context off records the delta in a per-cooperator histogram
+    // (Cooperator::GetSchedulingDelay). A delay that grows while handler run time holds steady is
+    // an overloaded cooperator, not a slow handler. With schedulingDelayByName the delay is also
+    // aggregated per context name (Context::SetName), at the cost of a map lookup per resume.
+    // Unlike perf's RunQueueWait histogram it needs no perf build or family; it costs a counter
+    // read per push and per resume, so it lands off by default.
+    //
+    bool trackSchedulingDelay = false;
+    bool schedulingDelayByName = false;
+
+    // Per-context IO accounting. When set, every io::Handle submission from a context stamps the
+    // cycle counter, and its Finalize (the last CQE) charges the context's m_statistics: a read or
+    // write op, the bytes its result reports, and the ticks from submit to completion. The status
+    // server's context tree shows them, so a connection moving a disproportionate share of a
+    // cooperator's bytes, or waiting on most of its IO, can be found by name. It costs a counter
+    // read per submit and per completion, so it lands off by default.
+    //
+    bool trackContextIo = false;
+
+    // Per-context hardware counters (perf/pmu.h). When set, the cooperator opens a perf_event
+    // group on its thread -- cycles, instructions, LLC misses, branch misses, user space only --
+    // and reads it (rdpmc, where the kernel allows it) at every context switch, charging the
+    // deltas to the outgoing context's m_statistics. /api/status shows them per context and
+    // aggregated per context name, which gives IPC and miss rates per handler type without an
+    // external profiler. If the group cannot be opened (perf_event_paranoid, no PMU in a VM)
+    // nothing is charged and Cooperator::PmuError says why. Four counter reads per switch, so it
+    // lands off by default.
+    //
+    bool trackContextPmu = false;
+
+    // Checked bump heap. When nonzero, a bump allocation (Alloc<T>, AllocBuffer, Arena's region)
+    // that would leave fewer than this many bytes between the heap and the calling frame is served
+    // from an overflow chunk off the cooperator's SizeClassAllocator rather than carved toward the
+    // stack, and counted (perf BumpOverflow, StackDepth::bumpOverflows). That lets handlers run on
+    // segments sized for the common request, the odd large buffer spilling instead of colliding.
+    // It costs a frame-address compare per bump allocation, so it lands off (0, unchecked: only a
+    // debug assert guards the collision) by default.
+    //
+    uint32_t bumpReserve = 0;
+
     // Direct context-to-context yield. A plain Context::Yield normally trampolines through the
     // cooperator loop -- two switches plus the loop's bookkeeping -- which is also where io_uring
     // is polled. With this set, a yield that finds another runnable context switches straight into
@@ -104,17 +233,130 @@ struct CooperatorConfiguration
     // A wall-clock floor for the short-list/expensive-task case is still future work (#23).
     //
     int ioPresentLimit = 8;
+
+    // Starvation guard for the priority run queue (SpawnConfiguration::priority). Runnable contexts
+    // are served highest class first; a lower class that has been passed over this many consecutive
+    // times while runnable is served next, so background work still progresses under sustained
+    // high-priority load. 0 disables the guard (strict priority).
+    //
+    uint32_t priorityStarvationLimit = 8;
+
+    // Run-queue ordering policy (see SchedulingMode). The starvation guard above also applies to the
+    // deadline heap in EarliestDeadline mode, which ranks above every priority class.
+    //
+    SchedulingMode schedulingMode = SchedulingMode::Priority;
+
+    // Time slice for cooperative preemption checkpoints (coop::MaybeYield, preempt.h). When
+    // nonzero, a process-wide ticker thread marks a slice that has run this long as expired, and
+    // the next MaybeYield on it yields; ParallelFor checks it between chunks. The check itself is
+    // two relaxed loads of the cooperator's own line, no clock read, so long CPU-bound loops can
+    // afford one per iteration. 0 (the default) starts no ticker, and MaybeYield never yields.
+    //
+    uint32_t timeSliceUs = 0;
+
+    // Policy consulted by Context::Rebalance (see MigrationPolicy). nullptr, the default, never
+    // migrates; explicit Context::MigrateTo is unaffected.
+    //
+    MigrationPolicy migrationPolicy = nullptr;
+
+    // Stack size classes, per-class cache caps, prewarm counts and the idle trim policy for this
+    // cooperator's StackPool (see StackPoolConfiguration). Spawn sizes round up to these classes.
+    //
+    StackPoolConfiguration stackPool = s_defaultStackPoolConfiguration;
+
+    // Free blocks the ContinuationPool keeps per size class -- its ceiling -- and how many it
+    // keeps through memory pressure, its floor (see memory_pressure.h)
+    //
+    uint32_t continuationPoolCap = 256;
+    uint32_t continuationPoolFloor = 0;
+
+    // The one stack SpawnConfiguration::sharedStack contexts take turns on (see shared_stack.h),
+    // mapped with a guard page at the first such spawn. It bounds how deep a shared context's
+    // frames may go while it runs, not what it keeps while parked.
+    //
+    size_t sharedStackSize = 256 * 1024;
+
+    // Preallocated cross-thread submission entries (128 bytes each, so 32KB at the default). A
+    // Submit whose closure fits takes one instead of allocating; past this many in flight, or for
+    // a bigger closure, entries come from the heap. 0 allocates every entry.
+    //
+    uint32_t submissionSlots = 256;
+
+    // Cross-thread wake through a futex word instead of the eventfd. By default the producer whose
+    // Submit (or Cooperate, or migration) finds the queue empty writes the cooperator's eventfd,
+    // whether or not its loop is asleep. With this set, the submission drainer keeps a futex wait
+    // (io::FutexWait, kernel 6.7+) in flight on a per-cooperator word instead, the loop flags
+    // itself parked around its wait for CQEs, and a producer wakes the word -- one futex(2) --
+    // only when that flag is up; a busy loop picks the submission up on its next pass, so that
+    // producer makes no syscall at all. Lands off by default until proven on the kernels we ship.
+    //
+    bool futexWake = false;
+
+    // Budgeted reclamation of the cooperator's epoch::Manager at idle points, off by default (see
+    // EpochReclaimConfiguration).
+    //
+    EpochReclaimConfiguration epochReclaim = {};
+
+    // Snapshots of the context tree for observers on other threads, off by default (see
+    // StatusSnapshotConfiguration).
+    //
+    StatusSnapshotConfiguration statusSnapshot = {};
+
+    // Shutdown's kill sweep fires this many contexts' kill signals, then yields to the loop so they
+    // unwind -- and their Handles' cancels reach the ring and drain -- before it fires the next
+    // batch. The batch is also capped at a quarter of the completion ring, so a sweep over every
+    // context of a 100K-connection cooperator never has more cancels in flight than the CQ can
+    // take. 0 leaves only that cap.
+    //
+    uint32_t shutdownKillBatch = 1024;
+
+    // Once the sweep has killed every context, cancel what is still waiting on the ring with a
+    // handful of cancels by opcode (io::Uring::CancelWaiting) rather than one per Handle, taking
+    // the stragglers: waits that are not kill-aware, and operations whose Handles are not yet being
+    // destroyed. Needs kernel 6.6 (taken as 6.7, see SupportsCancelOp); a no-op before it. Lands
+    // off by default until proven on the kernels we ship.
+    //
+    bool shutdownBulkCancel = false;
+
+    // Dedicated storage ring, for O_DIRECT IO on NVMe. With storage.entries > 0 the cooperator
+    // sets up a second Uring from this configuration next to its own (IOPOLL by default, so
+    // completions are found by polling the device rather than by interrupt) and drives it from its
+    // loop: one polling enter per batch of resumes while storage IO is outstanding, and instead of
+    // sleeping in the kernel while it is, since an IOPOLL completion never wakes a wait.
+    // io::GetStorageUring() reaches it, and DirectFile lands on it by default; sockets and
+    // everything else stay on the cooperator's ring. 0 entries (the default) sets up none.
+    //
+    io::UringConfiguration storage = {.entries = 0, .taskName = "Storage", .iopoll = true};
 };
 
 static const CooperatorConfiguration s_defaultCooperatorConfiguration = {
     .uring = io::s_defaultUringConfiguration,
     .name = {},
     .cpuAffinity = -1,
+    .placement = PlacementPolicy::RoundRobin,
     .timerMode = TimerMode::KernelPerTimer,
     .trackContextCycles = false,
+    .trackStackDepth = false,
+    .trackSchedulingDelay = false,
+    .schedulingDelayByName = false,
+    .trackContextIo = false,
+    .trackContextPmu = false,
+    .bumpReserve = 0,
     .directYield = false,
     .directYieldBudget = 64,
     .ioPresentLimit = 8,
+    .priorityStarvationLimit = 8,
+    .schedulingMode = SchedulingMode::Priority,
+    .timeSliceUs = 0,
+    .migrationPolicy = nullptr,
+    .stackPool = s_defaultStackPoolConfiguration,
+    .submissionSlots = 256,
+    .futexWake = false,
+    .epochReclaim = {},
+    .statusSnapshot = {},
+    .shutdownKillBatch = 1024,
+    .shutdownBulkCancel = false,
+    .storage = {.entries = 0, .taskName = "Storage", .iopoll = true},
 };
 
 } // end namespace coop
@@ -0,0 +1,153 @@
+#include "cooperator_group.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+#include "time/now.h"
+
+namespace coop
+{
+
+CooperatorGroup::CooperatorGroup(int n, CooperatorGroupConfiguration const& config)
+: m_createdNs(time::MonotonicNanos())
+{
+    if (n <= 0)
+    {
+        auto const& topo = GetTopology();
+        n = topo.cpus.empty() ? 1 : static_cast<int>(topo.cpus.size());
+    }
+
+    bool parallel = config.parallelBootstrap && n > 1 && !PinningDisabled();
+
+    std::vector<CooperatorConfiguration> coConfigs(n, config.cooperator
+        ? *config.cooperator
+        : s_defaultCooperatorConfiguration);
+    m_members.reserve(n);
+    for (int i = 0; i < n; i++)
+    {
+        auto& coConfig = coConfigs[i];
+        char nameBuf[COOPERATOR_NAME_MAX];
+        snprintf(nameBuf, sizeof(nameBuf), "%s-%d", config.name, i);
+        coConfig.SetName(nameBuf);
+        coConfig.cpuAffinity = -1;
+        coConfig.placement = config.placement;
+
+        // Place every member up front, in order, so each bootstrap thread knows its cpu. Launch
+        // pins to the same one.
+        //
+        if (parallel)
+        {
+            coConfig.cpuAffinity = PlaceCpu(config.placement);
+        }
+        m_members.push_back(std::make_unique<Member>());
+    }
+
+    if (parallel)
+    {
+        std::vector<std::thread> bootstraps;
+        bootstraps.reserve(n);
+        for (int i = 0; i < n; i++)
+        {
+            bootstraps.emplace_back([member = m_members[i].get(), &coConfig = coConfigs[i]]
+            {
+                if (coConfig.cpuAffinity >= 0)
+                {
+                    PinThread(coConfig.cpuAffinity);
+                }
+                member->co = std::make_unique<Cooperator>(coConfig);
+            });
+        }
+        for (auto& bootstrap : bootstraps)
+        {
+            bootstrap.join();
+        }
+
+        // Launch claims its cpu again; hand back the claims made above
+        //
+        for (auto const& coConfig : coConfigs)
+        {
+            ReleaseCpu(coConfig.cpuAffinity);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < n; i++)
+        {
+            m_members[i]->co = std::make_unique<Cooperator>(coConfigs[i]);
+        }
+    }
+
+    m_threads.reserve(n);
+    for (auto& member : m_members)
+    {
+        m_threads.push_back(std::make_unique<Thread>(member->co.get()));
+    }
+}
+
+CooperatorGroup::~CooperatorGroup()
+{
+    Shutdown();
+    Join();
+}
+
+uint32_t CooperatorGroup::Load(int i) const
+{
+    auto const& member = *m_members[i];
+    return member.co->Load() + member.queued.load(std::memory_order_relaxed);
+}
+
+int CooperatorGroup::LeastLoaded() const
+{
+    int n = Size();
+    uint32_t cursor = m_cursor.fetch_add(1, std::memory_order_relaxed);
+    int start = static_cast<int>(cursor % static_cast<uint32_t>(n));
+    int best = start;
+    uint32_t bestLoad = Load(start);
+    for (int k = 1; k < n; k++)
+    {
+        int i = (start + k) % n;
+        uint32_t load = Load(i);
+        if (load < bestLoad)
+        {
+            best = i;
+            bestLoad = load;
+        }
+    }
+    return best;
+}
+
+void CooperatorGroup::Shutdown()
+{
+    for (auto& member : m_members)
+    {
+        member->co->Shutdown();
+    }
+}
+
+void CooperatorGroup::Drain(time::Interval grace)
+{
+    for (auto& member : m_members)
+    {
+        member->co->Drain(grace);
+    }
+}
+
+time::Interval CooperatorGroup::WaitReady() const
+{
+    int64_t readyNs = m_createdNs;
+    for (auto const& member : m_members)
+    {
+        member->co->WaitReady();
+        readyNs = std::max(readyNs, member->co->ReadyNanos());
+    }
+    return std::chrono::duration_cast<time::Interval>(
+        std::chrono::nanoseconds(readyNs - m_createdNs));
+}
+
+void CooperatorGroup::Join()
+{
+    m_threads.clear();
+}
+
+} // end namespace coop
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "cooperator.h"
+#include "cooperator.hpp"
+#include "cooperator_configuration.h"
+#include "spawn_configuration.h"
+#include "thread.h"
+#include "time/interval.h"
+#include "topology.h"
+
+namespace coop
+{
+
+// Options for CooperatorGroup.
+//
+struct CooperatorGroupConfiguration
+{
+    // Members are placed by this policy, counting every cooperator already pinned: by default one
+    // per physical core, spread across last-level caches, before any core's second hardware thread
+    //
+    PlacementPolicy placement = PlacementPolicy::SpreadPhysicalFirst;
+
+    // Members are named "<name>-<i>"
+    //
+    const char* name = "Group";
+
+    // Base configuration for every member; each gets its own name and placement. nullptr means
+    // s_defaultCooperatorConfiguration.
+    //
+    CooperatorConfiguration const* cooperator = nullptr;
+
+    // Construct the members in parallel, each on a bootstrap thread pinned to the cpu its member
+    // will run on, so the cooperator's own memory -- its submission slab, its CooperatorVar
+    // storage -- is first touched on that cpu's NUMA node. Members then Launch in parallel as
+    // before, pinning, prewarming their stack pools and setting up their rings on their own
+    // threads. Off, or with pinning disabled, members are constructed one by one on the caller.
+    //
+    bool parallelBootstrap = true;
+};
+
+// CooperatorGroup owns n cooperators, each started on its own Thread, and shuts them down as a
+// unit: the usual shape of a multi-core program, with placement and load-aware dispatch built in.
+//
+//  coop::CooperatorGroup group(0);                     // one per available cpu
+//  group.Broadcast([](coop::Context*) { Warm(); });    // once on every member
+//  for (auto& job : jobs)
+//  {
+//      group.SubmitAny([job](coop::Context* ctx) { Run(ctx, job); });
+//  }
+//  group.Drain(std::chrono::seconds(5));               // or Shutdown(); the destructor joins
+//
+// SubmitAny places work on the least-loaded member. A member's load is what its scheduler loop
+// last published (Cooperator::Load: runnable contexts and in-flight io_uring ops, republished
+// every iteration and before it sleeps), plus the submissions the group has queued to it that
+// have not started yet -- so a burst from one thread spreads even before any loop has run. Ties
+// go to the first member from a per-thread rotating start, so idle members share work evenly.
+// Choosing reads one atomic pair per member and writes only the chosen member's queued count.
+//
+// The members and their threads live as long as the group. Submit* and Broadcast are safe from
+// any thread, members included.
+//
+struct CooperatorGroup
+{
+    // n <= 0 means one member per available cpu
+    //
+    explicit CooperatorGroup(int n = 0, CooperatorGroupConfiguration const& config = {});
+
+    // Shutdown, then join every member
+    //
+    ~CooperatorGroup();
+
+    CooperatorGroup(CooperatorGroup const&) = delete;
+    CooperatorGroup& operator=(CooperatorGroup const&) = delete;
+
+    int Size() const { return static_cast<int>(m_members.size()); }
+
+    Cooperator* At(int i) { return m_members[i]->co.get(); }
+
+    // Submit fn on member i. False when that member is shutting down.
+    //
+    template<typename Fn>
+    bool SubmitTo(int i, Fn&& fn, SpawnConfiguration const& config = s_defaultConfiguration)
+    {
+        return Queue(*m_members[i], std::forward<Fn>(fn), config);
+    }
+
+    // Submit fn on the least-loaded member. False when the group is shutting down.
+    //
+    template<typename Fn>
+    bool SubmitAny(Fn&& fn, SpawnConfiguration const& config = s_defaultConfiguration)
+    {
+        return Queue(*m_members[LeastLoaded()], std::forward<Fn>(fn), config);
+    }
+
+    // Submit a copy of fn on every member. Returns how many took it.
+    //
+    template<typename Fn>
+    int Broadcast(Fn const& fn, SpawnConfiguration const& config = s_defaultConfiguration)
+    {
+        int accepted = 0;
+        for (auto& member : m_members)
+        {
+            accepted += Queue(*member, fn, config);
+        }
+        return accepted;
+    }
+
+    // The member SubmitAny would pick now, and the load it compares
+    //
+    int LeastLoaded() const;
+    uint32_t Load(int i) const;
+
+    // Shut every member down now, or drain them (Cooperator::Drain). From any thread.
+    //
+    void Shutdown();
+    void Drain(time::Interval grace);
+
+    // Block until every member is ready for work (Cooperator::StartupNanos). Returns the time
+    // from the group's construction to the last member's ready: the process's time-to-ready for
+    // this group. From any thread but a member's.
+    //
+    time::Interval WaitReady() const;
+
+    // Block until every member has exited, as the destructor does
+    //
+    void Join();
+
+  private:
+    // Its own line: submitters bump queued while the member's thread counts it down
+    //
+    struct alignas(64) Member
+    {
+        std::unique_ptr<Cooperator>     co;
+        std::atomic<uint32_t>           queued{0};
+    };
+
+    template<typename Fn>
+    bool Queue(Member& member, Fn&& fn, SpawnConfiguration const& config)
+    {
+        member.queued.fetch_add(1, std::memory_order_relaxed);
+        bool ok = member.co->Submit(
+            [queued = &member.queued, fn = std::forward<Fn>(fn)](Context* ctx) mutable
+            {
+                queued->fetch_sub(1, std::memory_order_relaxed);
+                fn(ctx);
+            }, config);
+        if (!ok)
+        {
+            member.queued.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return ok;
+    }
+
+    std::vector<std::unique_ptr<Member>>    m_members;
+    std::vector<std::unique_ptr<Thread>>    m_threads;
+    int64_t                                 m_createdNs;
+
+    // Where the next least-loaded scan starts, so ties rotate. Relaxed: any spread will do.
+    //
+    mutable std::atomic<uint32_t>           m_cursor{0};
+};
+
+} // end namespace coop
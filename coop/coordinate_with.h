@@ -4,8 +4,10 @@
 #include <type_traits>
 #include <utility>
 
+#include "coop/deadline_scope.h"
 #include "coop/detail/multi_coordinator.h"
 #include "coop/self.h"
+#include "coop/shared_stack.h"
 #include "coop/io/handle.h"
 #include "coop/io/timeout.h"
 #include "coop/time/interval.h"
@@ -119,8 +121,8 @@ CoordinationResult CoordinateWithImpl(Context* ctx, Args... args)
     }
     else
     {
-        MultiCoordinator<AlwaysCoordinatorPtr<Args>...> mc(toCoord(args)...);
-        auto result = mc.Acquire(ctx);
+        WaitStorage<MultiCoordinator<AlwaysCoordinatorPtr<Args>...>> mc(ctx, toCoord(args)...);
+        auto result = mc->Acquire(ctx);
 
         // Reset any Signal whose coordinator won
         //
@@ -145,9 +147,25 @@ CoordinationResult CoordinateWithImpl(Context* ctx, Args... args)
 template<typename... Args>
 CoordinationResult CoordinateWithTimeoutImpl(Context* ctx, time::Interval timeout, Args... args)
 {
-    Coordinator timeoutCoord;
-    io::Handle timeoutHandle(ctx, GetUring(), &timeoutCoord);
-    if (!io::Timeout(timeoutHandle, timeout))
+    // A DeadlineScope on the context shortens the wait to what is left of its budget
+    //
+    timeout = DeadlineScope::Clamp(ctx, timeout);
+
+    // The handle's completion writes into it, so a shared-stack context keeps both off its stack
+    //
+    struct TimeoutState
+    {
+        explicit TimeoutState(Context* ctx)
+        : handle(ctx, GetUring(), &coord)
+        {
+        }
+
+        Coordinator coord;
+        io::Handle handle;
+    };
+    WaitStorage<TimeoutState> state(ctx, ctx);
+    Coordinator& timeoutCoord = state->coord;
+    if (!io::Timeout(state->handle, timeout))
     {
         return CoordinationResult { static_cast<size_t>(-3), nullptr };
     }
@@ -161,9 +179,9 @@ CoordinationResult CoordinateWithTimeoutImpl(Context* ctx, time::Interval timeou
 
     // Order: [user args..., timeout]
     //
-    MultiCoordinator<AlwaysCoordinatorPtr<Args>..., Coordinator*> mc(
-        toCoord(args)..., &timeoutCoord);
-    auto result = mc.Acquire(ctx);
+    WaitStorage<MultiCoordinator<AlwaysCoordinatorPtr<Args>..., Coordinator*>> mc(
+        ctx, toCoord(args)..., &timeoutCoord);
+    auto result = mc->Acquire(ctx);
 
     // io::Handle destructor cancels the pending timeout if it hasn't fired yet
 
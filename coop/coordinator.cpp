@@ -4,6 +4,7 @@
 
 #include "context.h"
 #include "cooperator.h"
+#include "shared_stack.h"
 
 namespace coop
 {
@@ -54,8 +55,11 @@ void Coordinator::Acquire(Context* ctx)
         return;
     }
 
-    Coordinated coord(ctx);
-    AddAsBlocked(&coord);
+    // In the frame, or in the segment heap of a shared-stack context, whose frames may be copied
+    // away while the releaser still needs the node
+    //
+    detail::WaitStorage<Coordinated> coord(ctx, ctx);
+    AddAsBlocked(coord.Get());
 
     // Block the context on this coordinator
     //
@@ -94,6 +98,30 @@ void Coordinator::Release(Context* ctx, const bool schedule /* = true */)
     ReleaseToNext(next, schedule);
 }
 
+void Coordinator::ReleaseTo(Context* ctx)
+{
+    if (!m_held)
+    {
+        return;
+    }
+    m_held = false;
+
+    auto* next = m_blocking.Pop();
+    if (!next)
+    {
+        return;
+    }
+
+    // Woken without scheduling, so it waits on the run queue for the handoff to take it off
+    //
+    Context* target = next->IsContinuation() ? nullptr : next->GetContext();
+    ReleaseToNext(next, false);
+    if (target)
+    {
+        ctx->YieldTo(target);
+    }
+}
+
 [[gnu::noinline]] void Coordinator::ReleaseToNext(Coordinated* next, const bool schedule)
 {
     // A context waiter takes ownership — the coordinator stays held until it releases. A
@@ -109,7 +137,7 @@ void Coordinator::Release(Context* ctx, const bool schedule /* = true */)
     // Release is driven by a context or by the cooperator loop (e.g. a CQE / a continuation's
     // latch release). This is the single dispatch every wake site shares.
     //
-    Cooperator::thread_cooperator->WakeWaiter(next, schedule);
+    Cooperator::thread_cooperator->WakeWaiter(next, schedule, this);
 }
 
 void Coordinator::AddAsBlocked(Coordinated* c)
@@ -189,6 +189,14 @@ struct Coordinator
     //
     void Release(Context*, const bool schedule = true);
 
+    // Release and hand off to the context it wakes, through Context::YieldTo. Release's default
+    // switches into the waiter unconditionally; this one is bounded by the direct-yield budget and
+    // IO governor, so a ping-pong pair handing a coordinator back and forth still lets the loop
+    // poll. Returns without yielding when nothing was waiting, or when the waiter was a
+    // continuation.
+    //
+    void ReleaseTo(Context*);
+
     // Register a stackless continuation to run when this coordinator is next Released, instead
     // of blocking a context on it. Returns a ContinuationImpl owned by the caller's frame
     // (constructed in place — guaranteed copy elision); call Await() to block until it fires and
@@ -0,0 +1,48 @@
+#include <algorithm>
+
+#include "deadline_scope.h"
+
+#include "coop/context.h"
+#include "coop/time/now.h"
+
+namespace coop
+{
+
+DeadlineScope::DeadlineScope(Context* ctx, time::Interval budget)
+: m_context(ctx)
+, m_previous(ctx->m_ioDeadlineUs)
+{
+    // Rounded up like a coarse timeout, so the deadline is never before now + budget
+    //
+    int64_t deadline = time::MonotonicMicrosCeil() + std::max<int64_t>(budget.count(), 0);
+    if (m_previous == 0 || deadline < m_previous)
+    {
+        ctx->m_ioDeadlineUs = deadline;
+    }
+}
+
+DeadlineScope::~DeadlineScope()
+{
+    m_context->m_ioDeadlineUs = m_previous;
+}
+
+time::Interval DeadlineScope::Remaining(Context* ctx)
+{
+    if (!ctx || ctx->m_ioDeadlineUs == 0)
+    {
+        return time::Interval::max();
+    }
+    return time::Interval(std::max<int64_t>(ctx->m_ioDeadlineUs - time::MonotonicMicros(), 0));
+}
+
+bool DeadlineScope::Expired(Context* ctx)
+{
+    return Remaining(ctx).count() == 0;
+}
+
+time::Interval DeadlineScope::Clamp(Context* ctx, time::Interval timeout)
+{
+    return std::min(timeout, Remaining(ctx));
+}
+
+} // end namespace coop
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+#include "coop/time/interval.h"
+
+namespace coop
+{
+
+struct Context;
+
+// Bounds every blocking IO operation a context makes, and every context it spawns, by one budget:
+//
+//   coop::DeadlineScope scope(ctx, std::chrono::milliseconds(50));
+//   auto n = coop::io::Recv(conn, buf, sizeof(buf));    // -ETIMEDOUT once the 50ms are spent
+//   Backend(ctx);                                       // and so does everything in here
+//
+// The scope stores an absolute deadline on the context (Context::m_ioDeadlineUs). Contexts spawned
+// while it is set start with the same deadline, so a request handler's budget follows the work it
+// fans out to. A scope only tightens: nested inside an earlier deadline it keeps the earlier one.
+// The destructor restores whatever deadline was in effect before, so scopes must nest (the usual
+// stack discipline of an RAII guard).
+//
+// Consumers:
+//
+//   io::Handle::Submit        arms a coarse timer at the deadline (the SubmitWithCoarseTimeout
+//                             mechanism). When it fires the operation is cancelled and marked
+//                             timed out; the blocking wrappers return -ETIMEDOUT.
+//   Submit{,Coarse}Timeout    the explicit timeout is clamped to what is left of the budget.
+//   CoordinateWith(.., t)     the timeout is clamped the same way.
+//
+// Not consumed: io::Timeout/Sleep themselves (already bounded), Close (an fd must not leak to a
+// budget), and the untimed CoordinateWith / CoordinateWithKill, whose callers rely on them only
+// returning their own coordinators or a kill. Contexts moved to another cooperator keep their
+// deadline; work handed over through Cooperate or a Passage does not carry one.
+//
+struct DeadlineScope
+{
+    DeadlineScope(Context* ctx, time::Interval budget);
+    ~DeadlineScope();
+
+    DeadlineScope(DeadlineScope const&) = delete;
+    DeadlineScope& operator=(DeadlineScope const&) = delete;
+
+    // What is left of the context's budget: zero once it has passed, Interval::max() when the
+    // context has no deadline
+    //
+    static time::Interval Remaining(Context* ctx);
+
+    // Whether the context's deadline has passed, for CPU-bound work between IO calls to check
+    //
+    static bool Expired(Context* ctx);
+
+    // `timeout`, or less when the context's budget runs out first
+    //
+    static time::Interval Clamp(Context* ctx, time::Interval timeout);
+
+  private:
+    Context* m_context;
+    int64_t m_previous;
+};
+
+} // end namespace coop
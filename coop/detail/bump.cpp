@@ -0,0 +1,94 @@
+#include "bump.h"
+
+#include <cstdlib>
+
+#include "coop/cooperator.h"
+#include "coop/size_class_allocator.h"
+#include "coop/perf/probe.h"
+
+namespace coop
+{
+namespace detail
+{
+
+void* BumpOverflow(Context* ctx, size_t size, size_t align)
+{
+    auto* allocator = SizeClassAllocator::Current();
+    assert(allocator && "BumpAlloc called off a cooperator thread");
+
+    // Chunks come aligned to the header; a larger alignment is done by hand
+    //
+    const size_t bytes = sizeof(BumpChunk) + size + (align > alignof(BumpChunk) ? align : 0);
+    void* memory = allocator->Allocate(bytes);
+    if (!memory)
+    {
+        std::abort();                           // where the unchecked heap would hit the stack
+    }
+
+    uintptr_t data = reinterpret_cast<uintptr_t>(memory) + sizeof(BumpChunk);
+    data = (data + align - 1) & ~(align - 1);
+    auto* chunk = new (memory) BumpChunk{
+        ctx->m_bumpOverflow, ctx->m_heapTop, reinterpret_cast<void*>(data), bytes};
+    ctx->m_bumpOverflow = chunk;
+    ctx->m_bumpOverflows++;
+    COOP_PERF_INC(ctx->GetCooperator()->GetPerfCounters(), perf::Counter::BumpOverflow);
+    return chunk->data;
+}
+
+static void PopChunk(Context* ctx)
+{
+    BumpChunk* chunk = ctx->m_bumpOverflow;
+    ctx->m_bumpOverflow = chunk->next;
+    SizeClassAllocator::Release(chunk, chunk->bytes);
+}
+
+bool BumpFreeOverflow(Context* ctx, void* ptr)
+{
+    BumpChunk* found = ctx->m_bumpOverflow;
+    while (found && found->data != ptr)
+    {
+        found = found->next;
+    }
+
+    if (!found)
+    {
+        // A segment pointer: chunks taken since the heap last stood at or below it go with it
+        //
+        while (ctx->m_bumpOverflow
+               && reinterpret_cast<uintptr_t>(ctx->m_bumpOverflow->heapTop)
+                  > reinterpret_cast<uintptr_t>(ptr))
+        {
+            PopChunk(ctx);
+        }
+        return false;
+    }
+
+    // The chunk, every one taken after it, and the segment allocations made since
+    //
+    void* heapTop = found->heapTop;
+    BumpChunk* last;
+    do
+    {
+        last = ctx->m_bumpOverflow;
+        PopChunk(ctx);
+    }
+    while (last != found);
+
+    if (ctx->m_heapTop > ctx->m_heapHigh)
+    {
+        ctx->m_heapHigh = ctx->m_heapTop;
+    }
+    ctx->m_heapTop = heapTop;
+    return true;
+}
+
+void BumpReleaseOverflow(Context* ctx)
+{
+    while (ctx->m_bumpOverflow)
+    {
+        PopChunk(ctx);
+    }
+}
+
+} // end namespace coop::detail
+} // end namespace coop
@@ -18,31 +18,89 @@ namespace detail
 // LIFO de-bumping is supported via BumpFree for temporary allocations that should release space
 // before the context exits.
 //
+// Checked mode (CooperatorConfiguration::bumpReserve): an allocation that would leave less than
+// the reserve between the heap and the calling frame is served from an overflow chunk off the
+// cooperator's SizeClassAllocator instead, so a segment sized for the common request survives
+// the occasional large one. Chunks keep the same LIFO contract -- BumpFree of a chunk, or of a
+// segment pointer below the heap watermark the chunk was taken at, releases it -- and any still
+// held are released when the context exits. The unchecked path only asserts.
+//
+// A shared-stack context (shared_stack.h) has no frames in its segment: its heap runs up to the
+// segment's top, and Spawn gives it the checked path so the heap cannot run past it.
+//
+struct BumpChunk
+{
+    BumpChunk*  next;
+    void*       heapTop;        // the segment watermark when the chunk was taken
+    void*       data;
+    size_t      bytes;          // the whole chunk, header included
+};
+
+void* BumpOverflow(Context* ctx, size_t size, size_t align);
+bool BumpFreeOverflow(Context* ctx, void* ptr);
+void BumpReleaseOverflow(Context* ctx);
+
 inline void* BumpAlloc(Context* ctx, size_t size, size_t align = 16)
 {
     uintptr_t top = reinterpret_cast<uintptr_t>(ctx->m_heapTop);
     top = (top + align - 1) & ~(align - 1);
+    if (ctx->m_bumpReserve) [[unlikely]]
+    {
+        uintptr_t frame = ctx->m_sharedStack
+            ? reinterpret_cast<uintptr_t>(ctx->m_segment.Top()) + ctx->m_bumpReserve
+            : reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+        if (top >= frame || frame - top < size + ctx->m_bumpReserve)
+        {
+            return BumpOverflow(ctx, size, align);
+        }
+    }
     void* result = reinterpret_cast<void*>(top);
     ctx->m_heapTop = reinterpret_cast<void*>(top + size);
 
     // Sanity: heap must not collide with the stack. BumpAlloc is always called from the context
     // whose segment we're allocating from, so the current frame pointer is on that stack.
     //
-    assert(reinterpret_cast<uintptr_t>(ctx->m_heapTop) <
+    assert(ctx->m_sharedStack || reinterpret_cast<uintptr_t>(ctx->m_heapTop) <
            reinterpret_cast<uintptr_t>(__builtin_frame_address(0)));
 
     return result;
 }
 
+// Room left between the heap watermark and the calling frame, which must be on ctx's own stack,
+// less the checked-mode reserve: what the heap and the rest of the stack still have to share.
+// For a shared-stack context, what is left of its segment.
+//
+inline size_t BumpHeadroom(Context* ctx)
+{
+    if (ctx->m_sharedStack)
+    {
+        uintptr_t top = reinterpret_cast<uintptr_t>(ctx->m_heapTop);
+        uintptr_t end = reinterpret_cast<uintptr_t>(ctx->m_segment.Top());
+        return end > top ? end - top : 0;
+    }
+
+    uintptr_t top = reinterpret_cast<uintptr_t>(ctx->m_heapTop) + ctx->m_bumpReserve;
+    uintptr_t frame = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+    return frame > top ? frame - top : 0;
+}
+
 // Restore the heap watermark to a previous position. Strictly LIFO — ptr must be the value
 // returned by the corresponding BumpAlloc call (or an earlier one to free multiple allocations).
 //
 inline void BumpFree(Context* ctx, void* ptr)
 {
+    if (ctx->m_bumpOverflow && BumpFreeOverflow(ctx, ptr)) [[unlikely]]
+    {
+        return;
+    }
     assert(reinterpret_cast<uintptr_t>(ptr) >=
            reinterpret_cast<uintptr_t>(ctx->m_segment.Bottom()));
     assert(reinterpret_cast<uintptr_t>(ptr) <=
            reinterpret_cast<uintptr_t>(ctx->m_heapTop));
+    if (ctx->m_heapTop > ctx->m_heapHigh)
+    {
+        ctx->m_heapHigh = ctx->m_heapTop;       // stack-depth scan must start above it
+    }
     ctx->m_heapTop = ptr;
 }
 
@@ -0,0 +1,89 @@
+#include "cooperator_registry.h"
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+
+namespace coop
+{
+namespace detail
+{
+
+CooperatorRegistry::~CooperatorRegistry()
+{
+    delete m_array.load(std::memory_order_relaxed);
+}
+
+void CooperatorRegistry::Push(Cooperator* co)
+{
+    auto* next = new Array;
+    if (Array const* array = m_array.load(std::memory_order_relaxed))
+    {
+        next->entries = array->entries;
+    }
+    next->entries.push_back(co);
+    Replace(next);
+}
+
+void CooperatorRegistry::Remove(Cooperator* co)
+{
+    Array const* array = m_array.load(std::memory_order_relaxed);
+    if (!array)
+    {
+        return;
+    }
+
+    // Launch order is kept, as the list this replaced kept it
+    //
+    auto* next = new Array;
+    next->entries.reserve(array->entries.size());
+    std::remove_copy(array->entries.begin(), array->entries.end(),
+                     std::back_inserter(next->entries), co);
+    if (next->entries.empty())
+    {
+        delete next;
+        next = nullptr;
+    }
+    Replace(next);
+}
+
+bool CooperatorRegistry::Contains(Cooperator* co) const
+{
+    Array const* array = m_array.load(std::memory_order_relaxed);
+    return array && std::find(array->entries.begin(), array->entries.end(), co)
+                    != array->entries.end();
+}
+
+bool CooperatorRegistry::IsEmpty() const
+{
+    return m_array.load(std::memory_order_relaxed) == nullptr;
+}
+
+void CooperatorRegistry::Replace(Array* next)
+{
+    Array* prev = m_array.exchange(next, std::memory_order_seq_cst);
+    Synchronize();
+    delete prev;
+}
+
+void CooperatorRegistry::Synchronize()
+{
+    // Readers counted on the side in use may hold the array the swap replaced, so that side must
+    // drain, and the flip sends new readers to the other. A reader may have read the side just
+    // before the flip and count itself in just after the drain was seen; it loads the array after
+    // its count, so it can only hold the new one -- but an earlier Synchronize's late reader sits
+    // on the other side holding what is now the old array. Draining both sides covers it.
+    //
+    for (int i = 0; i < 2; i++)
+    {
+        size_t side = m_side.load(std::memory_order_relaxed);
+        m_side.store(side ^ 1, std::memory_order_seq_cst);
+        while (m_readers[side].count.load(std::memory_order_seq_cst) != 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+} // end namespace coop::detail
+} // end namespace coop
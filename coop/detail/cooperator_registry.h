@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace coop
+{
+
+struct Cooperator;
+
+namespace detail
+{
+
+// The process's running cooperators, read far more often than it changes: the status server, the
+// preemption ticker, trace export and sharded metric sums walk it from any thread, while it only
+// changes when a cooperator launches or exits. So it is an immutable array, replaced whole on
+// each change, that readers walk without a lock:
+//
+//   registry.Visit([](Cooperator* co) -> bool { ...; return true; });
+//
+// A reader counts itself in on one of two reader counts before it loads the array and out when it
+// is done. A writer swaps the next array in, then moves new readers to the other count and waits
+// for the old one to empty, twice -- the grace period of a read-copy-update scheme, in the shape
+// of sleepable RCU, which needs nothing of readers' threads. After it no reader can still hold the
+// old array or a cooperator that was taken out of it, so Remove returning means what releasing
+// the old registry lock meant: nothing is visiting that cooperator any more.
+//
+// A reader pays two read-modify-writes on a line shared with other readers and never waits. A
+// writer pays a copy of the array and waits out the readers already inside. Writers serialize on
+// a lock of the caller's: Cooperator's registry lock, which also gates launches against
+// ShutdownAll. A visit may nest and may yield, but must not launch or remove a cooperator (the
+// removal would wait for its own visit), and should be short: an exiting cooperator's thread
+// waits for it.
+//
+struct CooperatorRegistry
+{
+    CooperatorRegistry() = default;
+    ~CooperatorRegistry();
+
+    CooperatorRegistry(CooperatorRegistry const&) = delete;
+
+    // Any thread, no lock. Return false from fn to stop early.
+    //
+    template<typename Fn>
+    void Visit(Fn const& fn) const
+    {
+        size_t side = Enter();
+        if (Array const* array = m_array.load(std::memory_order_seq_cst))
+        {
+            for (Cooperator* co : array->entries)
+            {
+                if (!fn(co))
+                {
+                    break;
+                }
+            }
+        }
+        Exit(side);
+    }
+
+    // Under the writer lock. Push and Remove return after the grace period.
+    //
+    void Push(Cooperator* co);
+    void Remove(Cooperator* co);
+    bool Contains(Cooperator* co) const;
+    bool IsEmpty() const;
+
+    // Wait until every reader that was inside at the call has left
+    //
+    void Synchronize();
+
+  private:
+    struct Array
+    {
+        std::vector<Cooperator*> entries;
+    };
+
+    size_t Enter() const
+    {
+        size_t side = m_side.load(std::memory_order_relaxed);
+        m_readers[side].count.fetch_add(1, std::memory_order_seq_cst);
+        return side;
+    }
+
+    void Exit(size_t side) const
+    {
+        m_readers[side].count.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    void Replace(Array* next);
+
+    struct alignas(64) Readers
+    {
+        std::atomic<uint64_t> count{0};
+    };
+
+    mutable Readers         m_readers[2];
+    std::atomic<size_t>     m_side{0};
+    std::atomic<Array*>     m_array{nullptr};
+};
+
+} // end namespace coop::detail
+} // end namespace coop
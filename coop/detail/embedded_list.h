@@ -227,6 +227,15 @@ struct EmbeddedList
         return n->Cast();
     }
 
+    // Returns the element before h, or nullptr if h is the first element.
+    //
+    Ptr Prev(Hookups* h)
+    {
+        auto* p = h->prev;
+        if (p == &sentinel) return nullptr;
+        return p->Cast();
+    }
+
     size_t Size() const
     {
         size_t n = 0;
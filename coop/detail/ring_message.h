@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace coop
+{
+
+namespace detail
+{
+
+// A message one cooperator posts onto another's io_uring (Cooperator::PostMessage, carried by
+// IORING_OP_MSG_RING). The CQE lands in the target's completion ring, and its dispatch calls
+// deliver there, on the target's thread, from inside Poll: no eventfd, no drainer context. If the
+// kernel refuses the post -- the target ring's CQ overflowed, say -- the sender's own completion
+// of it calls undelivered on the sender's thread instead, so the poster can fall back.
+//
+// The message is addressed by pointer, so it must stay alive until one of the two has run.
+// Neither may block: both run mid-Poll, outside any context.
+//
+struct alignas(8) RingMessage
+{
+    void (*deliver)(RingMessage*) = nullptr;
+    void (*undelivered)(RingMessage*) = nullptr;
+};
+
+} // end namespace coop::detail
+} // end namespace coop
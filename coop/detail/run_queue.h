@@ -0,0 +1,358 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "coop/context.h"
+#include "coop/cooperator_configuration.h"
+#include "coop/detail/tsc.h"
+#include "coop/perf/probe.h"
+#include "coop/scheduling_group.h"
+#include "coop/spawn_configuration.h"
+#include "coop/time/timer_queue.h"
+
+namespace coop
+{
+
+namespace detail
+{
+
+// Map a SpawnConfiguration::priority value onto a run-list index, clamping out-of-range values to
+// the nearest class. Index 0 is the lowest class.
+//
+inline int PriorityClassIndex(int priority)
+{
+    if (priority < PRIORITY_BACKGROUND) priority = PRIORITY_BACKGROUND;
+    if (priority > PRIORITY_HIGH) priority = PRIORITY_HIGH;
+    return priority - PRIORITY_BACKGROUND;
+}
+
+// The cooperator's set of runnable (YIELDED) contexts. A single FIFO list lets a latency-critical
+// handler wait behind any number of background contexts, so runnable contexts are instead kept on
+// one FIFO list per priority class and Pop serves the highest non-empty class.
+//
+// Strict priority starves a lower class for as long as a higher one stays busy, so Pop carries a
+// starvation guard: every Pop that serves a class above a non-empty lower class counts as one
+// "pass-over" of that lower class, and once a class has been passed over m_starvationLimit times in
+// a row it is served next regardless of what sits above it. Lower classes therefore get at least one
+// slot in every m_starvationLimit + 1 pops under sustained load. A limit of 0 disables the guard.
+//
+// In SchedulingMode::EarliestDeadline, runnable contexts that carry a deadline are instead kept in an
+// intrusive pairing heap (the same time::TimerQueue that backs sleeps, hooked through Context's
+// TimerNode base) which ranks above every priority class: the earliest deadline runs first, and
+// deadline-less contexts keep their priority order behind it. The starvation guard treats the heap as
+// the top class, so deadline-less work is not starved by a steady stream of deadlines either.
+//
+// The element count is tracked so IsEmpty / Size stay O(1) -- the scheduler loop checks emptiness on
+// every iteration. Single-cooperator state, no synchronization.
+//
+// With stampReady (CooperatorConfiguration::trackSchedulingDelay), Push also stamps the context's
+// m_readyTsc, the start of the scheduling delay the cooperator records when it next resumes it.
+//
+// Contexts in a SchedulingGroup queue on their group instead, and once a group has been runnable
+// Pop first picks by fair share: the runnable group, or everything above as one more entity of
+// SCHEDULING_WEIGHT_DEFAULT, with the least virtual runtime (see scheduling_group.h). Charge feeds
+// the runtimes; m_count covers the grouped contexts too.
+//
+struct RunQueue
+{
+    explicit RunQueue(uint32_t starvationLimit = 0, SchedulingMode mode = SchedulingMode::Priority,
+                      bool stampReady = false)
+    : m_starvationLimit(starvationLimit)
+    , m_edf(mode == SchedulingMode::EarliestDeadline)
+    , m_stampReady(stampReady)
+    {
+    }
+
+    void Push(Context* ctx)
+    {
+        COOP_PERF_STAMP(perf::Hist::RunQueueWait, ctx->m_readyNs);
+        if (m_stampReady) [[unlikely]]
+        {
+            ctx->m_readyTsc = ReadTsc();
+        }
+        if (ctx->m_group) [[unlikely]]
+        {
+            PushGrouped(ctx);
+        }
+        else if (m_edf && ctx->m_deadlineUs)
+        {
+            m_deadlines.Insert(ctx, ctx->m_deadlineUs, nullptr);
+        }
+        else
+        {
+            m_lists[ctx->m_runClass].Push(ctx);
+        }
+        ++m_count;
+    }
+
+    Context* Pop()
+    {
+        if (!m_count)
+        {
+            return nullptr;
+        }
+        if (!m_groups.IsEmpty()) [[unlikely]]
+        {
+            if (auto* ctx = PopGrouped())
+            {
+                return ctx;
+            }
+        }
+
+        // The deadline heap, when in use, is the virtual class above PRIORITY_CLASSES - 1. It is never
+        // the starvation guard's pick: it already ranks first whenever it is non-empty.
+        //
+        constexpr int kDeadlineClass = PRIORITY_CLASSES;
+
+        int chosen = -1;
+        if (m_starvationLimit)
+        {
+            for (int c = 0; c < PRIORITY_CLASSES; c++)
+            {
+                if (m_passedOver[c] >= m_starvationLimit && !m_lists[c].IsEmpty())
+                {
+                    chosen = c;
+                    break;
+                }
+            }
+        }
+
+        if (chosen < 0)
+        {
+            if (!m_deadlines.Empty())
+            {
+                chosen = kDeadlineClass;
+            }
+            else
+            {
+                for (int c = PRIORITY_CLASSES - 1; c >= 0; c--)
+                {
+                    if (!m_lists[c].IsEmpty())
+                    {
+                        chosen = c;
+                        break;
+                    }
+                }
+            }
+        }
+        assert(chosen >= 0);
+
+        if (chosen < kDeadlineClass)
+        {
+            m_passedOver[chosen] = 0;
+        }
+        for (int c = 0; c < chosen && c < PRIORITY_CLASSES; c++)
+        {
+            m_passedOver[c] = m_lists[c].IsEmpty() ? 0 : m_passedOver[c] + 1;
+        }
+
+        --m_count;
+        if (chosen == kDeadlineClass)
+        {
+            // Every queued deadline is "expired" against the maximum, so this pops the minimum
+            //
+            auto* node = m_deadlines.PopExpired(std::numeric_limits<int64_t>::max());
+            return static_cast<Context*>(node);
+        }
+        return m_lists[chosen].Pop();
+    }
+
+    void Remove(Context* ctx)
+    {
+        if (ctx->m_group) [[unlikely]]
+        {
+            auto* group = ctx->m_group;
+            group->m_lists[ctx->m_runClass].Remove(ctx);
+            Deactivate(group);
+        }
+        else if (ctx->time::TimerNode::Linked())
+        {
+            m_deadlines.Remove(ctx);
+        }
+        else
+        {
+            m_lists[ctx->m_runClass].Remove(ctx);
+        }
+        --m_count;
+    }
+
+    bool IsEmpty() const
+    {
+        return !m_count;
+    }
+
+    size_t Size() const
+    {
+        return m_count;
+    }
+
+    // Whether a grouped context has been queued here, from when on every switch is charged
+    //
+    bool Charging() const
+    {
+        return m_charging;
+    }
+
+    // Charge a slice of ticks run by ctx to its group, or to the ungrouped contexts
+    //
+    void Charge(Context* ctx, int64_t ticks, int64_t now)
+    {
+        if (ctx->m_group)
+        {
+            ctx->m_group->Charge(ticks, now);
+        }
+        else
+        {
+            m_vruntime += static_cast<uint64_t>(ticks);
+        }
+    }
+
+    // Visit every runnable context: the deadline heap (unordered), then each class highest first.
+    // The same caution as EmbeddedList::Visit applies: the callback must not yield.
+    //
+    template<typename Fn>
+    void Visit(Fn const& fn)
+    {
+        bool keepGoing = true;
+        m_deadlines.Visit([&](time::TimerNode* node) -> bool
+        {
+            keepGoing = fn(static_cast<Context*>(node));
+            return keepGoing;
+        });
+        for (int c = PRIORITY_CLASSES - 1; c >= 0 && keepGoing; c--)
+        {
+            m_lists[c].Visit([&](Context* ctx) -> bool
+            {
+                keepGoing = fn(ctx);
+                return keepGoing;
+            });
+        }
+        m_groups.Visit([&](SchedulingGroup* group) -> bool
+        {
+            for (int c = PRIORITY_CLASSES - 1; c >= 0 && keepGoing; c--)
+            {
+                group->m_lists[c].Visit([&](Context* ctx) -> bool
+                {
+                    keepGoing = fn(ctx);
+                    return keepGoing;
+                });
+            }
+            return keepGoing;
+        });
+    }
+
+  private:
+    void PushGrouped(Context* ctx)
+    {
+        auto* group = ctx->m_group;
+        m_charging = true;
+        if (!group->m_statistics.runnable++)
+        {
+            // A group waking from idle starts level with the least runtime among the runnable, so
+            // its idle time is not banked as credit to starve the others with
+            //
+            if (group->m_vruntime < m_minVruntime)
+            {
+                group->m_vruntime = m_minVruntime;
+            }
+            m_groups.Push(group);
+        }
+        group->m_lists[ctx->m_runClass].Push(ctx);
+        m_grouped++;
+    }
+
+    void Deactivate(SchedulingGroup* group)
+    {
+        m_grouped--;
+        if (!--group->m_statistics.runnable)
+        {
+            m_groups.Remove(group);
+        }
+    }
+
+    // The fair-share pick: the least virtual runtime among the unthrottled runnable groups and the
+    // ungrouped contexts. nullptr when the ungrouped contexts win, for the pick below to serve;
+    // throttled groups only when nothing else is runnable.
+    //
+    Context* PopGrouped()
+    {
+        const bool ungrouped = m_count > m_grouped;
+        if (ungrouped && m_vruntime < m_minVruntime)
+        {
+            m_vruntime = m_minVruntime;
+        }
+
+        const int64_t now = ReadTsc();
+        SchedulingGroup* best = nullptr;
+        SchedulingGroup* throttled = nullptr;
+        uint64_t least = ungrouped ? m_vruntime : std::numeric_limits<uint64_t>::max();
+        m_groups.Visit([&](SchedulingGroup* group) -> bool
+        {
+            if (group->m_throttled)
+            {
+                group->RollPeriod(now);
+            }
+            if (group->m_throttled)
+            {
+                if (!throttled || group->m_vruntime < throttled->m_vruntime)
+                {
+                    throttled = group;
+                }
+            }
+            else if (group->m_vruntime < least)
+            {
+                best = group;
+                least = group->m_vruntime;
+            }
+            return true;
+        });
+
+        if (!best && !ungrouped)
+        {
+            best = throttled;
+        }
+        if (!best)
+        {
+            m_minVruntime = std::max(m_minVruntime, least);
+            return nullptr;
+        }
+        if (!best->m_throttled)
+        {
+            m_minVruntime = std::max(m_minVruntime, least);
+        }
+
+        Context* ctx = nullptr;
+        for (int c = PRIORITY_CLASSES - 1; c >= 0 && !ctx; c--)
+        {
+            ctx = best->m_lists[c].Pop();
+        }
+        assert(ctx);
+        Deactivate(best);
+        --m_count;
+        return ctx;
+    }
+
+    Context::ContextStateList m_lists[PRIORITY_CLASSES];
+    time::TimerQueue m_deadlines;
+    uint32_t m_passedOver[PRIORITY_CLASSES] = {};
+    uint32_t m_starvationLimit;
+    bool m_edf;
+    bool m_stampReady;
+    size_t m_count{0};
+
+    // Fair share: the groups with runnable contexts, how many contexts they hold, the ungrouped
+    // contexts' virtual runtime, and the floor a waking entity's runtime is raised to
+    //
+    SchedulingGroup::List m_groups;
+    size_t m_grouped{0};
+    uint64_t m_vruntime{0};
+    uint64_t m_minVruntime{0};
+    bool m_charging{false};
+};
+
+} // end namespace detail
+} // end namespace coop
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace coop
+{
+namespace detail
+{
+
+// SubmissionSlab is a cooperator's preallocated store of submission entries: a fixed array of
+// SLOT_SIZE-byte slots on a lock-free free stack. Producer threads take slots in Submit; the
+// cooperator returns them once an entry has run. An entry too big for a slot, or a Submit that
+// finds the stack empty, falls back to the heap, so the slab bounds memory without bounding
+// submissions.
+//
+// The stack head packs a slot index (plus one; zero is empty) with a tag bumped by every update,
+// which is what keeps a pop that read a stale next index from landing: ABA would need 2^32
+// updates between its load and its CAS.
+//
+struct SubmissionSlab
+{
+    static constexpr size_t SLOT_SIZE = 128;
+
+    explicit SubmissionSlab(uint32_t slots)
+    : m_count(slots)
+    , m_slots(slots ? new Slot[slots] : nullptr)
+    , m_next(slots ? new std::atomic<uint32_t>[slots] : nullptr)
+    {
+        for (uint32_t i = 0; i < slots; i++)
+        {
+            m_next[i].store(i + 1 < slots ? i + 2 : 0, std::memory_order_relaxed);
+        }
+        m_head.store(slots ? 1 : 0, std::memory_order_relaxed);
+    }
+
+    SubmissionSlab(SubmissionSlab const&) = delete;
+    SubmissionSlab& operator=(SubmissionSlab const&) = delete;
+
+    // A slot for an entry of size bytes and alignment align, or nullptr
+    //
+    void* Acquire(size_t size, size_t align)
+    {
+        if (size > SLOT_SIZE || align > alignof(Slot))
+        {
+            return nullptr;
+        }
+
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        for (;;)
+        {
+            uint32_t index = static_cast<uint32_t>(head);
+            if (!index)
+            {
+                return nullptr;
+            }
+            uint32_t next = m_next[index - 1].load(std::memory_order_relaxed);
+            uint64_t desired = (((head >> 32) + 1) << 32) | next;
+            if (m_head.compare_exchange_weak(head, desired, std::memory_order_acquire,
+                                             std::memory_order_acquire))
+            {
+                return m_slots[index - 1].bytes;
+            }
+        }
+    }
+
+    bool Owns(const void* p) const
+    {
+        auto* slot = static_cast<const Slot*>(p);
+        return slot >= m_slots.get() && slot < m_slots.get() + m_count;
+    }
+
+    void Release(void* p)
+    {
+        uint32_t index = static_cast<uint32_t>(static_cast<Slot*>(p) - m_slots.get());
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        uint64_t desired;
+        do
+        {
+            m_next[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            desired = (((head >> 32) + 1) << 32) | (index + 1);
+        }
+        while (!m_head.compare_exchange_weak(head, desired, std::memory_order_release,
+                                             std::memory_order_relaxed));
+    }
+
+  private:
+    struct alignas(16) Slot
+    {
+        char bytes[SLOT_SIZE];
+    };
+
+    alignas(64) std::atomic<uint64_t>           m_head{0};
+    uint32_t                                    m_count;
+    std::unique_ptr<Slot[]>                     m_slots;
+    std::unique_ptr<std::atomic<uint32_t>[]>    m_next;
+};
+
+} // end namespace coop::detail
+} // end namespace coop
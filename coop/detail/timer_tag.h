@@ -20,5 +20,43 @@ namespace detail
 static constexpr uintptr_t kTimerTag    = 0x4;        // bit 2: deadline-timer expiry
 static constexpr uintptr_t kTimerAckTag = 0x4 | 0x1;  // bit 2 | bit 0: update ack (ignored)
 
+// The cross-cooperator wake cookie (work::Grid's idle-stealer doorbell, delivered by
+// IORING_OP_MSG_RING). Also a small integer rather than a pointer -- the receiver is the thread's
+// current cooperator -- and matched exactly, since no real Handle lives at address 0x8. kWakeTag is
+// the message posted onto the sleeping peer's ring; kWakeAckTag is the sender's own MSG_RING
+// completion (ignored).
+//
+static constexpr uintptr_t kWakeTag     = 0x8;
+static constexpr uintptr_t kWakeAckTag  = 0x8 | 0x1;
+
+// The completion of a Descriptor's cancel-by-file (IORING_ASYNC_CANCEL_FD). The cancelled
+// operations report through their own CQEs, so this one carries nothing and is dropped; matched
+// exactly, as kWakeTag is.
+//
+static constexpr uintptr_t kCancelFdTag = 0x10 | 0x1;
+
+// The completion of one of io::Uring::CancelWaiting's cancels-by-opcode. Its result counts the
+// operations it took, so unlike kCancelFdTag it is not dropped; matched exactly as well.
+//
+static constexpr uintptr_t kBulkCancelTag = 0x20 | 0x1;
+
+// A detached op (io/detached.h): bit 62 -- which, as bit 63 below, no user-space pointer has --
+// over the op's opcode, or over the address of the heap copy it frees when its CQE arrives
+//
+static constexpr uintptr_t kDetachedTag = uintptr_t(1) << 62;
+
+// A RingMessage (ring_message.h) posted by another cooperator. The userdata is the message's
+// address with bit 63 set -- no user-space pointer has it on x86-64 or aarch64 -- and, on the
+// sender's own completion of the post, bit 0 as well.
+//
+static constexpr uintptr_t kMessageTag    = uintptr_t(1) << 63;
+static constexpr uintptr_t kMessageAckTag = kMessageTag | 0x1;
+
+// An io::Watcher's multishot poll (io/watcher.h): the watcher's address with bit 61 set, and bit 0
+// as well on the completion of its poll update or removal
+//
+static constexpr uintptr_t kWatchTag    = uintptr_t(1) << 61;
+static constexpr uintptr_t kWatchAckTag = kWatchTag | 0x1;
+
 } // namespace detail
 } // namespace coop
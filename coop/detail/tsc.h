@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+namespace coop
+{
+
+namespace detail
+{
+
+// The cheap cycle counter behind trackContextCycles and trackSchedulingDelay: the TSC on x86-64,
+// the virtual counter on aarch64. No serializing barrier: the readings feed observability only,
+// where a few cycles of reordering do not matter.
+//
+inline int64_t ReadTsc()
+{
+#if defined(__x86_64__)
+    uint32_t hi, lo;
+    __asm__ __volatile__("rdtsc" : "=a"(lo),"=d"(hi));
+    return static_cast<int64_t>((uint64_t)hi << 32 | lo);
+#elif defined(__aarch64__)
+    uint64_t val;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(val));
+    return static_cast<int64_t>(val);
+#else
+#error "Unsupported architecture for rdtsc"
+#endif
+}
+
+} // end namespace coop::detail
+} // end namespace coop
@@ -0,0 +1,42 @@
+#include "drain.h"
+
+#include "cooperator.h"
+
+namespace coop
+{
+
+DrainHook::DrainHook(Cooperator* co)
+: m_co(co)
+, m_hooked(true)
+{
+    m_co->m_drainHooks.Push(this);
+}
+
+DrainHook::~DrainHook()
+{
+    if (m_hooked)
+    {
+        m_co->m_drainHooks.Remove(this);
+    }
+}
+
+DrainHold::DrainHold(Cooperator* co)
+: m_co(co)
+{
+    // The coordinator is held while any hold is, so the drain blocks on it until the last goes
+    //
+    if (m_co->m_drainHolds++ == 0)
+    {
+        m_co->m_drainHeld.TryAcquire();
+    }
+}
+
+DrainHold::~DrainHold()
+{
+    if (--m_co->m_drainHolds == 0)
+    {
+        m_co->m_drainHeld.Release(nullptr, false);
+    }
+}
+
+} // end namespace coop
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+
+#include "detail/embedded_list.h"
+
+namespace coop
+{
+
+struct Cooperator;
+
+// Graceful drain (Cooperator::Drain) runs in two phases on each cooperator: every DrainHook is
+// told to stop taking new work, then the drain waits -- up to its grace period -- for the
+// cooperator's DrainHolds to go, and only then runs the ordinary Shutdown kill sweep. The HTTP
+// server hooks its listeners (it cancels their accepts, leaving the sockets open for a successor
+// to inherit) and holds each request from its request line to its response; keep-alive
+// connections answer Connection: close while their cooperator drains.
+//
+//  struct StopIntake : coop::DrainHook
+//  {
+//      using DrainHook::DrainHook;
+//      void OnDrain() override { queue.Close(); }
+//  };
+//
+//  StopIntake hook(co);            // on the cooperator's thread, like everything below
+//  {
+//      coop::DrainHold hold(co);   // the drain waits for this scope
+//      Process(item);
+//  }
+//
+
+// Told once, on its cooperator's thread, when that cooperator starts draining. A hook destroyed
+// before then is never told. OnDrain may not block; it may destroy hooks, its own included.
+//
+struct DrainHook : EmbeddedListHookups<DrainHook>
+{
+    explicit DrainHook(Cooperator* co);
+    virtual ~DrainHook();
+
+    virtual void OnDrain() = 0;
+
+  private:
+    friend struct Cooperator;
+
+    Cooperator* m_co;
+    bool        m_hooked;
+};
+
+// Work a drain waits for, counted per cooperator. Constructing one costs an increment; it never
+// blocks, and a drain that is already waiting simply waits for it too.
+//
+struct DrainHold
+{
+    explicit DrainHold(Cooperator* co);
+    ~DrainHold();
+
+    DrainHold(DrainHold const&) = delete;
+    DrainHold& operator=(DrainHold const&) = delete;
+
+  private:
+    Cooperator* m_co;
+};
+
+} // end namespace coop
@@ -0,0 +1,275 @@
+#include "domain.h"
+
+#include <cassert>
+
+#include "coop/cooperator.h"
+#include "coop/perf/probe.h"
+
+namespace coop
+{
+namespace epoch
+{
+
+namespace
+{
+
+// Two epochs behind: every participant has published at least once since the entry was retired,
+// so a reader pinned before the unlink has exited
+//
+bool Ready(RetireEntry const* entry, Epoch current)
+{
+    return entry->m_retiredAt.Value() + 2 <= current.Value();
+}
+
+void Append(RetireEntry*& head, RetireEntry*& tail, RetireEntry* entry)
+{
+    entry->m_next = nullptr;
+    if (tail)
+    {
+        tail->m_next = entry;
+    }
+    else
+    {
+        head = entry;
+    }
+    tail = entry;
+}
+
+size_t ReclaimReady(RetireEntry*& head, RetireEntry*& tail, Epoch current)
+{
+    size_t reclaimed = 0;
+    while (head && Ready(head, current))
+    {
+        auto* entry = head;
+        head = entry->m_next;
+        if (!head)
+        {
+            tail = nullptr;
+        }
+        entry->reclaim(entry);
+        reclaimed++;
+    }
+    return reclaimed;
+}
+
+} // end anonymous namespace
+
+// ---- Domain ----
+
+Domain::~Domain()
+{
+    assert(m_participants.IsEmpty() && "epoch::Domain destroyed with participants still joined");
+
+    // No participant is left to read anything
+    //
+    ReclaimOrphans(Epoch::Alive());
+}
+
+size_t Domain::ParticipantCount()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_participants.Size();
+}
+
+void Domain::Join(Participant* participant)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_participants.Push(participant);
+}
+
+void Domain::Leave(Participant* participant)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_participants.Remove(participant);
+
+    // The leftovers are stamped in this domain's epoch and keep their order relative to each
+    // other; the orphan list is reclaimed by scanning, not by its head alone
+    //
+    while (auto* entry = participant->m_retireHead)
+    {
+        participant->m_retireHead = entry->m_next;
+        Append(m_orphanHead, m_orphanTail, entry);
+    }
+    participant->m_retireTail = nullptr;
+    participant->m_retireCount = 0;
+}
+
+// The advance side of the pin protocol: our fence pairs with the one a first pin issues after
+// publishing, so either this scan sees the pin or that reader sees the epoch we are leaving behind
+// it, which it is then entitled to.
+//
+bool Domain::TryAdvance(Epoch seen)
+{
+    std::unique_lock<std::mutex> lock(m_lock, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_global.load(std::memory_order_relaxed) != seen.Value())
+    {
+        return false;
+    }
+
+    bool behind = false;
+    m_participants.Visit([&](Participant* participant) -> bool
+    {
+        Epoch published = participant->m_published.load(std::memory_order_acquire);
+        behind = published < seen;
+        return !behind;
+    });
+    if (behind)
+    {
+        return false;
+    }
+
+    Epoch next = seen.Next();
+    m_global.store(next.Value(), std::memory_order_release);
+    ReclaimOrphans(next);
+    return true;
+}
+
+size_t Domain::ReclaimOrphans(Epoch current)
+{
+    size_t reclaimed = 0;
+    RetireEntry* keptHead = nullptr;
+    RetireEntry* keptTail = nullptr;
+    for (auto* entry = m_orphanHead; entry;)
+    {
+        auto* next = entry->m_next;
+        if (current.IsAlive() || Ready(entry, current))
+        {
+            entry->reclaim(entry);
+            reclaimed++;
+        }
+        else
+        {
+            Append(keptHead, keptTail, entry);
+        }
+        entry = next;
+    }
+    m_orphanHead = keptHead;
+    m_orphanTail = keptTail;
+    return reclaimed;
+}
+
+// ---- Participant ----
+
+Participant::Participant(Domain& domain)
+: m_domain(domain)
+, m_cooperator(Cooperator::thread_cooperator)
+{
+    assert(m_cooperator != nullptr
+           && "epoch::Participant created outside a cooperator thread");
+    domain.Join(this);
+    m_cooperator->m_epochParticipants.Push(this);
+}
+
+Participant::~Participant()
+{
+    assert(m_pins.IsEmpty() && "epoch::Participant destroyed with a DomainGuard still pinned");
+    assert(m_holders.IsEmpty() && "epoch::Participant destroyed with a Holder still registered");
+    assert(Cooperator::thread_cooperator == m_cooperator
+           && "epoch::Participant destroyed off its cooperator");
+    m_cooperator->m_epochParticipants.Remove(this);
+    Reclaim();
+    m_domain.Leave(this);
+}
+
+void Participant::Enter(DomainGuard* guard)
+{
+    assert(Cooperator::thread_cooperator == m_cooperator
+           && "epoch::DomainGuard pinned off its participant's cooperator");
+
+    Epoch current{m_domain.m_global.load(std::memory_order_relaxed)};
+    guard->m_epoch = current;
+    bool first = m_pins.IsEmpty();
+    m_pins.Push(guard);
+    if (first)
+    {
+        // The fence keeps the structure's reads from moving above the publish (see TryAdvance)
+        //
+        m_published.store(current, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void Participant::Exit(DomainGuard* guard)
+{
+    assert(Cooperator::thread_cooperator == m_cooperator
+           && "epoch::DomainGuard released off its participant's cooperator; did it migrate?");
+
+    bool oldest = m_pins.Peek() == guard;
+    m_pins.Remove(guard);
+    if (oldest)
+    {
+        // Release: the reads made under the pin are done before an advancer can see it gone
+        //
+        Epoch published = m_pins.IsEmpty() ? Epoch::Alive() : m_pins.Peek()->m_epoch;
+        m_published.store(published, std::memory_order_release);
+    }
+}
+
+void Participant::Retire(RetireEntry* entry)
+{
+    assert(Cooperator::thread_cooperator == m_cooperator
+           && "epoch::Participant::Retire called off its cooperator");
+
+    // Order the unlink that made the entry unreachable before the epoch it is stamped with
+    //
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    entry->m_retiredAt = Epoch{m_domain.m_global.load(std::memory_order_relaxed)};
+    Append(m_retireHead, m_retireTail, entry);
+    m_retireCount++;
+}
+
+size_t Participant::Reclaim()
+{
+    size_t reclaimed = ReclaimReady(m_retireHead, m_retireTail, m_domain.Current());
+    m_retireCount -= reclaimed;
+    return reclaimed;
+}
+
+void Participant::Quiesce()
+{
+    // Renew first, so a holder pinned at the epoch being left behind does not stop it moving on
+    //
+    if (!m_holders.IsEmpty()) [[unlikely]]
+    {
+        m_holders.Visit([](Holder* holder) -> bool
+        {
+            holder->quiesce(holder, false);
+            return true;
+        });
+    }
+
+    if (!m_retireHead)
+    {
+        return;
+    }
+
+    // Entries are stamped oldest first, so the head says whether the epoch still has to move
+    //
+    Epoch current = m_domain.Current();
+    if (!Ready(m_retireHead, current))
+    {
+        if (m_domain.TryAdvance(current))
+        {
+            COOP_PERF_INC(m_cooperator->GetPerfCounters(), perf::Counter::EpochAdvance);
+        }
+    }
+    Reclaim();
+}
+
+void Participant::Park()
+{
+    m_holders.Visit([](Holder* holder) -> bool
+    {
+        holder->quiesce(holder, true);
+        return true;
+    });
+}
+
+} // end namespace coop::epoch
+} // end namespace coop
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "epoch.h"
+
+#include "coop/detail/embedded_list.h"
+
+namespace coop
+{
+
+struct Cooperator;
+
+namespace epoch
+{
+
+struct Participant;
+struct DomainGuard;
+struct Holder;
+
+// A Participant is on two lists: its domain's, and its cooperator's (for the per-loop Quiesce)
+//
+static constexpr int PARTICIPANT_LIST_DOMAIN = 0;
+static constexpr int PARTICIPANT_LIST_COOPERATOR = 1;
+
+// Domain is epoch-based reclamation for a structure several cooperators share. A Manager's epoch
+// is its own cooperator's counter, so its pins and retirements only order against each other; a
+// Domain has one epoch for every cooperator that joins it.
+//
+//   coop::epoch::Domain domain;                       // lives as long as the shared structure
+//
+//   coop::epoch::Participant participant(domain);     // one per cooperator, on its thread
+//   {
+//       coop::epoch::DomainGuard guard(participant);  // pins this context
+//       auto* node = table.Find(key);                 // safe to read node, across yields too
+//   }
+//   table.Erase(key, [&](Node* n) { participant.Retire(n); });
+//
+// Each participant publishes the oldest epoch any of its contexts is pinned at (or Alive) in a
+// slot of its own cache line, written only by its cooperator. The domain's epoch moves from E to
+// E+1 once every published slot has reached E; an entry retired at E is reclaimed once the epoch
+// reaches E+2, when no reader that could have seen it can still be pinned.
+//
+// Nothing needs to drive it: the cooperator quiesces each of its participants once per scheduler
+// loop iteration. One with retirements waiting tries to advance the epoch and reclaims its own
+// ready batch; one with none does nothing. Readers cost a relaxed load and, for the first pin on a
+// cooperator, a store and a fence -- no shared write, so read paths scale across cores.
+//
+// A participant belongs to the cooperator that built it: pins, retirements and its destruction
+// happen there, and a context must not migrate to another cooperator while it holds a guard.
+// Retirements still pending when it is destroyed pass to the domain, which reclaims them as the
+// epoch advances or, at the latest, in its destructor, which must come after every participant's.
+//
+struct Domain
+{
+    Domain(Domain const&) = delete;
+    Domain(Domain&&) = delete;
+
+    Domain() = default;
+    ~Domain();
+
+    Epoch Current() const { return Epoch{m_global.load(std::memory_order_acquire)}; }
+
+    // A snapshot: participants join and leave from their own threads
+    //
+    size_t ParticipantCount();
+
+  private:
+    friend struct Participant;
+
+    void Join(Participant* participant);
+    void Leave(Participant* participant);
+
+    // Move the epoch on from seen, if every participant has caught up with it. False when it did
+    // not: a participant is behind, the epoch has already moved, or another cooperator is trying.
+    //
+    bool TryAdvance(Epoch seen);
+
+    // Under m_lock
+    //
+    size_t ReclaimOrphans(Epoch current);
+
+    alignas(64) std::atomic<uint64_t>   m_global{1};
+
+    alignas(64) std::mutex              m_lock;
+    EmbeddedList<Participant, int, PARTICIPANT_LIST_DOMAIN> m_participants;
+    RetireEntry*                        m_orphanHead{nullptr};
+    RetireEntry*                        m_orphanTail{nullptr};
+};
+
+// A pin that outlives the contexts using it: something that caches a pointer into a domain's
+// structure across scheduler iterations, as Published<T>::Reader caches its snapshot. A held pin
+// would hold the domain's epoch back for as long as it lives, so its participant calls quiesce
+// when no context is running: from each Quiesce (idle false), to renew the pin at the current
+// epoch, and before the cooperator sleeps in the kernel (idle true), to let it go. Whatever the
+// holder hands out is therefore good only until the context using it next yields or blocks.
+//
+struct Holder : EmbeddedListHookups<Holder>
+{
+    void (*quiesce)(Holder* holder, bool idle);
+};
+
+// One cooperator's membership in a Domain: its published epoch, its pins and its retire list.
+//
+struct Participant : EmbeddedListHookups<Participant, int, PARTICIPANT_LIST_DOMAIN>
+                   , EmbeddedListHookups<Participant, int, PARTICIPANT_LIST_COOPERATOR>
+{
+    using CooperatorList = EmbeddedList<Participant, int, PARTICIPANT_LIST_COOPERATOR>;
+
+    Participant(Participant const&) = delete;
+    Participant(Participant&&) = delete;
+
+    // On the cooperator's thread
+    //
+    explicit Participant(Domain& domain);
+
+    // No guard may still be pinned
+    //
+    ~Participant();
+
+    Domain& GetDomain() { return m_domain; }
+
+    // Retire an entry for later reclamation, stamped with the domain's current epoch. The entry
+    // must already be unreachable for new readers.
+    //
+    void Retire(RetireEntry* entry);
+
+    // Reclaim every retired entry the domain's epoch has left behind. Returns the number reclaimed.
+    //
+    size_t Reclaim();
+
+    // The scheduler's once-per-iteration call: renew the holders' pins, then, with retirements
+    // waiting, try to move the epoch on and reclaim what is ready. Cheap when there are none.
+    //
+    void Quiesce();
+
+    // The scheduler's call before it sleeps in the kernel: the holders let their pins go, so an
+    // idle cooperator holds no one's epoch back
+    //
+    void Park();
+
+    // Register a holder for the calls above, on the cooperator's thread. It must be removed before
+    // the participant is destroyed.
+    //
+    void AddHolder(Holder* holder) { m_holders.Push(holder); }
+    void RemoveHolder(Holder* holder) { m_holders.Remove(holder); }
+
+    size_t PendingCount() const { return m_retireCount; }
+
+    // The oldest epoch a context of this cooperator is pinned at, or Alive. Read by any thread.
+    //
+    Epoch Published() const { return m_published.load(std::memory_order_acquire); }
+
+  private:
+    friend struct Domain;
+    friend struct DomainGuard;
+
+    void Enter(DomainGuard* guard);
+    void Exit(DomainGuard* guard);
+
+    Domain&                     m_domain;
+    Cooperator*                 m_cooperator;
+    EmbeddedList<DomainGuard>   m_pins;             // oldest first: pins only move forward
+    EmbeddedList<Holder>        m_holders;
+    RetireEntry*                m_retireHead{nullptr};
+    RetireEntry*                m_retireTail{nullptr};
+    size_t                      m_retireCount{0};
+
+    alignas(64) std::atomic<Epoch> m_published{Epoch::Alive()};
+};
+
+// RAII pin on a Participant, held by a context for as long as it may touch nodes of the shared
+// structure -- across yields and blocking IO included.
+//
+struct DomainGuard : EmbeddedListHookups<DomainGuard>
+{
+    explicit DomainGuard(Participant& participant)
+    : m_participant(participant)
+    {
+        participant.Enter(this);
+    }
+
+    ~DomainGuard()
+    {
+        m_participant.Exit(this);
+    }
+
+    DomainGuard(DomainGuard const&) = delete;
+    DomainGuard(DomainGuard&&) = delete;
+
+    Epoch PinnedEpoch() const { return m_epoch; }
+
+    Participant& GetParticipant() const { return m_participant; }
+
+  private:
+    friend struct Participant;
+
+    Participant&    m_participant;
+    Epoch           m_epoch;
+};
+
+} // end namespace coop::epoch
+} // end namespace coop
@@ -1,6 +1,7 @@
 #include "epoch.h"
 #include "coop/cooperator.h"
 #include "coop/perf/probe.h"
+#include "coop/time/now.h"
 
 namespace coop
 {
@@ -238,10 +239,27 @@ size_t Manager::Reclaim()
 }
 
 size_t Manager::Reclaim(Epoch boundary)
+{
+    return Reclaim(boundary, SIZE_MAX, 0);
+}
+
+size_t Manager::Reclaim(size_t maxEntries, int64_t maxNanos)
+{
+    // SafeEpoch walks the registry; an empty queue has no use for it
+    //
+    if (!m_retireHead)
+    {
+        return 0;
+    }
+    return Reclaim(SafeEpoch(), maxEntries, maxNanos);
+}
+
+size_t Manager::Reclaim(Epoch boundary, size_t maxEntries, int64_t maxNanos)
 {
     size_t reclaimed = 0;
+    const int64_t start = maxNanos > 0 ? time::MonotonicNanos() : 0;
 
-    while (m_retireHead && m_retireHead->m_retiredAt < boundary)
+    while (m_retireHead && m_retireHead->m_retiredAt < boundary && reclaimed < maxEntries)
     {
         auto* entry = m_retireHead;
         m_retireHead = entry->m_next;
@@ -252,6 +270,12 @@ size_t Manager::Reclaim(Epoch boundary)
         m_retireCount--;
         entry->reclaim(entry);
         reclaimed++;
+
+        if (maxNanos > 0 && reclaimed % kReclaimClockStride == 0
+            && time::MonotonicNanos() - start >= maxNanos)
+        {
+            break;
+        }
     }
 
     return reclaimed;
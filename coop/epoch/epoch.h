@@ -92,12 +92,14 @@ struct RetireEntry
 // pointer set during a bootstrap task.
 //
 // The epoch is a single monotonically increasing counter. All operations are cooperator-local
-// (no cross-thread synchronization). Cross-cooperator aggregation, if ever needed, is done
-// externally via the cooperator registry with appropriate locking.
+// (no cross-thread synchronization). A structure shared across cooperators needs one epoch for
+// all of them: see epoch::Domain (domain.h).
 //
 // The manager does not spawn its own GC task — that is a policy decision for the consumer.
 // It provides the mechanism: Retire to enqueue, SafeEpoch to compute the reclamation horizon,
-// Reclaim to free everything below it.
+// Reclaim to free everything below it. The one policy on offer is opt-in: with
+// CooperatorConfiguration::epochReclaim set, the cooperator reclaims its own manager's queue
+// in budgeted passes at its idle points.
 //
 struct Manager
 {
@@ -183,6 +185,17 @@ struct Manager
     //
     size_t Reclaim(Epoch boundary);
 
+    // Budgeted Reclaim: as above, but stops after maxEntries entries or once maxNanos have
+    // passed, whichever comes first, leaving the rest queued in order for a later call. The
+    // clock is read every kReclaimClockStride entries, so a pass may overrun maxNanos by that
+    // many reclaim callbacks; maxNanos <= 0 bounds the pass by count alone. The cooperator's
+    // scheduler-driven reclamation (CooperatorConfiguration::epochReclaim) is built on this.
+    //
+    static constexpr size_t kReclaimClockStride = 8;
+
+    size_t Reclaim(size_t maxEntries, int64_t maxNanos);
+    size_t Reclaim(Epoch boundary, size_t maxEntries, int64_t maxNanos);
+
     // Number of entries awaiting reclamation.
     //
     size_t PendingCount() const { return m_retireCount; }
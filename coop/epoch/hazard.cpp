@@ -0,0 +1,178 @@
+#include "hazard.h"
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+
+#include "coop/context_var.h"
+
+namespace coop
+{
+namespace epoch
+{
+
+namespace
+{
+
+// Every context's slot block, for Reclaim on any thread to scan
+//
+struct HazardRegistry
+{
+    static HazardRegistry& Instance()
+    {
+        static HazardRegistry s_instance;
+        return s_instance;
+    }
+
+    std::mutex                          m_lock;
+    EmbeddedList<detail::HazardSlots>   m_slots;
+    std::atomic<size_t>                 m_count{0};
+};
+
+LazyContextVar<detail::HazardSlots> s_slots;
+
+} // end anonymous namespace
+
+// ---- Slots ----
+
+detail::HazardSlots::HazardSlots()
+{
+    auto& registry = HazardRegistry::Instance();
+    std::lock_guard<std::mutex> lock(registry.m_lock);
+    registry.m_slots.Push(this);
+    registry.m_count.fetch_add(HAZARD_SLOTS, std::memory_order_relaxed);
+}
+
+detail::HazardSlots::~HazardSlots()
+{
+    assert(!taken && "context torn down holding a hazard");
+
+    auto& registry = HazardRegistry::Instance();
+    std::lock_guard<std::mutex> lock(registry.m_lock);
+    registry.m_slots.Remove(this);
+    registry.m_count.fetch_sub(HAZARD_SLOTS, std::memory_order_relaxed);
+}
+
+detail::HazardSlots* detail::Slots(Context* ctx)
+{
+    return s_slots.Get(ctx);
+}
+
+// ---- Guard ----
+
+HazardGuard::HazardGuard(Context* ctx)
+: m_slots(detail::Slots(ctx))
+{
+    uint32_t free = ~m_slots->taken & ((1u << HAZARD_SLOTS) - 1);
+    assert(free && "context already holds HAZARD_SLOTS hazards");
+
+    size_t index = __builtin_ctz(free);
+    m_bit = 1u << index;
+    m_slot = &m_slots->slots[index];
+    m_slots->taken |= m_bit;
+}
+
+HazardGuard::~HazardGuard()
+{
+    Reset();
+    m_slots->taken &= ~m_bit;
+}
+
+// ---- Domain ----
+
+HazardDomain::~HazardDomain()
+{
+    while (m_retireHead)
+    {
+        auto* entry = m_retireHead;
+        m_retireHead = entry->m_next;
+        entry->reclaim(entry);
+    }
+    m_retireCount = 0;
+}
+
+size_t HazardDomain::RegisteredSlots()
+{
+    return HazardRegistry::Instance().m_count.load(std::memory_order_relaxed);
+}
+
+void HazardDomain::Retire(RetireEntry* entry)
+{
+    entry->m_next = m_retireHead;
+    m_retireHead = entry;
+    m_retireCount++;
+
+    // Twice the slots: a pass frees at least half of what it looks at, so each retirement pays a
+    // constant share of the scan
+    //
+    if (!m_reclaiming && m_retireCount >= std::max(m_scanThreshold, 2 * RegisteredSlots()))
+    {
+        Reclaim();
+    }
+}
+
+size_t HazardDomain::Reclaim()
+{
+    if (!m_retireHead || m_reclaiming)
+    {
+        return 0;
+    }
+
+    // Take the queue as it stands: an entry a reclaim callback retires was unlinked after the
+    // scan below, so it waits for the next one
+    //
+    RetireEntry* pending = m_retireHead;
+    m_retireHead = nullptr;
+    m_retireCount = 0;
+    m_reclaiming = true;
+
+    // Pairs with the store-then-reload in Protect: a reader that published a hazard before our
+    // fence is seen below, and one that published after it reloads the source and finds the node
+    // gone -- it was unlinked before it was retired
+    //
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    m_scratch.clear();
+    {
+        auto& registry = HazardRegistry::Instance();
+        std::lock_guard<std::mutex> lock(registry.m_lock);
+        for (auto* block : registry.m_slots)
+        {
+            for (auto& slot : block->slots)
+            {
+                if (auto* p = slot.load(std::memory_order_acquire))
+                {
+                    m_scratch.push_back(p);
+                }
+            }
+        }
+    }
+    std::sort(m_scratch.begin(), m_scratch.end());
+
+    size_t kept = 0;
+    size_t reclaimed = 0;
+    while (pending)
+    {
+        auto* entry = pending;
+        pending = entry->m_next;
+        if (std::binary_search(m_scratch.begin(), m_scratch.end(), entry))
+        {
+            entry->m_next = m_retireHead;
+            m_retireHead = entry;
+            m_retireCount++;
+            kept++;
+            continue;
+        }
+        entry->reclaim(entry);
+        reclaimed++;
+    }
+    m_reclaiming = false;
+
+    m_stats.scans++;
+    m_stats.reclaimed += reclaimed;
+    m_stats.deferred += kept;
+    return reclaimed;
+}
+
+} // end namespace coop::epoch
+} // end namespace coop
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "epoch.h"
+
+#include "coop/self.h"
+#include "coop/detail/embedded_list.h"
+
+namespace coop
+{
+namespace epoch
+{
+
+// HazardDomain is hazard-pointer reclamation, for structures whose readers may hold on for a long
+// time. An epoch pin protects everything retired at or after its epoch, so a context that sits on
+// a pin -- a slow client's cursor, a watch that parks between events -- holds back every
+// reclamation behind it and the retire queue grows without bound. A hazard protects only the one
+// node it names:
+//
+//   coop::epoch::HazardDomain hazards;                // one per cooperator, like a Manager
+//
+//   {
+//       coop::epoch::HazardGuard hazard;              // takes one of the context's slots
+//       Node* node = hazard.Protect(list.m_head);     // safe to read node, across yields too
+//       ...
+//   }
+//   list.Unlink(node);
+//   hazards.Retire(node);                             // Node derives from RetireEntry
+//
+// Every context that takes a hazard gets HAZARD_SLOTS of them, in a LazyContextVar: contexts that
+// never take one pay a pointer. Their slot blocks are on one process-wide list, so a reader on
+// any cooperator protects a node from a domain on any other; joining the list takes a lock once,
+// on the context's first hazard, and leaving it once more, at its teardown.
+//
+// Protect publishes the pointer it loaded, then loads again to check it is still the one there:
+// once it has been unlinked, no new reader can find it, so a Reclaim that scans after the unlink
+// sees every hazard that matters. Reclaim collects the slots of every registered context and
+// frees each retired entry none of them names; Retire calls it once PendingCount() reaches
+// twice the number of slots (or scanThreshold, whichever is more), which makes the scan cost
+// constant per retirement and leaves at most one protected entry per slot behind. Memory under
+// slow readers is bounded by the slots they hold, not by how long they hold them.
+//
+// A domain is cooperator-local, as a Manager is: Retire, Reclaim and its destruction happen on
+// the one thread. Readers may be anywhere, and may migrate while holding a hazard: the slots
+// belong to the context, not to a cooperator. Entries share the RetireEntry interface with
+// Manager and Domain, so a structure picks its scheme per use; m_retiredAt goes unused. A hazard
+// names the RetireEntry, so an object is protected through the entry that retires it.
+//
+
+static constexpr size_t HAZARD_SLOTS = 4;
+
+namespace detail
+{
+
+// One context's hazards. The context writes them; Reclaim on any thread reads them.
+//
+struct HazardSlots : EmbeddedListHookups<HazardSlots>
+{
+    HazardSlots();
+    ~HazardSlots();
+
+    std::atomic<RetireEntry const*> slots[HAZARD_SLOTS] = {};
+    uint32_t                        taken{0};           // bitmask, owner only
+};
+
+// The calling context's slots, constructed and registered on its first hazard
+//
+HazardSlots* Slots(Context* ctx);
+
+} // end namespace coop::epoch::detail
+
+struct HazardDomain
+{
+    HazardDomain(HazardDomain const&) = delete;
+    HazardDomain(HazardDomain&&) = delete;
+
+    explicit HazardDomain(size_t scanThreshold = 64)
+    : m_scanThreshold(scanThreshold)
+    {
+    }
+
+    // No reader may still protect an entry retired here
+    //
+    ~HazardDomain();
+
+    // Queue an entry already unlinked from the structure; reclaims once enough have queued
+    //
+    void Retire(RetireEntry* entry);
+
+    // Free every queued entry no hazard names. Returns the number freed.
+    //
+    size_t Reclaim();
+
+    size_t PendingCount() const { return m_retireCount; }
+
+    struct Stats
+    {
+        uint64_t scans;         // Reclaim passes
+        uint64_t reclaimed;     // entries freed
+        uint64_t deferred;      // entries a pass found protected and kept
+    };
+
+    Stats GetStats() const { return m_stats; }
+
+    // Slots registered process-wide: contexts that have taken a hazard, times HAZARD_SLOTS
+    //
+    static size_t RegisteredSlots();
+
+  private:
+    size_t                      m_scanThreshold;
+    RetireEntry*                m_retireHead{nullptr};
+    size_t                      m_retireCount{0};
+    bool                        m_reclaiming{false};
+    std::vector<RetireEntry const*> m_scratch;
+    Stats                       m_stats{};
+};
+
+// One hazard slot, held for the guard's lifetime. A context holds at most HAZARD_SLOTS at once.
+//
+struct HazardGuard
+{
+    HazardGuard(HazardGuard const&) = delete;
+    HazardGuard(HazardGuard&&) = delete;
+
+    HazardGuard()
+    : HazardGuard(Self())
+    {
+    }
+
+    explicit HazardGuard(Context* ctx);
+    ~HazardGuard();
+
+    // Load src and protect what it pointed to: on return the node cannot be reclaimed until the
+    // guard protects something else or is destroyed. Null when src was.
+    //
+    template<typename T>
+    T* Protect(std::atomic<T*> const& src)
+    {
+        static_assert(std::is_base_of_v<RetireEntry, T>, "hazards name RetireEntry nodes");
+
+        T* p = src.load(std::memory_order_acquire);
+        for (;;)
+        {
+            m_slot->store(p, std::memory_order_seq_cst);
+            T* again = src.load(std::memory_order_seq_cst);
+            if (again == p)
+            {
+                return p;
+            }
+            p = again;
+        }
+    }
+
+    // Protect an entry the caller knows to be still reachable, e.g. one found through a node
+    // this context already protects
+    //
+    void Set(RetireEntry const* entry) { m_slot->store(entry, std::memory_order_seq_cst); }
+
+    void Reset() { m_slot->store(nullptr, std::memory_order_release); }
+
+  private:
+    detail::HazardSlots*                m_slots;
+    std::atomic<RetireEntry const*>*    m_slot;
+    uint32_t                            m_bit;
+};
+
+} // end namespace coop::epoch
+} // end namespace coop
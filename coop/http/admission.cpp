@@ -0,0 +1,173 @@
+#include "admission.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "coop/context.h"
+#include "coop/coordinate_with.h"
+#include "coop/self.h"
+#include "coop/shared_stack.h"
+
+namespace coop
+{
+namespace http
+{
+
+namespace
+{
+
+// Gradient: the recent average follows each sample by this much, the long-term one by far less
+//
+constexpr double kShortWeight = 0.5;
+constexpr double kLongWeight = 0.01;
+
+// Gradient: how much slower than the long-term average recent latency may run before the limit
+// comes down, and how much of each new limit carries over
+//
+constexpr double kTolerance = 1.5;
+constexpr double kSmoothing = 0.2;
+
+} // end anonymous namespace
+
+AdmissionControl::AdmissionControl(AdmissionConfiguration const& config)
+: m_config(config)
+, m_limit(config.maxInFlight)
+, m_estimate(double(config.maxInFlight))
+{
+    m_config.minInFlight = std::clamp<size_t>(m_config.minInFlight, 1,
+                                              std::max<size_t>(config.maxInFlight, 1));
+}
+
+bool AdmissionControl::AdmitConnection()
+{
+    if (m_config.maxConnections && m_connections >= m_config.maxConnections)
+    {
+        m_rejectedConnections++;
+        return false;
+    }
+    m_connections++;
+    return true;
+}
+
+void AdmissionControl::ConnectionClosed()
+{
+    m_connections--;
+}
+
+bool AdmissionControl::BeginRequest(Context* ctx)
+{
+    if (!m_config.maxInFlight || m_inFlight < m_limit)
+    {
+        m_inFlight++;
+        return true;
+    }
+    if (m_queued >= m_config.maxQueued)
+    {
+        m_shedRequests++;
+        return false;
+    }
+
+    // EndRequest pops the waiter and counts the slot as in flight before releasing it, so a
+    // waiter found granted holds a slot however its wait ended
+    //
+    coop::detail::WaitStorage<Waiter> stored(ctx, ctx);
+    Waiter& waiter = *stored.Get();
+    m_waiters.Push(&waiter);
+    m_queued++;
+    auto result = CoordinateWithKill(ctx, &waiter.coord, m_config.queueTimeout);
+
+    if (!waiter.granted)
+    {
+        m_waiters.Remove(&waiter);
+        m_queued--;
+        m_shedRequests++;
+        return false;
+    }
+    if (result.Killed())
+    {
+        m_inFlight--;
+        GrantWaiters();
+        return false;
+    }
+    return true;
+}
+
+void AdmissionControl::EndRequest(time::Interval latency)
+{
+    if (m_config.maxInFlight && m_config.limit != AdmissionConfiguration::Limit::FIXED)
+    {
+        Adapt(latency);
+    }
+    m_inFlight--;
+    GrantWaiters();
+}
+
+void AdmissionControl::GrantWaiters()
+{
+    while (m_inFlight < m_limit && !m_waiters.IsEmpty())
+    {
+        auto* waiter = m_waiters.Pop();
+        waiter->granted = true;
+        m_queued--;
+        m_inFlight++;
+        waiter->coord.Release(Self(), false);
+    }
+}
+
+void AdmissionControl::Adapt(time::Interval latency)
+{
+    double sample = double(std::max<int64_t>(latency.count(), 1));
+    double lo = double(m_config.minInFlight);
+    double hi = double(m_config.maxInFlight);
+
+    if (m_config.limit == AdmissionConfiguration::Limit::AIMD)
+    {
+        if (sample > double(m_config.latencyTarget.count()))
+        {
+            m_estimate *= m_config.backoff;
+            m_increase = 0.0;
+        }
+        else if (m_inFlight * 2 >= m_limit)
+        {
+            // Only grow a limit that is in use: an idle server's latency says nothing about more
+            //
+            m_increase += 1.0 / m_estimate;
+            if (m_increase >= 1.0)
+            {
+                m_estimate += 1.0;
+                m_increase = 0.0;
+            }
+        }
+    }
+    else
+    {
+        if (m_longLatency == 0.0)
+        {
+            m_shortLatency = m_longLatency = sample;
+        }
+        m_shortLatency += (sample - m_shortLatency) * kShortWeight;
+        m_longLatency += (sample - m_longLatency) * kLongWeight;
+
+        // A long-term average far above recent latency is stale -- the load that set it has
+        // passed -- and would hold the limit up; let it catch down faster
+        //
+        if (m_longLatency > 2.0 * m_shortLatency)
+        {
+            m_longLatency *= 0.95;
+        }
+
+        double gradient = std::clamp(kTolerance * m_longLatency / m_shortLatency, 0.5, 1.0);
+        double next = m_estimate * gradient + std::sqrt(m_estimate);
+        if (next > m_estimate && m_inFlight * 2 < m_limit)
+        {
+            next = m_estimate;
+        }
+        m_estimate = m_estimate * (1.0 - kSmoothing) + next * kSmoothing;
+    }
+
+    m_estimate = std::clamp(m_estimate, lo, hi);
+    m_limit = static_cast<size_t>(m_estimate);
+}
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "coop/coordinator.h"
+#include "coop/detail/embedded_list.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+
+struct Context;
+
+namespace http
+{
+
+// Admission control for one server (RunServer, RunTlsServer, each member of RunServerGroup).
+// All limits are per server, so per cooperator; zero means unlimited. Everything off by default.
+//
+struct AdmissionConfiguration
+{
+    enum class Limit : uint8_t
+    {
+        FIXED,          // maxInFlight as given
+        AIMD,           // +1 per limit's worth of fast requests, * backoff on a slow one
+        GRADIENT,       // scaled by long-term / recent latency, plus sqrt(limit) of headroom
+    };
+
+    // Open connections. An accepted connection past it is answered with the canned 503
+    // (response::SERVICE_UNAVAILABLE) and closed, without a handler context.
+    //
+    size_t maxConnections = 0;
+
+    // Requests being handled at once, from a parsed request line to the handler's return. One
+    // past the limit waits, in arrival order, for a slot; past maxQueued waiting, or after
+    // queueTimeout, it is answered 503 and its connection closed. With an adaptive limit this is
+    // the ceiling, and the limit starts there.
+    //
+    size_t maxInFlight = 0;
+    size_t maxQueued = 64;
+    time::Interval queueTimeout = std::chrono::seconds(1);
+
+    // Adaptive limits move between minInFlight and maxInFlight on the handlers' measured latency
+    //
+    Limit limit = Limit::FIXED;
+    size_t minInFlight = 4;
+
+    // AIMD: a request slower than latencyTarget backs the limit off
+    //
+    time::Interval latencyTarget = std::chrono::milliseconds(50);
+    double backoff = 0.9;
+};
+
+// The server's admission state. Single-cooperator, like everything a server's connections share,
+// so plain counters; it lives as long as the cooperator, since a connection can outlast its
+// server's accept loop.
+//
+struct AdmissionControl
+{
+    explicit AdmissionControl(AdmissionConfiguration const& config);
+
+    AdmissionControl(AdmissionControl const&) = delete;
+    AdmissionControl& operator=(AdmissionControl const&) = delete;
+
+    // Count a new connection in. False, counting nothing, when it would exceed maxConnections.
+    //
+    bool AdmitConnection();
+    void ConnectionClosed();
+
+    // Take a request slot for ctx, waiting in the queue if none is free. False when the request
+    // is shed: the queue is full, the wait timed out, or ctx was killed.
+    //
+    bool BeginRequest(Context* ctx);
+
+    // Give the slot back, with how long the handler took, and hand it to the longest waiter
+    //
+    void EndRequest(time::Interval latency);
+
+    size_t Limit() const { return m_limit; }
+    size_t InFlight() const { return m_inFlight; }
+    size_t Queued() const { return m_queued; }
+    size_t Connections() const { return m_connections; }
+
+    uint64_t RejectedConnections() const { return m_rejectedConnections; }
+    uint64_t ShedRequests() const { return m_shedRequests; }
+
+  private:
+    struct Waiter : EmbeddedListHookups<Waiter>
+    {
+        explicit Waiter(Context* ctx) : coord(ctx) {}
+
+        Coordinator     coord;
+        bool            granted = false;
+    };
+
+    void Adapt(time::Interval latency);
+    void GrantWaiters();
+
+    AdmissionConfiguration  m_config;
+    EmbeddedList<Waiter>    m_waiters;
+
+    size_t      m_limit;
+    size_t      m_inFlight = 0;
+    size_t      m_queued = 0;
+    size_t      m_connections = 0;
+
+    uint64_t    m_rejectedConnections = 0;
+    uint64_t    m_shedRequests = 0;
+
+    // Adaptive state: the fractional limit, the AIMD increase carried between requests, and the
+    // gradient's short- and long-term latency averages (microseconds, 0 = no sample yet)
+    //
+    double      m_estimate;
+    double      m_increase = 0.0;
+    double      m_shortLatency = 0.0;
+    double      m_longLatency = 0.0;
+};
+
+} // end namespace coop::http
+} // end namespace coop
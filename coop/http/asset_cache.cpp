@@ -0,0 +1,627 @@
+#include "asset_cache.h"
+#include "common_headers.h"
+#include "connection.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/cooperator.h"
+#include "coop/io/open.h"
+#include "coop/io/read.h"
+#include "coop/io/statx.h"
+
+namespace coop
+{
+namespace http
+{
+
+namespace
+{
+
+// A file is only worth loading once it is whole: written and closed, or renamed into place.
+// Directories are watched for what appears and disappears in them.
+//
+constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE
+    | IN_DELETE | IN_DELETE_SELF | IN_ONLYDIR;
+
+// Variants are tried in this order; Negotiate picks among what survives
+//
+constexpr ContentEncoding kCodings[] = {
+    ContentEncoding::ZSTD,
+    ContentEncoding::GZIP,
+    ContentEncoding::DEFLATE,
+};
+
+bool Compressible(const char* contentType)
+{
+    return strncmp(contentType, "text/", 5) == 0
+        || strcmp(contentType, "application/javascript") == 0
+        || strcmp(contentType, "application/json") == 0
+        || strcmp(contentType, "application/wasm") == 0
+        || strcmp(contentType, "image/svg+xml") == 0;
+}
+
+bool Hidden(const char* name)
+{
+    return name[0] == '.';
+}
+
+// Copy bytes into a fresh memfd, seal it against any change, and map it read-only
+//
+bool Seal(std::string_view bytes, AssetCache::Asset::Body* body)
+{
+    int fd = memfd_create("coop-asset", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    if (!bytes.empty())
+    {
+        // The writable mapping must be gone before F_SEAL_WRITE, which refuses while one exists
+        //
+        void* map = MAP_FAILED;
+        if (ftruncate(fd, off_t(bytes.size())) == 0)
+        {
+            map = mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (map == MAP_FAILED)
+        {
+            ::close(fd);
+            return false;
+        }
+        memcpy(map, bytes.data(), bytes.size());
+        munmap(map, bytes.size());
+    }
+
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    if (!bytes.empty())
+    {
+        void* map = mmap(nullptr, bytes.size(), PROT_READ, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED)
+        {
+            ::close(fd);
+            return false;
+        }
+        body->data = static_cast<const char*>(map);
+    }
+    body->size = bytes.size();
+    body->fd = fd;
+    return true;
+}
+
+// The validators and coding lines every answer from this body carries. Vary goes on each of an
+// asset's bodies once it has more than one, the identity body included.
+//
+void FormatHeaders(AssetCache::Asset const& asset, ContentEncoding encoding,
+                   AssetCache::Asset::Body* body)
+{
+    char etag[ETAG_MAX];
+    size_t etagSize = FormatETag(FileInfo{
+        .size = body->size,
+        .mtimeNs = asset.mtimeNs,
+        .encoding = encoding,
+    }, etag);
+    body->etag.assign(etag, etagSize);
+
+    char modified[response::HTTP_DATE_SIZE];
+    response::FormatHttpDate(asset.mtimeNs / 1000000000, modified);
+
+    body->headers = "ETag: ";
+    body->headers += body->etag;
+    body->headers += "\r\nLast-Modified: ";
+    body->headers.append(modified, sizeof(modified));
+    body->headers += "\r\nAccept-Ranges: bytes\r\n";
+    if (encoding != ContentEncoding::IDENTITY || asset.encodings)
+    {
+        auto lines = EncodingHeaders(encoding);
+        body->headers.append(lines.data, lines.size);
+    }
+}
+
+} // end anonymous namespace
+
+AssetCache::Asset::~Asset()
+{
+    for (Body& body : bodies)
+    {
+        if (body.data)
+        {
+            munmap(const_cast<char*>(body.data), body.size);
+        }
+        if (body.fd >= 0)
+        {
+            ::close(body.fd);
+        }
+    }
+}
+
+AssetCache::Ref::Ref(Asset* asset)
+: m_asset(asset)
+{
+    m_asset->m_refs++;
+}
+
+AssetCache::Ref& AssetCache::Ref::operator=(Ref&& other)
+{
+    if (this != &other)
+    {
+        Reset();
+        m_asset = other.m_asset;
+        other.m_asset = nullptr;
+    }
+    return *this;
+}
+
+void AssetCache::Ref::Reset()
+{
+    if (!m_asset)
+    {
+        return;
+    }
+    if (--m_asset->m_refs == 0 && !m_asset->m_cached)
+    {
+        delete m_asset;
+    }
+    m_asset = nullptr;
+}
+
+AssetCache::AssetCache(const char* root, AssetCacheOptions const& options /* = {} */,
+                       Context* ctx /* = Self() */)
+: m_root(root)
+, m_options(options)
+{
+    while (m_root.size() > 1 && m_root.back() == '/')
+    {
+        m_root.pop_back();
+    }
+    if (!m_options.watch)
+    {
+        return;
+    }
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        // Still worth serving from memory; it just will not see changes
+        //
+        spdlog::warn("asset cache inotify_init1 failed errno={}, assets will not reload", errno);
+        return;
+    }
+    m_inotify.emplace(fd);
+
+    // As io::FileCache's: the watcher holds m_watcherExit for its whole run, taken inside Spawn
+    //
+    bool spawned = ctx->GetCooperator()->Spawn([this](Context* watchCtx)
+    {
+        watchCtx->SetName("AssetCacheWatch");
+        m_watcherExit.Acquire(watchCtx);
+        Watch(watchCtx);
+        m_watcherExit.Release(watchCtx, false);
+    }, &m_watcher);
+    if (!spawned)
+    {
+        spdlog::warn("asset cache watcher spawn failed, assets will not reload");
+        m_inotify.reset();
+    }
+}
+
+AssetCache::~AssetCache()
+{
+    auto* ctx = Self();
+    if (m_watcher)
+    {
+        m_watcher.Kill();
+    }
+    m_watcherExit.Acquire(ctx);
+    m_watcherExit.Release(ctx, false);
+
+    Clear();
+}
+
+int AssetCache::Load()
+{
+    ++m_generation;
+    int result = Walk("");
+    if (result < 0)
+    {
+        return result;
+    }
+
+    // What the walk did not come across is gone from the tree
+    //
+    std::vector<Asset*> stale;
+    for (auto& [path, asset] : m_assets)
+    {
+        if (asset->m_generation != m_generation)
+        {
+            stale.push_back(asset);
+        }
+    }
+    for (Asset* asset : stale)
+    {
+        Drop(asset);
+    }
+    return static_cast<int>(m_assets.size());
+}
+
+// Load every file under dir, a path from root, and watch every directory on the way. readdir
+// blocks, as opendir does in topology.cpp; it reads the kernel's cached directory, and the file
+// reads, the slow part, go through the ring.
+//
+int AssetCache::Walk(std::string const& dir)
+{
+    std::string full = m_root + dir;
+    DIR* d = opendir(full.c_str());
+    if (!d)
+    {
+        return -errno;
+    }
+    if (m_inotify)
+    {
+        int wd = inotify_add_watch(m_inotify->m_fd, full.c_str(), kWatchMask);
+        if (wd >= 0)
+        {
+            m_dirs[wd] = dir;
+        }
+    }
+
+    std::vector<std::string> files;
+    std::vector<std::string> dirs;
+    while (struct dirent* entry = readdir(d))
+    {
+        if (Hidden(entry->d_name))
+        {
+            continue;
+        }
+        std::string path = dir + "/" + entry->d_name;
+        if (entry->d_type == DT_DIR)
+        {
+            dirs.push_back(std::move(path));
+        }
+        else if (entry->d_type == DT_REG || entry->d_type == DT_UNKNOWN)
+        {
+            files.push_back(std::move(path));
+        }
+    }
+    closedir(d);
+
+    for (auto const& path : files)
+    {
+        LoadFile(path);
+    }
+    for (auto const& path : dirs)
+    {
+        Walk(path);
+    }
+    return 0;
+}
+
+// Read one file and its variants into a new asset, replacing the one at path. A file that cannot
+// be held -- gone, not regular, too big, over budget -- drops the old asset instead, so a request
+// for it misses through to whatever serves from disk.
+//
+int AssetCache::LoadFile(std::string const& path)
+{
+    std::string full = m_root + path;
+
+    auto skip = [&](int result)
+    {
+        m_stats.skipped++;
+        auto it = m_assets.find(path);
+        if (it != m_assets.end())
+        {
+            Drop(it->second);
+        }
+        return result;
+    };
+
+    struct statx stx;
+    int result = io::Statx(full.c_str(), 0, STATX_TYPE | STATX_SIZE | STATX_MTIME, &stx);
+    if (result < 0)
+    {
+        return skip(result);
+    }
+    if (!S_ISREG(stx.stx_mode))
+    {
+        return skip(-EINVAL);
+    }
+    if (stx.stx_size > m_options.maxAssetSize)
+    {
+        return skip(-EFBIG);
+    }
+
+    int fd = io::Open(full.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return skip(fd);
+    }
+    io::Descriptor file(fd);
+
+    std::string content(stx.stx_size, '\0');
+    size_t at = 0;
+    while (at < content.size())
+    {
+        int n = io::Read(file, content.data() + at, content.size() - at, at);
+        if (n <= 0)
+        {
+            return skip(n < 0 ? n : -EIO);
+        }
+        at += size_t(n);
+    }
+
+    auto* asset = new Asset;
+    asset->path = path;
+    asset->mtimeNs = stx.stx_mtime.tv_sec * 1'000'000'000LL + stx.stx_mtime.tv_nsec;
+    asset->contentType = m_options.classify ? m_options.classify(full.c_str()) : nullptr;
+    if (!asset->contentType)
+    {
+        asset->contentType = "application/octet-stream";
+    }
+    asset->m_generation = m_generation;
+
+    size_t bytes = content.size();
+    bool sealed = Seal(content, &asset->bodies[static_cast<size_t>(ContentEncoding::IDENTITY)]);
+    if (sealed && Compressible(asset->contentType)
+        && content.size() >= m_options.compression.minSize)
+    {
+        std::string coded;
+        for (ContentEncoding encoding : kCodings)
+        {
+            if (!(m_options.encodings & EncodingBit(encoding)) || !EncodingSupported(encoding))
+            {
+                continue;
+            }
+            coded.clear();
+            if (Compressor::CompressAll(encoding, m_options.compression, content.data(),
+                                        content.size(), &coded)
+                && Seal(coded, &asset->bodies[static_cast<size_t>(encoding)]))
+            {
+                asset->encodings |= EncodingBit(encoding);
+                bytes += coded.size();
+            }
+        }
+    }
+
+    auto it = m_assets.find(path);
+    size_t held = m_bytes;
+    if (it != m_assets.end())
+    {
+        for (Asset::Body const& body : it->second->bodies)
+        {
+            held -= body.size;
+        }
+    }
+    if (!sealed || held + bytes > m_options.maxBytes)
+    {
+        if (sealed)
+        {
+            spdlog::warn("asset cache over maxBytes={}, leaving out path={}",
+                         m_options.maxBytes, path);
+        }
+        delete asset;
+        return skip(sealed ? -ENOSPC : -ENOMEM);
+    }
+
+    for (ContentEncoding encoding : {ContentEncoding::IDENTITY, ContentEncoding::GZIP,
+                                     ContentEncoding::DEFLATE, ContentEncoding::ZSTD})
+    {
+        auto& body = asset->bodies[static_cast<size_t>(encoding)];
+        if (encoding == ContentEncoding::IDENTITY || (asset->encodings & EncodingBit(encoding)))
+        {
+            FormatHeaders(*asset, encoding, &body);
+        }
+    }
+    Insert(asset);
+    return 0;
+}
+
+void AssetCache::Insert(Asset* asset)
+{
+    auto it = m_assets.find(asset->path);
+    if (it != m_assets.end())
+    {
+        Drop(it->second);
+    }
+    for (Asset::Body const& body : asset->bodies)
+    {
+        m_bytes += body.size;
+    }
+    asset->m_cached = true;
+    m_assets.emplace(asset->path, asset);
+}
+
+void AssetCache::Drop(Asset* asset)
+{
+    m_assets.erase(asset->path);
+    for (Asset::Body const& body : asset->bodies)
+    {
+        m_bytes -= body.size;
+    }
+    asset->m_cached = false;
+    if (asset->m_refs == 0)
+    {
+        delete asset;
+    }
+}
+
+void AssetCache::DropUnder(std::string const& dir)
+{
+    std::string prefix = dir + "/";
+    std::vector<Asset*> under;
+    for (auto& [path, asset] : m_assets)
+    {
+        if (path.compare(0, prefix.size(), prefix) == 0)
+        {
+            under.push_back(asset);
+        }
+    }
+    for (Asset* asset : under)
+    {
+        Drop(asset);
+    }
+}
+
+void AssetCache::Clear()
+{
+    while (!m_assets.empty())
+    {
+        Drop(m_assets.begin()->second);
+    }
+}
+
+AssetCache::Ref AssetCache::Lookup(std::string_view path)
+{
+    path = path.substr(0, path.find('?'));
+
+    char indexed[512];
+    if (!path.empty() && path.back() == '/')
+    {
+        int n = snprintf(indexed, sizeof(indexed), "%.*sindex.html", int(path.size()), path.data());
+        if (n < 0 || size_t(n) >= sizeof(indexed))
+        {
+            m_stats.misses++;
+            return Ref();
+        }
+        path = std::string_view(indexed, size_t(n));
+    }
+
+    auto it = m_assets.find(path);
+    if (it == m_assets.end())
+    {
+        m_stats.misses++;
+        return Ref();
+    }
+    m_stats.hits++;
+    return Ref(it->second);
+}
+
+bool AssetCache::Send(ConnectionBase& conn, FileConditions const& conditions, Asset const& asset)
+{
+    ContentEncoding encoding = conn.AcceptedEncodings().Negotiate(asset.encodings);
+    Asset::Body const& body = asset.Get(encoding);
+
+    // The body is coded already and its lines carry the coding; the connection must not code it
+    // again. SendFileResponse below replaces the lines with its own, and announces the coding.
+    //
+    conn.EnableCompression(nullptr);
+    conn.SetResponseHeaders(body.headers);
+
+    // The revalidation a browser sends for an asset it holds: its own ETag back, alone
+    //
+    if (!conditions.ifNoneMatch.empty() && conditions.ifNoneMatch == body.etag)
+    {
+        return conn.SendHeaders(304, asset.contentType, body.size);
+    }
+
+    if (!conditions.ifNoneMatch.empty() || !conditions.ifModifiedSince.empty()
+        || !conditions.range.empty())
+    {
+        return SendFileResponse(conn, conditions, FileInfo{
+            .fd = body.fd,
+            .size = body.size,
+            .mtimeNs = asset.mtimeNs,
+            .contentType = asset.contentType,
+            .encoding = encoding,
+        });
+    }
+
+    return conn.Send(200, asset.contentType, body.data, body.size);
+}
+
+void AssetCache::Watch(Context* ctx)
+{
+    alignas(struct inotify_event) char buf[4096];
+    while (!ctx->IsKilled())
+    {
+        int n = io::ReadKill(*m_inotify, buf, sizeof(buf));
+        if (n <= 0)
+        {
+            if (n < 0 && n != -ECANCELED)
+            {
+                spdlog::warn("asset cache inotify read failed err={}, assets will not reload", n);
+            }
+            return;
+        }
+
+        for (int off = 0; off < n;)
+        {
+            auto* event = reinterpret_cast<struct inotify_event*>(buf + off);
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                spdlog::warn("asset cache inotify queue overflow, reloading {} assets", Size());
+                Load();
+            }
+            else
+            {
+                OnEvent(event->wd, event->mask, event->len ? event->name : "");
+            }
+            off += static_cast<int>(sizeof(struct inotify_event) + event->len);
+        }
+    }
+}
+
+void AssetCache::OnEvent(int wd, uint32_t mask, const char* name)
+{
+    auto it = m_dirs.find(wd);
+    if (it == m_dirs.end())
+    {
+        return;
+    }
+    if (mask & IN_IGNORED)
+    {
+        m_dirs.erase(it);
+        return;
+    }
+    if (!name[0] || Hidden(name))
+    {
+        return;
+    }
+
+    std::string path = it->second + "/" + name;
+    if (mask & IN_ISDIR)
+    {
+        if (mask & (IN_CREATE | IN_MOVED_TO))
+        {
+            Walk(path);
+        }
+        else if (mask & (IN_DELETE | IN_MOVED_FROM))
+        {
+            DropUnder(path);
+        }
+        return;
+    }
+
+    if (mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+    {
+        SPDLOG_DEBUG("asset cache reload path={}", path);
+        m_stats.reloads++;
+        LoadFile(path);
+    }
+    else if (mask & (IN_DELETE | IN_MOVED_FROM))
+    {
+        auto asset = m_assets.find(path);
+        if (asset != m_assets.end())
+        {
+            Drop(asset->second);
+        }
+    }
+}
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "compression.h"
+#include "file_response.h"
+
+#include "coop/context.h"
+#include "coop/coordinator.h"
+#include "coop/self.h"
+#include "coop/io/descriptor.h"
+
+namespace coop
+{
+namespace http
+{
+
+struct ConnectionBase;
+
+struct AssetCacheOptions
+{
+    // Files bigger than this are left on disk, for io::FileCache and SendFileResponse to serve;
+    // past maxBytes in all, bodies and coded variants counted, further files are left out too
+    //
+    size_t maxAssetSize = 1 << 20;
+    size_t maxBytes = 64 << 20;
+
+    // Codings precomputed for each text asset, as an EncodingBit mask, and how hard to try. The
+    // work is done once per load, so the levels default to the slow end; a variant that does not
+    // come out smaller is not kept.
+    //
+    uint8_t encodings = EncodingBit(ContentEncoding::GZIP) | EncodingBit(ContentEncoding::ZSTD);
+    CompressionOptions compression = {.minSize = 256, .gzipLevel = 9, .zstdLevel = 19};
+
+    // Content type by path, e.g. from the extension; the returned string must be static.
+    // "application/octet-stream" without one.
+    //
+    const char* (*classify)(const char* path) = nullptr;
+
+    // Reload a file when it is rewritten or moved into place, and drop it when it goes, through
+    // inotify on every directory of the tree
+    //
+    bool watch = true;
+};
+
+struct AssetCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t reloads = 0;       // files loaded again after a change
+    uint64_t skipped = 0;       // files left out: too big, over maxBytes, or failed to load
+};
+
+// A directory tree of small static assets held in memory, for servers whose hot path is answering
+// the same few hundred files -- an SPA's bundles, its index, its icons. Each file is read once,
+// into a sealed memfd mapped read-only, with its gzip and zstd variants beside it and, for each,
+// the header lines its answers carry (ETag, Last-Modified, Accept-Ranges, the coding) formatted
+// ahead of time. A hit is then one conn.Send of those lines and the mapped body: gathered into one
+// write, or sent zero-copy above the connection's threshold, with no open, stat, page-cache lookup
+// or compression per request. The seals mean the body a zero-copy send points at can never change
+// under it.
+//
+// Conditional requests matching an asset's ETag exactly get their 304 the same way. Any other
+// conditional or Range request goes through SendFileResponse (file_response.h) on the memfd, which
+// is a file like any other, so the answers are the ones io::FileCache serving would give.
+//
+// Load walks the tree from root; dot-files and everything but regular files and directories are
+// skipped. With AssetCacheOptions::watch a watcher context keeps an inotify read in flight, and a
+// file written (closed after writing) or moved into place is loaded again, one removed or moved
+// away is dropped, and a new directory is walked. An inotify queue overflow reloads the lot.
+//
+// Lookup returns a Ref that pins the asset: one replaced or dropped while a response is sending it
+// stays mapped until its last Ref goes, and Refs may outlive the cache.
+//
+// One cache per cooperator (a CooperatorVar, or a member of something per-cooperator), created and
+// destroyed on a context of it; Refs are not shared across threads.
+//
+//  void Assets(ConnectionBase& conn)       // routed as "/*path"
+//  {
+//      FileConditions conditions;
+//      conditions.Read(conn);
+//      if (auto asset = s_assets->Lookup(conn.GetRequestLine()->path))
+//      {
+//          AssetCache::Send(conn, conditions, *asset);
+//          return;
+//      }
+//      conn.Send(404, "text/plain", "Not Found\n");
+//  }
+//
+struct AssetCache
+{
+    struct Asset
+    {
+        // One representation: the identity body, or a coded variant
+        //
+        struct Body
+        {
+            const char*     data = nullptr;     // the memfd's read-only mapping; null when empty
+            size_t          size = 0;
+            int             fd = -1;            // the sealed memfd
+            std::string     etag;               // as FormatETag makes it for this representation
+            std::string     headers;            // the lines for SetResponseHeaders
+        };
+
+        ~Asset();
+
+        Body const& Get(ContentEncoding encoding) const
+        {
+            return bodies[static_cast<size_t>(encoding)];
+        }
+
+        std::string     path;                   // from root, with a leading '/'
+        const char*     contentType = nullptr;
+        int64_t         mtimeNs = 0;
+        uint8_t         encodings = 0;          // EncodingBit of each coded variant held
+        Body            bodies[4];              // by ContentEncoding
+
+    private:
+        friend struct AssetCache;
+
+        int             m_refs = 0;
+        bool            m_cached = false;
+        uint64_t        m_generation = 0;
+    };
+
+    struct Ref
+    {
+        Ref() = default;
+        explicit Ref(Asset* asset);
+        Ref(Ref&& other) : m_asset(other.m_asset) { other.m_asset = nullptr; }
+        Ref& operator=(Ref&& other);
+        ~Ref() { Reset(); }
+
+        Ref(Ref const&) = delete;
+        Ref& operator=(Ref const&) = delete;
+
+        explicit operator bool() const { return m_asset != nullptr; }
+        Asset const* operator->() const { return m_asset; }
+        Asset const& operator*() const { return *m_asset; }
+
+        void Reset();
+
+    private:
+        Asset* m_asset = nullptr;
+    };
+
+    // Nothing is loaded until Load. The watcher, if any, starts here on ctx's cooperator.
+    //
+    AssetCache(const char* root, AssetCacheOptions const& options = {}, Context* ctx = Self());
+    ~AssetCache();
+
+    AssetCache(AssetCache const&) = delete;
+    AssetCache& operator=(AssetCache const&) = delete;
+
+    // Walk the tree, loading every file, and drop assets whose file is gone. Blocks the calling
+    // context on the reads. Returns the assets held after it, or the negative errno of opening
+    // root.
+    //
+    int Load();
+
+    // The asset at a request path ("/app.js"; a path ending in '/' means its index.html). The query
+    // string, if any, is ignored.
+    //
+    Ref Lookup(std::string_view path);
+
+    // Answer a GET for asset, in the coding the request's Accept-Encoding prefers among those it
+    // holds, honoring conditions (see above). After conditions.Read, which completes the parsed
+    // Accept-Encoding. Returns false on a send failure.
+    //
+    static bool Send(ConnectionBase& conn, FileConditions const& conditions, Asset const& asset);
+
+    void Clear();
+
+    size_t Size() const { return m_assets.size(); }
+    size_t Bytes() const { return m_bytes; }
+    AssetCacheStats const& Stats() const { return m_stats; }
+
+private:
+    int Walk(std::string const& dir);
+    int LoadFile(std::string const& path);
+    void Insert(Asset* asset);
+    void Drop(Asset* asset);
+    void DropUnder(std::string const& dir);
+
+    void Watch(Context* ctx);
+    void OnEvent(int wd, uint32_t mask, const char* name);
+
+    std::string                                         m_root;
+    AssetCacheOptions                                   m_options;
+    AssetCacheStats                                     m_stats;
+    size_t                                              m_bytes = 0;
+
+    // Bumped per Load, so the assets it did not come across can be told apart afterwards
+    //
+    uint64_t                                            m_generation = 0;
+
+    std::unordered_map<std::string_view, Asset*>        m_assets;
+
+    // The inotify watch of each directory, to the directory's path from root ("" for root)
+    //
+    std::unordered_map<int, std::string>                m_dirs;
+
+    std::optional<io::Descriptor>                       m_inotify;
+    Coordinator                                         m_watcherExit;
+    Context::Handle                                     m_watcher;
+};
+
+} // end namespace coop::http
+} // end namespace coop
@@ -1,13 +1,17 @@
 #include "client.h"
 #include "connection.h"
+#include "scan.h"
 #include "transport.h"
 #include "tls_transport.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cstdio>
 #include <cstring>
 #include <strings.h>
 
+#include "coop/trace.h"
+
 namespace coop
 {
 namespace http
@@ -36,16 +40,24 @@ ClientConnectionImpl<Derived>::ClientConnectionImpl(
 , m_pendingConnection(false)
 , m_keepAlive(true)
 , m_serverClose(false)
+, m_pipelining(false)
+, m_chunkedRequest(false)
+, m_outstanding(0)
 {
 }
 
 template<typename Derived>
 void ClientConnectionImpl<Derived>::Reset()
 {
+    // A response begun is one fewer outstanding, read to its end or not
+    //
+    if (m_responseLineParsed && m_outstanding > 0)
+    {
+        m_outstanding--;
+    }
     Compact();
 
     m_parsePos              = 0;
-    m_sendLen               = 0;
     m_phase                 = RESPONSE_LINE;
     m_contentLength         = -1;
     m_chunkedBody           = false;
@@ -61,6 +73,22 @@ void ClientConnectionImpl<Derived>::Reset()
     m_serverClose           = false;
 }
 
+template<typename Derived>
+bool ClientConnectionImpl<Derived>::Recycle()
+{
+    if (m_outstanding > 1) return false;
+    if (m_outstanding == 1)
+    {
+        if (!m_responseLineParsed || m_responseLine.status <= 0) return false;
+        SkipBody();
+        if (m_chunkedBody ? !m_chunkedDone : m_bodyRemaining > 0) return false;
+    }
+    if (!KeepAlive()) return false;
+
+    Reset();
+    return m_bufLen == 0 && m_sendLen == 0;
+}
+
 // -------------------------------------------------------------------------------------
 // Buffer management
 // -------------------------------------------------------------------------------------
@@ -74,6 +102,10 @@ int ClientConnectionImpl<Derived>::RecvMore()
         if (m_bufLen >= RecvBufSize()) return 0;
     }
 
+    // Queued pipelined requests go out before we wait on their responses
+    //
+    if (m_sendLen > 0 && !Flush()) return -1;
+
     int n = TransportRecv(RecvBuf() + m_bufLen, RecvBufSize() - m_bufLen, 0, m_timeout);
     if (n <= 0) return -1;
 
@@ -511,6 +543,45 @@ Chunk* ClientConnectionImpl<Derived>::ReadBody()
     return &m_chunk;
 }
 
+template<typename Derived>
+Chunk* ClientConnectionImpl<Derived>::ReadBufferedBody()
+{
+    if (m_phase < BODY)
+    {
+        if (!AdvanceToPhase(BODY)) return nullptr;
+    }
+    if (m_phase != BODY || m_chunkedBody || m_parsePos == m_bufLen) return nullptr;
+    return ReadBody();
+}
+
+template<typename Derived>
+void ClientConnectionImpl<Derived>::MarkBodyRead(size_t size)
+{
+    if (m_phase != BODY || m_chunkedBody) return;
+
+    if (m_bodyRemaining == 0 && m_contentLength > 0)
+    {
+        m_bodyRemaining = static_cast<size_t>(m_contentLength);
+    }
+    m_bodyRemaining -= std::min(size, m_bodyRemaining);
+    if (m_bodyRemaining == 0)
+    {
+        m_phase = DONE;
+    }
+}
+
+template<typename Derived>
+void ClientConnectionImpl<Derived>::EndWithoutBody()
+{
+    if (m_phase < BODY)
+    {
+        if (!AdvanceToPhase(BODY)) return;
+    }
+    m_bodyRemaining = 0;
+    m_chunkedBody = false;
+    m_phase = DONE;
+}
+
 template<typename Derived>
 void ClientConnectionImpl<Derived>::SkipBody()
 {
@@ -561,6 +632,12 @@ Chunk* ClientConnectionImpl<Derived>::ReadChunkedBody()
                     return &m_chunk;
                 }
             }
+            if (memcmp(RecvBuf() + m_parsePos, "\r\n", 2) != 0)
+            {
+                m_chunk.complete = true;
+                MalformedChunk();
+                return &m_chunk;
+            }
             m_parsePos += 2;
         }
 
@@ -578,22 +655,19 @@ Chunk* ClientConnectionImpl<Derived>::ReadChunkedBody()
         if (cr && cr + 1 < RecvBuf() + m_bufLen && cr[1] == '\n')
         {
             size_t i = cr - RecvBuf();
-            size_t chunkSize = 0;
-            for (size_t j = m_parsePos; j < i; j++)
+            uint64_t chunkSize = 0;
+            if (!detail::ParseChunkSize(RecvBuf() + m_parsePos, i - m_parsePos, searchLen,
+                                        &chunkSize))
             {
-                char c = RecvBuf()[j];
-                if (c == ';') break;
-
-                chunkSize <<= 4;
-                if (c >= '0' && c <= '9') chunkSize += c - '0';
-                else if (c >= 'a' && c <= 'f') chunkSize += c - 'a' + 10;
-                else if (c >= 'A' && c <= 'F') chunkSize += c - 'A' + 10;
+                MalformedChunk();
+                return nullptr;
             }
 
             m_parsePos = i + 2;
 
             if (chunkSize == 0)
             {
+                SkipTrailers();
                 m_chunkedDone = true;
                 m_phase = DONE;
                 return nullptr;
@@ -608,6 +682,47 @@ Chunk* ClientConnectionImpl<Derived>::ReadChunkedBody()
     }
 }
 
+// The trailer section after the last chunk, through the blank line ending the message. Left
+// unread, it would open the next response on a reused connection; a connection that fails to
+// deliver it is closed instead.
+//
+template<typename Derived>
+void ClientConnectionImpl<Derived>::SkipTrailers()
+{
+    while (true)
+    {
+        size_t searchLen = m_bufLen > m_parsePos ? m_bufLen - m_parsePos : 0;
+        char* cr = searchLen > 0
+            ? static_cast<char*>(memchr(RecvBuf() + m_parsePos, '\r', searchLen))
+            : nullptr;
+
+        if (cr && cr + 1 < RecvBuf() + m_bufLen && cr[1] == '\n')
+        {
+            size_t lineStart = m_parsePos;
+            m_parsePos = (cr - RecvBuf()) + 2;
+            if (cr - RecvBuf() == static_cast<ptrdiff_t>(lineStart)) return;
+            continue;
+        }
+
+        Compact();
+        if (RecvMore() <= 0)
+        {
+            m_serverClose = true;
+            return;
+        }
+    }
+}
+
+// The response cannot be framed past here: it ends incomplete and the connection is not reused
+//
+template<typename Derived>
+void ClientConnectionImpl<Derived>::MalformedChunk()
+{
+    m_bodyRemaining = 0;
+    m_phase = DONE;
+    m_serverClose = true;
+}
+
 // -------------------------------------------------------------------------------------
 // Write buffer
 // -------------------------------------------------------------------------------------
@@ -691,6 +806,8 @@ bool ClientConnectionImpl<Derived>::SendRequest(
     const char* contentType,
     const void* body, size_t bodySize)
 {
+    m_outstanding++;
+
     // Request line: "METHOD /path HTTP/1.1\r\n"
     //
     if (!Append(method, strlen(method))) return false;
@@ -704,6 +821,8 @@ bool ClientConnectionImpl<Derived>::SendRequest(
     if (!Append(m_host, strlen(m_host))) return false;
     if (!AppendLiteral("\r\n")) return false;
 
+    if (!AppendTraceParent()) return false;
+
     // Content-Type + Content-Length for requests with bodies
     //
     if (body && bodySize > 0 && contentType)
@@ -722,7 +841,84 @@ bool ClientConnectionImpl<Derived>::SendRequest(
         if (!Append(body, bodySize)) return false;
     }
 
-    return Flush();
+    return m_pipelining || Flush();
+}
+
+// The caller's trace context, sampled or not, so the server joins its trace
+//
+template<typename Derived>
+bool ClientConnectionImpl<Derived>::AppendTraceParent()
+{
+    if (!trace::IsTracing()) return true;
+
+    trace::SpanContext const* current = trace::Current();
+    if (!current || !current->Valid()) return true;
+
+    char traceParent[trace::kTraceParentSize];
+    trace::FormatTraceParent(*current, traceParent);
+    return AppendLiteral("traceparent: ") && Append(traceParent, sizeof(traceParent)) &&
+           AppendLiteral("\r\n");
+}
+
+template<typename Derived>
+bool ClientConnectionImpl<Derived>::SendRequestHead(
+    const char* method, std::string_view target, std::string_view headerLines,
+    int64_t contentLength, std::string_view host)
+{
+    m_outstanding++;
+    m_chunkedRequest = contentLength < 0;
+
+    if (!Append(method, strlen(method))) return false;
+    if (!AppendLiteral(" ")) return false;
+    if (!Append(target.data(), target.size())) return false;
+    if (!AppendLiteral(" HTTP/1.1\r\nHost: ")) return false;
+    if (host.empty())
+    {
+        if (!Append(m_host, strlen(m_host))) return false;
+    }
+    else if (!Append(host.data(), host.size()))
+    {
+        return false;
+    }
+    if (!AppendLiteral("\r\n")) return false;
+    if (!AppendTraceParent()) return false;
+    if (!Append(headerLines.data(), headerLines.size())) return false;
+
+    if (m_chunkedRequest)
+    {
+        if (!AppendLiteral("Transfer-Encoding: chunked\r\n")) return false;
+    }
+    else if (contentLength > 0)
+    {
+        if (!AppendLiteral("Content-Length: ")) return false;
+        if (!AppendUInt(static_cast<size_t>(contentLength))) return false;
+        if (!AppendLiteral("\r\n")) return false;
+    }
+    if (!AppendLiteral("\r\n")) return false;
+
+    return m_pipelining || Flush();
+}
+
+template<typename Derived>
+bool ClientConnectionImpl<Derived>::SendBody(const void* data, size_t size)
+{
+    if (size == 0) return true;
+    if (!m_chunkedRequest) return Append(data, size);
+
+    char hex[20];
+    int len = snprintf(hex, sizeof(hex), "%zx\r\n", size);
+    return Append(hex, static_cast<size_t>(len)) && Append(data, size) && AppendLiteral("\r\n");
+}
+
+template<typename Derived>
+bool ClientConnectionImpl<Derived>::EndBody()
+{
+    if (m_chunkedRequest)
+    {
+        m_chunkedRequest = false;
+        if (!AppendLiteral("0\r\n\r\n")) return false;
+    }
+    return m_pipelining || Flush();
 }
 
 template<typename Derived>
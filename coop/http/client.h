@@ -40,6 +40,27 @@ struct ClientConnectionImpl
     bool Post(const char* path, const char* contentType,
               const void* body, size_t bodySize);
 
+    // Streaming requests, for proxies: the request line and the caller's own header lines (each a
+    // complete "Name: value\r\n"), framed for a body of contentLength bytes -- no Content-Length
+    // header for 0 -- or, with -1, chunked. Host is the connection's unless host is given. The body
+    // follows in any number of SendBody calls and ends with EndBody; bytes written to the socket
+    // directly (a splice) in place of SendBody must come after the head is flushed, which it is
+    // unless pipelining.
+    //
+    bool SendRequestHead(const char* method, std::string_view target, std::string_view headerLines,
+                         int64_t contentLength, std::string_view host = {});
+    bool SendBody(const void* data, size_t size);
+    bool EndBody();
+
+    // Pipelining: with it on, SendRequest only queues, and the queue goes out in one send at
+    // FlushRequests or the next response read. Responses come back in request order: read each,
+    // then Reset for the next. Keep a batch to what the socket buffers hold -- the server may
+    // stop reading while its responses go unread.
+    //
+    void SetPipelining(bool on) { m_pipelining = on; }
+    bool FlushRequests() { return Flush(); }
+    uint32_t Outstanding() const { return m_outstanding; }
+
     // --- Response parsing ---
     //
     // Phase 1: Status line. Null on parse failure, connection closed, or timeout.
@@ -61,8 +82,41 @@ struct ClientConnectionImpl
     int64_t ContentLength();
 
     bool KeepAlive() const { return m_keepAlive && !m_serverClose; }
+
+    // Whether the response body is chunked. Meaningful once the headers have been read.
+    //
+    bool ChunkedBody() const { return m_chunkedBody; }
+
+    // Whether the body was read to its end, as opposed to ReadBody stopping on a recv failure
+    //
+    bool BodyComplete() const
+    {
+        return m_phase == DONE && (m_chunkedBody ? m_chunkedDone : m_bodyRemaining == 0);
+    }
+
+    // For proxies moving a Content-Length body past the parser: the part of it already in the recv
+    // buffer, consumed, or null when none is buffered (no recv is made); then MarkBodyRead for the
+    // bytes taken off the socket directly, so the connection can be recycled after.
+    //
+    Chunk* ReadBufferedBody();
+    void MarkBodyRead(size_t size);
+
+    // The response has no body whatever its headers say: it answers a HEAD, or is a 204 or 304
+    //
+    void EndWithoutBody();
+
+    // Ready the parser for the next response. Bytes already received past this one, and requests
+    // still queued, are kept.
+    //
     void Reset();
 
+    // Make the connection ready for another request: drain the rest of any response begun, then
+    // Reset. False when it cannot carry one -- a request is still unanswered, the response ended
+    // short, the server is closing, or it sent bytes nobody asked for. What ClientPool reuse
+    // decides on.
+    //
+    bool Recycle();
+
   private:
     char* RecvBuf() { return static_cast<Derived*>(this)->m_buf; }
     size_t RecvBufSize() const { return static_cast<const Derived*>(this)->m_recvBufSize; }
@@ -105,7 +159,10 @@ struct ClientConnectionImpl
     bool ParseResponseLine();
     bool AdvanceToPhase(Phase target);
     Chunk* ReadChunkedBody();
+    void MalformedChunk();
+    void SkipTrailers();
     bool SendRaw(const void* data, size_t size);
+    bool AppendTraceParent();
 
     io::Descriptor& m_desc;
     const char*     m_host;
@@ -132,6 +189,9 @@ struct ClientConnectionImpl
 
     bool            m_keepAlive;
     bool            m_serverClose;
+    bool            m_pipelining;
+    bool            m_chunkedRequest;
+    uint32_t        m_outstanding;  // requests sent or queued whose response is not done
 };
 
 // ClientConnection<Transport> is the final concrete type. Same trailing-buffer pattern as the
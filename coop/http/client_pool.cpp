@@ -0,0 +1,454 @@
+#include "client_pool.h"
+
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <new>
+#include <optional>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/context.h"
+#include "coop/coordinate_with.h"
+#include "coop/coordinator.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator_var.h"
+#include "coop/cooperator_var.hpp"
+#include "coop/self.h"
+#include "coop/shared_stack.h"
+#include "coop/detail/embedded_list.h"
+#include "coop/io/connect.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/ssl/connection.h"
+#include "coop/io/ssl/context.h"
+#include "coop/time/now.h"
+
+namespace coop
+{
+namespace http
+{
+
+namespace
+{
+
+CooperatorVar<ClientPool> s_pool;
+
+} // end anonymous namespace
+
+// One pooled connection. The socket is owned here and closed with ::close rather than through the
+// Descriptor, whose destructor needs a context to close on -- entries are also torn down from the
+// pool's destructor, when the cooperator goes.
+//
+struct ClientPool::Entry
+{
+    Entry(Host* h, int socket, bool isTls)
+    : host(h)
+    , fd(socket)
+    , tls(isTls)
+    , desc(io::borrowed, socket)
+    {}
+
+    Host*                               host;
+    int                                 fd;
+    bool                                tls;
+    io::Descriptor                      desc;
+    std::optional<io::ssl::Connection>  ssl;
+    void*                               conn = nullptr;     // ClientConnection<Transport>
+    int64_t                             idleSince = 0;
+};
+
+struct ClientPool::Waiter : EmbeddedListHookups<Waiter>
+{
+    explicit Waiter(Context* ctx) : coord(ctx) {}
+
+    Coordinator     coord;
+    bool            granted = false;
+    Entry*          entry = nullptr;    // granted with nullptr: a free slot to connect in
+};
+
+struct ClientPool::Host
+{
+    std::string             key;            // name:port, +tls; also the TLS resumption key
+    std::string             name;
+    int                     port;
+    bool                    tls;
+    std::string             hostHeader;     // name, or name:port off the scheme's default port
+
+    size_t                  open = 0;       // idle + checked out + being connected
+    std::vector<Entry*>     idle;           // most recently returned last
+    EmbeddedList<Waiter>    waiters;
+};
+
+ClientPool::ClientPool(ClientPoolOptions const& options)
+: m_options(options)
+{
+}
+
+ClientPool::~ClientPool()
+{
+    for (auto& it : m_hosts)
+    {
+        for (auto* entry : it.second->idle)
+        {
+            Close(entry);
+        }
+    }
+}
+
+ClientPool& ClientPool::Local()
+{
+    return *s_pool;
+}
+
+void ClientPool::Configure(ClientPoolOptions const& options)
+{
+    m_options = options;
+}
+
+ClientPool::PlainLease ClientPool::Checkout(const char* host, int port)
+{
+    auto* entry = Acquire(host, port, false);
+    return entry ? PlainLease(this, entry) : PlainLease();
+}
+
+ClientPool::TlsLease ClientPool::CheckoutTls(const char* host, int port)
+{
+    if (!m_options.tls)
+    {
+        spdlog::warn("http client pool: TLS checkout of {}:{} with no TLS context", host, port);
+        return TlsLease();
+    }
+    auto* entry = Acquire(host, port, true);
+    return entry ? TlsLease(this, entry) : TlsLease();
+}
+
+size_t ClientPool::Prune()
+{
+    size_t pruned = 0;
+    int64_t now = time::NowCoarse();
+    for (auto& it : m_hosts)
+    {
+        auto& idle = it.second->idle;
+        for (size_t i = 0; i < idle.size();)
+        {
+            if (Healthy(idle[i], now))
+            {
+                i++;
+                continue;
+            }
+            auto* entry = idle[i];
+            idle.erase(idle.begin() + i);
+            Destroy(entry);
+            pruned++;
+        }
+    }
+    return pruned;
+}
+
+size_t ClientPool::Idle() const
+{
+    size_t idle = 0;
+    for (auto const& it : m_hosts)
+    {
+        idle += it.second->idle.size();
+    }
+    return idle;
+}
+
+ClientPool::Entry* ClientPool::Acquire(const char* name, int port, bool tls)
+{
+    std::string key = std::string(name) + ':' + std::to_string(port) + (tls ? "+tls" : "");
+    auto& slot = m_hosts[key];
+    if (!slot)
+    {
+        slot = std::make_unique<Host>();
+        slot->key = key;
+        slot->name = name;
+        slot->port = port;
+        slot->tls = tls;
+        slot->hostHeader = port == (tls ? 443 : 80) ? slot->name : key.substr(0, key.find('+'));
+    }
+    Host& host = *slot;
+
+    // Newest first: the one likeliest to still be alive, and to have a warm window
+    //
+    int64_t now = time::NowCoarse();
+    while (!host.idle.empty())
+    {
+        auto* entry = host.idle.back();
+        host.idle.pop_back();
+        if (Healthy(entry, now))
+        {
+            m_reuses++;
+            return entry;
+        }
+        Destroy(entry);
+    }
+
+    if (host.open < std::max<size_t>(m_options.maxPerHost, 1))
+    {
+        host.open++;
+        return Open(host);
+    }
+
+    // Return and Vacate pop the waiter and hand it a connection or a slot before releasing it,
+    // so a waiter found granted owns one however its wait ended
+    //
+    auto* ctx = Self();
+    coop::detail::WaitStorage<Waiter> stored(ctx, ctx);
+    Waiter& waiter = *stored.Get();
+    host.waiters.Push(&waiter);
+    auto result = CoordinateWithKill(ctx, &waiter.coord, m_options.checkoutTimeout);
+
+    if (!waiter.granted)
+    {
+        host.waiters.Remove(&waiter);
+        return nullptr;
+    }
+    if (result.Killed())
+    {
+        if (waiter.entry)
+        {
+            Give(waiter.entry);
+        }
+        else
+        {
+            Vacate(host);
+        }
+        return nullptr;
+    }
+    if (waiter.entry)
+    {
+        m_reuses++;
+        return waiter.entry;
+    }
+    return Open(host);
+}
+
+// Connect in a slot already counted in host.open. On failure the slot is given up.
+//
+ClientPool::Entry* ClientPool::Open(Host& host)
+{
+    // Raced across the host's addresses, so one blackholed family costs an attempt delay rather
+    // than a connect timeout
+    //
+    int fd = io::ConnectAny(host.name.c_str(), host.port, m_options.connectTimeout,
+                            {.noDelay = true, .fastOpen = m_options.fastOpen});
+    if (fd < 0)
+    {
+        spdlog::warn("http client pool: connect {}:{}: {}", host.name, host.port, strerror(-fd));
+        Vacate(host);
+        return nullptr;
+    }
+
+    auto* entry = new Entry(&host, fd, host.tls);
+
+    if (host.tls)
+    {
+        entry->ssl.emplace(*m_options.tls, entry->desc, io::ssl::SocketBio{});
+
+        // SNI only for names: RFC 6066 rules out literal addresses
+        //
+        in6_addr addr;
+        if (::inet_pton(AF_INET, host.name.c_str(), &addr) != 1 &&
+            ::inet_pton(AF_INET6, host.name.c_str(), &addr) != 1)
+        {
+            SSL_set_tlsext_host_name(entry->ssl->m_ssl, host.name.c_str());
+        }
+        entry->ssl->SetResumptionKey(host.key);
+        if (entry->ssl->HandshakeKill() != 0)
+        {
+            spdlog::warn("http client pool: TLS handshake {}:{} failed", host.name, host.port);
+            Destroy(entry);
+            return nullptr;
+        }
+        if (entry->ssl->SessionReused())
+        {
+            m_resumptions++;
+        }
+
+        using Connection = ClientConnection<TlsTransport>;
+        void* mem = std::malloc(sizeof(Connection) + Connection::ExtraBytes());
+        entry->conn = new (mem) Connection(
+            TlsTransport(*entry->ssl, entry->desc), host.hostHeader.c_str(),
+            Connection::DEFAULT_RECV_SIZE, Connection::DEFAULT_SEND_SIZE, m_options.timeout);
+    }
+    else
+    {
+        using Connection = ClientConnection<PlaintextTransport>;
+        void* mem = std::malloc(sizeof(Connection) + Connection::ExtraBytes());
+        entry->conn = new (mem) Connection(
+            PlaintextTransport(entry->desc), host.hostHeader.c_str(),
+            Connection::DEFAULT_RECV_SIZE, Connection::DEFAULT_SEND_SIZE, m_options.timeout);
+    }
+
+    m_connects++;
+    return entry;
+}
+
+void ClientPool::Return(Entry* entry, bool reuse)
+{
+    if (reuse)
+    {
+        Give(entry);
+    }
+    else
+    {
+        Destroy(entry);
+    }
+}
+
+// A reusable connection goes to the longest waiter, else to the idle list if there is room
+//
+void ClientPool::Give(Entry* entry)
+{
+    Host& host = *entry->host;
+    if (!host.waiters.IsEmpty())
+    {
+        auto* waiter = host.waiters.Pop();
+        waiter->granted = true;
+        waiter->entry = entry;
+        waiter->coord.Release(Self(), false);
+        return;
+    }
+    if (host.idle.size() >= m_options.maxIdlePerHost)
+    {
+        Destroy(entry);
+        return;
+    }
+    entry->idleSince = time::NowCoarse();
+    host.idle.push_back(entry);
+}
+
+// A slot came free: the longest waiter connects in it, or the count comes down
+//
+void ClientPool::Vacate(Host& host)
+{
+    if (!host.waiters.IsEmpty())
+    {
+        auto* waiter = host.waiters.Pop();
+        waiter->granted = true;
+        waiter->entry = nullptr;
+        waiter->coord.Release(Self(), false);
+        return;
+    }
+    host.open--;
+}
+
+void ClientPool::Destroy(Entry* entry)
+{
+    Host& host = *entry->host;
+    Close(entry);
+    Vacate(host);
+}
+
+void ClientPool::Close(Entry* entry)
+{
+    if (entry->conn)
+    {
+        if (entry->tls)
+        {
+            static_cast<ClientConnection<TlsTransport>*>(entry->conn)->~ClientConnection();
+        }
+        else
+        {
+            static_cast<ClientConnection<PlaintextTransport>*>(entry->conn)->~ClientConnection();
+        }
+        std::free(entry->conn);
+    }
+    int fd = entry->fd;
+    delete entry;
+    ::close(fd);
+}
+
+// Idle and quiet: past idleTimeout, or with the peer's FIN (0) or unasked bytes waiting, the
+// next request would likely fail or be answered out of turn
+//
+bool ClientPool::Healthy(Entry* entry, int64_t now) const
+{
+    auto idleMicros = std::chrono::duration_cast<std::chrono::microseconds>(m_options.idleTimeout);
+    if (now - entry->idleSince > idleMicros.count())
+    {
+        return false;
+    }
+    char b;
+    return ::recv(entry->fd, &b, 1, MSG_PEEK | MSG_DONTWAIT) < 0 && errno == EAGAIN;
+}
+
+// -----------------------------------------------------------------------------
+// Lease
+// -----------------------------------------------------------------------------
+
+template<typename Transport>
+ClientPool::Lease<Transport>::Lease(ClientPool* pool, Entry* entry)
+: m_pool(pool)
+, m_entry(entry)
+, m_conn(static_cast<Connection*>(entry->conn))
+{
+}
+
+template<typename Transport>
+ClientPool::Lease<Transport>::Lease(Lease&& other)
+: m_pool(other.m_pool)
+, m_entry(other.m_entry)
+, m_conn(other.m_conn)
+{
+    other.m_pool = nullptr;
+    other.m_entry = nullptr;
+    other.m_conn = nullptr;
+}
+
+template<typename Transport>
+ClientPool::Lease<Transport>& ClientPool::Lease<Transport>::operator=(Lease&& other)
+{
+    if (this != &other)
+    {
+        Release();
+        std::swap(m_pool, other.m_pool);
+        std::swap(m_entry, other.m_entry);
+        std::swap(m_conn, other.m_conn);
+    }
+    return *this;
+}
+
+template<typename Transport>
+void ClientPool::Lease<Transport>::Release()
+{
+    if (!m_entry)
+    {
+        return;
+    }
+    m_pool->Return(m_entry, m_conn->Recycle());
+    m_pool = nullptr;
+    m_entry = nullptr;
+    m_conn = nullptr;
+}
+
+template<typename Transport>
+void ClientPool::Lease<Transport>::Discard()
+{
+    if (!m_entry)
+    {
+        return;
+    }
+    m_pool->Return(m_entry, false);
+    m_pool = nullptr;
+    m_entry = nullptr;
+    m_conn = nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Explicit template instantiations
+// -----------------------------------------------------------------------------
+
+template struct ClientPool::Lease<PlaintextTransport>;
+template struct ClientPool::Lease<TlsTransport>;
+
+} // end namespace coop::http
+} // end namespace coop
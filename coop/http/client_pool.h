@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "client.h"
+#include "transport.h"
+#include "tls_transport.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+
+struct Context;
+
+namespace io { namespace ssl { struct Context; } }
+
+namespace http
+{
+
+struct ClientPoolOptions
+{
+    // Connections per key (host, port, TLS), idle and checked out together. A checkout past it
+    // waits for one to come back.
+    //
+    size_t maxPerHost = 8;
+
+    // Idle connections kept per key; one coming back past it is closed
+    //
+    size_t maxIdlePerHost = 4;
+
+    // An idle connection older than this is closed instead of reused: servers drop idle
+    // keep-alives, often without a word
+    //
+    time::Interval idleTimeout = std::chrono::seconds(30);
+
+    // How long a checkout waits when its key is at maxPerHost
+    //
+    time::Interval checkoutTimeout = std::chrono::seconds(5);
+
+    // How long opening a connection may take, raced across the host's addresses (io::ConnectAny)
+    //
+    time::Interval connectTimeout = std::chrono::seconds(10);
+
+    // Open connections with TCP Fast Open, so a request on a new connection rides its SYN once
+    // the kernel holds the host's cookie. See io::ConnectAnyOptions::fastOpen for the trade.
+    //
+    bool fastOpen = false;
+
+    // Recv timeout of each connection's response parser
+    //
+    time::Interval timeout = std::chrono::seconds(30);
+
+    // Client context (ssl::Mode::Client) for TLS checkouts. Its settings, kTLS included, apply to
+    // every TLS connection the pool opens. With EnableSessionResumption on it, a connection to a
+    // key the cooperator has already handshaken with resumes that session.
+    //
+    io::ssl::Context* tls = nullptr;
+};
+
+// ClientPool keeps keep-alive client connections per (host, port, TLS) for reuse, so an outbound
+// request pays the resolve, connect and handshake once per connection rather than per request.
+//
+// Checkout returns a Lease holding a connection -- idle and still healthy, or newly opened --
+// and blocks, kill-aware, up to checkoutTimeout for one to come back when the key is at
+// maxPerHost. Releasing the lease returns the connection: kept if it can carry another request
+// (ClientConnectionImpl::Recycle: the response was read to its end and the server keeps the
+// connection alive), closed otherwise. An idle connection is checked before reuse: past
+// idleTimeout, or with the peer gone or bytes waiting unasked (a nonblocking MSG_PEEK), it is
+// closed and another taken.
+//
+// Single-cooperator, like the connections in it. Local() is the calling cooperator's pool.
+//
+//  auto lease = ClientPool::Local().Checkout("10.0.0.5", 8080);
+//  if (lease && lease->Get("/health"))
+//  {
+//      auto* status = lease->GetResponseLine();
+//      ...
+//  }                                   // back to the pool once the lease goes
+//
+struct ClientPool
+{
+    template<typename Transport>
+    struct Lease;
+
+    using PlainLease = Lease<PlaintextTransport>;
+    using TlsLease = Lease<TlsTransport>;
+
+    explicit ClientPool(ClientPoolOptions const& options = {});
+    ~ClientPool();
+
+    ClientPool(ClientPool const&) = delete;
+    ClientPool& operator=(ClientPool const&) = delete;
+
+    // The calling cooperator's pool. It starts with the default options (no TLS context);
+    // Configure it before its first checkout.
+    //
+    static ClientPool& Local();
+    void Configure(ClientPoolOptions const& options);
+
+    // An empty lease when no connection could be had: connect or handshake failure, checkout
+    // timeout, or kill. CheckoutTls needs options.tls; host is also the TLS server name.
+    //
+    PlainLease Checkout(const char* host, int port);
+    TlsLease CheckoutTls(const char* host, int port);
+
+    // Close idle connections past idleTimeout or found dead. Returns how many.
+    //
+    size_t Prune();
+
+    uint64_t Connects() const { return m_connects; }
+    uint64_t Reuses() const { return m_reuses; }
+    uint64_t Resumptions() const { return m_resumptions; }     // TLS connects that resumed
+    size_t Idle() const;
+
+  private:
+    struct Entry;
+    struct Host;
+    struct Waiter;
+
+    Entry* Acquire(const char* host, int port, bool tls);
+    Entry* Open(Host& host);
+    void Return(Entry* entry, bool reuse);
+    void Give(Entry* entry);
+    void Vacate(Host& host);
+    void Destroy(Entry* entry);
+    void Close(Entry* entry);
+    bool Healthy(Entry* entry, int64_t now) const;
+
+    ClientPoolOptions   m_options;
+    std::unordered_map<std::string, std::unique_ptr<Host>> m_hosts;
+
+    uint64_t            m_connects = 0;
+    uint64_t            m_reuses = 0;
+    uint64_t            m_resumptions = 0;
+};
+
+// A checked-out connection. Move-only; the connection goes back to the pool on Release or
+// destruction.
+//
+template<typename Transport>
+struct ClientPool::Lease
+{
+    using Connection = ClientConnection<Transport>;
+
+    Lease() = default;
+    Lease(Lease&& other);
+    Lease& operator=(Lease&& other);
+    ~Lease() { Release(); }
+
+    explicit operator bool() const { return m_conn != nullptr; }
+    Connection* operator->() const { return m_conn; }
+    Connection& operator*() const { return *m_conn; }
+
+    // Give the connection back: kept for the next checkout if it can be recycled, else closed
+    //
+    void Release();
+
+    // Close it instead, e.g. after abandoning an exchange midway
+    //
+    void Discard();
+
+  private:
+    friend struct ClientPool;
+
+    Lease(ClientPool* pool, Entry* entry);
+
+    ClientPool*     m_pool = nullptr;
+    Entry*          m_entry = nullptr;
+    Connection*     m_conn = nullptr;
+};
+
+} // end namespace coop::http
+} // end namespace coop
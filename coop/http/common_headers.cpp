@@ -0,0 +1,241 @@
+#include "common_headers.h"
+
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/cooperator.h"
+#include "coop/cooperator_var.h"
+#include "coop/cooperator_var.hpp"
+#include "coop/time/sleep.h"
+
+namespace coop
+{
+namespace http
+{
+namespace response
+{
+
+namespace
+{
+
+constexpr char kDatePrefix[] = "Date: ";
+constexpr char kDays[] = "SunMonTueWedThuFriSat";
+constexpr char kMonths[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+constexpr size_t kDateSize = sizeof("Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n") - 1;
+
+struct DateState
+{
+    char    text[kDateSize + 1] = {};
+    int64_t second = -1;
+
+    // A DateClock exists on this cooperator, and its ticker is keeping text current
+    //
+    bool    clock = false;
+    bool    ticking = false;
+};
+
+CooperatorVar<DateState> s_date;
+
+std::string s_commonHeaders;
+
+void Put2(char* p, int v)
+{
+    p[0] = static_cast<char>('0' + v / 10);
+    p[1] = static_cast<char>('0' + v % 10);
+}
+
+void Format(DateState& state, int64_t second)
+{
+    memcpy(state.text, kDatePrefix, sizeof(kDatePrefix) - 1);
+    FormatHttpDate(second, state.text + sizeof(kDatePrefix) - 1);
+    memcpy(state.text + kDateSize - 2, "\r\n", 2);
+    state.second = second;
+}
+
+int64_t RealtimeMicros(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+void Tick(Context* ctx)
+{
+    auto& state = *s_date;
+    state.ticking = true;
+    while (!ctx->IsKilled())
+    {
+        int64_t now = RealtimeMicros(CLOCK_REALTIME);
+        Format(state, now / 1000000);
+
+        // Wake just past the next second boundary
+        //
+        time::Interval wait(1000000 - now % 1000000);
+        if (time::Sleep(ctx, wait) != time::SleepResult::Ok)
+        {
+            break;
+        }
+    }
+    state.ticking = false;
+}
+
+} // end anonymous namespace
+
+// IMF-fixdate, by hand: strftime's %a and %b follow the locale
+//
+void FormatHttpDate(int64_t second, char* out)
+{
+    time_t t = static_cast<time_t>(second);
+    struct tm tm;
+    gmtime_r(&t, &tm);
+
+    char* p = out;
+    memcpy(p, kDays + 3 * tm.tm_wday, 3);
+    p[3] = ',';
+    p[4] = ' ';
+    Put2(p + 5, tm.tm_mday);
+    p[7] = ' ';
+    memcpy(p + 8, kMonths + 3 * tm.tm_mon, 3);
+    p[11] = ' ';
+    int year = tm.tm_year + 1900;
+    Put2(p + 12, year / 100);
+    Put2(p + 14, year % 100);
+    p[16] = ' ';
+    Put2(p + 17, tm.tm_hour);
+    p[19] = ':';
+    Put2(p + 20, tm.tm_min);
+    p[22] = ':';
+    Put2(p + 23, tm.tm_sec);
+    memcpy(p + 25, " GMT", 4);
+}
+
+int64_t ParseHttpDate(std::string_view text)
+{
+    // "Sun, 06 Nov 1994 08:49:37 GMT": fixed positions, so each field is a digit check away
+    //
+    if (text.size() != HTTP_DATE_SIZE || text[3] != ',' || text[4] != ' ' || text[7] != ' '
+        || text[11] != ' ' || text[16] != ' ' || text[19] != ':' || text[22] != ':'
+        || text.substr(25) != " GMT")
+    {
+        return -1;
+    }
+
+    auto number = [&](size_t at, size_t digits)
+    {
+        int v = 0;
+        for (size_t i = at; i < at + digits; i++)
+        {
+            if (text[i] < '0' || text[i] > '9')
+            {
+                return -1;
+            }
+            v = v * 10 + (text[i] - '0');
+        }
+        return v;
+    };
+
+    struct tm tm = {};
+    tm.tm_mday = number(5, 2);
+    tm.tm_year = number(12, 4) - 1900;
+    tm.tm_hour = number(17, 2);
+    tm.tm_min = number(20, 2);
+    tm.tm_sec = number(23, 2);
+    tm.tm_mon = -1;
+    for (int m = 0; m < 12; m++)
+    {
+        if (memcmp(kMonths + 3 * m, text.data() + 8, 3) == 0)
+        {
+            tm.tm_mon = m;
+        }
+    }
+    if (tm.tm_mday < 1 || tm.tm_year < 0 || tm.tm_hour < 0 || tm.tm_min < 0 || tm.tm_sec < 0
+        || tm.tm_mon < 0)
+    {
+        return -1;
+    }
+    return static_cast<int64_t>(timegm(&tm));
+}
+
+Fragment DateHeader()
+{
+    auto& state = *s_date;
+    if (!state.ticking)
+    {
+        int64_t second = RealtimeMicros(CLOCK_REALTIME_COARSE) / 1000000;
+        if (second != state.second)
+        {
+            Format(state, second);
+        }
+    }
+    return { state.text, kDateSize };
+}
+
+DateClock::DateClock(Context* ctx /* = Self() */)
+{
+    auto& state = *s_date;
+    if (state.clock)
+    {
+        return;
+    }
+    state.clock = true;
+    m_owner = true;
+
+    // The ticker holds m_exit for its whole run; it starts inside Spawn, so it has taken it before
+    // the destructor can wait on it
+    //
+    bool spawned = ctx->GetCooperator()->Spawn([this](Context* tickCtx)
+    {
+        tickCtx->SetName("HttpDateClock");
+        m_exit.Acquire(tickCtx);
+        Tick(tickCtx);
+        m_exit.Release(tickCtx, false);
+    }, &m_ticker);
+    if (!spawned)
+    {
+        spdlog::warn("http date clock spawn failed, formatting dates on demand");
+    }
+}
+
+DateClock::~DateClock()
+{
+    if (!m_owner)
+    {
+        return;
+    }
+
+    auto* ctx = Self();
+    if (m_ticker)
+    {
+        m_ticker.Kill();
+    }
+    m_exit.Acquire(ctx);
+    m_exit.Release(ctx, false);
+    s_date->clock = false;
+}
+
+bool RegisterCommonHeaders(std::string_view block)
+{
+    if (block.size() < 2 || block.substr(block.size() - 2) != "\r\n")
+    {
+        return false;
+    }
+    s_commonHeaders.append(block);
+    return true;
+}
+
+void ClearCommonHeaders()
+{
+    s_commonHeaders.clear();
+}
+
+Fragment CommonHeaders()
+{
+    return { s_commonHeaders.data(), s_commonHeaders.size() };
+}
+
+} // end namespace coop::http::response
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "response_constants.h"
+
+#include "coop/context.h"
+#include "coop/coordinator.h"
+#include "coop/self.h"
+
+namespace coop
+{
+namespace http
+{
+namespace response
+{
+
+// Header lines every response carries, after the status line and ahead of Content-Type: the Date
+// (RFC 9110 6.6.1) and the registered common block. Both are kept formatted, so a response costs
+// one memcpy each rather than any formatting.
+//
+
+// "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n" for the current second, per cooperator. While a
+// DateClock runs on the cooperator this is a plain load of the string it keeps; without one, each
+// call reads the coarse realtime clock and reformats when the second has turned.
+//
+Fragment DateHeader();
+
+// Refreshes the calling cooperator's Date once a second from a context of its own, sleeping on the
+// cooperator's timers between ticks. The servers hold one while they accept. Nests: the first on a
+// cooperator starts the ticker, the others ride on it.
+//
+struct DateClock
+{
+    explicit DateClock(Context* ctx = Self());
+    ~DateClock();
+
+    DateClock(DateClock const&) = delete;
+    DateClock& operator=(DateClock const&) = delete;
+
+  private:
+    bool                m_owner = false;
+    Coordinator         m_exit;
+    Context::Handle     m_ticker;
+};
+
+// IMF-fixdate (RFC 9110 5.6.7), "Sun, 06 Nov 1994 08:49:37 GMT", for a Unix second: HTTP_DATE_SIZE
+// bytes, no terminator. ParseHttpDate is the reverse, -1 for anything else -- the obsolete RFC 850
+// and asctime forms included.
+//
+constexpr size_t HTTP_DATE_SIZE = 29;
+void FormatHttpDate(int64_t second, char* out);
+int64_t ParseHttpDate(std::string_view text);
+
+// Precomposed header lines -- CORS, security headers, a Server line -- appended to every response
+// after the Date. block is one or more complete "Name: value\r\n" lines; each call adds to what is
+// registered. Process-wide and not synchronized: register before any server starts. Returns false
+// (registering nothing) for a block that is empty or does not end in CRLF.
+//
+bool RegisterCommonHeaders(std::string_view block);
+void ClearCommonHeaders();
+Fragment CommonHeaders();
+
+} // end namespace coop::http::response
+} // end namespace coop::http
+} // end namespace coop
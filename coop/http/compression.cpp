@@ -0,0 +1,434 @@
+#include "compression.h"
+
+#include <cassert>
+#include <cstring>
+#include <strings.h>
+#include <vector>
+
+#include <zlib.h>
+#ifndef COOP_HAVE_ZSTD
+#define COOP_HAVE_ZSTD 0
+#endif
+#if COOP_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "coop/cooperator.h"
+#include "coop/cooperator_var.h"
+#include "coop/cooperator_var.hpp"
+
+namespace coop
+{
+namespace http
+{
+
+namespace
+{
+
+constexpr char kGzipHeaders[] = "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n";
+constexpr char kDeflateHeaders[] = "Content-Encoding: deflate\r\nVary: Accept-Encoding\r\n";
+constexpr char kZstdHeaders[] = "Content-Encoding: zstd\r\nVary: Accept-Encoding\r\n";
+constexpr char kVaryHeader[] = "Vary: Accept-Encoding\r\n";
+
+// Idle coders kept per coding and cooperator. A burst beyond this frees its extras on End.
+//
+constexpr size_t kPoolMax = 16;
+
+struct ZlibCoder
+{
+    z_stream    strm{};
+    int         level = 0;
+};
+
+struct CoderPool
+{
+    ~CoderPool()
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            for (void* state : idle[i])
+            {
+                Free(static_cast<ContentEncoding>(i), state);
+            }
+        }
+    }
+
+    static void Free(ContentEncoding encoding, void* state)
+    {
+#if COOP_HAVE_ZSTD
+        if (encoding == ContentEncoding::ZSTD)
+        {
+            ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(state));
+            return;
+        }
+#endif
+        (void)encoding;
+        auto* coder = static_cast<ZlibCoder*>(state);
+        deflateEnd(&coder->strm);
+        delete coder;
+    }
+
+    std::vector<void*> idle[4];
+};
+
+CooperatorVar<CoderPool> s_coders;
+
+// The calling cooperator's pool, or none off-cooperator (tests, setup code): coders are then
+// created and freed per stream
+//
+CoderPool* Pool()
+{
+    return Cooperator::thread_cooperator ? &*s_coders : nullptr;
+}
+
+void* NewCoder(ContentEncoding encoding, CompressionOptions const& options)
+{
+    if (encoding == ContentEncoding::ZSTD)
+    {
+#if COOP_HAVE_ZSTD
+        auto* cctx = ZSTD_createCCtx();
+        if (cctx)
+        {
+            ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, options.zstdLevel);
+        }
+        return cctx;
+#else
+        return nullptr;
+#endif
+    }
+
+    // gzip wraps the deflate stream in a gzip header and trailer (windowBits + 16); the deflate
+    // coding is the zlib format, not raw deflate (RFC 9110 8.4.1.2)
+    //
+    auto* coder = new ZlibCoder;
+    int windowBits = encoding == ContentEncoding::GZIP ? 15 + 16 : 15;
+    if (deflateInit2(&coder->strm, options.gzipLevel, Z_DEFLATED, windowBits, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        delete coder;
+        return nullptr;
+    }
+    coder->level = options.gzipLevel;
+    return coder;
+}
+
+// Ready a pooled coder for a new stream at the options' level
+//
+bool ResetCoder(ContentEncoding encoding, void* state, CompressionOptions const& options)
+{
+#if COOP_HAVE_ZSTD
+    if (encoding == ContentEncoding::ZSTD)
+    {
+        auto* cctx = static_cast<ZSTD_CCtx*>(state);
+        ZSTD_CCtx_reset(cctx, ZSTD_reset_session_only);
+        return !ZSTD_isError(
+            ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, options.zstdLevel));
+    }
+#endif
+    (void)encoding;
+    auto* coder = static_cast<ZlibCoder*>(state);
+    if (deflateReset(&coder->strm) != Z_OK)
+    {
+        return false;
+    }
+    if (coder->level != options.gzipLevel)
+    {
+        if (deflateParams(&coder->strm, options.gzipLevel, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            return false;
+        }
+        coder->level = options.gzipLevel;
+    }
+    return true;
+}
+
+bool TokenIs(std::string_view token, const char* name)
+{
+    return token.size() == strlen(name) && strncasecmp(token.data(), name, token.size()) == 0;
+}
+
+std::string_view Trim(std::string_view s)
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+    {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+    {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+// qvalue = ( "0" [ "." 0*3DIGIT ] ) / ( "1" [ "." 0*3("0") ] ), in thousandths. A malformed one
+// counts as 1, the default.
+//
+int16_t ParseQ(std::string_view params)
+{
+    while (!params.empty())
+    {
+        size_t semi = params.find(';');
+        auto param = Trim(params.substr(0, semi));
+        params = semi == std::string_view::npos ? std::string_view() : params.substr(semi + 1);
+        if (param.size() < 3 || (param[0] != 'q' && param[0] != 'Q') || param[1] != '=')
+        {
+            continue;
+        }
+
+        auto v = param.substr(2);
+        if (v[0] != '0' && v[0] != '1')
+        {
+            return 1000;
+        }
+        int q = (v[0] - '0') * 1000;
+        if (v.size() > 1 && v[1] == '.')
+        {
+            int scale = 100;
+            for (size_t i = 2; i < v.size() && i < 5 && v[i] >= '0' && v[i] <= '9'; i++)
+            {
+                q += (v[i] - '0') * scale;
+                scale /= 10;
+            }
+        }
+        return static_cast<int16_t>(q > 1000 ? 1000 : q);
+    }
+    return 1000;
+}
+
+} // end anonymous namespace
+
+bool EncodingSupported(ContentEncoding encoding)
+{
+    switch (encoding)
+    {
+    case ContentEncoding::GZIP:
+    case ContentEncoding::DEFLATE:
+        return true;
+    case ContentEncoding::ZSTD:
+        return COOP_HAVE_ZSTD;
+    default:
+        return false;
+    }
+}
+
+const char* EncodingName(ContentEncoding encoding)
+{
+    switch (encoding)
+    {
+    case ContentEncoding::GZIP:     return "gzip";
+    case ContentEncoding::DEFLATE:  return "deflate";
+    case ContentEncoding::ZSTD:     return "zstd";
+    default:                        return "identity";
+    }
+}
+
+response::Fragment EncodingHeaders(ContentEncoding encoding)
+{
+    switch (encoding)
+    {
+    case ContentEncoding::GZIP:     return { kGzipHeaders, sizeof(kGzipHeaders) - 1 };
+    case ContentEncoding::DEFLATE:  return { kDeflateHeaders, sizeof(kDeflateHeaders) - 1 };
+    case ContentEncoding::ZSTD:     return { kZstdHeaders, sizeof(kZstdHeaders) - 1 };
+    default:                        return { kVaryHeader, sizeof(kVaryHeader) - 1 };
+    }
+}
+
+void AcceptEncoding::Parse(std::string_view value)
+{
+    while (!value.empty())
+    {
+        size_t comma = value.find(',');
+        auto item = value.substr(0, comma);
+        value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+
+        size_t semi = item.find(';');
+        auto coding = Trim(item.substr(0, semi));
+        int16_t qv = semi == std::string_view::npos ? 1000 : ParseQ(item.substr(semi + 1));
+
+        if (TokenIs(coding, "gzip") || TokenIs(coding, "x-gzip"))
+        {
+            q[static_cast<int>(ContentEncoding::GZIP)] = qv;
+        }
+        else if (TokenIs(coding, "deflate"))
+        {
+            q[static_cast<int>(ContentEncoding::DEFLATE)] = qv;
+        }
+        else if (TokenIs(coding, "zstd"))
+        {
+            q[static_cast<int>(ContentEncoding::ZSTD)] = qv;
+        }
+        else if (TokenIs(coding, "*"))
+        {
+            wildcard = qv;
+        }
+    }
+}
+
+ContentEncoding AcceptEncoding::Negotiate(uint8_t allowed /* = ALL_ENCODINGS */) const
+{
+    static constexpr ContentEncoding kPreference[] = {
+        ContentEncoding::ZSTD,
+        ContentEncoding::GZIP,
+        ContentEncoding::DEFLATE,
+    };
+
+    ContentEncoding best = ContentEncoding::IDENTITY;
+    int16_t bestQ = 0;
+    for (auto encoding : kPreference)
+    {
+        if (!(allowed & EncodingBit(encoding)) || !EncodingSupported(encoding))
+        {
+            continue;
+        }
+        int16_t qv = q[static_cast<int>(encoding)];
+        if (qv < 0)
+        {
+            qv = wildcard;
+        }
+        if (qv > bestQ)
+        {
+            best = encoding;
+            bestQ = qv;
+        }
+    }
+    return best;
+}
+
+bool AcceptEncoding::Accepts(ContentEncoding encoding) const
+{
+    if (encoding == ContentEncoding::IDENTITY)
+    {
+        return true;
+    }
+    int16_t qv = q[static_cast<int>(encoding)];
+    return (qv < 0 ? wildcard : qv) > 0;
+}
+
+bool Compressor::Begin(ContentEncoding encoding, CompressionOptions const& options /* = {} */)
+{
+    End();
+    if (!EncodingSupported(encoding))
+    {
+        return false;
+    }
+
+    auto* pool = Pool();
+    void* state = nullptr;
+    if (pool && !pool->idle[static_cast<int>(encoding)].empty())
+    {
+        auto& idle = pool->idle[static_cast<int>(encoding)];
+        state = idle.back();
+        idle.pop_back();
+        if (!ResetCoder(encoding, state, options))
+        {
+            CoderPool::Free(encoding, state);
+            state = nullptr;
+        }
+    }
+    if (!state)
+    {
+        state = NewCoder(encoding, options);
+    }
+    if (!state)
+    {
+        return false;
+    }
+
+    m_state = state;
+    m_encoding = encoding;
+    return true;
+}
+
+void Compressor::End()
+{
+    if (!m_state)
+    {
+        return;
+    }
+
+    auto* pool = Pool();
+    auto index = static_cast<int>(m_encoding);
+    if (pool && pool->idle[index].size() < kPoolMax)
+    {
+        pool->idle[index].push_back(m_state);
+    }
+    else
+    {
+        CoderPool::Free(m_encoding, m_state);
+    }
+    m_state = nullptr;
+    m_encoding = ContentEncoding::IDENTITY;
+}
+
+bool Compressor::Write(const void* data, size_t size, Flush flush, std::string* out)
+{
+    assert(m_state);
+
+#if COOP_HAVE_ZSTD
+    if (m_encoding == ContentEncoding::ZSTD)
+    {
+        auto* cctx = static_cast<ZSTD_CCtx*>(m_state);
+        ZSTD_EndDirective mode = flush == FINISH ? ZSTD_e_end
+            : flush == SYNC ? ZSTD_e_flush : ZSTD_e_continue;
+        ZSTD_inBuffer in = { data, size, 0 };
+        size_t chunk = ZSTD_CStreamOutSize();
+        while (true)
+        {
+            size_t at = out->size();
+            out->resize(at + chunk);
+            ZSTD_outBuffer o = { out->data() + at, chunk, 0 };
+            size_t remaining = ZSTD_compressStream2(cctx, &o, &in, mode);
+            out->resize(at + o.pos);
+            if (ZSTD_isError(remaining))
+            {
+                return false;
+            }
+            bool drained = mode == ZSTD_e_continue ? in.pos == in.size : remaining == 0;
+            if (drained)
+            {
+                return true;
+            }
+        }
+    }
+#endif
+
+    auto* strm = &static_cast<ZlibCoder*>(m_state)->strm;
+    int mode = flush == FINISH ? Z_FINISH : flush == SYNC ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+    strm->next_in = static_cast<Bytef*>(const_cast<void*>(data));
+    strm->avail_in = static_cast<uInt>(size);
+    while (true)
+    {
+        size_t chunk = deflateBound(strm, strm->avail_in) + 64;
+        size_t at = out->size();
+        out->resize(at + chunk);
+        strm->next_out = reinterpret_cast<Bytef*>(out->data() + at);
+        strm->avail_out = static_cast<uInt>(chunk);
+        int result = deflate(strm, mode);
+        out->resize(at + chunk - strm->avail_out);
+        if (result == Z_STREAM_ERROR)
+        {
+            return false;
+        }
+        if (mode == Z_FINISH ? result == Z_STREAM_END
+                             : strm->avail_in == 0 && strm->avail_out > 0)
+        {
+            return true;
+        }
+    }
+}
+
+bool Compressor::CompressAll(ContentEncoding encoding, CompressionOptions const& options,
+                             const void* data, size_t size, std::string* out)
+{
+    Compressor compressor;
+    out->clear();
+    if (!compressor.Begin(encoding, options))
+    {
+        return false;
+    }
+    out->reserve(size / 2 + 64);
+    return compressor.Write(data, size, FINISH, out) && out->size() < size;
+}
+
+} // end namespace coop::http
+} // end namespace coop
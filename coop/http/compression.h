@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "response_constants.h"
+
+namespace coop
+{
+namespace http
+{
+
+// Response content codings. ZSTD is only available when the library was built against libzstd
+// (COOP_HAVE_ZSTD); gzip and deflate come from zlib.
+//
+enum class ContentEncoding : uint8_t
+{
+    IDENTITY,
+    GZIP,
+    DEFLATE,
+    ZSTD,
+};
+
+constexpr uint8_t EncodingBit(ContentEncoding encoding)
+{
+    return static_cast<uint8_t>(1u << static_cast<unsigned>(encoding));
+}
+
+constexpr uint8_t ALL_ENCODINGS = EncodingBit(ContentEncoding::GZIP)
+    | EncodingBit(ContentEncoding::DEFLATE) | EncodingBit(ContentEncoding::ZSTD);
+
+bool EncodingSupported(ContentEncoding encoding);
+
+// "gzip", "deflate", "zstd" -- the token for Content-Encoding -- or "identity"
+//
+const char* EncodingName(ContentEncoding encoding);
+
+// The response header lines a coded response carries: "Content-Encoding: gzip\r\n" and "Vary:
+// Accept-Encoding\r\n", or just the Vary line for IDENTITY (the response still depended on the
+// request's Accept-Encoding).
+//
+response::Fragment EncodingHeaders(ContentEncoding encoding);
+
+// A parsed Accept-Encoding header (RFC 9110 12.5.3): the q-value of each coding we know, in
+// thousandths, or -1 where the header did not name it. Filled in by the parser as the header goes
+// by; a request without one gets IDENTITY.
+//
+struct AcceptEncoding
+{
+    void Parse(std::string_view value);
+    void Clear() { *this = AcceptEncoding(); }
+
+    // The coding to answer with, among the allowed mask (EncodingBit) and what this build
+    // supports: the highest q-value, ties going zstd, gzip, deflate. IDENTITY when none is
+    // acceptable.
+    //
+    ContentEncoding Negotiate(uint8_t allowed = ALL_ENCODINGS) const;
+
+    // Whether the client takes the coding at all (q > 0, named or through "*"), whether or not
+    // this build can produce it -- what serving a precompressed file needs
+    //
+    bool Accepts(ContentEncoding encoding) const;
+
+    int16_t q[4] = {-1, -1, -1, -1};
+    int16_t wildcard = -1;
+};
+
+struct CompressionOptions
+{
+    // Codings offered, as an EncodingBit mask
+    //
+    uint8_t encodings = ALL_ENCODINGS;
+
+    // Send bodies smaller than this go out uncompressed: below about a packet's worth, the coding
+    // overhead eats what it saves. Chunked responses always compress.
+    //
+    size_t minSize = 1024;
+
+    int gzipLevel = 5;
+    int zstdLevel = 3;
+};
+
+// A streaming compressor. Begin draws coder state for the coding from a per-cooperator pool --
+// deflateReset / ZSTD_CCtx_reset on reuse, rather than a fresh init with its hundreds of KB of
+// allocation per response -- and End (or the destructor) returns it.
+//
+struct Compressor
+{
+    enum Flush : uint8_t
+    {
+        NONE,           // buffer as the coder likes
+        SYNC,           // everything so far is in the output, decodable as it stands
+        FINISH,         // end of the stream; End follows
+    };
+
+    Compressor() = default;
+    ~Compressor() { End(); }
+
+    Compressor(Compressor const&) = delete;
+    Compressor& operator=(Compressor const&) = delete;
+
+    // False (and Active() stays false) for IDENTITY, an unsupported coding, or a coder that would
+    // not initialize
+    //
+    bool Begin(ContentEncoding encoding, CompressionOptions const& options = {});
+
+    // Compress size bytes, appending the output to *out. False on a coder error, after which the
+    // stream is unusable.
+    //
+    bool Write(const void* data, size_t size, Flush flush, std::string* out);
+
+    void End();
+
+    bool Active() const { return m_state != nullptr; }
+    ContentEncoding Encoding() const { return m_encoding; }
+
+    // Compress a whole body in one go. False when it would not come out smaller.
+    //
+    static bool CompressAll(ContentEncoding encoding, CompressionOptions const& options,
+                            const void* data, size_t size, std::string* out);
+
+  private:
+    void*               m_state = nullptr;
+    ContentEncoding     m_encoding = ContentEncoding::IDENTITY;
+};
+
+// A compressing layer for io::Compose (coop/io/stream_stack.h): what goes below is one Encoding
+// stream, Compressor-coded. Data sent goes down as the coder emits it. Flush ends a sync block, so
+// all of it so far decodes at the far end, and Finish ends the stream. Recv passes through. A
+// Buffered layer below gathers the coder's small outputs into whole sends. Sends fail with
+// -ENOTSUP when the build lacks the coding, and after Finish.
+//
+//  io::Compose<http::Compressed<ContentEncoding::ZSTD>, io::Buffered<16384>, io::Plain> out(desc);
+//
+template<ContentEncoding Encoding>
+struct Compressed
+{
+    template<typename Lower>
+    struct On
+    {
+        template<typename... Args>
+        explicit On(Args&&... args) : m_lower(std::forward<Args>(args)...)
+        {
+            m_compressor.Begin(Encoding);
+        }
+
+        int Send(const void* buf, size_t size) { return SendAll(buf, size); }
+
+        int SendAll(const void* buf, size_t size)
+        {
+            int result = Write(buf, size, Compressor::NONE);
+            return result < 0 ? result : static_cast<int>(size);
+        }
+
+        int Recv(void* buf, size_t size) { return m_lower.Recv(buf, size); }
+
+        int Flush()
+        {
+            int result = m_compressor.Active() ? Write(nullptr, 0, Compressor::SYNC) : 0;
+            return result < 0 ? result : m_lower.Flush();
+        }
+
+        int Finish()
+        {
+            int result = Write(nullptr, 0, Compressor::FINISH);
+            m_compressor.End();
+            return result < 0 ? result : m_lower.Flush();
+        }
+
+        Lower& Next() { return m_lower; }
+
+      private:
+        int Write(const void* buf, size_t size, Compressor::Flush flush)
+        {
+            if (!m_compressor.Active())
+            {
+                return -ENOTSUP;
+            }
+            m_out.clear();
+            if (!m_compressor.Write(buf, size, flush, &m_out))
+            {
+                m_compressor.End();
+                return -EIO;
+            }
+            if (m_out.empty())
+            {
+                return 0;
+            }
+            int result = m_lower.SendAll(m_out.data(), m_out.size());
+            return result < 0 ? result : 0;
+        }
+
+        Lower           m_lower;
+        Compressor      m_compressor;
+        std::string     m_out;          // the coder's output for one call, reused
+    };
+};
+
+} // end namespace coop::http
+} // end namespace coop
@@ -1,22 +1,148 @@
 #include "connection.h"
+#include "common_headers.h"
+#include "scan.h"
 #include "response_constants.h"
+#include "response_template.h"
 #include "transport.h"
 #include "tls_transport.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <fcntl.h>
+#include <memory>
 #include <strings.h>
+#include <unistd.h>
+#include <vector>
+
+#include <spdlog/spdlog.h>
 
 #include "coop/context.h"
 #include "coop/cooperator.h"
+#include "coop/cooperator_var.h"
+#include "coop/cooperator_var.hpp"
+#include "coop/memory_accounting.h"
 #include "coop/self.h"
+#include "coop/trace.h"
+#include "coop/io/recv.h"
+#include "coop/io/splice.h"
+#include "coop/io/write.h"
 
 namespace coop
 {
 namespace http
 {
 
+namespace
+{
+
+// The headers the parser acts on itself, found by the same hash as a handler's capture set
+//
+enum SpecialHeader
+{
+    CONTENT_LENGTH,
+    TRANSFER_ENCODING,
+    CONNECTION,
+    ACCEPT_ENCODING,
+    TRACEPARENT,
+};
+
+constexpr HeaderSet SPECIAL_HEADERS = {
+    HeaderName("content-length"),
+    HeaderName("transfer-encoding"),
+    HeaderName("connection"),
+    HeaderName("accept-encoding"),
+    HeaderName("traceparent"),
+};
+
+// Idle grown recv buffers, per cooperator and size class. Heads past the inline buffer are rare
+// and short-lived, so a few of each class cover a cooperator's connections; past MAX_CACHED,
+// returned buffers are freed. Off-cooperator (tests, setup code) they are allocated and freed
+// directly.
+//
+struct RecvGrowthPool
+{
+    static constexpr size_t MAX_CACHED = 16;
+
+    ~RecvGrowthPool()
+    {
+        for (int cls = 0; cls < ConnectionBase::GROWN_BUFFER_CLASSES; cls++)
+        {
+            for (char* buffer : m_free[cls])
+            {
+                Delete(buffer, cls);
+            }
+        }
+    }
+
+    char* Acquire(int cls)
+    {
+        if (m_free[cls].empty())
+        {
+            size_t size = ConnectionBase::GROWN_BUFFER_SIZES[cls];
+            AccountMemory(MemoryTag::HttpRecvGrowth, size, 1);
+            return new char[size];
+        }
+        char* buffer = m_free[cls].back();
+        m_free[cls].pop_back();
+        return buffer;
+    }
+
+    void Release(char* buffer, int cls)
+    {
+        if (m_free[cls].size() < MAX_CACHED)
+        {
+            m_free[cls].push_back(buffer);
+            return;
+        }
+        Delete(buffer, cls);
+    }
+
+    static void Delete(char* buffer, int cls)
+    {
+        size_t size = ConnectionBase::GROWN_BUFFER_SIZES[cls];
+        AccountMemory(MemoryTag::HttpRecvGrowth, -int64_t(size), -1);
+        delete[] buffer;
+    }
+
+    std::vector<char*> m_free[ConnectionBase::GROWN_BUFFER_CLASSES];
+};
+
+CooperatorVar<RecvGrowthPool> s_recvGrowth;
+
+char* AcquireGrown(int cls)
+{
+    if (Cooperator::thread_cooperator)
+    {
+        return s_recvGrowth->Acquire(cls);
+    }
+    return new char[ConnectionBase::GROWN_BUFFER_SIZES[cls]];
+}
+
+void ReleaseGrown(char* buffer, int cls)
+{
+    if (Cooperator::thread_cooperator)
+    {
+        s_recvGrowth->Release(buffer, cls);
+        return;
+    }
+    delete[] buffer;
+}
+
+} // end anonymous namespace
+
+bool ConnectionBase::NegotiateEncoding(size_t size, ContentEncoding* encoding)
+{
+    *encoding = ContentEncoding::IDENTITY;
+    if (!m_compression || size < m_compression->minSize)
+    {
+        return false;
+    }
+    SkipHeaders();
+    *encoding = m_acceptEncoding.Negotiate(m_compression->encodings);
+    return true;
+}
+
 template<typename Derived>
 ConnectionImpl<Derived>::ConnectionImpl(io::Descriptor& desc, Context* ctx, Cooperator* co,
                                         time::Interval timeout)
@@ -27,6 +153,8 @@ ConnectionImpl<Derived>::ConnectionImpl(io::Descriptor& desc, Context* ctx, Coop
 , m_bufLen(0)
 , m_parsePos(0)
 , m_sendLen(0)
+, m_grown{}
+, m_grownCount(0)
 , m_phase(REQUEST_LINE)
 , m_contentLength(-1)
 , m_chunkedBody(false)
@@ -39,22 +167,47 @@ ConnectionImpl<Derived>::ConnectionImpl(io::Descriptor& desc, Context* ctx, Coop
 , m_pendingContentLength(false)
 , m_pendingTransferEncoding(false)
 , m_pendingConnection(false)
+, m_pendingAcceptEncoding(false)
+, m_pendingTraceParent(false)
 , m_chunkedHeadersPending(false)
 , m_chunkedStatus(0)
 , m_chunkedContentType(nullptr)
+, m_chunkedVary(false)
 , m_keepAlive(true)
 , m_clientClose(false)
 , m_sendError(false)
+, m_zeroCopyThreshold(DEFAULT_ZERO_COPY_THRESHOLD)
+, m_batching(false)
+{
+}
+
+template<typename Derived>
+ConnectionImpl<Derived>::~ConnectionImpl()
 {
+    while (m_grownCount > 0)
+    {
+        m_grownCount--;
+        ReleaseGrown(m_grown[m_grownCount].data, m_grown[m_grownCount].cls);
+    }
+}
+
+template<typename Derived>
+bool ConnectionImpl<Derived>::KeepAlive() const
+{
+    return m_keepAlive && !m_clientClose && !(m_co && m_co->IsDraining());
 }
 
 template<typename Derived>
 void ConnectionImpl<Derived>::Reset()
 {
-    Compact();
+    ReturnGrown();
+    Compact(true);
 
     m_parsePos          = 0;
-    m_sendLen           = 0;
+    if (!m_batching)
+    {
+        m_sendLen       = 0;
+    }
     m_phase             = REQUEST_LINE;
     m_contentLength     = -1;
     m_chunkedBody       = false;
@@ -62,14 +215,25 @@ void ConnectionImpl<Derived>::Reset()
     m_requestLine       = {};
     m_chunk             = {};
     m_requestLineParsed = false;
+    m_params.count      = 0;
     m_chunkedDone       = false;
     m_valueConsumed     = true;
     m_pendingContentLength     = false;
     m_pendingTransferEncoding  = false;
     m_pendingConnection        = false;
+    m_pendingAcceptEncoding    = false;
+    m_pendingTraceParent       = false;
     m_chunkedHeadersPending    = false;
     m_chunkedStatus            = 0;
     m_chunkedContentType       = nullptr;
+    m_chunkedVary              = false;
+    m_compression              = nullptr;
+    m_contentEncoding          = ContentEncoding::IDENTITY;
+    m_responseHeaders          = {};
+    m_acceptEncoding.Clear();
+    m_headerSet                = nullptr;
+    m_captured.Clear();
+    m_compressor.End();
     m_clientClose              = false;
     m_sendError                = false;
 }
@@ -83,9 +247,22 @@ int ConnectionImpl<Derived>::RecvMore()
 {
     if (m_ctx->IsKilled()) return -1;
 
+    // Batched responses never wait on the peer: it may be waiting on them
+    //
+    if (m_batching && m_sendLen > 0 && !m_sendError)
+    {
+        Flush();
+    }
+
     if (m_bufLen >= RecvBufSize())
     {
-        Compact();
+        // A full buffer mid-head grows rather than compacts, so what the request line and the
+        // handler hold stays put; past the largest class the head gets the old behavior
+        //
+        if (!(m_phase < BODY && Grow()))
+        {
+            Compact(true);
+        }
         if (m_bufLen >= RecvBufSize()) return 0;
     }
 
@@ -99,10 +276,16 @@ int ConnectionImpl<Derived>::RecvMore()
 }
 
 template<typename Derived>
-void ConnectionImpl<Derived>::Compact()
+void ConnectionImpl<Derived>::Compact(bool force)
 {
     if (m_parsePos == 0) return;
 
+    // Past the request line, the bytes before m_parsePos are the request line, an argument or
+    // header name, or a value chunk already handed out, so they stay where they are. RecvMore
+    // forces the move when the buffer is full and growth is out.
+    //
+    if (!force && (m_phase == ARGS || m_phase == HEADERS)) return;
+
     size_t remaining = m_bufLen - m_parsePos;
     if (remaining > 0)
     {
@@ -112,6 +295,61 @@ void ConnectionImpl<Derived>::Compact()
     m_parsePos = 0;
 }
 
+template<typename Derived>
+bool ConnectionImpl<Derived>::Grow()
+{
+    if (m_grownCount == GROWN_BUFFER_CLASSES) return false;
+
+    int cls = m_grownCount ? m_grown[m_grownCount - 1].cls + 1 : 0;
+    while (cls < GROWN_BUFFER_CLASSES && GROWN_BUFFER_SIZES[cls] <= RecvBufSize())
+    {
+        cls++;
+    }
+    if (cls == GROWN_BUFFER_CLASSES) return false;
+
+    // Only the unparsed bytes move; the buffer they leave is kept, untouched, until Reset
+    //
+    size_t remaining = m_bufLen - m_parsePos;
+    char* data = AcquireGrown(cls);
+    memcpy(data, RecvBuf() + m_parsePos, remaining);
+    m_grown[m_grownCount++] = {data, static_cast<uint8_t>(cls)};
+    m_bufLen = remaining;
+    m_parsePos = 0;
+    return true;
+}
+
+template<typename Derived>
+void ConnectionImpl<Derived>::ReturnGrown()
+{
+    if (m_grownCount == 0) return;
+
+    // The next request's bytes, if any, go back inline when they fit; otherwise the buffer holding
+    // them stays on for it and only the ones before it go
+    //
+    size_t remaining = m_bufLen - m_parsePos;
+    int keep = m_grownCount - 1;
+    if (remaining <= static_cast<const Derived*>(this)->m_recvBufSize)
+    {
+        memcpy(static_cast<Derived*>(this)->m_buf, RecvBuf() + m_parsePos, remaining);
+        m_bufLen = remaining;
+        m_parsePos = 0;
+        keep = -1;
+    }
+
+    for (int i = 0; i < m_grownCount; i++)
+    {
+        if (i != keep)
+        {
+            ReleaseGrown(m_grown[i].data, m_grown[i].cls);
+        }
+    }
+    if (keep >= 0)
+    {
+        m_grown[0] = m_grown[keep];
+    }
+    m_grownCount = keep >= 0 ? 1 : 0;
+}
+
 // -------------------------------------------------------------------------------------
 // Phase 1: Request line
 // -------------------------------------------------------------------------------------
@@ -160,17 +398,22 @@ bool ConnectionImpl<Derived>::ParseRequestLine()
     p = sp + 1;
     size_t pathStart = p - base;
 
-    // Path end — multi-delimiter, keep byte loop (typically < 20 chars)
+    // Path end — first of '?', ' ', '\r'
     //
-    size_t i = pathStart;
-    while (i < m_bufLen && base[i] != '?' && base[i] != ' ' && base[i] != '\r') i++;
+    size_t i = pathStart + detail::FindFirstOf(base + pathStart, m_bufLen - pathStart,
+                                               '?', ' ', '\r', '\r');
     if (i >= m_bufLen) return false;
 
     m_requestLine.path = std::string_view(base + pathStart, i - pathStart);
 
     if (RecvBuf()[i] == '?')
     {
+        // The line is all buffered (GetRequestLine saw its CRLF), so the query ends before it
+        //
         m_parsePos = i + 1;
+        size_t queryEnd = m_parsePos + detail::FindFirstOf(base + m_parsePos, m_bufLen - m_parsePos,
+                                                           ' ', '\r', '\r', '\r');
+        m_requestLine.query = std::string_view(base + m_parsePos, queryEnd - m_parsePos);
     }
     else
     {
@@ -269,33 +512,32 @@ const char* ConnectionImpl<Derived>::NextArgName()
 
     while (true)
     {
-        for (size_t i = (nameStart == m_parsePos ? m_parsePos : m_parsePos); i < m_bufLen; i++)
+        size_t i = m_parsePos + detail::FindFirstOf(RecvBuf() + m_parsePos, m_bufLen - m_parsePos,
+                                                    '=', '&', ' ', '\r');
+        if (i < m_bufLen)
         {
             char c = RecvBuf()[i];
-            if (c == '=' || c == '&' || c == ' ' || c == '\r')
-            {
-                RecvBuf()[i] = '\0';
-                const char* name = RecvBuf() +nameStart;
-                m_parsePos = i;
-
-                if (c == '=')
-                {
-                    m_parsePos++;
-                    m_valueConsumed = false;
-                }
-                else
-                {
-                    if (c == '&') m_parsePos++;
-                    m_valueConsumed = true;
-                }
+            RecvBuf()[i] = '\0';
+            const char* name = RecvBuf() +nameStart;
+            m_parsePos = i;
 
-                return name;
+            if (c == '=')
+            {
+                m_parsePos++;
+                m_valueConsumed = false;
+            }
+            else
+            {
+                if (c == '&') m_parsePos++;
+                m_valueConsumed = true;
             }
+
+            return name;
         }
 
         Compact();
-        nameStart = m_parsePos;
         if (RecvMore() <= 0) return nullptr;
+        nameStart = m_parsePos;
     }
 }
 
@@ -306,20 +548,19 @@ Chunk* ConnectionImpl<Derived>::ReadArgValue()
 
     size_t valueStart = m_parsePos;
 
-    for (size_t i = m_parsePos; i < m_bufLen; i++)
+    size_t i = m_parsePos + detail::FindFirstOf(RecvBuf() + m_parsePos, m_bufLen - m_parsePos,
+                                                '&', ' ', '\r', '\r');
+    if (i < m_bufLen)
     {
         char c = RecvBuf()[i];
-        if (c == '&' || c == ' ' || c == '\r')
-        {
-            m_chunk.data = RecvBuf() +valueStart;
-            m_chunk.size = i - valueStart;
-            m_chunk.complete = true;
+        m_chunk.data = RecvBuf() +valueStart;
+        m_chunk.size = i - valueStart;
+        m_chunk.complete = true;
 
-            m_parsePos = i;
-            if (c == '&') m_parsePos++;
-            m_valueConsumed = true;
-            return &m_chunk;
-        }
+        m_parsePos = i;
+        if (c == '&') m_parsePos++;
+        m_valueConsumed = true;
+        return &m_chunk;
     }
 
     size_t available = m_bufLen - valueStart;
@@ -350,16 +591,14 @@ void ConnectionImpl<Derived>::SkipArgValue()
 
     while (true)
     {
-        for (size_t i = m_parsePos; i < m_bufLen; i++)
+        size_t i = m_parsePos + detail::FindFirstOf(RecvBuf() + m_parsePos, m_bufLen - m_parsePos,
+                                                    '&', ' ', '\r', '\r');
+        if (i < m_bufLen)
         {
-            char c = RecvBuf()[i];
-            if (c == '&' || c == ' ' || c == '\r')
-            {
-                m_parsePos = i;
-                if (c == '&') m_parsePos++;
-                m_valueConsumed = true;
-                return;
-            }
+            m_parsePos = i;
+            if (RecvBuf()[i] == '&') m_parsePos++;
+            m_valueConsumed = true;
+            return;
         }
 
         Compact();
@@ -420,25 +659,19 @@ const char* ConnectionImpl<Derived>::NextHeaderName()
 
         while (true)
         {
+            // One pass for the colon or the line end: a \r before any colon is a malformed line
+            //
             size_t avail = m_bufLen - m_parsePos;
-            char* colon = avail > 0
-                ? static_cast<char*>(memchr(RecvBuf() + m_parsePos, ':', avail))
-                : nullptr;
-
-            if (colon)
+            size_t at = detail::FindFirstOf(RecvBuf() + m_parsePos, avail, ':', '\r', '\r', '\r');
+            if (at < avail && RecvBuf()[m_parsePos + at] == '\r')
             {
-                // Check for \r before the colon (malformed)
-                //
-                char* cr = static_cast<char*>(
-                    memchr(RecvBuf() + m_parsePos, '\r',
-                           colon - (RecvBuf() + m_parsePos)));
-                if (cr)
-                {
-                    m_phase = DONE;
-                    return nullptr;
-                }
+                m_phase = DONE;
+                return nullptr;
+            }
 
-                size_t i = colon - RecvBuf();
+            if (at < avail)
+            {
+                size_t i = m_parsePos + at;
                 size_t nameEnd = i;
                 RecvBuf()[i] = '\0';
                 const char* name = RecvBuf() + nameStart;
@@ -449,41 +682,35 @@ const char* ConnectionImpl<Derived>::NextHeaderName()
                     m_parsePos++;
                 }
 
+                // One hash of the name serves the parser's own headers and the handler's
+                //
                 size_t nameLen = nameEnd - nameStart;
-                if (nameLen == 14 &&
-                    strncasecmp(name, "content-length", 14) == 0)
-                {
-                    m_pendingContentLength = true;
-                }
-                if (nameLen == 17 &&
-                    strncasecmp(name, "transfer-encoding", 17) == 0)
+                uint64_t hash = detail::HeaderNameHash(name, nameLen);
+                switch (SPECIAL_HEADERS.Find(hash, name, nameLen))
                 {
-                    m_pendingTransferEncoding = true;
+                    case CONTENT_LENGTH:    m_pendingContentLength = true; break;
+                    case TRANSFER_ENCODING: m_pendingTransferEncoding = true; break;
+                    case CONNECTION:        m_pendingConnection = true; break;
+                    case ACCEPT_ENCODING:   m_pendingAcceptEncoding = true; break;
+                    case TRACEPARENT:       m_pendingTraceParent = trace::IsTracing(); break;
+                    default:                break;
                 }
-                if (nameLen == 10 &&
-                    strncasecmp(name, "connection", 10) == 0)
+                if (m_headerSet)
                 {
-                    m_pendingConnection = true;
+                    int slot = m_headerSet->Find(hash, name, nameLen);
+                    if (slot >= 0)
+                    {
+                        m_captured.Begin(slot);
+                    }
                 }
 
                 m_valueConsumed = false;
                 return name;
             }
 
-            // No colon — check for \r
-            //
-            char* cr = avail > 0
-                ? static_cast<char*>(memchr(RecvBuf() + m_parsePos, '\r', avail))
-                : nullptr;
-            if (cr)
-            {
-                m_phase = DONE;
-                return nullptr;
-            }
-
             Compact();
-            nameStart = m_parsePos;
             if (RecvMore() <= 0) return nullptr;
+            nameStart = m_parsePos;
         }
     }
 }
@@ -506,6 +733,7 @@ Chunk* ConnectionImpl<Derived>::ReadHeaderValue()
         m_chunk.data = RecvBuf() + valueStart;
         m_chunk.size = i - valueStart;
         m_chunk.complete = true;
+        m_captured.Append(m_chunk.data, m_chunk.size, true);
 
         if (m_pendingContentLength)
         {
@@ -538,6 +766,24 @@ Chunk* ConnectionImpl<Derived>::ReadHeaderValue()
             }
             m_pendingConnection = false;
         }
+        if (m_pendingAcceptEncoding)
+        {
+            m_acceptEncoding.Parse(std::string_view(static_cast<const char*>(m_chunk.data),
+                                                    m_chunk.size));
+            m_pendingAcceptEncoding = false;
+        }
+        if (m_pendingTraceParent)
+        {
+            // Re-parent the request's server span under the caller's (see coop/trace.h)
+            //
+            trace::SpanContext remote;
+            if (trace::ParseTraceParent(std::string_view(static_cast<const char*>(m_chunk.data),
+                                                         m_chunk.size), remote))
+            {
+                trace::Adopt(remote);
+            }
+            m_pendingTraceParent = false;
+        }
 
         m_parsePos = i;
         if (m_parsePos + 1 < m_bufLen && RecvBuf()[m_parsePos + 1] == '\n')
@@ -554,6 +800,7 @@ Chunk* ConnectionImpl<Derived>::ReadHeaderValue()
         m_chunk.data = RecvBuf() +valueStart;
         m_chunk.size = available;
         m_chunk.complete = false;
+        m_captured.Append(m_chunk.data, m_chunk.size, false);
 
         m_parsePos = m_bufLen;
         RecvMore();
@@ -565,6 +812,9 @@ Chunk* ConnectionImpl<Derived>::ReadHeaderValue()
         m_pendingContentLength = false;
         m_pendingTransferEncoding = false;
         m_pendingConnection = false;
+        m_pendingAcceptEncoding = false;
+        m_pendingTraceParent = false;
+        m_captured.End();
         m_valueConsumed = true;
         return nullptr;
     }
@@ -577,7 +827,8 @@ void ConnectionImpl<Derived>::SkipHeaderValue()
 {
     if (m_valueConsumed) return;
 
-    if (m_pendingContentLength || m_pendingTransferEncoding || m_pendingConnection)
+    if (m_pendingContentLength || m_pendingTransferEncoding || m_pendingConnection ||
+        m_pendingAcceptEncoding || m_pendingTraceParent || m_captured.Capturing())
     {
         while (true)
         {
@@ -717,6 +968,136 @@ void ConnectionImpl<Derived>::SkipBody()
     while (ReadBody() != nullptr) {}
 }
 
+namespace
+{
+
+// Per splice: the pipe is grown to this where the limit allows, so one round trip moves a lot
+//
+constexpr size_t kSplicePipeSize = 1 << 20;
+
+bool WriteFully(io::Descriptor& file, const void* data, size_t size)
+{
+    auto* at = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        int n = io::Write(file, at, size, uint64_t(-1));
+        if (n <= 0) return false;
+        at += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // end anonymous namespace
+
+template<typename Derived>
+int64_t ConnectionImpl<Derived>::ReceiveBodyToFile(io::Descriptor& file)
+{
+    if (m_phase < BODY)
+    {
+        if (!AdvanceToPhase(BODY)) return -1;
+    }
+    if (m_phase != BODY) return 0;
+
+    if (!m_chunkedBody)
+    {
+        if (m_contentLength <= 0)
+        {
+            m_phase = DONE;
+            return 0;
+        }
+        if (m_bodyRemaining == 0)
+        {
+            m_bodyRemaining = static_cast<size_t>(m_contentLength);
+        }
+    }
+
+    bool splice = TransportCanSplice() && !file.m_direct && file.m_fd >= 0;
+    int pipefd[2] = {-1, -1};
+    int64_t total = 0;
+    bool ok = true;
+
+    while (ok && m_phase == BODY)
+    {
+        // Bytes of the current chunk (or the whole body) still on the socket go by splice once
+        // the recv buffer holds none of them
+        //
+        if (splice && m_bodyRemaining > 0 && m_parsePos == m_bufLen)
+        {
+            if (pipefd[0] < 0)
+            {
+                if (pipe2(pipefd, O_NONBLOCK | O_CLOEXEC) != 0)
+                {
+                    spdlog::warn("http upload pipe2 failed errno={}", errno);
+                    splice = false;
+                    continue;
+                }
+                fcntl(pipefd[1], F_SETPIPE_SZ, static_cast<int>(kSplicePipeSize));
+            }
+
+            size_t len = std::min(m_bodyRemaining, kSplicePipeSize);
+            int n = CountIn(io::SpliceKill(m_desc, file, pipefd, len));
+            if (n <= 0)
+            {
+                ok = false;
+                break;
+            }
+            m_bodyRemaining -= static_cast<size_t>(n);
+            total += n;
+
+            if (m_bodyRemaining > 0) continue;
+            if (!m_chunkedBody)
+            {
+                m_phase = DONE;
+                break;
+            }
+
+            // The CRLF closing the chunk's data
+            //
+            while (ok && m_bufLen - m_parsePos < 2)
+            {
+                Compact();
+                ok = RecvMore() > 0;
+            }
+            ok = ok && memcmp(RecvBuf() + m_parsePos, "\r\n", 2) == 0;
+            m_parsePos += ok ? 2 : 0;
+            continue;
+        }
+
+        Chunk* chunk = ReadBody();
+        if (!chunk) break;
+        if (!WriteFully(file, chunk->data, chunk->size))
+        {
+            spdlog::warn("http upload write to fd={} failed", file.m_fd);
+            ok = false;
+            break;
+        }
+        total += static_cast<int64_t>(chunk->size);
+    }
+
+    if (pipefd[0] >= 0)
+    {
+        close(pipefd[0]);
+        close(pipefd[1]);
+    }
+
+    // ReadBody ends the same way on a truncated body as on a complete one
+    //
+    if (ok && (m_chunkedBody ? !m_chunkedDone : m_bodyRemaining > 0))
+    {
+        ok = false;
+    }
+    if (!ok)
+    {
+        // The rest of the body is somewhere on the socket: nothing after it can be parsed
+        //
+        m_phase = DONE;
+        m_clientClose = true;
+        return -1;
+    }
+    return total;
+}
+
 // -------------------------------------------------------------------------------------
 // Chunked body parsing
 // -------------------------------------------------------------------------------------
@@ -755,6 +1136,15 @@ Chunk* ConnectionImpl<Derived>::ReadChunkedBody()
                     return &m_chunk;
                 }
             }
+
+            // The chunk's data goes out either way; what follows it cannot be framed
+            //
+            if (memcmp(RecvBuf() + m_parsePos, "\r\n", 2) != 0)
+            {
+                m_chunk.complete = true;
+                MalformedChunk();
+                return &m_chunk;
+            }
             m_parsePos += 2;
         }
 
@@ -772,15 +1162,11 @@ Chunk* ConnectionImpl<Derived>::ReadChunkedBody()
         if (cr && cr + 1 < RecvBuf() + m_bufLen && cr[1] == '\n')
         {
             size_t i = cr - RecvBuf();
-            size_t chunkSize = 0;
-            for (size_t j = m_parsePos; j < i; j++)
+            uint64_t chunkSize = 0;
+            if (!detail::ParseChunkSize(RecvBuf() + m_parsePos, i - m_parsePos, avail, &chunkSize))
             {
-                char c = RecvBuf()[j];
-                if (c == ';') break;
-
-                chunkSize <<= 4;
-                chunkSize += c & 0xF;
-                if (c > '9') c += 9;
+                MalformedChunk();
+                return nullptr;
             }
 
             m_parsePos = i + 2;
@@ -801,6 +1187,17 @@ Chunk* ConnectionImpl<Derived>::ReadChunkedBody()
     }
 }
 
+// Nothing after a framing error can be parsed: the body ends incomplete and the connection
+// closes after the response
+//
+template<typename Derived>
+void ConnectionImpl<Derived>::MalformedChunk()
+{
+    m_bodyRemaining = 0;
+    m_phase = DONE;
+    m_clientClose = true;
+}
+
 // -------------------------------------------------------------------------------------
 // Write buffer
 // -------------------------------------------------------------------------------------
@@ -841,6 +1238,29 @@ bool ConnectionImpl<Derived>::Flush()
     return ok;
 }
 
+// The end of a complete response. Batching, it stays buffered while more of the peer's bytes are
+// already here (likely a pipelined request) and the buffer has room; the keep-alive loop decides.
+//
+template<typename Derived>
+bool ConnectionImpl<Derived>::FlushResponse()
+{
+    if (m_batching && m_bufLen > m_parsePos && m_sendLen < SendBufSize())
+    {
+        return !m_sendError;
+    }
+    return Flush();
+}
+
+template<typename Derived>
+bool ConnectionImpl<Derived>::PipelinedRequestReady() const
+{
+    if (m_bufLen <= m_parsePos)
+    {
+        return false;
+    }
+    return memmem(RecvBuf() + m_parsePos, m_bufLen - m_parsePos, "\r\n\r\n", 4) != nullptr;
+}
+
 template<typename Derived>
 bool ConnectionImpl<Derived>::AppendUInt(size_t val)
 {
@@ -895,10 +1315,68 @@ bool ConnectionImpl<Derived>::AppendLiteral(const char (&s)[N])
     return Append(s, N - 1);
 }
 
+// Status line, then the lines every response carries -- Date and the registered common block --
+// and any the handler set for this one
+//
+template<typename Derived>
+bool ConnectionImpl<Derived>::AppendPreamble(int status)
+{
+    return AppendPreamble(status, response::StatusLine(status));
+}
+
+template<typename Derived>
+bool ConnectionImpl<Derived>::AppendPreamble(int status, response::Fragment statusLine)
+{
+    m_responseStatus = status;
+    if (!Append(statusLine.data, statusLine.size)) return false;
+    auto date = response::DateHeader();
+    if (!Append(date.data, date.size)) return false;
+    auto common = response::CommonHeaders();
+    if (common.size > 0 && !Append(common.data, common.size)) return false;
+    return m_responseHeaders.empty() || Append(m_responseHeaders.data(), m_responseHeaders.size());
+}
+
+// The deferred header block of a chunked response, coding lines included
+//
+template<typename Derived>
+bool ConnectionImpl<Derived>::AppendChunkedPreamble()
+{
+    m_chunkedHeadersPending = false;
+
+    if (!AppendPreamble(m_chunkedStatus)) return false;
+    if (!AppendLiteral(response::CONTENT_TYPE)) return false;
+    if (!Append(m_chunkedContentType, strlen(m_chunkedContentType))) return false;
+    if (!AppendLiteral(response::CRLF)) return false;
+    if (m_chunkedVary)
+    {
+        auto lines = EncodingHeaders(m_compressor.Encoding());
+        if (!Append(lines.data, lines.size)) return false;
+    }
+    if (!AppendLiteral(response::TRANSFER_ENCODING_CHUNKED)) return false;
+    return AppendConnectionTrailer();
+}
+
+// The chunk's size line, its data, and what follows it (the closing CRLF, or that and the
+// terminator). Data that would not fit behind the size line is gathered, not copied.
+//
+template<typename Derived>
+bool ConnectionImpl<Derived>::AppendChunk(const void* data, size_t size,
+                                          const char* trailer, size_t trailerSize)
+{
+    if (!AppendHex(size)) return false;
+    if (!AppendLiteral(response::CRLF)) return false;
+    if (m_sendLen + size + trailerSize > SendBufSize())
+    {
+        return SendGather(data, size, trailer, trailerSize);
+    }
+    if (!Append(data, size)) return false;
+    return Append(trailer, trailerSize);
+}
+
 template<typename Derived>
 bool ConnectionImpl<Derived>::AppendConnectionTrailer()
 {
-    if (m_keepAlive && !m_clientClose)
+    if (KeepAlive())
     {
         return AppendLiteral(response::CONN_KEEP_ALIVE);
     }
@@ -923,6 +1401,50 @@ bool ConnectionImpl<Derived>::SendRaw(const void* data, size_t size)
     return true;
 }
 
+template<typename Derived>
+bool ConnectionImpl<Derived>::SendGather(const void* body, size_t size,
+                                         const char* trailer, size_t trailerSize)
+{
+    assert(!m_sendError);
+
+    struct iovec iov[3];
+    int iovcnt = 0;
+    if (m_sendLen > 0)
+    {
+        iov[iovcnt++] = {SendBuf(), m_sendLen};
+    }
+    iov[iovcnt++] = {const_cast<void*>(body), size};
+    if (trailerSize > 0)
+    {
+        iov[iovcnt++] = {const_cast<char*>(trailer), trailerSize};
+    }
+
+    const size_t total = m_sendLen + size + trailerSize;
+    m_sendLen = 0;
+
+    int result = TransportSendAllv(iov, iovcnt);
+    if (result <= 0 || static_cast<size_t>(result) != total)
+    {
+        m_sendError = true;
+        return false;
+    }
+    return true;
+}
+
+template<typename Derived>
+bool ConnectionImpl<Derived>::SendRawZeroCopy(const void* data, size_t size)
+{
+    assert(!m_sendError);
+
+    int result = TransportSendAllZeroCopy(data, size);
+    if (result <= 0 || static_cast<size_t>(result) != size)
+    {
+        m_sendError = true;
+        return false;
+    }
+    return true;
+}
+
 // Append the common header block: status line, Content-Type, Content-Length, Connection.
 //
 template<typename Derived>
@@ -931,15 +1453,19 @@ bool ConnectionImpl<Derived>::SendHeaders(int status, const char* contentType,
 {
     assert(!m_sendError);
 
-    auto sl = response::StatusLine(status);
-    if (!Append(sl.data, sl.size)) return false;
+    if (!AppendPreamble(status)) return false;
+    if (m_contentEncoding != ContentEncoding::IDENTITY)
+    {
+        auto lines = EncodingHeaders(m_contentEncoding);
+        if (!Append(lines.data, lines.size)) return false;
+    }
     if (!AppendLiteral(response::CONTENT_TYPE)) return false;
     if (!Append(contentType, strlen(contentType))) return false;
     if (!AppendLiteral(response::CONTENT_LENGTH)) return false;
     if (!AppendUInt(contentLength)) return false;
     if (!AppendLiteral(response::CRLF)) return false;
     if (!AppendConnectionTrailer()) return false;
-    return Flush();
+    return FlushResponse();
 }
 
 template<typename Derived>
@@ -948,8 +1474,29 @@ bool ConnectionImpl<Derived>::Send(int status, const char* contentType,
 {
     assert(!m_sendError);
 
-    auto sl = response::StatusLine(status);
-    if (!Append(sl.data, sl.size)) return false;
+    // A body that would not come out smaller goes as it is, still marked as negotiated
+    //
+    ContentEncoding encoding;
+    bool negotiated = NegotiateEncoding(size, &encoding);
+    if (encoding != ContentEncoding::IDENTITY)
+    {
+        if (Compressor::CompressAll(encoding, *m_compression, body, size, &m_compressed))
+        {
+            body = m_compressed.data();
+            size = m_compressed.size();
+        }
+        else
+        {
+            encoding = ContentEncoding::IDENTITY;
+        }
+    }
+
+    if (!AppendPreamble(status)) return false;
+    if (negotiated)
+    {
+        auto lines = EncodingHeaders(encoding);
+        if (!Append(lines.data, lines.size)) return false;
+    }
     if (!AppendLiteral(response::CONTENT_TYPE)) return false;
     if (!Append(contentType, strlen(contentType))) return false;
     if (!AppendLiteral(response::CONTENT_LENGTH)) return false;
@@ -959,7 +1506,7 @@ bool ConnectionImpl<Derived>::Send(int status, const char* contentType,
 
     if (size == 0)
     {
-        return Flush();
+        return FlushResponse();
     }
 
     // Small body: coalesce headers + body into one send
@@ -967,13 +1514,21 @@ bool ConnectionImpl<Derived>::Send(int status, const char* contentType,
     if (m_sendLen + size <= SendBufSize())
     {
         if (!Append(body, size)) return false;
-        return Flush();
+        return FlushResponse();
     }
 
-    // Large body: flush headers, then send body directly
+    // Huge body: flush headers, then send body zero-copy -- above the threshold the copy into
+    // socket buffers costs more than waiting out the kernel's release of body
     //
-    if (!Flush()) return false;
-    return SendRaw(body, size);
+    if (m_zeroCopyThreshold > 0 && size >= m_zeroCopyThreshold)
+    {
+        if (!Flush()) return false;
+        return SendRawZeroCopy(body, size);
+    }
+
+    // Anything between: headers and body in one gather write, the body never copied
+    //
+    return SendGather(body, size, nullptr, 0);
 }
 
 template<typename Derived>
@@ -991,6 +1546,15 @@ bool ConnectionImpl<Derived>::BeginChunked(int status, const char* contentType)
     m_chunkedHeadersPending = true;
     m_chunkedStatus = status;
     m_chunkedContentType = contentType;
+
+    // No minimum size applies: the body's length is not known yet
+    //
+    ContentEncoding encoding;
+    m_chunkedVary = NegotiateEncoding(SIZE_MAX, &encoding);
+    if (encoding != ContentEncoding::IDENTITY)
+    {
+        m_compressor.Begin(encoding, *m_compression);
+    }
     return true;
 }
 
@@ -1004,21 +1568,25 @@ bool ConnectionImpl<Derived>::SendChunk(const void* data, size_t size)
 
     if (m_chunkedHeadersPending)
     {
-        m_chunkedHeadersPending = false;
+        if (!AppendChunkedPreamble()) return false;
+    }
 
-        auto sl = response::StatusLine(m_chunkedStatus);
-        if (!Append(sl.data, sl.size)) return false;
-        if (!AppendLiteral(response::CONTENT_TYPE)) return false;
-        if (!Append(m_chunkedContentType, strlen(m_chunkedContentType))) return false;
-        if (!AppendLiteral(response::CRLF)) return false;
-        if (!AppendLiteral(response::TRANSFER_ENCODING_CHUNKED)) return false;
-        if (!AppendConnectionTrailer()) return false;
+    if (m_compressor.Active())
+    {
+        // A sync flush per chunk: the client can decode everything sent so far as it arrives
+        //
+        m_compressed.clear();
+        if (!m_compressor.Write(data, size, Compressor::SYNC, &m_compressed))
+        {
+            m_sendError = true;
+            return false;
+        }
+        data = m_compressed.data();
+        size = m_compressed.size();
+        if (size == 0) return Flush();
     }
 
-    if (!AppendHex(size)) return false;
-    if (!AppendLiteral(response::CRLF)) return false;
-    if (!Append(data, size)) return false;
-    if (!AppendLiteral(response::CRLF)) return false;
+    if (!AppendChunk(data, size, response::CRLF, sizeof(response::CRLF) - 1)) return false;
     return Flush();
 }
 
@@ -1029,46 +1597,54 @@ bool ConnectionImpl<Derived>::EndChunked()
 
     if (m_chunkedHeadersPending)
     {
-        m_chunkedHeadersPending = false;
+        if (!AppendChunkedPreamble()) return false;
+    }
 
-        auto sl = response::StatusLine(m_chunkedStatus);
-        if (!Append(sl.data, sl.size)) return false;
-        if (!AppendLiteral(response::CONTENT_TYPE)) return false;
-        if (!Append(m_chunkedContentType, strlen(m_chunkedContentType))) return false;
-        if (!AppendLiteral(response::CRLF)) return false;
-        if (!AppendLiteral(response::TRANSFER_ENCODING_CHUNKED)) return false;
-        if (!AppendConnectionTrailer()) return false;
+    if (m_compressor.Active())
+    {
+        return EndChunked(nullptr, 0);
     }
 
     if (!AppendLiteral(response::CHUNKED_TERMINATOR)) return false;
-    return Flush();
+    return FlushResponse();
 }
 
 template<typename Derived>
 bool ConnectionImpl<Derived>::EndChunked(const void* lastChunkData, size_t lastChunkSize)
 {
     assert(!m_sendError);
-    if (lastChunkSize == 0) return EndChunked();
+    if (lastChunkSize == 0 && !m_compressor.Active()) return EndChunked();
 
     if (m_chunkedHeadersPending)
     {
-        m_chunkedHeadersPending = false;
+        if (!AppendChunkedPreamble()) return false;
+    }
 
-        auto sl = response::StatusLine(m_chunkedStatus);
-        if (!Append(sl.data, sl.size)) return false;
-        if (!AppendLiteral(response::CONTENT_TYPE)) return false;
-        if (!Append(m_chunkedContentType, strlen(m_chunkedContentType))) return false;
-        if (!AppendLiteral(response::CRLF)) return false;
-        if (!AppendLiteral(response::TRANSFER_ENCODING_CHUNKED)) return false;
-        if (!AppendConnectionTrailer()) return false;
+    if (m_compressor.Active())
+    {
+        m_compressed.clear();
+        bool ok = m_compressor.Write(lastChunkData, lastChunkSize, Compressor::FINISH,
+                                     &m_compressed);
+        m_compressor.End();
+        if (!ok)
+        {
+            m_sendError = true;
+            return false;
+        }
+        lastChunkData = m_compressed.data();
+        lastChunkSize = m_compressed.size();
     }
 
-    if (!AppendHex(lastChunkSize)) return false;
-    if (!AppendLiteral(response::CRLF)) return false;
-    if (!Append(lastChunkData, lastChunkSize)) return false;
-    if (!AppendLiteral(response::CRLF)) return false;
-    if (!AppendLiteral(response::CHUNKED_TERMINATOR)) return false;
-    return Flush();
+    if (lastChunkSize == 0)
+    {
+        if (!AppendLiteral(response::CHUNKED_TERMINATOR)) return false;
+    }
+    else if (!AppendChunk(lastChunkData, lastChunkSize, response::LAST_CHUNK_TRAILER,
+                          sizeof(response::LAST_CHUNK_TRAILER) - 1))
+    {
+        return false;
+    }
+    return FlushResponse();
 }
 
 template<typename Derived>
@@ -1089,6 +1665,44 @@ bool ConnectionImpl<Derived>::Sendfile(int fileFd, off_t offset, size_t count)
     return true;
 }
 
+template<typename Derived>
+int64_t ConnectionImpl<Derived>::SendBodyFrom(io::Descriptor& source, size_t count)
+{
+    assert(!m_sendError);
+    if (!Flush()) return 0;
+
+    int64_t total = 0;
+    int pipefd[2];
+    if (TransportCanSpliceInto() && !source.m_direct && source.m_fd >= 0 && io::AcquirePipe(pipefd))
+    {
+        while (static_cast<size_t>(total) < count)
+        {
+            int n = CountOut(io::SpliceKill(source, m_desc, pipefd, count - total));
+            if (n <= 0) break;
+            total += n;
+        }
+        io::ReleasePipe(pipefd, static_cast<size_t>(total) == count);
+        return total;
+    }
+
+    constexpr size_t kCopySize = 16 * 1024;
+    std::unique_ptr<char[]> buf(new char[kCopySize]);
+    while (static_cast<size_t>(total) < count)
+    {
+        int n = io::RecvKill(source, buf.get(), std::min(count - total, kCopySize), 0, m_timeout);
+        if (n <= 0 || !SendRaw(buf.get(), static_cast<size_t>(n))) break;
+        total += n;
+    }
+    return total;
+}
+
+template<typename Derived>
+void ConnectionImpl<Derived>::AbortResponse()
+{
+    m_sendError = true;
+    m_clientClose = true;
+}
+
 // -------------------------------------------------------------------------------------
 // SendRawBytes — for protocol upgrade (101 Switching Protocols)
 // -------------------------------------------------------------------------------------
@@ -1100,11 +1714,74 @@ bool ConnectionImpl<Derived>::SendRawBytes(const void* data, size_t size)
     return SendRaw(data, size);
 }
 
+// The template's status line, then the preamble's lines, then its own. Pieces too big for the send
+// buffer go out directly, as Append sends them.
+//
+template<typename Derived>
+bool ConnectionImpl<Derived>::SendRendered(response::Rendered const& rendered)
+{
+    assert(!m_sendError);
+
+    if (!AppendPreamble(rendered.status, rendered.statusLine)) return false;
+    for (size_t i = 0; i < rendered.headCount; i++)
+    {
+        if (!Append(rendered.head[i].data, rendered.head[i].size)) return false;
+    }
+    if (rendered.contentLength)
+    {
+        if (!AppendLiteral(response::CONTENT_LENGTH_LINE)) return false;
+        if (!AppendUInt(rendered.bodySize)) return false;
+        if (!AppendLiteral(response::CRLF)) return false;
+    }
+    if (!AppendConnectionTrailer()) return false;
+    for (size_t i = 0; i < rendered.bodyCount; i++)
+    {
+        if (!Append(rendered.body[i].data, rendered.body[i].size)) return false;
+    }
+    return FlushResponse();
+}
+
+// The chunks go behind the preamble, if it is still pending, straight from the caller's buffers.
+// A compressor has to see the data, so a compressed response takes them one SendChunk at a time.
+//
+template<typename Derived>
+bool ConnectionImpl<Derived>::SendFramedChunks(struct iovec* chunks, int count)
+{
+    assert(!m_sendError);
+    if (m_compressor.Active())
+    {
+        for (int i = 0; i < count; i++)
+        {
+            auto data = detail::ChunkPayload(chunks[i]);
+            if (!data.empty() && !SendChunk(data.data(), data.size())) return false;
+        }
+        return true;
+    }
+
+    if (m_chunkedHeadersPending && !AppendChunkedPreamble()) return false;
+    if (!Flush()) return false;
+
+    size_t total = 0;
+    for (int i = 0; i < count; i++)
+    {
+        total += chunks[i].iov_len;
+    }
+    int result = TransportSendAllv(chunks, count);
+    if (result <= 0 || static_cast<size_t>(result) != total)
+    {
+        m_sendError = true;
+        return false;
+    }
+    return true;
+}
+
 // -------------------------------------------------------------------------------------
 // Explicit template instantiations for known transport types
 // -------------------------------------------------------------------------------------
 
 template struct ConnectionImpl<Connection<PlaintextTransport>>;
+template struct ConnectionImpl<Connection<RegisteredTransport>>;
+template struct ConnectionImpl<Connection<ArmedTransport>>;
 template struct ConnectionImpl<Connection<TlsTransport>>;
 
 } // end namespace coop::http
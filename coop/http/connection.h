@@ -2,10 +2,17 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <sys/uio.h>
 
+#include "compression.h"
+#include "header_set.h"
+#include "response_constants.h"
+#include "router.h"
 #include "types.h"
+#include "coop/memory_accounting.h"
 #include "coop/io/descriptor.h"
 #include "coop/time/interval.h"
 
@@ -18,6 +25,29 @@ struct Cooperator;
 namespace http
 {
 
+namespace response
+{
+struct Rendered;
+}
+
+namespace detail
+{
+
+// The data of one framed chunk, "size\r\ndata\r\n" (SendFramedChunks)
+//
+inline std::string_view ChunkPayload(struct iovec const& chunk)
+{
+    std::string_view framed(static_cast<const char*>(chunk.iov_base), chunk.iov_len);
+    size_t start = framed.find("\r\n");
+    if (start == std::string_view::npos || framed.size() < start + 4)
+    {
+        return {};
+    }
+    return framed.substr(start + 2, framed.size() - start - 4);
+}
+
+} // end namespace coop::http::detail
+
 // ConnectionBase is the handler-facing interface. Handlers take ConnectionBase& for transport-
 // agnostic request processing. Virtual dispatch at the handler boundary; the parser internals
 // (ConnectionImpl) use CRTP for zero-overhead buffer access.
@@ -27,6 +57,15 @@ struct ConnectionBase
     static constexpr size_t DEFAULT_BUFFER_SIZE = 2048;
     static constexpr size_t DEFAULT_SEND_BUFFER_SIZE = 512;
 
+    // A request head -- request line and headers -- that outgrows the recv buffer moves, unparsed
+    // bytes only, into the next of these borrowed from the cooperator's pool, and the buffers go
+    // back after the request. What the handler already holds (the request line, a header name or
+    // value) stays where it is. A head past the last class fails as it would without growth.
+    //
+    static constexpr size_t GROWN_BUFFER_SIZES[] = {8 * 1024, 32 * 1024, 64 * 1024};
+    static constexpr int GROWN_BUFFER_CLASSES = 3;
+    static constexpr size_t DEFAULT_ZERO_COPY_THRESHOLD = 64 * 1024;
+
     virtual ~ConnectionBase() = default;
 
     // Phase 1: Request line. Lazy, memoized. Null = parse failure.
@@ -55,6 +94,14 @@ struct ConnectionBase
     virtual void SkipBody() = 0;
     virtual int64_t ContentLength() = 0;
 
+    // For uploads: write the rest of the body to file, at its current position, and return the
+    // bytes written -- -1 on a recv or write error. A Content-Length body, or each chunk's data in
+    // a chunked one (the framing parsed here), is spliced socket -> pipe -> file without entering
+    // userspace where the transport allows it: plaintext, or TLS with kTLS receive. Anything
+    // already buffered, and everything on other transports, is copied.
+    //
+    virtual int64_t ReceiveBodyToFile(io::Descriptor& file) = 0;
+
     // Response methods. Return false on send failure. Callers must not call send methods after
     // a failure (asserts in debug). Use SendError() to check.
     //
@@ -67,8 +114,30 @@ struct ConnectionBase
     virtual bool EndChunked(const void* lastChunkData, size_t lastChunkSize) = 0;
     virtual bool Sendfile(int fileFd, off_t offset, size_t count) = 0;
 
+    // For proxies: send count body bytes read off source, a socket whose byte stream is the
+    // plaintext, after SendHeaders. Spliced source -> pipe -> socket where the transport allows it
+    // (plaintext, or TLS with kTLS transmit), else copied. Returns the bytes sent: fewer than count
+    // when source ended early or a recv or send failed.
+    //
+    virtual int64_t SendBodyFrom(io::Descriptor& source, size_t count) = 0;
+
+    // Give up on the response begun, e.g. when a proxied body ends short: an HTTP/1.1 connection
+    // closes once the handler returns, an HTTP/2 stream is reset. SendError() is true after.
+    //
+    virtual void AbortResponse() = 0;
+
+    // Send bodies of at least threshold bytes with zero-copy send (io::SendZc) instead of copying
+    // them into socket buffers. Send then returns only once the kernel has released the body.
+    // Default DEFAULT_ZERO_COPY_THRESHOLD; 0 disables. Plaintext only -- TLS always copies.
+    //
+    virtual void SetZeroCopyThreshold(size_t threshold) = 0;
+
     virtual bool SendError() const = 0;
     virtual void Reset() = 0;
+
+    // Whether the connection stays open after this response: false once either side asked to
+    // close, or when its cooperator is draining (Cooperator::Drain)
+    //
     virtual bool KeepAlive() const = 0;
     virtual io::Descriptor& GetDescriptor() = 0;
     virtual Cooperator* GetCooperator() = 0;
@@ -81,6 +150,93 @@ struct ConnectionBase
     virtual const char* LeftoverData() = 0;
     virtual size_t LeftoverSize() = 0;
     virtual bool SendRawBytes(const void* data, size_t size) = 0;
+
+    // For fan-out (EventStream): after BeginChunked, body chunks the caller framed itself, one
+    // complete "size\r\ndata\r\n" per iovec, so that bytes formatted once can go to many
+    // connections. HTTP/1.1 sends them as they are in one gathered write (the iovecs may be
+    // modified); an HTTP/2 stream, or a compressed response, sends each chunk's data through
+    // SendChunk instead.
+    //
+    virtual bool SendFramedChunks(struct iovec* chunks, int count) = 0;
+
+    // A response a ResponseTemplate rendered (response_template.h): its pieces copied into the
+    // send buffer around the connection's own header lines, never compressed
+    //
+    virtual bool SendRendered(response::Rendered const& rendered) = 0;
+
+    // Parameters captured by the route that matched this request (":id", "*path", see Router),
+    // filled in by the server before it calls the handler. The views point into the request line
+    // and share its lifetime.
+    //
+    std::string_view Param(std::string_view name) const { return m_params.Get(name); }
+    RouteParams const& Params() const { return m_params; }
+
+    // Compress this response's body (compression.h): Send, and the chunked responses, then code it
+    // with the best of the request's Accept-Encoding that options offers, and say so with
+    // Content-Encoding and Vary. Send leaves bodies under options.minSize alone. options must
+    // outlive the response; Reset turns compression off again for the next request.
+    //
+    void EnableCompression(CompressionOptions const* options) { m_compression = options; }
+
+    // The request's Accept-Encoding, parsed as the header goes by: complete once the headers have
+    // been read or skipped
+    //
+    AcceptEncoding const& AcceptedEncodings() const { return m_acceptEncoding; }
+
+    // The coding of a body the caller coded itself (a precompressed file), for SendHeaders to
+    // announce. Reset returns it to IDENTITY.
+    //
+    void SetContentEncoding(ContentEncoding encoding) { m_contentEncoding = encoding; }
+
+    // Extra header lines for this response, each a complete "Name: value\r\n", sent after the
+    // common block by whichever response method goes next. The bytes are not copied: they must
+    // stay valid until that method returns. Reset clears them.
+    //
+    void SetResponseHeaders(std::string_view lines) { m_responseHeaders = lines; }
+
+    // Capture the values of set's names as the headers are read (header_set.h). Before the
+    // handler reads any header itself; set must outlive the request, and Reset forgets it.
+    //
+    void CaptureHeaders(HeaderSet const& set)
+    {
+        m_headerSet = &set;
+        m_captured.Clear();
+    }
+
+    // A captured header's value, reading past any headers the handler left first. Empty when
+    // the request did not send it, or name is not in the set.
+    //
+    std::optional<std::string_view> Header(HeaderName const& name)
+    {
+        if (!m_headerSet)
+        {
+            return std::nullopt;
+        }
+        SkipHeaders();
+        return m_captured.Get(m_headerSet->Find(name));
+    }
+
+    // Whether this response's coding depends on Accept-Encoding -- compression is on and a body of
+    // size is worth coding -- and if so, through *encoding, the coding to use. Reads past any
+    // headers the handler left, since Accept-Encoding may be among them.
+    //
+    bool NegotiateEncoding(size_t size, ContentEncoding* encoding);
+
+    // Request accounting for the router's metrics (route_metrics.h): byte totals over the
+    // connection's life, which HandleRequest differences around each request, and the status of
+    // the response the current request began, 0 until one does
+    //
+    uint64_t                    m_bytesIn = 0;
+    uint64_t                    m_bytesOut = 0;
+    int                         m_responseStatus = 0;
+
+    RouteParams                 m_params;
+    CompressionOptions const*   m_compression = nullptr;
+    AcceptEncoding              m_acceptEncoding;
+    ContentEncoding             m_contentEncoding = ContentEncoding::IDENTITY;
+    std::string_view            m_responseHeaders;
+    HeaderSet const*            m_headerSet = nullptr;
+    HeaderCapture               m_captured;
 };
 
 // ConnectionImpl<Derived> is the CRTP parser implementation. All parser state lives here; buffer
@@ -108,6 +264,7 @@ struct ConnectionImpl : ConnectionBase
     Chunk* ReadBody() override;
     void SkipBody() override;
     int64_t ContentLength() override;
+    int64_t ReceiveBodyToFile(io::Descriptor& file) override;
     bool Send(int status, const char* contentType, const void* body, size_t size) override;
     bool Send(int status, const char* contentType, const std::string& body) override;
     bool SendHeaders(int status, const char* contentType, size_t contentLength) override;
@@ -116,27 +273,61 @@ struct ConnectionImpl : ConnectionBase
     bool EndChunked() override;
     bool EndChunked(const void* lastChunkData, size_t lastChunkSize) override;
     bool Sendfile(int fileFd, off_t offset, size_t count) override;
+    int64_t SendBodyFrom(io::Descriptor& source, size_t count) override;
+    void AbortResponse() override;
     bool SendError() const override { return m_sendError; }
+    void SetZeroCopyThreshold(size_t threshold) override { m_zeroCopyThreshold = threshold; }
     void Reset() override;
-    bool KeepAlive() const override { return m_keepAlive && !m_clientClose; }
+    bool KeepAlive() const override;
     io::Descriptor& GetDescriptor() override { return m_desc; }
     Cooperator* GetCooperator() override { return m_co; }
 
+    ~ConnectionImpl();
+
     const char* LeftoverData() override
     {
-        return static_cast<Derived*>(this)->m_buf + m_parsePos;
+        return RecvBuf() + m_parsePos;
     }
     size_t LeftoverSize() override
     {
         return m_bufLen > m_parsePos ? m_bufLen - m_parsePos : 0;
     }
     bool SendRawBytes(const void* data, size_t size) override;
+    bool SendFramedChunks(struct iovec* chunks, int count) override;
+    bool SendRendered(response::Rendered const& rendered) override;
+
+    // Response batching for pipelined requests (the keep-alive loops turn it on). A finished
+    // response -- Send, SendHeaders, EndChunked -- stays in the send buffer while more request
+    // bytes are already buffered, so the loop can answer the requests behind it and send the lot
+    // in one go with FlushResponses. Any recv flushes first, as does anything that bypasses the
+    // buffer, so a batched response never waits on the peer.
+    //
+    void SetResponseBatching(bool on) { m_batching = on; }
+    bool FlushResponses() { return Flush(); }
+
+    // Whether the recv buffer already holds the complete head of another request. Meaningful right
+    // after Reset.
+    //
+    bool PipelinedRequestReady() const;
 
   private:
-    // Buffer access via CRTP — resolved to compile-time offset, no pointer indirection
+    // Buffer access via CRTP — resolved to compile-time offset, no pointer indirection, unless a
+    // head has outgrown the inline recv buffer (Grow)
     //
-    char* RecvBuf() { return static_cast<Derived*>(this)->m_buf; }
-    size_t RecvBufSize() const { return static_cast<const Derived*>(this)->m_recvBufSize; }
+    char* RecvBuf()
+    {
+        return m_grownCount ? m_grown[m_grownCount - 1].data : static_cast<Derived*>(this)->m_buf;
+    }
+    char const* RecvBuf() const
+    {
+        return m_grownCount ? m_grown[m_grownCount - 1].data
+                            : static_cast<const Derived*>(this)->m_buf;
+    }
+    size_t RecvBufSize() const
+    {
+        return m_grownCount ? GROWN_BUFFER_SIZES[m_grown[m_grownCount - 1].cls]
+                            : static_cast<const Derived*>(this)->m_recvBufSize;
+    }
     char* SendBuf() { return static_cast<Derived*>(this)->m_buf +
                              static_cast<const Derived*>(this)->m_recvBufSize; }
     size_t SendBufSize() const { return static_cast<const Derived*>(this)->m_sendBufSize; }
@@ -145,28 +336,65 @@ struct ConnectionImpl : ConnectionBase
     //
     int TransportRecv(void* buf, size_t size, int flags, time::Interval timeout)
     {
-        return static_cast<Derived*>(this)->DoRecv(buf, size, flags, timeout);
+        return CountIn(static_cast<Derived*>(this)->DoRecv(buf, size, flags, timeout));
     }
 
     int TransportSendAll(const void* buf, size_t size)
     {
-        return static_cast<Derived*>(this)->DoSendAll(buf, size);
+        return CountOut(static_cast<Derived*>(this)->DoSendAll(buf, size));
+    }
+
+    int TransportSendAllv(struct iovec* iov, int iovcnt)
+    {
+        return CountOut(static_cast<Derived*>(this)->DoSendAllv(iov, iovcnt));
+    }
+
+    int TransportSendAllZeroCopy(const void* buf, size_t size)
+    {
+        return CountOut(static_cast<Derived*>(this)->DoSendAllZeroCopy(buf, size));
     }
 
     int TransportSendfileAll(int in_fd, off_t offset, size_t count)
     {
-        return static_cast<Derived*>(this)->DoSendfileAll(in_fd, offset, count);
+        return CountOut(static_cast<Derived*>(this)->DoSendfileAll(in_fd, offset, count));
+    }
+
+    int CountIn(int n)
+    {
+        m_bytesIn += n > 0 ? static_cast<uint64_t>(n) : 0;
+        return n;
+    }
+
+    int CountOut(int n)
+    {
+        m_bytesOut += n > 0 ? static_cast<uint64_t>(n) : 0;
+        return n;
+    }
+
+    bool TransportCanSplice()
+    {
+        return static_cast<Derived*>(this)->DoCanSplice();
+    }
+
+    bool TransportCanSpliceInto()
+    {
+        return static_cast<Derived*>(this)->DoCanSpliceInto();
     }
 
     // Write buffer management
     //
     bool Append(const void* data, size_t size);
     bool Flush();
+    bool FlushResponse();
     bool AppendUInt(size_t val);
     bool AppendHex(size_t val);
     template<size_t N>
     bool AppendLiteral(const char (&s)[N]);
     bool AppendConnectionTrailer();
+    bool AppendPreamble(int status);
+    bool AppendPreamble(int status, response::Fragment statusLine);
+    bool AppendChunkedPreamble();
+    bool AppendChunk(const void* data, size_t size, const char* trailer, size_t trailerSize);
 
     enum Phase
     {
@@ -180,15 +408,23 @@ struct ConnectionImpl : ConnectionBase
     // Buffer management
     //
     int RecvMore();
-    void Compact();
+    void Compact(bool force = false);
+    bool Grow();
+    void ReturnGrown();
 
     // Internal parsing helpers
     //
     bool ParseRequestLine();
     bool AdvanceToPhase(Phase target);
     Chunk* ReadChunkedBody();
+    void MalformedChunk();
     void SkipToHeaders();
     bool SendRaw(const void* data, size_t size);
+    bool SendRawZeroCopy(const void* data, size_t size);
+
+    // The send buffer, then body from the caller's memory, then trailer, in one gather write
+    //
+    bool SendGather(const void* body, size_t size, const char* trailer, size_t trailerSize);
 
     io::Descriptor& m_desc;
     Context*        m_ctx;
@@ -199,6 +435,18 @@ struct ConnectionImpl : ConnectionBase
     size_t          m_parsePos;
     size_t          m_sendLen;
 
+    // Pooled recv buffers this request's head has grown into, oldest first, the last in use. The
+    // earlier ones -- and the inline buffer -- are not written again until Reset returns them: the
+    // request line and any value the handler holds may point into them.
+    //
+    struct Grown
+    {
+        char*   data;
+        uint8_t cls;
+    };
+    Grown           m_grown[GROWN_BUFFER_CLASSES];
+    uint8_t         m_grownCount;
+
     Phase           m_phase;
     int64_t         m_contentLength;
     bool            m_chunkedBody;
@@ -213,14 +461,24 @@ struct ConnectionImpl : ConnectionBase
     bool            m_pendingContentLength;
     bool            m_pendingTransferEncoding;
     bool            m_pendingConnection;
+    bool            m_pendingAcceptEncoding;
+    bool            m_pendingTraceParent;
 
     bool            m_chunkedHeadersPending;
     int             m_chunkedStatus;
     const char*     m_chunkedContentType;
+    bool            m_chunkedVary;
+
+    // Coded bodies are built here; the buffer's capacity carries over from response to response
+    //
+    Compressor      m_compressor;
+    std::string     m_compressed;
 
     bool            m_keepAlive;
     bool            m_clientClose;
     bool            m_sendError;
+    size_t          m_zeroCopyThreshold;
+    bool            m_batching;
 };
 
 // Connection<Transport> is the final, concrete HTTP connection. The transport template parameter
@@ -251,7 +509,16 @@ struct Connection final : ConnectionImpl<Connection<Transport>>
     , m_transport(transport)
     , m_recvBufSize(recvBufSize)
     , m_sendBufSize(sendBufSize)
-    {}
+    {
+        AccountMemory(MemoryTag::HttpConnection, Bytes(), 1);
+    }
+
+    ~Connection()
+    {
+        AccountMemory(MemoryTag::HttpConnection, -Bytes(), -1);
+    }
+
+    int64_t Bytes() const { return sizeof(Connection) + m_recvBufSize + m_sendBufSize; }
 
     // CRTP transport dispatch — called by ConnectionImpl, fully inlined
     //
@@ -265,11 +532,31 @@ struct Connection final : ConnectionImpl<Connection<Transport>>
         return m_transport.SendAll(buf, size);
     }
 
+    int DoSendAllv(struct iovec* iov, int iovcnt)
+    {
+        return m_transport.SendAllv(iov, iovcnt);
+    }
+
+    int DoSendAllZeroCopy(const void* buf, size_t size)
+    {
+        return m_transport.SendAllZeroCopy(buf, size);
+    }
+
     int DoSendfileAll(int in_fd, off_t offset, size_t count)
     {
         return m_transport.SendfileAll(in_fd, offset, count);
     }
 
+    bool DoCanSplice()
+    {
+        return m_transport.CanSplice();
+    }
+
+    bool DoCanSpliceInto()
+    {
+        return m_transport.CanSpliceInto();
+    }
+
     Transport       m_transport;
     size_t          m_recvBufSize;
     size_t          m_sendBufSize;
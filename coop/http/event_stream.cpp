@@ -0,0 +1,273 @@
+#include "event_stream.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <sys/uio.h>
+
+#include <spdlog/spdlog.h>
+
+#include "connection.h"
+#include "coop/cooperator.h"
+#include "coop/time/sleep.h"
+
+namespace coop
+{
+namespace http
+{
+
+namespace
+{
+
+// Up to the first line break
+//
+std::string_view Line(std::string_view s)
+{
+    return s.substr(0, s.find_first_of("\r\n"));
+}
+
+void AppendField(std::string* out, const char* name, std::string_view value)
+{
+    out->append(name);
+    out->append(": ");
+    out->append(value);
+    out->push_back('\n');
+}
+
+std::string FormatEvent(std::string_view data, std::string_view event, std::string_view id)
+{
+    std::string out;
+    if (!id.empty())
+    {
+        AppendField(&out, "id", Line(id));
+    }
+    if (!event.empty())
+    {
+        AppendField(&out, "event", Line(event));
+    }
+    for (;;)
+    {
+        size_t end = data.find('\n');
+        AppendField(&out, "data", data.substr(0, end));
+        if (end == std::string_view::npos)
+        {
+            break;
+        }
+        data.remove_prefix(end + 1);
+    }
+    out.push_back('\n');
+    return out;
+}
+
+} // end anonymous namespace
+
+// ---------------------------------------------------------------------------
+// SharedEvent
+// ---------------------------------------------------------------------------
+
+namespace detail
+{
+
+SharedEvent* SharedEvent::Make(std::string_view payload)
+{
+    char head[20];
+    int headSize = snprintf(head, sizeof(head), "%zx\r\n", payload.size());
+    size_t size = static_cast<size_t>(headSize) + payload.size() + 2;
+
+    void* memory = ::operator new(sizeof(SharedEvent) + size);
+    auto* event = new (memory) SharedEvent;
+    event->m_size = size;
+    memcpy(event->m_data, head, static_cast<size_t>(headSize));
+    memcpy(event->m_data + headSize, payload.data(), payload.size());
+    memcpy(event->m_data + size - 2, "\r\n", 2);
+    return event;
+}
+
+void SharedEvent::Release()
+{
+    assert(m_refs > 0);
+    if (--m_refs == 0)
+    {
+        this->~SharedEvent();
+        ::operator delete(this);
+    }
+}
+
+EventRef& EventRef::operator=(EventRef const& other)
+{
+    if (other.m_event)
+    {
+        other.m_event->AddRef();
+    }
+    if (m_event)
+    {
+        m_event->Release();
+    }
+    m_event = other.m_event;
+    return *this;
+}
+
+} // end namespace coop::http::detail
+
+// ---------------------------------------------------------------------------
+// EventTopic
+// ---------------------------------------------------------------------------
+
+EventTopic::EventTopic(Context* ctx /* = Self() */, EventTopicOptions const& options)
+: m_options(options)
+, m_heartbeat(detail::SharedEvent::Make(":\n\n"))
+{
+    if (m_options.heartbeat.count() <= 0)
+    {
+        return;
+    }
+
+    // As DateClock's ticker: it holds m_exit for its whole run, taken inside Spawn, before the
+    // destructor can wait on it
+    //
+    bool spawned = ctx->GetCooperator()->Spawn([this](Context* beatCtx)
+    {
+        beatCtx->SetName("EventTopicHeartbeat");
+        m_exit.Acquire(beatCtx);
+        Beat(beatCtx);
+        m_exit.Release(beatCtx, false);
+    }, &m_beater);
+    if (!spawned)
+    {
+        spdlog::warn("event topic heartbeat spawn failed, streams get no heartbeats");
+    }
+}
+
+EventTopic::~EventTopic()
+{
+    if (m_beater)
+    {
+        m_beater.Kill();
+    }
+    auto* ctx = Self();
+    m_exit.Acquire(ctx);
+    m_exit.Release(ctx, false);
+    Shutdown();
+}
+
+// A beat goes out only after a whole quiet interval: a busy topic sends none
+//
+void EventTopic::Beat(Context* ctx)
+{
+    uint64_t seen = m_ring.Sent();
+    while (!ctx->IsKilled() && !m_ring.IsShutdown())
+    {
+        if (time::Sleep(ctx, m_options.heartbeat) != time::SleepResult::Ok)
+        {
+            break;
+        }
+        if (m_ring.Sent() == seen)
+        {
+            m_ring.TrySend(m_heartbeat);
+        }
+        seen = m_ring.Sent();
+    }
+}
+
+bool EventTopic::Publish(std::string_view data, std::string_view event, std::string_view id)
+{
+    if (m_ring.IsShutdown())
+    {
+        return false;
+    }
+    return m_ring.Send(detail::EventRef(detail::SharedEvent::Make(FormatEvent(data, event, id))));
+}
+
+void EventTopic::Shutdown()
+{
+    m_ring.Shutdown();
+}
+
+// ---------------------------------------------------------------------------
+// EventStream
+// ---------------------------------------------------------------------------
+
+EventStream::EventStream(ConnectionBase& conn, EventTopic& topic,
+                         EventStreamOptions const& options)
+: m_conn(conn)
+, m_options(options)
+, m_reader(topic.m_ring, options.lag)
+{
+}
+
+int EventStream::Run(Context* ctx /* = Self() */)
+{
+    // Intermediaries must not cache or hold the stream; the handler's own lines win
+    //
+    if (m_conn.m_responseHeaders.empty())
+    {
+        m_conn.SetResponseHeaders("Cache-Control: no-cache\r\n");
+    }
+    if (!m_conn.BeginChunked(200, "text/event-stream"))
+    {
+        return -EIO;
+    }
+
+    // Something to open with, so the client has the headers now rather than at the first event
+    //
+    {
+        std::string opening = ":\n\n";
+        if (m_options.retry.count() > 0)
+        {
+            auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(m_options.retry);
+            opening = "retry: " + std::to_string(millis.count()) + "\n\n";
+        }
+        detail::EventRef first(detail::SharedEvent::Make(opening));
+        struct iovec iov = {const_cast<char*>(first.Get()->Data()), first.Get()->Size()};
+        if (!m_conn.SendFramedChunks(&iov, 1))
+        {
+            return -EIO;
+        }
+    }
+
+    detail::EventRef events[BATCH];
+    struct iovec iov[BATCH];
+    for (;;)
+    {
+        if (!m_reader.RecvKill(events[0]))
+        {
+            break;
+        }
+        int count = 1;
+        while (count < BATCH && m_reader.TryRecv(events[count]))
+        {
+            count++;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            auto* event = events[i].Get();
+            iov[i] = {const_cast<char*>(event->Data()), event->Size()};
+        }
+        bool sent = m_conn.SendFramedChunks(iov, count);
+        for (int i = 0; i < count; i++)
+        {
+            events[i] = detail::EventRef();
+        }
+        if (!sent)
+        {
+            return -EIO;
+        }
+    }
+
+    if (ctx->IsKilled())
+    {
+        return -ECANCELED;
+    }
+    if (!m_conn.EndChunked())
+    {
+        return -EIO;
+    }
+    return m_reader.IsDisconnected() ? -ENOBUFS : 0;
+}
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,180 @@
+#pragma once
+
+// Server-Sent Events (text/event-stream): one EventTopic fans events out to every EventStream
+// subscribed to it.
+//
+//   coop::http::EventTopic* s_quotes;     // made on the serving cooperator
+//
+//   void HandleQuotes(coop::http::ConnectionBase& conn)
+//   {
+//       coop::http::EventStream stream(conn, *s_quotes);
+//       stream.Run();                     // until the topic shuts down, the client goes, or kill
+//   }
+//
+//   s_quotes->Publish("{\"AAPL\":187.2}", "quote");
+//
+// Publish formats the event once -- the "id:", "event:" and "data:" lines and, around them, the
+// HTTP/1.1 chunk framing -- into a shared buffer, and appends a reference to it to the topic's
+// chan::Broadcast ring. Each stream is a cursor on that ring, read from the handler's own context:
+// it wakes once per send it can make, takes everything published since (up to BATCH events), and
+// writes them in one gathered send straight from the shared buffers (SendFramedChunks), so a
+// subscriber costs a wake and a writev per batch and nothing is formatted or copied per
+// connection. HTTP/2 streams send the same buffers' data as DATA frames.
+//
+// Heartbeats are the topic's: one context sleeping on the cooperator's timers publishes a comment
+// line whenever a whole interval passed with no event published, however many streams there are.
+// They keep intermediaries from timing the streams out and surface dead clients as failed sends.
+//
+// A stream RING events behind the topic is in the way of the next Publish, which is where its lag
+// policy applies (chan::Lag): DropOldest (the default) skips events, Disconnect ends the stream so
+// the client reconnects, Block holds the publisher up until it catches up.
+//
+// Single cooperator: the topic, its publishers, and the handlers serving its streams share one,
+// as chan::Broadcast does. Destroying or shutting down the topic ends every stream's response
+// once it has sent what it had.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "coop/chan/broadcast.h"
+#include "coop/context.h"
+#include "coop/coordinator.h"
+#include "coop/self.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+namespace http
+{
+
+struct ConnectionBase;
+
+namespace detail
+{
+
+// One event as it goes on the wire, chunk framing included, shared by every stream. Counted by
+// hand: a topic and its streams live on one cooperator.
+//
+struct SharedEvent
+{
+    static SharedEvent* Make(std::string_view payload);
+
+    void AddRef() { m_refs++; }
+    void Release();
+
+    const char* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+  private:
+    SharedEvent() = default;
+
+    uint32_t    m_refs = 1;
+    size_t      m_size = 0;
+    char        m_data[0];
+};
+
+// The ring's element: a counted reference, so an event lives until every slot and stream holding
+// it lets go
+//
+struct EventRef
+{
+    EventRef() = default;
+    explicit EventRef(SharedEvent* event) : m_event(event) {}
+    EventRef(EventRef const& other) : m_event(other.m_event) { if (m_event) m_event->AddRef(); }
+    EventRef& operator=(EventRef const& other);
+    ~EventRef() { if (m_event) m_event->Release(); }
+
+    SharedEvent* Get() const { return m_event; }
+    explicit operator bool() const { return m_event != nullptr; }
+
+  private:
+    SharedEvent* m_event = nullptr;
+};
+
+} // end namespace coop::http::detail
+
+struct EventTopicOptions
+{
+    // A comment line to every stream after this long with no event published; zero for none
+    //
+    time::Interval heartbeat = std::chrono::seconds(15);
+};
+
+struct EventTopic
+{
+    static constexpr size_t RING = 256;
+    using Ring = chan::Broadcast<detail::EventRef, RING>;
+
+    explicit EventTopic(Context* ctx = Self(), EventTopicOptions const& options = {});
+    ~EventTopic();
+
+    EventTopic(EventTopic const&) = delete;
+    EventTopic& operator=(EventTopic const&) = delete;
+
+    // One event to every stream subscribed. data may span lines, each sent as its own "data:" line;
+    // event and id, when given, are single lines (anything from a line break on is left out).
+    // Blocks only while a Block stream lags. False once the topic is shut down.
+    //
+    bool Publish(std::string_view data, std::string_view event = {}, std::string_view id = {});
+
+    // Streams send what they have and end their responses. Idempotent.
+    //
+    void Shutdown();
+
+    size_t Subscribers() const { return m_ring.Readers(); }
+    uint64_t Published() const { return m_ring.Sent(); }
+
+  private:
+    friend struct EventStream;
+
+    void Beat(Context* ctx);
+
+    EventTopicOptions   m_options;
+    Ring                m_ring;
+    detail::EventRef    m_heartbeat;
+    Coordinator         m_exit;
+    Context::Handle     m_beater;
+};
+
+struct EventStreamOptions
+{
+    chan::Lag lag = chan::Lag::DropOldest;
+
+    // The client's reconnection delay, sent ahead of the first event ("retry:"); zero to leave it
+    // to the client
+    //
+    time::Interval retry = time::Interval(0);
+};
+
+// One connection's subscription. It joins the topic when constructed (it sees what is published
+// from then on) and leaves when destroyed.
+//
+struct EventStream
+{
+    static constexpr int BATCH = 64;
+
+    EventStream(ConnectionBase& conn, EventTopic& topic, EventStreamOptions const& options = {});
+
+    EventStream(EventStream const&) = delete;
+    EventStream& operator=(EventStream const&) = delete;
+
+    // Begin the 200 text/event-stream response and send events until the topic is shut down or
+    // destroyed, which ends it and returns 0. -ENOBUFS when a Disconnect stream fell too far
+    // behind (the response is ended too), -EIO when a send fails, -ECANCELED on kill.
+    //
+    int Run(Context* ctx = Self());
+
+    // Events lost to the DropOldest policy
+    //
+    uint64_t Dropped() const { return m_reader.Dropped(); }
+
+  private:
+    ConnectionBase&         m_conn;
+    EventStreamOptions      m_options;
+    EventTopic::Ring::Reader m_reader;
+};
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,398 @@
+#include "file_response.h"
+#include "common_headers.h"
+#include "connection.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <strings.h>
+
+namespace coop
+{
+namespace http
+{
+
+namespace
+{
+
+#define BYTERANGES_BOUNDARY "coop-byteranges-5c1d2e8a9f"
+
+constexpr char kMultipartType[] = "multipart/byteranges; boundary=" BYTERANGES_BOUNDARY;
+constexpr char kMultipartEnd[] = "\r\n--" BYTERANGES_BOUNDARY "--\r\n";
+
+struct ByteRange
+{
+    uint64_t first;
+    uint64_t last;
+};
+
+enum class RangeResult
+{
+    IGNORE,             // no usable Range: send the whole file
+    UNSATISFIABLE,
+    SATISFIABLE,
+};
+
+std::string_view Trim(std::string_view s)
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+    {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+    {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+// Next comma-separated item of a list header, trimmed; empty items are skipped
+//
+bool NextItem(std::string_view* list, std::string_view* item)
+{
+    while (!list->empty())
+    {
+        size_t comma = list->find(',');
+        *item = Trim(list->substr(0, comma));
+        *list = comma == std::string_view::npos ? std::string_view() : list->substr(comma + 1);
+        if (!item->empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Decimal digits only, at most 19 of them, so the value always fits
+//
+bool ParseNumber(std::string_view text, uint64_t* value)
+{
+    if (text.empty() || text.size() > 19)
+    {
+        return false;
+    }
+    *value = 0;
+    for (char c : text)
+    {
+        if (c < '0' || c > '9')
+        {
+            return false;
+        }
+        *value = *value * 10 + uint64_t(c - '0');
+    }
+    return true;
+}
+
+// If-None-Match uses the weak comparison: W/ prefixes do not matter (RFC 9110 13.1.2)
+//
+bool MatchesAny(std::string_view list, std::string_view etag)
+{
+    std::string_view item;
+    while (NextItem(&list, &item))
+    {
+        if (item == "*")
+        {
+            return true;
+        }
+        if (item.size() > 2 && item[0] == 'W' && item[1] == '/')
+        {
+            item.remove_prefix(2);
+        }
+        if (item == etag)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NotModified(FileConditions const& conditions, std::string_view etag, int64_t mtime)
+{
+    if (!conditions.ifNoneMatch.empty())
+    {
+        return MatchesAny(conditions.ifNoneMatch, etag);
+    }
+    if (!conditions.ifModifiedSince.empty())
+    {
+        int64_t since = response::ParseHttpDate(Trim(conditions.ifModifiedSince));
+        return since >= 0 && mtime <= since;
+    }
+    return false;
+}
+
+// If-Range takes the strong comparison for an entity tag, and an exact match for a date
+// (RFC 9110 13.1.5)
+//
+bool RangeStillApplies(std::string_view ifRange, std::string_view etag, int64_t mtime)
+{
+    ifRange = Trim(ifRange);
+    if (ifRange.empty())
+    {
+        return true;
+    }
+    if (ifRange[0] == '"')
+    {
+        return ifRange == etag;
+    }
+    return response::ParseHttpDate(ifRange) == mtime;
+}
+
+RangeResult ParseRanges(std::string_view value, uint64_t size, ByteRange* ranges, size_t* count)
+{
+    value = Trim(value);
+    if (value.size() < 6 || strncasecmp(value.data(), "bytes=", 6) != 0)
+    {
+        return RangeResult::IGNORE;
+    }
+    value.remove_prefix(6);
+
+    *count = 0;
+    uint64_t total = 0;
+    std::string_view spec;
+    while (NextItem(&value, &spec))
+    {
+        size_t dash = spec.find('-');
+        if (dash == std::string_view::npos)
+        {
+            return RangeResult::IGNORE;
+        }
+        auto firstText = Trim(spec.substr(0, dash));
+        auto lastText = Trim(spec.substr(dash + 1));
+
+        ByteRange range;
+        if (firstText.empty())
+        {
+            // A suffix: the final n bytes
+            //
+            uint64_t suffix;
+            if (!ParseNumber(lastText, &suffix))
+            {
+                return RangeResult::IGNORE;
+            }
+            if (suffix == 0)
+            {
+                continue;
+            }
+            range.first = suffix < size ? size - suffix : 0;
+            range.last = size - 1;
+        }
+        else
+        {
+            if (!ParseNumber(firstText, &range.first))
+            {
+                return RangeResult::IGNORE;
+            }
+            range.last = size - 1;
+            if (!lastText.empty())
+            {
+                if (!ParseNumber(lastText, &range.last) || range.last < range.first)
+                {
+                    return RangeResult::IGNORE;
+                }
+                range.last = std::min(range.last, size - 1);
+            }
+            if (range.first >= size)
+            {
+                continue;
+            }
+        }
+
+        if (*count == MAX_RANGES)
+        {
+            return RangeResult::IGNORE;
+        }
+        total += range.last - range.first + 1;
+        if (total > size)
+        {
+            return RangeResult::IGNORE;
+        }
+        ranges[(*count)++] = range;
+    }
+    return *count > 0 ? RangeResult::SATISFIABLE : RangeResult::UNSATISFIABLE;
+}
+
+size_t AppendLine(char* buf, size_t at, size_t capacity, const char* format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+size_t AppendLine(char* buf, size_t at, size_t capacity, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf + at, capacity - at, format, args);
+    va_end(args);
+    return n < 0 ? at : std::min(at + size_t(n), capacity - 1);
+}
+
+bool SendRanges(ConnectionBase& conn, FileInfo const& file, ByteRange const* ranges,
+                size_t count)
+{
+    // Every part's header first, so Content-Length is known before any of the body goes
+    //
+    std::string headers;
+    size_t ends[MAX_RANGES];
+    uint64_t total = sizeof(kMultipartEnd) - 1;
+    char line[128];
+    for (size_t i = 0; i < count; i++)
+    {
+        headers += "\r\n--" BYTERANGES_BOUNDARY "\r\nContent-Type: ";
+        headers += file.contentType;
+        snprintf(line, sizeof(line), "\r\nContent-Range: bytes %llu-%llu/%llu\r\n\r\n",
+                 static_cast<unsigned long long>(ranges[i].first),
+                 static_cast<unsigned long long>(ranges[i].last),
+                 static_cast<unsigned long long>(file.size));
+        headers += line;
+        ends[i] = headers.size();
+        total += ranges[i].last - ranges[i].first + 1;
+    }
+    total += headers.size();
+
+    if (!conn.SendHeaders(206, kMultipartType, total))
+    {
+        return false;
+    }
+    size_t at = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!conn.SendRawBytes(headers.data() + at, ends[i] - at)
+            || !conn.Sendfile(file.fd, off_t(ranges[i].first),
+                              ranges[i].last - ranges[i].first + 1))
+        {
+            return false;
+        }
+        at = ends[i];
+    }
+    return conn.SendRawBytes(kMultipartEnd, sizeof(kMultipartEnd) - 1);
+}
+
+} // end anonymous namespace
+
+void FileConditions::Read(ConnectionBase& conn)
+{
+    while (const char* name = conn.NextHeaderName())
+    {
+        std::string* value = nullptr;
+        if (strcasecmp(name, "if-none-match") == 0)
+        {
+            value = &ifNoneMatch;
+        }
+        else if (strcasecmp(name, "if-modified-since") == 0)
+        {
+            value = &ifModifiedSince;
+        }
+        else if (strcasecmp(name, "range") == 0)
+        {
+            value = &range;
+        }
+        else if (strcasecmp(name, "if-range") == 0)
+        {
+            value = &ifRange;
+        }
+
+        if (!value)
+        {
+            conn.SkipHeaderValue();
+            continue;
+        }
+
+        value->clear();
+        while (Chunk* chunk = conn.ReadHeaderValue())
+        {
+            if (value->size() <= MAX_VALUE)
+            {
+                value->append(static_cast<const char*>(chunk->data),
+                              std::min(chunk->size, MAX_VALUE + 1 - value->size()));
+            }
+            if (chunk->complete)
+            {
+                break;
+            }
+        }
+        if (value->size() > MAX_VALUE)
+        {
+            value->clear();
+        }
+    }
+}
+
+size_t FormatETag(FileInfo const& file, char* out)
+{
+    const char* suffix = "";
+    switch (file.encoding)
+    {
+    case ContentEncoding::GZIP:     suffix = "-gz"; break;
+    case ContentEncoding::DEFLATE:  suffix = "-df"; break;
+    case ContentEncoding::ZSTD:     suffix = "-zst"; break;
+    default:                        break;
+    }
+    int n = snprintf(out, ETAG_MAX, "\"%llx-%llx%s\"",
+                     static_cast<unsigned long long>(file.size),
+                     static_cast<unsigned long long>(file.mtimeNs), suffix);
+    return n < 0 ? 0 : std::min(size_t(n), ETAG_MAX - 1);
+}
+
+bool SendFileResponse(ConnectionBase& conn, FileConditions const& conditions,
+                      FileInfo const& file)
+{
+    char etagBuf[ETAG_MAX];
+    std::string_view etag(etagBuf, FormatETag(file, etagBuf));
+    int64_t mtime = file.mtimeNs / 1000000000;
+
+    char modified[response::HTTP_DATE_SIZE + 1];
+    response::FormatHttpDate(mtime, modified);
+    modified[response::HTTP_DATE_SIZE] = '\0';
+
+    // Validators on every answer, 304 and 416 included. The lines must outlive the send method.
+    //
+    char lines[256];
+    size_t size = AppendLine(lines, 0, sizeof(lines),
+                             "ETag: %.*s\r\nLast-Modified: %s\r\nAccept-Ranges: bytes\r\n",
+                             int(etag.size()), etag.data(), modified);
+    conn.SetContentEncoding(file.encoding);
+    conn.SetResponseHeaders(std::string_view(lines, size));
+
+    if (NotModified(conditions, etag, mtime))
+    {
+        return conn.SendHeaders(304, file.contentType, file.size);
+    }
+
+    ByteRange ranges[MAX_RANGES];
+    size_t count = 0;
+    auto result = RangeResult::IGNORE;
+    if (!conditions.range.empty() && file.size > 0
+        && RangeStillApplies(conditions.ifRange, etag, mtime))
+    {
+        result = ParseRanges(conditions.range, file.size, ranges, &count);
+    }
+
+    switch (result)
+    {
+    case RangeResult::UNSATISFIABLE:
+        size = AppendLine(lines, size, sizeof(lines), "Content-Range: bytes */%llu\r\n",
+                          static_cast<unsigned long long>(file.size));
+        conn.SetResponseHeaders(std::string_view(lines, size));
+        return conn.Send(416, "text/plain", "", 0);
+
+    case RangeResult::SATISFIABLE:
+        if (count > 1)
+        {
+            return SendRanges(conn, file, ranges, count);
+        }
+        size = AppendLine(lines, size, sizeof(lines), "Content-Range: bytes %llu-%llu/%llu\r\n",
+                          static_cast<unsigned long long>(ranges[0].first),
+                          static_cast<unsigned long long>(ranges[0].last),
+                          static_cast<unsigned long long>(file.size));
+        conn.SetResponseHeaders(std::string_view(lines, size));
+        return conn.SendHeaders(206, file.contentType, ranges[0].last - ranges[0].first + 1)
+            && conn.Sendfile(file.fd, off_t(ranges[0].first),
+                             ranges[0].last - ranges[0].first + 1);
+
+    default:
+        return conn.SendHeaders(200, file.contentType, file.size)
+            && (file.size == 0 || conn.Sendfile(file.fd, 0, file.size));
+    }
+}
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "compression.h"
+
+namespace coop
+{
+namespace http
+{
+
+struct ConnectionBase;
+
+// A file to answer with: an open fd and the stat data io::FileCache keeps for it. encoding is the
+// coding the file is stored in (a precompressed sibling), IDENTITY for the file itself.
+//
+struct FileInfo
+{
+    int                 fd = -1;
+    uint64_t            size = 0;
+    int64_t             mtimeNs = 0;
+    const char*         contentType = "application/octet-stream";
+    ContentEncoding     encoding = ContentEncoding::IDENTITY;
+};
+
+// The request headers a file response depends on (RFC 9110 13, 14), copied out as the headers go
+// by: the parser's buffer moves on before the response is chosen. Values past MAX_VALUE bytes are
+// dropped, as if the header had not been sent.
+//
+struct FileConditions
+{
+    static constexpr size_t MAX_VALUE = 1024;
+
+    // Read the request's remaining headers, keeping these and skipping the others. Headers the
+    // handler already read are not seen again, so call this before reading any.
+    //
+    void Read(ConnectionBase& conn);
+
+    std::string ifNoneMatch;
+    std::string ifModifiedSince;
+    std::string range;
+    std::string ifRange;
+};
+
+// Strong validator for the file's current contents, from its size, mtime and coding:
+// "\"<size hex>-<mtime ns hex>\"", with a coding suffix for a precompressed sibling, so each
+// representation validates on its own. Returns the length written; out holds ETAG_MAX bytes.
+//
+constexpr size_t ETAG_MAX = 48;
+size_t FormatETag(FileInfo const& file, char* out);
+
+// Answer a GET for file, carrying ETag, Last-Modified and Accept-Ranges:
+//
+//  - 304, with no body, when If-None-Match (or, without one, If-Modified-Since) says the client's
+//    copy is current -- decided from the cached stat data, the body is never read
+//  - 206 for a satisfiable Range, in one part, or as multipart/byteranges for several
+//  - 416 when no range in it is satisfiable
+//  - 200 with the whole file otherwise: no Range, an If-Range that no longer matches, or a Range
+//    that is malformed, asks for more than MAX_RANGES parts or, overlapping, more than the file
+//
+// Range parts go through Sendfile, so a plaintext connection still never copies the body.
+//
+constexpr size_t MAX_RANGES = 16;
+bool SendFileResponse(ConnectionBase& conn, FileConditions const& conditions,
+                      FileInfo const& file);
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,296 @@
+#pragma once
+
+// Header lookup by interest set: the names a handler wants, registered before the headers are
+// read, and their values captured as the parser goes by.
+//
+//   static const coop::http::HeaderSet s_wanted = {
+//       coop::http::header::USER_AGENT,
+//       coop::http::header::AUTHORIZATION,
+//       coop::http::HeaderName("x-request-id"),
+//   };
+//
+//   void Handle(coop::http::ConnectionBase& conn)
+//   {
+//       conn.CaptureHeaders(s_wanted);
+//       auto agent = conn.Header(coop::http::header::USER_AGENT);   // std::optional<string_view>
+//       ...
+//   }
+//
+// A HeaderName carries a case-insensitive hash of the name, computed at compile time for
+// constants. The parser computes the same hash for every header line it scans, from the first
+// and last 8 bytes of the name the colon scan already delimited, so a line costs one probe of
+// the set's table, with one case-insensitive compare only on a hash match. That replaces a
+// compare per wanted name per line. Lookups after the scan are the same probe.
+//
+// Values are copied out of the receive buffer as they are read into one buffer per connection,
+// whose capacity carries over from request to request, so they stay valid until the next
+// request. A header sent more than once is captured as its values joined with ", " (RFC 9110
+// 5.3). Header() reads through whatever headers the handler left first; CaptureHeaders must
+// come before the handler reads any itself, since lines already parsed are not revisited.
+//
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <strings.h>
+#include <type_traits>
+
+namespace coop
+{
+namespace http
+{
+
+namespace detail
+{
+
+// Up to 8 bytes little-endian, zero-padded, with 0x20 or'd into each byte present: ASCII
+// letters fold to lower case. Other bytes fold too ('@' with '`'), which only costs a compare.
+// At run time, 4 bytes or more are two overlapping loads, never reading past p + n.
+//
+constexpr uint64_t LoadFolded(const char* p, size_t n)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+    uint64_t v = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (!std::is_constant_evaluated() && n >= 4)
+    {
+        if (n == 8)
+        {
+            memcpy(&v, p, 8);
+            return v | 0x2020202020202020ull;
+        }
+        uint32_t lo;
+        uint32_t hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + n - 4, 4);
+        v = lo | (uint64_t(hi) << (8 * (n - 4)));
+        return v | (0x2020202020202020ull >> (64 - 8 * n));
+    }
+#endif
+    for (size_t i = 0; i < n; i++)
+    {
+        v |= uint64_t(static_cast<unsigned char>(p[i])) << (8 * i);
+    }
+    return v | (0x2020202020202020ull >> (64 - 8 * n));
+}
+
+// The first and last 8 bytes and the length: names that differ only in the middle collide and
+// are told apart by the compare
+//
+constexpr uint64_t HeaderNameHash(const char* p, size_t n)
+{
+    uint64_t first = LoadFolded(p, n < 8 ? n : 8);
+    uint64_t last = n > 8 ? LoadFolded(p + n - 8, 8) : first;
+    uint64_t h = first * 0x9e3779b97f4a7c15ull;
+    h ^= (last + n) * 0xc2b2ae3d27d4eb4full;
+    return h ^ (h >> 29);
+}
+
+constexpr bool HeaderNameEquals(std::string_view a, const char* b, size_t n)
+{
+    if (a.size() != n)
+    {
+        return false;
+    }
+    if (!std::is_constant_evaluated())
+    {
+        return strncasecmp(a.data(), b, n) == 0;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        char x = a[i];
+        char y = b[i];
+        if (x >= 'A' && x <= 'Z') x = static_cast<char>(x + 32);
+        if (y >= 'A' && y <= 'Z') y = static_cast<char>(y + 32);
+        if (x != y)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // end namespace coop::http::detail
+
+struct HeaderName
+{
+    constexpr HeaderName() = default;
+
+    explicit constexpr HeaderName(std::string_view name)
+    : name(name)
+    , hash(detail::HeaderNameHash(name.data(), name.size()))
+    {
+    }
+
+    constexpr bool Matches(uint64_t h, const char* other, size_t size) const
+    {
+        return h == hash && detail::HeaderNameEquals(name, other, size);
+    }
+
+    std::string_view    name;
+    uint64_t            hash = 0;
+};
+
+namespace header
+{
+
+inline constexpr HeaderName ACCEPT{"accept"};
+inline constexpr HeaderName ACCEPT_LANGUAGE{"accept-language"};
+inline constexpr HeaderName AUTHORIZATION{"authorization"};
+inline constexpr HeaderName CONTENT_TYPE{"content-type"};
+inline constexpr HeaderName COOKIE{"cookie"};
+inline constexpr HeaderName HOST{"host"};
+inline constexpr HeaderName IF_MODIFIED_SINCE{"if-modified-since"};
+inline constexpr HeaderName IF_NONE_MATCH{"if-none-match"};
+inline constexpr HeaderName ORIGIN{"origin"};
+inline constexpr HeaderName RANGE{"range"};
+inline constexpr HeaderName REFERER{"referer"};
+inline constexpr HeaderName USER_AGENT{"user-agent"};
+inline constexpr HeaderName X_FORWARDED_FOR{"x-forwarded-for"};
+inline constexpr HeaderName X_REQUEST_ID{"x-request-id"};
+
+} // end namespace coop::http::header
+
+// Up to MAX names, each given a slot in the order listed. Open addressing on the low bits of the
+// hash in a table twice as large, so a probe usually ends at its first entry. Build sets once,
+// as statics: a connection refers to its set, and does not copy it.
+//
+struct HeaderSet
+{
+    static constexpr size_t MAX = 16;
+
+    constexpr HeaderSet(std::initializer_list<HeaderName> names)
+    {
+        assert(names.size() <= MAX);
+        for (HeaderName const& name : names)
+        {
+            if (m_count == MAX)
+            {
+                break;
+            }
+            size_t i = name.hash & (TABLE - 1);
+            while (m_table[i] != 0)
+            {
+                i = (i + 1) & (TABLE - 1);
+            }
+            m_table[i] = static_cast<uint8_t>(m_count + 1);
+            m_names[m_count++] = name;
+        }
+    }
+
+    // The slot of a header name as scanned, -1 when it is not in the set
+    //
+    constexpr int Find(uint64_t hash, const char* name, size_t size) const
+    {
+        for (size_t i = hash & (TABLE - 1); m_table[i] != 0; i = (i + 1) & (TABLE - 1))
+        {
+            size_t slot = m_table[i] - 1u;
+            if (m_names[slot].Matches(hash, name, size))
+            {
+                return static_cast<int>(slot);
+            }
+        }
+        return -1;
+    }
+
+    constexpr int Find(HeaderName const& name) const
+    {
+        return Find(name.hash, name.name.data(), name.name.size());
+    }
+
+    constexpr size_t Size() const { return m_count; }
+    constexpr HeaderName const& Name(size_t slot) const { return m_names[slot]; }
+
+  private:
+    static constexpr size_t TABLE = MAX * 2;
+
+    std::array<HeaderName, MAX>     m_names = {};
+    std::array<uint8_t, TABLE>      m_table = {};       // slot + 1; 0 is empty
+    size_t                          m_count = 0;
+};
+
+// The values captured for a connection's set, by slot
+//
+struct HeaderCapture
+{
+    void Clear()
+    {
+        m_values.clear();
+        m_present = 0;
+        m_current = -1;
+    }
+
+    // A line for slot begins: a repeat is moved to the end of the buffer, ", " after it, so the
+    // value stays contiguous as it grows
+    //
+    void Begin(int slot)
+    {
+        Span& span = m_spans[slot];
+        if (m_present & (1u << slot))
+        {
+            m_values.reserve(m_values.size() + span.size + 2);
+            size_t moved = m_values.size();
+            m_values.append(m_values.data() + span.offset, span.size);
+            m_values.append(", ");
+            span = {static_cast<uint32_t>(moved), span.size + 2};
+        }
+        else
+        {
+            span = {static_cast<uint32_t>(m_values.size()), 0};
+            m_present |= 1u << slot;
+        }
+        m_current = slot;
+    }
+
+    // Part of the current line's value, if one is being captured, and whether it ends it
+    //
+    void Append(const void* data, size_t size, bool complete)
+    {
+        if (m_current < 0)
+        {
+            return;
+        }
+        m_values.append(static_cast<const char*>(data), size);
+        m_spans[m_current].size += static_cast<uint32_t>(size);
+        if (complete)
+        {
+            m_current = -1;
+        }
+    }
+
+    void End() { m_current = -1; }
+    bool Capturing() const { return m_current >= 0; }
+
+    std::optional<std::string_view> Get(int slot) const
+    {
+        if (slot < 0 || !(m_present & (1u << slot)))
+        {
+            return std::nullopt;
+        }
+        return std::string_view(m_values.data() + m_spans[slot].offset, m_spans[slot].size);
+    }
+
+  private:
+    struct Span
+    {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    std::string     m_values;
+    Span            m_spans[HeaderSet::MAX];
+    uint32_t        m_present = 0;
+    int             m_current = -1;
+};
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,504 @@
+#include "hpack.h"
+
+#include <cerrno>
+
+namespace coop
+{
+namespace http
+{
+namespace hpack
+{
+
+namespace
+{
+
+// RFC 7541 Appendix A, indices 1 through 61
+//
+constexpr Header kStaticTable[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+constexpr size_t kStaticCount = sizeof(kStaticTable) / sizeof(kStaticTable[0]);
+
+// Symbols in canonical order (by code length, then code), and how many codes there are of each
+// length: enough to decode RFC 7541 Appendix B without a tree. 256 is EOS.
+//
+constexpr uint16_t kHuffmanSymbols[257] = {
+    48, 49, 50, 97, 99, 101, 105, 111, 115, 116, 32, 37,
+    45, 46, 47, 51, 52, 53, 54, 55, 56, 57, 61, 65,
+    95, 98, 100, 102, 103, 104, 108, 109, 110, 112, 114, 117,
+    58, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76,
+    77, 78, 79, 80, 81, 82, 83, 84, 85, 86, 87, 89,
+    106, 107, 113, 118, 119, 120, 121, 122, 38, 42, 44, 59,
+    88, 90, 33, 34, 40, 41, 63, 39, 43, 124, 35, 62,
+    0, 36, 64, 91, 93, 126, 94, 125, 60, 96, 123, 92,
+    195, 208, 128, 130, 131, 162, 184, 194, 224, 226, 153, 161,
+    167, 172, 176, 177, 179, 209, 216, 217, 227, 229, 230, 129,
+    132, 133, 134, 136, 146, 154, 156, 160, 163, 164, 169, 170,
+    173, 178, 181, 185, 186, 187, 189, 190, 196, 198, 228, 232,
+    233, 1, 135, 137, 138, 139, 140, 141, 143, 147, 149, 150,
+    151, 152, 155, 157, 158, 165, 166, 168, 174, 175, 180, 182,
+    183, 188, 191, 197, 231, 239, 9, 142, 144, 145, 148, 159,
+    171, 206, 215, 225, 236, 237, 199, 207, 234, 235, 192, 193,
+    200, 201, 202, 205, 210, 213, 218, 219, 238, 240, 242, 243,
+    255, 203, 204, 211, 212, 214, 221, 222, 223, 241, 244, 245,
+    246, 247, 248, 250, 251, 252, 253, 254, 2, 3, 4, 5,
+    6, 7, 8, 11, 12, 14, 15, 16, 17, 18, 19, 20,
+    21, 23, 24, 25, 26, 27, 28, 29, 30, 31, 127, 220,
+    249, 10, 13, 22, 256,
+};
+
+constexpr uint16_t kHuffmanCounts[31] = {
+    0, 0, 0, 0, 0, 10, 26, 32, 6, 0, 5, 3, 2, 6, 2, 3,
+    0, 0, 0, 3, 8, 13, 26, 29, 12, 4, 15, 19, 29, 0, 4,
+};
+
+// Per-entry overhead in table and list size accounting (RFC 7541 4.1)
+//
+constexpr size_t kEntryOverhead = 32;
+
+// Static table index of an exact name + value match, else of the first entry with the name (as
+// a negative number), else 0
+//
+int StaticIndex(std::string_view name, std::string_view value)
+{
+    int nameMatch = 0;
+    for (size_t i = 0; i < kStaticCount; i++)
+    {
+        if (kStaticTable[i].name != name)
+        {
+            continue;
+        }
+        if (kStaticTable[i].value == value)
+        {
+            return static_cast<int>(i + 1);
+        }
+        if (!nameMatch)
+        {
+            nameMatch = -static_cast<int>(i + 1);
+        }
+    }
+    return nameMatch;
+}
+
+} // end anonymous namespace
+
+// -------------------------------------------------------------------------------------
+// HeaderList
+// -------------------------------------------------------------------------------------
+
+void HeaderList::Add(std::string_view name, std::string_view value)
+{
+    Field field;
+    field.name = static_cast<uint32_t>(m_bytes.size());
+    field.nameLen = static_cast<uint32_t>(name.size());
+    m_bytes.append(name);
+    m_bytes.push_back('\0');
+    field.value = static_cast<uint32_t>(m_bytes.size());
+    field.valueLen = static_cast<uint32_t>(value.size());
+    m_bytes.append(value);
+    m_bytes.push_back('\0');
+    m_fields.push_back(field);
+    m_size += name.size() + value.size() + kEntryOverhead;
+}
+
+void HeaderList::Clear()
+{
+    m_bytes.clear();
+    m_fields.clear();
+    m_size = 0;
+}
+
+Header HeaderList::Get(size_t i) const
+{
+    auto const& field = m_fields[i];
+    return Header{
+        std::string_view(m_bytes.data() + field.name, field.nameLen),
+        std::string_view(m_bytes.data() + field.value, field.valueLen)};
+}
+
+std::string_view HeaderList::Find(std::string_view name) const
+{
+    for (size_t i = 0; i < m_fields.size(); i++)
+    {
+        auto header = Get(i);
+        if (header.name == name)
+        {
+            return header.value;
+        }
+    }
+    return {};
+}
+
+// -------------------------------------------------------------------------------------
+// DynamicTable
+// -------------------------------------------------------------------------------------
+
+bool DynamicTable::Get(size_t index, Header* out) const
+{
+    if (index >= m_entries.size())
+    {
+        return false;
+    }
+    auto const& entry = m_entries[index];
+    out->name = std::string_view(entry.bytes.data(), entry.nameLen);
+    out->value = std::string_view(entry.bytes.data() + entry.nameLen,
+                                  entry.bytes.size() - entry.nameLen);
+    return true;
+}
+
+void DynamicTable::Evict(size_t maxSize)
+{
+    while (m_size > maxSize && !m_entries.empty())
+    {
+        m_size -= m_entries.back().bytes.size() + kEntryOverhead;
+        m_entries.pop_back();
+    }
+}
+
+void DynamicTable::Insert(std::string_view name, std::string_view value)
+{
+    size_t size = name.size() + value.size() + kEntryOverhead;
+    if (size > m_maxSize)
+    {
+        // An entry larger than the whole table empties it and is not added (RFC 7541 4.4)
+        //
+        Evict(0);
+        return;
+    }
+
+    // Copy before evicting: name and value may point into an entry about to go
+    //
+    Entry entry;
+    entry.bytes.reserve(name.size() + value.size());
+    entry.bytes.append(name);
+    entry.bytes.append(value);
+    entry.nameLen = name.size();
+    Evict(m_maxSize - size);
+    m_entries.push_front(std::move(entry));
+    m_size += size;
+}
+
+void DynamicTable::SetMaxSize(size_t maxSize)
+{
+    m_maxSize = maxSize;
+    Evict(maxSize);
+}
+
+// -------------------------------------------------------------------------------------
+// Primitives
+// -------------------------------------------------------------------------------------
+
+void EncodeInteger(uint64_t value, int prefixBits, uint8_t flags, std::string* out)
+{
+    uint64_t limit = (uint64_t(1) << prefixBits) - 1;
+    if (value < limit)
+    {
+        out->push_back(static_cast<char>(flags | value));
+        return;
+    }
+    out->push_back(static_cast<char>(flags | limit));
+    value -= limit;
+    while (value >= 128)
+    {
+        out->push_back(static_cast<char>(0x80 | (value & 0x7f)));
+        value >>= 7;
+    }
+    out->push_back(static_cast<char>(value));
+}
+
+bool DecodeInteger(const uint8_t** p, const uint8_t* end, int prefixBits, uint64_t* out)
+{
+    if (*p >= end)
+    {
+        return false;
+    }
+    uint64_t limit = (uint64_t(1) << prefixBits) - 1;
+    uint64_t value = **p & limit;
+    (*p)++;
+    if (value < limit)
+    {
+        *out = value;
+        return true;
+    }
+
+    // Continuation bytes, 7 bits each. Nothing in HTTP/2 needs more than 32 bits; refusing past
+    // that keeps a hostile encoding from overflowing
+    //
+    for (int shift = 0; shift <= 28; shift += 7)
+    {
+        if (*p >= end)
+        {
+            return false;
+        }
+        uint8_t byte = **p;
+        (*p)++;
+        value += uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            *out = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HuffmanDecode(const uint8_t* p, size_t n, std::string* out)
+{
+    // Canonical decoding one bit at a time: code is the bits read so far for the current symbol,
+    // first the first code of length len, index where length len starts in kHuffmanSymbols
+    //
+    uint32_t code = 0;
+    uint32_t first = 0;
+    uint32_t index = 0;
+    int len = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        for (int bit = 7; bit >= 0; bit--)
+        {
+            code = (code << 1) | ((p[i] >> bit) & 1);
+            len++;
+            uint32_t count = kHuffmanCounts[len];
+            if (code - first < count)
+            {
+                uint16_t symbol = kHuffmanSymbols[index + (code - first)];
+                if (symbol == 256)
+                {
+                    return false;
+                }
+                out->push_back(static_cast<char>(symbol));
+                code = first = index = 0;
+                len = 0;
+                continue;
+            }
+            index += count;
+            first = (first + count) << 1;
+            if (len == 30)
+            {
+                return false;
+            }
+        }
+    }
+
+    // What is left must be padding: fewer than 8 bits, all ones (a prefix of EOS)
+    //
+    return len < 8 && code == (uint32_t(1) << len) - 1;
+}
+
+bool DecodeString(const uint8_t** p, const uint8_t* end, std::string* out)
+{
+    if (*p >= end)
+    {
+        return false;
+    }
+    bool huffman = (**p & 0x80) != 0;
+    uint64_t len;
+    if (!DecodeInteger(p, end, 7, &len) || len > static_cast<uint64_t>(end - *p))
+    {
+        return false;
+    }
+    const uint8_t* data = *p;
+    *p += len;
+
+    out->clear();
+    if (huffman)
+    {
+        return HuffmanDecode(data, len, out);
+    }
+    out->assign(reinterpret_cast<const char*>(data), len);
+    return true;
+}
+
+// -------------------------------------------------------------------------------------
+// Decoder
+// -------------------------------------------------------------------------------------
+
+bool Decoder::Lookup(uint64_t index, Header* out) const
+{
+    if (index == 0)
+    {
+        return false;
+    }
+    if (index <= kStaticCount)
+    {
+        *out = kStaticTable[index - 1];
+        return true;
+    }
+    return m_table.Get(index - kStaticCount - 1, out);
+}
+
+int Decoder::Decode(const uint8_t* p, size_t n, HeaderList* out)
+{
+    const uint8_t* end = p + n;
+    bool fieldSeen = false;
+    bool tooBig = false;
+
+    auto emit = [&](std::string_view name, std::string_view value)
+    {
+        fieldSeen = true;
+        if (out->Bytes() + name.size() + value.size() + kEntryOverhead > m_maxListSize)
+        {
+            tooBig = true;
+            return;
+        }
+        out->Add(name, value);
+    };
+
+    while (p < end)
+    {
+        uint8_t byte = *p;
+        Header header;
+
+        if (byte & 0x80)
+        {
+            // Indexed field
+            //
+            uint64_t index;
+            if (!DecodeInteger(&p, end, 7, &index) || !Lookup(index, &header))
+            {
+                return -EBADMSG;
+            }
+            emit(header.name, header.value);
+            continue;
+        }
+
+        if ((byte & 0xe0) == 0x20)
+        {
+            // Dynamic table size update: only at the start of a block, and within what we allowed
+            //
+            uint64_t size;
+            if (fieldSeen || !DecodeInteger(&p, end, 5, &size) || size > m_maxTableSize)
+            {
+                return -EBADMSG;
+            }
+            m_table.SetMaxSize(size);
+            continue;
+        }
+
+        // Literal: with incremental indexing (01), without indexing (0000) or never indexed
+        // (0001). The name is an index or, when that is 0, a string of its own.
+        //
+        bool indexing = (byte & 0xc0) == 0x40;
+        uint64_t nameIndex;
+        if (!DecodeInteger(&p, end, indexing ? 6 : 4, &nameIndex))
+        {
+            return -EBADMSG;
+        }
+        if (nameIndex)
+        {
+            if (!Lookup(nameIndex, &header))
+            {
+                return -EBADMSG;
+            }
+            m_name.assign(header.name);
+        }
+        else if (!DecodeString(&p, end, &m_name))
+        {
+            return -EBADMSG;
+        }
+        if (!DecodeString(&p, end, &m_value))
+        {
+            return -EBADMSG;
+        }
+
+        emit(m_name, m_value);
+        if (indexing)
+        {
+            m_table.Insert(m_name, m_value);
+        }
+    }
+    return tooBig ? -E2BIG : 0;
+}
+
+// -------------------------------------------------------------------------------------
+// Encoder
+// -------------------------------------------------------------------------------------
+
+void Encode(std::string_view name, std::string_view value, std::string* out)
+{
+    int index = StaticIndex(name, value);
+    if (index > 0)
+    {
+        EncodeInteger(static_cast<uint64_t>(index), 7, 0x80, out);
+        return;
+    }
+
+    // Literal without indexing, indexed name where the static table has it
+    //
+    if (index < 0)
+    {
+        EncodeInteger(static_cast<uint64_t>(-index), 4, 0x00, out);
+    }
+    else
+    {
+        out->push_back(0x00);
+        EncodeInteger(name.size(), 7, 0x00, out);
+        out->append(name);
+    }
+    EncodeInteger(value.size(), 7, 0x00, out);
+    out->append(value);
+}
+
+} // end namespace coop::http::hpack
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coop
+{
+namespace http
+{
+namespace hpack
+{
+
+// HPACK (RFC 7541) header compression for HTTP/2. The decoder is complete: static and dynamic
+// table references, literals with and without indexing, table size updates, and Huffman-coded
+// strings. The encoder stays stateless: it references the static table where it can and writes
+// everything else as a raw literal without indexing, so the peer's SETTINGS_HEADER_TABLE_SIZE
+// never matters to it.
+//
+
+struct Header
+{
+    std::string_view name;
+    std::string_view value;
+};
+
+// A decoded header list. Names and values are stored back to back, each NUL-terminated, so a name
+// doubles as the C string the handler API hands out. Views stay valid until the next Add or Clear.
+//
+struct HeaderList
+{
+    void Add(std::string_view name, std::string_view value);
+    void Clear();
+
+    size_t Count() const { return m_fields.size(); }
+    Header Get(size_t i) const;
+    const char* Name(size_t i) const { return m_bytes.data() + m_fields[i].name; }
+
+    // The value of the first header called name, or an empty view
+    //
+    std::string_view Find(std::string_view name) const;
+
+    // Size as SETTINGS_MAX_HEADER_LIST_SIZE counts it: name + value + 32 per field
+    //
+    size_t Bytes() const { return m_size; }
+
+  private:
+    struct Field
+    {
+        uint32_t name;
+        uint32_t nameLen;
+        uint32_t value;
+        uint32_t valueLen;
+    };
+
+    std::string         m_bytes;
+    std::vector<Field>  m_fields;
+    size_t              m_size = 0;
+};
+
+// The dynamic table: newest entry first, evicting from the oldest end to stay within MaxSize()
+// octets (name + value + 32 per entry).
+//
+struct DynamicTable
+{
+    explicit DynamicTable(size_t maxSize = 4096) : m_maxSize(maxSize) {}
+
+    // Entry index, 0 being the newest. False past the end.
+    //
+    bool Get(size_t index, Header* out) const;
+    void Insert(std::string_view name, std::string_view value);
+    void SetMaxSize(size_t maxSize);
+
+    size_t Count() const { return m_entries.size(); }
+    size_t Size() const { return m_size; }
+    size_t MaxSize() const { return m_maxSize; }
+
+  private:
+    struct Entry
+    {
+        std::string bytes;
+        size_t      nameLen;
+    };
+
+    void Evict(size_t maxSize);
+
+    std::deque<Entry>   m_entries;
+    size_t              m_size = 0;
+    size_t              m_maxSize;
+};
+
+// One decoder per connection, fed every header block in the order they arrive: the dynamic table
+// is shared state with the peer's encoder, so a block that is refused must still be decoded.
+//
+struct Decoder
+{
+    // maxTableSize is the SETTINGS_HEADER_TABLE_SIZE we advertised, the most a size update may
+    // ask for; maxListSize bounds a decoded list (SETTINGS_MAX_HEADER_LIST_SIZE)
+    //
+    explicit Decoder(size_t maxTableSize = 4096, size_t maxListSize = 65536)
+    : m_table(maxTableSize)
+    , m_maxTableSize(maxTableSize)
+    , m_maxListSize(maxListSize)
+    {}
+
+    // Decode one complete header block, appending its fields to *out. Returns 0, -EBADMSG for a
+    // malformed block (a connection COMPRESSION_ERROR), or -E2BIG when the list outgrew
+    // maxListSize -- the table is still in sync then, only the list is incomplete.
+    //
+    int Decode(const uint8_t* p, size_t n, HeaderList* out);
+
+    DynamicTable const& Table() const { return m_table; }
+
+  private:
+    bool Lookup(uint64_t index, Header* out) const;
+
+    DynamicTable    m_table;
+    size_t          m_maxTableSize;
+    size_t          m_maxListSize;
+    std::string     m_name;
+    std::string     m_value;
+};
+
+// Append one header field to *out
+//
+void Encode(std::string_view name, std::string_view value, std::string* out);
+
+// Integer and string primitives (RFC 7541 5.1, 5.2), exposed for tests. DecodeInteger and
+// DecodeString advance *p and return false on a truncated or oversized encoding.
+//
+void EncodeInteger(uint64_t value, int prefixBits, uint8_t flags, std::string* out);
+bool DecodeInteger(const uint8_t** p, const uint8_t* end, int prefixBits, uint64_t* out);
+bool DecodeString(const uint8_t** p, const uint8_t* end, std::string* out);
+bool HuffmanDecode(const uint8_t* p, size_t n, std::string* out);
+
+} // end namespace coop::http::hpack
+} // end namespace coop::http
+} // end namespace coop
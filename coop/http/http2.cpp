@@ -0,0 +1,1603 @@
+#include "http2.h"
+#include "common_headers.h"
+#include "connection.h"
+#include "hpack.h"
+#include "http2_frame.h"
+#include "response_template.h"
+#include "transport.h"
+#include "tls_transport.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/context.h"
+#include "coop/coordinate_with.h"
+#include "coop/coordinator.h"
+#include "coop/cooperator.h"
+#include "coop/self.h"
+#include "coop/trace.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/read.h"
+#include "coop/io/recv.h"
+#include "coop/io/write.h"
+
+namespace coop
+{
+namespace http
+{
+
+using namespace http2;
+
+namespace
+{
+
+template<typename Transport>
+struct Session;
+
+// -------------------------------------------------------------------------------------
+// Stream: one request, and the ConnectionBase its handler sees
+// -------------------------------------------------------------------------------------
+
+template<typename Transport>
+struct Stream final : ConnectionBase
+{
+    Stream(Session<Transport>& session, uint32_t id, Context* ctx)
+    : m_session(session)
+    , m_id(id)
+    , m_wake(ctx)
+    {
+    }
+
+    // Request
+    //
+    RequestLine* GetRequestLine() override { return &m_requestLine; }
+    const char* NextArgName() override;
+    Chunk* ReadArgValue() override;
+    void SkipArgValue() override { m_argValueConsumed = true; }
+    void SkipArgs() override { m_argPos = m_query.size(); m_argValueConsumed = true; }
+    const char* NextHeaderName() override;
+    Chunk* ReadHeaderValue() override;
+    void SkipHeaderValue() override { m_headerValueConsumed = true; }
+    void SkipHeaders() override;
+    Chunk* ReadBody() override;
+    void SkipBody() override;
+    int64_t ContentLength() override { return m_contentLength; }
+    int64_t ReceiveBodyToFile(io::Descriptor& file) override;
+
+    // Response
+    //
+    bool Send(int status, const char* contentType, const void* body, size_t size) override;
+    bool Send(int status, const char* contentType, const std::string& body) override
+    {
+        return Send(status, contentType, body.data(), body.size());
+    }
+    bool SendHeaders(int status, const char* contentType, size_t contentLength) override;
+    bool BeginChunked(int status, const char* contentType) override;
+    bool SendChunk(const void* data, size_t size) override;
+    bool EndChunked() override { return EndChunked(nullptr, 0); }
+    bool EndChunked(const void* lastChunkData, size_t lastChunkSize) override;
+    bool Sendfile(int fileFd, off_t offset, size_t count) override;
+    int64_t SendBodyFrom(io::Descriptor& source, size_t count) override;
+    void AbortResponse() override { Fail(); }
+    void SetZeroCopyThreshold(size_t /* threshold */) override {}
+    bool SendError() const override { return m_sendError; }
+    void Reset() override {}
+    bool KeepAlive() const override { return false; }
+    io::Descriptor& GetDescriptor() override;
+    Cooperator* GetCooperator() override;
+    const char* LeftoverData() override { return nullptr; }
+    size_t LeftoverSize() override { return 0; }
+    bool SendRawBytes(const void* data, size_t size) override;
+    bool SendFramedChunks(struct iovec* chunks, int count) override;
+    bool SendRendered(response::Rendered const& rendered) override;
+
+    // Wake the handler if it is waiting for body data or send window. The wake coordinator is a
+    // binary semaphore: held while nothing is pending, so a wake with no waiter is kept for the
+    // next wait.
+    //
+    void Wake(Context* ctx)
+    {
+        if (m_wake.IsHeld())
+        {
+            m_wake.Release(ctx, false);
+        }
+    }
+
+    // Wait for Wake. False if the stream's context was killed.
+    //
+    bool Wait(Context* ctx)
+    {
+        return !CoordinateWithKill(ctx, &m_wake).Killed();
+    }
+
+    bool Fail()
+    {
+        m_sendError = true;
+        return false;
+    }
+
+    bool StartResponse(int status, const char* contentType, int64_t contentLength,
+                       bool endStream, bool negotiated = false,
+                       ContentEncoding encoding = ContentEncoding::IDENTITY);
+    bool SendBody(const void* data, size_t size);
+    void Capture(size_t i);
+
+    Session<Transport>&     m_session;
+    uint32_t                m_id;
+
+    hpack::HeaderList       m_headers;
+    RequestLine             m_requestLine{};
+    int64_t                 m_contentLength = 0;
+
+    std::string             m_query;
+    size_t                  m_argPos = 0;
+    bool                    m_argValueConsumed = true;
+    std::string_view        m_argValue;
+
+    size_t                  m_headerIndex = 0;
+    bool                    m_headerValueConsumed = true;
+
+    // DATA lands in m_body; ReadBody swaps it into m_delivered, which the handler's chunk points
+    // into, so arriving frames never move bytes the handler is looking at
+    //
+    std::string             m_body;
+    std::string             m_delivered;
+    bool                    m_bodySkipped = false;
+    Chunk                   m_chunk{};
+
+    int64_t                 m_sendWindow = 0;
+    int64_t                 m_recvWindow = 0;
+
+    enum BodyMode : uint8_t
+    {
+        NONE,
+        FIXED,
+        CHUNKED,
+    };
+
+    BodyMode                m_bodyMode = NONE;
+    uint64_t                m_bodyRemaining = 0;
+
+    bool                    m_remoteClosed = false;
+    bool                    m_localClosed = false;
+    bool                    m_reset = false;
+    bool                    m_headersSent = false;
+    bool                    m_sendError = false;
+
+    Compressor              m_compressor;
+    std::string             m_compressed;
+
+    Coordinator             m_wake;
+    Coordinator             m_exit;
+    Context::Handle         m_handle;
+};
+
+// -------------------------------------------------------------------------------------
+// Session: the connection's frame reader, and the writer every stream shares
+// -------------------------------------------------------------------------------------
+
+template<typename Transport>
+struct Session
+{
+    using StreamT = Stream<Transport>;
+
+    Session(Context* ctx, Transport transport, std::function<void(ConnectionBase&)> const& handler,
+            Http2Options const& options)
+    : m_ctx(ctx)
+    , m_co(ctx->GetCooperator())
+    , m_transport(transport)
+    , m_handler(handler)
+    , m_options(options)
+    , m_recvBufSize(2 * (FRAME_HEADER_SIZE + kFramePayloadMax))
+    , m_recvBuf(new char[m_recvBufSize])
+    , m_sendBuf(new uint8_t[FRAME_HEADER_SIZE + kFramePayloadMax])
+    , m_recvWindow(DEFAULT_WINDOW_SIZE)
+    , m_decoder(4096, options.maxHeaderListSize)
+    {
+    }
+
+    void Run(const char* initial, size_t initialSize);
+
+    // Frame reading
+    //
+    int Fill(size_t need);
+    bool ReadFrame(FrameHeader* header, const uint8_t** payload);
+
+    // Frame handlers. False means a connection error, the code already in m_error.
+    //
+    bool OnFrame(FrameHeader const& header, const uint8_t* payload);
+    bool OnData(FrameHeader const& header, const uint8_t* payload);
+    bool OnHeaders(FrameHeader const& header, const uint8_t* payload);
+    bool OnContinuation(FrameHeader const& header, const uint8_t* payload);
+    bool OnHeaderBlock();
+    bool OnSettings(FrameHeader const& header, const uint8_t* payload);
+    bool OnWindowUpdate(FrameHeader const& header, const uint8_t* payload);
+    bool ConnectionError(ErrorCode code, const char* why);
+
+    void OpenStream(uint32_t id, hpack::HeaderList&& headers, bool endStream);
+    void RunStream(Context* ctx, StreamT* stream);
+    void Reap();
+    void Close();
+
+    // Frame writing: any context, serialized by m_writeLock
+    //
+    void Lock(Context* ctx) { m_writeLock.Acquire(ctx); }
+    void Unlock(Context* ctx) { m_writeLock.Release(ctx, false); }
+    bool WriteFrameLocked(uint8_t type, uint8_t flags, uint32_t stream, const void* payload,
+                          size_t len);
+    bool WriteFrame(uint8_t type, uint8_t flags, uint32_t stream, const void* payload,
+                    size_t len);
+    bool WriteHeaders(uint32_t stream, std::string const& block, bool endStream);
+    bool WriteRstStream(uint32_t stream, ErrorCode code);
+    bool WriteWindowUpdate(uint32_t stream, uint32_t increment);
+    bool WriteData(StreamT* stream, const char* data, size_t size, bool endStream);
+
+    // A frame's worth of scratch for a stream's Sendfile or SendBodyFrom, kept for the next one.
+    // Streams run concurrently, so each borrows its own; the session keeps the returned ones.
+    //
+    std::unique_ptr<char[]> TakePayloadBuffer()
+    {
+        if (m_payloadBuffers.empty())
+        {
+            return std::unique_ptr<char[]>(new char[kFramePayloadMax]);
+        }
+        std::unique_ptr<char[]> buf = std::move(m_payloadBuffers.back());
+        m_payloadBuffers.pop_back();
+        return buf;
+    }
+
+    void ReturnPayloadBuffer(std::unique_ptr<char[]> buf)
+    {
+        m_payloadBuffers.push_back(std::move(buf));
+    }
+
+    StreamT* Find(uint32_t id)
+    {
+        auto it = m_streams.find(id);
+        return it == m_streams.end() ? nullptr : it->second;
+    }
+
+    void WakeAll()
+    {
+        for (auto& [id, stream] : m_streams)
+        {
+            stream->Wake(m_ctx);
+        }
+    }
+
+    Context*                                    m_ctx;
+    Cooperator*                                 m_co;
+    Transport                                   m_transport;
+    std::function<void(ConnectionBase&)> const& m_handler;
+    Http2Options                                m_options;
+
+    size_t                                      m_recvBufSize;
+    std::unique_ptr<char[]>                     m_recvBuf;
+    size_t                                      m_recvLen = 0;
+    size_t                                      m_recvPos = 0;
+
+    Coordinator                                 m_writeLock;
+    std::unique_ptr<uint8_t[]>                  m_sendBuf;
+    bool                                        m_writeError = false;
+
+    std::vector<std::unique_ptr<char[]>>        m_payloadBuffers;
+
+    // Peer SETTINGS, and our send window on the connection
+    //
+    uint32_t                                    m_peerInitialWindow = DEFAULT_WINDOW_SIZE;
+    uint32_t                                    m_peerMaxFrameSize = DEFAULT_MAX_FRAME_SIZE;
+    int64_t                                     m_sendWindow = DEFAULT_WINDOW_SIZE;
+
+    // Our receive window on the connection, and what has arrived since we last topped it up
+    //
+    int64_t                                     m_recvWindow;
+    uint32_t                                    m_recvUnacked = 0;
+
+    hpack::Decoder                              m_decoder;
+    uint32_t                                    m_headerStream = 0;
+    uint8_t                                     m_headerFlags = 0;
+    std::string                                 m_headerBlock;
+
+    std::unordered_map<uint32_t, StreamT*>      m_streams;
+    std::vector<StreamT*>                       m_finished;
+    uint32_t                                    m_lastStreamId = 0;
+    ErrorCode                                   m_error = NO_ERROR;
+};
+
+// -------------------------------------------------------------------------------------
+// Session: reading
+// -------------------------------------------------------------------------------------
+
+// Make sure need bytes are buffered from m_recvPos on. Returns 1, or 0 / a negative errno from the
+// transport.
+//
+template<typename Transport>
+int Session<Transport>::Fill(size_t need)
+{
+    while (m_recvLen - m_recvPos < need)
+    {
+        if (m_recvPos > 0 && m_recvBufSize - m_recvPos < need)
+        {
+            memmove(m_recvBuf.get(), m_recvBuf.get() + m_recvPos, m_recvLen - m_recvPos);
+            m_recvLen -= m_recvPos;
+            m_recvPos = 0;
+        }
+
+        // Idle timeout only while no stream is open: a slow handler is not an idle connection
+        //
+        time::Interval timeout = m_streams.empty() ? m_options.idleTimeout : time::Interval(0);
+        int n = m_transport.Recv(m_recvBuf.get() + m_recvLen, m_recvBufSize - m_recvLen, 0,
+                                 timeout);
+        if (n <= 0)
+        {
+            return n;
+        }
+        m_recvLen += size_t(n);
+    }
+    return 1;
+}
+
+template<typename Transport>
+bool Session<Transport>::ReadFrame(FrameHeader* header, const uint8_t** payload)
+{
+    if (Fill(FRAME_HEADER_SIZE) <= 0)
+    {
+        return false;
+    }
+    auto* p = reinterpret_cast<const uint8_t*>(m_recvBuf.get() + m_recvPos);
+    ReadFrameHeader(p, header);
+    if (header->length > kFramePayloadMax)
+    {
+        return ConnectionError(FRAME_SIZE_ERROR, "frame too large");
+    }
+    if (Fill(FRAME_HEADER_SIZE + header->length) <= 0)
+    {
+        return false;
+    }
+    *payload = reinterpret_cast<const uint8_t*>(m_recvBuf.get() + m_recvPos + FRAME_HEADER_SIZE);
+    m_recvPos += FRAME_HEADER_SIZE + header->length;
+    return true;
+}
+
+template<typename Transport>
+bool Session<Transport>::ConnectionError(ErrorCode code, const char* why)
+{
+    SPDLOG_DEBUG("http2 connection error code={} why={}", uint32_t(code), why);
+    m_error = code;
+    return false;
+}
+
+template<typename Transport>
+void Session<Transport>::Run(const char* initial, size_t initialSize)
+{
+    if (initialSize > m_recvBufSize)
+    {
+        return;
+    }
+    memcpy(m_recvBuf.get(), initial, initialSize);
+    m_recvLen = initialSize;
+
+    if (Fill(PREFACE_SIZE) <= 0 || memcmp(m_recvBuf.get(), PREFACE, PREFACE_SIZE) != 0)
+    {
+        SPDLOG_DEBUG("http2 bad or missing client preface");
+        return;
+    }
+    m_recvPos = PREFACE_SIZE;
+
+    // Our SETTINGS, then the connection window raised to what the options ask for
+    //
+    uint8_t settings[3 * 6];
+    WriteSetting(settings, MAX_CONCURRENT_STREAMS, m_options.maxConcurrentStreams);
+    WriteSetting(settings + 6, INITIAL_WINDOW_SIZE, m_options.initialWindowSize);
+    WriteSetting(settings + 12, MAX_HEADER_LIST_SIZE, m_options.maxHeaderListSize);
+    if (!WriteFrame(SETTINGS, 0, 0, settings, sizeof(settings)))
+    {
+        return;
+    }
+    if (m_options.connectionWindowSize > DEFAULT_WINDOW_SIZE)
+    {
+        uint32_t raise = std::min(m_options.connectionWindowSize, MAX_WINDOW_SIZE)
+            - DEFAULT_WINDOW_SIZE;
+        m_recvWindow += raise;
+        WriteWindowUpdate(0, raise);
+    }
+
+    FrameHeader header;
+    const uint8_t* payload;
+    while (!m_ctx->IsKilled() && !m_writeError && ReadFrame(&header, &payload))
+    {
+        if (!OnFrame(header, payload))
+        {
+            break;
+        }
+        Reap();
+    }
+
+    if (m_error != NO_ERROR && !m_writeError)
+    {
+        uint8_t goaway[8];
+        WriteU32(goaway, m_lastStreamId);
+        WriteU32(goaway + 4, m_error);
+        WriteFrame(GOAWAY, 0, 0, goaway, sizeof(goaway));
+    }
+    Close();
+}
+
+template<typename Transport>
+bool Session<Transport>::OnFrame(FrameHeader const& header, const uint8_t* payload)
+{
+    // A header block is contiguous: nothing may come between HEADERS and its last CONTINUATION
+    //
+    if (m_headerStream && header.type != CONTINUATION)
+    {
+        return ConnectionError(PROTOCOL_ERROR, "frame inside a header block");
+    }
+
+    switch (header.type)
+    {
+    case DATA:
+        return OnData(header, payload);
+
+    case HEADERS:
+        return OnHeaders(header, payload);
+
+    case CONTINUATION:
+        return OnContinuation(header, payload);
+
+    case SETTINGS:
+        return OnSettings(header, payload);
+
+    case WINDOW_UPDATE:
+        return OnWindowUpdate(header, payload);
+
+    case PING:
+        if (header.length != 8)
+        {
+            return ConnectionError(FRAME_SIZE_ERROR, "ping size");
+        }
+        if (header.stream != 0)
+        {
+            return ConnectionError(PROTOCOL_ERROR, "ping on a stream");
+        }
+        if (!(header.flags & ACK))
+        {
+            WriteFrame(PING, ACK, 0, payload, 8);
+        }
+        return true;
+
+    case RST_STREAM:
+        if (header.length != 4)
+        {
+            return ConnectionError(FRAME_SIZE_ERROR, "rst_stream size");
+        }
+        if (header.stream == 0 || header.stream > m_lastStreamId)
+        {
+            return ConnectionError(PROTOCOL_ERROR, "rst_stream on an idle stream");
+        }
+        if (auto* stream = Find(header.stream))
+        {
+            stream->m_reset = true;
+            stream->m_remoteClosed = true;
+            stream->Wake(m_ctx);
+        }
+        return true;
+
+    case PRIORITY:
+        if (header.length != 5)
+        {
+            return ConnectionError(FRAME_SIZE_ERROR, "priority size");
+        }
+        return true;
+
+    case GOAWAY:
+        // The peer opens nothing new; what is in flight still gets its response
+        //
+        SPDLOG_DEBUG("http2 peer goaway");
+        return true;
+
+    case PUSH_PROMISE:
+        return ConnectionError(PROTOCOL_ERROR, "push_promise from a client");
+
+    default:
+        // Unknown frame types are ignored (RFC 9113 4.1)
+        //
+        return true;
+    }
+}
+
+template<typename Transport>
+bool Session<Transport>::OnData(FrameHeader const& header, const uint8_t* payload)
+{
+    if (header.stream == 0)
+    {
+        return ConnectionError(PROTOCOL_ERROR, "data on stream 0");
+    }
+    if (header.stream > m_lastStreamId)
+    {
+        return ConnectionError(PROTOCOL_ERROR, "data on an idle stream");
+    }
+
+    // Padding counts against flow control too
+    //
+    m_recvWindow -= header.length;
+    if (m_recvWindow < 0)
+    {
+        return ConnectionError(FLOW_CONTROL_ERROR, "connection window overrun");
+    }
+    m_recvUnacked += header.length;
+    if (m_recvUnacked >= m_options.connectionWindowSize / 2)
+    {
+        m_recvWindow += m_recvUnacked;
+        WriteWindowUpdate(0, m_recvUnacked);
+        m_recvUnacked = 0;
+    }
+
+    size_t len = header.length;
+    if (!StripPadding(header.flags, &payload, &len))
+    {
+        return ConnectionError(PROTOCOL_ERROR, "data padding");
+    }
+
+    // A stream we have already finished with (or reset) just drops its data
+    //
+    auto* stream = Find(header.stream);
+    if (!stream || stream->m_reset)
+    {
+        return true;
+    }
+    if (stream->m_remoteClosed)
+    {
+        stream->m_reset = true;
+        WriteRstStream(header.stream, STREAM_CLOSED);
+        stream->Wake(m_ctx);
+        return true;
+    }
+
+    stream->m_recvWindow -= header.length;
+    if (stream->m_recvWindow < 0)
+    {
+        stream->m_reset = true;
+        WriteRstStream(header.stream, FLOW_CONTROL_ERROR);
+        stream->Wake(m_ctx);
+        return true;
+    }
+
+    if (stream->m_bodySkipped)
+    {
+        // The handler wants none of it: hand the window straight back so the client can finish
+        //
+        stream->m_recvWindow += header.length;
+        if (header.length > 0 && !(header.flags & END_STREAM))
+        {
+            WriteWindowUpdate(header.stream, header.length);
+        }
+    }
+    else
+    {
+        stream->m_body.append(reinterpret_cast<const char*>(payload), len);
+    }
+    stream->m_bytesIn += len;
+
+    if (header.flags & END_STREAM)
+    {
+        stream->m_remoteClosed = true;
+    }
+    stream->Wake(m_ctx);
+    return true;
+}
+
+template<typename Transport>
+bool Session<Transport>::OnHeaders(FrameHeader const& header, const uint8_t* payload)
+{
+    if (header.stream == 0)
+    {
+        return ConnectionError(PROTOCOL_ERROR, "headers on stream 0");
+    }
+
+    size_t len = header.length;
+    if (!StripPadding(header.flags, &payload, &len))
+    {
+        return ConnectionError(PROTOCOL_ERROR, "headers padding");
+    }
+    if (header.flags & PRIORITY_FLAG)
+    {
+        if (len < 5)
+        {
+            return ConnectionError(FRAME_SIZE_ERROR, "headers priority");
+        }
+        payload += 5;
+        len -= 5;
+    }
+
+    m_headerBlock.assign(reinterpret_cast<const char*>(payload), len);
+    m_headerStream = header.stream;
+    m_headerFlags = header.flags;
+    return (header.flags & END_HEADERS) ? OnHeaderBlock() : true;
+}
+
+template<typename Transport>
+bool Session<Transport>::OnContinuation(FrameHeader const& header, const uint8_t* payload)
+{
+    if (!m_headerStream || header.stream != m_headerStream)
+    {
+        return ConnectionError(PROTOCOL_ERROR, "unexpected continuation");
+    }
+    if (m_headerBlock.size() + header.length > kHeaderBlockMax)
+    {
+        return ConnectionError(ENHANCE_YOUR_CALM, "header block too large");
+    }
+    m_headerBlock.append(reinterpret_cast<const char*>(payload), header.length);
+    return (header.flags & END_HEADERS) ? OnHeaderBlock() : true;
+}
+
+template<typename Transport>
+bool Session<Transport>::OnHeaderBlock()
+{
+    uint32_t id = m_headerStream;
+    bool endStream = (m_headerFlags & END_STREAM) != 0;
+    m_headerStream = 0;
+
+    // Decoded even when the stream is refused: the dynamic table must stay in step with the peer
+    //
+    hpack::HeaderList headers;
+    int decoded = m_decoder.Decode(reinterpret_cast<const uint8_t*>(m_headerBlock.data()),
+                                   m_headerBlock.size(), &headers);
+    if (decoded == -EBADMSG)
+    {
+        return ConnectionError(COMPRESSION_ERROR, "hpack");
+    }
+
+    if (auto* stream = Find(id))
+    {
+        // Trailers: they end the request body and are otherwise dropped
+        //
+        if (!endStream || stream->m_remoteClosed)
+        {
+            stream->m_reset = true;
+            WriteRstStream(id, PROTOCOL_ERROR);
+        }
+        stream->m_remoteClosed = true;
+        stream->Wake(m_ctx);
+        return true;
+    }
+
+    if (id <= m_lastStreamId)
+    {
+        // A stream we are done with; anything but trailers on it is an error, trailers are moot
+        //
+        return endStream ? true : ConnectionError(STREAM_CLOSED, "headers on a closed stream");
+    }
+    if ((id & 1) == 0)
+    {
+        return ConnectionError(PROTOCOL_ERROR, "even stream id from a client");
+    }
+    m_lastStreamId = id;
+
+    if (decoded == -E2BIG)
+    {
+        std::string block;
+        hpack::Encode(":status", "431", &block);
+        WriteHeaders(id, block, true);
+        return true;
+    }
+    if (m_streams.size() >= m_options.maxConcurrentStreams)
+    {
+        WriteRstStream(id, REFUSED_STREAM);
+        return true;
+    }
+
+    OpenStream(id, std::move(headers), endStream);
+    return true;
+}
+
+template<typename Transport>
+bool Session<Transport>::OnSettings(FrameHeader const& header, const uint8_t* payload)
+{
+    if (header.stream != 0)
+    {
+        return ConnectionError(PROTOCOL_ERROR, "settings on a stream");
+    }
+    if (header.flags & ACK)
+    {
+        return header.length == 0 ? true : ConnectionError(FRAME_SIZE_ERROR, "settings ack size");
+    }
+    if (header.length % 6 != 0)
+    {
+        return ConnectionError(FRAME_SIZE_ERROR, "settings size");
+    }
+
+    for (size_t i = 0; i < header.length; i += 6)
+    {
+        uint16_t id = uint16_t((payload[i] << 8) | payload[i + 1]);
+        uint32_t value = ReadU32(payload + i + 2);
+        switch (id)
+        {
+        case ENABLE_PUSH:
+            if (value > 1)
+            {
+                return ConnectionError(PROTOCOL_ERROR, "enable_push");
+            }
+            break;
+
+        case INITIAL_WINDOW_SIZE:
+        {
+            if (value > MAX_WINDOW_SIZE)
+            {
+                return ConnectionError(FLOW_CONTROL_ERROR, "initial_window_size");
+            }
+
+            // Applies to every open stream, retroactively: windows may go negative
+            //
+            int64_t delta = int64_t(value) - int64_t(m_peerInitialWindow);
+            m_peerInitialWindow = value;
+            for (auto& [streamId, stream] : m_streams)
+            {
+                stream->m_sendWindow += delta;
+            }
+            WakeAll();
+            break;
+        }
+
+        case MAX_FRAME_SIZE:
+            if (value < DEFAULT_MAX_FRAME_SIZE || value > 0xffffff)
+            {
+                return ConnectionError(PROTOCOL_ERROR, "max_frame_size");
+            }
+            m_peerMaxFrameSize = value;
+            break;
+
+        default:
+            // HEADER_TABLE_SIZE does not matter to an encoder that never indexes; the rest are
+            // limits on what we would send that we never approach, or unknown and ignored
+            //
+            break;
+        }
+    }
+    WriteFrame(SETTINGS, ACK, 0, nullptr, 0);
+    return true;
+}
+
+template<typename Transport>
+bool Session<Transport>::OnWindowUpdate(FrameHeader const& header, const uint8_t* payload)
+{
+    if (header.length != 4)
+    {
+        return ConnectionError(FRAME_SIZE_ERROR, "window_update size");
+    }
+    uint32_t increment = ReadU32(payload) & MAX_WINDOW_SIZE;
+
+    if (header.stream == 0)
+    {
+        if (increment == 0)
+        {
+            return ConnectionError(PROTOCOL_ERROR, "zero window increment");
+        }
+        m_sendWindow += increment;
+        if (m_sendWindow > MAX_WINDOW_SIZE)
+        {
+            return ConnectionError(FLOW_CONTROL_ERROR, "connection window overflow");
+        }
+        WakeAll();
+        return true;
+    }
+
+    auto* stream = Find(header.stream);
+    if (!stream)
+    {
+        return header.stream <= m_lastStreamId
+            ? true
+            : ConnectionError(PROTOCOL_ERROR, "window_update on an idle stream");
+    }
+    stream->m_sendWindow += increment;
+    if (increment == 0 || stream->m_sendWindow > MAX_WINDOW_SIZE)
+    {
+        stream->m_reset = true;
+        WriteRstStream(header.stream, increment == 0 ? PROTOCOL_ERROR : FLOW_CONTROL_ERROR);
+    }
+    stream->Wake(m_ctx);
+    return true;
+}
+
+// -------------------------------------------------------------------------------------
+// Session: streams
+// -------------------------------------------------------------------------------------
+
+template<typename Transport>
+void Session<Transport>::OpenStream(uint32_t id, hpack::HeaderList&& headers, bool endStream)
+{
+    auto method = headers.Find(":method");
+    auto path = headers.Find(":path");
+    if (method.empty() || path.empty())
+    {
+        WriteRstStream(id, PROTOCOL_ERROR);
+        return;
+    }
+
+    auto* stream = new StreamT(*this, id, m_ctx);
+    stream->m_headers = std::move(headers);
+    auto authority = stream->m_headers.Find(":authority");
+    if (!authority.empty() && stream->m_headers.Find("host").empty())
+    {
+        std::string host(authority);
+        stream->m_headers.Add("host", host);
+    }
+
+    // Views into m_headers, taken once it has stopped growing
+    //
+    path = stream->m_headers.Find(":path");
+    auto query = path.find('?');
+    stream->m_requestLine.method = stream->m_headers.Find(":method");
+    stream->m_requestLine.path = path.substr(0, query);
+    if (query != std::string_view::npos)
+    {
+        stream->m_query.assign(path.substr(query + 1));
+        stream->m_requestLine.query = stream->m_query;
+    }
+
+    stream->m_acceptEncoding.Parse(stream->m_headers.Find("accept-encoding"));
+
+    auto length = stream->m_headers.Find("content-length");
+    if (!length.empty())
+    {
+        stream->m_contentLength = strtoll(std::string(length).c_str(), nullptr, 10);
+    }
+
+    stream->m_remoteClosed = endStream;
+    stream->m_sendWindow = m_peerInitialWindow;
+    stream->m_recvWindow = m_options.initialWindowSize;
+    m_streams.emplace(id, stream);
+
+    SpawnConfiguration config = {.priority = m_ctx->GetPriority(),
+                                 .stackSize = m_options.streamStackSize};
+    bool spawned = m_co->Spawn(config, [this, stream](Context* ctx)
+    {
+        RunStream(ctx, stream);
+    }, &stream->m_handle);
+    if (!spawned)
+    {
+        spdlog::warn("http2 stream spawn failed id={}", id);
+        m_streams.erase(id);
+        delete stream;
+        WriteRstStream(id, REFUSED_STREAM);
+    }
+}
+
+template<typename Transport>
+void Session<Transport>::RunStream(Context* ctx, StreamT* stream)
+{
+    ctx->SetName("Http2Stream");
+    stream->m_exit.Acquire(ctx);
+
+    // The headers are all here already, so the caller's trace context is taken before the
+    // handler's server span opens rather than adopted into it
+    //
+    trace::SpanContext remote;
+    if (trace::IsTracing() &&
+        trace::ParseTraceParent(stream->m_headers.Find("traceparent"), remote))
+    {
+        trace::SetRemoteParent(remote);
+    }
+
+    m_handler(*stream);
+
+    // A response left unfinished is cut off; a request body left unread is refused, so the
+    // client stops sending it
+    //
+    if (!stream->m_reset && !m_writeError)
+    {
+        if (!stream->m_localClosed)
+        {
+            WriteRstStream(stream->m_id, INTERNAL_ERROR);
+        }
+        else if (!stream->m_remoteClosed)
+        {
+            WriteRstStream(stream->m_id, NO_ERROR);
+        }
+    }
+
+    m_streams.erase(stream->m_id);
+    m_finished.push_back(stream);
+    stream->m_exit.Release(ctx, false);
+}
+
+// Free streams whose contexts are gone
+//
+template<typename Transport>
+void Session<Transport>::Reap()
+{
+    auto it = std::remove_if(m_finished.begin(), m_finished.end(), [](StreamT* stream)
+    {
+        if (stream->m_handle)
+        {
+            return false;
+        }
+        delete stream;
+        return true;
+    });
+    m_finished.erase(it, m_finished.end());
+}
+
+template<typename Transport>
+void Session<Transport>::Close()
+{
+    std::vector<StreamT*> open;
+    for (auto& [id, stream] : m_streams)
+    {
+        stream->m_reset = true;
+        stream->Wake(m_ctx);
+        open.push_back(stream);
+    }
+    for (auto* stream : open)
+    {
+        if (stream->m_handle)
+        {
+            stream->m_handle.Kill();
+        }
+    }
+
+    // Each stream context holds m_exit until its last act, so once it is ours the context is gone
+    //
+    for (auto* stream : open)
+    {
+        stream->m_exit.Acquire(m_ctx);
+        stream->m_exit.Release(m_ctx, false);
+    }
+    for (auto* stream : m_finished)
+    {
+        stream->m_exit.Acquire(m_ctx);
+        stream->m_exit.Release(m_ctx, false);
+    }
+
+    // Past its Release a stream context only has its own teardown left, which clears the handle
+    //
+    Reap();
+    while (!m_finished.empty())
+    {
+        m_ctx->Yield();
+        Reap();
+    }
+}
+
+// -------------------------------------------------------------------------------------
+// Session: writing
+// -------------------------------------------------------------------------------------
+
+template<typename Transport>
+bool Session<Transport>::WriteFrameLocked(uint8_t type, uint8_t flags, uint32_t stream,
+                                          const void* payload, size_t len)
+{
+    if (m_writeError)
+    {
+        return false;
+    }
+    assert(len <= kFramePayloadMax);
+    WriteFrameHeader(m_sendBuf.get(), len, type, flags, stream);
+    if (len > 0)
+    {
+        memcpy(m_sendBuf.get() + FRAME_HEADER_SIZE, payload, len);
+    }
+    if (m_transport.SendAll(m_sendBuf.get(), FRAME_HEADER_SIZE + len) < 0)
+    {
+        m_writeError = true;
+        return false;
+    }
+    return true;
+}
+
+template<typename Transport>
+bool Session<Transport>::WriteFrame(uint8_t type, uint8_t flags, uint32_t stream,
+                                    const void* payload, size_t len)
+{
+    auto* ctx = Self();
+    Lock(ctx);
+    bool ok = WriteFrameLocked(type, flags, stream, payload, len);
+    Unlock(ctx);
+    return ok;
+}
+
+// HEADERS plus as many CONTINUATIONs as the block needs, under one hold of the lock: nothing may
+// interleave with a header block
+//
+template<typename Transport>
+bool Session<Transport>::WriteHeaders(uint32_t stream, std::string const& block, bool endStream)
+{
+    auto* ctx = Self();
+    Lock(ctx);
+    size_t max = std::min<size_t>(m_peerMaxFrameSize, kFramePayloadMax);
+    size_t at = 0;
+    bool ok = true;
+    do
+    {
+        size_t n = std::min(max, block.size() - at);
+        bool first = at == 0;
+        bool last = at + n == block.size();
+        uint8_t flags = (last ? END_HEADERS : 0) | (first && endStream ? END_STREAM : 0);
+        ok = WriteFrameLocked(first ? HEADERS : CONTINUATION, flags, stream,
+                              block.data() + at, n);
+        at += n;
+    }
+    while (ok && at < block.size());
+    Unlock(ctx);
+    return ok;
+}
+
+template<typename Transport>
+bool Session<Transport>::WriteRstStream(uint32_t stream, ErrorCode code)
+{
+    uint8_t payload[4];
+    WriteU32(payload, code);
+    return WriteFrame(RST_STREAM, 0, stream, payload, sizeof(payload));
+}
+
+template<typename Transport>
+bool Session<Transport>::WriteWindowUpdate(uint32_t stream, uint32_t increment)
+{
+    uint8_t payload[4];
+    WriteU32(payload, increment);
+    return WriteFrame(WINDOW_UPDATE, 0, stream, payload, sizeof(payload));
+}
+
+// DATA frames within both flow control windows, blocking for WINDOW_UPDATEs as needed. The
+// windows are checked and charged under the lock, so concurrent streams never overdraw the
+// connection's.
+//
+template<typename Transport>
+bool Session<Transport>::WriteData(StreamT* stream, const char* data, size_t size, bool endStream)
+{
+    auto* ctx = Self();
+    do
+    {
+        if (stream->m_reset || m_writeError)
+        {
+            return false;
+        }
+
+        Lock(ctx);
+        int64_t window = std::min(m_sendWindow, stream->m_sendWindow);
+        if (size > 0 && window <= 0)
+        {
+            Unlock(ctx);
+            if (!stream->Wait(ctx))
+            {
+                return false;
+            }
+            continue;
+        }
+
+        size_t n = std::min({size, size_t(std::min<uint32_t>(m_peerMaxFrameSize,
+                                                              kFramePayloadMax)),
+                             size_t(std::max<int64_t>(window, 0))});
+        bool last = endStream && n == size;
+        bool ok = WriteFrameLocked(DATA, last ? END_STREAM : 0, stream->m_id, data, n);
+        stream->m_bytesOut += n;
+        m_sendWindow -= int64_t(n);
+        stream->m_sendWindow -= int64_t(n);
+        Unlock(ctx);
+        if (!ok)
+        {
+            return false;
+        }
+
+        data += n;
+        size -= n;
+        if (last)
+        {
+            stream->m_localClosed = true;
+        }
+    }
+    while (size > 0);
+    return true;
+}
+
+// -------------------------------------------------------------------------------------
+// Stream: request
+// -------------------------------------------------------------------------------------
+
+template<typename Transport>
+const char* Stream<Transport>::NextArgName()
+{
+    m_argValueConsumed = true;
+    while (m_argPos < m_query.size())
+    {
+        size_t end = m_query.find('&', m_argPos);
+        if (end == std::string::npos)
+        {
+            end = m_query.size();
+        }
+        size_t start = m_argPos;
+        m_argPos = end < m_query.size() ? end + 1 : end;
+        if (end == start)
+        {
+            continue;
+        }
+
+        // Names are terminated in place, as the HTTP/1.1 parser does in its recv buffer
+        //
+        size_t eq = m_query.find('=', start);
+        if (eq != std::string::npos && eq < end)
+        {
+            m_query[eq] = '\0';
+            m_argValue = std::string_view(m_query.data() + eq + 1, end - eq - 1);
+            m_argValueConsumed = false;
+        }
+        if (end < m_query.size())
+        {
+            m_query[end] = '\0';
+        }
+        return m_query.data() + start;
+    }
+    return nullptr;
+}
+
+template<typename Transport>
+Chunk* Stream<Transport>::ReadArgValue()
+{
+    if (m_argValueConsumed)
+    {
+        return nullptr;
+    }
+    m_argValueConsumed = true;
+    m_chunk.data = m_argValue.data();
+    m_chunk.size = m_argValue.size();
+    m_chunk.complete = true;
+    return &m_chunk;
+}
+
+template<typename Transport>
+const char* Stream<Transport>::NextHeaderName()
+{
+    m_argPos = m_query.size();
+    while (m_headerIndex < m_headers.Count())
+    {
+        size_t i = m_headerIndex++;
+        if (m_headers.Name(i)[0] == ':')
+        {
+            continue;
+        }
+        Capture(i);
+        m_headerValueConsumed = false;
+        return m_headers.Name(i);
+    }
+    return nullptr;
+}
+
+// The list is decoded whole, so a captured value is taken in one piece as its name goes by
+//
+template<typename Transport>
+void Stream<Transport>::Capture(size_t i)
+{
+    if (!m_headerSet)
+    {
+        return;
+    }
+    auto header = m_headers.Get(i);
+    int slot = m_headerSet->Find(detail::HeaderNameHash(header.name.data(), header.name.size()),
+                                 header.name.data(), header.name.size());
+    if (slot >= 0)
+    {
+        m_captured.Begin(slot);
+        m_captured.Append(header.value.data(), header.value.size(), true);
+    }
+}
+
+template<typename Transport>
+void Stream<Transport>::SkipHeaders()
+{
+    for (; m_headerIndex < m_headers.Count(); m_headerIndex++)
+    {
+        if (m_headers.Name(m_headerIndex)[0] != ':')
+        {
+            Capture(m_headerIndex);
+        }
+    }
+    m_headerValueConsumed = true;
+}
+
+template<typename Transport>
+Chunk* Stream<Transport>::ReadHeaderValue()
+{
+    if (m_headerValueConsumed || m_headerIndex == 0)
+    {
+        return nullptr;
+    }
+    m_headerValueConsumed = true;
+    auto value = m_headers.Get(m_headerIndex - 1).value;
+    m_chunk.data = value.data();
+    m_chunk.size = value.size();
+    m_chunk.complete = true;
+    return &m_chunk;
+}
+
+template<typename Transport>
+Chunk* Stream<Transport>::ReadBody()
+{
+    SkipHeaders();
+    auto* ctx = Self();
+
+    // What the handler took last time is read: give its window back
+    //
+    if (!m_delivered.empty())
+    {
+        auto credit = uint32_t(m_delivered.size());
+        m_delivered.clear();
+        m_recvWindow += credit;
+        if (!m_remoteClosed && !m_reset)
+        {
+            m_session.WriteWindowUpdate(m_id, credit);
+        }
+    }
+
+    while (m_body.empty())
+    {
+        if (m_remoteClosed || m_reset || !Wait(ctx))
+        {
+            return nullptr;
+        }
+    }
+
+    std::swap(m_body, m_delivered);
+    m_chunk.data = m_delivered.data();
+    m_chunk.size = m_delivered.size();
+    m_chunk.complete = m_remoteClosed;
+    return &m_chunk;
+}
+
+// DATA frames arrive through the session's reader already copied out of the socket, so the body
+// is written from the chunks; there is nothing to splice
+//
+template<typename Transport>
+int64_t Stream<Transport>::ReceiveBodyToFile(io::Descriptor& file)
+{
+    int64_t total = 0;
+    while (Chunk* chunk = ReadBody())
+    {
+        auto* at = static_cast<const char*>(chunk->data);
+        size_t size = chunk->size;
+        while (size > 0)
+        {
+            int n = io::Write(file, at, size, uint64_t(-1));
+            if (n <= 0)
+            {
+                spdlog::warn("h2 upload write to fd={} failed", file.m_fd);
+                SkipBody();
+                return -1;
+            }
+            at += n;
+            size -= size_t(n);
+        }
+        total += int64_t(chunk->size);
+    }
+    return m_remoteClosed && !m_reset ? total : -1;
+}
+
+template<typename Transport>
+void Stream<Transport>::SkipBody()
+{
+    SkipHeaders();
+    m_bodySkipped = true;
+    m_body.clear();
+    m_delivered.clear();
+}
+
+// -------------------------------------------------------------------------------------
+// Stream: response
+// -------------------------------------------------------------------------------------
+
+template<typename Transport>
+bool Stream<Transport>::StartResponse(int status, const char* contentType, int64_t contentLength,
+                                      bool endStream, bool negotiated /* = false */,
+                                      ContentEncoding encoding /* = IDENTITY */)
+{
+    assert(!m_sendError && "send after a failed send");
+    if (m_headersSent)
+    {
+        return Fail();
+    }
+    m_headersSent = true;
+    m_responseStatus = status;
+
+    char number[24];
+    std::string block;
+    snprintf(number, sizeof(number), "%d", status);
+    hpack::Encode(":status", number, &block);
+    auto date = response::DateHeader();
+    EncodeHeaderLines(std::string_view(date.data, date.size), &block);
+    auto common = response::CommonHeaders();
+    EncodeHeaderLines(std::string_view(common.data, common.size), &block);
+    EncodeHeaderLines(m_responseHeaders, &block);
+    if (contentType)
+    {
+        hpack::Encode("content-type", contentType, &block);
+    }
+    if (negotiated)
+    {
+        auto lines = EncodingHeaders(encoding);
+        EncodeHeaderLines(std::string_view(lines.data, lines.size), &block);
+    }
+    if (contentLength >= 0)
+    {
+        snprintf(number, sizeof(number), "%lld", static_cast<long long>(contentLength));
+        hpack::Encode("content-length", number, &block);
+    }
+
+    if (m_reset || !m_session.WriteHeaders(m_id, block, endStream))
+    {
+        return Fail();
+    }
+    if (endStream)
+    {
+        m_localClosed = true;
+    }
+    return true;
+}
+
+template<typename Transport>
+bool Stream<Transport>::Send(int status, const char* contentType, const void* body, size_t size)
+{
+    ContentEncoding encoding;
+    bool negotiated = NegotiateEncoding(size, &encoding);
+    if (encoding != ContentEncoding::IDENTITY)
+    {
+        if (Compressor::CompressAll(encoding, *m_compression, body, size, &m_compressed))
+        {
+            body = m_compressed.data();
+            size = m_compressed.size();
+        }
+        else
+        {
+            encoding = ContentEncoding::IDENTITY;
+        }
+    }
+
+    if (!StartResponse(status, contentType, int64_t(size), size == 0, negotiated, encoding))
+    {
+        return false;
+    }
+    if (size > 0 && !m_session.WriteData(this, static_cast<const char*>(body), size, true))
+    {
+        return Fail();
+    }
+    return true;
+}
+
+template<typename Transport>
+bool Stream<Transport>::SendHeaders(int status, const char* contentType, size_t contentLength)
+{
+    m_bodyMode = FIXED;
+
+    // A 304 describes the length a 200 would have had, and has no body all the same
+    //
+    bool bodyless = contentLength == 0 || status == 304;
+    m_bodyRemaining = bodyless ? 0 : contentLength;
+    return StartResponse(status, contentType, int64_t(contentLength), bodyless,
+                         m_contentEncoding != ContentEncoding::IDENTITY, m_contentEncoding);
+}
+
+// Body bytes after SendHeaders: the stream ends with the byte that completes the declared length
+//
+template<typename Transport>
+bool Stream<Transport>::SendBody(const void* data, size_t size)
+{
+    if (m_bodyMode != FIXED || size > m_bodyRemaining)
+    {
+        return Fail();
+    }
+    m_bodyRemaining -= size;
+    if (!m_session.WriteData(this, static_cast<const char*>(data), size, m_bodyRemaining == 0))
+    {
+        return Fail();
+    }
+    return true;
+}
+
+template<typename Transport>
+bool Stream<Transport>::SendRawBytes(const void* data, size_t size)
+{
+    return SendBody(data, size);
+}
+
+// The head pieces join the handler's lines in the header block; the body goes as one DATA write
+//
+template<typename Transport>
+bool Stream<Transport>::SendRendered(response::Rendered const& rendered)
+{
+    std::string lines(m_responseHeaders);
+    for (size_t i = 0; i < rendered.headCount; i++)
+    {
+        lines.append(rendered.head[i].data, rendered.head[i].size);
+    }
+    std::string body;
+    body.reserve(rendered.bodySize);
+    for (size_t i = 0; i < rendered.bodyCount; i++)
+    {
+        body.append(rendered.body[i].data, rendered.body[i].size);
+    }
+
+    auto handlerLines = m_responseHeaders;
+    m_responseHeaders = lines;
+    bool ok = SendHeaders(rendered.status, nullptr, body.size());
+    m_responseHeaders = handlerLines;
+    return ok && (body.empty() || SendBody(body.data(), body.size()));
+}
+
+// DATA frames are the framing here: each chunk's data goes as its own
+//
+template<typename Transport>
+bool Stream<Transport>::SendFramedChunks(struct iovec* chunks, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        auto data = detail::ChunkPayload(chunks[i]);
+        if (!data.empty() && !SendChunk(data.data(), data.size()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Transport>
+bool Stream<Transport>::BeginChunked(int status, const char* contentType)
+{
+    m_bodyMode = CHUNKED;
+    ContentEncoding encoding;
+    bool negotiated = NegotiateEncoding(SIZE_MAX, &encoding);
+    if (encoding != ContentEncoding::IDENTITY && !m_compressor.Begin(encoding, *m_compression))
+    {
+        encoding = ContentEncoding::IDENTITY;
+    }
+    return StartResponse(status, contentType, -1, false, negotiated, encoding);
+}
+
+template<typename Transport>
+bool Stream<Transport>::SendChunk(const void* data, size_t size)
+{
+    if (m_bodyMode != CHUNKED)
+    {
+        return Fail();
+    }
+    if (m_compressor.Active())
+    {
+        m_compressed.clear();
+        if (!m_compressor.Write(data, size, Compressor::SYNC, &m_compressed))
+        {
+            return Fail();
+        }
+        data = m_compressed.data();
+        size = m_compressed.size();
+    }
+    if (size == 0)
+    {
+        return true;
+    }
+    if (!m_session.WriteData(this, static_cast<const char*>(data), size, false))
+    {
+        return Fail();
+    }
+    return true;
+}
+
+template<typename Transport>
+bool Stream<Transport>::EndChunked(const void* lastChunkData, size_t lastChunkSize)
+{
+    if (m_bodyMode != CHUNKED)
+    {
+        return Fail();
+    }
+    if (m_compressor.Active())
+    {
+        m_compressed.clear();
+        bool ok = m_compressor.Write(lastChunkData, lastChunkSize, Compressor::FINISH,
+                                     &m_compressed);
+        m_compressor.End();
+        if (!ok)
+        {
+            return Fail();
+        }
+        lastChunkData = m_compressed.data();
+        lastChunkSize = m_compressed.size();
+    }
+    if (!m_session.WriteData(this, static_cast<const char*>(lastChunkData), lastChunkSize, true))
+    {
+        return Fail();
+    }
+    return true;
+}
+
+template<typename Transport>
+bool Stream<Transport>::Sendfile(int fileFd, off_t offset, size_t count)
+{
+    // DATA frames carry the bytes, so they come through userspace: a frame's worth at a time, read
+    // through the ring so a cold file parks this stream rather than the cooperator
+    //
+    io::Descriptor file(io::borrowed, fileFd);
+    std::unique_ptr<char[]> buf = m_session.TakePayloadBuffer();
+    bool ok = true;
+    while (ok && count > 0)
+    {
+        int n = io::Read(file, buf.get(), std::min(count, kFramePayloadMax), uint64_t(offset));
+        if (n <= 0)
+        {
+            ok = Fail();
+            break;
+        }
+        ok = SendBody(buf.get(), size_t(n));
+        offset += n;
+        count -= size_t(n);
+    }
+    m_session.ReturnPayloadBuffer(std::move(buf));
+    return ok;
+}
+
+// As Sendfile: DATA frames are built in userspace, so the bytes are recv'd a frame's worth at a
+// time rather than spliced
+//
+template<typename Transport>
+int64_t Stream<Transport>::SendBodyFrom(io::Descriptor& source, size_t count)
+{
+    std::unique_ptr<char[]> buf = m_session.TakePayloadBuffer();
+    int64_t total = 0;
+    while (static_cast<size_t>(total) < count)
+    {
+        int n = io::RecvKill(source, buf.get(), std::min(count - total, kFramePayloadMax));
+        if (n <= 0 || !SendBody(buf.get(), size_t(n)))
+        {
+            break;
+        }
+        total += n;
+    }
+    m_session.ReturnPayloadBuffer(std::move(buf));
+    return total;
+}
+
+template<typename Transport>
+io::Descriptor& Stream<Transport>::GetDescriptor()
+{
+    return m_session.m_transport.Descriptor();
+}
+
+template<typename Transport>
+Cooperator* Stream<Transport>::GetCooperator()
+{
+    return m_session.m_co;
+}
+
+} // end anonymous namespace
+
+template<typename Transport>
+void ServeHttp2(
+    Context* ctx,
+    Transport transport,
+    std::function<void(ConnectionBase&)> const& handler,
+    Http2Options const& options /* = {} */,
+    const char* initial /* = nullptr */,
+    size_t initialSize /* = 0 */)
+{
+    Session<Transport> session(ctx, transport, handler, options);
+    session.Run(initial, initialSize);
+}
+
+// -------------------------------------------------------------------------------------
+// Explicit template instantiations for known transport types
+// -------------------------------------------------------------------------------------
+
+template void ServeHttp2<PlaintextTransport>(
+    Context*, PlaintextTransport, std::function<void(ConnectionBase&)> const&,
+    Http2Options const&, const char*, size_t);
+template void ServeHttp2<TlsTransport>(
+    Context*, TlsTransport, std::function<void(ConnectionBase&)> const&,
+    Http2Options const&, const char*, size_t);
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "coop/time/interval.h"
+
+namespace coop
+{
+
+struct Context;
+
+namespace http
+{
+
+struct ConnectionBase;
+
+namespace http2
+{
+
+// Wire constants from RFC 9113
+//
+constexpr char PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t PREFACE_SIZE = sizeof(PREFACE) - 1;
+constexpr size_t FRAME_HEADER_SIZE = 9;
+constexpr uint32_t DEFAULT_WINDOW_SIZE = 65535;
+constexpr uint32_t MAX_WINDOW_SIZE = 0x7fffffff;
+constexpr uint32_t DEFAULT_MAX_FRAME_SIZE = 16384;
+
+enum FrameType : uint8_t
+{
+    DATA            = 0x0,
+    HEADERS         = 0x1,
+    PRIORITY        = 0x2,
+    RST_STREAM      = 0x3,
+    SETTINGS        = 0x4,
+    PUSH_PROMISE    = 0x5,
+    PING            = 0x6,
+    GOAWAY          = 0x7,
+    WINDOW_UPDATE   = 0x8,
+    CONTINUATION    = 0x9,
+};
+
+enum Flags : uint8_t
+{
+    END_STREAM      = 0x1,
+    ACK             = 0x1,
+    END_HEADERS     = 0x4,
+    PADDED          = 0x8,
+    PRIORITY_FLAG   = 0x20,
+};
+
+enum ErrorCode : uint32_t
+{
+    NO_ERROR            = 0x0,
+    PROTOCOL_ERROR      = 0x1,
+    INTERNAL_ERROR      = 0x2,
+    FLOW_CONTROL_ERROR  = 0x3,
+    SETTINGS_TIMEOUT    = 0x4,
+    STREAM_CLOSED       = 0x5,
+    FRAME_SIZE_ERROR    = 0x6,
+    REFUSED_STREAM      = 0x7,
+    CANCEL              = 0x8,
+    COMPRESSION_ERROR   = 0x9,
+    CONNECT_ERROR       = 0xa,
+    ENHANCE_YOUR_CALM   = 0xb,
+};
+
+enum Setting : uint16_t
+{
+    HEADER_TABLE_SIZE       = 0x1,
+    ENABLE_PUSH             = 0x2,
+    MAX_CONCURRENT_STREAMS  = 0x3,
+    INITIAL_WINDOW_SIZE     = 0x4,
+    MAX_FRAME_SIZE          = 0x5,
+    MAX_HEADER_LIST_SIZE    = 0x6,
+};
+
+} // end namespace coop::http::http2
+
+struct Http2Options
+{
+    // Advertised in our SETTINGS. Streams past maxConcurrentStreams are refused (REFUSED_STREAM),
+    // which a client retries.
+    //
+    uint32_t maxConcurrentStreams = 100;
+    uint32_t initialWindowSize = http2::DEFAULT_WINDOW_SIZE;
+    uint32_t maxHeaderListSize = 16384;
+
+    // Receive window for the connection as a whole, raised from the protocol's 65535 right after
+    // the preface and topped up as DATA arrives. The per-stream window is what bounds how much
+    // request body a stream buffers.
+    //
+    uint32_t connectionWindowSize = 1 << 20;
+
+    // Stack for each stream's handler context. TLS writes run OpenSSL on it, hence the margin.
+    //
+    size_t streamStackSize = 65536;
+
+    // Close a connection that has no open streams and sends nothing for this long; 0 disables.
+    // Only honored by transports with recv timeouts (plaintext).
+    //
+    time::Interval idleTimeout = std::chrono::seconds(30);
+};
+
+// Serve one HTTP/2 connection on transport (PlaintextTransport, TlsTransport, see transport.h)
+// until the peer closes it, a connection error, or ctx is killed. initial holds bytes already read
+// off the connection, starting with the client preface (prior knowledge) -- or nothing, when the
+// preface is still to come (TLS after ALPN picked "h2").
+//
+// Each request runs handler on a context of its own, spawned on ctx's cooperator, with a
+// ConnectionBase for its stream: the same handler-facing interface as HTTP/1.1, so a Route table
+// serves both unchanged. Header names are lowercase, and an :authority without a host header is
+// also presented as host. KeepAlive() is false, LeftoverData()/SendRawBytes() do not apply (no
+// upgrades inside HTTP/2), and response bodies go out as DATA frames within the peer's flow
+// control windows -- a handler sending more than the window allows blocks until the client reads.
+//
+// ctx reads every frame; the stream contexts write theirs under a lock, so a TlsTransport must
+// sit on a Connection with its own write staging buffer (ssl::Connection::SetWriteBuffer) or with
+// pooled staging.
+//
+template<typename Transport>
+void ServeHttp2(
+    Context* ctx,
+    Transport transport,
+    std::function<void(ConnectionBase&)> const& handler,
+    Http2Options const& options = {},
+    const char* initial = nullptr,
+    size_t initialSize = 0);
+
+} // end namespace coop::http
+} // end namespace coop
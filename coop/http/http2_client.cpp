@@ -0,0 +1,968 @@
+#include "http2_client.h"
+#include "http2_frame.h"
+#include "transport.h"
+#include "tls_transport.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/coordinate_with.h"
+#include "coop/cooperator.h"
+#include "coop/self.h"
+#include "coop/shared_stack.h"
+#include "coop/time/now.h"
+
+namespace coop
+{
+namespace http
+{
+
+using namespace http2;
+
+// One request's stream, on the requesting context's stack. The reader fills in the response and
+// wakes it; the wake coordinator is the same binary semaphore the server's streams use.
+//
+template<typename Transport>
+struct Http2Client<Transport>::Stream
+{
+    Stream(Context* ctx, Http2Response* r)
+    : response(r)
+    , wake(ctx)
+    {
+    }
+
+    void Wake(Context* ctx)
+    {
+        if (wake.IsHeld())
+        {
+            wake.Release(ctx, false);
+        }
+    }
+
+    uint32_t            id = 0;
+    Http2Response*      response;
+
+    int64_t             sendWindow = 0;
+    int64_t             recvWindow = 0;
+    uint32_t            recvUnacked = 0;
+
+    bool                headersDone = false;    // the final (non-1xx) response headers are in
+    bool                remoteClosed = false;
+    bool                reset = false;
+    bool                refused = false;        // never processed: REFUSED_STREAM or GOAWAY
+
+    Coordinator         wake;
+};
+
+template<typename Transport>
+struct Http2Client<Transport>::Waiter : EmbeddedListHookups<Waiter>
+{
+    explicit Waiter(Context* ctx) : coord(ctx) {}
+
+    Coordinator     coord;
+    bool            granted = false;
+};
+
+namespace
+{
+
+time::Interval Remaining(int64_t deadline)
+{
+    return time::Interval(deadline - time::MonotonicMicros());
+}
+
+} // end anonymous namespace
+
+template<typename Transport>
+Http2Client<Transport>::Http2Client(Transport transport, const char* authority,
+                                    Http2ClientOptions const& options)
+: m_transport(transport)
+, m_authority(authority)
+, m_options(options)
+, m_recvBufSize(2 * (FRAME_HEADER_SIZE + kFramePayloadMax))
+, m_recvBuf(new char[m_recvBufSize])
+, m_sendBuf(new uint8_t[FRAME_HEADER_SIZE + kFramePayloadMax])
+, m_decoder(4096, options.maxHeaderListSize)
+{
+}
+
+template<typename Transport>
+Http2Client<Transport>::~Http2Client()
+{
+    if (m_started)
+    {
+        Close(Self());
+    }
+}
+
+template<typename Transport>
+bool Http2Client<Transport>::Start(Context* ctx)
+{
+    assert(!m_started);
+    m_started = true;
+
+    // Preface and SETTINGS in one send, then the connection window raised
+    //
+    uint8_t out[PREFACE_SIZE + FRAME_HEADER_SIZE + 3 * 6];
+    memcpy(out, PREFACE, PREFACE_SIZE);
+    uint8_t* settings = out + PREFACE_SIZE + FRAME_HEADER_SIZE;
+    WriteSetting(settings, ENABLE_PUSH, 0);
+    WriteSetting(settings + 6, INITIAL_WINDOW_SIZE,
+                 std::min(m_options.initialWindowSize, MAX_WINDOW_SIZE));
+    WriteSetting(settings + 12, MAX_HEADER_LIST_SIZE, m_options.maxHeaderListSize);
+    WriteFrameHeader(out + PREFACE_SIZE, 3 * 6, SETTINGS, 0, 0);
+
+    Lock(ctx);
+    m_writeError = m_transport.SendAll(out, sizeof(out)) < 0;
+    Unlock(ctx);
+    if (m_writeError)
+    {
+        m_failed = true;
+        return false;
+    }
+    if (m_options.connectionWindowSize > DEFAULT_WINDOW_SIZE)
+    {
+        uint32_t raise = std::min(m_options.connectionWindowSize, MAX_WINDOW_SIZE)
+            - DEFAULT_WINDOW_SIZE;
+        m_recvWindow += raise;
+        WriteWindowUpdate(0, raise);
+    }
+
+    SpawnConfiguration config = {.priority = ctx->GetPriority(),
+                                 .stackSize = m_options.readerStackSize};
+    bool spawned = ctx->GetCooperator()->Spawn(config, [this](Context* reader)
+    {
+        Run(reader);
+    }, &m_reader);
+    if (!spawned)
+    {
+        spdlog::warn("http2 client reader spawn failed authority={}", m_authority);
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+template<typename Transport>
+void Http2Client<Transport>::Close(Context* ctx)
+{
+    if (!m_started)
+    {
+        return;
+    }
+    if (!m_failed && !m_writeError)
+    {
+        uint8_t goaway[8];
+        WriteU32(goaway, 0);
+        WriteU32(goaway + 4, NO_ERROR);
+        WriteFrame(GOAWAY, 0, 0, goaway, sizeof(goaway));
+    }
+    m_goaway = true;
+
+    // The reader holds m_readerExit until its last act and fails every stream on the way out
+    //
+    if (m_reader)
+    {
+        m_reader.Kill();
+    }
+    m_readerExit.Acquire(ctx);
+    m_readerExit.Release(ctx, false);
+    while (m_reader || m_active > 0)
+    {
+        ctx->Yield();
+    }
+    m_started = false;
+}
+
+// -------------------------------------------------------------------------------------
+// Requests
+// -------------------------------------------------------------------------------------
+
+template<typename Transport>
+int Http2Client<Transport>::Request(Context* ctx, const char* method, const char* path,
+                                    Http2Response* response, const char* headerLines,
+                                    const void* body, size_t bodySize)
+{
+    response->status = 0;
+    response->headers.Clear();
+    response->body.clear();
+
+    int64_t deadline = time::MonotonicMicros()
+        + std::chrono::duration_cast<time::Interval>(m_options.timeout).count();
+    if (!Usable())
+    {
+        return -EAGAIN;
+    }
+    if (!AcquireSlot(ctx, deadline))
+    {
+        if (ctx->IsKilled())
+        {
+            return -ECANCELED;
+        }
+        return Usable() ? -ETIMEDOUT : -EAGAIN;
+    }
+    if (!Usable())
+    {
+        ReleaseSlot();
+        return -EAGAIN;
+    }
+
+    std::string block;
+    hpack::Encode(":method", method, &block);
+    hpack::Encode(":scheme", std::is_same_v<Transport, TlsTransport> ? "https" : "http", &block);
+    hpack::Encode(":authority", m_authority, &block);
+    hpack::Encode(":path", path, &block);
+    if (body)
+    {
+        hpack::Encode("content-length", std::to_string(bodySize), &block);
+    }
+    if (headerLines)
+    {
+        EncodeHeaderLines(headerLines, &block);
+    }
+
+    Stream stream(ctx, response);
+    bool endStream = !body;
+
+    // Ids are taken under the write lock, so streams open on the wire in id order as the
+    // protocol requires
+    //
+    Lock(ctx);
+    if (m_nextStreamId == 0)
+    {
+        Unlock(ctx);
+        ReleaseSlot();
+        return -EAGAIN;
+    }
+    stream.id = m_nextStreamId;
+    m_nextStreamId = m_nextStreamId >= MAX_WINDOW_SIZE - 2 ? 0 : m_nextStreamId + 2;
+    stream.sendWindow = m_peerInitialWindow;
+    stream.recvWindow = std::min(m_options.initialWindowSize, MAX_WINDOW_SIZE);
+    m_streams.emplace(stream.id, &stream);
+
+    size_t max = std::min<size_t>(m_peerMaxFrameSize, kFramePayloadMax);
+    size_t at = 0;
+    bool ok = true;
+    do
+    {
+        size_t n = std::min(max, block.size() - at);
+        bool first = at == 0;
+        bool last = at + n == block.size();
+        uint8_t flags = (last ? END_HEADERS : 0) | (first && endStream ? END_STREAM : 0);
+        ok = WriteFrameLocked(first ? HEADERS : CONTINUATION, flags, stream.id,
+                              block.data() + at, n);
+        at += n;
+    }
+    while (ok && at < block.size());
+    Unlock(ctx);
+
+    if (ok && body)
+    {
+        ok = WriteData(ctx, &stream, static_cast<const char*>(body), bodySize, deadline);
+    }
+
+    int result = 0;
+    while (ok && !stream.remoteClosed && !stream.reset && !m_failed)
+    {
+        auto remaining = Remaining(deadline);
+        if (remaining.count() <= 0)
+        {
+            result = -ETIMEDOUT;
+            break;
+        }
+        auto wait = CoordinateWithKill(ctx, &stream.wake, remaining);
+        if (wait.Killed())
+        {
+            result = -ECANCELED;
+            break;
+        }
+        if (wait.TimedOut())
+        {
+            result = -ETIMEDOUT;
+            break;
+        }
+    }
+
+    if (result == 0 && !(stream.remoteClosed && stream.headersDone && !stream.reset))
+    {
+        result = ctx->IsKilled() ? -ECANCELED
+            : stream.refused ? -EAGAIN
+            : !ok && !m_failed && !m_writeError && !stream.reset ? -ETIMEDOUT
+            : -ECONNRESET;
+    }
+
+    // A stream we give up on is cancelled, so the server stops working on it
+    //
+    if ((result == -ETIMEDOUT || result == -ECANCELED) && !stream.reset && !m_failed)
+    {
+        uint8_t payload[4];
+        WriteU32(payload, CANCEL);
+        WriteFrame(RST_STREAM, 0, stream.id, payload, sizeof(payload));
+    }
+
+    m_streams.erase(stream.id);
+    ReleaseSlot();
+    return result;
+}
+
+// A stream slot under the server's SETTINGS_MAX_CONCURRENT_STREAMS, in arrival order. A waiter is
+// popped and its slot counted before it is released, so one found granted holds a slot however
+// its wait ended.
+//
+template<typename Transport>
+bool Http2Client<Transport>::AcquireSlot(Context* ctx, int64_t deadline)
+{
+    if (m_active < m_peerMaxStreams && m_waiters.IsEmpty())
+    {
+        m_active++;
+        return true;
+    }
+
+    auto remaining = Remaining(deadline);
+    if (remaining.count() <= 0)
+    {
+        return false;
+    }
+    coop::detail::WaitStorage<Waiter> stored(ctx, ctx);
+    Waiter& waiter = *stored.Get();
+    m_waiters.Push(&waiter);
+    auto result = CoordinateWithKill(ctx, &waiter.coord, remaining);
+
+    if (!waiter.granted)
+    {
+        m_waiters.Remove(&waiter);
+        return false;
+    }
+    if (result.Killed())
+    {
+        ReleaseSlot();
+        return false;
+    }
+    return true;
+}
+
+template<typename Transport>
+void Http2Client<Transport>::ReleaseSlot()
+{
+    m_active--;
+    GrantWaiters();
+}
+
+// A failed connection grants everyone, so each waiter wakes to find it unusable
+//
+template<typename Transport>
+void Http2Client<Transport>::GrantWaiters()
+{
+    while ((m_active < m_peerMaxStreams || !Usable()) && !m_waiters.IsEmpty())
+    {
+        auto* waiter = m_waiters.Pop();
+        waiter->granted = true;
+        m_active++;
+        waiter->coord.Release(Self(), false);
+    }
+}
+
+// -------------------------------------------------------------------------------------
+// Reading
+// -------------------------------------------------------------------------------------
+
+template<typename Transport>
+void Http2Client<Transport>::Run(Context* ctx)
+{
+    ctx->SetName("Http2Client");
+    m_readerExit.Acquire(ctx);
+
+    FrameHeader header;
+    const uint8_t* payload;
+    while (!ctx->IsKilled() && !m_writeError && ReadFrame(&header, &payload))
+    {
+        if (!OnFrame(header, payload))
+        {
+            break;
+        }
+    }
+
+    if (m_error != NO_ERROR && !m_writeError)
+    {
+        uint8_t goaway[8];
+        WriteU32(goaway, 0);
+        WriteU32(goaway + 4, m_error);
+        WriteFrame(GOAWAY, 0, 0, goaway, sizeof(goaway));
+    }
+    Fail();
+    m_readerExit.Release(ctx, false);
+}
+
+// The connection is done: every stream and waiter wakes to an error
+//
+template<typename Transport>
+void Http2Client<Transport>::Fail()
+{
+    m_failed = true;
+    auto* ctx = Self();
+    for (auto& [id, stream] : m_streams)
+    {
+        stream->Wake(ctx);
+    }
+    GrantWaiters();
+}
+
+template<typename Transport>
+int Http2Client<Transport>::Fill(size_t need)
+{
+    while (m_recvLen - m_recvPos < need)
+    {
+        if (m_recvPos > 0 && m_recvBufSize - m_recvPos < need)
+        {
+            memmove(m_recvBuf.get(), m_recvBuf.get() + m_recvPos, m_recvLen - m_recvPos);
+            m_recvLen -= m_recvPos;
+            m_recvPos = 0;
+        }
+        int n = m_transport.Recv(m_recvBuf.get() + m_recvLen, m_recvBufSize - m_recvLen, 0,
+                                 time::Interval(0));
+        if (n <= 0)
+        {
+            return n;
+        }
+        m_recvLen += size_t(n);
+    }
+    return 1;
+}
+
+template<typename Transport>
+bool Http2Client<Transport>::ReadFrame(FrameHeader* header, const uint8_t** payload)
+{
+    if (Fill(FRAME_HEADER_SIZE) <= 0)
+    {
+        return false;
+    }
+    ReadFrameHeader(reinterpret_cast<const uint8_t*>(m_recvBuf.get() + m_recvPos), header);
+    if (header->length > kFramePayloadMax)
+    {
+        return ConnectionError(FRAME_SIZE_ERROR, "frame too large");
+    }
+    if (Fill(FRAME_HEADER_SIZE + header->length) <= 0)
+    {
+        return false;
+    }
+    *payload = reinterpret_cast<const uint8_t*>(m_recvBuf.get() + m_recvPos + FRAME_HEADER_SIZE);
+    m_recvPos += FRAME_HEADER_SIZE + header->length;
+    return true;
+}
+
+template<typename Transport>
+bool Http2Client<Transport>::ConnectionError(ErrorCode code, const char* why)
+{
+    SPDLOG_DEBUG("http2 client connection error code={} why={}", uint32_t(code), why);
+    m_error = code;
+    return false;
+}
+
+template<typename Transport>
+bool Http2Client<Transport>::OnFrame(FrameHeader const& header, const uint8_t* payload)
+{
+    if (m_headerStream && (header.type != CONTINUATION || header.stream != m_headerStream))
+    {
+        return ConnectionError(PROTOCOL_ERROR, "frame inside a header block");
+    }
+
+    switch (header.type)
+    {
+    case DATA:
+        return OnData(header, payload);
+
+    case HEADERS:
+    {
+        if (header.stream == 0)
+        {
+            return ConnectionError(PROTOCOL_ERROR, "headers on stream 0");
+        }
+        size_t len = header.length;
+        if (!StripPadding(header.flags, &payload, &len))
+        {
+            return ConnectionError(PROTOCOL_ERROR, "headers padding");
+        }
+        if (header.flags & PRIORITY_FLAG)
+        {
+            if (len < 5)
+            {
+                return ConnectionError(FRAME_SIZE_ERROR, "headers priority");
+            }
+            payload += 5;
+            len -= 5;
+        }
+        m_headerBlock.assign(reinterpret_cast<const char*>(payload), len);
+        m_headerStream = header.stream;
+        m_headerFlags = header.flags;
+        return (header.flags & END_HEADERS) ? OnHeaderBlock() : true;
+    }
+
+    case CONTINUATION:
+        if (!m_headerStream)
+        {
+            return ConnectionError(PROTOCOL_ERROR, "unexpected continuation");
+        }
+        if (m_headerBlock.size() + header.length > kHeaderBlockMax)
+        {
+            return ConnectionError(ENHANCE_YOUR_CALM, "header block too large");
+        }
+        m_headerBlock.append(reinterpret_cast<const char*>(payload), header.length);
+        return (header.flags & END_HEADERS) ? OnHeaderBlock() : true;
+
+    case SETTINGS:
+        return OnSettings(header, payload);
+
+    case WINDOW_UPDATE:
+        return OnWindowUpdate(header, payload);
+
+    case PING:
+        if (header.length != 8)
+        {
+            return ConnectionError(FRAME_SIZE_ERROR, "ping size");
+        }
+        if (header.stream != 0)
+        {
+            return ConnectionError(PROTOCOL_ERROR, "ping on a stream");
+        }
+        if (!(header.flags & ACK))
+        {
+            WriteFrame(PING, ACK, 0, payload, 8);
+        }
+        return true;
+
+    case RST_STREAM:
+        if (header.length != 4)
+        {
+            return ConnectionError(FRAME_SIZE_ERROR, "rst_stream size");
+        }
+        if (auto* stream = Find(header.stream))
+        {
+            stream->reset = true;
+            stream->refused = ReadU32(payload) == REFUSED_STREAM;
+            stream->Wake(Self());
+        }
+        return true;
+
+    case GOAWAY:
+        return OnGoaway(header, payload);
+
+    case PUSH_PROMISE:
+        return ConnectionError(PROTOCOL_ERROR, "push_promise with push disabled");
+
+    default:
+        // PRIORITY and unknown frame types are ignored (RFC 9113 4.1)
+        //
+        return true;
+    }
+}
+
+template<typename Transport>
+bool Http2Client<Transport>::OnData(FrameHeader const& header, const uint8_t* payload)
+{
+    if (header.stream == 0)
+    {
+        return ConnectionError(PROTOCOL_ERROR, "data on stream 0");
+    }
+
+    // Padding counts against flow control too. Responses are collected whole, so the window goes
+    // straight back.
+    //
+    m_recvWindow -= header.length;
+    if (m_recvWindow < 0)
+    {
+        return ConnectionError(FLOW_CONTROL_ERROR, "connection window overrun");
+    }
+    m_recvUnacked += header.length;
+    if (m_recvUnacked >= m_options.connectionWindowSize / 2)
+    {
+        m_recvWindow += m_recvUnacked;
+        WriteWindowUpdate(0, m_recvUnacked);
+        m_recvUnacked = 0;
+    }
+
+    size_t len = header.length;
+    if (!StripPadding(header.flags, &payload, &len))
+    {
+        return ConnectionError(PROTOCOL_ERROR, "data padding");
+    }
+
+    // A stream given up on (timed out, cancelled) just drops its data
+    //
+    auto* stream = Find(header.stream);
+    if (!stream || stream->reset)
+    {
+        return true;
+    }
+    if (stream->remoteClosed || !stream->headersDone)
+    {
+        stream->reset = true;
+        uint8_t code[4];
+        WriteU32(code, stream->remoteClosed ? STREAM_CLOSED : PROTOCOL_ERROR);
+        WriteFrame(RST_STREAM, 0, header.stream, code, sizeof(code));
+        stream->Wake(Self());
+        return true;
+    }
+
+    stream->recvWindow -= header.length;
+    if (stream->recvWindow < 0)
+    {
+        stream->reset = true;
+        uint8_t code[4];
+        WriteU32(code, FLOW_CONTROL_ERROR);
+        WriteFrame(RST_STREAM, 0, header.stream, code, sizeof(code));
+        stream->Wake(Self());
+        return true;
+    }
+    stream->response->body.append(reinterpret_cast<const char*>(payload), len);
+
+    if (header.flags & END_STREAM)
+    {
+        stream->remoteClosed = true;
+        stream->Wake(Self());
+        return true;
+    }
+    stream->recvUnacked += header.length;
+    if (stream->recvUnacked >= m_options.initialWindowSize / 2)
+    {
+        stream->recvWindow += stream->recvUnacked;
+        WriteWindowUpdate(header.stream, stream->recvUnacked);
+        stream->recvUnacked = 0;
+    }
+    return true;
+}
+
+template<typename Transport>
+bool Http2Client<Transport>::OnHeaderBlock()
+{
+    uint32_t id = m_headerStream;
+    bool endStream = (m_headerFlags & END_STREAM) != 0;
+    m_headerStream = 0;
+
+    // Decoded even for a stream given up on: the dynamic table must stay in step with the server
+    //
+    hpack::HeaderList headers;
+    int decoded = m_decoder.Decode(reinterpret_cast<const uint8_t*>(m_headerBlock.data()),
+                                   m_headerBlock.size(), &headers);
+    if (decoded == -EBADMSG)
+    {
+        return ConnectionError(COMPRESSION_ERROR, "hpack");
+    }
+
+    auto* stream = Find(id);
+    if (!stream || stream->reset)
+    {
+        return true;
+    }
+
+    auto fail = [&](ErrorCode code)
+    {
+        stream->reset = true;
+        uint8_t payload[4];
+        WriteU32(payload, code);
+        WriteFrame(RST_STREAM, 0, id, payload, sizeof(payload));
+        stream->Wake(Self());
+        return true;
+    };
+    if (decoded == -E2BIG)
+    {
+        return fail(CANCEL);
+    }
+
+    if (!stream->headersDone)
+    {
+        auto status = headers.Find(":status");
+        int code = 0;
+        for (char c : status)
+        {
+            code = c >= '0' && c <= '9' && code < 1000 ? code * 10 + (c - '0') : 1000;
+        }
+        if (code < 100 || code > 999)
+        {
+            return fail(PROTOCOL_ERROR);
+        }
+
+        // Interim (1xx) responses come before the real one and are dropped
+        //
+        if (code < 200)
+        {
+            return endStream ? fail(PROTOCOL_ERROR) : true;
+        }
+        stream->response->status = code;
+        stream->headersDone = true;
+    }
+    else if (!endStream)
+    {
+        return fail(PROTOCOL_ERROR);    // a second header block must be trailers
+    }
+
+    for (size_t i = 0; i < headers.Count(); i++)
+    {
+        auto field = headers.Get(i);
+        if (field.name.empty() || field.name[0] != ':')
+        {
+            stream->response->headers.Add(field.name, field.value);
+        }
+    }
+
+    if (endStream)
+    {
+        stream->remoteClosed = true;
+        stream->Wake(Self());
+    }
+    return true;
+}
+
+template<typename Transport>
+bool Http2Client<Transport>::OnSettings(FrameHeader const& header, const uint8_t* payload)
+{
+    if (header.stream != 0)
+    {
+        return ConnectionError(PROTOCOL_ERROR, "settings on a stream");
+    }
+    if (header.flags & ACK)
+    {
+        return header.length == 0 ? true : ConnectionError(FRAME_SIZE_ERROR, "settings ack size");
+    }
+    if (header.length % 6 != 0)
+    {
+        return ConnectionError(FRAME_SIZE_ERROR, "settings size");
+    }
+
+    auto* ctx = Self();
+    for (size_t i = 0; i < header.length; i += 6)
+    {
+        uint16_t id = uint16_t((payload[i] << 8) | payload[i + 1]);
+        uint32_t value = ReadU32(payload + i + 2);
+        switch (id)
+        {
+        case MAX_CONCURRENT_STREAMS:
+            m_peerMaxStreams = value;
+            break;
+
+        case INITIAL_WINDOW_SIZE:
+        {
+            if (value > MAX_WINDOW_SIZE)
+            {
+                return ConnectionError(FLOW_CONTROL_ERROR, "initial_window_size");
+            }
+
+            // Applies to every open stream, retroactively: windows may go negative
+            //
+            int64_t delta = int64_t(value) - int64_t(m_peerInitialWindow);
+            m_peerInitialWindow = value;
+            for (auto& [streamId, stream] : m_streams)
+            {
+                stream->sendWindow += delta;
+                stream->Wake(ctx);
+            }
+            break;
+        }
+
+        case MAX_FRAME_SIZE:
+            if (value < DEFAULT_MAX_FRAME_SIZE || value > 0xffffff)
+            {
+                return ConnectionError(PROTOCOL_ERROR, "max_frame_size");
+            }
+            m_peerMaxFrameSize = value;
+            break;
+
+        default:
+            // HEADER_TABLE_SIZE does not matter to an encoder that never indexes; ENABLE_PUSH is
+            // the server's to ignore; the rest are unknown and ignored
+            //
+            break;
+        }
+    }
+    WriteFrame(SETTINGS, ACK, 0, nullptr, 0);
+    GrantWaiters();
+    return true;
+}
+
+template<typename Transport>
+bool Http2Client<Transport>::OnWindowUpdate(FrameHeader const& header, const uint8_t* payload)
+{
+    if (header.length != 4)
+    {
+        return ConnectionError(FRAME_SIZE_ERROR, "window_update size");
+    }
+    uint32_t increment = ReadU32(payload) & MAX_WINDOW_SIZE;
+    auto* ctx = Self();
+
+    if (header.stream == 0)
+    {
+        if (increment == 0)
+        {
+            return ConnectionError(PROTOCOL_ERROR, "zero window increment");
+        }
+        m_sendWindow += increment;
+        if (m_sendWindow > MAX_WINDOW_SIZE)
+        {
+            return ConnectionError(FLOW_CONTROL_ERROR, "connection window overflow");
+        }
+        for (auto& [id, stream] : m_streams)
+        {
+            stream->Wake(ctx);
+        }
+        return true;
+    }
+
+    auto* stream = Find(header.stream);
+    if (!stream)
+    {
+        return true;
+    }
+    stream->sendWindow += increment;
+    if (increment == 0 || stream->sendWindow > MAX_WINDOW_SIZE)
+    {
+        stream->reset = true;
+        uint8_t code[4];
+        WriteU32(code, increment == 0 ? PROTOCOL_ERROR : FLOW_CONTROL_ERROR);
+        WriteFrame(RST_STREAM, 0, header.stream, code, sizeof(code));
+    }
+    stream->Wake(ctx);
+    return true;
+}
+
+// The server takes nothing new; streams past its last-processed id were never seen and may be
+// retried elsewhere, the rest still get their responses
+//
+template<typename Transport>
+bool Http2Client<Transport>::OnGoaway(FrameHeader const& header, const uint8_t* payload)
+{
+    if (header.stream != 0 || header.length < 8)
+    {
+        return ConnectionError(PROTOCOL_ERROR, "goaway");
+    }
+    uint32_t last = ReadU32(payload) & MAX_WINDOW_SIZE;
+    SPDLOG_DEBUG("http2 client peer goaway last={} code={}", last, ReadU32(payload + 4));
+    m_goaway = true;
+
+    auto* ctx = Self();
+    for (auto& [id, stream] : m_streams)
+    {
+        if (id > last)
+        {
+            stream->reset = true;
+            stream->refused = true;
+            stream->Wake(ctx);
+        }
+    }
+    GrantWaiters();
+    return true;
+}
+
+// -------------------------------------------------------------------------------------
+// Writing
+// -------------------------------------------------------------------------------------
+
+template<typename Transport>
+bool Http2Client<Transport>::WriteFrameLocked(uint8_t type, uint8_t flags, uint32_t stream,
+                                              const void* payload, size_t len)
+{
+    if (m_writeError)
+    {
+        return false;
+    }
+    assert(len <= kFramePayloadMax);
+    WriteFrameHeader(m_sendBuf.get(), len, type, flags, stream);
+    if (len > 0)
+    {
+        memcpy(m_sendBuf.get() + FRAME_HEADER_SIZE, payload, len);
+    }
+    if (m_transport.SendAll(m_sendBuf.get(), FRAME_HEADER_SIZE + len) < 0)
+    {
+        m_writeError = true;
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+template<typename Transport>
+bool Http2Client<Transport>::WriteFrame(uint8_t type, uint8_t flags, uint32_t stream,
+                                        const void* payload, size_t len)
+{
+    auto* ctx = Self();
+    Lock(ctx);
+    bool ok = WriteFrameLocked(type, flags, stream, payload, len);
+    Unlock(ctx);
+    return ok;
+}
+
+template<typename Transport>
+bool Http2Client<Transport>::WriteWindowUpdate(uint32_t stream, uint32_t increment)
+{
+    uint8_t payload[4];
+    WriteU32(payload, increment);
+    return WriteFrame(WINDOW_UPDATE, 0, stream, payload, sizeof(payload));
+}
+
+// The request body as DATA within both flow control windows, waiting for WINDOW_UPDATEs as the
+// server's Session::WriteData does. False on a reset, write error, kill, or the deadline.
+//
+template<typename Transport>
+bool Http2Client<Transport>::WriteData(Context* ctx, Stream* stream, const char* data,
+                                       size_t size, int64_t deadline)
+{
+    do
+    {
+        if (stream->reset || m_writeError || m_failed)
+        {
+            return false;
+        }
+
+        Lock(ctx);
+        int64_t window = std::min(m_sendWindow, stream->sendWindow);
+        if (size > 0 && window <= 0)
+        {
+            Unlock(ctx);
+            auto remaining = Remaining(deadline);
+            if (remaining.count() <= 0)
+            {
+                return false;
+            }
+            auto wait = CoordinateWithKill(ctx, &stream->wake, remaining);
+            if (wait.Killed() || wait.TimedOut())
+            {
+                return false;
+            }
+            continue;
+        }
+
+        size_t n = std::min({size, size_t(std::min<uint32_t>(m_peerMaxFrameSize,
+                                                              kFramePayloadMax)),
+                             size_t(std::max<int64_t>(window, 0))});
+        bool last = n == size;
+        bool ok = WriteFrameLocked(DATA, last ? END_STREAM : 0, stream->id, data, n);
+        m_sendWindow -= int64_t(n);
+        stream->sendWindow -= int64_t(n);
+        Unlock(ctx);
+        if (!ok)
+        {
+            return false;
+        }
+
+        data += n;
+        size -= n;
+    }
+    while (size > 0);
+    return true;
+}
+
+// -------------------------------------------------------------------------------------
+// Explicit template instantiations for known transport types
+// -------------------------------------------------------------------------------------
+
+template struct Http2Client<PlaintextTransport>;
+template struct Http2Client<TlsTransport>;
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "hpack.h"
+#include "http2.h"
+#include "coop/context.h"
+#include "coop/coordinator.h"
+#include "coop/detail/embedded_list.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+namespace http
+{
+
+namespace http2 { struct FrameHeader; }
+
+struct Http2ClientOptions
+{
+    // Advertised in our SETTINGS. Responses are collected whole, so both windows are handed back
+    // as DATA arrives; they bound only how far a backend may run ahead of our reads.
+    //
+    uint32_t initialWindowSize = 1 << 20;
+    uint32_t connectionWindowSize = 1 << 24;
+    uint32_t maxHeaderListSize = 65536;
+
+    // How long a Request may take, from waiting for a stream slot to its response's last byte
+    //
+    time::Interval timeout = std::chrono::seconds(30);
+
+    // Stack for the frame reader context. TLS reads run OpenSSL on it, hence the margin.
+    //
+    size_t readerStackSize = 65536;
+};
+
+struct Http2Response
+{
+    int                 status = 0;
+    hpack::HeaderList   headers;    // lowercase names, trailers included, no pseudo-headers
+    std::string         body;
+};
+
+// Http2Client multiplexes requests over one HTTP/2 connection (RFC 9113), sharing the server's
+// framing and HPACK code: any number of contexts on the cooperator call Request at once, each on
+// a stream of its own, up to the server's SETTINGS_MAX_CONCURRENT_STREAMS -- past it they queue
+// in arrival order. A fan-out to one backend then costs a few connections, not one per call.
+//
+// Start sends the preface and our SETTINGS (push disabled) and spawns the reader context, which
+// reads every frame and hands each stream its response; requests write their own frames under a
+// lock. As with ServeHttp2, a TlsTransport must sit on a Connection with its own write staging
+// buffer (ssl::Connection::SetWriteBuffer) or pooled staging, and its client context must offer
+// ALPN "h2".
+//
+// Request returns 0, or a negative errno:
+//   -EAGAIN     not sent: connection closing (GOAWAY), or the server refused the stream -- safe
+//               to retry on another connection
+//   -ECONNRESET the stream was reset, or the connection failed mid-response
+//   -ETIMEDOUT  options.timeout passed; the stream is cancelled
+//   -ECANCELED  the calling context was killed; the stream is cancelled
+//
+// Close (or the destructor, on a context) stops the reader and waits for requests in flight to
+// fail out. Usable() is false once the connection has failed, is closing, or has used up its
+// stream ids: time to open another.
+//
+//  coop::http::Http2Client client(coop::http::PlaintextTransport(desc), "backend:8080");
+//  client.Start(ctx);
+//  coop::http::Http2Response response;
+//  if (client.Get(ctx, "/users/42", &response) == 0 && response.status == 200) ...
+//
+template<typename Transport>
+struct Http2Client
+{
+    Http2Client(Transport transport, const char* authority,
+                Http2ClientOptions const& options = {});
+    ~Http2Client();
+
+    Http2Client(Http2Client const&) = delete;
+    Http2Client& operator=(Http2Client const&) = delete;
+
+    // False on a write failure; the connection is then unusable
+    //
+    bool Start(Context* ctx);
+
+    // headerLines: extra request headers as "Name: value\r\n" lines (content-type, ...), names
+    // lowercased on the way out. A body goes out as DATA within the server's flow control windows.
+    //
+    int Request(Context* ctx, const char* method, const char* path, Http2Response* response,
+                const char* headerLines = nullptr, const void* body = nullptr,
+                size_t bodySize = 0);
+
+    int Get(Context* ctx, const char* path, Http2Response* response)
+    {
+        return Request(ctx, "GET", path, response);
+    }
+
+    void Close(Context* ctx);
+
+    bool Usable() const { return m_started && !m_failed && !m_goaway && m_nextStreamId > 0; }
+
+    // Streams open or being opened, and the most the server lets us have
+    //
+    size_t Active() const { return m_active; }
+    uint32_t MaxConcurrentStreams() const { return m_peerMaxStreams; }
+
+  private:
+    struct Stream;
+    struct Waiter;
+
+    void Run(Context* ctx);
+    int Fill(size_t need);
+    bool ReadFrame(http2::FrameHeader* header, const uint8_t** payload);
+
+    // Frame handlers. False means a connection error, the code already in m_error.
+    //
+    bool OnFrame(http2::FrameHeader const& header, const uint8_t* payload);
+    bool OnData(http2::FrameHeader const& header, const uint8_t* payload);
+    bool OnHeaderBlock();
+    bool OnSettings(http2::FrameHeader const& header, const uint8_t* payload);
+    bool OnWindowUpdate(http2::FrameHeader const& header, const uint8_t* payload);
+    bool OnGoaway(http2::FrameHeader const& header, const uint8_t* payload);
+    bool ConnectionError(http2::ErrorCode code, const char* why);
+    void Fail();
+
+    bool AcquireSlot(Context* ctx, int64_t deadline);
+    void ReleaseSlot();
+    void GrantWaiters();
+
+    void Lock(Context* ctx) { m_writeLock.Acquire(ctx); }
+    void Unlock(Context* ctx) { m_writeLock.Release(ctx, false); }
+    bool WriteFrameLocked(uint8_t type, uint8_t flags, uint32_t stream, const void* payload,
+                          size_t len);
+    bool WriteFrame(uint8_t type, uint8_t flags, uint32_t stream, const void* payload,
+                    size_t len);
+    bool WriteWindowUpdate(uint32_t stream, uint32_t increment);
+    bool WriteData(Context* ctx, Stream* stream, const char* data, size_t size, int64_t deadline);
+
+    Stream* Find(uint32_t id)
+    {
+        auto it = m_streams.find(id);
+        return it == m_streams.end() ? nullptr : it->second;
+    }
+
+    Transport                               m_transport;
+    std::string                             m_authority;
+    Http2ClientOptions                      m_options;
+
+    Context::Handle                         m_reader;
+    Coordinator                             m_readerExit;
+    bool                                    m_started = false;
+    bool                                    m_failed = false;
+    bool                                    m_goaway = false;
+
+    size_t                                  m_recvBufSize;
+    std::unique_ptr<char[]>                 m_recvBuf;
+    size_t                                  m_recvLen = 0;
+    size_t                                  m_recvPos = 0;
+
+    Coordinator                             m_writeLock;
+    std::unique_ptr<uint8_t[]>              m_sendBuf;
+    bool                                    m_writeError = false;
+
+    // Server SETTINGS, and our send window on the connection
+    //
+    uint32_t                                m_peerMaxStreams = 100;
+    uint32_t                                m_peerInitialWindow = http2::DEFAULT_WINDOW_SIZE;
+    uint32_t                                m_peerMaxFrameSize = http2::DEFAULT_MAX_FRAME_SIZE;
+    int64_t                                 m_sendWindow = http2::DEFAULT_WINDOW_SIZE;
+
+    // Our receive window on the connection, and what has arrived since we last topped it up
+    //
+    int64_t                                 m_recvWindow = http2::DEFAULT_WINDOW_SIZE;
+    uint32_t                                m_recvUnacked = 0;
+
+    hpack::Decoder                          m_decoder;
+    uint32_t                                m_headerStream = 0;
+    uint8_t                                 m_headerFlags = 0;
+    std::string                             m_headerBlock;
+
+    std::unordered_map<uint32_t, Stream*>   m_streams;
+    EmbeddedList<Waiter>                    m_waiters;
+    size_t                                  m_active = 0;
+    uint32_t                                m_nextStreamId = 1;     // 0 once ids run out
+    http2::ErrorCode                        m_error = http2::NO_ERROR;
+};
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "hpack.h"
+#include "http2.h"
+
+namespace coop
+{
+namespace http
+{
+namespace http2
+{
+
+// Framing shared by the server session (http2.cpp) and the client (http2_client.cpp)
+//
+
+// Largest frame we accept, and the most a frame of ours ever carries: we do not raise
+// SETTINGS_MAX_FRAME_SIZE, and 16K frames already amortize the 9-byte header
+//
+constexpr size_t kFramePayloadMax = DEFAULT_MAX_FRAME_SIZE;
+
+// A header block may span CONTINUATION frames; past this much compressed input it is an attack
+// rather than a request
+//
+constexpr size_t kHeaderBlockMax = 4 * 65536;
+
+inline uint32_t ReadU32(const uint8_t* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+inline void WriteU32(uint8_t* p, uint32_t v)
+{
+    p[0] = uint8_t(v >> 24);
+    p[1] = uint8_t(v >> 16);
+    p[2] = uint8_t(v >> 8);
+    p[3] = uint8_t(v);
+}
+
+inline void WriteFrameHeader(uint8_t* p, size_t len, uint8_t type, uint8_t flags, uint32_t stream)
+{
+    p[0] = uint8_t(len >> 16);
+    p[1] = uint8_t(len >> 8);
+    p[2] = uint8_t(len);
+    p[3] = type;
+    p[4] = flags;
+    WriteU32(p + 5, stream & MAX_WINDOW_SIZE);
+}
+
+struct FrameHeader
+{
+    uint32_t    length;
+    uint8_t     type;
+    uint8_t     flags;
+    uint32_t    stream;
+};
+
+inline void ReadFrameHeader(const uint8_t* p, FrameHeader* header)
+{
+    header->length = (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | p[2];
+    header->type = p[3];
+    header->flags = p[4];
+    header->stream = ReadU32(p + 5) & MAX_WINDOW_SIZE;
+}
+
+// One SETTINGS entry at p: identifier, then value
+//
+inline void WriteSetting(uint8_t* p, Setting id, uint32_t value)
+{
+    p[0] = uint8_t(id >> 8);
+    p[1] = uint8_t(id);
+    WriteU32(p + 2, value);
+}
+
+// Strip the pad length byte and trailing padding of a PADDED frame. False if the padding does not
+// fit.
+//
+inline bool StripPadding(uint8_t flags, const uint8_t** p, size_t* len)
+{
+    if (!(flags & PADDED))
+    {
+        return true;
+    }
+    if (*len < 1)
+    {
+        return false;
+    }
+    size_t pad = **p;
+    if (pad >= *len)
+    {
+        return false;
+    }
+    (*p)++;
+    *len -= 1 + pad;
+    return true;
+}
+
+// Re-encode HTTP/1.1 "Name: value\r\n" lines (the Date and common header blocks, a client's extra
+// request headers) as header fields, names lowercased as HTTP/2 requires
+//
+inline void EncodeHeaderLines(std::string_view lines, std::string* out)
+{
+    std::string name;
+    while (!lines.empty())
+    {
+        size_t end = lines.find("\r\n");
+        auto line = lines.substr(0, end);
+        lines = end == std::string_view::npos ? std::string_view() : lines.substr(end + 2);
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos || colon == 0)
+        {
+            continue;
+        }
+        name.assign(line.substr(0, colon));
+        for (auto& c : name)
+        {
+            c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        }
+        auto value = line.substr(colon + 1);
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        {
+            value.remove_prefix(1);
+        }
+        hpack::Encode(name, value, out);
+    }
+}
+
+} // end namespace coop::http::http2
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,224 @@
+#include "json_writer.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#include "connection.h"
+#include "scan.h"
+
+namespace coop
+{
+namespace http
+{
+
+namespace
+{
+
+// The two-character escapes; zero where a control character takes \u00XX
+//
+constexpr char SHORT_ESCAPE[0x20] = {
+    0,   0,   0,   0,   0,   0,   0,   0,   'b', 't', 'n', 0,   'f', 'r', 0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+constexpr char HEX[] = "0123456789abcdef";
+
+} // end anonymous namespace
+
+JsonWriter::JsonWriter(ConnectionBase& conn, int status /* = 200 */,
+                       const char* contentType /* = "application/json" */)
+: m_conn(&conn)
+, m_status(status)
+, m_contentType(contentType)
+{
+    m_first[0] = true;
+}
+
+JsonWriter::JsonWriter(std::string& out)
+: m_out(&out)
+{
+    m_first[0] = true;
+}
+
+void JsonWriter::Key(std::string_view key)
+{
+    Comma();
+    Quoted(key);
+    Put(':');
+
+    // The value that follows takes no comma
+    //
+    m_first[m_depth] = true;
+}
+
+void JsonWriter::String(std::string_view value)
+{
+    Comma();
+    Quoted(value);
+}
+
+void JsonWriter::Int(int64_t value)
+{
+    Comma();
+    char* p = Reserve(NUMBER_SPACE);
+    m_pos = std::to_chars(p, p + NUMBER_SPACE, value).ptr;
+}
+
+void JsonWriter::UInt(uint64_t value)
+{
+    Comma();
+    char* p = Reserve(NUMBER_SPACE);
+    m_pos = std::to_chars(p, p + NUMBER_SPACE, value).ptr;
+}
+
+void JsonWriter::Double(double value)
+{
+    Comma();
+    if (!std::isfinite(value))
+    {
+        Write("null", 4);
+        return;
+    }
+    char* p = Reserve(NUMBER_SPACE);
+    m_pos = std::to_chars(p, p + NUMBER_SPACE, value).ptr;
+}
+
+// Fixed notation is as long as the integer part: what does not fit goes shortest instead
+//
+void JsonWriter::Double(double value, int decimals)
+{
+    Comma();
+    if (!std::isfinite(value))
+    {
+        Write("null", 4);
+        return;
+    }
+    char* p = Reserve(NUMBER_SPACE);
+    auto result = std::to_chars(p, p + NUMBER_SPACE, value, std::chars_format::fixed,
+                                decimals < 0 ? 0 : decimals > 17 ? 17 : decimals);
+    if (result.ec != std::errc())
+    {
+        result = std::to_chars(p, p + NUMBER_SPACE, value);
+    }
+    m_pos = result.ptr;
+}
+
+void JsonWriter::Raw(std::string_view json)
+{
+    Comma();
+    Write(json.data(), json.size());
+}
+
+void JsonWriter::Write(const char* data, size_t size)
+{
+    for (;;)
+    {
+        size_t room = static_cast<size_t>(m_buffer + BUFFER - m_pos);
+        if (size <= room)
+        {
+            memcpy(m_pos, data, size);
+            m_pos += size;
+            return;
+        }
+        memcpy(m_pos, data, room);
+        m_pos += room;
+        data += room;
+        size -= room;
+        Flush();
+    }
+}
+
+// Clean runs are copied whole; only the bytes that need it are looked at one by one
+//
+void JsonWriter::Quoted(std::string_view s)
+{
+    Put('"');
+    const char* p = s.data();
+    size_t n = s.size();
+    for (;;)
+    {
+        size_t run = detail::FindJsonEscape(p, n);
+        Write(p, run);
+        if (run == n)
+        {
+            break;
+        }
+
+        char* out = Reserve(NUMBER_SPACE);
+        auto c = static_cast<unsigned char>(p[run]);
+        out[0] = '\\';
+        if (c == '"' || c == '\\')
+        {
+            out[1] = static_cast<char>(c);
+            m_pos = out + 2;
+        }
+        else if (SHORT_ESCAPE[c])
+        {
+            out[1] = SHORT_ESCAPE[c];
+            m_pos = out + 2;
+        }
+        else
+        {
+            memcpy(out + 1, "u00", 3);
+            out[4] = HEX[c >> 4];
+            out[5] = HEX[c & 0xf];
+            m_pos = out + 6;
+        }
+        p += run + 1;
+        n -= run + 1;
+    }
+    Put('"');
+}
+
+// The buffer is full (or about to be): it goes out, and is empty again whatever happened
+//
+void JsonWriter::Flush()
+{
+    const size_t size = static_cast<size_t>(m_pos - m_buffer);
+    m_pos = m_buffer;
+    if (m_out)
+    {
+        m_out->append(m_buffer, size);
+        return;
+    }
+    if (m_failed)
+    {
+        return;
+    }
+    if (!m_chunked)
+    {
+        m_chunked = true;
+        if (!m_conn->BeginChunked(m_status, m_contentType))
+        {
+            m_failed = true;
+            return;
+        }
+    }
+    if (!m_conn->SendChunk(m_buffer, size))
+    {
+        m_failed = true;
+    }
+}
+
+bool JsonWriter::Finish()
+{
+    assert(m_depth == 0);
+    const size_t size = static_cast<size_t>(m_pos - m_buffer);
+    m_pos = m_buffer;
+    if (m_out)
+    {
+        m_out->append(m_buffer, size);
+        return true;
+    }
+    if (m_failed)
+    {
+        return false;
+    }
+    m_failed = !(m_chunked ? m_conn->EndChunked(m_buffer, size)
+                           : m_conn->Send(m_status, m_contentType, m_buffer, size));
+    return !m_failed;
+}
+
+} // end namespace coop::http
+} // end namespace coop
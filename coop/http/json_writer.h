@@ -0,0 +1,170 @@
+#pragma once
+
+// Streaming JSON output, into a response or a string.
+//
+//   void HandleUser(coop::http::ConnectionBase& conn)
+//   {
+//       coop::http::JsonWriter w(conn);
+//       w.BeginObject();
+//       w.Key("id");
+//       w.UInt(user.id);
+//       w.Key("name");
+//       w.String(user.name);
+//       w.Key("tags");
+//       w.BeginArray();
+//       for (auto const& tag : user.tags) w.String(tag);
+//       w.EndArray();
+//       w.EndObject();
+//       w.Finish();
+//   }
+//
+// The writer formats into a fixed buffer of its own (BUFFER bytes, on the caller's stack) and
+// allocates nothing. A document that fits goes out at Finish as one Content-Length response,
+// the buffer gathered behind the headers (ConnectionBase::Send), so its bytes are written once
+// and never copied. The first time the buffer fills, the response turns chunked: BeginChunked,
+// then one SendChunk per buffer, and Finish sends the rest as the last chunk. There is no
+// intermediate std::string at any size.
+//
+// Strings are escaped as JSON requires -- '"', '\\' and the control characters, the common ones
+// as \n, \t and so on and the rest as \u00XX -- with runs between them found by the vector scan
+// in scan.h (detail::FindJsonEscape) and copied whole. Other bytes, UTF-8 included, pass as is.
+// Numbers go through std::to_chars: doubles as the shortest form that reads back exactly, or with
+// fixed decimals; NaN and the infinities, which JSON cannot carry, as null.
+//
+// Commas are the writer's: values and keys are written in order and it separates them. It does
+// not check the document's shape beyond nesting depth (MAX_DEPTH, asserted).
+//
+// A failed send stops output: later calls write nothing and Finish returns false. The writer
+// is the response, so nothing else may be sent on the connection between the first write and
+// Finish.
+//
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace coop
+{
+namespace http
+{
+
+struct ConnectionBase;
+
+struct JsonWriter
+{
+    static constexpr int MAX_DEPTH = 32;
+    static constexpr size_t BUFFER = 2048;
+
+    // The response on conn, sent from Finish (or chunked from the first full buffer)
+    //
+    explicit JsonWriter(ConnectionBase& conn, int status = 200,
+                        const char* contentType = "application/json");
+
+    // Appended to out, a buffer at a time and the rest at Finish
+    //
+    explicit JsonWriter(std::string& out);
+
+    JsonWriter(JsonWriter const&) = delete;
+    JsonWriter& operator=(JsonWriter const&) = delete;
+
+    void BeginObject() { Open('{'); }
+    void EndObject() { Close('}'); }
+    void BeginArray() { Open('['); }
+    void EndArray() { Close(']'); }
+
+    // The key of the next value in an object
+    //
+    void Key(std::string_view key);
+
+    void String(std::string_view value);
+    void Int(int64_t value);
+    void UInt(uint64_t value);
+    void Bool(bool value) { Comma(); Write(value ? "true" : "false", value ? 4 : 5); }
+    void Null() { Comma(); Write("null", 4); }
+
+    // Shortest round trip, or fixed decimals (at most 17)
+    //
+    void Double(double value);
+    void Double(double value, int decimals);
+
+    // A value serialized elsewhere, written as is
+    //
+    void Raw(std::string_view json);
+
+    // Send the response (connection) or append what is buffered (string). Once, after the last
+    // value; false when a send failed, now or earlier.
+    //
+    bool Finish();
+
+    bool Failed() const { return m_failed; }
+    bool Chunked() const { return m_chunked; }
+
+  private:
+    // Room for the longest number to_chars writes and the longest escape (\u00XX)
+    //
+    static constexpr size_t NUMBER_SPACE = 32;
+
+    void Comma()
+    {
+        if (!m_first[m_depth])
+        {
+            Put(',');
+        }
+        m_first[m_depth] = false;
+    }
+
+    void Open(char c)
+    {
+        assert(m_depth + 1 < MAX_DEPTH);
+        Comma();
+        Put(c);
+        m_first[++m_depth] = true;
+    }
+
+    void Close(char c)
+    {
+        assert(m_depth > 0);
+        m_depth--;
+        Put(c);
+    }
+
+    void Put(char c)
+    {
+        if (m_pos == m_buffer + BUFFER)
+        {
+            Flush();
+        }
+        *m_pos++ = c;
+    }
+
+    // At least size bytes free at the returned position, size <= NUMBER_SPACE
+    //
+    char* Reserve(size_t size)
+    {
+        if (static_cast<size_t>(m_buffer + BUFFER - m_pos) < size)
+        {
+            Flush();
+        }
+        return m_pos;
+    }
+
+    void Write(const char* data, size_t size);
+    void Quoted(std::string_view s);
+    void Flush();
+
+    ConnectionBase* m_conn = nullptr;
+    std::string*    m_out = nullptr;
+    int             m_status = 200;
+    const char*     m_contentType = nullptr;
+    bool            m_chunked = false;
+    bool            m_failed = false;
+    int             m_depth = 0;
+    bool            m_first[MAX_DEPTH];
+    char*           m_pos = m_buffer;
+    char            m_buffer[BUFFER];
+};
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,423 @@
+#include "metrics.h"
+#include "connection.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "coop/cooperator.h"
+#include "coop/io/buffer_ring.h"
+#include "coop/io/buffer_ring_set.h"
+#include "coop/io/uring.h"
+#include "coop/perf/counters.h"
+#include "coop/perf/histogram.h"
+#include "coop/sharded_counter.h"
+#include "coop/stack_pool.h"
+
+namespace coop
+{
+namespace http
+{
+
+namespace
+{
+
+struct RingSnapshot
+{
+    uint16_t group;
+    uint32_t entries;
+    uint32_t bufSize;
+    uint32_t inUse;
+};
+
+struct CooperatorSnapshot
+{
+    std::string name;
+    size_t contexts;
+    size_t runnable;
+    size_t blocked;
+    uint64_t stalls;
+    uint64_t preemptions;
+    int64_t startupNs;
+    StackPool::Stats stackPool;
+    std::vector<RingSnapshot> rings;
+    io::Uring::RingStatistics uring;
+    uint32_t sqEntries;
+    std::vector<uint64_t> sharded;      // ShardedCounter / ShardedGauge slots, in registry order
+#if COOP_PERF_MODE > 0
+    perf::Counters counters;
+    perf::Histograms histograms;
+#endif
+};
+
+using Snapshots = std::vector<std::unique_ptr<CooperatorSnapshot>>;
+
+RingSnapshot SnapshotRing(io::BufferRing const* ring)
+{
+    return RingSnapshot{ring->Group(), ring->Entries(), ring->BufSize(), ring->InUse()};
+}
+
+// Copy everything the exposition needs in one registry visit, rendering nothing: an exiting
+// cooperator waits for the visit, which is a few copies per cooperator
+//
+Snapshots TakeSnapshots()
+{
+    Snapshots snapshots;
+    Cooperator::VisitRegistry([&](Cooperator* co) -> bool
+    {
+        auto s = std::make_unique<CooperatorSnapshot>();
+        s->name = co->GetName();
+        if (s->name.empty())
+        {
+            s->name = "cooperator-" + std::to_string(snapshots.size());
+        }
+        s->contexts = co->ContextsCount();
+        s->runnable = co->YieldedCount();
+        s->blocked = co->BlockedCount();
+        s->stalls = co->Stalls();
+        s->preemptions = co->Preemptions();
+        s->startupNs = co->StartupNanos();
+        s->stackPool = co->GetStackPoolStats();
+
+        auto* uring = co->GetUring();
+        s->uring = uring->GetRingStatistics();
+        s->sqEntries = uring->SqEntries();
+        if (auto* ring = uring->GetBufferRing())
+        {
+            s->rings.push_back(SnapshotRing(ring));
+        }
+        if (auto* set = uring->GetBufferRingSet())
+        {
+            for (int i = 0; i < set->Count(); i++)
+            {
+                s->rings.push_back(SnapshotRing(set->Class(i)));
+            }
+        }
+
+        size_t metrics = coop::detail::ShardedMetricRegistry::Instance().Count();
+        for (size_t slot = 0; slot < metrics; slot++)
+        {
+            s->sharded.push_back(coop::detail::ShardedLocal(slot, co));
+        }
+
+#if COOP_PERF_MODE > 0
+        s->counters = co->GetPerfCounters();
+        s->histograms = co->GetPerfHistograms();
+#endif
+        snapshots.push_back(std::move(s));
+        return true;
+    });
+    return snapshots;
+}
+
+// ---- Text exposition ----
+
+// Metric names allow [a-zA-Z0-9_:]; user .def display names may carry anything else
+//
+void AppendMetricName(std::string& out, std::string_view name)
+{
+    for (char c : name)
+    {
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+            || c == '_' || c == ':';
+        out += ok ? c : '_';
+    }
+}
+
+void AppendLabelValue(std::string& out, std::string_view value)
+{
+    for (char c : value)
+    {
+        switch (c)
+        {
+            case '\\': out += "\\\\"; break;
+            case '"':  out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            default:   out += c; break;
+        }
+    }
+}
+
+void AppendDouble(std::string& out, double value)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", value);
+    out += buf;
+}
+
+// "# TYPE" and "# HELP" lines opening a metric family; every sample of the family follows
+//
+void BeginFamily(std::string& out, std::string_view family, const char* type, const char* help)
+{
+    out += "# TYPE ";
+    out += family;
+    out += ' ';
+    out += type;
+    out += "\n# HELP ";
+    out += family;
+    out += ' ';
+    out += help;
+    out += '\n';
+}
+
+// One sample's name and label set: family + suffix{cooperator="...",extra}, then a space
+//
+void BeginSample(std::string& out, std::string_view family, const char* suffix,
+                 CooperatorSnapshot const& s, std::string_view extra = {})
+{
+    out += family;
+    out += suffix;
+    out += "{cooperator=\"";
+    AppendLabelValue(out, s.name);
+    out += '"';
+    if (!extra.empty())
+    {
+        out += ',';
+        out += extra;
+    }
+    out += "} ";
+}
+
+void Sample(std::string& out, std::string_view family, const char* suffix,
+            CooperatorSnapshot const& s, uint64_t value, std::string_view extra = {})
+{
+    BeginSample(out, family, suffix, s, extra);
+    out += std::to_string(value);
+    out += '\n';
+}
+
+// A gauge or counter family with one value per cooperator
+//
+template<typename Fn>
+void PerCooperator(std::string& out, Snapshots const& snapshots, const char* family,
+                   const char* type, const char* help, Fn const& value)
+{
+    BeginFamily(out, family, type, help);
+    const char* suffix = std::string_view(type) == "counter" ? "_total" : "";
+    for (auto const& s : snapshots)
+    {
+        Sample(out, family, suffix, *s, value(*s));
+    }
+}
+
+#if COOP_PERF_MODE > 0
+
+void AppendCounters(std::string& out, Snapshots const& snapshots)
+{
+    for (size_t i = 0; i < static_cast<size_t>(perf::Counter::COUNT); i++)
+    {
+        auto c = static_cast<perf::Counter>(i);
+        std::string family = "coop_";
+        AppendMetricName(family, perf::CounterName(c));
+        BeginFamily(out, family, "counter", "coop perf counter");
+        for (auto const& s : snapshots)
+        {
+            Sample(out, family, "_total", *s, s->counters.Get(c));
+        }
+    }
+}
+
+// Each histogram as cumulative buckets at every power of two -- the top of each group of
+// sub-buckets, 38 boundaries -- which keeps the exposition small while the JSON API still serves
+// the exact quantiles. Nanosecond histograms (a "_ns" name) are exported in seconds.
+//
+void AppendHistograms(std::string& out, Snapshots const& snapshots)
+{
+    using perf::Histogram;
+
+    for (size_t i = 0; i < static_cast<size_t>(perf::Hist::COUNT); i++)
+    {
+        auto h = static_cast<perf::Hist>(i);
+        std::string_view name = perf::HistName(h);
+        double scale = 1.0;
+        std::string family = "coop_";
+        if (name.size() > 3 && name.substr(name.size() - 3) == "_ns")
+        {
+            AppendMetricName(family, name.substr(0, name.size() - 3));
+            family += "_seconds";
+            scale = 1e-9;
+        }
+        else
+        {
+            AppendMetricName(family, name);
+        }
+
+        BeginFamily(out, family, "histogram", "coop perf latency histogram");
+        for (auto const& s : snapshots)
+        {
+            Histogram const& hist = s->histograms.Get(h);
+            uint64_t cumulative = 0;
+            size_t next = 0;
+            for (size_t b = Histogram::kSubBuckets - 1; b + 1 < Histogram::kBuckets;
+                 b += Histogram::kSubBuckets)
+            {
+                for (; next <= b; next++)
+                {
+                    cumulative += hist.buckets[next];
+                }
+                std::string le = "le=\"";
+                AppendDouble(le, static_cast<double>(Histogram::BucketHigh(b)) * scale);
+                le += '"';
+                Sample(out, family, "_bucket", *s, cumulative, le);
+            }
+            Sample(out, family, "_bucket", *s, hist.count, "le=\"+Inf\"");
+            Sample(out, family, "_count", *s, hist.count);
+            BeginSample(out, family, "_sum", *s);
+            AppendDouble(out, static_cast<double>(hist.sum) * scale);
+            out += '\n';
+        }
+    }
+}
+
+#endif
+
+void AppendContexts(std::string& out, Snapshots const& snapshots)
+{
+    BeginFamily(out, "coop_contexts", "gauge", "Contexts by scheduler state");
+    for (auto const& s : snapshots)
+    {
+        Sample(out, "coop_contexts", "", *s, s->contexts, "state=\"live\"");
+        Sample(out, "coop_contexts", "", *s, s->runnable, "state=\"runnable\"");
+        Sample(out, "coop_contexts", "", *s, s->blocked, "state=\"blocked\"");
+    }
+    PerCooperator(out, snapshots, "coop_stalls", "counter",
+                  "Context slices the stall watchdog reported (perf/watchdog.h)",
+                  [](CooperatorSnapshot const& s) { return s.stalls; });
+    PerCooperator(out, snapshots, "coop_preemptions", "counter",
+                  "MaybeYield calls that yielded an expired time slice (preempt.h)",
+                  [](CooperatorSnapshot const& s) { return s.preemptions; });
+    PerCooperator(out, snapshots, "coop_startup_microseconds", "gauge",
+                  "Time Launch took to pin and prewarm the cooperator and set up its ring",
+                  [](CooperatorSnapshot const& s) -> uint64_t { return s.startupNs / 1000; });
+}
+
+void AppendStackPool(std::string& out, Snapshots const& snapshots)
+{
+    using Snap = CooperatorSnapshot;
+    PerCooperator(out, snapshots, "coop_stack_pool_cached_stacks", "gauge",
+                  "Stack segments cached for reuse",
+                  [](Snap const& s) { return s.stackPool.cached; });
+    PerCooperator(out, snapshots, "coop_stack_pool_cached_bytes", "gauge",
+                  "Bytes of cached stack segments",
+                  [](Snap const& s) { return s.stackPool.totalBytes; });
+    PerCooperator(out, snapshots, "coop_stack_pool_arena_bytes", "gauge",
+                  "Bytes of huge-page stack arenas",
+                  [](Snap const& s) { return s.stackPool.arenaBytes; });
+    PerCooperator(out, snapshots, "coop_stack_pool_hits", "counter",
+                  "Stack allocations served from the cache",
+                  [](Snap const& s) { return s.stackPool.hits; });
+    PerCooperator(out, snapshots, "coop_stack_pool_misses", "counter",
+                  "Stack allocations that mapped a new segment",
+                  [](Snap const& s) { return s.stackPool.misses; });
+    PerCooperator(out, snapshots, "coop_stack_pool_trimmed", "counter",
+                  "Cached stack segments released by idle or pressure trimming",
+                  [](Snap const& s) { return s.stackPool.trimmed; });
+}
+
+void AppendUring(std::string& out, Snapshots const& snapshots)
+{
+    using Snap = CooperatorSnapshot;
+    PerCooperator(out, snapshots, "coop_uring_sq_entries", "gauge",
+                  "Submission queue entries of the cooperator's ring",
+                  [](Snap const& s) -> uint64_t { return s.sqEntries; });
+    PerCooperator(out, snapshots, "coop_uring_sq_full", "counter",
+                  "SQE requests that found the submission queue full",
+                  [](Snap const& s) { return s.uring.sqFull; });
+    PerCooperator(out, snapshots, "coop_uring_cq_overflow", "counter",
+                  "Polls that found completions on the kernel's CQ overflow list",
+                  [](Snap const& s) { return s.uring.cqOverflow; });
+    PerCooperator(out, snapshots, "coop_uring_resizes", "counter",
+                  "Ring growths under submission or completion pressure",
+                  [](Snap const& s) { return s.uring.resizes; });
+}
+
+void AppendBufferRings(std::string& out, Snapshots const& snapshots)
+{
+    struct Field
+    {
+        const char* family;
+        const char* help;
+        uint64_t (*value)(RingSnapshot const&);
+    };
+    static const Field s_fields[] = {
+        {"coop_buffer_ring_buffers", "Buffers in the provided buffer ring",
+         [](RingSnapshot const& r) -> uint64_t { return r.entries; }},
+        {"coop_buffer_ring_buffers_in_use", "Buffers delivered to the application, not returned",
+         [](RingSnapshot const& r) -> uint64_t { return r.inUse; }},
+        {"coop_buffer_ring_buffer_bytes", "Size of each buffer in the ring",
+         [](RingSnapshot const& r) -> uint64_t { return r.bufSize; }},
+    };
+
+    for (auto const& field : s_fields)
+    {
+        BeginFamily(out, field.family, "gauge", field.help);
+        for (auto const& s : snapshots)
+        {
+            for (auto const& ring : s->rings)
+            {
+                std::string group = "group=\"" + std::to_string(ring.group) + '"';
+                Sample(out, field.family, "", *s, field.value(ring), group);
+            }
+        }
+    }
+}
+
+// Application ShardedCounters and ShardedGauges, under the names they were declared with
+//
+void AppendSharded(std::string& out, Snapshots const& snapshots)
+{
+    auto const& registry = coop::detail::ShardedMetricRegistry::Instance();
+    size_t metrics = registry.Count();
+    for (size_t slot = 0; slot < metrics; slot++)
+    {
+        auto const& entry = registry.At(slot);
+        std::string family;
+        AppendMetricName(family, entry.name);
+        BeginFamily(out, family, entry.gauge ? "gauge" : "counter", entry.help);
+        for (auto const& s : snapshots)
+        {
+            if (slot >= s->sharded.size())
+            {
+                continue;
+            }
+            uint64_t value = s->sharded[slot];
+            BeginSample(out, family, entry.gauge ? "" : "_total", *s);
+            out += entry.gauge ? std::to_string(static_cast<int64_t>(value))
+                               : std::to_string(value);
+            out += '\n';
+        }
+    }
+}
+
+} // end anonymous namespace
+
+std::string GenerateOpenMetrics()
+{
+    Snapshots snapshots = TakeSnapshots();
+
+    std::string out;
+    out.reserve(snapshots.size() * 16384 + 256);
+#if COOP_PERF_MODE > 0
+    AppendCounters(out, snapshots);
+    AppendHistograms(out, snapshots);
+#endif
+    AppendContexts(out, snapshots);
+    AppendStackPool(out, snapshots);
+    AppendUring(out, snapshots);
+    AppendBufferRings(out, snapshots);
+    AppendSharded(out, snapshots);
+    out += "# EOF\n";
+    return out;
+}
+
+void HandleMetrics(ConnectionBase& conn)
+{
+    std::string body = GenerateOpenMetrics();
+    conn.Send(200, "application/openmetrics-text; version=1.0.0; charset=utf-8", body);
+}
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+namespace coop
+{
+namespace http
+{
+
+struct ConnectionBase;
+
+// Prometheus / OpenMetrics exposition of the runtime's metrics, served at /metrics by the status
+// routes. Every live cooperator (Cooperator::VisitRegistry) contributes one label set, keyed by
+// cooperator="<CooperatorConfiguration::name>" (or "cooperator-<n>" in registry order when it has
+// none):
+//
+//   coop_<counter>_total               every perf::Counter, user .def counters included (mode > 0)
+//   coop_<histogram>_seconds           every perf::Hist as an OpenMetrics histogram (mode > 0)
+//   coop_contexts{state=...}           live, runnable and blocked context counts
+//   coop_startup_microseconds          how long Launch took to make the cooperator ready
+//   coop_stack_pool_*                  StackPool occupancy and hit/miss/trim totals
+//   coop_buffer_ring_*{group=...}      provided buffer ring size and buffers in use, per group
+//   <name>_total, <name>               every ShardedCounter and ShardedGauge (sharded_counter.h)
+//
+// The whole registry is snapshotted first -- plain copies of words each cooperator's thread
+// writes, as /api/cooperators/perf reads them -- and the text rendered from the copies, so a
+// scrape never takes anything a cooperator waits on.
+//
+std::string GenerateOpenMetrics();
+
+void HandleMetrics(ConnectionBase& conn);
+
+} // end namespace coop::http
+} // end namespace coop
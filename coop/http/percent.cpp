@@ -0,0 +1,81 @@
+#include "percent.h"
+
+#include <cstring>
+
+#include "scan.h"
+
+namespace coop
+{
+namespace http
+{
+
+namespace
+{
+
+// The escape at data[i] ('%' or '+'), written at data[out]; returns the input bytes it took
+//
+size_t DecodeOne(char* data, size_t size, size_t i, size_t out)
+{
+    if (data[i] == '+')
+    {
+        data[out] = ' ';
+        return 1;
+    }
+    if (i + 2 < size)
+    {
+        int high = detail::HexDigitValue(data[i + 1]);
+        int low = detail::HexDigitValue(data[i + 2]);
+        if (high >= 0 && low >= 0)
+        {
+            data[out] = static_cast<char>(high << 4 | low);
+            return 3;
+        }
+    }
+    data[out] = '%';
+    return 1;
+}
+
+} // end anonymous namespace
+
+// Nothing moves until the first escape; from there each clean run moves up behind the output
+//
+size_t PercentDecode(char* data, size_t size, bool plusAsSpace /* = true */)
+{
+    const char plus = plusAsSpace ? '+' : '%';
+    size_t in = detail::FindFirstOf(data, size, '%', plus, '%', '%');
+    size_t out = in;
+    while (in < size)
+    {
+        in += DecodeOne(data, size, in, out++);
+        size_t run = detail::FindFirstOf(data + in, size - in, '%', plus, '%', '%');
+        memmove(data + out, data + in, run);
+        in += run;
+        out += run;
+    }
+    return out;
+}
+
+namespace detail
+{
+
+size_t PercentDecodeScalar(char* data, size_t size, bool plusAsSpace)
+{
+    size_t out = 0;
+    for (size_t in = 0; in < size;)
+    {
+        if (data[in] == '%' || (plusAsSpace && data[in] == '+'))
+        {
+            in += DecodeOne(data, size, in, out++);
+        }
+        else
+        {
+            data[out++] = data[in++];
+        }
+    }
+    return out;
+}
+
+} // end namespace coop::http::detail
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,57 @@
+#pragma once
+
+// Percent-decoding (RFC 3986 2.1) for query args and form bodies, in place.
+//
+//   while (auto* name = conn.NextArgName())
+//   {
+//       if (auto* value = conn.ReadArgValue())
+//       {
+//           coop::http::PercentDecode(value);     // "a%20b+c" -> "a b c"
+//           ...
+//       }
+//   }
+//
+// Arg values and bodies reach handlers as the client sent them; decoding is the handler's
+// choice, done where the bytes already are since it only ever shortens them. Runs with nothing
+// to decode are found with the vector scan in scan.h (detail::FindFirstOf on '%' and '+') and
+// moved whole, so a mostly plain value costs about a memmove. '+' is a space in
+// application/x-www-form-urlencoded data, query strings included; pass plusAsSpace false for
+// paths and other strict RFC 3986 input. A '%' not followed by two hex digits stays as it is.
+//
+// An element spanning receives arrives in several Chunks (complete false), and one may end
+// inside an escape: collect such values and decode them whole.
+//
+
+#include <cstddef>
+
+#include "types.h"
+
+namespace coop
+{
+namespace http
+{
+
+// The decoded size; data[0, size) is rewritten
+//
+size_t PercentDecode(char* data, size_t size, bool plusAsSpace = true);
+
+// A chunk from ReadArgValue, ReadHeaderValue or ReadBody, decoded where it sits in the
+// connection's buffer; chunk->size becomes the decoded size
+//
+inline void PercentDecode(Chunk* chunk, bool plusAsSpace = true)
+{
+    chunk->size = PercentDecode(static_cast<char*>(const_cast<void*>(chunk->data)), chunk->size,
+                                plusAsSpace);
+}
+
+namespace detail
+{
+
+// The byte loop PercentDecode is checked and measured against
+//
+size_t PercentDecodeScalar(char* data, size_t size, bool plusAsSpace);
+
+} // end namespace coop::http::detail
+
+} // end namespace coop::http
+} // end namespace coop
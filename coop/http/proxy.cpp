@@ -0,0 +1,462 @@
+#include "proxy.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <strings.h>
+#include <unordered_map>
+#include <vector>
+
+#include "client_pool.h"
+#include "connection.h"
+#include "coop/cooperator_var.h"
+#include "coop/cooperator_var.hpp"
+#include "coop/deadline_scope.h"
+#include "coop/self.h"
+#include "coop/time/now.h"
+
+namespace coop
+{
+namespace http
+{
+
+namespace
+{
+
+struct UpstreamState
+{
+    ProxyUpstreamStats  stats;
+    uint32_t            failures = 0;       // in a row
+    int64_t             ejectedUntil = 0;   // time::NowCoarse
+};
+
+// Per cooperator, per proxy: each cooperator balances over its own pool's connections
+//
+struct ProxyState
+{
+    std::vector<UpstreamState>  upstreams;
+    size_t                      cursor = 0;     // where the next pick starts scanning
+};
+
+CooperatorVar<std::unordered_map<Proxy const*, ProxyState>> s_proxies;
+
+ProxyState& LocalState(Proxy const* proxy)
+{
+    auto& state = (*s_proxies)[proxy];
+    if (state.upstreams.empty())
+    {
+        state.upstreams.resize(proxy->Options().upstreamCount);
+    }
+    return state;
+}
+
+// The request as it goes upstream, copied out of the connection: its views do not survive the
+// body reads
+//
+struct Request
+{
+    std::string method;
+    std::string target;
+    std::string headers;
+    std::string host;
+    int64_t     length = 0;
+    bool        chunked = false;
+    bool        head = false;
+};
+
+struct Exchange
+{
+    bool bodyTaken = false;         // some of the request body has been read: no retry
+    bool responseBegun = false;     // the client has been sent something
+};
+
+enum class Result
+{
+    OK,
+    UPSTREAM,       // no connection, the request not sent, or no response: counts against it
+    BROKEN,         // failed after the response line, or moving the request body
+};
+
+bool IsName(const char* name, const char* expected)
+{
+    return strcasecmp(name, expected) == 0;
+}
+
+// Not forwarded either way (RFC 9110 7.6.1), or written by the proxy itself
+//
+bool IsHopByHop(const char* name)
+{
+    static const char* const s_names[] = {
+        "connection", "keep-alive", "proxy-connection", "te", "trailer", "transfer-encoding",
+        "upgrade", "content-length",
+    };
+    for (const char* hop : s_names)
+    {
+        if (IsName(name, hop))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename Conn>
+void AppendValue(Conn& conn, std::string* out)
+{
+    while (Chunk* value = conn.ReadHeaderValue())
+    {
+        out->append(static_cast<const char*>(value->data), value->size);
+        if (value->complete)
+        {
+            break;
+        }
+    }
+}
+
+// The header name comes first: a value spanning recvs may compact the buffer the name is in
+//
+template<typename Conn>
+void AppendHeader(Conn& conn, const char* name, std::string* out)
+{
+    out->append(name);
+    out->append(": ");
+    AppendValue(conn, out);
+    out->append("\r\n");
+}
+
+void ReadRequest(ConnectionBase& conn, RequestLine const& line, Request* request)
+{
+    request->method.assign(line.method);
+    request->head = line.method == "HEAD";
+    request->target.assign(line.path);
+    if (!line.query.empty())
+    {
+        request->target += '?';
+        request->target.append(line.query);
+    }
+
+    conn.SkipArgs();
+    while (const char* name = conn.NextHeaderName())
+    {
+        if (name[0] == ':' || IsName(name, "expect") || IsName(name, "traceparent"))
+        {
+            conn.SkipHeaderValue();
+        }
+        else if (IsName(name, "host"))
+        {
+            AppendValue(conn, &request->host);
+        }
+        else if (IsName(name, "transfer-encoding"))
+        {
+            std::string value;
+            AppendValue(conn, &value);
+            request->chunked = strcasestr(value.c_str(), "chunked") != nullptr;
+        }
+        else if (IsHopByHop(name))
+        {
+            conn.SkipHeaderValue();
+        }
+        else
+        {
+            AppendHeader(conn, name, &request->headers);
+        }
+    }
+    request->length = request->chunked ? -1 : conn.ContentLength();
+}
+
+template<typename Lease>
+bool SendRequest(ConnectionBase& conn, Lease& lease, Request const& request, bool preserveHost,
+                 Exchange* exchange, Result* result)
+{
+    std::string_view host = preserveHost ? std::string_view(request.host) : std::string_view();
+    if (!lease->SendRequestHead(request.method.c_str(), request.target, request.headers,
+                                request.length, host))
+    {
+        *result = Result::UPSTREAM;
+        return false;
+    }
+    if (!request.chunked && request.length <= 0)
+    {
+        return true;
+    }
+
+    exchange->bodyTaken = true;
+    *result = Result::BROKEN;
+    auto& transport = lease->m_transport;
+    if (!request.chunked && transport.CanSpliceInto())
+    {
+        return conn.ReceiveBodyToFile(transport.Descriptor()) == request.length;
+    }
+
+    int64_t sent = 0;
+    while (Chunk* chunk = conn.ReadBody())
+    {
+        if (!lease->SendBody(chunk->data, chunk->size))
+        {
+            return false;
+        }
+        sent += static_cast<int64_t>(chunk->size);
+    }
+    return (request.chunked || sent == request.length) && lease->EndBody();
+}
+
+template<typename Lease>
+Result RelayBody(ConnectionBase& conn, Lease& lease, int status, const char* contentType)
+{
+    if (lease->ChunkedBody())
+    {
+        if (!conn.BeginChunked(status, contentType))
+        {
+            return Result::BROKEN;
+        }
+        while (Chunk* chunk = lease->ReadBody())
+        {
+            if (!conn.SendChunk(chunk->data, chunk->size))
+            {
+                return Result::BROKEN;
+            }
+        }
+        return lease->BodyComplete() && conn.EndChunked() ? Result::OK : Result::BROKEN;
+    }
+
+    const size_t length = static_cast<size_t>(lease->ContentLength());
+    if (!conn.SendHeaders(status, contentType, length))
+    {
+        return Result::BROKEN;
+    }
+
+    // What came in with the headers is copied; the rest goes straight from socket to socket
+    //
+    size_t sent = 0;
+    while (sent < length)
+    {
+        Chunk* chunk = lease->ReadBufferedBody();
+        if (!chunk)
+        {
+            break;
+        }
+        if (!conn.SendRawBytes(chunk->data, chunk->size))
+        {
+            return Result::BROKEN;
+        }
+        sent += chunk->size;
+    }
+
+    auto& transport = lease->m_transport;
+    if (sent < length && transport.CanSplice())
+    {
+        const size_t n = static_cast<size_t>(conn.SendBodyFrom(transport.Descriptor(),
+                                                               length - sent));
+        lease->MarkBodyRead(n);
+        return sent + n == length ? Result::OK : Result::BROKEN;
+    }
+    while (sent < length)
+    {
+        Chunk* chunk = lease->ReadBody();
+        if (!chunk || !conn.SendRawBytes(chunk->data, chunk->size))
+        {
+            return Result::BROKEN;
+        }
+        sent += chunk->size;
+    }
+    return Result::OK;
+}
+
+template<typename Lease>
+Result Relay(ConnectionBase& conn, Lease lease, Request const& request, bool preserveHost,
+             Exchange* exchange)
+{
+    if (!lease)
+    {
+        return Result::UPSTREAM;
+    }
+
+    Result result = Result::OK;
+    if (!SendRequest(conn, lease, request, preserveHost, exchange, &result))
+    {
+        lease.Discard();
+        return result;
+    }
+
+    auto* line = lease->GetResponseLine();
+    if (!line)
+    {
+        lease.Discard();
+        return Result::UPSTREAM;
+    }
+    const int status = line->status;
+
+    std::string headers;
+    std::string contentType;
+    while (const char* name = lease->NextHeaderName())
+    {
+        if (IsName(name, "content-type"))
+        {
+            AppendValue(*lease, &contentType);
+        }
+        else if (IsHopByHop(name) || IsName(name, "date"))
+        {
+            lease->SkipHeaderValue();
+        }
+        else
+        {
+            AppendHeader(*lease, name, &headers);
+        }
+    }
+
+    exchange->responseBegun = true;
+    conn.SetResponseHeaders(headers);
+    const char* type = contentType.empty() ? "application/octet-stream" : contentType.c_str();
+
+    if (request.head || status < 200 || status == 204 || status == 304)
+    {
+        const int64_t length = status == 204 ? 0 : lease->ContentLength();
+        lease->EndWithoutBody();
+        result = conn.SendHeaders(status, type, static_cast<size_t>(length))
+            ? Result::OK : Result::BROKEN;
+    }
+    else
+    {
+        result = RelayBody(conn, lease, status, type);
+    }
+    conn.SetResponseHeaders({});
+
+    if (result != Result::OK)
+    {
+        lease.Discard();
+    }
+    return result;
+}
+
+// Least outstanding among the upstreams in rotation and not tried yet, scanning from a cursor
+// that moves on each pick so ties rotate. With none in rotation, the untried one whose ejection
+// ends first.
+//
+size_t Pick(std::vector<UpstreamState> const& states, std::vector<bool> const& tried,
+            size_t* cursor, int64_t now)
+{
+    const size_t count = states.size();
+    size_t best = count;
+    size_t fallback = count;
+    for (size_t k = 0; k < count; k++)
+    {
+        size_t i = (*cursor + k) % count;
+        if (tried[i])
+        {
+            continue;
+        }
+        auto const& state = states[i];
+        if (state.ejectedUntil > now)
+        {
+            if (fallback == count || state.ejectedUntil < states[fallback].ejectedUntil)
+            {
+                fallback = i;
+            }
+            continue;
+        }
+        if (best == count || state.stats.outstanding < states[best].stats.outstanding)
+        {
+            best = i;
+        }
+    }
+    *cursor = (*cursor + 1) % count;
+    return best < count ? best : fallback;
+}
+
+} // end anonymous namespace
+
+Proxy::Proxy(ProxyOptions const& options)
+: m_options(options)
+{
+}
+
+void Proxy::Forward(ConnectionBase& conn)
+{
+    auto* line = conn.GetRequestLine();
+    if (!line)
+    {
+        return;
+    }
+    std::optional<DeadlineScope> deadline;
+    if (m_options.timeout.count() > 0)
+    {
+        deadline.emplace(Self(), m_options.timeout);
+    }
+
+    Request request;
+    ReadRequest(conn, *line, &request);
+
+    auto& local = LocalState(this);
+    auto& states = local.upstreams;
+    auto& pool = ClientPool::Local();
+    std::vector<bool> tried(states.size(), false);
+    Exchange exchange;
+
+    const size_t attempts = std::min(std::max<size_t>(m_options.attempts, 1), states.size());
+    for (size_t attempt = 0; attempt < attempts; attempt++)
+    {
+        const int64_t now = time::NowCoarse();
+        const size_t i = Pick(states, tried, &local.cursor, now);
+        if (i >= states.size())
+        {
+            break;
+        }
+        tried[i] = true;
+
+        auto& state = states[i];
+        auto const& upstream = m_options.upstreams[i];
+        state.stats.outstanding++;
+        Result result = upstream.tls
+            ? Relay(conn, pool.CheckoutTls(upstream.host, upstream.port), request,
+                    m_options.preserveHost, &exchange)
+            : Relay(conn, pool.Checkout(upstream.host, upstream.port), request,
+                    m_options.preserveHost, &exchange);
+        state.stats.outstanding--;
+
+        if (result == Result::OK)
+        {
+            state.stats.requests++;
+            state.failures = 0;
+            return;
+        }
+        if (result == Result::BROKEN)
+        {
+            break;
+        }
+
+        state.stats.failures++;
+        if (++state.failures >= std::max<uint32_t>(m_options.failuresToEject, 1))
+        {
+            auto ejectMicros =
+                std::chrono::duration_cast<std::chrono::microseconds>(m_options.ejectFor);
+            state.ejectedUntil = time::NowCoarse() + ejectMicros.count();
+            state.failures = std::max<uint32_t>(m_options.failuresToEject, 1) - 1;
+        }
+        if (exchange.bodyTaken)
+        {
+            break;
+        }
+    }
+
+    if (exchange.responseBegun)
+    {
+        conn.AbortResponse();
+        return;
+    }
+    if (!conn.SendError())
+    {
+        conn.Send(502, "text/plain", "Bad Gateway\n");
+    }
+}
+
+ProxyUpstreamStats Proxy::Stats(size_t upstream) const
+{
+    auto const& state = LocalState(this).upstreams[upstream];
+    ProxyUpstreamStats stats = state.stats;
+    stats.ejected = state.ejectedUntil > time::NowCoarse();
+    return stats;
+}
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,133 @@
+#pragma once
+
+// Reverse proxying: a route whose handler forwards the request to one of a set of upstreams and
+// relays the answer back.
+//
+//   static const coop::http::ProxyUpstream s_backends[] = {
+//       {"10.0.0.5", 8080},
+//       {"10.0.0.6", 8080},
+//   };
+//   static coop::http::Proxy s_api({.upstreams = s_backends, .upstreamCount = 2});
+//
+//   static const coop::http::Route routes[] = {
+//       coop::http::ProxyRoute<s_api>("/api/*rest"),
+//       ...
+//   };
+//
+// The request goes out with its method, path and query as received and its headers as sent, less
+// the hop-by-hop ones (Connection, Keep-Alive, Proxy-Connection, TE, Trailer, Transfer-Encoding,
+// Upgrade), Expect, and the framing and trace headers the proxy writes itself. Host is the
+// client's unless preserveHost is off. The response comes back the same way, through the
+// server's own response methods, so Date, the common header block and Connection are this
+// server's.
+//
+// Connections come from the cooperator's ClientPool (ClientPool::Local(); TLS upstreams need its
+// ClientPoolOptions::tls) and go back to it after the response, so steady traffic runs over
+// keep-alive connections. Bodies stream in both directions a chunk at a time and never sit whole
+// in memory. A Content-Length body is spliced socket -> pipe -> socket when both ends allow it:
+// the request body when the client leg's bytes are the plaintext (plaintext, or kTLS receive) and
+// the upstream leg takes plaintext writes (plaintext, or kTLS transmit); the response body the
+// same the other way round. Anything else -- chunked bodies, TLS legs without kTLS, HTTP/2
+// clients -- is copied. Response bodies are Content-Length or chunked; one delimited by the
+// upstream closing is not supported and comes back empty. An HTTP/2 request's body is forwarded
+// only when it declares a Content-Length.
+//
+// Balancing is least outstanding requests, ties broken round robin, counted per cooperator (each
+// has its own pool and its own view of the upstreams). Health is passive: failuresToEject
+// failures in a row -- no connection, the request not sent, no response -- eject an upstream for
+// ejectFor, after which one more failure ejects it again. With every upstream ejected the one
+// whose ejection ends first is tried anyway. A request that fails before any of its body was read
+// is tried on another upstream, up to attempts in all, and is answered 502 when none answers.
+// Once the response has begun, an upstream failure aborts it (ConnectionBase::AbortResponse).
+//
+// A Proxy is shared by every cooperator serving the route, so it must outlive them all: give it
+// static storage, as ProxyRoute's template argument requires anyway.
+//
+
+#include <cstddef>
+#include <cstdint>
+
+#include "server.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+namespace http
+{
+
+struct ConnectionBase;
+
+struct ProxyUpstream
+{
+    const char* host;
+    int         port;
+    bool        tls = false;
+};
+
+struct ProxyOptions
+{
+    ProxyUpstream const* upstreams = nullptr;
+    size_t upstreamCount = 0;
+
+    // Upstreams tried for one request, the first included
+    //
+    size_t attempts = 2;
+
+    // Passive health: consecutive failures that eject an upstream, and for how long
+    //
+    uint32_t failuresToEject = 3;
+    time::Interval ejectFor = std::chrono::seconds(10);
+
+    // Forward the client's Host header; off, the upstream's own name goes instead
+    //
+    bool preserveHost = true;
+
+    // Budget for the whole exchange, a DeadlineScope around it; zero for none. The recv timeouts
+    // of the two connections still apply, but a spliced body has no other bound.
+    //
+    time::Interval timeout = time::Interval(0);
+};
+
+// The calling cooperator's view of one upstream
+//
+struct ProxyUpstreamStats
+{
+    uint64_t requests = 0;      // answered, whatever the status
+    uint64_t failures = 0;
+    uint32_t outstanding = 0;
+    bool     ejected = false;
+};
+
+struct Proxy
+{
+    explicit Proxy(ProxyOptions const& options);
+
+    Proxy(Proxy const&) = delete;
+    Proxy& operator=(Proxy const&) = delete;
+
+    // Forward the request on conn and relay the response: the route handler
+    //
+    void Forward(ConnectionBase& conn);
+
+    ProxyUpstreamStats Stats(size_t upstream) const;
+
+    ProxyOptions const& Options() const { return m_options; }
+
+  private:
+    ProxyOptions m_options;
+};
+
+template<Proxy& P>
+void ProxyHandler(ConnectionBase& conn)
+{
+    P.Forward(conn);
+}
+
+template<Proxy& P>
+constexpr Route ProxyRoute(const char* path)
+{
+    return Route{path, &ProxyHandler<P>};
+}
+
+} // end namespace coop::http
+} // end namespace coop
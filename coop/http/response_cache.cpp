@@ -0,0 +1,215 @@
+#include "response_cache.h"
+#include "common_headers.h"
+#include "connection.h"
+#include "response_constants.h"
+
+#include <cstdio>
+
+#include "coop/cooperator.h"
+#include "coop/time/now.h"
+
+namespace coop
+{
+namespace http
+{
+
+ResponseCache::Ref::Ref(Entry* entry)
+: m_entry(entry)
+{
+    m_entry->m_refs++;
+}
+
+ResponseCache::Ref& ResponseCache::Ref::operator=(Ref&& other)
+{
+    if (this != &other)
+    {
+        Reset();
+        m_entry = other.m_entry;
+        other.m_entry = nullptr;
+    }
+    return *this;
+}
+
+void ResponseCache::Ref::Reset()
+{
+    if (!m_entry)
+    {
+        return;
+    }
+    if (--m_entry->m_refs == 0 && !m_entry->m_cached)
+    {
+        delete m_entry;
+    }
+    m_entry = nullptr;
+}
+
+ResponseCache::ResponseCache(ResponseCacheOptions const& options /* = {} */)
+: m_options(options)
+{
+}
+
+ResponseCache::~ResponseCache()
+{
+    Clear();
+}
+
+// method, path and vary joined by NULs, which none of them can contain
+//
+std::string_view ResponseCache::MakeKey(std::string_view method, std::string_view path,
+                                        std::string_view vary)
+{
+    m_scratch.clear();
+    m_scratch.append(method);
+    m_scratch.push_back('\0');
+    m_scratch.append(path);
+    m_scratch.push_back('\0');
+    m_scratch.append(vary);
+    return m_scratch;
+}
+
+uint64_t ResponseCache::CurrentVersion() const
+{
+    return m_options.version ? m_options.version->load(std::memory_order_relaxed) : 0;
+}
+
+void ResponseCache::Drop(Entry* entry)
+{
+    m_entries.erase(entry->m_key);
+    m_lru.Remove(entry);
+    entry->m_cached = false;
+
+    if (entry->m_refs == 0)
+    {
+        delete entry;
+    }
+}
+
+ResponseCache::Ref ResponseCache::Lookup(std::string_view method, std::string_view path,
+                                         std::string_view vary /* = {} */)
+{
+    auto it = m_entries.find(MakeKey(method, path, vary));
+    if (it == m_entries.end())
+    {
+        m_stats.misses++;
+        return Ref();
+    }
+
+    Entry* entry = it->second;
+    if (entry->m_expiresUs <= time::NowCoarse() || entry->m_version != CurrentVersion())
+    {
+        m_stats.expirations++;
+        m_stats.misses++;
+        Drop(entry);
+        return Ref();
+    }
+
+    m_lru.Remove(entry);
+    m_lru.Push(entry);
+    m_stats.hits++;
+    return Ref(entry);
+}
+
+ResponseCache::Ref ResponseCache::Insert(
+    std::string_view method,
+    std::string_view path,
+    std::string_view vary,
+    int status,
+    const char* contentType,
+    std::string_view body,
+    time::Interval ttl /* = time::Interval(0) */)
+{
+    // The version is read before the caller's render is cached, never after: a bump that raced
+    // the render leaves this entry already outdated rather than stamped current
+    //
+    uint64_t version = CurrentVersion();
+
+    // The same bytes Connection::Send writes for a keep-alive response. The Date is the render's,
+    // as a shared cache's would be.
+    //
+    auto sl = response::StatusLine(status);
+    auto date = response::DateHeader();
+    auto common = response::CommonHeaders();
+    char length[24];
+    int lengthSize = snprintf(length, sizeof(length), "%zu", body.size());
+
+    auto* entry = new Entry;
+    entry->status = status;
+    entry->contentType = contentType;
+    auto& bytes = entry->bytes;
+    bytes.reserve(sl.size + date.size + common.size
+                  + sizeof(response::CONTENT_TYPE) + entry->contentType.size()
+                  + sizeof(response::CONTENT_LENGTH) + size_t(lengthSize)
+                  + sizeof(response::CRLF) + sizeof(response::CONN_KEEP_ALIVE) + body.size());
+    bytes.append(sl.data, sl.size);
+    bytes.append(date.data, date.size);
+    bytes.append(common.data, common.size);
+    bytes.append(response::CONTENT_TYPE);
+    bytes.append(entry->contentType);
+    bytes.append(response::CONTENT_LENGTH);
+    bytes.append(length, size_t(lengthSize));
+    bytes.append(response::CRLF);
+    bytes.append(response::CONN_KEEP_ALIVE);
+    entry->bodyOffset = bytes.size();
+    bytes.append(body);
+
+    if (ttl.count() <= 0)
+    {
+        ttl = m_options.ttl;
+    }
+    entry->m_expiresUs = time::NowCoarse() + ttl.count();
+    entry->m_version = version;
+    Ref ref(entry);
+
+    if (m_options.capacity == 0 || ttl.count() <= 0)
+    {
+        return ref;
+    }
+
+    auto key = MakeKey(method, path, vary);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end())
+    {
+        Drop(it->second);
+    }
+    while (m_entries.size() >= m_options.capacity)
+    {
+        Drop(m_lru.Peek());
+    }
+
+    entry->m_key = key;
+    entry->m_cached = true;
+    m_entries.emplace(entry->m_key, entry);
+    m_lru.Push(entry);
+    return ref;
+}
+
+void ResponseCache::Invalidate(std::string_view method, std::string_view path,
+                               std::string_view vary /* = {} */)
+{
+    auto it = m_entries.find(MakeKey(method, path, vary));
+    if (it != m_entries.end())
+    {
+        Drop(it->second);
+    }
+}
+
+void ResponseCache::Clear()
+{
+    while (!m_lru.IsEmpty())
+    {
+        Drop(m_lru.Peek());
+    }
+}
+
+bool ResponseCache::Send(ConnectionBase& conn, Entry const& entry)
+{
+    if (conn.KeepAlive())
+    {
+        return conn.SendRawBytes(entry.bytes.data(), entry.bytes.size());
+    }
+    auto body = entry.Body();
+    return conn.Send(entry.status, entry.contentType.c_str(), body.data(), body.size());
+}
+
+} // end namespace coop::http
+} // end namespace coop
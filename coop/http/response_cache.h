@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "coop/detail/embedded_list.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+namespace http
+{
+
+struct ConnectionBase;
+
+struct ResponseCacheOptions
+{
+    // Most responses held at once; the least recently used is dropped to make room
+    //
+    size_t capacity = 1024;
+
+    // How long an entry serves before it counts as a miss, unless Insert says otherwise
+    //
+    time::Interval ttl = std::chrono::seconds(1);
+
+    // Optional version source shared by every replica: an entry stamped with an older version is a
+    // miss, so one increment, from any thread, invalidates the lot. A relaxed load per lookup.
+    //
+    std::atomic<uint64_t> const* version = nullptr;
+};
+
+struct ResponseCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t expirations = 0;
+};
+
+// Pre-rendered responses for endpoints that answer the same bytes for a while -- health checks,
+// config blobs, feature flags. Each entry holds the complete HTTP/1.1 response, status line through
+// body, serialized once at Insert; a hit goes out in one send without running the handler's work
+// or formatting a header.
+//
+// Entries are keyed by method, path and a vary string the caller builds from whatever request
+// headers the response depends on (empty if none). Lookup returns a Ref that pins the entry, so a
+// response being sent is never freed by an expiry or eviction meanwhile; Refs may outlive the
+// cache.
+//
+// One cache per cooperator (a CooperatorVar, or a member of something per-cooperator): entries and
+// their refcounts are not shared across threads, so lookups take no lock. Replicas are kept
+// coherent by TTL, or by bumping the shared ResponseCacheOptions::version.
+//
+//  static CooperatorVar<ResponseCache> s_cache;
+//
+//  void Flags(ConnectionBase& conn)
+//  {
+//      auto* req = conn.GetRequestLine();
+//      auto hit = s_cache->Lookup(req->method, req->path);
+//      if (!hit)
+//      {
+//          auto body = RenderFlags();
+//          hit = s_cache->Insert(req->method, req->path, {}, 200, "application/json", body);
+//      }
+//      ResponseCache::Send(conn, *hit);
+//  }
+//
+struct ResponseCache
+{
+    struct Entry : EmbeddedListHookups<Entry>
+    {
+        // The full response, and where its body starts in it
+        //
+        std::string     bytes;
+        size_t          bodyOffset = 0;
+        int             status = 0;
+        std::string     contentType;
+
+        std::string_view Body() const
+        {
+            return std::string_view(bytes).substr(bodyOffset);
+        }
+
+    private:
+        friend struct ResponseCache;
+
+        std::string     m_key;
+        int64_t         m_expiresUs = 0;
+        uint64_t        m_version = 0;
+        int             m_refs = 0;
+        bool            m_cached = false;
+    };
+
+    struct Ref
+    {
+        Ref() = default;
+        explicit Ref(Entry* entry);
+        Ref(Ref&& other) : m_entry(other.m_entry) { other.m_entry = nullptr; }
+        Ref& operator=(Ref&& other);
+        ~Ref() { Reset(); }
+
+        Ref(Ref const&) = delete;
+        Ref& operator=(Ref const&) = delete;
+
+        explicit operator bool() const { return m_entry != nullptr; }
+        Entry const* operator->() const { return m_entry; }
+        Entry const& operator*() const { return *m_entry; }
+
+        void Reset();
+
+    private:
+        Entry* m_entry = nullptr;
+    };
+
+    ResponseCache(ResponseCacheOptions const& options = {});
+    ~ResponseCache();
+
+    ResponseCache(ResponseCache const&) = delete;
+    ResponseCache& operator=(ResponseCache const&) = delete;
+
+    // The live entry for the key, or an empty Ref. An expired or outdated entry is dropped here.
+    //
+    Ref Lookup(std::string_view method, std::string_view path, std::string_view vary = {});
+
+    // Render and cache a response, replacing any entry for the key. ttl 0 takes the options' ttl.
+    // The returned Ref is good to send even when capacity is 0 and nothing was cached.
+    //
+    Ref Insert(std::string_view method, std::string_view path, std::string_view vary,
+               int status, const char* contentType, std::string_view body,
+               time::Interval ttl = time::Interval(0));
+
+    // Drop the entry for the key, or every entry
+    //
+    void Invalidate(std::string_view method, std::string_view path, std::string_view vary = {});
+    void Clear();
+
+    // Send a cached response on conn. A keep-alive HTTP/1.1 connection gets the stored bytes as
+    // they are; anything else (Connection: close, HTTP/2) goes through conn.Send with the stored
+    // status, type and body.
+    //
+    static bool Send(ConnectionBase& conn, Entry const& entry);
+
+    size_t Size() const { return m_entries.size(); }
+    ResponseCacheStats const& Stats() const { return m_stats; }
+
+private:
+    std::string_view MakeKey(std::string_view method, std::string_view path, std::string_view vary);
+    uint64_t CurrentVersion() const;
+    void Drop(Entry* entry);
+
+    ResponseCacheOptions                                m_options;
+    ResponseCacheStats                                  m_stats;
+
+    // Lookup keys are assembled here, so a hit allocates nothing
+    //
+    std::string                                         m_scratch;
+
+    std::unordered_map<std::string_view, Entry*>        m_entries;
+    EmbeddedList<Entry>                                 m_lru;
+};
+
+} // end namespace coop::http
+} // end namespace coop
@@ -13,6 +13,7 @@ namespace response
 STATUS_LINE(200, "OK");
 STATUS_LINE(201, "Created");
 STATUS_LINE(204, "No Content");
+STATUS_LINE(206, "Partial Content");
 STATUS_LINE(301, "Moved Permanently");
 STATUS_LINE(302, "Found");
 STATUS_LINE(304, "Not Modified");
@@ -23,6 +24,7 @@ STATUS_LINE(404, "Not Found");
 STATUS_LINE(405, "Method Not Allowed");
 STATUS_LINE(408, "Request Timeout");
 STATUS_LINE(413, "Payload Too Large");
+STATUS_LINE(416, "Range Not Satisfiable");
 STATUS_LINE(500, "Internal Server Error");
 STATUS_LINE(502, "Bad Gateway");
 STATUS_LINE(503, "Service Unavailable");
@@ -38,6 +40,7 @@ Fragment StatusLine(int code)
         case 200: return { SL_200, sizeof(SL_200) - 1 };
         case 201: return { SL_201, sizeof(SL_201) - 1 };
         case 204: return { SL_204, sizeof(SL_204) - 1 };
+        case 206: return { SL_206, sizeof(SL_206) - 1 };
         case 301: return { SL_301, sizeof(SL_301) - 1 };
         case 302: return { SL_302, sizeof(SL_302) - 1 };
         case 304: return { SL_304, sizeof(SL_304) - 1 };
@@ -48,6 +51,7 @@ Fragment StatusLine(int code)
         case 405: return { SL_405, sizeof(SL_405) - 1 };
         case 408: return { SL_408, sizeof(SL_408) - 1 };
         case 413: return { SL_413, sizeof(SL_413) - 1 };
+        case 416: return { SL_416, sizeof(SL_416) - 1 };
         case 500: return { SL_500, sizeof(SL_500) - 1 };
         case 502: return { SL_502, sizeof(SL_502) - 1 };
         case 503: return { SL_503, sizeof(SL_503) - 1 };
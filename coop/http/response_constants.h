@@ -23,6 +23,7 @@ Fragment StatusLine(int code);
 //
 inline constexpr char CONTENT_TYPE[]     = "Content-Type: ";
 inline constexpr char CONTENT_LENGTH[]   = "\r\nContent-Length: ";
+inline constexpr char CONTENT_LENGTH_LINE[] = "Content-Length: ";
 inline constexpr char TRANSFER_ENCODING_CHUNKED[] =
     "Transfer-Encoding: chunked\r\n";
 
@@ -31,9 +32,25 @@ inline constexpr char TRANSFER_ENCODING_CHUNKED[] =
 inline constexpr char CONN_KEEP_ALIVE[]  = "Connection: keep-alive\r\n\r\n";
 inline constexpr char CONN_CLOSE[]       = "Connection: close\r\n\r\n";
 
+// A whole 503 for load shedding (admission.h), sent as it stands and followed by a close: no
+// formatting, no Date (a server under overload need not compute one, RFC 9110 6.6.1)
+//
+inline constexpr char SERVICE_UNAVAILABLE[] =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 20\r\n"
+    "Retry-After: 1\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "Service Unavailable\n";
+
 inline constexpr char CRLF[] = "\r\n";
 inline constexpr char CHUNKED_TERMINATOR[] = "0\r\n\r\n";
 
+// The CRLF closing a chunk's data, then the terminator: what follows a response's last chunk
+//
+inline constexpr char LAST_CHUNK_TRAILER[] = "\r\n0\r\n\r\n";
+
 } // end namespace coop::http::response
 } // end namespace coop::http
 } // end namespace coop
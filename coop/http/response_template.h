@@ -0,0 +1,423 @@
+#pragma once
+
+// Responses of a fixed shape, parsed at compile time. The template is the response as it goes on
+// the wire, with "{}" wherever a value goes:
+//
+//   using UserReply = coop::http::ResponseTemplate<
+//       "HTTP/1.1 200 OK\r\n"
+//       "Content-Type: application/json\r\n"
+//       "Content-Length: {}\r\n"
+//       "\r\n"
+//       "{\"id\":{},\"ok\":true}">;
+//
+//   UserReply::Send(conn, user.id);
+//
+// The parse splits the text into literal fragments and slots, and sums the body's literal bytes
+// into STATIC_BODY_SIZE. Send formats each argument -- integers as decimal, bools as true/false,
+// strings as they are, unescaped -- and hands the pieces to the connection, which copies them into
+// its send buffer behind the status line, Date and common headers, with a Content-Length of the
+// static size plus the formatted values. Nothing is scanned or formatted at run time but the
+// values themselves.
+//
+// The rules, each a build error when broken:
+//   - a "HTTP/1.1 NNN Reason" status line, 100 to 599, and CRLF line ends throughout the head
+//   - "Name: value" header lines, ended by a blank line; slots only in values
+//   - Content-Length, if present, is "{}": the connection fills it in (it always sends one, but for
+//     1xx, 204 and 304)
+//   - no Connection, Date or Transfer-Encoding: those are the connection's
+//   - no body on a 1xx, 204 or 304
+//   - as many arguments as slots
+//
+// Every "{}" is a slot; there is no escape for a literal one. The response is never compressed.
+// Over HTTP/2 the same pieces become the stream's header block and one DATA write.
+//
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "connection.h"
+#include "response_constants.h"
+
+namespace coop
+{
+namespace http
+{
+
+namespace response
+{
+
+// What a template rendered, for ConnectionBase::SendRendered: the pieces in wire order
+//
+struct Rendered
+{
+    int             status;
+    Fragment        statusLine;         // "HTTP/1.1 200 OK\r\n"
+    Fragment const* head;               // the header lines but Content-Length, each CRLF-ended,
+    size_t          headCount;          //   split where the slots go
+    Fragment const* body;
+    size_t          bodyCount;
+    size_t          bodySize;
+    bool            contentLength;      // false for the statuses that carry none
+};
+
+} // end namespace coop::http::response
+
+namespace detail
+{
+
+// A string literal as a template argument
+//
+template<size_t N>
+struct TemplateText
+{
+    consteval TemplateText(const char (&s)[N])
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            text[i] = s[i];
+        }
+    }
+
+    static constexpr size_t SIZE = N - 1;
+    char text[N];
+};
+
+// Not constexpr: a parse that reaches it is not a constant expression, and the build stops there
+// with the reason in the trace
+//
+inline void MalformedResponseTemplate(const char* /* reason */) {}
+
+struct TemplateSegment
+{
+    size_t  offset = 0;
+    size_t  size = 0;
+    bool    slot = false;
+};
+
+template<size_t N>
+struct TemplateLayout
+{
+    int             status = 0;
+    size_t          statusLineSize = 0;
+    TemplateSegment head[N] = {};
+    size_t          headCount = 0;
+    size_t          headSlots = 0;
+    TemplateSegment body[N] = {};
+    size_t          bodyCount = 0;
+    size_t          bodySlots = 0;
+    size_t          staticBodySize = 0;
+};
+
+constexpr char Lower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr bool NameIs(std::string_view name, std::string_view lower)
+{
+    if (name.size() != lower.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < name.size(); i++)
+    {
+        if (Lower(name[i]) != lower[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// text[begin, end) as literals and slots, a literal joining the one before it when contiguous
+//
+template<size_t N>
+consteval void Split(std::string_view text, size_t begin, size_t end, TemplateSegment* out,
+                     size_t* count, size_t* slots)
+{
+    auto literal = [&](size_t from, size_t to)
+    {
+        if (from == to)
+        {
+            return;
+        }
+        if (*count > 0 && !out[*count - 1].slot &&
+            out[*count - 1].offset + out[*count - 1].size == from)
+        {
+            out[*count - 1].size += to - from;
+            return;
+        }
+        out[(*count)++] = {from, to - from, false};
+    };
+
+    size_t from = begin;
+    for (size_t i = begin; i < end; i++)
+    {
+        if (i + 1 < end && text[i] == '{' && text[i + 1] == '}')
+        {
+            literal(from, i);
+            out[(*count)++] = {i, 0, true};
+            (*slots)++;
+            from = i + 2;
+            i++;
+        }
+    }
+    literal(from, end);
+}
+
+template<size_t N>
+consteval TemplateLayout<N> ParseTemplate(TemplateText<N> const& source)
+{
+    TemplateLayout<N> layout;
+    std::string_view text(source.text, TemplateText<N>::SIZE);
+
+    // Status line
+    //
+    constexpr std::string_view VERSION = "HTTP/1.1 ";
+    if (text.substr(0, VERSION.size()) != VERSION || text.size() < VERSION.size() + 4)
+    {
+        MalformedResponseTemplate("must begin with an HTTP/1.1 status line");
+    }
+    int status = 0;
+    for (size_t i = VERSION.size(); i < VERSION.size() + 3; i++)
+    {
+        if (text[i] < '0' || text[i] > '9')
+        {
+            MalformedResponseTemplate("status code must be three digits");
+        }
+        status = status * 10 + (text[i] - '0');
+    }
+    if (status < 100 || status > 599 || text[VERSION.size() + 3] != ' ')
+    {
+        MalformedResponseTemplate("status code must be 100-599, followed by a space");
+    }
+    size_t lineEnd = text.find("\r\n");
+    if (lineEnd == std::string_view::npos)
+    {
+        MalformedResponseTemplate("status line must end in CRLF");
+    }
+    auto statusLine = text.substr(0, lineEnd);
+    if (statusLine.find('\n') != std::string_view::npos ||
+        statusLine.find("{}") != std::string_view::npos)
+    {
+        MalformedResponseTemplate("status line takes no slots and ends in CRLF");
+    }
+    layout.status = status;
+    layout.statusLineSize = lineEnd + 2;
+
+    // Header lines, up to the blank one
+    //
+    size_t pos = layout.statusLineSize;
+    for (;;)
+    {
+        if (text.substr(pos, 2) == "\r\n")
+        {
+            pos += 2;
+            break;
+        }
+        size_t end = text.find("\r\n", pos);
+        if (end == std::string_view::npos)
+        {
+            MalformedResponseTemplate("headers must end with a blank line");
+        }
+        auto line = text.substr(pos, end - pos);
+        if (line.find('\n') != std::string_view::npos || line.find('\r') != std::string_view::npos)
+        {
+            MalformedResponseTemplate("header lines must end in CRLF");
+        }
+        size_t colon = line.find(':');
+        if (colon == 0 || colon == std::string_view::npos)
+        {
+            MalformedResponseTemplate("header line without a name and colon");
+        }
+        auto name = line.substr(0, colon);
+        for (char c : name)
+        {
+            if (c == ' ' || c == '\t' || c == '{' || c == '}')
+            {
+                MalformedResponseTemplate("header name must be a token");
+            }
+        }
+        auto value = line.substr(colon + 1);
+        while (!value.empty() && value.front() == ' ')
+        {
+            value.remove_prefix(1);
+        }
+
+        if (NameIs(name, "content-length"))
+        {
+            if (value != "{}")
+            {
+                MalformedResponseTemplate("Content-Length is computed: write it as {}");
+            }
+        }
+        else if (NameIs(name, "connection") || NameIs(name, "date") ||
+                 NameIs(name, "transfer-encoding"))
+        {
+            MalformedResponseTemplate("Connection, Date and Transfer-Encoding are the server's");
+        }
+        else
+        {
+            Split<N>(text, pos, end + 2, layout.head, &layout.headCount, &layout.headSlots);
+        }
+        pos = end + 2;
+    }
+
+    // Body
+    //
+    Split<N>(text, pos, text.size(), layout.body, &layout.bodyCount, &layout.bodySlots);
+    for (size_t i = 0; i < layout.bodyCount; i++)
+    {
+        layout.staticBodySize += layout.body[i].size;
+    }
+    const bool bodyless = status < 200 || status == 204 || status == 304;
+    if (bodyless && layout.bodyCount > 0)
+    {
+        MalformedResponseTemplate("1xx, 204 and 304 responses have no body");
+    }
+    return layout;
+}
+
+// The first Count of a layout's segments, so a template keeps only what it uses
+//
+template<size_t Count, size_t N>
+consteval std::array<TemplateSegment, Count> Take(TemplateSegment const (&from)[N])
+{
+    std::array<TemplateSegment, Count> out = {};
+    for (size_t i = 0; i < Count; i++)
+    {
+        out[i] = from[i];
+    }
+    return out;
+}
+
+// One argument, formatted for its slot. Holds its digits itself, so the Fragment it gives is good
+// for as long as it lives.
+//
+struct SlotValue
+{
+    template<typename T>
+    explicit SlotValue(T const& value)
+    {
+        using V = std::decay_t<T>;
+        if constexpr (std::is_same_v<V, bool>)
+        {
+            m_view = value ? std::string_view("true") : std::string_view("false");
+        }
+        else if constexpr (std::is_integral_v<V>)
+        {
+            FormatInteger(value);
+        }
+        else if constexpr (std::is_convertible_v<T const&, std::string_view>)
+        {
+            m_view = std::string_view(value);
+        }
+        else
+        {
+            static_assert(std::is_integral_v<V>, "template slots take integers, bools or strings");
+        }
+    }
+
+    SlotValue(SlotValue const&) = delete;
+    SlotValue& operator=(SlotValue const&) = delete;
+
+    response::Fragment Get() const
+    {
+        if (m_digits)
+        {
+            return {m_buf + sizeof(m_buf) - m_digits, m_digits};
+        }
+        return {m_view.data(), m_view.size()};
+    }
+
+  private:
+    // Backwards from the end, as AppendUInt does
+    //
+    template<typename I>
+    void FormatInteger(I value)
+    {
+        using U = std::make_unsigned_t<I>;
+        const bool negative = value < 0;
+        U v = negative ? static_cast<U>(0) - static_cast<U>(value) : static_cast<U>(value);
+        size_t pos = sizeof(m_buf);
+        do
+        {
+            m_buf[--pos] = static_cast<char>('0' + v % 10);
+            v /= 10;
+        } while (v > 0);
+        if (negative)
+        {
+            m_buf[--pos] = '-';
+        }
+        m_digits = sizeof(m_buf) - pos;
+    }
+
+    std::string_view    m_view;
+    char                m_buf[20];
+    size_t              m_digits = 0;
+};
+
+} // end namespace coop::http::detail
+
+template<detail::TemplateText Text>
+struct ResponseTemplate
+{
+    static constexpr auto LAYOUT = detail::ParseTemplate(Text);
+    static constexpr int STATUS = LAYOUT.status;
+    static constexpr size_t SLOTS = LAYOUT.headSlots + LAYOUT.bodySlots;
+    static constexpr size_t STATIC_BODY_SIZE = LAYOUT.staticBodySize;
+    static constexpr auto HEAD = detail::Take<LAYOUT.headCount>(LAYOUT.head);
+    static constexpr auto BODY = detail::Take<LAYOUT.bodyCount>(LAYOUT.body);
+
+    // Render and send. False on send failure, as the connection's other response methods.
+    //
+    template<typename... Args>
+    static bool Send(ConnectionBase& conn, Args const&... args)
+    {
+        static_assert(sizeof...(Args) == SLOTS, "one argument per {} in the template");
+
+        // One spare, so a template without slots or pieces still has arrays
+        //
+        const detail::SlotValue values[SLOTS + 1] = {
+            detail::SlotValue(args)...,
+            detail::SlotValue(0),
+        };
+        std::array<response::Fragment, HEAD.size() + 1> head;
+        std::array<response::Fragment, BODY.size() + 1> body;
+
+        size_t slot = 0;
+        for (size_t i = 0; i < HEAD.size(); i++)
+        {
+            head[i] = Piece(HEAD[i], values, &slot);
+        }
+        size_t bodySize = STATIC_BODY_SIZE;
+        for (size_t i = 0; i < BODY.size(); i++)
+        {
+            body[i] = Piece(BODY[i], values, &slot);
+            bodySize += BODY[i].slot ? body[i].size : 0;
+        }
+
+        response::Rendered rendered{
+            STATUS, {Text.text, LAYOUT.statusLineSize}, head.data(), HEAD.size(),
+            body.data(), BODY.size(), bodySize,
+            !(STATUS < 200 || STATUS == 204 || STATUS == 304)};
+        return conn.SendRendered(rendered);
+    }
+
+  private:
+    static response::Fragment Piece(detail::TemplateSegment const& segment,
+                                    detail::SlotValue const* values, size_t* slot)
+    {
+        if (segment.slot)
+        {
+            return values[(*slot)++].Get();
+        }
+        return {Text.text + segment.offset, segment.size};
+    }
+};
+
+} // end namespace coop::http
+} // end namespace coop
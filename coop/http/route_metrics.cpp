@@ -0,0 +1,249 @@
+#include "route_metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#include "types.h"
+#include "coop/cooperator.h"
+#include "coop/time/now.h"
+
+namespace coop
+{
+namespace http
+{
+
+namespace
+{
+
+std::atomic<size_t>  s_slowCount{0};
+std::atomic<int64_t> s_slowIntervalMicros{10 * 1000 * 1000};
+
+// The published slow requests, a ring under its own lock: written by each table as its interval
+// rolls over, read by the status server
+//
+std::mutex  s_slowMutex;
+SlowRequest s_slowHistory[kSlowRequestHistory];
+size_t      s_slowTotal = 0;
+
+void CopyTerminated(char* out, size_t capacity, std::string_view s)
+{
+    const size_t n = std::min(s.size(), capacity - 1);
+    memcpy(out, s.data(), n);
+    out[n] = '\0';
+}
+
+} // end anonymous namespace
+
+// Every live table, for scrapes. The lock also covers a table's slot vectors changing size
+// (AddRoute), the one thing a scrape's plain reads cannot tolerate.
+//
+struct RouteMetricsRegistry
+{
+    static inline std::mutex            mutex;
+    static inline RouteMetricsTable*    head = nullptr;
+
+    static void Link(RouteMetricsTable* table)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        table->m_next = head;
+        if (head)
+        {
+            head->m_prev = table;
+        }
+        head = table;
+    }
+
+    static void Unlink(RouteMetricsTable* table)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (table->m_prev)
+        {
+            table->m_prev->m_next = table->m_next;
+        }
+        else
+        {
+            head = table->m_next;
+        }
+        if (table->m_next)
+        {
+            table->m_next->m_prev = table->m_prev;
+        }
+    }
+
+    // fn(RouteMetricsTable const&) for every live table, under the lock
+    //
+    template<typename Fn>
+    static void Visit(Fn const& fn)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto* table = head; table; table = table->m_next)
+        {
+            fn(*table);
+        }
+    }
+};
+
+void RouteMetrics::Merge(RouteMetrics const& other)
+{
+    requests += other.requests;
+    for (size_t i = 0; i < std::size(statusClass); i++)
+    {
+        statusClass[i] += other.statusClass[i];
+    }
+    bytesIn += other.bytesIn;
+    bytesOut += other.bytesOut;
+    latency.Merge(other.latency);
+}
+
+RouteMetricsTable::RouteMetricsTable()
+{
+    RouteMetricsRegistry::Link(this);
+}
+
+RouteMetricsTable::~RouteMetricsTable()
+{
+    RouteMetricsRegistry::Unlink(this);
+}
+
+void RouteMetricsTable::AddRoute(const char* path)
+{
+    std::lock_guard<std::mutex> lock(RouteMetricsRegistry::mutex);
+    m_paths.push_back(path);
+    m_routes.emplace_back();
+}
+
+bool RouteMetricsTable::BeginSample(RequestLine const& request, SlowRequest& sample) const
+{
+    if (!s_slowCount.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+    CopyTerminated(sample.method, sizeof(sample.method), request.method);
+    CopyTerminated(sample.path, sizeof(sample.path), request.path);
+    return true;
+}
+
+void RouteMetricsTable::Record(Cooperator* co, int slot, SlowRequest* sample, int status,
+    uint64_t in, uint64_t out, uint64_t nanos)
+{
+    (slot >= 0 ? m_routes[static_cast<size_t>(slot)] : m_unmatched).Record(status, in, out, nanos);
+    if (!sample)
+    {
+        return;
+    }
+
+    const int64_t now = time::MonotonicMicros();
+    if (now >= m_intervalEnd)
+    {
+        Publish();
+        m_intervalEnd = now + s_slowIntervalMicros.load(std::memory_order_relaxed);
+    }
+
+    // Keep the interval's slowest: fill up to count, then displace the fastest kept
+    //
+    const size_t count = s_slowCount.load(std::memory_order_relaxed);
+    SlowRequest* into = nullptr;
+    if (m_slowest.size() < count)
+    {
+        into = &m_slowest.emplace_back();
+    }
+    else if (!m_slowest.empty())
+    {
+        auto fastest = std::min_element(m_slowest.begin(), m_slowest.end(),
+            [](SlowRequest const& a, SlowRequest const& b) { return a.nanos < b.nanos; });
+        if (fastest->nanos < nanos)
+        {
+            into = &*fastest;
+        }
+    }
+    if (!into)
+    {
+        return;
+    }
+
+    memcpy(into->method, sample->method, sizeof(into->method));
+    memcpy(into->path, sample->path, sizeof(into->path));
+    CopyTerminated(into->route, sizeof(into->route),
+        slot >= 0 ? m_paths[static_cast<size_t>(slot)] : "");
+    CopyTerminated(into->cooperatorName, sizeof(into->cooperatorName), co->GetName());
+    into->status = status;
+    into->bytesIn = in;
+    into->bytesOut = out;
+    into->nanos = nanos;
+    into->completedMicros = now;
+}
+
+// The interval's survivors go into the ring slowest first
+//
+void RouteMetricsTable::Publish()
+{
+    if (m_slowest.empty())
+    {
+        return;
+    }
+    std::sort(m_slowest.begin(), m_slowest.end(),
+        [](SlowRequest const& a, SlowRequest const& b) { return a.nanos > b.nanos; });
+
+    std::lock_guard<std::mutex> lock(s_slowMutex);
+    for (auto const& request : m_slowest)
+    {
+        s_slowHistory[s_slowTotal++ % kSlowRequestHistory] = request;
+    }
+    m_slowest.clear();
+}
+
+void SetSlowRequestCapture(size_t count, time::Interval interval)
+{
+    s_slowIntervalMicros.store(std::max<int64_t>(interval.count(), 1), std::memory_order_relaxed);
+    s_slowCount.store(count, std::memory_order_relaxed);
+}
+
+size_t ReadSlowRequests(SlowRequest* out, size_t maxRequests)
+{
+    std::lock_guard<std::mutex> lock(s_slowMutex);
+    size_t available = s_slowTotal < kSlowRequestHistory ? s_slowTotal : kSlowRequestHistory;
+    size_t count = available < maxRequests ? available : maxRequests;
+    size_t start = s_slowTotal - available;
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = s_slowHistory[(start + i) % kSlowRequestHistory];
+    }
+    return count;
+}
+
+namespace detail
+{
+
+void MergeRouteMetrics(MergedRouteMetrics& out)
+{
+    std::map<std::string, RouteMetrics, std::less<>> byPath;
+    RouteMetricsRegistry::Visit([&](RouteMetricsTable const& table)
+    {
+        for (size_t i = 0; i < table.Size(); i++)
+        {
+            auto it = byPath.find(std::string_view(table.Path(i)));
+            if (it == byPath.end())
+            {
+                it = byPath.try_emplace(table.Path(i)).first;
+            }
+            it->second.Merge(table.At(i));
+        }
+        out.unmatched.Merge(table.Unmatched());
+    });
+
+    out.paths.reserve(byPath.size());
+    out.metrics.reserve(byPath.size());
+    for (auto& [path, metrics] : byPath)
+    {
+        out.paths.push_back(path);
+        out.metrics.push_back(metrics);
+    }
+}
+
+} // end namespace coop::http::detail
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,186 @@
+#pragma once
+
+// Per-route request metrics. Every Router carries a RouteMetricsTable with one RouteMetrics slot
+// per route, plus one for requests no route took (static files, 404s). A Router is built per
+// server and per cooperator, so each slot has exactly one writer: HandleRequest updates it after
+// the handler returns -- a request count, a count per status class, bytes in and out, and the
+// handler's latency in a perf::Histogram -- with no atomics. Scrapes (the status server's
+// /api/routes, VisitRouteMetrics) read the slots from other threads as plain words, as
+// /api/cooperators/perf reads perf::Counters, and sum them per route path across every server and
+// cooperator.
+//
+// Slow-request sampling is off until SetSlowRequestCapture turns it on. Each table then keeps the
+// slowest count requests of every interval -- the request line (method and path, not the query or
+// body), status, bytes and latency -- and publishes them into a process-wide ring when the first
+// request after the interval lands. ReadSlowRequests returns the ring, oldest first:
+//
+//   coop::http::SetSlowRequestCapture(4, std::chrono::seconds(10));
+//   ...
+//   GET /api/routes/slow
+//   [{"method":"POST","path":"/users/17/posts","route":"/users/:id/posts","status":200,...}]
+//
+// Bytes are the request's and response's on the wire for HTTP/1.1 (headers included; bytes of a
+// pipelined request buffered behind this one count here), and DATA payload for an HTTP/2 stream.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "coop/cooperator_configuration.h"
+#include "coop/perf/histogram.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+
+struct Cooperator;
+
+namespace http
+{
+
+struct RequestLine;
+
+struct RouteMetrics
+{
+    uint64_t requests = 0;
+
+    // By status / 100: [1] 1xx through [5] 5xx; [0] counts requests that sent no response status
+    // (a failed send, an upgraded connection) or one outside 100-599
+    //
+    uint64_t statusClass[6] = {};
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+
+    // Handler latency, nanoseconds
+    //
+    perf::Histogram latency;
+
+    void Record(int status, uint64_t in, uint64_t out, uint64_t nanos)
+    {
+        requests++;
+        statusClass[status >= 100 && status < 600 ? status / 100 : 0]++;
+        bytesIn += in;
+        bytesOut += out;
+        latency.Record(nanos);
+    }
+
+    void Merge(RouteMetrics const& other);
+};
+
+// One sampled slow request, copied out of the connection: the views it came from die with it
+//
+struct SlowRequest
+{
+    static constexpr size_t METHOD_BYTES = 16;
+    static constexpr size_t PATH_BYTES = 128;
+
+    char        method[METHOD_BYTES];
+    char        path[PATH_BYTES];           // truncated, always terminated
+    char        route[PATH_BYTES];          // the matched route's path, empty if none matched
+    char        cooperatorName[COOPERATOR_NAME_MAX];
+    int         status;
+    uint64_t    bytesIn;
+    uint64_t    bytesOut;
+    uint64_t    nanos;
+    int64_t     completedMicros;            // time::MonotonicMicros when the handler returned
+};
+
+// The metrics of one Router. Non-movable: the scrape registry holds its address from construction
+// to destruction.
+//
+struct RouteMetricsTable
+{
+    RouteMetricsTable();
+    ~RouteMetricsTable();
+
+    RouteMetricsTable(RouteMetricsTable const&) = delete;
+    RouteMetricsTable& operator=(RouteMetricsTable const&) = delete;
+
+    // Router::Add, for each route it accepts: its slot is the next index
+    //
+    void AddRoute(const char* path);
+
+    // Before dispatch, while request's views are good (a handler's body reads may compact the recv
+    // buffer under them): copy the request line into sample if sampling is on. False, copying
+    // nothing, when it is off.
+    //
+    bool BeginSample(RequestLine const& request, SlowRequest& sample) const;
+
+    // The owning cooperator, after the handler returns. slot is the matched route's, or -1;
+    // sample is the one BeginSample filled, or null.
+    //
+    void Record(Cooperator* co, int slot, SlowRequest* sample, int status, uint64_t in,
+        uint64_t out, uint64_t nanos);
+
+    size_t Size() const { return m_routes.size(); }
+    const char* Path(size_t slot) const { return m_paths[slot]; }
+    RouteMetrics const& At(size_t slot) const { return m_routes[slot]; }
+    RouteMetrics const& Unmatched() const { return m_unmatched; }
+
+  private:
+    void Publish();
+
+    std::vector<const char*>    m_paths;
+    std::vector<RouteMetrics>   m_routes;
+    RouteMetrics                m_unmatched;
+
+    // This interval's slowest, unordered, and when the interval ends
+    //
+    std::vector<SlowRequest>    m_slowest;
+    int64_t                     m_intervalEnd = 0;
+
+    // Scrape registry hookup
+    //
+    RouteMetricsTable*          m_prev = nullptr;
+    RouteMetricsTable*          m_next = nullptr;
+
+    friend struct RouteMetricsRegistry;
+};
+
+// Keep the slowest count requests per interval, per server per cooperator. 0 (the default) turns
+// sampling off; the change reaches each table at its next request.
+//
+void SetSlowRequestCapture(size_t count, time::Interval interval);
+
+// The most recent published slow requests, up to kSlowRequestHistory, oldest first
+//
+constexpr size_t kSlowRequestHistory = 256;
+
+size_t ReadSlowRequests(SlowRequest* out, size_t maxRequests);
+
+namespace detail
+{
+
+// What VisitRouteMetrics walks: the merged snapshot, built in one registry visit
+//
+struct MergedRouteMetrics
+{
+    std::vector<std::string>    paths;
+    std::vector<RouteMetrics>   metrics;
+    RouteMetrics                unmatched;
+};
+
+void MergeRouteMetrics(MergedRouteMetrics& out);
+
+} // end namespace coop::http::detail
+
+// fn(const char* path, RouteMetrics const&): every route path served anywhere, summed over its
+// servers and cooperators, in path order; requests no route matched come last with a null path.
+// The sums are taken in one registry visit and walked after it returns.
+//
+template<typename Fn>
+void VisitRouteMetrics(Fn const& fn)
+{
+    detail::MergedRouteMetrics merged;
+    detail::MergeRouteMetrics(merged);
+    for (size_t i = 0; i < merged.paths.size(); i++)
+    {
+        fn(merged.paths[i].c_str(), merged.metrics[i]);
+    }
+    fn(static_cast<const char*>(nullptr), merged.unmatched);
+}
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,224 @@
+#include "router.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "server.h"
+
+namespace coop
+{
+namespace http
+{
+
+namespace
+{
+
+// Split the next segment off rest. Returns false once there are none left: "/" is one empty
+// segment, so "/a" and "/a/" stay distinct.
+//
+bool NextSegment(std::string_view* rest, bool* done, std::string_view* segment)
+{
+    if (*done)
+    {
+        return false;
+    }
+    auto slash = rest->find('/');
+    if (slash == std::string_view::npos)
+    {
+        *segment = *rest;
+        *rest = {};
+        *done = true;
+    }
+    else
+    {
+        *segment = rest->substr(0, slash);
+        *rest = rest->substr(slash + 1);
+    }
+    return true;
+}
+
+} // end anonymous namespace
+
+Router::Router(Route const* routes, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (!Add(routes[i]))
+        {
+            spdlog::warn("router ignoring malformed route path={}", routes[i].path);
+        }
+    }
+}
+
+uint32_t Router::Child(uint32_t node, std::string_view segment)
+{
+    auto& children = m_nodes[node].children;
+    auto it = std::lower_bound(children.begin(), children.end(), segment,
+        [this](uint32_t child, std::string_view s) { return m_nodes[child].segment < s; });
+    if (it != children.end() && m_nodes[*it].segment == segment)
+    {
+        return *it;
+    }
+
+    auto index = static_cast<uint32_t>(m_nodes.size());
+    children.insert(it, index);
+    m_nodes.push_back(Node{});
+    m_nodes.back().segment = segment;
+    return index;
+}
+
+bool Router::Add(Route const& route)
+{
+    std::string_view path = route.path;
+    if (path.empty() || path[0] != '/')
+    {
+        return false;
+    }
+
+    std::vector<std::string> names;
+    uint32_t node = 0;
+    std::string_view rest = path.substr(1), segment;
+    bool done = false;
+    while (NextSegment(&rest, &done, &segment))
+    {
+        if (!segment.empty() && segment[0] == ':')
+        {
+            if (segment.size() == 1)
+            {
+                return false;
+            }
+            names.emplace_back(segment.substr(1));
+            if (m_nodes[node].param < 0)
+            {
+                m_nodes[node].param = static_cast<int32_t>(m_nodes.size());
+                m_nodes.push_back(Node{});
+            }
+            node = static_cast<uint32_t>(m_nodes[node].param);
+        }
+        else if (!segment.empty() && segment[0] == '*')
+        {
+            if (!done)
+            {
+                return false;
+            }
+            names.emplace_back(segment.size() > 1 ? segment.substr(1) : segment);
+            if (m_nodes[node].wildcard < 0)
+            {
+                m_nodes[node].wildcard = static_cast<int32_t>(m_nodes.size());
+                m_nodes.push_back(Node{});
+            }
+            node = static_cast<uint32_t>(m_nodes[node].wildcard);
+        }
+        else
+        {
+            node = Child(node, segment);
+        }
+    }
+
+    if (names.size() > static_cast<size_t>(RouteParams::MAX))
+    {
+        return false;
+    }
+
+    auto& end = m_nodes[node];
+    if (end.route)
+    {
+        SPDLOG_DEBUG("router duplicate route path={} kept={}", route.path, end.route->path);
+        return true;
+    }
+    end.route = &route;
+    end.slot = static_cast<int32_t>(m_routes);
+    end.names = std::move(names);
+    m_routes++;
+    m_metrics->AddRoute(route.path);
+    return true;
+}
+
+// Depth-first over the trie, most specific branch first. Captures are pushed as the walk descends
+// and popped when a branch fails; their names are filled in from the route that finally matched.
+//
+bool Router::Walk(uint32_t index, std::string_view rest, bool done, RouteParams* params,
+    uint32_t* out) const
+{
+    auto const& node = m_nodes[index];
+    std::string_view remaining = rest;
+    std::string_view segment;
+    if (!NextSegment(&rest, &done, &segment))
+    {
+        if (!node.route)
+        {
+            return false;
+        }
+        *out = index;
+        return true;
+    }
+
+    auto const& children = node.children;
+    auto it = std::lower_bound(children.begin(), children.end(), segment,
+        [this](uint32_t child, std::string_view s) { return m_nodes[child].segment < s; });
+    if (it != children.end() && m_nodes[*it].segment == segment
+        && Walk(*it, rest, done, params, out))
+    {
+        return true;
+    }
+
+    if (node.param >= 0 && !segment.empty() && params->count < RouteParams::MAX)
+    {
+        params->values[params->count++] = segment;
+        if (Walk(static_cast<uint32_t>(node.param), rest, done, params, out))
+        {
+            return true;
+        }
+        params->count--;
+    }
+
+    if (node.wildcard >= 0 && params->count < RouteParams::MAX)
+    {
+        auto const& wild = m_nodes[static_cast<uint32_t>(node.wildcard)];
+        if (wild.route)
+        {
+            params->values[params->count++] = remaining;
+            *out = static_cast<uint32_t>(node.wildcard);
+            return true;
+        }
+    }
+    return false;
+}
+
+Route const* Router::Match(std::string_view path, RouteParams* params,
+    int* slot /* = nullptr */) const
+{
+    params->count = 0;
+    if (slot)
+    {
+        *slot = -1;
+    }
+    if (path.empty() || path[0] != '/')
+    {
+        return nullptr;
+    }
+
+    uint32_t end;
+    if (!Walk(0, path.substr(1), false, params, &end))
+    {
+        params->count = 0;
+        return nullptr;
+    }
+
+    // The walk pushed exactly one capture per parameter of the route it ended on
+    //
+    auto const& node = m_nodes[end];
+    for (int i = 0; i < params->count; i++)
+    {
+        params->names[i] = node.names[i];
+    }
+    if (slot)
+    {
+        *slot = node.slot;
+    }
+    return node.route;
+}
+
+} // end namespace coop::http
+} // end namespace coop
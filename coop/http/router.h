@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "route_metrics.h"
+
+namespace coop
+{
+namespace http
+{
+
+struct Route;
+
+// Parameters captured by a route match. Views point into the matched path -- for a request, the
+// recv buffer -- so they are valid exactly as long as the RequestLine they came from.
+//
+struct RouteParams
+{
+    static constexpr int MAX = 8;
+
+    // The value captured for name, or an empty view if the route has no such parameter
+    //
+    std::string_view Get(std::string_view name) const
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (names[i] == name)
+            {
+                return values[i];
+            }
+        }
+        return {};
+    }
+
+    std::string_view    names[MAX];
+    std::string_view    values[MAX];
+    int                 count = 0;
+};
+
+// A segment trie over a Route table, built once (RunServer builds one per server) so lookup costs
+// O(path length) regardless of how many routes there are. Route paths are split on '/'; a segment
+// may be
+//
+//   literal    matched exactly
+//   :name      matches any one non-empty segment, captured as name
+//   *name      matches the rest of the path, possibly empty, captured as name (or unnamed as *).
+//              Only valid as the last segment.
+//
+//     /users/:id/posts/:post
+//     /static/*path
+//
+// At each segment a literal match wins over a parameter, and a parameter over a wildcard; a more
+// specific branch that dead-ends further down falls back to the less specific one. Paths ending in
+// '/' are distinct from those without, as with plain string comparison. When two routes have the
+// same shape the first one listed wins.
+//
+struct Router
+{
+    Router() = default;
+    Router(Route const* routes, int count);
+
+    // Add one route, returning false (and ignoring it) if its path is malformed: not starting with
+    // '/', a wildcard that is not last, an empty parameter name, or more than RouteParams::MAX
+    // captures
+    //
+    bool Add(Route const& route);
+
+    // The route matching path, with its captures in *params, or nullptr. With slot, also the
+    // route's index in Metrics() (-1 when nothing matched).
+    //
+    Route const* Match(std::string_view path, RouteParams* params, int* slot = nullptr) const;
+
+    size_t Size() const { return m_routes; }
+
+    // Per-route request metrics, one slot per route in the order Add accepted them (see
+    // route_metrics.h). Written by the server on the router's cooperator.
+    //
+    RouteMetricsTable& Metrics() const { return *m_metrics; }
+
+private:
+    struct Node
+    {
+        std::string             segment;
+
+        // Literal children, kept sorted by segment for binary search
+        //
+        std::vector<uint32_t>   children;
+        int32_t                 param = -1;
+        int32_t                 wildcard = -1;
+
+        // Set on a node that ends a route, with the route's parameter names in capture order
+        //
+        Route const*                    route = nullptr;
+        int32_t                         slot = -1;
+        std::vector<std::string>        names;
+    };
+
+    uint32_t Child(uint32_t node, std::string_view segment);
+    bool Walk(uint32_t node, std::string_view rest, bool done, RouteParams* params,
+        uint32_t* out) const;
+
+    std::vector<Node>   m_nodes{Node{}};
+    size_t              m_routes{0};
+
+    // Behind a pointer so the router stays movable while the registry holds the table's address
+    //
+    std::unique_ptr<RouteMetricsTable> m_metrics{std::make_unique<RouteMetricsTable>()};
+};
+
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,125 @@
+#include "scan.h"
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace coop
+{
+namespace http
+{
+namespace detail
+{
+
+#if defined(__SSE4_1__) || (defined(__ARM_NEON) && defined(__aarch64__))
+
+namespace
+{
+
+// A shuffle control from offset count moves the first count bytes to the end of the register
+// and zeroes the rest (0x80 is zero for pshufb, out of range for tbl)
+//
+alignas(16) constexpr unsigned char ALIGN_RIGHT[32] = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0,    1,    2,    3,    4,    5,    6,    7,    8,    9,    10,   11,   12,   13,   14,   15,
+};
+
+// All 16 bytes hex: a 17th makes it too many
+//
+size_t Count(const char* p, size_t n, size_t count)
+{
+    if (count == 16 && n > 16 && HexDigitValue(p[16]) >= 0)
+    {
+        return 17;
+    }
+    return count;
+}
+
+} // end anonymous namespace
+
+#endif
+
+#if defined(__SSE4_1__)
+
+size_t ParseHex(const char* p, size_t n, uint64_t* value)
+{
+    if (n < 16)
+    {
+        return ParseHexScalar(p, n, value);
+    }
+
+    // Signed compares are fine here: every byte from 0x80 up is negative and fails both ranges
+    //
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                   _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    uint32_t hex = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(digit, letter)));
+    size_t count = static_cast<size_t>(__builtin_ctz(~hex | 0x10000));
+
+    // A digit's value is its low four bits, plus 9 for a letter ('a' is 0x61, 'A' 0x41). With the
+    // digits right-aligned, pairs fold to bytes' worth (x16), pairs of those to 16-bit groups
+    // (x256), and the four groups, most significant first, reverse into one little-endian word.
+    //
+    __m128i nibbles = _mm_add_epi8(_mm_and_si128(v, _mm_set1_epi8(0x0f)),
+                                   _mm_and_si128(letter, _mm_set1_epi8(9)));
+    nibbles = _mm_shuffle_epi8(nibbles,
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(ALIGN_RIGHT + count)));
+    __m128i pairs = _mm_maddubs_epi16(nibbles, _mm_set1_epi16(0x0110));
+    __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00010100));
+    __m128i packed = _mm_packus_epi32(groups, groups);
+    packed = _mm_shufflelo_epi16(packed, _MM_SHUFFLE(0, 1, 2, 3));
+    *value = static_cast<uint64_t>(_mm_cvtsi128_si64(packed));
+    return Count(p, n, count);
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+size_t ParseHex(const char* p, size_t n, uint64_t* value)
+{
+    if (n < 16)
+    {
+        return ParseHexScalar(p, n, value);
+    }
+
+    // Unsigned wrap-around makes each range one compare
+    //
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    uint8x16_t lower = vorrq_u8(v, vdupq_n_u8(0x20));
+    uint8x16_t digit = vcleq_u8(vsubq_u8(v, vdupq_n_u8('0')), vdupq_n_u8(9));
+    uint8x16_t letter = vcleq_u8(vsubq_u8(lower, vdupq_n_u8('a')), vdupq_n_u8(5));
+    uint8x8_t packedMask = vshrn_n_u16(vreinterpretq_u16_u8(vorrq_u8(digit, letter)), 4);
+    uint64_t notHex = ~vget_lane_u64(vreinterpret_u64_u8(packedMask), 0);
+    size_t count = notHex ? static_cast<size_t>(__builtin_ctzll(notHex) >> 2) : 16;
+
+    // As the SSE path, with shifts and masks for the multiply-adds
+    //
+    uint8x16_t nibbles = vaddq_u8(vandq_u8(v, vdupq_n_u8(0x0f)), vandq_u8(letter, vdupq_n_u8(9)));
+    nibbles = vqtbl1q_u8(nibbles, vld1q_u8(ALIGN_RIGHT + count));
+    uint16x8_t lanes = vreinterpretq_u16_u8(nibbles);
+    uint16x8_t pairs = vorrq_u16(vshlq_n_u16(vandq_u16(lanes, vdupq_n_u16(0xff)), 4),
+                                 vshrq_n_u16(lanes, 8));
+    uint32x4_t words = vreinterpretq_u32_u16(pairs);
+    uint32x4_t groups = vorrq_u32(vshlq_n_u32(vandq_u32(words, vdupq_n_u32(0xffff)), 8),
+                                  vshrq_n_u32(words, 16));
+    uint16x4_t packed = vrev64_u16(vmovn_u32(groups));
+    *value = vget_lane_u64(vreinterpret_u64_u16(packed), 0);
+    return Count(p, n, count);
+}
+
+#else
+
+size_t ParseHex(const char* p, size_t n, uint64_t* value)
+{
+    return ParseHexScalar(p, n, value);
+}
+
+#endif
+
+} // end namespace coop::http::detail
+} // end namespace coop::http
+} // end namespace coop
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace coop
+{
+namespace http
+{
+namespace detail
+{
+
+// Delimiter scanning for the request parser: the offset of the first byte in [p, p + n) equal to
+// any of a, b, c or d (repeat one to look for fewer), or n if there is none. memchr already covers
+// a single delimiter; these are the multi-delimiter scans -- path end, query arg boundaries,
+// header name-or-line-end -- that were byte loops.
+//
+// The vector path compares 32 bytes per iteration as two 16-byte registers (SSE2 is part of the
+// x86-64 baseline, NEON of aarch64), then 16, then finishes the tail scalar. Request lines and
+// most header names are short, where the scalar tail does the work; long cookie and auth headers
+// are where the wide loop pays.
+//
+inline size_t FindFirstOfScalar(const char* p, size_t n, char a, char b, char c, char d)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        char x = p[i];
+        if (x == a || x == b || x == c || x == d)
+        {
+            return i;
+        }
+    }
+    return n;
+}
+
+// The JSON string scan (json_writer.h): the offset of the first byte in [p, p + n) that a JSON
+// string cannot carry as is -- '"', '\\' or a control character below 0x20 -- or n. Same strides
+// as FindFirstOf; bytes from 0x80 up are UTF-8 and pass.
+//
+inline bool NeedsJsonEscape(char x)
+{
+    return x == '"' || x == '\\' || static_cast<unsigned char>(x) < 0x20;
+}
+
+inline size_t FindJsonEscapeScalar(const char* p, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        if (NeedsJsonEscape(p[i]))
+        {
+            return i;
+        }
+    }
+    return n;
+}
+
+// 0-15 for a hex digit, -1 for anything else
+//
+inline int HexDigitValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    c = static_cast<char>(c | 0x20);
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Chunk sizes: the number of hex digits at p, looking at no more than n bytes and counting no
+// further than 17 -- 17 meaning too many for 64 bits -- with the value of the first 16 or fewer
+// in *value.
+//
+// ParseHex classifies and converts 16 bytes at once when there are 16 to read -- SSE4.1 on x86
+// (pshufb right-aligns the digits, pmaddubsw and pmaddwd fold them into 16-bit groups), NEON on
+// aarch64 -- and is the scalar loop otherwise. It is out of line (scan.cpp) because those are
+// past the baseline the library's users compile with.
+//
+inline size_t ParseHexScalar(const char* p, size_t n, uint64_t* value)
+{
+    uint64_t v = 0;
+    size_t i = 0;
+    for (; i < n && i < 17; i++)
+    {
+        int digit = HexDigitValue(p[i]);
+        if (digit < 0)
+        {
+            break;
+        }
+        if (i < 16)
+        {
+            v = v << 4 | static_cast<uint64_t>(digit);
+        }
+    }
+    *value = v;
+    return i;
+}
+
+size_t ParseHex(const char* p, size_t n, uint64_t* value);
+
+// A chunk-size line (RFC 9112 7.1): size bytes up to its CR, readable bytes from line on. Hex
+// digits, then nothing or the extensions (';', or whitespace before one), which are ignored.
+// False when it is anything else or too large for 64 bits.
+//
+inline bool ParseChunkSize(const char* line, size_t size, size_t readable, uint64_t* value)
+{
+    size_t digits = ParseHex(line, readable, value);
+    if (digits == 0 || digits > 16 || digits > size)
+    {
+        return false;
+    }
+    char next = digits < size ? line[digits] : ';';
+    return next == ';' || next == ' ' || next == '\t';
+}
+
+#if defined(__SSE2__)
+
+inline uint32_t MatchMask16(const char* p, __m128i a, __m128i b, __m128i c, __m128i d)
+{
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i m = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, a), _mm_cmpeq_epi8(v, b)),
+        _mm_or_si128(_mm_cmpeq_epi8(v, c), _mm_cmpeq_epi8(v, d)));
+    return static_cast<uint32_t>(_mm_movemask_epi8(m));
+}
+
+inline size_t FindFirstOf(const char* p, size_t n, char a, char b, char c, char d)
+{
+    __m128i va = _mm_set1_epi8(a);
+    __m128i vb = _mm_set1_epi8(b);
+    __m128i vc = _mm_set1_epi8(c);
+    __m128i vd = _mm_set1_epi8(d);
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        uint32_t mask = MatchMask16(p + i, va, vb, vc, vd)
+            | (MatchMask16(p + i + 16, va, vb, vc, vd) << 16);
+        if (mask)
+        {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    if (i + 16 <= n)
+    {
+        uint32_t mask = MatchMask16(p + i, va, vb, vc, vd);
+        if (mask)
+        {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+        i += 16;
+    }
+    return i + FindFirstOfScalar(p + i, n - i, a, b, c, d);
+}
+
+// SSE2 compares bytes signed; min_epu8(v, 0x1f) == v is the unsigned v <= 0x1f
+//
+inline uint32_t EscapeMask16(const char* p, __m128i quote, __m128i backslash, __m128i control)
+{
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i m = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+        _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+    return static_cast<uint32_t>(_mm_movemask_epi8(m));
+}
+
+inline size_t FindJsonEscape(const char* p, size_t n)
+{
+    __m128i quote = _mm_set1_epi8('"');
+    __m128i backslash = _mm_set1_epi8('\\');
+    __m128i control = _mm_set1_epi8(0x1f);
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        uint32_t mask = EscapeMask16(p + i, quote, backslash, control)
+            | (EscapeMask16(p + i + 16, quote, backslash, control) << 16);
+        if (mask)
+        {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    if (i + 16 <= n)
+    {
+        uint32_t mask = EscapeMask16(p + i, quote, backslash, control);
+        if (mask)
+        {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+        i += 16;
+    }
+    return i + FindJsonEscapeScalar(p + i, n - i);
+}
+
+#elif defined(__ARM_NEON)
+
+// NEON has no movemask. Narrowing each 16-bit lane pair by 4 bits packs the 16 byte-results into
+// a 64-bit value with one nibble per byte, so the first match is ctz / 4.
+//
+inline uint64_t MatchMask16(const char* p, uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d)
+{
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, a), vceqq_u8(v, b)),
+                            vorrq_u8(vceqq_u8(v, c), vceqq_u8(v, d)));
+    uint8x8_t packed = vshrn_n_u16(vreinterpretq_u16_u8(m), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(packed), 0);
+}
+
+inline size_t FindFirstOf(const char* p, size_t n, char a, char b, char c, char d)
+{
+    uint8x16_t va = vdupq_n_u8(static_cast<uint8_t>(a));
+    uint8x16_t vb = vdupq_n_u8(static_cast<uint8_t>(b));
+    uint8x16_t vc = vdupq_n_u8(static_cast<uint8_t>(c));
+    uint8x16_t vd = vdupq_n_u8(static_cast<uint8_t>(d));
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        uint64_t lo = MatchMask16(p + i, va, vb, vc, vd);
+        if (lo)
+        {
+            return i + static_cast<size_t>(__builtin_ctzll(lo) >> 2);
+        }
+        uint64_t hi = MatchMask16(p + i + 16, va, vb, vc, vd);
+        if (hi)
+        {
+            return i + 16 + static_cast<size_t>(__builtin_ctzll(hi) >> 2);
+        }
+    }
+    if (i + 16 <= n)
+    {
+        uint64_t mask = MatchMask16(p + i, va, vb, vc, vd);
+        if (mask)
+        {
+            return i + static_cast<size_t>(__builtin_ctzll(mask) >> 2);
+        }
+        i += 16;
+    }
+    return i + FindFirstOfScalar(p + i, n - i, a, b, c, d);
+}
+
+inline uint64_t EscapeMask16(const char* p, uint8x16_t quote, uint8x16_t backslash,
+                             uint8x16_t space)
+{
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)),
+                            vcltq_u8(v, space));
+    uint8x8_t packed = vshrn_n_u16(vreinterpretq_u16_u8(m), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(packed), 0);
+}
+
+inline size_t FindJsonEscape(const char* p, size_t n)
+{
+    uint8x16_t quote = vdupq_n_u8('"');
+    uint8x16_t backslash = vdupq_n_u8('\\');
+    uint8x16_t space = vdupq_n_u8(0x20);
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        uint64_t lo = EscapeMask16(p + i, quote, backslash, space);
+        if (lo)
+        {
+            return i + static_cast<size_t>(__builtin_ctzll(lo) >> 2);
+        }
+        uint64_t hi = EscapeMask16(p + i + 16, quote, backslash, space);
+        if (hi)
+        {
+            return i + 16 + static_cast<size_t>(__builtin_ctzll(hi) >> 2);
+        }
+    }
+    if (i + 16 <= n)
+    {
+        uint64_t mask = EscapeMask16(p + i, quote, backslash, space);
+        if (mask)
+        {
+            return i + static_cast<size_t>(__builtin_ctzll(mask) >> 2);
+        }
+        i += 16;
+    }
+    return i + FindJsonEscapeScalar(p + i, n - i);
+}
+
+#else
+
+inline size_t FindFirstOf(const char* p, size_t n, char a, char b, char c, char d)
+{
+    return FindFirstOfScalar(p, n, a, b, c, d);
+}
+
+inline size_t FindJsonEscape(const char* p, size_t n)
+{
+    return FindJsonEscapeScalar(p, n);
+}
+
+#endif
+
+} // end namespace coop::http::detail
+} // end namespace coop::http
+} // end namespace coop
@@ -1,22 +1,53 @@
 #include "server.h"
+#include "admission.h"
+#include "common_headers.h"
 #include "connection.h"
+#include "file_response.h"
+#include "http2.h"
+#include "route_metrics.h"
+#include "router.h"
 #include "transport.h"
 #include "tls_transport.h"
 
+#include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
+#include <linux/filter.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <list>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
 #include "coop/alloc.h"
 #include "coop/cooperator.h"
+#include "coop/cooperator_var.h"
+#include "coop/cooperator_var.hpp"
+#include "coop/coordinate_with.h"
 #include "coop/launchable.h"
+#include "coop/semaphore.h"
+#include "coop/spawn_template.h"
+#include "coop/thread.h"
+#include "coop/topology.h"
+#include "coop/trace.h"
+#include "coop/wait_group.h"
+#include "coop/io/armed_handle.h"
+#include "coop/io/file_cache.h"
 #include "coop/io/io.h"
 #include "coop/io/ssl/connection.h"
 #include "coop/io/ssl/context.h"
+#include "coop/perf/probe.h"
+#include "coop/time/now.h"
 
 namespace coop
 {
@@ -47,9 +78,111 @@ bool HasPathTraversal(const char* path)
     return strstr(path, "..") != nullptr;
 }
 
+// The open-file cache static serving goes through, per cooperator. The first server on a
+// cooperator that serves files creates it and tears it down when it exits; a server sharing the
+// cooperator uses it meanwhile, and serves uncached once it is gone.
+//
+struct StaticFiles
+{
+    io::FileCache* cache = nullptr;
+};
+
+CooperatorVar<StaticFiles> s_staticFiles;
+
+// Route tries, one per server, built when it starts. A connection can still be finishing a request
+// after its server's accept loop has exited, so they live as long as the cooperator does.
+//
+CooperatorVar<std::list<Router>> s_routers;
+
+// Admission state, one per server, kept for the same reason
+//
+CooperatorVar<std::list<AdmissionControl>> s_admissions;
+
+struct StaticFilesScope
+{
+    explicit StaticFilesScope(const char* const* searchPaths)
+    {
+        if (searchPaths && !s_staticFiles->cache)
+        {
+            m_cache.emplace(io::FileCacheOptions{.classify = ContentTypeForExtension});
+            s_staticFiles->cache = &*m_cache;
+        }
+    }
+
+    ~StaticFilesScope()
+    {
+        if (m_cache)
+        {
+            s_staticFiles->cache = nullptr;
+        }
+    }
+
+    std::optional<io::FileCache> m_cache;
+};
+
+// Text types: worth a precompressed sibling lookup. Everything else the table knows is opaque.
+//
+bool Compressible(const char* contentType)
+{
+    return strncmp(contentType, "text/", 5) == 0
+        || strcmp(contentType, "application/javascript") == 0
+        || strcmp(contentType, "application/json") == 0;
+}
+
+// Answer with one file, if it exists, as contentType with the given coding: conditional and range
+// requests included (file_response.h). Returns true if it was found.
+//
+bool SendStaticFile(ConnectionBase& conn, FileConditions const& conditions, const char* filePath,
+                    const char* contentType, ContentEncoding encoding)
+{
+    if (auto* cache = s_staticFiles->cache)
+    {
+        auto file = cache->Open(filePath);
+        if (!file)
+        {
+            return false;
+        }
+
+        // The lease keeps the fd open across the send even if the file changes meanwhile
+        //
+        SendFileResponse(conn, conditions, FileInfo{
+            .fd = file->desc.m_fd,
+            .size = file->size,
+            .mtimeNs = file->mtimeNs,
+            .contentType = contentType,
+            .encoding = encoding,
+        });
+        return true;
+    }
+
+    int fileFd = ::open(filePath, O_RDONLY);
+    if (fileFd < 0) return false;
+
+    struct stat st;
+    if (::fstat(fileFd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        ::close(fileFd);
+        return false;
+    }
+
+    SendFileResponse(conn, conditions, FileInfo{
+        .fd = fileFd,
+        .size = uint64_t(st.st_size),
+        .mtimeNs = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec,
+        .contentType = contentType,
+        .encoding = encoding,
+    });
+
+    ::close(fileFd);
+    return true;
+}
+
 // Try to serve a static file matching the requested path from the search paths.
 // Returns true if a file was found and served.
 //
+// A text file with a precompressed sibling -- "app.js.zst", "app.js.gz" -- goes out as the sibling
+// to a client that accepts its coding, zstd first, still sendfile'd as it lies on disk.
+//
 bool ServeFile(ConnectionBase& conn, std::string_view reqPath,
                const char* const* searchPaths)
 {
@@ -68,7 +201,23 @@ bool ServeFile(ConnectionBase& conn, std::string_view reqPath,
         uriPath = "/index.html";
     }
 
+    // Accept-Encoding goes by with the rest (the parser keeps it), so one pass over the headers
+    //
+    FileConditions conditions;
+    conditions.Read(conn);
+    auto const& accepted = conn.AcceptedEncodings();
+
+    static constexpr struct
+    {
+        ContentEncoding encoding;
+        const char*     suffix;
+    } kSiblings[] = {
+        { ContentEncoding::ZSTD, ".zst" },
+        { ContentEncoding::GZIP, ".gz" },
+    };
+
     char filePath[512];
+    char siblingPath[520];
 
     for (const char* const* sp = searchPaths; *sp != nullptr; sp++)
     {
@@ -78,34 +227,58 @@ bool ServeFile(ConnectionBase& conn, std::string_view reqPath,
             continue;
         }
 
-        int fileFd = ::open(filePath, O_RDONLY);
-        if (fileFd < 0) continue;
-
-        struct stat st;
-        if (::fstat(fileFd, &st) != 0 || !S_ISREG(st.st_mode))
+        const char* ct = ContentTypeForExtension(filePath);
+        if (Compressible(ct))
         {
-            ::close(fileFd);
-            continue;
+            for (auto const& sibling : kSiblings)
+            {
+                if (!accepted.Accepts(sibling.encoding))
+                {
+                    continue;
+                }
+                snprintf(siblingPath, sizeof(siblingPath), "%s%s", filePath, sibling.suffix);
+                if (SendStaticFile(conn, conditions, siblingPath, ct, sibling.encoding))
+                {
+                    return true;
+                }
+            }
         }
 
-        const char* ct = ContentTypeForExtension(filePath);
-        conn.SendHeaders(200, ct, st.st_size);
-
-        if (st.st_size > 0)
+        if (SendStaticFile(conn, conditions, filePath, ct, ContentEncoding::IDENTITY))
         {
-            conn.Sendfile(fileFd, 0, st.st_size);
+            return true;
         }
-
-        ::close(fileFd);
-        return true;
     }
 
     return false;
 }
 
-void HandleRequest(ConnectionBase& conn, const Route* routes, int routeCount,
-                   const char* const* searchPaths)
+void Dispatch(ConnectionBase& conn, Router const& router, const char* const* searchPaths,
+              std::string_view path, int* slot)
+{
+    if (auto* route = router.Match(path, &conn.m_params, slot))
+    {
+        route->handler(conn);
+        return;
+    }
+
+    if (searchPaths && ServeFile(conn, path, searchPaths))
+    {
+        return;
+    }
+
+    conn.Send(404, "text/plain", "Not Found\n");
+}
+
+// Answer one request. Returns false, having sent nothing, when admission sheds it: the caller
+// answers 503 (ShedRequest) and, on HTTP/1.1, closes. An admitted request holds off its
+// cooperator's drain (DrainHold) until answered, and is charged to its route's metrics once it is.
+//
+bool HandleRequest(ConnectionBase& conn, Router const& router, const char* const* searchPaths,
+                   AdmissionControl& admission)
 {
+    const uint64_t bytesIn = conn.m_bytesIn;
+    const uint64_t bytesOut = conn.m_bytesOut;
     auto* req = conn.GetRequestLine();
     if (!req)
     {
@@ -113,24 +286,96 @@ void HandleRequest(ConnectionBase& conn, const Route* routes, int routeCount,
         {
             conn.Send(400, "text/plain", "Bad Request\n");
         }
-        return;
+        return true;
     }
 
-    for (int i = 0; i < routeCount; i++)
+    if (!admission.BeginRequest(Self()))
     {
-        if (req->path == routes[i].path)
-        {
-            routes[i].handler(conn);
-            return;
-        }
+        return false;
+    }
+    DrainHold hold(conn.GetCooperator());
+
+    auto& metrics = router.Metrics();
+    SlowRequest sample;
+    const bool sampling = metrics.BeginSample(*req, sample);
+    conn.m_responseStatus = 0;
+    int slot = -1;
+
+    // One clock pair times the handler for the route's metrics, the HttpHandler histogram and
+    // the adaptive limit alike
+    //
+    const int64_t begin = time::MonotonicNanos();
+    {
+        trace::Span span("http.server", trace::Kind::Server);
+        Dispatch(conn, router, searchPaths, req->path, &slot);
     }
+    const int64_t end = time::MonotonicNanos();
+    const uint64_t elapsed = end > begin ? static_cast<uint64_t>(end - begin) : 0;
+    metrics.Record(conn.GetCooperator(), slot, sampling ? &sample : nullptr, conn.m_responseStatus,
+                   conn.m_bytesIn - bytesIn, conn.m_bytesOut - bytesOut, elapsed);
 
-    if (searchPaths && ServeFile(conn, req->path, searchPaths))
+    COOP_PERF_RECORD(conn.GetCooperator()->GetPerfHistograms(), perf::Hist::HttpHandler, elapsed);
+    admission.EndRequest(std::chrono::duration_cast<time::Interval>(
+        std::chrono::nanoseconds(elapsed)));
+    return true;
+}
+
+// The canned 503 for a shed request. On HTTP/1.1 it says Connection: close, and the request it
+// answers is left unread, so the caller closes; a stream gets the same answer formatted.
+//
+void ShedRequest(ConnectionBase& conn, bool http1)
+{
+    if (http1)
     {
+        conn.SendRawBytes(response::SERVICE_UNAVAILABLE, sizeof(response::SERVICE_UNAVAILABLE) - 1);
         return;
     }
+    conn.SetResponseHeaders("Retry-After: 1\r\n");
+    conn.Send(503, "text/plain", "Service Unavailable\n");
+}
 
-    conn.Send(404, "text/plain", "Not Found\n");
+// A connection over maxConnections gets the 503 straight from the accept loop: one nonblocking
+// send on the fresh socket, then close, with no context launched. Best effort -- a client whose
+// request is already unread in the socket may see a reset instead.
+//
+void RejectConnection(int fd)
+{
+    (void)::send(fd, response::SERVICE_UNAVAILABLE, sizeof(response::SERVICE_UNAVAILABLE) - 1,
+                 MSG_DONTWAIT | MSG_NOSIGNAL);
+    close(fd);
+}
+
+// Most pipelined responses held back for one send. The bytes are bounded by the send buffer, which
+// flushes when full.
+//
+constexpr size_t kMaxBatchedResponses = 16;
+
+// Between requests on a keep-alive loop. A pipelined request already buffered is answered before
+// the responses so far are sent, up to kMaxBatchedResponses; otherwise they go now. Returns false
+// when the connection should close.
+//
+template<typename Conn>
+bool NextRequest(Conn& conn, size_t* batched)
+{
+    // Held from HandleRequest's without a yield between, so a drain's Shutdown waits for the
+    // batched responses to go out
+    //
+    DrainHold hold(conn.GetCooperator());
+    if (conn.SendError()) return false;
+    if (!conn.KeepAlive())
+    {
+        conn.FlushResponses();
+        return false;
+    }
+
+    conn.SkipBody();
+    conn.Reset();
+    if (++*batched < kMaxBatchedResponses && conn.PipelinedRequestReady())
+    {
+        return true;
+    }
+    *batched = 0;
+    return conn.FlushResponses();
 }
 
 // -------------------------------------------------------------------------------------
@@ -140,49 +385,171 @@ void HandleRequest(ConnectionBase& conn, const Route* routes, int routeCount,
 struct HttpConnection : Launchable
 {
     HttpConnection(Context* ctx, int fd, Cooperator* co,
-                   const Route* routes, int routeCount,
+                   Router const* router,
                    const char* const* searchPaths,
-                   time::Interval timeout)
+                   time::Interval timeout,
+                   bool fixedBuffers,
+                   bool multishotRecv,
+                   AdmissionControl* admission)
     : Launchable(ctx)
-    , m_fd(fd)
+    , m_fd(io::registered, fd)
     , m_shutdownGuard(ctx, m_fd)
     , m_co(co)
-    , m_routes(routes)
-    , m_routeCount(routeCount)
+    , m_router(router)
     , m_searchPaths(searchPaths)
     , m_timeout(timeout)
+    , m_fixedBuffers(fixedBuffers)
+    , m_multishotRecv(multishotRecv)
+    , m_admission(admission)
     {
         fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
         ctx->SetName("HttpConnection");
     }
 
+    ~HttpConnection()
+    {
+        m_admission->ConnectionClosed();
+    }
+
     virtual void Launch() final
     {
+        if (m_multishotRecv && LaunchArmed())
+        {
+            return;
+        }
+        if (m_fixedBuffers && LaunchRegistered())
+        {
+            return;
+        }
+
         using Conn = Connection<PlaintextTransport>;
         PlaintextTransport transport(m_fd);
         auto conn = GetContext()->Allocate<Conn>(
             Conn::ExtraBytes(), transport, GetContext(), m_co,
             ConnectionBase::DEFAULT_BUFFER_SIZE, ConnectionBase::DEFAULT_SEND_BUFFER_SIZE,
             m_timeout);
+        Serve(*conn);
+    }
+
+    // Lay the Connection out in one of the ring's registered buffers, the recv buffer taking
+    // whatever the send buffer leaves, so every recv and buffered send is a fixed op. Returns false
+    // (the caller falls back to a context allocation) when the pool is absent or exhausted.
+    //
+    bool LaunchRegistered()
+    {
+        using Conn = Connection<RegisteredTransport>;
+        auto* ring = m_fd.m_ring;
+        size_t header = sizeof(Conn) + ConnectionBase::DEFAULT_SEND_BUFFER_SIZE;
+        if (ring->FixedBufferSize() < header + ConnectionBase::DEFAULT_BUFFER_SIZE)
+        {
+            return false;
+        }
+        auto fixed = ring->AcquireFixedBuffer();
+        if (!fixed.data)
+        {
+            return false;
+        }
+
+        RegisteredTransport transport(m_fd);
+        auto* conn = new (fixed.data) Conn(
+            transport, GetContext(), m_co, ring->FixedBufferSize() - header,
+            ConnectionBase::DEFAULT_SEND_BUFFER_SIZE, m_timeout);
+        Serve(*conn);
+        conn->~Conn();
+        ring->ReleaseFixedBuffer(fixed.index);
+        return true;
+    }
+
+    // Receive on one multishot recv from the ring's default BufferRing, and hold a Connection --
+    // parser state and recv buffer -- only while requests are in flight: it is built when bytes
+    // arrive on an idle connection and torn down again once every buffered byte has been answered.
+    // Returns false (the caller falls back) when the ring has no buffer ring.
+    //
+    bool LaunchArmed()
+    {
+        auto* ring = m_fd.m_ring->GetBufferRing();
+        if (!ring)
+        {
+            return false;
+        }
+
+        using Conn = Connection<ArmedTransport>;
+        ArmedStream stream(GetContext(), m_fd, ring);
+        size_t bytes = sizeof(Conn) + Conn::ExtraBytes();
+
+        while (!GetContext()->IsKilled() && stream.Wait(m_timeout))
+        {
+            void* block = malloc(bytes);
+            if (!block)
+            {
+                break;
+            }
+            auto* conn = new (block) Conn(
+                ArmedTransport(m_fd, stream), GetContext(), m_co,
+                ConnectionBase::DEFAULT_BUFFER_SIZE, ConnectionBase::DEFAULT_SEND_BUFFER_SIZE,
+                m_timeout);
+            bool open = ServeBuffered(*conn, stream);
+            conn->~Conn();
+            free(conn);
+            if (!open)
+            {
+                break;
+            }
+        }
+        return true;
+    }
 
+    // Serve until nothing is left to parse, either in the Connection or in the stream's chunk.
+    // Returns false when the connection should close.
+    //
+    template<typename Conn>
+    bool ServeBuffered(Conn& conn, ArmedStream& stream)
+    {
+        size_t batched = 0;
+        conn.SetResponseBatching(true);
         while (!GetContext()->IsKilled())
         {
-            HandleRequest(*conn, m_routes, m_routeCount, m_searchPaths);
+            if (!HandleRequest(conn, *m_router, m_searchPaths, *m_admission))
+            {
+                ShedRequest(conn, true);
+                return false;
+            }
 
-            if (conn->SendError() || !conn->KeepAlive()) return;
+            if (!NextRequest(conn, &batched)) return false;
+            if (conn.LeftoverSize() == 0 && !stream.Buffered())
+            {
+                return conn.FlushResponses();
+            }
+        }
+        return false;
+    }
+
+    template<typename Conn>
+    void Serve(Conn& conn)
+    {
+        size_t batched = 0;
+        conn.SetResponseBatching(true);
+        while (!GetContext()->IsKilled())
+        {
+            if (!HandleRequest(conn, *m_router, m_searchPaths, *m_admission))
+            {
+                ShedRequest(conn, true);
+                return;
+            }
 
-            conn->SkipBody();
-            conn->Reset();
+            if (!NextRequest(conn, &batched)) return;
         }
     }
 
     io::Descriptor      m_fd;
     io::ShutdownOnKillGuard m_shutdownGuard;
     Cooperator*         m_co;
-    const Route*        m_routes;
-    int                 m_routeCount;
+    Router const*       m_router;
     const char* const*  m_searchPaths;
     time::Interval      m_timeout;
+    bool                m_fixedBuffers;
+    bool                m_multishotRecv;
+    AdmissionControl*   m_admission;
 };
 
 // -------------------------------------------------------------------------------------
@@ -192,19 +559,20 @@ struct HttpConnection : Launchable
 struct HttpTlsConnection : Launchable
 {
     HttpTlsConnection(Context* ctx, int fd, Cooperator* co,
-                      const Route* routes, int routeCount,
+                      Router const* router,
                       io::ssl::Context& sslCtx,
                       const char* const* searchPaths,
-                      time::Interval timeout)
+                      time::Interval timeout,
+                      AdmissionControl* admission)
     : Launchable(ctx)
-    , m_fd(fd)
+    , m_fd(io::registered, fd)
     , m_shutdownGuard(ctx, m_fd)
     , m_co(co)
-    , m_routes(routes)
-    , m_routeCount(routeCount)
+    , m_router(router)
     , m_sslCtx(sslCtx)
     , m_searchPaths(searchPaths)
     , m_timeout(timeout)
+    , m_admission(admission)
     {
         fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
 
@@ -219,12 +587,31 @@ struct HttpTlsConnection : Launchable
         ctx->SetName("HttpTlsConnection");
     }
 
+    ~HttpTlsConnection()
+    {
+        m_admission->ConnectionClosed();
+    }
+
     virtual void Launch() final
     {
-        char sslBuf[io::ssl::Connection::BUFFER_SIZE];
-        io::ssl::Connection sslConn(m_sslCtx, m_fd, sslBuf, sizeof(sslBuf));
+        // Pooled staging: a keep-alive connection waiting on its next request holds no staging
+        // buffer, and HTTP/2's reader and stream contexts each borrow their own
+        //
+        io::ssl::Connection sslConn(m_sslCtx, m_fd);
         if (sslConn.HandshakeKill() != 0) return;
 
+        if (sslConn.AlpnProtocol() == "h2")
+        {
+            ServeHttp2(GetContext(), TlsTransport(sslConn, m_fd), [this](ConnectionBase& conn)
+            {
+                if (!HandleRequest(conn, *m_router, m_searchPaths, *m_admission))
+                {
+                    ShedRequest(conn, false);
+                }
+            });
+            return;
+        }
+
         using Conn = Connection<TlsTransport>;
         TlsTransport transport(sslConn, m_fd);
         auto conn = GetContext()->Allocate<Conn>(
@@ -232,75 +619,523 @@ struct HttpTlsConnection : Launchable
             ConnectionBase::DEFAULT_BUFFER_SIZE, ConnectionBase::DEFAULT_SEND_BUFFER_SIZE,
             m_timeout);
 
+        size_t batched = 0;
+        conn->SetResponseBatching(true);
         while (!GetContext()->IsKilled())
         {
-            HandleRequest(*conn, m_routes, m_routeCount, m_searchPaths);
-
-            if (conn->SendError() || !conn->KeepAlive()) return;
+            if (!HandleRequest(*conn, *m_router, m_searchPaths, *m_admission))
+            {
+                ShedRequest(*conn, true);
+                return;
+            }
 
-            conn->SkipBody();
-            conn->Reset();
+            if (!NextRequest(*conn, &batched)) return;
         }
     }
 
     io::Descriptor      m_fd;
     io::ShutdownOnKillGuard m_shutdownGuard;
     Cooperator*         m_co;
-    const Route*        m_routes;
-    int                 m_routeCount;
+    Router const*       m_router;
     io::ssl::Context&   m_sslCtx;
     const char* const*  m_searchPaths;
     time::Interval      m_timeout;
+    AdmissionControl*   m_admission;
 };
 
-} // end anonymous namespace
+// A draining cooperator's listeners stop accepting: the accept in flight is cancelled, not the
+// socket shut down, so a successor that inherited the listener keeps taking its connections
+//
+struct StopAccepting : DrainHook
+{
+    StopAccepting(Cooperator* co, io::Descriptor& desc, io::ArmedHandle* accepts)
+    : DrainHook(co)
+    , desc(desc)
+    , accepts(accepts)
+    {
+    }
 
-void RunServer(
-    Context* ctx,
-    int port,
-    const Route* routes,
-    int routeCount,
-    const char* name /* = "HttpServer" */,
-    const char* const* searchPaths /* = nullptr */,
-    time::Interval timeout /* = std::chrono::seconds(30) */)
+    void OnDrain() override
+    {
+        stopped = true;
+        if (accepts)
+        {
+            accepts->Cancel();
+        }
+        else
+        {
+            desc.Cancel();
+        }
+    }
+
+    io::Descriptor&     desc;
+    io::ArmedHandle*    accepts;
+    bool                stopped = false;
+};
+
+// Accept on desc until the context is killed or the accept fails, handing each connection's fd to
+// launch. The multishot form keeps one accept armed for the whole loop; its queued-but-unlaunched
+// connections are closed when the loop exits.
+//
+// Connections are the loop context's children, so when a drain stops the loop it stays parked
+// until the drain's Shutdown kills it, and them with it.
+//
+template<typename Launch>
+void AcceptLoop(Context* ctx, io::Descriptor& desc, bool multishot, Launch const& launch)
 {
-    ctx->SetName(name);
+    if (!multishot)
+    {
+        StopAccepting drain(ctx->GetCooperator(), desc, nullptr);
+        while (!ctx->IsKilled() && !drain.stopped)
+        {
+            int fd = io::AcceptKill(desc);
+            if (fd < 0)
+            {
+                break;
+            }
+            launch(fd);
+            ctx->Yield();
+        }
+        if (drain.stopped)
+        {
+            CoordinateWith(ctx, ctx->GetKilledSignal());
+        }
+        return;
+    }
+
+    Coordinator coord;
+    io::ArmedHandle accepts(io::accepting, ctx, desc, &coord);
+    StopAccepting drain(ctx->GetCooperator(), desc, &accepts);
+    accepts.Arm();
+    while (!ctx->IsKilled())
+    {
+        int fd = accepts.AcceptKill();
+        if (fd < 0)
+        {
+            break;
+        }
+        launch(fd);
+        ctx->Yield();
+    }
+    if (drain.stopped)
+    {
+        CoordinateWith(ctx, ctx->GetKilledSignal());
+    }
+}
+
+// Busy-poll the listener's connections when the cooperator busy-polls its ring: accepted sockets
+// inherit the listener's SO_BUSY_POLL
+//
+void BusyPollListener(io::Descriptor& desc)
+{
+    if (int err = io::SetBusyPoll(desc); err < 0)
+    {
+        spdlog::warn("server listener SO_BUSY_POLL failed err={}", err);
+    }
+}
 
+// Bind a nonblocking SO_REUSEPORT listener on port. Returns the fd, or -1.
+//
+int Listen(int port, ListenerConfiguration const& config)
+{
     int serverFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
-    assert(serverFd > 0);
+    if (serverFd < 0)
+    {
+        return -1;
+    }
 
     int on = 1;
-    int ret = setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
-    assert(ret == 0);
-    ret = setsockopt(serverFd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
-    assert(ret == 0);
-
     struct sockaddr_in addr;
     addr.sin_family = AF_INET;
     addr.sin_port = htons(port);
     addr.sin_addr.s_addr = INADDR_ANY;
 
-    ret = bind(serverFd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in));
-    assert(ret == 0);
+    if (setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0
+        || setsockopt(serverFd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0
+        || bind(serverFd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in)) != 0
+        || listen(serverFd, 512) != 0)
+    {
+        close(serverFd);
+        return -1;
+    }
+
+    // Neither is worth failing the listener over: without them it accepts as it always has
+    //
+    if (config.fastOpenQueue > 0
+        && setsockopt(serverFd, IPPROTO_TCP, TCP_FASTOPEN, &config.fastOpenQueue,
+                      sizeof(config.fastOpenQueue)) != 0)
+    {
+        spdlog::warn("server listener TCP_FASTOPEN failed errno={}", errno);
+    }
+    if (config.deferAcceptSeconds > 0
+        && setsockopt(serverFd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &config.deferAcceptSeconds,
+                      sizeof(config.deferAcceptSeconds)) != 0)
+    {
+        spdlog::warn("server listener TCP_DEFER_ACCEPT failed errno={}", errno);
+    }
+    return serverFd;
+}
+
+// What a plaintext server launches each accepted connection with
+//
+struct ServeState
+{
+    Router const*       router;
+    const char* const*  searchPaths;
+    time::Interval      timeout;
+    bool                fixedBuffers;
+    bool                multishotRecv;
+    AdmissionControl*   admission;
 
-    ret = listen(serverFd, 512);
-    assert(ret == 0);
+    // Serve's launch site for HttpConnection, on its cooperator
+    //
+    SpawnTemplate<HttpConnection>* connections;
+};
 
+void LaunchConnection(Cooperator* co, ServeState const& state, int fd)
+{
+    if (!state.admission->AdmitConnection())
+    {
+        RejectConnection(fd);
+        return;
+    }
+    state.connections->Launch(fd, co, state.router, state.searchPaths, state.timeout,
+                              state.fixedBuffers, state.multishotRecv, state.admission);
+}
+
+// A RunServerGroup member, as the others hand connections to it (handoffByIncomingCpu)
+//
+struct GroupMember
+{
+    Cooperator* co = nullptr;
+
+    // Set by Serve while it accepts. Only the member's own thread touches it: handoffs run there.
+    //
+    ServeState const* serving = nullptr;
+
+    // Cpu id -> the member pinned there, shared by the group; nullptr without handoff
+    //
+    std::vector<GroupMember*> const* byCpu = nullptr;
+};
+
+// An accepted connection submitted to another member, launched there against that member's
+// admission. It owns the fd until then: a submission dropped at shutdown closes it, as does a
+// member that stopped serving before the handoff ran.
+//
+struct Handoff
+{
+    Handoff(GroupMember* target, int fd) : m_target(target), m_fd(fd) {}
+    Handoff(Handoff&& other) : m_target(other.m_target), m_fd(std::exchange(other.m_fd, -1)) {}
+    Handoff(Handoff const&) = delete;
+
+    ~Handoff()
+    {
+        if (m_fd >= 0) close(m_fd);
+    }
+
+    void operator()(Context* ctx)
+    {
+        if (m_target->serving)
+        {
+            LaunchConnection(ctx->GetCooperator(), *m_target->serving, Release());
+        }
+    }
+
+    int Release() { return std::exchange(m_fd, -1); }
+
+    GroupMember* m_target;
+    int m_fd;
+};
+
+// The member pinned to the CPU that last received fd's packets (SO_INCOMING_CPU), if it is not
+// self; nullptr to serve the connection where it was accepted
+//
+GroupMember* HandoffTarget(GroupMember const* self, int fd)
+{
+    int cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if (getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) != 0 || cpu < 0
+        || static_cast<size_t>(cpu) >= self->byCpu->size())
+    {
+        return nullptr;
+    }
+    auto* target = (*self->byCpu)[cpu];
+    return target == self ? nullptr : target;
+}
+
+// Serve plaintext HTTP on an already-listening serverFd until the context is killed. A group
+// member (self) first offers each connection to the member on its incoming CPU.
+//
+void Serve(
+    Context* ctx,
+    int serverFd,
+    const Route* routes,
+    int routeCount,
+    const char* const* searchPaths,
+    time::Interval timeout,
+    bool multishotAccept,
+    bool fixedBuffers,
+    bool multishotRecv,
+    AdmissionConfiguration const& admissionConfig,
+    GroupMember* self = nullptr)
+{
     auto* co = ctx->GetCooperator();
     io::Descriptor desc(serverFd);
+    BusyPollListener(desc);
+    auto const& router = s_routers->emplace_back(routes, routeCount);
+    auto& admission = s_admissions->emplace_back(admissionConfig);
+    SpawnTemplate<HttpConnection> connections(co, {.priority = 0, .stackSize = 32768});
+    const ServeState state = {&router, searchPaths, timeout, fixedBuffers, multishotRecv,
+                              &admission, &connections};
+    if (self)
+    {
+        self->serving = &state;
+    }
+    StaticFilesScope files(searchPaths);
+    response::DateClock date(ctx);
 
-    while (!ctx->IsKilled())
+    AcceptLoop(ctx, desc, multishotAccept, [&](int fd)
     {
-        int fd = io::AcceptKill(desc);
-        if (fd < 0)
+        auto* target = self && self->byCpu ? HandoffTarget(self, fd) : nullptr;
+        if (target)
         {
-            break;
+            // A member already shutting down refuses the submission without taking the fd, and
+            // the connection is served here instead
+            //
+            Handoff handoff(target, fd);
+            if (target->co->Submit(std::move(handoff)))
+            {
+                return;
+            }
+            fd = handoff.Release();
         }
+        LaunchConnection(co, state, fd);
+    });
 
-        static constexpr SpawnConfiguration config = {.priority = 0, .stackSize = 32768};
-        co->Launch<HttpConnection>(config, fd, co, routes, routeCount, searchPaths, timeout);
-        ctx->Yield();
+    if (self)
+    {
+        self->serving = nullptr;
+    }
+}
+
+// Attach a classic BPF reuseport program to the group fd belongs to: the receiving CPU picks the
+// listener whose cooperator is pinned there. cpus[i] is listener i's core; a CPU hosting no
+// listener falls back to cpu % n, so every connection still lands somewhere deterministic.
+//
+bool SteerByCpu(int fd, std::vector<int> const& cpus)
+{
+    auto n = static_cast<uint32_t>(cpus.size());
+    std::vector<sock_filter> prog;
+    prog.reserve(2 * n + 3);
+    prog.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)));
+    for (uint32_t i = 0; i < n; i++)
+    {
+        prog.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(cpus[i]), 0, 1));
+        prog.push_back(BPF_STMT(BPF_RET | BPF_K, i));
+    }
+    prog.push_back(BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, n));
+    prog.push_back(BPF_STMT(BPF_RET | BPF_A, 0));
+    if (prog.size() > BPF_MAXINSNS)
+    {
+        return false;
+    }
+
+    sock_fprog fprog = {static_cast<unsigned short>(prog.size()), prog.data()};
+    return setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &fprog, sizeof(fprog)) == 0;
+}
+
+// -------------------------------------------------------------------------------------
+// Stackless HTTP connections
+// -------------------------------------------------------------------------------------
+
+struct StacklessConnection;
+struct StacklessRequest;
+
+// What a stackless server's connections share. It outlives them: the server waits on open, which
+// counts every connection and the promoter, before it returns.
+//
+struct StacklessServer
+{
+    StacklessServer(Router const* router, const char* const* searchPaths, time::Interval timeout,
+                    AdmissionControl* admission, SpawnTemplate<StacklessRequest>* requests)
+    : router(router)
+    , searchPaths(searchPaths)
+    , timeout(timeout)
+    , admission(admission)
+    , requests(requests)
+    , readyCount(0)
+    {
+    }
+
+    Router const*                       router;
+    const char* const*                  searchPaths;
+    time::Interval                      timeout;
+    AdmissionControl*                   admission;
+    SpawnTemplate<StacklessRequest>*    requests;
+
+    EmbeddedList<StacklessConnection>   idle;       // poll armed
+    EmbeddedList<StacklessConnection>   ready;      // readable, for the promoter to launch
+    Semaphore                           readyCount;
+    WaitGroup                           open;
+    bool                                stopping = false;
+};
+
+// A connection between requests: its socket and one POLLIN poll on a continuation-driven Handle.
+// It holds no context, stack or recv buffer. Turning readable, it is queued for the promoter,
+// which launches a StacklessRequest on it; timed out, failed or cancelled, it closes itself from
+// the reap loop.
+//
+struct StacklessConnection final : Continuation, EmbeddedListHookups<StacklessConnection>
+{
+    StacklessConnection(StacklessServer* server, int fd)
+    : m_server(server)
+    , m_fd(io::registered, fd)
+    , m_poll(m_fd, static_cast<Continuation*>(this))
+    {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        server->open.Add();
+    }
+
+    ~StacklessConnection()
+    {
+        m_server->admission->ConnectionClosed();
+        m_server->open.Done();
+    }
+
+    // Wait, without a context, for the next request's first bytes, up to the keep-alive timeout.
+    // Returns false, and the caller closes, when no SQE could be had.
+    //
+    bool Idle()
+    {
+        if (!io::Poll(m_poll, POLLIN, io::CoarseTimeout(m_server->timeout)))
+        {
+            return false;
+        }
+        m_server->idle.Push(this);
+        return true;
+    }
+
+    void Run() final
+    {
+        m_server->idle.Remove(this);
+        if (m_poll.Result() <= 0 || m_server->stopping)
+        {
+            // There is no context here for io::Close: the descriptor gives the fd up, clearing
+            // its ring slot as it goes, and the socket is closed directly
+            //
+            int fd = m_fd.Release();
+            delete this;
+            close(fd);
+            return;
+        }
+        m_server->ready.Push(this);
+        m_server->readyCount.Release();
+    }
+
+    StacklessServer*    m_server;
+    io::Descriptor      m_fd;
+    io::Handle          m_poll;
+};
+
+// A connection's requests, on a context: it serves until nothing buffered is left to answer and
+// hands the connection back to Idle, its recv buffer and stack going with the context.
+//
+struct StacklessRequest : Launchable
+{
+    StacklessRequest(Context* ctx, StacklessConnection* conn)
+    : Launchable(ctx)
+    , m_conn(conn)
+    {
+        ctx->SetName("HttpStacklessRequest");
+    }
+
+    virtual void Launch() final
+    {
+        if (!Serve() || GetContext()->IsKilled() || m_conn->m_server->stopping
+            || !m_conn->Idle())
+        {
+            delete m_conn;
+        }
+    }
+
+    // Returns false when the connection should close
+    //
+    bool Serve()
+    {
+        auto& server = *m_conn->m_server;
+        io::ShutdownOnKillGuard shutdownGuard(GetContext(), m_conn->m_fd);
+
+        using Conn = Connection<PlaintextTransport>;
+        PlaintextTransport transport(m_conn->m_fd);
+        auto conn = GetContext()->Allocate<Conn>(
+            Conn::ExtraBytes(), transport, GetContext(), GetContext()->GetCooperator(),
+            ConnectionBase::DEFAULT_BUFFER_SIZE, ConnectionBase::DEFAULT_SEND_BUFFER_SIZE,
+            server.timeout);
+
+        size_t batched = 0;
+        conn->SetResponseBatching(true);
+        while (!GetContext()->IsKilled())
+        {
+            if (!HandleRequest(*conn, *server.router, server.searchPaths, *server.admission))
+            {
+                ShedRequest(*conn, true);
+                return false;
+            }
+
+            if (!NextRequest(*conn, &batched)) return false;
+            if (conn->LeftoverSize() == 0)
+            {
+                return conn->FlushResponses();
+            }
+        }
+        return false;
+    }
+
+    StacklessConnection* m_conn;
+};
+
+// Launch a StacklessRequest for each connection that turns readable, until killed. Those still
+// queued then are closed.
+//
+void PromoteReady(Context* ctx, StacklessServer& server)
+{
+    while (server.readyCount.AcquireWithKill(ctx, 1).index == 0)
+    {
+        auto* conn = server.ready.Pop();
+        if (!server.requests->Launch(conn))
+        {
+            delete conn;
+        }
     }
+    while (auto* conn = server.ready.Pop())
+    {
+        delete conn;
+    }
+}
+
+} // end anonymous namespace
+
+void RunServer(
+    Context* ctx,
+    int port,
+    const Route* routes,
+    int routeCount,
+    const char* name /* = "HttpServer" */,
+    const char* const* searchPaths /* = nullptr */,
+    time::Interval timeout /* = std::chrono::seconds(30) */,
+    bool multishotAccept /* = false */,
+    bool fixedBuffers /* = false */,
+    bool multishotRecv /* = false */,
+    AdmissionConfiguration const& admission /* = {} */,
+    ListenerConfiguration const& listener /* = {} */)
+{
+    ctx->SetName(name);
+
+    int serverFd = Listen(port, listener);
+    assert(serverFd > 0);
+
+    Serve(ctx, serverFd, routes, routeCount, searchPaths, timeout, multishotAccept, fixedBuffers,
+          multishotRecv, admission);
 }
 
 void RunTlsServer(
@@ -311,48 +1146,242 @@ void RunTlsServer(
     io::ssl::Context& sslCtx,
     const char* name /* = "HttpsServer" */,
     const char* const* searchPaths /* = nullptr */,
-    time::Interval timeout /* = std::chrono::seconds(30) */)
+    time::Interval timeout /* = std::chrono::seconds(30) */,
+    bool multishotAccept /* = false */,
+    AdmissionConfiguration const& admissionConfig /* = {} */,
+    ListenerConfiguration const& listener /* = {} */)
 {
     ctx->SetName(name);
 
-    int serverFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    int serverFd = Listen(port, listener);
     assert(serverFd > 0);
 
-    int on = 1;
-    int ret = setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
-    assert(ret == 0);
-    ret = setsockopt(serverFd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
-    assert(ret == 0);
+    auto* co = ctx->GetCooperator();
+    io::Descriptor desc(serverFd);
+    BusyPollListener(desc);
+    auto const& router = s_routers->emplace_back(routes, routeCount);
+    auto& admission = s_admissions->emplace_back(admissionConfig);
+    StaticFilesScope files(searchPaths);
+    response::DateClock date(ctx);
 
-    struct sockaddr_in addr;
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    addr.sin_addr.s_addr = INADDR_ANY;
+    // TLS handshake + HTTP requires more stack for OpenSSL
+    //
+    SpawnTemplate<HttpTlsConnection> connections(co, {.priority = 0, .stackSize = 65536});
+
+    AcceptLoop(ctx, desc, multishotAccept, [&](int fd)
+    {
+        if (!admission.AdmitConnection())
+        {
+            RejectConnection(fd);
+            return;
+        }
+        connections.Launch(fd, co, &router, sslCtx, searchPaths, timeout, &admission);
+    });
+}
 
-    ret = bind(serverFd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in));
-    assert(ret == 0);
+void RunStacklessServer(
+    Context* ctx,
+    int port,
+    const Route* routes,
+    int routeCount,
+    const char* name /* = "HttpStacklessServer" */,
+    const char* const* searchPaths /* = nullptr */,
+    time::Interval timeout /* = std::chrono::seconds(30) */,
+    bool multishotAccept /* = false */,
+    AdmissionConfiguration const& admissionConfig /* = {} */,
+    ListenerConfiguration const& listener /* = {} */)
+{
+    ctx->SetName(name);
 
-    ret = listen(serverFd, 512);
-    assert(ret == 0);
+    int serverFd = Listen(port, listener);
+    assert(serverFd > 0);
 
     auto* co = ctx->GetCooperator();
     io::Descriptor desc(serverFd);
+    BusyPollListener(desc);
+    auto const& router = s_routers->emplace_back(routes, routeCount);
+    auto& admission = s_admissions->emplace_back(admissionConfig);
+    StaticFilesScope files(searchPaths);
+    response::DateClock date(ctx);
 
-    while (!ctx->IsKilled())
+    SpawnTemplate<StacklessRequest> requests(co, {.priority = 0, .stackSize = 32768});
+    StacklessServer server(&router, searchPaths, timeout, &admission, &requests);
+
+    Context::Handle promoter;
+    server.open.Add();
+    bool promoting = co->Spawn([&server](Context* promoterCtx)
     {
-        int fd = io::AcceptKill(desc);
-        if (fd < 0)
+        promoterCtx->SetName("HttpStacklessPromoter");
+        PromoteReady(promoterCtx, server);
+        server.open.Done();
+    }, &promoter);
+    if (!promoting)
+    {
+        server.open.Done();
+        return;
+    }
+
+    // A new connection's request is usually already in flight, so it goes straight to a context
+    // rather than through a poll first
+    //
+    AcceptLoop(ctx, desc, multishotAccept, [&](int fd)
+    {
+        if (!admission.AdmitConnection())
         {
-            break;
+            RejectConnection(fd);
+            return;
+        }
+        auto* conn = new StacklessConnection(&server, fd);
+        if (!requests.Launch(conn))
+        {
+            delete conn;
+        }
+    });
+
+    // Requests in flight run to their end (or are killed with the server), idle connections close
+    // as their cancelled polls land, and the promoter closes what it had queued
+    //
+    server.stopping = true;
+    promoter.Kill();
+    server.idle.Visit([](StacklessConnection* conn)
+    {
+        conn->m_poll.Cancel();
+        return true;
+    });
+    server.open.Wait(ctx);
+}
+
+bool RunServerGroup(
+    int port,
+    const Route* routes,
+    int routeCount,
+    int cooperators /* = 0 */,
+    ServerGroupConfiguration const& config /* = {} */)
+{
+    auto const& topo = GetTopology();
+    int available = topo.cpus.empty() ? 1 : static_cast<int>(topo.cpus.size());
+    if (cooperators <= 0)
+    {
+        cooperators = available;
+    }
+
+    // Bind every listener first, in order, so that listener i is index i of the reuseport group.
+    // Inherited listeners already are.
+    //
+    bool inherited = !config.listeners.empty();
+    std::vector<int> fds = config.listeners;
+    if (inherited)
+    {
+        cooperators = static_cast<int>(fds.size());
+    }
+    std::vector<int> cpus;
+    for (int i = 0; i < cooperators; i++)
+    {
+        if (inherited)
+        {
+            int listening = 0;
+            socklen_t len = sizeof(listening);
+            if (getsockopt(fds[i], SOL_SOCKET, SO_ACCEPTCONN, &listening, &len) != 0 || !listening)
+            {
+                spdlog::error("server group inherited fd={} is not listening", fds[i]);
+                return false;
+            }
         }
+        else
+        {
+            int fd = Listen(port, config.listener);
+            if (fd < 0)
+            {
+                spdlog::error("server group listen port={} errno={}", port, errno);
+                for (int f : fds) close(f);
+                return false;
+            }
+            fds.push_back(fd);
+        }
+        cpus.push_back(topo.cpus.empty() ? -1 : topo.cpus[i % available].cpu_id);
+    }
+    if (config.boundListeners)
+    {
+        *config.boundListeners = fds;
+    }
+
+    bool pinned = !topo.cpus.empty() && !PinningDisabled();
+    if (config.steerByCpu && pinned && !inherited && !SteerByCpu(fds[0], cpus))
+    {
+        spdlog::warn("server group SO_ATTACH_REUSEPORT_CBPF failed errno={}, using reuseport hash",
+                     errno);
+    }
+
+    struct Member
+    {
+        const Route* routes;
+        int routeCount;
+        int fd;
+        ServerGroupConfiguration const* config;
+        GroupMember group;
+    };
+
+    std::vector<Member> members;
+    std::vector<std::unique_ptr<Cooperator>> pool;
+    std::vector<GroupMember*> byCpu;
+    members.reserve(cooperators);
+    pool.reserve(cooperators);
+
+    for (int i = 0; i < cooperators; i++)
+    {
+        CooperatorConfiguration coConfig = config.cooperator
+            ? *config.cooperator
+            : s_defaultCooperatorConfiguration;
+        char nameBuf[COOPERATOR_NAME_MAX];
+        snprintf(nameBuf, sizeof(nameBuf), "%s-%d", config.name, i);
+        coConfig.SetName(nameBuf);
+        coConfig.cpuAffinity = cpus[i];
+
+        pool.push_back(std::make_unique<Cooperator>(coConfig));
+        members.push_back({routes, routeCount, fds[i], &config, {pool.back().get()}});
 
-        // TLS handshake + HTTP requires more stack for OpenSSL
+        // The first member on a cpu takes the connections received there
         //
-        static constexpr SpawnConfiguration config = {.priority = 0, .stackSize = 65536};
-        co->Launch<HttpTlsConnection>(config, fd, co, routes, routeCount,
-                                      sslCtx, searchPaths, timeout);
-        ctx->Yield();
+        if (config.handoffByIncomingCpu && pinned)
+        {
+            members.back().group.byCpu = &byCpu;
+            if (byCpu.size() <= static_cast<size_t>(cpus[i]))
+            {
+                byCpu.resize(cpus[i] + 1, nullptr);
+            }
+            if (!byCpu[cpus[i]])
+            {
+                byCpu[cpus[i]] = &members.back().group;
+            }
+        }
+    }
+
+    // Each Serve is its cooperator's first submission, so it is serving before any handoff to it
+    // runs
+    //
+    for (int i = 0; i < cooperators; i++)
+    {
+        pool[i]->Submit([](Context* ctx, void* arg)
+        {
+            auto* m = static_cast<Member*>(arg);
+            ctx->SetName(m->config->name);
+            Serve(ctx, m->fd, m->routes, m->routeCount, m->config->searchPaths,
+                  m->config->timeout, m->config->multishotAccept, m->config->fixedBuffers,
+                  m->config->multishotRecv, m->config->admission, &m->group);
+        }, &members[i]);
+    }
+
+    // Each Thread joins its cooperator on destruction, i.e. once the group is shut down
+    //
+    {
+        std::vector<std::unique_ptr<Thread>> threads;
+        threads.reserve(cooperators);
+        for (auto& co : pool)
+        {
+            threads.push_back(std::make_unique<Thread>(co.get()));
+        }
     }
+    return true;
 }
 
 } // end namespace coop::http
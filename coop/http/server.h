@@ -1,7 +1,10 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
+#include "admission.h"
+#include "coop/cooperator_configuration.h"
 #include "coop/time/interval.h"
 
 namespace coop
@@ -17,15 +20,53 @@ namespace http
 
 struct ConnectionBase;
 
+// One entry of a route table. path is matched segment by segment: literal segments exactly, a
+// ":name" segment as any one segment and a trailing "*name" as the rest of the path, both captured
+// for the handler as ConnectionBase::Param(name). See router.h.
+//
 struct Route
 {
     const char* path;
     void (*handler)(ConnectionBase&);
 };
 
+// Options for a server's listening socket
+//
+struct ListenerConfiguration
+{
+    // TCP_FASTOPEN: take a request on the SYN from a client holding this host's cookie, handing
+    // it to the connection before the handshake ends; up to this many such connections may be
+    // pending at once. 0 leaves Fast Open off. Needs net.ipv4.tcp_fastopen's server bit (0x2).
+    //
+    int fastOpenQueue = 0;
+
+    // TCP_DEFER_ACCEPT: keep a connection in the kernel until its first bytes arrive, or about
+    // this many seconds have passed, so accept never launches a context only to wait on an idle
+    // socket. 0 accepts on the handshake.
+    //
+    int deferAcceptSeconds = 0;
+};
+
 // Run an HTTP server on the given port with the provided route table. Binds, listens, and accepts
 // connections in a loop, launching a handler context per client.
 //
+// With multishotAccept, the loop arms one IORING_ACCEPT_MULTISHOT accept (io::ArmedHandle) for
+// the listener's lifetime instead of submitting an accept per connection, so a connection storm
+// costs one CQE per client instead of a CQE and a resubmission.
+//
+// With fixedBuffers, each connection is laid out inside one of the ring's registered buffers
+// (UringConfiguration::fixedBuffers) so its recvs and buffered sends are fixed ops; connections
+// beyond the pool, or a ring without one, fall back to the ordinary layout.
+//
+// With multishotRecv, each connection receives through one multishot recv on the ring's default
+// BufferRing (UringConfiguration::bufferRingEntries) and allocates its parser and recv buffer only
+// while a request is in flight, so idle keep-alive connections hold no recv buffer. Without a
+// buffer ring it falls back to the options above.
+//
+// admission bounds the server's open connections and concurrent requests, shedding the excess
+// with a 503 (admission.h); by default everything is admitted. listener sets the listening
+// socket's Fast Open and deferred-accept options.
+//
 void RunServer(
     Context* ctx,
     int port,
@@ -33,11 +74,19 @@ void RunServer(
     int routeCount,
     const char* name = "HttpServer",
     const char* const* searchPaths = nullptr,
-    time::Interval timeout = std::chrono::seconds(30));
+    time::Interval timeout = std::chrono::seconds(30),
+    bool multishotAccept = false,
+    bool fixedBuffers = false,
+    bool multishotRecv = false,
+    AdmissionConfiguration const& admission = {},
+    ListenerConfiguration const& listener = {});
 
 // Run an HTTPS server. Same as RunServer but performs a TLS handshake on each accepted connection
 // before entering the HTTP handler loop. Uses socket BIO mode with kTLS when available.
 //
+// Offer "h2" through ALPN (sslCtx.SetAlpnProtocols, listing "h2" ahead of "http/1.1") and clients
+// that pick it are served HTTP/2 -- see http2.h -- through the same routes.
+//
 void RunTlsServer(
     Context* ctx,
     int port,
@@ -46,7 +95,109 @@ void RunTlsServer(
     io::ssl::Context& sslCtx,
     const char* name = "HttpsServer",
     const char* const* searchPaths = nullptr,
-    time::Interval timeout = std::chrono::seconds(30));
+    time::Interval timeout = std::chrono::seconds(30),
+    bool multishotAccept = false,
+    AdmissionConfiguration const& admission = {},
+    ListenerConfiguration const& listener = {});
+
+// Run an HTTP server whose connections hold a context only while a request is being served. Between
+// requests a connection is its socket and one POLLIN poll on a continuation-driven io::Handle --
+// no context, stack, parser or recv buffer -- so a server holding a great many mostly idle
+// keep-alive connections (a push gateway's) pays a few hundred bytes for each. When one turns
+// readable a context is launched to serve it, through the same routes and handlers as RunServer,
+// and it goes back to idle once every buffered request is answered. The keep-alive timeout is a
+// coarse one on the poll (io::CoarseTimeout).
+//
+// Each request pays a context launch and, after the first, a poll round trip that RunServer's
+// connections do not, so this is for connection counts where the memory matters more.
+//
+void RunStacklessServer(
+    Context* ctx,
+    int port,
+    const Route* routes,
+    int routeCount,
+    const char* name = "HttpStacklessServer",
+    const char* const* searchPaths = nullptr,
+    time::Interval timeout = std::chrono::seconds(30),
+    bool multishotAccept = false,
+    AdmissionConfiguration const& admission = {},
+    ListenerConfiguration const& listener = {});
+
+// Options for RunServerGroup.
+//
+struct ServerGroupConfiguration
+{
+    // Steer each connection to the listener whose cooperator is pinned to the CPU that received
+    // it (SO_ATTACH_REUSEPORT_CBPF), so accept, parse and respond run on the core the NIC queue
+    // interrupts. Off, or with pinning disabled (COOP_NO_PIN=1), the kernel's reuseport hash
+    // spreads connections instead.
+    //
+    bool steerByCpu = true;
+
+    // After each accept, read the connection's SO_INCOMING_CPU and, when another member is pinned
+    // to that CPU, Submit the fd to that member's cooperator (a MSG_RING doorbell between
+    // cooperators), which launches the connection against its own admission. This catches what
+    // the reuseport program cannot: the hash fallback, RX steering that moved after the SYN, and
+    // steering failing to attach. A CPU hosting no member keeps the connection where it was
+    // accepted. Off by default: each handoff costs a cross-thread submission, which pays only
+    // when the connection's traffic then stays on the receiving core. Needs pinning.
+    //
+    bool handoffByIncomingCpu = false;
+
+    bool multishotAccept = false;
+    bool fixedBuffers = false;
+    bool multishotRecv = false;
+    const char* name = "HttpServer";
+    const char* const* searchPaths = nullptr;
+    time::Interval timeout = std::chrono::seconds(30);
+
+    // Per cooperator: each member server keeps its own counts and limit
+    //
+    AdmissionConfiguration admission;
+
+    // Options of the listeners bound here; inherited listeners keep their own
+    //
+    ListenerConfiguration listener;
+
+    // Base configuration for every cooperator in the group; each gets its own name and core.
+    // nullptr means s_defaultCooperatorConfiguration.
+    //
+    CooperatorConfiguration const* cooperator = nullptr;
+
+    // Listening sockets to serve instead of binding port, one per cooperator, in their reuseport
+    // group's order: a predecessor's, received over io::ReceiveFds during a restart. The
+    // cooperators argument is ignored; the group has one member per fd, and owns them.
+    //
+    std::vector<int> listeners;
+
+    // When set, filled with the group's listening fds, in order, before any cooperator starts --
+    // what a restart hands its successor (io::SendFds) before draining. They stay open until the
+    // members' servers exit.
+    //
+    std::vector<int>* boundListeners = nullptr;
+};
+
+// Run one HTTP server per core: start cooperators pinned one per available CPU (round-robin when
+// cooperators exceeds the cores), each serving its own SO_REUSEPORT listener on port, and block
+// until they all shut down (Cooperator::ShutdownAll, e.g. from InstallShutdownHandler). cooperators
+// <= 0 means one per available CPU.
+//
+// The listeners are bound here, in cooperator order, before any cooperator starts: a reuseport
+// group indexes its sockets by join order, which is what lets the steering program name a
+// listener by CPU. Returns false, starting nothing, if a listener cannot be bound, or an inherited
+// one is not listening.
+//
+// For a zero-downtime restart the old process sends boundListeners to the new one and then drains
+// (Cooperator::DrainAll, or SIGTERM with InstallShutdownHandler(grace)): its members stop
+// accepting and finish their requests while the successor, serving the same sockets, takes every
+// new connection. The steering program is the sockets' own, so it carries over.
+//
+bool RunServerGroup(
+    int port,
+    const Route* routes,
+    int routeCount,
+    int cooperators = 0,
+    ServerGroupConfiguration const& config = {});
 
 } // end namespace coop::http
 } // end namespace coop
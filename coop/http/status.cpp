@@ -1,19 +1,32 @@
 #include "status.h"
 #include "server.h"
 #include "connection.h"
+#include "metrics.h"
+#include "route_metrics.h"
+#include "json_writer.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdio>
 #include <cxxabi.h>
 #include <dlfcn.h>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "coop/cooperator.h"
 #include "coop/context.h"
 #include "coop/detail/scheduler_state.h"
 #include "coop/epoch/epoch.h"
+#include "coop/memory_accounting.h"
 #include "coop/perf/counters.h"
+#include "coop/perf/histogram.h"
 #include "coop/perf/patch.h"
+#include "coop/perf/pprof.h"
 #include "coop/perf/sampler.h"
+#include "coop/status_snapshot.h"
+#include "coop/time/now.h"
 
 namespace coop
 {
@@ -23,118 +36,6 @@ namespace http
 namespace
 {
 
-// Minimal JSON writer that appends to a string reference. Handles comma separation via
-// depth-tracked first-element flags.
-//
-struct JsonWriter
-{
-    static constexpr int MAX_DEPTH = 32;
-
-    std::string& m_out;
-    bool m_first[MAX_DEPTH];
-    int m_depth;
-
-    JsonWriter(std::string& out)
-    : m_out(out)
-    , m_depth(0)
-    {
-        m_first[0] = true;
-    }
-
-    void Comma()
-    {
-        if (!m_first[m_depth])
-        {
-            m_out += ',';
-        }
-        m_first[m_depth] = false;
-    }
-
-    void BeginObject()
-    {
-        Comma();
-        m_out += '{';
-        m_depth++;
-        m_first[m_depth] = true;
-    }
-
-    void EndObject()
-    {
-        m_depth--;
-        m_out += '}';
-    }
-
-    void BeginArray()
-    {
-        Comma();
-        m_out += '[';
-        m_depth++;
-        m_first[m_depth] = true;
-    }
-
-    void EndArray()
-    {
-        m_depth--;
-        m_out += ']';
-    }
-
-    void Key(const char* key)
-    {
-        Comma();
-        m_out += '"';
-        m_out += key;
-        m_out += "\":";
-        // Mark as first so the value itself doesn't emit a comma
-        //
-        m_first[m_depth] = true;
-    }
-
-    void String(const char* val)
-    {
-        Comma();
-        m_out += '"';
-        // Escape special characters
-        //
-        for (const char* p = val; *p; p++)
-        {
-            switch (*p)
-            {
-                case '"':  m_out += "\\\""; break;
-                case '\\': m_out += "\\\\"; break;
-                case '\n': m_out += "\\n";  break;
-                case '\r': m_out += "\\r";  break;
-                case '\t': m_out += "\\t";  break;
-                default:   m_out += *p;     break;
-            }
-        }
-        m_out += '"';
-    }
-
-    void Int(int64_t val)
-    {
-        Comma();
-        m_out += std::to_string(val);
-    }
-
-    void UInt(uint64_t val)
-    {
-        Comma();
-        m_out += std::to_string(val);
-    }
-
-    void Bool(bool val)
-    {
-        Comma();
-        m_out += val ? "true" : "false";
-    }
-
-    void Null()
-    {
-        Comma();
-        m_out += "null";
-    }
-};
-
 const char* StateString(SchedulerState state)
 {
     switch (state)
@@ -146,6 +47,51 @@ const char* StateString(SchedulerState state)
     return "unknown";
 }
 
+void SerializeStatistics(JsonWriter& w, Context::Statistics const& s, Cooperator* co)
+{
+    w.Key("statistics");
+    w.BeginObject();
+    w.Key("ticks");
+    w.UInt(s.ticks);
+    w.Key("yields");
+    w.UInt(s.yields);
+    w.Key("blocks");
+    w.UInt(s.blocks);
+    w.Key("ioSubmits");
+    w.UInt(s.ioSubmits);
+    w.Key("ioCompletes");
+    w.UInt(s.ioCompletes);
+    w.Key("samples");
+    w.UInt(s.samples);
+    w.Key("blockedTicks");
+    w.UInt(s.blockedTicks);
+    if (co->TracksContextIo())
+    {
+        w.Key("ioReads");
+        w.UInt(s.ioReads);
+        w.Key("ioWrites");
+        w.UInt(s.ioWrites);
+        w.Key("ioReadBytes");
+        w.UInt(s.ioReadBytes);
+        w.Key("ioWriteBytes");
+        w.UInt(s.ioWriteBytes);
+        w.Key("ioWaitTicks");
+        w.UInt(s.ioWaitTicks);
+    }
+    if (co->TracksContextPmu())
+    {
+        w.Key("pmuCycles");
+        w.UInt(s.pmuCycles);
+        w.Key("pmuInstructions");
+        w.UInt(s.pmuInstructions);
+        w.Key("pmuLlcMisses");
+        w.UInt(s.pmuLlcMisses);
+        w.Key("pmuBranchMisses");
+        w.UInt(s.pmuBranchMisses);
+    }
+    w.EndObject();
+}
+
 void SerializeContext(JsonWriter& w, Context* ctx)
 {
     w.BeginObject();
@@ -162,21 +108,7 @@ void SerializeContext(JsonWriter& w, Context* ctx)
     w.Key("priority");
     w.Int(ctx->m_priority);
 
-    w.Key("statistics");
-    w.BeginObject();
-    w.Key("ticks");
-    w.UInt(ctx->m_statistics.ticks);
-    w.Key("yields");
-    w.UInt(ctx->m_statistics.yields);
-    w.Key("blocks");
-    w.UInt(ctx->m_statistics.blocks);
-    w.Key("ioSubmits");
-    w.UInt(ctx->m_statistics.ioSubmits);
-    w.Key("ioCompletes");
-    w.UInt(ctx->m_statistics.ioCompletes);
-    w.Key("samples");
-    w.UInt(ctx->m_statistics.samples);
-    w.EndObject();
+    SerializeStatistics(w, ctx->m_statistics, ctx->GetCooperator());
 
     w.Key("children");
     w.BeginArray();
@@ -190,6 +122,101 @@ void SerializeContext(JsonWriter& w, Context* ctx)
     w.EndObject();
 }
 
+// The same shape as SerializeContext, from a snapshot (status_snapshot.h): the entry at i, then
+// its children, which follow it one level deeper. Returns the index after its subtree.
+//
+size_t SerializeContextSnapshot(JsonWriter& w, std::vector<ContextSnapshot> const& contexts,
+                                size_t i, Cooperator* co)
+{
+    ContextSnapshot const& entry = contexts[i];
+    w.BeginObject();
+
+    w.Key("name");
+    w.String(entry.name);
+
+    w.Key("state");
+    w.String(StateString(entry.state));
+
+    w.Key("killed");
+    w.Bool(entry.killed);
+
+    w.Key("priority");
+    w.Int(entry.priority);
+
+    SerializeStatistics(w, entry.statistics, co);
+
+    w.Key("children");
+    w.BeginArray();
+    size_t next = i + 1;
+    while (next < contexts.size() && contexts[next].depth > entry.depth)
+    {
+        next = SerializeContextSnapshot(w, contexts, next, co);
+    }
+    w.EndArray();
+
+    w.EndObject();
+    return next;
+}
+
+// Summary of one latency histogram, in nanoseconds: enough for an SLO check without shipping
+// the buckets. nanosPerUnit scales a histogram kept in other units (ticks) to nanoseconds.
+//
+void SerializeHistogram(JsonWriter& w, perf::Histogram const& h, double nanosPerUnit = 1.0)
+{
+    auto ns = [&](uint64_t v)
+    {
+        return static_cast<uint64_t>(static_cast<double>(v) * nanosPerUnit);
+    };
+
+    w.BeginObject();
+    w.Key("count");
+    w.UInt(h.count);
+    w.Key("mean");
+    w.UInt(ns(h.Mean()));
+    w.Key("p50");
+    w.UInt(ns(h.Quantile(0.5)));
+    w.Key("p90");
+    w.UInt(ns(h.Quantile(0.9)));
+    w.Key("p99");
+    w.UInt(ns(h.Quantile(0.99)));
+    w.Key("p999");
+    w.UInt(ns(h.Quantile(0.999)));
+    w.Key("max");
+    w.UInt(ns(h.max));
+    w.EndObject();
+}
+
+// One ContextPmu as counts plus the ratios that make them comparable across names: IPC, and
+// misses per thousand instructions
+//
+void SerializeContextPmu(JsonWriter& w, Cooperator::ContextPmu const& p)
+{
+    auto perKilo = [&](uint64_t misses)
+    {
+        return p.instructions ? 1000.0 * static_cast<double>(misses)
+                                    / static_cast<double>(p.instructions)
+                              : 0.0;
+    };
+
+    w.Key("cycles");
+    w.UInt(p.cycles);
+    w.Key("instructions");
+    w.UInt(p.instructions);
+    w.Key("llcMisses");
+    w.UInt(p.llcMisses);
+    w.Key("branchMisses");
+    w.UInt(p.branchMisses);
+    // Ratios: three decimals are plenty
+    //
+    w.Key("ipc");
+    w.Double(p.cycles ? static_cast<double>(p.instructions) / static_cast<double>(p.cycles)
+                      : 0.0, 3);
+    w.Key("llcMpki");
+    w.Double(perKilo(p.llcMisses), 3);
+    w.Key("branchMpki");
+    w.Double(perKilo(p.branchMisses), 3);
+}
+
 void SerializeCooperatorStatus(JsonWriter& w, Cooperator* co)
 {
     w.BeginObject();
@@ -221,6 +248,87 @@ void SerializeCooperatorStatus(JsonWriter& w, Cooperator* co)
     });
     w.EndArray();
 
+    if (co->TracksStackDepth())
+    {
+        w.Key("stackDepths");
+        w.BeginArray();
+        co->VisitStackDepths([&](const char* name, Cooperator::StackDepth const& d)
+        {
+            w.BeginObject();
+            w.Key("name");
+            w.String(name);
+            w.Key("exits");
+            w.UInt(d.exits);
+            w.Key("stackSize");
+            w.UInt(d.stackSize);
+            w.Key("maxStackBytes");
+            w.UInt(d.maxStackBytes);
+            w.Key("meanStackBytes");
+            w.UInt(d.exits ? d.totalStackBytes / d.exits : 0);
+            w.Key("maxUsedBytes");
+            w.UInt(d.maxUsedBytes);
+            w.Key("maxHeapBytes");
+            w.UInt(d.maxHeapBytes);
+            w.Key("bumpOverflows");
+            w.UInt(d.bumpOverflows);
+            w.EndObject();
+        });
+        w.EndArray();
+    }
+
+    if (co->TracksContextPmu())
+    {
+        w.Key("pmu");
+        w.BeginObject();
+        w.Key("rdpmc");
+        w.Bool(co->PmuUsesRdpmc());
+        w.Key("loop");
+        w.BeginObject();
+        SerializeContextPmu(w, co->GetLoopPmu());
+        w.EndObject();
+        w.Key("byName");
+        w.BeginArray();
+        co->VisitContextPmu([&](const char* name, Cooperator::ContextPmu const& p)
+        {
+            w.BeginObject();
+            w.Key("name");
+            w.String(name);
+            w.Key("exits");
+            w.UInt(p.exits);
+            w.Key("live");
+            w.UInt(p.live);
+            SerializeContextPmu(w, p);
+            w.EndObject();
+        });
+        w.EndArray();
+        w.EndObject();
+    }
+    else if (co->PmuError())
+    {
+        w.Key("pmuError");
+        w.Int(co->PmuError());
+    }
+
+    if (co->TracksSchedulingDelay())
+    {
+        const double nanosPerTick = co->NanosPerTick();
+        w.Key("schedulingDelay");
+        SerializeHistogram(w, co->GetSchedulingDelay(), nanosPerTick);
+
+        w.Key("schedulingDelays");
+        w.BeginArray();
+        co->VisitSchedulingDelays([&](const char* name, perf::Histogram const& h)
+        {
+            w.BeginObject();
+            w.Key("name");
+            w.String(name);
+            w.Key("delay");
+            SerializeHistogram(w, h, nanosPerTick);
+            w.EndObject();
+        });
+        w.EndArray();
+    }
+
     w.EndObject();
 }
 
@@ -230,6 +338,7 @@ std::string GenerateStatusJson(Cooperator* co)
     out.reserve(4096);
     JsonWriter w(out);
     SerializeCooperatorStatus(w, co);
+    w.Finish();
     return out;
 }
 
@@ -261,6 +370,21 @@ void SerializePerfCounters(JsonWriter& w, Cooperator* co)
     (void)co;
 #endif
 
+    w.EndObject();
+
+    w.Key("histograms");
+    w.BeginObject();
+
+#if COOP_PERF_MODE > 0
+    auto& histograms = co->GetPerfHistograms();
+    for (size_t i = 0; i < static_cast<size_t>(perf::Hist::COUNT); i++)
+    {
+        auto h = static_cast<perf::Hist>(i);
+        w.Key(perf::HistName(h));
+        SerializeHistogram(w, histograms.Get(h));
+    }
+#endif
+
     w.EndObject();
     w.EndObject();
 }
@@ -344,6 +468,7 @@ std::string GeneratePerfJson(Cooperator* co)
 
     w.EndObject();
     w.EndObject();
+    w.Finish();
     return out;
 }
 
@@ -389,9 +514,7 @@ void HandlePerfDisable(ConnectionBase& conn)
 
 void HandleSampler(ConnectionBase& conn)
 {
-    std::string out;
-    out.reserve(256);
-    JsonWriter w(out);
+    JsonWriter w(conn);
     w.BeginObject();
     w.Key("sampling");
     w.Bool(perf::IsSampling());
@@ -406,7 +529,7 @@ void HandleSampler(ConnectionBase& conn)
     w.Key("stackSubsample");
     w.Int(perf::StackSubsample());
     w.EndObject();
-    conn.Send(200, "application/json", out.data(), out.size());
+    w.Finish();
 }
 
 void HandleSamplerStart(ConnectionBase& conn)
@@ -458,13 +581,12 @@ void SerializeSampleContext(JsonWriter& w, const char* ctxName, const char* coop
     else w.Null();
 }
 
-static void SerializePcSamples(JsonWriter& w, std::string& out)
+static void SerializePcSamples(JsonWriter& w)
 {
     static constexpr size_t MAX_READ = 8192;
     auto* samples = new perf::Sample[MAX_READ];
     size_t count = perf::ReadSamples(samples, MAX_READ);
 
-    out.reserve(out.size() + count * 48 + 64);
     w.Key("count");
     w.UInt(count);
     w.Key("samples");
@@ -487,13 +609,12 @@ static void SerializePcSamples(JsonWriter& w, std::string& out)
     delete[] samples;
 }
 
-static void SerializeStackSamples(JsonWriter& w, std::string& out)
+static void SerializeStackSamples(JsonWriter& w)
 {
     static constexpr size_t MAX_READ = 2048;
     auto* samples = new perf::StackSample[MAX_READ];
     size_t count = perf::ReadStackSamples(samples, MAX_READ);
 
-    out.reserve(out.size() + count * 200 + 64);
     w.Key("stackCount");
     w.UInt(count);
     w.Key("stackSamples");
@@ -525,25 +646,181 @@ void HandleSamplerSamples(ConnectionBase& conn)
 {
     bool stackMode = perf::IsStackMode();
 
-    std::string out;
-    JsonWriter w(out);
+    JsonWriter w(conn);
     w.BeginObject();
     w.Key("stacks");
     w.Bool(stackMode);
 
     // PC ring is always populated (full-rate RIP capture).
     //
-    SerializePcSamples(w, out);
+    SerializePcSamples(w);
 
     // In stack mode, also include the subsampled stack traces.
     //
     if (stackMode)
     {
-        SerializeStackSamples(w, out);
+        SerializeStackSamples(w);
+    }
+
+    w.EndObject();
+    w.Finish();
+}
+
+// The stack ring for off-host symbolization (coop/perf/pprof.h): a gzipped pprof profile, or
+// collapsed-stack text, with raw addresses and each object's build-id. Nothing is symbolized here.
+//
+void HandleSamplerPprof(ConnectionBase& conn)
+{
+    static constexpr size_t MAX_READ = 2048;
+    auto samples = std::make_unique<perf::StackSample[]>(MAX_READ);
+    size_t count = perf::ReadStackSamples(samples.get(), MAX_READ);
+
+    std::string out;
+    if (!perf::AppendPprof(out, samples.get(), count, conn.GetCooperator()->NanosPerTick()))
+    {
+        conn.Send(500, "application/json", "{\"ok\":false}");
+        return;
+    }
+    conn.Send(200, "application/octet-stream", out.data(), out.size());
+}
+
+void HandleSamplerCollapsed(ConnectionBase& conn)
+{
+    static constexpr size_t MAX_READ = 2048;
+    auto samples = std::make_unique<perf::StackSample[]>(MAX_READ);
+    size_t count = perf::ReadStackSamples(samples.get(), MAX_READ);
+
+    std::string out;
+    out.reserve(count * 64 + 4096);
+    perf::AppendCollapsed(out, samples.get(), count);
+    conn.Send(200, "text/plain; charset=utf-8", out.data(), out.size());
+}
+
+// ---- Off-CPU profiler API ----
+
+void HandleOffCpuStart(ConnectionBase& conn)
+{
+    perf::ResetOffCpuSamples();
+    perf::StartOffCpuProfiling();
+    conn.Send(200, "application/json", "{\"ok\":true}");
+}
+
+void HandleOffCpuStop(ConnectionBase& conn)
+{
+    perf::StopOffCpuProfiling();
+    conn.Send(200, "application/json", "{\"ok\":true}");
+}
+
+// The ring folded into one entry per distinct (cooperator, context name, stack), weighted by
+// blocked time, plus the same time per waking Coordinator. The stack entries have the shape of
+// /api/sampler/samples' stackSamples, with a weight (blocked microseconds) for the flame graph.
+//
+void HandleOffCpu(ConnectionBase& conn)
+{
+    static constexpr size_t MAX_READ = 2048;
+    auto samples = std::make_unique<perf::OffCpuSample[]>(MAX_READ);
+    size_t count = perf::ReadOffCpuSamples(samples.get(), MAX_READ);
+    const double nanosPerTick = conn.GetCooperator()->NanosPerTick();
+
+    struct Folded
+    {
+        size_t   first;             // a sample carrying the stack
+        uint64_t count = 0;
+        uint64_t ticks = 0;
+    };
+    std::map<std::string, Folded> stacks;
+    std::map<Coordinator const*, Folded> coordinators;
+    for (size_t i = 0; i < count; i++)
+    {
+        auto const& s = samples[i];
+        std::string key;
+        key.append(s.cooperator ? s.cooperator->GetName() : "").append(1, '\0');
+        key.append(s.name ? s.name : "").append(1, '\0');
+        key.append(reinterpret_cast<const char*>(s.frames), s.depth * sizeof(uintptr_t));
+
+        auto& stack = stacks.try_emplace(std::move(key), Folded{i}).first->second;
+        stack.count++;
+        stack.ticks += s.blockedTicks;
+
+        auto& coordinator = coordinators.try_emplace(s.coordinator, Folded{i}).first->second;
+        coordinator.count++;
+        coordinator.ticks += s.blockedTicks;
     }
 
+    auto nanos = [&](uint64_t ticks)
+    {
+        return static_cast<uint64_t>(static_cast<double>(ticks) * nanosPerTick);
+    };
+
+    JsonWriter w(conn);
+    w.BeginObject();
+    w.Key("profiling");
+    w.Bool(perf::IsOffCpuProfiling());
+    w.Key("total");
+    w.UInt(perf::TotalOffCpuSamples());
+    w.Key("capacity");
+    w.UInt(perf::OffCpuCapacity());
+    w.Key("stacks");
+    w.Bool(true);
+    w.Key("count");
+    w.UInt(count);
+    w.Key("samples");
+    w.BeginArray();
+    w.EndArray();
+
+    w.Key("stackSamples");
+    w.BeginArray();
+    for (auto const& [key, folded] : stacks)
+    {
+        auto const& s = samples[folded.first];
+        const uint64_t blockedNs = nanos(folded.ticks);
+        w.BeginObject();
+        w.Key("frames");
+        w.BeginArray();
+        for (int f = 0; f < s.depth; f++)
+        {
+            char pcBuf[20];
+            snprintf(pcBuf, sizeof(pcBuf), "0x%lx", s.frames[f]);
+            w.String(pcBuf);
+        }
+        w.EndArray();
+        SerializeSampleContext(w, s.name, s.cooperator ? s.cooperator->GetName() : nullptr);
+        w.Key("count");
+        w.UInt(folded.count);
+        w.Key("blockedNs");
+        w.UInt(blockedNs);
+        w.Key("weight");
+        w.UInt(blockedNs / 1000 ? blockedNs / 1000 : 1);
+        w.EndObject();
+    }
+    w.EndArray();
+
+    w.Key("coordinators");
+    w.BeginArray();
+    for (auto const& [coordinator, folded] : coordinators)
+    {
+        w.BeginObject();
+        w.Key("coordinator");
+        if (coordinator)
+        {
+            char addrBuf[20];
+            snprintf(addrBuf, sizeof(addrBuf), "%p", static_cast<const void*>(coordinator));
+            w.String(addrBuf);
+        }
+        else
+        {
+            w.Null();
+        }
+        w.Key("count");
+        w.UInt(folded.count);
+        w.Key("blockedNs");
+        w.UInt(nanos(folded.ticks));
+        w.EndObject();
+    }
+    w.EndArray();
+
     w.EndObject();
-    conn.Send(200, "application/json", out.data(), out.size());
+    w.Finish();
 }
 
 void HandleSymbolize(ConnectionBase& conn)
@@ -559,9 +836,7 @@ void HandleSymbolize(ConnectionBase& conn)
         if (body.size() > 65536) break; // safety limit
     }
 
-    std::string out;
-    out.reserve(body.size() * 4);
-    JsonWriter w(out);
+    JsonWriter w(conn);
     w.BeginObject();
     w.Key("symbols");
     w.BeginObject();
@@ -625,7 +900,7 @@ void HandleSymbolize(ConnectionBase& conn)
 
     w.EndObject();
     w.EndObject();
-    conn.Send(200, "application/json", out.data(), out.size());
+    w.Finish();
 }
 
 // ---- Multi-cooperator API ----
@@ -633,20 +908,20 @@ void HandleSymbolize(ConnectionBase& conn)
 // Provides a unified view of all cooperators in the process. For the local cooperator (the one
 // running the status server), data is read directly. For remote cooperators, counter values are
 // read cross-thread — uint64_t reads are tear-free on x86-64, acceptable for observability.
-// Context trees are gathered via SubmitSync to serialize access on the owning thread.
+// Remote context trees come from the snapshots cooperators publish (status_snapshot.h), so
+// nothing here touches another cooperator's thread or waits on it.
 //
 
 void HandleCooperators(ConnectionBase& conn)
 {
     Cooperator* local = conn.GetCooperator();
-    std::string out;
-    out.reserve(8192);
-    JsonWriter w(out);
+    JsonWriter w(conn);
 
     w.BeginObject();
     w.Key("cooperators");
     w.BeginArray();
 
+    CooperatorSnapshot snapshot;
     Cooperator::VisitRegistry([&](Cooperator* co) -> bool
     {
         if (co == local)
@@ -655,22 +930,39 @@ void HandleCooperators(ConnectionBase& conn)
             //
             SerializeCooperatorStatus(w, co);
         }
-        else
+        else if (co->ReadStatusSnapshot(snapshot))
         {
-            // Remote cooperator — gather context tree via SubmitSync for thread safety.
-            // SubmitSync blocks the current context (not the thread) until the remote
-            // cooperator executes our lambda.
-            //
-            // Note: we must drop the registry lock before calling SubmitSync, because the
-            // remote cooperator's DrainSubmissions runs under its own thread and doesn't
-            // touch the registry lock. However, VisitRegistry holds the lock for the
-            // duration of the visit. To avoid deadlock concerns, we collect remote
-            // cooperator pointers first, then query them outside the lock.
+            // Remote cooperator that publishes -- counts and tree from the same pass
             //
-            // For now, read counters and summary stats cross-thread (tear-free uint64_t on
-            // x86-64). Context tree is omitted for remote cooperators in the registry walk
-            // to avoid the lock ordering issue. The /api/cooperators/<name>/status endpoint
-            // uses SubmitSync for full context tree access.
+            w.BeginObject();
+            w.Key("name");
+            w.String(co->GetName());
+            w.Key("contextsCount");
+            w.UInt(snapshot.contextsCount);
+            w.Key("yieldedCount");
+            w.UInt(snapshot.yieldedCount);
+            w.Key("blockedCount");
+            w.UInt(snapshot.blockedCount);
+            w.Key("ticks");
+            w.Int(snapshot.ticks);
+            w.Key("snapshotAgeUs");
+            w.Int(std::max<int64_t>(time::MonotonicMicros() - snapshot.publishedUs, 0));
+            w.Key("snapshotVersion");
+            w.UInt(snapshot.version);
+            w.Key("truncated");
+            w.Bool(snapshot.truncated);
+            w.Key("contexts");
+            w.BeginArray();
+            for (size_t i = 0; i < snapshot.contexts.size();)
+            {
+                i = SerializeContextSnapshot(w, snapshot.contexts, i, co);
+            }
+            w.EndArray();
+            w.EndObject();
+        }
+        else
+        {
+            // Remote cooperator without snapshots -- its counters only, read cross-thread
             //
             w.BeginObject();
             w.Key("name");
@@ -693,14 +985,12 @@ void HandleCooperators(ConnectionBase& conn)
 
     w.EndArray();
     w.EndObject();
-    conn.Send(200, "application/json", out.data(), out.size());
+    w.Finish();
 }
 
 void HandleCooperatorsPerf(ConnectionBase& conn)
 {
-    std::string out;
-    out.reserve(4096);
-    JsonWriter w(out);
+    JsonWriter w(conn);
 
     w.BeginObject();
 
@@ -718,15 +1008,36 @@ void HandleCooperatorsPerf(ConnectionBase& conn)
 
     // Counter reads are tear-free on x86-64 — safe to read cross-thread for observability.
     //
+#if COOP_PERF_MODE > 0
+    auto merged = std::make_unique<perf::Histograms>();
+#endif
     Cooperator::VisitRegistry([&](Cooperator* co) -> bool
     {
         SerializePerfCounters(w, co);
+#if COOP_PERF_MODE > 0
+        merged->Merge(co->GetPerfHistograms());
+#endif
         return true;
     });
 
     w.EndArray();
+
+    // The same histograms merged over every cooperator: the process-wide distribution
+    //
+    w.Key("histograms");
+    w.BeginObject();
+#if COOP_PERF_MODE > 0
+    for (size_t i = 0; i < static_cast<size_t>(perf::Hist::COUNT); i++)
+    {
+        auto h = static_cast<perf::Hist>(i);
+        w.Key(perf::HistName(h));
+        SerializeHistogram(w, merged->Get(h));
+    }
+#endif
+    w.EndObject();
+
     w.EndObject();
-    conn.Send(200, "application/json", out.data(), out.size());
+    w.Finish();
 }
 
 // ---- Epoch API ----
@@ -740,9 +1051,7 @@ void HandleEpoch(ConnectionBase& conn)
         return;
     }
 
-    std::string out;
-    out.reserve(512);
-    JsonWriter w(out);
+    JsonWriter w(conn);
 
     w.BeginObject();
 
@@ -769,16 +1078,14 @@ void HandleEpoch(ConnectionBase& conn)
     w.EndObject();
 
     w.EndObject();
-    conn.Send(200, "application/json", out.data(), out.size());
+    w.Finish();
 }
 
 void HandleEpochAll(ConnectionBase& conn)
 {
     auto* localMgr = epoch::GetManager();
 
-    std::string out;
-    out.reserve(2048);
-    JsonWriter w(out);
+    JsonWriter w(conn);
 
     w.BeginObject();
 
@@ -811,7 +1118,234 @@ void HandleEpochAll(ConnectionBase& conn)
 
     w.EndArray();
     w.EndObject();
-    conn.Send(200, "application/json", out.data(), out.size());
+    w.Finish();
+}
+
+// ---- Memory API ----
+
+void SerializeContextMemory(JsonWriter& w, ContextMemory const& m)
+{
+    w.Key("contexts");
+    w.UInt(m.contexts);
+    w.Key("stackReserved");
+    w.UInt(m.stackReserved);
+    w.Key("stackCommitted");
+    w.UInt(m.stackCommitted);
+    w.Key("heapBytes");
+    w.UInt(m.heapBytes);
+    w.Key("heapHighWater");
+    w.UInt(m.heapHighWater);
+    w.Key("overflowBytes");
+    w.UInt(m.overflowBytes);
+}
+
+void SerializeTaggedMemory(JsonWriter& w, TaggedMemory const* tagged)
+{
+    w.BeginObject();
+    for (size_t i = 0; i < static_cast<size_t>(MemoryTag::COUNT); i++)
+    {
+        w.Key(MemoryTagName(static_cast<MemoryTag>(i)));
+        w.BeginObject();
+        w.Key("bytes");
+        w.Int(tagged[i].bytes);
+        w.Key("objects");
+        w.Int(tagged[i].objects);
+        w.EndObject();
+    }
+    w.EndObject();
+}
+
+// The serving cooperator in full, walked on its own thread. Other cooperators' contexts and
+// caches are theirs to walk, so for them only the tagged totals, which are readable cross-thread
+// during a registry visit, and the process-wide sums.
+//
+void HandleMemory(ConnectionBase& conn)
+{
+    Cooperator* local = conn.GetCooperator();
+    auto m = AccountCooperatorMemory(local);
+
+    JsonWriter w(conn);
+    w.BeginObject();
+
+    w.Key("name");
+    w.String(local->GetName());
+    SerializeContextMemory(w, m.contexts);
+
+    w.Key("sharedStackBytes");
+    w.UInt(m.sharedStackBytes);
+    w.Key("sharedStackCommitted");
+    w.UInt(m.sharedStackCommitted);
+    w.Key("sharedStackSaved");
+    w.UInt(m.sharedStackSaved);
+    w.Key("stackPoolBytes");
+    w.UInt(m.stackPoolBytes);
+    w.Key("continuationPoolBytes");
+    w.UInt(m.continuationPoolBytes);
+    w.Key("bufferRingBytes");
+    w.UInt(m.bufferRingBytes);
+    w.Key("bufferRingOutstanding");
+    w.UInt(m.bufferRingOutstanding);
+
+    w.Key("tagged");
+    SerializeTaggedMemory(w, m.tagged);
+
+    w.Key("byName");
+    w.BeginArray();
+    for (auto const& named : ContextMemoryByName(local))
+    {
+        w.BeginObject();
+        w.Key("name");
+        w.String(named.name);
+        SerializeContextMemory(w, named.memory);
+        w.EndObject();
+    }
+    w.EndArray();
+
+    w.Key("cooperators");
+    w.BeginArray();
+    Cooperator::VisitRegistry([&](Cooperator* co) -> bool
+    {
+        TaggedMemory tagged[static_cast<size_t>(MemoryTag::COUNT)];
+        for (size_t i = 0; i < static_cast<size_t>(MemoryTag::COUNT); i++)
+        {
+            tagged[i] = GetTaggedMemory(static_cast<MemoryTag>(i), co);
+        }
+        w.BeginObject();
+        w.Key("name");
+        w.String(co->GetName());
+        w.Key("contextsCount");
+        w.UInt(co->ContextsCount());
+        w.Key("stackPoolBytes");
+        w.UInt(co->GetStackPoolStats().totalBytes);
+        w.Key("tagged");
+        SerializeTaggedMemory(w, tagged);
+        w.EndObject();
+        return true;
+    });
+    w.EndArray();
+
+    TaggedMemory total[static_cast<size_t>(MemoryTag::COUNT)];
+    for (size_t i = 0; i < static_cast<size_t>(MemoryTag::COUNT); i++)
+    {
+        total[i] = GetTaggedMemory(static_cast<MemoryTag>(i));
+    }
+    w.Key("taggedTotal");
+    SerializeTaggedMemory(w, total);
+
+    w.EndObject();
+    w.Finish();
+}
+
+// Per-route request metrics summed over every server and cooperator (route_metrics.h), latency in
+// nanoseconds. Requests no route took are the entry with a null route.
+//
+void HandleRoutes(ConnectionBase& conn)
+{
+    JsonWriter w(conn);
+    w.BeginArray();
+    VisitRouteMetrics([&](const char* path, RouteMetrics const& m)
+    {
+        w.BeginObject();
+        w.Key("route");
+        if (path)
+        {
+            w.String(path);
+        }
+        else
+        {
+            w.Null();
+        }
+        w.Key("requests");
+        w.UInt(m.requests);
+        w.Key("status");
+        w.BeginObject();
+        static const char* const s_classes[] = {"none", "1xx", "2xx", "3xx", "4xx", "5xx"};
+        for (size_t i = 0; i < std::size(s_classes); i++)
+        {
+            w.Key(s_classes[i]);
+            w.UInt(m.statusClass[i]);
+        }
+        w.EndObject();
+        w.Key("bytesIn");
+        w.UInt(m.bytesIn);
+        w.Key("bytesOut");
+        w.UInt(m.bytesOut);
+        w.Key("latency");
+        SerializeHistogram(w, m.latency);
+        w.EndObject();
+    });
+    w.EndArray();
+    w.Finish();
+}
+
+// The published slowest requests, oldest first
+//
+void HandleRoutesSlow(ConnectionBase& conn)
+{
+    auto requests = std::make_unique<SlowRequest[]>(kSlowRequestHistory);
+    size_t count = ReadSlowRequests(requests.get(), kSlowRequestHistory);
+
+    JsonWriter w(conn);
+    w.BeginArray();
+    for (size_t i = 0; i < count; i++)
+    {
+        auto const& r = requests[i];
+        w.BeginObject();
+        w.Key("method");
+        w.String(r.method);
+        w.Key("path");
+        w.String(r.path);
+        w.Key("route");
+        w.String(r.route);
+        w.Key("cooperator");
+        w.String(r.cooperatorName);
+        w.Key("status");
+        w.Int(r.status);
+        w.Key("bytesIn");
+        w.UInt(r.bytesIn);
+        w.Key("bytesOut");
+        w.UInt(r.bytesOut);
+        w.Key("nanos");
+        w.UInt(r.nanos);
+        w.Key("completedMicros");
+        w.Int(r.completedMicros);
+        w.EndObject();
+    }
+    w.EndArray();
+    w.Finish();
+}
+
+// ?count=<n>&interval_ms=<ms>, defaulting to the 8 slowest every 10 seconds
+//
+void HandleRoutesSlowStart(ConnectionBase& conn)
+{
+    size_t count = 8;
+    int64_t intervalMs = 10000;
+    while (auto* name = conn.NextArgName())
+    {
+        const std::string_view arg(name);
+        if (arg != "count" && arg != "interval_ms")
+        {
+            continue;
+        }
+        if (auto* chunk = conn.ReadArgValue())
+        {
+            char buf[24] = {};
+            size_t len = chunk->size < sizeof(buf) - 1 ? chunk->size : sizeof(buf) - 1;
+            memcpy(buf, chunk->data, len);
+            long long val = atoll(buf);
+            if (val > 0 && arg == "count") count = static_cast<size_t>(val);
+            if (val > 0 && arg == "interval_ms") intervalMs = val;
+        }
+    }
+    SetSlowRequestCapture(count, std::chrono::milliseconds(intervalMs));
+    conn.Send(200, "application/json", "{\"ok\":true}");
+}
+
+void HandleRoutesSlowStop(ConnectionBase& conn)
+{
+    SetSlowRequestCapture(0, std::chrono::seconds(10));
+    conn.Send(200, "application/json", "{\"ok\":true}");
 }
 
 Route s_statusRoutes[] = {
@@ -824,10 +1358,21 @@ Route s_statusRoutes[] = {
     {"/api/sampler/stop",   HandleSamplerStop},
     {"/api/sampler/samples", HandleSamplerSamples},
     {"/api/sampler/symbolize", HandleSymbolize},
+    {"/api/sampler/pprof",     HandleSamplerPprof},
+    {"/api/sampler/collapsed", HandleSamplerCollapsed},
+    {"/api/sampler/offcpu",       HandleOffCpu},
+    {"/api/sampler/offcpu/start", HandleOffCpuStart},
+    {"/api/sampler/offcpu/stop",  HandleOffCpuStop},
     {"/api/cooperators",       HandleCooperators},
     {"/api/cooperators/perf",  HandleCooperatorsPerf},
     {"/api/epoch",             HandleEpoch},
     {"/api/epoch/all",         HandleEpochAll},
+    {"/api/memory",            HandleMemory},
+    {"/api/routes",            HandleRoutes},
+    {"/api/routes/slow",       HandleRoutesSlow},
+    {"/api/routes/slow/start", HandleRoutesSlowStart},
+    {"/api/routes/slow/stop",  HandleRoutesSlowStop},
+    {"/metrics",               HandleMetrics},
 };
 
 static constexpr int STATUS_ROUTE_COUNT = sizeof(s_statusRoutes) / sizeof(s_statusRoutes[0]);
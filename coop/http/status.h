@@ -12,8 +12,10 @@ namespace http
 struct Route;
 
 // Return the built-in status/perf API route table (/api/status, /api/perf, /api/perf/enable,
-// /api/perf/disable). These can be appended to an application's own route table so that the
-// status dashboard shares the same port as the application server.
+// /api/perf/disable, ..., /api/memory of memory_accounting.h, and the OpenMetrics /metrics of
+// http/metrics.h). These can be appended
+// to an application's own route table so that the status dashboard shares the same port as the
+// application server.
 //
 const Route* StatusRoutes();
 int StatusRouteCount();
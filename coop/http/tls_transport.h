@@ -1,10 +1,14 @@
 #pragma once
 
+#include <cstdint>
+#include <sys/uio.h>
+
 #include "coop/io/descriptor.h"
 #include "coop/io/ssl/connection.h"
 #include "coop/io/ssl/recv.h"
 #include "coop/io/ssl/send.h"
 #include "coop/io/ssl/sendfile.h"
+#include "coop/io/writev.h"
 #include "coop/time/interval.h"
 
 namespace coop
@@ -36,11 +40,48 @@ struct TlsTransport
         return io::ssl::SendAll(m_conn, buf, size);
     }
 
+    // With kTLS transmit the kernel frames whatever the socket is given, so the pieces go out as
+    // one plain gather write -- once the connection is past its small records. Otherwise each is
+    // encrypted through OpenSSL in turn.
+    //
+    int SendAllv(struct iovec* iov, int iovcnt)
+    {
+        if (m_conn.m_ktlsTx && m_conn.RecordLimit() == SIZE_MAX)
+        {
+            return io::WritevAll(m_desc, iov, iovcnt);
+        }
+
+        size_t total = 0;
+        for (int i = 0; i < iovcnt; i++)
+        {
+            int sent = SendAll(iov[i].iov_base, iov[i].iov_len);
+            if (sent < 0 || static_cast<size_t>(sent) != iov[i].iov_len)
+            {
+                return sent;
+            }
+            total += sent;
+        }
+        return (int)total;
+    }
+
+    // Records are encrypted into OpenSSL's buffer, so there is no caller buffer to send from
+    //
+    int SendAllZeroCopy(const void* buf, size_t size)
+    {
+        return SendAll(buf, size);
+    }
+
     int SendfileAll(int in_fd, off_t offset, size_t count)
     {
         return io::ssl::SendfileAll(m_conn, in_fd, offset, count);
     }
 
+    // Only with kTLS receive is the socket's byte stream the plaintext, and only with kTLS
+    // transmit do plaintext bytes written to it go out encrypted
+    //
+    bool CanSplice() const { return m_conn.m_ktlsRx && !m_desc.m_direct && m_desc.m_fd >= 0; }
+    bool CanSpliceInto() const { return m_conn.m_ktlsTx && !m_desc.m_direct && m_desc.m_fd >= 0; }
+
     io::ssl::Connection& m_conn;
     io::Descriptor&      m_desc;
 };
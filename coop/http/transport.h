@@ -1,9 +1,18 @@
 #pragma once
 
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include "coop/coordinator.h"
+#include "coop/io/armed_handle.h"
 #include "coop/io/descriptor.h"
+#include "coop/io/fixed.h"
 #include "coop/io/recv.h"
 #include "coop/io/send.h"
 #include "coop/io/sendfile.h"
+#include "coop/io/uring.h"
+#include "coop/io/writev.h"
 #include "coop/time/interval.h"
 
 namespace coop
@@ -38,12 +47,228 @@ struct PlaintextTransport
         return io::SendAllFastpath(m_desc, buf, size);
     }
 
+    // One gather write over the pieces of a response; iov is consumed
+    //
+    int SendAllv(struct iovec* iov, int iovcnt)
+    {
+        return io::WritevAll(m_desc, iov, iovcnt);
+    }
+
+    int SendAllZeroCopy(const void* buf, size_t size)
+    {
+        return io::SendAllZc(m_desc, buf, size);
+    }
+
     int SendfileAll(int in_fd, off_t offset, size_t count)
     {
         return io::SendfileAll(m_desc, in_fd, offset, count);
     }
 
+    // Body bytes may be spliced straight off the socket (ReceiveBodyToFile), and onto it
+    // (SendBodyFrom)
+    //
+    bool CanSplice() const { return !m_desc.m_direct && m_desc.m_fd >= 0; }
+    bool CanSpliceInto() const { return CanSplice(); }
+
+    io::Descriptor& m_desc;
+};
+
+// RegisteredTransport is PlaintextTransport for a Connection laid out inside one of the ring's
+// registered buffers (RunServer's fixedBuffers): its recv and send buffers are then registered
+// memory, so each call names the buffer by index and the kernel skips pinning the pages per op.
+// A buffer from anywhere else -- a handler's static body, say -- takes the ordinary fastpath ops.
+//
+struct RegisteredTransport
+{
+    explicit RegisteredTransport(io::Descriptor& desc) : m_desc(desc) {}
+
+    io::Descriptor& Descriptor() { return m_desc; }
+
+    int Recv(void* buf, size_t size, int flags, time::Interval timeout)
+    {
+        int index = m_desc.m_ring->FixedBufferIndex(buf, size);
+        if (index < 0 || flags != 0)
+        {
+            if (timeout.count() > 0)
+            {
+                return io::RecvFastpath(m_desc, buf, size, flags, timeout);
+            }
+            return io::RecvFastpath(m_desc, buf, size, flags);
+        }
+        if (timeout.count() > 0)
+        {
+            return io::ReadFixed(m_desc, buf, size, index, 0, timeout);
+        }
+        return io::ReadFixed(m_desc, buf, size, index);
+    }
+
+    int SendAll(const void* buf, size_t size)
+    {
+        int index = m_desc.m_ring->FixedBufferIndex(buf, size);
+        if (index < 0)
+        {
+            return io::SendAllFastpath(m_desc, buf, size);
+        }
+
+        size_t offset = 0;
+        while (offset < size)
+        {
+            int sent = io::WriteFixed(m_desc, (const char*)buf + offset, size - offset, index);
+            if (sent <= 0)
+            {
+                return sent;
+            }
+            offset += sent;
+        }
+        return (int)size;
+    }
+
+    // A gather write names no buffer index, so it pins the pages as a plain writev does
+    //
+    int SendAllv(struct iovec* iov, int iovcnt)
+    {
+        return io::WritevAll(m_desc, iov, iovcnt);
+    }
+
+    int SendAllZeroCopy(const void* buf, size_t size)
+    {
+        return io::SendAllZc(m_desc, buf, size);
+    }
+
+    int SendfileAll(int in_fd, off_t offset, size_t count)
+    {
+        return io::SendfileAll(m_desc, in_fd, offset, count);
+    }
+
+    // Body bytes may be spliced straight off the socket (ReceiveBodyToFile), and onto it
+    // (SendBodyFrom)
+    //
+    bool CanSplice() const { return !m_desc.m_direct && m_desc.m_fd >= 0; }
+    bool CanSpliceInto() const { return CanSplice(); }
+
+    io::Descriptor& m_desc;
+};
+
+// ArmedStream is the receive side of a connection served on multishot recv: one armed recv on a
+// provided buffer ring (io::ArmedHandle) for the connection's whole life, plus the part of the
+// latest chunk the parser has not taken yet. While no request is in flight the connection holds
+// no recv buffer at all -- the kernel picks one from the shared ring only when bytes land -- so an
+// idle keep-alive connection costs its context and this, not a parser buffer.
+//
+struct ArmedStream
+{
+    ArmedStream(Context* ctx, io::Descriptor& desc, io::BufferRing* ring)
+    : m_armed(ctx, desc, ring, &m_coord)
+    {
+        m_armed.Arm();
+    }
+
+    // Block until some bytes have arrived. False once the peer has closed, on error, or if
+    // timeout (when positive) passes first.
+    //
+    bool Wait(time::Interval timeout)
+    {
+        return Fill(timeout) > 0;
+    }
+
+    // Copy up to size arrived bytes into buf, blocking for them as Wait does. Returns the bytes
+    // copied, or 0 / a negative errno as a recv would.
+    //
+    int Read(void* buf, size_t size, time::Interval timeout)
+    {
+        int ret = Fill(timeout);
+        if (ret <= 0)
+        {
+            return ret;
+        }
+        size_t n = size < m_remaining ? size : m_remaining;
+        memcpy(buf, m_data, n);
+        m_data += n;
+        m_remaining -= n;
+        return int(n);
+    }
+
+    // Bytes from the current chunk not yet read
+    //
+    bool Buffered() const { return m_remaining > 0; }
+
+  private:
+    // Make sure part of a chunk is on hand: 1 if so, else 0 (closed) or a negative errno
+    //
+    int Fill(time::Interval timeout)
+    {
+        while (m_remaining == 0)
+        {
+            io::ArmedHandle::Chunk chunk;
+            int n = m_armed.Next(&chunk, timeout);
+            if (n == -ENOBUFS)
+            {
+                // The shared ring ran dry and the kernel disarmed us; our last buffer went back
+                // with Next, so re-arm and wait for the pool to refill
+                //
+                m_armed.Arm();
+                continue;
+            }
+            if (n <= 0)
+            {
+                return n;
+            }
+            m_data = chunk.data;
+            m_remaining = size_t(n);
+        }
+        return 1;
+    }
+
+    Coordinator      m_coord;
+    io::ArmedHandle  m_armed;
+    const char*      m_data = nullptr;
+    size_t           m_remaining = 0;
+};
+
+// ArmedTransport is PlaintextTransport with its recvs served from an ArmedStream: the parser's
+// recv buffer is filled by copying out of the provided buffer the kernel chose. Sends go through
+// the ordinary fastpath ops.
+//
+struct ArmedTransport
+{
+    ArmedTransport(io::Descriptor& desc, ArmedStream& stream) : m_desc(desc), m_stream(stream) {}
+
+    io::Descriptor& Descriptor() { return m_desc; }
+
+    int Recv(void* buf, size_t size, int flags, time::Interval timeout)
+    {
+        assert(flags == 0 && "a multishot recv takes no per-call flags");
+        (void)flags;
+        return m_stream.Read(buf, size, timeout);
+    }
+
+    int SendAll(const void* buf, size_t size)
+    {
+        return io::SendAllFastpath(m_desc, buf, size);
+    }
+
+    int SendAllv(struct iovec* iov, int iovcnt)
+    {
+        return io::WritevAll(m_desc, iov, iovcnt);
+    }
+
+    int SendAllZeroCopy(const void* buf, size_t size)
+    {
+        return io::SendAllZc(m_desc, buf, size);
+    }
+
+    int SendfileAll(int in_fd, off_t offset, size_t count)
+    {
+        return io::SendfileAll(m_desc, in_fd, offset, count);
+    }
+
+    // The armed multishot recv owns the socket's incoming bytes; outgoing ones are the socket's
+    //
+    bool CanSplice() const { return false; }
+    bool CanSpliceInto() const { return !m_desc.m_direct && m_desc.m_fd >= 0; }
+
     io::Descriptor& m_desc;
+    ArmedStream&    m_stream;
 };
 
 } // end namespace coop::http
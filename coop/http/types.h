@@ -15,6 +15,7 @@ struct RequestLine
 {
     std::string_view method;
     std::string_view path;      // before '?'
+    std::string_view query;     // after '?', empty if none; as sent, until the args are read
 };
 
 // Parsed HTTP response status line. String_view points into the recv buffer.
@@ -18,7 +18,14 @@ namespace coop
 namespace io
 {
 
+static inline void PrepAcceptDirect(struct io_uring_sqe* sqe, int fd, struct sockaddr* addr,
+    socklen_t* addrLen, int flags)
+{
+    io_uring_prep_accept_direct(sqe, fd, addr, addrLen, flags, IORING_FILE_INDEX_ALLOC);
+}
+
 COOP_IO_IMPLEMENTATIONS(Accept, io_uring_prep_accept, ACCEPT_ARGS)
+COOP_IO_IMPLEMENTATIONS(AcceptDirect, PrepAcceptDirect, ACCEPT_ARGS)
 
 } // end namespace coop::io
 } // end namespace coop
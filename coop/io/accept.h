@@ -17,6 +17,12 @@ struct Handle;
     F(struct sockaddr*, addr, = nullptr) F(socklen_t*, addrLen, = nullptr) F(int, flags, = 0)
 COOP_IO_DECLARATIONS(Accept, ACCEPT_ARGS)
 
+// Accept straight into the ring's direct range (UringConfiguration::directSlots): the kernel picks
+// a free slot (IORING_FILE_INDEX_ALLOC) and no process fd is created. Returns the slot, to adopt
+// with Descriptor(direct, slot), or a negative errno (-ENFILE once the range is full).
+//
+COOP_IO_DECLARATIONS(AcceptDirect, ACCEPT_ARGS)
+
 } // end namespace coop::io
 } // end namespace coop
 
@@ -1,13 +1,18 @@
 #include <cassert>
 #include <cerrno>
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <liburing.h>
+#include <unistd.h>
 
 #include "armed_handle.h"
 
 #include "buffer_ring.h"
 #include "descriptor.h"
+#include "udp.h"
 #include "uring.h"
+#include "zcrx.h"
 
 #include "coop/context.h"
 #include "coop/coordinate_with.h"
@@ -26,16 +31,22 @@ namespace io
 static constexpr uintptr_t kArmedTag  = 0x2;
 static constexpr uintptr_t kCancelTag = 0x1;
 
+// IORING_OP_RECV_ZC (6.15), whose enum value older headers lack
+//
+static constexpr int kOpRecvZc = 58;
+
 ArmedHandle::ArmedHandle(
     Context* context,
     Descriptor& descriptor,
     BufferRing* bufferRing,
-    Coordinator* coordinator)
+    Coordinator* coordinator,
+    bool bundle /* = false */)
 : m_ring(descriptor.m_ring)
 , m_descriptor(&descriptor)
 , m_bufferRing(bufferRing)
 , m_coord(coordinator)
 , m_context(context)
+, m_bundle(bundle && descriptor.m_ring->SupportsRecvBundles() && !bufferRing->Incremental())
 {
     // The queue is allocated lazily on the first surfaced chunk -- see Enqueue. Sizing it here
     // would charge every armed connection O(pool) of resident memory whether or not any bytes
@@ -44,13 +55,74 @@ ArmedHandle::ArmedHandle(
     //
 }
 
+ArmedHandle::ArmedHandle(
+    Context* context,
+    Descriptor& descriptor,
+    BufferRingSet* set,
+    Coordinator* coordinator,
+    bool bundle /* = false */)
+: ArmedHandle(context, descriptor, set->Class(0), coordinator, bundle)
+{
+    m_set = set;
+}
+
+ArmedHandle::ArmedHandle(
+    Accepting,
+    Context* context,
+    Descriptor& listener,
+    Coordinator* coordinator,
+    bool installDirect /* = false */)
+: m_ring(listener.m_ring)
+, m_descriptor(&listener)
+, m_bufferRing(nullptr)
+, m_coord(coordinator)
+, m_context(context)
+, m_accept(true)
+, m_direct(installDirect)
+{
+    assert(!installDirect || m_ring->SupportsDirectDescriptors());
+}
+
+ArmedHandle::ArmedHandle(
+    Datagrams,
+    Context* context,
+    Descriptor& descriptor,
+    BufferRing* bufferRing,
+    Coordinator* coordinator,
+    uint32_t nameLen /* = sizeof(struct sockaddr_in6) */,
+    uint32_t controlLen /* = 0 */)
+: ArmedHandle(context, descriptor, bufferRing, coordinator)
+{
+    assert(!bufferRing->Incremental() && "multishot recvmsg needs whole buffers");
+    m_datagram = true;
+    m_msg.msg_namelen = nameLen;
+    m_msg.msg_controllen = controlLen;
+}
+
+ArmedHandle::ArmedHandle(
+    ZeroCopy,
+    Context* context,
+    Descriptor& descriptor,
+    ZcrxQueue* queue,
+    Coordinator* coordinator)
+: m_ring(descriptor.m_ring)
+, m_descriptor(&descriptor)
+, m_bufferRing(nullptr)
+, m_zcrx(queue)
+, m_coord(coordinator)
+, m_context(context)
+{
+    assert(queue->Registered());
+}
+
 ArmedHandle::~ArmedHandle()
 {
     m_tearingDown = true;
 
-    if (m_armed)
+    if (m_armed || m_cancelPending)
     {
-        // A multishot is still live in the kernel. Cancel it and cooperatively block until the
+        // A multishot is still live in the kernel, or a regroup cancel has yet to be acknowledged.
+        // Cancel it (unless that cancel is already in flight) and cooperatively block until the
         // cancel acknowledgment and the terminal recv CQE drain; the drain path releases the
         // coordinator, which wakes this Flash. Mirrors io::Handle's destructor contract.
         //
@@ -67,9 +139,42 @@ ArmedHandle::~ArmedHandle()
 
     if (m_returnBid >= 0)
     {
-        m_bufferRing->ReturnAndPublish(uint32_t(m_returnBid));
+        m_returnRing->Return(uint32_t(m_returnBid), uint32_t(m_returnLen));
+        m_returnRing->Publish();
         m_returnBid = -1;
     }
+
+    // Area bytes are the NIC's to fill next: hand back everything still queued, not just the
+    // chunk last handed out
+    //
+    if (m_zcrx)
+    {
+        if (m_returnZc)
+        {
+            m_zcrx->Return(m_returnZc, uint32_t(m_returnLen));
+            m_returnZc = nullptr;
+        }
+        while (m_qCount > 0)
+        {
+            Chunk c = Dequeue();
+            if (c.len > 0)
+            {
+                m_zcrx->Return(c.data, uint32_t(c.len));
+            }
+        }
+        m_zcrx->Publish();
+    }
+
+    // Connections the kernel accepted but nobody took
+    //
+    while (m_accept && m_qCount > 0)
+    {
+        Chunk c = Dequeue();
+        if (c.len >= 0)
+        {
+            CloseAccepted(c.len);
+        }
+    }
 }
 
 void ArmedHandle::Arm()
@@ -79,12 +184,57 @@ void ArmedHandle::Arm()
     auto* sqe = m_ring->GetSqe();
     assert(sqe);
 
-    // A multishot recv that names only the buffer group: the kernel selects a pool buffer per
-    // delivery and reports its id in cqe->flags. No userspace recv buffer is pinned.
-    //
-    io_uring_prep_recv_multishot(sqe, m_descriptor->m_fd, nullptr, 0, 0);
-    sqe->flags |= IOSQE_BUFFER_SELECT;
-    sqe->buf_group = m_bufferRing->Group();
+    if (m_accept)
+    {
+        // Direct install lets the kernel pick a free slot in the reserved range
+        // (IORING_FILE_INDEX_ALLOC); the CQE reports the slot
+        //
+        if (m_direct)
+        {
+            io_uring_prep_multishot_accept_direct(sqe, m_descriptor->m_fd, nullptr, nullptr, 0);
+        }
+        else
+        {
+            io_uring_prep_multishot_accept(sqe, m_descriptor->m_fd, nullptr, nullptr, 0);
+        }
+    }
+    else if (m_zcrx)
+    {
+        // No buffer named at all: the bytes land in the queue's area, and the CQE says where. The
+        // queue id shares the SQE word with file_index (zcrx_ifq_idx in 6.15 headers); len 0
+        // leaves the multishot unbounded.
+        //
+        io_uring_prep_rw(kOpRecvZc, sqe, m_descriptor->m_fd, nullptr, 0, 0);
+        sqe->ioprio |= IORING_RECV_MULTISHOT;
+        sqe->file_index = m_zcrx->Id();
+    }
+    else
+    {
+        if (m_set && m_set->Class(m_class) != m_bufferRing)
+        {
+            m_bufferRing = m_set->Class(m_class);
+            m_regroups++;
+        }
+
+        // A multishot recv that names only the buffer group: the kernel selects a pool buffer per
+        // delivery and reports its id in cqe->flags. No userspace recv buffer is pinned. The
+        // recvmsg flavor lays each buffer out by m_msg's name and control lengths.
+        //
+        if (m_datagram)
+        {
+            io_uring_prep_recvmsg_multishot(sqe, m_descriptor->m_fd, &m_msg, 0);
+        }
+        else
+        {
+            io_uring_prep_recv_multishot(sqe, m_descriptor->m_fd, nullptr, 0, 0);
+        }
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = m_bufferRing->Group();
+        if (m_bundle)
+        {
+            sqe->ioprio |= IORING_RECVSEND_BUNDLE;
+        }
+    }
 
     if (m_descriptor->m_registeredIndex >= 0)
     {
@@ -104,7 +254,7 @@ void ArmedHandle::Arm()
 
 void ArmedHandle::Cancel()
 {
-    if (!m_armed)
+    if (!m_armed || m_cancelPending)
     {
         return;
     }
@@ -131,6 +281,14 @@ void ArmedHandle::Dispatch(struct io_uring_cqe* cqe, uintptr_t data)
     {
         self->OnCancelAck(cqe);
     }
+    else if (self->m_accept)
+    {
+        self->OnAccept(cqe);
+    }
+    else if (self->m_zcrx)
+    {
+        self->OnRecvZc(cqe);
+    }
     else
     {
         self->OnRecv(cqe);
@@ -143,6 +301,7 @@ void ArmedHandle::OnRecv(struct io_uring_cqe* cqe)
     bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
     uint32_t bid = 0;
     bool hasBuf = BufferRing::SelectedBuffer(cqe, &bid);
+    bool held = hasBuf && (cqe->flags & IORING_CQE_F_BUF_MORE) != 0;
 
     // The CQ head is not advanced here. Uring::Poll reaps the whole ready batch and issues a
     // single io_uring_cq_advance after the last callback returns; a per-CQE io_uring_cqe_seen
@@ -165,12 +324,30 @@ void ArmedHandle::OnRecv(struct io_uring_cqe* cqe)
         //
         if (hasBuf)
         {
-            m_bufferRing->ReturnAndPublish(bid);
+            m_bufferRing->Consume(bid, res > 0 ? uint32_t(res) : 0, held);
+            if (!held)
+            {
+                m_bufferRing->Return(bid, res > 0 ? uint32_t(res) : 0);
+                m_bufferRing->Publish();
+            }
         }
         MaybeReleaseForTeardown();
         return;
     }
 
+    if (!more && m_regroupPending)
+    {
+        // The multishot ended, by our cancel or on its own: either way the next Arm() moves it to
+        // m_class. The cancel's own terminal is not news to the consumer.
+        //
+        m_regroupPending = false;
+        if (res == -ECANCELED)
+        {
+            Arm();
+            return;
+        }
+    }
+
     if (res == -ENOBUFS)
     {
         // The pool drained and the kernel disarmed the multishot. Surface a terminal so the
@@ -179,7 +356,7 @@ void ArmedHandle::OnRecv(struct io_uring_cqe* cqe)
         //
         m_enobufs++;
         m_finalResult = res;
-        Enqueue(nullptr, res, -1);
+        Enqueue(nullptr, res, -1, nullptr);
         WakeConsumer();
         return;
     }
@@ -187,15 +364,15 @@ void ArmedHandle::OnRecv(struct io_uring_cqe* cqe)
     if (res < 0)
     {
         m_finalResult = res;
-        Enqueue(nullptr, res, -1);
+        Enqueue(nullptr, res, -1, nullptr);
         WakeConsumer();
         return;
     }
 
     // res >= 0: a data chunk (res > 0) or EOF (res == 0).
     //
-    char* data = hasBuf ? m_bufferRing->Buffer(bid) : nullptr;
-    Enqueue(data, res, hasBuf ? int32_t(bid) : -1);
+    char* data = hasBuf ? m_bufferRing->Consume(bid, uint32_t(res), held) : nullptr;
+    Enqueue(data, res, hasBuf ? int32_t(bid) : -1, m_bufferRing, held);
 
     if (res == 0)
     {
@@ -206,6 +383,10 @@ void ArmedHandle::OnRecv(struct io_uring_cqe* cqe)
     else
     {
         m_delivered++;
+        if (m_set)
+        {
+            Observe(res);
+        }
         if (!more)
         {
             // Benign multishot termination with data still flowing -- re-arm transparently so the
@@ -218,6 +399,108 @@ void ArmedHandle::OnRecv(struct io_uring_cqe* cqe)
     WakeConsumer();
 }
 
+void ArmedHandle::OnRecvZc(struct io_uring_cqe* cqe)
+{
+    int res = cqe->res;
+    bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+    char* data = res > 0 ? m_zcrx->Consume(cqe) : nullptr;
+
+    if (!more)
+    {
+        m_armed = false;
+        m_ring->m_pendingOps--;
+    }
+
+    if (m_tearingDown)
+    {
+        if (data)
+        {
+            m_zcrx->ReturnAndPublish(data, uint32_t(res));
+        }
+        MaybeReleaseForTeardown();
+        return;
+    }
+
+    // The same stream shape as OnRecv, minus the pool: an error or EOF ends it, and a benign end
+    // with data flowing re-arms
+    //
+    Enqueue(data, res, -1, nullptr);
+    if (res <= 0)
+    {
+        m_finalResult = res;
+    }
+    else
+    {
+        m_delivered++;
+        if (!more)
+        {
+            Arm();
+        }
+    }
+    WakeConsumer();
+}
+
+void ArmedHandle::OnAccept(struct io_uring_cqe* cqe)
+{
+    int res = cqe->res;
+    bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+
+    if (!more)
+    {
+        m_armed = false;
+        m_ring->m_pendingOps--;
+    }
+
+    if (m_tearingDown)
+    {
+        if (res >= 0)
+        {
+            CloseAccepted(res);
+        }
+        MaybeReleaseForTeardown();
+        return;
+    }
+
+    if (res < 0)
+    {
+        // An error with F_MORE (e.g. a transient -EMFILE) leaves the accept armed; without it the
+        // stream is over until the caller re-arms
+        //
+        if (!more)
+        {
+            m_finalResult = res;
+        }
+        Enqueue(nullptr, res, -1, nullptr);
+        WakeConsumer();
+        return;
+    }
+
+    m_delivered++;
+    Enqueue(nullptr, res, -1, nullptr);
+    if (!more && m_cancelPending)
+    {
+        // Ended on its own with a Cancel on the way: stay disarmed, as the cancel would have
+        //
+        m_finalResult = -ECANCELED;
+        Enqueue(nullptr, -ECANCELED, -1, nullptr);
+    }
+    else if (!more)
+    {
+        Arm();                                  // benign termination: keep accepting
+    }
+    WakeConsumer();
+}
+
+void ArmedHandle::CloseAccepted(int res)
+{
+    if (m_direct)
+    {
+        Descriptor slot(direct, res, m_ring);   // clears the slot on destruction
+        return;
+    }
+    ::close(res);
+}
+
 void ArmedHandle::OnCancelAck(struct io_uring_cqe* cqe)
 {
     // CQ-head advance is deferred to Uring::Poll's batch io_uring_cq_advance (see OnRecv); this
@@ -226,7 +509,93 @@ void ArmedHandle::OnCancelAck(struct io_uring_cqe* cqe)
     (void)cqe;
     m_cancelPending = false;
     m_ring->m_pendingOps--;
-    MaybeReleaseForTeardown();
+    if (m_tearingDown)
+    {
+        MaybeReleaseForTeardown();
+    }
+}
+
+// The header the kernel writes at the front of every multishot recvmsg buffer (the ABI's struct
+// io_uring_recvmsg_out), followed by msg_namelen bytes of name, msg_controllen bytes of control
+// and then the payload
+//
+struct RecvMsgOut
+{
+    uint32_t namelen;
+    uint32_t controllen;
+    uint32_t payloadlen;
+    uint32_t flags;
+};
+
+bool ArmedHandle::ParseDatagram(Chunk const& chunk, Datagram* out) const
+{
+    assert(m_datagram);
+    size_t nameOffset = sizeof(RecvMsgOut);
+    size_t controlOffset = nameOffset + m_msg.msg_namelen;
+    size_t payloadOffset = controlOffset + m_msg.msg_controllen;
+    if (chunk.len < 0 || size_t(chunk.len) < payloadOffset)
+    {
+        return false;
+    }
+
+    RecvMsgOut header;
+    memcpy(&header, chunk.data, sizeof(header));
+
+    uint32_t nameLen = std::min<uint32_t>(header.namelen, m_msg.msg_namelen);
+    out->name = nameLen
+        ? reinterpret_cast<struct sockaddr const*>(chunk.data + nameOffset)
+        : nullptr;
+    out->nameLen = nameLen;
+    out->payload = chunk.data + payloadOffset;
+    out->payloadLen = std::min<uint32_t>(header.payloadlen, uint32_t(chunk.len - payloadOffset));
+    out->truncated = (header.flags & (MSG_TRUNC | MSG_CTRUNC)) != 0
+                  || header.namelen > m_msg.msg_namelen
+                  || out->payloadLen < header.payloadlen;
+
+    // Walk the control messages the kernel wrote for a GRO segment size
+    //
+    out->segment = 0;
+    if (header.controllen > 0)
+    {
+        struct msghdr control{};
+        control.msg_control = chunk.data + controlOffset;
+        control.msg_controllen = std::min<uint32_t>(header.controllen, m_msg.msg_controllen);
+        out->segment = UdpGroSegment(control);
+    }
+    return true;
+}
+
+void ArmedHandle::Observe(int32_t len)
+{
+    // A message is a run of full buffers ended by a partial one. A bulk stream that never ends one
+    // is cut at the largest class, which is then what it needs.
+    //
+    m_runBytes += uint32_t(len);
+    uint32_t largest = m_set->Class(m_set->Count() - 1)->BufSize();
+    if (uint32_t(len) % m_bufferRing->BufSize() == 0 && m_runBytes < largest)
+    {
+        return;
+    }
+
+    uint32_t message = m_runBytes;
+    m_runBytes = 0;
+    m_avgMessage = m_avgMessage == 0 ? message : m_avgMessage - m_avgMessage / 4 + message / 4;
+
+    int target = m_set->ClassFor(m_avgMessage);
+    if (target == m_class)
+    {
+        return;
+    }
+    m_class = target;
+
+    // Still armed on the old group: cancel, and OnRecv re-arms on the terminal. A multishot that
+    // is ending anyway re-arms through Arm(), which picks up m_class.
+    //
+    if (m_armed && !m_cancelPending)
+    {
+        m_regroupPending = true;
+        Cancel();
+    }
 }
 
 void ArmedHandle::WakeConsumer()
@@ -249,18 +618,37 @@ void ArmedHandle::MaybeReleaseForTeardown()
     }
 }
 
-void ArmedHandle::Enqueue(char* data, int32_t len, int32_t bid)
+void ArmedHandle::Enqueue(char* data, int32_t len, int32_t bid, BufferRing* ring, bool held)
 {
-    if (m_queue.empty())
+    if (m_accept || m_zcrx || m_bufferRing->Incremental())
+    {
+        // Accepts and zero-copy recvs have no buffer pool to bound them, and an incremental buffer
+        // can be carved into any number of chunks: grow to the largest burst, unrolling the ring
+        // into the new storage
+        //
+        if (m_qCount == m_queue.size())
+        {
+            std::vector<Chunk> grown(m_queue.empty() ? 64 : m_queue.size() * 2);
+            for (uint32_t i = 0; i < m_qCount; i++)
+            {
+                grown[i] = m_queue[(m_qHead + i) % m_queue.size()];
+            }
+            m_queue.swap(grown);
+            m_qHead = 0;
+            m_qTail = m_qCount;
+        }
+    }
+    else if (m_queue.empty())
     {
         // First chunk for this connection: size the queue to a hard bound it can never exceed.
         // At most pool-many buffers can be checked out at once (a checked-out buffer is one not
-        // yet recycled), plus headroom for a terminal (EOF / error) marker.
+        // yet recycled), plus headroom for a terminal (EOF / error) marker. A handle on a set can
+        // hold buffers of every class across a switch.
         //
-        m_queue.resize(m_bufferRing->Entries() + 4);
+        m_queue.resize((m_set ? m_set->TotalEntries() : m_bufferRing->Entries()) + 4);
     }
     assert(m_qCount < m_queue.size());
-    m_queue[m_qTail] = Chunk{data, len, bid};
+    m_queue[m_qTail] = Chunk{data, len, bid, ring, held};
     m_qTail = (m_qTail + 1) % m_queue.size();
     m_qCount++;
 }
@@ -275,14 +663,25 @@ ArmedHandle::Chunk ArmedHandle::Dequeue()
 }
 
 int ArmedHandle::Next(Chunk* out)
+{
+    return Next(out, time::Interval(0));
+}
+
+int ArmedHandle::Next(Chunk* out, time::Interval timeout)
 {
     // Recycle the buffer handed out by the previous Next() now that the caller is done with it.
     //
     if (m_returnBid >= 0)
     {
-        m_bufferRing->ReturnAndPublish(uint32_t(m_returnBid));
+        m_returnRing->Return(uint32_t(m_returnBid), uint32_t(m_returnLen));
+        m_returnRing->Publish();
         m_returnBid = -1;
     }
+    if (m_returnZc)
+    {
+        m_zcrx->ReturnAndPublish(m_returnZc, uint32_t(m_returnLen));
+        m_returnZc = nullptr;
+    }
 
     while (m_qCount == 0)
     {
@@ -290,23 +689,89 @@ int ArmedHandle::Next(Chunk* out)
         {
             // Stream finished and nothing buffered: report the terminal result idempotently.
             //
-            *out = Chunk{nullptr, 0, -1};
+            *out = Chunk{nullptr, 0, -1, nullptr, false};
             return m_finalResult;
         }
 
         m_consumerParked = true;
-        CoordinateWith(m_context, m_coord);
+        if (timeout.count() > 0)
+        {
+            if (CoordinateWith(m_context, m_coord, timeout).TimedOut())
+            {
+                m_consumerParked = false;
+                *out = Chunk{nullptr, 0, -1, nullptr, false};
+                return -ETIMEDOUT;
+            }
+        }
+        else
+        {
+            CoordinateWith(m_context, m_coord);
+        }
         m_consumerParked = false;
     }
 
     Chunk c = Dequeue();
-    if (c.bid >= 0)
+    if (c.bid >= 0 && !c.held)
     {
+        m_returnRing = c.ring;
         m_returnBid = c.bid;
+        m_returnLen = c.len > 0 ? c.len : 0;
+    }
+    else if (m_zcrx && c.len > 0)
+    {
+        m_returnZc = c.data;
+        m_returnLen = c.len;
     }
     *out = c;
     return c.len;
 }
 
+BufferRing::Pieces ArmedHandle::Pieces(Chunk const& chunk) const
+{
+    assert(chunk.bid >= 0);
+    return chunk.ring->Bundle(uint32_t(chunk.bid), uint32_t(chunk.len),
+        uint32_t(chunk.data - chunk.ring->Buffer(uint32_t(chunk.bid))));
+}
+
+int ArmedHandle::Accept()
+{
+    return NextAccepted(/*killable=*/false);
+}
+
+int ArmedHandle::AcceptKill()
+{
+    return NextAccepted(/*killable=*/true);
+}
+
+int ArmedHandle::NextAccepted(bool killable)
+{
+    assert(m_accept);
+
+    while (m_qCount == 0)
+    {
+        if (!m_armed)
+        {
+            return m_finalResult < 0 ? m_finalResult : -EINVAL;     // ended, or never armed
+        }
+
+        m_consumerParked = true;
+        if (killable)
+        {
+            if (CoordinateWithKill(m_context, m_coord).Killed())
+            {
+                m_consumerParked = false;
+                return -ECANCELED;
+            }
+        }
+        else
+        {
+            CoordinateWith(m_context, m_coord);
+        }
+        m_consumerParked = false;
+    }
+
+    return Dequeue().len;
+}
+
 } // end namespace io
 } // end namespace coop
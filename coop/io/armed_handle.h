@@ -1,8 +1,15 @@
 #pragma once
 
 #include <cstdint>
+#include <netinet/in.h>
+#include <sys/socket.h>
 #include <vector>
 
+#include "buffer_ring.h"
+#include "buffer_ring_set.h"
+
+#include "coop/time/interval.h"
+
 struct io_uring_cqe;
 
 namespace coop
@@ -14,10 +21,26 @@ struct Coordinator;
 namespace io
 {
 
-struct BufferRing;
 struct Descriptor;
 struct Uring;
 
+// Tag type selecting ArmedHandle's multishot accept mode
+//
+struct Accepting {};
+inline constexpr Accepting accepting;
+
+// Tag type selecting ArmedHandle's multishot recvmsg mode, for datagram sockets
+//
+struct Datagrams {};
+inline constexpr Datagrams datagrams;
+
+// Tag type selecting ArmedHandle's multishot zero-copy recv mode, over a ZcrxQueue
+//
+struct ZeroCopy {};
+inline constexpr ZeroCopy zeroCopy;
+
+struct ZcrxQueue;
+
 // ArmedHandle: the multishot-aware sibling of io::Handle.
 //
 // Why a separate type
@@ -64,6 +87,69 @@ struct Uring;
 // The owning context and the consuming context are the same: Next() and the destructor both run
 // on m_context. Cross-context fan-out (a detached continuation per CQE) is a later layer.
 //
+// Bundles
+// -------
+//
+// With bundle set (and a kernel that supports it, Uring::SupportsRecvBundles), each recv CQE may
+// cover a run of ring buffers rather than one, so a 64KB burst into 4KB buffers is one CQE and one
+// consumer wake instead of sixteen. A chunk's len can then exceed the ring's BufSize(): data is
+// the first buffer only, and Pieces(chunk) iterates every buffer of the run. The whole run is
+// recycled in one batch on the following Next(). Without kernel support the flag is dropped and
+// every chunk is a single buffer, as before.
+//
+// Incremental buffers
+// -------------------
+//
+// On an incremental BufferRing (BufferRing::Incremental) successive chunks may be carved from the
+// same buffer, each chunk's data pointing just past the previous one's. A chunk marked held is
+// not the last its buffer will take, so Next() leaves the buffer with the kernel; the chunk that
+// ends the buffer recycles it. Bundles are not combined with incremental rings: the flag is
+// dropped, since a 64KB buffer that absorbs many messages is the point.
+//
+// Size classes
+// ------------
+//
+// Constructed on a BufferRingSet, the handle starts on the smallest class and tracks the size of
+// the messages it receives: a message is a run of full buffers ended by a partial one. When a
+// running average of recent message sizes calls for a different class (the smallest whose buffers
+// hold it), the handle cancels its multishot and re-arms it on that class's group as soon as the
+// terminal CQE lands. Chunks already queued keep their own ring, so nothing is lost or reordered
+// across the switch; the switch costs one cancel round trip and is invisible to Next().
+//
+// Multishot recvmsg
+// -----------------
+//
+// Constructed with the `datagrams` tag on a datagram socket, the handle arms a multishot
+// IORING_OP_RECVMSG over the buffer ring instead: one CQE per datagram, each landing in a pool
+// buffer behind a kernel header, its source address (nameLen bytes reserved) and its control
+// messages (controlLen reserved -- UDP_GRO_CONTROL for GRO). Next() surfaces the whole buffer and
+// ParseDatagram splits it. With UDP_GRO on (SetUdpGro), one chunk may hold a coalesced run of
+// datagrams, segment bytes each. Needs kernel 6.0+; older kernels end the stream with -EINVAL on
+// the first Next(). Not combined with bundles, incremental rings or size classes.
+//
+// Zero-copy recv
+// --------------
+//
+// Constructed with the `zeroCopy` tag on a registered ZcrxQueue (zcrx.h), the handle arms a
+// multishot IORING_OP_RECV_ZC instead: the payload is already in the queue's area when the CQE
+// lands, and each chunk's data points at it there. bid is -1 and ring is nullptr; the chunk is
+// handed back to the queue's refill ring on the following Next(), as a pool buffer would be. The
+// socket's flow must be steered to the queue's NIC rx queue, and the ring set up for it (see
+// ZcrxQueue); otherwise the stream ends with the kernel's error on the first Next(). Not combined
+// with bundles, size classes or Pieces().
+//
+// Multishot accept
+// ----------------
+//
+// Constructed with the `accepting` tag on a listening Descriptor, the same lifecycle drives an
+// IORING_ACCEPT_MULTISHOT accept instead: one SQE yields a CQE per incoming connection, and
+// Accept() / AcceptKill() pop accepted fds in arrival order, where one-shot Accept pays a
+// resubmission per connection. No buffer ring is involved, and the queue grows to whatever
+// burst lands in one Poll. With installDirect the kernel installs each socket straight into the
+// ring's reserved direct range (UringConfiguration::directSlots) and the result is a slot for a
+// Descriptor(direct, slot) rather than an fd. Accepted connections still queued at destruction
+// are closed.
+//
 struct ArmedHandle
 {
     ArmedHandle(ArmedHandle const&) = delete;
@@ -71,16 +157,25 @@ struct ArmedHandle
 
     // A chunk of received bytes surfaced from one CQE. data points into the BufferRing slot and
     // is valid until the next Next() call (which returns the slot to the kernel). bid is the
-    // kernel buffer id, or -1 for a terminal completion (EOF / error) that carries no buffer.
+    // kernel buffer id, or -1 for a terminal completion (EOF / error) that carries no buffer, and
+    // ring the BufferRing it came from. held marks a chunk from an incremental buffer the kernel
+    // is still filling; its bytes stay valid until the buffer's last chunk is recycled.
     //
     struct Chunk
     {
-        char*   data;
-        int32_t len;
-        int32_t bid;
+        char*       data;
+        int32_t     len;
+        int32_t     bid;
+        BufferRing* ring;
+        bool        held;
     };
 
-    ArmedHandle(Context*, Descriptor&, BufferRing*, Coordinator*);
+    ArmedHandle(Context*, Descriptor&, BufferRing*, Coordinator*, bool bundle = false);
+    ArmedHandle(Context*, Descriptor&, BufferRingSet*, Coordinator*, bool bundle = false);
+    ArmedHandle(Accepting, Context*, Descriptor& listener, Coordinator*, bool installDirect = false);
+    ArmedHandle(Datagrams, Context*, Descriptor&, BufferRing*, Coordinator*,
+        uint32_t nameLen = sizeof(struct sockaddr_in6), uint32_t controlLen = 0);
+    ArmedHandle(ZeroCopy, Context*, Descriptor&, ZcrxQueue*, Coordinator*);
     ~ArmedHandle();
 
     // Submit the multishot recv. Holds the coordinator on the first call. Re-arm is automatic on
@@ -96,12 +191,59 @@ struct ArmedHandle
     //
     int Next(Chunk* out);
 
+    // Next, giving up with -ETIMEDOUT if no chunk arrives within timeout. The multishot stays
+    // armed; a later Next() picks up where this left off.
+    //
+    int Next(Chunk* out, time::Interval timeout);
+
+    // The buffers behind a data chunk from Next(), in order; a single piece unless bundled
+    //
+    BufferRing::Pieces Pieces(Chunk const& chunk) const;
+
+    // A datagram taken apart from a datagram-mode data chunk. name (nullptr if none) and payload
+    // point into the chunk's buffer and share its lifetime. truncated marks a payload, or a
+    // source address, cut short by the buffer size; segment is the GRO segment size, 0 for a
+    // single datagram.
+    //
+    struct Datagram
+    {
+        struct sockaddr const*  name;
+        uint32_t                nameLen;
+        char const*             payload;
+        uint32_t                payloadLen;
+        uint16_t                segment;
+        bool                    truncated;
+    };
+
+    // Split a data chunk from Next() in datagram mode. Returns false if the buffer is too short to
+    // hold the header the kernel writes.
+    //
+    bool ParseDatagram(Chunk const& chunk, Datagram* out) const;
+
+    // Accept mode. Block until the next connection is accepted, returning its fd (its direct slot
+    // with installDirect), or a negative errno once the multishot has ended on an error -- Arm()
+    // again to resume. AcceptKill() also returns -ECANCELED if the owning context is killed.
+    //
+    int Accept();
+    int AcceptKill();
+
     bool Armed() const { return m_armed; }
 
+    // Cancel the multishot, leaving the descriptor open. What it already delivered is still
+    // handed out; then Next() or Accept() returns the -ECANCELED it ended with, and it stays
+    // disarmed until Arm(). No-op when not armed.
+    //
+    void Cancel();
+
     // Diagnostics for tests / observability.
     //
     uint64_t Delivered() const { return m_delivered; }
     uint64_t Enobufs() const { return m_enobufs; }
+    uint64_t Regroups() const { return m_regroups; }
+
+    // The ring the multishot is (or will next be) armed on
+    //
+    BufferRing* Ring() const { return m_bufferRing; }
 
     // CQE dispatch entry point, routed from Handle::Callback by the armed tag bit. data is the
     // raw (tagged) userdata; bit 0 distinguishes the cancel acknowledgment from a recv CQE.
@@ -110,10 +252,14 @@ struct ArmedHandle
 
 private:
     void OnRecv(struct io_uring_cqe* cqe);
+    void OnRecvZc(struct io_uring_cqe* cqe);
+    void OnAccept(struct io_uring_cqe* cqe);
     void OnCancelAck(struct io_uring_cqe* cqe);
 
-    void Cancel();
-    void Enqueue(char* data, int32_t len, int32_t bid);
+    int NextAccepted(bool killable);
+    void CloseAccepted(int res);
+    void Observe(int32_t len);
+    void Enqueue(char* data, int32_t len, int32_t bid, BufferRing* ring, bool held = false);
     Chunk Dequeue();
     void WakeConsumer();
     void MaybeReleaseForTeardown();
@@ -121,28 +267,51 @@ private:
     Uring*       m_ring;
     Descriptor*  m_descriptor;
     BufferRing*  m_bufferRing;
+    BufferRingSet* m_set{nullptr};
+    ZcrxQueue*   m_zcrx{nullptr};
     Coordinator* m_coord;
     Context*     m_context;
 
     // Bounded circular queue of surfaced chunks. Capacity exceeds the buffer pool size, so it
     // can never overflow: a checked-out buffer is one not yet recycled, and there are only pool
-    // many buffers.
+    // many buffers. Accept mode and incremental rings, which have no such bound, grow it instead.
     //
     std::vector<Chunk> m_queue;
     uint32_t m_qHead{0};
     uint32_t m_qTail{0};
     uint32_t m_qCount{0};
 
-    int32_t  m_returnBid{-1};   // buffer to recycle on the next Next(), or -1
+    BufferRing* m_returnRing{nullptr};
+    int32_t  m_returnBid{-1};   // buffer (or first of a bundle) to recycle on the next Next(), or -1
+    int32_t  m_returnLen{0};    // bytes of that chunk, which size its bundle
+    char*    m_returnZc{nullptr};   // zero-copy: the area bytes to refill on the next Next()
     int32_t  m_finalResult{0};  // result returned once the stream is drained and disarmed
 
+    // Size-class policy, with m_set: the class to arm on, bytes of the message in progress, and
+    // the running average message size
+    //
+    int      m_class{0};
+    uint32_t m_runBytes{0};
+    uint32_t m_avgMessage{0};
+
     bool     m_armed{false};
     bool     m_cancelPending{false};
     bool     m_consumerParked{false};
     bool     m_tearingDown{false};
+    bool     m_accept{false};
+    bool     m_datagram{false};
+    bool     m_direct{false};
+    bool     m_bundle{false};
+    bool     m_regroupPending{false};   // cancelled to move to m_class; re-arm on the terminal CQE
+
+    // Datagram mode: the recvmsg template, whose name and control lengths lay out every buffer.
+    // The kernel reads it at arm time.
+    //
+    struct msghdr m_msg{};
 
     uint64_t m_delivered{0};
     uint64_t m_enobufs{0};
+    uint64_t m_regroups{0};
 };
 
 static_assert(alignof(ArmedHandle) >= 8, "ArmedHandle must be 8-byte aligned for tagged userdata");
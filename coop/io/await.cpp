@@ -0,0 +1,36 @@
+#include "await.h"
+
+#include "handle.h"
+
+#include "coop/continuation.h"
+#include "coop/io/detail/handle_extension.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+bool HandleAwaiter::await_ready()
+{
+    return handle.TryComplete();
+}
+
+void HandleAwaiter::await_suspend(std::coroutine_handle<> awaiter)
+{
+    // The coordinator is held from Submit until Finalize releases it on the last CQE, which pops
+    // this continuation
+    //
+    detail::HandleExtension::Coord(handle)->ContinueDetached([awaiter](Coordinator*)
+    {
+        awaiter.resume();
+    });
+}
+
+int HandleAwaiter::await_resume()
+{
+    return handle.Result();
+}
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <coroutine>
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Handle;
+
+// co_await io::Await(handle) suspends a coop::Task until the operation submitted on handle (a
+// contextless Handle, see Handle(Descriptor&, Coordinator*)) completes, and yields its result. An
+// operation the kernel completes inline is reaped without suspending, as in Handle::Wait.
+// Otherwise a detached continuation on the handle's coordinator resumes the Task from the loop's
+// continuation drain when the last CQE lands.
+//
+//     coop::Coordinator coord;
+//     coop::io::Handle handle(desc, &coord);
+//     if (!coop::io::Recv(handle, buf, sizeof(buf))) co_return -EAGAIN;
+//     int n = co_await coop::io::Await(handle);
+//
+struct HandleAwaiter
+{
+    bool await_ready();
+    void await_suspend(std::coroutine_handle<> awaiter);
+    int await_resume();
+
+    Handle& handle;
+};
+
+inline HandleAwaiter Await(Handle& handle)
+{
+    return HandleAwaiter{handle};
+}
+
+} // end namespace coop::io
+} // end namespace coop
@@ -6,6 +6,21 @@
 
 #include "uring.h"
 
+// Compat defines for kernel headers that predate recv bundles (6.10). Stable kernel ABI.
+//
+#ifndef IORING_RECVSEND_BUNDLE
+#define IORING_RECVSEND_BUNDLE (1U << 4)
+#endif
+
+// ...and incrementally consumed buffers (6.12)
+//
+#ifndef IOU_PBUF_RING_INC
+#define IOU_PBUF_RING_INC 2
+#endif
+#ifndef IORING_CQE_F_BUF_MORE
+#define IORING_CQE_F_BUF_MORE (1U << 4)
+#endif
+
 namespace coop
 {
 
@@ -44,6 +59,26 @@ namespace io
 //        v  application consumes Buffer(bid) bytes
 //   Return(bid) -- hand the slot back; advance so the kernel may reuse it
 //
+// Bundles
+// -------
+//
+// A bundle recv (IORING_RECVSEND_BUNDLE, 6.10+) fills as many buffers as the bytes need in one
+// CQE: the CQE names the first buffer id, and the rest are the ring entries that followed it. Ring
+// order is not id order once buffers come back out of order, so the ring keeps a shadow of which
+// id sits in which entry; Bundle(bid, len) walks one with it, and Return(bid, len) hands the
+// whole run back in one batch.
+//
+// Incremental consumption
+// -----------------------
+//
+// Normally a recv consumes a whole buffer however few bytes land, so a ring of 64KB buffers
+// spends 64KB per 100-byte message. An incremental ring (IOU_PBUF_RING_INC, 6.12+) lets the kernel
+// carve successive recvs out of the same buffer: a CQE with IORING_CQE_F_BUF_MORE says the buffer
+// still has room and will be filled further, so it must not be returned yet; the CQE without it
+// is the buffer's last. The ring keeps each buffer's consumed offset, and Consume() turns a CQE
+// into a pointer to the bytes it delivered. Registration falls back to whole-buffer consumption on
+// kernels without it; Incremental() reports which mode is live.
+//
 // If the application falls behind and the kernel finds the ring empty, the recv completes with
 // -ENOBUFS and (for multishot) the recv is disarmed. Callers MUST handle -ENOBUFS by re-arming,
 // optionally after a one-shot classic recv into a private buffer to avoid dropping the wakeup.
@@ -57,12 +92,18 @@ struct BufferRing
     // group is the buffer-group id named by recvs that draw from this ring; it must be unique
     // among buffer rings on the same Uring.
     //
-    BufferRing(uint16_t group, uint32_t entries, uint32_t bufSize)
+    // incremental asks for IOU_PBUF_RING_INC; see Incremental().
+    //
+    BufferRing(uint16_t group, uint32_t entries, uint32_t bufSize, bool incremental = false)
     : m_group(group)
     , m_entries(entries)
     , m_bufSize(bufSize)
     , m_mask(io_uring_buf_ring_mask(entries))
+    , m_incremental(incremental)
     , m_storage(size_t(entries) * bufSize)
+    , m_entryBid(entries)
+    , m_bidEntry(entries)
+    , m_consumed(incremental ? entries : 0)
     {
     }
 
@@ -72,7 +113,21 @@ struct BufferRing
     int Register(Uring& uring)
     {
         int err = 0;
-        m_ring = io_uring_setup_buf_ring(&uring.m_ring, m_entries, m_group, 0, &err);
+        if (m_incremental)
+        {
+            // Older kernels reject the flag outright; whole-buffer consumption still works
+            //
+            m_ring = io_uring_setup_buf_ring(&uring.m_ring, m_entries, m_group, IOU_PBUF_RING_INC,
+                &err);
+            if (!m_ring)
+            {
+                m_incremental = false;
+            }
+        }
+        if (!m_ring)
+        {
+            m_ring = io_uring_setup_buf_ring(&uring.m_ring, m_entries, m_group, 0, &err);
+        }
         if (!m_ring)
         {
             return err;
@@ -80,7 +135,7 @@ struct BufferRing
         m_uring = &uring;
         for (uint32_t b = 0; b < m_entries; b++)
         {
-            io_uring_buf_ring_add(m_ring, Slot(b), m_bufSize, b, m_mask, b);
+            Add(b, b);
         }
         io_uring_buf_ring_advance(m_ring, m_entries);
         return 0;
@@ -96,6 +151,18 @@ struct BufferRing
 
     uint16_t Group() const { return m_group; }
     uint32_t Entries() const { return m_entries; }
+    uint32_t BufSize() const { return m_bufSize; }
+
+    // Whether the registered ring consumes buffers incrementally (meaningful after Register)
+    //
+    bool Incremental() const { return m_incremental; }
+
+    // Buffers the application holds: delivered by a recv CQE (counted at Consume, an incremental
+    // buffer once, at its first chunk) and not yet Returned. An occupancy gauge for metrics;
+    // Entries() - InUse() is what the kernel has left to select from, give or take returns
+    // awaiting Publish.
+    //
+    uint32_t InUse() const { return m_inUse; }
 
     // The bytes the kernel delivered into slot `bid`. Valid until Return(bid).
     //
@@ -106,7 +173,107 @@ struct BufferRing
     //
     void Return(uint32_t bid)
     {
-        io_uring_buf_ring_add(m_ring, Slot(bid), m_bufSize, bid, m_mask, m_pending++);
+        Add(bid, m_pending++);
+        if (m_inUse)
+        {
+            m_inUse--;
+        }
+    }
+
+    // The buffers a recv of len bytes filled, starting at first: one for a plain recv, as many as
+    // len needs for a bundle. Each piece is a full buffer except possibly the last.
+    //
+    struct Piece
+    {
+        char*    data;
+        uint32_t len;
+        uint32_t bid;
+    };
+
+    struct Pieces
+    {
+        struct Iterator
+        {
+            Piece operator*() const
+            {
+                uint32_t bid = ring->m_entryBid[entry & ring->m_mask];
+                return Piece{ring->Slot(bid) + offset, Length(), bid};
+            }
+
+            Iterator& operator++()
+            {
+                remaining -= Length();
+                offset = 0;
+                entry++;
+                return *this;
+            }
+
+            uint32_t Length() const
+            {
+                uint32_t room = ring->m_bufSize - offset;
+                return remaining < room ? remaining : room;
+            }
+
+            bool operator!=(Iterator const& other) const { return remaining != other.remaining; }
+
+            BufferRing* ring;
+            uint32_t    entry;
+            uint32_t    remaining;
+            uint32_t    offset;
+        };
+
+        Iterator begin() const { return Iterator{ring, entry, len, offset}; }
+        Iterator end() const { return Iterator{ring, 0, 0, 0}; }
+        uint32_t Count() const { return (offset + len + ring->m_bufSize - 1) / ring->m_bufSize; }
+
+        BufferRing* ring;
+        uint32_t    entry;
+        uint32_t    len;
+        uint32_t    offset;
+    };
+
+    // offset is where the bytes start in the first buffer: non-zero only for a chunk carved from
+    // an incrementally consumed buffer
+    //
+    Pieces Bundle(uint32_t first, uint32_t len, uint32_t offset = 0)
+    {
+        return Pieces{this, m_bidEntry[first], len, offset};
+    }
+
+    // Return every buffer of a bundle (see Bundle). A zero-length recv still consumed first.
+    // Batches like Return(bid): visible to the kernel on Publish().
+    //
+    void Return(uint32_t first, uint32_t len)
+    {
+        if (len == 0)
+        {
+            Return(first);
+            return;
+        }
+        for (Piece piece : Bundle(first, len))
+        {
+            Return(piece.bid);
+        }
+    }
+
+    // The bytes a recv CQE delivered into bid. On an incremental ring they follow whatever
+    // earlier CQEs left in the buffer; more is the CQE's IORING_CQE_F_BUF_MORE, and while it is
+    // set the buffer must not be returned. Otherwise the same as Buffer(bid).
+    //
+    char* Consume(uint32_t bid, uint32_t len, bool more)
+    {
+        if (!m_incremental)
+        {
+            m_inUse += len > m_bufSize ? (len + m_bufSize - 1) / m_bufSize : 1;     // a bundle
+            return Slot(bid);
+        }
+        if (!m_consumed[bid])
+        {
+            m_inUse++;
+        }
+        char* data = Slot(bid) + m_consumed[bid];
+        m_consumed[bid] = more ? m_consumed[bid] + len : 0;
+        return data;
     }
 
     void Publish()
@@ -140,14 +307,29 @@ struct BufferRing
 private:
     char* Slot(uint32_t b) { return m_storage.data() + size_t(b) * m_bufSize; }
 
+    // Publish-pending add at tail + offset, recording which ring entry now holds bid
+    //
+    void Add(uint32_t bid, uint32_t offset)
+    {
+        uint32_t entry = uint16_t(m_ring->tail + offset);
+        m_entryBid[entry & m_mask] = bid;
+        m_bidEntry[bid] = entry;
+        io_uring_buf_ring_add(m_ring, Slot(bid), m_bufSize, bid, m_mask, offset);
+    }
+
     Uring* m_uring{nullptr};
     struct io_uring_buf_ring* m_ring{nullptr};
     uint16_t m_group;
     uint32_t m_entries;
     uint32_t m_bufSize;
     int m_mask;
+    bool m_incremental;
     uint32_t m_pending{0};
+    uint32_t m_inUse{0};
     std::vector<char> m_storage;
+    std::vector<uint32_t> m_entryBid;   // ring entry (masked) -> bid it holds
+    std::vector<uint32_t> m_bidEntry;   // bid -> unmasked ring entry it was added at
+    std::vector<uint32_t> m_consumed;   // incremental: bid -> bytes the kernel has filled so far
 };
 
 } // end namespace io
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "buffer_ring.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+// Several provided buffer rings of different buffer sizes, one buffer group each, so connections
+// with different message sizes draw from pools that suit them.
+//
+// A single BufferRing forces one buffer size on every connection: small buffers cost a CQE (and a
+// wake) per few hundred bytes of a bulk flow, large ones tie up 64KB of pool for a 200-byte
+// keep-alive request. With a set, an ArmedHandle constructed on it starts on the smallest class
+// and moves its multishot recv between groups as its recent message sizes change (see
+// ArmedHandle), so resident recv memory stays close to the bytes actually in flight.
+//
+// Classes are added smallest first. Like BufferRing, a set is registered explicitly, or configured
+// on the Uring via UringConfiguration::bufferRingClassSizes.
+//
+struct BufferRingSet
+{
+    static constexpr int MAX_CLASSES = 4;
+
+    BufferRingSet() = default;
+    BufferRingSet(BufferRingSet const&) = delete;
+    BufferRingSet& operator=(BufferRingSet const&) = delete;
+
+    // Add a class of entries buffers (a power of two) of bufSize bytes under its own group id.
+    // bufSize must exceed every class already added. Returns false if the set is full or the
+    // ordering is violated.
+    //
+    bool Add(uint16_t group, uint32_t entries, uint32_t bufSize)
+    {
+        if (m_count == MAX_CLASSES || (m_count > 0 && bufSize <= m_classes[m_count - 1]->BufSize()))
+        {
+            return false;
+        }
+        m_classes[m_count++] = std::make_unique<BufferRing>(group, entries, bufSize);
+        return true;
+    }
+
+    // Register every class. Returns 0 on success or the first negative errno; on failure the set
+    // must not be used (classes already registered are unregistered when it is destroyed).
+    //
+    int Register(Uring& uring)
+    {
+        for (int i = 0; i < m_count; i++)
+        {
+            int err = m_classes[i]->Register(uring);
+            if (err < 0)
+            {
+                return err;
+            }
+        }
+        return 0;
+    }
+
+    int Count() const { return m_count; }
+    BufferRing* Class(int i) const { return m_classes[i].get(); }
+
+    // The smallest class whose buffers hold bytes, or the largest class if none does
+    //
+    int ClassFor(uint32_t bytes) const
+    {
+        for (int i = 0; i < m_count; i++)
+        {
+            if (m_classes[i]->BufSize() >= bytes)
+            {
+                return i;
+            }
+        }
+        return m_count - 1;
+    }
+
+    // Buffers across every class: the most a handle moving between classes can hold checked out
+    //
+    uint32_t TotalEntries() const
+    {
+        uint32_t total = 0;
+        for (int i = 0; i < m_count; i++)
+        {
+            total += m_classes[i]->Entries();
+        }
+        return total;
+    }
+
+private:
+    std::unique_ptr<BufferRing> m_classes[MAX_CLASSES];
+    int m_count{0};
+};
+
+} // end namespace io
+} // end namespace coop
@@ -0,0 +1,53 @@
+#include "busy_poll.h"
+
+#include <cerrno>
+#include <sys/socket.h>
+
+#include "descriptor.h"
+#include "uring.h"
+
+#include "coop/cooperator.h"
+
+// Older libc headers predate the busy-poll socket options
+//
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+
+namespace coop
+{
+
+namespace io
+{
+
+int SetBusyPoll(Descriptor& desc, uint32_t usecs, bool preferBusyPoll /* = false */)
+{
+    int value = static_cast<int>(usecs);
+    if (setsockopt(desc.m_fd, SOL_SOCKET, SO_BUSY_POLL, &value, sizeof(value)) < 0)
+    {
+        return -errno;
+    }
+    value = preferBusyPoll ? 1 : 0;
+    if (preferBusyPoll
+        && setsockopt(desc.m_fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &value, sizeof(value)) < 0)
+    {
+        return -errno;
+    }
+    return 0;
+}
+
+int SetBusyPoll(Descriptor& desc)
+{
+    auto const& config = Cooperator::thread_cooperator->GetUring()->GetConfiguration();
+    if (config.busyPollUs == 0)
+    {
+        return 0;
+    }
+    return SetBusyPoll(desc, config.busyPollUs, config.preferBusyPoll);
+}
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Descriptor;
+
+// Socket-level busy polling (SO_BUSY_POLL, SO_PREFER_BUSY_POLL), the per-socket half of
+// UringConfiguration::busyPollUs. A blocking receive on such a socket polls its NIC queue for up
+// to usecs before sleeping, and preferBusyPoll keeps softirqs off that queue while it is polled.
+// An accepted socket inherits its listener's setting, so a server sets it once on the listener.
+//
+// Raising usecs above net.core.busy_poll needs CAP_NET_ADMIN. Returns 0 or a negative errno:
+// -EPERM for that, -ENOPROTOOPT on a kernel without the option (SO_PREFER_BUSY_POLL is 5.11+).
+//
+int SetBusyPoll(Descriptor& desc, uint32_t usecs, bool preferBusyPoll = false);
+
+// The same with the calling cooperator's UringConfiguration::busyPollUs and preferBusyPoll. A
+// no-op returning 0 when busyPollUs is 0.
+//
+int SetBusyPoll(Descriptor& desc);
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,102 @@
+#include "chain.h"
+
+#include <cassert>
+#include <liburing.h>
+#include <new>
+
+#include <spdlog/spdlog.h>
+
+#include "descriptor.h"
+#include "uring.h"
+
+#include "coop/io/detail/handle_extension.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+Chain::Chain(Context* ctx /* = Self() */, Uring* ring /* = GetUring() */)
+: m_context(ctx)
+, m_ring(ring)
+{
+    assert(m_context && m_ring);
+}
+
+Chain::~Chain()
+{
+    // Front to back: cancelling an in-flight head fails the steps linked behind it, so their own
+    // drains find them already completing
+    //
+    for (int i = 0; i < m_steps; i++)
+    {
+        Step(i).~Handle();
+    }
+}
+
+void Chain::Prepare(Link link)
+{
+    assert(m_steps < MAX_STEPS && "chain too long");
+    assert((m_steps == 0 || m_lastLink != Link::End) && "step appended after Last()");
+
+    // Keep the whole chain in one submission: a GetSqe that finds the SQ full flushes it, and a
+    // flush between two linked SQEs would end the chain early
+    //
+    if (m_steps == 0 && io_uring_sq_space_left(&m_ring->m_ring) < MAX_STEPS)
+    {
+        m_ring->Submit();
+    }
+    m_lastLink = link;
+}
+
+static uint8_t LinkFlags(Link link)
+{
+    switch (link)
+    {
+        case Link::Soft:    return IOSQE_IO_LINK;
+        case Link::Hard:    return IOSQE_IO_HARDLINK;
+        case Link::End:     break;
+    }
+    return 0;
+}
+
+Handle& Chain::Then(Descriptor& desc, Link link /* = Link::Soft */)
+{
+    assert(desc.m_ring == m_ring);
+    Prepare(link);
+    auto* handle = new (m_storage[m_steps]) Handle(m_context, desc, &m_coords[m_steps]);
+    detail::HandleExtension::SetLinkFlags(*handle, LinkFlags(link));
+    m_steps++;
+    return *handle;
+}
+
+Handle& Chain::Then(Link link /* = Link::Soft */)
+{
+    Prepare(link);
+    auto* handle = new (m_storage[m_steps]) Handle(m_context, m_ring, &m_coords[m_steps]);
+    detail::HandleExtension::SetLinkFlags(*handle, LinkFlags(link));
+    m_steps++;
+    return *handle;
+}
+
+int Chain::Wait()
+{
+    assert(m_steps > 0 && m_lastLink == Link::End && "chain not closed with Last()");
+
+    // The kernel posts a chain's CQEs in step order, so once the last step has completed every
+    // earlier one has too: one wake covers the pipeline
+    //
+    int result = Step(m_steps - 1).Wait();
+    SPDLOG_TRACE("chain complete steps={} result={}", m_steps, result);
+    return result;
+}
+
+int Chain::Result(int step) const
+{
+    assert(step >= 0 && step < m_steps);
+    return Step(step).Result();
+}
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+
+#include "coop/coordinator.h"
+#include "coop/self.h"
+
+#include "handle.h"
+
+namespace coop
+{
+
+struct Context;
+
+namespace io
+{
+
+struct Descriptor;
+struct Uring;
+
+// How a chain step hands off to the step after it.
+//
+//   Soft   IOSQE_IO_LINK: the next step starts only once this one succeeds. An error -- or a short
+//          read/write/splice, which the kernel also counts as a failure -- completes every later
+//          step with -ECANCELED.
+//   Hard   IOSQE_IO_HARDLINK: the next step starts once this one completes, whatever its result.
+//   End    the final step; nothing follows it.
+//
+enum class Link : uint8_t
+{
+    End,
+    Soft,
+    Hard,
+};
+
+// A pipeline of io_uring operations issued as one linked SQE chain: the kernel runs the steps in
+// order, and the calling context blocks once, on the last step, rather than once per operation.
+//
+//     io::Chain chain;
+//     io::OpenDirect(chain.Then(), path, O_RDONLY, 0, slot);
+//     io::Read(chain.Then(file, io::Link::Hard), buf, size, -1);
+//     io::Read(chain.Last(file), &probe, 1, -1);
+//     chain.Wait();
+//     int opened = chain.Result(0);
+//
+// Then/Last return the Handle for the next step; hand it to exactly one async operation (any op
+// generated by COOP_IO_IMPLEMENTATIONS or COOP_IO_URING_IMPLEMENTATIONS) before appending the
+// next. Steps must not use the timeout variants -- a linked timeout would split the chain -- and
+// the chain must be closed with Last() before Wait().
+//
+// Linked SQEs must be contiguous in the SQ, so the first step flushes the ring when it has less
+// than MAX_STEPS free entries, and nothing else may queue SQEs on this ring until Wait(). CQEs
+// arrive in step order, which is why waiting on the last step covers them all. Each step's
+// Result() is its own CQE's result: a step skipped behind a failed soft link reports -ECANCELED.
+//
+// If the chain is destroyed with steps in flight (the context was killed), each step's Handle
+// cancels and drains in turn, as a lone Handle would.
+//
+struct Chain
+{
+    static constexpr int MAX_STEPS = 8;
+
+    Chain(Context* ctx = Self(), Uring* ring = GetUring());
+    ~Chain();
+
+    Chain(Chain const&) = delete;
+    Chain& operator=(Chain const&) = delete;
+
+    // Append a step on desc (or, without one, a ring-level step such as Open), linked to the step
+    // appended after it.
+    //
+    Handle& Then(Descriptor& desc, Link link = Link::Soft);
+    Handle& Then(Link link = Link::Soft);
+
+    // Append the final step
+    //
+    Handle& Last(Descriptor& desc) { return Then(desc, Link::End); }
+    Handle& Last() { return Then(Link::End); }
+
+    // Submit the chain and block until its last step completes. Returns the last step's result.
+    //
+    int Wait();
+
+    int Steps() const { return m_steps; }
+
+    // A step's result, in append order. Only valid after Wait().
+    //
+    int Result(int step) const;
+
+private:
+    Handle& Step(int i) { return *reinterpret_cast<Handle*>(m_storage[i]); }
+    Handle const& Step(int i) const { return *reinterpret_cast<Handle const*>(m_storage[i]); }
+
+    void Prepare(Link link);
+
+    Context*    m_context;
+    Uring*      m_ring;
+    int         m_steps{0};
+    Link        m_lastLink{Link::Soft};
+
+    Coordinator m_coords[MAX_STEPS];
+    alignas(Handle) unsigned char m_storage[MAX_STEPS][sizeof(Handle)];
+};
+
+} // end namespace coop::io
+} // end namespace coop
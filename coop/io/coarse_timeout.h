@@ -0,0 +1,30 @@
+#pragma once
+
+#include "coop/time/interval.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+// A timeout for an operation that does not need an exact one: an idle or keep-alive wait, where a
+// deadline serviced at the cooperator's next timer pass is as good as one the kernel fires to the
+// microsecond. Passed where a time::Interval timeout would be, it selects the coarse path (see
+// Handle::SubmitWithCoarseTimeout): the deadline lives in the cooperator's timer queue instead of
+// a linked IORING_OP_LINK_TIMEOUT, so an operation that completes first -- the usual outcome --
+// costs no timeout SQE or CQE at all, and one that does not is cancelled when the deadline passes.
+//
+// It never fires early, and the result is the same as the exact form's: -ETIMEDOUT from the
+// blocking calls, TimedOut() on the Handle. Protocol deadlines that guard correctness keep the
+// exact path.
+//
+struct CoarseTimeout
+{
+    explicit CoarseTimeout(time::Interval timeout) : interval(timeout) {}
+
+    time::Interval interval;
+};
+
+} // end namespace coop::io
+} // end namespace coop
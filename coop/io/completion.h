@@ -0,0 +1,56 @@
+#pragma once
+
+#include <utility>
+
+#include "coop/coordinator.h"
+#include "coop/io/handle.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Descriptor;
+
+// Completion<Fn> is a continuation-driven Handle (see Handle(Descriptor&, Continuation*)) bundled
+// with the function its completions run: fn(handle, result) is called inline from the reap loop
+// each time an operation submitted on it finishes. It converts to Handle&, so every async
+// operation takes it as is, and fn may submit the next one on the handle it is given.
+//
+//     io::Completion echo(desc, [&](io::Handle& handle, int n)
+//     {
+//         if (n > 0) io::Send(handle, buf, n);  // rides the batch the loop submits next
+//     });
+//     io::Recv(echo, buf, sizeof(buf));
+//
+// It is fixed in place (the Handle's address is the SQE userdata), and follows the contextless
+// handle's rule: not destroyed with an operation in flight.
+//
+template<typename Fn>
+struct Completion final : Continuation
+{
+    Completion(Descriptor& desc, Fn fn)
+    : m_handle(desc, static_cast<Continuation*>(this))
+    , m_fn(std::move(fn))
+    {
+    }
+
+    Completion(Completion const&) = delete;
+    Completion(Completion&&) = delete;
+
+    operator Handle&() { return m_handle; }
+    Handle& GetHandle() { return m_handle; }
+
+    void Run() final
+    {
+        m_fn(m_handle, m_handle.Result());
+    }
+
+  private:
+    Handle  m_handle;
+    Fn      m_fn;
+};
+
+} // end namespace coop::io
+} // end namespace coop
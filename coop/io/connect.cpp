@@ -1,19 +1,28 @@
 #include <arpa/inet.h>
 #include <cerrno>
+#include <cstring>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 
 #include <spdlog/spdlog.h>
 
 #define COOP_IO_KEEP_ARGS
 #include "connect.h"
 
+#include "coop/context.h"
 #include "coop/coordinator.h"
+#include "coop/cooperator.h"
 #include "coop/self.h"
+#include "coop/semaphore.h"
+#include "coop/time/now.h"
+#include "coop/wait_group.h"
 
+#include "chain.h"
 #include "descriptor.h"
 #include "handle.h"
 #include "resolve.h"
+#include "socket.h"
 #include "uring.h"
 
 namespace coop
@@ -28,27 +37,235 @@ int Connect(Descriptor& desc, const char* hostname, int port)
 {
     SPDLOG_DEBUG("connect fd={} host={} port={}", desc.m_fd, hostname, port);
 
-    struct sockaddr_in addr;
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
+    // Resolve for the socket's family: an IPv6 socket takes an AAAA record, or failing that an
+    // A record as a v4-mapped address
+    //
+    int domain = AF_INET;
+    socklen_t domainLen = sizeof(domain);
+    getsockopt(desc.m_fd, SOL_SOCKET, SO_DOMAIN, &domain, &domainLen);
+
+    struct sockaddr_storage addr;
+    socklen_t addrLen;
+    int ret = Resolve(hostname, port, &addr, &addrLen, domain == AF_INET6 ? AF_UNSPEC : AF_INET);
+    if (ret == 0 && domain == AF_INET6 && addr.ss_family == AF_INET)
+    {
+        struct sockaddr_in v4;
+        memcpy(&v4, &addr, sizeof(v4));
+        auto* sin6 = reinterpret_cast<struct sockaddr_in6*>(&addr);
+        memset(sin6, 0, sizeof(*sin6));
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = v4.sin_port;
+        sin6->sin6_addr.s6_addr[10] = 0xff;
+        sin6->sin6_addr.s6_addr[11] = 0xff;
+        memcpy(&sin6->sin6_addr.s6_addr[12], &v4.sin_addr, 4);
+        addrLen = sizeof(*sin6);
+    }
+    if (ret < 0)
+    {
+        spdlog::warn("connect resolve failed host={} ret={}", hostname, ret);
+        return ret;
+    }
+
+    int result = Connect(desc, (struct sockaddr*)&addr, addrLen);
+    SPDLOG_DEBUG("connect fd={} host={} port={} result={}", desc.m_fd, hostname, port, result);
+    return result;
+}
+
+namespace
+{
+
+constexpr size_t MAX_RACE = 16;
+
+// What the attempts of one ConnectAny share, on its frame: each Releases `finished` once when it
+// is done, won or lost
+//
+struct Race
+{
+    Semaphore   finished{0};
+    int         winner = -1;                // the winning socket
+    int         lastError = -ECONNREFUSED;
+};
+
+// The socket through the ring where the kernel has IORING_OP_SOCKET, else the syscall
+//
+int OpenSocket(int family)
+{
+    constexpr int type = SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC;
+    if (GetUring()->SupportsSocket())
+    {
+        return Socket(family, type);
+    }
+    int fd = ::socket(family, type, 0);
+    return fd < 0 ? -errno : fd;
+}
+
+// The options, set before the connect. Through the ring they go as one hard-linked chain, so
+// they cost one wait together, and one the kernel refuses (TCP_FASTOPEN_CONNECT where TFO is
+// compiled out) does not keep the next from being set. Either way a refused option is ignored:
+// the connection works without it.
+//
+void SetOptions(Descriptor& desc, ConnectAnyOptions const& options)
+{
+    static const int one = 1;
+    struct { int level; int name; } opts[2];
+    int n = 0;
+    if (options.noDelay)
+    {
+        opts[n++] = {IPPROTO_TCP, TCP_NODELAY};
+    }
+    if (options.fastOpen)
+    {
+        opts[n++] = {IPPROTO_TCP, TCP_FASTOPEN_CONNECT};
+    }
+    if (n == 0)
+    {
+        return;
+    }
+
+    if (!desc.m_ring->SupportsSocketCommands())
+    {
+        for (int i = 0; i < n; i++)
+        {
+            ::setsockopt(desc.m_fd, opts[i].level, opts[i].name, &one, sizeof(one));
+        }
+        return;
+    }
+
+    Chain chain;
+    for (int i = 0; i < n; i++)
+    {
+        Handle& step = i + 1 < n ? chain.Then(desc, Link::Hard) : chain.Last(desc);
+        SetSockOpt(step, opts[i].level, opts[i].name, &one, socklen_t(sizeof(one)));
+    }
+    chain.Wait();
+}
 
-    // Try numeric IP first (fast path)
+void Attempt(Race* race, struct sockaddr_storage const* addr, time::Interval timeout,
+             ConnectAnyOptions const* options)
+{
+    socklen_t len = addr->ss_family == AF_INET6 ? sizeof(struct sockaddr_in6)
+                                                : sizeof(struct sockaddr_in);
+    int fd = OpenSocket(addr->ss_family);
+    if (fd < 0)
+    {
+        race->lastError = fd;
+        race->finished.Release();
+        return;
+    }
+
+    Descriptor desc(fd);
+    SetOptions(desc, *options);
+
+    // Killed as a loser, this returns -ECANCELED with the connect cancelled and drained. With a
+    // Fast Open cookie cached for the address, the kernel defers the SYN to the first send and
+    // this returns 0 at once.
     //
-    if (inet_pton(AF_INET, hostname, &addr.sin_addr) != 1)
+    int ret = ConnectKill(desc, reinterpret_cast<struct sockaddr const*>(addr), len, timeout);
+    if (ret == 0 && race->winner < 0)
     {
-        // DNS resolve
-        //
-        int ret = Resolve4(hostname, &addr.sin_addr);
-        if (ret < 0)
+        race->winner = desc.Release();
+    }
+    else if (ret < 0 && race->winner < 0)
+    {
+        race->lastError = ret;
+        SPDLOG_DEBUG("connect any: attempt family={} failed ret={}", addr->ss_family, ret);
+    }
+    race->finished.Release();
+}
+
+} // end anonymous namespace
+
+int ConnectAny(const char* host, int port, time::Interval timeout,
+               ConnectAnyOptions const& options /* = {} */)
+{
+    struct sockaddr_storage addrs[MAX_RACE];
+    int n = ResolveAll(host, port, addrs, std::min(options.maxAddresses, MAX_RACE),
+                       options.family);
+    if (n < 0)
+    {
+        spdlog::warn("connect any: resolve failed host={} ret={}", host, n);
+        return n;
+    }
+
+    auto* ctx = Self();
+    const int64_t deadline = time::MonotonicMicros() + timeout.count();
+    Race race;
+    WaitGroup attempts;
+    Context::Handle handles[MAX_RACE];
+
+    int started = 0;
+    int finished = 0;
+    int64_t nextStart = 0;
+    int ret = 0;
+    while (race.winner < 0)
+    {
+        int64_t now = time::MonotonicMicros();
+        if (now >= deadline)
         {
-            spdlog::warn("connect resolve failed host={} ret={}", hostname, ret);
-            return ret;
+            ret = -ETIMEDOUT;
+            break;
+        }
+
+        if (started < n && (now >= nextStart || finished == started))
+        {
+            auto* addr = &addrs[started];
+            time::Interval remaining(deadline - now);
+            attempts.Add();
+            bool spawned = ctx->GetCooperator()->Spawn(
+                [&race, &attempts, addr, remaining, &options](Context*)
+            {
+                Attempt(&race, addr, remaining, &options);
+                attempts.Done();
+            }, &handles[started]);
+            if (!spawned)
+            {
+                attempts.Done();
+                race.lastError = -EAGAIN;
+                race.finished.Release();
+            }
+            started++;
+            nextStart = now + options.attemptDelay.count();
+            continue;
+        }
+        if (finished == n)
+        {
+            ret = race.lastError;
+            break;
+        }
+
+        int64_t until = started < n ? std::min(nextStart, deadline) : deadline;
+        auto result = race.finished.AcquireWithKill(ctx, 1, time::Interval(until - now));
+        if (result.Killed())
+        {
+            ret = -ECANCELED;
+            break;
+        }
+        if (result.index == 0)
+        {
+            finished++;
         }
     }
 
-    int result = Connect(desc, (struct sockaddr*)&addr, sizeof(struct sockaddr_in));
-    SPDLOG_DEBUG("connect fd={} host={} port={} result={}", desc.m_fd, hostname, port, result);
-    return result;
+    // Losers still connecting are killed, and joined: they share this frame
+    //
+    for (int i = 0; i < started; i++)
+    {
+        if (handles[i])
+        {
+            handles[i].Kill();
+        }
+    }
+    attempts.Wait(ctx);
+
+    if (race.winner >= 0)
+    {
+        SPDLOG_DEBUG("connect any host={} port={} fd={} after {} attempts", host, port,
+                     race.winner, started);
+        return race.winner;
+    }
+    spdlog::warn("connect any: host={} port={} failed after {} attempts ret={}", host, port,
+                 started, ret);
+    return ret;
 }
 
 } // end namespace coop::io
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <sys/socket.h>
 
 #include "coop/io/detail/op_macros.h"
+#include "coop/time/interval.h"
 
 namespace coop
 {
@@ -16,11 +18,56 @@ struct Handle;
 #define CONNECT_ARGS(F) F(const struct sockaddr*, addr, ) F(socklen_t, addrLen, )
 COOP_IO_DECLARATIONS(Connect, CONNECT_ARGS)
 
-// Accepts either a dotted-quad IP address or a hostname. If the string isn't a numeric address,
-// DNS resolution is performed cooperatively via Resolve4 (UDP queries through io_uring).
+// Accepts either a numeric IP address or a hostname. A name is resolved cooperatively through the
+// calling cooperator's resolver cache (resolve.h) for the socket's family: an AF_INET socket
+// takes an A record; an AF_INET6 socket prefers an A record, which it connects to through a
+// v4-mapped address, and falls back to an AAAA record.
 //
 int Connect(Descriptor& desc, const char* hostname, int port);
 
+struct ConnectAnyOptions
+{
+    // RFC 8305's Connection Attempt Delay: how long an attempt runs alone before the next
+    // address gets one alongside it. A failed attempt starts the next at once.
+    //
+    time::Interval attemptDelay = std::chrono::milliseconds(250);
+
+    // AF_INET or AF_INET6 to race one family only
+    //
+    int family = AF_UNSPEC;
+
+    // Addresses raced at most, from the front of ResolveAll's order
+    //
+    size_t maxAddresses = 8;
+
+    // TCP_NODELAY, set on each attempt's socket before it connects
+    //
+    bool noDelay = false;
+
+    // TCP Fast Open (TCP_FASTOPEN_CONNECT): once the kernel holds a cookie for an address, the
+    // connect returns at once and the first send rides the SYN, saving the handshake's round
+    // trip; the first connection to an address is an ordinary one that fetches the cookie. A dead
+    // address then fails on the first send or recv rather than the connect, and wins the race,
+    // so this suits backends whose addresses are known to answer. Needs net.ipv4.tcp_fastopen's
+    // client bit (0x1, the default).
+    //
+    bool fastOpen = false;
+};
+
+// Happy eyeballs (RFC 8305): resolve host to every address (ResolveAll, IPv6 and IPv4
+// interleaved) and race TCP connects across them, each in its own context, starting one every
+// attemptDelay. The first to connect wins; the rest are killed, which cancels their connects
+// through their io::Handles, and closed. Returns the winner's socket -- nonblocking, close-on-
+// exec, for the caller to wrap in a Descriptor -- or a negative errno: the resolver's, -ETIMEDOUT
+// when timeout passes first, -ECANCELED when the calling context is killed, else the last
+// attempt's error. timeout bounds the connects, not the DNS lookups.
+//
+// Each attempt's socket is created and its options set through the ring where the kernel can
+// (Uring::SupportsSocket, SupportsSocketCommands), so the setup costs no syscalls of its own.
+//
+int ConnectAny(const char* host, int port, time::Interval timeout,
+               ConnectAnyOptions const& options = {});
+
 } // end namespace coop::io
 } // end namespace coop
 
@@ -0,0 +1,182 @@
+#include "cork.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include "coop/context.h"
+
+#include "descriptor.h"
+#include "send.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+Cork::Cork(Descriptor& desc, size_t capacity /* = kDefaultCapacity */, Context* ctx /* = Self() */)
+: m_desc(desc)
+, m_context(ctx)
+, m_next(ctx->m_corks)
+, m_handle(desc, static_cast<Continuation*>(this))
+, m_buffer(new char[capacity])
+, m_capacity(capacity)
+, m_head(0)
+, m_flushEnd(0)
+, m_tail(0)
+, m_inflight(false)
+, m_error(0)
+{
+    assert(!desc.m_cork && "one Cork per descriptor at a time");
+    desc.m_cork = this;
+    ctx->m_corks = this;
+}
+
+Cork::~Cork()
+{
+    Flush();
+
+    m_desc.m_cork = nullptr;
+    Cork** link = &m_context->m_corks;
+    while (*link != this)
+    {
+        link = &(*link)->m_next;
+    }
+    *link = m_next;
+}
+
+int Cork::Send(const void* buf, size_t size)
+{
+    if (m_error)
+    {
+        return m_error;
+    }
+
+    if (size > m_capacity - m_tail)
+    {
+        // No room behind what is queued. Once everything queued is written the buffer is empty
+        // again, which is all the room there will ever be.
+        //
+        if (Flush() < 0)
+        {
+            return m_error;
+        }
+        if (size > m_capacity - m_tail)
+        {
+            // Bigger than the buffer: written straight through, behind everything before it
+            //
+            ++m_statistics.bypassed;
+            m_desc.m_cork = nullptr;
+            int result = SendAll(m_desc, buf, size);
+            m_desc.m_cork = this;
+            return result;
+        }
+    }
+
+    if (!m_inflight && m_head == m_tail)
+    {
+        m_head = m_flushEnd = m_tail = 0;
+    }
+    memcpy(m_buffer.get() + m_tail, buf, size);
+    m_tail += size;
+    ++m_statistics.sends;
+    return (int)size;
+}
+
+int Cork::Flush()
+{
+    WaitIdle();
+
+    if (!m_error && m_head < m_tail)
+    {
+        // No SQE for the asynchronous send; write the rest inline
+        //
+        m_desc.m_cork = nullptr;
+        int result = SendAll(m_desc, m_buffer.get() + m_head, m_tail - m_head);
+        m_desc.m_cork = this;
+        if (result < 0)
+        {
+            m_error = result;
+        }
+        else
+        {
+            m_statistics.bytes += result;
+        }
+    }
+    m_head = m_flushEnd = m_tail = 0;
+    return m_error;
+}
+
+void Cork::FlushAll(Context* ctx)
+{
+    for (Cork* cork = ctx->m_corks; cork; cork = cork->m_next)
+    {
+        cork->Kick();
+    }
+}
+
+void Cork::Kick()
+{
+    if (m_inflight || m_error || m_head == m_tail)
+    {
+        return;
+    }
+    if (SubmitPending())
+    {
+        m_inflight = true;
+        m_idle = CompletionLatch();
+    }
+}
+
+void Cork::WaitIdle()
+{
+    Kick();
+    if (m_inflight)
+    {
+        m_idle.Wait(m_context);
+    }
+}
+
+bool Cork::SubmitPending()
+{
+    m_flushEnd = m_tail;
+    if (!io::Send(m_handle, m_buffer.get() + m_head, m_flushEnd - m_head))
+    {
+        return false;
+    }
+    ++m_statistics.flushes;
+    return true;
+}
+
+void Cork::Run()
+{
+    int result = m_handle.Result();
+    if (result < 0)
+    {
+        // The buffer is lost with the stream: nothing after a failed write can be ordered
+        // behind it
+        //
+        m_error = result;
+        m_head = m_flushEnd = m_tail = 0;
+    }
+    else
+    {
+        m_head += result;
+        m_statistics.bytes += result;
+
+        // A short send's remainder, along with whatever was queued behind it meanwhile, goes
+        // out now: the context may be blocked on something else until long after
+        //
+        if (m_head < m_tail && SubmitPending())
+        {
+            return;
+        }
+    }
+
+    m_inflight = false;
+    m_idle.Fire();
+}
+
+} // end namespace coop::io
+} // end namespace coop
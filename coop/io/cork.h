@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "coop/continuation.h"
+#include "coop/self.h"
+
+#include "handle.h"
+
+namespace coop
+{
+
+struct Context;
+
+namespace io
+{
+
+struct Descriptor;
+
+struct CorkStatistics
+{
+    size_t sends{0};        // Send calls taken into the buffer
+    size_t flushes{0};      // send operations submitted for buffered bytes
+    size_t bytes{0};        // bytes those operations wrote
+    size_t bypassed{0};     // sends too large for the buffer, written straight through
+};
+
+// Cork is a write-combining buffer over a Descriptor, for handlers that write a message in pieces
+// (a header, a body, a trailer) and would otherwise pay one SQE -- and often one TCP segment -- per
+// piece. While a Cork is open, the untimed blocking Send and SendFastpath on its descriptor (and
+// SendAll, SendAllFastpath over them) copy into the buffer and return at once. The buffer goes out
+// as one send when the context next yields or blocks, so everything written in one scheduler turn
+// leaves together: MSG_MORE's coalescing, without its wait for more data that is not coming.
+//
+//     {
+//         io::Cork cork(desc);
+//         io::SendAll(desc, header, headerSize);
+//         io::SendAll(desc, body, bodySize);
+//     }                                               // one send, at the latest here
+//
+// The flush is asynchronous: a context that blocks on a Recv has its reply on the wire without
+// waiting for it. An error from a flush is sticky, and the next Send or Flush returns it. A send
+// larger than the buffer waits for the one in flight and is written straight through.
+//
+// Only those untimed sends are buffered; the blocking Writev flushes the cork before it writes.
+// Anything else that writes the descriptor -- a timed or Kill send, SendZc, an async Handle op, a
+// TLS connection over it -- must Flush first, or it can overtake the buffer. One Cork per
+// descriptor at a time, opened and used on one context.
+//
+struct Cork : Continuation
+{
+    static constexpr size_t kDefaultCapacity = 16 * 1024;
+
+    Cork(Descriptor& desc, size_t capacity = kDefaultCapacity, Context* ctx = Self());
+
+    // Flushes what is buffered, blocking until it is written
+    //
+    ~Cork();
+
+    Cork(Cork const&) = delete;
+    Cork(Cork&&) = delete;
+
+    // Buffer `size` bytes. Returns size, or the negative errno an earlier flush failed with.
+    //
+    int Send(const void* buf, size_t size);
+
+    // Write everything buffered and wait for it. Returns 0, or the sticky flush error.
+    //
+    int Flush();
+
+    // Bytes buffered and not yet written, in flight or not
+    //
+    size_t Pending() const
+    {
+        return m_tail - m_head;
+    }
+
+    CorkStatistics const& GetStatistics() const
+    {
+        return m_statistics;
+    }
+
+    // Submit every buffered cork of `ctx` that has nothing in flight. Called by Context at each
+    // Yield and Block.
+    //
+    static void FlushAll(Context* ctx);
+
+  private:
+    // Submit [m_head, m_tail) if nothing is in flight. Never blocks.
+    //
+    void Kick();
+
+    // Block until the send in flight, and whatever it picked up as it went, is written
+    //
+    void WaitIdle();
+
+    bool SubmitPending();
+
+    // The continuation-driven handle's completion, inline from the reap loop
+    //
+    void Run() final;
+
+    Descriptor& m_desc;
+    Context*    m_context;
+    Cork*       m_next;
+    Handle      m_handle;
+
+    // [m_head, m_flushEnd) is in flight, [m_flushEnd, m_tail) waits for the next send. The
+    // buffer never moves, so appending behind a send in flight is safe.
+    //
+    std::unique_ptr<char[]> m_buffer;
+    size_t                  m_capacity;
+    size_t                  m_head;
+    size_t                  m_flushEnd;
+    size_t                  m_tail;
+
+    bool            m_inflight;
+    int             m_error;
+    CompletionLatch m_idle;
+    CorkStatistics  m_statistics;
+};
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,202 @@
+#ifndef COOP_HAVE_CURL
+#define COOP_HAVE_CURL 0
+#endif
+
+#if COOP_HAVE_CURL
+
+#include <algorithm>
+#include <cerrno>
+#include <poll.h>
+
+#include "curl.h"
+#include "watcher.h"
+
+#include "coop/context.h"
+#include "coop/coordinate_with.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+namespace curl
+{
+
+// One socket curl asked to have watched: its edges queue it on the multi and wake the driver
+//
+struct Multi::Socket final : Continuation
+{
+    Socket(Multi* multi, int fd, uint32_t events)
+    : m_multi(multi)
+    , m_watcher(fd, events, static_cast<Continuation*>(this))
+    {
+    }
+
+    void Run() final
+    {
+        m_multi->OnReady(m_watcher.Fd(), m_watcher.Take());
+    }
+
+    Multi*  m_multi;
+    Watcher m_watcher;
+};
+
+static uint32_t Events(int what)
+{
+    uint32_t events = 0;
+    if (what == CURL_POLL_IN || what == CURL_POLL_INOUT)
+    {
+        events |= POLLIN;
+    }
+    if (what == CURL_POLL_OUT || what == CURL_POLL_INOUT)
+    {
+        events |= POLLOUT;
+    }
+    return events;
+}
+
+Multi::Multi(Context* context)
+: m_context(context)
+, m_multi(curl_multi_init())
+{
+    curl_multi_setopt(m_multi, CURLMOPT_SOCKETFUNCTION, &Multi::OnSocket);
+    curl_multi_setopt(m_multi, CURLMOPT_SOCKETDATA, this);
+    curl_multi_setopt(m_multi, CURLMOPT_TIMERFUNCTION, &Multi::OnTimer);
+    curl_multi_setopt(m_multi, CURLMOPT_TIMERDATA, this);
+
+    // Held by the driver for the multi's life; an edge releases it to the parked driver
+    //
+    m_wake.TryAcquire(m_context);
+}
+
+Multi::~Multi()
+{
+    curl_multi_cleanup(m_multi);
+
+    // Sockets of transfers still in flight, which cleanup closes without telling the callback
+    //
+    for (Socket* socket : m_sockets)
+    {
+        delete socket;
+    }
+    m_wake.Release(m_context, false);
+}
+
+int Multi::OnSocket(CURL* easy, curl_socket_t s, int what, void* userp, void* socketp)
+{
+    (void)easy;
+    auto* self = static_cast<Multi*>(userp);
+    auto* socket = static_cast<Socket*>(socketp);
+
+    if (what == CURL_POLL_REMOVE)
+    {
+        // curl closes the socket after this returns; the watcher drains its poll first
+        //
+        if (socket)
+        {
+            auto it = std::find(self->m_sockets.begin(), self->m_sockets.end(), socket);
+            *it = self->m_sockets.back();
+            self->m_sockets.pop_back();
+            delete socket;
+            curl_multi_assign(self->m_multi, s, nullptr);
+        }
+        return 0;
+    }
+
+    if (!socket)
+    {
+        socket = new Socket(self, s, Events(what));
+        self->m_sockets.push_back(socket);
+        curl_multi_assign(self->m_multi, s, socket);
+        return 0;
+    }
+    socket->m_watcher.SetEvents(Events(what));
+    return 0;
+}
+
+int Multi::OnTimer(CURLM* multi, long timeoutMs, void* userp)
+{
+    (void)multi;
+    auto* self = static_cast<Multi*>(userp);
+    self->m_timerArmed = timeoutMs >= 0;
+    self->m_deadline = Clock::now() + std::chrono::milliseconds(std::max(timeoutMs, 0L));
+    return 0;
+}
+
+void Multi::OnReady(int fd, uint32_t revents)
+{
+    m_ready.push_back(Ready{fd, revents});
+    if (m_parked)
+    {
+        m_parked = false;
+        m_wake.Release(m_context, false);
+    }
+}
+
+void Multi::Action(curl_socket_t s, int mask)
+{
+    curl_multi_socket_action(m_multi, s, mask, &m_running);
+}
+
+int Multi::Perform()
+{
+    Action(CURL_SOCKET_TIMEOUT, 0);
+    while (m_running > 0)
+    {
+        if (m_ready.empty())
+        {
+            // Wait for an edge, or for curl's timer -- a timed wait, and so a TimerQueue entry
+            //
+            auto now = Clock::now();
+            if (!m_timerArmed || m_deadline > now)
+            {
+                m_parked = true;
+                CoordinationResult result = m_timerArmed
+                    ? CoordinateWithKill(m_context, &m_wake,
+                          std::chrono::ceil<time::Interval>(m_deadline - now))
+                    : CoordinateWithKill(m_context, &m_wake);
+                m_parked = false;
+                if (result.Killed())
+                {
+                    return -ECANCELED;
+                }
+            }
+            if (m_ready.empty())
+            {
+                m_timerArmed = false;
+                Action(CURL_SOCKET_TIMEOUT, 0);
+                continue;
+            }
+        }
+
+        // Actions may remove sockets and queue new edges: work from a copy
+        //
+        m_draining.swap(m_ready);
+        for (Ready const& ready : m_draining)
+        {
+            int mask = 0;
+            mask |= (ready.revents & POLLIN) ? CURL_CSELECT_IN : 0;
+            mask |= (ready.revents & POLLOUT) ? CURL_CSELECT_OUT : 0;
+            mask |= (ready.revents & (POLLERR | POLLHUP)) ? CURL_CSELECT_ERR : 0;
+            Action(ready.fd, mask);
+        }
+        m_draining.clear();
+
+        // A timer that came due while the sockets were busy
+        //
+        if (m_timerArmed && m_deadline <= Clock::now())
+        {
+            m_timerArmed = false;
+            Action(CURL_SOCKET_TIMEOUT, 0);
+        }
+    }
+    return 0;
+}
+
+} // end namespace coop::io::curl
+} // end namespace coop::io
+} // end namespace coop
+
+#endif // COOP_HAVE_CURL
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "coop/coordinator.h"
+
+// libcurl's multi_socket API on a context. curl asks, through CURLMOPT_SOCKETFUNCTION, to have
+// each of its sockets watched for reading or writing, and through CURLMOPT_TIMERFUNCTION to be
+// called back after a timeout; curl::Multi answers the first with one continuation-driven
+// io::Watcher per socket and the second with a timed wait on the cooperator's timer queue. One
+// driver context runs every transfer added to it, much as one thread runs a curl event loop:
+//
+//   io::curl::Multi multi(ctx);
+//   multi.Add(easy1);
+//   multi.Add(easy2);
+//   multi.Perform();                       // until both are done, or ctx is killed
+//   while (CURLMsg* m = curl_multi_info_read(multi.Get(), &left)) { ... }
+//
+// A ready socket's edge runs inline from the reap loop and only queues the socket and wakes the
+// driver; curl_multi_socket_action runs on the driver context, where curl may add, change and
+// remove watchers. Built when CMake finds libcurl (COOP_HAVE_CURL).
+//
+
+namespace coop
+{
+
+struct Context;
+
+namespace io
+{
+
+namespace curl
+{
+
+struct Multi
+{
+    explicit Multi(Context* context);
+    ~Multi();
+
+    Multi(Multi const&) = delete;
+
+    CURLM* Get() const { return m_multi; }
+
+    CURLMcode Add(CURL* easy) { return curl_multi_add_handle(m_multi, easy); }
+    CURLMcode Remove(CURL* easy) { return curl_multi_remove_handle(m_multi, easy); }
+
+    // Drive the transfers added so far until none is running. 0, or -ECANCELED when the driver
+    // context is killed first, with the rest still in flight. Finished transfers are reported by
+    // curl_multi_info_read, as usual.
+    //
+    int Perform();
+
+    size_t Sockets() const { return m_sockets.size(); }
+
+  private:
+    struct Socket;
+    struct Ready
+    {
+        int         fd;
+        uint32_t    revents;
+    };
+
+    static int OnSocket(CURL* easy, curl_socket_t s, int what, void* userp, void* socketp);
+    static int OnTimer(CURLM* multi, long timeoutMs, void* userp);
+
+    void OnReady(int fd, uint32_t revents);
+    void Action(curl_socket_t s, int mask);
+
+    using Clock = std::chrono::steady_clock;
+
+    Context*                m_context;
+    CURLM*                  m_multi;
+    Coordinator             m_wake;
+    bool                    m_parked = false;
+    bool                    m_timerArmed = false;
+    Clock::time_point       m_deadline;
+    int                     m_running = 0;
+    std::vector<Ready>      m_ready;
+    std::vector<Ready>      m_draining;
+    std::vector<Socket*>    m_sockets;
+};
+
+} // end namespace coop::io::curl
+} // end namespace coop::io
+} // end namespace coop
@@ -1,12 +1,18 @@
 #include "descriptor.h"
 
+#include <cassert>
+#include <liburing.h>
 #include <spdlog/spdlog.h>
 
 #include "close.h"
+#include "detached.h"
+#include "handle.h"
 #include "uring.h"
 
 #include "coop/context.h"
+#include "coop/coordinator.h"
 #include "coop/detail/embedded_list.h"
+#include "coop/detail/timer_tag.h"
 
 namespace coop
 {
@@ -19,6 +25,7 @@ Descriptor::Descriptor(int fd, Uring* ring /* = GetUring() */)
 , m_fd(fd)
 , m_registeredIndex(-1)
 , m_owned(true)
+, m_direct(false)
 {
     assert(m_ring);
     SPDLOG_DEBUG("descriptor create fd={}", m_fd);
@@ -30,6 +37,7 @@ Descriptor::Descriptor(Registered, int fd, Uring* ring /* = GetUring() */)
 , m_fd(fd)
 , m_registeredIndex(-1)
 , m_owned(true)
+, m_direct(false)
 {
     assert(m_ring);
     SPDLOG_DEBUG("descriptor create registered fd={}", m_fd);
@@ -42,19 +50,35 @@ Descriptor::Descriptor(Borrowed, int fd, Uring* ring /* = GetUring() */)
 , m_fd(fd)
 , m_registeredIndex(-1)
 , m_owned(false)
+, m_direct(false)
 {
     assert(m_ring);
     SPDLOG_DEBUG("descriptor create borrowed fd={}", m_fd);
     m_ring->m_descriptors.Push(this);
 }
 
+Descriptor::Descriptor(Direct, int slot, Uring* ring /* = GetUring() */)
+: m_ring(ring)
+, m_fd(-1)
+, m_registeredIndex(slot)
+, m_owned(true)
+, m_direct(true)
+{
+    assert(m_ring);
+    SPDLOG_DEBUG("descriptor create direct slot={}", slot);
+    m_ring->m_descriptors.Push(this);
+}
+
 Descriptor::~Descriptor()
 {
     if (m_registeredIndex >= 0)
     {
         m_ring->Unregister(this);
     }
-    if (m_owned && m_fd >= 0)
+    // Nothing waits on a destructor's close, so it is detached; only a full SQ falls back to a
+    // blocking close
+    //
+    if (m_owned && m_fd >= 0 && !CloseDetached(*this))
     {
         int fd = m_fd;
         int result = Close();
@@ -68,16 +92,89 @@ Descriptor::~Descriptor()
 
 int Descriptor::Close()
 {
+    // A direct descriptor's file is only referenced by its slot: clearing the slot closes it
+    //
+    if (m_direct)
+    {
+        if (m_registeredIndex >= 0)
+        {
+            CancelAndDrain();
+            m_ring->Unregister(this);
+        }
+        return 0;
+    }
+
     if (!m_owned || m_fd < 0)
     {
         return 0;
     }
+    CancelAndDrain();
+
+    // IORING_OP_CLOSE refuses a fixed file, so a registered fd leaves the table first
+    //
+    if (m_registeredIndex >= 0)
+    {
+        m_ring->Unregister(this);
+    }
     SPDLOG_DEBUG("descriptor close fd={}", m_fd);
     int result = io::Close(*this);
     m_fd = -1;
     return result;
 }
 
+void Descriptor::Cancel()
+{
+    if (m_handles.IsEmpty())
+    {
+        return;
+    }
+
+    // One cancel for the whole file, matched by the file itself: a registered descriptor's ops
+    // went in through its slot, so the slot names it. The cancel's own CQE is dropped.
+    //
+    if (m_ring->SupportsCancelFd() && (m_registeredIndex >= 0 || m_fd >= 0))
+    {
+        auto* sqe = m_ring->GetSqe();
+        assert(sqe);
+        if (m_registeredIndex >= 0)
+        {
+            io_uring_prep_cancel_fd(sqe, m_registeredIndex,
+                                    IORING_ASYNC_CANCEL_ALL | IORING_ASYNC_CANCEL_FD_FIXED);
+        }
+        else
+        {
+            io_uring_prep_cancel_fd(sqe, m_fd, IORING_ASYNC_CANCEL_ALL);
+        }
+        io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(coop::detail::kCancelFdTag));
+        return;
+    }
+
+    m_handles.Visit([](Handle* handle) -> bool
+    {
+        handle->Cancel();
+        return true;
+    });
+}
+
+void Descriptor::CancelAndDrain(Context* ctx /* = Self() */)
+{
+    if (m_handles.IsEmpty())
+    {
+        return;
+    }
+    assert(!m_drained && "one CancelAndDrain at a time");
+
+    Cancel();
+
+    // Held here and released by the Finalize that empties the list, as a Handle's own coordinator
+    // is by its one operation
+    //
+    Coordinator drained;
+    drained.TryAcquire(ctx);
+    m_drained = &drained;
+    drained.Flash(ctx);
+}
+
 int Descriptor::Release()
 {
     int fd = m_fd;
@@ -85,5 +182,30 @@ int Descriptor::Release()
     return fd;
 }
 
+bool Descriptor::Unbind()
+{
+    assert(m_handles.IsEmpty());
+    assert(!m_direct && "a direct descriptor lives in its ring's file table and cannot migrate");
+    bool registered = m_registeredIndex >= 0;
+    if (registered)
+    {
+        m_ring->Unregister(this);
+    }
+    m_ring->m_descriptors.Remove(this);
+    m_ring = nullptr;
+    return registered;
+}
+
+void Descriptor::Rebind(Uring* ring, bool registered)
+{
+    assert(!m_ring && ring);
+    m_ring = ring;
+    m_ring->m_descriptors.Push(this);
+    if (registered && m_fd >= 0)
+    {
+        m_ring->Register(this);
+    }
+}
+
 } // end namespace io
 } // end namespace coop
@@ -6,9 +6,13 @@
 namespace coop
 {
 
+struct Context;
+struct Coordinator;
+
 namespace io
 {
 
+struct Cork;
 struct Handle;
 struct Uring;
 
@@ -23,6 +27,14 @@ inline constexpr Registered registered;
 struct Borrowed {};
 inline constexpr Borrowed borrowed;
 
+// Tag type for adopting a direct descriptor: a slot of the uring's registered file table that the
+// kernel installed a file into (a direct multishot accept), with no process fd behind it. Every
+// operation goes through IOSQE_FIXED_FILE; closing it clears the slot. It cannot migrate, and
+// plain syscalls (fcntl, setsockopt) have no fd to act on.
+//
+struct Direct {};
+inline constexpr Direct direct;
+
 // A Descriptor (as in "file descriptor") is our wrapper for file/socket operations. We mirror its
 // usage with being a largely passive set of state that is passed into methods which actually do the
 // work (see operations.h)
@@ -32,16 +44,38 @@ struct Descriptor : EmbeddedListHookups<Descriptor>
     Descriptor(int fd, Uring* ring = GetUring());
     Descriptor(Registered, int fd, Uring* ring = GetUring());
     Descriptor(Borrowed, int fd, Uring* ring = GetUring());
+    Descriptor(Direct, int slot, Uring* ring = GetUring());
 
     ~Descriptor();
 
     int Close();
 
+    // Cancel every operation in flight on the descriptor, leaving it open: each completes with
+    // -ECANCELED, or with its own result if it finished first. Where the ring supports it this is
+    // one IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL for the whole file, which takes any
+    // ArmedHandle's multishot op on it too; otherwise one cancel per Handle.
+    //
+    void Cancel();
+
+    // Cancel, then wait in one block until every Handle in flight on the descriptor has completed.
+    // Their owners wake with the results, and their destructors have nothing left to cancel. Close
+    // does this first, so tearing down a busy connection costs one cancel, not one per operation.
+    //
+    void CancelAndDrain(Context* ctx = Self());
+
     // Release ownership of the fd without closing it. Returns the fd value. After this call the
     // descriptor is empty (m_fd == -1) and the destructor will not close.
     //
     int Release();
 
+    // Migration support (Context::MigrateTo). Unbind unhooks the descriptor from its ring, dropping
+    // its fixed-file slot, and must run on that ring's thread; it returns whether the descriptor was
+    // registered. Rebind hooks it into `ring` on that ring's thread, re-registering if asked (best
+    // effort, as for the registered constructor). No IO may be in flight across the pair.
+    //
+    bool Unbind();
+    void Rebind(Uring* ring, bool registered);
+
     // TODO lock down the guts
     //
     Uring* m_ring;
@@ -55,9 +89,18 @@ struct Descriptor : EmbeddedListHookups<Descriptor>
 
     int             m_result;
     bool            m_owned;
+    bool            m_direct;
 
     friend struct Handle;
     EmbeddedList<Handle> m_handles;
+
+    // Released by the Finalize that empties m_handles while CancelAndDrain waits; else nullptr
+    //
+    Coordinator* m_drained{nullptr};
+
+    // The io::Cork collecting this descriptor's untimed sends, or nullptr (see cork.h)
+    //
+    Cork* m_cork{nullptr};
 };
 
 } // end namespace coop::io
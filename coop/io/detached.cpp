@@ -0,0 +1,176 @@
+#include "detached.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <liburing.h>
+
+#include "coop/self.h"
+#include "coop/detail/timer_tag.h"
+
+#include "descriptor.h"
+#include "uring.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+// The heap copy an op that carries a path owns until its CQE. Its address is the userdata, so it
+// is aligned well past the opcode range an owning-nothing op puts there.
+//
+struct DetachedPath
+{
+    uint8_t opcode;
+    char    path[1];
+};
+
+// Mark sqe detached: tagged userdata, no CQE on success where the kernel can skip it
+//
+static void Detach(Uring* ring, io_uring_sqe* sqe, uintptr_t payload, bool skipSuccess = true)
+{
+    if (skipSuccess && ring->SupportsCqeSkip())
+    {
+        sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
+    }
+    io_uring_sqe_set_data64(sqe, coop::detail::kDetachedTag | payload);
+    ++ring->m_detachedStatistics.submitted;
+}
+
+// The descriptor's fd as its ops address it, as Handle::Prepare does
+//
+static void Target(Descriptor& desc, io_uring_sqe* sqe)
+{
+    if (desc.m_registeredIndex >= 0)
+    {
+        sqe->fd = desc.m_registeredIndex;
+        sqe->flags |= IOSQE_FIXED_FILE;
+    }
+}
+
+bool CloseDetached(Descriptor& desc)
+{
+    if (desc.m_direct)
+    {
+        if (desc.m_registeredIndex >= 0)
+        {
+            desc.CancelAndDrain();
+            desc.m_ring->Unregister(&desc);
+        }
+        return true;
+    }
+    if (!desc.m_owned || desc.m_fd < 0)
+    {
+        return true;
+    }
+
+    desc.CancelAndDrain();
+    auto* sqe = desc.m_ring->GetSqe();
+    if (!sqe)
+    {
+        return false;
+    }
+
+    // IORING_OP_CLOSE refuses a fixed file, so a registered fd leaves the table first
+    //
+    if (desc.m_registeredIndex >= 0)
+    {
+        desc.m_ring->Unregister(&desc);
+    }
+    io_uring_prep_close(sqe, desc.m_fd);
+    Detach(desc.m_ring, sqe, IORING_OP_CLOSE);
+    desc.m_fd = -1;
+    return true;
+}
+
+bool ShutdownDetached(Descriptor& desc, int how)
+{
+    auto* sqe = desc.m_ring->GetSqe();
+    if (!sqe)
+    {
+        return false;
+    }
+    io_uring_prep_shutdown(sqe, desc.m_fd, how);
+    Target(desc, sqe);
+    Detach(desc.m_ring, sqe, IORING_OP_SHUTDOWN);
+    return true;
+}
+
+bool SendDetached(Descriptor& desc, const void* buf, size_t size, int flags /* = 0 */)
+{
+    auto* sqe = desc.m_ring->GetSqe();
+    if (!sqe)
+    {
+        return false;
+    }
+    io_uring_prep_send(sqe, desc.m_fd, buf, size, flags);
+    Target(desc, sqe);
+    Detach(desc.m_ring, sqe, IORING_OP_SEND);
+    return true;
+}
+
+bool UnlinkDetached(char const* path, int flags /* = 0 */)
+{
+    auto* ring = GetUring();
+    auto* sqe = ring->GetSqe();
+    if (!sqe)
+    {
+        return false;
+    }
+
+    // The kernel reads the path when it takes the SQE, which under SQPOLL is whenever its thread
+    // gets to it; so the copy lives until the completion says it has
+    //
+    const size_t length = strlen(path);
+    auto* copy = static_cast<DetachedPath*>(malloc(sizeof(DetachedPath) + length));
+    copy->opcode = IORING_OP_UNLINKAT;
+    memcpy(copy->path, path, length + 1);
+
+    io_uring_prep_unlinkat(sqe, AT_FDCWD, copy->path, flags);
+    Detach(ring, sqe, reinterpret_cast<uintptr_t>(copy), false /* skipSuccess */);
+    return true;
+}
+
+DetachedStatistics const& GetDetachedStatistics()
+{
+    return GetUring()->m_detachedStatistics;
+}
+
+void SetDetachedErrorCallback(DetachedErrorCallback callback)
+{
+    GetUring()->m_detachedErrorCallback = callback;
+}
+
+namespace detail
+{
+
+void CompleteDetached(Uring* ring, uintptr_t data, int result)
+{
+    uintptr_t payload = data & ~coop::detail::kDetachedTag;
+    uint8_t opcode;
+    if (payload > 0xff)
+    {
+        auto* copy = reinterpret_cast<DetachedPath*>(payload);
+        opcode = copy->opcode;
+        free(copy);
+    }
+    else
+    {
+        opcode = static_cast<uint8_t>(payload);
+    }
+
+    if (result < 0)
+    {
+        ++ring->m_detachedStatistics.failed;
+        if (ring->m_detachedErrorCallback)
+        {
+            ring->m_detachedErrorCallback(opcode, result);
+        }
+    }
+}
+
+} // end namespace detail
+
+} // end namespace coop::io
+} // end namespace coop
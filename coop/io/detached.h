@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Descriptor;
+struct Uring;
+
+// Fire-and-forget operations, for the IO whose result nobody waits on: the close of a finished
+// connection, a shutdown before it, the unlink of a temp file, a best-effort canned reply. Each
+// queues one SQE on the descriptor's ring and returns -- no Handle, no Coordinator, no block, no
+// wake. IOSQE_CQE_SKIP_SUCCESS (5.17+, Uring::SupportsCqeSkip) keeps a success from posting a CQE
+// at all; a failure posts one, which is counted in the ring's DetachedStatistics and passed to
+// its DetachedErrorCallback if one is set. Without CQE skipping a success posts and is dropped.
+//
+// Each returns false, doing nothing, only when no SQE was to be had. The SQE rides the ring's next
+// submit, like any deferred submission.
+//
+struct DetachedStatistics
+{
+    size_t submitted{0};
+    size_t failed{0};
+};
+
+// Called on the ring's cooperator, from its CQE reap, with a failed detached op's opcode and
+// (negative) result. Must not suspend.
+//
+using DetachedErrorCallback = void (*)(uint8_t opcode, int result);
+
+// Close the descriptor without waiting for the close: as Descriptor::Close, but the close itself
+// is detached. Operations still in flight on it are drained first (Descriptor::CancelAndDrain), so
+// a busy descriptor still blocks for those. A registered descriptor leaves the table first;
+// closing a direct one only clears its slot. The descriptor is empty afterwards.
+//
+bool CloseDetached(Descriptor& desc);
+
+bool ShutdownDetached(Descriptor& desc, int how);
+
+// buf must stay valid until the send is done, which the caller never learns: for static data.
+// A short send is a success, and the rest is not sent.
+//
+bool SendDetached(Descriptor& desc, const void* buf, size_t size, int flags = 0);
+
+// The path is copied, so it need not outlive the call. That copy is freed by the op's completion,
+// so an unlink always posts its CQE.
+//
+bool UnlinkDetached(char const* path, int flags = 0);
+
+DetachedStatistics const& GetDetachedStatistics();
+void SetDetachedErrorCallback(DetachedErrorCallback callback);
+
+// The CQE reap's half (Handle::Callback): a detached op's CQE, by its userdata
+//
+namespace detail
+{
+void CompleteDetached(Uring* ring, uintptr_t data, int result);
+}
+
+} // end namespace coop::io
+} // end namespace coop
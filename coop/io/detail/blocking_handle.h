@@ -0,0 +1,45 @@
+#pragma once
+
+#include "coop/coordinator.h"
+#include "coop/io/handle.h"
+#include "coop/shared_stack.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Descriptor;
+struct Uring;
+
+namespace detail
+{
+
+// The Coordinator and Handle a blocking io:: call waits on. The completion writes into both while
+// the caller is parked, so on a shared stack they go in the context's bump heap (WaitStorage), not
+// in frames that may have been copied away by then; otherwise they stay in the caller's frame.
+//
+struct BlockingHandle
+{
+    BlockingHandle(Context* ctx, Descriptor& desc) : m_op(ctx, ctx, desc) {}
+    BlockingHandle(Context* ctx, Uring* ring) : m_op(ctx, ctx, ring) {}
+
+    Handle& Get() { return m_op->handle; }
+
+  private:
+    struct Op
+    {
+        template<typename Target>
+        Op(Context* ctx, Target&& target) : handle(ctx, target, &coord) {}
+
+        Coordinator coord;
+        Handle      handle;
+    };
+
+    coop::detail::WaitStorage<Op> m_op;
+};
+
+} // end namespace coop::io::detail
+} // end namespace coop::io
+} // end namespace coop
@@ -34,6 +34,16 @@ struct HandleExtension
     {
         return &h.m_timeout;
     }
+
+    static Coordinator* Coord(Handle& h)
+    {
+        return h.m_coord;
+    }
+
+    static void SetLinkFlags(Handle& h, uint8_t flags)
+    {
+        h.m_linkFlags = flags;
+    }
 };
 
 } // end namespace detail
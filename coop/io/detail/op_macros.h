@@ -1,5 +1,7 @@
 #pragma once
 
+#include "coop/io/coarse_timeout.h"
+#include "coop/io/detail/blocking_handle.h"
 #include "coop/io/detail/handle_extension.h"
 #include "coop/time/interval.h"
 
@@ -16,15 +18,19 @@
 #define COOP_IO_ARG_FWD(type, name, default) , name
 
 // Generate all 4 declarations for a standard IO operation. Timeout variants strip defaults from
-// preceding args so timeout is always explicitly provided.
+// preceding args so timeout is always explicitly provided. Each timeout variant also comes in a
+// CoarseTimeout flavor (coarse_timeout.h).
 //
 #define COOP_IO_DECLARATIONS(name, ARGS)                                                \
     bool name(Handle& handle ARGS(COOP_IO_ARG_DECL));                                  \
     bool name(Handle& handle ARGS(COOP_IO_ARG_DEF), time::Interval timeout);           \
+    bool name(Handle& handle ARGS(COOP_IO_ARG_DEF), CoarseTimeout timeout);            \
     int name(Descriptor& desc ARGS(COOP_IO_ARG_DECL));                                 \
     int name(Descriptor& desc ARGS(COOP_IO_ARG_DEF), time::Interval timeout);          \
+    int name(Descriptor& desc ARGS(COOP_IO_ARG_DEF), CoarseTimeout timeout);           \
     int name##Kill(Descriptor& desc ARGS(COOP_IO_ARG_DECL));                           \
-    int name##Kill(Descriptor& desc ARGS(COOP_IO_ARG_DEF), time::Interval timeout);
+    int name##Kill(Descriptor& desc ARGS(COOP_IO_ARG_DEF), time::Interval timeout);    \
+    int name##Kill(Descriptor& desc ARGS(COOP_IO_ARG_DEF), CoarseTimeout timeout);
 
 // Individual implementation macros, exposed for operations that only need a subset.
 //
@@ -54,23 +60,37 @@
         return true;                                                                     \
     }
 
+#define COOP_IO_ASYNC_COARSE_IMPL(name, prep_fn, ARGS)                                  \
+    bool name(Handle& handle ARGS(COOP_IO_ARG_DEF), CoarseTimeout timeout)              \
+    {                                                                                    \
+        auto* sqe = detail::HandleExtension::GetSqe(handle);                           \
+        if (!sqe)                                                                        \
+        {                                                                                \
+            return false;                                                                \
+        }                                                                                \
+        prep_fn(sqe, detail::HandleExtension::Fd(handle) ARGS(COOP_IO_ARG_FWD));        \
+        handle.SubmitWithCoarseTimeout(sqe, timeout.interval);                          \
+        return true;                                                                     \
+    }
+
 #define COOP_IO_BLOCKING_IMPL(name, ARGS)                                                \
     int name(Descriptor& desc ARGS(COOP_IO_ARG_DEF))                                    \
     {                                                                                    \
-        Coordinator coord;                                                               \
-        Handle handle(Self(), desc, &coord);                                             \
+        detail::BlockingHandle blocking(Self(), desc);                                   \
+        Handle& handle = blocking.Get();                                                 \
         if (!name(handle ARGS(COOP_IO_ARG_FWD)))                                        \
         {                                                                                \
             return -EAGAIN;                                                              \
         }                                                                                \
-        return handle.Wait();                                                                   \
+        int result = handle.Wait();                                                             \
+        return handle.TimedOut() ? -ETIMEDOUT : result;                                         \
     }
 
-#define COOP_IO_BLOCKING_TIMEOUT_IMPL(name, ARGS)                                       \
-    int name(Descriptor& desc ARGS(COOP_IO_ARG_DEF), time::Interval timeout)            \
+#define COOP_IO_BLOCKING_TIMEOUT_IMPL(name, ARGS, TimeoutType)                           \
+    int name(Descriptor& desc ARGS(COOP_IO_ARG_DEF), TimeoutType timeout)               \
     {                                                                                    \
-        Coordinator coord;                                                               \
-        Handle handle(Self(), desc, &coord);                                             \
+        detail::BlockingHandle blocking(Self(), desc);                                   \
+        Handle& handle = blocking.Get();                                                 \
         if (!name(handle ARGS(COOP_IO_ARG_FWD), timeout))                               \
         {                                                                                \
             return -EAGAIN;                                                              \
@@ -86,20 +106,21 @@
 #define COOP_IO_BLOCKING_KILL_IMPL(name, ARGS)                                           \
     int name##Kill(Descriptor& desc ARGS(COOP_IO_ARG_DEF))                              \
     {                                                                                    \
-        Coordinator coord;                                                               \
-        Handle handle(Self(), desc, &coord);                                             \
+        detail::BlockingHandle blocking(Self(), desc);                                   \
+        Handle& handle = blocking.Get();                                                 \
         if (!name(handle ARGS(COOP_IO_ARG_FWD)))                                         \
         {                                                                                \
             return -EAGAIN;                                                              \
         }                                                                                \
-        return handle.WaitKill();                                                        \
+        int result = handle.WaitKill();                                                  \
+        return handle.TimedOut() ? -ETIMEDOUT : result;                                  \
     }
 
-#define COOP_IO_BLOCKING_TIMEOUT_KILL_IMPL(name, ARGS)                                   \
-    int name##Kill(Descriptor& desc ARGS(COOP_IO_ARG_DEF), time::Interval timeout)      \
+#define COOP_IO_BLOCKING_TIMEOUT_KILL_IMPL(name, ARGS, TimeoutType)                      \
+    int name##Kill(Descriptor& desc ARGS(COOP_IO_ARG_DEF), TimeoutType timeout)         \
     {                                                                                    \
-        Coordinator coord;                                                               \
-        Handle handle(Self(), desc, &coord);                                             \
+        detail::BlockingHandle blocking(Self(), desc);                                   \
+        Handle& handle = blocking.Get();                                                 \
         if (!name(handle ARGS(COOP_IO_ARG_FWD), timeout))                                \
         {                                                                                \
             return -EAGAIN;                                                              \
@@ -126,24 +147,25 @@
         if (ret >= 0) return ret;                                                        \
         if (errno != EAGAIN && errno != EWOULDBLOCK) return -errno;                      \
                                                                                          \
-        Coordinator coord;                                                               \
-        Handle handle(Self(), desc, &coord);                                             \
+        detail::BlockingHandle blocking(Self(), desc);                                   \
+        Handle& handle = blocking.Get();                                                 \
         if (!name(handle ARGS(COOP_IO_ARG_FWD)))                                        \
         {                                                                                \
             return -EAGAIN;                                                              \
         }                                                                                \
-        return handle.Wait();                                                            \
+        int result = handle.Wait();                                                      \
+        return handle.TimedOut() ? -ETIMEDOUT : result;                                  \
     }
 
-#define COOP_IO_BLOCKING_TIMEOUT_FASTPATH_IMPL(name, try_fn, ARGS)                       \
-    int name(Descriptor& desc ARGS(COOP_IO_ARG_DEF), time::Interval timeout)            \
+#define COOP_IO_BLOCKING_TIMEOUT_FASTPATH_IMPL(name, try_fn, ARGS, TimeoutType)          \
+    int name(Descriptor& desc ARGS(COOP_IO_ARG_DEF), TimeoutType timeout)               \
     {                                                                                    \
         int ret = try_fn(desc.m_fd ARGS(COOP_IO_ARG_FWD));                              \
         if (ret >= 0) return ret;                                                        \
         if (errno != EAGAIN && errno != EWOULDBLOCK) return -errno;                      \
                                                                                          \
-        Coordinator coord;                                                               \
-        Handle handle(Self(), desc, &coord);                                             \
+        detail::BlockingHandle blocking(Self(), desc);                                   \
+        Handle& handle = blocking.Get();                                                 \
         if (!name(handle ARGS(COOP_IO_ARG_FWD), timeout))                               \
         {                                                                                \
             return -EAGAIN;                                                              \
@@ -163,24 +185,25 @@
         if (ret >= 0) return ret;                                                        \
         if (errno != EAGAIN && errno != EWOULDBLOCK) return -errno;                      \
                                                                                          \
-        Coordinator coord;                                                               \
-        Handle handle(Self(), desc, &coord);                                             \
+        detail::BlockingHandle blocking(Self(), desc);                                   \
+        Handle& handle = blocking.Get();                                                 \
         if (!name(handle ARGS(COOP_IO_ARG_FWD)))                                         \
         {                                                                                \
             return -EAGAIN;                                                              \
         }                                                                                \
-        return handle.WaitKill();                                                        \
+        int result = handle.WaitKill();                                                  \
+        return handle.TimedOut() ? -ETIMEDOUT : result;                                  \
     }
 
-#define COOP_IO_BLOCKING_TIMEOUT_FASTPATH_KILL_IMPL(name, try_fn, ARGS)                  \
-    int name##Kill(Descriptor& desc ARGS(COOP_IO_ARG_DEF), time::Interval timeout)      \
+#define COOP_IO_BLOCKING_TIMEOUT_FASTPATH_KILL_IMPL(name, try_fn, ARGS, TimeoutType)     \
+    int name##Kill(Descriptor& desc ARGS(COOP_IO_ARG_DEF), TimeoutType timeout)         \
     {                                                                                    \
         int ret = try_fn(desc.m_fd ARGS(COOP_IO_ARG_FWD));                              \
         if (ret >= 0) return ret;                                                        \
         if (errno != EAGAIN && errno != EWOULDBLOCK) return -errno;                      \
                                                                                          \
-        Coordinator coord;                                                               \
-        Handle handle(Self(), desc, &coord);                                             \
+        detail::BlockingHandle blocking(Self(), desc);                                   \
+        Handle& handle = blocking.Get();                                                 \
         if (!name(handle ARGS(COOP_IO_ARG_FWD), timeout))                                \
         {                                                                                \
             return -EAGAIN;                                                              \
@@ -198,20 +221,26 @@
 #define COOP_IO_IMPLEMENTATIONS(name, prep_fn, ARGS)                                     \
     COOP_IO_ASYNC_IMPL(name, prep_fn, ARGS)                                              \
     COOP_IO_ASYNC_TIMEOUT_IMPL(name, prep_fn, ARGS)                                      \
+    COOP_IO_ASYNC_COARSE_IMPL(name, prep_fn, ARGS)                                       \
     COOP_IO_BLOCKING_IMPL(name, ARGS)                                                    \
-    COOP_IO_BLOCKING_TIMEOUT_IMPL(name, ARGS)                                            \
+    COOP_IO_BLOCKING_TIMEOUT_IMPL(name, ARGS, time::Interval)                            \
+    COOP_IO_BLOCKING_TIMEOUT_IMPL(name, ARGS, CoarseTimeout)                             \
     COOP_IO_BLOCKING_KILL_IMPL(name, ARGS)                                               \
-    COOP_IO_BLOCKING_TIMEOUT_KILL_IMPL(name, ARGS)
+    COOP_IO_BLOCKING_TIMEOUT_KILL_IMPL(name, ARGS, time::Interval)                       \
+    COOP_IO_BLOCKING_TIMEOUT_KILL_IMPL(name, ARGS, CoarseTimeout)
 
 // Generate all 4 implementations with nonblocking fast path on blocking variants.
 //
 #define COOP_IO_IMPLEMENTATIONS_FASTPATH(name, prep_fn, try_fn, ARGS)                    \
     COOP_IO_ASYNC_IMPL(name, prep_fn, ARGS)                                              \
     COOP_IO_ASYNC_TIMEOUT_IMPL(name, prep_fn, ARGS)                                      \
+    COOP_IO_ASYNC_COARSE_IMPL(name, prep_fn, ARGS)                                       \
     COOP_IO_BLOCKING_FASTPATH_IMPL(name, try_fn, ARGS)                                   \
-    COOP_IO_BLOCKING_TIMEOUT_FASTPATH_IMPL(name, try_fn, ARGS)                           \
+    COOP_IO_BLOCKING_TIMEOUT_FASTPATH_IMPL(name, try_fn, ARGS, time::Interval)           \
+    COOP_IO_BLOCKING_TIMEOUT_FASTPATH_IMPL(name, try_fn, ARGS, CoarseTimeout)            \
     COOP_IO_BLOCKING_FASTPATH_KILL_IMPL(name, try_fn, ARGS)                              \
-    COOP_IO_BLOCKING_TIMEOUT_FASTPATH_KILL_IMPL(name, try_fn, ARGS)
+    COOP_IO_BLOCKING_TIMEOUT_FASTPATH_KILL_IMPL(name, try_fn, ARGS, time::Interval)      \
+    COOP_IO_BLOCKING_TIMEOUT_FASTPATH_KILL_IMPL(name, try_fn, ARGS, CoarseTimeout)
 
 // -------------------------------------------------------------------------------------
 // Uring-level operations (AT_FDCWD pattern)
@@ -267,21 +296,22 @@
     int name(COOP_IO_NO_LEAD(ARGS(COOP_IO_ARG_DEF)))                                     \
     {                                                                                     \
         auto* ring = GetUring();                                                          \
-        Coordinator coord;                                                                \
-        Handle handle(Self(), ring, &coord);                                              \
+        detail::BlockingHandle blocking(Self(), ring);                                    \
+        Handle& handle = blocking.Get();                                                  \
         if (!name(handle ARGS(COOP_IO_ARG_FWD)))                                         \
         {                                                                                 \
             return -EAGAIN;                                                               \
         }                                                                                 \
-        return handle.Wait();                                                                    \
+        int result = handle.Wait();                                                              \
+        return handle.TimedOut() ? -ETIMEDOUT : result;                                          \
     }
 
 #define COOP_IO_URING_BLOCKING_TIMEOUT_IMPL(name, ARGS)                                   \
     int name(COOP_IO_NO_LEAD(ARGS(COOP_IO_ARG_DEF)), time::Interval timeout)             \
     {                                                                                     \
         auto* ring = GetUring();                                                          \
-        Coordinator coord;                                                                \
-        Handle handle(Self(), ring, &coord);                                              \
+        detail::BlockingHandle blocking(Self(), ring);                                    \
+        Handle& handle = blocking.Get();                                                  \
         if (!name(handle ARGS(COOP_IO_ARG_FWD), timeout))                                \
         {                                                                                 \
             return -EAGAIN;                                                               \
@@ -298,21 +328,22 @@
     int name##Kill(COOP_IO_NO_LEAD(ARGS(COOP_IO_ARG_DEF)))                               \
     {                                                                                     \
         auto* ring = GetUring();                                                          \
-        Coordinator coord;                                                                \
-        Handle handle(Self(), ring, &coord);                                              \
+        detail::BlockingHandle blocking(Self(), ring);                                    \
+        Handle& handle = blocking.Get();                                                  \
         if (!name(handle ARGS(COOP_IO_ARG_FWD)))                                          \
         {                                                                                 \
             return -EAGAIN;                                                               \
         }                                                                                 \
-        return handle.WaitKill();                                                         \
+        int result = handle.WaitKill();                                                   \
+        return handle.TimedOut() ? -ETIMEDOUT : result;                                   \
     }
 
 #define COOP_IO_URING_BLOCKING_TIMEOUT_KILL_IMPL(name, ARGS)                              \
     int name##Kill(COOP_IO_NO_LEAD(ARGS(COOP_IO_ARG_DEF)), time::Interval timeout)       \
     {                                                                                     \
         auto* ring = GetUring();                                                          \
-        Coordinator coord;                                                                \
-        Handle handle(Self(), ring, &coord);                                              \
+        detail::BlockingHandle blocking(Self(), ring);                                    \
+        Handle& handle = blocking.Get();                                                  \
         if (!name(handle ARGS(COOP_IO_ARG_FWD), timeout))                                 \
         {                                                                                 \
             return -EAGAIN;                                                               \
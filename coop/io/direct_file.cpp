@@ -0,0 +1,162 @@
+#include "direct_file.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <fcntl.h>
+#include <new>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/coordinator.h"
+#include "coop/self.h"
+
+#include "fixed.h"
+#include "handle.h"
+#include "open.h"
+#include "read.h"
+#include "write.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+DirectFile::DirectFile(const char* path, int flags, mode_t mode /* = 0 */,
+    Uring* ring /* = GetStorageUring() */)
+: m_ring(ring)
+{
+    assert(m_ring);
+
+    // Opened on the cooperator's ring: an IOPOLL storage ring refuses anything but reads and writes
+    //
+    int fd = Open(path, flags | O_DIRECT | O_CLOEXEC, mode);
+    if (fd < 0)
+    {
+        spdlog::warn("direct file open failed path={} err={}", path, fd);
+        m_error = fd;
+        return;
+    }
+
+    m_desc.emplace(registered, fd, m_ring);
+    SPDLOG_DEBUG("direct file open path={} fd={}", path, fd);
+}
+
+DirectFile::~DirectFile()
+{
+    int result = Close();
+    if (result < 0) [[unlikely]]
+    {
+        spdlog::warn("direct file close in destructor failed result={}", result);
+    }
+}
+
+int DirectFile::Close()
+{
+    if (!m_desc)
+    {
+        return 0;
+    }
+
+    if (m_ring == GetUring())
+    {
+        int result = m_desc->Close();
+        m_desc.reset();
+        return result;
+    }
+
+    // Same story as the open: hand the fd to the cooperator's ring to close
+    //
+    int fd = m_desc->Release();
+    m_desc.reset();
+    Descriptor closer(fd, GetUring());
+    return closer.Close();
+}
+
+int DirectFile::ReadAt(void* buf, uint32_t len, uint64_t offset, int bufIndex /* = -1 */)
+{
+    BlockIo op{buf, len, offset, bufIndex};
+    Batch(&op, 1, false);
+    return op.result;
+}
+
+int DirectFile::WriteAt(void const* buf, uint32_t len, uint64_t offset, int bufIndex /* = -1 */)
+{
+    BlockIo op{const_cast<void*>(buf), len, offset, bufIndex};
+    Batch(&op, 1, true);
+    return op.result;
+}
+
+int DirectFile::Batch(BlockIo* ops, size_t count, bool write)
+{
+    if (!m_desc)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            ops[i].result = -EBADF;
+        }
+        return 0;
+    }
+
+    auto* ctx = Self();
+    int complete = 0;
+
+    Coordinator coords[MAX_BATCH];
+    alignas(Handle) unsigned char storage[MAX_BATCH][sizeof(Handle)];
+
+    for (size_t base = 0; base < count; base += MAX_BATCH)
+    {
+        size_t n = std::min(MAX_BATCH, count - base);
+
+        // Queue the whole batch before waiting on any of it. Nothing is submitted until the first
+        // Wait's Poll, which then hands every SQE to the kernel in one enter (GetSqe flushes early
+        // only if the SQ is smaller than the batch).
+        //
+        for (size_t i = 0; i < n; i++)
+        {
+            auto& op = ops[base + i];
+            assert(reinterpret_cast<uintptr_t>(op.buf) % ALIGNMENT == 0 && "unaligned buffer");
+            assert(op.len % ALIGNMENT == 0 && "unaligned length");
+            assert(op.offset % ALIGNMENT == 0 && "unaligned offset");
+
+            auto* handle = new (storage[i]) Handle(ctx, *m_desc, &coords[i]);
+            bool submitted;
+            if (op.bufIndex >= 0)
+            {
+                submitted = write
+                    ? WriteFixed(*handle, op.buf, op.len, op.bufIndex, op.offset)
+                    : ReadFixed(*handle, op.buf, op.len, op.bufIndex, op.offset);
+            }
+            else
+            {
+                submitted = write
+                    ? Write(*handle, op.buf, op.len, op.offset)
+                    : Read(*handle, op.buf, op.len, op.offset);
+            }
+            op.result = submitted ? 0 : -EAGAIN;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            auto& op = ops[base + i];
+            auto* handle = reinterpret_cast<Handle*>(storage[i]);
+            if (op.result == 0)
+            {
+                op.result = handle->Wait();
+            }
+            handle->~Handle();
+
+            if (op.result == static_cast<int>(op.len))
+            {
+                complete++;
+            }
+        }
+    }
+
+    SPDLOG_TRACE("direct file {} ops={} complete={}", write ? "write" : "read", count, complete);
+    return complete;
+}
+
+} // end namespace coop::io
+} // end namespace coop
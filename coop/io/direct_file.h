@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <sys/types.h>
+
+#include "descriptor.h"
+#include "uring.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+// A file opened with O_DIRECT: reads and writes move between the device and the caller's memory
+// with no page cache in between, which is what a storage engine that runs its own buffer pool
+// wants (no double caching, no writeback surprises). The kernel then requires every buffer,
+// offset and length to be aligned to the device's logical block size; ALIGNMENT is the
+// conservative value that satisfies every common device, and the asserts check it.
+//
+// Aligned blocks come from the ring's registered buffer pool (UringConfiguration::fixedBuffers,
+// mmap'd and so page aligned), and IO on them goes out as ReadFixed/WriteFixed, skipping the
+// per-op page pinning. ReadAt/WriteAt take a batch of operations at independent offsets and put
+// every one of them in the SQ before blocking once, so the whole batch reaches the device in a
+// single io_uring_enter.
+//
+// The file may live on a dedicated storage Uring (ring != the cooperator's) -- typically one set
+// up with UringConfiguration::iopoll, where completions are found by polling the device instead
+// of by interrupt. Such a ring only accepts O_DIRECT reads and writes, so opening and closing go
+// through the cooperator's own ring. The default ring is the cooperator's storage ring when it has
+// one (CooperatorConfiguration::storage), which its loop drives:
+//
+//     cfg.storage = {.entries = 256, .iopoll = true, .fixedBuffers = 64,
+//         .fixedBufferSize = 64 * 1024};
+//     io::DirectFile file("data.db", O_RDWR | O_CREAT, 0644);
+//
+// A standalone ring works too, with something to drive it:
+//
+//     co->Spawn([&](Context* ctx) { storage.Run(ctx); }, &driver);
+//     io::DirectFile file("data.db", O_RDWR | O_CREAT, 0644, &storage);
+//
+// Owning thread only, like the Uring it runs on.
+//
+struct DirectFile
+{
+    static constexpr size_t ALIGNMENT = 4096;
+    static constexpr size_t MAX_BATCH = 32;
+
+    DirectFile(const char* path, int flags, mode_t mode = 0, Uring* ring = GetStorageUring());
+    ~DirectFile();
+
+    DirectFile(DirectFile const&) = delete;
+    DirectFile& operator=(DirectFile const&) = delete;
+
+    bool IsOpen() const { return m_desc.has_value(); }
+
+    // The open's negative errno when !IsOpen(), else 0. -EINVAL usually means the filesystem does
+    // not support O_DIRECT (tmpfs).
+    //
+    int Error() const { return m_error; }
+
+    int Close();
+
+    // One registered block of BlockSize() bytes from the ring's pool, or {nullptr, -1} when the
+    // pool is empty (or the ring has none). Blocks go back with ReleaseBlock.
+    //
+    Uring::FixedBuffer AcquireBlock() { return m_ring->AcquireFixedBuffer(); }
+    void ReleaseBlock(Uring::FixedBuffer block) { m_ring->ReleaseFixedBuffer(block.index); }
+    size_t BlockSize() const { return m_ring->FixedBufferSize(); }
+
+    // One operation of a batch. buf, len and offset must be ALIGNMENT aligned. bufIndex names the
+    // registered buffer holding buf (an AcquireBlock index, or Uring::FixedBufferIndex) or is -1
+    // for plain memory, which then only needs aligning -- posix_memalign, say. result is the op's
+    // own outcome: bytes moved or a negative errno.
+    //
+    struct BlockIo
+    {
+        void*       buf;
+        uint32_t    len;
+        uint64_t    offset;
+        int         bufIndex = -1;
+        int         result = 0;
+    };
+
+    // Issue count operations (any number; batches of MAX_BATCH go out one submission each) and
+    // block until all of them completed. Not kill-aware, like the blocking IO calls: a caller's
+    // buffers stay in use until the device is done with them. Returns how many ops moved their
+    // full len; each op's result says what happened to it.
+    //
+    int ReadAt(BlockIo* ops, size_t count) { return Batch(ops, count, false); }
+    int WriteAt(BlockIo* ops, size_t count) { return Batch(ops, count, true); }
+
+    // Single-op conveniences
+    //
+    int ReadAt(void* buf, uint32_t len, uint64_t offset, int bufIndex = -1);
+    int WriteAt(void const* buf, uint32_t len, uint64_t offset, int bufIndex = -1);
+
+    Uring* GetRing() const { return m_ring; }
+
+private:
+    int Batch(BlockIo* ops, size_t count, bool write);
+
+    Uring*                      m_ring;
+    int                         m_error{0};
+    std::optional<Descriptor>   m_desc;
+};
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,22 @@
+#define COOP_IO_KEEP_ARGS
+#include "fallocate.h"
+
+#include <cerrno>
+
+#include "coop/coordinator.h"
+#include "coop/self.h"
+
+#include "descriptor.h"
+#include "handle.h"
+#include "uring.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+COOP_IO_IMPLEMENTATIONS(Fallocate, io_uring_prep_fallocate, FALLOCATE_ARGS)
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+#include "coop/io/detail/op_macros.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Descriptor;
+struct Handle;
+
+// fallocate(2) through io_uring: reserve (mode 0) or otherwise manipulate [offset, offset + len)
+// of a file. Preallocating a log segment up front lets later appends fdatasync without a size
+// change to commit.
+//
+#define FALLOCATE_ARGS(F) F(int, mode, ) F(uint64_t, offset, ) F(uint64_t, len, )
+
+COOP_IO_DECLARATIONS(Fallocate, FALLOCATE_ARGS)
+
+} // end namespace coop::io
+} // end namespace coop
+
+#ifndef COOP_IO_KEEP_ARGS
+#undef FALLOCATE_ARGS
+#endif
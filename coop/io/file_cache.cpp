@@ -0,0 +1,291 @@
+#include "file_cache.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/coordinate_with.h"
+#include "coop/cooperator.h"
+
+#include "open.h"
+#include "read.h"
+#include "statx.h"
+#include "uring.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+namespace
+{
+
+// Anything that can make the cached fd, size or mtime wrong. Unlink and rename-over show up as
+// IN_ATTRIB (the link count changed): the inode itself lives on while we hold it open, so
+// IN_DELETE_SELF would only come once we let go.
+//
+constexpr uint32_t kWatchMask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF
+    | IN_DELETE_SELF;
+
+} // end anonymous namespace
+
+FileCache::Entry::Entry(int fd, bool registered, Uring* ring)
+: desc(registered ? Descriptor(io::registered, fd, ring) : Descriptor(fd, ring))
+{
+}
+
+FileCache::Lease::Lease(Entry* entry)
+: m_entry(entry)
+{
+    m_entry->m_refs++;
+}
+
+FileCache::Lease& FileCache::Lease::operator=(Lease&& other)
+{
+    if (this != &other)
+    {
+        Reset();
+        m_entry = other.m_entry;
+        other.m_entry = nullptr;
+    }
+    return *this;
+}
+
+void FileCache::Lease::Reset()
+{
+    if (!m_entry)
+    {
+        return;
+    }
+    if (--m_entry->m_refs == 0 && !m_entry->m_cached)
+    {
+        delete m_entry;
+    }
+    m_entry = nullptr;
+}
+
+FileCache::FileCache(FileCacheOptions const& options /* = {} */, Context* ctx /* = Self() */)
+: m_options(options)
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        // Without change notification a cached file could go stale forever, so cache nothing
+        //
+        spdlog::warn("file cache inotify_init1 failed errno={}, caching disabled", errno);
+        m_options.capacity = 0;
+        return;
+    }
+    m_inotify.emplace(fd);
+
+    // The watcher holds m_watcherExit for its whole run; it starts inside Spawn, so it has taken it
+    // before the destructor can wait on it
+    //
+    bool spawned = ctx->GetCooperator()->Spawn([this](Context* watchCtx)
+    {
+        watchCtx->SetName("FileCacheWatch");
+        m_watcherExit.Acquire(watchCtx);
+        Watch(watchCtx);
+        m_watcherExit.Release(watchCtx, false);
+    }, &m_watcher);
+    if (!spawned)
+    {
+        spdlog::warn("file cache watcher spawn failed, caching disabled");
+        m_options.capacity = 0;
+    }
+}
+
+FileCache::~FileCache()
+{
+    auto* ctx = Self();
+    if (m_watcher)
+    {
+        m_watcher.Kill();
+    }
+    m_watcherExit.Acquire(ctx);
+    m_watcherExit.Release(ctx, false);
+
+    Clear();
+}
+
+void FileCache::Watch(Context* ctx)
+{
+    alignas(struct inotify_event) char buf[4096];
+    while (!ctx->IsKilled())
+    {
+        int n = ReadKill(*m_inotify, buf, sizeof(buf));
+        if (n <= 0)
+        {
+            if (n < 0 && n != -ECANCELED)
+            {
+                spdlog::warn("file cache inotify read failed err={}, caching disabled", n);
+                m_options.capacity = 0;
+                Clear();
+            }
+            return;
+        }
+
+        for (int off = 0; off < n;)
+        {
+            auto* event = reinterpret_cast<struct inotify_event*>(buf + off);
+            m_events++;
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                spdlog::warn("file cache inotify queue overflow, dropping {} entries", Size());
+                Clear();
+            }
+            else
+            {
+                OnEvent(event->wd);
+            }
+            off += static_cast<int>(sizeof(struct inotify_event) + event->len);
+        }
+    }
+}
+
+void FileCache::OnEvent(int wd)
+{
+    // Hard links and repeated paths share one watch, so every entry on it goes
+    //
+    for (auto it = m_lru.begin(); it != m_lru.end();)
+    {
+        Entry* entry = *it;
+        ++it;
+        if (entry->m_watch == wd)
+        {
+            SPDLOG_DEBUG("file cache invalidate path={}", entry->m_path);
+            m_stats.invalidations++;
+            Drop(entry);
+        }
+    }
+}
+
+void FileCache::Drop(Entry* entry)
+{
+    m_entries.erase(entry->m_path);
+    m_lru.Remove(entry);
+    entry->m_cached = false;
+    Unwatch(entry->m_watch);
+
+    if (entry->m_refs == 0)
+    {
+        delete entry;
+    }
+}
+
+// Remove a watch no cached entry shares any more
+//
+void FileCache::Unwatch(int wd)
+{
+    for (auto* entry : m_lru)
+    {
+        if (entry->m_watch == wd)
+        {
+            return;
+        }
+    }
+    inotify_rm_watch(m_inotify->m_fd, wd);
+}
+
+void FileCache::Invalidate(const char* path)
+{
+    auto it = m_entries.find(path);
+    if (it != m_entries.end())
+    {
+        Drop(it->second);
+    }
+}
+
+void FileCache::Clear()
+{
+    while (!m_lru.IsEmpty())
+    {
+        Drop(m_lru.Peek());
+    }
+}
+
+FileCache::Lease FileCache::Open(const char* path, int* error /* = nullptr */)
+{
+    int ignored;
+    error = error ? error : &ignored;
+    *error = 0;
+
+    auto it = m_entries.find(path);
+    if (it != m_entries.end())
+    {
+        Entry* entry = it->second;
+        m_lru.Remove(entry);
+        m_lru.Push(entry);
+        m_stats.hits++;
+        return Lease(entry);
+    }
+    m_stats.misses++;
+
+    // Watch before opening: a change from here on is seen as an event, and one that lands while
+    // this miss is blocked keeps the result out of the cache
+    //
+    uint64_t events = m_events;
+    int wd = m_options.capacity > 0 ? inotify_add_watch(m_inotify->m_fd, path, kWatchMask) : -1;
+
+    int fd = io::Open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        *error = fd;
+        if (wd >= 0)
+        {
+            Unwatch(wd);
+        }
+        return Lease();
+    }
+
+    struct statx stx;
+    int result = Statx(path, 0, STATX_TYPE | STATX_SIZE | STATX_MTIME, &stx);
+    if (result < 0 || !S_ISREG(stx.stx_mode))
+    {
+        *error = result < 0 ? result : S_ISDIR(stx.stx_mode) ? -EISDIR : -EINVAL;
+        ::close(fd);
+        if (wd >= 0)
+        {
+            Unwatch(wd);
+        }
+        return Lease();
+    }
+
+    auto* entry = new Entry(fd, m_options.registered, GetUring());
+    entry->size = stx.stx_size;
+    entry->mtimeNs = stx.stx_mtime.tv_sec * 1'000'000'000LL + stx.stx_mtime.tv_nsec;
+    entry->contentType = m_options.classify ? m_options.classify(path) : nullptr;
+    Lease lease(entry);
+
+    // Not cacheable: caching is off, the watch failed, or the file (or another one) changed while
+    // we were blocked. The lease alone owns the entry then.
+    //
+    if (wd < 0 || events != m_events || m_entries.count(path))
+    {
+        if (wd >= 0)
+        {
+            Unwatch(wd);
+        }
+        return lease;
+    }
+
+    while (m_entries.size() >= m_options.capacity)
+    {
+        Drop(m_lru.Peek());
+    }
+
+    entry->m_path = path;
+    entry->m_watch = wd;
+    entry->m_cached = true;
+    m_entries.emplace(entry->m_path, entry);
+    m_lru.Push(entry);
+    return lease;
+}
+
+} // end namespace coop::io
+} // end namespace coop
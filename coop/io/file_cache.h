@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "coop/coordinator.h"
+#include "coop/context.h"
+#include "coop/detail/embedded_list.h"
+#include "coop/self.h"
+
+#include "descriptor.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+struct FileCacheOptions
+{
+    // Most files held open at once; the least recently used is closed to make room
+    //
+    size_t capacity = 256;
+
+    // Also register each file in the ring's fixed file table (best effort, as for
+    // Descriptor(registered, ...)), so ops on Entry::desc skip the per-op fd lookup
+    //
+    bool registered = false;
+
+    // Computed once per cached file and kept as Entry::contentType (e.g. a MIME type from the
+    // extension). The returned string must be static.
+    //
+    const char* (*classify)(const char* path) = nullptr;
+};
+
+struct FileCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidations = 0;
+};
+
+// Path -> open file cache, for serving the same static files over and over: a hit hands back an
+// already-open Descriptor with its size, mtime and content type, costing no syscalls at all where
+// every uncached request pays an open, a stat and a close.
+//
+// Staleness is handled by inotify rather than by re-stat'ing: each cached file is watched, and a
+// watcher context spawned by the cache keeps a read on the inotify fd in flight. A write to the
+// file, a change to its attributes or link count (it was unlinked, or renamed over), or a move
+// drops the entry, so the next Open() sees the new file. An inotify queue overflow drops
+// everything.
+//
+// Open() returns a Lease that pins the entry: an entry evicted or invalidated while leased stays
+// open, out of the cache, until its last lease goes, so a response in the middle of a sendfile
+// never has its fd closed under it. Leases may outlive the cache.
+//
+// One cache per cooperator, created and destroyed on a context of it; entries are not shared
+// across threads. Only regular files are cached.
+//
+struct FileCache
+{
+    struct Entry : EmbeddedListHookups<Entry>
+    {
+        Entry(int fd, bool registered, Uring* ring);
+
+        Descriptor      desc;
+        uint64_t        size = 0;
+        int64_t         mtimeNs = 0;
+        const char*     contentType = nullptr;
+
+    private:
+        friend struct FileCache;
+
+        std::string     m_path;
+        int             m_watch = -1;
+        int             m_refs = 0;
+        bool            m_cached = false;
+    };
+
+    struct Lease
+    {
+        Lease() = default;
+        explicit Lease(Entry* entry);
+        Lease(Lease&& other) : m_entry(other.m_entry) { other.m_entry = nullptr; }
+        Lease& operator=(Lease&& other);
+        ~Lease() { Reset(); }
+
+        Lease(Lease const&) = delete;
+        Lease& operator=(Lease const&) = delete;
+
+        explicit operator bool() const { return m_entry != nullptr; }
+        Entry const* operator->() const { return m_entry; }
+        Entry const& operator*() const { return *m_entry; }
+
+        void Reset();
+
+    private:
+        Entry* m_entry = nullptr;
+    };
+
+    FileCache(FileCacheOptions const& options = {}, Context* ctx = Self());
+    ~FileCache();
+
+    FileCache(FileCache const&) = delete;
+    FileCache& operator=(FileCache const&) = delete;
+
+    // The open file at path, from the cache or opened (and cached) now. An empty lease on failure,
+    // with *error set to the negative errno: -ENOENT and friends from the open, -EISDIR or -EINVAL
+    // for something that is not a regular file.
+    //
+    Lease Open(const char* path, int* error = nullptr);
+
+    // Drop the entry for path, or every entry
+    //
+    void Invalidate(const char* path);
+    void Clear();
+
+    size_t Size() const { return m_entries.size(); }
+    FileCacheStats const& Stats() const { return m_stats; }
+
+private:
+    void Watch(Context* ctx);
+    void OnEvent(int wd);
+    void Drop(Entry* entry);
+    void Unwatch(int wd);
+
+    FileCacheOptions                                    m_options;
+    FileCacheStats                                      m_stats;
+
+    // Bumped per inotify event, so a miss that blocked can tell whether its file changed meanwhile
+    //
+    uint64_t                                            m_events{0};
+
+    std::unordered_map<std::string_view, Entry*>        m_entries;
+    EmbeddedList<Entry>                                 m_lru;
+
+    std::optional<Descriptor>                           m_inotify;
+    Coordinator                                         m_watcherExit;
+    Context::Handle                                     m_watcher;
+};
+
+} // end namespace coop::io
+} // end namespace coop
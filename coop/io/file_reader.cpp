@@ -0,0 +1,168 @@
+#include "file_reader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <fcntl.h>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/context.h"
+
+#include "open.h"
+#include "read.h"
+#include "uring.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+FileReader::FileReader(const char* path, FileReaderOptions const& options /* = {} */,
+    Context* ctx /* = Self() */, Uring* ring /* = GetUring() */)
+: m_context(ctx)
+, m_chunkSize(options.chunkSize)
+, m_depth(std::clamp(options.depth, 1, MAX_DEPTH))
+, m_nextOffset(options.offset)
+{
+    assert(m_context && ring && m_chunkSize > 0);
+
+    int fd = Open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        spdlog::warn("file reader open failed path={} err={}", path, fd);
+        m_error = fd;
+        return;
+    }
+    m_desc.emplace(fd, ring);
+
+    m_buffers = std::make_unique<char[]>(m_chunkSize * static_cast<size_t>(m_depth));
+    for (int i = 0; i < m_depth; i++)
+    {
+        m_slots[i].handle.emplace(m_context, *m_desc, &m_slots[i].coord);
+        Issue(i);
+    }
+}
+
+FileReader::~FileReader()
+{
+    // The handles cancel and drain whatever is still in flight, before the descriptor closes
+    //
+    for (auto& slot : m_slots)
+    {
+        slot.handle.reset();
+    }
+}
+
+void FileReader::Issue(int slot)
+{
+    auto& s = m_slots[slot];
+    assert(!s.inFlight);
+
+    s.offset = m_nextOffset;
+    if (!Read(*s.handle, Buffer(slot), m_chunkSize, s.offset))
+    {
+        return;
+    }
+    s.inFlight = true;
+    m_nextOffset += m_chunkSize;
+}
+
+// A short read left a gap before the reads queued behind it. Let those finish, discard them, and
+// restart the pipeline at the short read's end. At EOF they all read nothing, so this is cheap. A
+// kill stops it midway; the next Next() reports it.
+//
+void FileReader::Resync(uint64_t offset)
+{
+    for (int i = 0; i < m_depth; i++)
+    {
+        auto& s = m_slots[(m_head + i) % m_depth];
+        if (!s.inFlight)
+        {
+            continue;
+        }
+        if (s.handle->WaitKill() == -ECANCELED && m_context->IsKilled())
+        {
+            m_error = -ECANCELED;
+            return;
+        }
+        s.inFlight = false;
+    }
+
+    m_nextOffset = offset;
+    for (int i = 0; i < m_depth; i++)
+    {
+        int slot = (m_head + i) % m_depth;
+        if (slot != m_held)
+        {
+            Issue(slot);
+        }
+    }
+}
+
+int FileReader::Next(Chunk* out)
+{
+    if (m_error < 0)
+    {
+        return m_error;
+    }
+    if (m_eof)
+    {
+        return 0;
+    }
+
+    if (m_held >= 0)
+    {
+        Issue(m_held);
+        m_held = -1;
+    }
+
+    int slot = m_head;
+    auto& s = m_slots[slot];
+    if (!s.inFlight)
+    {
+        // The SQ had no room when this slot was recycled
+        //
+        Issue(slot);
+        if (!s.inFlight)
+        {
+            return -EAGAIN;
+        }
+    }
+
+    int result = s.handle->WaitKill();
+    if (result == -ECANCELED && m_context->IsKilled())
+    {
+        // Still in flight: the handle drains it on destruction
+        //
+        m_error = -ECANCELED;
+        return m_error;
+    }
+    s.inFlight = false;
+
+    if (result < 0)
+    {
+        spdlog::warn("file reader read failed offset={} err={}", s.offset, result);
+        m_error = result;
+        return result;
+    }
+    if (result == 0)
+    {
+        m_eof = true;
+        return 0;
+    }
+
+    *out = Chunk{Buffer(slot), static_cast<size_t>(result), s.offset};
+    m_head = (m_head + 1) % m_depth;
+    m_held = slot;
+
+    if (static_cast<size_t>(result) < m_chunkSize)
+    {
+        Resync(s.offset + static_cast<uint64_t>(result));
+    }
+    return result;
+}
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "coop/coordinator.h"
+#include "coop/self.h"
+
+#include "descriptor.h"
+#include "handle.h"
+
+namespace coop
+{
+
+struct Context;
+
+namespace io
+{
+
+struct Uring;
+
+struct FileReaderOptions
+{
+    // Bytes per read, and so the largest chunk Next() hands out
+    //
+    size_t chunkSize = 128 * 1024;
+
+    // Reads kept in flight ahead of the consumer, counting the one it is waiting on: 2 is double
+    // buffering, 3 triple. Clamped to [1, FileReader::MAX_DEPTH].
+    //
+    int depth = 3;
+
+    // Where in the file to start
+    //
+    uint64_t offset = 0;
+};
+
+// Stream a file of any size through a fixed set of buffers. The reader keeps `depth` reads in
+// flight at consecutive offsets, so while the caller works on one chunk the next ones are already
+// on their way from the device; Next() usually finds its chunk complete and returns without
+// blocking.
+//
+//     io::FileReader reader(path);
+//     io::FileReader::Chunk chunk;
+//     int n;
+//     while ((n = reader.Next(&chunk)) > 0)
+//     {
+//         Consume(chunk.data, chunk.len);
+//     }
+//     // n == 0 at EOF, negative errno on failure
+//
+// A chunk is a view into the reader's own buffer -- nothing is copied -- and stays valid until the
+// following Next(), which recycles its buffer into a new read at the tail of the pipeline. Chunks
+// come back in file order and are chunkSize bytes except where the kernel returns a short read
+// (the last chunk, or a file still being written); the pipeline then resyncs at the short read's
+// end so no byte is skipped.
+//
+// Next() is kill-aware and returns -ECANCELED once the context is killed; in-flight reads are
+// cancelled and drained when the reader is destroyed. For a file that fits in memory in one go,
+// ReadFile is simpler.
+//
+struct FileReader
+{
+    static constexpr int MAX_DEPTH = 8;
+
+    struct Chunk
+    {
+        char const* data;
+        size_t      len;
+        uint64_t    offset;
+    };
+
+    FileReader(const char* path, FileReaderOptions const& options = {}, Context* ctx = Self(),
+        Uring* ring = GetUring());
+    ~FileReader();
+
+    FileReader(FileReader const&) = delete;
+    FileReader& operator=(FileReader const&) = delete;
+
+    // Whether the open succeeded; Error() is its negative errno otherwise, or the error that ended
+    // the stream
+    //
+    bool IsOpen() const { return m_desc.has_value(); }
+    int Error() const { return m_error; }
+
+    // The next chunk in file order. Returns its length (> 0), 0 at EOF, or a negative errno.
+    //
+    int Next(Chunk* out);
+
+private:
+    struct Slot
+    {
+        Coordinator             coord;
+        std::optional<Handle>   handle;
+        uint64_t                offset{0};
+        bool                    inFlight{false};
+    };
+
+    char* Buffer(int slot) { return m_buffers.get() + static_cast<size_t>(slot) * m_chunkSize; }
+
+    void Issue(int slot);
+    void Resync(uint64_t offset);
+
+    Context*                    m_context;
+    size_t                      m_chunkSize;
+    int                         m_depth;
+    uint64_t                    m_nextOffset;
+    int                         m_error{0};
+    bool                        m_eof{false};
+
+    // The pipeline is a FIFO over the slots: m_head is the oldest read, and m_held the slot whose
+    // chunk the caller holds, reissued at the tail on the next Next()
+    //
+    int                         m_head{0};
+    int                         m_held{-1};
+
+    std::unique_ptr<char[]>     m_buffers;
+    std::optional<Descriptor>   m_desc;
+    Slot                        m_slots[MAX_DEPTH];
+};
+
+} // end namespace coop::io
+} // end namespace coop
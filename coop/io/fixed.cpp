@@ -0,0 +1,47 @@
+#define COOP_IO_KEEP_ARGS
+#include "fixed.h"
+
+#include <cerrno>
+
+#include "coop/coordinator.h"
+#include "coop/self.h"
+
+#include "descriptor.h"
+#include "handle.h"
+#include "uring.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+// liburing's prep helpers take the buffer index last; the ARGS lists keep the optional offset
+// (or flags) last instead, so these reorder.
+//
+static inline void PrepReadFixed(
+    io_uring_sqe* sqe, int fd, void* buf, size_t size, int bufIndex, uint64_t offset)
+{
+    io_uring_prep_read_fixed(sqe, fd, buf, size, offset, bufIndex);
+}
+
+static inline void PrepWriteFixed(
+    io_uring_sqe* sqe, int fd, const void* buf, size_t size, int bufIndex, uint64_t offset)
+{
+    io_uring_prep_write_fixed(sqe, fd, buf, size, offset, bufIndex);
+}
+
+static inline void PrepSendFixed(
+    io_uring_sqe* sqe, int fd, const void* buf, size_t size, int bufIndex, int flags)
+{
+    io_uring_prep_send(sqe, fd, buf, size, flags);
+    sqe->ioprio |= IORING_RECVSEND_FIXED_BUF;
+    sqe->buf_index = static_cast<uint16_t>(bufIndex);
+}
+
+COOP_IO_IMPLEMENTATIONS(ReadFixed, PrepReadFixed, READ_FIXED_ARGS)
+COOP_IO_IMPLEMENTATIONS(WriteFixed, PrepWriteFixed, WRITE_FIXED_ARGS)
+COOP_IO_IMPLEMENTATIONS(SendFixed, PrepSendFixed, SEND_FIXED_ARGS)
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+#include "coop/io/detail/op_macros.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Descriptor;
+struct Handle;
+
+// Read/Write/Send through a registered buffer (UringConfiguration::fixedBuffers). bufIndex names
+// the registered buffer and [buf, buf + size) must lie inside it -- Uring::FixedBufferIndex
+// answers both for a pointer. The kernel skips the per-op page pinning an unregistered buffer
+// costs, which is most of the CPU of a large read or write that hits the page cache.
+//
+// ReadFixed/WriteFixed work on any fd, sockets included (the offset is ignored on a stream).
+// SendFixed is IORING_OP_SEND with IORING_RECVSEND_FIXED_BUF, for callers that need send flags;
+// kernels that only accept fixed buffers on SEND_ZC fail it with -EINVAL, so plain socket writes
+// should prefer WriteFixed.
+//
+#define READ_FIXED_ARGS(F) F(void*, buf, ) F(size_t, size, ) F(int, bufIndex, ) F(uint64_t, offset, = 0)
+#define WRITE_FIXED_ARGS(F) F(const void*, buf, ) F(size_t, size, ) F(int, bufIndex, ) F(uint64_t, offset, = 0)
+#define SEND_FIXED_ARGS(F) F(const void*, buf, ) F(size_t, size, ) F(int, bufIndex, ) F(int, flags, = 0)
+
+COOP_IO_DECLARATIONS(ReadFixed, READ_FIXED_ARGS)
+COOP_IO_DECLARATIONS(WriteFixed, WRITE_FIXED_ARGS)
+COOP_IO_DECLARATIONS(SendFixed, SEND_FIXED_ARGS)
+
+} // end namespace coop::io
+} // end namespace coop
+
+#ifndef COOP_IO_KEEP_ARGS
+#undef READ_FIXED_ARGS
+#undef WRITE_FIXED_ARGS
+#undef SEND_FIXED_ARGS
+#endif
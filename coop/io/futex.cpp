@@ -0,0 +1,83 @@
+#include "futex.h"
+
+#include <cerrno>
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <liburing.h>
+
+#include "handle.h"
+#include "detail/handle_extension.h"
+
+// futex2 flags, for headers older than the io_uring futex opcodes (6.7)
+//
+#ifndef FUTEX2_SIZE_U32
+#define FUTEX2_SIZE_U32 0x02
+#endif
+#ifndef FUTEX2_PRIVATE
+#define FUTEX2_PRIVATE 128
+#endif
+
+namespace coop
+{
+
+namespace io
+{
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t)
+              && std::atomic<uint32_t>::is_always_lock_free,
+              "a futex word is a plain, lock-free 32-bit atomic");
+
+static inline uint32_t* Word(std::atomic<uint32_t>* word)
+{
+    return reinterpret_cast<uint32_t*>(word);
+}
+
+// A shared word is keyed by its page, so two processes' mappings at different addresses meet
+//
+static void PrepFutexWait(io_uring_sqe* sqe, std::atomic<uint32_t>* word, uint32_t expected,
+    FutexScope scope)
+{
+    const unsigned flags = FUTEX2_SIZE_U32 | (scope == FutexScope::Private ? FUTEX2_PRIVATE : 0);
+    io_uring_prep_futex_wait(sqe, Word(word), expected, FUTEX_BITSET_MATCH_ANY, flags, 0);
+}
+
+bool FutexWait(Handle& handle, std::atomic<uint32_t>* word, uint32_t expected,
+    FutexScope scope /* = FutexScope::Shared */)
+{
+    auto* sqe = detail::HandleExtension::GetSqe(handle);
+    if (!sqe)
+    {
+        return false;
+    }
+    PrepFutexWait(sqe, word, expected, scope);
+    handle.Submit(sqe);
+    return true;
+}
+
+bool FutexWait(Handle& handle, std::atomic<uint32_t>* word, uint32_t expected,
+    time::Interval timeout, FutexScope scope /* = FutexScope::Shared */)
+{
+    auto* sqe = detail::HandleExtension::GetSqe(handle);
+    if (!sqe)
+    {
+        return false;
+    }
+    PrepFutexWait(sqe, word, expected, scope);
+    handle.SubmitWithTimeout(sqe, timeout);
+    return true;
+}
+
+int FutexWake(std::atomic<uint32_t>* word, int count /* = 1 */,
+    FutexScope scope /* = FutexScope::Shared */)
+{
+    const int op = scope == FutexScope::Private ? FUTEX_WAKE_PRIVATE : FUTEX_WAKE;
+    long woken = syscall(SYS_futex, Word(word), op, count > 0 ? count : INT_MAX, nullptr, nullptr,
+        0);
+    return woken < 0 ? -errno : static_cast<int>(woken);
+}
+
+} // end namespace coop::io
+} // end namespace coop
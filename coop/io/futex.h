@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "coop/time/interval.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Handle;
+
+// Whether the other side of a futex word is another process mapping the same page (Shared), or
+// only this process's threads (Private, which saves the kernel the shared key lookup)
+//
+enum class FutexScope
+{
+    Shared,
+    Private,
+};
+
+// Wait on a futex word through the ring (IORING_OP_FUTEX_WAIT, kernel 6.7+), so a context can
+// park on memory another process writes: the operation completes 0 when woken, -EAGAIN if *word no
+// longer held expected when the kernel looked, and -EINVAL on a kernel without the opcode. A Shared
+// word (the default) may be woken by any process mapping the same page; a Private one only from
+// this process, with the matching scope. The timeout variant links a timeout as the other
+// operations do; the handle is then TimedOut().
+//
+bool FutexWait(Handle& handle, std::atomic<uint32_t>* word, uint32_t expected,
+    FutexScope scope = FutexScope::Shared);
+bool FutexWait(Handle& handle, std::atomic<uint32_t>* word, uint32_t expected,
+    time::Interval timeout, FutexScope scope = FutexScope::Shared);
+
+// Wake up to count waiters on a futex word of the given scope. A plain futex(2) syscall, not a ring
+// operation: the waker is often a thread, or a process, with no cooperator. Returns how many were
+// woken, or a negative errno.
+//
+int FutexWake(std::atomic<uint32_t>* word, int count = 1, FutexScope scope = FutexScope::Shared);
+
+} // end namespace coop::io
+} // end namespace coop
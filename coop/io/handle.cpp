@@ -3,19 +3,28 @@
 #include <cstdint>
 #include <liburing.h>
 #include <spdlog/spdlog.h>
+#include <utility>
 
 #include "handle.h"
 
 #include "armed_handle.h"
 #include "descriptor.h"
+#include "detached.h"
 #include "uring.h"
+#include "watcher.h"
 
 #include "coop/context.h"
 #include "coop/coordinate_with.h"
 #include "coop/coordinator.h"
+#include "coop/deadline_scope.h"
+#include "coop/thunk.h"
+#include "coop/detail/ring_message.h"
 #include "coop/detail/timer_tag.h"
 #include "coop/perf/probe.h"
+#include "coop/perf/usdt.h"
 #include "coop/cooperator.h"
+#include "coop/detail/tsc.h"
+#include "coop/time/now.h"
 
 namespace coop
 {
@@ -31,9 +40,11 @@ Handle::Handle(
 , m_descriptor(&descriptor)
 , m_coord(coordinator)
 , m_context(context)
+, m_onComplete(nullptr)
 , m_result(0)
 , m_pendingCqes(0)
 , m_timedOut(false)
+, m_linkFlags(0)
 {
 }
 
@@ -45,32 +56,113 @@ Handle::Handle(
 , m_descriptor(nullptr)
 , m_coord(coordinator)
 , m_context(context)
+, m_onComplete(nullptr)
 , m_result(0)
 , m_pendingCqes(0)
 , m_timedOut(false)
+, m_linkFlags(0)
 {
 }
 
+Handle::Handle(
+    Descriptor& descriptor,
+    Coordinator* coordinator)
+: Handle(nullptr, descriptor, coordinator)
+{
+}
+
+Handle::Handle(
+    Descriptor& descriptor,
+    Continuation* onComplete)
+: Handle(nullptr, descriptor, nullptr)
+{
+    m_onComplete = onComplete;
+}
+
 Handle::~Handle()
 {
     if (m_pendingCqes > 0)
     {
+        assert(m_context && "contextless Handle destroyed with its operation in flight");
         Cancel();
         m_coord->Flash(m_context);
     }
     assert(Disconnected());
 }
 
+void Handle::StampAccounting(struct io_uring_sqe* sqe)
+{
+    if (Cooperator::thread_cooperator->TracksContextIo())
+    {
+        m_accountTsc = coop::detail::ReadTsc();
+        m_opcode = sqe->opcode;
+    }
+}
+
+// The op's share of its context's IO statistics. A recv or send is a read or write like any
+// other; an op that moves no data (accept, poll, a timeout, ...) adds only its wait. A short
+// SendZc still reports the bytes its first CQE carried: a notification leaves m_result alone.
+//
+void Handle::ChargeAccounting()
+{
+    auto& stats = m_context->m_statistics;
+    stats.ioWaitTicks += static_cast<size_t>(coop::detail::ReadTsc() - m_accountTsc);
+    m_accountTsc = 0;
+
+    const size_t bytes = m_result > 0 ? static_cast<size_t>(m_result) : 0;
+    switch (m_opcode)
+    {
+        case IORING_OP_READ:
+        case IORING_OP_READV:
+        case IORING_OP_READ_FIXED:
+        case IORING_OP_RECV:
+        case IORING_OP_RECVMSG:
+            ++stats.ioReads;
+            stats.ioReadBytes += bytes;
+            break;
+
+        case IORING_OP_WRITE:
+        case IORING_OP_WRITEV:
+        case IORING_OP_WRITE_FIXED:
+        case IORING_OP_SEND:
+        case IORING_OP_SENDMSG:
+        case IORING_OP_SEND_ZC:
+        case IORING_OP_SENDMSG_ZC:
+            ++stats.ioWrites;
+            stats.ioWriteBytes += bytes;
+            break;
+
+        default:
+            break;
+    }
+}
+
 void Handle::Submit(struct io_uring_sqe* sqe)
 {
-    SPDLOG_TRACE("handle submit ctx={}", m_context->GetName());
+    Prepare(sqe);
+    ArmDeadline(sqe->opcode, 0);
+}
+
+void Handle::Prepare(struct io_uring_sqe* sqe)
+{
+    SPDLOG_TRACE("handle submit ctx={}", m_context ? m_context->GetName() : "(stackless)");
 
-    COOP_PERF_INC(m_context->GetCooperator()->GetPerfCounters(), perf::Counter::IoSubmit);
-    ++m_context->m_statistics.ioSubmits;
+    COOP_PERF_INC(Cooperator::thread_cooperator->GetPerfCounters(), perf::Counter::IoSubmit);
+    COOP_USDT(io_submit, this, m_descriptor ? m_descriptor->m_fd : sqe->fd, sqe->opcode,
+              m_context);
+    COOP_PERF_STAMP(perf::Hist::IoLatency, m_submitNs);
+    if (m_context)
+    {
+        ++m_context->m_statistics.ioSubmits;
+        StampAccounting(sqe);
+    }
     m_timedOut = false;
     m_pendingCqes = 1;
     m_ring->m_pendingOps++;
-    m_coord->TryAcquire(m_context);
+    if (m_coord)
+    {
+        m_coord->TryAcquire(m_context);
+    }
     if (m_descriptor)
     {
         m_descriptor->m_handles.Push(this);
@@ -81,12 +173,14 @@ void Handle::Submit(struct io_uring_sqe* sqe)
         sqe->fd = m_descriptor->m_registeredIndex;
         sqe->flags |= IOSQE_FIXED_FILE;
     }
+    sqe->flags |= m_linkFlags;
 
     io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(this));
 }
 
 void Handle::SubmitWithTimeout(struct io_uring_sqe* sqe, time::Interval timeout)
 {
+    timeout = DeadlineScope::Clamp(m_context, timeout);
     auto secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
     m_timeout.tv_sec = secs.count();
     m_timeout.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(
@@ -94,14 +188,63 @@ void Handle::SubmitWithTimeout(struct io_uring_sqe* sqe, time::Interval timeout)
     SubmitLinked(sqe);
 }
 
+void Handle::SubmitWithCoarseTimeout(struct io_uring_sqe* sqe, time::Interval timeout)
+{
+    Prepare(sqe);
+
+    // Stamped with the rounding-up clock, so the deadline is never before now + timeout
+    //
+    ArmDeadline(sqe->opcode, time::MonotonicMicrosCeil() + timeout.count());
+}
+
+void Handle::ArmDeadline(uint8_t opcode, int64_t deadlineUs)
+{
+    // The context's DeadlineScope bounds every operation but the ones that are bounded already or
+    // must run to completion. A timer fired against it looks like any coarse timeout.
+    //
+    if (m_context && m_context->m_ioDeadlineUs != 0)
+    {
+        if (opcode != IORING_OP_TIMEOUT && opcode != IORING_OP_CLOSE
+            && (deadlineUs == 0 || m_context->m_ioDeadlineUs < deadlineUs))
+        {
+            deadlineUs = m_context->m_ioDeadlineUs;
+        }
+    }
+    if (deadlineUs != 0)
+    {
+        Cooperator::thread_cooperator->RegisterTimer(this, deadlineUs, nullptr /* OnDeadline */);
+    }
+}
+
+void Handle::OnDeadline(time::TimerNode* node)
+{
+    auto* handle = static_cast<Handle*>(node);
+    if (handle->m_pendingCqes > 0 && !handle->m_timedOut)
+    {
+        handle->m_timedOut = true;
+        handle->Cancel();
+    }
+}
+
 void Handle::SubmitLinked(struct io_uring_sqe* sqe)
 {
-    SPDLOG_TRACE("handle submit_linked ctx={}", m_context->GetName());
+    SPDLOG_TRACE("handle submit_linked ctx={}", m_context ? m_context->GetName() : "(stackless)");
+    assert(m_linkFlags == 0 && "a chain step cannot carry its own linked timeout");
+    COOP_USDT(io_submit, this, m_descriptor ? m_descriptor->m_fd : sqe->fd, sqe->opcode,
+              m_context);
+    if (m_context)
+    {
+        ++m_context->m_statistics.ioSubmits;
+        StampAccounting(sqe);
+    }
 
     m_timedOut = false;
     m_pendingCqes = 2;
     m_ring->m_pendingOps++;
-    m_coord->TryAcquire(m_context);
+    if (m_coord)
+    {
+        m_coord->TryAcquire(m_context);
+    }
     if (m_descriptor)
     {
         m_descriptor->m_handles.Push(this);
@@ -172,6 +315,8 @@ bool Handle::DeferSubmit() const
 
 int Handle::Wait()
 {
+    assert(m_context && "a contextless Handle is awaited with io::Await");
+
     // Fast path: submit pending SQEs and check for immediate completion. With COOP_TASKRUN
     // (or bare mode), task_work runs during io_uring_submit(), so synchronously completed
     // operations have CQEs ready immediately. This avoids two context switches (block +
@@ -208,6 +353,8 @@ int Handle::Wait()
 
 int Handle::WaitKill()
 {
+    assert(m_context && "a contextless Handle is awaited with io::Await");
+
     // Same fast path as Wait(): submit pending SQEs and consume any CQEs that are already ready.
     // A fast-path-armed op with a resume batch to amortize into defers the eager submit to the
     // batch boundary (see MarkFastPathArmed / DeferSubmit).
@@ -231,6 +378,15 @@ int Handle::WaitKill()
     return m_result;
 }
 
+bool Handle::TryComplete()
+{
+    if (m_pendingCqes > 0 && !DeferSubmit())
+    {
+        m_ring->Poll();
+    }
+    return m_pendingCqes == 0;
+}
+
 int Handle::Result() const
 {
     assert(m_pendingCqes == 0);
@@ -245,10 +401,36 @@ void Handle::Finalize()
     }
 
     m_ring->m_pendingOps--;
+    COOP_USDT(io_finalize, this, m_descriptor ? m_descriptor->m_fd : -1, m_result);
+    if (m_accountTsc)
+    {
+        ChargeAccounting();
+    }
 
+    if (time::TimerNode::Linked())
+    {
+        Cooperator::thread_cooperator->CancelTimer(this);
+    }
     if (m_descriptor)
     {
         this->Pop();
+
+        // The last operation a CancelAndDrain is waiting out
+        //
+        if (m_descriptor->m_drained && m_descriptor->m_handles.IsEmpty())
+        {
+            std::exchange(m_descriptor->m_drained, nullptr)->Release(m_context, false);
+        }
+    }
+
+    // A continuation-driven handle runs its owner inline, last: Run may resubmit on this handle
+    // or free it
+    //
+    if (m_onComplete)
+    {
+        coop::detail::ThunkScope inThunk;
+        m_onComplete->Run();
+        return;
     }
     m_coord->Release(m_context, false /* schedule */);
 }
@@ -258,12 +440,35 @@ void Handle::Finalize()
 // reaps a whole batch with a single io_uring_cq_advance(n) after the last callback returns,
 // collapsing what would be N per-CQE release stores to the kernel-visible head into one store.
 //
+//
+// A zero-copy send (SendZc) completes in two CQEs on the same userdata: the result, flagged
+// IORING_CQE_F_MORE when a notification will follow, then the notification (IORING_CQE_F_NOTIF)
+// once the kernel no longer references the buffer. F_MORE adds the notification to m_pendingCqes,
+// so the coordinator -- and with it Wait() -- is only released when the buffer is the caller's
+// again. The notification carries no result of its own. One-shot ops never set either flag.
+//
 void Handle::Complete(struct io_uring_cqe* cqe)
 {
-    COOP_PERF_INC(m_context->GetCooperator()->GetPerfCounters(), perf::Counter::IoComplete);
-    ++m_context->m_statistics.ioCompletes;
+    if (cqe->flags & IORING_CQE_F_NOTIF)
+    {
+        SPDLOG_TRACE("handle zero-copy notification");
+        Finalize();
+        return;
+    }
+
+    COOP_PERF_INC(Cooperator::thread_cooperator->GetPerfCounters(), perf::Counter::IoComplete);
+    COOP_PERF_RECORD_SINCE(Cooperator::thread_cooperator->GetPerfHistograms(),
+                           perf::Hist::IoLatency, m_submitNs);
+    if (m_context)
+    {
+        ++m_context->m_statistics.ioCompletes;
+    }
     m_result = cqe->res;
     SPDLOG_TRACE("handle complete result={}", m_result);
+    if (cqe->flags & IORING_CQE_F_MORE)
+    {
+        ++m_pendingCqes;
+    }
     Finalize();
 }
 
@@ -281,6 +486,15 @@ void Handle::Callback(struct io_uring_cqe* cqe)
 {
     auto data = reinterpret_cast<uintptr_t>(io_uring_cqe_get_data(cqe));
 
+    // A detached op's failure, or its success where the kernel cannot skip that CQE. Its low
+    // bits carry an opcode, so it is routed out before they are read as tags.
+    //
+    if (data & coop::detail::kDetachedTag)
+    {
+        detail::CompleteDetached(GetUring(), data, cqe->res);
+        return;
+    }
+
     // Bit 1 (0x2) marks a multishot ArmedHandle CQE -- a distinct lifecycle that holds its
     // coordinator across an unbounded CQE stream rather than the one-shot count-to-zero this
     // Handle owns. Route it out before the one-shot decode. Bit 0 (0x1) then disambiguates within
@@ -306,6 +520,54 @@ void Handle::Callback(struct io_uring_cqe* cqe)
         return;
     }
 
+    if (data == coop::detail::kCancelFdTag)
+    {
+        return;
+    }
+    if (data == coop::detail::kBulkCancelTag)
+    {
+        GetUring()->OnBulkCancel(cqe->res);
+        return;
+    }
+
+    // The cross-cooperator wake (kWakeTag) and the sender's acknowledgement of it. Bits 0-2 cannot
+    // tell these apart from a Handle pointer, so they match whole values.
+    //
+    if ((data & ~uintptr_t(0x1)) == coop::detail::kWakeTag)
+    {
+        if (data == coop::detail::kWakeTag)
+        {
+            Cooperator::thread_cooperator->OnPeerWake();
+        }
+        return;
+    }
+
+    // An io::Watcher's readiness edge, or the acknowledgement of its update or removal
+    //
+    if (data & coop::detail::kWatchTag)
+    {
+        Watcher::Dispatch(cqe, data);
+        return;
+    }
+
+    // A cooperator's RingMessage: delivered here, or -- bit 0 set -- the sender's completion of the
+    // post, which only matters when the kernel refused it
+    //
+    if (data & coop::detail::kMessageTag)
+    {
+        auto* message = reinterpret_cast<coop::detail::RingMessage*>(
+            data & ~(coop::detail::kMessageAckTag | uintptr_t(0x6)));
+        if (!(data & 0x1))
+        {
+            message->deliver(message);
+        }
+        else if (cqe->res < 0)
+        {
+            message->undelivered(message);
+        }
+        return;
+    }
+
     auto* handle = reinterpret_cast<Handle*>(data & ~uintptr_t(0x7));
 
     if (data & 1)
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <linux/time_types.h>
 
 #include "coop/detail/embedded_list.h"
 #include "coop/time/interval.h"
+#include "coop/time/timer_queue.h"
 
 struct io_uring_cqe;
 struct io_uring_sqe;
@@ -12,6 +14,7 @@ namespace coop
 {
 
 struct Context;
+struct Continuation;
 struct Coordinator;
 
 namespace io
@@ -79,7 +82,17 @@ namespace detail { struct HandleExtension; }
 //   Bit 0 is stolen to distinguish primary CQEs (the operation itself) from secondary CQEs
 //   (cancel acknowledgments, linked timeout completions).
 //
+// Coarse timeouts
+//
+//   SubmitWithCoarseTimeout submits the operation alone and registers its deadline in the
+//   cooperator's timer queue through the private TimerNode base. Finalize unlinks it when the
+//   operation completes first; if the deadline passes first, the timer service calls OnDeadline,
+//   which marks the handle timed out and Cancels, and the operation then completes -ECANCELED as it
+//   would under a linked timeout. Nothing else -- Wait, the destructor, an external waiter on the
+//   coordinator -- needs to know which kind of timeout is armed.
+//
 struct Handle : EmbeddedListHookups<Handle>
+              , private time::TimerNode
 {
     using List = EmbeddedList<Handle>;
 
@@ -88,6 +101,23 @@ struct Handle : EmbeddedListHookups<Handle>
 
     Handle(Context*, Descriptor&, Coordinator*);
     Handle(Context*, Uring*, Coordinator*);
+
+    // Contextless handle, for stackless owners (a Task, a continuation) that wait on the
+    // coordinator through a continuation -- io::Await -- rather than blocking a context. Wait and
+    // WaitKill are unavailable, and it must not be destroyed with its operation in flight: there is
+    // no context to drain the cancellation on.
+    //
+    Handle(Descriptor&, Coordinator*);
+
+    // Continuation-driven handle: no coordinator and no context. When the operation's last CQE
+    // lands, onComplete->Run() is called inline from Uring::Poll's reap loop, with Result() ready
+    // -- so a stackless state machine can read, parse and submit its next operation on this same
+    // handle without a context, a switch or a trip through the continuation drain. Run must not
+    // suspend or Poll (its CQE batch is still being reaped); it may destroy the handle's owner
+    // once it has decided not to resubmit. Not for io::Await, Wait or WaitKill, and the same
+    // destruction rule as a contextless handle: Cancel, and let Run see -ECANCELED, first.
+    //
+    Handle(Descriptor&, Continuation* onComplete);
     ~Handle();
 
     // Block until the operation completes. Uses CoordinateWith on the Handle's coordinator.
@@ -107,8 +137,18 @@ struct Handle : EmbeddedListHookups<Handle>
     //
     int Result() const;
 
+    // Wait()'s fast path without the wait: flush pending SQEs and reap ready CQEs (subject to the
+    // same deferral), then report whether the operation has completed. For stackless waiters.
+    //
+    bool TryComplete();
+
     bool TimedOut() const { return m_timedOut; }
 
+    // The coordinator Submit holds and the last CQE releases; null for a continuation-driven
+    // handle
+    //
+    Coordinator* GetCoordinator() const { return m_coord; }
+
     void Submit(struct io_uring_sqe*);
 
     // Submit with a linked timeout. Converts the interval to a __kernel_timespec stored in
@@ -117,13 +157,20 @@ struct Handle : EmbeddedListHookups<Handle>
     //
     void SubmitWithTimeout(struct io_uring_sqe*, time::Interval timeout);
 
+    // Submit with a coarse timeout (io::CoarseTimeout): no linked SQE; the deadline goes in the
+    // cooperator's timer queue and, if it passes before the operation completes, Cancels it. On
+    // the cooperator thread, like every submit.
+    //
+    void SubmitWithCoarseTimeout(struct io_uring_sqe*, time::Interval timeout);
+
     // Cancel an in-flight operation. Submits an IORING_OP_ASYNC_CANCEL targeting our original
     // SQE's userdata. The cancel acknowledgment CQE is routed to OnSecondaryComplete. No-op if
     // m_pendingCqes == 0.
     //
     void Cancel();
 
-    // Invoked when the primary completion queue event is received (untagged pointer).
+    // Invoked when the primary completion queue event is received (untagged pointer). Also takes
+    // a zero-copy send's notification CQE, which shares the primary's userdata.
     //
     void Complete(struct io_uring_cqe*);
 
@@ -136,6 +183,11 @@ struct Handle : EmbeddedListHookups<Handle>
     //
     static void Callback(struct io_uring_cqe* cqe);
 
+    // Invoked by the cooperator's timer service when a coarse deadline passes. The node is a
+    // Handle's (a TimerNode registered without a coordinator).
+    //
+    static void OnDeadline(time::TimerNode* node);
+
 private:
     friend struct detail::HandleExtension;
 
@@ -144,11 +196,25 @@ private:
     //
     void SubmitLinked(struct io_uring_sqe*);
 
+    // Submit's bookkeeping without the deadline, shared with SubmitWithCoarseTimeout
+    //
+    void Prepare(struct io_uring_sqe*);
+
+    // Register the coarse timer at `deadlineUs`, or at the context's DeadlineScope deadline when
+    // that comes first; 0 for no explicit deadline. Registers nothing when neither is set.
+    //
+    void ArmDeadline(uint8_t opcode, int64_t deadlineUs);
+
     // Shared finalization logic. Decrements m_pendingCqes and only releases the coordinator
     // when it hits zero.
     //
     void Finalize();
 
+    // Per-context IO accounting: stamp at submit when the cooperator tracks it, charge at Finalize
+    //
+    void StampAccounting(struct io_uring_sqe* sqe);
+    void ChargeAccounting();
+
     // Whether Wait()/WaitKill() should skip the eager submit and let the SQE accumulate for the
     // scheduler's batch-boundary Poll(). Gated purely on in-flight depth (PendingOps > threshold):
     // a fan-out server batches; a serial flow eager-submits for latency. See handle.cpp.
@@ -159,11 +225,27 @@ private:
     Descriptor*     m_descriptor;
     Coordinator*    m_coord;
     Context*        m_context;
+    Continuation*   m_onComplete;
 
     int     m_result;
     int     m_pendingCqes;
     bool    m_timedOut;
 
+    // IOSQE_IO_LINK or IOSQE_IO_HARDLINK when the operation is a non-final step of an io::Chain,
+    // ORed into its SQE at Submit. Zero otherwise.
+    //
+    uint8_t m_linkFlags;
+
+    // When the operation was submitted, for the IoLatency histogram; 0 when not timing
+    //
+    int64_t m_submitNs{0};
+
+    // Per-context IO accounting (CooperatorConfiguration::trackContextIo): ReadTsc at submit, 0
+    // when not accounting, and the operation's opcode, to class it as a read or write at Finalize
+    //
+    int64_t m_accountTsc{0};
+    uint8_t m_opcode{0};
+
     struct __kernel_timespec m_timeout;
 };
 
@@ -1,10 +1,23 @@
 #pragma once
 
 #include "accept.h"
+#include "await.h"
+#include "busy_poll.h"
 #include "close.h"
 #include "connect.h"
+#include "cork.h"
+#include "detached.h"
+#include "direct_file.h"
+#include "fallocate.h"
+#include "file_cache.h"
+#include "file_reader.h"
+#include "fixed.h"
+#include "fsync.h"
+#include "futex.h"
+#include "nvme.h"
 #include "open.h"
 #include "poll.h"
+#include "proxy.h"
 #include "read.h"
 #include "read_file.h"
 #include "recv.h"
@@ -12,8 +25,12 @@
 #include "send.h"
 #include "sendfile.h"
 #include "splice.h"
+#include "sqpoll_pool.h"
+#include "statx.h"
 #include "stream.h"
+#include "udp.h"
 #include "shutdown_on_kill.h"
+#include "socket.h"
 #include "writev.h"
 
 // coop::io offers a very direct abstraction for blocking i/o and its user facing unit is the
@@ -0,0 +1,271 @@
+#define COOP_IO_KEEP_ARGS
+#include "nvme.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/nvme_ioctl.h>
+#include <memory>
+#include <new>
+#include <sys/ioctl.h>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/coordinator.h"
+#include "coop/self.h"
+
+#include "handle.h"
+#include "open.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+// NVM command set opcodes, and the admin command the open identifies the namespace with
+//
+static constexpr uint8_t kNvmeWrite = 0x01;
+static constexpr uint8_t kNvmeRead = 0x02;
+static constexpr uint8_t kNvmeIdentify = 0x06;
+
+// The command in the SQE's upper half. The driver reads it there, so nothing of it outlives the
+// prep.
+//
+static void PrepNvme(io_uring_sqe* sqe, int fd, uint8_t opcode, const void* buf, uint32_t len,
+    uint64_t offset, NvmeNamespace ns, int bufIndex)
+{
+    assert(offset % (uint64_t(1) << ns.lbaShift) == 0 && "unaligned offset");
+    assert(len > 0 && len % (uint32_t(1) << ns.lbaShift) == 0 && "unaligned length");
+
+    io_uring_prep_rw(IORING_OP_URING_CMD, sqe, fd, nullptr, 0, 0);
+    sqe->cmd_op = NVME_URING_CMD_IO;
+    if (bufIndex >= 0)
+    {
+        sqe->uring_cmd_flags = IORING_URING_CMD_FIXED;
+        sqe->buf_index = static_cast<uint16_t>(bufIndex);
+    }
+
+    auto* cmd = reinterpret_cast<struct nvme_uring_cmd*>(sqe->cmd);
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->opcode = opcode;
+    cmd->nsid = ns.nsid;
+    cmd->addr = reinterpret_cast<uint64_t>(buf);
+    cmd->data_len = len;
+
+    // Starting LBA in cdw10-11, and the block count, zero-based, in cdw12's low half
+    //
+    uint64_t slba = offset >> ns.lbaShift;
+    cmd->cdw10 = static_cast<uint32_t>(slba);
+    cmd->cdw11 = static_cast<uint32_t>(slba >> 32);
+    cmd->cdw12 = (len >> ns.lbaShift) - 1;
+}
+
+static inline void PrepNvmeRead(io_uring_sqe* sqe, int fd, void* buf, uint32_t len,
+    uint64_t offset, NvmeNamespace ns, int bufIndex)
+{
+    PrepNvme(sqe, fd, kNvmeRead, buf, len, offset, ns, bufIndex);
+}
+
+static inline void PrepNvmeWrite(io_uring_sqe* sqe, int fd, const void* buf, uint32_t len,
+    uint64_t offset, NvmeNamespace ns, int bufIndex)
+{
+    PrepNvme(sqe, fd, kNvmeWrite, buf, len, offset, ns, bufIndex);
+}
+
+COOP_IO_IMPLEMENTATIONS(NvmeRead, PrepNvmeRead, NVME_READ_ARGS)
+COOP_IO_IMPLEMENTATIONS(NvmeWrite, PrepNvmeWrite, NVME_WRITE_ARGS)
+
+// The namespace id, LBA size and capacity. An ioctl, once per open: the identify is an admin
+// command, which the IO queues a passthrough ring polls cannot carry.
+//
+static int Identify(int fd, NvmeNamespace* ns, uint64_t* blocks)
+{
+    int nsid = ioctl(fd, NVME_IOCTL_ID);
+    if (nsid < 0)
+    {
+        return -errno;
+    }
+
+    // Page-aligned for the DMA. Allocated per call: the identify runs once per open.
+    //
+    constexpr size_t kIdentifySize = 4096;
+    std::unique_ptr<unsigned char, decltype(&free)> buffer(
+        static_cast<unsigned char*>(std::aligned_alloc(kIdentifySize, kIdentifySize)), &free);
+    if (!buffer)
+    {
+        return -ENOMEM;
+    }
+    unsigned char* data = buffer.get();
+
+    struct nvme_admin_cmd cmd{};
+    cmd.opcode = kNvmeIdentify;
+    cmd.nsid = uint32_t(nsid);
+    cmd.addr = reinterpret_cast<uint64_t>(data);
+    cmd.data_len = kIdentifySize;
+    cmd.cdw10 = 0;                          // CNS 0: the namespace's identify structure
+    if (ioctl(fd, NVME_IOCTL_ADMIN_CMD, &cmd) < 0)
+    {
+        return -errno;
+    }
+
+    // NSZE at byte 0; FLBAS at 26 picks one of the LBA formats from byte 128, whose LBADS (byte 2
+    // of the 4) is the LBA size as a power of two. FLBAS's low nibble is the index, bits 5-6 its
+    // upper bits past 16 formats.
+    //
+    uint64_t nsze;
+    memcpy(&nsze, data, sizeof(nsze));
+    uint8_t flbas = data[26];
+    unsigned format = (flbas & 0xf) | ((flbas >> 5) & 0x3) << 4;
+    uint8_t lbads = data[128 + 4 * format + 2];
+    if (lbads < 9)
+    {
+        return -EINVAL;
+    }
+
+    ns->nsid = uint32_t(nsid);
+    ns->lbaShift = lbads;
+    *blocks = nsze;
+    return 0;
+}
+
+NvmeDevice::NvmeDevice(const char* path, Uring* ring /* = GetStorageUring() */)
+: m_ring(ring)
+{
+    assert(m_ring);
+    if (!m_ring->SupportsPassthrough())
+    {
+        spdlog::warn("nvme device path={} needs a ring with sqe128 and cqe32", path);
+        m_error = -EINVAL;
+        return;
+    }
+
+    // Opened on the cooperator's ring, as DirectFile's files are
+    //
+    int fd = Open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        spdlog::warn("nvme device open failed path={} err={}", path, fd);
+        m_error = fd;
+        return;
+    }
+
+    int err = Identify(fd, &m_ns, &m_blocks);
+    if (err < 0)
+    {
+        spdlog::warn("nvme device identify failed path={} err={}", path, err);
+        Descriptor closer(fd, GetUring());
+        closer.Close();
+        m_error = err;
+        return;
+    }
+
+    m_desc.emplace(registered, fd, m_ring);
+    spdlog::info("nvme device open path={} nsid={} lba={} blocks={}",
+        path, m_ns.nsid, BlockSize(), m_blocks);
+}
+
+NvmeDevice::~NvmeDevice()
+{
+    int result = Close();
+    if (result < 0) [[unlikely]]
+    {
+        spdlog::warn("nvme device close in destructor failed result={}", result);
+    }
+}
+
+int NvmeDevice::Close()
+{
+    if (!m_desc)
+    {
+        return 0;
+    }
+    if (m_ring == GetUring())
+    {
+        int result = m_desc->Close();
+        m_desc.reset();
+        return result;
+    }
+
+    int fd = m_desc->Release();
+    m_desc.reset();
+    Descriptor closer(fd, GetUring());
+    return closer.Close();
+}
+
+int NvmeDevice::ReadAt(void* buf, uint32_t len, uint64_t offset, int bufIndex /* = -1 */)
+{
+    BlockIo op{buf, len, offset, bufIndex};
+    Batch(&op, 1, false);
+    return op.result;
+}
+
+int NvmeDevice::WriteAt(void const* buf, uint32_t len, uint64_t offset, int bufIndex /* = -1 */)
+{
+    BlockIo op{const_cast<void*>(buf), len, offset, bufIndex};
+    Batch(&op, 1, true);
+    return op.result;
+}
+
+int NvmeDevice::Batch(BlockIo* ops, size_t count, bool write)
+{
+    if (!m_desc)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            ops[i].result = -EBADF;
+        }
+        return 0;
+    }
+
+    auto* ctx = Self();
+    int complete = 0;
+
+    Coordinator coords[MAX_BATCH];
+    alignas(Handle) unsigned char storage[MAX_BATCH][sizeof(Handle)];
+
+    for (size_t base = 0; base < count; base += MAX_BATCH)
+    {
+        size_t n = std::min(MAX_BATCH, count - base);
+
+        // The whole batch goes into the SQ before the first wait, as in DirectFile::Batch
+        //
+        for (size_t i = 0; i < n; i++)
+        {
+            auto& op = ops[base + i];
+            auto* handle = new (storage[i]) Handle(ctx, *m_desc, &coords[i]);
+            bool submitted = write
+                ? NvmeWrite(*handle, op.buf, op.len, op.offset, m_ns, op.bufIndex)
+                : NvmeRead(*handle, op.buf, op.len, op.offset, m_ns, op.bufIndex);
+            op.result = submitted ? 0 : -EAGAIN;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            auto& op = ops[base + i];
+            auto* handle = reinterpret_cast<Handle*>(storage[i]);
+            if (op.result == 0)
+            {
+                // The driver reports 0 for the whole transfer, and an NVMe status above it
+                //
+                int result = handle->Wait();
+                op.result = result == 0 ? static_cast<int>(op.len) : result > 0 ? -EIO : result;
+            }
+            handle->~Handle();
+
+            if (op.result == static_cast<int>(op.len))
+            {
+                complete++;
+            }
+        }
+    }
+
+    SPDLOG_TRACE("nvme device {} ops={} complete={}", write ? "write" : "read", count, complete);
+    return complete;
+}
+
+} // end namespace coop::io
+} // end namespace coop
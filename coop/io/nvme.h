@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "descriptor.h"
+#include "direct_file.h"
+#include "uring.h"
+
+#include "coop/io/detail/op_macros.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Handle;
+
+// What an NVMe command needs to know about the namespace it addresses: its id, and the LBA size
+// as a shift, which turns byte offsets and lengths into the command's block numbers
+//
+struct NvmeNamespace
+{
+    uint32_t nsid;
+    uint32_t lbaShift;
+};
+
+// NVMe read and write passthrough (IORING_OP_URING_CMD with NVME_URING_CMD_IO, kernel 6.0+) on a
+// namespace's generic char device (/dev/ngXnY). The command goes from the SQE to the driver's
+// queue: no filesystem, no block layer, no bio -- the per-IO cost a storage engine that owns its
+// own layout has no use for.
+//
+// The ring must be set up with UringConfiguration::sqe128 and cqe32, since the NVMe command rides
+// in the upper half of a 128-byte SQE. With IOPOLL (the storage ring's default) the completion is
+// polled off the device's queue. bufIndex names a registered buffer holding buf, or is -1 for
+// plain memory; offset and len must be LBA multiples, and len at most the device's transfer limit.
+//
+// The result is the driver's: 0 on success, a negative errno, or a positive NVMe status (status
+// code and type, as the completion reported them) when the device failed the command.
+//
+#define NVME_READ_ARGS(F) F(void*, buf, ) F(uint32_t, len, ) F(uint64_t, offset, ) F(NvmeNamespace, ns, ) F(int, bufIndex, = -1)
+#define NVME_WRITE_ARGS(F) F(const void*, buf, ) F(uint32_t, len, ) F(uint64_t, offset, ) F(NvmeNamespace, ns, ) F(int, bufIndex, = -1)
+
+COOP_IO_DECLARATIONS(NvmeRead, NVME_READ_ARGS)
+COOP_IO_DECLARATIONS(NvmeWrite, NVME_WRITE_ARGS)
+
+// DirectFile's counterpart for an NVMe namespace through passthrough: the generic char device,
+// opened on the cooperator's ring and driven on a storage ring set up for it,
+//
+//     cfg.storage = {.entries = 256, .iopoll = true, .cqe32 = true, .sqe128 = true,
+//         .fixedBuffers = 64, .fixedBufferSize = 64 * 1024};
+//     io::NvmeDevice device("/dev/ng0n1");
+//
+// The open identifies the namespace (one admin ioctl), so BlockSize and Blocks come from the
+// device. Batches work as DirectFile's do, and results are bytes moved as there: a device error
+// is -EIO. Needs read and write access to the char device (root, or the disk group).
+//
+struct NvmeDevice
+{
+    using BlockIo = DirectFile::BlockIo;
+    static constexpr size_t MAX_BATCH = DirectFile::MAX_BATCH;
+
+    explicit NvmeDevice(const char* path, Uring* ring = GetStorageUring());
+    ~NvmeDevice();
+
+    NvmeDevice(NvmeDevice const&) = delete;
+    NvmeDevice& operator=(NvmeDevice const&) = delete;
+
+    bool IsOpen() const { return m_desc.has_value(); }
+
+    // The open's or identify's negative errno when !IsOpen(), else 0. -EINVAL: the ring was not
+    // set up for passthrough. -ENOTTY: not an NVMe char device.
+    //
+    int Error() const { return m_error; }
+
+    int Close();
+
+    NvmeNamespace Namespace() const { return m_ns; }
+
+    // The LBA size, and the namespace's size in LBAs
+    //
+    uint32_t BlockSize() const { return uint32_t(1) << m_ns.lbaShift; }
+    uint64_t Blocks() const { return m_blocks; }
+
+    // Registered memory from the ring's pool, as DirectFile::AcquireBlock
+    //
+    Uring::FixedBuffer AcquireBuffer() { return m_ring->AcquireFixedBuffer(); }
+    void ReleaseBuffer(Uring::FixedBuffer buffer) { m_ring->ReleaseFixedBuffer(buffer.index); }
+
+    // Issue count operations and block until all of them completed, as DirectFile::ReadAt. Offsets
+    // and lengths need only be BlockSize() multiples. Returns how many ops moved their full len.
+    //
+    int ReadAt(BlockIo* ops, size_t count) { return Batch(ops, count, false); }
+    int WriteAt(BlockIo* ops, size_t count) { return Batch(ops, count, true); }
+
+    int ReadAt(void* buf, uint32_t len, uint64_t offset, int bufIndex = -1);
+    int WriteAt(void const* buf, uint32_t len, uint64_t offset, int bufIndex = -1);
+
+    Uring* GetRing() const { return m_ring; }
+
+private:
+    int Batch(BlockIo* ops, size_t count, bool write);
+
+    Uring*                      m_ring;
+    int                         m_error{0};
+    NvmeNamespace               m_ns{0, 9};
+    uint64_t                    m_blocks{0};
+    std::optional<Descriptor>   m_desc;
+};
+
+} // end namespace coop::io
+} // end namespace coop
+
+#ifndef COOP_IO_KEEP_ARGS
+#undef NVME_READ_ARGS
+#undef NVME_WRITE_ARGS
+#endif
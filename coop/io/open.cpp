@@ -17,6 +17,7 @@ namespace io
 {
 
 COOP_IO_URING_IMPLEMENTATIONS(Open, io_uring_prep_openat, OPEN_ARGS)
+COOP_IO_URING_IMPLEMENTATIONS(OpenDirect, io_uring_prep_openat_direct, OPEN_DIRECT_ARGS)
 
 } // end namespace coop::io
 } // end namespace coop
@@ -15,9 +15,20 @@ struct Handle;
 #define OPEN_ARGS(F) F(const char*, path, ) F(int, flags, ) F(mode_t, mode, = 0)
 COOP_IO_URING_DECLARATIONS(Open, OPEN_ARGS)
 
+// Open straight into slot of the registered file table (io_uring_prep_openat_direct) instead of
+// the process fd table: no fd is allocated and the file is addressable only through the slot, by
+// Descriptor(direct, slot). Returns 0 on success. The slot comes from Uring::ReserveSlot. Being
+// fd-free, it can open and use a file within one io::Chain. With IORING_FILE_INDEX_ALLOC for slot
+// the kernel picks a free one from the direct range instead and returns it.
+//
+#define OPEN_DIRECT_ARGS(F) \
+    F(const char*, path, ) F(int, flags, ) F(mode_t, mode, ) F(unsigned, slot, )
+COOP_IO_URING_DECLARATIONS(OpenDirect, OPEN_DIRECT_ARGS)
+
 } // end namespace coop::io
 } // end namespace coop
 
 #ifndef COOP_IO_KEEP_ARGS
 #undef OPEN_ARGS
+#undef OPEN_DIRECT_ARGS
 #endif
@@ -0,0 +1,127 @@
+#include "pass_fds.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace coop
+{
+
+namespace io
+{
+
+namespace
+{
+
+// Control space for a full message, aligned as cmsghdr requires
+//
+union ControlBuffer
+{
+    char            buf[CMSG_SPACE(sizeof(int) * kMaxPassedFds)];
+    struct cmsghdr  align;
+};
+
+} // end anonymous namespace
+
+int SendFds(int sock, int const* fds, int count)
+{
+    if (count <= 0 || count > kMaxPassedFds)
+    {
+        return -EINVAL;
+    }
+
+    // A stream socket carries ancillary data only alongside at least one byte
+    //
+    char byte = 0;
+    struct iovec iov = {&byte, 1};
+    ControlBuffer control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+    auto* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+
+    ssize_t n;
+    while ((n = ::sendmsg(sock, &msg, MSG_NOSIGNAL)) < 0 && errno == EINTR)
+    {
+    }
+    return n < 0 ? -errno : 0;
+}
+
+int ReceiveFds(int sock, int* fds, int maxFds)
+{
+    if (maxFds <= 0)
+    {
+        return -EINVAL;
+    }
+
+    char byte;
+    struct iovec iov = {&byte, 1};
+    ControlBuffer control;
+
+    struct msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t n;
+    while ((n = ::recvmsg(sock, &msg, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR)
+    {
+    }
+    if (n <= 0)
+    {
+        return n < 0 ? -errno : 0;
+    }
+
+    int received = 0;
+    bool overflow = (msg.msg_flags & MSG_CTRUNC) != 0;
+    for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+        {
+            continue;
+        }
+
+        int count = static_cast<int>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        auto const* data = CMSG_DATA(cmsg);
+        for (int i = 0; i < count; i++)
+        {
+            int fd;
+            memcpy(&fd, data + i * sizeof(int), sizeof(int));
+            if (received < maxFds)
+            {
+                fds[received++] = fd;
+            }
+            else
+            {
+                ::close(fd);
+                overflow = true;
+            }
+        }
+    }
+
+    // The control buffer holds a full message, so truncation also means too many
+    //
+    if (overflow)
+    {
+        for (int i = 0; i < received; i++)
+        {
+            ::close(fds[i]);
+        }
+        return -EMSGSIZE;
+    }
+    return received;
+}
+
+} // end namespace coop::io
+} // end namespace coop
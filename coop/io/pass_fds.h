@@ -0,0 +1,33 @@
+#pragma once
+
+namespace coop
+{
+
+namespace io
+{
+
+// Pass descriptors to another process over a connected unix domain socket (SCM_RIGHTS). This is
+// how a restarting server hands its listening sockets to the binary replacing it: the successor
+// serves the same sockets (http::ServerGroupConfiguration::listeners), so connections queue on
+// them throughout and none are refused, while the old process drains (Cooperator::Drain). The
+// receiver gets new fds for the same open sockets; the sender's copies stay its own to close.
+//
+// These are plain blocking syscalls -- a handoff runs once, from whatever thread orchestrates the
+// restart, not on a cooperator's hot path.
+//
+// At most kMaxPassedFds per message, the kernel's SCM_MAX_FD
+//
+inline constexpr int kMaxPassedFds = 253;
+
+// Send count fds as one message. Returns 0 or a negative errno.
+//
+int SendFds(int sock, int const* fds, int count);
+
+// Receive one message's fds, up to maxFds (close-on-exec). Returns how many arrived, 0 if the
+// peer closed, or a negative errno: -EMSGSIZE, every fd closed, when the message carried more
+// than maxFds.
+//
+int ReceiveFds(int sock, int* fds, int maxFds);
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,184 @@
+#ifndef COOP_HAVE_PQ
+#define COOP_HAVE_PQ 0
+#endif
+
+#if COOP_HAVE_PQ
+
+#include <cerrno>
+#include <poll.h>
+
+#include "pq.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+namespace pq
+{
+
+Connection::Connection(Context* context)
+: m_context(context)
+{
+}
+
+Connection::~Connection()
+{
+    // The poll pins the socket's file, not its number: remove it before libpq closes the socket
+    //
+    m_watcher.reset();
+    if (m_conn)
+    {
+        PQfinish(m_conn);
+    }
+}
+
+int Connection::WaitFor(uint32_t events, time::Interval timeout)
+{
+    int fd = PQsocket(m_conn);
+    if (fd < 0)
+    {
+        return -EBADF;
+    }
+
+    if (!m_watcher)
+    {
+        m_watcher.emplace(m_context, fd, events);
+    }
+    else
+    {
+        m_watcher->SetEvents(events);
+    }
+
+    int ev = timeout.count() > 0 ? m_watcher->WaitKill(timeout) : m_watcher->WaitKill();
+    if (ev < 0)
+    {
+        m_waitError = ev;
+    }
+    return ev;
+}
+
+int Connection::Connect(char const* conninfo, time::Interval stepTimeout)
+{
+    m_conn = PQconnectStart(conninfo);
+    if (!m_conn)
+    {
+        return -ENOMEM;
+    }
+
+    PostgresPollingStatusType poll = PGRES_POLLING_WRITING;
+    while (poll != PGRES_POLLING_OK)
+    {
+        if (poll == PGRES_POLLING_FAILED || PQstatus(m_conn) == CONNECTION_BAD)
+        {
+            m_watcher.reset();
+            return -ECONNREFUSED;
+        }
+
+        int ev = WaitFor(poll == PGRES_POLLING_READING ? POLLIN : POLLOUT, stepTimeout);
+        if (ev < 0)
+        {
+            return ev;
+        }
+        poll = PQconnectPoll(m_conn);
+
+        // libpq may move to a new socket between steps, trying the next host or address, and
+        // the new one can reuse the old number. A watcher per step costs a few SQEs per connect.
+        //
+        m_watcher.reset();
+    }
+
+    PQsetnonblocking(m_conn, 1);
+    return 0;
+}
+
+int Connection::Flush()
+{
+    m_waitError = 0;
+
+    int ret;
+    while ((ret = PQflush(m_conn)) == 1)
+    {
+        // The server may be waiting for us to read before it reads more of what we send
+        //
+        int ev = WaitFor(POLLIN | POLLOUT);
+        if (ev < 0)
+        {
+            return ev;
+        }
+        if ((ev & POLLIN) && !PQconsumeInput(m_conn))
+        {
+            return -EIO;
+        }
+    }
+    return ret == 0 ? 0 : -EIO;
+}
+
+PGresult* Connection::GetResult()
+{
+    // PQconsumeInput reads until the socket would block or its buffer fills, and libpq grows the
+    // buffer and reads again when it fills, so every wait here starts from a drained socket --
+    // what the watcher's edges need
+    //
+    while (PQisBusy(m_conn))
+    {
+        if (WaitFor(POLLIN) < 0 || !PQconsumeInput(m_conn))
+        {
+            return nullptr;
+        }
+    }
+    return PQgetResult(m_conn);
+}
+
+PGresult* Connection::Collect()
+{
+    if (Flush() < 0)
+    {
+        return nullptr;
+    }
+
+    // PQexec's rule: the last result wins, and a failed one is kept over what follows it
+    //
+    PGresult* last = nullptr;
+    while (PGresult* result = GetResult())
+    {
+        if (last && PQresultStatus(last) == PGRES_FATAL_ERROR)
+        {
+            PQclear(result);
+            continue;
+        }
+        PQclear(last);
+        last = result;
+    }
+    if (m_waitError < 0)
+    {
+        PQclear(last);
+        return nullptr;
+    }
+    return last;
+}
+
+PGresult* Connection::Exec(char const* sql)
+{
+    if (!PQsendQuery(m_conn, sql))
+    {
+        return nullptr;
+    }
+    return Collect();
+}
+
+PGresult* Connection::ExecParams(char const* sql, int nParams, char const* const* values)
+{
+    if (!PQsendQueryParams(m_conn, sql, nParams, nullptr, values, nullptr, nullptr, 0))
+    {
+        return nullptr;
+    }
+    return Collect();
+}
+
+} // end namespace coop::io::pq
+} // end namespace coop::io
+} // end namespace coop
+
+#endif // COOP_HAVE_PQ
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <optional>
+
+#include <libpq-fe.h>
+
+#include "watcher.h"
+
+#include "coop/time/interval.h"
+
+// libpq on a context. libpq's nonblocking API does the protocol and the socket IO itself and
+// leaves the waiting to the caller; pq::Connection does that waiting on an io::Watcher, so a
+// query parks its context until the server answers instead of blocking the cooperator's thread.
+// It follows the libpq documentation's asynchronous pattern to the letter: PQconnectPoll steered
+// by its reading and writing verdicts, PQflush until it reports 0 (consuming input when the
+// socket turns readable meanwhile), and PQconsumeInput until PQisBusy clears.
+//
+//   io::pq::Connection db(ctx);
+//   if (db.Connect("host=localhost dbname=app") < 0) { spdlog::warn("{}", db.Error()); ... }
+//   PGresult* r = db.Exec("SELECT 1");
+//   ...
+//   PQclear(r);
+//
+// Built when CMake finds libpq (COOP_HAVE_PQ).
+//
+
+namespace coop
+{
+
+struct Context;
+
+namespace io
+{
+
+namespace pq
+{
+
+struct Connection
+{
+    explicit Connection(Context* context);
+    ~Connection();
+
+    Connection(Connection const&) = delete;
+
+    // Connect with PQconnectStart's conninfo. 0 once the connection is up; -ECONNREFUSED when
+    // libpq gives up (Error() says why), -ETIMEDOUT when one step waits longer than stepTimeout,
+    // -ECANCELED when the context is killed.
+    //
+    int Connect(char const* conninfo, time::Interval stepTimeout = time::Interval(0));
+
+    // PQexec, without blocking the thread: send, wait for every result and return the last, for
+    // the caller to PQclear. nullptr when the send, the server or the wait fails -- WaitError()
+    // is nonzero for the latter, and the connection should then be dropped: a query was left
+    // half-read.
+    //
+    PGresult* Exec(char const* sql);
+    PGresult* ExecParams(char const* sql, int nParams, char const* const* values);
+
+    // The steps Exec is built from, for PQsendQueryParams, PQsendPrepared or pipeline mode:
+    // after a PQsend*, Flush, then GetResult until it returns nullptr.
+    //
+    int Flush();
+    PGresult* GetResult();
+
+    char const* Error() const { return PQerrorMessage(m_conn); }
+    int WaitError() const { return m_waitError; }
+
+    PGconn* Get() const { return m_conn; }
+
+  private:
+    int WaitFor(uint32_t events, time::Interval timeout = time::Interval(0));
+    PGresult* Collect();
+
+    Context*                m_context;
+    PGconn*                 m_conn = nullptr;
+    std::optional<Watcher>  m_watcher;
+    int                     m_waitError = 0;
+};
+
+} // end namespace coop::io::pq
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,140 @@
+#include "proxy.h"
+
+#include <cerrno>
+#include <optional>
+#include <sys/socket.h>
+#include <tuple>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/context.h"
+#include "coop/coordinate_with.h"
+#include "coop/coordinator.h"
+#include "coop/cooperator.h"
+#include "coop/self.h"
+
+#include "descriptor.h"
+#include "shutdown.h"
+#include "shutdown_on_kill.h"
+#include "splice.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+namespace
+{
+
+// Relay in -> out until in reaches EOF (half-closing out), a splice fails, or ctx is killed
+//
+int Relay(Context* ctx, Descriptor& in, Descriptor& out, ProxyOptions const& options,
+    uint64_t* bytes)
+{
+    int pipefd[2];
+    if (!AcquirePipe(pipefd))
+    {
+        spdlog::warn("proxy pipe2 failed errno={}", errno);
+        return -EIO;
+    }
+
+    int result;
+    for (;;)
+    {
+        int n = options.chained
+            ? SpliceChained(in, out, pipefd, options.chunk)
+            : SpliceKill(in, out, pipefd, options.chunk);
+        if (n > 0)
+        {
+            *bytes += static_cast<uint64_t>(n);
+            continue;
+        }
+
+        if (n == 0)
+        {
+            std::ignore = Shutdown(out, SHUT_WR);
+            result = 0;
+        }
+        else
+        {
+            result = n == -ECANCELED ? -ECANCELED : -EIO;
+        }
+        break;
+    }
+
+    // A chained relay sees a kill as the guard's shutdown, i.e. as EOF
+    //
+    if (ctx->IsKilled())
+    {
+        result = -ECANCELED;
+    }
+    if (result == -EIO)
+    {
+        std::ignore = Shutdown(in, SHUT_RDWR);
+        std::ignore = Shutdown(out, SHUT_RDWR);
+    }
+
+    ReleasePipe(pipefd, result == 0);
+    return result;
+}
+
+} // end anonymous namespace
+
+int Proxy(Descriptor& a, Descriptor& b, ProxyOptions const& options /* = {} */,
+    ProxyStats* stats /* = nullptr */)
+{
+    auto* ctx = Self();
+    ProxyStats local;
+    auto* counters = stats ? stats : &local;
+    *counters = {};
+
+    std::optional<ShutdownOnKillGuard> guardA, guardB;
+    if (options.chained)
+    {
+        guardA.emplace(ctx, a);
+        guardB.emplace(ctx, b);
+    }
+
+    // The child holds exit for its whole run; it starts running inside Spawn, so it has taken exit
+    // before the parent can wait on it
+    //
+    Coordinator exit;
+    Context::Handle child;
+    int childResult = 0;
+    bool spawned = ctx->GetCooperator()->Spawn([&](Context* relayCtx)
+    {
+        relayCtx->SetName("ProxyRelay");
+        exit.Acquire(relayCtx);
+        childResult = Relay(relayCtx, b, a, options, &counters->bToA);
+        exit.Release(relayCtx, false);
+    }, &child);
+    if (!spawned)
+    {
+        return ctx->IsKilled() ? -ECANCELED : -EIO;
+    }
+
+    int result = Relay(ctx, a, b, options, &counters->aToB);
+
+    // Join the child. A killed parent takes it down first; a chained child is woken by the guards
+    // instead, which have already shut both sockets.
+    //
+    if (result == -ECANCELED || CoordinateWithKill(ctx, &exit).Killed())
+    {
+        if (child && !options.chained)
+        {
+            child.Kill();
+        }
+        result = -ECANCELED;
+        exit.Acquire(ctx);
+    }
+    exit.Release(ctx, false);
+
+    SPDLOG_DEBUG("proxy done a={} b={} aToB={} bToA={} result={} childResult={}",
+        a.m_fd, b.m_fd, counters->aToB, counters->bToA, result, childResult);
+    return result != 0 ? result : childResult;
+}
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Descriptor;
+
+struct ProxyOptions
+{
+    // Most bytes moved per splice hop. Pooled pipes have the default 64KB capacity, which caps a
+    // hop regardless.
+    //
+    size_t chunk = 65536;
+
+    // Issue each hop as one linked chain (SpliceChained) instead of SpliceKill. A chain is not
+    // kill-aware, so kill then reaches the relays through a ShutdownOnKillGuard on both sockets.
+    //
+    bool chained = false;
+};
+
+// Bytes relayed in each direction. Updated as the relay runs, so the caller's copy can be read
+// from another context on the same cooperator while the proxy is live.
+//
+struct ProxyStats
+{
+    uint64_t aToB = 0;
+    uint64_t bToA = 0;
+};
+
+// Relay bytes both ways between two non-blocking sockets until both directions have closed -- a
+// zero-copy L4 byte pusher. Each direction splices through its own kernel pipe, so payload never
+// enters userspace; pipes come from a per-cooperator pool and go back to it when their direction
+// ends cleanly. a -> b runs on the calling context, b -> a on a child context it spawns and joins.
+//
+// EOF on one side is propagated as a half-close (Shutdown(SHUT_WR)) of the other, and the opposite
+// direction keeps flowing until it sees its own EOF. An error in either direction shuts both
+// sockets down, ending the other direction too.
+//
+// Returns 0 once both directions closed cleanly, -ECANCELED if the calling context was killed, or
+// -EIO if a splice failed. The descriptors stay open; closing them is the caller's.
+//
+int Proxy(Descriptor& a, Descriptor& b, ProxyOptions const& options = {},
+    ProxyStats* stats = nullptr);
+
+} // end namespace coop::io
+} // end namespace coop
@@ -1,15 +1,18 @@
 #include "read_file.h"
 
 #include <cerrno>
+#include <cstdint>
 #include <fcntl.h>
 
 #include <spdlog/spdlog.h>
 
 #include "coop/self.h"
 
+#include "chain.h"
 #include "descriptor.h"
 #include "open.h"
 #include "read.h"
+#include "uring.h"
 
 namespace coop
 {
@@ -17,21 +20,33 @@ namespace coop
 namespace io
 {
 
-int ReadFile(const char* path, void* buf, size_t bufSize)
+namespace
 {
-    int fd = Open(path, O_RDONLY);
-    if (fd < 0)
-    {
-        spdlog::error("readfile open failed path={} err={}", path, fd);
-        return fd;
-    }
 
-    auto* ring = GetUring();
-    Descriptor desc(fd, ring);
+// Read from the file position (the kernel's -1 offset), so chained reads pick up where the last
+// one stopped without knowing its length in advance
+//
+constexpr uint64_t kFilePosition = static_cast<uint64_t>(-1);
 
-    size_t total = 0;
+// Read on from total bytes already in buf until EOF, probing one byte past a full buffer to detect
+// overflow.
+//
+int ReadRest(Descriptor& desc, const char* path, void* buf, size_t bufSize, size_t total)
+{
     for (;;)
     {
+        if (total == bufSize)
+        {
+            char probe;
+            int probeResult = Read(desc, &probe, 1, total);
+            if (probeResult > 0)
+            {
+                spdlog::error("readfile overflow path={} bufSize={}", path, bufSize);
+                return -EOVERFLOW;
+            }
+            break;
+        }
+
         int result = Read(
             desc,
             static_cast<char*>(buf) + total,
@@ -41,7 +56,6 @@ int ReadFile(const char* path, void* buf, size_t bufSize)
         if (result < 0)
         {
             spdlog::error("readfile read failed path={} err={}", path, result);
-            desc.Close();
             return result;
         }
 
@@ -51,27 +65,91 @@ int ReadFile(const char* path, void* buf, size_t bufSize)
         }
 
         total += static_cast<size_t>(result);
-
-        // If the buffer is full, probe for one more byte to detect overflow
-        //
-        if (total == bufSize)
-        {
-            char probe;
-            int probeResult = Read(desc, &probe, 1, total);
-            if (probeResult > 0)
-            {
-                spdlog::error("readfile overflow path={} bufSize={}", path, bufSize);
-                desc.Close();
-                return -EOVERFLOW;
-            }
-            break;
-        }
     }
 
-    desc.Close();
     SPDLOG_DEBUG("readfile path={} bytes={}", path, total);
     return static_cast<int>(total);
 }
 
+int ReadFileLoop(const char* path, void* buf, size_t bufSize)
+{
+    int fd = Open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        spdlog::error("readfile open failed path={} err={}", path, fd);
+        return fd;
+    }
+
+    Descriptor desc(fd, GetUring());
+    int result = ReadRest(desc, path, buf, bufSize, 0);
+    desc.Close();
+    return result;
+}
+
+} // end anonymous namespace
+
+// With a free registered-file slot, the open, the read and the overflow probe go out as one linked
+// chain and the caller wakes once: the file is opened straight into the slot, read into buf, then
+// probed for one more byte. A file that fits in one read (the common case) is done at that point,
+// and the slot is cleared -- closing the file -- when `file` goes out of scope. A short first read
+// that is not EOF (a pipe, a file growing under us) resumes in the one-op-per-wake loop, as does
+// every read when no slot is free.
+//
+int ReadFile(const char* path, void* buf, size_t bufSize)
+{
+    auto* ring = GetUring();
+    int slot = ring->ReserveSlot();
+    if (slot < 0)
+    {
+        return ReadFileLoop(path, buf, bufSize);
+    }
+
+    Descriptor file(direct, slot, ring);
+    char probe;
+    int opened, result, probeResult;
+    {
+        Chain chain(Self(), ring);
+        OpenDirect(chain.Then(), path, O_RDONLY, 0, static_cast<unsigned>(slot));
+
+        // Hard link into the probe: a short read fails a soft link, and short is the usual case
+        //
+        Read(chain.Then(file, Link::Hard), buf, bufSize, kFilePosition);
+        Read(chain.Last(file), &probe, 1, kFilePosition);
+        chain.Wait();
+
+        opened = chain.Result(0);
+        result = chain.Result(1);
+        probeResult = chain.Result(2);
+    }
+
+    if (opened < 0)
+    {
+        spdlog::error("readfile open failed path={} err={}", path, opened);
+        return opened;
+    }
+    if (result < 0)
+    {
+        spdlog::error("readfile read failed path={} err={}", path, result);
+        return result;
+    }
+
+    size_t total = static_cast<size_t>(result);
+    if (probeResult <= 0)
+    {
+        // EOF, or nothing more we can learn from the probe: what the read returned is the file
+        //
+        SPDLOG_DEBUG("readfile path={} bytes={}", path, total);
+        return result;
+    }
+    if (total == bufSize)
+    {
+        spdlog::error("readfile overflow path={} bufSize={}", path, bufSize);
+        return -EOVERFLOW;
+    }
+
+    static_cast<char*>(buf)[total++] = probe;
+    return ReadRest(file, path, buf, bufSize, total);
+}
+
 } // end namespace coop::io
 } // end namespace coop
@@ -9,7 +9,8 @@ namespace io
 {
 
 // Read an entire file into a caller-provided buffer. Returns bytes read (>= 0) on success,
-// negative errno on error, or -EOVERFLOW if the file exceeds bufSize.
+// negative errno on error, or -EOVERFLOW if the file exceeds bufSize. Files of unbounded size are
+// streamed with FileReader instead.
 //
 int ReadFile(const char* path, void* buf, size_t bufSize);
 
@@ -44,6 +44,7 @@ static inline int TryRecv(int fd, void* buf, size_t size, int flags)
 //
 COOP_IO_IMPLEMENTATIONS(Recv, io_uring_prep_recv, RECV_ARGS)
 COOP_IO_IMPLEMENTATIONS_FASTPATH(RecvFastpath, io_uring_prep_recv, TryRecv, RECV_ARGS)
+COOP_IO_IMPLEMENTATIONS(RecvMsg, io_uring_prep_recvmsg, RECV_MSG_ARGS)
 
 } // end namespace coop::io
 } // end namespace coop
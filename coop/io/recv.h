@@ -2,6 +2,8 @@
 
 #include "coop/io/detail/op_macros.h"
 
+struct msghdr;
+
 namespace coop
 {
 
@@ -19,9 +21,18 @@ struct Handle;
 COOP_IO_DECLARATIONS(Recv, RECV_ARGS)
 COOP_IO_DECLARATIONS(RecvFastpath, RECV_ARGS)
 
+// RecvMsg is recvmsg(2) through io_uring: the source address and control messages (e.g. a UDP_GRO
+// segment size, see udp.h) come back in msg alongside the payload. msg and everything it points to
+// must stay valid until the op completes. For a stream of datagrams without an SQE per packet, see
+// ArmedHandle's multishot recvmsg mode.
+//
+#define RECV_MSG_ARGS(F) F(struct msghdr*, msg, ) F(int, flags, = 0)
+COOP_IO_DECLARATIONS(RecvMsg, RECV_MSG_ARGS)
+
 } // end namespace coop::io
 } // end namespace coop
 
 #ifndef COOP_IO_KEEP_ARGS
 #undef RECV_ARGS
+#undef RECV_MSG_ARGS
 #endif
@@ -8,13 +8,22 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cctype>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include <spdlog/spdlog.h>
 
+#include "coop/coordinate_with.h"
+#include "coop/coordinator.h"
+#include "coop/cooperator_var.h"
+#include "coop/cooperator_var.hpp"
 #include "coop/self.h"
+#include "coop/time/now.h"
+#include "coop/wait_group.h"
 
 #include "close.h"
 #include "connect.h"
@@ -30,7 +39,7 @@ namespace io
 {
 
 // -------------------------------------------------------------------------------------
-// Config state — lazily parsed on first Resolve4 call
+// Config state — lazily parsed on first lookup, once per process
 // -------------------------------------------------------------------------------------
 
 struct ResolvConfig
@@ -44,11 +53,14 @@ struct ResolvConfig
 struct HostsConfig
 {
     std::unordered_map<std::string, struct in_addr> entries;
+    std::unordered_map<std::string, struct in6_addr> entries6;
     bool loaded = false;
 };
 
-static ResolvConfig s_resolv;
-static HostsConfig  s_hosts;
+static ResolvConfig   s_resolv;
+static HostsConfig    s_hosts;
+static std::once_flag s_resolvOnce;
+static std::once_flag s_hostsOnce;
 
 // -------------------------------------------------------------------------------------
 // Config parsers
@@ -175,10 +187,10 @@ static void ParseHosts()
         *sep = '\0';
 
         struct in_addr addr;
-        if (inet_pton(AF_INET, ip, &addr) != 1)
+        struct in6_addr addr6;
+        bool v4 = inet_pton(AF_INET, ip, &addr) == 1;
+        if (!v4 && inet_pton(AF_INET6, ip, &addr6) != 1)
         {
-            // Could be IPv6 — skip
-            //
             line = nl ? nl + 1 : nullptr;
             continue;
         }
@@ -194,8 +206,17 @@ static void ParseHosts()
             char* end = tok;
             while (*end && *end != ' ' && *end != '\t' && *end != '#' && *end != '\r') end++;
 
+            // The first line naming a host wins, as in glibc
+            //
             std::string name(tok, end - tok);
-            s_hosts.entries[name] = addr;
+            if (v4)
+            {
+                s_hosts.entries.emplace(name, addr);
+            }
+            else
+            {
+                s_hosts.entries6.emplace(name, addr6);
+            }
             SPDLOG_DEBUG("resolve: hosts entry {} -> {}", name, ip);
 
             tok = end;
@@ -251,9 +272,15 @@ static int EncodeDnsName(const char* hostname, uint8_t* buf, int bufSize)
     return pos;
 }
 
-// Build a DNS A-record query. Returns total packet length, or 0 on error.
+static constexpr uint16_t DNS_TYPE_A     = 1;
+static constexpr uint16_t DNS_TYPE_CNAME = 5;
+static constexpr uint16_t DNS_TYPE_SOA   = 6;
+static constexpr uint16_t DNS_TYPE_AAAA  = 28;
+
+// Build a DNS query for one record type. Returns total packet length, or 0 on error.
 //
-static int BuildDnsQuery(const char* hostname, uint8_t* buf, int bufSize, uint16_t txnId)
+static int BuildDnsQuery(const char* hostname, uint8_t* buf, int bufSize, uint16_t txnId,
+                         uint16_t qtype)
 {
     if (bufSize < 12) return 0;
 
@@ -274,10 +301,8 @@ static int BuildDnsQuery(const char* hostname, uint8_t* buf, int bufSize, uint16
     int pos = 12 + nameLen;
     if (pos + 4 > bufSize) return 0;
 
-    // QTYPE = A (1)
-    //
-    buf[pos++] = 0x00;
-    buf[pos++] = 0x01;
+    buf[pos++] = qtype >> 8;
+    buf[pos++] = qtype & 0xFF;
 
     // QCLASS = IN (1)
     //
@@ -332,11 +357,33 @@ static int SkipDnsName(const uint8_t* pkt, int pktLen, int offset)
     return 0;
 }
 
-// Parse a DNS response and extract the first A record. Returns 0 on success, negative errno
-// on failure.
+// What one query found: up to MAX_ADDRESSES addresses of the queried type and the TTL to cache
+// them for, or a negative answer
+//
+static constexpr int      MAX_ADDRESSES = 8;
+static constexpr uint32_t NO_SOA_TTL    = UINT32_MAX;
+
+struct Answer
+{
+    int      error = 0;         // 0, or -ENOENT for NXDOMAIN / no record of the type
+    uint32_t ttl = 0;           // seconds; NO_SOA_TTL for a negative answer without an SOA
+    int      count = 0;
+    int      addrLen = 0;       // 4 or 16
+    uint8_t  addresses[MAX_ADDRESSES][16];
+};
+
+static uint32_t ReadU32(const uint8_t* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+// Parse a DNS response to a query of the given type. Returns 0 when the response settles the
+// lookup -- records found, or a negative answer -- with *answer filled in. Returns a negative
+// errno when it does not (a malformed or mismatched packet, SERVFAIL, REFUSED), and the lookup
+// goes on to the other nameservers.
 //
-static int ParseDnsResponse(const uint8_t* pkt, int pktLen, uint16_t expectedId,
-                            struct in_addr* result)
+static int ParseDnsResponse(const uint8_t* pkt, int pktLen, const uint8_t* query, int queryLen,
+                            uint16_t qtype, Answer* answer)
 {
     if (pktLen < 12)
     {
@@ -345,6 +392,7 @@ static int ParseDnsResponse(const uint8_t* pkt, int pktLen, uint16_t expectedId,
     }
 
     uint16_t id = (pkt[0] << 8) | pkt[1];
+    uint16_t expectedId = (query[0] << 8) | query[1];
     if (id != expectedId)
     {
         SPDLOG_DEBUG("resolve: id mismatch expected={} got={}", expectedId, id);
@@ -365,12 +413,7 @@ static int ParseDnsResponse(const uint8_t* pkt, int pktLen, uint16_t expectedId,
     // Check RCODE
     //
     int rcode = flags2 & 0x0F;
-    if (rcode == 3) // NXDOMAIN
-    {
-        SPDLOG_DEBUG("resolve: NXDOMAIN");
-        return -ENOENT;
-    }
-    if (rcode != 0)
+    if (rcode != 0 && rcode != 3) // 3 = NXDOMAIN
     {
         SPDLOG_DEBUG("resolve: DNS error rcode={}", rcode);
         return -EPROTO;
@@ -378,22 +421,26 @@ static int ParseDnsResponse(const uint8_t* pkt, int pktLen, uint16_t expectedId,
 
     uint16_t qdcount = (pkt[4] << 8) | pkt[5];
     uint16_t ancount = (pkt[6] << 8) | pkt[7];
+    uint16_t nscount = (pkt[8] << 8) | pkt[9];
 
-    // Skip question section
+    // The question must be ours, echoed: the cheap half of spoofing resistance, with the id
     //
-    int pos = 12;
-    for (int i = 0; i < qdcount; i++)
+    if (qdcount != 1 || pktLen < queryLen || memcmp(pkt + 12, query + 12, queryLen - 12) != 0)
     {
-        int nameLen = SkipDnsName(pkt, pktLen, pos);
-        if (nameLen == 0) return -EPROTO;
-        pos += nameLen;
-        pos += 4; // QTYPE + QCLASS
-        if (pos > pktLen) return -EPROTO;
+        SPDLOG_DEBUG("resolve: question mismatch");
+        return -EPROTO;
     }
+    int pos = queryLen;
 
-    // Walk answer RRs looking for the first A record
+    // Answers: the records of our type, and the TTL of every record on the way to them (a CNAME
+    // expiring first expires the lot). Then the authority section's SOA, for a negative TTL.
     //
-    for (int i = 0; i < ancount; i++)
+    const int addrLen = qtype == DNS_TYPE_AAAA ? 16 : 4;
+    uint32_t minTtl = UINT32_MAX;
+    uint32_t soaTtl = NO_SOA_TTL;
+    answer->count = 0;
+    answer->addrLen = addrLen;
+    for (int i = 0; i < ancount + nscount; i++)
     {
         int nameLen = SkipDnsName(pkt, pktLen, pos);
         if (nameLen == 0) return -EPROTO;
@@ -403,149 +450,594 @@ static int ParseDnsResponse(const uint8_t* pkt, int pktLen, uint16_t expectedId,
 
         uint16_t rrtype  = (pkt[pos] << 8) | pkt[pos + 1];
         uint16_t rrclass = (pkt[pos + 2] << 8) | pkt[pos + 3];
-        // TTL at pos+4..pos+7 (unused)
+        uint32_t ttl     = ReadU32(pkt + pos + 4);
         uint16_t rdlen   = (pkt[pos + 8] << 8) | pkt[pos + 9];
         pos += 10;
 
         if (pos + rdlen > pktLen) return -EPROTO;
 
-        if (rrtype == 1 && rrclass == 1 && rdlen == 4)
+        if (rrclass == 1 && i < ancount)
         {
-            // A record — copy the 4-byte IPv4 address
+            if (rrtype == qtype && rdlen == addrLen)
+            {
+                if (answer->count < MAX_ADDRESSES)
+                {
+                    memcpy(answer->addresses[answer->count++], pkt + pos, addrLen);
+                }
+                minTtl = std::min(minTtl, ttl);
+            }
+            else if (rrtype == DNS_TYPE_CNAME)
+            {
+                minTtl = std::min(minTtl, ttl);
+            }
+        }
+        else if (rrclass == 1 && rrtype == DNS_TYPE_SOA && rdlen >= 20)
+        {
+            // RFC 2308: the negative TTL is the lesser of the SOA's own TTL and its MINIMUM, the
+            // last field of the RDATA
             //
-            memcpy(result, pkt + pos, 4);
-            return 0;
+            soaTtl = std::min(ttl, ReadU32(pkt + pos + rdlen - 4));
         }
 
         pos += rdlen;
     }
 
-    SPDLOG_DEBUG("resolve: no A record in {} answers", ancount);
-    return -ENOENT;
+    if (answer->count > 0)
+    {
+        answer->error = 0;
+        answer->ttl = minTtl;
+        return 0;
+    }
+
+    SPDLOG_DEBUG("resolve: {} in {} answers", rcode == 3 ? "NXDOMAIN" : "no record", ancount);
+    answer->error = -ENOENT;
+    answer->ttl = soaTtl;
+    return 0;
 }
 
 // -------------------------------------------------------------------------------------
 // Transport
 // -------------------------------------------------------------------------------------
 
-static int DoResolve4(const char* hostname, struct in_addr* result, time::Interval timeout)
+static void LoadConfig()
 {
-    // Fast path: numeric address
-    //
-    if (inet_pton(AF_INET, hostname, result) == 1)
-    {
-        return 0;
-    }
+    std::call_once(s_resolvOnce, ParseResolvConf);
+}
 
-    // Check /etc/hosts
-    //
-    ParseHosts();
-    auto it = s_hosts.entries.find(hostname);
-    if (it != s_hosts.entries.end())
-    {
-        *result = it->second;
-        SPDLOG_DEBUG("resolve: {} found in /etc/hosts", hostname);
-        return 0;
-    }
+static time::Interval DefaultTimeout()
+{
+    LoadConfig();
+    return std::chrono::seconds(s_resolv.timeoutSec);
+}
 
-    // DNS query
-    //
-    ParseResolvConf();
+// Query every nameserver at once from one unconnected socket, and take the first response that
+// settles the lookup. A round waits until every server has answered unusably or the timeout
+// passes; up to `attempts` rounds are sent, with the same id, so a late response to an earlier
+// round still counts.
+//
+static int Query(const char* hostname, uint16_t qtype, time::Interval timeout, Answer* answer,
+                 uint64_t* rounds)
+{
+    LoadConfig();
 
-    // Build query packet
-    //
     uint16_t txnId = static_cast<uint16_t>(rand() & 0xFFFF);
     uint8_t query[512];
-    int queryLen = BuildDnsQuery(hostname, query, sizeof(query), txnId);
+    int queryLen = BuildDnsQuery(hostname, query, sizeof(query), txnId, qtype);
     if (queryLen == 0)
     {
         spdlog::warn("resolve: failed to build query for {}", hostname);
         return -EINVAL;
     }
 
-    // Try each nameserver
-    //
-    for (auto& ns : s_resolv.nameservers)
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
     {
-        for (int attempt = 0; attempt < s_resolv.attempts; attempt++)
-        {
-            int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
-            if (fd < 0)
-            {
-                spdlog::warn("resolve: socket() failed errno={}", errno);
-                return -errno;
-            }
-
-            auto* ring = GetUring();
-            Descriptor desc(fd, ring);
+        spdlog::warn("resolve: socket() failed errno={}", errno);
+        return -errno;
+    }
+    Descriptor desc(fd, GetUring());
 
-            // UDP connect just sets the destination address
-            //
-            int ret = Connect(desc, (struct sockaddr*)&ns, sizeof(ns));
+    auto& servers = s_resolv.nameservers;
+    const size_t n = std::min<size_t>(servers.size(), 64);
+    for (int attempt = 0; attempt < s_resolv.attempts; attempt++)
+    {
+        (*rounds)++;
+        uint64_t pending = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            struct iovec iov = { query, static_cast<size_t>(queryLen) };
+            struct msghdr msg = {};
+            msg.msg_name = &servers[i];
+            msg.msg_namelen = sizeof(servers[i]);
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            int ret = SendMsg(desc, &msg);
             if (ret < 0)
             {
-                SPDLOG_DEBUG("resolve: connect to nameserver failed ret={}", ret);
-                desc.Close();
+                SPDLOG_DEBUG("resolve: send to nameserver {} failed ret={}", i, ret);
                 continue;
             }
+            pending |= uint64_t(1) << i;
+        }
 
-            ret = Send(desc, query, queryLen);
-            if (ret < 0)
+        const int64_t deadline = time::MonotonicMicros() + timeout.count();
+        while (pending)
+        {
+            int64_t remaining = deadline - time::MonotonicMicros();
+            if (remaining <= 0)
             {
-                SPDLOG_DEBUG("resolve: send failed ret={}", ret);
-                desc.Close();
-                continue;
+                break;
             }
 
             uint8_t response[512];
-            ret = Recv(desc, response, sizeof(response), 0, timeout);
-            desc.Close();
-
+            struct sockaddr_in from = {};
+            struct iovec iov = { response, sizeof(response) };
+            struct msghdr msg = {};
+            msg.msg_name = &from;
+            msg.msg_namelen = sizeof(from);
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            int ret = RecvMsg(desc, &msg, 0, time::Interval(remaining));
             if (ret == -ETIMEDOUT)
             {
-                SPDLOG_DEBUG("resolve: timeout from nameserver, attempt {}", attempt + 1);
-                continue;
+                SPDLOG_DEBUG("resolve: timeout from nameservers, attempt {}", attempt + 1);
+                break;
             }
-
             if (ret < 0)
             {
                 SPDLOG_DEBUG("resolve: recv failed ret={}", ret);
+                break;
+            }
+
+            // Only a reply from a server this round is waiting on counts
+            //
+            size_t i = 0;
+            while (i < n && (servers[i].sin_addr.s_addr != from.sin_addr.s_addr ||
+                             servers[i].sin_port != from.sin_port))
+            {
+                i++;
+            }
+            if (i == n)
+            {
+                SPDLOG_DEBUG("resolve: response from a stranger, dropped");
                 continue;
             }
 
-            int parseRet = ParseDnsResponse(response, ret, txnId, result);
+            int parseRet = ParseDnsResponse(response, ret, query, queryLen, qtype, answer);
             if (parseRet == 0)
             {
-                char ipStr[INET_ADDRSTRLEN];
-                inet_ntop(AF_INET, result, ipStr, sizeof(ipStr));
-                SPDLOG_DEBUG("resolve: {} -> {}", hostname, ipStr);
+                desc.Close();
                 return 0;
             }
+            SPDLOG_DEBUG("resolve: nameserver {} unusable ret={}", i, parseRet);
+            pending &= ~(uint64_t(1) << i);
+        }
+    }
+    desc.Close();
 
-            // NXDOMAIN is authoritative — don't retry other nameservers
-            //
-            if (parseRet == -ENOENT)
+    spdlog::warn("resolve: all nameservers exhausted for {}", hostname);
+    return -ETIMEDOUT;
+}
+
+// -------------------------------------------------------------------------------------
+// Per-cooperator cache and single-flight
+// -------------------------------------------------------------------------------------
+
+namespace
+{
+
+// One query in flight. The context running it holds `done` and releases it with the answer in
+// place; each waiter acquires it in turn, copies the answer and releases it to the next. The
+// last of them out frees it.
+//
+struct Flight
+{
+    explicit Flight(Context* ctx) : done(ctx) {}
+
+    Coordinator done;
+    Answer      answer;
+    int         result = -ETIMEDOUT;
+    int         refs = 1;
+};
+
+struct Entry
+{
+    Answer  answer;
+    int64_t expires;            // NowCoarse microseconds
+};
+
+struct ResolverCache
+{
+    ResolverOptions                             options;
+    std::unordered_map<std::string, Entry>      entries;
+    std::unordered_map<std::string, Flight*>    inflight;
+    ResolverStats                               stats = {};
+
+    void Insert(std::string const& key, Answer const& answer, int64_t now)
+    {
+        int64_t ttl;
+        if (answer.error == 0)
+        {
+            ttl = std::min<int64_t>(int64_t(answer.ttl) * 1000000, options.maxTtl.count());
+        }
+        else if (answer.ttl == NO_SOA_TTL)
+        {
+            ttl = options.defaultNegativeTtl.count();
+        }
+        else
+        {
+            ttl = std::min<int64_t>(int64_t(answer.ttl) * 1000000,
+                                    options.maxNegativeTtl.count());
+        }
+        if (ttl <= 0)
+        {
+            return;
+        }
+
+        if (entries.size() >= options.maxEntries && !entries.count(key))
+        {
+            for (auto it = entries.begin(); it != entries.end();)
+            {
+                it = it->second.expires <= now ? entries.erase(it) : std::next(it);
+            }
+            if (entries.size() >= options.maxEntries)
             {
-                return parseRet;
+                entries.clear();
             }
+        }
+        entries[key] = Entry{answer, now + ttl};
+    }
+};
 
-            SPDLOG_DEBUG("resolve: parse error ret={}, retrying", parseRet);
+CooperatorVar<ResolverCache> s_cache;
+
+// Names compare case-insensitively and with or without the root's trailing dot
+//
+std::string CacheKey(const char* hostname, uint16_t qtype)
+{
+    std::string key(hostname);
+    while (!key.empty() && key.back() == '.')
+    {
+        key.pop_back();
+    }
+    std::transform(key.begin(), key.end(), key.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    key += qtype == DNS_TYPE_AAAA ? "|6" : "|4";
+    return key;
+}
+
+// Resolve one name and type through the cache. Returns the answer's error (0 or -ENOENT), or the
+// query's.
+//
+int Lookup(const char* hostname, uint16_t qtype, time::Interval timeout, Answer* out)
+{
+    auto& cache = *s_cache;
+    if (!cache.options.cache)
+    {
+        cache.stats.misses++;
+        int ret = Query(hostname, qtype, timeout, out, &cache.stats.queries);
+        return ret == 0 ? out->error : ret;
+    }
+
+    std::string key = CacheKey(hostname, qtype);
+    const int64_t now = time::NowCoarse();
+    auto it = cache.entries.find(key);
+    if (it != cache.entries.end())
+    {
+        if (now < it->second.expires)
+        {
+            cache.stats.hits++;
+            *out = it->second.answer;
+            return out->error;
         }
+        cache.entries.erase(it);
     }
 
-    spdlog::warn("resolve: all nameservers exhausted for {}", hostname);
-    return -ETIMEDOUT;
+    auto* ctx = Self();
+    auto fit = cache.inflight.find(key);
+    if (fit != cache.inflight.end())
+    {
+        // Wait out the query in flight for as long as one of our own could have taken
+        //
+        Flight* flight = fit->second;
+        flight->refs++;
+        cache.stats.coalesced++;
+
+        LoadConfig();
+        int ret;
+        auto result = CoordinateWith(ctx, &flight->done, timeout * s_resolv.attempts);
+        if (result.TimedOut())
+        {
+            ret = -ETIMEDOUT;
+        }
+        else
+        {
+            flight->done.Release(ctx, false);
+            ret = flight->result;
+            if (ret == 0)
+            {
+                *out = flight->answer;
+                ret = out->error;
+            }
+        }
+        if (--flight->refs == 0)
+        {
+            delete flight;
+        }
+        return ret;
+    }
+
+    cache.stats.misses++;
+    Flight* flight = new Flight(ctx);
+    cache.inflight.emplace(key, flight);
+    flight->result = Query(hostname, qtype, timeout, &flight->answer, &cache.stats.queries);
+    cache.inflight.erase(key);
+
+    int ret = flight->result;
+    if (ret == 0)
+    {
+        cache.Insert(key, flight->answer, time::NowCoarse());
+        *out = flight->answer;
+        ret = out->error;
+    }
+    flight->done.Release(ctx, false);
+    if (--flight->refs == 0)
+    {
+        delete flight;
+    }
+    return ret;
+}
+
+} // end anonymous namespace
+
+// -------------------------------------------------------------------------------------
+// Public API
+// -------------------------------------------------------------------------------------
+
+int Resolve4(const char* hostname, struct in_addr* result, time::Interval timeout)
+{
+    // Fast path: numeric address
+    //
+    if (inet_pton(AF_INET, hostname, result) == 1)
+    {
+        return 0;
+    }
+
+    std::call_once(s_hostsOnce, ParseHosts);
+    auto it = s_hosts.entries.find(hostname);
+    if (it != s_hosts.entries.end())
+    {
+        *result = it->second;
+        SPDLOG_DEBUG("resolve: {} found in /etc/hosts", hostname);
+        return 0;
+    }
+
+    Answer answer;
+    int ret = Lookup(hostname, DNS_TYPE_A, timeout, &answer);
+    if (ret == 0)
+    {
+        memcpy(result, answer.addresses[0], sizeof(*result));
+    }
+    return ret;
 }
 
 int Resolve4(const char* hostname, struct in_addr* result)
 {
-    auto timeout = std::chrono::seconds(s_resolv.loaded ? s_resolv.timeoutSec : 5);
-    return DoResolve4(hostname, result, std::chrono::duration_cast<time::Interval>(timeout));
+    return Resolve4(hostname, result, DefaultTimeout());
 }
 
-int Resolve4(const char* hostname, struct in_addr* result, time::Interval timeout)
+int Resolve6(const char* hostname, struct in6_addr* result, time::Interval timeout)
+{
+    if (inet_pton(AF_INET6, hostname, result) == 1)
+    {
+        return 0;
+    }
+
+    std::call_once(s_hostsOnce, ParseHosts);
+    auto it = s_hosts.entries6.find(hostname);
+    if (it != s_hosts.entries6.end())
+    {
+        *result = it->second;
+        SPDLOG_DEBUG("resolve: {} found in /etc/hosts", hostname);
+        return 0;
+    }
+
+    Answer answer;
+    int ret = Lookup(hostname, DNS_TYPE_AAAA, timeout, &answer);
+    if (ret == 0)
+    {
+        memcpy(result, answer.addresses[0], sizeof(*result));
+    }
+    return ret;
+}
+
+int Resolve6(const char* hostname, struct in6_addr* result)
+{
+    return Resolve6(hostname, result, DefaultTimeout());
+}
+
+int Resolve(const char* hostname, int port, struct sockaddr_storage* result,
+            socklen_t* resultLen, int family, time::Interval timeout)
+{
+    memset(result, 0, sizeof(*result));
+
+    // A numeric IPv6 address is never looked up as a name
+    //
+    struct in6_addr literal6;
+    if (family != AF_INET && inet_pton(AF_INET6, hostname, &literal6) == 1)
+    {
+        auto* sin6 = reinterpret_cast<struct sockaddr_in6*>(result);
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = htons(port);
+        sin6->sin6_addr = literal6;
+        *resultLen = sizeof(*sin6);
+        return 0;
+    }
+
+    int ret = -ENOENT;
+    if (family == AF_INET || family == AF_UNSPEC)
+    {
+        auto* sin = reinterpret_cast<struct sockaddr_in*>(result);
+        ret = Resolve4(hostname, &sin->sin_addr, timeout);
+        if (ret == 0)
+        {
+            sin->sin_family = AF_INET;
+            sin->sin_port = htons(port);
+            *resultLen = sizeof(*sin);
+            return 0;
+        }
+    }
+
+    // Only a name with no IPv4 address falls through: a timeout would only time out again
+    //
+    if (family == AF_INET6 || (family == AF_UNSPEC && ret == -ENOENT))
+    {
+        auto* sin6 = reinterpret_cast<struct sockaddr_in6*>(result);
+        ret = Resolve6(hostname, &sin6->sin6_addr, timeout);
+        if (ret == 0)
+        {
+            sin6->sin6_family = AF_INET6;
+            sin6->sin6_port = htons(port);
+            *resultLen = sizeof(*sin6);
+            return 0;
+        }
+    }
+    return ret;
+}
+
+int Resolve(const char* hostname, int port, struct sockaddr_storage* result,
+            socklen_t* resultLen, int family /* = AF_UNSPEC */)
+{
+    return Resolve(hostname, port, result, resultLen, family, DefaultTimeout());
+}
+
+namespace
+{
+
+// One family's addresses for ResolveAll: a literal, /etc/hosts, or the cache
+//
+int Gather(const char* hostname, int family, time::Interval timeout,
+           std::vector<struct sockaddr_storage>& out, int port)
+{
+    struct sockaddr_storage ss = {};
+    if (family == AF_INET)
+    {
+        auto* sin = reinterpret_cast<struct sockaddr_in*>(&ss);
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons(port);
+
+        std::call_once(s_hostsOnce, ParseHosts);
+        auto it = s_hosts.entries.find(hostname);
+        if (inet_pton(AF_INET, hostname, &sin->sin_addr) == 1 || it != s_hosts.entries.end())
+        {
+            if (it != s_hosts.entries.end()) sin->sin_addr = it->second;
+            out.push_back(ss);
+            return 0;
+        }
+
+        Answer answer;
+        int ret = Lookup(hostname, DNS_TYPE_A, timeout, &answer);
+        for (int i = 0; ret == 0 && i < answer.count; i++)
+        {
+            memcpy(&sin->sin_addr, answer.addresses[i], 4);
+            out.push_back(ss);
+        }
+        return ret;
+    }
+
+    auto* sin6 = reinterpret_cast<struct sockaddr_in6*>(&ss);
+    sin6->sin6_family = AF_INET6;
+    sin6->sin6_port = htons(port);
+
+    std::call_once(s_hostsOnce, ParseHosts);
+    auto it = s_hosts.entries6.find(hostname);
+    if (inet_pton(AF_INET6, hostname, &sin6->sin6_addr) == 1 || it != s_hosts.entries6.end())
+    {
+        if (it != s_hosts.entries6.end()) sin6->sin6_addr = it->second;
+        out.push_back(ss);
+        return 0;
+    }
+
+    Answer answer;
+    int ret = Lookup(hostname, DNS_TYPE_AAAA, timeout, &answer);
+    for (int i = 0; ret == 0 && i < answer.count; i++)
+    {
+        memcpy(&sin6->sin6_addr, answer.addresses[i], 16);
+        out.push_back(ss);
+    }
+    return ret;
+}
+
+} // end anonymous namespace
+
+int ResolveAll(const char* hostname, int port, struct sockaddr_storage* results,
+               size_t maxResults, int family, time::Interval timeout)
+{
+    std::vector<struct sockaddr_storage> v4, v6;
+    int ret4 = -ENOENT, ret6 = -ENOENT;
+
+    // A literal of one family is no name in the other: skip the lookup that would ask for it
+    //
+    struct in6_addr literal6;
+    struct in_addr literal4;
+    bool isLiteral6 = inet_pton(AF_INET6, hostname, &literal6) == 1;
+    bool isLiteral4 = inet_pton(AF_INET, hostname, &literal4) == 1;
+
+    if (family == AF_UNSPEC && !isLiteral4 && !isLiteral6)
+    {
+        // The A lookup in a child, the AAAA lookup here: one round trip for both
+        //
+        WaitGroup lookups;
+        lookups.Spawn([&](Context*) { ret4 = Gather(hostname, AF_INET, timeout, v4, port); });
+        ret6 = Gather(hostname, AF_INET6, timeout, v6, port);
+        lookups.Wait(Self());
+    }
+    else
+    {
+        if ((family == AF_INET || family == AF_UNSPEC) && !isLiteral6)
+        {
+            ret4 = Gather(hostname, AF_INET, timeout, v4, port);
+        }
+        if ((family == AF_INET6 || family == AF_UNSPEC) && !isLiteral4)
+        {
+            ret6 = Gather(hostname, AF_INET6, timeout, v6, port);
+        }
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; count < maxResults && (i < v4.size() || i < v6.size()); i++)
+    {
+        if (i < v6.size()) results[count++] = v6[i];
+        if (i < v4.size() && count < maxResults) results[count++] = v4[i];
+    }
+    if (count > 0)
+    {
+        return static_cast<int>(count);
+    }
+    return ret4 != -ENOENT ? ret4 : ret6;
+}
+
+int ResolveAll(const char* hostname, int port, struct sockaddr_storage* results,
+               size_t maxResults, int family /* = AF_UNSPEC */)
+{
+    return ResolveAll(hostname, port, results, maxResults, family, DefaultTimeout());
+}
+
+void ConfigureResolver(ResolverOptions const& options)
+{
+    s_cache->options = options;
+}
+
+void FlushResolverCache()
+{
+    s_cache->entries.clear();
+}
+
+ResolverStats GetResolverStats()
 {
-    return DoResolve4(hostname, result, timeout);
+    ResolverStats stats = s_cache->stats;
+    stats.entries = s_cache->entries.size();
+    return stats;
 }
 
 } // end namespace coop::io
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <netinet/in.h>
+#include <sys/socket.h>
 
 #include "coop/time/interval.h"
 
@@ -20,5 +23,81 @@ namespace io
 int Resolve4(const char* hostname, struct in_addr* result);
 int Resolve4(const char* hostname, struct in_addr* result, time::Interval timeout);
 
+// The same for an IPv6 address, from AAAA records (and /etc/hosts' IPv6 lines)
+//
+int Resolve6(const char* hostname, struct in6_addr* result);
+int Resolve6(const char* hostname, struct in6_addr* result, time::Interval timeout);
+
+// Resolve to a socket address with the given port, ready for Connect. family is AF_INET or
+// AF_INET6 for that family only, or AF_UNSPEC for either: IPv4 if the name has an address for
+// it, else IPv6, so an IPv4-only host never waits on an AAAA lookup. *resultLen is set to the
+// address's size.
+//
+int Resolve(const char* hostname, int port, struct sockaddr_storage* result,
+            socklen_t* resultLen, int family = AF_UNSPEC);
+int Resolve(const char* hostname, int port, struct sockaddr_storage* result,
+            socklen_t* resultLen, int family, time::Interval timeout);
+
+// Every address of a name, up to maxResults, as socket addresses with the given port, ordered for
+// connection racing (RFC 8305 section 4): families interleaved, IPv6 first. With AF_UNSPEC the
+// A and AAAA lookups run side by side. Returns the number of addresses (at least one), or a
+// negative errno: -ENOENT when neither family has an address, else the other lookup's error.
+//
+int ResolveAll(const char* hostname, int port, struct sockaddr_storage* results,
+               size_t maxResults, int family = AF_UNSPEC);
+int ResolveAll(const char* hostname, int port, struct sockaddr_storage* results,
+               size_t maxResults, int family, time::Interval timeout);
+
+// DNS answers are cached per cooperator, for their TTL: a positive answer for the smallest TTL
+// among its records (CNAMEs included), a failed name (NXDOMAIN, or no record of the type) for
+// the negative TTL its SOA gives (RFC 2308). Lookups are single-flight: while one context queries
+// a name, others asking for it on the same cooperator block on that query's Coordinator and
+// share its answer. A query goes to every nameserver in /etc/resolv.conf at once, and the first
+// usable answer wins; a server's SERVFAIL or REFUSED is only that server's, and the round waits
+// on the rest. Timeouts and transport errors are not cached. /etc/hosts and numeric addresses
+// skip the cache.
+//
+struct ResolverOptions
+{
+    // Off: every lookup queries, and none are coalesced
+    //
+    bool cache = true;
+
+    // TTL caps. A zero TTL is honored (the answer serves the lookups waiting on it, then goes).
+    //
+    time::Interval maxTtl = std::chrono::hours(1);
+    time::Interval maxNegativeTtl = std::chrono::minutes(5);
+
+    // For a negative answer without an SOA to take a TTL from
+    //
+    time::Interval defaultNegativeTtl = std::chrono::seconds(30);
+
+    // Entries per cooperator. An insert past it sweeps expired entries, and clears the cache if
+    // that frees nothing.
+    //
+    size_t maxEntries = 4096;
+};
+
+// Replace the calling cooperator's resolver options. Entries already cached keep their expiry.
+//
+void ConfigureResolver(ResolverOptions const& options);
+
+// Drop every entry in the calling cooperator's cache. Lookups in flight are unaffected.
+//
+void FlushResolverCache();
+
+struct ResolverStats
+{
+    uint64_t hits;          // answered from the cache, positive or negative
+    uint64_t misses;        // started a query
+    uint64_t coalesced;     // waited on another context's query
+    uint64_t queries;       // query rounds sent, retries included
+    size_t   entries;       // cached now
+};
+
+// The calling cooperator's counters
+//
+ResolverStats GetResolverStats();
+
 } // end namespace coop::io
 } // end namespace coop
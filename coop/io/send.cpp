@@ -9,6 +9,7 @@
 #include "coop/coordinator.h"
 #include "coop/self.h"
 
+#include "cork.h"
 #include "descriptor.h"
 #include "handle.h"
 #include "uring.h"
@@ -29,11 +30,94 @@ static inline int TrySend(int fd, const void* buf, size_t size, int flags)
     return (int)syscall(SYS_sendto, fd, buf, size, flags | MSG_DONTWAIT, nullptr, (socklen_t)0);
 }
 
+// An untimed blocking send on a corked descriptor goes into the Cork's buffer (see cork.h). Flags
+// beyond MSG_MORE, which the buffer already means, ask for something it does not do: those flush
+// it and send as usual. Returns whether the cork took the send, with its result in `result`.
+//
+static inline bool Corked(Descriptor& desc, const void* buf, size_t size, int flags, int* result)
+{
+    if (!desc.m_cork)
+    {
+        return false;
+    }
+    if ((flags & ~MSG_MORE) == 0)
+    {
+        *result = desc.m_cork->Send(buf, size);
+        return true;
+    }
+    *result = desc.m_cork->Flush();
+    return *result < 0;
+}
+
 // Send submits straight to io_uring; SendFastpath tries a nonblocking send() first (a win when the
-// socket is usually writable, which is the common case for responses). See send.h.
+// socket is usually writable, which is the common case for responses). See send.h. Their untimed
+// blocking forms are spelled out for the cork; the rest come from the macros.
 //
-COOP_IO_IMPLEMENTATIONS(Send, io_uring_prep_send, SEND_ARGS)
-COOP_IO_IMPLEMENTATIONS_FASTPATH(SendFastpath, io_uring_prep_send, TrySend, SEND_ARGS)
+COOP_IO_ASYNC_IMPL(Send, io_uring_prep_send, SEND_ARGS)
+COOP_IO_ASYNC_TIMEOUT_IMPL(Send, io_uring_prep_send, SEND_ARGS)
+COOP_IO_ASYNC_COARSE_IMPL(Send, io_uring_prep_send, SEND_ARGS)
+COOP_IO_BLOCKING_TIMEOUT_IMPL(Send, SEND_ARGS, time::Interval)
+COOP_IO_BLOCKING_TIMEOUT_IMPL(Send, SEND_ARGS, CoarseTimeout)
+COOP_IO_BLOCKING_KILL_IMPL(Send, SEND_ARGS)
+COOP_IO_BLOCKING_TIMEOUT_KILL_IMPL(Send, SEND_ARGS, time::Interval)
+COOP_IO_BLOCKING_TIMEOUT_KILL_IMPL(Send, SEND_ARGS, CoarseTimeout)
+
+int Send(Descriptor& desc, const void* buf, size_t size, int flags /* = 0 */)
+{
+    int result;
+    if (Corked(desc, buf, size, flags, &result))
+    {
+        return result;
+    }
+
+    detail::BlockingHandle blocking(Self(), desc);
+    Handle& handle = blocking.Get();
+    if (!Send(handle, buf, size, flags))
+    {
+        return -EAGAIN;
+    }
+    result = handle.Wait();
+    return handle.TimedOut() ? -ETIMEDOUT : result;
+}
+
+COOP_IO_ASYNC_IMPL(SendFastpath, io_uring_prep_send, SEND_ARGS)
+COOP_IO_ASYNC_TIMEOUT_IMPL(SendFastpath, io_uring_prep_send, SEND_ARGS)
+COOP_IO_ASYNC_COARSE_IMPL(SendFastpath, io_uring_prep_send, SEND_ARGS)
+COOP_IO_BLOCKING_TIMEOUT_FASTPATH_IMPL(SendFastpath, TrySend, SEND_ARGS, time::Interval)
+COOP_IO_BLOCKING_TIMEOUT_FASTPATH_IMPL(SendFastpath, TrySend, SEND_ARGS, CoarseTimeout)
+COOP_IO_BLOCKING_FASTPATH_KILL_IMPL(SendFastpath, TrySend, SEND_ARGS)
+COOP_IO_BLOCKING_TIMEOUT_FASTPATH_KILL_IMPL(SendFastpath, TrySend, SEND_ARGS, time::Interval)
+COOP_IO_BLOCKING_TIMEOUT_FASTPATH_KILL_IMPL(SendFastpath, TrySend, SEND_ARGS, CoarseTimeout)
+
+int SendFastpath(Descriptor& desc, const void* buf, size_t size, int flags /* = 0 */)
+{
+    int result;
+    if (Corked(desc, buf, size, flags, &result))
+    {
+        return result;
+    }
+
+    result = TrySend(desc.m_fd, buf, size, flags);
+    if (result >= 0) return result;
+    if (errno != EAGAIN && errno != EWOULDBLOCK) return -errno;
+
+    detail::BlockingHandle blocking(Self(), desc);
+    Handle& handle = blocking.Get();
+    if (!SendFastpath(handle, buf, size, flags))
+    {
+        return -EAGAIN;
+    }
+    result = handle.Wait();
+    return handle.TimedOut() ? -ETIMEDOUT : result;
+}
+
+static inline void PrepSendZc(io_uring_sqe* sqe, int fd, const void* buf, size_t size, int flags)
+{
+    io_uring_prep_send_zc(sqe, fd, buf, size, flags, 0);
+}
+
+COOP_IO_IMPLEMENTATIONS(SendZc, PrepSendZc, SEND_ARGS)
+COOP_IO_IMPLEMENTATIONS(SendMsg, io_uring_prep_sendmsg, SEND_MSG_ARGS)
 
 int SendAll(Descriptor& desc, const void* buf, size_t size, int flags /* = 0 */)
 {
@@ -65,5 +149,25 @@ int SendAllFastpath(Descriptor& desc, const void* buf, size_t size, int flags /*
     return (int)size;
 }
 
+int SendAllZc(Descriptor& desc, const void* buf, size_t size, int flags /* = 0 */)
+{
+    if (!desc.m_ring->SupportsSendZc())
+    {
+        return SendAll(desc, buf, size, flags);
+    }
+
+    size_t offset = 0;
+    while (offset < size)
+    {
+        int sent = SendZc(desc, (const char*)buf + offset, size - offset, flags);
+        if (sent <= 0)
+        {
+            return sent;
+        }
+        offset += sent;
+    }
+    return (int)size;
+}
+
 } // end namespace coop::io
 } // end namespace coop
@@ -2,6 +2,8 @@
 
 #include "coop/io/detail/op_macros.h"
 
+struct msghdr;
+
 namespace coop
 {
 
@@ -20,14 +22,34 @@ struct Handle;
 COOP_IO_DECLARATIONS(Send, SEND_ARGS)
 COOP_IO_DECLARATIONS(SendFastpath, SEND_ARGS)
 
+// SendZc is IORING_OP_SEND_ZC: the kernel transmits straight from buf instead of copying it into
+// socket buffers, and the op completes -- the Handle's coordinator releases, Wait() returns --
+// only once the kernel's zero-copy notification says it no longer references buf. For TCP that is
+// when the peer has acknowledged the data, so it trades a round trip of latency for the copy; worth
+// it for large, fully formed bodies, not for small responses. Needs kernel 6.0+
+// (Uring::SupportsSendZc); older kernels fail it with -EINVAL.
+//
+COOP_IO_DECLARATIONS(SendZc, SEND_ARGS)
+
+// SendMsg is sendmsg(2) through io_uring: a destination address and control messages ride along
+// with the iovecs. On UDP a UDP_SEGMENT control message (udp.h) makes one SendMsg a GSO train of
+// equal-sized datagrams, segmented by the kernel or the NIC -- one SQE for up to 64 packets. msg
+// and everything it points to must stay valid until the op completes.
+//
+#define SEND_MSG_ARGS(F) F(const struct msghdr*, msg, ) F(int, flags, = 0)
+COOP_IO_DECLARATIONS(SendMsg, SEND_MSG_ARGS)
+
 // SendAll loops until the whole buffer is written. SendAllFastpath does the same over SendFastpath.
+// SendAllZc does it over SendZc, or over Send where the ring lacks SEND_ZC.
 //
 int SendAll(Descriptor& desc, const void* buf, size_t size, int flags = 0);
 int SendAllFastpath(Descriptor& desc, const void* buf, size_t size, int flags = 0);
+int SendAllZc(Descriptor& desc, const void* buf, size_t size, int flags = 0);
 
 } // end namespace coop::io
 } // end namespace coop
 
 #ifndef COOP_IO_KEEP_ARGS
 #undef SEND_ARGS
+#undef SEND_MSG_ARGS
 #endif
@@ -55,7 +55,7 @@ ShutdownOnKillGuard::~ShutdownOnKillGuard()
 
     while (!m_done)
     {
-        m_owner->Yield(true);
+        m_owner->Yield();
     }
 }
 
@@ -0,0 +1,45 @@
+#define COOP_IO_KEEP_ARGS
+#include "socket.h"
+
+#include <cerrno>
+#include <fcntl.h>
+
+#include "coop/coordinator.h"
+#include "coop/self.h"
+
+#include "descriptor.h"
+#include "handle.h"
+#include "uring.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+// The ring-level macros lead with a dirfd, which a socket has no use for
+//
+static inline void PrepSocket(struct io_uring_sqe* sqe, int, int domain, int type, int protocol)
+{
+    io_uring_prep_socket(sqe, domain, type, protocol, 0);
+}
+
+static inline void PrepSocketDirect(struct io_uring_sqe* sqe, int, int domain, int type,
+    int protocol)
+{
+    io_uring_prep_socket_direct_alloc(sqe, domain, type, protocol, 0);
+}
+
+static inline void PrepSetSockOpt(struct io_uring_sqe* sqe, int fd, int level, int optname,
+    const void* optval, socklen_t optlen)
+{
+    io_uring_prep_cmd_sock(sqe, SOCKET_URING_OP_SETSOCKOPT, fd, level, optname,
+                           const_cast<void*>(optval), int(optlen));
+}
+
+COOP_IO_URING_IMPLEMENTATIONS(Socket, PrepSocket, SOCKET_ARGS)
+COOP_IO_URING_IMPLEMENTATIONS(SocketDirect, PrepSocketDirect, SOCKET_DIRECT_ARGS)
+COOP_IO_IMPLEMENTATIONS(SetSockOpt, PrepSetSockOpt, SET_SOCK_OPT_ARGS)
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <sys/socket.h>
+
+#include "coop/io/detail/op_macros.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Handle;
+
+// Create a socket through the ring (IORING_OP_SOCKET, kernel 5.19+) instead of the socket syscall.
+// Returns an ordinary fd, or a negative errno -- -EINVAL on a kernel without the opcode, which
+// Uring::SupportsSocket reports ahead of time.
+//
+#define SOCKET_ARGS(F) F(int, domain, ) F(int, type, ) F(int, protocol, = 0)
+COOP_IO_URING_DECLARATIONS(Socket, SOCKET_ARGS)
+
+// Create a socket straight into the ring's direct range (io_uring_prep_socket_direct_alloc,
+// kernel 5.19+): the kernel picks a free slot of UringConfiguration::directSlots and no process fd
+// is created. Returns the slot, to adopt with Descriptor(direct, slot) and Connect through, or a
+// negative errno (-ENFILE once the range is full). Options that need setsockopt need a real fd.
+//
+#define SOCKET_DIRECT_ARGS(F) F(int, domain, ) F(int, type, ) F(int, protocol, = 0)
+COOP_IO_URING_DECLARATIONS(SocketDirect, SOCKET_DIRECT_ARGS)
+
+// setsockopt through the ring: a SOCKET_URING_OP_SETSOCKOPT uring_cmd (kernel 6.7+, see
+// Uring::SupportsSocketCommands). It reaches registered and direct descriptors too, which the
+// syscall cannot, and chains (chain.h) ahead of a connect. optval must outlive the operation.
+//
+#define SET_SOCK_OPT_ARGS(F) \
+    F(int, level, ) F(int, optname, ) F(const void*, optval, ) F(socklen_t, optlen, )
+COOP_IO_DECLARATIONS(SetSockOpt, SET_SOCK_OPT_ARGS)
+
+} // end namespace coop::io
+} // end namespace coop
+
+#ifndef COOP_IO_KEEP_ARGS
+#undef SOCKET_ARGS
+#undef SOCKET_DIRECT_ARGS
+#undef SET_SOCK_OPT_ARGS
+#endif
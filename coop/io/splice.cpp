@@ -1,12 +1,26 @@
+#define COOP_IO_KEEP_ARGS
 #include "splice.h"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <cerrno>
 #include <fcntl.h>
 #include <poll.h>
+#include <unistd.h>
+#include <vector>
 #include <spdlog/spdlog.h>
 
+#include "coop/coordinator.h"
+#include "coop/cooperator_var.h"
+#include "coop/cooperator_var.hpp"
+#include "coop/self.h"
+
+#include "chain.h"
 #include "descriptor.h"
+#include "handle.h"
 #include "poll.h"
+#include "uring.h"
 
 namespace coop
 {
@@ -14,6 +28,14 @@ namespace coop
 namespace io
 {
 
+static void PrepSpliceFrom(struct io_uring_sqe* sqe, int fdOut, int fdIn, size_t len,
+    unsigned flags)
+{
+    io_uring_prep_splice(sqe, fdIn, -1, fdOut, -1, len, flags);
+}
+
+COOP_IO_IMPLEMENTATIONS(SpliceFrom, PrepSpliceFrom, SPLICE_FROM_ARGS)
+
 static int WaitForSpliceReady(Descriptor& desc, unsigned mask, bool killAware)
 {
     if (killAware)
@@ -23,6 +45,38 @@ static int WaitForSpliceReady(Descriptor& desc, unsigned mask, bool killAware)
     return Poll(desc, mask);
 }
 
+namespace detail
+{
+
+int DrainPipe(Descriptor& out, int pipefd[2], size_t remaining, bool killAware)
+{
+    while (remaining > 0)
+    {
+        ssize_t w = ::splice(pipefd[0], nullptr, out.m_fd, nullptr, remaining,
+                             SPLICE_F_NONBLOCK | SPLICE_F_MOVE);
+        if (w > 0)
+        {
+            remaining -= w;
+            continue;
+        }
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            SPDLOG_TRACE("splice out={} EAGAIN", out.m_fd);
+            int r = WaitForSpliceReady(out, POLLOUT, killAware);
+            if (r == -ECANCELED) return -ECANCELED;
+            if (r < 0) return -1;
+            continue;
+        }
+
+        spdlog::warn("splice out={} errno={}", out.m_fd, errno);
+        return -1;
+    }
+    return 0;
+}
+
+} // end namespace coop::io::detail
+
 static int SpliceImpl(Descriptor& in, Descriptor& out, int pipefd[2], size_t len, bool killAware)
 {
     SPDLOG_TRACE("splice in={} out={} len={}", in.m_fd, out.m_fd, len);
@@ -52,32 +106,71 @@ static int SpliceImpl(Descriptor& in, Descriptor& out, int pipefd[2], size_t len
 
     // Phase 2: drain pipe into output socket
     //
-    size_t remaining = (size_t)n;
-    while (remaining > 0)
+    int r = detail::DrainPipe(out, pipefd, (size_t)n, killAware);
+    if (r < 0) return r;
+
+    SPDLOG_TRACE("splice in={} out={} transferred={}", in.m_fd, out.m_fd, n);
+    return (int)n;
+}
+
+namespace
+{
+
+// Idle relay pipes, per cooperator. Creating a pipe is two fds and a syscall, and a relay takes one
+// per direction; an edge proxy churning through short connections reuses them instead. Only
+// pipes whose direction ended cleanly come back -- those are empty. Anything else is closed.
+//
+struct PipePool
+{
+    static constexpr size_t MAX_CACHED = 64;
+
+    ~PipePool()
     {
-        ssize_t w = ::splice(pipefd[0], nullptr, out.m_fd, nullptr, remaining,
-                             SPLICE_F_NONBLOCK | SPLICE_F_MOVE);
-        if (w > 0)
+        for (auto& p : m_free)
         {
-            remaining -= w;
-            continue;
+            close(p[0]);
+            close(p[1]);
         }
+    }
 
-        if (errno == EAGAIN || errno == EWOULDBLOCK)
+    bool Acquire(int pipefd[2])
+    {
+        if (!m_free.empty())
         {
-            SPDLOG_TRACE("splice out={} EAGAIN", out.m_fd);
-            int r = WaitForSpliceReady(out, POLLOUT, killAware);
-            if (r == -ECANCELED) return -ECANCELED;
-            if (r < 0) return -1;
-            continue;
+            pipefd[0] = m_free.back()[0];
+            pipefd[1] = m_free.back()[1];
+            m_free.pop_back();
+            return true;
         }
+        return pipe2(pipefd, O_NONBLOCK | O_CLOEXEC) == 0;
+    }
 
-        spdlog::warn("splice out={} errno={}", out.m_fd, errno);
-        return -1;
+    void Release(int pipefd[2], bool clean)
+    {
+        if (clean && m_free.size() < MAX_CACHED)
+        {
+            m_free.push_back({pipefd[0], pipefd[1]});
+            return;
+        }
+        close(pipefd[0]);
+        close(pipefd[1]);
     }
 
-    SPDLOG_TRACE("splice in={} out={} transferred={}", in.m_fd, out.m_fd, n);
-    return (int)n;
+    std::vector<std::array<int, 2>> m_free;
+};
+
+CooperatorVar<PipePool> s_pipes;
+
+} // end anonymous namespace
+
+bool AcquirePipe(int pipefd[2])
+{
+    return s_pipes->Acquire(pipefd);
+}
+
+void ReleasePipe(int pipefd[2], bool clean)
+{
+    s_pipes->Release(pipefd, clean);
 }
 
 int Splice(Descriptor& in, Descriptor& out, int pipefd[2], size_t len)
@@ -90,5 +183,62 @@ int SpliceKill(Descriptor& in, Descriptor& out, int pipefd[2], size_t len)
     return SpliceImpl(in, out, pipefd, len, true);
 }
 
+int SpliceChained(Descriptor& in, Descriptor& out, int pipefd[2], size_t len)
+{
+    assert(in.m_fd >= 0 && "the chained splice names its input by process fd");
+    SPDLOG_TRACE("splice chained in={} out={} len={}", in.m_fd, out.m_fd, len);
+
+    constexpr unsigned flags = SPLICE_F_NONBLOCK | SPLICE_F_MOVE;
+    Descriptor pipeIn(borrowed, pipefd[1], in.m_ring);
+    for (;;)
+    {
+        int polled, moved, sent;
+        {
+            // The socket-side splice is hard linked: a short splice -- the usual case -- would
+            // otherwise fail the chain before the pipe is drained
+            //
+            Chain chain(Self(), in.m_ring);
+            Poll(chain.Then(in), POLLIN);
+            SpliceFrom(chain.Then(pipeIn, Link::Hard), in.m_fd, len, flags);
+            SpliceFrom(chain.Last(out), pipefd[0], len, flags);
+            chain.Wait();
+
+            polled = chain.Result(0);
+            moved = chain.Result(1);
+            sent = chain.Result(2);
+        }
+
+        if (polled < 0)
+        {
+            spdlog::warn("splice in={} poll err={}", in.m_fd, polled);
+            return -1;
+        }
+        if (moved == 0)
+        {
+            return 0;
+        }
+        if (moved == -EAGAIN)
+        {
+            continue;                                   // readable mask that held no bytes
+        }
+        if (moved < 0)
+        {
+            spdlog::warn("splice in={} err={}", in.m_fd, moved);
+            return -1;
+        }
+        if (sent < 0 && sent != -EAGAIN)
+        {
+            spdlog::warn("splice out={} err={}", out.m_fd, sent);
+            return -1;
+        }
+
+        int r = detail::DrainPipe(out, pipefd, (size_t)(moved - std::max(sent, 0)), false);
+        if (r < 0) return r;
+
+        SPDLOG_TRACE("splice chained in={} out={} transferred={}", in.m_fd, out.m_fd, moved);
+        return moved;
+    }
+}
+
 } // end namespace coop::io
 } // end namespace coop
@@ -2,6 +2,8 @@
 
 #include <stddef.h>
 
+#include "coop/io/detail/op_macros.h"
+
 namespace coop
 {
 
@@ -9,6 +11,7 @@ namespace io
 {
 
 struct Descriptor;
+struct Handle;
 
 // Splice up to `len` bytes from `in` to `out` via kernel pipe — zero userspace copies.
 // Both descriptors must be non-blocking. The pipe is caller-managed (create with
@@ -22,5 +25,41 @@ int Splice(Descriptor& in, Descriptor& out, int pipefd[2], size_t len);
 //
 int SpliceKill(Descriptor& in, Descriptor& out, int pipefd[2], size_t len);
 
+// A nonblocking pipe for the splices above from the calling cooperator's pool, or a new one; false
+// if pipe2 failed. Released clean -- empty, its transfer finished -- it goes back to the pool;
+// otherwise it is closed.
+//
+bool AcquirePipe(int pipefd[2]);
+void ReleasePipe(int pipefd[2], bool clean);
+
+// Splice as one linked io_uring chain -- poll `in` for readability, splice it into the pipe, splice
+// the pipe into `out` -- so a relay hop costs the calling context one wake rather than a syscall
+// and a poll per phase. Whatever the socket-side splice leaves in the pipe (`out` full) drains
+// through the same poll-and-splice loop as Splice. Same contract and results as Splice; `in` must
+// have a process fd.
+//
+int SpliceChained(Descriptor& in, Descriptor& out, int pipefd[2], size_t len);
+
+// io_uring splice of up to len bytes from the raw fd fdIn into the handle's descriptor, for
+// building chains (see io::Chain). Returns bytes moved. No offsets: both ends are streams.
+//
+namespace detail
+{
+
+// Move `remaining` bytes already in the pipe into out, waiting for writability as needed. Returns
+// 0, -ECANCELED when kill-aware and killed, or -1. For splices that fill the pipe their own way
+// (ssl::Splice).
+//
+int DrainPipe(Descriptor& out, int pipefd[2], size_t remaining, bool killAware);
+
+} // end namespace coop::io::detail
+
+#define SPLICE_FROM_ARGS(F) F(int, fdIn, ) F(size_t, len, ) F(unsigned, flags, = 0)
+COOP_IO_DECLARATIONS(SpliceFrom, SPLICE_FROM_ARGS)
+
 } // end namespace coop::io
 } // end namespace coop
+
+#ifndef COOP_IO_KEEP_ARGS
+#undef SPLICE_FROM_ARGS
+#endif
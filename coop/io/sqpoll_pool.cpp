@@ -0,0 +1,76 @@
+#include "sqpoll_pool.h"
+
+#include <algorithm>
+
+#include "uring_configuration.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+SqpollPool::SqpollPool(int pollersPerNode /* = 1 */)
+: m_pollersPerNode(std::max(pollersPerNode, 1))
+{
+}
+
+void SqpollPool::Configure(UringConfiguration& config)
+{
+    config.sqpoll = true;
+    config.coopTaskrun = false;
+    config.deferTaskrun = false;
+    config.attachSqFd = -1;
+    config.sqpollPool = this;
+}
+
+int SqpollPool::Join(int node)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto& n = m_nodes[std::max(node, 0)];
+
+    while (true)
+    {
+        if (static_cast<int>(n.fds.size()) + n.starting < m_pollersPerNode)
+        {
+            n.starting++;
+            return -1;
+        }
+        if (!n.fds.empty())
+        {
+            return n.fds[n.next++ % n.fds.size()];
+        }
+
+        // Every poller slot is taken by a ring still in its setup; one of them publishes soon
+        //
+        m_published.wait(lock);
+    }
+}
+
+void SqpollPool::Publish(int node, int fd)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& n = m_nodes[std::max(node, 0)];
+        n.starting--;
+        if (fd >= 0)
+        {
+            n.fds.push_back(fd);
+        }
+    }
+    m_published.notify_all();
+}
+
+size_t SqpollPool::Pollers() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t total = 0;
+    for (auto const& [node, n] : m_nodes)
+    {
+        total += n.fds.size();
+    }
+    return total;
+}
+
+} // end namespace coop::io
+} // end namespace coop
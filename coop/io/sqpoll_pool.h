@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace coop
+{
+
+namespace io
+{
+
+struct UringConfiguration;
+
+// Shares SQPOLL kernel threads among cooperators. Every ring set up with sqpoll gets a kernel
+// thread of its own that polls its SQ, so N cooperators burn N extra cores; a ring set up with
+// IORING_SETUP_ATTACH_WQ instead shares an existing ring's poller. A pool automates that: each
+// ring that joins it (UringConfiguration::sqpollPool) either becomes one of its node's pollers or
+// attaches to one, round robin, so a process has pollersPerNode polling threads per NUMA node
+// however many cooperators it runs.
+//
+//     io::SqpollPool pollers(1);
+//     for (auto& config : configs) pollers.Configure(config.uring);
+//
+// Joining happens in Uring::Init, on the ring's own thread, once it is pinned (the cooperator's
+// NumaNode picks the node; an unpinned ring counts as node 0). A ring that would attach waits for
+// its poller's ring to be up. A poller whose SQPOLL setup is refused (no CAP_SYS_ADMIN, say) hands
+// the role to the next ring to join, and falls back like any other ring. The pool only has to live
+// until every member's Init has run.
+//
+struct SqpollPool
+{
+    explicit SqpollPool(int pollersPerNode = 1);
+
+    SqpollPool(SqpollPool const&) = delete;
+    SqpollPool& operator=(SqpollPool const&) = delete;
+
+    // Make config join this pool: sqpoll on, with the taskrun modes SQPOLL is incompatible with off
+    //
+    void Configure(UringConfiguration& config);
+
+    // Called by Uring::Init before the ring is set up. -1 when the ring is to be a new poller for
+    // node (it must then Publish), else the fd of the poller ring to attach to.
+    //
+    int Join(int node);
+
+    // A poller's setup result: its ring fd, or -1 when SQPOLL was not granted
+    //
+    void Publish(int node, int fd);
+
+    // Polling threads up, across all nodes
+    //
+    size_t Pollers() const;
+
+  private:
+    struct Node
+    {
+        std::vector<int> fds;
+        int starting = 0;
+        size_t next = 0;
+    };
+
+    int m_pollersPerNode;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_published;
+    std::map<int, Node> m_nodes;
+};
+
+} // end namespace coop::io
+} // end namespace coop
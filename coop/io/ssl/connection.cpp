@@ -1,19 +1,35 @@
 #include "connection.h"
 
 #include <cassert>
+#include <cstring>
 #include <fcntl.h>
+#include <linux/tls.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <optional>
 #include <poll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
 #include <openssl/bio.h>
+#include <openssl/buffer.h>
 #include <openssl/err.h>
 #include <spdlog/spdlog.h>
 
 #include "context.h"
+#include "ktls.h"
+#include "session_cache.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator_var.h"
+#include "coop/cooperator_var.hpp"
+#include "coop/memory_accounting.h"
 #include "coop/io/descriptor.h"
 #include "coop/io/poll.h"
 #include "coop/io/recv.h"
 #include "coop/io/send.h"
+#include "coop/time/now.h"
+#include "coop/work/grid.h"
 
 namespace coop
 {
@@ -24,13 +40,120 @@ namespace io
 namespace ssl
 {
 
+namespace
+{
+
+// Idle staging buffers, per cooperator. A pooled Connection borrows one for each flush and read,
+// so a cooperator needs about as many as it has connections moving ciphertext at once rather than
+// one per connection. Past MAX_CACHED, returned buffers are freed.
+//
+struct StagingPool
+{
+    static constexpr size_t MAX_CACHED = 64;
+
+    ~StagingPool()
+    {
+        for (char* buffer : m_free)
+        {
+            Delete(buffer);
+        }
+    }
+
+    char* Acquire()
+    {
+        if (m_free.empty())
+        {
+            AccountMemory(MemoryTag::TlsStaging, Connection::BUFFER_SIZE, 1);
+            return new char[Connection::BUFFER_SIZE];
+        }
+        char* buffer = m_free.back();
+        m_free.pop_back();
+        return buffer;
+    }
+
+    void Release(char* buffer)
+    {
+        if (m_free.size() < MAX_CACHED)
+        {
+            m_free.push_back(buffer);
+            return;
+        }
+        Delete(buffer);
+    }
+
+    static void Delete(char* buffer)
+    {
+        AccountMemory(MemoryTag::TlsStaging, -int64_t(Connection::BUFFER_SIZE), -1);
+        delete[] buffer;
+    }
+
+    std::vector<char*> m_free;
+};
+
+CooperatorVar<StagingPool> s_staging;
+
+// A borrowed staging buffer for one scope. Off-cooperator (tests, setup code) it is allocated and
+// freed directly.
+//
+struct Staging
+{
+    Staging()
+    : data(Cooperator::thread_cooperator ? s_staging->Acquire()
+                                         : new char[Connection::BUFFER_SIZE])
+    {
+    }
+
+    ~Staging()
+    {
+        if (Cooperator::thread_cooperator)
+        {
+            s_staging->Release(data);
+            return;
+        }
+        delete[] data;
+    }
+
+    Staging(Staging const&) = delete;
+    Staging& operator=(Staging const&) = delete;
+
+    char* data;
+};
+
+} // end anonymous namespace
+
 Connection::Connection(Context& ctx, Descriptor& desc, char* buffer, size_t bufferSize)
 : m_desc(desc)
 , m_buffer(buffer)
 , m_bufferSize(bufferSize)
+, m_writeBuffer(buffer)
+, m_writeBufferSize(bufferSize)
+{
+    InitMemoryBio(ctx);
+    AccountMemory(MemoryTag::TlsConnection, sizeof(Connection) + m_bufferSize, 1);
+}
+
+Connection::Connection(Context& ctx, Descriptor& desc)
+: m_desc(desc)
+, m_buffer(nullptr)
+, m_bufferSize(0)
+, m_pooled(true)
+, m_writeBuffer(nullptr)
+, m_writeBufferSize(0)
+{
+    InitMemoryBio(ctx);
+
+    // OpenSSL's own record buffers (~34KB between them) are freed between records too
+    //
+    SSL_set_mode(m_ssl, SSL_MODE_RELEASE_BUFFERS);
+    AccountMemory(MemoryTag::TlsConnection, sizeof(Connection), 1);
+}
+
+void Connection::InitMemoryBio(Context& ctx)
 {
     m_ssl = SSL_new(ctx.m_ctx);
     assert(m_ssl);
+    SSL_set_app_data(m_ssl, this);
+    InitRecordSizing(ctx);
 
     // Create memory BIOs. OpenSSL will read ciphertext from rbio and write ciphertext to wbio.
     // We shuttle data between these BIOs and the real socket using io::Send/io::Recv. This
@@ -59,9 +182,13 @@ Connection::Connection(Context& ctx, Descriptor& desc, SocketBio)
 : m_desc(desc)
 , m_buffer(nullptr)
 , m_bufferSize(0)
+, m_writeBuffer(nullptr)
+, m_writeBufferSize(0)
 {
     m_ssl = SSL_new(ctx.m_ctx);
     assert(m_ssl);
+    SSL_set_app_data(m_ssl, this);
+    InitRecordSizing(ctx);
 
     // Attach OpenSSL directly to the real socket fd. This lets OpenSSL install kTLS state
     // into the kernel after handshake. SSL_set_fd creates socket BIOs internally.
@@ -91,23 +218,257 @@ Connection::Connection(Context& ctx, Descriptor& desc, SocketBio)
     {
         SSL_set_connect_state(m_ssl);
     }
+    AccountMemory(MemoryTag::TlsConnection, sizeof(Connection), 1);
 }
 
 Connection::~Connection()
 {
     SSL_free(m_ssl);
+    AccountMemory(MemoryTag::TlsConnection, -int64_t(sizeof(Connection) + m_bufferSize), -1);
 }
 
-// Drain any pending data from OpenSSL's write BIO and send it over the wire via io::Send. This
-// must be called after every SSL operation that might produce output (handshake, SSL_write, etc).
+std::string_view Connection::AlpnProtocol() const
+{
+    const unsigned char* data = nullptr;
+    unsigned int len = 0;
+    SSL_get0_alpn_selected(m_ssl, &data, &len);
+    return std::string_view(reinterpret_cast<const char*>(data), data ? len : 0);
+}
+
+void Connection::SetResumptionKey(std::string key)
+{
+    auto* ctx = Context::From(m_ssl);
+    if (ctx->m_mode != Mode::Client || ctx->m_sessionCacheSize == 0)
+    {
+        return;
+    }
+    m_resumptionKey = std::move(key);
+
+    auto& cache = ctx->LocalSessions();
+    SSL_SESSION* session = cache.Take(m_resumptionKey);
+    if (!session)
+    {
+        return;
+    }
+    SSL_set_session(m_ssl, session);
+    if (SSL_SESSION_get_protocol_version(session) < TLS1_3_VERSION)
+    {
+        cache.Insert(m_resumptionKey, session);
+    }
+    else
+    {
+        SSL_SESSION_free(session);
+    }
+}
+
+void Connection::OnKeyLog(const char* line)
+{
+    // "<label> <client random> <secret>", all hex after the label
+    //
+    bool server = Context::From(m_ssl)->m_mode == Mode::Server;
+    TrafficSecret* secret = nullptr;
+    if (strncmp(line, "CLIENT_TRAFFIC_SECRET_0 ", 24) == 0)
+    {
+        secret = server ? &m_rxSecret : &m_txSecret;
+    }
+    else if (strncmp(line, "SERVER_TRAFFIC_SECRET_0 ", 24) == 0)
+    {
+        secret = server ? &m_txSecret : &m_rxSecret;
+    }
+    const char* hex = secret ? strchr(line + 24, ' ') : nullptr;
+    if (!hex)
+    {
+        return;
+    }
+    hex++;
+
+    size_t len = strlen(hex) / 2;
+    if (len > sizeof(secret->data))
+    {
+        return;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        int hi = OPENSSL_hexchar2int(static_cast<unsigned char>(hex[2 * i]));
+        int lo = OPENSSL_hexchar2int(static_cast<unsigned char>(hex[2 * i + 1]));
+        if (hi < 0 || lo < 0)
+        {
+            secret->len = 0;
+            return;
+        }
+        secret->data[i] = static_cast<unsigned char>(hi << 4 | lo);
+    }
+    secret->len = len;
+}
+
+// OpenSSL 3.0 installs kTLS RX for TLS 1.2 only. For TLS 1.3 we install it from the logged
+// secret, at sequence 0: OpenSSL reads a record at a time (no read-ahead), so it has read nothing
+// past the peer's Finished unless SSL_has_pending says otherwise. A client keeping sessions is
+// left alone -- tickets arriving on a kTLS socket never reach OpenSSL.
 //
-// Returns 0 on success, negative on I/O error.
+void Connection::EnableKtlsRx()
+{
+    auto* ctx = Context::From(m_ssl);
+    if (m_ktlsTx && ctx->m_ktlsZerocopySendfile)
+    {
+        int one = 1;
+        ::setsockopt(m_desc.m_fd, SOL_TLS, TLS_TX_ZEROCOPY_RO, &one, sizeof(one));
+    }
+    if (SSL_version(m_ssl) != TLS1_3_VERSION || !m_ktlsTx)
+    {
+        return;
+    }
+    if (!m_ktlsRx)
+    {
+        if (m_rxSecret.len == 0 || SSL_has_pending(m_ssl) ||
+            (ctx->m_mode == Mode::Client && ctx->m_sessionCacheSize > 0))
+        {
+            return;
+        }
+        if (!InstallKtls13(m_desc.m_fd, TLS_RX, SSL_get_current_cipher(m_ssl), m_rxSecret, 0))
+        {
+            return;
+        }
+        m_ktlsRx = true;
+    }
+
+    // Decrypt straight into the caller's buffer, betting the peer does not pad its records
+    // (6.0+; a padded record costs a retry, and the kernel stops betting if they keep coming)
+    //
+    int one = 1;
+    ::setsockopt(m_desc.m_fd, SOL_TLS, TLS_RX_EXPECT_NO_PAD, &one, sizeof(one));
+}
+
+int Connection::KtlsControl(uint8_t type, const char* data, size_t len, bool killAware)
+{
+    constexpr uint8_t ALERT = 21;
+    constexpr uint8_t HANDSHAKE = 22;
+    constexpr uint8_t NEW_SESSION_TICKET = 4;
+    constexpr uint8_t KEY_UPDATE = 24;
+
+    if (type == ALERT)
+    {
+        // level, description: close_notify (0) is the peer's clean end
+        //
+        if (len >= 2 && data[1] == 0)
+        {
+            return 0;
+        }
+        spdlog::warn("ssl ktls recv fd={} alert={}", m_desc.m_fd,
+            len >= 2 ? static_cast<int>(static_cast<uint8_t>(data[1])) : -1);
+        return -1;
+    }
+    if (type != HANDSHAKE)
+    {
+        spdlog::warn("ssl ktls recv fd={} unexpected record type={}", m_desc.m_fd, type);
+        return -1;
+    }
+
+    // A handshake message may span records, and a record hold several
+    //
+    m_ktlsControl.append(data, len);
+    while (m_ktlsControl.size() >= 4)
+    {
+        auto* p = reinterpret_cast<const uint8_t*>(m_ktlsControl.data());
+        size_t body = size_t(p[1]) << 16 | size_t(p[2]) << 8 | p[3];
+        if (body > 65536)
+        {
+            spdlog::warn("ssl ktls recv fd={} handshake message too large", m_desc.m_fd);
+            return -1;
+        }
+        if (m_ktlsControl.size() < 4 + body)
+        {
+            break;
+        }
+        if (p[0] == KEY_UPDATE)
+        {
+            if (body != 1 || !KtlsKeyUpdate(p[4] == 1, killAware))
+            {
+                return -1;
+            }
+        }
+        else if (p[0] != NEW_SESSION_TICKET)
+        {
+            spdlog::warn("ssl ktls recv fd={} unexpected handshake type={}", m_desc.m_fd, p[0]);
+            return -1;
+        }
+        m_ktlsControl.erase(0, 4 + body);
+    }
+    return 1;
+}
+
+// The peer moved to its next key: so does the kernel's RX state, from sequence 0. Asked to, we
+// answer with an update of our own -- sent under the old key -- and move TX too. Needs a kernel
+// with TLS 1.3 rekey (6.14); older ones refuse the second install, failing the connection.
+//
+bool Connection::KtlsKeyUpdate(bool requested, bool killAware)
+{
+    const SSL_CIPHER* cipher = SSL_get_current_cipher(m_ssl);
+    if (m_rxSecret.len == 0 || !NextTrafficSecret(cipher, &m_rxSecret) ||
+        !InstallKtls13(m_desc.m_fd, TLS_RX, cipher, m_rxSecret, 0))
+    {
+        spdlog::warn("ssl ktls fd={} rx key update failed", m_desc.m_fd);
+        return false;
+    }
+    SPDLOG_DEBUG("ssl ktls fd={} rx key updated requested={}", m_desc.m_fd, requested);
+    if (!requested)
+    {
+        return true;
+    }
+
+    static const uint8_t update[] = {24, 0, 0, 1, 0};     // KeyUpdate, update_not_requested
+    if (!m_ktlsTx || m_txSecret.len == 0 ||
+        SendKtlsRecord(*this, 22, update, sizeof(update), killAware) < 0 ||
+        !NextTrafficSecret(cipher, &m_txSecret) ||
+        !InstallKtls13(m_desc.m_fd, TLS_TX, cipher, m_txSecret, 0))
+    {
+        spdlog::warn("ssl ktls fd={} tx key update failed", m_desc.m_fd);
+        return false;
+    }
+    return true;
+}
+
+void Connection::SetWriteBuffer(char* buffer, size_t bufferSize)
+{
+    assert(m_rbio && "socket BIO mode has no staging buffers");
+    m_writeBuffer = buffer;
+    m_writeBufferSize = bufferSize;
+}
+
+// Drain any pending data from OpenSSL's write BIO and send it over the wire. This must be called
+// after every SSL operation that might produce output (handshake, SSL_write, etc).
+//
+// A flush almost always finds the socket writable, so it tries a nonblocking send() first and
+// only submits to io_uring on EAGAIN (io::SendFastpath). A direct descriptor has no process fd to
+// send() on and goes straight to the ring.
+//
+// Only one context flushes at a time: a flush that finds another in progress returns at once, and
+// the one in progress keeps draining until the BIO is empty, so ciphertext still leaves in order.
+//
+// Returns 0 on success, a negative errno on I/O error.
 //
 int Connection::FlushWrite(bool killAware)
 {
-    while (BIO_ctrl_pending(m_wbio) > 0)
+    if (m_flushing)
+    {
+        return 0;
+    }
+    m_flushing = true;
+    int result = 0;
+
+    char* out = m_writeBuffer;
+    size_t outSize = m_writeBufferSize;
+    std::optional<Staging> staging;
+    if (!out && BIO_ctrl_pending(m_wbio) > 0)
+    {
+        staging.emplace();
+        out = staging->data;
+        outSize = BUFFER_SIZE;
+    }
+
+    while (result == 0 && BIO_ctrl_pending(m_wbio) > 0)
     {
-        int n = BIO_read(m_wbio, m_buffer, m_bufferSize);
+        int n = BIO_read(m_wbio, out, outSize);
         if (n <= 0)
         {
             break;
@@ -117,18 +478,98 @@ int Connection::FlushWrite(bool killAware)
         int at = 0;
         while (at < n)
         {
-            int sent = killAware
-                ? io::SendKill(m_desc, &m_buffer[at], n - at)
-                : io::Send(m_desc, &m_buffer[at], n - at);
+            int sent;
+            if (m_desc.m_direct)
+            {
+                sent = killAware ? io::SendKill(m_desc, &out[at], n - at)
+                                 : io::Send(m_desc, &out[at], n - at);
+            }
+            else
+            {
+                sent = killAware ? io::SendFastpathKill(m_desc, &out[at], n - at)
+                                 : io::SendFastpath(m_desc, &out[at], n - at);
+            }
             if (sent <= 0)
             {
                 spdlog::warn("ssl flush_write fd={} send failed={}", m_desc.m_fd, sent);
-                return -1;
+                result = sent < 0 ? sent : -EPIPE;
+                break;
             }
             at += sent;
         }
     }
-    return 0;
+    m_flushing = false;
+    if (m_pooled && result == 0)
+    {
+        TrimBio(m_wbio);
+    }
+    return result;
+}
+
+void Connection::InitRecordSizing(Context& ctx)
+{
+    m_smallRecord = ctx.m_smallRecord;
+    m_smallRecordBytes = m_smallRecord ? ctx.m_smallRecordBytes : 0;
+    m_recordIdle = ctx.m_recordIdle.count();
+}
+
+// The budget is measured from the last write, on the coarse clock: a second's idle is long
+// enough that a stale reading does not matter, and the kernel will have let the congestion
+// window decay (tcp_slow_start_after_idle) in about that time
+//
+size_t Connection::RecordLimit()
+{
+    if (m_smallRecordBytes == 0)
+    {
+        return SIZE_MAX;
+    }
+    int64_t now = time::NowCoarse();
+    if (now - m_lastWrite >= m_recordIdle)
+    {
+        m_smallLeft = m_smallRecordBytes;
+    }
+    m_lastWrite = now;
+
+    if (m_smallLeft == 0)
+    {
+        if (m_kernelSmallRecords)
+        {
+            KernelRecordLimit(false);
+        }
+        return SIZE_MAX;
+    }
+    if (m_ktlsTx && (m_kernelSmallRecords || KernelRecordLimit(true)))
+    {
+        // The kernel cuts the records: one write may carry the rest of the budget
+        //
+        return m_smallLeft;
+    }
+    return m_smallRecord;
+}
+
+bool Connection::KernelRecordLimit(bool small)
+{
+#ifdef TLS_TX_MAX_PAYLOAD_LEN
+    if (!m_kernelRecordLimit)
+    {
+        return false;
+    }
+    uint16_t size = static_cast<uint16_t>(small ? m_smallRecord : 16384);
+    if (::setsockopt(m_desc.m_fd, SOL_TLS, TLS_TX_MAX_PAYLOAD_LEN, &size, sizeof(size)) != 0)
+    {
+        // An older kernel: split the writes instead, from now on
+        //
+        SPDLOG_DEBUG("ssl record limit fd={} errno={}", m_desc.m_fd, errno);
+        m_kernelRecordLimit = false;
+        return false;
+    }
+    m_kernelSmallRecords = small;
+    return true;
+#else
+    (void)small;
+    m_kernelRecordLimit = false;
+    return false;
+#endif
 }
 
 // Read ciphertext from the wire via io::Recv and feed it into OpenSSL's read BIO. Called when
@@ -138,6 +579,11 @@ int Connection::FlushWrite(bool killAware)
 //
 int Connection::FeedRead(bool killAware)
 {
+    if (m_pooled)
+    {
+        return FeedReadPooled(killAware);
+    }
+
     int n = killAware
         ? io::RecvKill(m_desc, m_buffer, m_bufferSize)
         : io::Recv(m_desc, m_buffer, m_bufferSize);
@@ -153,11 +599,88 @@ int Connection::FeedRead(bool killAware)
     return written;
 }
 
+// A nonblocking recv() into a borrowed buffer takes what has already arrived; only when nothing
+// has does the context park, on a poll, with the buffer back in the pool. A direct descriptor has
+// no fd to recv() on and waits for readability first.
+//
+int Connection::FeedReadPooled(bool killAware)
+{
+    for (;;)
+    {
+        if (!m_desc.m_direct)
+        {
+            Staging staging;
+            int n = (int)syscall(SYS_recvfrom, m_desc.m_fd, staging.data, BUFFER_SIZE,
+                                 MSG_DONTWAIT, nullptr, nullptr);
+            if (n > 0)
+            {
+                [[maybe_unused]] int written = BIO_write(m_rbio, staging.data, n);
+                assert(written == n);
+                SPDLOG_TRACE("ssl feed_read fd={} recv={} pooled", m_desc.m_fd, n);
+                return n;
+            }
+            if (n == 0)
+            {
+                return 0;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                SPDLOG_TRACE("ssl feed_read fd={} recv errno={}", m_desc.m_fd, errno);
+                return -errno;
+            }
+        }
+
+        if (!m_flushing)
+        {
+            TrimBio(m_wbio);
+        }
+        TrimBio(m_rbio);
+
+        int r = killAware ? io::PollKill(m_desc, POLLIN) : io::Poll(m_desc, POLLIN);
+        if (r < 0)
+        {
+            SPDLOG_TRACE("ssl feed_read fd={} poll={}", m_desc.m_fd, r);
+            return r;
+        }
+
+        if (m_desc.m_direct)
+        {
+            Staging staging;
+            int n = killAware ? io::RecvKill(m_desc, staging.data, BUFFER_SIZE)
+                              : io::Recv(m_desc, staging.data, BUFFER_SIZE);
+            if (n <= 0)
+            {
+                return n;
+            }
+            [[maybe_unused]] int written = BIO_write(m_rbio, staging.data, n);
+            assert(written == n);
+            return n;
+        }
+    }
+}
+
+// Swap an empty memory BIO's buffer for a fresh, unallocated one. A mem BIO keeps its high-water
+// mark otherwise: a record's worth of memory per direction, for as long as the connection lives.
+//
+void Connection::TrimBio(BIO* bio)
+{
+    BUF_MEM* mem = nullptr;
+    if (BIO_ctrl_pending(bio) != 0 || BIO_get_mem_ptr(bio, &mem) <= 0 || !mem || mem->max == 0)
+    {
+        return;
+    }
+    BUF_MEM* fresh = BUF_MEM_new();
+    if (fresh)
+    {
+        BIO_set_mem_buf(bio, fresh, BIO_CLOSE);
+    }
+}
+
 // Dispatch to the appropriate handshake implementation based on the BIO mode.
 //
 int Connection::Handshake()
 {
-    if (m_buffer == nullptr)
+    if (m_rbio == nullptr)
     {
         return HandshakeSocketBio(false);
     }
@@ -166,7 +689,7 @@ int Connection::Handshake()
 
 int Connection::HandshakeKill()
 {
-    if (m_buffer == nullptr)
+    if (m_rbio == nullptr)
     {
         return HandshakeSocketBio(true);
     }
@@ -183,21 +706,23 @@ int Connection::HandshakeKill()
 int Connection::HandshakeSocketBio(bool killAware)
 {
     SPDLOG_DEBUG("ssl socket-bio handshake start fd={}", m_desc.m_fd);
+    bool input = false;
     for (;;)
     {
-        int ret = SSL_do_handshake(m_ssl);
-        if (ret == 1)
+        int err = HandshakeStep(input);
+        if (err == SSL_ERROR_NONE)
         {
             // Probe kTLS activation
             //
             m_ktlsTx = BIO_get_ktls_send(SSL_get_wbio(m_ssl)) != 0;
             m_ktlsRx = BIO_get_ktls_recv(SSL_get_rbio(m_ssl)) != 0;
+            EnableKtlsRx();
             SPDLOG_DEBUG("ssl socket-bio handshake complete fd={} ktls_tx={} ktls_rx={}",
                 m_desc.m_fd, m_ktlsTx, m_ktlsRx);
             return 0;
         }
 
-        int err = SSL_get_error(m_ssl, ret);
+        input = false;
         switch (err)
         {
         case SSL_ERROR_WANT_READ:
@@ -209,6 +734,7 @@ int Connection::HandshakeSocketBio(bool killAware)
                 spdlog::warn("ssl socket-bio handshake fd={} poll failed={}", m_desc.m_fd, r);
                 return -1;
             }
+            input = true;
             break;
         }
 
@@ -243,8 +769,8 @@ int Connection::HandshakeMemoryBio(bool killAware)
     SPDLOG_DEBUG("ssl handshake start fd={}", m_desc.m_fd);
     for (;;)
     {
-        int ret = SSL_do_handshake(m_ssl);
-        if (ret == 1)
+        int err = HandshakeStep(BIO_ctrl_pending(m_rbio) > 0);
+        if (err == SSL_ERROR_NONE)
         {
             // Handshake complete. Flush any final output (e.g. Finished message).
             //
@@ -252,7 +778,6 @@ int Connection::HandshakeMemoryBio(bool killAware)
             return FlushWrite(killAware);
         }
 
-        int err = SSL_get_error(m_ssl, ret);
         switch (err)
         {
         case SSL_ERROR_WANT_WRITE:
@@ -284,6 +809,47 @@ int Connection::HandshakeMemoryBio(bool killAware)
     }
 }
 
+int Connection::HandshakeStep(bool input)
+{
+    Cooperator* origin = GetCooperator();
+    if (!input || !origin->m_participation || !Context::From(m_ssl)->m_offloadHandshakes)
+    {
+        int ret = SSL_do_handshake(m_ssl);
+        return ret == 1 ? SSL_ERROR_NONE : SSL_get_error(m_ssl, ret);
+    }
+
+    // As ParallelReduce's join: the Erg's last touch of this frame is releasing done, on our own
+    // cooperator -- directly when a local stealer took it, through Cooperate from a peer
+    //
+    struct Step
+    {
+        Coordinator done{static_cast<coop::Context*>(nullptr)};
+        int         err = SSL_ERROR_SSL;
+    } step;
+
+    coop::Shed([this, origin, &step]
+    {
+        ERR_clear_error();
+        int ret = SSL_do_handshake(m_ssl);
+        step.err = ret == 1 ? SSL_ERROR_NONE : SSL_get_error(m_ssl, ret);
+        if (step.err == SSL_ERROR_SSL)
+        {
+            spdlog::warn("ssl offloaded handshake fd={} failed: {}", m_desc.m_fd,
+                ERR_reason_error_string(ERR_peek_error()));
+        }
+        ERR_clear_error();
+
+        if (Cooperator::thread_cooperator == origin)
+        {
+            step.done.Release(Self(), false);
+            return;
+        }
+        origin->Cooperate([&step](coop::Context* ctx) { step.done.Release(ctx, false); });
+    });
+    step.done.Acquire(Self());
+    return step.err;
+}
+
 } // end namespace coop::io::ssl
 } // end namespace coop::io
 } // end namespace coop
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <cerrno>
 #include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
 #include <openssl/ssl.h>
 
+#include "ktls.h"
+
 namespace coop
 {
 
@@ -29,6 +35,11 @@ struct SocketBio {};
 //   Plaintext out:  SSL_write() -> wbio (memory) -> FlushWrite() -> io::Send -> uring -> kernel
 //   Plaintext in:   kernel -> uring -> io::Recv -> FeedRead() -> rbio (memory) -> SSL_read()
 //
+// The staging buffer is either the caller's, resident for the connection's life, or (the pooled
+// constructor) drawn from a per-cooperator pool only while ciphertext is being moved. A pooled
+// connection waits for input holding no buffer, runs with SSL_MODE_RELEASE_BUFFERS, and returns
+// its BIOs' memory whenever they run empty, so an idle one costs little beyond the SSL object.
+//
 // **Socket BIO mode** (SocketBio tag): OpenSSL operates on the real fd. Handshake uses socket
 // readiness waits, and explicit kill-aware variants are available for callers that want prompt
 // cancellation. If kTLS activates, Send/Recv bypass OpenSSL on the data path entirely. Falls back
@@ -47,6 +58,12 @@ struct Connection
     //
     Connection(Context& ctx, Descriptor& desc, char* buffer, size_t bufferSize);
 
+    // Memory BIO constructor with pooled staging: BUFFER_SIZE buffers are borrowed from the
+    // cooperator's pool for each flush and read, and several contexts may flush and read at once
+    // without a SetWriteBuffer. For connections that spend most of their life idle.
+    //
+    Connection(Context& ctx, Descriptor& desc);
+
     // Socket BIO constructor — OpenSSL operates on the real fd. No staging buffer needed.
     // Enables kTLS if the ssl::Context has EnableKTLS() set and the kernel supports it.
     //
@@ -60,6 +77,49 @@ struct Connection
     int Handshake();
     int HandshakeKill();
 
+    // The protocol ALPN settled on (see Context::SetAlpnProtocols), or empty if none was. Valid
+    // once the handshake has completed.
+    //
+    std::string_view AlpnProtocol() const;
+
+    // Client session resumption (Context::EnableSessionResumption): sessions this connection is
+    // issued are kept under key, and one kept earlier under it is offered in the handshake --
+    // the pool passes its host:port key. TLS 1.3 tickets are single-use (RFC 8446 C.4), so one is
+    // taken out as it is offered; TLS 1.2 sessions stay for the next. Call before the handshake.
+    // Does nothing when the context keeps no client sessions.
+    //
+    void SetResumptionKey(std::string key);
+    std::string_view ResumptionKey() const { return m_resumptionKey; }
+
+    // The handshake resumed a session rather than running in full
+    //
+    bool SessionReused() const { return SSL_session_reused(m_ssl) == 1; }
+
+    // Memory BIO mode: stage outgoing ciphertext through buffer instead of the shared staging
+    // buffer, so one context may be blocked in a Recv while another Sends -- HTTP/2 reads frames
+    // on one context and writes responses from others. A Send that finds another context mid-flush
+    // leaves its ciphertext for that flush to push out. Pooled connections need none.
+    //
+    void SetWriteBuffer(char* buffer, size_t bufferSize);
+
+    // kTLS context only: OpenSSL's keylog line for this connection, from which we keep the TLS
+    // 1.3 traffic secrets (see EnableKtlsRx)
+    //
+    void OnKeyLog(const char* line);
+
+    // kTLS RX only: a non-application record recvmsg handed over, with its type. Alerts end the
+    // connection (0 for close_notify, else -1); KeyUpdates rekey the kernel; session tickets are
+    // dropped. Returns 1 when the connection carries on.
+    //
+    int KtlsControl(uint8_t type, const char* data, size_t len, bool killAware);
+
+    // Dynamic record sizing (Context::SetRecordSizing): the most plaintext the next write may
+    // hand to SSL_write, or to the socket with kTLS TX, SIZE_MAX when records may be full. Starts
+    // a small-record budget after an idle spell. Wrote charges what a write took against it.
+    //
+    size_t RecordLimit();
+    void Wrote(size_t size) { m_smallLeft -= size < m_smallLeft ? size : m_smallLeft; }
+
     SSL*         m_ssl;
     Descriptor&  m_desc;
 
@@ -89,6 +149,19 @@ struct Connection
     //
     int HandshakeMemoryBio(bool killAware);
 
+    // One SSL_do_handshake call, as an Erg on the grid when the context offloads handshakes and
+    // there is peer input to process (the first step of either side only writes a hello or
+    // finds nothing to read). Returns SSL_ERROR_NONE once the handshake is complete, else the
+    // SSL_get_error code -- taken where the step ran, OpenSSL's error queue being per thread.
+    //
+    int HandshakeStep(bool input);
+
+    // After a socket BIO handshake: take TLS 1.3 receive into the kernel where OpenSSL did not,
+    // and apply the context's zerocopy sendfile setting
+    //
+    void EnableKtlsRx();
+    bool KtlsKeyUpdate(bool requested, bool killAware);
+
     // Push any pending encrypted data from OpenSSL's write BIO out through the descriptor. Called
     // after any SSL operation that may produce output (handshake steps, SSL_write, shutdown).
     // Memory BIO mode only.
@@ -101,13 +174,62 @@ struct Connection
     //
     int FeedRead(bool killAware = false);
 
+    // Pooled staging: read whatever ciphertext is queued into a borrowed buffer, returning it
+    // before parking until more arrives
+    //
+    int FeedReadPooled(bool killAware);
+
+    // Pooled staging: hand an empty BIO's memory back to the allocator
+    //
+    static void TrimBio(BIO* bio);
+
+    void InitMemoryBio(Context& ctx);
+    void InitRecordSizing(Context& ctx);
+
+    // kTLS TX: have the kernel cut records at the small size, or back at full size. False when
+    // it cannot (no TLS_TX_MAX_PAYLOAD_LEN), and the writes are split here instead.
+    //
+    bool KernelRecordLimit(bool small);
+
     BIO* m_rbio;
     BIO* m_wbio;
 
-    char* m_buffer;
+    char* m_buffer;                 // nullptr for pooled staging, and in socket BIO mode
     size_t m_bufferSize;
+    bool m_pooled = false;
+
+    char* m_writeBuffer;
+    size_t m_writeBufferSize;
+    bool m_flushing = false;
+
+    std::string m_resumptionKey;
+
+    TrafficSecret m_rxSecret;
+    TrafficSecret m_txSecret;
+    std::string m_ktlsControl;      // a handshake message split across control records
+
+    size_t m_smallRecord = 0;       // 0: record sizing off
+    size_t m_smallRecordBytes = 0;
+    int64_t m_recordIdle = 0;       // microseconds
+    int64_t m_lastWrite = INT64_MIN / 2;
+    size_t m_smallLeft = 0;         // budget left for small records
+    bool m_kernelSmallRecords = false;
+    bool m_kernelRecordLimit = true;    // until a setsockopt says otherwise
 };
 
+// The negative errno ssl::Send and ssl::Recv return for an SSL_get_error code they do not handle:
+// a failed syscall's errno on a socket BIO, where OpenSSL made it, -ECONNRESET for a syscall
+// error without one (the peer went away mid-record), else -EPROTO
+//
+inline int SslErrno(int err, bool socketBio)
+{
+    if (err == SSL_ERROR_SYSCALL)
+    {
+        return socketBio && errno != 0 ? -errno : -ECONNRESET;
+    }
+    return -EPROTO;
+}
+
 } // end namespace coop::io::ssl
 } // end namespace coop::io
 } // end namespace coop
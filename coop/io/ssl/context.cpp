@@ -1,14 +1,25 @@
 #include "context.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstring>
 
 #include <openssl/bio.h>
+#include <openssl/core_names.h>
 #include <openssl/crypto.h>
 #include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
 #include <openssl/pem.h>
+#include <openssl/rand.h>
 
 #include <spdlog/spdlog.h>
 
+#include "connection.h"
+#include "session_cache.h"
+#include "coop/cooperator.h"
+
 namespace coop
 {
 
@@ -34,11 +45,144 @@ static SSL_CTX* CreateCtx(Mode mode)
     return SSL_CTX_new(mode == Mode::Server ? TLS_server_method() : TLS_client_method());
 }
 
+// Server-side ALPN selection: our preference order wins (SSL_select_next_proto walks its first
+// list). No overlap means no ALPN rather than a failed handshake, so an old client still gets
+// HTTP/1.1.
+//
+static int SelectAlpn(SSL* /* ssl */, const unsigned char** out, unsigned char* outLen,
+                      const unsigned char* in, unsigned int inLen, void* arg)
+{
+    auto* ctx = static_cast<Context*>(arg);
+    unsigned char* selected = nullptr;
+    int ret = SSL_select_next_proto(&selected, outLen,
+        reinterpret_cast<const unsigned char*>(ctx->m_alpn.data()),
+        static_cast<unsigned int>(ctx->m_alpn.size()), in, inLen);
+    if (ret != OPENSSL_NPN_NEGOTIATED)
+    {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+    *out = selected;
+    return SSL_TLSEXT_ERR_OK;
+}
+
+// Server cache callbacks, keyed by session id. OpenSSL still hands over TLS 1.3 sessions that
+// travel as stateless tickets; there is nothing to look up later, so they are not kept.
+//
+static int NewServerSession(SSL* ssl, SSL_SESSION* session)
+{
+    if (SSL_version(ssl) >= TLS1_3_VERSION && !(SSL_get_options(ssl) & SSL_OP_NO_TICKET))
+    {
+        return 0;
+    }
+    unsigned int len = 0;
+    const unsigned char* id = SSL_SESSION_get_id(session, &len);
+    Context::From(ssl)->LocalSessions().Insert(
+        std::string(reinterpret_cast<const char*>(id), len), session);
+    return 1;
+}
+
+static SSL_SESSION* GetServerSession(SSL* ssl, const unsigned char* id, int len, int* copy)
+{
+    // The cache keeps its reference; OpenSSL takes one of its own
+    //
+    *copy = 1;
+    return Context::From(ssl)->LocalSessions().Find(
+        std::string(reinterpret_cast<const char*>(id), len));
+}
+
+static void RemoveServerSession(SSL_CTX* sslCtx, SSL_SESSION* session)
+{
+    auto* ctx = static_cast<Context*>(SSL_CTX_get_app_data(sslCtx));
+    if (!Cooperator::thread_cooperator || !ctx)
+    {
+        return;
+    }
+    unsigned int len = 0;
+    const unsigned char* id = SSL_SESSION_get_id(session, &len);
+    ctx->LocalSessions().Erase(std::string(reinterpret_cast<const char*>(id), len));
+}
+
+// Client: keep a session the server issued under its connection's resumption key. TLS 1.3
+// tickets arrive after the handshake, during a later Recv.
+//
+static int NewClientSession(SSL* ssl, SSL_SESSION* session)
+{
+    auto* conn = static_cast<Connection*>(SSL_get_app_data(ssl));
+    if (!conn || conn->ResumptionKey().empty() || !SSL_SESSION_is_resumable(session))
+    {
+        return 0;
+    }
+    Context::From(ssl)->LocalSessions().Insert(std::string(conn->ResumptionKey()), session);
+    return 1;
+}
+
+// Seal a new ticket under the current key, or open one under whichever key named it. 2 asks
+// OpenSSL to reissue the ticket under the current key, 0 to ignore it (full handshake).
+//
+static int TicketKeyCallback(SSL* ssl, unsigned char* name, unsigned char* iv,
+                             EVP_CIPHER_CTX* cipher, EVP_MAC_CTX* mac, int enc)
+{
+    auto const& keys = Context::From(ssl)->m_ticketKeys->Local();
+    if (keys.empty())
+    {
+        return 0;
+    }
+
+    const TicketKeys::Key* key = nullptr;
+    int ret = 1;
+    if (enc)
+    {
+        key = &keys.front();
+        memcpy(name, key->name, TicketKeys::NAME_SIZE);
+        if (RAND_bytes(iv, EVP_CIPHER_get_iv_length(EVP_aes_256_cbc())) != 1)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        for (auto const& k : keys)
+        {
+            if (memcmp(name, k.name, TicketKeys::NAME_SIZE) == 0)
+            {
+                key = &k;
+                break;
+            }
+        }
+        if (!key)
+        {
+            return 0;
+        }
+        ret = key == &keys.front() ? 1 : 2;
+    }
+
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY,
+            const_cast<unsigned char*>(key->hmac), sizeof(key->hmac)),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>("SHA256"), 0),
+        OSSL_PARAM_construct_end(),
+    };
+    if (EVP_MAC_CTX_set_params(mac, params) != 1)
+    {
+        return -1;
+    }
+    int ok = enc ? EVP_EncryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key->aes, iv)
+                 : EVP_DecryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key->aes, iv);
+    return ok == 1 ? ret : -1;
+}
+
+static long Seconds(time::Interval interval)
+{
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::seconds>(interval).count());
+}
+
 Context::Context(Mode mode)
 : m_ctx(CreateCtx(mode))
 , m_mode(mode)
+, m_id(NextCacheId())
 {
     assert(m_ctx);
+    SSL_CTX_set_app_data(m_ctx, this);
     spdlog::info("ssl context created mode={}",
         mode == Mode::Server ? "server" : "client");
 }
@@ -129,10 +273,136 @@ bool Context::LoadPrivateKey(const char* pem, size_t len)
     return true;
 }
 
-void Context::EnableKTLS()
+// Hand each kTLS connection its traffic secrets, for the RX install and KeyUpdates OpenSSL 3.0
+// leaves to us
+//
+static void KeyLog(const SSL* ssl, const char* line)
+{
+    if (auto* conn = static_cast<Connection*>(SSL_get_app_data(const_cast<SSL*>(ssl))))
+    {
+        conn->OnKeyLog(line);
+    }
+}
+
+void Context::EnableKTLS(bool zerocopySendfile)
 {
     SSL_CTX_set_options(m_ctx, SSL_OP_ENABLE_KTLS);
-    spdlog::info("ssl ktls enabled");
+    SSL_CTX_set_keylog_callback(m_ctx, KeyLog);
+    m_ktlsZerocopySendfile = zerocopySendfile;
+    spdlog::info("ssl ktls enabled zerocopy_sendfile={}", zerocopySendfile);
+}
+
+bool Context::SetAlpnProtocols(const char* const* protocols, int count)
+{
+    std::string wire;
+    for (int i = 0; i < count; i++)
+    {
+        size_t len = strlen(protocols[i]);
+        if (len == 0 || len > 255)
+        {
+            spdlog::error("ssl alpn protocol length={} out of range", len);
+            return false;
+        }
+        wire.push_back(static_cast<char>(len));
+        wire.append(protocols[i], len);
+    }
+    if (wire.empty())
+    {
+        return false;
+    }
+
+    if (m_mode == Mode::Client && SSL_CTX_set_alpn_protos(m_ctx,
+            reinterpret_cast<const unsigned char*>(wire.data()),
+            static_cast<unsigned int>(wire.size())) != 0)
+    {
+        spdlog::error("ssl failed to set alpn protocols");
+        return false;
+    }
+    m_alpn = std::move(wire);
+    if (m_mode == Mode::Server)
+    {
+        SSL_CTX_set_alpn_select_cb(m_ctx, SelectAlpn, this);
+    }
+    spdlog::info("ssl alpn protocols count={}", count);
+    return true;
+}
+
+void Context::EnableSessionCache(size_t capacity, time::Interval lifetime)
+{
+    assert(m_mode == Mode::Server);
+    m_sessionCacheSize = std::max<size_t>(capacity, 1);
+
+    static const unsigned char sidContext[] = "coop";
+    SSL_CTX_set_session_id_context(m_ctx, sidContext, sizeof(sidContext) - 1);
+    SSL_CTX_set_session_cache_mode(m_ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(m_ctx, NewServerSession);
+    SSL_CTX_sess_set_get_cb(m_ctx, GetServerSession);
+    SSL_CTX_sess_set_remove_cb(m_ctx, RemoveServerSession);
+    SSL_CTX_set_timeout(m_ctx, Seconds(lifetime));
+
+    // Stateful TLS 1.3 tickets too, so every resumption goes through the cache
+    //
+    if (!m_ticketKeys)
+    {
+        SSL_CTX_set_options(m_ctx, SSL_OP_NO_TICKET);
+    }
+    spdlog::info("ssl session cache enabled capacity={}", m_sessionCacheSize);
+}
+
+void Context::EnableSessionTickets(TicketKeys* keys, time::Interval lifetime)
+{
+    assert(m_mode == Mode::Server && keys);
+    m_ticketKeys = keys;
+
+    SSL_CTX_clear_options(m_ctx, SSL_OP_NO_TICKET);
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(m_ctx, TicketKeyCallback);
+    SSL_CTX_set_timeout(m_ctx, Seconds(lifetime));
+    if (m_sessionCacheSize == 0)
+    {
+        SSL_CTX_set_session_cache_mode(m_ctx, SSL_SESS_CACHE_OFF);
+    }
+    spdlog::info("ssl session tickets enabled");
+}
+
+void Context::EnableSessionResumption(size_t capacity)
+{
+    assert(m_mode == Mode::Client);
+    m_sessionCacheSize = std::max<size_t>(capacity, 1);
+
+    SSL_CTX_set_session_cache_mode(m_ctx,
+        SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(m_ctx, NewClientSession);
+    spdlog::info("ssl session resumption enabled capacity={}", m_sessionCacheSize);
+}
+
+void Context::OffloadHandshakes(bool enable)
+{
+    m_offloadHandshakes = enable;
+    spdlog::info("ssl handshake offload {}", enable ? "enabled" : "disabled");
+}
+
+void Context::SetRecordSizing(size_t smallRecord /* = SMALL_RECORD */,
+                              size_t smallBytes /* = 10 * SMALL_RECORD */,
+                              time::Interval idle /* = std::chrono::seconds(1) */)
+{
+    // A record carries at most 16KB of plaintext anyway
+    //
+    m_smallRecord = std::min<size_t>(smallRecord, 16384);
+    m_smallRecordBytes = smallBytes;
+    m_recordIdle = idle;
+    spdlog::info("ssl record sizing small={} bytes={} idle_ms={}", m_smallRecord, smallBytes,
+                 std::chrono::duration_cast<std::chrono::milliseconds>(idle).count());
+}
+
+SessionCache& Context::LocalSessions()
+{
+    assert(m_sessionCacheSize > 0);
+    return LocalSessionCache(m_id, m_sessionCacheSize);
+}
+
+Context* Context::From(SSL* ssl)
+{
+    return static_cast<Context*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
 }
 
 } // end namespace coop::io::ssl
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <string>
 #include <openssl/ssl.h>
 
+#include "coop/time/interval.h"
+
 namespace coop
 {
 
@@ -12,6 +16,9 @@ namespace io
 namespace ssl
 {
 
+struct SessionCache;
+struct TicketKeys;
+
 // Mode determines whether this context will be used for accepting (Server) or initiating (Client)
 // TLS connections. This selects the appropriate OpenSSL method (TLS_server_method vs
 // TLS_client_method) at construction time.
@@ -57,10 +64,98 @@ struct Context
     // a TCP socket (not AF_UNIX) and a socket BIO connection. Must be called before any
     // connections are created from this context.
     //
-    void EnableKTLS();
+    // TLS 1.3 receive, which OpenSSL 3.0 leaves in userspace, is installed by the connection
+    // itself (socket BIO, from the traffic secrets OpenSSL logs), with KeyUpdates followed in
+    // ssl::Recv. zerocopySendfile sets TLS_TX_ZEROCOPY_RO (5.19+): ssl::Sendfile then encrypts
+    // straight from the page cache, so a file must not change while it is being sent.
+    //
+    void EnableKTLS(bool zerocopySendfile = false);
+
+    // Negotiate an application protocol with ALPN, e.g. {"h2", "http/1.1"} to offer HTTP/2. A
+    // server picks the first of these, in this order, that the client also offers, and carries on
+    // without ALPN when there is none; a client offers them all. The result is
+    // Connection::AlpnProtocol(). Returns false (changing nothing) for an empty list or a name
+    // that is empty or longer than 255 bytes. Must be called before any connections are created
+    // from this context.
+    //
+    bool SetAlpnProtocols(const char* const* protocols, int count);
+
+    // Server: keep sessions for resumption by session id (TLS 1.2) or stateful ticket (TLS 1.3)
+    // in a SessionCache per cooperator, capacity sessions each, in place of OpenSSL's internal
+    // cache -- one store for every thread, behind a lock. A session resumes only on the
+    // cooperator that made it, so without EnableSessionTickets a client landing on another thread
+    // gets a full handshake. Must be called before any connections are created from this context.
+    //
+    void EnableSessionCache(size_t capacity = 1024,
+                            time::Interval lifetime = std::chrono::hours(2));
+
+    // Server: issue stateless tickets sealed with keys, which resume on any cooperator and any
+    // Context sharing them. keys must outlive this context; rotate them with TicketKeys::Rotate.
+    // Without EnableSessionCache, OpenSSL's internal cache is switched off: tickets carry the
+    // whole session. Must be called before any connections are created from this context.
+    //
+    void EnableSessionTickets(TicketKeys* keys, time::Interval lifetime = std::chrono::hours(2));
+
+    // Client: keep the sessions servers hand us, capacity per cooperator, under each connection's
+    // Connection::SetResumptionKey, and offer one when a connection with the same key connects.
+    // Must be called before any connections are created from this context.
+    //
+    void EnableSessionResumption(size_t capacity = 256);
+
+    // Run the CPU-heavy handshake steps -- those processing a peer flight: key exchange,
+    // certificate signing and verification -- as Ergs on the calling cooperator's work::Grid
+    // while the connection's context waits, so a burst of handshakes is spread over the grid
+    // instead of stalling every other context on the accepting core. The wait is uninterruptible
+    // (the Erg borrows the SSL object); a kill-aware handshake notices a kill at its next I/O
+    // wait. Off-grid cooperators handshake inline. OpenSSL callbacks (session cache, tickets,
+    // ALPN) then run on whichever cooperator took the step, so a stateful EnableSessionCache
+    // entry lands in that cooperator's cache; tickets resume anywhere.
+    //
+    void OffloadHandshakes(bool enable = true);
+
+    // Dynamic record sizing. After an idle spell of at least idle -- and so at the start of every
+    // connection -- the first smallBytes of application data go out in records of at most
+    // smallRecord bytes, each small enough to ride in one TCP segment, so the peer can decrypt
+    // and act on the first bytes of a response as soon as they land rather than after a whole
+    // 16KB record has crossed a cold congestion window. Later writes make full records. The
+    // default budget is ten records, the initial congestion window (RFC 6928). With kTLS TX it
+    // is the kernel that splits, through TLS_TX_MAX_PAYLOAD_LEN where the kernel has it, else
+    // the connection hands it one record's worth per write. A smallRecord of 0 turns sizing off.
+    // Must be called before any connections are created from this context.
+    //
+    static constexpr size_t SMALL_RECORD = 1400;
+
+    void SetRecordSizing(size_t smallRecord = SMALL_RECORD, size_t smallBytes = 10 * SMALL_RECORD,
+                         time::Interval idle = std::chrono::seconds(1));
+
+    // The calling cooperator's session cache; only once one of the above enabled it
+    //
+    SessionCache& LocalSessions();
+
+    // The Context an SSL object was made from
+    //
+    static Context* From(SSL* ssl);
+
+    SSL_CTX*    m_ctx;
+    Mode        m_mode;
+
+    // Protocols in ALPN wire format: each name prefixed by its length
+    //
+    std::string m_alpn;
+
+    // Session resumption. m_id names this context's per-cooperator caches; a capacity of 0 means
+    // no cache.
+    //
+    uint64_t    m_id;
+    size_t      m_sessionCacheSize = 0;
+    TicketKeys* m_ticketKeys = nullptr;
+
+    bool        m_offloadHandshakes = false;
+    bool        m_ktlsZerocopySendfile = false;
 
-    SSL_CTX* m_ctx;
-    Mode     m_mode;
+    size_t          m_smallRecord = SMALL_RECORD;
+    size_t          m_smallRecordBytes = 10 * SMALL_RECORD;
+    time::Interval  m_recordIdle = std::chrono::seconds(1);
 };
 
 } // end namespace coop::io::ssl
@@ -0,0 +1,213 @@
+#include "ktls.h"
+
+#include <cerrno>
+#include <cstring>
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/kdf.h>
+#include <openssl/params.h>
+#include <spdlog/spdlog.h>
+
+#include "connection.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/poll.h"
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+
+namespace coop
+{
+
+namespace io
+{
+
+namespace ssl
+{
+
+TrafficSecret::~TrafficSecret()
+{
+    OPENSSL_cleanse(data, sizeof(data));
+}
+
+// HKDF-Expand-Label(secret, label, "", outLen) (RFC 8446 7.1)
+//
+static bool ExpandLabel(const EVP_MD* md, TrafficSecret const& secret, const char* label,
+                        unsigned char* out, size_t outLen)
+{
+    unsigned char info[2 + 1 + 255 + 1];
+    size_t labelLen = strlen(label);
+    size_t n = 0;
+    info[n++] = static_cast<unsigned char>(outLen >> 8);
+    info[n++] = static_cast<unsigned char>(outLen);
+    info[n++] = static_cast<unsigned char>(6 + labelLen);
+    memcpy(info + n, "tls13 ", 6);
+    n += 6;
+    memcpy(info + n, label, labelLen);
+    n += labelLen;
+    info[n++] = 0;
+
+    EVP_KDF* kdf = EVP_KDF_fetch(nullptr, "HKDF", nullptr);
+    EVP_KDF_CTX* kctx = kdf ? EVP_KDF_CTX_new(kdf) : nullptr;
+    EVP_KDF_free(kdf);
+    if (!kctx)
+    {
+        return false;
+    }
+
+    int mode = EVP_KDF_HKDF_MODE_EXPAND_ONLY;
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_int(OSSL_KDF_PARAM_MODE, &mode),
+        OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST,
+            const_cast<char*>(EVP_MD_get0_name(md)), 0),
+        OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_KEY,
+            const_cast<unsigned char*>(secret.data), secret.len),
+        OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_INFO, info, n),
+        OSSL_PARAM_construct_end(),
+    };
+    bool ok = EVP_KDF_derive(kctx, out, outLen, params) == 1;
+    EVP_KDF_CTX_free(kctx);
+    return ok;
+}
+
+// Fill a kernel crypto_info from the secret. TLS 1.3 has no explicit nonce: the kernel's salt is
+// the head of the derived IV and its iv field the rest (all of it for ChaCha20, saltless).
+//
+template<typename Info>
+static bool Fill(Info* info, uint16_t cipherType, const EVP_MD* md,
+                 TrafficSecret const& secret, uint64_t seq)
+{
+    static_assert(sizeof(info->salt) + sizeof(info->iv) == 12);
+    unsigned char iv[12];
+    if (!ExpandLabel(md, secret, "key", info->key, sizeof(info->key)) ||
+        !ExpandLabel(md, secret, "iv", iv, sizeof(iv)))
+    {
+        return false;
+    }
+    info->info.version = TLS_1_3_VERSION;
+    info->info.cipher_type = cipherType;
+    memcpy(info->salt, iv, sizeof(info->salt));
+    memcpy(info->iv, iv + sizeof(info->salt), sizeof(info->iv));
+    for (size_t i = 0; i < sizeof(info->rec_seq); i++)
+    {
+        info->rec_seq[i] = static_cast<unsigned char>(seq >> (56 - 8 * i));
+    }
+    OPENSSL_cleanse(iv, sizeof(iv));
+    return true;
+}
+
+template<typename Info>
+static bool Set(int fd, int direction, uint16_t cipherType, const EVP_MD* md,
+                TrafficSecret const& secret, uint64_t seq)
+{
+    Info info;
+    memset(&info, 0, sizeof(info));
+    bool ok = Fill(&info, cipherType, md, secret, seq) &&
+              ::setsockopt(fd, SOL_TLS, direction, &info, sizeof(info)) == 0;
+    int saved = errno;
+    OPENSSL_cleanse(&info, sizeof(info));
+    errno = saved;
+    return ok;
+}
+
+bool InstallKtls13(int fd, int direction, const SSL_CIPHER* cipher, TrafficSecret const& secret,
+                   uint64_t seq)
+{
+    if (::setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) != 0 && errno != EEXIST)
+    {
+        SPDLOG_DEBUG("ssl ktls fd={} no tls ulp errno={}", fd, errno);
+        return false;
+    }
+
+    const EVP_MD* md = SSL_CIPHER_get_handshake_digest(cipher);
+    bool ok = false;
+    switch (SSL_CIPHER_get_id(cipher) & 0xffff)
+    {
+    case 0x1301:    // TLS_AES_128_GCM_SHA256
+        ok = Set<tls12_crypto_info_aes_gcm_128>(fd, direction, TLS_CIPHER_AES_GCM_128, md,
+                                                secret, seq);
+        break;
+    case 0x1302:    // TLS_AES_256_GCM_SHA384
+        ok = Set<tls12_crypto_info_aes_gcm_256>(fd, direction, TLS_CIPHER_AES_GCM_256, md,
+                                                secret, seq);
+        break;
+    case 0x1303:    // TLS_CHACHA20_POLY1305_SHA256
+        ok = Set<tls12_crypto_info_chacha20_poly1305>(fd, direction,
+                                                      TLS_CIPHER_CHACHA20_POLY1305, md,
+                                                      secret, seq);
+        break;
+    default:
+        SPDLOG_DEBUG("ssl ktls fd={} cipher {} has no kernel counterpart", fd,
+            SSL_CIPHER_get_name(cipher));
+        return false;
+    }
+    if (!ok)
+    {
+        SPDLOG_DEBUG("ssl ktls fd={} {} install failed errno={}", fd,
+            direction == TLS_RX ? "rx" : "tx", errno);
+    }
+    return ok;
+}
+
+bool NextTrafficSecret(const SSL_CIPHER* cipher, TrafficSecret* secret)
+{
+    TrafficSecret next;
+    next.len = secret->len;
+    if (!ExpandLabel(SSL_CIPHER_get_handshake_digest(cipher), *secret, "traffic upd", next.data,
+                     next.len))
+    {
+        return false;
+    }
+    memcpy(secret->data, next.data, next.len);
+    return true;
+}
+
+int SendKtlsRecord(Connection& conn, uint8_t type, const void* data, size_t len, bool killAware)
+{
+    char control[CMSG_SPACE(sizeof(type))];
+    memset(control, 0, sizeof(control));
+    iovec iov{const_cast<void*>(data), len};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_TLS;
+    cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(type));
+    memcpy(CMSG_DATA(cmsg), &type, sizeof(type));
+
+    for (;;)
+    {
+        ssize_t ret = ::sendmsg(conn.m_desc.m_fd, &msg, 0);
+        if (ret == static_cast<ssize_t>(len))
+        {
+            return 0;
+        }
+        if (ret >= 0)
+        {
+            spdlog::warn("ssl ktls fd={} control record cut short", conn.m_desc.m_fd);
+            return -1;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            int r = killAware ? io::PollKill(conn.m_desc, POLLOUT)
+                              : io::Poll(conn.m_desc, POLLOUT);
+            if (r < 0) return -1;
+            continue;
+        }
+        spdlog::warn("ssl ktls fd={} control record send errno={}", conn.m_desc.m_fd, errno);
+        return -1;
+    }
+}
+
+} // end namespace coop::io::ssl
+} // end namespace coop::io
+} // end namespace coop
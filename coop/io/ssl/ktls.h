@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+
+namespace coop
+{
+
+namespace io
+{
+
+namespace ssl
+{
+
+// A TLS 1.3 application traffic secret, as OpenSSL reports it to its keylog callback
+// (CLIENT_TRAFFIC_SECRET_0 / SERVER_TRAFFIC_SECRET_0). Kept by a Connection on a kTLS context so
+// it can install kernel state OpenSSL 3.0 will not (TLS 1.3 RX) and follow KeyUpdates.
+//
+struct TrafficSecret
+{
+    unsigned char   data[EVP_MAX_MD_SIZE];
+    size_t          len = 0;
+
+    ~TrafficSecret();
+};
+
+// Install kernel TLS state for direction (TLS_TX or TLS_RX) on a TCP socket: the record key and
+// IV derived from secret (RFC 8446 7.3) and the next record's sequence number. Also attaches the
+// "tls" ULP if nothing has yet. False when the cipher has no kernel counterpart or the kernel
+// refuses -- no TLS 1.3 RX (before 5.x), or no rekey (before 6.14) when replacing state.
+//
+bool InstallKtls13(int fd, int direction, const SSL_CIPHER* cipher, TrafficSecret const& secret,
+                   uint64_t seq);
+
+// Advance secret past a KeyUpdate: application_traffic_secret_N+1 (RFC 8446 7.2)
+//
+bool NextTrafficSecret(const SSL_CIPHER* cipher, TrafficSecret* secret);
+
+// Send one record of type (a handshake message, say) through kTLS TX, waiting for writability.
+// Returns 0, or -1 on error.
+//
+struct Connection;
+int SendKtlsRecord(Connection& conn, uint8_t type, const void* data, size_t len, bool killAware);
+
+} // end namespace coop::io::ssl
+} // end namespace coop::io
+} // end namespace coop
@@ -1,7 +1,10 @@
 #include "recv.h"
 
 #include <cerrno>
+#include <cstdint>
+#include <linux/tls.h>
 #include <poll.h>
+#include <sys/socket.h>
 #include <unistd.h>
 #include <openssl/ssl.h>
 #include <spdlog/spdlog.h>
@@ -9,6 +12,7 @@
 #include "connection.h"
 #include "coop/io/descriptor.h"
 #include "coop/io/poll.h"
+#include "coop/io/recv.h"
 
 namespace coop
 {
@@ -19,18 +23,38 @@ namespace io
 namespace ssl
 {
 
-// kTLS RX recv — read() directly, kernel handles decryption. Falls back to readiness waits when
-// no data available (EAGAIN). First call typically returns EAGAIN (receiver called before
-// sender), but if data is already buffered, returns immediately without uring.
+// kTLS RX control path — recvmsg(), which names each record's type in a TLS_GET_RECORD_TYPE cmsg:
+// alerts, KeyUpdates and session tickets go to KtlsControl, and the loop reads on until data
+// arrives. Readiness waits on EAGAIN.
 //
-static int RecvKtls(Connection& conn, void* buf, size_t size, bool killAware)
+static int RecvKtlsMsg(Connection& conn, void* buf, size_t size, bool killAware)
 {
-    SPDLOG_TRACE("ssl ktls recv fd={} maxsize={}", conn.m_desc.m_fd, size);
+    constexpr uint8_t APPLICATION_DATA = 23;
     for (;;)
     {
-        ssize_t ret = ::read(conn.m_desc.m_fd, buf, size);
+        char control[CMSG_SPACE(sizeof(uint8_t))];
+        iovec iov{buf, size};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t ret = ::recvmsg(conn.m_desc.m_fd, &msg, 0);
         if (ret > 0)
         {
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+            uint8_t type = APPLICATION_DATA;
+            if (cmsg && cmsg->cmsg_level == SOL_TLS && cmsg->cmsg_type == TLS_GET_RECORD_TYPE)
+            {
+                type = *CMSG_DATA(cmsg);
+            }
+            if (type != APPLICATION_DATA)
+            {
+                int r = conn.KtlsControl(type, static_cast<const char*>(buf), ret, killAware);
+                if (r <= 0) return r < 0 ? -EPROTO : 0;
+                continue;
+            }
             SPDLOG_TRACE("ssl ktls recv fd={} read={}", conn.m_desc.m_fd, ret);
             return (int)ret;
         }
@@ -40,13 +64,35 @@ static int RecvKtls(Connection& conn, void* buf, size_t size, bool killAware)
         {
             SPDLOG_TRACE("ssl ktls recv fd={} EAGAIN", conn.m_desc.m_fd);
             int r = killAware ? io::PollKill(conn.m_desc, POLLIN) : io::Poll(conn.m_desc, POLLIN);
-            if (r < 0) return -1;
+            if (r < 0) return r;
             continue;
         }
 
-        spdlog::warn("ssl ktls recv fd={} errno={}", conn.m_desc.m_fd, errno);
-        return -1;
+        int err = errno;
+        spdlog::warn("ssl ktls recv fd={} errno={}", conn.m_desc.m_fd, err);
+        return -err;
+    }
+}
+
+// kTLS RX recv — the kernel decrypts, so this is a plain socket recv: a nonblocking recv() when
+// data is already buffered, else an io_uring recv that completes when it lands (one wake, no poll
+// and retry). The kernel hands a control record only to a caller with room for its type cmsg and
+// fails a plain recv with EIO, leaving the record queued; that goes to RecvKtlsMsg.
+//
+static int RecvKtls(Connection& conn, void* buf, size_t size, bool killAware)
+{
+    SPDLOG_TRACE("ssl ktls recv fd={} maxsize={}", conn.m_desc.m_fd, size);
+    int ret = killAware ? io::RecvFastpathKill(conn.m_desc, buf, size)
+                        : io::RecvFastpath(conn.m_desc, buf, size);
+    if (ret == -EIO)
+    {
+        return RecvKtlsMsg(conn, buf, size, killAware);
     }
+    if (ret < 0 && ret != -ECANCELED)
+    {
+        spdlog::warn("ssl ktls recv fd={} err={}", conn.m_desc.m_fd, ret);
+    }
+    return ret;
 }
 
 // Socket BIO recv — SSL_read operates on the real fd, readiness waits for cooperative waiting.
@@ -71,7 +117,7 @@ static int RecvSocketBio(Connection& conn, void* buf, size_t size, bool killAwar
         {
             SPDLOG_TRACE("ssl socket-bio recv fd={} WANT_READ", conn.m_desc.m_fd);
             int r = killAware ? io::PollKill(conn.m_desc, POLLIN) : io::Poll(conn.m_desc, POLLIN);
-            if (r < 0) return -1;
+            if (r < 0) return r;
             break;
         }
 
@@ -81,7 +127,7 @@ static int RecvSocketBio(Connection& conn, void* buf, size_t size, bool killAwar
             //
             SPDLOG_TRACE("ssl socket-bio recv fd={} WANT_WRITE", conn.m_desc.m_fd);
             int r = killAware ? io::PollKill(conn.m_desc, POLLOUT) : io::Poll(conn.m_desc, POLLOUT);
-            if (r < 0) return -1;
+            if (r < 0) return r;
             break;
         }
 
@@ -89,19 +135,23 @@ static int RecvSocketBio(Connection& conn, void* buf, size_t size, bool killAwar
             return 0;
 
         default:
-            spdlog::warn("ssl socket-bio recv fd={} error={}", conn.m_desc.m_fd, err);
-            return -1;
+        {
+            int code = SslErrno(err, true);
+            spdlog::warn("ssl socket-bio recv fd={} error={} errno={}", conn.m_desc.m_fd, err,
+                         -code);
+            return code;
+        }
         }
     }
 }
 
 // Receive plaintext data from a TLS connection. Dispatches based on connection mode:
 //
-//   kTLS RX:     read() directly, kernel decrypts + readiness waits on EAGAIN
+//   kTLS RX:     recv() directly, kernel decrypts; io_uring recv on EAGAIN
 //   Socket BIO:  SSL_read on real fd + readiness waits
 //   Memory BIO:  FeedRead -> rbio -> SSL_read (existing path)
 //
-// Returns bytes read on success, negative on error, 0 on clean shutdown.
+// Returns bytes read on success, a negative errno on error, 0 on clean shutdown.
 //
 int RecvImpl(Connection& conn, void* buf, size_t size, bool killAware)
 {
@@ -114,7 +164,7 @@ int RecvImpl(Connection& conn, void* buf, size_t size, bool killAware)
 
     // Socket BIO without kTLS: SSL_read on real fd + readiness waits
     //
-    if (conn.m_buffer == nullptr)
+    if (conn.m_rbio == nullptr)
     {
         return RecvSocketBio(conn, buf, size, killAware);
     }
@@ -136,13 +186,13 @@ int RecvImpl(Connection& conn, void* buf, size_t size, bool killAware)
         {
         case SSL_ERROR_WANT_READ:
             SPDLOG_TRACE("ssl recv fd={} WANT_READ", conn.m_desc.m_fd);
-            if (conn.FlushWrite(killAware) < 0)
+            if (int r = conn.FlushWrite(killAware); r < 0)
             {
-                return -1;
+                return r;
             }
-            if (conn.FeedRead(killAware) <= 0)
+            if (int r = conn.FeedRead(killAware); r <= 0)
             {
-                return -1;
+                return r < 0 ? r : -ECONNRESET;  // closed without close_notify
             }
             break;
 
@@ -150,9 +200,9 @@ int RecvImpl(Connection& conn, void* buf, size_t size, bool killAware)
             // Can happen during TLS renegotiation.
             //
             SPDLOG_TRACE("ssl recv fd={} WANT_WRITE", conn.m_desc.m_fd);
-            if (conn.FlushWrite(killAware) < 0)
+            if (int r = conn.FlushWrite(killAware); r < 0)
             {
-                return -1;
+                return r;
             }
             break;
 
@@ -161,7 +211,7 @@ int RecvImpl(Connection& conn, void* buf, size_t size, bool killAware)
 
         default:
             spdlog::warn("ssl recv fd={} error={}", conn.m_desc.m_fd, err);
-            return -1;
+            return SslErrno(err, false);
         }
     }
 }
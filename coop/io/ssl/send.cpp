@@ -1,5 +1,6 @@
 #include "send.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <poll.h>
 #include <unistd.h>
@@ -9,6 +10,7 @@
 #include "connection.h"
 #include "coop/io/descriptor.h"
 #include "coop/io/poll.h"
+#include "coop/io/send.h"
 
 namespace coop
 {
@@ -19,34 +21,41 @@ namespace io
 namespace ssl
 {
 
-// kTLS TX send — write() directly, kernel handles encryption. Falls back to readiness waits when
-// the socket buffer is full (EAGAIN). Avoids uring for the common case where the write
-// succeeds immediately, matching the synchronous-when-possible pattern of SendSocketBio.
+// kTLS TX send — kernel encrypts, so this is a plain socket send: a nonblocking send() when the
+// socket has room (the usual case, no uring round trip), else an io_uring send that completes once
+// it does. Waiting on the send itself rather than polling and retrying saves a wake and a syscall,
+// and the submission is batched with the cooperator's others like any plaintext send.
+//
+// The kernel frames each send as its own records, so while small records are due and it cannot
+// be told to cut them itself, the bytes go a record's worth per send.
 //
 static int SendKtls(Connection& conn, const void* buf, size_t size, bool killAware)
 {
     SPDLOG_TRACE("ssl ktls send fd={} size={}", conn.m_desc.m_fd, size);
-    for (;;)
+    size_t done = 0;
+    while (done < size)
     {
-        ssize_t ret = ::write(conn.m_desc.m_fd, buf, size);
-        if (ret > 0)
+        size_t n = std::min(size - done, conn.RecordLimit());
+        const char* p = static_cast<const char*>(buf) + done;
+        int ret = killAware ? io::SendFastpathKill(conn.m_desc, p, n)
+                            : io::SendFastpath(conn.m_desc, p, n);
+        if (ret <= 0)
         {
-            SPDLOG_TRACE("ssl ktls send fd={} written={}", conn.m_desc.m_fd, ret);
-            return (int)ret;
+            if (ret < 0 && ret != -ECANCELED)
+            {
+                spdlog::warn("ssl ktls send fd={} err={}", conn.m_desc.m_fd, ret);
+            }
+            return done > 0 ? int(done) : ret;
         }
-        if (ret == 0) return 0;
-
-        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        conn.Wrote(size_t(ret));
+        done += size_t(ret);
+        if (size_t(ret) < n)
         {
-            SPDLOG_TRACE("ssl ktls send fd={} EAGAIN", conn.m_desc.m_fd);
-            int r = killAware ? io::PollKill(conn.m_desc, POLLOUT) : io::Poll(conn.m_desc, POLLOUT);
-            if (r < 0) return -1;
-            continue;
+            break;
         }
-
-        spdlog::warn("ssl ktls send fd={} errno={}", conn.m_desc.m_fd, errno);
-        return -1;
     }
+    SPDLOG_TRACE("ssl ktls send fd={} written={}", conn.m_desc.m_fd, done);
+    return int(done);
 }
 
 // Socket BIO send — SSL_write operates on the real fd, readiness waits for cooperative waiting.
@@ -55,13 +64,21 @@ static int SendKtls(Connection& conn, const void* buf, size_t size, bool killAwa
 static int SendSocketBio(Connection& conn, const void* buf, size_t size, bool killAware)
 {
     SPDLOG_TRACE("ssl socket-bio send fd={} size={}", conn.m_desc.m_fd, size);
+    size_t done = 0;
     for (;;)
     {
-        int ret = SSL_write(conn.m_ssl, buf, size);
+        size_t n = std::min(size - done, conn.RecordLimit());
+        int ret = SSL_write(conn.m_ssl, static_cast<const char*>(buf) + done, n);
         if (ret > 0)
         {
-            SPDLOG_TRACE("ssl socket-bio send fd={} written={}", conn.m_desc.m_fd, ret);
-            return ret;
+            conn.Wrote(size_t(ret));
+            done += size_t(ret);
+            if (done < size)
+            {
+                continue;
+            }
+            SPDLOG_TRACE("ssl socket-bio send fd={} written={}", conn.m_desc.m_fd, done);
+            return int(done);
         }
 
         int err = SSL_get_error(conn.m_ssl, ret);
@@ -71,7 +88,7 @@ static int SendSocketBio(Connection& conn, const void* buf, size_t size, bool ki
         {
             SPDLOG_TRACE("ssl socket-bio send fd={} WANT_WRITE", conn.m_desc.m_fd);
             int r = killAware ? io::PollKill(conn.m_desc, POLLOUT) : io::Poll(conn.m_desc, POLLOUT);
-            if (r < 0) return -1;
+            if (r < 0) return r;
             break;
         }
 
@@ -81,7 +98,7 @@ static int SendSocketBio(Connection& conn, const void* buf, size_t size, bool ki
             //
             SPDLOG_TRACE("ssl socket-bio send fd={} WANT_READ", conn.m_desc.m_fd);
             int r = killAware ? io::PollKill(conn.m_desc, POLLIN) : io::Poll(conn.m_desc, POLLIN);
-            if (r < 0) return -1;
+            if (r < 0) return r;
             break;
         }
 
@@ -89,19 +106,23 @@ static int SendSocketBio(Connection& conn, const void* buf, size_t size, bool ki
             return 0;
 
         default:
-            spdlog::warn("ssl socket-bio send fd={} error={}", conn.m_desc.m_fd, err);
-            return -1;
+        {
+            int code = SslErrno(err, true);
+            spdlog::warn("ssl socket-bio send fd={} error={} errno={}", conn.m_desc.m_fd, err,
+                         -code);
+            return code;
+        }
         }
     }
 }
 
 // Send plaintext data over a TLS connection. Dispatches based on connection mode:
 //
-//   kTLS TX:     write() directly, kernel encrypts + readiness waits on EAGAIN
+//   kTLS TX:     send() directly, kernel encrypts; io_uring send on EAGAIN
 //   Socket BIO:  SSL_write on real fd + readiness waits
 //   Memory BIO:  SSL_write -> wbio -> FlushWrite -> io::Send (existing path)
 //
-// Returns bytes written on success, negative on error, 0 on clean shutdown.
+// Returns bytes written on success, a negative errno on error, 0 on clean shutdown.
 //
 int SendImpl(Connection& conn, const void* buf, size_t size, bool killAware)
 {
@@ -114,27 +135,37 @@ int SendImpl(Connection& conn, const void* buf, size_t size, bool killAware)
 
     // Socket BIO without kTLS: SSL_write on real fd + readiness waits
     //
-    if (conn.m_buffer == nullptr)
+    if (conn.m_rbio == nullptr)
     {
         return SendSocketBio(conn, buf, size, killAware);
     }
 
-    // Memory BIO: existing path
+    // Memory BIO: existing path. Small records pile up in the wbio one SSL_write each, and the
+    // flush sends them together.
     //
     SPDLOG_TRACE("ssl send fd={} size={}", conn.m_desc.m_fd, size);
+    size_t done = 0;
     for (;;)
     {
-        int ret = SSL_write(conn.m_ssl, buf, size);
+        size_t n = std::min(size - done, conn.RecordLimit());
+        int ret = SSL_write(conn.m_ssl, static_cast<const char*>(buf) + done, n);
         if (ret > 0)
         {
+            conn.Wrote(size_t(ret));
+            done += size_t(ret);
+            if (done < size)
+            {
+                continue;
+            }
+
             // Plaintext was encrypted. Push the ciphertext out.
             //
-            SPDLOG_TRACE("ssl send fd={} written={}", conn.m_desc.m_fd, ret);
-            if (conn.FlushWrite(killAware) < 0)
+            SPDLOG_TRACE("ssl send fd={} written={}", conn.m_desc.m_fd, done);
+            if (int r = conn.FlushWrite(killAware); r < 0)
             {
-                return -1;
+                return r;
             }
-            return ret;
+            return int(done);
         }
 
         int err = SSL_get_error(conn.m_ssl, ret);
@@ -142,9 +173,9 @@ int SendImpl(Connection& conn, const void* buf, size_t size, bool killAware)
         {
         case SSL_ERROR_WANT_WRITE:
             SPDLOG_TRACE("ssl send fd={} WANT_WRITE", conn.m_desc.m_fd);
-            if (conn.FlushWrite(killAware) < 0)
+            if (int r = conn.FlushWrite(killAware); r < 0)
             {
-                return -1;
+                return r;
             }
             break;
 
@@ -152,13 +183,13 @@ int SendImpl(Connection& conn, const void* buf, size_t size, bool killAware)
             // Can happen during TLS renegotiation.
             //
             SPDLOG_TRACE("ssl send fd={} WANT_READ", conn.m_desc.m_fd);
-            if (conn.FlushWrite(killAware) < 0)
+            if (int r = conn.FlushWrite(killAware); r < 0)
             {
-                return -1;
+                return r;
             }
-            if (conn.FeedRead(killAware) <= 0)
+            if (int r = conn.FeedRead(killAware); r <= 0)
             {
-                return -1;
+                return r < 0 ? r : -ECONNRESET;  // closed without close_notify
             }
             break;
 
@@ -167,7 +198,7 @@ int SendImpl(Connection& conn, const void* buf, size_t size, bool killAware)
 
         default:
             spdlog::warn("ssl send fd={} error={}", conn.m_desc.m_fd, err);
-            return -1;
+            return SslErrno(err, false);
         }
     }
 }
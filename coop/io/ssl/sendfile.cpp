@@ -1,5 +1,7 @@
 #include "sendfile.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <unistd.h>
 #include <spdlog/spdlog.h>
 
@@ -18,13 +20,20 @@ namespace ssl
 
 static int SendfileImpl(Connection& conn, int in_fd, off_t offset, size_t count, bool killAware)
 {
-    // kTLS TX: kernel handles encryption, sendfile() directly — zero copies
+    // kTLS TX: kernel handles encryption, sendfile() directly — zero copies. Each call ends its
+    // records, so a small one is due, one small record's worth.
     //
     if (conn.m_ktlsTx)
     {
-        return killAware
+        count = std::min(count, conn.RecordLimit());
+        int ret = killAware
             ? io::SendfileKill(conn.m_desc, in_fd, offset, count)
             : io::Sendfile(conn.m_desc, in_fd, offset, count);
+        if (ret > 0)
+        {
+            conn.Wrote(size_t(ret));
+        }
+        return ret;
     }
 
     // Non-kTLS fallback: read from file, encrypt via SSL, send
@@ -54,13 +63,30 @@ int SendfileKill(Connection& conn, int in_fd, off_t offset, size_t count)
 
 static int SendfileAllImpl(Connection& conn, int in_fd, off_t offset, size_t count, bool killAware)
 {
-    // kTLS TX: kernel handles encryption, sendfile() directly — zero copies
+    // kTLS TX: kernel handles encryption, sendfile() directly — zero copies. Small records
+    // first, while they are due, then the rest in one go.
     //
     if (conn.m_ktlsTx)
     {
-        return killAware
-            ? io::SendfileAllKill(conn.m_desc, in_fd, offset, count)
-            : io::SendfileAll(conn.m_desc, in_fd, offset, count);
+        size_t total = 0;
+        for (size_t limit; total < count && (limit = conn.RecordLimit()) != SIZE_MAX;)
+        {
+            int sent = SendfileImpl(conn, in_fd, offset + off_t(total),
+                                    std::min(count - total, limit), killAware);
+            if (sent <= 0)
+            {
+                return total > 0 ? int(total) : sent;
+            }
+            total += size_t(sent);
+        }
+        if (total == count)
+        {
+            return int(count);
+        }
+        int sent = killAware
+            ? io::SendfileAllKill(conn.m_desc, in_fd, offset + off_t(total), count - total)
+            : io::SendfileAll(conn.m_desc, in_fd, offset + off_t(total), count - total);
+        return sent < 0 ? sent : int(total) + sent;
     }
 
     // Non-kTLS fallback: read from file in chunks, encrypt and send each
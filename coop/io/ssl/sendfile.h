@@ -15,7 +15,8 @@ struct Connection;
 
 // Send file data over a TLS connection. Dispatches based on connection mode:
 //
-//   kTLS TX:  sendfile() directly — kernel encrypts, zero userspace copies
+//   kTLS TX:  sendfile() directly — kernel encrypts, zero userspace copies (and none at all
+//             from the page cache with EnableKTLS(true))
 //   Other:    pread() into buffer, then ssl::Send (fallback)
 //
 // Returns bytes sent on success, 0 at EOF, -1 on error.
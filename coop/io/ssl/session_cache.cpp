@@ -0,0 +1,231 @@
+#include "session_cache.h"
+
+#include <algorithm>
+#include <ctime>
+#include <memory>
+
+#include <openssl/rand.h>
+#include <spdlog/spdlog.h>
+
+#include "coop/cooperator_var.h"
+#include "coop/cooperator_var.hpp"
+
+namespace coop
+{
+
+namespace io
+{
+
+namespace ssl
+{
+
+namespace
+{
+
+struct LocalTicketKeys
+{
+    uint64_t                        generation = UINT64_MAX;
+    std::vector<TicketKeys::Key>    keys;
+};
+
+struct CooperatorSessions
+{
+    std::unordered_map<uint64_t, std::unique_ptr<SessionCache>> caches;
+    std::unordered_map<uint64_t, LocalTicketKeys>               tickets;
+};
+
+CooperatorVar<CooperatorSessions> s_sessions;
+
+std::atomic<uint64_t> s_nextId{1};
+
+bool Expired(SSL_SESSION* session, time_t now)
+{
+    return !SSL_SESSION_is_resumable(session) ||
+           SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) <= now;
+}
+
+bool Generate(TicketKeys::Key* key)
+{
+    return RAND_bytes(key->name, sizeof(key->name)) == 1 &&
+           RAND_bytes(key->aes, sizeof(key->aes)) == 1 &&
+           RAND_bytes(key->hmac, sizeof(key->hmac)) == 1;
+}
+
+} // end anonymous namespace
+
+uint64_t NextCacheId()
+{
+    return s_nextId.fetch_add(1, std::memory_order_relaxed);
+}
+
+SessionCache& LocalSessionCache(uint64_t id, size_t capacity)
+{
+    auto& cache = s_sessions->caches[id];
+    if (!cache)
+    {
+        cache = std::make_unique<SessionCache>(capacity);
+    }
+    return *cache;
+}
+
+// -----------------------------------------------------------------------------
+// SessionCache
+// -----------------------------------------------------------------------------
+
+SessionCache::SessionCache(size_t capacity)
+: m_capacity(std::max<size_t>(capacity, 1))
+{
+}
+
+SessionCache::~SessionCache()
+{
+    for (auto& item : m_lru)
+    {
+        SSL_SESSION_free(item.session);
+    }
+}
+
+void SessionCache::Insert(std::string const& key, SSL_SESSION* session)
+{
+    auto& sessions = m_index[key];
+    if (sessions.size() >= PER_KEY)
+    {
+        Remove(sessions.front(), true);
+    }
+
+    m_lru.push_front(Item{key, session});
+    m_index[key].push_back(m_lru.begin());
+
+    if (m_lru.size() > m_capacity)
+    {
+        Remove(std::prev(m_lru.end()), true);
+    }
+}
+
+SSL_SESSION* SessionCache::Find(std::string const& key)
+{
+    auto it = Newest(key);
+    if (it == m_lru.end())
+    {
+        return nullptr;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it);
+    return it->session;
+}
+
+SSL_SESSION* SessionCache::Take(std::string const& key)
+{
+    auto it = Newest(key);
+    if (it == m_lru.end())
+    {
+        return nullptr;
+    }
+    SSL_SESSION* session = it->session;
+    Remove(it, false);
+    return session;
+}
+
+void SessionCache::Erase(std::string const& key)
+{
+    auto found = m_index.find(key);
+    if (found == m_index.end())
+    {
+        return;
+    }
+    for (auto it : found->second)
+    {
+        SSL_SESSION_free(it->session);
+        m_lru.erase(it);
+    }
+    m_index.erase(found);
+}
+
+// The key's newest session, dropping expired ones on the way
+//
+SessionCache::Iterator SessionCache::Newest(std::string const& key)
+{
+    time_t now = ::time(nullptr);
+    for (;;)
+    {
+        auto found = m_index.find(key);
+        if (found == m_index.end())
+        {
+            return m_lru.end();
+        }
+        auto it = found->second.back();
+        if (!Expired(it->session, now))
+        {
+            return it;
+        }
+        Remove(it, true);
+    }
+}
+
+void SessionCache::Remove(Iterator it, bool free)
+{
+    auto found = m_index.find(it->key);
+    auto& sessions = found->second;
+    sessions.erase(std::find(sessions.begin(), sessions.end(), it));
+    if (sessions.empty())
+    {
+        m_index.erase(found);
+    }
+    if (free)
+    {
+        SSL_SESSION_free(it->session);
+    }
+    m_lru.erase(it);
+}
+
+// -----------------------------------------------------------------------------
+// TicketKeys
+// -----------------------------------------------------------------------------
+
+TicketKeys::TicketKeys(size_t keep)
+: m_id(NextCacheId())
+, m_keep(std::max<size_t>(keep, 1))
+{
+    Key key;
+    if (!Generate(&key))
+    {
+        spdlog::error("ssl ticket key generation failed, no tickets until a rotation");
+        return;
+    }
+    m_keys.push_back(key);
+}
+
+bool TicketKeys::Rotate()
+{
+    Key key;
+    if (!Generate(&key))
+    {
+        spdlog::error("ssl ticket key generation failed, keeping the current keys");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_keys.insert(m_keys.begin(), key);
+    if (m_keys.size() > m_keep)
+    {
+        m_keys.resize(m_keep);
+    }
+    m_generation.fetch_add(1, std::memory_order_release);
+    SPDLOG_DEBUG("ssl ticket keys rotated generation={}", m_generation.load());
+    return true;
+}
+
+std::vector<TicketKeys::Key> const& TicketKeys::Local() const
+{
+    auto& local = s_sessions->tickets[m_id];
+    if (local.generation != Generation())
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        local.keys = m_keys;
+        local.generation = m_generation.load(std::memory_order_relaxed);
+    }
+    return local.keys;
+}
+
+} // end namespace coop::io::ssl
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <openssl/ssl.h>
+
+namespace coop
+{
+
+namespace io
+{
+
+namespace ssl
+{
+
+// SessionCache is an LRU of SSL_SESSION references by key, owned by one cooperator: lookups and
+// inserts touch no lock and no other thread's memory. Context keeps one per cooperator (see
+// Context::EnableSessionCache and EnableSessionResumption), keyed by session id on a server and
+// by Connection::SetResumptionKey on a client.
+//
+// A key may hold several sessions, newest first -- a TLS 1.3 server sends two tickets per
+// handshake, and a client wants one per connection it opens at once. Expired sessions are dropped
+// as lookups find them.
+//
+struct SessionCache
+{
+    static constexpr size_t PER_KEY = 4;
+
+    explicit SessionCache(size_t capacity);
+    ~SessionCache();
+
+    SessionCache(SessionCache const&) = delete;
+    SessionCache& operator=(SessionCache const&) = delete;
+
+    // Takes the caller's reference. The least recently used session goes past capacity, the
+    // key's oldest past PER_KEY.
+    //
+    void Insert(std::string const& key, SSL_SESSION* session);
+
+    // The key's newest live session, still owned by the cache, or nullptr
+    //
+    SSL_SESSION* Find(std::string const& key);
+
+    // As Find, but removes it: the reference passes to the caller
+    //
+    SSL_SESSION* Take(std::string const& key);
+
+    // Drop every session under key
+    //
+    void Erase(std::string const& key);
+
+    size_t Size() const { return m_lru.size(); }
+
+  private:
+    struct Item
+    {
+        std::string     key;
+        SSL_SESSION*    session;
+    };
+    using Iterator = std::list<Item>::iterator;
+
+    Iterator Newest(std::string const& key);
+    void Remove(Iterator it, bool free);
+
+    size_t                                              m_capacity;
+    std::list<Item>                                     m_lru;      // most recently used first
+    std::unordered_map<std::string, std::vector<Iterator>> m_index; // per key, oldest first
+};
+
+// TicketKeys seal and open stateless session tickets (RFC 5077, and TLS 1.3's PSK tickets) for
+// every Context handed it and every cooperator serving them, so a client may resume on any
+// thread. The first key is current and seals new tickets; the keep-1 keys before it still open
+// tickets, which are then reissued under the current key. A ticket thus lives at most keep
+// rotation periods: rotate on a timer (every few hours, say) so a stolen key unseals little.
+//
+// Rotation takes a lock; lookups do not. Each cooperator keeps its own copy of the keys and
+// refreshes it, under the lock, the first time it sees a newer generation.
+//
+struct TicketKeys
+{
+    static constexpr size_t NAME_SIZE = 16;
+
+    struct Key
+    {
+        unsigned char   name[NAME_SIZE];
+        unsigned char   aes[32];
+        unsigned char   hmac[32];
+    };
+
+    // Starts with one random key
+    //
+    explicit TicketKeys(size_t keep = 2);
+
+    TicketKeys(TicketKeys const&) = delete;
+    TicketKeys& operator=(TicketKeys const&) = delete;
+
+    // Make a fresh random key current, retiring the oldest past keep. False (changing nothing)
+    // when the random source fails. Safe from any thread.
+    //
+    bool Rotate();
+
+    uint64_t Generation() const { return m_generation.load(std::memory_order_acquire); }
+
+    // The calling cooperator's copy, current key first
+    //
+    std::vector<Key> const& Local() const;
+
+  private:
+    const uint64_t          m_id;
+    const size_t            m_keep;
+
+    mutable std::mutex      m_lock;
+    std::vector<Key>        m_keys;
+    std::atomic<uint64_t>   m_generation{0};
+};
+
+// The calling cooperator's cache for the cache owner with this id (Context::m_id), created empty
+// with capacity on first use
+//
+SessionCache& LocalSessionCache(uint64_t id, size_t capacity);
+
+// Ids for cache owners, unique for the life of the process, so a cooperator's caches never
+// outlive an owner into a successor at the same address
+//
+uint64_t NextCacheId();
+
+} // end namespace coop::io::ssl
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,124 @@
+#include "splice.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <spdlog/spdlog.h>
+
+#include "connection.h"
+#include "recv.h"
+#include "send.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/poll.h"
+#include "coop/io/recv.h"
+#include "coop/io/send.h"
+#include "coop/io/splice.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+namespace ssl
+{
+
+// One splice round. inConn/outConn are null for a plain descriptor end.
+//
+static int SpliceImpl(Descriptor& in, Connection* inConn, Descriptor& out, Connection* outConn,
+                      int pipefd[2], size_t len, bool killAware)
+{
+    if ((!inConn || inConn->m_ktlsRx) && (!outConn || outConn->m_ktlsTx))
+    {
+        for (;;)
+        {
+            ssize_t n = ::splice(in.m_fd, nullptr, pipefd[1], nullptr, len,
+                                 SPLICE_F_NONBLOCK | SPLICE_F_MOVE);
+            if (n > 0)
+            {
+                int r = io::detail::DrainPipe(out, pipefd, (size_t)n, killAware);
+                return r < 0 ? r : (int)n;
+            }
+            if (n == 0) return 0;
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                SPDLOG_TRACE("ssl splice in={} EAGAIN", in.m_fd);
+                int r = killAware ? io::PollKill(in, POLLIN) : io::Poll(in, POLLIN);
+                if (r == -ECANCELED) return -ECANCELED;
+                if (r < 0) return -1;
+                continue;
+            }
+
+            // kTLS serves a control record only to recvmsg. It stays queued for the Recv below.
+            //
+            if (errno == EINVAL && inConn)
+            {
+                SPDLOG_TRACE("ssl splice in={} control record", in.m_fd);
+                break;
+            }
+
+            spdlog::warn("ssl splice in={} errno={}", in.m_fd, errno);
+            return -1;
+        }
+    }
+
+    char buf[16384];
+    size_t want = std::min(len, sizeof(buf));
+    int n;
+    if (inConn)
+    {
+        n = killAware ? ssl::RecvKill(*inConn, buf, want) : ssl::Recv(*inConn, buf, want);
+    }
+    else
+    {
+        n = killAware ? io::RecvKill(in, buf, want) : io::Recv(in, buf, want);
+    }
+    if (n <= 0) return n;
+
+    int sent;
+    if (outConn)
+    {
+        sent = killAware ? ssl::SendAllKill(*outConn, buf, n) : ssl::SendAll(*outConn, buf, n);
+    }
+    else
+    {
+        sent = io::SendAll(out, buf, n);
+    }
+    return sent < 0 ? sent : n;
+}
+
+int Splice(Connection& in, Descriptor& out, int pipefd[2], size_t len)
+{
+    return SpliceImpl(in.m_desc, &in, out, nullptr, pipefd, len, false);
+}
+
+int Splice(Descriptor& in, Connection& out, int pipefd[2], size_t len)
+{
+    return SpliceImpl(in, nullptr, out.m_desc, &out, pipefd, len, false);
+}
+
+int Splice(Connection& in, Connection& out, int pipefd[2], size_t len)
+{
+    return SpliceImpl(in.m_desc, &in, out.m_desc, &out, pipefd, len, false);
+}
+
+int SpliceKill(Connection& in, Descriptor& out, int pipefd[2], size_t len)
+{
+    return SpliceImpl(in.m_desc, &in, out, nullptr, pipefd, len, true);
+}
+
+int SpliceKill(Descriptor& in, Connection& out, int pipefd[2], size_t len)
+{
+    return SpliceImpl(in, nullptr, out.m_desc, &out, pipefd, len, true);
+}
+
+int SpliceKill(Connection& in, Connection& out, int pipefd[2], size_t len)
+{
+    return SpliceImpl(in.m_desc, &in, out.m_desc, &out, pipefd, len, true);
+}
+
+} // end namespace coop::io::ssl
+} // end namespace coop::io
+} // end namespace coop
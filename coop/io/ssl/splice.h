@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Descriptor;
+
+namespace ssl
+{
+
+struct Connection;
+
+// Splice up to `len` bytes between TLS connections and plain descriptors. Where kTLS carries both
+// directions -- RX on a Connection read from, TX on one written to -- the bytes go through the
+// kernel pipe as io::Splice moves them, decrypted and re-encrypted in the kernel and never copied
+// through OpenSSL. Otherwise they take one ssl::Recv / Send round through a stack buffer.
+//
+// A control record (alert, KeyUpdate, session ticket) cannot be spliced: the kernel refuses it,
+// and that round goes through ssl::Recv, which handles it.
+//
+// Returns bytes transferred, 0 on EOF (input closed), negative on error; -ECANCELED from the kill
+// variants when kill wins while waiting for readiness.
+//
+int Splice(Connection& in, Descriptor& out, int pipefd[2], size_t len);
+int Splice(Descriptor& in, Connection& out, int pipefd[2], size_t len);
+int Splice(Connection& in, Connection& out, int pipefd[2], size_t len);
+
+int SpliceKill(Connection& in, Descriptor& out, int pipefd[2], size_t len);
+int SpliceKill(Descriptor& in, Connection& out, int pipefd[2], size_t len);
+int SpliceKill(Connection& in, Connection& out, int pipefd[2], size_t len);
+
+} // end namespace coop::io::ssl
+} // end namespace coop::io
+} // end namespace coop
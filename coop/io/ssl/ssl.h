@@ -5,6 +5,8 @@
 #include "recv.h"
 #include "send.h"
 #include "sendfile.h"
+#include "session_cache.h"
+#include "splice.h"
 #include "stream.h"
 
 // coop::io::ssl provides a TLS layer on top of coop's io module. Two modes are supported:
@@ -24,11 +26,17 @@
 //   ssl::Connection — Per-connection TLS state. Memory BIO ctor takes a staging buffer; socket BIO
 //                     ctor takes `ssl::SocketBio{}` tag (no buffer needed).
 //
+//   ssl::SessionCache, ssl::TicketKeys
+//                   — Session resumption: a per-cooperator session LRU, and ticket keys shared by
+//                     every cooperator. See Context::EnableSessionCache / EnableSessionTickets /
+//                     EnableSessionResumption.
+//
 // Free functions mirror the io module's API:
 //
 //   ssl::Send(connection, buf, size)  — encrypt and send plaintext
 //   ssl::Recv(connection, buf, size)  — receive and decrypt ciphertext
 //   ssl::SendKill / ssl::RecvKill     — explicit kill-aware siblings
+//   ssl::Splice(in, out, pipe, len)   — kernel pipe between kTLS ends, else one Recv/Send round
 //
 // Usage (memory BIO):
 //
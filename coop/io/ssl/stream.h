@@ -1,5 +1,7 @@
 #pragma once
 
+#include "recv.h"
+#include "send.h"
 #include "coop/io/stream.h"
 
 namespace coop
@@ -29,6 +31,21 @@ struct SecureStream : Stream
     Connection& m_conn;
 };
 
+// The TLS terminal of an io::Compose stack (coop/io/stream_stack.h): the ssl:: free functions on a
+// Connection. The Connection does its own socket IO (kTLS included), so no layer goes below it.
+//
+struct Tls
+{
+    explicit Tls(Connection& conn) : m_conn(conn) {}
+
+    int Send(const void* buf, size_t size) { return ssl::Send(m_conn, buf, size); }
+    int SendAll(const void* buf, size_t size) { return ssl::SendAll(m_conn, buf, size); }
+    int Recv(void* buf, size_t size) { return ssl::Recv(m_conn, buf, size); }
+    int Flush() { return 0; }
+
+    Connection& m_conn;
+};
+
 } // end namespace coop::io::ssl
 } // end namespace coop::io
 } // end namespace coop
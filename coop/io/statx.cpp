@@ -0,0 +1,22 @@
+#define COOP_IO_KEEP_ARGS
+#include "statx.h"
+
+#include <cerrno>
+#include <fcntl.h>
+
+#include "coop/coordinator.h"
+#include "coop/self.h"
+
+#include "handle.h"
+#include "uring.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+COOP_IO_URING_IMPLEMENTATIONS(Statx, io_uring_prep_statx, STATX_ARGS)
+
+} // end namespace coop::io
+} // end namespace coop
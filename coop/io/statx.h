@@ -0,0 +1,27 @@
+#pragma once
+
+#include "coop/io/detail/op_macros.h"
+
+struct statx;
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Handle;
+
+// statx(2) on a path, relative to the working directory: mask selects the STATX_* fields wanted
+// and flags takes AT_* (AT_SYMLINK_NOFOLLOW, AT_STATX_DONT_SYNC). buf must outlive the operation.
+//
+#define STATX_ARGS(F) \
+    F(const char*, path, ) F(int, flags, ) F(unsigned, mask, ) F(struct statx*, buf, )
+COOP_IO_URING_DECLARATIONS(Statx, STATX_ARGS)
+
+} // end namespace coop::io
+} // end namespace coop
+
+#ifndef COOP_IO_KEEP_ARGS
+#undef STATX_ARGS
+#endif
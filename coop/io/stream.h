@@ -20,6 +20,11 @@ struct Stream
     virtual int Send(const void* buf, size_t size) = 0;
     virtual int SendAll(const void* buf, size_t size) = 0;
     virtual int Recv(void* buf, size_t size) = 0;
+
+    // Push down to the socket anything the stream holds back (a buffered layer of a
+    // StreamAdapter, stream_stack.h). 0, or a negative errno.
+    //
+    virtual int Flush() { return 0; }
 };
 
 // PlaintextStream delegates directly to the io:: free functions.
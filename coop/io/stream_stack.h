@@ -0,0 +1,304 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+#include "recv.h"
+#include "send.h"
+#include "stream.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Descriptor;
+
+// A stream built from layers at compile time, io::Compose<Outer, ..., Terminal>. Each layer holds
+// the one below it by value and calls it directly, so a call through the stack inlines down to the
+// terminal's io:: call -- no virtual dispatch per layer, and no copy but the ones a layer exists to
+// make (a buffer's, a coder's). The virtual Stream interface goes on the outside only, through
+// StreamAdapter, where code that must not know the stack receives it.
+//
+//  using Lines = io::Compose<io::BufferedReader<4096>, io::Buffered<4096>, io::ssl::Tls>;
+//  Lines stream(conn);                     // the arguments go to the terminal
+//
+//  std::string_view line;
+//  bool complete;
+//  while (stream.ReadLine(&line, &complete) > 0) { ... stream.SendAll(reply, size); }
+//  stream.Flush();
+//
+// Every layer has Send, SendAll and Recv, with io::Stream's meaning, and Flush, which pushes what
+// the layers hold down to the socket: 0, or a negative errno. A layer's own calls
+// (BufferedReader::ReadLine) are on the stack only when it is outermost; below, they are reached
+// through Next(), the layer under each one.
+//
+// A terminal is a plain type over what does the IO (Plain over a Descriptor, ssl::Tls over an
+// ssl::Connection). A layer above it is a type with a nested On<Lower> template (Buffered<N>,
+// BufferedReader<N>, http::Compressed<Encoding>); a new one follows their shape.
+//
+namespace detail
+{
+
+template<typename... Layers>
+struct ComposeOf;
+
+template<typename Terminal>
+struct ComposeOf<Terminal>
+{
+    using Type = Terminal;
+};
+
+template<typename Layer, typename... Rest>
+struct ComposeOf<Layer, Rest...>
+{
+    using Type = typename Layer::template On<typename ComposeOf<Rest...>::Type>;
+};
+
+} // end namespace coop::io::detail
+
+template<typename... Layers>
+using Compose = typename detail::ComposeOf<Layers...>::Type;
+
+// The plaintext terminal: the io:: free functions on a Descriptor, as PlaintextStream calls them
+//
+struct Plain
+{
+    explicit Plain(Descriptor& desc) : m_desc(desc) {}
+
+    int Send(const void* buf, size_t size) { return io::Send(m_desc, buf, size); }
+    int SendAll(const void* buf, size_t size) { return io::SendAll(m_desc, buf, size); }
+    int Recv(void* buf, size_t size) { return io::Recv(m_desc, buf, size); }
+    int Flush() { return 0; }
+
+    Descriptor& m_desc;
+};
+
+// Coalesces sends into an N-byte buffer, which goes down in one SendAll when it fills or on Flush.
+// A send at least as big as the buffer goes straight down after what is buffered. Unlike io::Cork
+// the bytes wait in userspace, so a TLS layer below gets one record for them rather than one per
+// send. Nothing leaves until Flush; the owner must call it before waiting on the peer.
+//
+template<size_t N>
+struct Buffered
+{
+    template<typename Lower>
+    struct On
+    {
+        template<typename... Args>
+        explicit On(Args&&... args) : m_lower(std::forward<Args>(args)...) {}
+
+        // Buffered, a send is taken whole
+        //
+        int Send(const void* buf, size_t size) { return SendAll(buf, size); }
+
+        int SendAll(const void* buf, size_t size)
+        {
+            if (size <= N - m_len)
+            {
+                memcpy(m_buf + m_len, buf, size);
+                m_len += size;
+                return static_cast<int>(size);
+            }
+            int result = Drain();
+            if (result < 0)
+            {
+                return result;
+            }
+            if (size >= N)
+            {
+                return m_lower.SendAll(buf, size);
+            }
+            memcpy(m_buf, buf, size);
+            m_len = size;
+            return static_cast<int>(size);
+        }
+
+        int Recv(void* buf, size_t size) { return m_lower.Recv(buf, size); }
+
+        int Flush()
+        {
+            int result = Drain();
+            return result < 0 ? result : m_lower.Flush();
+        }
+
+        size_t Pending() const { return m_len; }
+
+        Lower& Next() { return m_lower; }
+
+      private:
+        int Drain()
+        {
+            if (m_len == 0)
+            {
+                return 0;
+            }
+            int result = m_lower.SendAll(m_buf, m_len);
+            m_len = 0;
+            return result < 0 ? result : 0;
+        }
+
+        Lower   m_lower;
+        size_t  m_len = 0;
+        char    m_buf[N];
+    };
+};
+
+// Reads through an N-byte buffer, and finds delimiters in it in place: ReadUntil and ReadLine
+// hand out a view of the buffer, valid until the next read, without copying. A line longer than
+// the buffer comes in pieces, each but the last flagged incomplete, as the HTTP parser delivers
+// values -- there is no line-length limit for the caller to trip over. The delimiter scan is
+// memchr's, vectorized in glibc, and a refill resumes it where it stopped rather than rescanning.
+//
+template<size_t N>
+struct BufferedReader
+{
+    template<typename Lower>
+    struct On
+    {
+        template<typename... Args>
+        explicit On(Args&&... args) : m_lower(std::forward<Args>(args)...) {}
+
+        int Send(const void* buf, size_t size) { return m_lower.Send(buf, size); }
+        int SendAll(const void* buf, size_t size) { return m_lower.SendAll(buf, size); }
+        int Flush() { return m_lower.Flush(); }
+
+        // Buffered bytes first; a read at least as big as the buffer, with none buffered, goes
+        // straight down
+        //
+        int Recv(void* buf, size_t size)
+        {
+            if (m_pos == m_len)
+            {
+                if (size >= N)
+                {
+                    return m_lower.Recv(buf, size);
+                }
+                int n = Fill();
+                if (n <= 0)
+                {
+                    return n;
+                }
+            }
+            size_t n = std::min(size, m_len - m_pos);
+            memcpy(buf, m_buf + m_pos, n);
+            Consume(n);
+            return static_cast<int>(n);
+        }
+
+        // The bytes up to and including the next delim, in *out. When the buffer fills (or the
+        // stream ends) before one turns up, what it holds comes out with *complete false and the
+        // next call carries on. Returns the size of *out, 0 at EOF with nothing buffered, or a
+        // negative errno.
+        //
+        int ReadUntil(char delim, std::string_view* out, bool* complete)
+        {
+            while (true)
+            {
+                size_t avail = m_len - m_pos;
+                const char* at = static_cast<const char*>(
+                    memchr(m_buf + m_pos + m_scanned, delim, avail - m_scanned));
+                if (at)
+                {
+                    return Deliver(out, complete, at + 1 - (m_buf + m_pos), true);
+                }
+                m_scanned = avail;
+
+                if (avail == N)
+                {
+                    return Deliver(out, complete, avail, false);
+                }
+                int n = Fill();
+                if (n <= 0)
+                {
+                    return avail > 0 && n == 0 ? Deliver(out, complete, avail, false) : n;
+                }
+            }
+        }
+
+        // ReadUntil('\n'), with the line ending ("\r\n" or "\n") left off a complete line
+        //
+        int ReadLine(std::string_view* line, bool* complete)
+        {
+            int n = ReadUntil('\n', line, complete);
+            if (n > 0 && *complete)
+            {
+                line->remove_suffix(line->size() > 1 && (*line)[line->size() - 2] == '\r' ? 2 : 1);
+            }
+            return n;
+        }
+
+        size_t Buffered() const { return m_len - m_pos; }
+
+        Lower& Next() { return m_lower; }
+
+      private:
+        // Room at the end, after moving what is unread to the front. Returns what the recv did.
+        //
+        int Fill()
+        {
+            if (m_pos == m_len)
+            {
+                m_pos = m_len = 0;
+            }
+            else if (m_pos > 0)
+            {
+                memmove(m_buf, m_buf + m_pos, m_len - m_pos);
+                m_len -= m_pos;
+                m_pos = 0;
+            }
+            int n = m_lower.Recv(m_buf + m_len, N - m_len);
+            if (n > 0)
+            {
+                m_len += static_cast<size_t>(n);
+            }
+            return n;
+        }
+
+        int Deliver(std::string_view* out, bool* complete, size_t size, bool found)
+        {
+            *out = std::string_view(m_buf + m_pos, size);
+            *complete = found;
+            Consume(size);
+            return static_cast<int>(size);
+        }
+
+        void Consume(size_t size)
+        {
+            m_pos += size;
+            m_scanned = 0;
+        }
+
+        Lower   m_lower;
+        size_t  m_pos = 0;
+        size_t  m_len = 0;
+        size_t  m_scanned = 0;      // bytes past m_pos already searched for the delimiter
+        char    m_buf[N];
+    };
+};
+
+// A stack behind the virtual Stream interface, for the boundary where callers take a Stream&.
+// It owns the stack; the calls inside it stay direct.
+//
+template<typename Stack>
+struct StreamAdapter final : Stream
+{
+    template<typename... Args>
+    explicit StreamAdapter(Args&&... args) : m_stack(std::forward<Args>(args)...) {}
+
+    int Send(const void* buf, size_t size) override { return m_stack.Send(buf, size); }
+    int SendAll(const void* buf, size_t size) override { return m_stack.SendAll(buf, size); }
+    int Recv(void* buf, size_t size) override { return m_stack.Recv(buf, size); }
+    int Flush() override { return m_stack.Flush(); }
+
+    Stack& Get() { return m_stack; }
+
+    Stack m_stack;
+};
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,67 @@
+#include "udp.h"
+
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#include "descriptor.h"
+
+// Older libc headers predate the offload socket options
+//
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+
+namespace coop
+{
+
+namespace io
+{
+
+void SetUdpSegment(struct msghdr* msg, UdpSegmentControl* control, uint16_t segSize)
+{
+    memset(control->buf, 0, sizeof(control->buf));
+    msg->msg_control = control->buf;
+    msg->msg_controllen = sizeof(control->buf);
+
+    struct cmsghdr* cm = CMSG_FIRSTHDR(msg);
+    cm->cmsg_level = SOL_UDP;
+    cm->cmsg_type = UDP_SEGMENT;
+    cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    memcpy(CMSG_DATA(cm), &segSize, sizeof(segSize));
+}
+
+int SetUdpGro(Descriptor& desc, bool on /* = true */)
+{
+    int value = on ? 1 : 0;
+    if (setsockopt(desc.m_fd, SOL_UDP, UDP_GRO, &value, sizeof(value)) < 0)
+    {
+        return -errno;
+    }
+    return 0;
+}
+
+uint16_t UdpGroSegment(struct msghdr const& msg)
+{
+    auto* m = const_cast<struct msghdr*>(&msg);
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(m); cm; cm = CMSG_NXTHDR(m, cm))
+    {
+        if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO)
+        {
+            int segment;
+            memcpy(&segment, CMSG_DATA(cm), sizeof(segment));
+            return static_cast<uint16_t>(segment);
+        }
+    }
+    return 0;
+}
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <sys/socket.h>
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Descriptor;
+
+// UDP segmentation offloads. With GSO a sender hands the kernel one large buffer and a segment
+// size, and the stack (or the NIC) cuts it into datagrams after the expensive per-packet work is
+// done once; with GRO a receiver gets a run of same-flow datagrams back as one buffer plus the
+// segment size to re-split it by. Either way one syscall -- or one SQE -- carries dozens of
+// packets, which is the only road to millions of datagrams per second per core.
+//
+
+// Control buffer for one UDP_SEGMENT message, on the sender's stack or in its state
+//
+struct UdpSegmentControl
+{
+    alignas(struct cmsghdr) char buf[CMSG_SPACE(sizeof(uint16_t))];
+};
+
+// Attach a UDP_SEGMENT control message to msg so a SendMsg of n bytes leaves as ceil(n / segSize)
+// datagrams of segSize bytes (the last may be shorter). control backs msg->msg_control and must
+// outlive the send. The kernel caps a train at 64 segments and rejects it with -EINVAL where GSO
+// is unsupported (pre-4.18 kernels, or a segment that does not fit the path MTU).
+//
+void SetUdpSegment(struct msghdr* msg, UdpSegmentControl* control, uint16_t segSize);
+
+// Enable (or disable) UDP_GRO on a socket: received runs of same-flow datagrams may then be
+// coalesced into one, each carrying a UDP_GRO control message with the segment size. Returns 0
+// or a negative errno (-ENOPROTOOPT before 5.0).
+//
+int SetUdpGro(Descriptor& desc, bool on = true);
+
+// The UDP_GRO segment size reported in a received msghdr's control messages, or 0 if the datagram
+// was not coalesced. A receive buffer for it needs UDP_GRO_CONTROL bytes of control space.
+//
+inline constexpr size_t UDP_GRO_CONTROL = CMSG_SPACE(sizeof(int));
+uint16_t UdpGroSegment(struct msghdr const& msg);
+
+} // end namespace coop::io
+} // end namespace coop
@@ -1,15 +1,24 @@
 #include "uring.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <cstdlib>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <spdlog/spdlog.h>
 
 #include "buffer_ring.h"
+#include "buffer_ring_set.h"
 #include "handle.h"
+#include "sqpoll_pool.h"
 
 #include "coop/context.h"
 #include "coop/cooperator.h"
+#include "coop/detail/timer_tag.h"
 #include "coop/perf/probe.h"
+#include "coop/time/now.h"
 
 // Compat defines for kernels/liburing that don't expose these yet. These are stable kernel ABI.
 //
@@ -40,6 +49,23 @@ static inline int io_uring_get_events(struct io_uring* ring)
 }
 #endif
 
+// io_uring_register_napi and struct io_uring_napi arrived in liburing 2.6. IO_URING_CHECK_VERSION
+// (2.4+) is true when the library is older than the version named.
+//
+#if defined(IO_URING_CHECK_VERSION)
+#if !IO_URING_CHECK_VERSION(2, 6)
+#define COOP_URING_HAS_NAPI 1
+#endif
+#endif
+
+// ...and io_uring_resize_rings, which remaps the rings after IORING_REGISTER_RESIZE_RINGS, 2.9
+//
+#if defined(IO_URING_CHECK_VERSION)
+#if !IO_URING_CHECK_VERSION(2, 9)
+#define COOP_URING_HAS_RESIZE 1
+#endif
+#endif
+
 namespace coop
 {
 
@@ -52,11 +78,27 @@ namespace io
 Uring::Uring(UringConfiguration const& config)
 : m_config(config)
 , m_registered(config.registeredSlots, -1)
+, m_directBase(config.registeredSlots)
 {
     memset(&m_ring, 0, sizeof(m_ring));
 }
 
-Uring::~Uring() = default;
+Uring::~Uring()
+{
+    // Detached ops queued since the last Poll (detached.h) have no one waiting on them to keep
+    // the loop polling; hand them to the kernel rather than drop them
+    //
+    if (m_ring.sq.khead && m_pendingSqes > 0)
+    {
+        io_uring_submit(&m_ring);
+    }
+
+    if (m_fixedBase)
+    {
+        io_uring_unregister_buffers(&m_ring);
+        munmap(m_fixedBase, m_fixedBufferSize * m_fixedCount);
+    }
+}
 
 void Uring::Init()
 {
@@ -81,6 +123,27 @@ void Uring::Init()
     {
         flags |= IORING_SETUP_COOP_TASKRUN | IORING_SETUP_TASKRUN_FLAG;
     }
+    if (m_config.cqe32)
+    {
+        flags |= IORING_SETUP_CQE32;
+    }
+    if (m_config.sqe128)
+    {
+        flags |= IORING_SETUP_SQE128;
+    }
+
+    // A pooled SQPOLL ring either becomes one of its node's pollers or attaches to one
+    //
+    int poolNode = -1;
+    bool poolPoller = false;
+    if (m_config.sqpoll && m_config.sqpollPool)
+    {
+        auto* co = Cooperator::thread_cooperator;
+        poolNode = co ? co->NumaNode() : -1;
+        int fd = m_config.sqpollPool->Join(poolNode);
+        poolPoller = fd < 0;
+        m_config.attachSqFd = fd;
+    }
 
     struct io_uring_params params;
     memset(&params, 0, sizeof(params));
@@ -138,6 +201,12 @@ void Uring::Init()
 
     spdlog::info("uring init flags={:#x}", m_ring.flags);
 
+    if (poolPoller)
+    {
+        m_config.sqpollPool->Publish(poolNode,
+            (m_ring.flags & IORING_SETUP_SQPOLL) ? m_ring.ring_fd : -1);
+    }
+
     // Register this ring's fd into the calling thread's registered-ring table so that subsequent
     // io_uring_enter() calls reference the ring by a small registered index rather than by file
     // descriptor (IORING_ENTER_REGISTERED_RING). io_uring_enter() is the hottest syscall coop
@@ -163,16 +232,87 @@ void Uring::Init()
         spdlog::warn("uring register_ring_fd failed ret={}, using unregistered enter path", ret);
     }
 
+    // IORING_OP_MSG_RING (5.18+) backs the cross-cooperator doorbell (SendMessage). Probe it once so
+    // callers can fall back to timer-driven polling on older kernels instead of waiting on a wake
+    // that will never be delivered. SEND_ZC (6.0+) is probed alongside so SendAllZc can use a
+    // copying send instead. It also stands in for the cancel-by-file flags, which have no probe of
+    // their own: IORING_ASYNC_CANCEL_FD_FIXED, the last of them Descriptor::Cancel needs, is 6.0.
+    // Socket commands are the same case: FUTEX_WAIT came with SOCKET_URING_OP_SETSOCKOPT, in 6.7,
+    // and stands in for cancel-by-opcode too (IORING_ASYNC_CANCEL_OP, 6.6) -- a release late.
+    //
+    if (auto* probe = io_uring_get_probe_ring(&m_ring))
+    {
+        m_msgRingSupported = io_uring_opcode_supported(probe, IORING_OP_MSG_RING);
+        m_sendZcSupported = io_uring_opcode_supported(probe, IORING_OP_SEND_ZC);
+        m_socketSupported = io_uring_opcode_supported(probe, IORING_OP_SOCKET);
+        m_socketCommandsSupported = io_uring_opcode_supported(probe, IORING_OP_FUTEX_WAIT);
+        io_uring_free_probe(probe);
+    }
+
+    // The table is registered sparse: the kernel allocates it empty, with no array of -1s to copy
+    // in, so it can be sized to a connection limit. The kernel refuses a table larger than
+    // RLIMIT_NOFILE, so it is clamped to that.
+    //
     if (!m_registered.empty())
     {
-        ret = io_uring_register_files(&m_ring, m_registered.data(), m_registered.size());
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < m_registered.size())
+        {
+            spdlog::warn("uring registeredSlots={} above RLIMIT_NOFILE, clamped to {}",
+                m_registered.size(), limit.rlim_cur);
+            m_registered.resize(limit.rlim_cur);
+        }
+        m_directBase = static_cast<int>(m_registered.size());
+
+        ret = io_uring_register_files_sparse(&m_ring, m_registered.size());
         if (ret < 0)
         {
-            spdlog::warn("uring register_files failed ret={}", ret);
+            spdlog::warn("uring register_files_sparse failed ret={}", ret);
             m_registered.clear();
+            m_directBase = 0;
+        }
+    }
+
+    // Hand the top directSlots of the table to the kernel for direct descriptor installs. Userspace
+    // registration stays below m_directBase, so the two allocators never hand out the same slot.
+    //
+    int directSlots = m_config.directSlots;
+    if (directSlots > 0 && directSlots <= static_cast<int>(m_registered.size()))
+    {
+        int base = static_cast<int>(m_registered.size()) - directSlots;
+        ret = io_uring_register_file_alloc_range(&m_ring, base, directSlots);
+        if (ret < 0)
+        {
+            spdlog::warn("uring register_file_alloc_range failed ret={}, no direct descriptors", ret);
+        }
+        else
+        {
+            m_directBase = base;
         }
     }
 
+    // Userspace slots are handed out LIFO from a free list, lowest first
+    //
+    m_freeSlots.reserve(m_directBase);
+    for (int i = m_directBase - 1; i >= 0; i--)
+    {
+        m_freeSlots.push_back(i);
+    }
+
+    if (m_config.fixedBuffers > 0)
+    {
+        RegisterFixedBuffers();
+    }
+
+    if (m_config.busyPollUs > 0)
+    {
+        RegisterNapi();
+    }
+
+    // Start the adaptive spin at its cap; the first few waits pull it to the traffic
+    //
+    m_waitGapNs = int64_t(m_config.adaptiveSpinMaxUs) * 1000 / 2;
+
     // Register the optional default provided buffer ring. The registration doubles as the runtime
     // feature probe: on a kernel without pbuf-ring support (pre-5.19) io_uring_setup_buf_ring
     // fails, and we warn and continue with no default ring -- classic recv is untouched -- exactly
@@ -186,7 +326,8 @@ void Uring::Init()
             entries <<= 1;
         }
         auto ring = std::make_unique<BufferRing>(
-            m_config.bufferRingGroup, entries, m_config.bufferRingBufSize);
+            m_config.bufferRingGroup, entries, m_config.bufferRingBufSize,
+            m_config.bufferRingIncremental);
         int err = ring->Register(*this);
         if (err < 0)
         {
@@ -199,6 +340,39 @@ void Uring::Init()
             m_bufferRing = std::move(ring);
         }
     }
+
+    // The optional size-class set, probed the same way
+    //
+    if (m_config.bufferRingClassSizes[0] > 0)
+    {
+        uint32_t entries = 1;
+        while (entries < m_config.bufferRingClassEntries)
+        {
+            entries <<= 1;
+        }
+        auto set = std::make_unique<BufferRingSet>();
+        for (int i = 0; i < BufferRingSet::MAX_CLASSES && m_config.bufferRingClassSizes[i] > 0; i++)
+        {
+            if (!set->Add(uint16_t(m_config.bufferRingClassGroup + i), entries,
+                    m_config.bufferRingClassSizes[i]))
+            {
+                spdlog::warn("uring buffer-ring class {} size={} not above the previous, ignored",
+                    i, m_config.bufferRingClassSizes[i]);
+                break;
+            }
+        }
+        int err = set->Register(*this);
+        if (err < 0)
+        {
+            spdlog::warn("uring buffer-ring set register failed ret={}, using classic recv", err);
+        }
+        else
+        {
+            spdlog::info("uring buffer-ring set registered classes={} entries={}",
+                set->Count(), entries);
+            m_bufferRingSet = std::move(set);
+        }
+    }
 }
 
 int Uring::Submit()
@@ -224,10 +398,13 @@ struct io_uring_sqe* Uring::GetSqe()
     auto* sqe = io_uring_get_sqe(&m_ring);
     if (!sqe)
     {
-        // SQ ring is full — flush pending SQEs and retry
+        // SQ ring is full — flush pending SQEs and retry. Callers may hold SQEs from before the
+        // flush, so growing waits for Poll.
         //
         io_uring_submit(&m_ring);
         m_pendingSqes = 0;
+        m_ringStatistics.sqFull++;
+        m_growWanted = true;
         sqe = io_uring_get_sqe(&m_ring);
     }
     if (sqe)
@@ -237,6 +414,72 @@ struct io_uring_sqe* Uring::GetSqe()
     return sqe;
 }
 
+bool Uring::SendMessage(Uring const& target, uintptr_t data, uintptr_t ackData)
+{
+    if (!m_msgRingSupported)
+    {
+        return false;
+    }
+
+    auto* sqe = GetSqe();
+    if (!sqe)
+    {
+        return false;
+    }
+    io_uring_prep_msg_ring(sqe, target.RingFd(), 0, data, 0);
+    io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(ackData));
+    return true;
+}
+
+int Uring::CancelWaiting()
+{
+    if (!SupportsCancelOp())
+    {
+        return 0;
+    }
+
+    // Scoped by opcode rather than IORING_ASYNC_CANCEL_ANY, which would take the cooperator's own
+    // timer and every send a cleanup path is still flushing with it
+    //
+    static constexpr uint8_t kWaiting[] = {
+        IORING_OP_RECV, IORING_OP_RECVMSG, IORING_OP_ACCEPT, IORING_OP_CONNECT,
+        IORING_OP_POLL_ADD, IORING_OP_READ, IORING_OP_FUTEX_WAIT,
+    };
+
+    int prepared = 0;
+    for (uint8_t opcode : kWaiting)
+    {
+        auto* sqe = GetSqe();
+        if (!sqe)
+        {
+            break;
+        }
+        io_uring_prep_cancel64(sqe, 0, IORING_ASYNC_CANCEL_OP | IORING_ASYNC_CANCEL_ALL);
+        sqe->len = opcode;
+        io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(coop::detail::kBulkCancelTag));
+
+        // Counted in flight, so the loop stays up for the answer
+        //
+        m_pendingOps++;
+        m_cancelStatistics.bulkCancels++;
+        prepared++;
+    }
+    return prepared;
+}
+
+void Uring::OnBulkCancel(int res)
+{
+    m_pendingOps--;
+    if (res >= 0)
+    {
+        m_cancelStatistics.bulkCancelled += static_cast<uint64_t>(res);
+    }
+    else if (res != -ENOENT)
+    {
+        m_cancelStatistics.bulkFailed++;
+    }
+}
+
 bool Uring::HasPendingCompletions() const
 {
     // Two independent signals that real IO is ready to service. The continuation drain consults
@@ -271,16 +514,22 @@ int Uring::Poll()
     //      in the CQ ring and blocked contexts would never wake. The flag is a volatile read
     //      from kernel-mapped memory (sq.kflags); SINGLE_ISSUER keeps it uncontended.
     //
-    // Note: liburing also checks CQ overflow inside sq_ring_needs_enter(). We skip that here;
-    // CQ overflow is pathological (means CQEs aren't being drained fast enough) and the next
-    // real submit catches it. Not worth an extra branch on every Poll().
+    //   3. IORING_SQ_CQ_OVERFLOW, in the same kflags word: completions that found the CQ full
+    //      wait on the kernel's overflow list, and the submit's GETEVENTS enter moves them into
+    //      the CQ. Counted, and the ring grows once this Poll has reaped (Grow).
     //
     // For DEFER_TASKRUN: io_uring_submit() cannot flush deferred completions (it doesn't pass
     // IORING_ENTER_GETEVENTS when submitted==0). io_uring_get_events() is required separately.
     //
-    if (m_pendingSqes > 0 || (*m_ring.sq.kflags & IORING_SQ_TASKRUN))
+    const unsigned sqFlags = *m_ring.sq.kflags;
+    if (m_pendingSqes > 0 || (sqFlags & (IORING_SQ_TASKRUN | IORING_SQ_CQ_OVERFLOW)))
     {
         COOP_PERF_INC(Cooperator::thread_cooperator->GetPerfCounters(), perf::Counter::PollSubmit);
+        if (sqFlags & IORING_SQ_CQ_OVERFLOW) [[unlikely]]
+        {
+            m_ringStatistics.cqOverflow++;
+            m_growWanted = true;
+        }
         io_uring_submit(&m_ring);
         m_pendingSqes = 0;
     }
@@ -289,6 +538,13 @@ int Uring::Poll()
     {
         io_uring_get_events(&m_ring);
     }
+    else if ((m_ring.flags & IORING_SETUP_IOPOLL) && m_pendingOps > 0)
+    {
+        // An IOPOLL ring has no completion interrupts: CQEs only appear when an enter with
+        // GETEVENTS polls the device, so with IO outstanding every Poll is one polling pass
+        //
+        io_uring_get_events(&m_ring);
+    }
 
     // Reap the whole ready batch and advance the CQ head once. Each callback only reads cqe->res
     // (see Handle::Complete) and never relies on the kernel reclaiming a slot mid-drain, so the
@@ -312,6 +568,11 @@ int Uring::Poll()
 
     io_uring_cq_advance(&m_ring, dispatched);
 
+    if (m_growWanted) [[unlikely]]
+    {
+        Grow();
+    }
+
     return dispatched;
 }
 
@@ -343,6 +604,34 @@ int Uring::ReapOnly()
 
 int Uring::WaitAndPoll()
 {
+    // Without NAPI the kernel's wait would sleep straight away, so spin here for the budget
+    // first; with it, the enter below busy-polls the receive queues itself
+    //
+    int64_t start = 0;
+    if (m_config.busyPollUs > 0 && !m_napiRegistered)
+    {
+        if (int dispatched = SpinPoll(int64_t(m_config.busyPollUs) * 1000))
+        {
+            return dispatched;
+        }
+    }
+    else if (m_config.adaptiveSpinMaxUs > 0)
+    {
+        start = time::MonotonicNanos();
+        if (int64_t window = AdaptiveSpinWindowNs())
+        {
+            if (int dispatched = SpinPoll(window))
+            {
+                COOP_PERF_INC(Cooperator::thread_cooperator->GetPerfCounters(),
+                              perf::Counter::WaitSpinHit);
+                RecordWaitGap(time::MonotonicNanos() - start);
+                return dispatched;
+            }
+            COOP_PERF_INC(Cooperator::thread_cooperator->GetPerfCounters(),
+                          perf::Counter::WaitSpinMiss);
+        }
+    }
+
     // Flush pending SQEs AND block for a completion in one io_uring_enter. The separate
     // io_uring_submit() + io_uring_wait_cqe() this replaces cost two enters per idle poll; on a busy
     // fan-out server the idle poll runs ~once per round-trip, so fusing them halves the wait-side
@@ -351,6 +640,10 @@ int Uring::WaitAndPoll()
     //
     int ret = io_uring_submit_and_wait(&m_ring, 1);
     m_pendingSqes = 0;
+    if (start)
+    {
+        RecordWaitGap(time::MonotonicNanos() - start);
+    }
     if (ret < 0)
     {
         return 0;
@@ -361,6 +654,129 @@ int Uring::WaitAndPoll()
     return Poll();
 }
 
+int64_t Uring::AdaptiveSpinWindowNs() const
+{
+    const int64_t cap = int64_t(m_config.adaptiveSpinMaxUs) * 1000;
+    if (m_waitGapNs > cap)
+    {
+        return 0;
+    }
+    return std::min(cap, 2 * m_waitGapNs);
+}
+
+void Uring::RecordWaitGap(int64_t gapNs)
+{
+    // Clamped, so one long idle stretch costs a handful of waits to forget rather than hundreds
+    //
+    const int64_t cap = int64_t(m_config.adaptiveSpinMaxUs) * 1000;
+    gapNs = std::min(gapNs, 8 * cap);
+    m_waitGapNs += (gapNs - m_waitGapNs) / 8;
+}
+
+
+int Uring::SpinPoll(int64_t budgetNs)
+{
+    const int64_t deadline = time::MonotonicNanos() + budgetNs;
+    const bool deferred = m_ring.flags & IORING_SETUP_DEFER_TASKRUN;
+    do
+    {
+        // The first pass flushes the SQEs the wait was going to submit. After that, only enter
+        // the kernel when it has something: a ready CQE, or task_work to run for one. Deferred
+        // task_work gives no sign, so every pass there asks.
+        //
+        if (m_pendingSqes > 0 || deferred || io_uring_cq_ready(&m_ring)
+            || (*m_ring.sq.kflags & IORING_SQ_TASKRUN))
+        {
+            if (int dispatched = Poll())
+            {
+                return dispatched;
+            }
+        }
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+    while (time::MonotonicNanos() < deadline);
+    return 0;
+}
+
+void Uring::RegisterNapi()
+{
+    // The registration is the feature probe, as for the buffer rings: a kernel before 6.9 rejects
+    // it and WaitAndPoll spins in userspace instead. NAPI ids are tracked dynamically, so every
+    // socket this ring receives on joins the poll set without further registration.
+    //
+#ifdef COOP_URING_HAS_NAPI
+    struct io_uring_napi napi;
+    memset(&napi, 0, sizeof(napi));
+    napi.busy_poll_to = m_config.busyPollUs;
+    napi.prefer_busy_poll = m_config.preferBusyPoll ? 1 : 0;
+    int ret = io_uring_register_napi(&m_ring, &napi);
+    if (ret < 0)
+    {
+        spdlog::warn("uring register_napi failed ret={}, busy-polling in userspace", ret);
+        return;
+    }
+    m_napiRegistered = true;
+    spdlog::info("uring napi busy poll registered timeout={}us prefer={}",
+        m_config.busyPollUs, m_config.preferBusyPoll);
+#else
+    spdlog::warn("uring built against liburing without NAPI, busy-polling in userspace");
+#endif
+}
+
+void Uring::Grow()
+{
+    m_growWanted = false;
+    if (m_growHalted)
+    {
+        return;
+    }
+
+    const uint32_t entries = m_ring.sq.ring_entries;
+    const uint32_t target = entries * 2;
+    auto const& stats = m_ringStatistics;
+    if (m_config.maxEntries > 0 && target <= uint32_t(m_config.maxEntries) && m_config.deferTaskrun)
+    {
+#ifdef COOP_URING_HAS_RESIZE
+        // The kernel copies whatever is still queued into the new rings, but a callback of this
+        // reap may have queued SQEs liburing has not yet handed over, so they go first. Nothing
+        // outside holds an SQE or CQE pointer here: Poll has reaped and advanced.
+        //
+        if (m_pendingSqes > 0)
+        {
+            io_uring_submit(&m_ring);
+            m_pendingSqes = 0;
+        }
+
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        params.sq_entries = target;
+        params.cq_entries = target * 2;
+        params.flags = IORING_SETUP_CQSIZE;
+        int ret = io_uring_resize_rings(&m_ring, &params);
+        if (ret == 0)
+        {
+            m_ringStatistics.resizes++;
+            spdlog::info("uring {} resized sq={} cq={} (sq full {}, cq overflow {})",
+                m_config.taskName, m_ring.sq.ring_entries, m_ring.cq.ring_entries,
+                stats.sqFull, stats.cqOverflow);
+            return;
+        }
+
+        // 6.13+ only: -EINVAL or -EOPNOTSUPP before that, for good
+        //
+        spdlog::warn("uring {} resize to sq={} failed ret={}", m_config.taskName, target, ret);
+#endif
+    }
+
+    m_growHalted = true;
+    spdlog::warn("uring {} under pressure at entries={} (sq full {}, cq overflow {}), "
+        "configure entries={} or more", m_config.taskName, entries, stats.sqFull, stats.cqOverflow,
+        target);
+}
 
 // Work loop for non-native urings that run as a dedicated context. Poll() handles both
 // submitting pending SQEs and processing CQEs, so the yield-poll loop naturally batches
@@ -381,26 +797,37 @@ void Uring::Run(Context* ctx)
 
 void Uring::Register(Descriptor* descriptor)
 {
-    int slots = static_cast<int>(m_registered.size());
-    for (int i = 0; i < slots; i++)
+    if (m_freeSlots.empty())
     {
-        if (m_registered[i] == -1)
-        {
-            m_registered[i] = descriptor->m_fd;
-            int ret = io_uring_register_files_update(&m_ring, i, &descriptor->m_fd, 1);
-            if (ret < 0)
-            {
-                spdlog::warn("uring register_files_update failed fd={} ret={}",
-                    descriptor->m_fd, ret);
-                m_registered[i] = -1;
-                return;
-            }
-            descriptor->m_registeredIndex = i;
-            SPDLOG_TRACE("uring register fd={} slot={}", descriptor->m_fd, i);
-            return;
-        }
+        SPDLOG_DEBUG("uring register fd={} no slot available", descriptor->m_fd);
+        return;
+    }
+
+    int i = m_freeSlots.back();
+    int ret = io_uring_register_files_update(&m_ring, i, &descriptor->m_fd, 1);
+    if (ret < 0)
+    {
+        spdlog::warn("uring register_files_update failed fd={} ret={}", descriptor->m_fd, ret);
+        return;
     }
-    SPDLOG_DEBUG("uring register fd={} no slot available", descriptor->m_fd);
+    m_freeSlots.pop_back();
+    m_registered[i] = descriptor->m_fd;
+    descriptor->m_registeredIndex = i;
+    SPDLOG_TRACE("uring register fd={} slot={}", descriptor->m_fd, i);
+}
+
+int Uring::ReserveSlot()
+{
+    if (m_freeSlots.empty())
+    {
+        return -1;
+    }
+
+    int i = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    m_registered[i] = kReservedSlot;
+    SPDLOG_TRACE("uring reserve slot={}", i);
+    return i;
 }
 
 void Uring::Unregister(Descriptor* descriptor)
@@ -416,9 +843,74 @@ void Uring::Unregister(Descriptor* descriptor)
         spdlog::warn("uring unregister_files_update failed fd={} slot={} ret={}",
             descriptor->m_fd, idx, ret);
     }
+
+    // Slots in the direct range go back to the kernel's allocator, which the clear above did
+    //
+    if (idx < m_directBase)
+    {
+        m_freeSlots.push_back(idx);
+    }
     descriptor->m_registeredIndex = -1;
     SPDLOG_TRACE("uring unregister fd={} slot={}", descriptor->m_fd, idx);
 }
 
+// Map and register the fixed buffer pool as one region, so FixedBufferIndex is a subtraction and
+// one MAP_POPULATE faults the whole pool in up front rather than on first use.
+//
+void Uring::RegisterFixedBuffers()
+{
+    size_t size = (m_config.fixedBufferSize + 4095) & ~size_t(4095);
+    uint32_t count = m_config.fixedBuffers;
+    void* base = mmap(nullptr, size * count, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        spdlog::warn("uring fixed buffers mmap failed errno={}, no fixed buffers", errno);
+        return;
+    }
+
+    std::vector<struct iovec> iovecs(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        iovecs[i].iov_base = static_cast<char*>(base) + i * size;
+        iovecs[i].iov_len = size;
+    }
+
+    int ret = io_uring_register_buffers(&m_ring, iovecs.data(), count);
+    if (ret < 0)
+    {
+        spdlog::warn("uring register_buffers failed ret={}, no fixed buffers", ret);
+        munmap(base, size * count);
+        return;
+    }
+
+    spdlog::info("uring fixed buffers registered count={} size={}", count, size);
+    m_fixedBase = base;
+    m_fixedBufferSize = size;
+    m_fixedCount = count;
+    m_fixedFree.reserve(count);
+    for (uint32_t i = count; i > 0; i--)
+    {
+        m_fixedFree.push_back(static_cast<int>(i - 1));
+    }
+}
+
+Uring::FixedBuffer Uring::AcquireFixedBuffer()
+{
+    if (m_fixedFree.empty())
+    {
+        return {nullptr, -1};
+    }
+    int index = m_fixedFree.back();
+    m_fixedFree.pop_back();
+    return {static_cast<char*>(m_fixedBase) + index * m_fixedBufferSize, index};
+}
+
+void Uring::ReleaseFixedBuffer(int index)
+{
+    assert(index >= 0 && static_cast<uint32_t>(index) < m_fixedCount);
+    m_fixedFree.push_back(index);
+}
+
 } // end namespace io
 } // end namespace coop
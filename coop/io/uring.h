@@ -8,11 +8,16 @@
 #include <vector>
 
 #include "descriptor.h"
+#include "detached.h"
 #include "uring_configuration.h"
 
 #include "coop/coordinator.h"
 #include "coop/detail/embedded_list.h"
 
+#ifndef IORING_FEAT_RECVSEND_BUNDLE
+#define IORING_FEAT_RECVSEND_BUNDLE (1U << 14)
+#endif
+
 namespace coop
 {
 
@@ -22,6 +27,7 @@ namespace io
 {
 
 struct BufferRing;
+struct BufferRingSet;
 
 // the coop::io::Uring serves as a wrapper around io_uring, as wrapped by liburing. It is not
 // expected that most developers will need to interact with the uring in any direct fashion:
@@ -46,6 +52,65 @@ struct Uring
     //
     BufferRing* GetBufferRing() const { return m_bufferRing.get(); }
 
+    // The default buffer ring set registered by Init from UringConfiguration::bufferRingClassSizes;
+    // nullptr when not configured or unsupported.
+    //
+    BufferRingSet* GetBufferRingSet() const { return m_bufferRingSet.get(); }
+
+    // Whether Init reserved a direct-descriptor range (UringConfiguration::directSlots) for the
+    // kernel to allocate from, which a direct multishot accept requires.
+    //
+    bool SupportsDirectDescriptors() const
+    {
+        return m_directBase < static_cast<int>(m_registered.size());
+    }
+
+    // Reserve a free slot of the registered file table (below the direct range) for a file the
+    // kernel installs itself, e.g. io::OpenDirect. Returns the slot, or -1 when none is free or the
+    // table was never registered. Adopt the slot with Descriptor(direct, slot); closing that
+    // descriptor clears the slot and returns it to the free pool.
+    //
+    int ReserveSlot();
+
+    // Slots of the registered file table free for Register or ReserveSlot
+    //
+    size_t FreeSlots() const { return m_freeSlots.size(); }
+
+    // Registered buffer pool (UringConfiguration::fixedBuffers). Acquire returns a buffer of
+    // FixedBufferSize() bytes and its registration index, or {nullptr, -1} when the pool is empty
+    // or was never registered; Release returns it. Buffers are handed out LIFO so the hottest one
+    // is reused first. Owning thread only.
+    //
+    struct FixedBuffer
+    {
+        void*   data;
+        int     index;
+    };
+
+    FixedBuffer AcquireFixedBuffer();
+    void ReleaseFixedBuffer(int index);
+    size_t FixedBufferSize() const { return m_fixedBufferSize; }
+    bool SupportsFixedBuffers() const { return m_fixedBase != nullptr; }
+
+    // The index of the registered buffer that wholly contains [ptr, ptr + size), or -1. The kernel
+    // accepts any sub-range of a registered buffer, so this is what lets code holding a pointer
+    // into the pool (a Connection laid out inside a fixed buffer) pick the fixed op per call.
+    //
+    int FixedBufferIndex(void const* ptr, size_t size) const
+    {
+        auto off = static_cast<char const*>(ptr) - static_cast<char const*>(m_fixedBase);
+        if (!m_fixedBase || off < 0 || static_cast<size_t>(off) >= m_fixedBufferSize * m_fixedCount)
+        {
+            return -1;
+        }
+        size_t index = static_cast<size_t>(off) / m_fixedBufferSize;
+        if (static_cast<size_t>(off) + size > (index + 1) * m_fixedBufferSize)
+        {
+            return -1;
+        }
+        return static_cast<int>(index);
+    }
+
     // True when io_uring has completions waiting to be harvested -- either CQEs already sitting in
     // the completion ring, or, under COOP_TASKRUN, kernel task_work that will materialize CQEs on
     // the next io_uring_enter(). It is a pure userspace read of kernel-mapped ring memory (the CQ
@@ -86,16 +151,119 @@ struct Uring
 
     // Block until at least one CQE is available. Submits pending SQEs first. Used by the
     // cooperator when all contexts are blocked on IO — replaces a tight spin with an efficient
-    // kernel wait. Returns number of CQEs dispatched.
+    // kernel wait. Returns number of CQEs dispatched. With UringConfiguration::busyPollUs the wait
+    // busy-polls first, in the kernel (NAPI) or here.
     //
     int WaitAndPoll();
 
+    // Whether Init registered NAPI busy polling (UringConfiguration::busyPollUs)
+    //
+    bool BusyPollsNapi() const { return m_napiRegistered; }
+
+    // How long the next wait will spin before sleeping (UringConfiguration::adaptiveSpinMaxUs),
+    // from the recent waits; 0 when it will not
+    //
+    int64_t AdaptiveSpinWindowNs() const;
+
+    UringConfiguration const& GetConfiguration() const { return m_config; }
+
+    // Pressure on the rings, and the growth it set off (UringConfiguration::maxEntries)
+    //
+    struct RingStatistics
+    {
+        uint64_t sqFull{0};         // GetSqe calls that found the SQ full and submitted early
+        uint64_t cqOverflow{0};     // Polls that found completions on the kernel's overflow list
+        uint64_t resizes{0};        // IORING_REGISTER_RESIZE_RINGS growths
+    };
+
+    RingStatistics const& GetRingStatistics() const { return m_ringStatistics; }
+
+    uint32_t SqEntries() const { return m_ring.sq.ring_entries; }
+    uint32_t CqEntries() const { return m_ring.cq.ring_entries; }
+
     // Get an SQE from the submission ring. If the ring is full, flushes pending SQEs to the
     // kernel and retries. Returns nullptr only if the ring is truly exhausted (shouldn't happen
     // in normal operation).
     //
     struct io_uring_sqe* GetSqe();
 
+    // Post a CQE carrying `data` as its userdata onto another ring (IORING_OP_MSG_RING) -- the
+    // cross-thread doorbell between cooperators. The SQE rides this ring's next submit like any
+    // other; its own completion on this ring reports `ackData`, which the caller's CQE dispatch must
+    // recognize and drop. Returns false if the kernel lacks MSG_RING (see SupportsMessages) or no
+    // SQE is available.
+    //
+    bool SendMessage(Uring const& target, uintptr_t data, uintptr_t ackData);
+
+    // Whether this kernel supports IORING_OP_MSG_RING, probed once by Init (5.18+).
+    //
+    bool SupportsMessages() const { return m_msgRingSupported; }
+
+    // Whether recvs may set IORING_RECVSEND_BUNDLE (IORING_FEAT_RECVSEND_BUNDLE, 6.10+)
+    //
+    bool SupportsRecvBundles() const { return m_ring.features & IORING_FEAT_RECVSEND_BUNDLE; }
+
+    // Whether this kernel supports IORING_OP_SEND_ZC, probed once by Init (6.0+).
+    //
+    bool SupportsSendZc() const { return m_sendZcSupported; }
+
+    // Whether one IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL cancel can take every operation
+    // on a file, fixed or not (6.0+, probed with SEND_ZC)
+    //
+    bool SupportsCancelFd() const { return m_sendZcSupported; }
+
+    // Whether a cancel can match by opcode (IORING_ASYNC_CANCEL_OP, 6.6+, probed by an opcode of
+    // the next release, as SupportsSocketCommands is)
+    //
+    bool SupportsCancelOp() const { return m_socketCommandsSupported; }
+
+    // Cancel every operation in flight on this ring that waits on something outside the process --
+    // recvs, accepts, connects, polls, reads and futex waits -- with one IORING_ASYNC_CANCEL_OP |
+    // IORING_ASYNC_CANCEL_ALL cancel per opcode, instead of one cancel per Handle. Sends, closes,
+    // timeouts and the rest are left alone: they finish on their own, and a cleanup path may be
+    // counting on them. Each cancelled operation completes -ECANCELED through its own CQE, as
+    // after Handle::Cancel. The cooperator's shutdown sweep issues it
+    // (CooperatorConfiguration::shutdownBulkCancel). Returns the cancels prepared, 0 without
+    // SupportsCancelOp; they ride the next submit.
+    //
+    int CancelWaiting();
+
+    // What CancelWaiting did: the cancels issued, the operations they took, and the cancels the
+    // kernel refused (an unmatched opcode is not a refusal)
+    //
+    struct CancelStatistics
+    {
+        uint64_t bulkCancels{0};
+        uint64_t bulkCancelled{0};
+        uint64_t bulkFailed{0};
+    };
+
+    CancelStatistics const& GetCancelStatistics() const { return m_cancelStatistics; }
+
+    // A CancelWaiting cancel's own completion: res is how many operations it took
+    //
+    void OnBulkCancel(int res);
+
+    // Whether io::Socket can create sockets (IORING_OP_SOCKET, 5.19+), and io::SetSockOpt set
+    // their options (SOCKET_URING_OP_SETSOCKOPT, 6.7+, probed by an opcode of the same release)
+    //
+    bool SupportsSocket() const { return m_socketSupported; }
+    bool SupportsSocketCommands() const { return m_socketCommandsSupported; }
+
+    // Whether the kernel honors IOSQE_CQE_SKIP_SUCCESS (IORING_FEAT_CQE_SKIP, 5.17+), which the
+    // detached ops (detached.h) set
+    //
+    bool SupportsCqeSkip() const { return m_ring.features & IORING_FEAT_CQE_SKIP; }
+
+    // Whether the ring was set up with the big SQEs and CQEs passthrough commands ride in
+    // (UringConfiguration::sqe128 and cqe32; nvme.h)
+    //
+    bool SupportsPassthrough() const
+    {
+        constexpr unsigned both = IORING_SETUP_SQE128 | IORING_SETUP_CQE32;
+        return (m_ring.flags & both) == both;
+    }
+
     void Run(Context* ctx);
 
     // TODO lock down the guts
@@ -110,22 +278,74 @@ struct Uring
     void Register(Descriptor*);
     void Unregister(Descriptor*);
 
+    void RegisterFixedBuffers();
+    void RegisterNapi();
+
+    // Double the rings after SQ exhaustion or CQ overflow, up to maxEntries; where the kernel or
+    // liburing cannot, warn once with the size to configure instead
+    //
+    void Grow();
+
+    // Poll until a CQE is dispatched or budgetNs runs out. Returns the CQEs dispatched.
+    //
+    int SpinPoll(int64_t budgetNs);
+
+    // Fold one wait's time to its first completion into m_waitGapNs
+    //
+    void RecordWaitGap(int64_t gapNs);
+
     struct  io_uring m_ring;
     DescriptorList m_descriptors;
     int m_pendingOps{0};
     int m_pendingSqes{0};
+    bool m_msgRingSupported{false};
+    bool m_sendZcSupported{false};
+    bool m_socketSupported{false};
+    bool m_socketCommandsSupported{false};
+    bool m_napiRegistered{false};
+
+    // Set by the pressure the statistics count, acted on by Poll once it has reaped. m_growHalted
+    // once growth reached maxEntries or was refused.
+    //
+    RingStatistics m_ringStatistics;
+    bool m_growWanted{false};
+    bool m_growHalted{false};
+
+    // Detached ops (detached.h): their counts, and who hears of their failures
+    //
+    DetachedStatistics    m_detachedStatistics;
+    DetachedErrorCallback m_detachedErrorCallback{nullptr};
+
+    CancelStatistics m_cancelStatistics;
 
-    // io_uring fd registration table. Slots contain the real fd or -1 for empty. Registration is
-    // opt-in via the Descriptor(Registered, ...) constructor. When a descriptor is registered, its
-    // slot index is stored in Descriptor::m_registeredIndex and operations use IOSQE_FIXED_FILE.
+    // Moving average of the adaptive waits' time to first completion
     //
+    int64_t m_waitGapNs{0};
+
+    // io_uring fd registration table. Slots contain the real fd, -1 for empty, or kReservedSlot
+    // while a ReserveSlot caller owns it. Registration is opt-in via the Descriptor(Registered, ...)
+    // constructor. When a descriptor is registered, its slot index is stored in
+    // Descriptor::m_registeredIndex and operations use IOSQE_FIXED_FILE. m_freeSlots holds the
+    // free slots below m_directBase, so claiming and releasing one is O(1) at any table size.
+    //
+    static constexpr int kReservedSlot = -2;
     std::vector<int> m_registered;
+    std::vector<int> m_freeSlots;
+    int m_directBase;               // first slot of the kernel-allocated direct range
+
+    // Registered buffer pool: one mapping of m_fixedCount buffers, m_fixedFree the free indexes
+    //
+    void*               m_fixedBase = nullptr;
+    size_t              m_fixedBufferSize = 0;
+    uint32_t            m_fixedCount = 0;
+    std::vector<int>    m_fixedFree;
     UringConfiguration m_config;
 
     // Optional default provided buffer ring, registered by Init when configured and supported.
     // Held by pointer so its registration outlives Init and is torn down with the Uring.
     //
     std::unique_ptr<BufferRing> m_bufferRing;
+    std::unique_ptr<BufferRingSet> m_bufferRingSet;
 };
 
 } // end namespace io
@@ -7,10 +7,18 @@ namespace coop
 namespace io
 {
 
+struct SqpollPool;
+
 struct UringConfiguration
 {
     int entries = 64;
-    int registeredSlots = 64;
+
+    // Size of the registered (fixed) file table, registered sparse so its size costs nothing up
+    // front. Size it to the ring's connection limit: every server connection is registered, and
+    // one over the limit just runs unregistered. Clamped to RLIMIT_NOFILE, which the kernel
+    // enforces on the table. 0 registers no table.
+    //
+    int registeredSlots = 1024;
     const char* taskName = "Uring";
 
     // IORING_SETUP_SQPOLL: kernel thread polls the SQ for new entries, avoiding io_uring_enter()
@@ -27,9 +35,11 @@ struct UringConfiguration
     unsigned sqpollIdleMs = 0;
 
     // IORING_SETUP_IOPOLL: kernel busy-polls for I/O completions instead of using interrupts.
-    // Only works with O_DIRECT / pollable operations. NOTE: the current Uring::Run() loop uses
-    // io_uring_peek_cqe which does not trigger IOPOLL reaping — enabling this requires Run()
-    // adaptations that are not yet implemented.
+    // Only O_DIRECT reads and writes (on a device that supports polling) are allowed on such a
+    // ring, so it is meant for a dedicated storage Uring next to the cooperator's own: the one
+    // CooperatorConfiguration::storage sets up, which the cooperator loop drives, or a standalone
+    // ring driven by Uring::Run on a context of its own (see coop/io/direct_file.h). Poll() reaps
+    // it with a polling enter whenever IO is outstanding.
     //
     bool iopoll = false;
 
@@ -47,6 +57,27 @@ struct UringConfiguration
     //
     bool deferTaskrun = false;
 
+    // Upper bound for growing the rings under pressure. When GetSqe finds the SQ full or Poll finds
+    // completions on the kernel's CQ overflow list, the next Poll doubles the SQ (and the CQ with
+    // it) through IORING_REGISTER_RESIZE_RINGS, up to this many SQ entries, so a small ring on an
+    // idle cooperator still rides out a burst. Resizing needs kernel 6.13+, deferTaskrun and
+    // liburing 2.9+; without them, or past the bound, the ring warns once with the entries to
+    // configure and keeps its size. Uring::GetRingStatistics counts both kinds of pressure. 0
+    // never grows.
+    //
+    int maxEntries = 4096;
+
+    // IORING_SETUP_CQE32: 32-byte CQEs. Zero-copy receive (coop/io/zcrx.h) reports where its bytes
+    // landed in the upper half, so a ring that registers a ZcrxQueue needs this, and deferTaskrun.
+    // Doubles the CQ's memory and the cache lines the reap loop touches; off by default.
+    //
+    bool cqe32 = false;
+
+    // IORING_SETUP_SQE128: 128-byte SQEs, whose upper half carries a passthrough command -- the
+    // NVMe ops (coop/io/nvme.h) need this and cqe32. Doubles the SQ's memory, like cqe32 the CQ's.
+    //
+    bool sqe128 = false;
+
     // IORING_SETUP_SINGLE_ISSUER is always forced and is not configurable — the cooperative
     // model guarantees only the cooperator's thread submits to the ring.
 
@@ -56,6 +87,12 @@ struct UringConfiguration
     //
     int attachSqFd = -1;
 
+    // Shared SQPOLL pollers (coop/io/sqpoll_pool.h). With sqpoll set, the ring joins the pool in
+    // Init and becomes one of its node's pollers or attaches to one, so attachSqFd is filled in
+    // automatically. nullptr (the default) leaves attachSqFd as given.
+    //
+    SqpollPool* sqpollPool = nullptr;
+
     // Default provided buffer ring (IORING_REGISTER_PBUF_RING, kernel 5.19+). A buffer ring lets
     // multishot recv draw a recv buffer from a shared pool only when bytes actually arrive,
     // instead of pinning one userspace buffer per armed connection. When bufferRingEntries > 0,
@@ -71,11 +108,68 @@ struct UringConfiguration
     uint32_t bufferRingEntries = 0;
     uint32_t bufferRingBufSize = 4096;
     uint16_t bufferRingGroup = 0;
+
+    // Register the default ring with incremental consumption (IOU_PBUF_RING_INC, 6.12+), so one
+    // large buffer absorbs many small recvs before it is recycled. Falls back to whole-buffer
+    // consumption on older kernels; see BufferRing.
+    //
+    bool bufferRingIncremental = false;
+
+    // Default buffer ring set (coop/io/buffer_ring_set.h): up to four buffer-size classes, smallest
+    // first, each a ring of bufferRingClassEntries buffers (rounded up to a power of two) under
+    // group id bufferRingClassGroup + its index, reachable via Uring::GetBufferRingSet(). An
+    // ArmedHandle on the set moves a connection between classes as its message sizes change. A
+    // zero size ends the list; all zero (the default) registers no set. Degrades like the single
+    // ring above: a failed registration warns and leaves no set.
+    //
+    uint32_t bufferRingClassSizes[4] = {};
+    uint32_t bufferRingClassEntries = 256;
+    uint16_t bufferRingClassGroup = 1;
+
+    // Trailing registered slots reserved for the kernel to install direct descriptors into
+    // (IORING_REGISTER_FILE_ALLOC_RANGE, kernel 6.0+), as a direct multishot accept does: the
+    // accepted socket lives only in the fixed-file table, never in the process fd table. Counted
+    // within registeredSlots; Descriptor(Registered, ...) only uses the slots below the range. If
+    // the kernel rejects the range, Init warns and direct accept is unavailable.
+    //
+    int directSlots = 0;
+
+    // Registered (fixed) buffer pool (io_uring_register_buffers). A plain read or write makes the
+    // kernel pin the user pages for the duration of every op; a registered buffer is pinned once,
+    // here, and ReadFixed/WriteFixed/SendFixed (coop/io/fixed.h) name it by index instead. When
+    // fixedBuffers > 0, Init maps fixedBuffers buffers of fixedBufferSize bytes each and registers
+    // them; Uring::AcquireFixedBuffer hands them out. Registration is the feature probe: if it
+    // fails (RLIMIT_MEMLOCK, or an old kernel), Init warns and the pool is empty.
+    //
+    uint32_t fixedBuffers = 0;
+    uint32_t fixedBufferSize = 65536;
+
+    // Busy polling, for cooperators pinned to latency-critical cores. With busyPollUs > 0 a
+    // WaitAndPoll that would sleep first polls for up to busyPollUs: Init registers io_uring NAPI
+    // busy polling (io_uring_register_napi, kernel 6.9+ with liburing 2.6+), so the wait spins on
+    // the receive queues of the sockets the ring has used; where that registration is unavailable
+    // WaitAndPoll spins on the completion queue in userspace for the same bound. Either way an
+    // idle cooperator burns its core, so leave it off everywhere else. preferBusyPoll also asks
+    // the kernel to leave those queues to the busy poller rather than softirqs (prefer_busy_poll).
+    // io::SetBusyPoll (busy_poll.h) sets the matching socket options.
+    //
+    uint32_t busyPollUs = 0;
+    bool preferBusyPoll = false;
+
+    // Adaptive spin before sleeping, for request/response traffic whose next completion usually
+    // arrives within microseconds, where the sleep and wake would cost more than the wait. With
+    // adaptiveSpinMaxUs > 0, WaitAndPoll tracks how long recent waits took to their first
+    // completion (a moving average) and spins on the CQ for twice that, capped here, before
+    // entering the kernel to sleep. Once waits run longer than the cap it stops spinning until
+    // they shorten again. WaitSpinHit / WaitSpinMiss (perf counters) count the outcomes. A fixed
+    // userspace busyPollUs spin takes precedence. 0 (the default) keeps the plain blocking wait.
+    //
+    uint32_t adaptiveSpinMaxUs = 0;
 };
 
 static const UringConfiguration s_defaultUringConfiguration = {
     .entries = 64,
-    .registeredSlots = 64,
+    .registeredSlots = 1024,
     .taskName = "Uring",
     .sqpoll = false,
     .sqpollIdleMs = 0,
@@ -0,0 +1,443 @@
+#include "wal.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <spdlog/spdlog.h>
+
+#include "coop/cooperator.h"
+#include "coop/coordinate_with.h"
+
+#include "chain.h"
+#include "fallocate.h"
+#include "fixed.h"
+#include "fsync.h"
+#include "open.h"
+#include "uring.h"
+#include "write.h"
+#include "writev.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+namespace
+{
+
+size_t AlignUp(size_t value)
+{
+    return (value + Wal::kAlignment - 1) & ~(Wal::kAlignment - 1);
+}
+
+// Finish a write the kernel cut short: skip the done bytes and write the rest where it goes.
+// Returns 0 or a negative errno.
+//
+int WriteRest(Descriptor& segment, struct iovec* iov, int iovcnt, uint64_t offset, size_t done,
+              size_t total, int flags)
+{
+    size_t remaining = total - done;
+    for (;;)
+    {
+        offset += done;
+        while (iovcnt > 0 && done >= iov->iov_len)
+        {
+            done -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (done > 0)
+        {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + done;
+            iov->iov_len -= done;
+        }
+        if (remaining == 0)
+        {
+            return 0;
+        }
+
+        int n = WritevAt(segment, iov, iovcnt, offset, flags);
+        if (n <= 0)
+        {
+            return n < 0 ? n : -EIO;
+        }
+        done = static_cast<size_t>(n);
+        remaining -= done;
+    }
+}
+
+} // end anon namespace
+
+Wal::Wal(
+        char const* directory,
+        uint64_t startLsn,
+        WalConfiguration const& configuration,
+        Context* ctx,
+        Uring* ring)
+: m_directory(directory)
+, m_configuration(configuration)
+, m_ring(ring)
+, m_segmentStart(startLsn)
+, m_nextLsn(startLsn)
+, m_batchBytes(std::max<size_t>(configuration.maxBatchBytes, 1))
+{
+    m_configuration.maxBatchRecords =
+        std::clamp<size_t>(m_configuration.maxBatchRecords, 1, kMaxIov);
+    m_wake.TryAcquire();
+
+    int fd = Open(directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        m_error = fd;
+        return;
+    }
+    m_directoryFd.emplace(fd, m_ring);
+
+    if (m_configuration.direct)
+    {
+        // Room for a batch behind the partial block carried over from the last one
+        //
+        if (m_ring->SupportsFixedBuffers() && m_ring->FixedBufferSize() >= 2 * kAlignment)
+        {
+            auto block = m_ring->AcquireFixedBuffer();
+            m_staging = static_cast<char*>(block.data);
+            m_stagingIndex = block.index;
+            m_stagingSize = m_ring->FixedBufferSize() & ~(kAlignment - 1);
+        }
+        if (!m_staging)
+        {
+            m_stagingSize = AlignUp(m_batchBytes) + kAlignment;
+            void* memory = nullptr;
+            if (posix_memalign(&memory, kAlignment, m_stagingSize) != 0)
+            {
+                m_error = -ENOMEM;
+                return;
+            }
+            m_staging = static_cast<char*>(memory);
+        }
+        m_batchBytes = m_stagingSize - kAlignment;
+    }
+
+    if (int result = OpenSegment(startLsn); result < 0)
+    {
+        m_error = result;
+        return;
+    }
+
+    // The flusher holds m_flusherExit for its whole run; it starts inside Spawn, so it has taken
+    // it before the destructor can wait on it
+    //
+    bool spawned = ctx->GetCooperator()->Spawn([this](Context* flushCtx)
+    {
+        flushCtx->SetName("WalFlusher");
+        m_flusherExit.Acquire(flushCtx);
+        Flush(flushCtx);
+        m_stopped = true;
+        m_flusherExit.Release(flushCtx, false);
+    }, &m_flusher);
+    if (!spawned)
+    {
+        m_error = -EAGAIN;
+    }
+}
+
+Wal::~Wal()
+{
+    auto* ctx = Self();
+    if (m_flusher)
+    {
+        m_flusher.Kill();
+    }
+    m_flusherExit.Acquire(ctx);
+    m_flusherExit.Release(ctx, false);
+
+    if (m_stagingIndex >= 0)
+    {
+        m_ring->ReleaseFixedBuffer(m_stagingIndex);
+    }
+    else
+    {
+        free(m_staging);
+    }
+    if (m_segment)
+    {
+        m_segment->Close();
+    }
+    if (m_directoryFd)
+    {
+        m_directoryFd->Close();
+    }
+}
+
+int64_t Wal::Append(Context* ctx, void const* data, size_t size)
+{
+    struct iovec iov{const_cast<void*>(data), size};
+    return Append(ctx, &iov, 1);
+}
+
+int64_t Wal::Append(Context* ctx, struct iovec const* iov, int iovcnt)
+{
+    if (m_error)
+    {
+        return m_error;
+    }
+    if (m_stopped)
+    {
+        return -ESHUTDOWN;
+    }
+    if (iovcnt <= 0 || iovcnt > kMaxIov)
+    {
+        return -EINVAL;
+    }
+
+    Record record;
+    record.iov = iov;
+    record.iovcnt = iovcnt;
+    record.size = 0;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        record.size += iov[i].iov_len;
+    }
+    if (m_configuration.direct && record.size > m_batchBytes)
+    {
+        return -EMSGSIZE;
+    }
+    record.result = static_cast<int64_t>(m_nextLsn);
+    m_nextLsn += record.size;
+    m_statistics.appends++;
+
+    record.done.TryAcquire(ctx);
+    m_pending.Push(&record);
+    if (m_idle)
+    {
+        m_idle = false;
+        m_wake.Release(ctx, false);
+    }
+
+    // The flusher releases it once the batch is durable or failed; the record is in use until then
+    //
+    record.done.Acquire(ctx);
+    record.done.Release(ctx, false);
+    return record.result;
+}
+
+void Wal::Flush(Context* ctx)
+{
+    Record* batch[kMaxIov];
+    for (;;)
+    {
+        if (m_pending.IsEmpty())
+        {
+            if (ctx->IsKilled())
+            {
+                return;
+            }
+            m_idle = true;
+            CoordinateWithKill(ctx, &m_wake);
+            m_idle = false;
+            continue;
+        }
+
+        // As much of the queue as one commit may take, and at least its head
+        //
+        size_t count = 0;
+        size_t bytes = 0;
+        int iovs = 0;
+        while (!m_pending.IsEmpty())
+        {
+            Record* record = m_pending.Peek();
+            if (count > 0 && (count == m_configuration.maxBatchRecords ||
+                              iovs + record->iovcnt > kMaxIov ||
+                              bytes + record->size > m_batchBytes))
+            {
+                break;
+            }
+            m_pending.Pop();
+            batch[count++] = record;
+            bytes += record->size;
+            iovs += record->iovcnt;
+        }
+
+        int result = m_error ? m_error : Commit(ctx, batch, count, bytes);
+        if (result < 0 && !m_error)
+        {
+            spdlog::warn("wal commit failed err={}, log stopped", result);
+            m_error = result;
+        }
+
+        // Not scheduling: the whole batch becomes runnable and the flusher goes on to the next
+        //
+        for (size_t i = 0; i < count; i++)
+        {
+            if (result < 0)
+            {
+                batch[i]->result = result;
+            }
+            batch[i]->done.Release(ctx, false);
+        }
+    }
+}
+
+int Wal::Commit(Context* ctx, Record** batch, size_t count, size_t bytes)
+{
+    if (m_segmentOffset > 0 && m_segmentOffset + bytes > m_configuration.segmentSize)
+    {
+        if (int result = OpenSegment(m_segmentStart + m_segmentOffset); result < 0)
+        {
+            return result;
+        }
+        m_statistics.rotations++;
+    }
+
+    int result = m_configuration.direct
+        ? CommitDirect(ctx, batch, count)
+        : CommitBuffered(ctx, batch, count, bytes);
+    if (result < 0)
+    {
+        return result;
+    }
+    m_segmentOffset += bytes;
+    m_statistics.batches++;
+    m_statistics.bytes += bytes;
+    return 0;
+}
+
+int Wal::CommitBuffered(Context* ctx, Record** batch, size_t count, size_t bytes)
+{
+    struct iovec iov[kMaxIov];
+    int iovcnt = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        for (int j = 0; j < batch[i]->iovcnt; j++)
+        {
+            iov[iovcnt++] = batch[i]->iov[j];
+        }
+    }
+
+    int written;
+    if (m_configuration.dsync)
+    {
+        written = WritevAt(*m_segment, iov, iovcnt, m_segmentOffset, RWF_DSYNC);
+    }
+    else
+    {
+        Chain chain(ctx, m_ring);
+        WritevAt(chain.Then(*m_segment), iov, iovcnt, m_segmentOffset);
+        Fsync(chain.Last(*m_segment), IORING_FSYNC_DATASYNC);
+        chain.Wait();
+        written = chain.Result(0);
+        if (written == static_cast<int>(bytes))
+        {
+            return chain.Result(1) < 0 ? chain.Result(1) : 0;
+        }
+    }
+    if (written < 0)
+    {
+        return written;
+    }
+
+    // Short: the soft link cancelled the sync, so finish the write and sync on its own
+    //
+    int flags = m_configuration.dsync ? RWF_DSYNC : 0;
+    if (int result = WriteRest(*m_segment, iov, iovcnt, m_segmentOffset,
+                               static_cast<size_t>(written), bytes, flags); result < 0)
+    {
+        return result;
+    }
+    return m_configuration.dsync ? 0 : Fsync(*m_segment, IORING_FSYNC_DATASYNC);
+}
+
+int Wal::CommitDirect(Context* ctx, Record** batch, size_t count)
+{
+    // The carried-over partial block, the batch behind it, zeros to the block boundary; written
+    // from the start of that block
+    //
+    size_t length = m_stagingTail;
+    for (size_t i = 0; i < count; i++)
+    {
+        for (int j = 0; j < batch[i]->iovcnt; j++)
+        {
+            std::memcpy(m_staging + length, batch[i]->iov[j].iov_base, batch[i]->iov[j].iov_len);
+            length += batch[i]->iov[j].iov_len;
+        }
+    }
+    size_t padded = AlignUp(length);
+    std::memset(m_staging + length, 0, padded - length);
+    uint64_t offset = m_segmentOffset - m_stagingTail;
+
+    Chain chain(ctx, m_ring);
+    Handle& write = m_configuration.dsync ? chain.Last(*m_segment) : chain.Then(*m_segment);
+    if (m_stagingIndex >= 0)
+    {
+        WriteFixed(write, m_staging, padded, m_stagingIndex, offset);
+    }
+    else
+    {
+        Write(write, m_staging, padded, offset);
+    }
+    if (!m_configuration.dsync)
+    {
+        Fsync(chain.Last(*m_segment), IORING_FSYNC_DATASYNC);
+    }
+    chain.Wait();
+
+    // O_DIRECT writes whole blocks or fail; a short one would leave a hole, so count it as failed
+    //
+    int written = chain.Result(0);
+    if (written != static_cast<int>(padded))
+    {
+        return written < 0 ? written : -EIO;
+    }
+    if (!m_configuration.dsync && chain.Result(1) < 0)
+    {
+        return chain.Result(1);
+    }
+
+    const size_t tail = length % kAlignment;
+    std::memmove(m_staging, m_staging + length - tail, tail);
+    m_stagingTail = tail;
+    return 0;
+}
+
+int Wal::OpenSegment(uint64_t startLsn)
+{
+    char path[4096];
+    std::snprintf(path, sizeof(path), "%s/%016" PRIx64 ".wal", m_directory.c_str(), startLsn);
+
+    int flags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+    if (m_configuration.direct)
+    {
+        flags |= O_DIRECT | (m_configuration.dsync ? O_DSYNC : 0);
+    }
+    int fd = Open(path, flags, 0644);
+    if (fd < 0)
+    {
+        return fd;
+    }
+    if (m_segment)
+    {
+        m_segment->Close();
+    }
+    m_segment.emplace(fd, m_ring);
+    m_segmentStart = startLsn;
+    m_segmentOffset = 0;
+    m_stagingTail = 0;
+
+    // Best effort: a filesystem without fallocate still works, its syncs just carry the size
+    //
+    int result = Fallocate(*m_segment, 0, 0, m_configuration.segmentSize);
+    if (result < 0 && result != -EOPNOTSUPP)
+    {
+        return result;
+    }
+    return Fsync(*m_directoryFd);
+}
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <sys/uio.h>
+
+#include "coop/context.h"
+#include "coop/coordinator.h"
+#include "coop/self.h"
+#include "coop/detail/embedded_list.h"
+
+#include "descriptor.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Uring;
+
+struct WalConfiguration
+{
+    // Bytes each segment file is preallocated to (fallocate), so a commit's fdatasync has no size
+    // change to write. A batch that would run past the end of the current segment starts a new one;
+    // a batch bigger than a whole segment still goes in one, which grows to fit.
+    //
+    size_t segmentSize = 64 << 20;
+
+    // Most bytes and records one group commit takes; appends beyond them wait for the next
+    //
+    size_t maxBatchBytes = 1 << 20;
+    size_t maxBatchRecords = 256;
+
+    // Make the write itself durable (RWF_DSYNC, or O_DSYNC with direct) instead of following it
+    // with a linked fdatasync
+    //
+    bool dsync = false;
+
+    // Open segments O_DIRECT and write through one aligned staging block: a registered buffer
+    // from the ring's pool when it has one (which then bounds a batch), else maxBatchBytes of
+    // aligned memory. Each batch rewrites the log's partial last block.
+    //
+    bool direct = false;
+};
+
+struct WalStatistics
+{
+    uint64_t appends = 0;
+    uint64_t batches = 0;           // group commits: one write and one sync each
+    uint64_t bytes = 0;
+    uint64_t rotations = 0;
+};
+
+// A write-ahead log with group commit. Any number of contexts Append; each blocks until its record
+// is durable and gets back its LSN, the record's byte position in the log. A flusher context the
+// log spawns takes every append waiting when it comes round, writes them with one writev at the
+// segment's offset and makes them durable with a linked fdatasync -- one io::Chain, one wait --
+// then wakes the whole batch in one pass. Appends that arrive while a commit is in flight form the
+// next batch, so under load N appends cost one sync, and an idle log costs one sync per append.
+//
+//   io::Wal wal("/var/lib/service/wal");
+//   int64_t lsn = wal.Append(ctx, record, size);       // durable once this returns >= 0
+//
+// The log is a sequence of segment files in directory, each named for the LSN of its first byte
+// (%016x.wal) and created exclusively: a Wal never writes over an existing segment, so one reopened
+// on a directory with history starts at the LSN recovery found (startLsn) and fails with -EEXIST
+// if that segment is already there. Records are raw bytes; framing them (length, checksum) and
+// reading the log back are the caller's. A new segment's directory entry is synced before the
+// first batch goes into it.
+//
+// A failed write or sync fails its whole batch and the log with it: later appends return the
+// same error, since after a failed fsync the kernel no longer says what reached the disk.
+//
+// Append is not kill-aware: the record stays in use until its batch completes. The log belongs to
+// the cooperator it was created on and is destroyed on a context of it; the destructor commits
+// whatever is still queued.
+//
+struct Wal
+{
+    static constexpr size_t kAlignment = 4096;
+    static constexpr int kMaxIov = 256;
+
+    Wal(char const* directory,
+        uint64_t startLsn = 0,
+        WalConfiguration const& configuration = {},
+        Context* ctx = Self(),
+        Uring* ring = GetUring());
+    ~Wal();
+
+    Wal(Wal const&) = delete;
+    Wal& operator=(Wal const&) = delete;
+
+    // 0 while the log works, else the negative errno that stopped it (at open or on a commit)
+    //
+    int Error() const { return m_error; }
+    bool IsOpen() const { return m_error == 0; }
+
+    // Block until the record is durable. Returns its LSN, or a negative errno: the log's error,
+    // -EINVAL for more than kMaxIov iovecs, -EMSGSIZE for a direct-mode record bigger than a
+    // batch, -ESHUTDOWN once the flusher has exited.
+    //
+    int64_t Append(Context* ctx, void const* data, size_t size);
+    int64_t Append(Context* ctx, struct iovec const* iov, int iovcnt);
+
+    int64_t Append(void const* data, size_t size) { return Append(Self(), data, size); }
+
+    // The LSN the next append will get, and the end of the last durable batch
+    //
+    uint64_t NextLsn() const { return m_nextLsn; }
+    uint64_t DurableLsn() const { return m_segmentStart + m_segmentOffset; }
+
+    WalStatistics const& GetStatistics() const { return m_statistics; }
+
+  private:
+    struct Record : EmbeddedListHookups<Record>
+    {
+        struct iovec const* iov;
+        int                 iovcnt;
+        size_t              size;
+        int64_t             result;         // the LSN until the batch lands, then the outcome
+        Coordinator         done;           // held until then
+    };
+
+    void Flush(Context* ctx);
+    int Commit(Context* ctx, Record** batch, size_t count, size_t bytes);
+    int CommitBuffered(Context* ctx, Record** batch, size_t count, size_t bytes);
+    int CommitDirect(Context* ctx, Record** batch, size_t count);
+    int OpenSegment(uint64_t startLsn);
+
+    std::string                 m_directory;
+    WalConfiguration            m_configuration;
+    Uring*                      m_ring;
+    int                         m_error = 0;
+
+    std::optional<Descriptor>   m_directoryFd;
+    std::optional<Descriptor>   m_segment;
+    uint64_t                    m_segmentStart;
+    uint64_t                    m_segmentOffset = 0;
+    uint64_t                    m_nextLsn;
+    size_t                      m_batchBytes;
+
+    // direct: the staging block, its registration index (-1 for plain memory) and how many bytes
+    // at its start are the segment's partial last block, already on disk
+    //
+    char*                       m_staging = nullptr;
+    int                         m_stagingIndex = -1;
+    size_t                      m_stagingSize = 0;
+    size_t                      m_stagingTail = 0;
+
+    EmbeddedList<Record>        m_pending;
+
+    // Held while the flusher has nothing to do and m_idle says so; an append releases it
+    //
+    Coordinator                 m_wake;
+    bool                        m_idle = false;
+    bool                        m_stopped = false;
+
+    // Held by the flusher for its whole run, as FileCache's watcher does
+    //
+    Coordinator                 m_flusherExit;
+    Context::Handle             m_flusher;
+
+    WalStatistics               m_statistics;
+};
+
+} // end namespace coop::io
+} // end namespace coop
@@ -0,0 +1,292 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <liburing.h>
+
+#include "watcher.h"
+
+#include "uring.h"
+
+#include "coop/context.h"
+#include "coop/coordinate_with.h"
+#include "coop/self.h"
+#include "coop/thunk.h"
+#include "coop/detail/timer_tag.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+static_assert(alignof(Watcher) >= 2, "bit 0 of a Watcher's userdata tags its acknowledgements");
+
+Watcher::Watcher(Context* context, int fd, uint32_t events)
+: Watcher(context, GetUring(), fd, events)
+{
+}
+
+Watcher::Watcher(Context* context, Uring* ring, int fd, uint32_t events)
+: m_ring(ring)
+, m_context(context)
+, m_onReady(nullptr)
+, m_fd(fd)
+, m_events(events)
+{
+    Arm();
+}
+
+Watcher::Watcher(int fd, uint32_t events, Continuation* onReady)
+: Watcher(GetUring(), fd, events, onReady)
+{
+}
+
+Watcher::Watcher(Uring* ring, int fd, uint32_t events, Continuation* onReady)
+: m_ring(ring)
+, m_context(nullptr)
+, m_onReady(onReady)
+, m_fd(fd)
+, m_events(events)
+{
+    Arm();
+}
+
+Watcher::~Watcher()
+{
+    m_tearingDown = true;
+
+    // A continuation-driven watcher borrows whichever context destroys it for the drain
+    //
+    Context* ctx = m_context ? m_context : Self();
+    if (m_armed || m_acksPending > 0)
+    {
+        assert(ctx && "Watcher destroyed off a context with its poll still armed");
+        Remove();
+        m_coord.Flash(ctx);
+    }
+    else if (m_coord.IsHeld())
+    {
+        m_coord.Release(ctx, false);
+    }
+}
+
+uintptr_t Watcher::UserData() const
+{
+    return reinterpret_cast<uintptr_t>(this) | coop::detail::kWatchTag;
+}
+
+void Watcher::Arm()
+{
+    assert(!m_armed);
+
+    auto* sqe = m_ring->GetSqe();
+    assert(sqe);
+    io_uring_prep_poll_multishot(sqe, m_fd, m_events);
+    io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(UserData()));
+
+    // No-op once held, across re-arms. TryAcquire takes no owner, so the continuation mode holds
+    // it too: that is what its destructor's Flash waits on.
+    //
+    m_coord.TryAcquire(m_context);
+    m_ring->m_pendingOps++;
+    m_armed = true;
+}
+
+void Watcher::Remove()
+{
+    if (!m_armed || m_removing)
+    {
+        return;
+    }
+
+    auto* sqe = m_ring->GetSqe();
+    assert(sqe);
+    io_uring_prep_poll_remove(sqe, UserData());
+    io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(UserData() | 0x1));
+
+    m_removing = true;
+    m_acksPending++;
+    m_ring->m_pendingOps++;
+}
+
+void Watcher::SetEvents(uint32_t events)
+{
+    if (events == m_events)
+    {
+        return;
+    }
+    m_events = events;
+
+    // A poll that ends before the update reaches it fails the update with -ENOENT, and OnPoll's
+    // re-arm picks up m_events instead
+    //
+    if (!m_armed || m_removing)
+    {
+        return;
+    }
+
+    auto* sqe = m_ring->GetSqe();
+    assert(sqe);
+    io_uring_prep_poll_update(sqe, UserData(), UserData(), events,
+                              IORING_POLL_UPDATE_EVENTS | IORING_POLL_ADD_MULTI);
+    io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(UserData() | 0x1));
+
+    m_acksPending++;
+    m_ring->m_pendingOps++;
+}
+
+void Watcher::Dispatch(struct io_uring_cqe* cqe, uintptr_t data)
+{
+    auto* self = reinterpret_cast<Watcher*>(data & ~(coop::detail::kWatchAckTag));
+    if (data & 0x1)
+    {
+        self->OnAck();
+    }
+    else
+    {
+        self->OnPoll(cqe);
+    }
+}
+
+void Watcher::OnPoll(struct io_uring_cqe* cqe)
+{
+    // The CQ head is Uring::Poll's to advance, once per batch, as for every other callback
+    //
+    int res = cqe->res;
+    bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+
+    if (!more)
+    {
+        m_armed = false;
+        m_ring->m_pendingOps--;
+    }
+
+    if (m_tearingDown)
+    {
+        MaybeReleaseForTeardown();
+        return;
+    }
+
+    if (res < 0)
+    {
+        // -ECANCELED follows a removal, which only the destructor issues, or the cooperator's
+        // shutdown bulk cancel (Uring::CancelWaiting), which ends the watch for good
+        //
+        if (!more)
+        {
+            m_error = res;
+        }
+    }
+    else
+    {
+        m_edges++;
+        m_pending |= uint32_t(res);
+        if (!more)
+        {
+            // The kernel ended the poll itself (a full CQ drops multishots): keep watching
+            //
+            m_rearms++;
+            Arm();
+        }
+    }
+
+    Notify();
+}
+
+void Watcher::OnAck()
+{
+    m_acksPending--;
+    m_ring->m_pendingOps--;
+    if (m_tearingDown)
+    {
+        MaybeReleaseForTeardown();
+    }
+}
+
+void Watcher::Notify()
+{
+    if (m_onReady)
+    {
+        coop::detail::ThunkScope inThunk;
+        m_onReady->Run();
+        return;
+    }
+
+    // Consume the park token first, so a burst of edges in one Poll wakes the waiter once
+    //
+    if (m_parked)
+    {
+        m_parked = false;
+        m_coord.Release(m_context, false);
+    }
+}
+
+void Watcher::MaybeReleaseForTeardown()
+{
+    if (!m_armed && m_acksPending == 0)
+    {
+        m_coord.Release(m_context, false);
+    }
+}
+
+uint32_t Watcher::Take()
+{
+    uint32_t pending = m_pending;
+    m_pending = 0;
+    return pending;
+}
+
+int Watcher::Wait()
+{
+    return Next(/*killable=*/false, time::Interval(0));
+}
+
+int Watcher::Wait(time::Interval timeout)
+{
+    return Next(/*killable=*/false, timeout);
+}
+
+int Watcher::WaitKill()
+{
+    return Next(/*killable=*/true, time::Interval(0));
+}
+
+int Watcher::WaitKill(time::Interval timeout)
+{
+    return Next(/*killable=*/true, timeout);
+}
+
+int Watcher::Next(bool killable, time::Interval timeout)
+{
+    assert(m_context && !m_onReady && "a continuation-driven Watcher is not waited on");
+
+    while (m_pending == 0)
+    {
+        if (!m_armed)
+        {
+            return m_error < 0 ? m_error : -EINVAL;
+        }
+
+        m_parked = true;
+        CoordinationResult result = killable
+            ? (timeout.count() > 0 ? CoordinateWithKill(m_context, &m_coord, timeout)
+                                   : CoordinateWithKill(m_context, &m_coord))
+            : (timeout.count() > 0 ? CoordinateWith(m_context, &m_coord, timeout)
+                                   : CoordinateWith(m_context, &m_coord));
+        m_parked = false;
+
+        if (killable && result.Killed())
+        {
+            return -ECANCELED;
+        }
+        if (result.TimedOut())
+        {
+            return -ETIMEDOUT;
+        }
+    }
+
+    return int(Take());
+}
+
+} // end namespace io
+} // end namespace coop
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <poll.h>
+
+#include "coop/coordinator.h"
+#include "coop/time/interval.h"
+
+struct io_uring_cqe;
+
+namespace coop
+{
+
+struct Context;
+
+namespace io
+{
+
+struct Uring;
+
+// Watcher: readiness of a file descriptor that something else reads and writes.
+//
+// Database drivers and HTTP client libraries (libpq, hiredis, libcurl) do their own IO on their
+// own sockets and want only to be told when one is readable or writable. io::Poll answers that
+// once per SQE, so a driver pumping a connection pays a submission per wait. A Watcher arms one
+// multishot IORING_OP_POLL_ADD (IORING_POLL_ADD_MULTI) on the fd when it is constructed and keeps
+// it armed: each time the fd's wait queue fires, a CQE lands and its revents are ORed into the
+// watcher's pending set, for a waiting context or an inline continuation to take.
+//
+//   io::Watcher watcher(ctx, PQsocket(conn), POLLIN);
+//   while (PQisBusy(conn))
+//   {
+//       if (watcher.WaitKill() < 0) { ... }            // the pending revents, or -errno
+//       PQconsumeInput(conn);
+//   }
+//
+// Edges, not levels
+// -----------------
+//
+// The kernel posts a CQE when the fd becomes ready (and at arm time, if it already is), not once
+// per Wait while it stays ready. A reader must therefore read until the library reports it would
+// block before it waits again, as with EPOLLET; libpq's PQconsumeInput and libcurl's socket
+// actions both do. Readiness that arrives while nobody waits is kept, so Wait returns at once.
+//
+// Lifecycle
+// ---------
+//
+// The coordinator is held from construction to destruction, as an ArmedHandle holds its own
+// across the stream. Wait parks the owning context on it and the next edge wakes it. A poll the
+// kernel ends by itself (a CQ overflow drops F_MORE) is re-armed transparently; one that ends in
+// error stays down and Wait returns the error. SetEvents changes the mask in place with
+// IORING_POLL_UPDATE_EVENTS rather than a cancel and re-arm. The destructor removes the poll and
+// blocks until its terminal CQE has drained; the fd itself is the caller's, and stays open.
+//
+// Continuation mode
+// -----------------
+//
+// Constructed with a Continuation instead of a context, the watcher runs onReady->Run() inline
+// from the reap loop on every edge, under a ThunkScope -- the rule of a continuation-driven
+// Handle: Run must not suspend or Poll. Run takes the edge with Take(). Destroying the watcher
+// still drains the poll, so it must happen on a context, and not from inside its own Run. This
+// is what lets one driver context serve every socket of a curl multi handle (curl.h).
+//
+// Single-cooperator, like the rest of io: constructed, waited on and destroyed on one thread.
+//
+struct Watcher
+{
+    Watcher(Context* context, int fd, uint32_t events);
+    Watcher(Context* context, Uring* ring, int fd, uint32_t events);
+
+    Watcher(int fd, uint32_t events, Continuation* onReady);
+    Watcher(Uring* ring, int fd, uint32_t events, Continuation* onReady);
+
+    Watcher(Watcher const&) = delete;
+    Watcher(Watcher&&) = delete;
+
+    ~Watcher();
+
+    // Block until readiness is pending and return it (POLLIN, POLLOUT, POLLERR, POLLHUP, ...),
+    // clearing it. Returns the poll's error once it has ended and nothing is pending, -ETIMEDOUT
+    // when the timeout passes first, and -- for WaitKill -- -ECANCELED when the context is killed.
+    // Context mode only.
+    //
+    int Wait();
+    int Wait(time::Interval timeout);
+    int WaitKill();
+    int WaitKill(time::Interval timeout);
+
+    // The pending revents, cleared. Never blocks.
+    //
+    uint32_t Take();
+
+    uint32_t Pending() const { return m_pending; }
+
+    // Watch for events from now on. In place while armed; otherwise recorded for the re-arm.
+    //
+    void SetEvents(uint32_t events);
+
+    uint32_t Events() const { return m_events; }
+    int Fd() const { return m_fd; }
+
+    // False once the poll ended in error (Error()) or was removed
+    //
+    bool Armed() const { return m_armed; }
+    int Error() const { return m_error; }
+
+    // CQEs delivered, and re-arms after the kernel ended the poll by itself
+    //
+    uint64_t Edges() const { return m_edges; }
+    uint64_t Rearms() const { return m_rearms; }
+
+    // CQE entry point, from Handle::Callback on kWatchTag
+    //
+    static void Dispatch(struct io_uring_cqe* cqe, uintptr_t data);
+
+  private:
+    void Arm();
+    void Remove();
+    void OnPoll(struct io_uring_cqe* cqe);
+    void OnAck();
+    void Notify();
+    void MaybeReleaseForTeardown();
+    int Next(bool killable, time::Interval timeout);
+
+    uintptr_t UserData() const;
+
+    Uring*          m_ring;
+    Context*        m_context;
+    Continuation*   m_onReady;
+    Coordinator     m_coord;
+    int             m_fd;
+    uint32_t        m_events;
+    uint32_t        m_pending = 0;
+    int             m_error = 0;
+    uint32_t        m_acksPending = 0;
+    bool            m_armed = false;
+    bool            m_removing = false;
+    bool            m_parked = false;
+    bool            m_tearingDown = false;
+    uint64_t        m_edges = 0;
+    uint64_t        m_rearms = 0;
+};
+
+} // end namespace io
+} // end namespace coop
@@ -5,8 +5,10 @@
 #include "coop/coordinator.h"
 #include "coop/self.h"
 
+#include "cork.h"
 #include "descriptor.h"
 #include "handle.h"
+#include "detail/blocking_handle.h"
 #include "detail/handle_extension.h"
 
 namespace coop
@@ -29,13 +31,25 @@ bool Writev(Handle& handle, const struct iovec* iov, int iovcnt)
 
 int Writev(Descriptor& desc, const struct iovec* iov, int iovcnt)
 {
-    Coordinator coord;
-    Handle handle(Self(), desc, &coord);
+    // A corked descriptor's buffered sends go first (cork.h)
+    //
+    if (desc.m_cork)
+    {
+        int err = desc.m_cork->Flush();
+        if (err < 0)
+        {
+            return err;
+        }
+    }
+
+    detail::BlockingHandle blocking(Self(), desc);
+    Handle& handle = blocking.Get();
     if (!Writev(handle, iov, iovcnt))
     {
         return -EAGAIN;
     }
-    return handle.Wait();
+    int result = handle.Wait();
+    return handle.TimedOut() ? -ETIMEDOUT : result;
 }
 
 int WritevAll(Descriptor& desc, struct iovec* iov, int iovcnt)
@@ -78,5 +92,29 @@ int WritevAll(Descriptor& desc, struct iovec* iov, int iovcnt)
     return static_cast<int>(sent);
 }
 
+bool WritevAt(Handle& handle, const struct iovec* iov, int iovcnt, uint64_t offset, int flags)
+{
+    auto* sqe = detail::HandleExtension::GetSqe(handle);
+    if (!sqe)
+    {
+        return false;
+    }
+    io_uring_prep_writev2(sqe, detail::HandleExtension::Fd(handle), iov, iovcnt, offset, flags);
+    handle.Submit(sqe);
+    return true;
+}
+
+int WritevAt(Descriptor& desc, const struct iovec* iov, int iovcnt, uint64_t offset, int flags)
+{
+    detail::BlockingHandle blocking(Self(), desc);
+    Handle& handle = blocking.Get();
+    if (!WritevAt(handle, iov, iovcnt, offset, flags))
+    {
+        return -EAGAIN;
+    }
+    int result = handle.Wait();
+    return handle.TimedOut() ? -ETIMEDOUT : result;
+}
+
 } // end namespace coop::io
 } // end namespace coop
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <sys/uio.h>
 
 namespace coop
@@ -12,7 +13,8 @@ struct Descriptor;
 struct Handle;
 
 // Scatter-gather write. Submits a single io_uring_prep_writev SQE covering all iovecs.
-// For sockets this is equivalent to sendmsg without ancillary data.
+// For sockets this is equivalent to sendmsg without ancillary data. The blocking form flushes the
+// descriptor's io::Cork, if it has one, before writing.
 //
 bool Writev(Handle& handle, const struct iovec* iov, int iovcnt);
 
@@ -23,5 +25,13 @@ int Writev(Descriptor& desc, const struct iovec* iov, int iovcnt);
 //
 int WritevAll(Descriptor& desc, struct iovec* iov, int iovcnt);
 
+// Positioned scatter-gather write (pwritev2): offset is a file position, -1 for the current one,
+// and flags are RWF_* (RWF_DSYNC to make the write itself durable)
+//
+bool WritevAt(Handle& handle, const struct iovec* iov, int iovcnt, uint64_t offset, int flags = 0);
+
+int WritevAt(Descriptor& desc, const struct iovec* iov, int iovcnt, uint64_t offset,
+             int flags = 0);
+
 } // end namespace coop::io
 } // end namespace coop
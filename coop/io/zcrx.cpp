@@ -0,0 +1,233 @@
+#include "zcrx.h"
+
+#include <cassert>
+#include <cerrno>
+#include <liburing.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <spdlog/spdlog.h>
+
+#include "uring.h"
+
+namespace coop
+{
+
+namespace io
+{
+
+// The registration ABI (include/uapi/linux/io_uring.h, 6.15), spelled out here so the tree builds
+// against headers that predate it. Layouts are fixed kernel ABI.
+//
+static constexpr unsigned kRegisterZcrxIfq = 32;            // IORING_REGISTER_ZCRX_IFQ
+static constexpr uint32_t kMemRegionTypeUser = 1;           // IORING_MEM_REGION_TYPE_USER
+static constexpr unsigned kAreaShift = 48;                  // IORING_ZCRX_AREA_SHIFT
+
+struct ZcrxOffsets
+{
+    uint32_t head;
+    uint32_t tail;
+    uint32_t rqes;
+    uint32_t resv2;
+    uint64_t resv[2];
+};
+
+struct ZcrxAreaReg
+{
+    uint64_t addr;
+    uint64_t len;
+    uint64_t rqAreaToken;
+    uint32_t flags;
+    uint32_t dmabufFd;
+    uint64_t resv2[2];
+};
+
+struct RegionDesc
+{
+    uint64_t userAddr;
+    uint64_t size;
+    uint32_t flags;
+    uint32_t id;
+    uint64_t mmapOffset;
+    uint64_t resv[4];
+};
+
+struct ZcrxIfqReg
+{
+    uint32_t    ifIdx;
+    uint32_t    ifRxq;
+    uint32_t    rqEntries;
+    uint32_t    flags;
+    uint64_t    areaPtr;
+    uint64_t    regionPtr;
+    ZcrxOffsets offsets;
+    uint32_t    zcrxId;
+    uint32_t    resv2;
+    uint64_t    resv[3];
+};
+
+// The upper half of a recv-zc CQE (struct io_uring_zcrx_cqe): area id and offset of the bytes
+//
+struct ZcrxCqe
+{
+    uint64_t off;
+    uint64_t pad;
+};
+
+static_assert(sizeof(ZcrxIfqReg) == 96, "io_uring_zcrx_ifq_reg layout");
+static_assert(sizeof(ZcrxAreaReg) == 48, "io_uring_zcrx_area_reg layout");
+static_assert(sizeof(RegionDesc) == 64, "io_uring_region_desc layout");
+
+static size_t PageAlign(size_t size)
+{
+    size_t page = size_t(sysconf(_SC_PAGESIZE));
+    return (size + page - 1) & ~(page - 1);
+}
+
+static void* MapAnonymous(size_t size)
+{
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+ZcrxQueue::ZcrxQueue(uint32_t ifindex, uint32_t rxq, size_t areaSize, uint32_t rqEntries /* = 0 */)
+: m_ifindex(ifindex)
+, m_rxq(rxq)
+, m_areaSize(PageAlign(areaSize))
+, m_rqEntries(rqEntries ? rqEntries : uint32_t(m_areaSize / size_t(sysconf(_SC_PAGESIZE))))
+{
+}
+
+ZcrxQueue::~ZcrxQueue()
+{
+    Unmap();
+}
+
+void ZcrxQueue::Unmap()
+{
+    if (m_area)
+    {
+        munmap(m_area, m_areaSize);
+        m_area = nullptr;
+    }
+    if (m_region)
+    {
+        munmap(m_region, m_regionSize);
+        m_region = nullptr;
+    }
+}
+
+int ZcrxQueue::Register(Uring& uring)
+{
+    assert(!m_uring && "ZcrxQueue registered twice");
+
+    // One page for the queue's head and tail, then the entries. The kernel may round the entry
+    // count up to a power of two, so room is left for that.
+    //
+    uint32_t entries = 1;
+    while (entries < m_rqEntries)
+    {
+        entries <<= 1;
+    }
+    m_regionSize = PageAlign(size_t(sysconf(_SC_PAGESIZE)) + size_t(entries) * sizeof(RefillEntry));
+
+    m_area = static_cast<char*>(MapAnonymous(m_areaSize));
+    m_region = MapAnonymous(m_regionSize);
+    if (!m_area || !m_region)
+    {
+        int err = -errno;
+        Unmap();
+        return err;
+    }
+
+    RegionDesc region{};
+    region.userAddr = reinterpret_cast<uint64_t>(m_region);
+    region.size = m_regionSize;
+    region.flags = kMemRegionTypeUser;
+
+    ZcrxAreaReg area{};
+    area.addr = reinterpret_cast<uint64_t>(m_area);
+    area.len = m_areaSize;
+
+    ZcrxIfqReg reg{};
+    reg.ifIdx = m_ifindex;
+    reg.ifRxq = m_rxq;
+    reg.rqEntries = m_rqEntries;
+    reg.areaPtr = reinterpret_cast<uint64_t>(&area);
+    reg.regionPtr = reinterpret_cast<uint64_t>(&region);
+
+    // liburing's wrapper (io_uring_register_ifq) is 2.10+; the raw register call is the same
+    //
+    if (syscall(__NR_io_uring_register, uring.m_ring.ring_fd, kRegisterZcrxIfq, &reg, 1) < 0)
+    {
+        int err = -errno;
+        Unmap();
+        return err;
+    }
+
+    auto* base = static_cast<char*>(m_region);
+    m_rqHead = reinterpret_cast<uint32_t*>(base + reg.offsets.head);
+    m_rqTail = reinterpret_cast<uint32_t*>(base + reg.offsets.tail);
+    m_rqes = reinterpret_cast<RefillEntry*>(base + reg.offsets.rqes);
+    m_rqEntries = reg.rqEntries;
+    m_tail = *m_rqTail;
+    m_id = reg.zcrxId;
+    m_areaToken = area.rqAreaToken;
+    m_uring = &uring;
+
+    spdlog::info("uring zcrx registered id={} ifindex={} rxq={} area={} entries={}",
+        m_id, m_ifindex, m_rxq, m_areaSize, m_rqEntries);
+    return 0;
+}
+
+char* ZcrxQueue::Consume(struct io_uring_cqe* cqe)
+{
+    auto const* rcqe = reinterpret_cast<ZcrxCqe const*>(cqe + 1);
+    uint64_t offset = rcqe->off & ((uint64_t(1) << kAreaShift) - 1);
+    assert(offset < m_areaSize);
+    m_inUse++;
+    return m_area + offset;
+}
+
+void ZcrxQueue::Return(char* data, uint32_t len)
+{
+    assert(data >= m_area && data < m_area + m_areaSize);
+    RefillEntry rqe{uint64_t(data - m_area) | m_areaToken, len, 0};
+    if (m_inUse)
+    {
+        m_inUse--;
+    }
+
+    uint32_t head = __atomic_load_n(m_rqHead, __ATOMIC_ACQUIRE);
+    if (m_backlog.empty() && m_tail - head < m_rqEntries)
+    {
+        m_rqes[m_tail++ & (m_rqEntries - 1)] = rqe;
+        return;
+    }
+    m_backlog.push_back(rqe);
+}
+
+void ZcrxQueue::Publish()
+{
+    if (!m_backlog.empty())
+    {
+        uint32_t head = __atomic_load_n(m_rqHead, __ATOMIC_ACQUIRE);
+        size_t written = 0;
+        while (written < m_backlog.size() && m_tail - head < m_rqEntries)
+        {
+            m_rqes[m_tail++ & (m_rqEntries - 1)] = m_backlog[written++];
+        }
+        m_backlog.erase(m_backlog.begin(), m_backlog.begin() + written);
+    }
+
+    // The entries are written before the tail that shows them to the kernel
+    //
+    if (*m_rqTail != m_tail)
+    {
+        __atomic_store_n(m_rqTail, m_tail, __ATOMIC_RELEASE);
+    }
+}
+
+} // end namespace io
+} // end namespace coop
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct io_uring_cqe;
+
+namespace coop
+{
+
+namespace io
+{
+
+struct Uring;
+
+// A zero-copy receive queue (io_uring zcrx, kernel 6.15+): one hardware rx queue of a NIC,
+// steered into a memory area registered with the ring. The NIC splits each packet's headers from
+// its payload, the kernel's TCP stack keeps the headers, and the payload is DMA'd straight into
+// the area -- a recv then reports where the bytes already are instead of copying them out.
+//
+// Why this exists
+// ---------------
+//
+// Even a buffer-ring recv (buffer_ring.h) copies every payload byte once, from the kernel's skb
+// into the pool buffer. At 100GbE ingest that copy is the cost left after SEND_ZC took the one on
+// the way out. A zcrx queue removes it: the area's pages are the NIC's receive buffers.
+//
+// Requirements
+// ------------
+//
+// The kernel and the setup both have to be there, and registration is the probe for all of it:
+//   - a NIC and driver with header split and a page-pool-backed queue, with the rx queue named
+//     here set aside for it (flow steering, e.g. ethtool -N ... action <rxq>, so the connections
+//     that want zero copy land on it);
+//   - a ring set up with UringConfiguration::cqe32 and deferTaskrun, since the kernel reports the
+//     area offset in the upper half of a 32-byte CQE;
+//   - CAP_NET_ADMIN.
+// Register returns the kernel's negative errno when any of it is missing, and the caller keeps
+// receiving the usual way.
+//
+// Lifecycle of a chunk
+// --------------------
+//
+//   Register()           -- map the area and the refill queue, hand both to the kernel
+//        |
+//        v   ArmedHandle(zeroCopy, ...) arms a multishot IORING_OP_RECV_ZC on a socket
+//   recv CQE: res bytes at Consume(cqe), inside Area()
+//        |
+//        v   application reads them in place
+//   Return(data, len) -- queue a refill entry; Publish() lets the kernel reuse the pages
+//
+// Returned bytes are what the NIC fills next, so a consumer that holds chunks starves the queue:
+// once the area is exhausted the kernel falls back to copying into whatever it gets back, and
+// then to dropping. Size the area for the bytes in flight across every connection on the queue.
+//
+// There is no unregister: the kernel releases the queue with its ring. A ZcrxQueue must outlive
+// every recv armed on it, and its memory is unmapped when it is destroyed.
+//
+struct ZcrxQueue
+{
+    ZcrxQueue(ZcrxQueue const&) = delete;
+    ZcrxQueue& operator=(ZcrxQueue const&) = delete;
+
+    // ifindex and rxq name the NIC queue. areaSize is rounded up to whole pages. rqEntries is the
+    // refill queue's size, which the kernel rounds up to a power of two; 0 sizes it to one entry
+    // per area page. Returns that find it full wait in a backlog until the kernel makes room.
+    //
+    ZcrxQueue(uint32_t ifindex, uint32_t rxq, size_t areaSize, uint32_t rqEntries = 0);
+    ~ZcrxQueue();
+
+    // Register with the kernel. Returns 0 on success or a negative errno. Call once, on the
+    // owning Uring's thread, after it has been Init()'d.
+    //
+    int Register(Uring& uring);
+
+    bool Registered() const { return m_uring != nullptr; }
+
+    // The queue's id on its ring, named by each recv armed on it
+    //
+    uint32_t Id() const { return m_id; }
+
+    char* Area() const { return m_area; }
+    size_t AreaSize() const { return m_areaSize; }
+
+    // Chunks the application holds: delivered by a recv CQE and not yet Returned
+    //
+    uint32_t InUse() const { return m_inUse; }
+
+    // The bytes a recv CQE delivered: inside Area(), valid until Return.
+    //
+    char* Consume(struct io_uring_cqe* cqe);
+
+    // Hand a delivered chunk back, whole. Batches: the kernel sees it on Publish().
+    //
+    void Return(char* data, uint32_t len);
+
+    void Publish();
+
+    void ReturnAndPublish(char* data, uint32_t len)
+    {
+        Return(data, len);
+        Publish();
+    }
+
+private:
+    void Unmap();
+
+    // The refill queue entry (the ABI's struct io_uring_zcrx_rqe)
+    //
+    struct RefillEntry
+    {
+        uint64_t off;
+        uint32_t len;
+        uint32_t pad;
+    };
+
+    Uring*       m_uring{nullptr};
+    uint32_t     m_ifindex;
+    uint32_t     m_rxq;
+    uint32_t     m_id{0};
+
+    char*        m_area{nullptr};
+    size_t       m_areaSize;
+    uint64_t     m_areaToken{0};    // area id, in the offset bits above IORING_ZCRX_AREA_SHIFT
+
+    // The refill queue: a ring of RefillEntry the kernel consumes from *m_rqHead, which this side
+    // produces into at *m_rqTail
+    //
+    void*        m_region{nullptr};
+    size_t       m_regionSize{0};
+    uint32_t*    m_rqHead{nullptr};
+    uint32_t*    m_rqTail{nullptr};
+    RefillEntry* m_rqes{nullptr};
+    uint32_t     m_rqEntries;
+    uint32_t     m_tail{0};         // local tail, ahead of *m_rqTail by the unpublished entries
+
+    // Returns that found the refill queue full, written as the kernel makes room
+    //
+    std::vector<RefillEntry> m_backlog;
+    uint32_t     m_inUse{0};
+};
+
+} // end namespace io
+} // end namespace coop
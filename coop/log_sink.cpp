@@ -0,0 +1,453 @@
+#include "log_sink.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <new>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+#include <spdlog/pattern_formatter.h>
+
+#include "cooperator.h"
+#include "cooperator_var.h"
+#include "io/descriptor.h"
+#include "io/writev.h"
+#include "time/sleep.h"
+
+namespace coop
+{
+namespace log
+{
+
+namespace
+{
+
+// Records per writev, well under IOV_MAX
+//
+constexpr size_t kBatch = 64;
+
+void Bump(std::atomic<uint64_t>& counter)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// ---- Rings ----
+
+// Single producer (the owning cooperator's thread), single consumer (the flusher). Records are
+// fixed-size slots the producer formats into; the flusher writes straight out of them and only
+// then hands them back, so nothing is copied twice.
+//
+struct Ring
+{
+    explicit Ring(size_t recordSize)
+    : m_recordSize(recordSize)
+    {
+    }
+
+    Ring(Ring const&) = delete;
+
+    ~Ring()
+    {
+        delete[] m_records;
+        delete[] m_lengths;
+    }
+
+    bool Allocate()
+    {
+        m_records = new (std::nothrow) char[kRingCapacity * m_recordSize];
+        m_lengths = new (std::nothrow) uint32_t[kRingCapacity];
+        return m_records && m_lengths;
+    }
+
+    // Producer only. The fullness check comes first, so a dropped record costs no formatting.
+    //
+    void Push(spdlog::details::log_msg const& msg)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) >= kRingCapacity)
+        {
+            Bump(m_dropped);
+            return;
+        }
+
+        m_buffer.clear();
+        m_formatter->format(msg, m_buffer);
+        char* slot = m_records + (head % kRingCapacity) * m_recordSize;
+        size_t length = m_buffer.size();
+        if (length > m_recordSize)
+        {
+            length = m_recordSize;
+            std::memcpy(slot, m_buffer.data(), length - 1);
+            slot[length - 1] = '\n';
+            Bump(m_truncated);
+        }
+        else
+        {
+            std::memcpy(slot, m_buffer.data(), length);
+        }
+        m_lengths[head % kRingCapacity] = static_cast<uint32_t>(length);
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    // Flusher only: point iov at up to max records from the tail, which stay put until Consume
+    //
+    size_t Gather(struct iovec* iov, size_t max) const
+    {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t count = std::min<uint64_t>(m_head.load(std::memory_order_acquire) - tail, max);
+        for (size_t i = 0; i < count; i++)
+        {
+            const size_t index = (tail + i) % kRingCapacity;
+            iov[i].iov_base = m_records + index * m_recordSize;
+            iov[i].iov_len = m_lengths[index];
+        }
+        return count;
+    }
+
+    void Consume(size_t count)
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    uint64_t Pending() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    uint64_t Dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    uint64_t Truncated() const { return m_truncated.load(std::memory_order_relaxed); }
+
+    // The producer's clone of the sink's formatter (pattern formatters cache per-thread state)
+    // and the version of it that was cloned. Only touched by the producer, and under the state's
+    // mutex when re-cloned.
+    //
+    std::unique_ptr<spdlog::formatter>  m_formatter;
+    uint64_t                            m_formatterVersion = 0;
+
+  private:
+    size_t                              m_recordSize;
+    char*                               m_records = nullptr;
+    uint32_t*                           m_lengths = nullptr;
+    spdlog::memory_buf_t                m_buffer;
+    alignas(64) std::atomic<uint64_t>   m_head{0};
+    std::atomic<uint64_t>               m_dropped{0};
+    std::atomic<uint64_t>               m_truncated{0};
+    alignas(64) std::atomic<uint64_t>   m_tail{0};
+};
+
+// Which ring this cooperator fills, and for which sink: rings belong to one sink's State and die
+// with it, so a generation mismatch means the pointer is stale
+//
+struct Local
+{
+    uint64_t generation = 0;
+    Ring* ring = nullptr;
+};
+
+CooperatorVar<Local> s_local;
+
+std::atomic<uint64_t> s_generation{0};
+
+// One sink at a time, as with the trace exporter
+//
+std::atomic<bool> s_running{false};
+
+// ---- Sink state ----
+
+struct State
+{
+    State(int fd, bool ownsFd, SinkConfiguration const& configuration)
+    : m_fd(fd)
+    , m_ownsFd(ownsFd)
+    , m_configuration(configuration)
+    , m_generation(s_generation.fetch_add(1, std::memory_order_relaxed) + 1)
+    , m_formatter(std::make_unique<spdlog::pattern_formatter>())
+    {
+        m_configuration.recordSize = std::max<size_t>(m_configuration.recordSize, 2);
+    }
+
+    ~State()
+    {
+        if (m_ownsFd)
+        {
+            ::close(m_fd);
+        }
+    }
+
+    // This cooperator's ring, made on its first record, with a current formatter. nullptr when
+    // the ring cannot be allocated.
+    //
+    Ring* LocalRing()
+    {
+        Local* local = s_local.Get();
+        if (local->generation != m_generation) [[unlikely]]
+        {
+            auto ring = std::make_unique<Ring>(m_configuration.recordSize);
+            if (!ring->Allocate())
+            {
+                return nullptr;
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            local->generation = m_generation;
+            local->ring = ring.get();
+            m_rings.push_back(std::move(ring));
+        }
+
+        Ring* ring = local->ring;
+        if (ring->m_formatterVersion != m_formatterVersion.load(std::memory_order_acquire))
+            [[unlikely]]
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ring->m_formatter = m_formatter->clone();
+            ring->m_formatterVersion = m_formatterVersion.load(std::memory_order_relaxed);
+        }
+        return ring;
+    }
+
+    void SetFormatter(std::unique_ptr<spdlog::formatter> formatter)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_formatter = std::move(formatter);
+        m_formatterVersion.fetch_add(1, std::memory_order_release);
+    }
+
+    // Off a cooperator, or after the flusher is gone: write(2) here and now
+    //
+    void WriteNow(spdlog::details::log_msg const& msg)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffer.clear();
+        m_formatter->format(msg, m_buffer);
+        char const* data = m_buffer.data();
+        size_t remaining = m_buffer.size();
+        while (remaining > 0)
+        {
+            ssize_t n = ::write(m_fd, data, remaining);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                Bump(m_failed);
+                return;
+            }
+            data += n;
+            remaining -= static_cast<size_t>(n);
+        }
+        Bump(m_written);
+    }
+
+    // Flusher only. Up to a ring's capacity from each per pass, so a producer that keeps up with
+    // the writes cannot hold the others back.
+    //
+    void Drain(io::Descriptor& out)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_snapshot.clear();
+            for (auto& ring : m_rings)
+            {
+                m_snapshot.push_back(ring.get());
+            }
+        }
+
+        struct iovec iov[kBatch];
+        for (Ring* ring : m_snapshot)
+        {
+            size_t taken = 0;
+            while (taken < kRingCapacity)
+            {
+                size_t count = ring->Gather(iov, kBatch);
+                if (count == 0)
+                {
+                    break;
+                }
+                int result = io::WritevAll(out, iov, static_cast<int>(count));
+                (result > 0 ? m_written : m_failed).fetch_add(count, std::memory_order_relaxed);
+                ring->Consume(count);
+                taken += count;
+            }
+        }
+    }
+
+    SinkStatistics Statistics()
+    {
+        SinkStatistics statistics{};
+        statistics.written = m_written.load(std::memory_order_relaxed);
+        statistics.failed = m_failed.load(std::memory_order_relaxed);
+        statistics.dropped = m_dropped.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& ring : m_rings)
+        {
+            statistics.dropped += ring->Dropped();
+            statistics.truncated += ring->Truncated();
+            statistics.pending += ring->Pending();
+        }
+        return statistics;
+    }
+
+    int                                 m_fd;
+    bool                                m_ownsFd;
+    SinkConfiguration                   m_configuration;
+    uint64_t                            m_generation;
+
+    // Cleared by the flusher on its way out; records logged after that are written synchronously
+    //
+    std::atomic<bool>                   m_flushing{true};
+
+    // Records lost because a ring could not be allocated
+    //
+    std::atomic<uint64_t>               m_dropped{0};
+
+    // Guards the ring list, the formatter and the synchronous path's buffer
+    //
+    std::mutex                          m_mutex;
+    std::vector<std::unique_ptr<Ring>>  m_rings;
+    std::unique_ptr<spdlog::formatter>  m_formatter;
+    std::atomic<uint64_t>               m_formatterVersion{1};
+    spdlog::memory_buf_t                m_buffer;
+
+    std::vector<Ring*>                  m_snapshot;
+    std::atomic<uint64_t>               m_written{0};
+    std::atomic<uint64_t>               m_failed{0};
+};
+
+// The running (or last) sink's state, for GetSinkStatistics. Weak, so a path sink still closes
+// its file with the last reference.
+//
+std::mutex s_stateMutex;
+std::weak_ptr<State> s_state;
+
+class Sink final : public spdlog::sinks::sink
+{
+  public:
+    explicit Sink(std::shared_ptr<State> state)
+    : m_state(std::move(state))
+    {
+    }
+
+    void log(spdlog::details::log_msg const& msg) override
+    {
+        if (Cooperator::thread_cooperator && m_state->m_flushing.load(std::memory_order_acquire))
+        {
+            if (Ring* ring = m_state->LocalRing())
+            {
+                ring->Push(msg);
+            }
+            else
+            {
+                Bump(m_state->m_dropped);
+            }
+            return;
+        }
+        m_state->WriteNow(msg);
+    }
+
+    // The flusher owns the writes; see log_sink.h
+    //
+    void flush() override
+    {
+    }
+
+    void set_pattern(std::string const& pattern) override
+    {
+        m_state->SetFormatter(std::make_unique<spdlog::pattern_formatter>(pattern));
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override
+    {
+        m_state->SetFormatter(std::move(formatter));
+    }
+
+  private:
+    std::shared_ptr<State> m_state;
+};
+
+std::shared_ptr<spdlog::sinks::sink> Start(
+    std::shared_ptr<State> state,
+    Context::Handle* handle)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_stateMutex);
+        s_state = state;
+    }
+
+    bool spawned = Cooperator::thread_cooperator->Spawn([state](Context* ctx)
+    {
+        ctx->SetName("LogFlusher");
+        io::Descriptor out(io::borrowed, state->m_fd);
+        bool running = true;
+        while (running)
+        {
+            running = time::Sleep(ctx, state->m_configuration.interval) == time::SleepResult::Ok;
+            if (!running)
+            {
+                state->m_flushing.store(false, std::memory_order_seq_cst);
+            }
+            state->Drain(out);
+        }
+        s_running.store(false, std::memory_order_release);
+    }, handle);
+
+    if (!spawned)
+    {
+        s_running.store(false, std::memory_order_release);
+        return nullptr;
+    }
+    return std::make_shared<Sink>(std::move(state));
+}
+
+} // end anon namespace
+
+std::shared_ptr<spdlog::sinks::sink> StartSink(
+    int fd,
+    SinkConfiguration const& configuration,
+    Context::Handle* handle)
+{
+    if (s_running.exchange(true, std::memory_order_acq_rel))
+    {
+        return nullptr;
+    }
+    return Start(std::make_shared<State>(fd, false, configuration), handle);
+}
+
+std::shared_ptr<spdlog::sinks::sink> StartSink(
+    char const* path,
+    SinkConfiguration const& configuration,
+    Context::Handle* handle)
+{
+    if (s_running.exchange(true, std::memory_order_acq_rel))
+    {
+        return nullptr;
+    }
+
+    // Once, at startup: the open itself may block, the writes after it do not
+    //
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        s_running.store(false, std::memory_order_release);
+        return nullptr;
+    }
+    return Start(std::make_shared<State>(fd, true, configuration), handle);
+}
+
+SinkStatistics GetSinkStatistics()
+{
+    std::shared_ptr<State> state;
+    {
+        std::lock_guard<std::mutex> lock(s_stateMutex);
+        state = s_state.lock();
+    }
+    return state ? state->Statistics() : SinkStatistics{};
+}
+
+} // end namespace coop::log
+} // end namespace coop
@@ -0,0 +1,83 @@
+#pragma once
+
+// A spdlog sink that never blocks a cooperator. spdlog's own file sinks call write(2) on whatever
+// thread logs, which on a cooperator stalls every context behind a slow disk. This one formats on
+// the calling thread into a preallocated per-cooperator ring (single producer, no lock, no
+// allocation once the ring exists) and leaves the IO to one flusher context, which drains every
+// ring on an interval and writes the records out with io::Writev, a batch per system call.
+//
+//   auto sink = coop::log::StartSink("/var/log/service.log");
+//   spdlog::default_logger()->sinks().assign({sink});
+//
+// A full ring drops the record and counts it (GetSinkStatistics), so a burst of log traffic costs
+// lines, not latency. A line longer than SinkConfiguration::recordSize is cut to fit, keeping its
+// newline, and counted. Threads that are not cooperators, and every thread once the flusher has
+// exited, write synchronously under a mutex, as spdlog's basic sinks do: blocking is fine there.
+//
+// Records from one cooperator reach the file in order; the interleaving between cooperators is by
+// flush pass, not by time. spdlog's flush() does not wait for the flusher -- a record is written
+// within one interval of being logged.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <spdlog/sinks/sink.h>
+
+#include "context.h"
+#include "time/interval.h"
+
+namespace coop
+{
+namespace log
+{
+
+struct SinkConfiguration
+{
+    // Bytes a formatted record may take in the ring. Each cooperator's ring is kRingCapacity of
+    // these, allocated on its first record.
+    //
+    size_t recordSize = 256;
+
+    // How often the flusher drains the rings
+    //
+    time::Interval interval = std::chrono::milliseconds(5);
+};
+
+constexpr size_t kRingCapacity = 1024;
+
+// Summed over every ring of the running (or last) sink
+//
+struct SinkStatistics
+{
+    uint64_t written;           // records handed to the file
+    uint64_t dropped;           // records lost to a full ring
+    uint64_t truncated;         // records cut to recordSize
+    uint64_t failed;            // records lost to a failed write
+    uint64_t pending;           // records in a ring, not yet written
+};
+
+// Spawn the flusher as a child of the calling context (or of nothing, from a Submit) on this
+// cooperator and return the sink it drains, which writes to fd. The fd should be a pipe, a tty
+// or a file opened O_APPEND: the writes carry no offset. The caller keeps ownership of it. The
+// flusher drains once more when killed, then exits. One sink at a time: returns nullptr if one is
+// running or the spawn fails.
+//
+std::shared_ptr<spdlog::sinks::sink> StartSink(
+    int fd,
+    SinkConfiguration const& configuration = {},
+    Context::Handle* handle = nullptr);
+
+// As above, appending to the file at path (created 0644 if missing), which the sink closes when
+// the last reference to it goes. Also nullptr if the file cannot be opened.
+//
+std::shared_ptr<spdlog::sinks::sink> StartSink(
+    char const* path,
+    SinkConfiguration const& configuration = {},
+    Context::Handle* handle = nullptr);
+
+SinkStatistics GetSinkStatistics();
+
+} // end namespace coop::log
+} // end namespace coop
@@ -0,0 +1,180 @@
+#include "memory_accounting.h"
+
+#include <algorithm>
+#include <map>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "context.h"
+#include "cooperator.h"
+#include "sharded_counter.h"
+#include "detail/bump.h"
+#include "io/buffer_ring.h"
+#include "io/buffer_ring_set.h"
+#include "io/uring.h"
+
+namespace coop
+{
+
+namespace
+{
+
+struct TagGauges
+{
+    ShardedGauge bytes;
+    ShardedGauge objects;
+};
+
+TagGauges s_tags[] = {
+    {{"coop_memory_http_connection_bytes", "HTTP connections and their buffers"},
+     {"coop_memory_http_connections", "HTTP connections open"}},
+    {{"coop_memory_ws_connection_bytes", "WebSocket connections and their buffers"},
+     {"coop_memory_ws_connections", "WebSocket connections open"}},
+    {{"coop_memory_tls_connection_bytes", "TLS connections, OpenSSL's own heap excluded"},
+     {"coop_memory_tls_connections", "TLS connections open"}},
+    {{"coop_memory_tls_staging_bytes", "Pooled TLS staging buffers"},
+     {"coop_memory_tls_staging_buffers", "Pooled TLS staging buffers, cached or borrowed"}},
+    {{"coop_memory_http_recv_growth_bytes", "Pooled HTTP recv buffers for oversized heads"},
+     {"coop_memory_http_recv_growth_buffers",
+      "Pooled HTTP recv buffers for oversized heads, cached or borrowed"}},
+};
+
+static_assert(sizeof(s_tags) / sizeof(s_tags[0]) == static_cast<size_t>(MemoryTag::COUNT));
+
+const char* s_tagNames[] = {"httpConnection", "wsConnection", "tlsConnection", "tlsStaging"};
+
+// Resident bytes of the whole pages in [begin, end). Pages the range only partly covers are left
+// out: the neighbours may not be mapped, and mincore fails on a hole.
+//
+size_t Resident(void const* begin, void const* end)
+{
+    static const uintptr_t kPageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t from = (reinterpret_cast<uintptr_t>(begin) + kPageSize - 1) & ~(kPageSize - 1);
+    uintptr_t to = reinterpret_cast<uintptr_t>(end) & ~(kPageSize - 1);
+
+    size_t resident = 0;
+    unsigned char vec[256];
+    while (from < to)
+    {
+        size_t pages = std::min<size_t>((to - from) / kPageSize, sizeof(vec));
+        if (mincore(reinterpret_cast<void*>(from), pages * kPageSize, vec) < 0)
+        {
+            break;
+        }
+        for (size_t i = 0; i < pages; i++)
+        {
+            resident += (vec[i] & 1) ? kPageSize : 0;
+        }
+        from += pages * kPageSize;
+    }
+    return resident;
+}
+
+void AddContext(ContextMemory& m, Context* ctx)
+{
+    auto bottom = reinterpret_cast<uintptr_t>(ctx->m_segment.Bottom());
+    auto top = std::max(reinterpret_cast<uintptr_t>(ctx->m_heapTop),
+                        reinterpret_cast<uintptr_t>(ctx->m_heapHigh));
+
+    m.contexts++;
+    m.stackReserved += ctx->m_segment.Size();
+    m.stackCommitted += Resident(ctx->m_segment.Bottom(), ctx->m_segment.Top());
+    m.heapBytes += reinterpret_cast<uintptr_t>(ctx->m_heapTop) - bottom;
+    m.heapHighWater += top - bottom;
+    for (auto* chunk = ctx->m_bumpOverflow; chunk; chunk = chunk->next)
+    {
+        m.overflowBytes += chunk->bytes;
+    }
+}
+
+void AddRing(CooperatorMemory& m, io::BufferRing const* ring)
+{
+    m.bufferRingBytes += size_t(ring->Entries()) * ring->BufSize();
+    m.bufferRingOutstanding += size_t(ring->InUse()) * ring->BufSize();
+}
+
+} // end anonymous namespace
+
+const char* MemoryTagName(MemoryTag tag)
+{
+    return s_tagNames[static_cast<size_t>(tag)];
+}
+
+void AccountMemory(MemoryTag tag, int64_t bytes, int64_t objects)
+{
+    auto& gauges = s_tags[static_cast<size_t>(tag)];
+    gauges.bytes.Add(bytes);
+    gauges.objects.Add(objects);
+}
+
+TaggedMemory GetTaggedMemory(MemoryTag tag, Cooperator* co)
+{
+    auto& gauges = s_tags[static_cast<size_t>(tag)];
+    return TaggedMemory{gauges.bytes.Value(co), gauges.objects.Value(co)};
+}
+
+TaggedMemory GetTaggedMemory(MemoryTag tag)
+{
+    auto& gauges = s_tags[static_cast<size_t>(tag)];
+    return TaggedMemory{gauges.bytes.Value(), gauges.objects.Value()};
+}
+
+CooperatorMemory AccountCooperatorMemory(Cooperator* co)
+{
+    CooperatorMemory m{};
+    co->VisitContexts([&](Context* ctx) -> bool
+    {
+        AddContext(m.contexts, ctx);
+        return true;
+    });
+
+    if (void const* shared = co->SharedStackMapping())
+    {
+        m.sharedStackBytes = co->SharedStackMappedBytes();
+        m.sharedStackCommitted =
+            Resident(shared, static_cast<char const*>(shared) + m.sharedStackBytes);
+    }
+    m.sharedStackSaved = co->GetSharedStackStats().savedBytes;
+
+    m.stackPoolBytes = co->GetStackPoolStats().totalBytes;
+    m.continuationPoolBytes = co->ContinuationPoolBytes();
+
+    auto* uring = co->GetUring();
+    if (auto* ring = uring->GetBufferRing())
+    {
+        AddRing(m, ring);
+    }
+    if (auto* set = uring->GetBufferRingSet())
+    {
+        for (int i = 0; i < set->Count(); i++)
+        {
+            AddRing(m, set->Class(i));
+        }
+    }
+
+    for (size_t i = 0; i < static_cast<size_t>(MemoryTag::COUNT); i++)
+    {
+        m.tagged[i] = GetTaggedMemory(static_cast<MemoryTag>(i), co);
+    }
+    return m;
+}
+
+std::vector<NamedContextMemory> ContextMemoryByName(Cooperator* co)
+{
+    std::map<std::string, ContextMemory> byName;
+    co->VisitContexts([&](Context* ctx) -> bool
+    {
+        AddContext(byName[ctx->GetName()], ctx);
+        return true;
+    });
+
+    std::vector<NamedContextMemory> out;
+    out.reserve(byName.size());
+    for (auto& [name, memory] : byName)
+    {
+        out.push_back(NamedContextMemory{name, memory});
+    }
+    return out;
+}
+
+} // end namespace coop
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Memory accounting answers what is holding memory on a cooperator. Nothing is tracked on the
+// spawn or switch paths for it: a report walks the cooperator's live contexts and reads what each
+// cache and ring already knows about itself, so it costs only when asked. The pieces:
+//
+//  - stacks: each live context's segment, reserved (its size) and committed (its resident pages,
+//    from mincore), plus the shared stack (shared_stack.h) and the frames parked off it
+//  - bump heaps: bytes in use now and the high-water mark, both from the segment bottom, plus
+//    overflow chunks (CooperatorConfiguration::bumpReserve)
+//  - caches: StackPool stacks and ContinuationPool blocks retained for reuse
+//  - BufferRing buffers: the default ring's and ring set's, in total and held by the application
+//  - tagged objects that live outside any one segment or are worth seeing on their own --
+//    HTTP and WebSocket connections with their buffers, TLS connections, the pooled TLS staging
+//    buffers. Their owners call AccountMemory as they come and go; the totals are ShardedGauges,
+//    so they are also exported by GenerateOpenMetrics and readable for every cooperator.
+//
+//   auto mem = coop::AccountCooperatorMemory(co);       // on co's thread
+//   for (auto const& n : coop::ContextMemoryByName(co)) // the same, by context name
+//       printf("%s: %zu contexts, %zu committed\n", n.name.c_str(), n.memory.contexts,
+//              n.memory.stackCommitted);
+//
+// A context's connection buffers are usually in its bump heap, so they appear twice: once under
+// the context's name as heap, once under their tag. TLS counts only what coop allocates: the SSL
+// object's own heap -- handshake state, and record buffers unless they are released while idle
+// -- is OpenSSL's and is not seen. GET /api/memory on the status server (http/status.h) serves
+// the lot.
+//
+
+namespace coop
+{
+
+struct Cooperator;
+
+enum class MemoryTag : uint8_t
+{
+    HttpConnection,     // http::Connection and its recv and send buffers
+    WsConnection,       // ws::Connection and its buffers
+    TlsConnection,      // io::ssl::Connection and a caller-provided staging buffer
+    TlsStaging,         // pooled TLS staging buffers on the cooperator, cached or borrowed
+    HttpRecvGrowth,     // pooled large HTTP recv buffers on the cooperator, cached or borrowed
+
+    COUNT,
+};
+
+const char* MemoryTagName(MemoryTag tag);
+
+// Charge (or, negative, give back) bytes and objects under tag to the calling cooperator. Off a
+// cooperator the charge goes to a process-wide total, as ShardedGauge::Add does.
+//
+void AccountMemory(MemoryTag tag, int64_t bytes, int64_t objects);
+
+// What tag holds on co, and in the process. The bytes and objects of one cooperator may be
+// negative when objects move between cooperators; the process-wide totals are not.
+//
+struct TaggedMemory
+{
+    int64_t bytes;
+    int64_t objects;
+};
+
+TaggedMemory GetTaggedMemory(MemoryTag tag, Cooperator* co);
+TaggedMemory GetTaggedMemory(MemoryTag tag);
+
+struct ContextMemory
+{
+    size_t contexts         = 0;
+    size_t stackReserved    = 0;    // segment bytes
+    size_t stackCommitted   = 0;    // resident segment pages
+    size_t heapBytes        = 0;    // bump heap in use, launch data included
+    size_t heapHighWater    = 0;    // the most it has been
+    size_t overflowBytes    = 0;    // bump overflow chunks
+};
+
+struct CooperatorMemory
+{
+    ContextMemory contexts;             // summed over live contexts
+
+    size_t sharedStackBytes;            // the shared stack's mapping, guard page included
+    size_t sharedStackCommitted;
+    size_t sharedStackSaved;            // frames copied off it by parked contexts
+
+    size_t stackPoolBytes;              // cached stacks
+    size_t continuationPoolBytes;       // cached continuation blocks
+
+    size_t bufferRingBytes;             // provided buffers registered with the kernel
+    size_t bufferRingOutstanding;       // of those, held by the application
+
+    TaggedMemory tagged[static_cast<size_t>(MemoryTag::COUNT)];
+};
+
+// Walk co's contexts and caches. co's thread only.
+//
+CooperatorMemory AccountCooperatorMemory(Cooperator* co);
+
+struct NamedContextMemory
+{
+    std::string     name;
+    ContextMemory   memory;
+};
+
+// co's live contexts grouped by name, in name order. co's thread only.
+//
+std::vector<NamedContextMemory> ContextMemoryByName(Cooperator* co);
+
+} // end namespace coop
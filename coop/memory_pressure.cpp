@@ -0,0 +1,177 @@
+#include "memory_pressure.h"
+
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "cooperate.h"
+#include "cooperator.h"
+#include "io/descriptor.h"
+#include "io/poll.h"
+#include "time/sleep.h"
+
+namespace coop
+{
+
+namespace
+{
+
+std::atomic<bool>       s_monitoring{false};
+std::atomic<uint64_t>   s_events{0};
+std::atomic<uint64_t>   s_trims{0};
+std::atomic<uint64_t>   s_freed{0};
+
+// Open the PSI file and write the trigger. A trigger lives as long as its descriptor, so the
+// monitor owns the fd from here.
+//
+int ArmTrigger(MemoryPressureConfiguration const& config)
+{
+    int fd = ::open(config.path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -errno;
+    }
+
+    char trigger[64];
+    int len = snprintf(trigger, sizeof(trigger), "some %u %u", config.stallUs, config.windowUs);
+    if (::write(fd, trigger, len + 1) < 0)
+    {
+        int err = errno;
+        ::close(fd);
+        return -err;
+    }
+    return fd;
+}
+
+// Trim this cooperator a batch at a time, yielding between batches so its other contexts run
+//
+void Trim(Context* ctx, size_t batch)
+{
+    ctx->SetName("PressureTrim");
+    auto* co = ctx->GetCooperator();
+
+    size_t freed = 0;
+    for (;;)
+    {
+        size_t n = co->Relieve(batch);
+        freed += n;
+        if (n < batch || ctx->IsKilled())
+        {
+            break;
+        }
+        Yield();
+    }
+
+    // Freed stacks and blocks go back to the allocator, which keeps them mapped; ask it to hand
+    // the pages to the kernel
+    //
+#if defined(__GLIBC__)
+    if (freed > 0)
+    {
+        malloc_trim(0);
+    }
+#endif
+
+    s_trims.fetch_add(1, std::memory_order_relaxed);
+    s_freed.fetch_add(freed, std::memory_order_relaxed);
+}
+
+} // end anonymous namespace
+
+PressureHook::PressureHook(Cooperator* co)
+: m_co(co)
+{
+    m_co->m_pressureHooks.Push(this);
+}
+
+PressureHook::~PressureHook()
+{
+    m_co->m_pressureHooks.Remove(this);
+}
+
+void TrimAllCooperators(size_t batch /* = 64 */)
+{
+    batch = batch ? batch : 1;
+    Cooperator::VisitRegistry([batch](Cooperator* co) -> bool
+    {
+        co->Submit([batch](Context* ctx)
+        {
+            Trim(ctx, batch);
+        });
+        return true;
+    });
+}
+
+int StartPressureMonitor(MemoryPressureConfiguration const& config /* = {} */,
+                         Context::Handle* handle /* = nullptr */)
+{
+    if (s_monitoring.exchange(true, std::memory_order_acq_rel))
+    {
+        return -EALREADY;
+    }
+
+    int fd = ArmTrigger(config);
+    if (fd < 0)
+    {
+        s_monitoring.store(false, std::memory_order_release);
+        return fd;
+    }
+
+    // The kernel reports a crossed threshold as POLLPRI, at most once per window, and clears it
+    // when the poll consumes it. The poll is killable, so the handle stops the monitor between
+    // events.
+    //
+    bool spawned = Cooperator::thread_cooperator->Spawn([fd, config](Context* ctx)
+    {
+        ctx->SetName("MemoryPressure");
+        io::Descriptor desc(fd);
+
+        for (;;)
+        {
+            int r = io::PollKill(desc, POLLPRI);
+            if (r < 0 || (r & (POLLERR | POLLNVAL)))
+            {
+                break;
+            }
+            if (!(r & POLLPRI))
+            {
+                continue;
+            }
+
+            s_events.fetch_add(1, std::memory_order_relaxed);
+            TrimAllCooperators(config.batch);
+            if (time::Sleep(ctx, config.cooldown) != time::SleepResult::Ok)
+            {
+                break;
+            }
+        }
+        s_monitoring.store(false, std::memory_order_release);
+    }, handle);
+
+    if (!spawned)
+    {
+        ::close(fd);
+        s_monitoring.store(false, std::memory_order_release);
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+MemoryPressureStats GetMemoryPressureStats()
+{
+    return MemoryPressureStats{
+        .events = s_events.load(std::memory_order_relaxed),
+        .trims = s_trims.load(std::memory_order_relaxed),
+        .freed = s_freed.load(std::memory_order_relaxed),
+    };
+}
+
+} // end namespace coop
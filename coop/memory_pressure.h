@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "context.h"
+#include "detail/embedded_list.h"
+#include "time/interval.h"
+
+// Memory-pressure trimming gives cached memory back when the machine runs short, rather than on
+// the idle timer alone. The monitor arms a Linux PSI trigger on /proc/pressure/memory (or a
+// cgroup's memory.pressure) and waits for it as an io_uring poll, so a quiet system costs
+// nothing. When the kernel reports that tasks stalled on memory for more than stallUs of a
+// windowUs window, every cooperator is asked to Relieve: its StackPool frees cached stacks down
+// to StackPoolConfiguration::pressureFloor, its ContinuationPool frees blocks down to
+// CooperatorConfiguration::continuationPoolFloor, its PressureHooks free what they cache, and
+// the heap is asked (malloc_trim) to hand freed pages back.
+//
+//  coop::StartPressureMonitor();                       // from a cooperating context
+//
+//  struct BufferCache : coop::PressureHook             // an application pool joins in
+//  {
+//      using PressureHook::PressureHook;
+//      size_t OnPressure(size_t batch) override { return FreeIdle(batch); }
+//  };
+//
+// Each pool sits between a floor, which pressure never trims below so the hot path stays warm,
+// and its cap, which bounds what it keeps at all. Trimming runs on each cooperator's own thread
+// as a submitted context, batch items at a time with a yield between batches, so a large pool
+// does not stall the cooperator's other work. Registered buffer rings and SizeClassAllocator
+// slabs are not trimmed: the kernel owns a ring's pages, and a slab's free blocks share pages
+// with live ones.
+//
+
+namespace coop
+{
+
+struct Cooperator;
+
+struct MemoryPressureConfiguration
+{
+    // The PSI file to arm: the system's, or a cgroup v2 memory.pressure for a container
+    //
+    const char* path = "/proc/pressure/memory";
+
+    // Fire when some task stalled on memory for stallUs within any windowUs. An unprivileged
+    // trigger needs a window that is a multiple of two seconds.
+    //
+    uint32_t stallUs = 150000;
+    uint32_t windowUs = 2000000;
+
+    // Items each pool frees per step of a trim
+    //
+    size_t batch = 64;
+
+    // Events closer together than this after a trim are absorbed by it
+    //
+    time::Interval cooldown = std::chrono::seconds(1);
+};
+
+// An application pool that frees memory under pressure. Asked on its cooperator's thread, with
+// the most it should free this step; returns how many items it freed, 0 once it is at its own
+// floor. OnPressure may not block or destroy hooks.
+//
+struct PressureHook : EmbeddedListHookups<PressureHook>
+{
+    explicit PressureHook(Cooperator* co);
+    virtual ~PressureHook();
+
+    virtual size_t OnPressure(size_t batch) = 0;
+
+  private:
+    Cooperator* m_co;
+};
+
+// Arm the trigger and spawn the monitor as a child of the calling context, on this cooperator.
+// Returns 0, -EALREADY if a monitor is running, or the negative errno that opening or arming
+// the trigger failed with -- -ENOENT on a kernel without PSI. Kill the handle to stop it.
+//
+int StartPressureMonitor(MemoryPressureConfiguration const& config = {},
+                         Context::Handle* handle = nullptr);
+
+// Ask every live cooperator to trim, as a pressure event does. Callable from any thread; each
+// trim runs on its cooperator's own.
+//
+void TrimAllCooperators(size_t batch = 64);
+
+struct MemoryPressureStats
+{
+    uint64_t events;        // pressure events the monitor acted on
+    uint64_t trims;         // per-cooperator trims run
+    uint64_t freed;         // stacks, blocks and hooked items they freed
+};
+
+MemoryPressureStats GetMemoryPressureStats();
+
+} // end namespace coop
@@ -0,0 +1,120 @@
+#include "offload.h"
+
+#include <algorithm>
+#include <cassert>
+#include <pthread.h>
+
+namespace coop
+{
+
+OffloadPool::OffloadPool(OffloadPoolConfiguration const& configuration)
+: m_configuration(configuration)
+{
+    m_threads.reserve(m_configuration.threads);
+    for (size_t i = 0; i < m_configuration.threads; i++)
+    {
+        m_threads.emplace_back([this] { Work(); });
+        pthread_setname_np(m_threads.back().native_handle(), m_configuration.name);
+    }
+}
+
+OffloadPool::~OffloadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_ready.notify_all();
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+bool OffloadPool::Execute(Context* ctx, Job& job)
+{
+    assert(ctx && "OffloadPool::Run blocks a context; call it from one");
+    assert(!ctx->IsSharedStack() && "OffloadPool::Run: fn uses the caller's stack");
+    job.next = nullptr;
+    job.queuedNs = perf::NowNanos();
+    job.done.TryAcquire();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queued >= m_configuration.queueDepth || m_threads.empty())
+        {
+            m_rejected++;
+            job.done.Release();
+            return false;
+        }
+        m_submitted++;
+        m_queued++;
+        (m_tail ? m_tail->next : m_head) = &job;
+        m_tail = &job;
+    }
+    m_ready.notify_one();
+
+    // Not AcquireWithKill: fn may still be using this stack
+    //
+    job.done.Acquire(ctx);
+    job.done.Release();
+    return true;
+}
+
+void OffloadPool::Work()
+{
+    // A call's run time is recorded at the next dequeue, under the lock the worker takes anyway
+    //
+    int64_t ranNs = -1;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        if (ranNs >= 0)
+        {
+            m_run.Record(static_cast<uint64_t>(ranNs));
+            m_completed++;
+            m_running--;
+            ranNs = -1;
+        }
+
+        m_ready.wait(lock, [this] { return m_head || m_stopping; });
+        Job* job = m_head;
+        if (!job)
+        {
+            return;
+        }
+        m_head = job->next;
+        if (!m_head)
+        {
+            m_tail = nullptr;
+        }
+        m_queued--;
+        m_running++;
+
+        const int64_t startNs = perf::NowNanos();
+        m_queueWait.Record(static_cast<uint64_t>(std::max<int64_t>(startNs - job->queuedNs, 0)));
+        lock.unlock();
+
+        job->run(job->arg);
+        ranNs = perf::NowNanos() - startNs;
+
+        // The caller may return, and the job go with its stack, as soon as this lands
+        //
+        job->done.Release();
+        lock.lock();
+    }
+}
+
+OffloadStatistics OffloadPool::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return OffloadStatistics{
+        m_submitted, m_rejected, m_completed, m_queued, m_running, m_queueWait, m_run };
+}
+
+OffloadPool& DefaultOffloadPool()
+{
+    static OffloadPool s_pool(OffloadPoolConfiguration{2, 256, "coop-offload"});
+    return s_pool;
+}
+
+} // end namespace coop
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "context.h"
+#include "remote_coordinator.h"
+#include "self.h"
+#include "perf/histogram.h"
+
+namespace coop
+{
+
+// Runs calls that would block a cooperator -- a library with its own blocking IO, a filesystem
+// io_uring punts badly, a CPU-heavy compression -- on a small pool of plain OS threads, while the
+// calling context blocks cooperatively and the rest of its cooperator keeps running:
+//
+//   coop::OffloadPool pool;                               // or the process-wide coop::Offload
+//
+//   int rc;
+//   if (!pool.Run(ctx, [&] { rc = fsync_on_some_fuse_mount(fd); }))
+//   {
+//       ...                                               // queue full: shed or retry
+//   }
+//
+// fn runs exactly once on a pool thread, and Run returns after it has. The wake comes back
+// through a RemoteCoordinator the worker releases, i.e. as a submission to the caller's
+// cooperator, so no cooperator thread ever waits on the pool. Because fn may use the caller's
+// stack, the wait ignores kills and deadlines: a killed caller still waits for its fn to finish.
+// For the same reason Run may not be called from a shared-stack context, whose frames are copied
+// away while it is parked.
+//
+// Queue depth is bounded; Run returns false without running fn when fn would be queued beyond
+// it. fn must not itself Run on the same pool (it could wait on a queue only it can drain), and
+// must not touch coop primitives that need a context.
+//
+struct OffloadPoolConfiguration
+{
+    size_t threads = 4;
+
+    // Calls waiting for a thread, beyond which Run refuses
+    //
+    size_t queueDepth = 256;
+
+    // pthread name of the workers (at most 15 characters)
+    //
+    char const* name = "coop-offload";
+};
+
+struct OffloadStatistics
+{
+    uint64_t submitted;             // calls accepted
+    uint64_t rejected;              // calls refused because the queue was full
+    uint64_t completed;
+    size_t   queued;                // waiting for a thread now
+    size_t   running;               // on a thread now
+    perf::Histogram queueWait;      // ns from Run to a thread picking fn up
+    perf::Histogram run;            // ns fn took
+};
+
+struct OffloadPool
+{
+    OffloadPool(OffloadPool const&) = delete;
+    OffloadPool(OffloadPool&&) = delete;
+
+    OffloadPool(OffloadPoolConfiguration const& configuration = {});
+
+    // Runs whatever is still queued, then joins the threads
+    //
+    ~OffloadPool();
+
+    template<typename Fn>
+    bool Run(Context* ctx, Fn&& fn);
+
+    template<typename Fn>
+    bool Run(Fn&& fn)
+    {
+        return Run(Self(), std::forward<Fn>(fn));
+    }
+
+    OffloadStatistics GetStatistics() const;
+
+  private:
+    // One call, on the caller's stack for the length of Run. The caller holds done from before
+    // the push until the worker releases it.
+    //
+    struct Job
+    {
+        void                (*run)(void*);
+        void*               arg;
+        Job*                next;
+        int64_t             queuedNs;
+        RemoteCoordinator   done;
+    };
+
+    bool Execute(Context* ctx, Job& job);
+    void Work();
+
+    OffloadPoolConfiguration        m_configuration;
+    std::vector<std::thread>        m_threads;
+
+    mutable std::mutex              m_mutex;
+    std::condition_variable         m_ready;
+    Job*                            m_head = nullptr;
+    Job*                            m_tail = nullptr;
+    bool                            m_stopping = false;
+
+    // Under m_mutex
+    //
+    uint64_t                        m_submitted = 0;
+    uint64_t                        m_rejected = 0;
+    uint64_t                        m_completed = 0;
+    size_t                          m_queued = 0;
+    size_t                          m_running = 0;
+    perf::Histogram                 m_queueWait;
+    perf::Histogram                 m_run;
+};
+
+template<typename Fn>
+bool OffloadPool::Run(Context* ctx, Fn&& fn)
+{
+    using Callable = std::remove_reference_t<Fn>;
+
+    Job job;
+    job.run = [](void* arg)
+    {
+        (*static_cast<Callable*>(arg))();
+    };
+    job.arg = const_cast<void*>(static_cast<void const*>(std::addressof(fn)));
+    return Execute(ctx, job);
+}
+
+// The process-wide pool, two threads, made on first use
+//
+OffloadPool& DefaultOffloadPool();
+
+template<typename Fn>
+bool Offload(Context* ctx, Fn&& fn)
+{
+    return DefaultOffloadPool().Run(ctx, std::forward<Fn>(fn));
+}
+
+template<typename Fn>
+bool Offload(Fn&& fn)
+{
+    return DefaultOffloadPool().Run(Self(), std::forward<Fn>(fn));
+}
+
+} // end namespace coop
@@ -43,6 +43,9 @@ enum class Counter : uint32_t
     ContextBlock,       // transitions to BLOCKED state
     ContextSpawn,       // new context spawns
     ContextExit,        // context destructions (stack freed)
+    ContextMigrate,     // contexts handed off to another cooperator (Context::MigrateTo)
+    ContextYieldTo,     // handoffs that switched straight into their target (Context::YieldTo)
+    BumpOverflow,       // checked bump allocations served from an overflow chunk
 
     // ---- IO ----
     //
@@ -51,6 +54,8 @@ enum class Counter : uint32_t
     PollCycle,          // Uring::Poll() invocations
     PollSubmit,         // Uring::Poll() calls that actually submitted SQEs
     PollCqe,            // individual CQEs processed
+    WaitSpinHit,        // adaptive WaitAndPoll spins that caught a completion
+    WaitSpinMiss,       // spins that ran out of window and fell through to sleep
 
     // ---- Epoch ----
     //
@@ -59,6 +64,30 @@ enum class Counter : uint32_t
     EpochUnpin,         // application-level unpins
     DrainCycles,        // reclamation attempts
     DrainReclaimed,     // nodes actually freed
+    EpochBacklog,       // retire-queue depth, summed over scheduler reclaim passes
+    EpochReclaimForced, // scheduler reclaim passes forced by the backlog watermark
+
+    // ---- Work ----
+    //
+    WorkStealAttempt,   // victims a Grid stealer tried to steal from
+    WorkSteal,          // steal attempts that claimed a batch
+    WorkStolen,         // Ergs moved by those batches (the first runs, the rest re-queue locally)
+    WorkLocalPull,      // Ergs a stealer took from its own shard
+    WorkPark,           // idle stealer parks (timer or indefinite)
+    WorkWake,           // cross-thread wakes sent to parked peers
+    WorkOverflow,       // Grid sheds that found the shard's deque full and spilled
+    WorkErgRun1K,       // Ergs that ran in < 1K timestamp ticks
+    WorkErgRun16K,      //  ... < 16K ticks
+    WorkErgRun256K,     //  ... < 256K ticks
+    WorkErgRunLong,     //  ... >= 256K ticks
+
+    // ---- Chan ----
+    //
+    PassageSpin,        // Passage::Recv waits that spun on the ring and caught an item
+    PassageSpinMiss,    // spins that ran out of budget and fell through to park
+    PassageYield,       // Passage::Recv yields taken while other contexts were runnable
+    PassagePark,        // Passage::Recv timed parks on m_recv
+    PassageParkTimeout, // parks that timed out rather than being woken
 
     // ---- User-defined counters (via COOP_PERF_USER_COUNTERS .def file) ----
     //
@@ -83,18 +112,43 @@ inline const char* CounterName(Counter c)
         "ctx_block",
         "ctx_spawn",
         "ctx_exit",
+        "ctx_migrate",
+        "ctx_yield_to",
+        "bump_overflow",
         // IO
         "io_submit",
         "io_complete",
         "poll_cycle",
         "poll_submit",
         "poll_cqe",
+        "wait_spin_hit",
+        "wait_spin_miss",
         // Epoch
         "epoch_advance",
         "epoch_pin",
         "epoch_unpin",
         "drain_cycles",
         "drain_reclaimed",
+        "epoch_backlog",
+        "epoch_reclaim_forced",
+        // Work
+        "work_steal_attempt",
+        "work_steal",
+        "work_stolen",
+        "work_local_pull",
+        "work_park",
+        "work_wake",
+        "work_overflow",
+        "work_erg_run_1k",
+        "work_erg_run_16k",
+        "work_erg_run_256k",
+        "work_erg_run_long",
+        // Chan
+        "passage_spin",
+        "passage_spin_miss",
+        "passage_yield",
+        "passage_park",
+        "passage_park_timeout",
         // User-defined
 #ifdef COOP_PERF_USER_COUNTERS
 #define COOP_PERF_COUNTER(name, family, display) display,
@@ -120,6 +174,9 @@ enum class Family : uint64_t
     Scheduler = 1ULL << 0,
     IO        = 1ULL << 1,
     Epoch     = 1ULL << 2,
+    Work      = 1ULL << 3,
+    Chan      = 1ULL << 4,
+    Http      = 1ULL << 5,
 
 #ifdef COOP_PERF_USER_FAMILIES
 #define COOP_PERF_FAMILY(name, bit, display) name = 1ULL << bit,
@@ -162,6 +219,9 @@ inline constexpr Family CounterFamily(Counter c)
         case Counter::ContextBlock:
         case Counter::ContextSpawn:
         case Counter::ContextExit:
+        case Counter::ContextMigrate:
+        case Counter::ContextYieldTo:
+        case Counter::BumpOverflow:
             return Family::Scheduler;
 
         case Counter::IoSubmit:
@@ -169,6 +229,8 @@ inline constexpr Family CounterFamily(Counter c)
         case Counter::PollCycle:
         case Counter::PollSubmit:
         case Counter::PollCqe:
+        case Counter::WaitSpinHit:
+        case Counter::WaitSpinMiss:
             return Family::IO;
 
         case Counter::EpochAdvance:
@@ -176,8 +238,30 @@ inline constexpr Family CounterFamily(Counter c)
         case Counter::EpochUnpin:
         case Counter::DrainCycles:
         case Counter::DrainReclaimed:
+        case Counter::EpochBacklog:
+        case Counter::EpochReclaimForced:
             return Family::Epoch;
 
+        case Counter::WorkStealAttempt:
+        case Counter::WorkSteal:
+        case Counter::WorkStolen:
+        case Counter::WorkLocalPull:
+        case Counter::WorkPark:
+        case Counter::WorkWake:
+        case Counter::WorkOverflow:
+        case Counter::WorkErgRun1K:
+        case Counter::WorkErgRun16K:
+        case Counter::WorkErgRun256K:
+        case Counter::WorkErgRunLong:
+            return Family::Work;
+
+        case Counter::PassageSpin:
+        case Counter::PassageSpinMiss:
+        case Counter::PassageYield:
+        case Counter::PassagePark:
+        case Counter::PassageParkTimeout:
+            return Family::Chan;
+
 #ifdef COOP_PERF_USER_COUNTERS
 #define COOP_PERF_COUNTER(name, family, display) case Counter::name: return Family::family;
 #include COOP_PERF_USER_COUNTERS
@@ -198,6 +282,9 @@ inline const char* FamilyName(Family f)
         case Family::Scheduler: return "scheduler";
         case Family::IO:        return "io";
         case Family::Epoch:     return "epoch";
+        case Family::Work:      return "work";
+        case Family::Chan:      return "chan";
+        case Family::Http:      return "http";
 #ifdef COOP_PERF_USER_FAMILIES
 #define COOP_PERF_FAMILY(name, bit, display) case Family::name: return display;
 #include COOP_PERF_USER_FAMILIES
@@ -213,6 +300,9 @@ inline constexpr Family s_allFamilies[] = {
     Family::Scheduler,
     Family::IO,
     Family::Epoch,
+    Family::Work,
+    Family::Chan,
+    Family::Http,
 #ifdef COOP_PERF_USER_FAMILIES
 #define COOP_PERF_FAMILY(name, bit, display) Family::name,
 #include COOP_PERF_USER_FAMILIES
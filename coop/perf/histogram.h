@@ -0,0 +1,261 @@
+#pragma once
+
+// Latency histograms for the coop perf subsystem. Counters give rates; these give the
+// distribution (p50/p99/p999) an SLO is written against.
+//
+// The Histogram type is always available, so callers can keep and Merge their own. The
+// per-cooperator set of built-in histograms (Histograms, reached through
+// Cooperator::GetPerfHistograms) follows the counter modes: no storage in mode 0, and in mode 1
+// and 2 one single-writer array per cooperator, recorded without atomics at probe sites that
+// mode 2 patches like counter sites (COOP_PERF_RECORD and friends in probe.h), family by family.
+//
+// Extension mechanism: as for counters, a COOP_PERF_USER_HISTOGRAMS .def file of
+// COOP_PERF_HISTOGRAM(name, family, display) lines adds histograms to the enum.
+//
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#include "counters.h"
+
+namespace coop
+{
+namespace perf
+{
+
+enum class Hist : uint32_t
+{
+    RunQueueWait,       // ns a context waited runnable in the run queue before it was resumed
+    RunSlice,           // ns a context ran between being switched in and switching out
+    IoLatency,          // ns from Handle::Submit to its completion
+    HttpHandler,        // ns an HTTP handler (request or HTTP/2 stream) took to return
+
+#ifdef COOP_PERF_USER_HISTOGRAMS
+#define COOP_PERF_HISTOGRAM(name, family, display) name,
+#include COOP_PERF_USER_HISTOGRAMS
+#undef COOP_PERF_HISTOGRAM
+#endif
+
+    COUNT
+};
+
+inline const char* HistName(Hist h)
+{
+    static const char* s_names[] = {
+        "run_queue_wait_ns",
+        "run_slice_ns",
+        "io_latency_ns",
+        "http_handler_ns",
+#ifdef COOP_PERF_USER_HISTOGRAMS
+#define COOP_PERF_HISTOGRAM(name, family, display) display,
+#include COOP_PERF_USER_HISTOGRAMS
+#undef COOP_PERF_HISTOGRAM
+#endif
+    };
+    static_assert(sizeof(s_names) / sizeof(s_names[0]) == static_cast<size_t>(Hist::COUNT));
+    auto idx = static_cast<size_t>(h);
+    return idx < static_cast<size_t>(Hist::COUNT) ? s_names[idx] : "unknown";
+}
+
+inline constexpr Family HistFamily(Hist h)
+{
+    switch (h)
+    {
+        case Hist::RunQueueWait:
+        case Hist::RunSlice:
+            return Family::Scheduler;
+
+        case Hist::IoLatency:
+            return Family::IO;
+
+        case Hist::HttpHandler:
+            return Family::Http;
+
+#ifdef COOP_PERF_USER_HISTOGRAMS
+#define COOP_PERF_HISTOGRAM(name, family, display) case Hist::name: return Family::family;
+#include COOP_PERF_USER_HISTOGRAMS
+#undef COOP_PERF_HISTOGRAM
+#endif
+
+        default:
+            return Family::All;
+    }
+}
+
+// Log-bucketed histogram in the HDR style: values below 2^kSubBits get a bucket each, and every
+// power of two above splits into 2^kSubBits linear sub-buckets, so a reported value is within
+// 1/2^kSubBits (6.25%) of the truth across the whole range. Values of 2^(kMaxExponent + 1) and up
+// (about 36 minutes, in nanoseconds) all land in the last bucket; the exact count, sum and max
+// are kept alongside.
+//
+// Plain data with one writer: Record does no atomics. Another thread may read it for
+// observability (each word is tear-free on x86-64 and aarch64, though the words are not a
+// consistent snapshot of each other), and Merge folds one into another.
+//
+struct Histogram
+{
+    static constexpr uint32_t kSubBits      = 4;
+    static constexpr uint32_t kSubBuckets   = 1u << kSubBits;
+    static constexpr uint32_t kMaxExponent  = 40;
+    static constexpr size_t   kBuckets      = kSubBuckets * (kMaxExponent - kSubBits + 2);
+
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    uint64_t buckets[kBuckets] = {};
+
+    static constexpr size_t BucketFor(uint64_t value)
+    {
+        if (value < kSubBuckets)
+        {
+            return static_cast<size_t>(value);
+        }
+        const uint32_t exponent = 63 - std::countl_zero(value);
+        if (exponent > kMaxExponent)
+        {
+            return kBuckets - 1;
+        }
+        const uint64_t sub = (value >> (exponent - kSubBits)) & (kSubBuckets - 1);
+        return (exponent - kSubBits + 1) * kSubBuckets + sub;
+    }
+
+    // The smallest value that lands in bucket i
+    //
+    static constexpr uint64_t BucketLow(size_t i)
+    {
+        if (i < kSubBuckets)
+        {
+            return i;
+        }
+        const uint32_t exponent = static_cast<uint32_t>(i / kSubBuckets) + kSubBits - 1;
+        return (kSubBuckets + i % kSubBuckets) << (exponent - kSubBits);
+    }
+
+    // The largest value that lands in bucket i
+    //
+    static constexpr uint64_t BucketHigh(size_t i)
+    {
+        return i + 1 < kBuckets ? BucketLow(i + 1) - 1 : UINT64_MAX;
+    }
+
+    void Record(uint64_t value)
+    {
+        buckets[BucketFor(value)]++;
+        count++;
+        sum += value;
+        if (value > max)
+        {
+            max = value;
+        }
+    }
+
+    void Merge(Histogram const& other)
+    {
+        for (size_t i = 0; i < kBuckets; i++)
+        {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        sum += other.sum;
+        if (other.max > max)
+        {
+            max = other.max;
+        }
+    }
+
+    // The value at quantile q in [0, 1]: the top of the bucket holding it, capped at the largest
+    // value recorded. 0 when empty.
+    //
+    uint64_t Quantile(double q) const
+    {
+        if (!count)
+        {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count) + 0.5);
+        rank = rank < 1 ? 1 : (rank > count ? count : rank);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; i++)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+            {
+                const uint64_t high = BucketHigh(i);
+                return high < max ? high : max;
+            }
+        }
+        return max;
+    }
+
+    uint64_t Mean() const { return count ? sum / count : 0; }
+
+    void Reset() { *this = Histogram{}; }
+};
+
+static_assert(Histogram::BucketFor(Histogram::kSubBuckets) == Histogram::kSubBuckets);
+static_assert(Histogram::BucketLow(Histogram::BucketFor(1000)) <= 1000);
+static_assert(Histogram::BucketHigh(Histogram::BucketFor(1000)) >= 1000);
+static_assert(Histogram::BucketFor(uint64_t(1) << Histogram::kMaxExponent) < Histogram::kBuckets);
+
+// The clock the span probes read: CLOCK_MONOTONIC in nanoseconds
+//
+inline int64_t NowNanos()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+#if COOP_PERF_MODE > 0
+
+struct Histograms
+{
+    Histogram values[static_cast<size_t>(Hist::COUNT)];
+
+    void Record(Hist id, uint64_t value) { values[static_cast<size_t>(id)].Record(value); }
+
+    Histogram const& Get(Hist id) const { return values[static_cast<size_t>(id)]; }
+
+    void Merge(Histograms const& other)
+    {
+        for (size_t i = 0; i < static_cast<size_t>(Hist::COUNT); i++)
+        {
+            values[i].Merge(other.values[i]);
+        }
+    }
+
+    void Reset()
+    {
+        for (auto& h : values)
+        {
+            h.Reset();
+        }
+    }
+};
+
+// The body of COOP_PERF_RECORD_SINCE
+//
+inline void RecordSince(Histograms& histograms, Hist id, int64_t& stamp)
+{
+    if (stamp)
+    {
+        const int64_t elapsed = NowNanos() - stamp;
+        histograms.Record(id, elapsed > 0 ? static_cast<uint64_t>(elapsed) : 0);
+        stamp = 0;
+    }
+}
+
+#else
+
+// Empty struct when perf is disabled — zero storage cost.
+//
+struct Histograms {};
+
+#endif
+
+} // end namespace coop::perf
+} // end namespace coop
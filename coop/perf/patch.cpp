@@ -1,4 +1,5 @@
 #include "patch.h"
+#include "histogram.h"
 
 #if COOP_PERF_MODE == 2
 
@@ -20,8 +21,8 @@ namespace
 struct SectionEntry
 {
     uint64_t addr;          // address of the JMP/NOP instruction
-    uint32_t counterId;     // Counter enum value
-    uint32_t pad;
+    uint32_t counterId;     // Counter enum value, or Hist for a histogram site
+    uint32_t kind;          // 0 counter site, 1 histogram site (COOP_PERF_HIST_SITE)
 };
 
 // Saved state per probe site for enable/disable toggling.
@@ -31,7 +32,7 @@ struct ProbeSite
     uint8_t* addr;
     uint8_t  origBytes[5];  // enough for both JEB (2 bytes) and JMP (5 bytes)
     uint8_t  origLen;       // instruction length (2 or 5)
-    uint32_t counterId;
+    Family   family;        // of the site's counter or histogram
 };
 
 #if defined(__x86_64__)
@@ -109,7 +110,8 @@ static void InitSites()
 
         ProbeSite site;
         site.addr = addr;
-        site.counterId = entry->counterId;
+        site.family = entry->kind == 1 ? HistFamily(static_cast<Hist>(entry->counterId))
+                                       : CounterFamily(static_cast<Counter>(entry->counterId));
 
 #if defined(__x86_64__)
         // Detect JMP instruction encoding.
@@ -171,8 +173,7 @@ void Enable(Family families)
     for (size_t i = 0; i < s_siteCount; i++)
     {
         auto& site = s_sites[i];
-        Counter c = static_cast<Counter>(site.counterId);
-        Family f = CounterFamily(c);
+        Family f = site.family;
         bool wasEnabled = HasFamily(s_enabledFamilies, f);
         bool wantEnabled = HasFamily(target, f);
 
@@ -199,8 +200,7 @@ void Disable(Family families)
     for (size_t i = 0; i < s_siteCount; i++)
     {
         auto& site = s_sites[i];
-        Counter c = static_cast<Counter>(site.counterId);
-        Family f = CounterFamily(c);
+        Family f = site.family;
         bool wasEnabled = HasFamily(s_enabledFamilies, f);
         bool wantEnabled = HasFamily(target, f);
 
@@ -222,8 +222,7 @@ void SetFamilies(Family families)
     for (size_t i = 0; i < s_siteCount; i++)
     {
         auto& site = s_sites[i];
-        Counter c = static_cast<Counter>(site.counterId);
-        Family f = CounterFamily(c);
+        Family f = site.family;
         bool wasEnabled = HasFamily(s_enabledFamilies, f);
         bool wantEnabled = HasFamily(families, f);
 
@@ -0,0 +1,204 @@
+#include "pmu.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace coop
+{
+namespace perf
+{
+
+const char* PmuEventName(PmuEvent event)
+{
+    switch (event)
+    {
+        case PmuEvent::Cycles:       return "cycles";
+        case PmuEvent::Instructions: return "instructions";
+        case PmuEvent::LlcMisses:    return "llcMisses";
+        case PmuEvent::BranchMisses: return "branchMisses";
+        case PmuEvent::COUNT:        break;
+    }
+    return "unknown";
+}
+
+namespace
+{
+
+static constexpr uint64_t s_eventConfig[PMU_EVENTS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+int OpenEvent(uint64_t config, int groupFd)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    // This thread, any CPU: the counters follow the thread as the scheduler moves it
+    //
+    long fd = syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, PERF_FLAG_FD_CLOEXEC);
+    return fd < 0 ? -errno : static_cast<int>(fd);
+}
+
+inline uint64_t Rdpmc(uint32_t counter)
+{
+#if defined(__x86_64__)
+    uint32_t hi, lo;
+    __asm__ __volatile__("rdpmc" : "=a"(lo), "=d"(hi) : "c"(counter));
+    return (uint64_t)hi << 32 | lo;
+#else
+    (void)counter;
+    return 0;
+#endif
+}
+
+} // end anonymous namespace
+
+int PmuGroup::Open()
+{
+    if (IsOpen())
+    {
+        return 0;
+    }
+
+    for (size_t i = 0; i < PMU_EVENTS; i++)
+    {
+        int fd = OpenEvent(s_eventConfig[i], i ? m_fds[0] : -1);
+        if (fd < 0 && i <= static_cast<size_t>(PmuEvent::Instructions))
+        {
+            Close();
+            return fd;
+        }
+        m_fds[i] = fd;
+    }
+
+#if defined(__x86_64__)
+    // One page each: only the header (the seqlock, index and offset) is read, no sample ring
+    //
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    m_rdpmc = true;
+    for (size_t i = 0; i < PMU_EVENTS; i++)
+    {
+        if (m_fds[i] < 0)
+        {
+            continue;
+        }
+        void* p = mmap(nullptr, page, PROT_READ, MAP_SHARED, m_fds[i], 0);
+        if (p == MAP_FAILED)
+        {
+            m_rdpmc = false;
+            continue;
+        }
+        m_pages[i] = p;
+        if (!static_cast<perf_event_mmap_page*>(p)->cap_user_rdpmc)
+        {
+            m_rdpmc = false;
+        }
+    }
+#endif
+    return 0;
+}
+
+void PmuGroup::Close()
+{
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    for (size_t i = PMU_EVENTS; i-- > 0;)
+    {
+        if (m_pages[i])
+        {
+            munmap(m_pages[i], page);
+            m_pages[i] = nullptr;
+        }
+        if (m_fds[i] >= 0)
+        {
+            close(m_fds[i]);
+            m_fds[i] = -1;
+        }
+    }
+    m_rdpmc = false;
+}
+
+void PmuGroup::Read(PmuSample& out) const
+{
+    if (!IsOpen())
+    {
+        out = PmuSample{};
+        return;
+    }
+    if (m_rdpmc && ReadMapped(out))
+    {
+        return;
+    }
+    ReadGroup(out);
+}
+
+// The kernel's documented user-space read (perf_event_mmap_page): offset plus the live counter,
+// sign-extended from pmc_width bits, retried while the seqlock moves under us. index 0 means the
+// event is not on the PMU right now (multiplexed out), which only the syscall can read.
+//
+bool PmuGroup::ReadMapped(PmuSample& out) const
+{
+    for (size_t i = 0; i < PMU_EVENTS; i++)
+    {
+        auto* pc = static_cast<perf_event_mmap_page volatile*>(m_pages[i]);
+        if (!pc)
+        {
+            out.values[i] = 0;
+            continue;
+        }
+
+        uint32_t seq;
+        uint64_t count;
+        do
+        {
+            seq = pc->lock;
+            std::atomic_signal_fence(std::memory_order_acq_rel);
+            const uint32_t index = pc->index;
+            if (!index)
+            {
+                return false;
+            }
+            const uint32_t shift = 64 - pc->pmc_width;
+            int64_t pmc = static_cast<int64_t>(Rdpmc(index - 1) << shift) >> shift;
+            count = pc->offset + pmc;
+            std::atomic_signal_fence(std::memory_order_acq_rel);
+        } while (pc->lock != seq);
+
+        out.values[i] = count;
+    }
+    return true;
+}
+
+// PERF_FORMAT_GROUP from the leader: { nr, value[nr] }, in the order the members joined
+//
+void PmuGroup::ReadGroup(PmuSample& out) const
+{
+    uint64_t buf[1 + PMU_EVENTS] = {};
+    if (read(m_fds[0], buf, sizeof(buf)) < static_cast<ssize_t>(sizeof(uint64_t)))
+    {
+        out = PmuSample{};
+        return;
+    }
+
+    size_t next = 1;
+    for (size_t i = 0; i < PMU_EVENTS; i++)
+    {
+        out.values[i] = m_fds[i] >= 0 && next <= buf[0] ? buf[next++] : 0;
+    }
+}
+
+} // end namespace coop::perf
+} // end namespace coop
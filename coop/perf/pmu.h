@@ -0,0 +1,91 @@
+#pragma once
+
+// Hardware PMU counters for one thread, read cheaply enough to sample at every context switch
+// (CooperatorConfiguration::trackContextPmu). A PmuGroup opens one perf_event_open group on the
+// calling thread -- cycles, instructions, last-level cache misses and branch misses, user space
+// only -- and maps each event's page so a read is an rdpmc per event under the page's seqlock, no
+// syscall. Where rdpmc is not allowed (perf_event_paranoid, a non-x86 build, an event the kernel
+// has multiplexed off the PMU at that moment) a read falls back to one read(2) of the group.
+//
+//   perf::PmuGroup pmu;
+//   if (pmu.Open() == 0)
+//   {
+//       perf::PmuSample before, after;
+//       pmu.Read(before);
+//       Work();
+//       pmu.Read(after);
+//       uint64_t retired = after[perf::PmuEvent::Instructions]
+//                        - before[perf::PmuEvent::Instructions];
+//   }
+//
+// Cycles and instructions are required; the two miss events are not exposed by every PMU (most
+// VMs lack the cache events), and read as zero when they failed to open. Counts are raw: under
+// multiplexing (more groups than counters on the core) they cover only the time the group ran.
+//
+
+#include <cstddef>
+#include <cstdint>
+
+namespace coop
+{
+namespace perf
+{
+
+enum class PmuEvent : int
+{
+    Cycles,
+    Instructions,
+    LlcMisses,
+    BranchMisses,
+    COUNT,
+};
+
+static constexpr size_t PMU_EVENTS = static_cast<size_t>(PmuEvent::COUNT);
+
+const char* PmuEventName(PmuEvent event);
+
+// Running totals since the group opened, indexed by PmuEvent
+//
+struct PmuSample
+{
+    uint64_t values[PMU_EVENTS] = {};
+
+    uint64_t operator[](PmuEvent event) const { return values[static_cast<size_t>(event)]; }
+};
+
+struct PmuGroup
+{
+    PmuGroup() = default;
+    PmuGroup(PmuGroup const&) = delete;
+    PmuGroup& operator=(PmuGroup const&) = delete;
+
+    ~PmuGroup() { Close(); }
+
+    // Open the group on the calling thread, which it then counts for as long as it is open.
+    // Returns 0, or a negative errno from the cycles or instructions event (-EACCES under a
+    // restrictive perf_event_paranoid, -ENOENT with no hardware PMU).
+    //
+    int Open();
+    void Close();
+
+    bool IsOpen() const { return m_fds[0] >= 0; }
+
+    // Whether every open event's page allows user-space rdpmc. Reads still work without it.
+    //
+    bool UsesRdpmc() const { return m_rdpmc; }
+
+    // Owning thread only: rdpmc reads the counters of the core it runs on
+    //
+    void Read(PmuSample& out) const;
+
+  private:
+    bool ReadMapped(PmuSample& out) const;
+    void ReadGroup(PmuSample& out) const;
+
+    int   m_fds[PMU_EVENTS] = {-1, -1, -1, -1};
+    void* m_pages[PMU_EVENTS] = {};
+    bool  m_rdpmc = false;
+};
+
+} // end namespace coop::perf
+} // end namespace coop
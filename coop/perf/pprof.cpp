@@ -0,0 +1,649 @@
+#include "pprof.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <link.h>
+#include <map>
+#include <memory>
+#include <unistd.h>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+
+#include "coop/cooperator.h"
+#include "coop/detail/tsc.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/open.h"
+#include "coop/io/write.h"
+#include "coop/time/sleep.h"
+
+namespace coop
+{
+namespace perf
+{
+
+namespace
+{
+
+// ---- Mappings ----
+
+constexpr uint32_t kNoteGnuBuildId = 3;     // NT_GNU_BUILD_ID
+
+void AppendHex(std::string& out, const uint8_t* bytes, size_t size)
+{
+    static const char s_digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < size; i++)
+    {
+        out += s_digits[bytes[i] >> 4];
+        out += s_digits[bytes[i] & 0xf];
+    }
+}
+
+// The NT_GNU_BUILD_ID note among an object's PT_NOTE segments, as hex
+//
+std::string BuildId(struct dl_phdr_info* info)
+{
+    std::string id;
+    for (int i = 0; i < info->dlpi_phnum && id.empty(); i++)
+    {
+        auto const& phdr = info->dlpi_phdr[i];
+        if (phdr.p_type != PT_NOTE)
+        {
+            continue;
+        }
+        auto* at = reinterpret_cast<const uint8_t*>(info->dlpi_addr + phdr.p_vaddr);
+        auto* end = at + phdr.p_memsz;
+        while (at + sizeof(ElfW(Nhdr)) <= end)
+        {
+            auto* note = reinterpret_cast<const ElfW(Nhdr)*>(at);
+            const uint8_t* name = at + sizeof(ElfW(Nhdr));
+            const uint8_t* desc = name + ((note->n_namesz + 3) & ~3u);
+            at = desc + ((note->n_descsz + 3) & ~3u);
+            if (at > end)
+            {
+                break;
+            }
+            if (note->n_type == kNoteGnuBuildId && note->n_namesz == 4 &&
+                memcmp(name, "GNU", 4) == 0)
+            {
+                AppendHex(id, desc, note->n_descsz);
+                break;
+            }
+        }
+    }
+    return id;
+}
+
+int CollectMapping(struct dl_phdr_info* info, size_t, void* arg)
+{
+    auto& mappings = *static_cast<std::vector<Mapping>*>(arg);
+
+    // The main executable comes first, with an empty name
+    //
+    std::string path = info->dlpi_name ? info->dlpi_name : "";
+    if (path.empty() && mappings.empty())
+    {
+        char exe[4096];
+        ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe));
+        if (len > 0)
+        {
+            path.assign(exe, static_cast<size_t>(len));
+        }
+    }
+
+    std::string buildId;
+    bool first = true;
+    for (int i = 0; i < info->dlpi_phnum; i++)
+    {
+        auto const& phdr = info->dlpi_phdr[i];
+        if (phdr.p_type != PT_LOAD || !(phdr.p_flags & PF_X))
+        {
+            continue;
+        }
+        if (first)
+        {
+            buildId = BuildId(info);
+            first = false;
+        }
+        uintptr_t start = info->dlpi_addr + phdr.p_vaddr;
+        mappings.push_back(Mapping{start, start + phdr.p_memsz, phdr.p_offset, info->dlpi_addr,
+                                   path, buildId});
+    }
+    return 0;
+}
+
+std::vector<Mapping> SortedMappings()
+{
+    auto mappings = ReadMappings();
+    std::sort(mappings.begin(), mappings.end(), [](Mapping const& a, Mapping const& b)
+    {
+        return a.start < b.start;
+    });
+    return mappings;
+}
+
+// The index of the mapping holding pc in sorted mappings, or -1
+//
+long FindMapping(std::vector<Mapping> const& mappings, uintptr_t pc)
+{
+    auto it = std::upper_bound(mappings.begin(), mappings.end(), pc,
+        [](uintptr_t value, Mapping const& m) { return value < m.start; });
+    if (it == mappings.begin())
+    {
+        return -1;
+    }
+    --it;
+    return pc < it->limit ? it - mappings.begin() : -1;
+}
+
+// A frame's address for symbolization: a return address (every frame but the leaf) moved back
+// into its call instruction
+//
+uintptr_t FrameAddress(StackSample const& s, int f)
+{
+    return f > 0 && s.frames[f] ? s.frames[f] - 1 : s.frames[f];
+}
+
+// ---- Attribution ----
+
+// The names of the cooperators still registered: a sample's Cooperator may be gone by the time
+// a batch is exported, and its name with it
+//
+std::unordered_map<Cooperator const*, std::string> CooperatorNames()
+{
+    std::unordered_map<Cooperator const*, std::string> names;
+    Cooperator::VisitRegistry([&](Cooperator* co) -> bool
+    {
+        names.emplace(co, co->GetName());
+        return true;
+    });
+    return names;
+}
+
+struct Folded
+{
+    size_t   first;             // a sample carrying the stack
+    uint64_t count = 0;
+};
+
+// Samples folded by (cooperator, context name, stack), in key order
+//
+std::map<std::string, Folded> Fold(StackSample const* samples, size_t count)
+{
+    std::map<std::string, Folded> folded;
+    for (size_t i = 0; i < count; i++)
+    {
+        auto const& s = samples[i];
+        std::string key(reinterpret_cast<const char*>(&s.cooperator), sizeof(s.cooperator));
+        key.append(s.name ? s.name : "").append(1, '\0');
+        key.append(reinterpret_cast<const char*>(s.frames), s.depth * sizeof(uintptr_t));
+        folded.try_emplace(std::move(key), Folded{i}).first->second.count++;
+    }
+    return folded;
+}
+
+const char* CooperatorName(std::unordered_map<Cooperator const*, std::string> const& names,
+                           Cooperator const* co)
+{
+    auto it = names.find(co);
+    return it != names.end() ? it->second.c_str() : "[exited]";
+}
+
+int64_t RealtimeNanos()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// ---- profile.proto encoding ----
+
+constexpr uint32_t kVarint = 0;
+constexpr uint32_t kBytes = 2;
+
+struct Proto
+{
+    std::string buf;
+
+    void Varint(uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            buf += static_cast<char>(v | 0x80);
+            v >>= 7;
+        }
+        buf += static_cast<char>(v);
+    }
+
+    void Tag(uint32_t field, uint32_t wire) { Varint((uint64_t(field) << 3) | wire); }
+
+    // Zero is the default and is left out, as protobuf encoders do
+    //
+    void Uint(uint32_t field, uint64_t v)
+    {
+        if (v)
+        {
+            Tag(field, kVarint);
+            Varint(v);
+        }
+    }
+
+    void Bytes(uint32_t field, const void* data, size_t size)
+    {
+        Tag(field, kBytes);
+        Varint(size);
+        buf.append(static_cast<const char*>(data), size);
+    }
+
+    void Message(uint32_t field, Proto const& m) { Bytes(field, m.buf.data(), m.buf.size()); }
+};
+
+// profile.proto's string_table: index 0 is the empty string
+//
+struct StringTable
+{
+    std::vector<std::string> strings{std::string()};
+    std::unordered_map<std::string, uint64_t> index{{std::string(), 0}};
+
+    uint64_t operator()(std::string const& s)
+    {
+        auto [it, added] = index.try_emplace(s, strings.size());
+        if (added)
+        {
+            strings.push_back(s);
+        }
+        return it->second;
+    }
+};
+
+Proto ValueType(StringTable& strings, const char* type, const char* unit)
+{
+    Proto m;
+    m.Uint(1, strings(type));
+    m.Uint(2, strings(unit));
+    return m;
+}
+
+Proto Label(StringTable& strings, const char* key, const char* value)
+{
+    Proto m;
+    m.Uint(1, strings(key));
+    m.Uint(2, strings(value));
+    return m;
+}
+
+// deflate data onto out as one gzip member
+//
+bool AppendGzip(std::string& out, std::string const& data)
+{
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return false;
+    }
+
+    const size_t old = out.size();
+    out.resize(old + deflateBound(&strm, data.size()) + 32);
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    strm.avail_in = static_cast<uInt>(data.size());
+    strm.next_out = reinterpret_cast<Bytef*>(&out[old]);
+    strm.avail_out = static_cast<uInt>(out.size() - old);
+
+    const bool ok = deflate(&strm, Z_FINISH) == Z_STREAM_END;
+    out.resize(ok ? out.size() - strm.avail_out : old);
+    deflateEnd(&strm);
+    return ok;
+}
+
+// ---- Collapsed text ----
+
+// A name as a collapsed frame: ';' separates frames and a line ends the stack
+//
+void AppendFrameName(std::string& out, const char* name)
+{
+    for (const char* p = name; *p; p++)
+    {
+        out += *p == ';' || *p == '\n' ? '_' : *p;
+    }
+}
+
+const char* BaseName(std::string const& path)
+{
+    const char* slash = strrchr(path.c_str(), '/');
+    return slash ? slash + 1 : path.c_str();
+}
+
+void AppendCollapsedBatch(std::string& out, StackSample const* samples, size_t count,
+                          uint64_t lost)
+{
+    auto mappings = SortedMappings();
+    auto names = CooperatorNames();
+    char buf[64];
+
+    snprintf(buf, sizeof(buf), "%zu samples, %zu lost, period ", count, size_t(lost));
+    out.append("# coop stacks: ").append(buf);
+    snprintf(buf, sizeof(buf), "%lld ns, at ", static_cast<long long>(StackSamplePeriod()));
+    out.append(buf);
+    snprintf(buf, sizeof(buf), "%lld unix ns\n", static_cast<long long>(RealtimeNanos()));
+    out.append(buf);
+
+    // One line per object, path last: a path is never all digits, so flamegraph.pl -- which
+    // takes a trailing number as a count -- skips these lines rather than misreading them
+    //
+    std::string last;
+    for (auto const& m : mappings)
+    {
+        if (m.path == last)
+        {
+            continue;
+        }
+        last = m.path;
+        out.append("# object ").append(m.buildId.empty() ? "-" : m.buildId);
+        out.append(" ").append(m.path.empty() ? "[unknown]" : m.path).append("\n");
+    }
+
+    for (auto const& [key, folded] : Fold(samples, count))
+    {
+        auto const& s = samples[folded.first];
+        AppendFrameName(out, CooperatorName(names, s.cooperator));
+        out += ';';
+        AppendFrameName(out, s.name ? s.name : "[scheduler]");
+        for (int f = s.depth - 1; f >= 0; f--)
+        {
+            const uintptr_t pc = FrameAddress(s, f);
+            const long m = FindMapping(mappings, pc);
+            out += ';';
+            if (m >= 0)
+            {
+                AppendFrameName(out, BaseName(mappings[m].path));
+                snprintf(buf, sizeof(buf), "+0x%lx", pc - mappings[m].bias);
+            }
+            else
+            {
+                snprintf(buf, sizeof(buf), "0x%lx", pc);
+            }
+            out.append(buf);
+        }
+        snprintf(buf, sizeof(buf), " %llu\n", static_cast<unsigned long long>(folded.count));
+        out.append(buf);
+    }
+}
+
+// ---- Continuous profile ----
+
+std::atomic<bool> s_writing{false};
+
+std::string RotatedPath(std::string const& path, int n)
+{
+    return path + "." + std::to_string(n);
+}
+
+// path.1 .. path.N-1 move up one, the last dropping off, and path becomes path.1
+//
+void Rotate(ContinuousProfileOptions const& options)
+{
+    for (int n = options.keepFiles - 1; n >= 1; n--)
+    {
+        ::rename(RotatedPath(options.path, n).c_str(), RotatedPath(options.path, n + 1).c_str());
+    }
+    if (options.keepFiles > 0)
+    {
+        ::rename(options.path.c_str(), RotatedPath(options.path, 1).c_str());
+    }
+    else
+    {
+        ::unlink(options.path.c_str());
+    }
+}
+
+struct ProfileFile
+{
+    ContinuousProfileOptions const& options;
+    std::unique_ptr<io::Descriptor> file;
+    size_t                          size = 0;
+
+    bool Open()
+    {
+        int fd = io::Open(options.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            spdlog::warn("continuous profile: cannot open {}: {}", options.path, strerror(-fd));
+            return false;
+        }
+        file = std::make_unique<io::Descriptor>(fd);
+        size = static_cast<size_t>(lseek(fd, 0, SEEK_END));
+        return true;
+    }
+
+    bool Append(std::string const& data)
+    {
+        if (size > 0 && size + data.size() > options.maxFileBytes)
+        {
+            file->Close();
+            Rotate(options);
+            if (!Open())
+            {
+                return false;
+            }
+        }
+
+        const char* at = data.data();
+        size_t left = data.size();
+        while (left > 0)
+        {
+            int n = io::Write(*file, at, left, uint64_t(-1));
+            if (n <= 0)
+            {
+                spdlog::warn("continuous profile: write to {} failed: {}", options.path,
+                             strerror(n < 0 ? -n : EIO));
+                return false;
+            }
+            at += n;
+            left -= static_cast<size_t>(n);
+            size += static_cast<size_t>(n);
+        }
+        return true;
+    }
+};
+
+} // end anonymous namespace
+
+std::vector<Mapping> ReadMappings()
+{
+    std::vector<Mapping> mappings;
+    dl_iterate_phdr(CollectMapping, &mappings);
+    return mappings;
+}
+
+int64_t StackSamplePeriod()
+{
+    const int hz = SamplingHz();
+    return hz > 0 ? int64_t(1000000000) / hz * StackSubsample() : 0;
+}
+
+bool AppendPprof(std::string& out, StackSample const* samples, size_t count,
+                 double nanosPerTick, int64_t periodNs /* = 0 */)
+{
+    if (periodNs <= 0)
+    {
+        periodNs = StackSamplePeriod();
+    }
+
+    auto mappings = SortedMappings();
+    auto names = CooperatorNames();
+    StringTable strings;
+    Proto profile;
+
+    profile.Message(1, ValueType(strings, "samples", "count"));
+    profile.Message(1, ValueType(strings, "cpu", "nanoseconds"));
+
+    // Locations are numbered from 1 as addresses are first seen; a mapping's id is its index + 1
+    //
+    std::unordered_map<uintptr_t, uint64_t> locationIds;
+    Proto locations;
+    std::vector<bool> mappingUsed(mappings.size());
+    uint64_t minTs = UINT64_MAX;
+    uint64_t maxTs = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        minTs = std::min(minTs, samples[i].timestamp);
+        maxTs = std::max(maxTs, samples[i].timestamp);
+    }
+
+    for (auto const& [key, folded] : Fold(samples, count))
+    {
+        auto const& s = samples[folded.first];
+        Proto ids;
+        for (int f = 0; f < s.depth; f++)
+        {
+            const uintptr_t pc = FrameAddress(s, f);
+            auto [it, added] = locationIds.try_emplace(pc, locationIds.size() + 1);
+            if (added)
+            {
+                const long m = FindMapping(mappings, pc);
+                Proto location;
+                location.Uint(1, it->second);
+                if (m >= 0)
+                {
+                    location.Uint(2, static_cast<uint64_t>(m) + 1);
+                    mappingUsed[m] = true;
+                }
+                location.Uint(3, pc);
+                locations.Message(4, location);
+            }
+            ids.Varint(it->second);
+        }
+
+        Proto values;
+        values.Varint(folded.count);
+        values.Varint(folded.count * static_cast<uint64_t>(periodNs));
+
+        Proto sample;
+        sample.Message(1, ids);
+        sample.Message(2, values);
+        sample.Message(3, Label(strings, "cooperator", CooperatorName(names, s.cooperator)));
+        sample.Message(3, Label(strings, "context", s.name ? s.name : "[scheduler]"));
+        profile.Message(2, sample);
+    }
+
+    for (size_t m = 0; m < mappings.size(); m++)
+    {
+        if (!mappingUsed[m])
+        {
+            continue;
+        }
+        Proto mapping;
+        mapping.Uint(1, m + 1);
+        mapping.Uint(2, mappings[m].start);
+        mapping.Uint(3, mappings[m].limit);
+        mapping.Uint(4, mappings[m].offset);
+        mapping.Uint(5, strings(mappings[m].path));
+        mapping.Uint(6, strings(mappings[m].buildId));
+        profile.Message(3, mapping);
+    }
+    profile.buf += locations.buf;
+    profile.Message(11, ValueType(strings, "cpu", "nanoseconds"));
+    profile.Uint(12, static_cast<uint64_t>(periodNs));
+
+    // The profile starts at its first sample: back from now by that sample's age
+    //
+    const uint64_t now = static_cast<uint64_t>(detail::ReadTsc());
+    if (count)
+    {
+        const auto age = static_cast<int64_t>(static_cast<double>(now - minTs) * nanosPerTick);
+        profile.Uint(9, static_cast<uint64_t>(RealtimeNanos() - age));
+        profile.Uint(10,
+            static_cast<uint64_t>(static_cast<double>(maxTs - minTs) * nanosPerTick));
+    }
+    else
+    {
+        profile.Uint(9, static_cast<uint64_t>(RealtimeNanos()));
+    }
+
+    // Last, once every string is in the table
+    //
+    for (auto const& s : strings.strings)
+    {
+        profile.Bytes(6, s.data(), s.size());
+    }
+
+    return AppendGzip(out, profile.buf);
+}
+
+void AppendCollapsed(std::string& out, StackSample const* samples, size_t count)
+{
+    AppendCollapsedBatch(out, samples, count, 0);
+}
+
+bool StartContinuousProfile(ContinuousProfileOptions options, Context::Handle* handle)
+{
+    if (s_writing.exchange(true, std::memory_order_acq_rel))
+    {
+        return false;
+    }
+
+    bool spawned = Cooperator::thread_cooperator->Spawn(
+        [options = std::move(options)](Context* ctx)
+    {
+        ctx->SetName("ContinuousProfile");
+
+        ProfileFile file{options};
+        if (!file.Open())
+        {
+            s_writing.store(false, std::memory_order_release);
+            return;
+        }
+
+        // Start from what is in the ring now: its older samples belong to no batch interval
+        //
+        static constexpr size_t kBatch = 2048;
+        auto samples = std::make_unique<StackSample[]>(kBatch);
+        uint64_t cursor = TotalStackSamples();
+        std::string text;
+        std::string compressed;
+
+        bool running = true;
+        bool writable = true;
+        while (running && writable)
+        {
+            running = time::Sleep(ctx, options.interval) == time::SleepResult::Ok;
+
+            // A full batch may have left more behind it
+            //
+            size_t count;
+            do
+            {
+                uint64_t lost = 0;
+                count = ReadStackSamplesSince(cursor, samples.get(), kBatch, &lost);
+                if (!count && !lost)
+                {
+                    break;
+                }
+                text.clear();
+                compressed.clear();
+                AppendCollapsedBatch(text, samples.get(), count, lost);
+                writable = !AppendGzip(compressed, text) || file.Append(compressed);
+            }
+            while (writable && count == kBatch);
+        }
+        file.file->Close();
+        s_writing.store(false, std::memory_order_release);
+    }, handle);
+
+    if (!spawned)
+    {
+        s_writing.store(false, std::memory_order_release);
+    }
+    return spawned;
+}
+
+} // end namespace coop::perf
+} // end namespace coop
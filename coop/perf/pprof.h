@@ -0,0 +1,96 @@
+#pragma once
+
+// Sampler export for off-host symbolization. /api/sampler/symbolize resolves addresses inside the
+// process, which costs a loaded server CPU it would rather spend serving; these formats carry raw
+// addresses plus what is needed to resolve them elsewhere -- each loaded object's path, address
+// range and GNU build-id -- so `pprof`, `addr2line` or a profiling backend does the work against
+// the matching binaries.
+//
+//   - AppendPprof: a gzipped profile.proto (the format `go tool pprof` and most continuous
+//     profilers read), one Location per address and one Mapping per executable segment.
+//   - AppendCollapsed: collapsed-stack text, one "frame;frame;... count" line per distinct stack
+//     (root first, as flamegraph.pl wants), each frame <object>+0x<address within it>, under "#"
+//     header lines naming every object's build-id and path.
+//   - StartContinuousProfile: a context that drains the stack ring on an interval and appends
+//     each batch to a file through io::Write, as a gzip member of collapsed text, rotating the
+//     file by size. The members concatenate, so `zcat` reads the whole file as one profile.
+//
+// Addresses are stack ring addresses (StartSampling with stacks=true); a non-leaf frame's return
+// address is moved back one byte, into the call instruction, so it resolves to the call's line.
+// Samples are attributed to their cooperator and context name: pprof labels, and the first two
+// frames of a collapsed stack.
+//
+//   curl -o cpu.pb.gz http://host:port/api/sampler/pprof
+//   go tool pprof -symbolize=local -http=: ./server cpu.pb.gz
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "coop/context.h"
+#include "coop/time/interval.h"
+
+#include "sampler.h"
+
+namespace coop
+{
+namespace perf
+{
+
+// One executable segment of a loaded object, in the shape of profile.proto's Mapping
+//
+struct Mapping
+{
+    uintptr_t   start;          // runtime address range [start, limit)
+    uintptr_t   limit;
+    uintptr_t   offset;         // file offset of start
+    uintptr_t   bias;           // load bias: runtime address - ELF virtual address
+    std::string path;
+    std::string buildId;        // lowercase hex of NT_GNU_BUILD_ID, empty when there is none
+};
+
+// The executable segments of every object loaded now, through dl_iterate_phdr. The main
+// executable's path comes from /proc/self/exe.
+//
+std::vector<Mapping> ReadMappings();
+
+// The stack sampler's period in nanoseconds: the signal interval times the stack subsample
+// ratio, or 0 when not sampling
+//
+int64_t StackSamplePeriod();
+
+// Append count stack samples to out as a gzipped profile.proto with sample types samples/count
+// and cpu/nanoseconds (periodNs per sample; StackSamplePeriod when 0). nanosPerTick converts the
+// samples' timestamps, for the profile's time and duration. False if compression fails, out
+// unchanged.
+//
+bool AppendPprof(std::string& out, StackSample const* samples, size_t count,
+                 double nanosPerTick, int64_t periodNs = 0);
+
+// Append count stack samples to out as collapsed-stack text
+//
+void AppendCollapsed(std::string& out, StackSample const* samples, size_t count);
+
+struct ContinuousProfileOptions
+{
+    std::string    path;                                    // the live file
+    time::Interval interval = std::chrono::seconds(10);     // between batches
+    size_t         maxFileBytes = 64 << 20;                 // rotate once a file reaches this
+    int            keepFiles = 4;                           // path.1 .. path.N kept after rotation
+};
+
+// Spawn the continuous profile writer as a child of the calling context (or of nothing, from a
+// Submit), on this cooperator. It appends to options.path (created 0644 if need be), and when
+// that reaches maxFileBytes renames it to path.1, shifting older files up and dropping the one
+// past keepFiles, then starts a new one. Every interval it writes the stack samples taken since
+// the last batch, if any; a batch header records how many the ring overwrote before they were
+// read. It writes a last batch when killed, then exits; it also exits, with a warning logged, if
+// the file will not open or a write fails. Start the sampler in stack mode separately. One writer
+// at a time: returns false if one is running or the spawn fails.
+//
+bool StartContinuousProfile(ContinuousProfileOptions options, Context::Handle* handle = nullptr);
+
+} // end namespace coop::perf
+} // end namespace coop
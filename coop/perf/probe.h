@@ -1,6 +1,7 @@
 #pragma once
 
 #include "counters.h"
+#include "histogram.h"
 
 // COOP_PERF_INC(counters, id)
 //
@@ -19,9 +20,22 @@
 // Add n to a performance counter. Same mode behavior as COOP_PERF_INC but increments by
 // an arbitrary amount. Used for batch counters like DrainReclaimed.
 //
+// COOP_PERF_RECORD(histograms, id, value)
+//
+// Record value into a perf::Histograms entry. value is only evaluated where the site is live, so
+// it may read a clock. The site belongs to HistFamily(id) for mode 2 patching.
+//
+// COOP_PERF_STAMP(id, stamp) / COOP_PERF_RECORD_SINCE(histograms, id, stamp)
+//
+// Span timing in nanoseconds. STAMP stores the time into an int64_t; RECORD_SINCE records the
+// time elapsed since it and zeroes it, and does nothing for a zero stamp, so a span that began
+// while its family was off is dropped rather than recorded from nothing.
+//
 // Usage:
 //   COOP_PERF_INC(m_perf, perf::Counter::ContextResume);
 //   COOP_PERF_ADD(m_perf, perf::Counter::DrainReclaimed, freedCount);
+//   COOP_PERF_STAMP(perf::Hist::IoLatency, m_submitNs);
+//   COOP_PERF_RECORD_SINCE(histograms, perf::Hist::IoLatency, m_submitNs);
 //
 
 #if COOP_PERF_MODE == 0
@@ -30,6 +44,9 @@
 //
 #define COOP_PERF_INC(counters, id) ((void)0)
 #define COOP_PERF_ADD(counters, id, n) ((void)0)
+#define COOP_PERF_RECORD(histograms, id, value) ((void)0)
+#define COOP_PERF_STAMP(id, stamp) ((void)0)
+#define COOP_PERF_RECORD_SINCE(histograms, id, stamp) ((void)0)
 
 #elif COOP_PERF_MODE == 1
 
@@ -37,6 +54,10 @@
 //
 #define COOP_PERF_INC(counters, id) (counters).Inc(id)
 #define COOP_PERF_ADD(counters, id, n) (counters).IncBy(id, n)
+#define COOP_PERF_RECORD(histograms, id, value) (histograms).Record(id, value)
+#define COOP_PERF_STAMP(id, stamp) ((stamp) = ::coop::perf::NowNanos())
+#define COOP_PERF_RECORD_SINCE(histograms, id, stamp)                                       \
+    ::coop::perf::RecordSince(histograms, id, stamp)
 
 #elif COOP_PERF_MODE == 2
 
@@ -51,6 +72,9 @@
 // __label__ creates a block-scoped label so multiple COOP_PERF_INC invocations in the same
 // function don't collide.
 //
+// The entry's last word is the site kind: 0 for a counter site, 1 for a histogram site
+// (COOP_PERF_HIST_SITE), whose ID is a Hist and whose family is HistFamily's.
+//
 // x86-64: uses JMP rel8/rel32 (2 or 5 bytes), patched to NOP.
 // aarch64: uses B (4 bytes), patched to NOP. Instruction cache flush required after patching.
 //
@@ -101,6 +125,21 @@
     __perf_skip: ;                                                                          \
 } while(0)
 
+#define COOP_PERF_HIST_SITE(id, stmt) do {                                                  \
+    __label__ __perf_skip;                                                                  \
+    asm goto(                                                                               \
+        "1: jmp %l[__perf_skip]\n"                                                          \
+        COOP_PERF_SITES_PUSH                                                                \
+        ".balign 16\n"                                                                      \
+        ".quad 1b\n"                                                                        \
+        ".long %c[cid]\n"                                                                   \
+        ".long 1\n"                                                                         \
+        ".popsection\n"                                                                     \
+        : : [cid] "i" (static_cast<uint32_t>(id)) : : __perf_skip);                        \
+    stmt;                                                                                   \
+    __perf_skip: ;                                                                          \
+} while(0)
+
 #elif defined(__aarch64__)
 
 #define COOP_PERF_INC(counters, id) do {                                                    \
@@ -133,10 +172,32 @@
     __perf_skip: ;                                                                          \
 } while(0)
 
+#define COOP_PERF_HIST_SITE(id, stmt) do {                                                  \
+    __label__ __perf_skip;                                                                  \
+    asm goto(                                                                               \
+        "1: b %l[__perf_skip]\n"                                                            \
+        COOP_PERF_SITES_PUSH                                                                \
+        ".balign 16\n"                                                                      \
+        ".quad 1b\n"                                                                        \
+        ".long %c[cid]\n"                                                                   \
+        ".long 1\n"                                                                         \
+        ".popsection\n"                                                                     \
+        : : [cid] "i" (static_cast<uint32_t>(id)) : : __perf_skip);                        \
+    stmt;                                                                                   \
+    __perf_skip: ;                                                                          \
+} while(0)
+
 #else
 #error "COOP_PERF_MODE 2 requires x86-64 or aarch64"
 #endif
 
+#define COOP_PERF_RECORD(histograms, id, value)                                             \
+    COOP_PERF_HIST_SITE(id, (histograms).Record(id, value))
+#define COOP_PERF_STAMP(id, stamp)                                                          \
+    COOP_PERF_HIST_SITE(id, (stamp) = ::coop::perf::NowNanos())
+#define COOP_PERF_RECORD_SINCE(histograms, id, stamp)                                       \
+    COOP_PERF_HIST_SITE(id, ::coop::perf::RecordSince(histograms, id, stamp))
+
 #else
 #error "COOP_PERF_MODE must be 0, 1, or 2"
 #endif
@@ -3,11 +3,14 @@
 #include <atomic>
 #include <csignal>
 #include <cstring>
+#include <pthread.h>
 #include <sys/time.h>
+#include <time.h>
 #include <ucontext.h>
 
 #include "coop/cooperator.h"
 #include "coop/context.h"
+#include "coop/detail/tsc.h"
 
 namespace coop
 {
@@ -38,19 +41,39 @@ static std::atomic<int>    g_stackEvery{10};  // backtrace every Nth signal (oth
 static std::atomic<size_t> g_signalOrdinal{0};
 static struct sigaction    g_prevAction;
 
+// Off-CPU ring buffer, written from every cooperator thread.
+//
+static constexpr size_t OFFCPU_RING_CAPACITY = 2048;
+static constexpr size_t OFFCPU_RING_MASK = OFFCPU_RING_CAPACITY - 1;
+
+static OffCpuSample             g_offCpuRing[OFFCPU_RING_CAPACITY];
+static std::atomic<size_t>      g_offCpuHead{0};
+static std::atomic<size_t>      g_offCpuTotal{0};
+
 static inline uint64_t rdtsc()
 {
-#if defined(__x86_64__)
-    uint32_t lo, hi;
-    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
-    return (static_cast<uint64_t>(hi) << 32) | lo;
-#elif defined(__aarch64__)
-    uint64_t val;
-    asm volatile("mrs %0, cntvct_el0" : "=r"(val));
-    return val;
-#else
-#error "Unsupported architecture for rdtsc"
-#endif
+    return static_cast<uint64_t>(detail::ReadTsc());
+}
+
+// Manual frame pointer walk -- no function calls, no locks, no malloc, so it is safe in the
+// signal handler. Requires -fno-omit-frame-pointer. Appends return addresses to frames from
+// index depth while fp stays in (low, high), and returns the new depth.
+//
+static inline int WalkFramePointers(uintptr_t fp, uintptr_t low, uintptr_t high,
+                                    uintptr_t* frames, int depth)
+{
+    while (depth < MAX_STACK_DEPTH && fp > low && fp < high && (fp & 7) == 0)
+    {
+        auto* frame = reinterpret_cast<uintptr_t*>(fp);
+        uintptr_t retAddr = frame[1];
+        if (retAddr == 0) break;
+        frames[depth++] = retAddr;
+
+        uintptr_t nextFp = frame[0];
+        if (nextFp <= fp) break; // must increase (unwinding toward stack base)
+        fp = nextFp;
+    }
+    return depth;
 }
 
 // SIGPROF handler — must be async-signal-safe.
@@ -104,11 +127,9 @@ static void SigprofHandler(int, siginfo_t*, void* uctx)
             size_t idx = g_stackHead.fetch_add(1, std::memory_order_relaxed) & STACK_RING_MASK;
             auto& s = g_stackRing[idx];
 
-            // Manual frame pointer walk — no function calls, no locks, no malloc.
-            // Requires -fno-omit-frame-pointer. Just a few memory loads per frame.
+            // Frame pointer walk from the interrupted frame -- just a few memory loads per frame
             //
             s.frames[0] = pc;
-            int depth = 1;
 
 #if defined(__x86_64__)
             uintptr_t fp = u->uc_mcontext.gregs[REG_RBP];
@@ -117,21 +138,11 @@ static void SigprofHandler(int, siginfo_t*, void* uctx)
             uintptr_t fp = u->uc_mcontext.regs[29];    // x29 = frame pointer
             uintptr_t sp = u->uc_mcontext.sp;
 #endif
-
-            while (depth < MAX_STACK_DEPTH && fp > sp && (fp & 7) == 0)
-            {
-                auto* frame = reinterpret_cast<uintptr_t*>(fp);
-                uintptr_t retAddr = frame[1];
-                if (retAddr == 0) break;
-                s.frames[depth++] = retAddr;
-
-                uintptr_t nextFp = frame[0];
-                if (nextFp <= fp) break; // must increase (unwinding toward stack base)
-                fp = nextFp;
-            }
+            int depth = WalkFramePointers(fp, sp, UINTPTR_MAX, s.frames, 1);
 
             s.depth = static_cast<uint8_t>(depth);
             s.context = ctx;
+            s.name = ctx ? ctx->GetName() : nullptr;
             s.cooperator = co;
             s.timestamp = ts;
             g_stackTotal.fetch_add(1, std::memory_order_release);
@@ -235,6 +246,41 @@ size_t ReadStackSamples(StackSample* out, size_t maxSamples)
     return count;
 }
 
+size_t ReadStackSamplesSince(uint64_t& cursor, StackSample* out, size_t maxSamples,
+                             uint64_t* lost /* = nullptr */)
+{
+    size_t total = g_stackTotal.load(std::memory_order_acquire);
+
+    // A reset (or a cursor from before one) starts over from what the ring holds now
+    //
+    if (cursor > total)
+    {
+        cursor = 0;
+    }
+    if (total - cursor > STACK_RING_CAPACITY)
+    {
+        if (lost)
+        {
+            *lost += total - cursor - STACK_RING_CAPACITY;
+        }
+        cursor = total - STACK_RING_CAPACITY;
+    }
+
+    size_t available = total - cursor;
+    size_t count = available < maxSamples ? available : maxSamples;
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = g_stackRing[(cursor + i) & STACK_RING_MASK];
+    }
+    cursor += count;
+    return count;
+}
+
+size_t TotalStackSamples()
+{
+    return g_stackTotal.load(std::memory_order_acquire);
+}
+
 void ResetSamples()
 {
     g_head.store(0, std::memory_order_relaxed);
@@ -269,5 +315,187 @@ size_t SampleCapacity()
     return RING_CAPACITY;
 }
 
+// ---- Off-CPU profiler ----
+
+void StartOffCpuProfiling()
+{
+    g_offCpuProfiling.store(true, std::memory_order_relaxed);
+}
+
+void StopOffCpuProfiling()
+{
+    g_offCpuProfiling.store(false, std::memory_order_relaxed);
+}
+
+size_t ReadOffCpuSamples(OffCpuSample* out, size_t maxSamples)
+{
+    size_t total = g_offCpuTotal.load(std::memory_order_acquire);
+
+    size_t available = total < OFFCPU_RING_CAPACITY ? total : OFFCPU_RING_CAPACITY;
+    size_t count = available < maxSamples ? available : maxSamples;
+    if (count == 0) return 0;
+
+    size_t start = total - available;
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = g_offCpuRing[(start + i) & OFFCPU_RING_MASK];
+    }
+    return count;
+}
+
+void ResetOffCpuSamples()
+{
+    g_offCpuHead.store(0, std::memory_order_relaxed);
+    g_offCpuTotal.store(0, std::memory_order_relaxed);
+}
+
+size_t TotalOffCpuSamples()
+{
+    return g_offCpuTotal.load(std::memory_order_relaxed);
+}
+
+size_t OffCpuCapacity()
+{
+    return OFFCPU_RING_CAPACITY;
+}
+
+// Not inlined, so the walk starts from a frame of its own: the first return address is the
+// blocking call site in Cooperator::Block. The walk stays inside the stack the context runs on
+// (Context::StackTop), which is where every frame of a blocked context lives.
+//
+[[gnu::noinline]] void OffCpuScope::Begin(Context* ctx)
+{
+    m_ctx = ctx;
+    m_cooperator = ctx->GetCooperator();
+    m_start = rdtsc();
+
+    auto fp = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+    auto top = reinterpret_cast<uintptr_t>(ctx->StackTop());
+    m_depth = static_cast<uint8_t>(WalkFramePointers(fp, fp - 1, top, m_frames, 0));
+
+    ctx->m_wakeTsc = 0;
+    ctx->m_wokenBy = nullptr;
+}
+
+void OffCpuScope::End()
+{
+    // A context resumed without passing Unblock (a kill's wake path, say) is charged up to now
+    //
+    const uint64_t wake = m_ctx->m_wakeTsc ? static_cast<uint64_t>(m_ctx->m_wakeTsc) : rdtsc();
+    const uint64_t ticks = wake > m_start ? wake - m_start : 0;
+    m_ctx->m_statistics.blockedTicks += ticks;
+
+    size_t idx = g_offCpuHead.fetch_add(1, std::memory_order_relaxed) & OFFCPU_RING_MASK;
+    auto& s = g_offCpuRing[idx];
+    memcpy(s.frames, m_frames, m_depth * sizeof(uintptr_t));
+    s.depth = m_depth;
+    s.context = m_ctx;
+    s.name = m_ctx->GetName();
+    s.cooperator = m_cooperator;
+    s.coordinator = m_ctx->m_wokenBy;
+    s.blockedTicks = ticks;
+    s.timestamp = m_start;
+    g_offCpuTotal.fetch_add(1, std::memory_order_release);
+}
+
+// ---- Stall capture ----
+
+// The one capture in flight: the watchdog sets the target and signals its thread, and whichever
+// of the handler and a timed-out watchdog takes the target back first owns the slot
+//
+static std::atomic<Cooperator*> g_stallTarget{nullptr};
+static std::atomic<bool>        g_stallReady{false};
+static StallCapture             g_stall;
+static int                      g_stallSignal = 0;
+static struct sigaction         g_prevStallAction;
+
+static void StallHandler(int, siginfo_t*, void* uctx)
+{
+    Cooperator* co = Cooperator::thread_cooperator;
+    Cooperator* expected = co;
+    if (!co || !g_stallTarget.compare_exchange_strong(expected, nullptr,
+                                                      std::memory_order_acq_rel))
+    {
+        return;
+    }
+
+    auto* u = static_cast<ucontext_t*>(uctx);
+#if defined(__x86_64__)
+    uintptr_t pc = u->uc_mcontext.gregs[REG_RIP];
+    uintptr_t fp = u->uc_mcontext.gregs[REG_RBP];
+    uintptr_t sp = u->uc_mcontext.gregs[REG_RSP];
+#elif defined(__aarch64__)
+    uintptr_t pc = u->uc_mcontext.pc;
+    uintptr_t fp = u->uc_mcontext.regs[29];
+    uintptr_t sp = u->uc_mcontext.sp;
+#endif
+
+    Context* ctx = co->Scheduled();
+    uintptr_t top = ctx ? reinterpret_cast<uintptr_t>(ctx->StackTop()) : UINTPTR_MAX;
+    g_stall.frames[0] = pc;
+    g_stall.depth = static_cast<uint8_t>(WalkFramePointers(fp, sp, top, g_stall.frames, 1));
+    g_stall.context = ctx;
+    g_stall.name = ctx ? ctx->GetName() : nullptr;
+    g_stall.sliceEpoch = co->SliceEpoch();
+    g_stallReady.store(true, std::memory_order_release);
+}
+
+bool InstallStallHandler(int signal)
+{
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = StallHandler;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+
+    if (sigaction(signal, &sa, &g_prevStallAction) != 0)
+    {
+        return false;
+    }
+    g_stallSignal = signal;
+    return true;
+}
+
+void RemoveStallHandler()
+{
+    if (g_stallSignal)
+    {
+        sigaction(g_stallSignal, &g_prevStallAction, nullptr);
+        g_stallSignal = 0;
+    }
+}
+
+bool CaptureStall(Cooperator* co, StallCapture& out, int64_t timeoutUs)
+{
+    if (!g_stallSignal)
+    {
+        return false;
+    }
+
+    g_stallReady.store(false, std::memory_order_relaxed);
+    g_stallTarget.store(co, std::memory_order_release);
+    if (pthread_kill(co->Thread(), g_stallSignal) != 0)
+    {
+        g_stallTarget.store(nullptr, std::memory_order_relaxed);
+        return false;
+    }
+
+    struct timespec pause = {0, 100000};
+    for (int64_t waited = 0; !g_stallReady.load(std::memory_order_acquire); waited += 100)
+    {
+        // Out of time: take the target back, unless the handler already has and is writing
+        //
+        Cooperator* expected = co;
+        if (waited >= timeoutUs &&
+            g_stallTarget.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel))
+        {
+            return false;
+        }
+        nanosleep(&pause, nullptr);
+    }
+    out = g_stall;
+    return true;
+}
+
 } // end namespace coop::perf
 } // end namespace coop
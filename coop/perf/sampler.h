@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 
@@ -8,6 +9,7 @@ namespace coop
 
 struct Context;
 struct Cooperator;
+struct Coordinator;
 
 namespace perf
 {
@@ -44,6 +46,7 @@ struct StackSample
     uintptr_t    frames[MAX_STACK_DEPTH];
     uint8_t      depth;        // number of valid frames
     Context*     context;
+    const char*  name;         // the context's name at sample time: safe to read after it exits
     Cooperator*  cooperator;
     uint64_t     timestamp;
 };
@@ -82,6 +85,17 @@ size_t ReadSamples(Sample* out, size_t maxSamples);
 //
 size_t ReadStackSamples(StackSample* out, size_t maxSamples);
 
+// Incremental read for a consumer that drains the stack ring as it goes (the continuous profile
+// writer in pprof.h). cursor counts stack samples ever taken; start it at 0 (or at
+// TotalStackSamples() to skip what is already there). Reads up to maxSamples taken since cursor,
+// oldest first, and advances cursor past them. Samples the ring overwrote before they were read
+// are skipped, and their number added to *lost when it is given.
+//
+size_t ReadStackSamplesSince(uint64_t& cursor, StackSample* out, size_t maxSamples,
+                             uint64_t* lost = nullptr);
+
+size_t TotalStackSamples();
+
 // Reset the ring buffer and total count. Call before StartSampling to get a clean window.
 //
 void ResetSamples();
@@ -100,5 +114,117 @@ size_t TotalSamples();
 //
 size_t SampleCapacity();
 
+// ---- Off-CPU profiler ----
+//
+// The sampler above only sees contexts on the CPU; a context blocked on an IO handle, a
+// Coordinator or a channel costs latency without ever being sampled. The off-CPU profiler records
+// each block instead: Cooperator::Block walks the blocking context's frame pointers (the same
+// walk as StackSample's, bounded by the context's segment) and, when the context is resumed,
+// records one OffCpuSample weighted by how long it was blocked -- from the block to the wake
+// (Cooperator::Unblock), so run-queue delay after the wake is not counted -- and the Coordinator
+// whose release woke it, if one did. The blocked time is also charged to the context's
+// m_statistics.blockedTicks.
+//
+// Samples go into their own lock-free ring, written from every cooperator thread. When the
+// profiler is off, a block costs one relaxed load. Like the sampler it is independent of
+// COOP_PERF_MODE, and can be started at runtime via API, env var (COOP_OFFCPU=1) or the
+// status server's /api/sampler/offcpu endpoints, which aggregate the ring into weighted stacks
+// for the dashboard's flame graph.
+//
+
+struct OffCpuSample
+{
+    uintptr_t          frames[MAX_STACK_DEPTH];    // return addresses, Cooperator::Block first
+    uint8_t            depth;
+    Context*           context;                    // may have exited since: read name instead
+    const char*        name;                       // the context's name when it woke
+    Cooperator*        cooperator;
+    Coordinator const* coordinator;                // whose release woke it, null if unknown
+    uint64_t           blockedTicks;               // rdtsc ticks from block to wake
+    uint64_t           timestamp;                  // rdtsc at block time
+};
+
+inline std::atomic<bool> g_offCpuProfiling{false};
+
+inline bool IsOffCpuProfiling()
+{
+    return g_offCpuProfiling.load(std::memory_order_relaxed);
+}
+
+void StartOffCpuProfiling();
+void StopOffCpuProfiling();
+
+// Read up to `maxSamples` off-CPU samples, oldest first, with the same snapshot semantics as
+// ReadSamples.
+//
+size_t ReadOffCpuSamples(OffCpuSample* out, size_t maxSamples);
+
+void ResetOffCpuSamples();
+size_t TotalOffCpuSamples();
+size_t OffCpuCapacity();
+
+// Held on the blocking context's stack across the switch out of Cooperator::Block: captures the
+// stack on construction and records the sample on destruction, once the context runs again. Does
+// nothing unless the profiler was on at the block.
+//
+struct OffCpuScope
+{
+    OffCpuScope(OffCpuScope const&) = delete;
+    OffCpuScope(OffCpuScope&&) = delete;
+
+    explicit OffCpuScope(Context* ctx)
+    {
+        if (IsOffCpuProfiling()) [[unlikely]]
+        {
+            Begin(ctx);
+        }
+    }
+
+    ~OffCpuScope()
+    {
+        if (m_ctx) [[unlikely]]
+        {
+            End();
+        }
+    }
+
+  private:
+    void Begin(Context* ctx);
+    void End();
+
+    Context*    m_ctx{nullptr};
+    Cooperator* m_cooperator;
+    uint64_t    m_start;
+    uint8_t     m_depth;
+    uintptr_t   m_frames[MAX_STACK_DEPTH];
+};
+
+// ---- Stall capture ----
+//
+// The stall watchdog (watchdog.h) takes the stack of a context that has run too long from its own
+// thread: it signals the cooperator's thread, whose handler walks the interrupted frame pointers
+// the way SIGPROF's does, within the running context's segment.
+//
+
+struct StallCapture
+{
+    uintptr_t    frames[MAX_STACK_DEPTH];   // the interrupted pc first
+    uint8_t      depth;
+    Context*     context;                   // what was running at the signal, null for none
+    const char*  name;
+    uint64_t     sliceEpoch;                // Cooperator::SliceEpoch at the signal
+};
+
+// Install / restore the capture handler for signal
+//
+bool InstallStallHandler(int signal);
+void RemoveStallHandler();
+
+// Signal co's thread and wait up to timeoutUs for its handler to fill out. Call with the registry
+// lock held (inside Cooperator::VisitRegistry), so the thread cannot exit meanwhile, and from one
+// thread at a time. False if the handler did not run in time.
+//
+bool CaptureStall(Cooperator* co, StallCapture& out, int64_t timeoutUs);
+
 } // end namespace coop::perf
 } // end namespace coop
@@ -0,0 +1,14 @@
+#include "usdt.h"
+
+#if defined(COOP_HAVE_SDT) && COOP_HAVE_SDT
+
+// One semaphore per probe, C linkage from the declaration in usdt.h. The tracer finds each
+// through the probe's note and increments it while attached; the section is the one
+// <sys/sdt.h> and the tracers expect.
+//
+#define COOP_USDT_DEFINE_SEMAPHORE(name)                                                    \
+    __attribute__((used, section(".probes"))) unsigned short coop_##name##_semaphore = 0;
+COOP_USDT_PROBES(COOP_USDT_DEFINE_SEMAPHORE)
+#undef COOP_USDT_DEFINE_SEMAPHORE
+
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+// USDT (user statically-defined tracing) probes: fixed hook points an external tracer -- bpftrace,
+// perf, SystemTap -- can attach to in a running binary, without a rebuild or COOP_PERF_MODE.
+//
+//   bpftrace -e 'usdt:./server:coop:context_block { @[str(arg1)] = count(); }'
+//
+// Each probe site is a single NOP plus an ELF note (.note.stapsdt) naming the provider ("coop"),
+// the probe and where its arguments live. Each probe also has a semaphore, a counter the tracer
+// increments while attached. A site tests it before doing anything, so the arguments (a context's
+// name, say) are only computed while someone is listening. With nothing attached a site costs one
+// load and a predicted branch.
+//
+// Built in when CMake finds <sys/sdt.h> (systemtap-sdt-dev / systemtap-sdt-devel) and COOP_USDT
+// is ON, which defines COOP_HAVE_SDT. Otherwise COOP_USDT expands to nothing. The probes and their
+// arguments, in order:
+//
+//   context_resume   Context*, name, Cooperator*      a context is switched in
+//   context_yield    Context*, name                   a running context yields
+//   context_block    Context*, name                   a running context blocks itself
+//   context_exit     Context*, name                   a context's entry function returned
+//   io_submit        io::Handle*, fd, opcode, Context* an SQE is bound to a Handle
+//   io_finalize      io::Handle*, fd, result          a Handle's last CQE was taken
+//   passage_wake     Passage state*, released         a Passage wake reached its receiver
+//   grid_steal       thief shard, Ergs taken, Erg*    a Grid stealer took work from a peer
+//
+// fd is the descriptor's own fd, -1 for an op with none; a registered file reports it, not its
+// fixed index. opcode is the io_uring opcode (IORING_OP_*). A name is the context's name or
+// "[anonymous]". A pointer is only an identity: match resume with block/yield by Context*, and
+// submit with finalize by Handle*.
+//
+// Adding a probe: add it to COOP_USDT_PROBES and call COOP_USDT(name, args...) at the site.
+// STAP_PROBEV takes up to twelve arguments.
+//
+
+#define COOP_USDT_PROBES(X)                                                                 \
+    X(context_resume)                                                                       \
+    X(context_yield)                                                                        \
+    X(context_block)                                                                        \
+    X(context_exit)                                                                         \
+    X(io_submit)                                                                            \
+    X(io_finalize)                                                                          \
+    X(passage_wake)                                                                         \
+    X(grid_steal)
+
+#if defined(COOP_HAVE_SDT) && COOP_HAVE_SDT
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+// Defined in usdt.cpp, in the .probes section where the tracer looks for them. The symbol names
+// are fixed by <sys/sdt.h>: <provider>_<probe>_semaphore.
+//
+#define COOP_USDT_DECLARE_SEMAPHORE(name)                                                   \
+    extern "C" unsigned short coop_##name##_semaphore;
+COOP_USDT_PROBES(COOP_USDT_DECLARE_SEMAPHORE)
+#undef COOP_USDT_DECLARE_SEMAPHORE
+
+// A volatile read: the tracer writes the semaphore from outside the process
+//
+#define COOP_USDT_ACTIVE(name)                                                              \
+    __builtin_expect(*static_cast<volatile unsigned short*>(&coop_##name##_semaphore), 0)
+
+#define COOP_USDT(name, ...)                                                                \
+    do                                                                                      \
+    {                                                                                       \
+        if (COOP_USDT_ACTIVE(name))                                                         \
+        {                                                                                   \
+            STAP_PROBEV(coop, name, __VA_ARGS__);                                           \
+        }                                                                                   \
+    }                                                                                       \
+    while (0)
+
+#else
+
+#define COOP_USDT_ACTIVE(name) false
+#define COOP_USDT(name, ...) ((void)0)
+
+#endif
@@ -0,0 +1,230 @@
+#include "watchdog.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/cooperator.h"
+#include "coop/time/now.h"
+
+namespace coop
+{
+namespace perf
+{
+
+namespace
+{
+
+// How long a capture waits for the stalled thread's handler. A thread in a blocking syscall
+// takes the signal at once (SA_RESTART resumes the call), so only a thread with the signal
+// masked runs this out.
+//
+constexpr int64_t kCaptureTimeoutUs = 10000;
+
+std::mutex              s_lifecycle;        // Start / Stop
+std::thread             s_thread;
+std::mutex              s_wakeMutex;
+std::condition_variable s_wake;
+bool                    s_stopping = false;
+std::atomic<bool>       s_running{false};
+std::atomic<uint64_t>   s_totalStalls{0};
+
+// The recent stalls, a ring under its own lock: written by the watchdog thread, read by anyone
+//
+std::mutex  s_historyMutex;
+StallReport s_history[kStallHistory];
+size_t      s_historyTotal = 0;
+
+// What the watchdog knows of one cooperator: the epoch it last saw, when it first saw it, and
+// whether that slice was reported
+//
+struct Watch
+{
+    uint64_t epoch = 0;
+    int64_t  sinceNs = 0;
+    bool     reported = false;
+};
+
+std::string FormatStack(StallReport const& report)
+{
+    std::string stack;
+    char buf[24];
+    for (int i = 0; i < report.depth; i++)
+    {
+        snprintf(buf, sizeof(buf), i ? " 0x%lx" : "0x%lx", report.frames[i]);
+        stack += buf;
+    }
+    return stack.empty() ? std::string("(not captured)") : stack;
+}
+
+void Report(Cooperator* co, int64_t elapsedNs, int64_t nowNs)
+{
+    StallReport report{};
+    report.cooperator = co;
+    strncpy(report.cooperatorName, co->GetName(), sizeof(report.cooperatorName) - 1);
+    report.elapsedNs = elapsedNs;
+    report.detectedNs = nowNs;
+
+    StallCapture capture;
+    if (CaptureStall(co, capture, kCaptureTimeoutUs))
+    {
+        report.name = capture.name;
+        report.depth = capture.depth;
+        memcpy(report.frames, capture.frames, capture.depth * sizeof(uintptr_t));
+    }
+
+    co->CountStall();
+    s_totalStalls.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(s_historyMutex);
+        s_history[s_historyTotal++ % kStallHistory] = report;
+    }
+
+    spdlog::warn("stall: context \"{}\" on cooperator \"{}\" has run {} ms without yielding; "
+                 "stack {}", report.name ? report.name : "?", report.cooperatorName,
+                 elapsedNs / 1000000, FormatStack(report));
+}
+
+void Run(WatchdogConfiguration config)
+{
+    const int64_t thresholdNs = config.threshold.count() * 1000;
+    std::unordered_map<Cooperator const*, Watch> watches;
+    std::unordered_map<Cooperator const*, Watch> seen;
+
+    std::unique_lock<std::mutex> lock(s_wakeMutex);
+    while (!s_wake.wait_for(lock, config.poll, [] { return s_stopping; }))
+    {
+        lock.unlock();
+
+        // In a registry visit, so a cooperator being signalled cannot exit meanwhile
+        //
+        seen.clear();
+        const int64_t now = time::MonotonicNanos();
+        Cooperator::VisitRegistry([&](Cooperator* co) -> bool
+        {
+            const uint64_t epoch = co->SliceEpoch();
+            auto it = watches.find(co);
+            Watch watch = it != watches.end() ? it->second : Watch{epoch, now, false};
+            if (watch.epoch != epoch)
+            {
+                if (watch.reported)
+                {
+                    spdlog::info("stall: the slice on cooperator \"{}\" ended after about {} ms",
+                                 co->GetName(), (now - watch.sinceNs) / 1000000);
+                }
+                watch = Watch{epoch, now, false};
+            }
+            else if ((epoch & 1) && !watch.reported && now - watch.sinceNs >= thresholdNs)
+            {
+                Report(co, now - watch.sinceNs, now);
+                watch.reported = true;
+            }
+            seen.emplace(co, watch);
+            return true;
+        });
+        watches.swap(seen);
+
+        lock.lock();
+    }
+}
+
+// A watchdog left running is stopped at exit: destroying a joinable std::thread terminates
+//
+struct StopAtExit
+{
+    ~StopAtExit() { StopWatchdog(); }
+} s_stopAtExit;
+
+} // end anonymous namespace
+
+bool StartWatchdog(WatchdogConfiguration const& config /* = {} */)
+{
+    std::lock_guard<std::mutex> lifecycle(s_lifecycle);
+    if (s_running.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+
+    WatchdogConfiguration resolved = config;
+    if (resolved.threshold <= time::Interval::zero())
+    {
+        return false;
+    }
+    if (resolved.poll <= time::Interval::zero())
+    {
+        resolved.poll = resolved.threshold / 4;
+        if (resolved.poll <= time::Interval::zero())
+        {
+            resolved.poll = time::Interval(1);
+        }
+    }
+    if (!resolved.signal)
+    {
+        resolved.signal = SIGRTMIN + 2;
+    }
+    if (!InstallStallHandler(resolved.signal))
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s_wakeMutex);
+        s_stopping = false;
+    }
+    s_thread = std::thread(Run, resolved);
+    s_running.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void StopWatchdog()
+{
+    std::lock_guard<std::mutex> lifecycle(s_lifecycle);
+    if (!s_running.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s_wakeMutex);
+        s_stopping = true;
+    }
+    s_wake.notify_all();
+    s_thread.join();
+    RemoveStallHandler();
+    s_running.store(false, std::memory_order_relaxed);
+}
+
+bool IsWatchdogRunning()
+{
+    return s_running.load(std::memory_order_relaxed);
+}
+
+uint64_t TotalStalls()
+{
+    return s_totalStalls.load(std::memory_order_relaxed);
+}
+
+size_t ReadStalls(StallReport* out, size_t maxReports)
+{
+    std::lock_guard<std::mutex> lock(s_historyMutex);
+    size_t available = s_historyTotal < kStallHistory ? s_historyTotal : kStallHistory;
+    size_t count = available < maxReports ? available : maxReports;
+    size_t start = s_historyTotal - available;
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = s_history[(start + i) % kStallHistory];
+    }
+    return count;
+}
+
+} // end namespace coop::perf
+} // end namespace coop
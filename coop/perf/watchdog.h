@@ -0,0 +1,93 @@
+#pragma once
+
+// Stall watchdog. A context that runs 50ms without yielding holds up every other context and the
+// ring on its cooperator; the watchdog names it. A plain thread (not a cooperator, so a stalled
+// cooperator cannot hold it up) polls each registered cooperator's slice epoch
+// (Cooperator::SliceEpoch), which advances at every context switch and is odd while a context
+// runs. An odd epoch unchanged for longer than the threshold is one slice running on: the
+// watchdog signals that cooperator's thread to capture its stack (CaptureStall, the sampler's
+// frame-pointer walk), logs a warning with the context's name, the cooperator's and the stack's
+// raw addresses, and counts the stall in Cooperator::Stalls (coop_stalls_total in /metrics). When
+// the slice ends it logs how long it ran. Each slice is reported once.
+//
+// The cost to a cooperator is one relaxed store per context switch, paid whether or not the
+// watchdog runs; the watchdog's reads cost a cache line transfer per poll. Detection is by
+// polling, so a slice is reported between threshold and threshold + poll after it began, and the
+// reported time is a lower bound. A stall in the cooperator's own loop (a long Thunk run from a
+// drain) has an even epoch and is not reported. It can be started at runtime via API or env var
+// (COOP_WATCHDOG_MS=<threshold>).
+//
+//   coop::perf::StartWatchdog({.threshold = std::chrono::milliseconds(50)});
+//   ...
+//   [warning] stall: context "conn-17" on cooperator "io-3" has run 63 ms without yielding;
+//             stack 0x55d0c1a2b3c4 0x55d0c1a29f10 ...
+//
+// The addresses symbolize off-host (perf/pprof.h's mappings, addr2line) or through the status
+// server's /api/sampler/symbolize.
+//
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "coop/cooperator_configuration.h"
+#include "coop/time/interval.h"
+
+#include "sampler.h"
+
+namespace coop
+{
+namespace perf
+{
+
+struct WatchdogConfiguration
+{
+    // A slice running this long is a stall
+    //
+    time::Interval threshold = std::chrono::milliseconds(50);
+
+    // Between polls; zero for a quarter of the threshold
+    //
+    time::Interval poll = time::Interval::zero();
+
+    // The signal the capture uses; zero for SIGRTMIN + 2. It must be one nothing else handles.
+    //
+    int signal = 0;
+};
+
+// One reported stall, as it was at detection
+//
+struct StallReport
+{
+    Cooperator const* cooperator;
+    char              cooperatorName[COOPERATOR_NAME_MAX];
+    const char*       name;                 // the context's name, null if the capture failed
+    int64_t           elapsedNs;            // how long the slice had run, at least
+    int64_t           detectedNs;           // CLOCK_MONOTONIC at detection
+    uint8_t           depth;                // 0 if the capture failed
+    uintptr_t         frames[MAX_STACK_DEPTH];
+};
+
+// Start the watchdog thread. False if it is already running or the signal handler will not
+// install.
+//
+bool StartWatchdog(WatchdogConfiguration const& config = {});
+
+// Stop and join the watchdog thread, and restore the signal's previous handler
+//
+void StopWatchdog();
+
+bool IsWatchdogRunning();
+
+// Stalls reported since the process started, over all cooperators
+//
+uint64_t TotalStalls();
+
+// The most recent stalls, up to kStallHistory of them, oldest first
+//
+constexpr size_t kStallHistory = 64;
+
+size_t ReadStalls(StallReport* out, size_t maxReports);
+
+} // end namespace coop::perf
+} // end namespace coop
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "size_class_allocator.h"
+
+namespace coop
+{
+
+// Typed front ends over the calling cooperator's SizeClassAllocator. Both are stateless: they
+// allocate from whichever cooperator they are called on, and a free goes back to the block's own
+// allocator from any thread (see SizeClassAllocator::Release). An object built on one cooperator
+// may therefore be freed on another, and a container may move between cooperators.
+//
+// Allocation must happen on a cooperator thread.
+//
+//   auto* req = coop::Pool<Request>::New(fd, now);
+//   ...
+//   coop::Pool<Request>::Delete(req);
+//
+//   auto parser = coop::Pool<Parser>::Make(config);                // unique_ptr, pooled deleter
+//
+//   std::vector<Header, coop::PoolAllocator<Header>> headers;
+//
+template<typename T>
+struct Pool
+{
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "Pool<T> does not serve over-aligned types");
+
+    // Construct a T in a pooled block. Null if no block could be had.
+    //
+    template<typename... Args>
+    static T* New(Args&&... args)
+    {
+        auto* allocator = SizeClassAllocator::Current();
+        assert(allocator && "coop::Pool<T>::New called off a cooperator thread");
+        void* memory = allocator->Allocate(sizeof(T));
+        return memory ? new (memory) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    // Destroy and free an object New made, on any thread. p must be the T that was built, not a
+    // base of it: the block is found by sizeof(T).
+    //
+    static void Delete(T* p)
+    {
+        if (p)
+        {
+            p->~T();
+            SizeClassAllocator::Release(p, sizeof(T));
+        }
+    }
+
+    struct Deleter
+    {
+        void operator()(T* p) const { Delete(p); }
+    };
+
+    using Ptr = std::unique_ptr<T, Deleter>;
+
+    template<typename... Args>
+    static Ptr Make(Args&&... args)
+    {
+        return Ptr(New(std::forward<Args>(args)...));
+    }
+};
+
+// STL allocator over the calling cooperator's SizeClassAllocator. Always equal, since any one can
+// free what another allocated.
+//
+template<typename T>
+struct PoolAllocator
+{
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "PoolAllocator<T> does not serve over-aligned types");
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    PoolAllocator() noexcept = default;
+
+    template<typename U>
+    PoolAllocator(PoolAllocator<U> const&) noexcept {}
+
+    T* allocate(size_t n)
+    {
+        auto* allocator = SizeClassAllocator::Current();
+        assert(allocator && "coop::PoolAllocator used off a cooperator thread");
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        void* memory = allocator->Allocate(n * sizeof(T));
+        if (!memory)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(memory);
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        SizeClassAllocator::Release(p, n * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(PoolAllocator<U> const&) const noexcept { return true; }
+};
+
+} // end namespace coop
@@ -0,0 +1,140 @@
+#include "preempt.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "context.h"
+#include "time/now.h"
+
+namespace coop
+{
+
+namespace
+{
+
+// Polls no faster than this, whatever the slices: a ticker spinning on a 10us slice would cost
+// more than the preemption saves
+//
+constexpr int64_t kMinPollUs = 50;
+
+std::mutex              s_lifecycle;        // Start / Stop
+std::thread             s_thread;
+size_t                  s_holders = 0;
+std::mutex              s_wakeMutex;
+std::condition_variable s_wake;
+bool                    s_stopping = false;
+
+// What the ticker knows of one cooperator: the epoch it last saw, when it first saw it, and
+// whether that slice was expired
+//
+struct Watch
+{
+    uint64_t epoch = 0;
+    int64_t  sinceNs = 0;
+    bool     expired = false;
+};
+
+void Run()
+{
+    std::unordered_map<Cooperator const*, Watch> watches;
+    std::unordered_map<Cooperator const*, Watch> seen;
+    auto poll = std::chrono::microseconds(kMinPollUs);
+
+    std::unique_lock<std::mutex> lock(s_wakeMutex);
+    while (!s_wake.wait_for(lock, poll, [] { return s_stopping; }))
+    {
+        lock.unlock();
+
+        // In a registry visit, so a cooperator cannot exit while it is being marked
+        //
+        seen.clear();
+        int64_t shortestUs = 0;
+        const int64_t now = time::MonotonicNanos();
+        Cooperator::VisitRegistry([&](Cooperator* co) -> bool
+        {
+            const int64_t sliceUs = co->TimeSliceUs();
+            if (!sliceUs)
+            {
+                return true;
+            }
+            shortestUs = shortestUs ? std::min(shortestUs, sliceUs) : sliceUs;
+
+            const uint64_t epoch = co->SliceEpoch();
+            auto it = watches.find(co);
+            Watch watch = it != watches.end() ? it->second : Watch{epoch, now, false};
+            if (watch.epoch != epoch)
+            {
+                watch = Watch{epoch, now, false};
+            }
+            else if ((epoch & 1) && !watch.expired && now - watch.sinceNs >= sliceUs * 1000)
+            {
+                co->ExpireSlice(epoch);
+                watch.expired = true;
+            }
+            seen.emplace(co, watch);
+            return true;
+        });
+        watches.swap(seen);
+        poll = std::chrono::microseconds(std::max(shortestUs / 4, kMinPollUs));
+
+        lock.lock();
+    }
+}
+
+} // end anonymous namespace
+
+namespace detail
+{
+
+bool YieldExpiredSlice()
+{
+    auto* co = Cooperator::thread_cooperator;
+    auto* ctx = co->Scheduled();
+    if (!ctx)
+    {
+        return false;
+    }
+    co->CountPreemption();
+    return ctx->Yield();
+}
+
+void StartPreemptTicker()
+{
+    std::lock_guard<std::mutex> lifecycle(s_lifecycle);
+    if (s_holders++)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s_wakeMutex);
+        s_stopping = false;
+    }
+    s_thread = std::thread(Run);
+}
+
+void StopPreemptTicker()
+{
+    std::lock_guard<std::mutex> lifecycle(s_lifecycle);
+    assert(s_holders > 0);
+    if (--s_holders)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s_wakeMutex);
+        s_stopping = true;
+    }
+    s_wake.notify_all();
+    s_thread.join();
+}
+
+} // end namespace detail
+
+} // end namespace coop
@@ -0,0 +1,66 @@
+#pragma once
+
+// Cooperative preemption checkpoints. A context only gives up its cooperator when it yields, so a
+// CPU-bound loop -- a compression pass, a large ParallelFor shard, a scan -- holds up every other
+// context and the ring for as long as it runs. Yielding every N iterations guesses at N;
+// MaybeYield instead yields only once the running slice has used up its time:
+//
+//   cfg.timeSliceUs = 2000;
+//   ...
+//   for (size_t i = 0; i < blocks; i++)
+//   {
+//       Compress(block[i]);
+//       coop::MaybeYield();
+//   }
+//
+// The check reads no clock. A process-wide ticker thread, running while any cooperator has
+// CooperatorConfiguration::timeSliceUs set, polls each cooperator's slice epoch as the stall
+// watchdog does (perf/watchdog.h) and marks a slice that has run timeSliceUs as expired. The check
+// is two relaxed loads from a line the cooperator already writes at every switch and a compare, so
+// it can sit in an inner loop. Detection is by polling, at a quarter of the slice: a slice expires
+// between timeSliceUs and about 1.25 times it after it began.
+//
+// MaybeYield must be called from a context. Erg and continuation bodies run to completion and
+// cannot yield; they can test SliceExpired() to cut their work short. ParallelFor does this
+// itself: an expired slice sheds the rest of a shard to the stealers, and the blocking forms
+// yield between chunks.
+//
+
+#include "cooperator.h"
+
+namespace coop
+{
+
+// Whether the calling cooperator's running slice has used up its timeSliceUs. False off a
+// cooperator thread, in the cooperator's own loop, and always with timeSliceUs unset.
+//
+inline bool SliceExpired()
+{
+    auto* co = Cooperator::thread_cooperator;
+    return co && co->SliceExpired();
+}
+
+namespace detail
+{
+
+bool YieldExpiredSlice();
+
+// Refcounted: each cooperator with a time slice holds the ticker for its loop's extent
+//
+void StartPreemptTicker();
+void StopPreemptTicker();
+
+} // end namespace detail
+
+// Yield if the running slice has expired; returns whether it did
+//
+inline bool MaybeYield()
+{
+    if (!SliceExpired()) [[likely]]
+    {
+        return false;
+    }
+    return detail::YieldExpiredSlice();
+}
+
+} // end namespace coop
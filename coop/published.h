@@ -0,0 +1,248 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "epoch/domain.h"
+
+namespace coop
+{
+
+// Published<T> is a read-mostly value that every cooperator consults on every request and that a
+// writer now and then replaces wholesale: a routing table, a feature config. Publish builds the
+// next immutable snapshot and swaps it in; the snapshot it replaces is retired through the
+// writer's epoch::Participant and freed once every cooperator has quiesced past it.
+//
+//  coop::epoch::Domain domain;                                     // process-wide
+//  coop::Published<Routes> routes(domain, LoadRoutes());
+//
+//  coop::epoch::Participant participant(domain);                   // per cooperator
+//  coop::Published<Routes>::Reader reader(routes, participant);
+//  Routes const& r = reader.Get();                                 // until this context yields
+//
+//  routes.Publish(participant, BuildRoutes());                     // from any cooperator
+//
+// Reader is the hot path. It caches the snapshot for its cooperator, and Get is a plain load of
+// that pointer -- no atomic, no fence, no shared write, where copying a shared_ptr costs two
+// read-modify-writes on a count every core contends for. The cached snapshot is kept alive by the
+// reader's epoch::Holder pin, which the participant renews at each scheduler Quiesce (picking up
+// a newer snapshot if one was published) and drops before the cooperator sleeps in the kernel;
+// the next Get pins and loads again. So a reader sees a publish within one scheduler pass, and a
+// reference from Get is good until the calling context next yields, blocks or migrates. To keep
+// one across those, hold an epoch::DomainGuard and use Published::Get(guard).
+//
+// Writers serialize on a std::mutex held for the swap only, never across T's construction or a
+// yield. The domain must outlive the participants (see epoch::Domain), the Published must outlive
+// its Readers, and destruction must not race a reader or writer. Retired snapshots carry their
+// own reclaim function, so they may outlive the Published.
+//
+template<typename T>
+struct Published
+{
+    struct Reader;
+
+    Published(Published const&) = delete;
+    Published(Published&&) = delete;
+
+    // The first snapshot, version 1, built from args
+    //
+    template<typename... Args>
+    explicit Published(epoch::Domain& domain, Args&&... args);
+    ~Published();
+
+    // Build the next snapshot from args and make it current; the one it replaces is retired
+    // through participant. Returns the new snapshot's version.
+    //
+    template<typename... Args>
+    uint64_t Publish(epoch::Participant& participant, Args&&... args);
+
+    // The current snapshot, valid for as long as guard is held
+    //
+    T const& Get(epoch::DomainGuard const& guard) const;
+
+    // The current snapshot's version: 1 for the first, one more for each Publish
+    //
+    uint64_t Version() const { return m_version.load(std::memory_order_acquire); }
+
+    epoch::Domain& GetDomain() const { return m_domain; }
+
+  private:
+    struct Snapshot : epoch::RetireEntry
+    {
+        template<typename... Args>
+        explicit Snapshot(Args&&... args)
+        : value(std::forward<Args>(args)...)
+        {
+            reclaim = &Snapshot::Free;
+        }
+
+        static void Free(epoch::RetireEntry* entry) { delete static_cast<Snapshot*>(entry); }
+
+        T const     value;
+        uint64_t    version = 1;    // set before the snapshot is published, then never again
+    };
+
+    epoch::Domain&          m_domain;
+    std::atomic<Snapshot*>  m_current;
+    std::atomic<uint64_t>   m_version{1};
+    std::mutex              m_writeLock;
+};
+
+// One cooperator's cached view of a Published. Built, used and destroyed on its participant's
+// cooperator; not shared between cooperators.
+//
+template<typename T>
+struct Published<T>::Reader : private epoch::Holder
+{
+    Reader(Reader const&) = delete;
+    Reader(Reader&&) = delete;
+
+    Reader(Published& published, epoch::Participant& participant);
+    ~Reader();
+
+    // The cached snapshot: good until the calling context next yields, blocks or migrates
+    //
+    T const& Get()
+    {
+        if (!m_cached) [[unlikely]]
+        {
+            Load();
+        }
+        return m_cached->value;
+    }
+
+    T const* operator->() { return &Get(); }
+
+    uint64_t Version()
+    {
+        Get();
+        return m_cached->version;
+    }
+
+  private:
+    static void OnQuiesce(epoch::Holder* holder, bool idle);
+
+    // Pin at the domain's current epoch and cache the current snapshot
+    //
+    void Load();
+
+    Published&                          m_published;
+    epoch::Participant&                 m_participant;
+    std::optional<epoch::DomainGuard>   m_guard;
+    Snapshot const*                     m_cached{nullptr};
+};
+
+// ---- Published ----
+
+template<typename T>
+template<typename... Args>
+Published<T>::Published(epoch::Domain& domain, Args&&... args)
+: m_domain(domain)
+, m_current(new Snapshot(std::forward<Args>(args)...))
+{
+}
+
+template<typename T>
+Published<T>::~Published()
+{
+    delete m_current.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+template<typename... Args>
+uint64_t Published<T>::Publish(epoch::Participant& participant, Args&&... args)
+{
+    assert(&participant.GetDomain() == &m_domain && "Published written through another domain");
+
+    // Built outside the lock; numbered and swapped in under it, so versions follow publish order
+    //
+    auto* next = new Snapshot(std::forward<Args>(args)...);
+    Snapshot* previous;
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(m_writeLock);
+        version = m_version.load(std::memory_order_relaxed) + 1;
+        next->version = version;
+
+        // Release: the snapshot's contents are visible to whoever loads the pointer
+        //
+        previous = m_current.exchange(next, std::memory_order_acq_rel);
+        m_version.store(version, std::memory_order_release);
+    }
+
+    participant.Retire(previous);
+    return version;
+}
+
+template<typename T>
+T const& Published<T>::Get(epoch::DomainGuard const& guard) const
+{
+    assert(&guard.GetParticipant().GetDomain() == &m_domain
+           && "Published read under another domain's guard");
+    (void)guard;
+    return m_current.load(std::memory_order_acquire)->value;
+}
+
+// ---- Reader ----
+
+template<typename T>
+Published<T>::Reader::Reader(Published& published, epoch::Participant& participant)
+: m_published(published)
+, m_participant(participant)
+{
+    assert(&participant.GetDomain() == &published.m_domain
+           && "Published::Reader built on another domain's participant");
+    quiesce = &Reader::OnQuiesce;
+    participant.AddHolder(this);
+}
+
+template<typename T>
+Published<T>::Reader::~Reader()
+{
+    m_participant.RemoveHolder(this);
+}
+
+template<typename T>
+void Published<T>::Reader::Load()
+{
+    m_guard.emplace(m_participant);
+
+    // Participant::Enter fences only for a cooperator's first pin. A nested one is published when
+    // the older pin exits, so the epoch it was taken at must still come before the snapshot load.
+    //
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    m_cached = m_published.m_current.load(std::memory_order_acquire);
+}
+
+template<typename T>
+void Published<T>::Reader::OnQuiesce(epoch::Holder* holder, bool idle)
+{
+    // No context is running, so nothing Get handed out is still in use
+    //
+    auto* reader = static_cast<Reader*>(holder);
+    if (!reader->m_cached)
+    {
+        return;
+    }
+    if (!idle
+        && reader->m_guard->PinnedEpoch() == reader->m_published.m_domain.Current()
+        && reader->m_cached == reader->m_published.m_current.load(std::memory_order_relaxed))
+    {
+        // The pin holds nothing back and the snapshot is current
+        //
+        return;
+    }
+
+    reader->m_guard.reset();
+    reader->m_cached = nullptr;
+    if (!idle)
+    {
+        reader->Load();
+    }
+}
+
+} // end namespace coop
@@ -0,0 +1,423 @@
+#include "endpoint.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <linux/filter.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <tuple>
+#include <unistd.h>
+
+#include "coop/context.h"
+#include "coop/coordinate_with.h"
+#include "coop/cooperator.h"
+#include "coop/self.h"
+#include "coop/wait_group.h"
+#include "coop/io/armed_handle.h"
+#include "coop/io/buffer_ring.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/send.h"
+#include "coop/io/udp.h"
+#include "coop/io/uring.h"
+#include "coop/time/now.h"
+#include "coop/time/sleep.h"
+
+namespace coop
+{
+namespace quic
+{
+
+namespace
+{
+
+// A train stays under the 64KB one UDP send may carry, with room for an IPv6 header
+//
+static constexpr size_t MAX_TRAIN_BYTES = 65000;
+static constexpr size_t MAX_DATAGRAM = 65507;
+
+// How long a Run blocked on an idle socket takes to notice a kill
+//
+static constexpr time::Interval KILL_POLL = std::chrono::milliseconds(100);
+
+// Pick the group's socket from the first byte of the destination connection ID: offset 6 in a
+// long header, after the flags, the version and the ID's length; offset 1 in a short one. The
+// program sees the UDP payload. A datagram too short for the load aborts to socket 0.
+//
+bool SteerByConnectionId(int fd, uint32_t count)
+{
+    sock_filter prog[] = {
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 0),
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x80, 0, 2),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 6),
+        BPF_JUMP(BPF_JMP | BPF_JA, 1, 0, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 1),
+        BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, count),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+    };
+    sock_fprog fprog = {static_cast<unsigned short>(sizeof(prog) / sizeof(prog[0])), prog};
+    return setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &fprog, sizeof(fprog)) == 0;
+}
+
+bool SamePeer(struct sockaddr_in6 const& a, socklen_t aLength, struct sockaddr_in6 const& b,
+              socklen_t bLength)
+{
+    return aLength == bLength && memcmp(&a, &b, aLength) == 0;
+}
+
+} // end anonymous namespace
+
+int OpenSteered(struct sockaddr const* addr, socklen_t addrLength, uint32_t count,
+                std::vector<int>* fds)
+{
+    if (count == 0 || count > 256 || addrLength > sizeof(struct sockaddr_in6))
+    {
+        return -EINVAL;
+    }
+
+    struct sockaddr_in6 bound = {};
+    memcpy(&bound, addr, addrLength);
+    size_t first = fds->size();
+    auto fail = [&](int err)
+    {
+        for (size_t i = first; i < fds->size(); i++)
+        {
+            ::close((*fds)[i]);
+        }
+        fds->resize(first);
+        return -err;
+    };
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        int fd = socket(addr->sa_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            return fail(errno);
+        }
+        fds->push_back(fd);
+
+        int on = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0
+            || bind(fd, reinterpret_cast<struct sockaddr*>(&bound), addrLength) != 0)
+        {
+            return fail(errno);
+        }
+
+        // The first bind settles an ephemeral port; the rest join it. The program attached to any
+        // member steers the whole group.
+        //
+        if (i == 0)
+        {
+            socklen_t length = addrLength;
+            if (getsockname(fd, reinterpret_cast<struct sockaddr*>(&bound), &length) != 0)
+            {
+                return fail(errno);
+            }
+            if (count > 1 && !SteerByConnectionId(fd, count))
+            {
+                return fail(errno);
+            }
+        }
+    }
+    return 0;
+}
+
+Endpoint::Endpoint(Context* ctx, io::Descriptor& desc, uint32_t index, uint32_t count,
+                   EndpointOptions options /* = {} */)
+: m_ctx(ctx)
+, m_desc(desc)
+, m_index(index)
+, m_count(count)
+, m_options(std::move(options))
+, m_wake(ctx)
+{
+}
+
+Endpoint::~Endpoint()
+{
+    assert(!m_armed);
+}
+
+int Endpoint::Run(DatagramHandler handler, void* arg)
+{
+    m_handler = handler;
+    m_arg = arg;
+    m_stopping = false;
+
+    io::BufferRing ring(m_options.bufferGroup, m_options.bufferCount, m_options.bufferSize);
+    int err = ring.Register(*GetUring());
+    if (err < 0)
+    {
+        return err;
+    }
+
+    // Best effort: without GRO every datagram is a completion of its own
+    //
+    if (m_options.gro)
+    {
+        std::ignore = io::SetUdpGro(m_desc);
+    }
+
+    Coordinator coord;
+    io::ArmedHandle armed(io::datagrams, m_ctx, m_desc, &ring, &coord,
+        sizeof(struct sockaddr_in6), m_options.gro ? uint32_t(io::UDP_GRO_CONTROL) : 0);
+    m_armed = &armed;
+
+    WaitGroup sender;
+    bool spawned = sender.Spawn([this](Context* child)
+    {
+        child->SetName("QuicSender");
+        Sender(child);
+    });
+    if (!spawned)
+    {
+        m_armed = nullptr;
+        return -EAGAIN;
+    }
+
+    armed.Arm();
+    int result = 0;
+    while (!m_stopping && !m_ctx->IsKilled())
+    {
+        io::ArmedHandle::Chunk chunk;
+        int n = armed.Next(&chunk, KILL_POLL);
+        if (n == -ETIMEDOUT)
+        {
+            continue;
+        }
+        if (n == -ENOBUFS)
+        {
+            armed.Arm();
+            continue;
+        }
+        if (n <= 0)
+        {
+            result = m_stopping ? 0 : n;
+            break;
+        }
+
+        m_stats.completions++;
+        io::ArmedHandle::Datagram datagram;
+        if (!armed.ParseDatagram(chunk, &datagram) || datagram.truncated)
+        {
+            m_stats.dropped++;
+            continue;
+        }
+
+        // A GRO run is cut back into the datagrams it coalesced
+        //
+        auto* payload = reinterpret_cast<const uint8_t*>(datagram.payload);
+        size_t segment = datagram.segment ? datagram.segment : datagram.payloadLen;
+        for (size_t at = 0; at < datagram.payloadLen; at += segment)
+        {
+            Deliver(payload + at, std::min<size_t>(segment, datagram.payloadLen - at),
+                    datagram.name, datagram.nameLen);
+        }
+    }
+
+    armed.Cancel();
+    m_armed = nullptr;
+    m_stopping = true;
+    Wake();
+    sender.Wait(m_ctx);
+    return result;
+}
+
+void Endpoint::Deliver(const uint8_t* data, size_t size, struct sockaddr const* peer,
+                       socklen_t peerLength)
+{
+    Header header;
+    if (!ParseHeader(data, size, m_options.cidLength, &header))
+    {
+        m_stats.dropped++;
+        return;
+    }
+
+    if (NeedsVersionNegotiation(header, m_options.versions))
+    {
+        uint8_t out[1 + 4 + 2 * (1 + MAX_CID_LENGTH) + 4 * 32];
+        size_t length = 0;
+        if (size >= MIN_INITIAL_DATAGRAM && peer)
+        {
+            length = WriteVersionNegotiation(out, sizeof(out), header, m_options.versions);
+        }
+        if (length > 0 && Send(peer, peerLength, out, length) == 0)
+        {
+            m_stats.negotiated++;
+        }
+        else
+        {
+            m_stats.dropped++;
+        }
+        return;
+    }
+
+    m_stats.received++;
+    m_handler(*this, Datagram{header, data, size, peer, peerLength}, m_arg);
+}
+
+int Endpoint::Send(struct sockaddr const* peer, socklen_t peerLength, const void* data,
+                   size_t size)
+{
+    if (size == 0 || size > MAX_DATAGRAM)
+    {
+        return -EMSGSIZE;
+    }
+    if (peerLength > sizeof(struct sockaddr_in6))
+    {
+        return -EINVAL;
+    }
+    if (m_queue.size() >= m_options.maxQueued)
+    {
+        return -ENOBUFS;
+    }
+
+    Queued queued;
+    queued.offset = m_bytes.size();
+    queued.size = static_cast<uint16_t>(size);
+    queued.peerLength = peerLength;
+    memset(&queued.peer, 0, sizeof(queued.peer));
+    memcpy(&queued.peer, peer, peerLength);
+    m_queue.push_back(queued);
+
+    auto* bytes = static_cast<const uint8_t*>(data);
+    m_bytes.insert(m_bytes.end(), bytes, bytes + size);
+    Wake();
+    return 0;
+}
+
+void Endpoint::Stop()
+{
+    m_stopping = true;
+    if (m_armed)
+    {
+        m_armed->Cancel();
+    }
+}
+
+bool Endpoint::NewConnectionId(ConnectionId* out) const
+{
+    return quic::NewConnectionId(m_options.cidLength, m_index, m_count, out);
+}
+
+void Endpoint::Wake()
+{
+    if (m_wake.IsHeld())
+    {
+        m_wake.Release(Self(), false);
+    }
+}
+
+// Drain the queue a round at a time until Run is done and nothing is left
+//
+int Endpoint::Sender(Context* ctx)
+{
+    for (;;)
+    {
+        if (m_queue.empty())
+        {
+            if (m_stopping)
+            {
+                return 0;
+            }
+            if (CoordinateWithKill(ctx, &m_wake).Killed())
+            {
+                return -ECANCELED;
+            }
+            continue;
+        }
+
+        m_sending.swap(m_queue);
+        m_sendingBytes.swap(m_bytes);
+
+        size_t i = 0;
+        while (i < m_sending.size())
+        {
+            // Gather a train: one peer, every datagram the first one's size but the last
+            //
+            Queued const& first = m_sending[i];
+            size_t limit = m_gso ? m_options.maxSegments : 1;
+            if (m_options.pacingRate > 0)
+            {
+                limit = std::min(limit, std::max<size_t>(1, m_options.pacingBurst / first.size));
+            }
+            size_t j = i + 1;
+            size_t bytes = first.size;
+            while (j < m_sending.size() && j - i < limit
+                   && m_sending[j - 1].size == first.size && m_sending[j].size <= first.size
+                   && bytes + m_sending[j].size <= MAX_TRAIN_BYTES
+                   && SamePeer(m_sending[j].peer, m_sending[j].peerLength, first.peer,
+                               first.peerLength))
+            {
+                bytes += m_sending[j].size;
+                j++;
+            }
+
+            Pace(ctx, bytes);
+            int ret = SendTrain(i, j - i, bytes);
+            if (j - i > 1 && (ret == -EIO || ret == -EINVAL || ret == -ENOPROTOOPT))
+            {
+                // No GSO here: send the train again a datagram at a time, and every one after
+                //
+                m_gso = false;
+                continue;
+            }
+            i = j;
+        }
+
+        m_sending.clear();
+        m_sendingBytes.clear();
+    }
+}
+
+int Endpoint::SendTrain(size_t first, size_t count, size_t bytes)
+{
+    Queued& head = m_sending[first];
+    struct iovec iov = {m_sendingBytes.data() + head.offset, bytes};
+    struct msghdr msg = {};
+    msg.msg_name = &head.peer;
+    msg.msg_namelen = head.peerLength;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    io::UdpSegmentControl control;
+    if (count > 1)
+    {
+        io::SetUdpSegment(&msg, &control, head.size);
+    }
+
+    m_stats.sends++;
+    int ret = io::SendMsg(m_desc, &msg);
+    if (ret >= 0)
+    {
+        m_stats.sent += count;
+    }
+    return ret;
+}
+
+// A virtual clock that runs bytes / rate ahead per train. It may lag the real one by up to a burst,
+// which is the credit an idle endpoint builds back up; a train due ahead of the real clock waits.
+//
+void Endpoint::Pace(Context* ctx, size_t bytes)
+{
+    uint64_t rate = m_options.pacingRate;
+    if (rate == 0)
+    {
+        return;
+    }
+    int64_t now = time::MonotonicMicros();
+    auto burstUs = static_cast<int64_t>(m_options.pacingBurst * 1000000 / rate);
+    m_nextSendUs = std::max(m_nextSendUs, now - burstUs);
+    if (m_nextSendUs > now)
+    {
+        m_stats.paced++;
+        time::Sleep(ctx, time::Interval(m_nextSendUs - now));
+    }
+    m_nextSendUs += static_cast<int64_t>(bytes * 1000000 / rate);
+}
+
+} // end namespace coop::quic
+} // end namespace coop
@@ -0,0 +1,209 @@
+#pragma once
+
+// coop::quic::Endpoint — the datagram engine under a QUIC server: one UDP socket per cooperator,
+// packets steered to the cooperator that owns their connection, received and sent in batches.
+//
+//   std::vector<int> fds;
+//   coop::quic::OpenSteered((sockaddr*)&addr, sizeof(addr), group.Size(), &fds);
+//   // on cooperator i of the group:
+//   coop::io::Descriptor desc(fds[i]);
+//   coop::quic::Endpoint endpoint(ctx, desc, i, group.Size());
+//   endpoint.Run(OnDatagram, &state);
+//
+// Steering. The sockets share a port through SO_REUSEPORT, and a classic BPF program on the group
+// picks the socket for each datagram from the first byte of its destination connection ID
+// (packet.h). IDs the server issues are made with NewConnectionId, whose first byte routes back
+// to the issuing socket, so from the client's second flight on every packet of a connection
+// lands on its cooperator: no lookup shared between threads, no handoff. A client's very first
+// packets carry an ID it chose at random; they land on a socket picked by that ID, the same one
+// for each, and that socket's cooperator is the one that takes the connection on.
+//
+// Receive. Run arms one multishot recvmsg over a buffer ring (io/armed_handle.h), with UDP_GRO
+// on, so a burst from one peer arrives coalesced in one buffer and costs one completion -- no
+// SQE per packet, no syscall per packet. Each datagram is handed to the handler with its header
+// parsed (ParseHeader); datagrams too short to parse are dropped, and a long header naming a
+// version not in EndpointOptions::versions is answered with Version Negotiation right here.
+//
+// Send. Send copies a datagram into the endpoint's queue and returns; a sender context owned by
+// Run drains the queue. Consecutive datagrams to one peer of one size (the last may be shorter)
+// leave as one UDP_SEGMENT (GSO) train of up to maxSegments packets, so replies the handler
+// queues while a coalesced burst is processed go out in a few sends rather than one each. Where
+// the kernel refuses GSO, the sender falls back to a send per datagram for good.
+//
+// Pacing. With a pacingRate, the sender spaces trains at that rate after an initial burst of
+// pacingBurst bytes, sleeping through the cooperator's timer queue (time/sleep.h) -- the same
+// queue every other timer on the cooperator shares, so a paced endpoint arms no timers of its
+// own. Trains are cut to the burst size, so a long queue cannot leave in one line-rate clump.
+//
+// This is the transport's bottom half only. The QUIC handshake needs a TLS stack with the QUIC
+// interface (RFC 9001), which the OpenSSL this tree builds against does not have; connection
+// state, loss recovery and HTTP/3 belong above the handler.
+//
+// Single-cooperator: Run, Send and Stop are called on the endpoint's cooperator.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <vector>
+
+#include "coop/coordinator.h"
+#include "coop/quic/packet.h"
+
+namespace coop
+{
+
+struct Context;
+
+namespace io
+{
+struct ArmedHandle;
+struct Descriptor;
+} // end namespace coop::io
+
+namespace quic
+{
+
+struct EndpointOptions
+{
+    // The length of every connection ID this endpoint issues, and so of short-header IDs
+    //
+    uint8_t cidLength = 8;
+
+    // Versions this endpoint speaks; a long header naming any other is answered with Version
+    // Negotiation. Empty hands every datagram to the handler.
+    //
+    std::vector<uint32_t> versions = {VERSION_1};
+
+    // The receive buffer ring. With GRO a buffer takes a whole coalesced run, so leave room for
+    // 64KB and the kernel's header; a run that does not fit is truncated and dropped.
+    //
+    uint16_t bufferGroup = 0x5143;      // unique among buffer rings on the cooperator's ring
+    uint32_t bufferCount = 64;          // a power of two
+    uint32_t bufferSize = 65536 + 256;
+    bool gro = true;
+
+    // Sending. A train carries at most maxSegments datagrams (the kernel's limit is 64); past
+    // maxQueued datagrams waiting, Send refuses more with -ENOBUFS.
+    //
+    uint16_t maxSegments = 64;
+    size_t maxQueued = 4096;
+
+    // Bytes per second, zero for unpaced; and what may leave back to back before pacing applies
+    //
+    uint64_t pacingRate = 0;
+    size_t pacingBurst = 10 * 1472;
+};
+
+struct EndpointStats
+{
+    uint64_t received = 0;          // datagrams handed to the handler
+    uint64_t completions = 0;       // receive completions they arrived in
+    uint64_t dropped = 0;           // unparseable or truncated
+    uint64_t negotiated = 0;        // Version Negotiation packets sent
+    uint64_t sent = 0;              // datagrams sent
+    uint64_t sends = 0;             // sendmsg operations they left in
+    uint64_t paced = 0;             // sleeps the pacer took
+};
+
+// One received datagram. header describes its first QUIC packet (a datagram may carry several,
+// coalesced); everything points into the receive buffer and is valid only during the callback.
+//
+struct Datagram
+{
+    Header                  header;
+    const uint8_t*          data;
+    size_t                  size;
+    struct sockaddr const*  peer;
+    socklen_t               peerLength;
+};
+
+struct Endpoint;
+
+using DatagramHandler = void (*)(Endpoint& endpoint, Datagram const& datagram, void* arg);
+
+// Open count UDP sockets bound to addr in one SO_REUSEPORT group, steered by connection ID:
+// socket i receives the packets whose destination ID has SteeringIndex i. A port of zero binds an
+// ephemeral one, shared by all. Returns 0 with the fds appended, or a negative errno with none
+// left open.
+//
+int OpenSteered(struct sockaddr const* addr, socklen_t addrLength, uint32_t count,
+                std::vector<int>* fds);
+
+struct Endpoint
+{
+    // desc is socket index of a steered group of count (OpenSteered). It must outlive the
+    // endpoint, and be used by nothing else while Run is running.
+    //
+    Endpoint(Context* ctx, io::Descriptor& desc, uint32_t index, uint32_t count,
+             EndpointOptions options = {});
+    ~Endpoint();
+
+    Endpoint(Endpoint const&) = delete;
+    Endpoint& operator=(Endpoint const&) = delete;
+
+    // Receive until Stop, a kill of ctx, or a receive error, handing every datagram to handler.
+    // Returns 0 when stopped or killed, or the negative errno that ended it (a buffer ring that
+    // would not register, a kernel without multishot recvmsg). Queued datagrams are sent before
+    // it returns.
+    //
+    int Run(DatagramHandler handler, void* arg);
+
+    // Queue a datagram to peer. Returns 0, -EMSGSIZE for an empty or oversized datagram, or
+    // -ENOBUFS when the queue is full.
+    //
+    int Send(struct sockaddr const* peer, socklen_t peerLength, const void* data, size_t size);
+
+    void Stop();
+
+    // A connection ID that steers back to this endpoint, of the configured length
+    //
+    bool NewConnectionId(ConnectionId* out) const;
+
+    uint32_t Index() const { return m_index; }
+    EndpointStats const& GetStats() const { return m_stats; }
+
+  private:
+    struct Queued
+    {
+        size_t                  offset;
+        uint16_t                size;
+        socklen_t               peerLength;
+        struct sockaddr_in6     peer;       // large enough for either family
+    };
+
+    void Deliver(const uint8_t* data, size_t size, struct sockaddr const* peer,
+                 socklen_t peerLength);
+    int Sender(Context* ctx);
+    int SendTrain(size_t first, size_t count, size_t bytes);
+    void Pace(Context* ctx, size_t bytes);
+    void Wake();
+
+    Context*            m_ctx;
+    io::Descriptor&     m_desc;
+    uint32_t            m_index;
+    uint32_t            m_count;
+    EndpointOptions     m_options;
+
+    DatagramHandler     m_handler = nullptr;
+    void*               m_arg = nullptr;
+    io::ArmedHandle*    m_armed = nullptr;      // the running receive, for Stop
+    bool                m_stopping = false;
+    bool                m_gso = true;
+
+    // Send appends to m_queue; the sender swaps it with m_sending and drains that, so datagrams
+    // queued while a send is in flight wait for the next round
+    //
+    std::vector<Queued>     m_queue;
+    std::vector<uint8_t>    m_bytes;
+    std::vector<Queued>     m_sending;
+    std::vector<uint8_t>    m_sendingBytes;
+    Coordinator             m_wake;
+
+    int64_t             m_nextSendUs = 0;
+    EndpointStats       m_stats;
+};
+
+} // end namespace coop::quic
+} // end namespace coop
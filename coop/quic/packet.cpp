@@ -0,0 +1,134 @@
+#include "packet.h"
+
+#include <endian.h>
+#include <sys/random.h>
+
+namespace coop
+{
+namespace quic
+{
+
+namespace
+{
+
+bool ReadConnectionId(const uint8_t*& p, const uint8_t* end, ConnectionId* out)
+{
+    if (p == end)
+    {
+        return false;
+    }
+    size_t length = *p++;
+    if (length > MAX_CID_LENGTH || size_t(end - p) < length)
+    {
+        return false;
+    }
+    out->length = static_cast<uint8_t>(length);
+    memcpy(out->bytes, p, length);
+    p += length;
+    return true;
+}
+
+uint8_t* WriteConnectionId(uint8_t* p, ConnectionId const& cid)
+{
+    *p++ = cid.length;
+    memcpy(p, cid.bytes, cid.length);
+    return p + cid.length;
+}
+
+} // end anonymous namespace
+
+bool ParseHeader(const uint8_t* data, size_t size, size_t shortCidLength, Header* out)
+{
+    if (size == 0)
+    {
+        return false;
+    }
+    out->isLong = (data[0] & 0x80) != 0;
+    if (!out->isLong)
+    {
+        if (shortCidLength > MAX_CID_LENGTH || size < 1 + shortCidLength)
+        {
+            return false;
+        }
+        out->version = 0;
+        out->dcid.length = static_cast<uint8_t>(shortCidLength);
+        memcpy(out->dcid.bytes, data + 1, shortCidLength);
+        out->scid.length = 0;
+        return true;
+    }
+
+    if (size < 5)
+    {
+        return false;
+    }
+    uint32_t version;
+    memcpy(&version, data + 1, sizeof(version));
+    out->version = be32toh(version);
+
+    const uint8_t* p = data + 5;
+    const uint8_t* end = data + size;
+    return ReadConnectionId(p, end, &out->dcid) && ReadConnectionId(p, end, &out->scid);
+}
+
+size_t WriteVersionNegotiation(uint8_t* out, size_t cap, Header const& to,
+                               std::span<const uint32_t> versions)
+{
+    size_t size = 1 + 4 + 1 + to.scid.length + 1 + to.dcid.length + 4 * versions.size();
+    if (size > cap)
+    {
+        return 0;
+    }
+
+    // The seven bits after the form bit are unused and should vary, so middleboxes do not come to
+    // depend on them
+    //
+    uint8_t first = 0;
+    if (getrandom(&first, 1, GRND_NONBLOCK) != 1)
+    {
+        first = to.dcid.length ? to.dcid.bytes[0] : 0;
+    }
+    uint8_t* p = out;
+    *p++ = 0x80 | first;
+    memset(p, 0, 4);
+    p += 4;
+
+    // The IDs come back swapped: the client's source ID is our destination
+    //
+    p = WriteConnectionId(p, to.scid);
+    p = WriteConnectionId(p, to.dcid);
+    for (uint32_t version : versions)
+    {
+        uint32_t be = htobe32(version);
+        memcpy(p, &be, sizeof(be));
+        p += sizeof(be);
+    }
+    return size;
+}
+
+bool NewConnectionId(size_t length, uint32_t index, uint32_t count, ConnectionId* out)
+{
+    if (length == 0 || length > MAX_CID_LENGTH || count == 0 || count > 256 || index >= count)
+    {
+        return false;
+    }
+    out->length = static_cast<uint8_t>(length);
+    size_t got = 0;
+    while (got < length)
+    {
+        ssize_t n = getrandom(out->bytes + got, length - got, 0);
+        if (n <= 0)
+        {
+            return false;
+        }
+        got += size_t(n);
+    }
+
+    // Keep what randomness the first byte can carry: any of index, index + count, ... up to 255
+    //
+    uint32_t choices = (255 - index) / count + 1;
+    out->bytes[0] = static_cast<uint8_t>(index + count * (out->bytes[0] % choices));
+    return true;
+}
+
+} // end namespace coop::quic
+} // end namespace coop
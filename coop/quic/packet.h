@@ -0,0 +1,115 @@
+#pragma once
+
+// The version-independent face of a QUIC packet (RFC 8999): enough of the header to route a
+// datagram to its connection, and to answer a version this endpoint does not speak, without
+// knowing anything version-specific or holding a key.
+//
+// Long header (handshakes):            Short header (1-RTT, everything after):
+//
+//    0  u8   1xxxxxxx                     0  u8   0xxxxxxx
+//    1  u32  version                      1  ...  destination CID, of the length the
+//    5  u8   dcid length                          receiver issued -- not on the wire
+//    6  ...  destination CID
+//    .  u8   scid length
+//    .  ...  source CID
+//    .  ...  version-specific
+//
+// A short header does not carry its connection ID's length, which is why the endpoint routing
+// them chooses the IDs: every one it issues is the same length, and its first byte names the
+// socket -- and so the cooperator -- the connection lives on (see endpoint.h).
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+namespace coop
+{
+namespace quic
+{
+
+inline constexpr uint32_t VERSION_NEGOTIATION = 0;
+inline constexpr uint32_t VERSION_1 = 0x00000001;
+
+// QUIC v1 caps connection IDs at 20 bytes. Later versions may use up to 255; a packet naming a
+// longer one is not parsed, which RFC 9000 allows a v1 endpoint to do.
+//
+inline constexpr size_t MAX_CID_LENGTH = 20;
+
+// The smallest datagram a client's first packet may arrive in. Version Negotiation is only sent
+// in reply to one at least this big, so it can never amplify a spoofed source.
+//
+inline constexpr size_t MIN_INITIAL_DATAGRAM = 1200;
+
+struct ConnectionId
+{
+    uint8_t length = 0;
+    uint8_t bytes[MAX_CID_LENGTH] = {};
+
+    std::string_view View() const
+    {
+        return std::string_view(reinterpret_cast<const char*>(bytes), length);
+    }
+
+    bool operator==(ConnectionId const& other) const
+    {
+        return length == other.length && memcmp(bytes, other.bytes, length) == 0;
+    }
+};
+
+struct Header
+{
+    bool            isLong = false;
+    uint32_t        version = 0;        // long headers only
+    ConnectionId    dcid;
+    ConnectionId    scid;               // long headers only
+};
+
+// Parse the invariant header at the front of a datagram. shortCidLength is the length of the
+// connection IDs this endpoint issues, which short headers carry without saying. False for a
+// datagram too short for its header or naming a connection ID past MAX_CID_LENGTH.
+//
+bool ParseHeader(const uint8_t* data, size_t size, size_t shortCidLength, Header* out);
+
+// Write a Version Negotiation packet answering a long header, listing versions. Returns its
+// length, or 0 if it does not fit in cap.
+//
+size_t WriteVersionNegotiation(uint8_t* out, size_t cap, Header const& to,
+                               std::span<const uint32_t> versions);
+
+// Whether a long-header packet of this version should be answered with Version Negotiation:
+// neither a version listed, nor a Version Negotiation packet itself
+//
+inline bool NeedsVersionNegotiation(Header const& header, std::span<const uint32_t> versions)
+{
+    if (!header.isLong || header.version == VERSION_NEGOTIATION)
+    {
+        return false;
+    }
+    for (uint32_t version : versions)
+    {
+        if (version == header.version)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The socket in a group of count a connection ID routes to: its first byte, modulo count. This
+// is the arithmetic the steering program in endpoint.cpp does in the kernel.
+//
+inline uint32_t SteeringIndex(ConnectionId const& cid, uint32_t count)
+{
+    return cid.length == 0 ? 0 : cid.bytes[0] % count;
+}
+
+// A fresh, random connection ID of length bytes whose SteeringIndex in a group of count is
+// index. Returns false if length is zero or past MAX_CID_LENGTH, or count exceeds 256.
+//
+bool NewConnectionId(size_t length, uint32_t index, uint32_t count, ConnectionId* out);
+
+} // end namespace coop::quic
+} // end namespace coop
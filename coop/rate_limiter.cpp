@@ -0,0 +1,347 @@
+#include "rate_limiter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+
+#include "context.h"
+#include "coordinate_with.h"
+#include "cooperator_group.h"
+#include "shared_stack.h"
+#include "time/now.h"
+#include "time/sleep.h"
+
+namespace coop
+{
+
+namespace
+{
+
+static constexpr uint64_t NS_PER_SECOND = 1000000000;
+static constexpr uint64_t MAX_RATE = 1000000000;
+
+// Nanoseconds the pool takes to earn n tokens, rounded up so a take never costs less than it
+// should
+//
+int64_t Cost(uint64_t n, uint64_t rate)
+{
+    return static_cast<int64_t>((n / rate) * NS_PER_SECOND
+                              + ((n % rate) * NS_PER_SECOND + rate - 1) / rate);
+}
+
+} // end anonymous namespace
+
+RateLimiter::RateLimiter(CooperatorGroup& group, RateLimiterConfiguration const& config /* = {} */)
+{
+    std::vector<Cooperator*> owners;
+    for (int i = 0; i < group.Size(); i++)
+    {
+        owners.push_back(group.At(i));
+    }
+    Init(owners, config);
+}
+
+RateLimiter::RateLimiter(std::vector<Cooperator*> const& owners,
+                         RateLimiterConfiguration const& config /* = {} */)
+{
+    Init(owners, config);
+}
+
+RateLimiter::~RateLimiter()
+{
+    for (size_t i = 0; i < m_count; i++)
+    {
+        assert((m_leases[i].waiters.IsEmpty() || detail::CooperatorIsShuttingDown())
+               && "rate limiter destroyed with waiters still queued");
+    }
+}
+
+void RateLimiter::Init(std::vector<Cooperator*> const& owners,
+                       RateLimiterConfiguration const& config)
+{
+    m_rate = std::clamp<uint64_t>(config.rate, 1, MAX_RATE);
+    m_burst = std::clamp<uint64_t>(config.burst, 1, MAX_RATE);
+    m_burstNs = Cost(m_burst, m_rate);
+
+    m_count = owners.size();
+    m_owners.reset(new Cooperator*[m_count]);
+    m_leases.reset(new Lease[m_count]);
+    for (size_t i = 0; i < m_count; i++)
+    {
+        m_owners[i] = owners[i];
+        m_leases[i].owner = owners[i];
+    }
+
+    m_lease = config.lease
+        ? std::min(config.lease, m_burst)
+        : std::max<uint64_t>(1, m_burst / (4 * std::max<size_t>(m_count, 1)));
+}
+
+bool RateLimiter::TryAcquireSlow(Lease* lease, uint64_t n)
+{
+    if (!lease)
+    {
+        if (n <= m_burst && Take(n, n) == n)
+        {
+            m_poolAdmitted.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        m_poolRefused.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (lease->waiting == 0 && n <= m_burst)
+    {
+        Refill(*lease, n);
+        if (lease->tokens >= n)
+        {
+            lease->tokens -= n;
+            Bump(lease->admitted);
+            return true;
+        }
+    }
+    Bump(lease->refused);
+    return false;
+}
+
+int RateLimiter::Acquire(Context* ctx, uint64_t n, time::Interval timeout)
+{
+    int64_t deadlineUs = time::MonotonicMicros() + std::max<int64_t>(timeout.count(), 0);
+    return AcquireUntil(ctx, n, deadlineUs);
+}
+
+int RateLimiter::Acquire(Context* ctx, uint64_t n /* = 1 */)
+{
+    return AcquireUntil(ctx, n, 0);
+}
+
+// Queue behind this cooperator's waiters. The head leads: it refills the lease for the whole
+// line, parking between refills for as long as the pool needs to earn the head's tokens; the
+// others park until granted or made the head. Each park is a timed wait on the waiter's own
+// coordinator, which Grant and Leave release early.
+//
+int RateLimiter::AcquireUntil(Context* ctx, uint64_t n, int64_t deadlineUs)
+{
+    if (ctx->IsKilled())
+    {
+        return -ECANCELED;
+    }
+    if (n > m_burst)
+    {
+        return -EINVAL;
+    }
+    Lease* lease = Local();
+    if (!lease)
+    {
+        return AcquireFromPool(ctx, n, deadlineUs);
+    }
+    if (lease->waiting == 0)
+    {
+        if (lease->tokens < n)
+        {
+            Refill(*lease, n);
+        }
+        if (lease->tokens >= n)
+        {
+            lease->tokens -= n;
+            Bump(lease->admitted);
+            return 0;
+        }
+    }
+
+    detail::WaitStorage<Waiter> stored(ctx, ctx, n);
+    Waiter& waiter = *stored.Get();
+    lease->waiters.Push(&waiter);
+    lease->waiting++;
+    if (!lease->leader)
+    {
+        lease->leader = &waiter;
+    }
+
+    int result = 0;
+    for (;;)
+    {
+        if (waiter.granted)
+        {
+            Bump(lease->admitted);
+            return 0;
+        }
+
+        int64_t now = time::MonotonicMicros();
+        int64_t parkUs;
+        if (lease->leader == &waiter)
+        {
+            Refill(*lease, n);
+            Grant(*lease);
+            if (waiter.granted)
+            {
+                continue;
+            }
+            parkUs = std::max<int64_t>(WaitFor(n - lease->tokens), 1);
+            if (deadlineUs && now + parkUs > deadlineUs)
+            {
+                result = -ETIMEDOUT;
+                break;
+            }
+        }
+        else if (deadlineUs)
+        {
+            if (now >= deadlineUs)
+            {
+                result = -ETIMEDOUT;
+                break;
+            }
+            parkUs = deadlineUs - now;
+        }
+        else
+        {
+            parkUs = 0;
+        }
+
+        auto r = parkUs > 0 ? CoordinateWithKill(ctx, &waiter.coord, time::Interval(parkUs))
+                            : CoordinateWithKill(ctx, &waiter.coord);
+        if (!r.Killed() && !r.TimedOut())
+        {
+            waiter.signaled = false;
+        }
+        if (r.Killed() && !waiter.granted)
+        {
+            result = -ECANCELED;
+            break;
+        }
+    }
+
+    Leave(*lease, waiter);
+    Bump(lease->refused);
+    return result;
+}
+
+int RateLimiter::AcquireFromPool(Context* ctx, uint64_t n, int64_t deadlineUs)
+{
+    for (;;)
+    {
+        if (Take(n, n) == n)
+        {
+            m_poolAdmitted.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        }
+        int64_t waitUs = std::max<int64_t>(WaitFor(n), 1);
+        if (deadlineUs && time::MonotonicMicros() + waitUs > deadlineUs)
+        {
+            m_poolRefused.fetch_add(1, std::memory_order_relaxed);
+            return -ETIMEDOUT;
+        }
+        if (time::Sleep(ctx, time::Interval(waitUs)) == time::SleepResult::Killed)
+        {
+            m_poolRefused.fetch_add(1, std::memory_order_relaxed);
+            return -ECANCELED;
+        }
+    }
+}
+
+// The clock may lag now by up to the burst; the lag, in tokens, is what there is to take
+//
+uint64_t RateLimiter::Take(uint64_t least, uint64_t most)
+{
+    int64_t now = time::MonotonicNanos();
+    int64_t tat = m_tat.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        int64_t base = std::max(tat, now - m_burstNs);
+        if (base >= now)
+        {
+            return 0;
+        }
+        uint64_t available = static_cast<uint64_t>(now - base) * m_rate / NS_PER_SECOND;
+        if (available < least || available == 0)
+        {
+            return 0;
+        }
+        uint64_t take = std::min(available, most);
+        if (m_tat.compare_exchange_weak(tat, base + Cost(take, m_rate), std::memory_order_acq_rel,
+                                        std::memory_order_relaxed))
+        {
+            return take;
+        }
+    }
+}
+
+int64_t RateLimiter::WaitFor(uint64_t n) const
+{
+    int64_t now = time::MonotonicNanos();
+    int64_t base = std::max(m_tat.load(std::memory_order_relaxed), now - m_burstNs);
+    int64_t ready = base + Cost(n, m_rate);
+    return ready > now ? (ready - now + 999) / 1000 : 0;
+}
+
+// Top the lease up to need, taking at least a lease's worth while the pool has it
+//
+void RateLimiter::Refill(Lease& lease, uint64_t need)
+{
+    uint64_t want = need > lease.tokens ? need - lease.tokens : 0;
+    uint64_t got = Take(1, std::max(m_lease, want));
+    if (got > 0)
+    {
+        lease.tokens += got;
+        Bump(lease.leases);
+    }
+}
+
+// Hand tokens down the line in order, then make sure whoever is at the head is leading
+//
+void RateLimiter::Grant(Lease& lease)
+{
+    while (!lease.waiters.IsEmpty() && lease.waiters.Peek()->want <= lease.tokens)
+    {
+        Waiter* waiter = lease.waiters.Pop();
+        lease.waiting--;
+        lease.tokens -= waiter->want;
+        waiter->granted = true;
+        if (lease.leader == waiter)
+        {
+            lease.leader = nullptr;
+        }
+        Signal(*waiter);
+    }
+    if (!lease.leader && !lease.waiters.IsEmpty())
+    {
+        lease.leader = lease.waiters.Peek();
+        Signal(*lease.leader);
+    }
+}
+
+void RateLimiter::Leave(Lease& lease, Waiter& waiter)
+{
+    lease.waiters.Remove(&waiter);
+    lease.waiting--;
+    if (lease.leader == &waiter)
+    {
+        lease.leader = nullptr;
+    }
+    Grant(lease);
+}
+
+void RateLimiter::Signal(Waiter& waiter)
+{
+    if (!waiter.signaled)
+    {
+        waiter.signaled = true;
+        waiter.coord.Release(nullptr, false);
+    }
+}
+
+RateLimiter::Stats RateLimiter::GetStats() const
+{
+    Stats stats{};
+    stats.admitted = m_poolAdmitted.load(std::memory_order_relaxed);
+    stats.refused = m_poolRefused.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < m_count; i++)
+    {
+        stats.admitted += m_leases[i].admitted.load(std::memory_order_relaxed);
+        stats.refused += m_leases[i].refused.load(std::memory_order_relaxed);
+        stats.leases += m_leases[i].leases.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+} // end namespace coop
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "coordinator.h"
+#include "cooperator.h"
+#include "detail/embedded_list.h"
+#include "time/interval.h"
+
+namespace coop
+{
+
+struct Context;
+struct CooperatorGroup;
+
+struct RateLimiterConfiguration
+{
+    // Tokens per second, across the process
+    //
+    uint64_t rate = 1000;
+
+    // Most tokens the pool saves up while unused: what a limiter idle for a while lets through at
+    // once. Both are capped at a billion.
+    //
+    uint64_t burst = 1000;
+
+    // Tokens a cooperator takes from the pool each time its own run out -- the accuracy knob.
+    // Bigger leases go to the shared pool less often; smaller ones keep the limit tighter, since
+    // up to a lease's worth can sit unspent on each cooperator while another is refused. Zero
+    // picks burst / (4 * owners), at least one.
+    //
+    uint64_t lease = 0;
+};
+
+// RateLimiter is a token bucket shared by a set of cooperators, with the bucket split so its hot
+// path touches nothing shared.
+//
+//  coop::RateLimiter limiter(group, {.rate = 50000, .burst = 5000});
+//
+//  if (!limiter.TryAcquire()) { Reject(429); }                 // from any owner's context
+//  if (limiter.Acquire(ctx, 1, std::chrono::milliseconds(20)) < 0) { ... }
+//
+// The tokens live in one global pool, kept as a GCRA clock in a single atomic: a take moves the
+// pool's theoretical arrival time forward by the tokens' cost, and whatever the clock lags the
+// real one by -- up to burst -- is what is available. No one spends from it directly. Each
+// owner cooperator holds a lease of tokens, its own, and an acquire on an owner is a compare and
+// a subtraction on the lease: no atomic, no shared cacheline. Only when the lease runs dry does
+// the owner go to the pool, and it takes a lease's worth at once, so the pool sees one
+// compare-and-swap per lease rather than one per request.
+//
+// The limit errs one way only. Every token spent came out of the pool, so the process never
+// admits more than rate per second beyond the burst. Tokens leased to a quiet cooperator are out
+// of the pool until it spends them, so the others can be refused early by at most a lease per
+// owner -- choose the lease against how tight that must be.
+//
+// Acquire blocks until the tokens are there. Waiters on a cooperator queue in arrival order,
+// like Semaphore's: a TryAcquire does not overtake them. Each parks on a Coordinator of its own.
+// The head of the line leads: it parks only until the pool should have earned what it needs,
+// then takes it and hands tokens down the line, so one context per cooperator watches the pool
+// however many wait. The rest park with their timeouts until granted or made the head. A wait
+// that could only end after its timeout fails at once with -ETIMEDOUT instead of sitting it out.
+//
+// Called on a cooperator that is not an owner, the limiter spends from the pool directly:
+// correct, but one atomic per call and no queueing. The owners must outlive the limiter, and it
+// must not be destroyed with contexts waiting.
+//
+struct RateLimiter
+{
+    RateLimiter(RateLimiter const&) = delete;
+    RateLimiter(RateLimiter&&) = delete;
+
+    RateLimiter(CooperatorGroup& group, RateLimiterConfiguration const& config = {});
+    RateLimiter(std::vector<Cooperator*> const& owners,
+                RateLimiterConfiguration const& config = {});
+    ~RateLimiter();
+
+    // Spend n tokens if they are there and no one on this cooperator is waiting ahead
+    //
+    bool TryAcquire(uint64_t n = 1)
+    {
+        Lease* lease = Local();
+        if (lease && lease->tokens >= n && lease->waiting == 0)
+        {
+            lease->tokens -= n;
+            Bump(lease->admitted);
+            return true;
+        }
+        return TryAcquireSlow(lease, n);
+    }
+
+    // Block until n tokens are spent. Returns 0, -ETIMEDOUT when they cannot be had within
+    // timeout, -ECANCELED if ctx is killed, or -EINVAL for n past burst, which can never be had.
+    //
+    int Acquire(Context* ctx, uint64_t n, time::Interval timeout);
+    int Acquire(Context* ctx, uint64_t n = 1);
+
+    struct Stats
+    {
+        uint64_t admitted;      // acquires that spent their tokens
+        uint64_t refused;       // acquires that did not
+        uint64_t leases;        // trips to the pool that brought tokens back
+    };
+
+    Stats GetStats() const;
+
+    uint64_t LeaseSize() const { return m_lease; }
+
+  private:
+    struct Waiter : EmbeddedListHookups<Waiter>
+    {
+        Waiter(Context* ctx, uint64_t n) : coord(ctx), want(n) {}
+
+        Coordinator     coord;              // held until granted, or made the head of the line
+        uint64_t        want;
+        bool            granted = false;
+        bool            signaled = false;   // coord released and not yet waited out
+    };
+
+    // One owner's tokens and line, on a cacheline of its own: only the owner writes it
+    //
+    struct alignas(64) Lease
+    {
+        Cooperator*             owner = nullptr;
+        uint64_t                tokens = 0;
+        size_t                  waiting = 0;
+        EmbeddedList<Waiter>    waiters;
+        Waiter*                 leader = nullptr;   // the head, refilling for the line
+
+        std::atomic<uint64_t>   admitted{0};
+        std::atomic<uint64_t>   refused{0};
+        std::atomic<uint64_t>   leases{0};
+    };
+
+    // The owner's lease scan. Owners are few and their pointers packed, so this is a handful of
+    // compares in one or two cachelines.
+    //
+    Lease* Local()
+    {
+        Cooperator* self = Cooperator::thread_cooperator;
+        for (size_t i = 0; i < m_count; i++)
+        {
+            if (m_owners[i] == self)
+            {
+                return &m_leases[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Owner-only counters: a plain load and store, which a concurrent GetStats may read stale
+    //
+    static void Bump(std::atomic<uint64_t>& counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void Init(std::vector<Cooperator*> const& owners, RateLimiterConfiguration const& config);
+
+    bool TryAcquireSlow(Lease* lease, uint64_t n);
+    int AcquireUntil(Context* ctx, uint64_t n, int64_t deadlineUs);
+    int AcquireFromPool(Context* ctx, uint64_t n, int64_t deadlineUs);
+
+    // Take between least and most tokens from the pool, as many as are there; zero if fewer than
+    // least are
+    //
+    uint64_t Take(uint64_t least, uint64_t most);
+
+    // Microseconds until the pool should hold n tokens, zero if it does now
+    //
+    int64_t WaitFor(uint64_t n) const;
+
+    void Refill(Lease& lease, uint64_t need);
+    void Grant(Lease& lease);
+    void Leave(Lease& lease, Waiter& waiter);
+    void Signal(Waiter& waiter);
+
+    uint64_t                    m_rate;
+    uint64_t                    m_burst;
+    uint64_t                    m_lease;
+    int64_t                     m_burstNs;
+
+    size_t                          m_count = 0;
+    std::unique_ptr<Cooperator*[]>  m_owners;
+    std::unique_ptr<Lease[]>        m_leases;
+
+    // The pool's theoretical arrival time in monotonic nanoseconds, and what non-owners spent
+    // from it directly
+    //
+    alignas(64) std::atomic<int64_t> m_tat{0};
+    std::atomic<uint64_t>           m_poolAdmitted{0};
+    std::atomic<uint64_t>           m_poolRefused{0};
+};
+
+} // end namespace coop
@@ -0,0 +1,149 @@
+#include "remote_coordinator.h"
+
+#include <cassert>
+
+#include "cooperator.h"
+#include "cooperator.hpp"
+
+namespace coop
+{
+
+RemoteCoordinator::Waiter::Waiter(Context* ctx)
+: coord(ctx)
+, home(ctx->GetCooperator())
+{
+    deliver = &Deliver;
+    undelivered = &Undelivered;
+}
+
+RemoteCoordinator::~RemoteCoordinator()
+{
+    assert((m_waiters.IsEmpty() || detail::CooperatorIsShuttingDown())
+           && "remote coordinator destroyed with waiters still queued");
+}
+
+bool RemoteCoordinator::Enqueue(Waiter* waiter)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    // Setting WAITERS under the lock is what sends the holder's Release down the slow path; if
+    // the holder released first, the CAS fails and we find it free
+    //
+    uint32_t state = m_state.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        if (!(state & LOCKED))
+        {
+            if (m_state.compare_exchange_weak(state, state | LOCKED, std::memory_order_acquire,
+                                              std::memory_order_relaxed))
+            {
+                return false;
+            }
+        }
+        else if ((state & WAITERS) ||
+                 m_state.compare_exchange_weak(state, state | WAITERS, std::memory_order_relaxed,
+                                               std::memory_order_relaxed))
+        {
+            break;
+        }
+    }
+
+    m_waiters.Push(waiter);
+    return true;
+}
+
+// ReleaseToNext marks a waiter granted under the lock before waking it, so a waiter found
+// granted holds the coordinator however its wait ended. One that lost -- to the kill signal, a
+// timeout or another coordinator -- still has a wake on its way, addressed to its own
+// coordinator: it waits for that to land, then gives the coordinator back.
+//
+CoordinationResult RemoteCoordinator::Settle(Waiter& waiter, CoordinationResult result)
+{
+    if (result.index != 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (!waiter.granted)
+            {
+                m_waiters.Remove(&waiter);
+                if (m_waiters.IsEmpty())
+                {
+                    m_state.fetch_and(~WAITERS, std::memory_order_relaxed);
+                }
+                return result;
+            }
+        }
+        waiter.coord.Acquire(Self());
+        Release();
+        return result;
+    }
+
+    // The releaser's writes were published by its store of m_state; pair with it before touching
+    // what the coordinator guards
+    //
+    (void)m_state.load(std::memory_order_acquire);
+    return CoordinationResult{0, nullptr};
+}
+
+// The holder is handing over: the state stays LOCKED, now on the next waiter's behalf
+//
+void RemoteCoordinator::ReleaseToNext()
+{
+    Waiter* next;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        next = m_waiters.Pop();
+        if (!next)
+        {
+            m_state.store(0, std::memory_order_release);
+            return;
+        }
+        next->granted = true;
+        m_state.store(m_waiters.IsEmpty() ? LOCKED : LOCKED | WAITERS, std::memory_order_release);
+    }
+    Wake(next);
+}
+
+void RemoteCoordinator::Wake(Waiter* waiter)
+{
+    auto* self = Cooperator::thread_cooperator;
+    if (self == waiter->home)
+    {
+        waiter->coord.Release(nullptr, false);
+        return;
+    }
+    if (self && waiter->home->PostMessage(waiter))
+    {
+        return;
+    }
+
+    auto wakeFn = [waiter](Context*)
+    {
+        waiter->coord.Release(nullptr, false);
+    };
+    bool submitted = self
+        ? waiter->home->Cooperate(std::move(wakeFn))
+        : waiter->home->Submit(std::move(wakeFn));
+
+    // Only a cooperator shutting down refuses; its teardown abandons the blocked waiter
+    //
+    (void)submitted;
+}
+
+void RemoteCoordinator::Deliver(detail::RingMessage* message)
+{
+    static_cast<Waiter*>(message)->coord.Release(nullptr, false);
+}
+
+// The kernel refused the post (on the releaser's cooperator): hand the wake over as a submission
+//
+void RemoteCoordinator::Undelivered(detail::RingMessage* message)
+{
+    auto* waiter = static_cast<Waiter*>(message);
+    waiter->home->Cooperate([waiter](Context*)
+    {
+        waiter->coord.Release(nullptr, false);
+    });
+}
+
+} // end namespace coop
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "context.h"
+#include "coordinate_with.h"
+#include "coordination_result.h"
+#include "coordinator.h"
+#include "detail/embedded_list.h"
+#include "detail/ring_message.h"
+#include "shared_stack.h"
+
+namespace coop
+{
+
+struct Cooperator;
+
+// RemoteCoordinator is a mutex for contexts on different cooperators. A Coordinator belongs to
+// one cooperator, so a structure several cooperators share (a global registry, a process-wide
+// cache) otherwise needs a std::mutex -- which stalls the whole thread, every context on it --
+// or has to be owned by one cooperator and reached through a Passage.
+//
+//  coop::RemoteCoordinator registry;                  // shared by every cooperator
+//
+//  registry.Acquire(ctx);                             // blocks only ctx
+//  ...
+//  registry.Release();
+//
+// Uncontended, Acquire and Release are one compare-and-swap each. A context that finds it held
+// queues a waiter under a short internal lock and blocks on a Coordinator of its own cooperator.
+// Release hands ownership straight to the longest waiter and wakes it through that waiter's
+// cooperator: inline when the releaser runs there, as a ring message (IORING_OP_MSG_RING) from
+// another cooperator, or as a submission from a plain thread. A woken waiter already holds it,
+// so nothing can barge in between the wake and the resume.
+//
+// AcquireWith and AcquireWithKill wait as CoordinateWith and CoordinateWithKill do, taking the
+// same extra arguments after the coordinator, which is index 0 of the result. Index 0 means it
+// is held (the result carries no coordinator for it); any other index or sentinel means not.
+//
+// TryAcquire and Release may be called from any thread; the blocking forms need a context.
+//
+struct RemoteCoordinator
+{
+    RemoteCoordinator(RemoteCoordinator const&) = delete;
+    RemoteCoordinator(RemoteCoordinator&&) = delete;
+
+    RemoteCoordinator() = default;
+
+    // Waiters would be left parked on a wait list that no longer exists
+    //
+    ~RemoteCoordinator();
+
+    bool TryAcquire()
+    {
+        uint32_t expected = 0;
+        return m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire,
+                                               std::memory_order_relaxed);
+    }
+
+    void Acquire(Context* ctx)
+    {
+        AcquireWith(ctx);
+    }
+
+    template<typename... Args>
+    CoordinationResult AcquireWith(Context* ctx, Args... args);
+
+    template<typename... Args>
+    CoordinationResult AcquireWithKill(Context* ctx, Args... args);
+
+    void Release()
+    {
+        uint32_t expected = LOCKED;
+        if (!m_state.compare_exchange_strong(expected, 0, std::memory_order_release,
+                                             std::memory_order_relaxed))
+        {
+            ReleaseToNext();
+        }
+    }
+
+    // A snapshot: another cooperator may take or release it at any moment
+    //
+    bool IsHeld() const
+    {
+        return (m_state.load(std::memory_order_relaxed) & LOCKED) != 0;
+    }
+
+  private:
+    static constexpr uint32_t LOCKED  = 1;
+    static constexpr uint32_t WAITERS = 2;         // m_waiters is non-empty
+
+    // A blocked context's place in line. Its coordinator lives on the waiter's cooperator and is
+    // released there by the wake, so the waiter blocks and resumes like any local wait.
+    //
+    struct Waiter : EmbeddedListHookups<Waiter>, detail::RingMessage
+    {
+        explicit Waiter(Context* ctx);
+
+        Coordinator     coord;              // held until the wake lands
+        Cooperator*     home;
+        bool            granted = false;    // under m_lock
+    };
+
+    // Queue waiter, or take the coordinator if it came free meanwhile (false)
+    //
+    bool Enqueue(Waiter* waiter);
+    CoordinationResult Settle(Waiter& waiter, CoordinationResult result);
+    void ReleaseToNext();
+
+    static void Wake(Waiter* waiter);
+    static void Deliver(detail::RingMessage* message);
+    static void Undelivered(detail::RingMessage* message);
+
+    alignas(64) std::atomic<uint32_t>   m_state{0};
+    std::mutex                          m_lock;
+    EmbeddedList<Waiter>                m_waiters;
+};
+
+template<typename... Args>
+CoordinationResult RemoteCoordinator::AcquireWith(Context* ctx, Args... args)
+{
+    if (TryAcquire())
+    {
+        return CoordinationResult{0, nullptr};
+    }
+
+    detail::WaitStorage<Waiter> stored(ctx, ctx);
+    Waiter& waiter = *stored.Get();
+    if (!Enqueue(&waiter))
+    {
+        return CoordinationResult{0, nullptr};
+    }
+    return Settle(waiter, CoordinateWith(ctx, &waiter.coord, args...));
+}
+
+template<typename... Args>
+CoordinationResult RemoteCoordinator::AcquireWithKill(Context* ctx, Args... args)
+{
+    if (ctx->IsKilled())
+    {
+        return CoordinationResult{static_cast<size_t>(-1), nullptr};
+    }
+    if (TryAcquire())
+    {
+        return CoordinationResult{0, nullptr};
+    }
+
+    detail::WaitStorage<Waiter> stored(ctx, ctx);
+    Waiter& waiter = *stored.Get();
+    if (!Enqueue(&waiter))
+    {
+        return CoordinationResult{0, nullptr};
+    }
+    return Settle(waiter, CoordinateWithKill(ctx, &waiter.coord, args...));
+}
+
+} // end namespace coop
@@ -0,0 +1,238 @@
+#include "protocol.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace coop
+{
+namespace resp
+{
+
+namespace
+{
+
+// Lengths and counts are short lines; anything longer is malformed
+//
+static constexpr size_t MAX_NUMBER_LINE = 32;
+
+// The CR of the CRLF ending the line at p, or null when the line is not all there. A line that
+// runs past limit without one is an error: *tooLong.
+//
+const char* LineEnd(const char* p, const char* end, size_t limit, bool* tooLong)
+{
+    size_t span = static_cast<size_t>(end - p);
+    auto* cr = static_cast<const char*>(memchr(p, '\r', span < limit ? span : limit));
+    if (!cr)
+    {
+        *tooLong = span >= limit;
+        return nullptr;
+    }
+    if (cr + 1 == end)
+    {
+        return nullptr;
+    }
+    if (cr[1] != '\n')
+    {
+        *tooLong = true;
+        return nullptr;
+    }
+    return cr;
+}
+
+// A decimal line's value, or -2 when it is not one
+//
+int64_t ParseLength(const char* p, const char* cr)
+{
+    int64_t n = 0;
+    auto [at, ec] = std::from_chars(p, cr, n);
+    if (ec != std::errc() || at != cr)
+    {
+        return -2;
+    }
+    return n;
+}
+
+ptrdiff_t ParseInline(const char* data, size_t size, Command* command, const char** error)
+{
+    // Terminals may end a line with a bare LF
+    //
+    size_t span = size < MAX_INLINE ? size : MAX_INLINE;
+    auto* lf = static_cast<const char*>(memchr(data, '\n', span));
+    if (!lf)
+    {
+        if (size >= MAX_INLINE)
+        {
+            *error = "Protocol error: too big inline request";
+            return -1;
+        }
+        return 0;
+    }
+    const char* line = lf > data && lf[-1] == '\r' ? lf - 1 : lf;
+
+    for (const char* p = data; p < line;)
+    {
+        while (p < line && (*p == ' ' || *p == '\t')) p++;
+        const char* word = p;
+        while (p < line && *p != ' ' && *p != '\t') p++;
+        if (p > word)
+        {
+            command->args.emplace_back(word, static_cast<size_t>(p - word));
+        }
+    }
+    return lf + 1 - data;
+}
+
+void AppendPrefixed(std::string* out, char prefix, int64_t n)
+{
+    char buf[24];
+    buf[0] = prefix;
+    auto [at, ec] = std::to_chars(buf + 1, buf + sizeof(buf) - 2, n);
+    (void)ec;
+    at[0] = '\r';
+    at[1] = '\n';
+    out->append(buf, static_cast<size_t>(at + 2 - buf));
+}
+
+} // end anonymous namespace
+
+bool Command::Is(std::string_view name) const
+{
+    if (args.empty() || args[0].size() != name.size())
+    {
+        return false;
+    }
+    std::string_view arg = args[0];
+    for (size_t i = 0; i < name.size(); i++)
+    {
+        char c = arg[i];
+        if (c >= 'a' && c <= 'z')
+        {
+            c = static_cast<char>(c - ('a' - 'A'));
+        }
+        if (c != name[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+ptrdiff_t ParseCommand(const char* data, size_t size, Command* command, const char** error)
+{
+    command->args.clear();
+    if (size == 0)
+    {
+        return 0;
+    }
+    if (data[0] != '*')
+    {
+        return ParseInline(data, size, command, error);
+    }
+
+    // *<count>\r\n, then count times $<length>\r\n<bytes>\r\n
+    //
+    const char* end = data + size;
+    bool bad = false;
+    const char* cr = LineEnd(data + 1, end, MAX_NUMBER_LINE, &bad);
+    if (!cr)
+    {
+        if (bad)
+        {
+            *error = "Protocol error: invalid multibulk length";
+            return -1;
+        }
+        return 0;
+    }
+    int64_t count = ParseLength(data + 1, cr);
+    if (count < -1 || count > int64_t(MAX_ARGS))
+    {
+        *error = "Protocol error: invalid multibulk length";
+        return -1;
+    }
+    const char* p = cr + 2;
+    if (count <= 0)
+    {
+        return p - data;
+    }
+
+    for (int64_t i = 0; i < count; i++)
+    {
+        if (p == end)
+        {
+            return 0;
+        }
+        if (*p != '$')
+        {
+            *error = "Protocol error: expected '$'";
+            return -1;
+        }
+        cr = LineEnd(p + 1, end, MAX_NUMBER_LINE, &bad);
+        if (!cr)
+        {
+            if (bad)
+            {
+                *error = "Protocol error: invalid bulk length";
+                return -1;
+            }
+            return 0;
+        }
+        int64_t length = ParseLength(p + 1, cr);
+        if (length < 0 || length > int64_t(MAX_BULK))
+        {
+            *error = "Protocol error: invalid bulk length";
+            return -1;
+        }
+        p = cr + 2;
+        if (size_t(end - p) < size_t(length) + 2)
+        {
+            return 0;
+        }
+        if (p[length] != '\r' || p[length + 1] != '\n')
+        {
+            *error = "Protocol error: bulk not terminated by CRLF";
+            return -1;
+        }
+        command->args.emplace_back(p, static_cast<size_t>(length));
+        p += length + 2;
+    }
+    return p - data;
+}
+
+void AppendSimple(std::string* out, std::string_view s)
+{
+    out->push_back('+');
+    out->append(s);
+    out->append("\r\n", 2);
+}
+
+void AppendError(std::string* out, std::string_view message)
+{
+    out->push_back('-');
+    out->append(message);
+    out->append("\r\n", 2);
+}
+
+void AppendInteger(std::string* out, int64_t n)
+{
+    AppendPrefixed(out, ':', n);
+}
+
+void AppendBulk(std::string* out, std::string_view s)
+{
+    AppendPrefixed(out, '$', static_cast<int64_t>(s.size()));
+    out->append(s);
+    out->append("\r\n", 2);
+}
+
+void AppendNull(std::string* out)
+{
+    out->append("$-1\r\n", 5);
+}
+
+void AppendArray(std::string* out, size_t count)
+{
+    AppendPrefixed(out, '*', static_cast<int64_t>(count));
+}
+
+} // end namespace coop::resp
+} // end namespace coop
@@ -0,0 +1,67 @@
+#pragma once
+
+// RESP, the Redis serialization protocol (version 2): command parsing and reply encoding.
+//
+// A client sends each command as an array of bulk strings,
+//
+//   *3\r\n$3\r\nSET\r\n$3\r\nkey\r\n$5\r\nvalue\r\n
+//
+// or, typed at a terminal, as an inline line of space-separated words ("PING\r\n"). Clients
+// pipeline: they write many commands before reading any reply, and a server that parses every
+// complete command in a read and answers them with one write serves the whole pipeline in one
+// round trip.
+//
+// ParseCommand reads one command in place: its arguments are views into the caller's buffer, with
+// nothing copied. The reply encoders append to a std::string the caller sends.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coop
+{
+namespace resp
+{
+
+// Limits on what ParseCommand accepts, as Redis's own defaults
+//
+static constexpr size_t MAX_ARGS = 1024 * 1024;
+static constexpr size_t MAX_BULK = 512 * 1024 * 1024;
+static constexpr size_t MAX_INLINE = 64 * 1024;
+
+// One command's arguments, the name first, each a view into the parsed buffer. Reused from
+// command to command, so its capacity is kept.
+//
+struct Command
+{
+    std::vector<std::string_view> args;
+
+    size_t Size() const { return args.size(); }
+    std::string_view operator[](size_t i) const { return args[i]; }
+
+    // Whether the name is `name`, which must be given in upper case
+    //
+    bool Is(std::string_view name) const;
+};
+
+// Parse the command at the start of data[0, size) into *command. Returns the bytes it took; 0 if
+// the command is not all there yet; -1 on a protocol error, with *error saying why (the
+// connection is to be answered with it and closed, as Redis does). An empty inline line parses
+// as a command of no arguments.
+//
+ptrdiff_t ParseCommand(const char* data, size_t size, Command* command, const char** error);
+
+// Reply encoders
+//
+void AppendSimple(std::string* out, std::string_view s);        // +OK
+void AppendError(std::string* out, std::string_view message);   // -ERR ...
+void AppendInteger(std::string* out, int64_t n);                // :1
+void AppendBulk(std::string* out, std::string_view s);          // $5\r\nvalue
+void AppendNull(std::string* out);                              // $-1
+void AppendArray(std::string* out, size_t count);               // *2, then count replies
+
+} // end namespace coop::resp
+} // end namespace coop
@@ -0,0 +1,477 @@
+#include "server.h"
+#include "protocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <optional>
+#include <span>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/http/transport.h"
+#include "coop/http/tls_transport.h"
+#include "coop/io/accept.h"
+#include "coop/io/descriptor.h"
+
+namespace coop
+{
+namespace resp
+{
+
+namespace
+{
+
+// Keys gathered before a run of reads is fetched regardless, bounding the batch
+//
+static constexpr size_t MAX_BATCHED_KEYS = 4096;
+
+template<typename Transport>
+struct RespConnection
+{
+    RespConnection(Context* ctx, Transport transport, Cache& cache, ServerOptions const& options)
+    : m_ctx(ctx)
+    , m_transport(transport)
+    , m_cache(cache)
+    , m_options(options)
+    , m_baseCap(std::max<size_t>(options.recvBufSize, 64))
+    , m_cap(m_baseCap)
+    , m_buf(new char[m_cap])
+    {
+    }
+
+    void Run();
+
+  private:
+    // A read whose reply waits on the batched GetMany: count keys, from the next unanswered one
+    //
+    enum class Read : uint8_t
+    {
+        GET,
+        MGET,
+        EXISTS,
+    };
+
+    struct Deferred
+    {
+        Read    kind;
+        size_t  count;
+    };
+
+    bool Execute(Command const& command);
+    void Defer(Read kind, Command const& command);
+    void Complete();
+    bool Send();
+    bool Fill();
+
+    void WrongArity(Command const& command)
+    {
+        std::string message = "ERR wrong number of arguments for '";
+        message.append(command[0].substr(0, 64));
+        message += "' command";
+        AppendError(&m_out, message);
+    }
+
+    Context*                                m_ctx;
+    Transport                               m_transport;
+    Cache&                                  m_cache;
+    ServerOptions const&                    m_options;
+
+    size_t                                  m_baseCap;
+    size_t                                  m_cap;
+    std::unique_ptr<char[]>                 m_buf;
+    size_t                                  m_len = 0;
+    size_t                                  m_pos = 0;
+
+    Command                                 m_command;
+    std::string                             m_out;
+
+    std::vector<Deferred>                   m_deferred;
+    std::vector<std::string>                m_keys;         // the first m_keyCount are in use
+    size_t                                  m_keyCount = 0;
+    std::vector<std::optional<std::string>> m_values;
+    std::string                             m_key;
+};
+
+// Parse and execute every complete command buffered, then answer them in one send and read more
+//
+template<typename Transport>
+void RespConnection<Transport>::Run()
+{
+    while (!m_ctx->IsKilled())
+    {
+        for (;;)
+        {
+            const char* error = nullptr;
+            ptrdiff_t n = ParseCommand(m_buf.get() + m_pos, m_len - m_pos, &m_command, &error);
+            if (n == 0)
+            {
+                break;
+            }
+            if (n < 0)
+            {
+                Complete();
+                AppendError(&m_out, error);
+                Send();
+                return;
+            }
+            m_pos += size_t(n);
+            if (!Execute(m_command))
+            {
+                Complete();
+                Send();
+                return;
+            }
+            if (m_keyCount >= MAX_BATCHED_KEYS || m_out.size() >= m_options.maxPendingReplies)
+            {
+                Complete();
+                if (!Send())
+                {
+                    return;
+                }
+            }
+        }
+
+        Complete();
+        if (!Send() || !Fill())
+        {
+            return;
+        }
+    }
+}
+
+// False for QUIT, its reply queued
+//
+template<typename Transport>
+bool RespConnection<Transport>::Execute(Command const& command)
+{
+    size_t args = command.Size();
+    if (args == 0)
+    {
+        return true;
+    }
+    if (command.Is("GET") && args == 2)
+    {
+        Defer(Read::GET, command);
+        return true;
+    }
+    if (command.Is("MGET") && args >= 2)
+    {
+        Defer(Read::MGET, command);
+        return true;
+    }
+    if (command.Is("EXISTS") && args >= 2)
+    {
+        Defer(Read::EXISTS, command);
+        return true;
+    }
+
+    // Everything else answers after the reads before it, and is seen by the reads after it
+    //
+    Complete();
+
+    if (command.Is("SET"))
+    {
+        if (args < 3)
+        {
+            WrongArity(command);
+        }
+        else if (args > 3)
+        {
+            AppendError(&m_out, "ERR syntax error");
+        }
+        else
+        {
+            m_cache.Put(m_ctx, std::string(command[1]), std::string(command[2]));
+            AppendSimple(&m_out, "OK");
+        }
+    }
+    else if (command.Is("DEL"))
+    {
+        if (args < 2)
+        {
+            WrongArity(command);
+            return true;
+        }
+        int64_t erased = 0;
+        for (size_t i = 1; i < args; i++)
+        {
+            m_key.assign(command[i]);
+            erased += m_cache.Erase(m_ctx, m_key);
+        }
+        AppendInteger(&m_out, erased);
+    }
+    else if (command.Is("PING"))
+    {
+        if (args == 1)
+        {
+            AppendSimple(&m_out, "PONG");
+        }
+        else if (args == 2)
+        {
+            AppendBulk(&m_out, command[1]);
+        }
+        else
+        {
+            WrongArity(command);
+        }
+    }
+    else if (command.Is("ECHO"))
+    {
+        if (args == 2)
+        {
+            AppendBulk(&m_out, command[1]);
+        }
+        else
+        {
+            WrongArity(command);
+        }
+    }
+    else if (command.Is("COMMAND"))
+    {
+        AppendArray(&m_out, 0);
+    }
+    else if (command.Is("QUIT"))
+    {
+        AppendSimple(&m_out, "OK");
+        return false;
+    }
+    else if (command.Is("GET") || command.Is("MGET") || command.Is("EXISTS"))
+    {
+        WrongArity(command);
+    }
+    else
+    {
+        std::string message = "ERR unknown command '";
+        message.append(command[0].substr(0, 64));
+        message += "'";
+        AppendError(&m_out, message);
+    }
+    return true;
+}
+
+// The command's keys are copied out, so the recv buffer may move before the run is fetched
+//
+template<typename Transport>
+void RespConnection<Transport>::Defer(Read kind, Command const& command)
+{
+    size_t count = command.Size() - 1;
+    for (size_t i = 1; i <= count; i++)
+    {
+        if (m_keyCount == m_keys.size())
+        {
+            m_keys.emplace_back();
+        }
+        m_keys[m_keyCount++].assign(command[i]);
+    }
+    m_deferred.push_back(Deferred{kind, count});
+}
+
+// Fetch the run of reads with one GetMany and queue their replies in order
+//
+template<typename Transport>
+void RespConnection<Transport>::Complete()
+{
+    if (m_deferred.empty())
+    {
+        return;
+    }
+    if (m_values.size() < m_keyCount)
+    {
+        m_values.resize(m_keyCount);
+    }
+    m_cache.GetMany(m_ctx, std::span<std::string const>(m_keys.data(), m_keyCount),
+                    m_values.data());
+
+    size_t at = 0;
+    for (Deferred const& deferred : m_deferred)
+    {
+        switch (deferred.kind)
+        {
+        case Read::MGET:
+            AppendArray(&m_out, deferred.count);
+            [[fallthrough]];
+        case Read::GET:
+            for (size_t i = 0; i < deferred.count; i++, at++)
+            {
+                if (m_values[at])
+                {
+                    AppendBulk(&m_out, *m_values[at]);
+                    m_values[at].reset();
+                }
+                else
+                {
+                    AppendNull(&m_out);
+                }
+            }
+            break;
+
+        case Read::EXISTS:
+        {
+            int64_t found = 0;
+            for (size_t i = 0; i < deferred.count; i++, at++)
+            {
+                found += m_values[at].has_value();
+                m_values[at].reset();
+            }
+            AppendInteger(&m_out, found);
+            break;
+        }
+        }
+    }
+    m_deferred.clear();
+    m_keyCount = 0;
+}
+
+template<typename Transport>
+bool RespConnection<Transport>::Send()
+{
+    if (m_out.empty())
+    {
+        return true;
+    }
+    bool ok = m_transport.SendAll(m_out.data(), m_out.size()) >= 0;
+    m_out.clear();
+    if (m_out.capacity() > 4 * m_options.maxPendingReplies)
+    {
+        std::string().swap(m_out);
+    }
+    return ok;
+}
+
+// Make room behind what is buffered and read into it. The buffer grows only for a command that
+// does not fit, and goes back to its first size once it is empty.
+//
+template<typename Transport>
+bool RespConnection<Transport>::Fill()
+{
+    if (m_pos == m_len)
+    {
+        m_pos = m_len = 0;
+        if (m_cap > m_baseCap)
+        {
+            m_cap = m_baseCap;
+            m_buf.reset(new char[m_cap]);
+        }
+    }
+    else if (m_pos > 0)
+    {
+        memmove(m_buf.get(), m_buf.get() + m_pos, m_len - m_pos);
+        m_len -= m_pos;
+        m_pos = 0;
+    }
+
+    if (m_len == m_cap)
+    {
+        if (m_cap >= m_options.maxCommandSize)
+        {
+            AppendError(&m_out, "ERR Protocol error: command too large");
+            Send();
+            return false;
+        }
+        size_t cap = std::min(m_cap * 2, std::max(m_options.maxCommandSize, m_cap));
+        std::unique_ptr<char[]> buf(new char[cap]);
+        memcpy(buf.get(), m_buf.get(), m_len);
+        m_buf = std::move(buf);
+        m_cap = cap;
+    }
+
+    int n = m_transport.Recv(m_buf.get() + m_len, m_cap - m_len, 0, m_options.idleTimeout);
+    if (n <= 0)
+    {
+        return false;
+    }
+    m_len += size_t(n);
+    return true;
+}
+
+// Bind a nonblocking listener on port. Returns the fd, or -1.
+//
+int Listen(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    int on = 1;
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = INADDR_ANY;
+
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0
+        || bind(fd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in)) != 0
+        || listen(fd, 512) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // end anonymous namespace
+
+template<typename Transport>
+void Serve(Context* ctx, Transport transport, Cache& cache,
+           ServerOptions const& options /* = {} */)
+{
+    RespConnection<Transport> conn(ctx, transport, cache, options);
+    conn.Run();
+}
+
+template void Serve<http::PlaintextTransport>(Context*, http::PlaintextTransport, Cache&,
+                                              ServerOptions const&);
+template void Serve<http::TlsTransport>(Context*, http::TlsTransport, Cache&,
+                                        ServerOptions const&);
+
+void RunServer(Context* ctx, int port, Cache& cache, ServerOptions const& options /* = {} */,
+               const char* name /* = "RespServer" */)
+{
+    ctx->SetName(name);
+
+    int listenFd = Listen(port);
+    if (listenFd < 0)
+    {
+        spdlog::error("resp server listen port={} failed: {}", port, strerror(errno));
+        return;
+    }
+    io::Descriptor listener(listenFd);
+
+    SpawnConfiguration config = {.priority = ctx->GetPriority(),
+                                 .stackSize = options.connectionStackSize};
+    while (!ctx->IsKilled())
+    {
+        int fd = io::AcceptKill(listener);
+        if (fd < 0)
+        {
+            break;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        bool ok = ctx->GetCooperator()->Spawn(config, [fd, &cache, options](Context* conn)
+        {
+            conn->SetName("RespConnection");
+            io::Descriptor desc(fd);
+            Serve(conn, http::PlaintextTransport(desc), cache, options);
+        });
+        if (!ok)
+        {
+            close(fd);
+        }
+    }
+}
+
+} // end namespace coop::resp
+} // end namespace coop
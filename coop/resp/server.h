@@ -0,0 +1,73 @@
+#pragma once
+
+// coop::resp — a Redis-protocol server over a ShardedCache.
+//
+//   coop::CooperatorGroup group(4);
+//   ...
+//   coop::resp::Cache cache(ctx, group);                     // one shard per cooperator
+//   coop::resp::RunServer(ctx, 6379, cache);
+//
+// Each connection has one context. It parses every complete command in its recv buffer in place
+// (protocol.h), executes them in order, and answers the whole pipeline with one send before it
+// reads again -- so a client pipelining a hundred commands gets a hundred replies in one write.
+//
+// Reads are batched across the pipeline as well. A run of GET, MGET and EXISTS commands is not
+// looked up key by key: their keys are gathered and fetched with one ShardedCache::GetMany, which
+// reads local shards directly and sends each remote shard its keys in one batch. A command that
+// writes, or answers by itself, first completes the run before it, so replies keep their order
+// and a read never sees a later write.
+//
+// Commands: GET, SET key value, DEL, EXISTS, MGET, PING, ECHO, COMMAND (an empty list, enough for
+// redis-cli and redis-benchmark), QUIT. Anything else is an error reply; a protocol error is
+// answered and closes the connection, as Redis does.
+//
+
+#include <cstddef>
+#include <string>
+
+#include "coop/sharded_cache.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+
+struct Context;
+
+namespace resp
+{
+
+using Cache = ShardedCache<std::string, std::string>;
+
+struct ServerOptions
+{
+    // The recv buffer's first size. It doubles for a command that does not fit, up to
+    // maxCommandSize, and shrinks back once the command is done.
+    //
+    size_t recvBufSize = 16 * 1024;
+    size_t maxCommandSize = 64 * 1024 * 1024;
+
+    // Replies queued past this are sent before the pipeline is done, bounding the send buffer
+    //
+    size_t maxPendingReplies = 256 * 1024;
+
+    // A connection silent this long is closed; zero for never, as Redis's default
+    //
+    time::Interval idleTimeout = time::Interval(0);
+
+    size_t connectionStackSize = 65536;
+};
+
+// Serve one connection until the client closes it or QUITs, it fails, or ctx is killed.
+// Transport is http::PlaintextTransport or http::TlsTransport (explicitly instantiated in
+// server.cpp).
+//
+template<typename Transport>
+void Serve(Context* ctx, Transport transport, Cache& cache, ServerOptions const& options = {});
+
+// Listen on port and Serve each plaintext connection on a context of its own until ctx is killed
+//
+void RunServer(Context* ctx, int port, Cache& cache, ServerOptions const& options = {},
+               const char* name = "RespServer");
+
+} // end namespace coop::resp
+} // end namespace coop
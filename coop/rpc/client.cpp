@@ -0,0 +1,316 @@
+#include "client.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/coordinate_with.h"
+#include "coop/cooperator.h"
+#include "coop/deadline_scope.h"
+#include "coop/self.h"
+#include "coop/http/transport.h"
+#include "coop/http/tls_transport.h"
+#include "coop/time/now.h"
+
+namespace coop
+{
+namespace rpc
+{
+
+// One call, on the calling context's stack. The reader fills in the answer and wakes it; it
+// finds the call by id only once the answer is read whole, so a caller that gives up (and leaves
+// the map) is never written to mid-read.
+//
+template<typename Transport>
+struct Client<Transport>::Pending
+{
+    Pending(Context* ctx, std::string* r)
+    : response(r)
+    , wake(ctx)
+    {
+    }
+
+    void Wake(Context* ctx)
+    {
+        if (wake.IsHeld())
+        {
+            wake.Release(ctx, false);
+        }
+    }
+
+    std::string*        response;
+    int                 status = 0;
+    bool                done = false;
+    Coordinator         wake;
+};
+
+template<typename Transport>
+Client<Transport>::Client(Transport transport, ClientOptions const& options)
+: m_stream(transport, options.recvBufSize)
+, m_options(options)
+{
+}
+
+template<typename Transport>
+Client<Transport>::~Client()
+{
+    if (m_started)
+    {
+        Close(Self());
+    }
+}
+
+template<typename Transport>
+bool Client<Transport>::Start(Context* ctx)
+{
+    assert(!m_started);
+    m_started = true;
+
+    SpawnConfiguration config = {.priority = ctx->GetPriority(),
+                                 .stackSize = m_options.readerStackSize};
+    bool spawned = ctx->GetCooperator()->Spawn(config, [this](Context* reader)
+    {
+        Run(reader);
+    }, &m_reader);
+    if (!spawned)
+    {
+        spdlog::warn("rpc client reader spawn failed");
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+template<typename Transport>
+void Client<Transport>::Close(Context* ctx)
+{
+    if (!m_started)
+    {
+        return;
+    }
+    m_closing = true;
+
+    // The reader holds m_readerExit until its last act and fails every call on the way out
+    //
+    if (m_reader)
+    {
+        m_reader.Kill();
+    }
+    m_readerExit.Acquire(ctx);
+    m_readerExit.Release(ctx, false);
+    while (m_reader || m_active > 0)
+    {
+        ctx->Yield();
+    }
+    m_started = false;
+}
+
+template<typename Transport>
+int Client<Transport>::Call(Context* ctx, uint16_t method, const void* request, size_t size,
+                            std::string* response)
+{
+    if (response)
+    {
+        response->clear();
+    }
+    if (!Usable())
+    {
+        return -EAGAIN;
+    }
+
+    // The server is told what is left of the wait, so it can give up when the caller will have
+    //
+    time::Interval timeout = DeadlineScope::Clamp(ctx, m_options.timeout);
+    if (timeout.count() <= 0)
+    {
+        return -ETIMEDOUT;
+    }
+    int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(timeout).count();
+    int64_t deadline = time::MonotonicMicros() + micros;
+
+    uint32_t id = m_nextId;
+    while (id == 0 || m_pending.count(id))
+    {
+        id++;
+    }
+    m_nextId = id + 1;
+
+    Pending pending(ctx, response);
+    m_pending.emplace(id, &pending);
+    m_active++;
+
+    FrameHeader header;
+    header.length = static_cast<uint32_t>(size);
+    header.type = REQUEST;
+    header.code = method;
+    header.id = id;
+    header.budget = static_cast<uint32_t>(
+        std::clamp<int64_t>(micros, 1, std::numeric_limits<uint32_t>::max()));
+    m_stream.Queue(header, request, size);
+    if (!m_stream.Flush())
+    {
+        Fail();
+    }
+
+    int result = 0;
+    while (!pending.done && !m_failed)
+    {
+        auto remaining = time::Interval(deadline - time::MonotonicMicros());
+        if (remaining.count() <= 0)
+        {
+            result = -ETIMEDOUT;
+            break;
+        }
+        auto wait = CoordinateWithKill(ctx, &pending.wake, remaining);
+        if (pending.done)
+        {
+            break;
+        }
+        if (wait.Killed())
+        {
+            result = -ECANCELED;
+            break;
+        }
+        if (wait.TimedOut())
+        {
+            result = -ETIMEDOUT;
+            break;
+        }
+    }
+    m_pending.erase(id);
+
+    if (pending.done)
+    {
+        result = pending.status;
+    }
+    else if (result == 0)
+    {
+        result = -ECONNRESET;
+    }
+    else if (!m_failed)
+    {
+        // A call we give up on is cancelled, so the server stops working on it
+        //
+        FrameHeader cancel;
+        cancel.type = CANCEL;
+        cancel.id = id;
+        m_stream.Queue(cancel, nullptr, 0);
+        if (!m_stream.Flush())
+        {
+            Fail();
+        }
+    }
+
+    m_active--;
+    return result;
+}
+
+template<typename Transport>
+void Client<Transport>::Run(Context* ctx)
+{
+    ctx->SetName("RpcClient");
+    m_readerExit.Acquire(ctx);
+
+    FrameHeader header;
+    while (!ctx->IsKilled() && !m_stream.SendFailed())
+    {
+        if (m_stream.ReadHeader(&header) <= 0 || !OnAnswer(header))
+        {
+            break;
+        }
+    }
+
+    Fail();
+    m_readerExit.Release(ctx, false);
+}
+
+template<typename Transport>
+bool Client<Transport>::OnAnswer(FrameHeader const& header)
+{
+    if (header.type == ERROR)
+    {
+        if (!m_stream.ReadInto(nullptr, header.length))
+        {
+            return false;
+        }
+        auto it = m_pending.find(header.id);
+        if (it != m_pending.end())
+        {
+            it->second->status = header.code != OK ? header.code : UNAVAILABLE;
+            it->second->done = true;
+            it->second->Wake(Self());
+        }
+        return true;
+    }
+    if (header.type != RESPONSE)
+    {
+        return m_stream.ReadInto(nullptr, header.length);
+    }
+
+    // In place when it fits; otherwise whole into m_large, handed over by swap
+    //
+    const char* payload = nullptr;
+    bool large = header.length > m_stream.RecvBufSize();
+    if (large)
+    {
+        m_large.clear();
+        if (!m_stream.ReadInto(&m_large, header.length))
+        {
+            return false;
+        }
+    }
+    else if (!(payload = m_stream.Payload(header.length)))
+    {
+        return false;
+    }
+
+    auto it = m_pending.find(header.id);
+    if (it == m_pending.end())
+    {
+        return true;
+    }
+    Pending* pending = it->second;
+    if (pending->response)
+    {
+        if (large)
+        {
+            pending->response->swap(m_large);
+        }
+        else
+        {
+            pending->response->assign(payload, header.length);
+        }
+    }
+    pending->status = OK;
+    pending->done = true;
+    pending->Wake(Self());
+    return true;
+}
+
+// The connection is done: every call outstanding wakes to an error
+//
+template<typename Transport>
+void Client<Transport>::Fail()
+{
+    m_failed = true;
+    auto* ctx = Self();
+    for (auto& [id, pending] : m_pending)
+    {
+        pending->Wake(ctx);
+    }
+}
+
+// -------------------------------------------------------------------------------------
+// Explicit template instantiations for known transport types
+// -------------------------------------------------------------------------------------
+
+template struct Client<http::PlaintextTransport>;
+template struct Client<http::TlsTransport>;
+
+} // end namespace coop::rpc
+} // end namespace coop
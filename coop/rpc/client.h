@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "stream.h"
+#include "coop/context.h"
+#include "coop/coordinator.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+namespace rpc
+{
+
+struct ClientOptions
+{
+    // How long a Call may take, from its send to its answer. A caller under a DeadlineScope waits
+    // only for what is left of it, and tells the server so.
+    //
+    time::Interval timeout = std::chrono::seconds(30);
+
+    // A response whose frame fits is read out of the recv buffer in place; a bigger one is copied
+    // out whole first
+    //
+    size_t recvBufSize = 64 * 1024;
+
+    // Stack for the frame reader context. TLS reads run OpenSSL on it, hence the margin.
+    //
+    size_t readerStackSize = 65536;
+};
+
+// What the pool holds, for either transport
+//
+struct ClientBase
+{
+    virtual ~ClientBase() = default;
+
+    virtual int Call(Context* ctx, uint16_t method, const void* request, size_t size,
+                     std::string* response) = 0;
+    virtual void Close(Context* ctx) = 0;
+    virtual bool Usable() const = 0;
+    virtual size_t Active() const = 0;
+};
+
+// Client multiplexes calls over one connection: any number of contexts on the cooperator Call at
+// once, each under an id of its own, answered in whatever order the server finishes them.
+//
+// Start spawns the reader context, which reads every frame and hands each call its answer. Calls
+// queue their requests through the shared detail::FrameStream, so requests made while a send is
+// in flight leave together in the next one.
+//
+// Call returns 0 with the response payload in *response (which may be null to discard it), a
+// positive Status the server answered with, or a negative errno:
+//   -EAGAIN     not sent: the connection is closing or has failed -- safe to retry elsewhere
+//   -ECONNRESET the connection failed with the call outstanding
+//   -ETIMEDOUT  the timeout, or the caller's deadline, passed; the call is cancelled
+//   -ECANCELED  the calling context was killed; the call is cancelled
+//
+// Close (or the destructor, on a context) stops the reader and waits for calls in flight to fail
+// out. Usable() is false once the connection has failed or is closing.
+//
+//  coop::rpc::Client<coop::http::PlaintextTransport> client(coop::http::PlaintextTransport(desc));
+//  client.Start(ctx);
+//  std::string response;
+//  if (client.Call(ctx, ECHO, "hi", 2, &response) == 0) ...
+//
+template<typename Transport>
+struct Client final : ClientBase
+{
+    explicit Client(Transport transport, ClientOptions const& options = {});
+    ~Client() override;
+
+    Client(Client const&) = delete;
+    Client& operator=(Client const&) = delete;
+
+    // False when the reader cannot be spawned; the connection is then unusable
+    //
+    bool Start(Context* ctx);
+
+    int Call(Context* ctx, uint16_t method, const void* request, size_t size,
+             std::string* response) override;
+
+    void Close(Context* ctx) override;
+
+    bool Usable() const override { return m_started && !m_failed && !m_closing; }
+
+    // Calls outstanding
+    //
+    size_t Active() const override { return m_active; }
+
+  private:
+    struct Pending;
+
+    void Run(Context* ctx);
+    bool OnAnswer(FrameHeader const& header);
+    void Fail();
+
+    detail::FrameStream<Transport>              m_stream;
+    ClientOptions                               m_options;
+
+    Context::Handle                             m_reader;
+    Coordinator                                 m_readerExit;
+    bool                                        m_started = false;
+    bool                                        m_failed = false;
+    bool                                        m_closing = false;
+
+    std::string                                 m_large;    // a response bigger than the buffer
+    std::unordered_map<uint32_t, Pending*>      m_pending;
+    size_t                                      m_active = 0;
+    uint32_t                                    m_nextId = 1;
+};
+
+} // end namespace coop::rpc
+} // end namespace coop
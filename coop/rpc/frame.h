@@ -0,0 +1,97 @@
+#pragma once
+
+// Wire format of coop::rpc: every message is one frame, a fixed 16-byte header and a payload of
+// the length it gives. All fields are big-endian.
+//
+//    0  u32  length    payload bytes after the header
+//    4  u8   type      REQUEST, RESPONSE, ERROR or CANCEL
+//    5  u8   flags     reserved, sent as zero
+//    6  u16  code      REQUEST: the method id; ERROR: a Status; otherwise zero
+//    8  u32  id        the call, chosen by the client and echoed by the server
+//   12  u32  budget    REQUEST: what is left of the caller's deadline, in microseconds; zero for
+//                      none (the server then applies its own timeout only)
+//
+// A call is one REQUEST answered by one RESPONSE or ERROR with its id. Calls are multiplexed:
+// any number may be outstanding on a connection, answered in any order. A CANCEL (no payload)
+// tells the server the caller gave up; it is not answered.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <endian.h>
+
+namespace coop
+{
+namespace rpc
+{
+
+static constexpr size_t FRAME_HEADER_SIZE = 16;
+
+enum FrameType : uint8_t
+{
+    REQUEST     = 1,
+    RESPONSE    = 2,
+    ERROR       = 3,
+    CANCEL      = 4,
+};
+
+// Why a call failed on the server, carried by an ERROR frame. Client calls return them as
+// positive values, beside the negative errnos of the transport. Applications use APPLICATION
+// and up for their own.
+//
+enum Status : uint16_t
+{
+    OK                  = 0,
+    UNKNOWN_METHOD      = 1,
+    DEADLINE_EXCEEDED   = 2,
+    TOO_LARGE           = 3,
+    NO_REPLY            = 4,    // the handler returned without replying
+    UNAVAILABLE         = 5,    // the server is shutting down
+    APPLICATION         = 256,
+};
+
+struct FrameHeader
+{
+    uint32_t    length = 0;
+    uint8_t     type = 0;
+    uint8_t     flags = 0;
+    uint16_t    code = 0;
+    uint32_t    id = 0;
+    uint32_t    budget = 0;
+};
+
+inline void WriteFrameHeader(uint8_t* out, FrameHeader const& header)
+{
+    uint32_t length = htobe32(header.length);
+    uint16_t code = htobe16(header.code);
+    uint32_t id = htobe32(header.id);
+    uint32_t budget = htobe32(header.budget);
+    memcpy(out, &length, 4);
+    out[4] = header.type;
+    out[5] = header.flags;
+    memcpy(out + 6, &code, 2);
+    memcpy(out + 8, &id, 4);
+    memcpy(out + 12, &budget, 4);
+}
+
+inline void ReadFrameHeader(const uint8_t* in, FrameHeader* header)
+{
+    uint32_t length;
+    uint16_t code;
+    uint32_t id;
+    uint32_t budget;
+    memcpy(&length, in, 4);
+    memcpy(&code, in + 6, 2);
+    memcpy(&id, in + 8, 4);
+    memcpy(&budget, in + 12, 4);
+    header->length = be32toh(length);
+    header->type = in[4];
+    header->flags = in[5];
+    header->code = be16toh(code);
+    header->id = be32toh(id);
+    header->budget = be32toh(budget);
+}
+
+} // end namespace coop::rpc
+} // end namespace coop
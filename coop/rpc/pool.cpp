@@ -0,0 +1,234 @@
+#include "pool.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <optional>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/context.h"
+#include "coop/self.h"
+#include "coop/http/transport.h"
+#include "coop/http/tls_transport.h"
+#include "coop/io/connect.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/ssl/connection.h"
+#include "coop/io/ssl/context.h"
+
+namespace coop
+{
+namespace rpc
+{
+
+// One pooled connection. The client goes first, its calls failed out, then the TLS session, then
+// the socket -- closed with ::close, as http::ClientPool does, rather than through a Descriptor
+// that needs a context to close on.
+//
+struct Pool::Entry
+{
+    explicit Entry(int socket)
+    : fd(socket)
+    , desc(io::borrowed, socket)
+    {
+    }
+
+    ~Entry()
+    {
+        client.reset();
+        ssl.reset();
+        ::close(fd);
+    }
+
+    int                                 fd;
+    io::Descriptor                      desc;
+    std::optional<io::ssl::Connection>  ssl;
+    std::unique_ptr<ClientBase>         client;
+};
+
+struct Pool::Host
+{
+    std::string                         name;
+    int                                 port;
+    size_t                              opening = 0;    // connects in progress
+    std::vector<std::unique_ptr<Entry>> entries;
+};
+
+Pool::Pool(PoolOptions const& options)
+: m_options(options)
+{
+}
+
+Pool::~Pool()
+{
+    if (!m_hosts.empty())
+    {
+        Close(Self());
+    }
+}
+
+int Pool::Call(Context* ctx, const char* host, int port, uint16_t method, const void* request,
+               size_t size, std::string* response)
+{
+    std::string key = host;
+    key += ':';
+    key += std::to_string(port);
+    auto& target = m_hosts[key];
+    if (!target)
+    {
+        target = std::make_unique<Host>();
+        target->name = host;
+        target->port = port;
+    }
+
+    int result = -EHOSTUNREACH;
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        ClientBase* client = Pick(ctx, *target);
+        if (!client)
+        {
+            return -EHOSTUNREACH;
+        }
+        result = client->Call(ctx, method, request, size, response);
+        if (result != -EAGAIN)
+        {
+            break;
+        }
+    }
+    return result;
+}
+
+// The usable connection with the fewest calls outstanding; a new one when every one is busy and
+// there is room for it
+//
+ClientBase* Pool::Pick(Context* ctx, Host& host)
+{
+    Prune(host);
+
+    ClientBase* best = nullptr;
+    for (auto& entry : host.entries)
+    {
+        ClientBase* client = entry->client.get();
+        if (client->Usable() && (!best || client->Active() < best->Active()))
+        {
+            best = client;
+        }
+    }
+    if (best && (best->Active() == 0
+                 || host.entries.size() + host.opening >= m_options.connectionsPerHost))
+    {
+        return best;
+    }
+    if (host.entries.size() + host.opening >= m_options.connectionsPerHost)
+    {
+        return nullptr;
+    }
+
+    Entry* entry = Open(ctx, host);
+    if (entry)
+    {
+        return entry->client.get();
+    }
+    return best;
+}
+
+Pool::Entry* Pool::Open(Context* ctx, Host& host)
+{
+    host.opening++;
+    int fd = io::ConnectAny(host.name.c_str(), host.port, m_options.connectTimeout,
+                            {.noDelay = true, .fastOpen = m_options.fastOpen});
+    host.opening--;
+    if (fd < 0)
+    {
+        spdlog::warn("rpc pool: connect {}:{}: {}", host.name, host.port, strerror(-fd));
+        return nullptr;
+    }
+    m_connects++;
+
+    auto entry = std::make_unique<Entry>(fd);
+    if (m_options.tls)
+    {
+        entry->ssl.emplace(*m_options.tls, entry->desc, io::ssl::SocketBio{});
+
+        // SNI only for names: RFC 6066 rules out literal addresses
+        //
+        in6_addr addr;
+        const char* name = host.name.c_str();
+        if (::inet_pton(AF_INET, name, &addr) != 1 && ::inet_pton(AF_INET6, name, &addr) != 1)
+        {
+            SSL_set_tlsext_host_name(entry->ssl->m_ssl, name);
+        }
+        if (entry->ssl->HandshakeKill() != 0)
+        {
+            spdlog::warn("rpc pool: TLS handshake {}:{} failed", host.name, host.port);
+            return nullptr;
+        }
+        auto* client = new Client<http::TlsTransport>(
+            http::TlsTransport(*entry->ssl, entry->desc), m_options.client);
+        entry->client.reset(client);
+        if (!client->Start(ctx))
+        {
+            return nullptr;
+        }
+    }
+    else
+    {
+        auto* client = new Client<http::PlaintextTransport>(
+            http::PlaintextTransport(entry->desc), m_options.client);
+        entry->client.reset(client);
+        if (!client->Start(ctx))
+        {
+            return nullptr;
+        }
+    }
+
+    host.entries.push_back(std::move(entry));
+    return host.entries.back().get();
+}
+
+// Drop the connections that failed, once no call is left on them
+//
+void Pool::Prune(Host& host)
+{
+    auto& entries = host.entries;
+    for (size_t i = 0; i < entries.size();)
+    {
+        ClientBase* client = entries[i]->client.get();
+        if (!client->Usable() && client->Active() == 0)
+        {
+            entries[i] = std::move(entries.back());
+            entries.pop_back();
+            continue;
+        }
+        i++;
+    }
+}
+
+void Pool::Close(Context* ctx)
+{
+    for (auto& it : m_hosts)
+    {
+        for (auto& entry : it.second->entries)
+        {
+            entry->client->Close(ctx);
+        }
+    }
+    m_hosts.clear();
+}
+
+size_t Pool::Connections() const
+{
+    size_t n = 0;
+    for (auto& it : m_hosts)
+    {
+        n += it.second->entries.size();
+    }
+    return n;
+}
+
+} // end namespace coop::rpc
+} // end namespace coop
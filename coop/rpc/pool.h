@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "client.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+
+struct Context;
+
+namespace io { namespace ssl { struct Context; } }
+
+namespace rpc
+{
+
+struct PoolOptions
+{
+    // Connections per (host, port). Calls multiplex, so a few carry any number of callers; more
+    // spread the load of one busy backend across its cores.
+    //
+    size_t connectionsPerHost = 2;
+
+    // How long opening a connection may take, raced across the host's addresses (io::ConnectAny)
+    //
+    time::Interval connectTimeout = std::chrono::seconds(10);
+
+    // Open connections with TCP Fast Open, so the first calls on a new connection ride its SYN
+    // once the kernel holds the host's cookie. See io::ConnectAnyOptions::fastOpen for the trade.
+    //
+    bool fastOpen = false;
+
+    ClientOptions client;
+
+    // Client context (ssl::Mode::Client) to open connections with TLS, SNI set for names; null for
+    // plaintext
+    //
+    io::ssl::Context* tls = nullptr;
+};
+
+// Pool keeps multiplexed rpc::Client connections per (host, port), opened on first use. A call
+// goes on the connection with the fewest calls outstanding; another is opened while every one is
+// busy and the host is under connectionsPerHost. A connection found unusable is dropped once its
+// calls have failed out, and a call that was not sent (-EAGAIN) is tried once more on another.
+//
+// Single-cooperator, like the clients in it.
+//
+//  coop::rpc::Pool pool;
+//  std::string response;
+//  int rc = pool.Call(ctx, "10.0.0.5", 7000, LOOKUP, key.data(), key.size(), &response);
+//
+struct Pool
+{
+    explicit Pool(PoolOptions const& options = {});
+    ~Pool();
+
+    Pool(Pool const&) = delete;
+    Pool& operator=(Pool const&) = delete;
+
+    // Client::Call on a connection to host:port; -EHOSTUNREACH when none could be opened
+    //
+    int Call(Context* ctx, const char* host, int port, uint16_t method, const void* request,
+             size_t size, std::string* response);
+
+    // Close every connection, waiting for their calls to fail out
+    //
+    void Close(Context* ctx);
+
+    size_t Connections() const;
+    uint64_t Connects() const { return m_connects; }
+
+  private:
+    struct Entry;
+    struct Host;
+
+    ClientBase* Pick(Context* ctx, Host& host);
+    Entry* Open(Context* ctx, Host& host);
+    void Prune(Host& host);
+
+    PoolOptions                                             m_options;
+    std::unordered_map<std::string, std::unique_ptr<Host>>  m_hosts;
+    uint64_t                                                m_connects = 0;
+};
+
+} // end namespace coop::rpc
+} // end namespace coop
@@ -0,0 +1,429 @@
+#include "server.h"
+#include "stream.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <optional>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/deadline_scope.h"
+#include "coop/detail/embedded_list.h"
+#include "coop/http/transport.h"
+#include "coop/http/tls_transport.h"
+#include "coop/io/accept.h"
+#include "coop/io/descriptor.h"
+
+namespace coop
+{
+namespace rpc
+{
+
+namespace
+{
+
+template<typename Transport>
+struct ServerConnection;
+
+// A call on the server. Its answer is queued, and sent at once unless the connection is in the
+// middle of a batch, whose end sends it with the rest. A killed call's answer is dropped: the
+// call was cancelled, or the server is going away.
+//
+template<typename Transport>
+struct ServerCall final : Call
+{
+    ServerCall(ServerConnection<Transport>* conn, Context* ctx, FrameHeader const& header,
+               std::string_view request)
+    : m_conn(conn)
+    {
+        m_context = ctx;
+        m_method = header.code;
+        m_id = header.id;
+        m_request = request;
+    }
+
+    bool Reply(const void* data, size_t size) override
+    {
+        return Answer(RESPONSE, OK, data, size);
+    }
+
+    bool Fail(uint16_t status) override
+    {
+        return Answer(ERROR, status, nullptr, 0);
+    }
+
+  private:
+    bool Answer(uint8_t type, uint16_t code, const void* data, size_t size)
+    {
+        if (m_replied || m_context->IsKilled())
+        {
+            return false;
+        }
+        m_replied = true;
+        return m_conn->Answer(m_id, type, code, data, size);
+    }
+
+    ServerConnection<Transport>* m_conn;
+};
+
+// A SPAWN call: its own copy of the request, and the handle a CANCEL kills it by. The handle is
+// cleared when the call's context is destroyed, after its function returns, so the connection
+// frees these (Reap) rather than the call itself.
+//
+struct Spawned : EmbeddedListHookups<Spawned>
+{
+    FrameHeader         header;
+    std::string         request;
+    Context::Handle     handle;
+};
+
+template<typename Transport>
+struct ServerConnection
+{
+    ServerConnection(Context* ctx, Transport transport, MethodTable const& methods,
+                     ServerOptions const& options)
+    : m_ctx(ctx)
+    , m_stream(transport, options.recvBufSize)
+    , m_methods(methods)
+    , m_options(options)
+    {
+    }
+
+    void Run();
+
+    bool Answer(uint32_t id, uint8_t type, uint16_t code, const void* data, size_t size)
+    {
+        FrameHeader header;
+        header.length = static_cast<uint32_t>(size);
+        header.type = type;
+        header.code = code;
+        header.id = id;
+        m_stream.Queue(header, data, size);
+        return m_batching ? !m_stream.SendFailed() : m_stream.Flush();
+    }
+
+  private:
+    bool OnFrame(FrameHeader const& header);
+    void Dispatch(FrameHeader const& header, std::string_view request);
+    void Spawn(Method const& method, FrameHeader const& header, std::string_view request);
+    void Cancel(uint32_t id);
+    void Reap();
+
+    time::Interval Budget(FrameHeader const& header) const
+    {
+        return header.budget ? time::Interval(std::chrono::microseconds(header.budget))
+                             : m_options.defaultBudget;
+    }
+
+    Context*                        m_ctx;
+    detail::FrameStream<Transport>  m_stream;
+    MethodTable const&              m_methods;
+    ServerOptions const&            m_options;
+
+    bool                            m_batching = false;
+    std::string                     m_large;        // a request bigger than the recv buffer
+    EmbeddedList<Spawned>           m_spawned;
+};
+
+// Frames already buffered are dispatched as one batch, their answers queued; the batch is sent
+// before the connection blocks for more
+//
+template<typename Transport>
+void ServerConnection<Transport>::Run()
+{
+    FrameHeader header;
+    while (!m_ctx->IsKilled())
+    {
+        if (!m_stream.FrameBuffered())
+        {
+            m_batching = false;
+            if (!m_stream.Flush())
+            {
+                break;
+            }
+        }
+        if (m_stream.ReadHeader(&header, m_options.idleTimeout) <= 0)
+        {
+            break;
+        }
+        m_batching = true;
+        if (!OnFrame(header))
+        {
+            break;
+        }
+    }
+    m_batching = false;
+    m_stream.Flush();
+
+    // Spawned calls refer to the connection: they are stopped before it goes
+    //
+    for (Spawned* spawned : m_spawned)
+    {
+        if (spawned->handle)
+        {
+            spawned->handle.Kill();
+        }
+    }
+    for (Reap(); !m_spawned.IsEmpty(); Reap())
+    {
+        m_ctx->Yield();
+    }
+}
+
+template<typename Transport>
+bool ServerConnection<Transport>::OnFrame(FrameHeader const& header)
+{
+    switch (header.type)
+    {
+    case REQUEST:
+    {
+        if (header.length > m_options.maxRequestSize)
+        {
+            Answer(header.id, ERROR, TOO_LARGE, nullptr, 0);
+            return m_stream.ReadInto(nullptr, header.length);
+        }
+        if (header.length <= m_stream.RecvBufSize())
+        {
+            const char* payload = m_stream.Payload(header.length);
+            if (!payload)
+            {
+                return false;
+            }
+            Dispatch(header, std::string_view(payload, header.length));
+            return true;
+        }
+        m_large.clear();
+        m_large.reserve(header.length);
+        if (!m_stream.ReadInto(&m_large, header.length))
+        {
+            return false;
+        }
+        Dispatch(header, m_large);
+        if (m_large.capacity() > 4 * m_stream.RecvBufSize())
+        {
+            std::string().swap(m_large);
+        }
+        return true;
+    }
+
+    case CANCEL:
+        Cancel(header.id);
+        return m_stream.ReadInto(nullptr, header.length);
+
+    default:
+        // Unknown to this version: skipped
+        //
+        return m_stream.ReadInto(nullptr, header.length);
+    }
+}
+
+template<typename Transport>
+void ServerConnection<Transport>::Dispatch(FrameHeader const& header, std::string_view request)
+{
+    Method const* method = m_methods.Find(header.code);
+    if (!method)
+    {
+        Answer(header.id, ERROR, UNKNOWN_METHOD, nullptr, 0);
+        return;
+    }
+    if (method->dispatch == SPAWN)
+    {
+        Spawn(*method, header, request);
+        return;
+    }
+
+    ServerCall<Transport> call(this, m_ctx, header, request);
+    {
+        time::Interval budget = Budget(header);
+        std::optional<DeadlineScope> scope;
+        if (budget.count() > 0)
+        {
+            scope.emplace(m_ctx, budget);
+        }
+        method->handler(call);
+    }
+    if (!call.Replied())
+    {
+        call.Fail(NO_REPLY);
+    }
+}
+
+template<typename Transport>
+void ServerConnection<Transport>::Spawn(Method const& method, FrameHeader const& header,
+                                        std::string_view request)
+{
+    Reap();
+
+    auto* spawned = new Spawned;
+    spawned->header = header;
+    spawned->request.assign(request);
+
+    // The budget starts when the request is read, not when the call's context first runs
+    //
+    int64_t deadline = 0;
+    time::Interval budget = Budget(header);
+    if (budget.count() > 0)
+    {
+        deadline = time::MonotonicMicros()
+            + std::chrono::duration_cast<std::chrono::microseconds>(budget).count();
+    }
+
+    SpawnConfiguration config = {.priority = m_ctx->GetPriority(),
+                                 .stackSize = m_options.callStackSize,
+                                 .deadlineUs = deadline};
+    Handler handler = method.handler;
+    bool ok = m_ctx->GetCooperator()->Spawn(config, [this, spawned, handler, deadline](Context* ctx)
+    {
+        ctx->SetName("RpcCall");
+        ServerCall<Transport> call(this, ctx, spawned->header, spawned->request);
+        int64_t left = deadline ? deadline - time::MonotonicMicros() : 0;
+        if (deadline && left <= 0)
+        {
+            call.Fail(DEADLINE_EXCEEDED);
+        }
+        else
+        {
+            std::optional<DeadlineScope> scope;
+            if (deadline)
+            {
+                scope.emplace(ctx, std::chrono::microseconds(left));
+            }
+            handler(call);
+        }
+        if (!call.Replied())
+        {
+            call.Fail(NO_REPLY);
+        }
+    }, &spawned->handle);
+
+    if (!ok)
+    {
+        spdlog::warn("rpc server call spawn failed method={}", header.code);
+        delete spawned;
+        Answer(header.id, ERROR, UNAVAILABLE, nullptr, 0);
+        return;
+    }
+    m_spawned.Push(spawned);
+}
+
+template<typename Transport>
+void ServerConnection<Transport>::Cancel(uint32_t id)
+{
+    for (Spawned* spawned : m_spawned)
+    {
+        if (spawned->header.id == id && spawned->handle)
+        {
+            spawned->handle.Kill();
+            return;
+        }
+    }
+}
+
+// Free the calls whose contexts are gone
+//
+template<typename Transport>
+void ServerConnection<Transport>::Reap()
+{
+    m_spawned.Visit([this](Spawned* spawned)
+    {
+        if (!spawned->handle)
+        {
+            m_spawned.Remove(spawned);
+            delete spawned;
+        }
+        return true;
+    });
+}
+
+// Bind a nonblocking listener on port. Returns the fd, or -1.
+//
+int Listen(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    int on = 1;
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = INADDR_ANY;
+
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0
+        || bind(fd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in)) != 0
+        || listen(fd, 512) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // end anonymous namespace
+
+template<typename Transport>
+void Serve(Context* ctx, Transport transport, MethodTable const& methods,
+           ServerOptions const& options /* = {} */)
+{
+    ServerConnection<Transport> conn(ctx, transport, methods, options);
+    conn.Run();
+}
+
+template void Serve<http::PlaintextTransport>(Context*, http::PlaintextTransport,
+                                              MethodTable const&, ServerOptions const&);
+template void Serve<http::TlsTransport>(Context*, http::TlsTransport, MethodTable const&,
+                                        ServerOptions const&);
+
+void RunServer(Context* ctx, int port, MethodTable const& methods,
+               ServerOptions const& options /* = {} */, const char* name /* = "RpcServer" */)
+{
+    ctx->SetName(name);
+
+    int listenFd = Listen(port);
+    if (listenFd < 0)
+    {
+        spdlog::error("rpc server listen port={} failed: {}", port, strerror(errno));
+        return;
+    }
+    io::Descriptor listener(listenFd);
+
+    // Connections are children of this context, so they go when it is killed; each keeps its
+    // own copy of the options
+    //
+    SpawnConfiguration config = {.priority = ctx->GetPriority(),
+                                 .stackSize = options.connectionStackSize};
+    while (!ctx->IsKilled())
+    {
+        int fd = io::AcceptKill(listener);
+        if (fd < 0)
+        {
+            break;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        bool ok = ctx->GetCooperator()->Spawn(config, [fd, &methods, options](Context* conn)
+        {
+            conn->SetName("RpcConnection");
+            io::Descriptor desc(fd);
+            Serve(conn, http::PlaintextTransport(desc), methods, options);
+        });
+        if (!ok)
+        {
+            close(fd);
+        }
+    }
+}
+
+} // end namespace coop::rpc
+} // end namespace coop
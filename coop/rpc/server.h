@@ -0,0 +1,193 @@
+#pragma once
+
+// coop::rpc — length-prefixed binary RPC over coop's transports (wire format in frame.h).
+//
+// A server is a table of methods, each a numeric id and a handler, built at compile time:
+//
+//   void Echo(coop::rpc::Call& call)
+//   {
+//       call.Reply(call.Request().data(), call.Request().size());
+//   }
+//
+//   void Lookup(coop::rpc::Call& call);   // reads a backend: slow, so it runs on its own context
+//
+//   static constexpr coop::rpc::MethodTable s_methods = {
+//       {1, &Echo},
+//       {2, &Lookup, coop::rpc::SPAWN},
+//   };
+//
+//   coop::rpc::RunServer(ctx, 7000, s_methods);
+//
+// Each connection has one context, which reads frames and dispatches each request by its id: a
+// probe of the table's open-addressed index, with no map and no virtual call. The request's
+// payload is a view into the connection's recv buffer, so a handler that answers at once (the
+// default, INLINE) sees the bytes where they arrived. A handler marked SPAWN runs on a context of
+// its own with the payload copied to it; the connection goes on reading, so one slow call does
+// not hold up the calls behind it.
+//
+// Replies are batched. Inline handlers queue their responses, and the connection sends
+// everything queued in one write once it has dispatched every request already buffered --
+// then it blocks for more. A client pipelining many small calls therefore gets their answers in
+// one send per turn rather than one each. A spawned handler's reply goes out when it is made,
+// coalesced with any others queued while a send is in flight (detail::FrameStream).
+//
+// A request carries what is left of the caller's deadline, and its handler runs under a
+// DeadlineScope of that budget, so the IO it does is bounded by the caller's wait (and the
+// contexts it spawns in turn). A request whose budget is spent before its handler starts is
+// answered DEADLINE_EXCEEDED without being run. A CANCEL kills the call's context, if spawned.
+//
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+
+#include "frame.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+
+struct Context;
+
+namespace rpc
+{
+
+struct Call;
+using Handler = void (*)(Call&);
+
+enum Dispatch : uint8_t
+{
+    INLINE,     // on the connection's context, with the request a view of its recv buffer
+    SPAWN,      // on a context of its own
+};
+
+struct Method
+{
+    uint16_t    id;
+    Handler     handler;
+    Dispatch    dispatch = INLINE;
+};
+
+// Up to MAX methods, indexed by the low bits of their ids in a table twice as large: ids given
+// out in sequence never collide. Build tables once, as constexpr statics.
+//
+struct MethodTable
+{
+    static constexpr size_t MAX = 64;
+
+    constexpr MethodTable(std::initializer_list<Method> methods)
+    {
+        assert(methods.size() <= MAX);
+        for (Method const& method : methods)
+        {
+            if (m_count == MAX)
+            {
+                break;
+            }
+            size_t i = method.id & (TABLE - 1);
+            while (m_index[i] != 0)
+            {
+                assert(m_methods[m_index[i] - 1u].id != method.id);
+                i = (i + 1) & (TABLE - 1);
+            }
+            m_index[i] = static_cast<uint8_t>(m_count + 1);
+            m_methods[m_count++] = method;
+        }
+    }
+
+    constexpr Method const* Find(uint16_t id) const
+    {
+        for (size_t i = id & (TABLE - 1); m_index[i] != 0; i = (i + 1) & (TABLE - 1))
+        {
+            Method const& method = m_methods[m_index[i] - 1u];
+            if (method.id == id)
+            {
+                return &method;
+            }
+        }
+        return nullptr;
+    }
+
+    constexpr size_t Size() const { return m_count; }
+
+  private:
+    static constexpr size_t TABLE = MAX * 2;
+
+    std::array<Method, MAX>         m_methods = {};
+    std::array<uint8_t, TABLE>      m_index = {};       // slot + 1; 0 is empty
+    size_t                          m_count = 0;
+};
+
+// One call, as its handler sees it. Reply or Fail once; a handler that returns without either
+// answers NO_REPLY.
+//
+struct Call
+{
+    virtual ~Call() = default;
+
+    uint16_t MethodId() const { return m_method; }
+    uint32_t Id() const { return m_id; }
+
+    // The request payload: in the recv buffer for an inline call, valid until it returns
+    //
+    std::string_view Request() const { return m_request; }
+
+    virtual bool Reply(const void* data, size_t size) = 0;
+    virtual bool Fail(uint16_t status) = 0;
+
+    bool Replied() const { return m_replied; }
+
+    // The context the handler runs on
+    //
+    Context* GetContext() const { return m_context; }
+
+  protected:
+    Context*            m_context = nullptr;
+    uint16_t            m_method = 0;
+    uint32_t            m_id = 0;
+    std::string_view    m_request;
+    bool                m_replied = false;
+};
+
+struct ServerOptions
+{
+    // A request whose frame fits is dispatched from the recv buffer in place; a bigger one is
+    // copied out whole first, up to maxRequestSize (answered TOO_LARGE, and skipped, past it)
+    //
+    size_t recvBufSize = 64 * 1024;
+    size_t maxRequestSize = 16 * 1024 * 1024;
+
+    // A connection silent this long is closed; zero for never
+    //
+    time::Interval idleTimeout = std::chrono::seconds(60);
+
+    // The budget of a request that carries none; zero for none
+    //
+    time::Interval defaultBudget = time::Interval(0);
+
+    // Stack for each connection's context and each spawned call. TLS reads run OpenSSL on the
+    // connection's, hence the margin.
+    //
+    size_t connectionStackSize = 65536;
+    size_t callStackSize = 65536;
+};
+
+// Serve one connection until the peer closes it, it fails, or ctx is killed. Spawned calls
+// still running are killed and waited for before it returns. Transport is
+// http::PlaintextTransport or http::TlsTransport (explicitly instantiated in server.cpp).
+//
+template<typename Transport>
+void Serve(Context* ctx, Transport transport, MethodTable const& methods,
+           ServerOptions const& options = {});
+
+// Listen on port and Serve each plaintext connection on a context of its own until ctx is
+// killed
+//
+void RunServer(Context* ctx, int port, MethodTable const& methods,
+               ServerOptions const& options = {}, const char* name = "RpcServer");
+
+} // end namespace coop::rpc
+} // end namespace coop
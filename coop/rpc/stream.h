@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "frame.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+namespace rpc
+{
+namespace detail
+{
+
+// The framing the client and server share over one transport (http::PlaintextTransport or
+// http::TlsTransport).
+//
+// Reads go through one recv buffer, from which a frame that fits is parsed in place: the
+// reader takes a pointer to its payload and nothing is copied. A frame bigger than the buffer
+// is copied out of it, once, as it arrives (ReadInto).
+//
+// Writes are queued and coalesced. Queue appends an encoded frame to a pending buffer; Flush
+// sends it. While one context is in a Flush, blocked on the socket, others only queue. The
+// flusher sends what they queued on its next pass, and they return at once. Frames queued in
+// the same turn therefore leave in one send, with no lock and no timer. The two buffers swap,
+// so their capacity is reused from send to send.
+//
+template<typename Transport>
+struct FrameStream
+{
+    FrameStream(Transport transport, size_t recvBufSize)
+    : m_transport(transport)
+    , m_recvBufSize(std::max(recvBufSize, FRAME_HEADER_SIZE))
+    , m_recvBuf(new char[m_recvBufSize])
+    {
+    }
+
+    Transport& GetTransport() { return m_transport; }
+
+    size_t RecvBufSize() const { return m_recvBufSize; }
+    size_t Buffered() const { return m_recvLen - m_recvPos; }
+
+    // Whether a whole frame is buffered, so that reading it will not block
+    //
+    bool FrameBuffered() const
+    {
+        if (Buffered() < FRAME_HEADER_SIZE)
+        {
+            return false;
+        }
+        uint32_t length;
+        memcpy(&length, m_recvBuf.get() + m_recvPos, 4);
+        return Buffered() - FRAME_HEADER_SIZE >= be32toh(length);
+    }
+
+    // At least need bytes buffered (need <= RecvBufSize). Returns 1, or what the failed recv
+    // did: 0 at EOF, a negative errno otherwise.
+    //
+    int Fill(size_t need, time::Interval timeout = time::Interval(0))
+    {
+        if (m_recvPos == m_recvLen)
+        {
+            m_recvPos = m_recvLen = 0;
+        }
+        while (m_recvLen - m_recvPos < need)
+        {
+            if (m_recvPos > 0 && m_recvBufSize - m_recvPos < need)
+            {
+                memmove(m_recvBuf.get(), m_recvBuf.get() + m_recvPos, m_recvLen - m_recvPos);
+                m_recvLen -= m_recvPos;
+                m_recvPos = 0;
+            }
+            int n = m_transport.Recv(m_recvBuf.get() + m_recvLen, m_recvBufSize - m_recvLen, 0,
+                                     timeout);
+            if (n <= 0)
+            {
+                return n;
+            }
+            m_recvLen += size_t(n);
+        }
+        return 1;
+    }
+
+    int ReadHeader(FrameHeader* header, time::Interval timeout = time::Interval(0))
+    {
+        int n = Fill(FRAME_HEADER_SIZE, timeout);
+        if (n <= 0)
+        {
+            return n;
+        }
+        ReadFrameHeader(reinterpret_cast<const uint8_t*>(m_recvBuf.get() + m_recvPos), header);
+        m_recvPos += FRAME_HEADER_SIZE;
+        return 1;
+    }
+
+    // The next length bytes where they lie in the recv buffer, valid until the next read; null
+    // when the recv fails. length must fit (length <= RecvBufSize).
+    //
+    const char* Payload(size_t length)
+    {
+        if (Fill(length) <= 0)
+        {
+            return nullptr;
+        }
+        const char* p = m_recvBuf.get() + m_recvPos;
+        m_recvPos += length;
+        return p;
+    }
+
+    // The next length bytes of any size appended to out, or skipped with a null out
+    //
+    bool ReadInto(std::string* out, size_t length)
+    {
+        while (length > 0)
+        {
+            if (Buffered() == 0 && Fill(1) <= 0)
+            {
+                return false;
+            }
+            size_t n = std::min(Buffered(), length);
+            if (out)
+            {
+                out->append(m_recvBuf.get() + m_recvPos, n);
+            }
+            m_recvPos += n;
+            length -= n;
+        }
+        return true;
+    }
+
+    void Queue(FrameHeader const& header, const void* payload, size_t size)
+    {
+        size_t at = m_pending.size();
+        m_pending.resize(at + FRAME_HEADER_SIZE);
+        WriteFrameHeader(reinterpret_cast<uint8_t*>(m_pending.data() + at), header);
+        m_pending.append(static_cast<const char*>(payload), size);
+    }
+
+    // Send what is queued, and what is queued while it sends. False once a send has failed.
+    //
+    bool Flush()
+    {
+        if (m_flushing || m_failed)
+        {
+            return !m_failed;
+        }
+        m_flushing = true;
+        while (!m_pending.empty() && !m_failed)
+        {
+            m_sending.swap(m_pending);
+            m_failed = m_transport.SendAll(m_sending.data(), m_sending.size()) < 0;
+            m_sending.clear();
+        }
+        m_pending.clear();
+        m_flushing = false;
+        return !m_failed;
+    }
+
+    bool Flushing() const { return m_flushing; }
+    bool SendFailed() const { return m_failed; }
+    size_t Pending() const { return m_pending.size(); }
+
+  private:
+    Transport                   m_transport;
+    size_t                      m_recvBufSize;
+    std::unique_ptr<char[]>     m_recvBuf;
+    size_t                      m_recvLen = 0;
+    size_t                      m_recvPos = 0;
+
+    std::string                 m_pending;
+    std::string                 m_sending;
+    bool                        m_flushing = false;
+    bool                        m_failed = false;
+};
+
+} // end namespace coop::rpc::detail
+} // end namespace coop::rpc
+} // end namespace coop
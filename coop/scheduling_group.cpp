@@ -0,0 +1,37 @@
+#include "scheduling_group.h"
+
+#include "cooperator.h"
+#include "detail/tsc.h"
+
+namespace coop
+{
+
+void SchedulingGroup::Join(Context* ctx)
+{
+    // The budget converts to ticks with the cooperator's calibration, once: the tick rate does not
+    // change under a running cooperator
+    //
+    if (!m_cooperator)
+    {
+        m_cooperator = ctx->m_cooperator;
+        const double nanosPerTick = m_cooperator->NanosPerTick();
+        if (m_config.budgetUs && nanosPerTick > 0)
+        {
+            m_budgetTicks = static_cast<int64_t>(m_config.budgetUs * 1000.0 / nanosPerTick);
+            m_periodTicks = static_cast<int64_t>(m_config.periodUs * 1000.0 / nanosPerTick);
+            m_periodStart = detail::ReadTsc();
+        }
+    }
+    assert(m_cooperator == ctx->m_cooperator && "scheduling group used on two cooperators");
+    m_statistics.contexts++;
+}
+
+void SchedulingGroup::Leave(Context* ctx)
+{
+    assert(ctx->m_group == this);
+    assert(ctx->m_state != SchedulerState::YIELDED && "leaving a group from its run queue");
+    ctx->m_group = nullptr;
+    m_statistics.contexts--;
+}
+
+} // end namespace coop
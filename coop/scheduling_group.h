@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "context.h"
+#include "spawn_configuration.h"
+#include "detail/embedded_list.h"
+
+namespace coop
+{
+
+namespace detail { struct RunQueue; }
+
+// The weight of the cooperator's ungrouped contexts, and a group's default: the unit shares are
+// counted in
+//
+static constexpr uint32_t SCHEDULING_WEIGHT_DEFAULT = 1024;
+
+struct SchedulingGroupConfiguration
+{
+    const char* name = nullptr;
+
+    // CPU share relative to the other groups (and to the ungrouped contexts, which weigh
+    // SCHEDULING_WEIGHT_DEFAULT): under contention a group gets weight / total of the loop.
+    //
+    uint32_t weight = SCHEDULING_WEIGHT_DEFAULT;
+
+    // Optional cap: at most budgetUs of running per periodUs. A group past it is throttled for the
+    // rest of the period, resumed only when nothing unthrottled is runnable -- the cap bounds what
+    // a tenant takes from the others, it does not idle the loop. 0 is uncapped.
+    //
+    uint32_t budgetUs = 0;
+    uint32_t periodUs = 10000;
+};
+
+// A fair-share scheduling group: a subtree of contexts that competes for its cooperator's loop as
+// one entity. A cooperator shared between tenants, or between the request path and background
+// jobs, otherwise gives a hot subtree whatever share its yields take.
+//
+// Contexts join through SpawnConfiguration::group, and children join their parent's group, so
+// spawning a tenant's root context into a group puts everything it fans out there too. The run
+// queue then picks, on every pop, the runnable group (or the ungrouped contexts, as one more
+// entity) with the least virtual runtime: each slice is charged to its group in cycle-counter
+// ticks, scaled by SCHEDULING_WEIGHT_DEFAULT / weight. A group that wakes after idling starts at
+// the least runtime among those running, so idling banks no credit.
+//
+// Within a group contexts run highest priority class first, FIFO within a class; the starvation
+// guard and EarliestDeadline ordering apply to the ungrouped contexts only.
+//
+// Charging reads the cycle counter at every switch once a cooperator has run a grouped context,
+// as trackContextCycles does; cooperators without groups pay one predictable branch per switch.
+//
+// A group is single-cooperator state: it binds to the cooperator of its first context, and must
+// outlive every context in it. A context that migrates (Context::MigrateTo) leaves its group.
+//
+struct SchedulingGroup : EmbeddedListHookups<SchedulingGroup>
+{
+    using List = EmbeddedList<SchedulingGroup>;
+
+    struct Statistics
+    {
+        uint64_t runTicks{0};           // cycle-counter ticks charged to the group's contexts
+        uint64_t throttledPeriods{0};   // periods in which the group ran out of budgetUs
+        size_t contexts{0};             // live contexts in the group
+        size_t runnable{0};             // of those, on the run queue
+    };
+
+    explicit SchedulingGroup(SchedulingGroupConfiguration const& config = {})
+    : m_config(config)
+    {
+        assert(m_config.weight > 0);
+    }
+
+    ~SchedulingGroup()
+    {
+        assert(!m_statistics.contexts && "scheduling group destroyed with contexts in it");
+    }
+
+    const char* Name() const { return m_config.name; }
+    uint32_t Weight() const { return m_config.weight; }
+
+    // Takes effect from the next charged slice
+    //
+    void SetWeight(uint32_t weight)
+    {
+        assert(weight > 0);
+        m_config.weight = weight;
+    }
+
+    bool Throttled() const { return m_throttled; }
+
+    Statistics const& GetStatistics() const { return m_statistics; }
+
+  private:
+    friend struct Context;
+    friend struct Cooperator;
+    friend struct detail::RunQueue;
+
+    void Join(Context* ctx);
+    void Leave(Context* ctx);
+
+    // Charge a slice; rolls the budget period over when it has passed
+    //
+    void Charge(int64_t ticks, int64_t now)
+    {
+        m_vruntime += static_cast<uint64_t>(ticks) * SCHEDULING_WEIGHT_DEFAULT / m_config.weight;
+        m_statistics.runTicks += static_cast<uint64_t>(ticks);
+        if (!m_budgetTicks)
+        {
+            return;
+        }
+
+        RollPeriod(now);
+        m_periodUsed += ticks;
+        if (m_periodUsed >= m_budgetTicks && !m_throttled)
+        {
+            m_throttled = true;
+            m_statistics.throttledPeriods++;
+        }
+    }
+
+    void RollPeriod(int64_t now)
+    {
+        if (now - m_periodStart >= m_periodTicks)
+        {
+            m_periodStart = now;
+            m_periodUsed = 0;
+            m_throttled = false;
+        }
+    }
+
+    SchedulingGroupConfiguration m_config;
+    Cooperator* m_cooperator{nullptr};
+
+    // Runnable members, one FIFO per priority class, and the virtual runtime the run queue orders
+    // groups by
+    //
+    Context::ContextStateList m_lists[PRIORITY_CLASSES];
+    uint64_t m_vruntime{0};
+
+    // budgetUs and periodUs in ticks, converted when the group binds; the current period's start
+    // and use
+    //
+    int64_t m_budgetTicks{0};
+    int64_t m_periodTicks{0};
+    int64_t m_periodStart{0};
+    int64_t m_periodUsed{0};
+    bool m_throttled{false};
+
+    Statistics m_statistics;
+};
+
+} // end namespace coop
@@ -0,0 +1,503 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "coop/chan/select.h"
+#include "coop/context.h"
+#include "coop/coordinate_with.h"
+#include "coop/coordinator.h"
+#include "coop/detail/coordinator_extension.h"
+#include "coop/io/handle.h"
+#include "coop/signal.h"
+#include "coop/time/sleep.h"
+
+// Selector -- a reusable, re-armable wait over channels, IO completions, timers and signals.
+//
+//   coop::io::Handle recv(ctx, sock, &recvDone);
+//   coop::io::Recv(recv, buf, len);
+//   coop::time::Sleeper ping(ctx, std::chrono::seconds(5));
+//   ping.Arm();
+//
+//   auto sel = coop::MakeSelector(ctx,
+//       coop::chan::On(control, [&](Command c) { Apply(c); }, [&] { closing = true; }),
+//       coop::OnComplete(recv, [&](int n) { Parse(buf, n); coop::io::Recv(recv, buf, len); }),
+//       coop::OnExpired(ping, [&] { SendPing(); ping.Arm(); }),
+//       coop::OnKill(ctx, [&] { closing = true; }));
+//
+//   while (!closing && sel.Wait() != coop::Selector::DONE) {}
+//
+// chan::Select and CoordinateWith build their waiters on every call: a MultiCoordinator that hooks
+// onto each coordinator, blocks, and unhooks from all of them again. A protocol multiplexer waiting
+// in a loop pays that for every event. A Selector instead hosts one arm per case, as Subscribe
+// does (chan/subscribe.h): each arm is a Continuation registered on its case's coordinator, and it
+// stays registered across Waits. A release queues the arm; its Run marks the case ready and, if
+// the selector's context is parked in Wait, wakes it. Wait then claims the case, runs its handler
+// on the context and re-arms that one case in place. Cases that did not fire are never touched.
+//
+// Handlers run on the waiting context, not in the continuation drain, so unlike Subscribe's they
+// may block, do IO or spawn. When several cases are ready the leftmost fires first, as in
+// CoordinateWith; one Wait fires one case.
+//
+// Cases:
+//
+//   chan::On(ch, fn[, onShutdown])    a value received from ch. A channel that shuts down runs
+//                                      onShutdown and retires the case. (OnSend carries a single
+//                                      value, so it has no place in a reusable selector.)
+//   OnComplete(handle, fn(int))       handle's operation completed, with its result. Add the handle
+//                                      with an operation submitted; resubmit from fn (or later) to
+//                                      be called again.
+//   OnExpired(sleeper, fn())          an Arm()-ed Sleeper expired; Arm it again to be called again.
+//   OnSignal(signal, fn()) / OnKill   a Signal (or the context's kill signal) notified. One-shot:
+//                                      the case retires after fn.
+//
+// Wait returns the index of the case that fired, or DONE once every case has retired; WaitKill
+// also returns KILLED. A selector belongs to one context on one cooperator, and is a named local
+// that must be declared after -- so destroyed before -- everything its cases watch: its arms sit
+// on their coordinators' wait lists until it is destroyed. At most 64 cases.
+//
+
+namespace coop
+{
+
+template<typename OnComplete>
+struct CompletionCase
+{
+    io::Handle& handle;
+    OnComplete  onComplete;
+    bool        fresh = true;
+
+    Coordinator* Coord() { return handle.GetCoordinator(); }
+
+    // Only the first arming looks for a completion that came before it; after that each fire
+    // waits for the next
+    //
+    bool Poll() { return std::exchange(fresh, false) && !Coord()->IsHeld(); }
+    bool Claim() { return !Coord()->IsHeld(); }
+
+    bool Fire()
+    {
+        onComplete(handle.Result());
+        return true;
+    }
+};
+
+template<typename OnExpired>
+struct SleeperCase
+{
+    time::Sleeper& sleeper;
+    OnExpired      onExpired;
+    bool           fresh = true;
+
+    Coordinator* Coord() { return sleeper.GetCoordinator(); }
+
+    bool Poll() { return std::exchange(fresh, false) && !Coord()->IsHeld(); }
+    bool Claim() { return !Coord()->IsHeld(); }
+
+    bool Fire()
+    {
+        onExpired();
+        return true;
+    }
+};
+
+// A notified signal stays notified, so the case fires once and retires. It never acquires the
+// signal's coordinator, which CoordinateWith would have to reset afterwards.
+//
+template<typename OnSignal>
+struct SignalCase
+{
+    Signal&  signal;
+    OnSignal onSignal;
+
+    Coordinator* Coord() { return signal.AsCoordinator(); }
+
+    bool Poll() { return signal.IsSignaled(); }
+    bool Claim() { return true; }
+
+    bool Fire()
+    {
+        onSignal();
+        return false;
+    }
+};
+
+template<typename Fn>
+auto OnComplete(io::Handle& handle, Fn&& fn) -> CompletionCase<std::decay_t<Fn>>
+{
+    return { handle, std::forward<Fn>(fn) };
+}
+
+template<typename Fn>
+auto OnExpired(time::Sleeper& sleeper, Fn&& fn) -> SleeperCase<std::decay_t<Fn>>
+{
+    return { sleeper, std::forward<Fn>(fn) };
+}
+
+template<typename Fn>
+auto OnSignal(Signal& signal, Fn&& fn) -> SignalCase<std::decay_t<Fn>>
+{
+    return { signal, std::forward<Fn>(fn) };
+}
+
+template<typename Fn>
+auto OnKill(Context* ctx, Fn&& fn) -> SignalCase<std::decay_t<Fn>>
+{
+    return { *ctx->GetKilledSignal(), std::forward<Fn>(fn) };
+}
+
+namespace detail
+{
+
+template<typename> struct IsSendCase : std::false_type {};
+template<typename T, typename S, typename D>
+struct IsSendCase<chan::SendCase<T, S, D>> : std::true_type {};
+
+struct SelectorCore;
+
+// The untyped half of an arm: its Coordinated hook, its place in the selector, and the list
+// bookkeeping, which follows Subscribe's ArmBase (m_listed, not Disconnected(), witnesses list
+// membership in release builds). The typed half is reached through four virtuals, one call each
+// per fire.
+//
+struct SelectArmBase : Continuation
+{
+    SelectArmBase(SelectorCore* core, int index)
+    : m_coordinated(static_cast<Continuation*>(this))
+    , m_core(core)
+    , m_index(index)
+    {
+    }
+
+    SelectArmBase(SelectArmBase const&) = delete;
+    SelectArmBase(SelectArmBase&&)      = delete;
+
+    virtual Coordinator* Coord() = 0;
+
+    // Ready without waiting; claim what a release left for us; run the handler, false to retire
+    //
+    virtual bool Poll() = 0;
+    virtual bool Claim() = 0;
+    virtual bool Fire() = 0;
+
+    void Register()
+    {
+        CoordinatorExtension().AddAsBlocked(Coord(), &m_coordinated);
+        m_listed = true;
+    }
+
+    // Defined below the core
+    //
+    void Arm();
+    void Retire();
+    void Run() final;
+
+    Coordinated   m_coordinated;
+    SelectorCore* m_core;
+    int           m_index;
+    bool          m_listed  = false;
+    bool          m_retired = false;
+};
+
+// A case a selector hosts. Channel cases (chan::On) know nothing of selectors: their readiness is
+// the channel invariant, m_recv released <-> non-empty.
+//
+template<typename Case>
+struct SelectArm final : SelectArmBase
+{
+    SelectArm(SelectorCore* core, int index, Case c)
+    : SelectArmBase(core, index)
+    , m_case(std::move(c))
+    {
+    }
+
+    Coordinator* Coord() final { return m_case.Coord(); }
+
+    bool Poll() final
+    {
+        if constexpr (requires { m_case.Poll(); })
+        {
+            return m_case.Poll();
+        }
+        else
+        {
+            return !m_case.Coord()->IsHeld();
+        }
+    }
+
+    bool Claim() final
+    {
+        if constexpr (requires { m_case.Claim(); })
+        {
+            return m_case.Claim();
+        }
+        else
+        {
+            return m_case.Coord()->TryAcquire();
+        }
+    }
+
+    bool Fire() final { return m_case.Fire(); }
+
+    Case m_case;
+};
+
+struct SelectorCore
+{
+    // m_wake starts held: Wait parks on it, and an arm that fires releases it to the parked context
+    //
+    explicit SelectorCore(Context* ctx)
+    : m_context(ctx)
+    , m_wake(ctx)
+    {
+    }
+
+    SelectorCore(SelectorCore const&) = delete;
+    SelectorCore(SelectorCore&&)      = delete;
+
+    void MarkReady(int index)
+    {
+        m_ready |= uint64_t(1) << index;
+        if (m_waiting)
+        {
+            m_waiting = false;
+            m_wake.Release(nullptr, /*schedule=*/false);
+        }
+    }
+
+    int Wait(bool killable);
+
+    Context*        m_context;
+    Coordinator     m_wake;
+    SelectArmBase** m_arms = nullptr;
+    int             m_count = 0;
+    int             m_live = 0;
+    uint64_t        m_ready = 0;
+    bool            m_waiting = false;
+};
+
+inline void SelectArmBase::Arm()
+{
+    if (Poll())
+    {
+        m_core->MarkReady(m_index);
+        return;
+    }
+    Register();
+}
+
+inline void SelectArmBase::Retire()
+{
+    if (m_retired)
+    {
+        return;
+    }
+    m_retired = true;
+    if (m_listed)
+    {
+        m_coordinated.Pop();   // off the coordinator's wait list or the pending-continuation queue
+        m_listed = false;
+    }
+    m_core->m_ready &= ~(uint64_t(1) << m_index);
+    m_core->m_live--;
+}
+
+// The coordinator was released and the drain popped us to run: a plain function call, so all it
+// does is record the case and wake the context
+//
+inline void SelectArmBase::Run()
+{
+    m_listed = false;
+    if (!m_retired)
+    {
+        m_core->MarkReady(m_index);
+    }
+}
+
+// Returns the fired case's index, or -1 (DONE) / -2 (KILLED)
+//
+inline int SelectorCore::Wait(bool killable)
+{
+    for (;;)
+    {
+        while (m_ready)
+        {
+            const int index = std::countr_zero(m_ready);
+            m_ready &= m_ready - 1;
+
+            // Another waiter on the same coordinator may have taken what the release left; the
+            // arm then waits for the next one
+            //
+            auto* arm = m_arms[index];
+            if (!arm->Claim())
+            {
+                arm->Register();
+                continue;
+            }
+            if (arm->Fire())
+            {
+                arm->Arm();
+            }
+            else
+            {
+                arm->Retire();
+            }
+            return index;
+        }
+
+        if (!m_live)
+        {
+            return -1;
+        }
+        if (killable && m_context->IsKilled())
+        {
+            return -2;
+        }
+
+        // A spurious pass -- m_wake released by a kill that lost the race -- just loops: the
+        // acquire re-holds it either way
+        //
+        m_waiting = true;
+        if (killable)
+        {
+            auto result = CoordinateWithKill(m_context, &m_wake);
+            m_waiting = false;
+            if (result.Killed())
+            {
+                return -2;
+            }
+        }
+        else
+        {
+            m_wake.Acquire(m_context);
+            m_waiting = false;
+        }
+    }
+}
+
+// One member per case, constructed in place (the arms are non-movable), as Subscribe's
+// ArmStorage
+//
+template<int I, typename... Cases>
+struct SelectArmStorage;
+
+template<int I>
+struct SelectArmStorage<I>
+{
+    explicit SelectArmStorage(SelectorCore*) {}
+    void Collect(SelectArmBase**) {}
+};
+
+template<int I, typename Case, typename... Rest>
+struct SelectArmStorage<I, Case, Rest...>
+{
+    SelectArmStorage(SelectorCore* core, Case c, Rest... rest)
+    : m_head(core, I, std::move(c))
+    , m_tail(core, std::move(rest)...)
+    {
+    }
+
+    void Collect(SelectArmBase** out)
+    {
+        out[I] = &m_head;
+        m_tail.Collect(out);
+    }
+
+    SelectArm<Case>                 m_head;
+    SelectArmStorage<I + 1, Rest...> m_tail;
+};
+
+template<typename... Cases>
+struct SelectorImpl;
+
+} // end namespace detail
+
+// The case-type-free face of a selector, for code that only waits on it
+//
+struct Selector
+{
+    static constexpr int DONE = -1;
+    static constexpr int KILLED = -2;
+
+    Selector(Selector const&) = delete;
+    Selector(Selector&&)      = delete;
+
+    // Block until a case fires and run its handler; returns the case's index, or DONE once every
+    // case has retired. Not kill-aware, unless an OnKill case makes it so.
+    //
+    int Wait() { return m_core.Wait(false); }
+
+    // Also returns KILLED once the context is killed, without running a case
+    //
+    int WaitKill() { return m_core.Wait(true); }
+
+    // Stop watching a case. Idempotent.
+    //
+    void Retire(int index) { m_core.m_arms[index]->Retire(); }
+
+    bool Live(int index) const { return !m_core.m_arms[index]->m_retired; }
+
+  protected:
+    explicit Selector(Context* ctx)
+    : m_core(ctx)
+    {
+    }
+
+    ~Selector() = default;
+
+    detail::SelectorCore m_core;
+};
+
+namespace detail
+{
+
+template<typename... Cases>
+struct SelectorImpl final : Selector
+{
+    static constexpr int N = static_cast<int>(sizeof...(Cases));
+    static_assert(N > 0 && N <= 64, "a Selector takes 1 to 64 cases");
+    static_assert(!(IsSendCase<Cases>::value || ...),
+        "OnSend carries one value; a reusable Selector takes recv cases only");
+
+    SelectorImpl(Context* ctx, Cases... cases)
+    : Selector(ctx)
+    , m_storage(&m_core, std::move(cases)...)
+    {
+        m_storage.Collect(m_armPtrs);
+        m_core.m_arms  = m_armPtrs;
+        m_core.m_count = N;
+        m_core.m_live  = N;
+        for (auto* arm : m_armPtrs)
+        {
+            arm->Arm();
+        }
+    }
+
+    ~SelectorImpl()
+    {
+        for (auto* arm : m_armPtrs)
+        {
+            arm->Retire();
+        }
+    }
+
+  private:
+    SelectArmStorage<0, Cases...> m_storage;
+    SelectArmBase*                m_armPtrs[N];
+};
+
+} // end namespace detail
+
+// Build a selector over the cases, armed at its final address (guaranteed copy elision). Bind it
+// to a named local; pass it on as Selector&.
+//
+template<typename... Cases>
+[[nodiscard]] detail::SelectorImpl<std::decay_t<Cases>...> MakeSelector(Context* ctx,
+    Cases&&... cases)
+{
+    return detail::SelectorImpl<std::decay_t<Cases>...>(ctx, std::forward<Cases>(cases)...);
+}
+
+} // end namespace coop
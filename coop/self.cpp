@@ -32,3 +32,9 @@ bool ::coop::IsShuttingDown()
 {
     return Cooperator::thread_cooperator->GetUring();
 }
+
+::coop::io::Uring* ::coop::GetStorageUring()
+{
+    auto* storage = Cooperator::thread_cooperator->GetStorageUring();
+    return storage ? storage : Cooperator::thread_cooperator->GetUring();
+}
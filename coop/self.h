@@ -29,4 +29,9 @@ Cooperator* GetCooperator();
 
 io::Uring* GetUring();
 
+// The calling cooperator's storage ring (CooperatorConfiguration::storage), or its own ring when
+// it has none
+//
+io::Uring* GetStorageUring();
+
 } // end namespace coop
@@ -0,0 +1,83 @@
+#include "semaphore.h"
+
+#include <cassert>
+
+namespace coop
+{
+
+Semaphore::Semaphore(size_t permits)
+: m_available(permits)
+{
+}
+
+Semaphore::~Semaphore()
+{
+    assert((m_waiters.IsEmpty() || detail::CooperatorIsShuttingDown())
+           && "semaphore destroyed with waiters still queued");
+}
+
+bool Semaphore::TryAcquire(size_t n /* = 1 */)
+{
+    // Nobody waiting means nobody to overtake: whoever is at the head of the line is owed
+    // whatever Release frees next
+    //
+    if (m_waiting == 0 && m_available >= n)
+    {
+        m_available -= n;
+        return true;
+    }
+    return false;
+}
+
+void Semaphore::Acquire(Context* ctx, size_t n /* = 1 */)
+{
+    AcquireWith(ctx, n);
+}
+
+void Semaphore::Release(size_t n /* = 1 */)
+{
+    m_available += n;
+    Grant();
+}
+
+void Semaphore::Enqueue(Waiter* waiter)
+{
+    m_waiters.Push(waiter);
+    m_waiting++;
+}
+
+// Grant pops a waiter and takes its permits before releasing it, so a waiter found granted holds
+// them however its wait ended. One that lost -- to the kill signal, a timeout or another
+// coordinator -- gives them back; one never granted leaves the line, which may let a smaller
+// request behind it through.
+//
+CoordinationResult Semaphore::Settle(Waiter& waiter, CoordinationResult result)
+{
+    if (!waiter.granted)
+    {
+        m_waiters.Remove(&waiter);
+        m_waiting--;
+        Grant();
+        return result;
+    }
+    if (result.index != 0)
+    {
+        Release(waiter.want);
+        return result;
+    }
+    return CoordinationResult{0, nullptr};
+}
+
+void Semaphore::Grant()
+{
+    while (!m_waiters.IsEmpty() && m_waiters.Peek()->want <= m_available)
+    {
+        auto* waiter = m_waiters.Pop();
+        m_waiting--;
+        m_available -= waiter->want;
+        waiter->granted = true;
+        waiter->coord.Release(nullptr, false);
+    }
+}
+
+} // end namespace coop
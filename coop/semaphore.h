@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+
+#include "context.h"
+#include "coordinate_with.h"
+#include "coordination_result.h"
+#include "coordinator.h"
+#include "detail/embedded_list.h"
+#include "shared_stack.h"
+
+namespace coop
+{
+
+// Semaphore is a counting semaphore for the contexts of one cooperator: a pool of permits, taken
+// one or several at a time and given back in any amounts.
+//
+//  coop::Semaphore slots(8);                   // at most 8 fetches in flight
+//
+//  slots.Acquire(ctx);
+//  Fetch(...);
+//  slots.Release();
+//
+//  auto r = slots.AcquireWithKill(ctx, 4, std::chrono::milliseconds(50));
+//  if (r.index == 0) { ... }                   // 4 permits held
+//
+// Waiters are served strictly in arrival order, a batch included: a request for 4 at the head
+// holds back a request for 1 behind it even when one permit is free, so large requests are not
+// starved. An uncontended acquire is a compare and a subtraction; only a context that has to
+// wait builds a waiter, which Release hands its permits to directly.
+//
+// AcquireWith and AcquireWithKill wait as CoordinateWith and CoordinateWithKill do, taking the
+// same extra arguments -- more coordinators or signals, and a trailing time::Interval -- after
+// the semaphore, which is index 0 of the result. Index 0 means the permits are held (the result
+// has no coordinator for it: a semaphore has none to hand back); any other index or sentinel
+// means none are.
+//
+struct Semaphore
+{
+    Semaphore(Semaphore const&) = delete;
+    Semaphore(Semaphore&&) = delete;
+
+    explicit Semaphore(size_t permits);
+
+    // Waiters would be left parked on a wait list that no longer exists
+    //
+    ~Semaphore();
+
+    // Take n permits if they are free and nobody is waiting ahead
+    //
+    bool TryAcquire(size_t n = 1);
+
+    // Block until n permits are held. Not kill-aware, like Coordinator::Acquire.
+    //
+    void Acquire(Context* ctx, size_t n = 1);
+
+    template<typename... Args>
+    CoordinationResult AcquireWith(Context* ctx, size_t n, Args... args);
+
+    template<typename... Args>
+    CoordinationResult AcquireWithKill(Context* ctx, size_t n, Args... args);
+
+    // Give n permits back, handing them to waiters in order. The woken waiters run later (the
+    // caller carries on), so Release is safe from continuations and callbacks too.
+    //
+    void Release(size_t n = 1);
+
+    size_t Available() const { return m_available; }
+    size_t Waiting() const { return m_waiting; }
+
+  private:
+    struct Waiter : EmbeddedListHookups<Waiter>
+    {
+        Waiter(Context* ctx, size_t n) : coord(ctx), want(n) {}
+
+        Coordinator     coord;              // held until granted
+        size_t          want;
+        bool            granted = false;
+    };
+
+    void Enqueue(Waiter* waiter);
+    CoordinationResult Settle(Waiter& waiter, CoordinationResult result);
+    void Grant();
+
+    size_t                  m_available;
+    size_t                  m_waiting = 0;
+    EmbeddedList<Waiter>    m_waiters;
+};
+
+template<typename... Args>
+CoordinationResult Semaphore::AcquireWith(Context* ctx, size_t n, Args... args)
+{
+    if (TryAcquire(n))
+    {
+        return CoordinationResult{0, nullptr};
+    }
+
+    detail::WaitStorage<Waiter> stored(ctx, ctx, n);
+    Waiter& waiter = *stored.Get();
+    Enqueue(&waiter);
+    return Settle(waiter, CoordinateWith(ctx, &waiter.coord, args...));
+}
+
+template<typename... Args>
+CoordinationResult Semaphore::AcquireWithKill(Context* ctx, size_t n, Args... args)
+{
+    if (ctx->IsKilled())
+    {
+        return CoordinationResult{static_cast<size_t>(-1), nullptr};
+    }
+    if (TryAcquire(n))
+    {
+        return CoordinationResult{0, nullptr};
+    }
+
+    detail::WaitStorage<Waiter> stored(ctx, ctx, n);
+    Waiter& waiter = *stored.Get();
+    Enqueue(&waiter);
+    return Settle(waiter, CoordinateWithKill(ctx, &waiter.coord, args...));
+}
+
+} // end namespace coop
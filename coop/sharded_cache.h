@@ -0,0 +1,672 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "context.h"
+#include "cooperator.h"
+#include "cooperator.hpp"
+#include "cooperator_group.h"
+#include "remote_coordinator.h"
+#include "self.h"
+#include "wait_group.h"
+#include "chan/passage.h"
+
+namespace coop
+{
+
+// Options for ShardedCache.
+//
+struct ShardedCacheConfiguration
+{
+    // Entries across every shard, each shard taking an equal part rounded up to a power-of-two
+    // count of buckets
+    //
+    size_t capacity = size_t(1) << 16;
+
+    // Most requests a shard's server takes from its inbox per wake
+    //
+    size_t batch = 64;
+};
+
+// ShardedCache is an in-process key-value cache split into one shard per owning cooperator,
+// each shard touched only by its owner's thread: shared-nothing, so nothing on the lookup path
+// is locked or atomic beyond the counters.
+//
+//  coop::CooperatorGroup group(0);
+//  ...
+//  coop::ShardedCache<uint64_t, Session> sessions(ctx, group);     // from a context
+//
+//  sessions.Put(ctx, id, session);
+//  if (auto session = sessions.Get(ctx, id)) { ... }
+//
+// A key's shard is fixed by its hash. Called on the shard's owner, Get, Put and Erase are plain
+// function calls into the shard's table. Called anywhere else, they are requests sent to the
+// owner through its shard's Passage -- a MSG_RING wake between cooperators -- and answered there
+// by the shard's server context, which takes up to ShardedCacheConfiguration::batch requests per
+// wake. GetMany sends each shard its keys in one SendBatch and waits once for all of them, so a
+// fan-out across n shards costs n sends and one wake back, not one round trip per key.
+//
+// Buckets are set-associative rather than chained: a key hashes to one bucket of kWays entries,
+// whose header -- a byte tag per way, the occupied and referenced masks and a clock hand -- is 16
+// bytes, four to a cache line. A lookup reads the header and compares keys only where the tag
+// matches. A full bucket evicts by CLOCK: the hand clears referenced bits until it finds an entry
+// not read since it last passed. A new entry starts unreferenced, so one never read again is the
+// first to go, ahead of any that has been.
+//
+// The cache is built and destroyed on one cooperator, from a context, and must not be destroyed
+// while any call is in flight. The owners must outlive it. Every call takes the calling context,
+// which a remote call blocks until the owner has answered; a missing shard answers as a miss.
+// A remote call's key, result and waiter stay in the caller's frames for the owner to use, so it
+// may not be made from a shared-stack context.
+//
+template<typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+struct ShardedCache
+{
+    static constexpr size_t kWays = 8;
+    static constexpr size_t kInbox = 1024;
+
+    ShardedCache(ShardedCache const&) = delete;
+    ShardedCache(ShardedCache&&) = delete;
+
+    // One shard per owner, served by a context each owner is given here. Returns once every
+    // shard is up.
+    //
+    ShardedCache(Context* ctx, std::vector<Cooperator*> const& owners,
+                 ShardedCacheConfiguration const& config = {});
+
+    // One shard per member of group
+    //
+    ShardedCache(Context* ctx, CooperatorGroup& group,
+                 ShardedCacheConfiguration const& config = {});
+
+    // Stops every shard's server and waits for them. On the cooperator that built it.
+    //
+    ~ShardedCache();
+
+    // A copy of key's value, or nullopt. A hit marks the entry referenced.
+    //
+    std::optional<V> Get(Context* ctx, K const& key);
+
+    // Add key or replace its value, evicting from its bucket if the bucket is full
+    //
+    void Put(Context* ctx, K key, V value);
+
+    // False if key was not cached
+    //
+    bool Erase(Context* ctx, K const& key);
+
+    // Get for every key, into out[i] for keys[i]: local shards are read directly and each remote
+    // shard is sent its keys as one batch
+    //
+    void GetMany(Context* ctx, std::span<K const> keys, std::optional<V>* out);
+
+    size_t ShardCount() const { return m_shards.size(); }
+    size_t ShardOf(K const& key) const { return ShardFor(Mix(m_hash(key))); }
+    Cooperator* OwnerOf(K const& key) const { return m_shards[ShardOf(key)]->owner; }
+
+    // Sums across the shards, each read without stopping it
+    //
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t inserts;
+        uint64_t evictions;
+        uint64_t remote;        // requests a server answered for another cooperator
+        uint64_t batches;       // inbox wakes those requests arrived in
+        size_t   entries;
+    };
+
+    Stats GetStats() const;
+
+  private:
+    // One remote call's completion: the last request answered releases done, which the caller
+    // holds while it waits
+    //
+    struct Waiter
+    {
+        std::atomic<size_t> remaining;
+        RemoteCoordinator   done;
+    };
+
+    enum class Op : uint8_t
+    {
+        Get,
+        Put,
+        Erase,
+    };
+
+    struct Request
+    {
+        Op                  op;
+        bool                found = false;
+        size_t              hash;
+        K const*            key;
+        V*                  in = nullptr;           // Put: moved into the entry
+        std::optional<V>*   out = nullptr;          // Get: the hit, copied
+        Waiter*             waiter;
+    };
+
+    struct alignas(16) Bucket
+    {
+        uint8_t tags[kWays];
+        uint8_t used = 0;
+        uint8_t referenced = 0;
+        uint8_t hand = 0;
+    };
+
+    static_assert(sizeof(Bucket) == 16);
+
+    union Slot
+    {
+        Slot() {}
+        ~Slot() {}
+
+        std::pair<K, V> entry;
+    };
+
+    // A shard's table, its counters and its inbox. Only the owner's thread touches the table;
+    // the counters are written there and may be read from anywhere.
+    //
+    struct Shard
+    {
+        Shard(Cooperator* owner, size_t buckets)
+        : owner(owner)
+        , mask(buckets - 1)
+        , buckets(new Bucket[buckets])
+        , slots(new Slot[buckets * kWays])
+        {
+        }
+
+        ~Shard();
+
+        Cooperator*                 owner;
+        size_t                      mask;
+        std::unique_ptr<Bucket[]>   buckets;
+        std::unique_ptr<Slot[]>     slots;
+
+        std::unique_ptr<chan::Passage<Request*, kInbox>> inbox;
+        std::atomic<bool>           stopped{false};
+
+        std::atomic<uint64_t>       hits{0};
+        std::atomic<uint64_t>       misses{0};
+        std::atomic<uint64_t>       inserts{0};
+        std::atomic<uint64_t>       evictions{0};
+        std::atomic<uint64_t>       remote{0};
+        std::atomic<uint64_t>       batches{0};
+        std::atomic<size_t>         entries{0};
+    };
+
+    // Spread std::hash's output, which is the identity for integers, before taking bits from it
+    //
+    static size_t Mix(size_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // The shard from the high bits, the bucket from the low and the tag from the middle
+    //
+    size_t ShardFor(size_t hash) const
+    {
+        return static_cast<size_t>((static_cast<unsigned __int128>(hash) * m_shards.size()) >> 64);
+    }
+
+    static uint8_t TagFor(size_t hash) { return static_cast<uint8_t>(hash >> 32); }
+
+    static void Bump(std::atomic<uint64_t>& counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // ---- On the owner ----
+
+    int FindWay(Shard& shard, size_t hash, K const& key) const;
+    bool Lookup(Shard& shard, size_t hash, K const& key, std::optional<V>* out);
+    void Insert(Shard& shard, size_t hash, K const& key, V&& value);
+    bool Remove(Shard& shard, size_t hash, K const& key);
+    void Apply(Shard& shard, Request& request);
+
+    void Serve(Context* ctx, size_t index);
+
+    // ---- On the caller ----
+
+    void Finish(Request* request);
+    void Send(Context* ctx, Shard& shard, std::span<Request*> requests);
+    void Call(Context* ctx, Shard& shard, Request& request);
+
+    Hash                                m_hash;
+    KeyEqual                            m_equal;
+    ShardedCacheConfiguration           m_config;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    WaitGroup                           m_ready;
+    WaitGroup                           m_servers;
+};
+
+// ---------------------------------------------------------------------------------------------
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+ShardedCache<K, V, Hash, KeyEqual>::Shard::~Shard()
+{
+    for (size_t b = 0; b <= mask; b++)
+    {
+        for (size_t way = 0; way < kWays; way++)
+        {
+            if (buckets[b].used & (1u << way))
+            {
+                slots[b * kWays + way].entry.~pair();
+            }
+        }
+    }
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+ShardedCache<K, V, Hash, KeyEqual>::ShardedCache(Context* ctx,
+                                                 std::vector<Cooperator*> const& owners,
+                                                 ShardedCacheConfiguration const& config)
+: m_config(config)
+{
+    assert(!owners.empty() && "a ShardedCache needs at least one owner");
+    assert(m_config.batch > 0);
+
+    size_t perShard = (m_config.capacity + owners.size() - 1) / owners.size();
+    size_t buckets = 1;
+    while (buckets * kWays < perShard)
+    {
+        buckets <<= 1;
+    }
+
+    // The tables are allocated here; each server builds its shard's inbox on its own cooperator
+    //
+    m_shards.reserve(owners.size());
+    for (auto* owner : owners)
+    {
+        m_shards.push_back(std::make_unique<Shard>(owner, buckets));
+    }
+
+    m_ready.Add(static_cast<int64_t>(owners.size()));
+    m_servers.Add(static_cast<int64_t>(owners.size()));
+    for (size_t i = 0; i < owners.size(); i++)
+    {
+        bool started = owners[i]->Cooperate([this, i](Context* serverCtx)
+        {
+            Serve(serverCtx, i);
+        });
+        if (!started)
+        {
+            m_shards[i]->stopped.store(true, std::memory_order_release);
+            m_ready.Done();
+            m_servers.Done();
+        }
+    }
+    m_ready.Wait(ctx);
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+ShardedCache<K, V, Hash, KeyEqual>::ShardedCache(Context* ctx, CooperatorGroup& group,
+                                                 ShardedCacheConfiguration const& config)
+: ShardedCache(ctx, [&group]
+    {
+        std::vector<Cooperator*> owners;
+        for (int i = 0; i < group.Size(); i++)
+        {
+            owners.push_back(group.At(i));
+        }
+        return owners;
+    }(), config)
+{
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+ShardedCache<K, V, Hash, KeyEqual>::~ShardedCache()
+{
+    for (auto& shard : m_shards)
+    {
+        if (shard->inbox)
+        {
+            shard->inbox->Shutdown();
+        }
+    }
+    m_servers.Wait(Self());
+}
+
+// A shard's server: its inbox is built on the owner, since a Passage belongs to its receiver,
+// then every batch of requests is applied and answered in arrival order. On the way out the
+// inbox is shut and what it still holds is answered, so no caller is left waiting.
+//
+template<typename K, typename V, typename Hash, typename KeyEqual>
+void ShardedCache<K, V, Hash, KeyEqual>::Serve(Context* ctx, size_t index)
+{
+    ctx->SetName("ShardedCache");
+    Shard& shard = *m_shards[index];
+    shard.inbox = std::make_unique<chan::Passage<Request*, kInbox>>(ctx, ctx->GetCooperator());
+    m_ready.Done();
+
+    std::vector<Request*> batch(m_config.batch);
+    while (size_t n = shard.inbox->RecvBatch(batch))
+    {
+        Bump(shard.batches);
+        for (size_t i = 0; i < n; i++)
+        {
+            Apply(shard, *batch[i]);
+            Finish(batch[i]);
+        }
+    }
+
+    shard.stopped.store(true, std::memory_order_release);
+    shard.inbox->Shutdown();
+    Request* request;
+    while (shard.inbox->TryRecv(request))
+    {
+        Finish(request);
+    }
+    m_servers.Done();
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+int ShardedCache<K, V, Hash, KeyEqual>::FindWay(Shard& shard, size_t hash, K const& key) const
+{
+    size_t b = hash & shard.mask;
+    Bucket const& bucket = shard.buckets[b];
+    uint8_t tag = TagFor(hash);
+    for (unsigned way = 0; way < kWays; way++)
+    {
+        if ((bucket.used & (1u << way)) && bucket.tags[way] == tag
+            && m_equal(shard.slots[b * kWays + way].entry.first, key))
+        {
+            return static_cast<int>(way);
+        }
+    }
+    return -1;
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+bool ShardedCache<K, V, Hash, KeyEqual>::Lookup(Shard& shard, size_t hash, K const& key,
+                                                std::optional<V>* out)
+{
+    int way = FindWay(shard, hash, key);
+    if (way < 0)
+    {
+        Bump(shard.misses);
+        return false;
+    }
+
+    size_t b = hash & shard.mask;
+    shard.buckets[b].referenced |= static_cast<uint8_t>(1u << way);
+    *out = shard.slots[b * kWays + way].entry.second;
+    Bump(shard.hits);
+    return true;
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+void ShardedCache<K, V, Hash, KeyEqual>::Insert(Shard& shard, size_t hash, K const& key,
+                                                V&& value)
+{
+    size_t b = hash & shard.mask;
+    Bucket& bucket = shard.buckets[b];
+    if (int way = FindWay(shard, hash, key); way >= 0)
+    {
+        shard.slots[b * kWays + way].entry.second = std::move(value);
+        return;
+    }
+
+    unsigned way;
+    if (bucket.used != 0xff)
+    {
+        way = static_cast<unsigned>(__builtin_ctz(~bucket.used & 0xffu));
+    }
+    else
+    {
+        // CLOCK: a referenced entry gets one more pass of the hand; at most kWays + 1 steps
+        //
+        for (;;)
+        {
+            way = bucket.hand;
+            bucket.hand = static_cast<uint8_t>((bucket.hand + 1) % kWays);
+            uint8_t bit = static_cast<uint8_t>(1u << way);
+            if (!(bucket.referenced & bit))
+            {
+                break;
+            }
+            bucket.referenced &= static_cast<uint8_t>(~bit);
+        }
+        shard.slots[b * kWays + way].entry.~pair();
+        bucket.used &= static_cast<uint8_t>(~(1u << way));
+        Bump(shard.evictions);
+        shard.entries.store(shard.entries.load(std::memory_order_relaxed) - 1,
+                            std::memory_order_relaxed);
+    }
+
+    new (&shard.slots[b * kWays + way].entry) std::pair<K, V>(key, std::move(value));
+    bucket.tags[way] = TagFor(hash);
+    bucket.used |= static_cast<uint8_t>(1u << way);
+    bucket.referenced &= static_cast<uint8_t>(~(1u << way));
+    Bump(shard.inserts);
+    shard.entries.store(shard.entries.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+bool ShardedCache<K, V, Hash, KeyEqual>::Remove(Shard& shard, size_t hash, K const& key)
+{
+    int way = FindWay(shard, hash, key);
+    if (way < 0)
+    {
+        return false;
+    }
+
+    size_t b = hash & shard.mask;
+    shard.slots[b * kWays + way].entry.~pair();
+    shard.buckets[b].used &= static_cast<uint8_t>(~(1u << way));
+    shard.entries.store(shard.entries.load(std::memory_order_relaxed) - 1,
+                        std::memory_order_relaxed);
+    return true;
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+void ShardedCache<K, V, Hash, KeyEqual>::Apply(Shard& shard, Request& request)
+{
+    Bump(shard.remote);
+    switch (request.op)
+    {
+    case Op::Get:
+        request.found = Lookup(shard, request.hash, *request.key, request.out);
+        break;
+    case Op::Put:
+        Insert(shard, request.hash, *request.key, std::move(*request.in));
+        request.found = true;
+        break;
+    case Op::Erase:
+        request.found = Remove(shard, request.hash, *request.key);
+        break;
+    }
+}
+
+// Count one request of a call answered (or abandoned); the last wakes the caller. The waiter
+// lives on the caller's frame and may be gone as soon as done is released.
+//
+template<typename K, typename V, typename Hash, typename KeyEqual>
+void ShardedCache<K, V, Hash, KeyEqual>::Finish(Request* request)
+{
+    Waiter* waiter = request->waiter;
+    if (waiter->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        waiter->done.Release();
+    }
+}
+
+// Push requests into shard's inbox, yielding while it is full. A shard that has stopped answers
+// the rest itself, as misses.
+//
+template<typename K, typename V, typename Hash, typename KeyEqual>
+void ShardedCache<K, V, Hash, KeyEqual>::Send(Context* ctx, Shard& shard,
+                                              std::span<Request*> requests)
+{
+    while (!requests.empty())
+    {
+        size_t sent = 0;
+        if (!shard.stopped.load(std::memory_order_acquire) && shard.inbox)
+        {
+            sent = shard.inbox->SendBatch(requests);
+        }
+        if (sent == 0)
+        {
+            if (shard.stopped.load(std::memory_order_acquire))
+            {
+                for (auto* request : requests)
+                {
+                    Finish(request);
+                }
+                return;
+            }
+            ctx->Yield();
+        }
+        requests = requests.subspan(sent);
+    }
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+void ShardedCache<K, V, Hash, KeyEqual>::Call(Context* ctx, Shard& shard, Request& request)
+{
+    assert(!ctx->IsSharedStack() && "ShardedCache: remote calls need a stack of their own");
+    Waiter waiter;
+    waiter.remaining.store(1, std::memory_order_relaxed);
+    waiter.done.TryAcquire();
+    request.waiter = &waiter;
+
+    Request* one = &request;
+    Send(ctx, shard, std::span<Request*>(&one, 1));
+    waiter.done.Acquire(ctx);
+    waiter.done.Release();
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+std::optional<V> ShardedCache<K, V, Hash, KeyEqual>::Get(Context* ctx, K const& key)
+{
+    size_t hash = Mix(m_hash(key));
+    Shard& shard = *m_shards[ShardFor(hash)];
+    std::optional<V> out;
+    if (shard.owner == Cooperator::thread_cooperator)
+    {
+        Lookup(shard, hash, key, &out);
+        return out;
+    }
+
+    Request request{.op = Op::Get, .hash = hash, .key = &key, .out = &out};
+    Call(ctx, shard, request);
+    return out;
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+void ShardedCache<K, V, Hash, KeyEqual>::Put(Context* ctx, K key, V value)
+{
+    size_t hash = Mix(m_hash(key));
+    Shard& shard = *m_shards[ShardFor(hash)];
+    if (shard.owner == Cooperator::thread_cooperator)
+    {
+        Insert(shard, hash, key, std::move(value));
+        return;
+    }
+
+    Request request{.op = Op::Put, .hash = hash, .key = &key, .in = &value};
+    Call(ctx, shard, request);
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+bool ShardedCache<K, V, Hash, KeyEqual>::Erase(Context* ctx, K const& key)
+{
+    size_t hash = Mix(m_hash(key));
+    Shard& shard = *m_shards[ShardFor(hash)];
+    if (shard.owner == Cooperator::thread_cooperator)
+    {
+        return Remove(shard, hash, key);
+    }
+
+    Request request{.op = Op::Erase, .hash = hash, .key = &key};
+    Call(ctx, shard, request);
+    return request.found;
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+void ShardedCache<K, V, Hash, KeyEqual>::GetMany(Context* ctx, std::span<K const> keys,
+                                                 std::optional<V>* out)
+{
+    std::vector<Request> requests;
+    requests.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        out[i].reset();
+        size_t hash = Mix(m_hash(keys[i]));
+        Shard& shard = *m_shards[ShardFor(hash)];
+        if (shard.owner == Cooperator::thread_cooperator)
+        {
+            Lookup(shard, hash, keys[i], &out[i]);
+            continue;
+        }
+        requests.push_back(Request{.op = Op::Get, .hash = hash, .key = &keys[i], .out = &out[i]});
+    }
+    if (requests.empty())
+    {
+        return;
+    }
+
+    assert(!ctx->IsSharedStack() && "ShardedCache: remote calls need a stack of their own");
+    Waiter waiter;
+    waiter.remaining.store(requests.size(), std::memory_order_relaxed);
+    waiter.done.TryAcquire();
+
+    // Grouped by shard, so each shard's keys go in one SendBatch and wake its server once
+    //
+    std::vector<Request*> group;
+    group.reserve(requests.size());
+    for (size_t s = 0; s < m_shards.size(); s++)
+    {
+        group.clear();
+        for (auto& request : requests)
+        {
+            if (ShardFor(request.hash) == s)
+            {
+                request.waiter = &waiter;
+                group.push_back(&request);
+            }
+        }
+        if (!group.empty())
+        {
+            Send(ctx, *m_shards[s], group);
+        }
+    }
+    waiter.done.Acquire(ctx);
+    waiter.done.Release();
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+typename ShardedCache<K, V, Hash, KeyEqual>::Stats
+ShardedCache<K, V, Hash, KeyEqual>::GetStats() const
+{
+    Stats stats{};
+    for (auto const& shard : m_shards)
+    {
+        stats.hits += shard->hits.load(std::memory_order_relaxed);
+        stats.misses += shard->misses.load(std::memory_order_relaxed);
+        stats.inserts += shard->inserts.load(std::memory_order_relaxed);
+        stats.evictions += shard->evictions.load(std::memory_order_relaxed);
+        stats.remote += shard->remote.load(std::memory_order_relaxed);
+        stats.batches += shard->batches.load(std::memory_order_relaxed);
+        stats.entries += shard->entries.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+} // end namespace coop
@@ -0,0 +1,76 @@
+#include "sharded_counter.h"
+
+#include <cassert>
+#include <thread>
+
+#include "cooperator.h"
+
+namespace coop
+{
+namespace detail
+{
+
+CooperatorVar<ShardedSlots> s_shardedSlots;
+
+size_t ShardedMetricRegistry::Register(const char* name, const char* help, bool gauge)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t slot = m_count.load(std::memory_order_relaxed);
+    assert(slot < SHARDED_METRIC_SLOTS && "more sharded metrics than SHARDED_METRIC_SLOTS");
+    m_entries[slot] = Entry{name, help ? help : "", gauge};
+    m_count.store(slot + 1, std::memory_order_release);
+    return slot;
+}
+
+uint64_t ShardedMetricRegistry::Sum(size_t slot) const
+{
+    // The retired total and the live slots are read between two loads of the retirement count,
+    // so a cooperator retiring meanwhile is counted once: in the visit or in the total, never
+    // both, and never neither. An overlapping retirement, once per cooperator exit, costs a retry.
+    //
+    for (;;)
+    {
+        uint64_t seq = m_retireSeq.load(std::memory_order_acquire);
+        if (seq & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint64_t sum = m_retired[slot].load(std::memory_order_relaxed);
+        Cooperator::VisitRegistry([&](Cooperator* co) -> bool
+        {
+            sum += ShardedLocal(slot, co);
+            return true;
+        });
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_retireSeq.load(std::memory_order_relaxed) == seq)
+        {
+            return sum;
+        }
+    }
+}
+
+void RetireShardedSlots(Cooperator* co)
+{
+    auto& registry = ShardedMetricRegistry::Instance();
+    uint64_t seq = registry.m_retireSeq.load(std::memory_order_relaxed);
+    registry.m_retireSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t count = registry.Count();
+    for (size_t slot = 0; slot < count; slot++)
+    {
+        uint64_t value = ShardedLocal(slot, co);
+        if (value)
+        {
+            registry.m_retired[slot].fetch_add(value, std::memory_order_relaxed);
+            s_shardedSlots.Get(co)->values[slot].store(0, std::memory_order_relaxed);
+        }
+    }
+    registry.m_retireSeq.store(seq + 2, std::memory_order_release);
+}
+
+} // end namespace coop::detail
+} // end namespace coop
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "cooperator_var.hpp"
+
+// ShardedCounter and ShardedGauge are application metrics -- requests served, bytes out, cache
+// hits, connections open -- kept per cooperator instead of in one shared std::atomic. Every
+// cooperator adds into a slot of its own with a plain load and store, so a hot counter costs what
+// an integer increment does and no cacheline moves between cores. Reading sums the slots of every
+// live cooperator (Cooperator::VisitRegistry), plus what cooperators that have exited left behind.
+//
+//   // file scope, like a CooperatorVar
+//   static coop::ShardedCounter s_served("http_requests_served", "Requests answered");
+//   static coop::ShardedGauge   s_open("http_connections_open", "Connections not yet closed");
+//
+//   s_served.Add();                     // from any cooperating code
+//   s_open.Add(1); ... s_open.Sub(1);   // may close on another cooperator than it opened on
+//
+//   uint64_t served = s_served.Value(); // from any thread
+//
+// The slots for every metric live in one CooperatorVar, a cacheline-aligned block in each
+// cooperator's inline storage: the owner is the only writer, and a reader's relaxed loads of
+// aligned 64-bit words cannot tear. A reader may miss adds still in flight, and the sum is not a
+// snapshot across cooperators -- fine for metrics, not for anything that must balance exactly.
+//
+// Off a cooperator, Add falls back to a shared atomic: correct, at the cost the type exists to
+// avoid.
+//
+// Every metric is exported by GenerateOpenMetrics (http/metrics.h) under its own name, one sample
+// per cooperator: "<name>_total" for a counter, "<name>" for a gauge. Metrics take one of
+// SHARDED_METRIC_SLOTS slots each and never give it back, so declare them at namespace scope or
+// in objects that live as long as the process.
+//
+
+namespace coop
+{
+
+struct Cooperator;
+
+static constexpr size_t SHARDED_METRIC_SLOTS = 128;
+
+namespace detail
+{
+
+struct ShardedSlots
+{
+    alignas(64) std::atomic<uint64_t> values[SHARDED_METRIC_SLOTS] = {};
+};
+
+extern CooperatorVar<ShardedSlots> s_shardedSlots;
+
+struct ShardedMetricRegistry
+{
+    struct Entry
+    {
+        const char* name;
+        const char* help;
+        bool gauge;
+    };
+
+    static ShardedMetricRegistry& Instance()
+    {
+        static ShardedMetricRegistry s_instance;
+        return s_instance;
+    }
+
+    size_t Register(const char* name, const char* help, bool gauge);
+
+    // Metrics registered so far. An entry is written before the count that covers it is
+    // published, so a reader on another thread sees only complete entries.
+    //
+    size_t Count() const { return m_count.load(std::memory_order_acquire); }
+
+    Entry const& At(size_t i) const { return m_entries[i]; }
+
+    // Sum of slot across live cooperators and retired ones
+    //
+    uint64_t Sum(size_t slot) const;
+
+    // What cooperators that have exited added, and what was added off any cooperator
+    //
+    std::atomic<uint64_t> m_retired[SHARDED_METRIC_SLOTS] = {};
+
+    // Odd while RetireShardedSlots moves a cooperator's values into m_retired: a Sum that overlaps
+    // one starts again
+    //
+    std::atomic<uint64_t> m_retireSeq{0};
+
+  private:
+    ShardedMetricRegistry() = default;
+
+    std::mutex              m_mutex;
+    Entry                   m_entries[SHARDED_METRIC_SLOTS] = {};
+    std::atomic<size_t>     m_count{0};
+};
+
+// Fold an exiting cooperator's slots into the retired totals. Cooperator::Launch calls it under
+// the registry lock, just before it deregisters; m_retireSeq makes a Sum that overlaps it retry,
+// so a reader never sees the values twice or not at all.
+//
+void RetireShardedSlots(Cooperator* co);
+
+inline void ShardedAdd(size_t slot, uint64_t n)
+{
+    if (Cooperator::thread_cooperator) [[likely]]
+    {
+        auto& value = s_shardedSlots->values[slot];
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        return;
+    }
+    ShardedMetricRegistry::Instance().m_retired[slot].fetch_add(n, std::memory_order_relaxed);
+}
+
+inline uint64_t ShardedLocal(size_t slot, Cooperator* co)
+{
+    return s_shardedSlots.Get(co)->values[slot].load(std::memory_order_relaxed);
+}
+
+} // end namespace coop::detail
+
+struct ShardedCounter
+{
+    ShardedCounter(ShardedCounter const&) = delete;
+    ShardedCounter(ShardedCounter&&) = delete;
+
+    ShardedCounter(const char* name, const char* help = "")
+    : m_slot(detail::ShardedMetricRegistry::Instance().Register(name, help, false))
+    {
+    }
+
+    void Add(uint64_t n = 1) { detail::ShardedAdd(m_slot, n); }
+
+    // The total across the process
+    //
+    uint64_t Value() const { return detail::ShardedMetricRegistry::Instance().Sum(m_slot); }
+
+    // What co has added. Only co's thread, or a reader holding it registered, may ask.
+    //
+    uint64_t Value(Cooperator* co) const { return detail::ShardedLocal(m_slot, co); }
+
+  private:
+    size_t m_slot;
+};
+
+// A level rather than a count: adds and subtracts may land on different cooperators, so one
+// cooperator's share can be negative while the total is not
+//
+struct ShardedGauge
+{
+    ShardedGauge(ShardedGauge const&) = delete;
+    ShardedGauge(ShardedGauge&&) = delete;
+
+    ShardedGauge(const char* name, const char* help = "")
+    : m_slot(detail::ShardedMetricRegistry::Instance().Register(name, help, true))
+    {
+    }
+
+    void Add(int64_t n = 1) { detail::ShardedAdd(m_slot, static_cast<uint64_t>(n)); }
+    void Sub(int64_t n = 1) { detail::ShardedAdd(m_slot, static_cast<uint64_t>(-n)); }
+
+    int64_t Value() const
+    {
+        return static_cast<int64_t>(detail::ShardedMetricRegistry::Instance().Sum(m_slot));
+    }
+
+    int64_t Value(Cooperator* co) const
+    {
+        return static_cast<int64_t>(detail::ShardedLocal(m_slot, co));
+    }
+
+  private:
+    size_t m_slot;
+};
+
+} // end namespace coop
@@ -0,0 +1,147 @@
+#include "shared_coordinator.h"
+
+#include <cassert>
+
+namespace coop
+{
+
+SharedCoordinator::SharedCoordinator(Preference preference /* = Preference::Writers */)
+: m_preference(preference)
+{
+}
+
+SharedCoordinator::~SharedCoordinator()
+{
+    assert((m_waiters.IsEmpty() || detail::CooperatorIsShuttingDown())
+           && "shared coordinator destroyed with waiters still queued");
+}
+
+bool SharedCoordinator::TryAcquire()
+{
+    if (!m_writer && m_readers == 0 && m_waiting == 0)
+    {
+        m_writer = true;
+        return true;
+    }
+    return false;
+}
+
+void SharedCoordinator::Acquire(Context* ctx)
+{
+    Wait<false, false>(ctx);
+}
+
+void SharedCoordinator::Release()
+{
+    assert(m_writer && "SharedCoordinator::Release without the exclusive hold");
+    m_writer = false;
+    Grant();
+}
+
+// A reader may join the readers in unless, preferring writers, someone is queued: the line only
+// ever holds readers behind a writer, so a queued reader means a queued writer ahead of it.
+//
+bool SharedCoordinator::TryAcquireShared()
+{
+    if (!m_writer && (m_waiting == 0 || m_preference == Preference::Readers))
+    {
+        m_readers++;
+        return true;
+    }
+    return false;
+}
+
+void SharedCoordinator::AcquireShared(Context* ctx)
+{
+    Wait<true, false>(ctx);
+}
+
+void SharedCoordinator::ReleaseShared()
+{
+    assert(m_readers > 0 && "SharedCoordinator::ReleaseShared without a shared hold");
+    if (--m_readers == 0)
+    {
+        Grant();
+    }
+}
+
+void SharedCoordinator::Enqueue(Waiter* waiter)
+{
+    m_waiters.Push(waiter);
+    m_waiting++;
+}
+
+// Admit takes the hold for a waiter before releasing it, so a waiter found granted holds it
+// however its wait ended. One that lost gives it back; one never granted leaves the line, which
+// may let the readers behind a departing writer in.
+//
+CoordinationResult SharedCoordinator::Settle(Waiter& waiter, CoordinationResult result)
+{
+    if (!waiter.granted)
+    {
+        m_waiters.Remove(&waiter);
+        m_waiting--;
+        Grant();
+        return result;
+    }
+    if (result.index != 0)
+    {
+        waiter.shared ? ReleaseShared() : Release();
+        return result;
+    }
+    return CoordinationResult{0, nullptr};
+}
+
+void SharedCoordinator::Admit(Waiter* waiter)
+{
+    m_waiters.Remove(waiter);
+    m_waiting--;
+    if (waiter->shared)
+    {
+        m_readers++;
+    }
+    else
+    {
+        m_writer = true;
+    }
+    waiter->granted = true;
+    waiter->coord.Release(nullptr, false);
+}
+
+void SharedCoordinator::Grant()
+{
+    if (m_writer)
+    {
+        return;
+    }
+
+    // Readers in: preferring writers, the run at the head of the line; preferring readers,
+    // every one queued
+    //
+    if (m_preference == Preference::Writers)
+    {
+        while (!m_waiters.IsEmpty() && m_waiters.Peek()->shared)
+        {
+            Admit(m_waiters.Peek());
+        }
+    }
+    else
+    {
+        for (auto* waiter = m_waiters.IsEmpty() ? nullptr : m_waiters.Peek(); waiter;)
+        {
+            auto* next = m_waiters.Next(waiter);
+            if (waiter->shared)
+            {
+                Admit(waiter);
+            }
+            waiter = next;
+        }
+    }
+
+    if (m_readers == 0 && !m_waiters.IsEmpty())
+    {
+        Admit(m_waiters.Peek());
+    }
+}
+
+} // end namespace coop
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "context.h"
+#include "coordinate_with.h"
+#include "coordination_result.h"
+#include "coordinator.h"
+#include "detail/embedded_list.h"
+#include "shared_stack.h"
+
+namespace coop
+{
+
+// SharedCoordinator is the reader-writer counterpart of Coordinator: any number of contexts
+// hold it shared, or one holds it exclusively. A read-mostly structure on a cooperator (a routing
+// table, a cache) that has to stay consistent across a reader's yields no longer serializes
+// every reader behind the last.
+//
+//  coop::SharedCoordinator routes;
+//
+//  routes.AcquireShared(ctx);              // lookups, which may yield
+//  ...
+//  routes.ReleaseShared();
+//
+//  routes.Acquire(ctx);                    // rebuild
+//  ...
+//  routes.Release();
+//
+// Preference decides what a new reader does while a writer waits. With Writers (the default) it
+// queues behind the writer, so writers are not starved by a steady stream of readers; with
+// Readers it joins the readers already in, and a writer waits for a moment with none. Waiters
+// are otherwise served in arrival order, each run of readers at the head of the line admitted
+// together.
+//
+// Uncontended acquires and releases touch only a counter or a flag. A context that has to wait
+// builds a waiter, which the release hands the coordinator to directly -- the waiter never
+// races a newcomer for it.
+//
+// The *With and *WithKill forms wait as CoordinateWith and CoordinateWithKill do, taking the
+// same extra arguments after the coordinator, which is index 0 of the result. Index 0 means it
+// is held (the result carries no coordinator for it); any other index or sentinel means not.
+//
+struct SharedCoordinator
+{
+    enum class Preference : uint8_t
+    {
+        Writers,
+        Readers,
+    };
+
+    SharedCoordinator(SharedCoordinator const&) = delete;
+    SharedCoordinator(SharedCoordinator&&) = delete;
+
+    explicit SharedCoordinator(Preference preference = Preference::Writers);
+
+    // Waiters would be left parked on a wait list that no longer exists
+    //
+    ~SharedCoordinator();
+
+    // Exclusive
+    //
+    bool TryAcquire();
+    void Acquire(Context* ctx);
+
+    template<typename... Args>
+    CoordinationResult AcquireWith(Context* ctx, Args... args);
+
+    template<typename... Args>
+    CoordinationResult AcquireWithKill(Context* ctx, Args... args);
+
+    void Release();
+
+    // Shared
+    //
+    bool TryAcquireShared();
+    void AcquireShared(Context* ctx);
+
+    template<typename... Args>
+    CoordinationResult AcquireSharedWith(Context* ctx, Args... args);
+
+    template<typename... Args>
+    CoordinationResult AcquireSharedWithKill(Context* ctx, Args... args);
+
+    void ReleaseShared();
+
+    // True while held exclusively
+    //
+    bool IsHeld() const { return m_writer; }
+
+    size_t Readers() const { return m_readers; }
+    size_t Waiting() const { return m_waiting; }
+
+  private:
+    struct Waiter : EmbeddedListHookups<Waiter>
+    {
+        Waiter(Context* ctx, bool isShared) : coord(ctx), shared(isShared) {}
+
+        Coordinator     coord;              // held until granted
+        bool            shared;
+        bool            granted = false;
+    };
+
+    template<bool Shared, bool Kill, typename... Args>
+    CoordinationResult Wait(Context* ctx, Args... args);
+
+    void Enqueue(Waiter* waiter);
+    CoordinationResult Settle(Waiter& waiter, CoordinationResult result);
+    void Admit(Waiter* waiter);
+    void Grant();
+
+    Preference              m_preference;
+    bool                    m_writer = false;
+    size_t                  m_readers = 0;
+    size_t                  m_waiting = 0;
+    EmbeddedList<Waiter>    m_waiters;
+};
+
+template<bool Shared, bool Kill, typename... Args>
+CoordinationResult SharedCoordinator::Wait(Context* ctx, Args... args)
+{
+    if constexpr (Kill)
+    {
+        if (ctx->IsKilled())
+        {
+            return CoordinationResult{static_cast<size_t>(-1), nullptr};
+        }
+    }
+    if (Shared ? TryAcquireShared() : TryAcquire())
+    {
+        return CoordinationResult{0, nullptr};
+    }
+
+    detail::WaitStorage<Waiter> stored(ctx, ctx, Shared);
+    Waiter& waiter = *stored.Get();
+    Enqueue(&waiter);
+    if constexpr (Kill)
+    {
+        return Settle(waiter, CoordinateWithKill(ctx, &waiter.coord, args...));
+    }
+    else
+    {
+        return Settle(waiter, CoordinateWith(ctx, &waiter.coord, args...));
+    }
+}
+
+template<typename... Args>
+CoordinationResult SharedCoordinator::AcquireWith(Context* ctx, Args... args)
+{
+    return Wait<false, false>(ctx, args...);
+}
+
+template<typename... Args>
+CoordinationResult SharedCoordinator::AcquireWithKill(Context* ctx, Args... args)
+{
+    return Wait<false, true>(ctx, args...);
+}
+
+template<typename... Args>
+CoordinationResult SharedCoordinator::AcquireSharedWith(Context* ctx, Args... args)
+{
+    return Wait<true, false>(ctx, args...);
+}
+
+template<typename... Args>
+CoordinationResult SharedCoordinator::AcquireSharedWithKill(Context* ctx, Args... args)
+{
+    return Wait<true, true>(ctx, args...);
+}
+
+} // end namespace coop
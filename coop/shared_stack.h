@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "context.h"
+#include "detail/bump.h"
+
+// Shared-stack mode is for the very many contexts that spend nearly all their lives parked -- a
+// long-poll handler, a push-gateway subscriber -- where a private stack apiece is most of the
+// memory. A context spawned with SpawnConfiguration::sharedStack runs its frames on one stack its
+// cooperator keeps for the purpose (CooperatorConfiguration::sharedStackSize). Its own segment
+// holds only the Context, its ContextVars, the closure and its bump heap, so a 4KB stackSize
+// class is usually plenty.
+//
+//  coop::SpawnConfiguration config = coop::s_defaultConfiguration;
+//  config.stackSize = 4096;
+//  config.sharedStack = true;
+//  co->Spawn(config, [&](coop::Context* ctx)
+//  {
+//      while (!coop::CoordinateWithKill(ctx, &update).Killed()) { ... }
+//  });
+//
+// The stack changes hands lazily (the libco "copy stack" technique): a parked context's frames
+// stay where they are until another shared context is resumed, which first copies the live bytes
+// of the one holding the stack -- from its saved stack pointer to the top, typically a few hundred
+// bytes -- into a buffer off the cooperator's SizeClassAllocator, and copies its own back in. The
+// copy always runs off the shared stack: from the loop, or from an ordinary context switching
+// directly into a shared one. Between two shared contexts the switch goes through the loop.
+//
+// The price is that a parked shared context's frames may be somewhere else by the time anyone
+// looks at them. They always come back to the same addresses before the context runs, so its
+// own pointers into its stack stay good; what nothing else may do is touch them while it is
+// suspended:
+//
+//  - Waits keep their nodes off the stack. Coordinator::Acquire, CoordinateWith and
+//    CoordinateWithKill (timeouts included) and time::Sleep place theirs in the context's bump
+//    heap (WaitStorage below), and so do the blocking io:: calls their Handle and Coordinator. A
+//    primitive that links a node of its own -- channel waiters, selectors, continuations -- or an
+//    io::Handle of the caller's, which its completion writes into, must live in the bump heap
+//    (Context::Allocate) or a longer-lived object, never a local. So must a buffer the kernel
+//    may read or write while the context is parked: io::Recv into a local array is not safe.
+//  - Bump allocations are fine: the heap is in the segment, which never moves. What must not
+//    escape is the address of a local.
+//  - A local may be handed to another context only for as long as the shared context keeps
+//    running, and never across a yield or a block.
+//  - The context cannot migrate (Context::CanMigrate), and its children get stacks of their own.
+//
+// Cooperator::GetSharedStackStats counts the copies and what parked shared contexts hold.
+//
+
+namespace coop
+{
+namespace detail
+{
+
+// Storage for a waiter node or object a context may block on: in the caller's frame, or in the
+// segment heap when ctx runs on the shared stack. Bump-allocated, so destroy in reverse order of
+// creation -- automatic for locals.
+//
+template<typename T>
+struct WaitStorage
+{
+    WaitStorage(WaitStorage const&) = delete;
+    WaitStorage(WaitStorage&&) = delete;
+
+    template<typename... Args>
+    explicit WaitStorage(Context* ctx, Args&&... args)
+    : m_ctx(ctx)
+    {
+        void* p = m_inline;
+        if (ctx->IsSharedStack()) [[unlikely]]
+        {
+            p = m_heap = BumpAlloc(ctx, sizeof(T), alignof(T));
+        }
+        m_value = new (p) T(std::forward<Args>(args)...);
+    }
+
+    ~WaitStorage()
+    {
+        m_value->~T();
+        if (m_heap) [[unlikely]]
+        {
+            BumpFree(m_ctx, m_heap);
+        }
+    }
+
+    T* Get() { return m_value; }
+    T* operator->() { return m_value; }
+
+  private:
+    Context*    m_ctx;
+    void*       m_heap{nullptr};
+    T*          m_value;
+    alignas(T) unsigned char m_inline[sizeof(T)];
+};
+
+} // end namespace coop::detail
+} // end namespace coop
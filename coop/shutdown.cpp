@@ -15,21 +15,51 @@ namespace coop
 
 static int g_shutdownFd = -1;
 
-static void SignalHandler(int)
+// The drain grace for SIGTERM, or negative when SIGTERM shuts down like SIGINT
+//
+static time::Interval g_drainGrace{-1};
+
+static volatile sig_atomic_t g_lastSignal = 0;
+
+static void SignalHandler(int sig)
 {
     // write() is async-signal-safe
     //
+    g_lastSignal = sig;
     uint64_t one = 1;
     [[maybe_unused]] ssize_t n = write(g_shutdownFd, &one, sizeof(one));
 }
 
 static void ShutdownWatcher()
 {
-    uint64_t count = 0;
-    while (read(g_shutdownFd, &count, sizeof(count)) < 0 && errno == EINTR)
+    bool draining = false;
+    for (;;)
+    {
+        uint64_t count = 0;
+        while (read(g_shutdownFd, &count, sizeof(count)) < 0 && errno == EINTR)
+        {
+        }
+
+        // Signals that arrived together count as a second one
+        //
+        if (!draining && count == 1 && g_lastSignal == SIGTERM && g_drainGrace.count() >= 0)
+        {
+            draining = true;
+            Cooperator::DrainAll(g_drainGrace);
+            continue;
+        }
+        Cooperator::ShutdownAll();
+        return;
+    }
+}
+
+void InstallShutdownHandler(time::Interval drainGrace)
+{
+    if (g_shutdownFd < 0)
     {
+        g_drainGrace = drainGrace;
     }
-    Cooperator::ShutdownAll();
+    InstallShutdownHandler();
 }
 
 void InstallShutdownHandler()
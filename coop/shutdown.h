@@ -1,5 +1,7 @@
 #pragma once
 
+#include "coop/time/interval.h"
+
 namespace coop
 {
 
@@ -10,4 +12,10 @@ namespace coop
 //
 void InstallShutdownHandler();
 
+// The same, with SIGTERM as the graceful stop: the first one calls Cooperator::DrainAll(grace),
+// so listeners stop accepting and in-flight requests get up to grace to finish (drain.h). SIGINT,
+// or any signal after that first SIGTERM, still calls ShutdownAll at once.
+//
+void InstallShutdownHandler(time::Interval drainGrace);
+
 } // end namespace coop
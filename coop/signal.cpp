@@ -17,6 +17,11 @@ bool Signal::IsSignaled() const
     return m_signaled;
 }
 
+bool Signal::HasWaiters() const
+{
+    return !m_coord.m_blocking.IsEmpty();
+}
+
 void Signal::Wait(Context* ctx)
 {
     if (m_signaled)
@@ -43,7 +48,7 @@ void Signal::Notify(Context* ctx, bool schedule /* = true */)
     //
     while (auto* ord = local.Pop())
     {
-        Cooperator::thread_cooperator->WakeWaiter(ord, schedule);
+        Cooperator::thread_cooperator->WakeWaiter(ord, schedule, &m_coord);
     }
 }
 
@@ -37,6 +37,10 @@ struct Signal
 
     bool IsSignaled() const;
 
+    // True while some context is parked in Wait (or a CoordinateWith) on this signal.
+    //
+    bool HasWaiters() const;
+
     // Block the calling context until Notify is called. Returns immediately if already signaled.
     //
     void Wait(Context* ctx);
@@ -53,6 +57,9 @@ struct Signal
     friend CoordinationResult detail::CoordinateWithTimeoutImpl(
         Context*, time::Interval, Coords...);
 
+    template<typename>
+    friend struct SignalCase;
+
     Coordinator* AsCoordinator() { return &m_coord; }
 
     // Reset internal coordinator after MultiCoordinator consumes it via TryAcquire. Without this,
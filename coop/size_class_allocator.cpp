@@ -0,0 +1,135 @@
+#include "size_class_allocator.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+#include "cooperator.h"
+
+namespace coop
+{
+
+SizeClassAllocator::~SizeClassAllocator()
+{
+    while (auto* slab = m_slabs)
+    {
+        m_slabs = slab->next;
+        std::free(slab);
+    }
+}
+
+SizeClassAllocator* SizeClassAllocator::Current()
+{
+    auto* co = Cooperator::thread_cooperator;
+    return co ? &co->GetAllocator() : nullptr;
+}
+
+void* SizeClassAllocator::Allocate(size_t n)
+{
+    assert(Current() == this && "SizeClassAllocator::Allocate called off its cooperator");
+
+    const size_t c = ClassFor(n);
+    if (c == kClasses)
+    {
+        return ::operator new(n);               // larger than any class: unpooled
+    }
+
+    if (!m_free[c] && m_remote.load(std::memory_order_relaxed))
+    {
+        DrainRemote();
+    }
+    if (FreeNode* node = m_free[c])
+    {
+        m_free[c] = node->next;
+        --m_freeCount[c];
+        return node;
+    }
+    return Carve(c);
+}
+
+void SizeClassAllocator::Release(void* p, size_t n)
+{
+    if (!p)
+    {
+        return;
+    }
+
+    const size_t c = ClassFor(n);
+    if (c == kClasses)
+    {
+        ::operator delete(p, n);
+        return;
+    }
+
+    auto* owner = SlabOf(p)->owner;
+    if (owner == Current())
+    {
+        owner->FreeLocal(p, c);
+    }
+    else
+    {
+        owner->FreeRemote(p, c);
+    }
+}
+
+void SizeClassAllocator::DrainRemote()
+{
+    // Acquire: the remote freers' last writes to their blocks are done before we reuse them
+    //
+    FreeNode* node = m_remote.exchange(nullptr, std::memory_order_acquire);
+    while (node)
+    {
+        FreeNode* next = node->next;
+        FreeLocal(node, node->sizeClass);
+        node = next;
+    }
+}
+
+void SizeClassAllocator::FreeLocal(void* p, size_t c)
+{
+    auto* node = static_cast<FreeNode*>(p);
+    node->next = m_free[c];
+    m_free[c] = node;
+    ++m_freeCount[c];
+}
+
+void SizeClassAllocator::FreeRemote(void* p, size_t c)
+{
+    // Push only, and only the owner pops (all at once), so the stack has no ABA to guard against
+    //
+    auto* node = static_cast<FreeNode*>(p);
+    node->sizeClass = static_cast<uint32_t>(c);
+    FreeNode* head = m_remote.load(std::memory_order_relaxed);
+    do
+    {
+        node->next = head;
+    }
+    while (!m_remote.compare_exchange_weak(head, node, std::memory_order_release,
+                                           std::memory_order_relaxed));
+}
+
+void* SizeClassAllocator::Carve(size_t c)
+{
+    const size_t size = ClassSize(c);
+    if (m_bumpEnd[c] - m_bump[c] < static_cast<ptrdiff_t>(size))
+    {
+        // The slab's tail that no longer fits a block is left unused
+        //
+        void* memory = std::aligned_alloc(kSlabBytes, kSlabBytes);
+        if (!memory)
+        {
+            return nullptr;
+        }
+        auto* slab = new (memory) Slab{this, m_slabs};
+        m_slabs = slab;
+        m_slabCount++;
+        m_bump[c] = reinterpret_cast<char*>(slab) + sizeof(Slab);
+        m_bumpEnd[c] = reinterpret_cast<char*>(slab) + kSlabBytes;
+    }
+
+    void* block = m_bump[c];
+    m_bump[c] += size;
+    return block;
+}
+
+} // end namespace coop
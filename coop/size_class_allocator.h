@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace coop
+{
+
+// Per-cooperator size-classed allocator for application hot-path objects: request structs, parser
+// nodes, response buffers. The ContinuationPool pattern opened up: each cooperator owns one
+// (Cooperator::GetAllocator), and it is only ever touched from that cooperator's thread, so the
+// allocation and local free paths take no lock and no atomic.
+//
+// Requests round up to a power-of-two class from 16 bytes to 4KB; a block of class c is aligned
+// to min(c, 64). Larger requests go to operator new. Blocks are carved from 64KB slabs, each
+// aligned to its size and headed by its owning allocator, so a free finds the owner with a mask.
+// Freed blocks go on per-class intrusive free lists. Slabs are not returned until the allocator
+// is destroyed: a cooperator's footprint is its high-water mark, which is what lets steady-state
+// request handling run without calling malloc at all.
+//
+// Remote frees: a block freed on another thread (another cooperator's, or a plain thread) is
+// pushed onto its owner's remote queue, a lock-free stack. The owner takes the whole queue back
+// in one exchange when a class's free list runs dry, before carving more slab. Only the remote
+// path pays an atomic, and a cooperator whose blocks never migrate never touches the queue.
+//
+// Every block must be freed, locally or remotely, before its owner is destroyed; the destructor
+// releases the slabs regardless of what is still outstanding.
+//
+// The typed front ends -- Pool<T> and the STL adaptor PoolAllocator<T> -- are in pool.h.
+//
+struct SizeClassAllocator
+{
+    static constexpr size_t kClasses    = 9;
+    static constexpr size_t kMinClass   = 16;
+    static constexpr size_t kMaxClass   = kMinClass << (kClasses - 1);    // 4KB
+    static constexpr size_t kSlabBytes  = 64 * 1024;
+    static constexpr size_t kMaxAlign   = 64;
+
+    SizeClassAllocator(SizeClassAllocator const&) = delete;
+    SizeClassAllocator(SizeClassAllocator&&) = delete;
+
+    SizeClassAllocator() = default;
+    ~SizeClassAllocator();
+
+    // The calling thread's cooperator's allocator, or null off a cooperator thread
+    //
+    static SizeClassAllocator* Current();
+
+    // At least n bytes, or null if a new slab could not be mapped. On the owning cooperator's
+    // thread only.
+    //
+    void* Allocate(size_t n);
+
+    // Free a block from any allocator, with the n it was allocated with, on any thread: to the
+    // calling cooperator's free list if the block is its own, to its owner's remote queue if not.
+    //
+    static void Release(void* p, size_t n);
+
+    // Take back every remotely freed block. Allocate does this on its own when a class runs dry.
+    //
+    void DrainRemote();
+
+    // ---- Statistics (owning thread) ----
+
+    size_t SlabCount() const { return m_slabCount; }
+
+    // Blocks of n's class waiting on the local free list
+    //
+    size_t FreeCount(size_t n) const { return m_freeCount[ClassFor(n)]; }
+
+    // Smallest class that fits n, or kClasses if n exceeds the largest
+    //
+    static constexpr size_t ClassFor(size_t n)
+    {
+        if (n > kMaxClass)
+        {
+            return kClasses;
+        }
+        size_t c = 0;
+        for (size_t size = kMinClass; size < n; size <<= 1)
+        {
+            c++;
+        }
+        return c;
+    }
+
+    static constexpr size_t ClassSize(size_t c) { return kMinClass << c; }
+
+  private:
+    struct FreeNode
+    {
+        FreeNode*   next;
+        uint32_t    sizeClass;      // read by DrainRemote, whose nodes come in mixed classes
+    };
+
+    struct alignas(kMaxAlign) Slab
+    {
+        SizeClassAllocator* owner;
+        Slab*               next;
+    };
+
+    static Slab* SlabOf(void* p)
+    {
+        return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(p) & ~(kSlabBytes - 1));
+    }
+
+    void FreeLocal(void* p, size_t c);
+    void FreeRemote(void* p, size_t c);
+
+    // Carve one block of class c from the current slab, mapping a new one when it is used up
+    //
+    void* Carve(size_t c);
+
+    FreeNode*   m_free[kClasses] = {};
+    size_t      m_freeCount[kClasses] = {};
+    char*       m_bump[kClasses] = {};
+    char*       m_bumpEnd[kClasses] = {};
+    Slab*       m_slabs{nullptr};
+    size_t      m_slabCount{0};
+
+    alignas(64) std::atomic<FreeNode*> m_remote{nullptr};
+};
+
+} // end namespace coop
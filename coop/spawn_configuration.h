@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 
 #ifndef COOP_DEFAULT_STACK_SIZE
 #define COOP_DEFAULT_STACK_SIZE 16384
@@ -9,15 +10,49 @@
 namespace coop
 {
 
+// Run-queue priority classes for SpawnConfiguration::priority. Each class has its own runnable list
+// in the Cooperator and the resume batch drains higher classes first, so a latency-critical handler
+// is not queued behind background work (log flushers, compaction loops, Grid stealers) on the same
+// thread. A starvation guard (CooperatorConfiguration::priorityStarvationLimit) still lets lower
+// classes run under sustained higher-class load. Values outside the range are clamped.
+//
+static constexpr int PRIORITY_BACKGROUND = -1;
+static constexpr int PRIORITY_NORMAL = 0;
+static constexpr int PRIORITY_HIGH = 1;
+static constexpr int PRIORITY_CLASSES = PRIORITY_HIGH - PRIORITY_BACKGROUND + 1;
+
+struct SchedulingGroup;
+
 struct SpawnConfiguration
 {
     int priority;
     size_t stackSize;
+
+    // Absolute deadline (time::MonotonicMicros) for cooperators running in
+    // SchedulingMode::EarliestDeadline; 0 means no deadline. For request serving this is simply the
+    // arrival time plus the request's SLO. Children spawned without an explicit configuration
+    // inherit it, so work fanned out for a request keeps the request's urgency.
+    //
+    int64_t deadlineUs;
+
+    // Fair-share group to run in (see scheduling_group.h). nullptr joins the parent's group, if
+    // the spawning context is in one.
+    //
+    SchedulingGroup* group;
+
+    // Run on the cooperator's shared stack and copy the live frames out when another shared
+    // context needs it (see shared_stack.h). stackSize then only has to hold the Context, its
+    // ContextVars, the closure and its bump heap. Not inherited: children get their own stacks.
+    //
+    bool sharedStack;
 };
 
 static const SpawnConfiguration s_defaultConfiguration = {
-    .priority = 0,
+    .priority = PRIORITY_NORMAL,
     .stackSize = COOP_DEFAULT_STACK_SIZE,
+    .deadlineUs = 0,
+    .group = nullptr,
+    .sharedStack = false,
 };
 
 } // end namespace coop
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "context_var.h"
+#include "cooperator.h"
+#include "launchable.h"
+
+namespace coop
+{
+
+// SpawnTemplate<T> is a Launch site resolved once: it fixes T's configuration against one
+// cooperator's StackPool and layout -- the stack class, its backing, where T goes past the
+// ContextVar region and where the bump heap starts -- so that each Launch through it skips the
+// per-spawn class search and offset arithmetic. With a cached segment, a Launch is a free list
+// pop, the Context's construction, T's placement and the switch into it.
+//
+// Segments are recycled by the class's LIFO free list, so the one a site launches into is
+// usually the one its last context exited from, still warm. They cannot be kept initialized
+// between uses: the Context holds its parent and handle, and ContextVars are per-context state.
+//
+// A SpawnTemplate is bound to its cooperator and used only on that cooperator's thread. Hot,
+// stable sites -- an accept loop launching each connection -- keep one for as long as they run.
+//
+//   SpawnTemplate<Connection> connections(co, {.priority = 0, .stackSize = 32768});
+//   while (...)
+//   {
+//       connections.Launch(fd, ...);
+//   }
+//
+template<typename T>
+struct SpawnTemplate
+{
+    static_assert(std::is_base_of<Launchable, T>::value);
+
+    SpawnTemplate(SpawnTemplate const&) = delete;
+    SpawnTemplate(SpawnTemplate&&) = delete;
+
+    explicit SpawnTemplate(Cooperator* co,
+                           SpawnConfiguration const& config = s_defaultConfiguration)
+    : m_co(co)
+    , m_config(config)
+    {
+        m_config.stackSize = co->m_stackPool.RoundUpStackSize(config.stackSize);
+        m_stackClass = co->m_stackPool.ClassIndex(m_config.stackSize);
+        m_backing = co->m_stackPool.Backing(m_config.stackSize);
+        m_launchOffset = ContextVarTotalSize();
+        m_heapOffset = (m_launchOffset + sizeof(T) + 15) & ~size_t(15);
+        assert(m_config.stackSize >= sizeof(Context));
+        assert(m_heapOffset <= m_config.stackSize);
+    }
+
+    // Same contract as Cooperator::Launch: nullptr if the calling context is killed or no segment
+    // could be allocated, else the instance, which may already be destructed.
+    //
+    template<typename... Args>
+    T* Launch(Context::Handle* handle, Args&&... args)
+    {
+        return m_co->template LaunchFrom<T>(*this, handle, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    T* Launch(Args&&... args)
+    {
+        Context::Handle* h = nullptr;
+        return Launch(h, std::forward<Args>(args)...);
+    }
+
+    Cooperator* GetCooperator() const { return m_co; }
+    SpawnConfiguration const& GetConfiguration() const { return m_config; }
+
+  private:
+    friend struct Cooperator;
+
+    Cooperator*         m_co;
+    SpawnConfiguration  m_config;           // stackSize rounded to its class
+    int                 m_stackClass;       // -1 above the largest class
+    StackBacking        m_backing;
+    size_t              m_launchOffset;     // T, from the segment's bottom
+    size_t              m_heapOffset;       // the bump heap, from the segment's bottom
+};
+
+template<typename T, typename... Args>
+T* Cooperator::LaunchFrom(SpawnTemplate<T> const& site, Context::Handle* handle, Args&&... args)
+{
+    assert(site.m_co == this && "SpawnTemplate used on a cooperator it was not built for");
+
+    if (m_scheduled && m_scheduled->IsKilled())
+    {
+        return nullptr;
+    }
+    if (site.m_config.sharedStack && !MapSharedStack())
+    {
+        return nullptr;
+    }
+
+    auto* alloc = m_stackPool.Allocate(site.m_stackClass, site.m_config.stackSize);
+    if (!alloc)
+    {
+        return nullptr;
+    }
+
+    auto* spawnCtx = new (alloc) Context(m_scheduled /* parent */, site.m_config, handle, this);
+    spawnCtx->m_segment.m_backing = site.m_backing;
+    m_contexts.Push(spawnCtx);
+
+    char* bottom = static_cast<char*>(spawnCtx->m_segment.Bottom());
+    detail::ContextVarRegistry::Instance().ConstructAll(bottom);
+    auto* launchable = new (bottom + site.m_launchOffset) T(
+        spawnCtx,
+        std::forward<Args>(args)...
+    );
+
+    spawnCtx->m_heapTop = bottom + site.m_heapOffset;
+    spawnCtx->m_bumpReserve = BumpReserveFor(site.m_config);
+    if (m_config.trackStackDepth && !site.m_config.sharedStack)
+    {
+        PaintStack(spawnCtx);
+    }
+
+    spawnCtx->m_entry = &LaunchTrampoline<T>;
+    spawnCtx->m_cleanup = &LaunchCleanup<T>;
+    EnterContext(spawnCtx);
+    return launchable;
+}
+
+} // end namespace coop
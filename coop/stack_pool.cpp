@@ -1,89 +1,185 @@
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
 #include <cstdlib>
 
-#ifndef NDEBUG
+#include <linux/mempolicy.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <unistd.h>
-#endif
 
 #include "stack_pool.h"
 #include "context.h"
 
+// Fault pages in writable without touching them one by one (5.14+)
+//
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
 namespace coop
 {
 
-StackPool::~StackPool()
+namespace
 {
-    Drain();
+
+#ifndef NDEBUG
+constexpr bool kDebugGuards = true;
+#else
+constexpr bool kDebugGuards = false;
+#endif
+
+size_t PageSize()
+{
+    static const size_t kPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return kPageSize;
+}
+
+// Bytes of one guarded mapping for a segment: bottom guard, the page-rounded Context + stack, and
+// (debug only) a top guard
+//
+size_t MappedTotal(size_t stackSize)
+{
+    const size_t page = PageSize();
+    size_t usable = sizeof(Context) + stackSize;
+    size_t usableAligned = (usable + page - 1) & ~(page - 1);
+    return page + usableAligned + (kDebugGuards ? page : 0);
 }
 
-size_t StackPool::RoundUpStackSize(size_t stackSize)
+constexpr size_t kArenaBytes = size_t(2) << 20;
+
+// Ask hugetlbfs for 2MB pages specifically (glibc only exposes the size flags via linux/mman.h)
+//
+#ifdef MAP_HUGE_SHIFT
+constexpr int kMapHuge2MB = 21 << MAP_HUGE_SHIFT;
+#else
+constexpr int kMapHuge2MB = 0;
+#endif
+
+// Distance between consecutive segments carved from an arena: Context + stack, kept at the
+// Context's 128-byte alignment rather than rounded to a page, so a 16KB class packs ~120 to an arena
+//
+size_t ArenaStride(size_t stackSize)
 {
-    if (stackSize <= MIN_STACK_SIZE) return MIN_STACK_SIZE;
-    if (stackSize > MAX_POOLED_STACK) return stackSize;
+    return (sizeof(Context) + stackSize + 127) & ~size_t(127);
+}
+
+} // end anonymous namespace
 
-    // Round up to next power of 2
+StackPool::StackPool(StackPoolConfiguration const& config)
+: m_trimIntervalUs(config.trimIntervalUs)
+, m_mapped(config.mappedStacks || kDebugGuards)
+, m_advice(config.releaseAdvice)
+, m_residentKeep(config.residentKeep)
+, m_populateBytes(config.populateBytes)
+, m_numaLocal(config.numaLocal)
+, m_hugePages(config.hugePages)
+{
+    assert(config.classCount >= 0 && config.classCount <= StackPoolConfiguration::MAX_CLASSES);
+    for (int i = 0; i < config.classCount; i++)
+    {
+        auto const& c = config.classes[i];
+        assert(c.size >= MIN_STACK_SIZE && (c.size & (MIN_STACK_SIZE - 1)) == 0);
+        assert(i == 0 || c.size > config.classes[i - 1].size);
+
+        auto& bucket = m_buckets[i];
+        bucket.size = c.size;
+        bucket.cap = c.cap;
+        bucket.prewarm = c.prewarm < c.cap ? c.prewarm : c.cap;
+        bucket.floor = c.pressureFloor < c.cap ? c.pressureFloor : c.cap;
+        bucket.arena = m_hugePages != HugePages::None
+                    && c.size <= config.hugePageMaxClass
+                    && ArenaStride(c.size) <= kArenaBytes;
+    }
+    m_numBuckets = config.classCount;
+}
+
+StackPool::~StackPool()
+{
+    // Cached arena segments go with their arenas. Every context on this pool has exited by now
+    // (and none of them migrated away), so nothing else points into them.
     //
-    stackSize--;
-    stackSize |= stackSize >> 1;
-    stackSize |= stackSize >> 2;
-    stackSize |= stackSize >> 4;
-    stackSize |= stackSize >> 8;
-    stackSize |= stackSize >> 16;
-    stackSize |= stackSize >> 32;
-    stackSize++;
-    return stackSize;
+    Drain();
+    for (void* arena : m_arenas)
+    {
+        munmap(arena, kArenaBytes);
+    }
 }
 
-void* StackPool::Allocate(size_t stackSize)
+void StackPool::BindToNode(int node)
 {
-    if (stackSize > MAX_POOLED_STACK)
+    assert(m_hits == 0 && m_misses == 0 && "bind before the first allocation");
+    if (!m_numaLocal || node < 0)
     {
-        m_misses++;
-        return RawAllocate(stackSize);
+        return;
     }
+    m_node = node;
+    m_mapped = true;                            // malloc'd memory cannot be mbind'ed
+}
 
+StackBacking StackPool::Backing(size_t stackSize) const
+{
     int idx = BucketIndex(stackSize);
-    auto& bucket = m_buckets[idx];
+    if (idx >= 0 && m_buckets[idx].arena)
+    {
+        return StackBacking::Arena;
+    }
+    return m_mapped ? StackBacking::Mapped : StackBacking::Heap;
+}
 
-    if (bucket.head)
+size_t StackPool::RoundUpStackSize(size_t stackSize) const
+{
+    if (stackSize <= MIN_STACK_SIZE) stackSize = MIN_STACK_SIZE;
+    for (int i = 0; i < m_numBuckets; i++)
     {
-        auto* node = bucket.head;
-        bucket.head = node->next;
-        bucket.count--;
-        m_cachedBytes -= sizeof(Context) + stackSize;
-        m_hits++;
-        return node;
+        if (stackSize <= m_buckets[i].size) return m_buckets[i].size;
     }
+    return stackSize;
+}
+
+void* StackPool::Allocate(size_t stackSize)
+{
+    return Allocate(BucketIndex(stackSize), stackSize);
+}
 
+void* StackPool::AllocateMiss(int classIndex, size_t stackSize)
+{
     m_misses++;
-    return RawAllocate(stackSize);
+    if (classIndex < 0)
+    {
+        return RawAllocate(stackSize);
+    }
+    return m_buckets[classIndex].arena ? Carve(stackSize) : RawAllocate(stackSize);
 }
 
-void StackPool::Free(void* ptr, size_t stackSize)
+void StackPool::Free(void* ptr, size_t stackSize, StackBacking backing)
 {
-    if (stackSize > MAX_POOLED_STACK)
+    int idx = BucketIndex(stackSize);
+    if (backing != Backing(stackSize))
     {
-        RawFree(ptr, stackSize);
+        RawFree(ptr, stackSize, backing);
         return;
     }
 
-    int idx = BucketIndex(stackSize);
-    auto& bucket = m_buckets[idx];
+    // An arena segment cannot be released on its own, so its class keeps all of them regardless
+    // of cap
+    //
+    if (backing != StackBacking::Arena && (idx < 0 || m_buckets[idx].count >= m_buckets[idx].cap))
+    {
+        RawFree(ptr, stackSize, backing);
+        return;
+    }
 
-    if (bucket.count >= MAX_PER_BUCKET)
+    if (m_advice != StackAdvice::None && backing == StackBacking::Mapped)
     {
-        // Evict the oldest (head) to make room for the new entry
-        //
-        auto* evict = bucket.head;
-        bucket.head = evict->next;
-        bucket.count--;
-        m_cachedBytes -= sizeof(Context) + stackSize;
-        RawFree(evict, stackSize);
+        Advise(ptr, stackSize);
     }
 
     // Overlay a FreeNode at the start of the dead allocation
     //
+    auto& bucket = m_buckets[idx];
     auto* node = static_cast<FreeNode*>(ptr);
     node->next = bucket.head;
     bucket.head = node;
@@ -91,100 +187,320 @@ void StackPool::Free(void* ptr, size_t stackSize)
     m_cachedBytes += sizeof(Context) + stackSize;
 }
 
+void StackPool::Advise(void* ptr, size_t stackSize)
+{
+    // Keep the first page (the FreeNode overlay lives there) and the top m_residentKeep bytes;
+    // release the page-aligned span in between
+    //
+    if (stackSize <= m_residentKeep)
+    {
+        return;
+    }
+
+    const size_t page = PageSize();
+    uintptr_t base = reinterpret_cast<uintptr_t>(ptr);
+    uintptr_t top = base + sizeof(Context) + stackSize;
+    uintptr_t lo = (base + sizeof(FreeNode) + page - 1) & ~(page - 1);
+    uintptr_t hi = (top - m_residentKeep) & ~(page - 1);
+    if (hi <= lo)
+    {
+        return;
+    }
+
+    if (m_advice == StackAdvice::Free)
+    {
+        if (madvise(reinterpret_cast<void*>(lo), hi - lo, MADV_FREE) == 0)
+        {
+            return;
+        }
+        if (errno == EINVAL)
+        {
+            m_advice = StackAdvice::DontNeed;   // pre-4.5 kernel: fall back for good
+        }
+    }
+    madvise(reinterpret_cast<void*>(lo), hi - lo, MADV_DONTNEED);
+}
+
+void StackPool::Populate(void* ptr, size_t stackSize) const
+{
+    if (m_populateBytes == 0)
+    {
+        return;
+    }
+
+    // The top of the segment, where a new context's first frames land, and populateBytes below
+    // it. Nothing lives in the segment yet, so touching it is harmless.
+    //
+    const size_t page = PageSize();
+    uintptr_t base = reinterpret_cast<uintptr_t>(ptr);
+    uintptr_t top = base + sizeof(Context) + stackSize;
+    uintptr_t lo = top - std::min(m_populateBytes, top - base);
+    uintptr_t alignedLo = (lo + page - 1) & ~(page - 1);
+    uintptr_t alignedHi = top & ~(page - 1);
+
+    static std::atomic<bool> s_noPopulate{false};
+    bool populated = alignedHi <= alignedLo;
+    if (!populated && !s_noPopulate.load(std::memory_order_relaxed))
+    {
+        populated = madvise(reinterpret_cast<void*>(alignedLo), alignedHi - alignedLo,
+                            MADV_POPULATE_WRITE) == 0;
+        if (!populated && errno == EINVAL)
+        {
+            s_noPopulate.store(true, std::memory_order_relaxed);   // pre-5.14 kernel
+        }
+    }
+    if (!populated)
+    {
+        for (uintptr_t at = alignedLo; at < alignedHi; at += page)
+        {
+            *reinterpret_cast<volatile char*>(at) = 0;
+        }
+    }
+
+    // The partial pages at either end
+    //
+    *reinterpret_cast<volatile char*>(lo) = 0;
+    *reinterpret_cast<volatile char*>(top - 1) = 0;
+}
+
+void StackPool::Prewarm()
+{
+    for (int i = 0; i < m_numBuckets; i++)
+    {
+        auto& bucket = m_buckets[i];
+        while (bucket.count < bucket.prewarm)
+        {
+            void* ptr = bucket.arena ? Carve(bucket.size) : RawAllocate(bucket.size);
+            if (!ptr) break;
+            Populate(ptr, bucket.size);
+            Free(ptr, bucket.size);
+        }
+        bucket.lowWater = bucket.count;
+    }
+}
+
+size_t StackPool::Trim(int64_t nowUs)
+{
+    if (m_trimIntervalUs <= 0 || nowUs - m_lastTrimUs < m_trimIntervalUs)
+    {
+        return 0;
+    }
+    m_lastTrimUs = nowUs;
+
+    size_t freed = 0;
+    for (int i = 0; i < m_numBuckets; i++)
+    {
+        auto& bucket = m_buckets[i];
+        if (bucket.arena)
+        {
+            continue;
+        }
+
+        // lowWater segments sat in the cache for the whole interval; free half of them (rounded
+        // up), keeping the prewarm floor
+        //
+        uint32_t idle = bucket.lowWater;
+        uint32_t spare = bucket.count > bucket.prewarm ? bucket.count - bucket.prewarm : 0;
+        uint32_t n = (idle + 1) / 2;
+        if (n > spare) n = spare;
+
+        Release(bucket, n);
+        freed += n;
+        bucket.lowWater = bucket.count;
+    }
+    m_trimmed += freed;
+    return freed;
+}
+
+size_t StackPool::Relieve(size_t batch)
+{
+    size_t freed = 0;
+    for (int i = m_numBuckets - 1; i >= 0 && freed < batch; i--)
+    {
+        auto& bucket = m_buckets[i];
+        if (bucket.arena || bucket.count <= bucket.floor)
+        {
+            continue;
+        }
+        size_t n = bucket.count - bucket.floor;
+        if (n > batch - freed) n = batch - freed;
+
+        Release(bucket, static_cast<uint32_t>(n));
+        freed += n;
+        if (bucket.lowWater > bucket.count) bucket.lowWater = bucket.count;
+    }
+    m_trimmed += freed;
+    return freed;
+}
+
+void StackPool::Release(Bucket& bucket, uint32_t n)
+{
+    for (; n > 0 && bucket.head; n--)
+    {
+        auto* node = bucket.head;
+        bucket.head = node->next;
+        bucket.count--;
+        m_cachedBytes -= sizeof(Context) + bucket.size;
+        RawFree(node, bucket.size);
+    }
+}
+
 void StackPool::Drain()
 {
-    for (int i = 0; i < NUM_BUCKETS; i++)
+    // Arena classes stay cached: their segments are only returned with the arenas, in ~StackPool
+    //
+    for (int i = 0; i < m_numBuckets; i++)
     {
-        size_t size = BucketSize(i);
-        auto* node = m_buckets[i].head;
-        while (node)
+        if (m_buckets[i].arena)
         {
-            auto* next = node->next;
-            RawFree(node, size);
-            node = next;
+            continue;
         }
-        m_buckets[i].head = nullptr;
-        m_buckets[i].count = 0;
+        Release(m_buckets[i], m_buckets[i].count);
+        m_buckets[i].lowWater = 0;
     }
-    m_cachedBytes = 0;
 }
 
 StackPool::Stats StackPool::GetStats() const
 {
     size_t cached = 0;
-    for (int i = 0; i < NUM_BUCKETS; i++)
+    for (int i = 0; i < m_numBuckets; i++)
     {
         cached += m_buckets[i].count;
     }
-    return Stats{cached, m_cachedBytes, m_hits, m_misses};
+    return Stats{cached, m_cachedBytes, m_hits, m_misses, m_trimmed, m_arenas.size() * kArenaBytes};
 }
 
-int StackPool::BucketIndex(size_t stackSize)
+int StackPool::BucketIndex(size_t stackSize) const
 {
-    // stackSize must be a power of 2 in [MIN_STACK_SIZE, MAX_POOLED_STACK]
+    // Exact match only: Allocate sees RoundUpStackSize output, Free sees a segment's recorded size
     //
-    int bits = __builtin_ctzl(stackSize);
-    int idx = bits - 12;  // 12 = log2(4096)
-    assert(idx >= 0 && idx < NUM_BUCKETS);
-    return idx;
-}
-
-size_t StackPool::BucketSize(int index)
-{
-    return MIN_STACK_SIZE << index;
+    for (int i = 0; i < m_numBuckets; i++)
+    {
+        if (m_buckets[i].size == stackSize) return i;
+    }
+    return -1;
 }
 
 // ---------------------------------------------------------------------------
 // Raw allocation — extracted from the original AllocateContext/FreeContext
 // ---------------------------------------------------------------------------
 
-#ifndef NDEBUG
-
-void* StackPool::RawAllocate(size_t stackSize)
+void* StackPool::RawAllocate(size_t stackSize) const
 {
     assert((stackSize & 127) == 0);
 
-    static const size_t kPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    if (!m_mapped)
+    {
+        return malloc(sizeof(Context) + stackSize);
+    }
 
-    size_t usable = sizeof(Context) + stackSize;
-    size_t usableAligned = (usable + kPageSize - 1) & ~(kPageSize - 1);
-    size_t total = kPageSize + usableAligned + kPageSize;
+    const size_t page = PageSize();
+    size_t total = MappedTotal(stackSize);
 
     void* base = mmap(nullptr, total, PROT_READ | PROT_WRITE,
-                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
     if (base == MAP_FAILED) return nullptr;
 
-    mprotect(base, kPageSize, PROT_NONE);
-    mprotect(static_cast<uint8_t*>(base) + kPageSize + usableAligned, kPageSize, PROT_NONE);
+    Bind(base, total);
+    mprotect(base, page, PROT_NONE);
+    if (kDebugGuards)
+    {
+        mprotect(static_cast<uint8_t*>(base) + total - page, page, PROT_NONE);
+    }
 
-    return static_cast<uint8_t*>(base) + kPageSize;
+    return static_cast<uint8_t*>(base) + page;
 }
 
-void StackPool::RawFree(void* ptr, size_t stackSize)
+void StackPool::RawFree(void* ptr, size_t stackSize, StackBacking backing)
 {
-    static const size_t kPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
-
-    size_t usable = sizeof(Context) + stackSize;
-    size_t usableAligned = (usable + kPageSize - 1) & ~(kPageSize - 1);
-    size_t total = kPageSize + usableAligned + kPageSize;
+    assert(backing != StackBacking::Arena && "arena segments are never released on their own");
+    if (backing == StackBacking::Heap)
+    {
+        free(ptr);
+        return;
+    }
 
-    void* base = static_cast<uint8_t*>(ptr) - kPageSize;
-    munmap(base, total);
+    void* base = static_cast<uint8_t*>(ptr) - PageSize();
+    munmap(base, MappedTotal(stackSize));
 }
 
-#else
+// ---------------------------------------------------------------------------
+// Huge-page arenas
+// ---------------------------------------------------------------------------
 
-void* StackPool::RawAllocate(size_t stackSize)
+void* StackPool::Carve(size_t stackSize)
 {
-    assert((stackSize & 127) == 0);
-    return malloc(sizeof(Context) + stackSize);
+    const size_t stride = ArenaStride(stackSize);
+    if (static_cast<size_t>(m_arenaEnd - m_arenaCursor) < stride)
+    {
+        // The tail of the old arena (less than one stride) is abandoned
+        //
+        auto* arena = static_cast<uint8_t*>(MapArena());
+        if (!arena) return nullptr;
+        m_arenaCursor = arena;
+        m_arenaEnd = arena + kArenaBytes;
+    }
+
+    void* ptr = m_arenaCursor;
+    m_arenaCursor += stride;
+    return ptr;
 }
 
-void StackPool::RawFree(void* ptr, size_t)
+void* StackPool::MapArena()
 {
-    free(ptr);
+    if (m_hugePages == HugePages::Explicit)
+    {
+        void* arena = mmap(nullptr, kArenaBytes, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | kMapHuge2MB, -1, 0);
+        if (arena != MAP_FAILED)
+        {
+            Bind(arena, kArenaBytes);
+            m_arenas.push_back(arena);
+            return arena;
+        }
+        m_hugePages = HugePages::Transparent;   // no reserved huge pages: fall back for good
+    }
+
+    // Over-map by one arena and trim to a 2MB-aligned window, so the whole arena can be a single
+    // transparent huge page
+    //
+    void* raw = mmap(nullptr, 2 * kArenaBytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (raw == MAP_FAILED) return nullptr;
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (base + kArenaBytes - 1) & ~(kArenaBytes - 1);
+    if (aligned > base)
+    {
+        munmap(raw, aligned - base);
+    }
+    munmap(reinterpret_cast<void*>(aligned + kArenaBytes), base + kArenaBytes - aligned);
+
+    void* arena = reinterpret_cast<void*>(aligned);
+    Bind(arena, kArenaBytes);
+    madvise(arena, kArenaBytes, MADV_HUGEPAGE);
+    m_arenas.push_back(arena);
+    return arena;
 }
 
-#endif
+void StackPool::Bind(void* addr, size_t len) const
+{
+    // Best effort: without the policy (a seccomp'd container, a node gone offline) pages still
+    // land wherever the touching thread runs, which is usually the same node
+    //
+    if (m_node < 0)
+    {
+        return;
+    }
+
+    unsigned long mask[16] = {};
+    constexpr size_t kBits = sizeof(mask) * 8;
+    if (static_cast<size_t>(m_node) >= kBits)
+    {
+        return;
+    }
+    mask[m_node / 64] = 1UL << (m_node % 64);
+    syscall(SYS_mbind, addr, len, MPOL_PREFERRED, mask, kBits + 1, 0);
+}
 
 } // end namespace coop
@@ -1,29 +1,100 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "context.h"
+#include "stack_pool_configuration.h"
 
 namespace coop
 {
 
 // A size-class allocator with per-bucket free lists for context stack allocations. Owned by
 // Cooperator (single-threaded, no locking required). Caches freed allocations to eliminate
-// mmap/munmap (debug) or malloc/free (release) syscalls on the hot path.
+// mmap/munmap (debug, or mappedStacks) or malloc/free (release) syscalls on the hot path.
+//
+// Size classes, per-class caps, prewarm counts and the idle trim policy come from
+// StackPoolConfiguration (see there); the default is powers of 2 from 4KB to 128KB. Requests
+// round up to the smallest class that fits. Requests larger than the largest class bypass the
+// pool entirely, as does freeing a segment whose size matches no class (a context that migrated
+// in from a cooperator with a different layout).
 //
-// Size classes are powers of 2 from 4KB to 128KB. Requests round up to the next bucket.
-// Requests larger than 128KB bypass the pool entirely.
+// With hugePages, the small classes are carved from 2MB huge-page arenas instead (see
+// StackPoolConfiguration::hugePages).
 //
 struct StackPool
 {
+    explicit StackPool(StackPoolConfiguration const& config = s_defaultStackPoolConfiguration);
     ~StackPool();
 
     void* Allocate(size_t stackSize);
-    void Free(void* ptr, size_t stackSize);
     void Drain();
 
-    // Round a requested stack size up to the nearest pool bucket boundary (power of 2,
-    // minimum 4KB). Sizes above MAX_POOLED_STACK are returned unchanged.
+    // Allocate for a site that resolved its class once (ClassIndex): a hit is a free list pop,
+    // with no class search. classIndex -1 (no class fits) allocates raw, as Allocate would.
+    //
+    void* Allocate(int classIndex, size_t stackSize)
+    {
+        if (classIndex >= 0)
+        {
+            auto& bucket = m_buckets[classIndex];
+            if (FreeNode* node = bucket.head) [[likely]]
+            {
+                bucket.head = node->next;
+                if (--bucket.count < bucket.lowWater) bucket.lowWater = bucket.count;
+                m_cachedBytes -= sizeof(Context) + stackSize;
+                m_hits++;
+                return node;
+            }
+        }
+        return AllocateMiss(classIndex, stackSize);
+    }
+
+    // The class a RoundUpStackSize result allocates from, or -1 if none holds it
+    //
+    int ClassIndex(size_t stackSize) const { return BucketIndex(stackSize); }
+
+    // Return a segment. backing says how it was allocated (Backing() of the pool that allocated
+    // it): a context that migrated in from a cooperator with a different backing is released raw,
+    // never cached. Arena segments never migrate, so they always come back to their own pool.
+    //
+    void Free(void* ptr, size_t stackSize, StackBacking backing);
+    void Free(void* ptr, size_t stackSize) { Free(ptr, stackSize, Backing(stackSize)); }
+
+    // How this pool allocates segments of stackSize: from a huge-page arena (hugePages, small
+    // classes only), as guarded mappings (debug builds, or mappedStacks), or from malloc.
     //
-    static size_t RoundUpStackSize(size_t stackSize);
+    StackBacking Backing(size_t stackSize) const;
+
+    // Prefer node for every raw allocation from here on, when numaLocal is configured (see
+    // StackPoolConfiguration). Called by the owning cooperator once it has pinned itself, before
+    // Prewarm and before any stack is allocated.
+    //
+    void BindToNode(int node);
+
+    // Fill every class up to its prewarm count, faulting in populateBytes of each. Called on the
+    // owning cooperator's thread, after pinning and before its loop starts, so the segments come
+    // from that thread's allocation.
+    //
+    void Prewarm();
+
+    // Apply the trim policy if trimIntervalUs has elapsed since the last trim (see
+    // StackPoolConfiguration). Cheap to call at every idle point. Returns segments freed.
+    //
+    size_t Trim(int64_t nowUs);
+
+    // Free up to batch cached segments above their classes' pressure floors, largest class first,
+    // whatever the trim interval. Returns segments freed: 0 once every class is at its floor.
+    //
+    size_t Relieve(size_t batch);
+
+    // Round a requested stack size up to the smallest class that holds it (minimum 4KB). Sizes
+    // above the largest class are returned unchanged.
+    //
+    size_t RoundUpStackSize(size_t stackSize) const;
+
+    bool TrimEnabled() const { return m_trimIntervalUs > 0; }
 
     struct Stats
     {
@@ -31,6 +102,8 @@ struct StackPool
         size_t totalBytes;
         size_t hits;
         size_t misses;
+        size_t trimmed;
+        size_t arenaBytes;
     };
 
     Stats GetStats() const;
@@ -40,28 +113,57 @@ struct StackPool
 
     struct Bucket
     {
-        FreeNode* head = nullptr;
-        int count = 0;
+        FreeNode* head     = nullptr;
+        size_t    size     = 0;
+        uint32_t  count    = 0;
+        uint32_t  cap      = 0;
+        uint32_t  prewarm  = 0;
+        uint32_t  floor    = 0;     // kept through memory pressure
+        uint32_t  lowWater = 0;     // min count since the last trim
+        bool      arena    = false; // carved from huge-page arenas
     };
 
-    static constexpr int NUM_BUCKETS = 6;              // 4KB .. 128KB
-    static constexpr int MAX_PER_BUCKET = 32;
     static constexpr size_t MIN_STACK_SIZE = 4096;
-    static constexpr size_t MAX_POOLED_STACK = 131072;
 
-    Bucket m_buckets[NUM_BUCKETS];
+    Bucket m_buckets[StackPoolConfiguration::MAX_CLASSES];
+    int    m_numBuckets = 0;
+
+    size_t  m_hits = 0;
+    size_t  m_misses = 0;
+    size_t  m_trimmed = 0;
+    size_t  m_cachedBytes = 0;
+    int64_t m_trimIntervalUs = 0;
+    int64_t m_lastTrimUs = 0;
 
-    size_t m_hits = 0;
-    size_t m_misses = 0;
-    size_t m_cachedBytes = 0;
+    bool        m_mapped = false;
+    StackAdvice m_advice = StackAdvice::None;
+    size_t      m_residentKeep = 0;
+    size_t      m_populateBytes = 0;
 
-    static int BucketIndex(size_t stackSize);
-    static size_t BucketSize(int index);
+    bool               m_numaLocal = false;
+    int                m_node = -1;
+    HugePages          m_hugePages = HugePages::None;
+    uint8_t*           m_arenaCursor = nullptr;
+    uint8_t*           m_arenaEnd = nullptr;
+    std::vector<void*> m_arenas;
 
-    // Underlying alloc/free — mmap+guard pages (debug) or malloc (release)
+    int BucketIndex(size_t stackSize) const;
+    void* AllocateMiss(int classIndex, size_t stackSize);
+    void Release(Bucket& bucket, uint32_t n);
+    void Advise(void* ptr, size_t stackSize);
+    void Populate(void* ptr, size_t stackSize) const;
+    void* Carve(size_t stackSize);
+    void* MapArena();
+    void Bind(void* addr, size_t len) const;
+
+    // Underlying alloc/free — a guarded mapping (debug, or mappedStacks) or malloc
     //
-    static void* RawAllocate(size_t stackSize);
-    static void RawFree(void* ptr, size_t stackSize);
+    void* RawAllocate(size_t stackSize) const;
+    void RawFree(void* ptr, size_t stackSize) const
+    {
+        RawFree(ptr, stackSize, m_mapped ? StackBacking::Mapped : StackBacking::Heap);
+    }
+    static void RawFree(void* ptr, size_t stackSize, StackBacking backing);
 };
 
 } // end namespace coop
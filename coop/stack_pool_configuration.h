@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace coop
+{
+
+// What StackPool does with the deep pages of a mapped stack when the stack is returned to the pool.
+// DontNeed drops them at once, and the next touch faults in a zero page. Free (MADV_FREE, Linux 4.5+,
+// falling back to DontNeed) lets the kernel reclaim them lazily under memory pressure, which is
+// cheaper when the stack is reused soon.
+//
+enum class StackAdvice : uint8_t
+{
+    None,
+    DontNeed,
+    Free,
+};
+
+// Whether StackPool carves small stacks out of 2MB huge-page arenas. Transparent maps an aligned
+// 2MB region and asks for transparent huge pages (MADV_HUGEPAGE), which the kernel may or may not
+// grant; Explicit maps from the reserved hugetlbfs pool (MAP_HUGETLB), falling back to Transparent
+// for good the first time the pool is empty.
+//
+enum class HugePages : uint8_t
+{
+    None,
+    Transparent,
+    Explicit,
+};
+
+// How one stack segment was allocated, recorded on its Segment so the right StackPool::Free path
+// runs for it.
+//
+enum class StackBacking : uint8_t
+{
+    Heap,       // malloc
+    Mapped,     // its own guarded mapping
+    Arena,      // carved from a huge-page arena; never released on its own
+};
+
+// Size classes and retention policy for a cooperator's StackPool.
+//
+// Each class is a stack size that spawn requests round up to, the number of freed segments of that
+// size the pool keeps cached (cap), and how many it allocates up front when the cooperator starts
+// (prewarm). Classes must be listed in ascending size, each a multiple of 4KB. A request larger than
+// the last class bypasses the pool. The defaults are the historical layout: powers of two from 4KB
+// to 128KB, 32 cached segments each, nothing prewarmed.
+//
+// Caps size the pool for the worst burst -- a connection storm spawning and exiting hundreds of
+// handler contexts -- but a cap that large would pin the burst's memory forever once traffic calms
+// down. The trim policy returns it: every trimIntervalUs of wall time, checked when the cooperator
+// is about to sleep, each class frees half of the segments that sat unused in its cache for the
+// whole interval (the class's low-water mark), never going below its prewarm count. A storm that
+// recurs keeps finding its working set cached; an idle cooperator decays back to the prewarm floor
+// geometrically. 0 disables trimming.
+//
+// Memory pressure (memory_pressure.h) trims harder: down to each class's pressureFloor at once, a
+// batch at a time, whatever the interval. The cap is the class's ceiling, its pressureFloor the
+// floor it keeps when the host is short of memory.
+//
+struct StackPoolConfiguration
+{
+    static constexpr int MAX_CLASSES = 16;
+
+    struct Class
+    {
+        size_t   size;
+        uint32_t cap;
+        uint32_t prewarm;
+        uint32_t pressureFloor = 0;
+    };
+
+    Class classes[MAX_CLASSES] = {
+        {4096, 32, 0},
+        {8192, 32, 0},
+        {16384, 32, 0},
+        {32768, 32, 0},
+        {65536, 32, 0},
+        {131072, 32, 0},
+    };
+    int classCount = 6;
+
+    int64_t trimIntervalUs = 0;
+
+    // Back stacks with their own anonymous mapping instead of malloc (always on in debug builds).
+    // The mapping is MAP_NORESERVE, so a class can be sized for the deepest handler -- say 1MB --
+    // while each stack's resident memory is only the pages it has actually touched. A PROT_NONE
+    // guard page sits below every segment (debug builds also keep one above), so an overflow that
+    // runs through the segment's own base faults instead of silently corrupting whatever malloc
+    // placed next to it. Costs one mmap/munmap per raw allocation, which the pool's caching keeps
+    // off the spawn path.
+    //
+    bool mappedStacks = false;
+
+    // On return to the pool, a mapped stack keeps its top residentKeep bytes (where the next
+    // context's shallow frames will land) and releases the pages below them with releaseAdvice --
+    // the high-water pages of whichever context went deep. One madvise per free, and only for
+    // classes larger than residentKeep.
+    //
+    StackAdvice releaseAdvice = StackAdvice::None;
+    size_t      residentKeep = 65536;
+
+    // With 50K+ live contexts every ContextSwitch lands on a different 4KB page and the stack
+    // switch becomes a TLB miss. With hugePages set, classes up to hugePageMaxClass are instead
+    // carved back to back out of 2MB huge-page arenas, so one TLB entry covers dozens of stacks.
+    // Arena segments are only ever recycled through their class's free list (ignoring its cap
+    // and the trim policy) and the arenas are unmapped when the pool is destroyed. They carry no
+    // guard pages, even in debug builds, and their contexts cannot migrate to another cooperator.
+    //
+    HugePages hugePages = HugePages::None;
+    size_t    hugePageMaxClass = 65536;
+
+    // Keep stacks (and the bump heap that shares each segment) on the owning cooperator's NUMA
+    // node. Pages already fault in on the pinned cooperator thread, but a malloc'd segment may
+    // be recycled memory another node touched first, and a mapped one may take its deep faults
+    // after its context migrated. With numaLocal, once the cooperator has pinned itself on a
+    // multi-node host, every stack mapping and huge-page arena is mbind'ed MPOL_PREFERRED to its
+    // node before first touch, and malloc-backed classes switch to mapped ones so they can be.
+    // No effect on a single-node host or an unpinned cooperator.
+    //
+    bool numaLocal = false;
+
+    // Fault in the top populateBytes of every segment Prewarm allocates (rounded to pages; pass
+    // the class size or more for all of it), so the first wave of contexts runs on resident
+    // stacks instead of taking a page fault per new frame page. Prewarm runs on the pinned
+    // cooperator thread, so the pages land on its node. Uses MADV_POPULATE_WRITE (5.14+), else
+    // touches each page. Keep it within residentKeep when releaseAdvice is set, or the first
+    // return to the pool drops the difference again. 0 leaves pages to fault on demand.
+    //
+    size_t populateBytes = 0;
+};
+
+static const StackPoolConfiguration s_defaultStackPoolConfiguration = {};
+
+} // end namespace coop
@@ -0,0 +1,120 @@
+#include "status_snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "cooperator.h"
+#include "time/now.h"
+
+namespace coop
+{
+
+StatusSlot::StatusSlot(size_t maxContexts)
+: m_capacity(maxContexts)
+{
+    for (Buffer& buffer : m_buffers)
+    {
+        buffer.contexts = std::make_unique<ContextSnapshot[]>(m_capacity);
+    }
+}
+
+size_t StatusSlot::Record(Buffer& buffer, Context* ctx, uint32_t depth, size_t at)
+{
+    if (at == m_capacity)
+    {
+        buffer.header.truncated = true;
+        return at;
+    }
+
+    ContextSnapshot& entry = buffer.contexts[at++];
+    strncpy(entry.name, ctx->GetName(), ContextSnapshot::NAME_SIZE - 1);
+    entry.name[ContextSnapshot::NAME_SIZE - 1] = '\0';
+    entry.depth = depth;
+    entry.state = ctx->m_state;
+    entry.killed = ctx->IsKilled();
+    entry.priority = ctx->m_priority;
+    entry.statistics = ctx->m_statistics;
+
+    ctx->m_children.Visit([&](Context* child) -> bool
+    {
+        at = Record(buffer, child, depth + 1, at);
+        return !buffer.header.truncated;
+    });
+    return at;
+}
+
+void StatusSlot::Publish(Cooperator* co)
+{
+    uint32_t current = m_current.load(std::memory_order_relaxed);
+    uint32_t next = current == 0 ? 1 : 0;
+    Buffer& buffer = m_buffers[next];
+
+    uint64_t seq = buffer.seq.load(std::memory_order_relaxed);
+    buffer.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    buffer.header.publishedUs = time::MonotonicMicros();
+    buffer.header.version = ++m_version;
+    buffer.header.contextsCount = co->ContextsCount();
+    buffer.header.yieldedCount = co->YieldedCount();
+    buffer.header.blockedCount = co->BlockedCount();
+    buffer.header.ticks = co->GetTicks();
+    buffer.header.truncated = false;
+
+    size_t at = 0;
+    co->VisitContexts([&](Context* ctx) -> bool
+    {
+        if (!ctx->Parent())
+        {
+            at = Record(buffer, ctx, 0, at);
+        }
+        return !buffer.header.truncated;
+    });
+    buffer.header.recorded = at;
+
+    buffer.seq.store(seq + 2, std::memory_order_release);
+    m_current.store(next, std::memory_order_release);
+}
+
+bool StatusSlot::Read(CooperatorSnapshot& out) const
+{
+    for (;;)
+    {
+        uint32_t current = m_current.load(std::memory_order_acquire);
+        if (current == NONE)
+        {
+            return false;
+        }
+
+        Buffer const& buffer = m_buffers[current];
+        uint64_t seq = buffer.seq.load(std::memory_order_acquire);
+        if (seq & 1)
+        {
+            continue;
+        }
+
+        Header header = buffer.header;
+
+        // A torn count must not take the copy past the buffer; the check below discards it
+        //
+        size_t recorded = std::min(header.recorded, m_capacity);
+        out.contexts.assign(buffer.contexts.get(), buffer.contexts.get() + recorded);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (buffer.seq.load(std::memory_order_relaxed) != seq)
+        {
+            continue;
+        }
+
+        out.publishedUs = header.publishedUs;
+        out.version = header.version;
+        out.contextsCount = header.contextsCount;
+        out.yieldedCount = header.yieldedCount;
+        out.blockedCount = header.blockedCount;
+        out.ticks = header.ticks;
+        out.truncated = header.truncated;
+        return true;
+    }
+}
+
+} // end namespace coop
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "context.h"
+
+namespace coop
+{
+
+struct Cooperator;
+
+// One context as a status snapshot recorded it
+//
+struct ContextSnapshot
+{
+    static constexpr size_t NAME_SIZE = 48;
+
+    char                name[NAME_SIZE];    // truncated to fit
+    uint32_t            depth;              // 0 for a root, its parent's depth + 1 otherwise
+    SchedulerState      state;
+    bool                killed;
+    int                 priority;
+    Context::Statistics statistics;
+};
+
+// A cooperator's contexts and counters as of one scheduler pass. The contexts are in depth-first
+// order, each parent before its children, so the tree is rebuilt from the depths.
+//
+struct CooperatorSnapshot
+{
+    int64_t     publishedUs = 0;    // time::MonotonicMicros at publish
+    uint64_t    version = 0;        // 1 for the first publish, one more for each after it
+    size_t      contextsCount = 0;
+    size_t      yieldedCount = 0;
+    size_t      blockedCount = 0;
+    int64_t     ticks = 0;
+    bool        truncated = false;  // the tree had more contexts than the slot holds
+
+    std::vector<ContextSnapshot> contexts;
+};
+
+// Where a cooperator publishes its CooperatorSnapshot for readers on other threads, which must
+// not walk its context tree themselves. Two buffers, each under its own sequence count: the
+// cooperator writes the one readers are not directed to, then directs them to it, and a reader
+// copies out of the current one and checks its count did not move meanwhile. Publishes alternate
+// buffers, so a reader only retries when two publishes -- normally two publish intervals -- land
+// within its copy; the cooperator never waits for readers.
+//
+// Sized once, for maxContexts (CooperatorConfiguration::statusSnapshot); a bigger tree is cut
+// short in depth-first order and flagged truncated. Reads copy fields their writer may be
+// rewriting and keep the copy only when the count proves it whole; that is the seqlock pattern,
+// uint64_t reads tear-free on the targets we build for.
+//
+struct StatusSlot
+{
+    explicit StatusSlot(size_t maxContexts);
+
+    StatusSlot(StatusSlot const&) = delete;
+
+    // On the cooperator's thread
+    //
+    void Publish(Cooperator* co);
+
+    // Any thread. False until the first publish.
+    //
+    bool Read(CooperatorSnapshot& out) const;
+
+    size_t Capacity() const { return m_capacity; }
+
+  private:
+    struct Header
+    {
+        int64_t     publishedUs;
+        uint64_t    version;
+        size_t      contextsCount;
+        size_t      yieldedCount;
+        size_t      blockedCount;
+        int64_t     ticks;
+        size_t      recorded;
+        bool        truncated;
+    };
+
+    struct Buffer
+    {
+        alignas(64) std::atomic<uint64_t>   seq{0};         // odd while the cooperator writes
+        Header                              header{};
+        std::unique_ptr<ContextSnapshot[]>  contexts;
+    };
+
+    size_t Record(Buffer& buffer, Context* ctx, uint32_t depth, size_t at);
+
+    static constexpr uint32_t NONE = ~uint32_t(0);
+
+    size_t                  m_capacity;
+    uint64_t                m_version{0};
+    std::atomic<uint32_t>   m_current{NONE};
+    Buffer                  m_buffers[2];
+};
+
+} // end namespace coop
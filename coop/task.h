@@ -0,0 +1,288 @@
+#pragma once
+
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "continuation.h"
+#include "coordinator.h"
+#include "cooperator.h"
+#include "self.h"
+
+namespace coop
+{
+
+template<typename T = void>
+struct Task;
+
+namespace detail
+{
+
+// State shared by every Task promise: how the frame is allocated, who to hand control to when it
+// finishes, and whether anyone is left to destroy it.
+//
+struct TaskPromiseBase
+{
+    // Frames come from the owning cooperator's continuation pool, like detached continuations: a
+    // Task is created, resumed and destroyed on one cooperator's thread. Frames larger than the
+    // pool's biggest class fall back to malloc inside the pool.
+    //
+    static void* operator new(std::size_t n)
+    {
+        return Cooperator::thread_cooperator->AllocateContinuation(n);
+    }
+
+    static void operator delete(void* p, std::size_t n)
+    {
+        Cooperator::thread_cooperator->FreeContinuation(p, n);
+    }
+
+    // Lazy: nothing runs until the Task is awaited, detached, or Await()ed
+    //
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+
+    // On completion control passes, by symmetric transfer, to the awaiting coroutine if there is
+    // one. A stackful Await()er is woken through its latch instead, and a detached frame frees
+    // itself.
+    //
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept
+        {
+            return false;
+        }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+        {
+            TaskPromiseBase& p = h.promise();
+            if (p.m_awaiter)
+            {
+                return p.m_awaiter;
+            }
+            if (p.m_latch)
+            {
+                p.m_latch->Fire();
+            }
+            else if (p.m_detached)
+            {
+                h.destroy();
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept
+        {
+        }
+    };
+
+    FinalAwaiter final_suspend() noexcept
+    {
+        return {};
+    }
+
+    // Like an Erg or a continuation, a Task has nowhere to propagate an exception to
+    //
+    void unhandled_exception() noexcept
+    {
+        std::terminate();
+    }
+
+    std::coroutine_handle<> m_awaiter;
+    CompletionLatch*        m_latch = nullptr;
+    bool                    m_started = false;
+    bool                    m_detached = false;
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase
+{
+    template<typename U>
+    void return_value(U&& value)
+    {
+        m_result.emplace(std::forward<U>(value));
+    }
+
+    T TakeResult()
+    {
+        return std::move(*m_result);
+    }
+
+    std::optional<T> m_result;
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase
+{
+    void return_void()
+    {
+    }
+
+    void TakeResult()
+    {
+    }
+};
+
+} // end namespace detail
+
+// A stackless (C++20) coroutine on the current cooperator. Where a Context costs a stack segment,
+// a Task costs one frame from the cooperator's continuation pool, sized by the compiler to the
+// locals live across its suspension points -- the shape for a million in-flight request state
+// machines.
+//
+// A Task starts lazily and is consumed one of three ways:
+//
+//   co_await task      from another Task: runs it, resuming the caller (by symmetric transfer, no
+//                      stack growth) with its result when it finishes.
+//   task.Detach()      run it as a free-standing state machine; its frame frees itself at the end.
+//   task.Await()       from a Context: run it and block until it finishes, returning its result.
+//
+// A Task suspends on coop primitives through awaiters -- co_await coop::Acquire(&coord), or
+// co_await io::Await(handle) on a contextless io::Handle (coop/io/await.h) -- each of which
+// registers a detached continuation on the coordinator in question. So once a Task has suspended,
+// it resumes from the cooperator loop's continuation drain and is bound by the continuation
+// contract until its next suspension: no current context, never block (no Self(), no blocking IO,
+// no Coordinator::Acquire), and Release with schedule=false.
+//
+// A Task that has started must finish before its owner destroys it; there is no cancellation of a
+// suspended frame. A Task is not thread-safe and never migrates.
+//
+template<typename T>
+struct [[nodiscard]] Task
+{
+    struct promise_type : detail::TaskPromise<T>
+    {
+        Task get_return_object()
+        {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+    Task(Task const&) = delete;
+    Task& operator=(Task const&) = delete;
+
+    Task(Task&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, {}))
+    {
+    }
+
+    ~Task()
+    {
+        if (m_handle)
+        {
+            assert((!m_handle.promise().m_started || m_handle.done())
+                   && "Task destroyed while suspended");
+            m_handle.destroy();
+        }
+    }
+
+    auto operator co_await() && noexcept
+    {
+        struct Awaiter
+        {
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+            {
+                handle.promise().m_awaiter = awaiter;
+                handle.promise().m_started = true;
+                return handle;
+            }
+
+            T await_resume()
+            {
+                return handle.promise().TakeResult();
+            }
+
+            std::coroutine_handle<promise_type> handle;
+        };
+        return Awaiter{m_handle};
+    }
+
+    // Run until the first suspension (or to completion). The frame now owns itself and is freed
+    // when the Task finishes; its result, if any, is discarded.
+    //
+    void Detach() &&
+    {
+        auto handle = std::exchange(m_handle, {});
+        handle.promise().m_detached = true;
+        handle.promise().m_started = true;
+        handle.resume();
+    }
+
+    // Context only. Run the Task and park the calling context until it finishes, then return its
+    // result. Completes without a context switch if the Task never suspends.
+    //
+    T Await() &&
+    {
+        CompletionLatch latch;
+        m_handle.promise().m_latch = &latch;
+        m_handle.promise().m_started = true;
+        m_handle.resume();
+        latch.Wait(Self());
+        return m_handle.promise().TakeResult();
+    }
+
+  private:
+    explicit Task(std::coroutine_handle<promise_type> handle)
+    : m_handle(handle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+// Awaitable Coordinator::Acquire for Tasks. Takes the coordinator at once if it is free; otherwise
+// queues on it as a detached continuation and resumes holding it. A continuation does not inherit
+// ownership on Release the way a context waiter does, so one that finds the coordinator taken
+// again by the time it runs re-queues at the back: fair among contexts, not strictly FIFO for
+// Tasks under contention. Release with coord->Release(nullptr, /*schedule=*/false).
+//
+struct AcquireAwaiter
+{
+    bool await_ready()
+    {
+        return coord->TryAcquire();
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiter)
+    {
+        Arm(coord, awaiter);
+    }
+
+    void await_resume()
+    {
+    }
+
+    static void Arm(Coordinator* coord, std::coroutine_handle<> awaiter)
+    {
+        coord->ContinueDetached([awaiter](Coordinator* c)
+        {
+            if (c->TryAcquire())
+            {
+                awaiter.resume();
+                return;
+            }
+            Arm(c, awaiter);
+        });
+    }
+
+    Coordinator* coord;
+};
+
+inline AcquireAwaiter Acquire(Coordinator* coord)
+{
+    return AcquireAwaiter{coord};
+}
+
+} // end namespace coop
@@ -35,5 +35,30 @@ inline int64_t MonotonicMicrosCeil()
     return static_cast<int64_t>(ts.tv_sec) * 1000000 + (ts.tv_nsec + 999) / 1000;
 }
 
+// Monotonic nanoseconds, for measuring short spans of work against a budget rather than for
+// deadlines
+//
+inline int64_t MonotonicNanos()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// A cached MonotonicMicros for hot paths that read the clock several times per request and can
+// live with a slightly stale answer: latency accounting, cache expiry, idle bookkeeping. On a
+// cooperator thread it loads the reading the scheduler takes after each Poll
+// (Cooperator::m_coarseMicros, through thread_cooperator); off one it reads the clock. Defined in
+// cooperator.h, which a caller includes.
+//
+// Bounded staleness: the value is at most one scheduler pass old -- a batch of up to 16 resumes and
+// a continuation drain -- plus however long the calling context has run since it was resumed, since
+// nothing refreshes it while a context runs. It is taken by the floor reader and never ahead of the
+// clock, so it suits checks that may err late ("has this expired") and intervals between yields.
+// It must not stamp a deadline that may not come early: a stale start puts the deadline early by
+// the staleness. Sleep deadlines and IO timeouts keep the exact readers above.
+//
+inline int64_t NowCoarse();
+
 } // end namespace time
 } // end namespace coop
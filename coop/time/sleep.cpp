@@ -8,6 +8,7 @@
 #include "coop/coordinate_with.h"
 #include "coop/io/timeout.h"
 #include "coop/self.h"
+#include "coop/shared_stack.h"
 
 namespace coop
 {
@@ -45,6 +46,7 @@ int64_t Sleeper::DeadlineUs() const
 {
     // Ceil the start so the absolute deadline is never earlier than now+interval in real terms (see
     // MonotonicMicrosCeil) -- the queue path's guard against returning a sub-microsecond early.
+    // NowCoarse is no substitute here: its staleness would come straight off the sleep.
     //
     const int64_t nowUs    = MonotonicMicrosCeil();
     const int64_t deadline = nowUs + m_interval.count();
@@ -113,7 +115,10 @@ SleepResult Sleeper::Sleep()
 
 SleepResult Sleep(Context* ctx, Interval interval, Interval slack)
 {
-    return Sleeper(ctx, interval, slack).Sleep();
+    // The timer node is linked into the cooperator's queue, so keep it off a shared stack
+    //
+    coop::detail::WaitStorage<Sleeper> sleeper(ctx, ctx, interval, slack);
+    return sleeper->Sleep();
 }
 
 SleepResult Sleep(Interval interval, Interval slack)
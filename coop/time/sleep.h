@@ -42,8 +42,8 @@ enum class SleepResult : int8_t
 // cooperator's TimerMode picks the backing, transparently to the caller:
 //
 //   - KernelPerTimer (default): arm an IORING_OP_TIMEOUT through m_handle, exactly as before.
-//   - UserspaceQueue: register m_node in the cooperator's timer queue; the queue Releases
-//     m_coordinator when the deadline expires.
+//   - UserspaceQueue, Wheel: register m_node in the cooperator's timer queue or wheel, which
+//     Releases m_coordinator when the deadline expires.
 //
 // Both back the same Coordinator the caller blocks on, so Wait()/Sleep() are mode-agnostic. The
 // destructor cleans up whichever was used (an unsubmitted Handle and an unlinked node are both
@@ -88,7 +88,7 @@ struct Sleeper
     Coordinator m_coordinator;
 
     Context*    m_context;
-    TimerNode   m_node;      // UserspaceQueue backing
+    TimerNode   m_node;      // UserspaceQueue and Wheel backing
     io::Handle  m_handle;    // KernelPerTimer backing
     Interval    m_interval;
     Interval    m_slack;
@@ -21,6 +21,9 @@ namespace time
 //   m_next   next sibling in the parent's child list, or null
 //   m_prev   previous sibling, or -- for a leftmost child -- the parent; null for the root
 //
+// A TimerWheel (timer_wheel.h) reuses m_next/m_prev as its slot list links and m_bucket to name the
+// slot, which sits in what was padding: the node is the same size in either structure.
+//
 struct TimerNode
 {
     TimerNode() = default;
@@ -41,6 +44,7 @@ struct TimerNode
 
   private:
     friend struct TimerQueue;
+    friend struct TimerWheel;
 
     int64_t      m_deadlineUs = 0;
     Coordinator* m_coord      = nullptr;
@@ -49,6 +53,7 @@ struct TimerNode
     TimerNode*   m_next  = nullptr;
     TimerNode*   m_prev  = nullptr;
     bool         m_linked = false;
+    uint16_t     m_bucket = 0;
 };
 
 // A per-cooperator, deadline-ordered structure of in-flight sleeps. Single-threaded: every method
@@ -102,6 +107,42 @@ struct TimerQueue
         return min;
     }
 
+    // Visit every queued node in unspecified order; return false from the callback to stop early.
+    // Iterative (climbs back up through m_prev), so depth is not bounded by the native stack. A
+    // debug/observability helper -- the callback must not insert or remove nodes.
+    //
+    template<typename Fn>
+    void Visit(Fn const& fn)
+    {
+        TimerNode* n = m_root;
+        while (n)
+        {
+            if (!fn(n))
+            {
+                return;
+            }
+            if (n->m_child)
+            {
+                n = n->m_child;
+                continue;
+            }
+            while (n && !n->m_next)
+            {
+                // Walk left to the leftmost sibling, whose m_prev is the parent (null at the root)
+                //
+                while (n->m_prev && n->m_prev->m_child != n)
+                {
+                    n = n->m_prev;
+                }
+                n = n->m_prev;
+            }
+            if (n)
+            {
+                n = n->m_next;
+            }
+        }
+    }
+
     // Heap-property check: every node's deadline is <= its children's. A test/debug helper, not used
     // on any hot path.
     //
@@ -0,0 +1,252 @@
+#include "timer_wheel.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace coop
+{
+
+namespace time
+{
+
+// The level is that of the highest digit in which the deadline and the wheel's time differ; the
+// two agree above it, so the deadline falls in the current rotation of that level and its digit
+// there is ahead of the wheel's. A deadline within range that crosses a top-level rotation has no
+// such level and wraps onto the top one, at or behind the current digit (NextSlot adds a rotation).
+//
+// Placement is stable while the wheel's time advances toward a node's slot: everything between the
+// time it was placed at and the slot's start shares the same digits above it, so the bucket the
+// node is in stays the one BucketFor names. That is what lets PopExpired move the time up to now
+// without touching the nodes it passes over.
+//
+uint16_t TimerWheel::BucketFor(int64_t deadlineUs) const
+{
+    if (deadlineUs <= m_elapsedUs)
+    {
+        return kDue;
+    }
+    if (deadlineUs - m_elapsedUs >= kRangeUs)
+    {
+        return kOverflow;
+    }
+
+    uint64_t diff = static_cast<uint64_t>(deadlineUs ^ m_elapsedUs) | (kSlots - 1);
+    int level = std::min((63 - std::countl_zero(diff)) / kLevelBits, kLevels - 1);
+    int slot  = static_cast<int>((deadlineUs >> (level * kLevelBits)) & (kSlots - 1));
+    return static_cast<uint16_t>(level * kSlots + slot);
+}
+
+void TimerWheel::Place(TimerNode* node)
+{
+    uint16_t bucket = BucketFor(node->m_deadlineUs);
+    if (bucket == kOverflow)
+    {
+        m_overflowMinUs = std::min(m_overflowMinUs, node->m_deadlineUs);
+    }
+    Push(bucket, node);
+}
+
+void TimerWheel::Push(uint16_t bucket, TimerNode* node)
+{
+    node->m_bucket = bucket;
+    node->m_prev   = nullptr;
+    node->m_next   = m_heads[bucket];
+    if (node->m_next)
+    {
+        node->m_next->m_prev = node;
+    }
+    m_heads[bucket] = node;
+    if (bucket < kDue)
+    {
+        m_occupied[bucket / kSlots] |= uint64_t(1) << (bucket % kSlots);
+    }
+}
+
+void TimerWheel::Unlink(TimerNode* node)
+{
+    uint16_t bucket = node->m_bucket;
+    if (node->m_prev)
+    {
+        node->m_prev->m_next = node->m_next;
+    }
+    else
+    {
+        m_heads[bucket] = node->m_next;
+    }
+    if (node->m_next)
+    {
+        node->m_next->m_prev = node->m_prev;
+    }
+    node->m_next = node->m_prev = nullptr;
+
+    if (!m_heads[bucket])
+    {
+        if (bucket < kDue)
+        {
+            m_occupied[bucket / kSlots] &= ~(uint64_t(1) << (bucket % kSlots));
+        }
+        else if (bucket == kOverflow)
+        {
+            m_overflowMinUs = INT64_MAX;
+        }
+    }
+}
+
+// The lowest occupied level holds the earliest slot: a node on level L is inside the wheel time's
+// current level-(L+1) slot, and every node above it is past that slot's end.
+//
+bool TimerWheel::NextSlot(int& level, int& slot, int64_t& startUs) const
+{
+    for (level = 0; level < kLevels; level++)
+    {
+        uint64_t occupied = m_occupied[level];
+        if (!occupied)
+        {
+            continue;
+        }
+
+        const int     shift   = level * kLevelBits;
+        const int     current = static_cast<int>((m_elapsedUs >> shift) & (kSlots - 1));
+        const int64_t base    = m_elapsedUs & ~((int64_t(1) << (shift + kLevelBits)) - 1);
+
+        if (level < kLevels - 1)
+        {
+            assert(!(occupied & ((uint64_t(2) << current) - 1)) && "slot behind the wheel");
+            slot = std::countr_zero(occupied);
+            startUs = base + (int64_t(slot) << shift);
+            return true;
+        }
+
+        // The top level is a ring: search from the slot after the current one, and a slot at or
+        // behind it belongs to the next rotation
+        //
+        const int from = (current + 1) & (kSlots - 1);
+        slot = (std::countr_zero(std::rotr(occupied, from)) + from) & (kSlots - 1);
+        startUs = base + (int64_t(slot) << shift);
+        if (slot <= current)
+        {
+            startUs += kRangeUs;
+        }
+        return true;
+    }
+    return false;
+}
+
+int64_t TimerWheel::NextExpiryUs() const
+{
+    assert(m_count);
+    if (m_heads[kDue])
+    {
+        return m_elapsedUs;
+    }
+
+    int level, slot;
+    int64_t startUs = INT64_MAX;
+    NextSlot(level, slot, startUs);
+    return std::min(startUs, ReclaimUs());
+}
+
+void TimerWheel::Cascade(uint16_t bucket)
+{
+    TimerNode* node = m_heads[bucket];
+    m_heads[bucket] = nullptr;
+    if (bucket < kDue)
+    {
+        m_occupied[bucket / kSlots] &= ~(uint64_t(1) << (bucket % kSlots));
+    }
+    else if (bucket == kOverflow)
+    {
+        m_overflowMinUs = INT64_MAX;
+    }
+
+    while (node)
+    {
+        TimerNode* next = node->m_next;
+        Place(node);
+        node = next;
+    }
+}
+
+// Each pass takes the earliest event at or before now -- a slot starting, or the overflow list
+// coming into range -- moves the wheel's time to it, and re-places what it held. The time never
+// moves onto a slot's start without that slot being cascaded, or the slot's nodes would no longer
+// be where BucketFor puts them. A level-0 slot's
+// nodes all have the slot's start as their deadline, so they land on the due list; a higher slot's
+// land lower down. The due list is drained before the time moves again, which keeps pops in
+// deadline order.
+//
+TimerNode* TimerWheel::PopExpired(int64_t nowUs)
+{
+    for (;;)
+    {
+        if (TimerNode* node = m_heads[kDue])
+        {
+            Unlink(node);
+            node->m_linked = false;
+            m_count--;
+            return node;
+        }
+        if (m_count == 0)
+        {
+            break;
+        }
+
+        int level, slot;
+        int64_t startUs;
+        const bool found = NextSlot(level, slot, startUs);
+        const int64_t reclaimUs = ReclaimUs();
+
+        if (reclaimUs <= nowUs && (!found || reclaimUs < startUs))
+        {
+            m_elapsedUs = std::max(m_elapsedUs, reclaimUs);
+            Cascade(kOverflow);
+            continue;
+        }
+        if (!found || startUs > nowUs)
+        {
+            break;
+        }
+        m_elapsedUs = startUs;
+        Cascade(static_cast<uint16_t>(level * kSlots + slot));
+    }
+
+    m_elapsedUs = std::max(m_elapsedUs, nowUs);
+    return nullptr;
+}
+
+bool TimerWheel::Validate() const
+{
+    size_t count = 0;
+    for (uint16_t bucket = 0; bucket < kBuckets; bucket++)
+    {
+        const TimerNode* prev = nullptr;
+        for (const TimerNode* n = m_heads[bucket]; n; prev = n, n = n->m_next)
+        {
+            if (!n->m_linked || n->m_bucket != bucket || n->m_prev != prev)
+            {
+                return false;
+            }
+            if (BucketFor(n->m_deadlineUs) != bucket)
+            {
+                return false;
+            }
+            if (bucket == kOverflow && n->m_deadlineUs < m_overflowMinUs)
+            {
+                return false;
+            }
+            count++;
+        }
+        if (bucket < kDue)
+        {
+            bool occupied = (m_occupied[bucket / kSlots] >> (bucket % kSlots)) & 1;
+            if (occupied != (m_heads[bucket] != nullptr))
+            {
+                return false;
+            }
+        }
+    }
+    return count == m_count;
+}
+
+} // end namespace time
+} // end namespace coop
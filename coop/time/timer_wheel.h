@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "timer_queue.h"
+
+namespace coop
+{
+
+struct Coordinator;
+
+namespace time
+{
+
+// A per-cooperator hierarchical hashed timing wheel over the same intrusive TimerNode the
+// TimerQueue uses, for fan-outs of timers too large for a heap's O(log n) delete: hundreds of
+// thousands of connection-idle timers, nearly all cancelled before they fire. Like the queue it is
+// single-threaded -- every method runs on the owning cooperator's thread -- and arming a timer
+// allocates nothing.
+//
+// kLevels levels of kSlots slots each, keyed by absolute monotonic microseconds. Level L slots are
+// 64^L microseconds wide, so the wheel spans kRangeUs (2^36us, about 19 hours) ahead of the wheel's
+// current time (m_elapsedUs). A deadline is placed at the level of the highest 6-bit digit in which
+// it differs from the current time, in the slot that digit names; when the current time reaches a
+// slot on a higher level, its nodes cascade down and land, exactly, on level 0. Nodes further out
+// than the whole wheel sit on an overflow list that is folded back in once the nearest of them
+// comes into range.
+//
+//   Insert, Remove     O(1): a list push or unlink, plus an occupancy bit
+//   PopExpired         O(1) per expired node, plus O(levels) per cascade; each node cascades
+//                      at most once per level
+//   NextExpiryUs       O(levels): a find-first-set over each level's occupancy mask
+//
+// Expiry is exact -- a node pops only once its deadline is <= now -- but NextExpiryUs is a lower
+// bound: for a node still on a higher level it is the start of that node's slot. A kernel timer
+// armed for it fires early, cascades, and re-arms, which the one-sided covenant permits; a long
+// sleep costs at most one such wake per level it passes through.
+//
+struct TimerWheel
+{
+    static constexpr int     kLevelBits = 6;
+    static constexpr int     kSlots     = 1 << kLevelBits;
+    static constexpr int     kLevels    = 6;
+    static constexpr int64_t kRangeUs   = int64_t(1) << (kLevelBits * kLevels);
+
+    TimerWheel(TimerWheel const&) = delete;
+    TimerWheel(TimerWheel&&) = delete;
+
+    // The wheel's time starts at nowUs and only moves forward, to the nowUs of each PopExpired.
+    // Deadlines at or before it are due at once.
+    //
+    explicit TimerWheel(int64_t nowUs = 0) : m_elapsedUs(nowUs) {}
+
+    bool Empty() const { return m_count == 0; }
+    size_t Size() const { return m_count; }
+
+    int64_t ElapsedUs() const { return m_elapsedUs; }
+
+    // No later than the nearest deadline in the wheel (see above). Only valid when !Empty().
+    //
+    int64_t NextExpiryUs() const;
+
+    // Register a node with the given absolute deadline and the coordinator to Release on expiry.
+    // O(1).
+    //
+    void Insert(TimerNode* node, int64_t deadlineUs, Coordinator* coord)
+    {
+        assert(!node->m_linked);
+        node->m_deadlineUs = deadlineUs;
+        node->m_coord      = coord;
+        node->m_child      = nullptr;
+        node->m_linked     = true;
+        m_count++;
+        Place(node);
+    }
+
+    // Remove a node from the wheel. Idempotent, as TimerQueue::Remove is. O(1).
+    //
+    void Remove(TimerNode* node)
+    {
+        if (!node->m_linked)
+        {
+            return;
+        }
+        Unlink(node);
+        node->m_linked = false;
+        m_count--;
+    }
+
+    // If a node's deadline is at or before nowUs, remove and return it; otherwise null, with the
+    // wheel's time moved up to nowUs. Nodes come out in deadline order, except that nodes already
+    // due when inserted come out first.
+    //
+    TimerNode* PopExpired(int64_t nowUs);
+
+    // Every node sits in the bucket its deadline maps to, and the occupancy masks and count agree
+    // with the lists. A test/debug helper, O(n).
+    //
+    bool Validate() const;
+
+  private:
+    static constexpr uint16_t kDue      = kLevels * kSlots;     // deadline <= m_elapsedUs
+    static constexpr uint16_t kOverflow = kDue + 1;             // beyond kRangeUs
+    static constexpr uint16_t kBuckets  = kOverflow + 1;
+
+    // The bucket a deadline maps to at the wheel's current time
+    //
+    uint16_t BucketFor(int64_t deadlineUs) const;
+
+    void Place(TimerNode* node);
+    void Push(uint16_t bucket, TimerNode* node);
+    void Unlink(TimerNode* node);
+
+    // The earliest occupied slot and when it starts, or false if no level holds a node
+    //
+    bool NextSlot(int& level, int& slot, int64_t& startUs) const;
+
+    // Re-place every node of a bucket at the wheel's (just advanced) time
+    //
+    void Cascade(uint16_t bucket);
+
+    // When the nearest overflow node may come into range: a lower bound, as m_overflowMinUs is
+    // left stale by removals
+    //
+    int64_t ReclaimUs() const
+    {
+        return m_heads[kOverflow] ? m_overflowMinUs - kRangeUs + 1 : INT64_MAX;
+    }
+
+    int64_t     m_elapsedUs;
+    size_t      m_count = 0;
+    int64_t     m_overflowMinUs = INT64_MAX;
+    uint64_t    m_occupied[kLevels] = {};
+    TimerNode*  m_heads[kBuckets] = {};
+};
+
+} // end namespace time
+} // end namespace coop
@@ -6,6 +6,8 @@
 #include <pthread.h>
 #include <dirent.h>
 #include <algorithm>
+#include <mutex>
+#include <tuple>
 
 #include "topology.h"
 
@@ -45,6 +47,129 @@ void ParseCpuList(char const* str, cpu_set_t& out)
     }
 }
 
+// Read the cpulist file at path into out. False if it cannot be read; an empty list is read.
+//
+bool ReadCpuListFile(char const* path, cpu_set_t& out)
+{
+    CPU_ZERO(&out);
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+
+    char buf[4096];
+    if (fgets(buf, sizeof(buf), f))
+    {
+        ParseCpuList(buf, out);
+    }
+    fclose(f);
+    return true;
+}
+
+// The lowest cpu in the cpulist file at path, or -1 if it cannot be read.
+//
+int LowestInCpuListFile(char const* path)
+{
+    cpu_set_t listed;
+    if (!ReadCpuListFile(path, listed))
+    {
+        return -1;
+    }
+    for (int c = 0; c < CPU_SETSIZE; c++)
+    {
+        if (CPU_ISSET(c, &listed))
+        {
+            return c;
+        }
+    }
+    return -1;
+}
+
+// Identify the last-level cache of the given cpu by the lowest cpu id sharing it. Walks the sysfs
+// cache indices for the highest level and reads its shared_cpu_list. Returns -1 if none is exposed.
+//
+int ReadLlcId(int cpu)
+{
+    int bestLevel = -1;
+    int bestIndex = -1;
+    for (int index = 0; index < 16; index++)
+    {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+
+        FILE* f = fopen(path, "r");
+        if (!f) break;
+
+        int level = -1;
+        if (fscanf(f, "%d", &level) == 1 && level > bestLevel)
+        {
+            bestLevel = level;
+            bestIndex = index;
+        }
+        fclose(f);
+    }
+    if (bestIndex < 0)
+    {
+        return -1;
+    }
+
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list",
+             cpu, bestIndex);
+    return LowestInCpuListFile(path);
+}
+
+// Identify the physical core of the given cpu by the lowest cpu id among its hardware threads.
+// core_cpus_list is the current name (5.4+); thread_siblings_list the older one. Returns -1 if
+// neither is exposed.
+//
+int ReadCoreId(int cpu)
+{
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_cpus_list", cpu);
+    int id = LowestInCpuListFile(path);
+    if (id < 0)
+    {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+                 cpu);
+        id = LowestInCpuListFile(path);
+    }
+    return id;
+}
+
+// Narrow available to the cgroup v2 cpuset's effective cpus. The affinity mask normally follows
+// the cpuset already; this covers a cpuset changed after the mask was inherited. Left alone when
+// the cgroup has no cpuset file or the intersection would be empty.
+//
+void ApplyCgroupCpuset(cpu_set_t& available)
+{
+    FILE* f = fopen("/proc/self/cgroup", "r");
+    if (!f) return;
+
+    char line[4096];
+    char path[4096 + 64] = {};
+    while (fgets(line, sizeof(line), f))
+    {
+        if (strncmp(line, "0::", 3) == 0)
+        {
+            line[strcspn(line, "\n")] = '\0';
+            snprintf(path, sizeof(path), "/sys/fs/cgroup%s/cpuset.cpus.effective", line + 3);
+            break;
+        }
+    }
+    fclose(f);
+
+    cpu_set_t cpuset;
+    if (!path[0] || !ReadCpuListFile(path, cpuset) || CPU_COUNT(&cpuset) == 0)
+    {
+        return;
+    }
+    cpu_set_t narrowed;
+    CPU_AND(&narrowed, &available, &cpuset);
+    if (CPU_COUNT(&narrowed) > 0)
+    {
+        available = narrowed;
+    }
+}
+
 // Apply COOP_NUMA_NODE and COOP_CPUS env var filters to the discovered topology.
 // COOP_NUMA_NODE=N restricts to CPUs on that NUMA node.
 // COOP_CPUS=0-3,8 restricts to an explicit CPU set.
@@ -152,6 +277,10 @@ Topology DiscoverTopology()
     {
         return topo;
     }
+    ApplyCgroupCpuset(available);
+
+    cpu_set_t isolated;
+    ReadCpuListFile("/sys/devices/system/cpu/isolated", isolated);
 
     // First pass: record all available CPUs. NUMA node assignment is backfilled from the
     // node-side scan below.
@@ -167,6 +296,9 @@ Topology DiscoverTopology()
         CpuInfo info;
         info.cpu_id = cpu;
         info.numa_node = 0; // filled in below
+        info.llc_id = ReadLlcId(cpu);
+        info.core_id = ReadCoreId(cpu);
+        info.isolated = CPU_ISSET(cpu, &isolated);
         topo.cpus.push_back(info);
     }
 
@@ -285,6 +417,11 @@ Topology DiscoverTopology()
 
 std::atomic<int> s_roundRobinCounter{0};
 
+// Cooperators placed per cpu, by PlaceCpu
+//
+std::mutex       s_placementMutex;
+std::vector<int> s_placementLoad;
+
 } // end anonymous namespace
 
 int Topology::NumaNodeForCpu(int cpu_id) const
@@ -299,6 +436,172 @@ int Topology::NumaNodeForCpu(int cpu_id) const
     return -1;
 }
 
+int Topology::LlcForCpu(int cpu_id) const
+{
+    for (auto const& info : cpus)
+    {
+        if (info.cpu_id == cpu_id)
+        {
+            return info.llc_id;
+        }
+    }
+    return -1;
+}
+
+int Topology::CoreForCpu(int cpu_id) const
+{
+    for (auto const& info : cpus)
+    {
+        if (info.cpu_id == cpu_id)
+        {
+            return info.core_id;
+        }
+    }
+    return -1;
+}
+
+std::vector<int> Topology::SiblingsOf(int cpu_id) const
+{
+    std::vector<int> siblings;
+    const int core = CoreForCpu(cpu_id);
+    for (auto const& info : cpus)
+    {
+        if (info.cpu_id == cpu_id || (core >= 0 && info.core_id == core))
+        {
+            siblings.push_back(info.cpu_id);
+        }
+    }
+    return siblings;
+}
+
+std::vector<int> Topology::PlacementOrder(PlacementPolicy policy) const
+{
+    bool anyIsolated = false;
+    bool allIsolated = !cpus.empty();
+    for (auto const& info : cpus)
+    {
+        anyIsolated |= info.isolated;
+        allIsolated &= info.isolated;
+    }
+
+    std::vector<CpuInfo const*> eligible;
+    for (auto const& info : cpus)
+    {
+        if (!info.isolated || allIsolated || !anyIsolated)
+        {
+            eligible.push_back(&info);
+        }
+    }
+    std::sort(eligible.begin(), eligible.end(),
+              [](auto const* a, auto const* b) { return a->cpu_id < b->cpu_id; });
+
+    if (policy == PlacementPolicy::RoundRobin)
+    {
+        std::vector<int> order;
+        for (auto const* info : eligible)
+        {
+            order.push_back(info->cpu_id);
+        }
+        return order;
+    }
+
+    // Per cpu: its hardware thread rank on its core (0 for the lowest id), its cache group (the
+    // LLC, or the NUMA node where the LLC is unknown) and its place among the cpus of the same
+    // rank in that group
+    //
+    struct Key
+    {
+        int rank;
+        int group;
+        int position;
+        int cpu;
+    };
+    std::vector<std::pair<int, int>> groups;       // (numa node, group id), sorted
+    std::vector<Key> keys;
+    for (auto const* info : eligible)
+    {
+        int rank = 0;
+        for (auto const* other : eligible)
+        {
+            if (other->cpu_id < info->cpu_id && info->core_id >= 0 &&
+                other->core_id == info->core_id)
+            {
+                rank++;
+            }
+        }
+        const int group = info->llc_id >= 0 ? info->llc_id : -1 - info->numa_node;
+        groups.emplace_back(info->numa_node, group);
+        keys.push_back({rank, group, 0, info->cpu_id});
+    }
+    std::sort(groups.begin(), groups.end());
+    groups.erase(std::unique(groups.begin(), groups.end()), groups.end());
+
+    for (auto& key : keys)
+    {
+        for (auto const& other : keys)
+        {
+            if (other.group == key.group && other.rank == key.rank && other.cpu < key.cpu)
+            {
+                key.position++;
+            }
+        }
+    }
+    for (auto& key : keys)
+    {
+        int groupIndex = 0;
+        while (groups[groupIndex].second != key.group)
+        {
+            groupIndex++;
+        }
+        key.group = groupIndex;
+    }
+
+    // Spread deals one core from each group in turn; Pack takes a group's cores before the next
+    // group's. Either way a rank is exhausted before the next rank starts.
+    //
+    const bool spread = policy == PlacementPolicy::SpreadPhysicalFirst;
+    std::sort(keys.begin(), keys.end(), [spread](Key const& a, Key const& b)
+    {
+        if (spread)
+        {
+            return std::tie(a.rank, a.position, a.group) < std::tie(b.rank, b.position, b.group);
+        }
+        return std::tie(a.rank, a.group, a.position) < std::tie(b.rank, b.group, b.position);
+    });
+
+    std::vector<int> order;
+    for (auto const& key : keys)
+    {
+        order.push_back(key.cpu);
+    }
+    return order;
+}
+
+int Topology::PickCpu(PlacementPolicy policy, std::vector<int> const& load) const
+{
+    auto loadOf = [&](int cpu) { return cpu < static_cast<int>(load.size()) ? load[cpu] : 0; };
+
+    int best = -1;
+    int bestCore = 0;
+    int bestCpu = 0;
+    for (int cpu : PlacementOrder(policy))
+    {
+        int coreLoad = 0;
+        for (int sibling : SiblingsOf(cpu))
+        {
+            coreLoad += loadOf(sibling);
+        }
+        const int cpuLoad = loadOf(cpu);
+        if (best < 0 || coreLoad < bestCore || (coreLoad == bestCore && cpuLoad < bestCpu))
+        {
+            best = cpu;
+            bestCore = coreLoad;
+            bestCpu = cpuLoad;
+        }
+    }
+    return best;
+}
+
 Topology const& GetTopology()
 {
     static Topology topo = DiscoverTopology();
@@ -317,6 +620,36 @@ int NextRoundRobinCpu()
     return topo.cpus[idx % topo.cpus.size()].cpu_id;
 }
 
+int PlaceCpu(PlacementPolicy policy, int requested /* = -1 */)
+{
+    std::lock_guard<std::mutex> lock(s_placementMutex);
+    int cpu = requested;
+    if (cpu < 0)
+    {
+        cpu = policy == PlacementPolicy::RoundRobin
+            ? NextRoundRobinCpu()
+            : GetTopology().PickCpu(policy, s_placementLoad);
+    }
+    if (cpu >= 0 && cpu < CPU_SETSIZE)
+    {
+        if (s_placementLoad.size() <= static_cast<size_t>(cpu))
+        {
+            s_placementLoad.resize(cpu + 1, 0);
+        }
+        s_placementLoad[cpu]++;
+    }
+    return cpu;
+}
+
+void ReleaseCpu(int cpu)
+{
+    std::lock_guard<std::mutex> lock(s_placementMutex);
+    if (cpu >= 0 && static_cast<size_t>(cpu) < s_placementLoad.size() && s_placementLoad[cpu] > 0)
+    {
+        s_placementLoad[cpu]--;
+    }
+}
+
 int PinThread(int cpu_id)
 {
     cpu_set_t set;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace coop
@@ -10,6 +11,45 @@ struct CpuInfo
 {
     int cpu_id;
     int numa_node;
+
+    // Identifies the last-level cache this CPU shares: the lowest CPU id in that cache's
+    // shared_cpu_list, so two CPUs share an LLC exactly when their llc_id matches. -1 when sysfs
+    // exposes no cache information.
+    //
+    int llc_id;
+
+    // Identifies the physical core: the lowest CPU id among its hardware threads, so two CPUs
+    // are SMT siblings exactly when their core_id matches. -1 when sysfs exposes no core
+    // topology.
+    //
+    int core_id;
+
+    // Listed in /sys/devices/system/cpu/isolated (isolcpus=). Automatic placement passes isolated
+    // cpus over unless every available cpu is isolated; an explicit cpuAffinity still pins there.
+    //
+    bool isolated;
+};
+
+// How a cooperator without an explicit cpuAffinity picks its cpu.
+//
+// RoundRobin is the historical default: the next available cpu in id order, whatever already runs
+// there. On SMT hardware with sibling ids interleaved it can put two busy cooperators on one
+// physical core while another core sits idle.
+//
+// SpreadPhysicalFirst and PackLLC place on the least-loaded physical core, counting every pinned
+// cooperator, by PlaceCpu. A core's second hardware thread is only used once every core carries
+// one cooperator. They differ in which idle core goes first:
+//   - SpreadPhysicalFirst spreads across last-level caches (and NUMA nodes), so independent
+//     cooperators do not share an L3.
+//   - PackLLC fills one shared-L3 group's cores before starting the next, so cooperators that
+//     hand work to each other stay in one cache.
+// Neither uses an isolated cpu unless that is all there is.
+//
+enum class PlacementPolicy : uint8_t
+{
+    RoundRobin,
+    SpreadPhysicalFirst,
+    PackLLC,
 };
 
 struct NumaNodeInfo
@@ -24,6 +64,24 @@ struct Topology
     std::vector<NumaNodeInfo> nodes;
 
     int NumaNodeForCpu(int cpu_id) const;
+    int LlcForCpu(int cpu_id) const;
+    int CoreForCpu(int cpu_id) const;
+
+    // The cpus sharing cpu_id's physical core, cpu_id included, in id order. Just cpu_id when the
+    // core topology is unknown; empty for a cpu not in the topology.
+    //
+    std::vector<int> SiblingsOf(int cpu_id) const;
+
+    // The cpus policy places on, best first while every cpu is idle.
+    //
+    std::vector<int> PlacementOrder(PlacementPolicy policy) const;
+
+    // The cpu policy would place the next cooperator on. load[c] is the number of cooperators
+    // cpu c already carries; a missing entry counts as 0. The cpu whose physical core carries the
+    // least wins, then the cpu itself carrying the least, then PlacementOrder. RoundRobin here is
+    // least-loaded in id order (PlaceCpu keeps its counter). -1 if there are no cpus.
+    //
+    int PickCpu(PlacementPolicy policy, std::vector<int> const& load) const;
 };
 
 // Discover the system topology. Reads from sysfs + sched_getaffinity to determine which
@@ -36,6 +94,16 @@ Topology const& GetTopology();
 //
 int NextRoundRobinCpu();
 
+// Choose a cpu for a cooperator and count it as carrying one more. requested >= 0 (an explicit
+// cpuAffinity) is taken as is; otherwise RoundRobin is NextRoundRobinCpu and the other policies
+// are GetTopology().PickCpu over the current counts. Returns -1 when there is no cpu. Thread-safe.
+//
+int PlaceCpu(PlacementPolicy policy, int requested = -1);
+
+// The cooperator placed on cpu by PlaceCpu has gone
+//
+void ReleaseCpu(int cpu);
+
 // Pin the calling thread to the given logical CPU. Returns 0 on success, -1 on failure.
 //
 int PinThread(int cpu_id);
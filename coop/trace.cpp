@@ -0,0 +1,564 @@
+#include "trace.h"
+
+#include <ctime>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "context_var.h"
+#include "cooperator.h"
+#include "cooperator_var.h"
+#include "cooperator_var.hpp"
+#include "detail/tsc.h"
+#include "perf/histogram.h"
+#include "time/sleep.h"
+
+namespace coop
+{
+namespace trace
+{
+
+namespace
+{
+
+// The ContextVar's type: a new context starts with its spawner's trace context (Spawn and Launch
+// construct ContextVars on the spawner's thread, before switching), less the local-only bits
+//
+struct Inherited : SpanContext
+{
+    Inherited()
+    {
+        if (IsTracing())
+        {
+            if (SpanContext* current = Current())
+            {
+                *static_cast<SpanContext*>(this) = *current;
+                flags &= kSampled;
+            }
+        }
+    }
+};
+
+ContextVar<Inherited> s_context;
+
+// Per cooperator: where a Thunk run from a loop drain keeps its context, there being no current
+// one, and the span id sequence
+//
+struct CooperatorTrace
+{
+    SpanContext drain;
+    uint64_t    idState = 0;
+};
+
+CooperatorVar<CooperatorTrace> s_cooperator;
+
+// Sampled when the trace id's low 56 bits, its random part under W3C level 2, fall below this
+//
+constexpr uint64_t kSampleScale = uint64_t(1) << 56;
+std::atomic<uint64_t> s_threshold{0};
+std::atomic<double> s_rate{0.0};
+
+uint64_t NextId()
+{
+    // splitmix64 over a per-cooperator sequence seeded from the TSC and the cooperator
+    //
+    uint64_t& state = s_cooperator->idState;
+    if (!state)
+    {
+        state = static_cast<uint64_t>(detail::ReadTsc()) ^
+                reinterpret_cast<uintptr_t>(&state) ^ 0x9e3779b97f4a7c15ull;
+    }
+    uint64_t z;
+    do
+    {
+        z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z ^= z >> 31;
+    }
+    while (!z);
+    return z;
+}
+
+// CLOCK_REALTIME minus CLOCK_MONOTONIC, taken once: spans are timed on the monotonic clock the
+// perf probes read, and reported in Unix time
+//
+int64_t UnixOffset()
+{
+    static const int64_t s_offset = []
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        int64_t real = static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        return real - perf::NowNanos();
+    }();
+    return s_offset;
+}
+
+// ---- Span rings ----
+
+// Single producer (the owning cooperator's thread), single consumer (the exporter). The slots are
+// allocated on the first push, so a cooperator that never samples a span keeps only the header.
+//
+struct SpanRing
+{
+    SpanRing() = default;
+    SpanRing(SpanRing const&) = delete;
+
+    ~SpanRing()
+    {
+        delete[] m_slots.load(std::memory_order_relaxed);
+    }
+
+    void Push(SpanData const& span)
+    {
+        SpanData* slots = m_slots.load(std::memory_order_relaxed);
+        if (!slots) [[unlikely]]
+        {
+            slots = new (std::nothrow) SpanData[kRingCapacity];
+            if (!slots)
+            {
+                m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1,
+                                std::memory_order_relaxed);
+                return;
+            }
+            m_slots.store(slots, std::memory_order_release);
+        }
+
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) >= kRingCapacity)
+        {
+            m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+            return;
+        }
+        slots[head % kRingCapacity] = span;
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    // Exporter only
+    //
+    void Drain(std::vector<SpanData>& out)
+    {
+        SpanData* slots = m_slots.load(std::memory_order_acquire);
+        if (!slots)
+        {
+            return;
+        }
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        for (; tail != head; tail++)
+        {
+            out.push_back(slots[tail % kRingCapacity]);
+        }
+        m_tail.store(tail, std::memory_order_release);
+    }
+
+    uint64_t Pending() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    uint64_t Dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<SpanData*>            m_slots{nullptr};
+    alignas(64) std::atomic<uint64_t> m_head{0};
+    std::atomic<uint64_t>             m_dropped{0};
+    alignas(64) std::atomic<uint64_t> m_tail{0};
+};
+
+CooperatorVar<SpanRing> s_rings;
+
+std::atomic<bool> s_exporting{false};
+
+void Record(SpanData const& span)
+{
+    if (Cooperator::thread_cooperator)
+    {
+        s_rings->Push(span);
+    }
+}
+
+void AppendHex(std::string& out, uint64_t value, int digits)
+{
+    static const char s_hex[] = "0123456789abcdef";
+    for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4)
+    {
+        out += s_hex[(value >> shift) & 0xf];
+    }
+}
+
+void AppendEscaped(std::string& out, std::string_view s)
+{
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            out += "\\u00";
+            AppendHex(out, static_cast<unsigned char>(c), 2);
+        }
+        else
+        {
+            out += c;
+        }
+    }
+}
+
+int HexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;                                      // the spec's hex is lowercase only
+}
+
+bool ParseHex(std::string_view s, uint64_t& out)
+{
+    out = 0;
+    for (char c : s)
+    {
+        int v = HexValue(c);
+        if (v < 0)
+        {
+            return false;
+        }
+        out = (out << 4) | static_cast<uint64_t>(v);
+    }
+    return true;
+}
+
+} // end anon namespace
+
+// -------------------------------------------------------------------------------------
+// Configuration and the current context
+// -------------------------------------------------------------------------------------
+
+void SetSampleRate(double rate)
+{
+    rate = rate < 0.0 ? 0.0 : (rate > 1.0 ? 1.0 : rate);
+    s_rate.store(rate, std::memory_order_relaxed);
+    s_threshold.store(static_cast<uint64_t>(rate * static_cast<double>(kSampleScale)),
+                      std::memory_order_relaxed);
+    g_tracing.store(true, std::memory_order_relaxed);
+}
+
+double GetSampleRate()
+{
+    return s_rate.load(std::memory_order_relaxed);
+}
+
+void Disable()
+{
+    g_tracing.store(false, std::memory_order_relaxed);
+}
+
+SpanContext* Current()
+{
+    auto* co = Cooperator::thread_cooperator;
+    if (!co)
+    {
+        return nullptr;
+    }
+    Context* ctx = co->Scheduled();
+    return ctx ? static_cast<SpanContext*>(s_context.Get(ctx)) : &s_cooperator.Get(co)->drain;
+}
+
+// -------------------------------------------------------------------------------------
+// Spans
+// -------------------------------------------------------------------------------------
+
+void Span::Begin(const char* name, Kind kind)
+{
+    SpanContext* slot = Current();
+    if (!slot)
+    {
+        return;
+    }
+    slot->flags &= ~kAdoptable;                     // it has a child now
+    m_slot = slot;
+    m_saved = *slot;
+    m_name = name;
+    m_kind = kind;
+
+    SpanContext next;
+    if (slot->Valid())
+    {
+        next.traceHi = slot->traceHi;
+        next.traceLo = slot->traceLo;
+        next.parentId = slot->spanId;
+        next.flags = slot->flags & kSampled;
+    }
+    else
+    {
+        next.traceHi = NextId();
+        next.traceLo = NextId();
+        if ((next.traceLo >> 8) < s_threshold.load(std::memory_order_relaxed))
+        {
+            next.flags = kSampled;
+        }
+    }
+    next.spanId = NextId();
+
+    // A server span may yet adopt a sampled upstream trace, so it is timed either way
+    //
+    if (kind == Kind::Server)
+    {
+        next.flags |= kAdoptable;
+    }
+    if (next.Sampled() || kind == Kind::Server)
+    {
+        m_startNs = perf::NowNanos();
+    }
+    *slot = next;
+}
+
+void Span::End()
+{
+    SpanContext const& span = *m_slot;
+    if (span.Sampled())
+    {
+        const int64_t offset = UnixOffset();
+        Record(SpanData{
+            .traceHi = span.traceHi,
+            .traceLo = span.traceLo,
+            .spanId = span.spanId,
+            .parentId = span.parentId,
+            .startNs = m_startNs + offset,
+            .endNs = perf::NowNanos() + offset,
+            .name = m_name,
+            .status = m_status,
+            .kind = m_kind,
+        });
+    }
+    *m_slot = m_saved;
+}
+
+// -------------------------------------------------------------------------------------
+// W3C traceparent
+// -------------------------------------------------------------------------------------
+
+bool ParseTraceParent(std::string_view value, SpanContext& out)
+{
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+    {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+    {
+        value.remove_suffix(1);
+    }
+    if (value.size() < kTraceParentSize)
+    {
+        return false;
+    }
+
+    uint64_t version, hi, lo, span, flags;
+    if (!ParseHex(value.substr(0, 2), version) || version == 0xff || value[2] != '-' ||
+        !ParseHex(value.substr(3, 16), hi) || !ParseHex(value.substr(19, 16), lo) ||
+        value[35] != '-' || !ParseHex(value.substr(36, 16), span) || value[52] != '-' ||
+        !ParseHex(value.substr(53, 2), flags))
+    {
+        return false;
+    }
+
+    // Version 00 is exactly this long; a later version may append fields after a dash
+    //
+    if (value.size() > kTraceParentSize && (version == 0 || value[kTraceParentSize] != '-'))
+    {
+        return false;
+    }
+    if (!(hi | lo) || !span)
+    {
+        return false;
+    }
+
+    out = SpanContext{};
+    out.traceHi = hi;
+    out.traceLo = lo;
+    out.spanId = span;
+    out.flags = static_cast<uint8_t>(flags) & kSampled;
+    return true;
+}
+
+size_t FormatTraceParent(SpanContext const& ctx, char* out)
+{
+    static const char s_hex[] = "0123456789abcdef";
+    auto put = [&](size_t at, uint64_t value, int digits)
+    {
+        for (int i = digits - 1; i >= 0; i--, value >>= 4)
+        {
+            out[at + i] = s_hex[value & 0xf];
+        }
+    };
+    out[0] = '0';
+    out[1] = '0';
+    out[2] = '-';
+    put(3, ctx.traceHi, 16);
+    put(19, ctx.traceLo, 16);
+    out[35] = '-';
+    put(36, ctx.spanId, 16);
+    out[52] = '-';
+    put(53, ctx.flags & kSampled, 2);
+    return kTraceParentSize;
+}
+
+void Adopt(SpanContext const& remote)
+{
+    if (!IsTracing())
+    {
+        return;
+    }
+    SpanContext* slot = Current();
+    if (!slot || !(slot->flags & kAdoptable))
+    {
+        return;
+    }
+    slot->traceHi = remote.traceHi;
+    slot->traceLo = remote.traceLo;
+    slot->parentId = remote.spanId;
+    slot->flags = remote.flags & kSampled;
+}
+
+void SetRemoteParent(SpanContext const& remote)
+{
+    if (!IsTracing())
+    {
+        return;
+    }
+    SpanContext* slot = Current();
+    if (!slot || slot->Valid())
+    {
+        return;
+    }
+    *slot = remote;
+    slot->parentId = 0;
+    slot->flags &= kSampled;
+}
+
+// -------------------------------------------------------------------------------------
+// Export
+// -------------------------------------------------------------------------------------
+
+uint64_t PendingSpans()
+{
+    uint64_t pending = 0;
+    Cooperator::VisitRegistry([&](Cooperator* co) -> bool
+    {
+        pending += s_rings.Get(co)->Pending();
+        return true;
+    });
+    return pending;
+}
+
+uint64_t DroppedSpans()
+{
+    uint64_t dropped = 0;
+    Cooperator::VisitRegistry([&](Cooperator* co) -> bool
+    {
+        dropped += s_rings.Get(co)->Dropped();
+        return true;
+    });
+    return dropped;
+}
+
+bool StartExporter(Sink sink, time::Interval interval, Context::Handle* handle)
+{
+    if (s_exporting.exchange(true, std::memory_order_acq_rel))
+    {
+        return false;
+    }
+
+    bool spawned = Cooperator::thread_cooperator->Spawn(
+        [sink = std::move(sink), interval](Context* ctx)
+    {
+        ctx->SetName("TraceExporter");
+
+        // Taken in a registry visit, handed to the sink outside it: the sink may block
+        //
+        std::vector<SpanData> batch;
+        batch.reserve(kRingCapacity);
+        bool running = true;
+        while (running)
+        {
+            running = time::Sleep(ctx, interval) == time::SleepResult::Ok;
+            Cooperator::VisitRegistry([&](Cooperator* co) -> bool
+            {
+                s_rings.Get(co)->Drain(batch);
+                return true;
+            });
+            if (!batch.empty())
+            {
+                sink(batch.data(), batch.size());
+                batch.clear();
+            }
+        }
+        s_exporting.store(false, std::memory_order_release);
+    }, handle);
+
+    if (!spawned)
+    {
+        s_exporting.store(false, std::memory_order_release);
+    }
+    return spawned;
+}
+
+void AppendOtlpJson(std::string& out, SpanData const* spans, size_t count,
+                    std::string_view serviceName)
+{
+    out += "{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":\"service.name\","
+           "\"value\":{\"stringValue\":\"";
+    AppendEscaped(out, serviceName);
+    out += "\"}}]},\"scopeSpans\":[{\"scope\":{\"name\":\"coop\"},\"spans\":[";
+
+    for (size_t i = 0; i < count; i++)
+    {
+        SpanData const& s = spans[i];
+        if (i)
+        {
+            out += ',';
+        }
+        out += "{\"traceId\":\"";
+        AppendHex(out, s.traceHi, 16);
+        AppendHex(out, s.traceLo, 16);
+        out += "\",\"spanId\":\"";
+        AppendHex(out, s.spanId, 16);
+        out += '"';
+        if (s.parentId)
+        {
+            out += ",\"parentSpanId\":\"";
+            AppendHex(out, s.parentId, 16);
+            out += '"';
+        }
+        out += ",\"name\":\"";
+        AppendEscaped(out, s.name ? s.name : "");
+        out += "\",\"kind\":";
+        out += std::to_string(static_cast<int>(s.kind));
+        out += ",\"startTimeUnixNano\":\"";
+        out += std::to_string(s.startNs);
+        out += "\",\"endTimeUnixNano\":\"";
+        out += std::to_string(s.endNs);
+        out += '"';
+        if (s.status)
+        {
+            out += ",\"attributes\":[{\"key\":\"http.response.status_code\","
+                   "\"value\":{\"intValue\":\"";
+            out += std::to_string(s.status);
+            out += "\"}}]";
+
+            // OTel's HTTP conventions: 5xx is an error on either side, 4xx only on the client's
+            //
+            bool error = s.status >= 500 || (s.kind == Kind::Client && s.status >= 400);
+            out += error ? ",\"status\":{\"code\":2}" : ",\"status\":{}";
+        }
+        out += '}';
+    }
+    out += "]}]}]}";
+}
+
+} // end namespace coop::trace
+} // end namespace coop
@@ -0,0 +1,270 @@
+#pragma once
+
+// Distributed tracing in the OpenTelemetry model, sized so a service can leave it on. A trace
+// context (trace id, the active span's id, W3C flags) lives in a ContextVar and follows the work:
+//
+//   - Spawn and Launch: a child context starts with its spawner's context, so its spans are
+//     children of the span that spawned it.
+//   - Erg and Continuation: Shed and Continue capture the caller's context into the Thunk, and
+//     the Thunk runs under it, on whichever cooperator or loop drain picks it up.
+//   - HTTP: the server extracts a `traceparent` request header into its "http.server" span (as
+//     HTTP/1.1 headers are read or skipped; at stream open on HTTP/2); the HTTP/1.1 client
+//     injects the caller's context into every request it sends.
+//
+// A Span is a scope on the stack. Only sampled spans are recorded: each cooperator has a span ring
+// its own thread writes without a lock or an atomic RMW, and one exporter context (StartExporter)
+// drains every ring on an interval and hands the spans to a sink -- AppendOtlpJson renders a batch
+// as an OTLP/JSON ExportTraceServiceRequest body. A full ring drops the span and counts it. There
+// is no allocation per span; the ring itself is allocated on a cooperator's first sampled span.
+//
+// Tracing is off until SetSampleRate (or COOP_TRACE_SAMPLE=<rate> in the environment). Off, a
+// Span is one relaxed load and Shed/Continue capture nothing. On, an unsampled Span makes ids and
+// propagates them (flags 00) but reads no clock and writes no ring, which is what makes a 1% rate
+// cheap. The sampling decision is made once per trace, at its root, from the trace id; a trace
+// that arrives with a traceparent keeps its upstream decision.
+//
+//   coop::trace::SetSampleRate(0.01);
+//   coop::trace::StartExporter([](coop::trace::SpanData const* spans, size_t n)
+//   {
+//       ...                                    // e.g. AppendOtlpJson, then POST to a collector
+//   });
+//
+//   void Lookup(...)
+//   {
+//       coop::trace::Span span("cache.lookup");
+//       ...
+//   }
+//
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "context.h"
+#include "time/interval.h"
+
+namespace coop
+{
+namespace trace
+{
+
+// W3C trace-context flags. kSampled is the wire's `sampled` bit; kAdoptable is local only (never
+// sent) and marks a server span that has had no children yet, so a traceparent read later in
+// the request can still re-parent it.
+//
+constexpr uint8_t kSampled   = 0x01;
+constexpr uint8_t kAdoptable = 0x80;
+
+enum class Kind : uint8_t
+{
+    Internal = 1,           // OTLP's SpanKind numbering
+    Server   = 2,
+    Client   = 3,
+};
+
+// What propagates: the trace, the active span within it, that span's parent, and the flags. All
+// zero is "no trace".
+//
+struct SpanContext
+{
+    uint64_t traceHi = 0;
+    uint64_t traceLo = 0;
+    uint64_t spanId = 0;
+    uint64_t parentId = 0;
+    uint8_t  flags = 0;
+
+    bool Valid() const { return (traceHi | traceLo) && spanId; }
+    bool Sampled() const { return flags & kSampled; }
+};
+
+// One finished, sampled span as it sits in a ring and reaches the exporter's sink. Times are Unix
+// nanoseconds; name has static storage duration (a Span keeps the pointer, not a copy).
+//
+struct SpanData
+{
+    uint64_t    traceHi;
+    uint64_t    traceLo;
+    uint64_t    spanId;
+    uint64_t    parentId;
+    int64_t     startNs;
+    int64_t     endNs;
+    const char* name;
+    int32_t     status;         // the HTTP status for http spans, else 0 (unset)
+    Kind        kind;
+};
+
+// ---- Configuration ----
+
+inline std::atomic<bool> g_tracing{false};
+
+inline bool IsTracing()
+{
+    return g_tracing.load(std::memory_order_relaxed);
+}
+
+// Turn tracing on, sampling new traces at rate in [0, 1]. 0 still propagates and extracts, and
+// follows an upstream decision, but starts no sampled trace of its own.
+//
+void SetSampleRate(double rate);
+double GetSampleRate();
+
+void Disable();
+
+// ---- The current trace context ----
+
+// The calling context's trace context; in a Thunk running from a loop drain (no current context)
+// the cooperator's. Never null on a cooperator thread, and null off one: no spans are traced
+// there.
+//
+SpanContext* Current();
+
+// What a Thunk captures at creation: the current context with the local-only bits cleared, or
+// all zero when tracing is off
+//
+inline SpanContext Capture()
+{
+    SpanContext captured;
+    if (IsTracing())
+    {
+        if (SpanContext* current = Current())
+        {
+            captured = *current;
+            captured.flags &= kSampled;
+        }
+    }
+    return captured;
+}
+
+// Install a captured context for a scope, restoring what was there on exit. A no-op for an
+// invalid one, so a Thunk captured with tracing off costs one branch to run.
+//
+struct ContextScope
+{
+    explicit ContextScope(SpanContext const& captured)
+    {
+        if (captured.Valid()) [[unlikely]]
+        {
+            m_slot = Current();
+            if (m_slot)
+            {
+                m_saved = *m_slot;
+                *m_slot = captured;
+            }
+        }
+    }
+
+    ~ContextScope()
+    {
+        if (m_slot) [[unlikely]]
+        {
+            *m_slot = m_saved;
+        }
+    }
+
+    ContextScope(ContextScope const&) = delete;
+    ContextScope& operator=(ContextScope const&) = delete;
+
+  private:
+    SpanContext* m_slot = nullptr;
+    SpanContext  m_saved;
+};
+
+// ---- Spans ----
+
+// A span over the enclosing scope: a child of the current span, or the root of a new trace when
+// there is none. Opening and closing it must happen on the same context (or within one Thunk).
+//
+struct Span
+{
+    explicit Span(const char* name, Kind kind = Kind::Internal)
+    {
+        if (IsTracing()) [[unlikely]]
+        {
+            Begin(name, kind);
+        }
+    }
+
+    ~Span()
+    {
+        if (m_slot) [[unlikely]]
+        {
+            End();
+        }
+    }
+
+    Span(Span const&) = delete;
+    Span& operator=(Span const&) = delete;
+
+    void SetStatus(int32_t status) { m_status = status; }
+
+    bool Sampled() const { return m_slot && m_slot->Sampled(); }
+
+  private:
+    void Begin(const char* name, Kind kind);
+    void End();
+
+    SpanContext* m_slot = nullptr;
+    SpanContext  m_saved;
+    const char*  m_name = nullptr;
+    int64_t      m_startNs = 0;
+    int32_t      m_status = 0;
+    Kind         m_kind = Kind::Internal;
+};
+
+// ---- W3C traceparent ----
+
+// "00-<32 hex trace id>-<16 hex span id>-<2 hex flags>"
+//
+constexpr size_t kTraceParentSize = 55;
+
+// Parse a traceparent value. False for a malformed one, an all-zero id, or version ff; a later
+// version's extra fields are ignored, as the spec asks. On success out carries the remote trace
+// and span ids and the sampled bit.
+//
+bool ParseTraceParent(std::string_view value, SpanContext& out);
+
+// Write ctx's traceparent into out, which holds kTraceParentSize bytes. Returns kTraceParentSize.
+//
+size_t FormatTraceParent(SpanContext const& ctx, char* out);
+
+// The server's end of extraction. Adopt re-parents the current span under remote, when that span
+// is a server span with no children yet (kAdoptable): HTTP/1.1 calls it as the traceparent header
+// goes by. SetRemoteParent makes remote the current context of a context that has none yet, so
+// the next span opened there is remote's child: HTTP/2 calls it as a stream's context starts.
+// Both are no-ops with tracing off.
+//
+void Adopt(SpanContext const& remote);
+void SetRemoteParent(SpanContext const& remote);
+
+// ---- Export ----
+
+// Spans every cooperator has recorded but the exporter has not yet taken, and spans dropped
+// because a ring was full (summed over live cooperators)
+//
+uint64_t PendingSpans();
+uint64_t DroppedSpans();
+
+constexpr size_t kRingCapacity = 1024;
+
+using Sink = std::function<void(SpanData const* spans, size_t count)>;
+
+// Spawn the exporter as a child of the calling context (or of nothing, from a Submit), on this
+// cooperator. Every interval it takes what each cooperator's ring holds, up to a ring's capacity
+// per pass, and calls sink with the batch on the exporter's context, which the sink may block.
+// It drains once more when killed, then exits. One exporter at a time: returns false if one is
+// running or the spawn fails.
+//
+bool StartExporter(Sink sink, time::Interval interval = std::chrono::seconds(1),
+                   Context::Handle* handle = nullptr);
+
+// Append spans to out as an OTLP/JSON ExportTraceServiceRequest (the body for POST /v1/traces)
+// under a resource with the given service.name
+//
+void AppendOtlpJson(std::string& out, SpanData const* spans, size_t count,
+                    std::string_view serviceName);
+
+} // end namespace coop::trace
+} // end namespace coop
@@ -0,0 +1,116 @@
+#include "wait_group.h"
+
+#include <cassert>
+
+#include "self.h"
+
+namespace coop
+{
+
+WaitGroup::WaitGroup()
+: m_home(Cooperator::thread_cooperator)
+{
+    assert(m_home && "WaitGroup: construct on its home cooperator");
+}
+
+WaitGroup::~WaitGroup()
+{
+    assert(Cooperator::thread_cooperator == m_home);
+    assert(m_count.load(std::memory_order_relaxed) == 0
+           && "WaitGroup destroyed with work still counted");
+    while (m_opening.load(std::memory_order_acquire) > 0)
+    {
+        Yield();
+    }
+}
+
+void WaitGroup::Add(int64_t n /* = 1 */)
+{
+    // Only the home cooperator can take the count off zero (Done's work cannot have started), so
+    // only it ever holds m_done here. Held already means an Open is still on its way, which will
+    // find the count up again and leave it held.
+    //
+    if (m_count.fetch_add(n, std::memory_order_relaxed) == 0)
+    {
+        assert(Cooperator::thread_cooperator == m_home && "WaitGroup: Add from zero off home");
+        m_done.TryAcquire();
+    }
+}
+
+void WaitGroup::Done()
+{
+    auto* self = Cooperator::thread_cooperator;
+    if (self == m_home)
+    {
+        int64_t before = m_count.fetch_sub(1, std::memory_order_acq_rel);
+        assert(before > 0 && "WaitGroup: Done without a matching Add");
+        if (before == 1)
+        {
+            Open();
+        }
+        return;
+    }
+
+    // Off home, the count may reach zero -- and home see it and destroy the group -- the moment
+    // this decrement lands, so m_opening, which the destructor waits out, goes up first. A Done
+    // that was not the last drops it again as its final touch.
+    //
+    m_opening.fetch_add(1, std::memory_order_relaxed);
+    int64_t before = m_count.fetch_sub(1, std::memory_order_acq_rel);
+    assert(before > 0 && "WaitGroup: Done without a matching Add");
+    if (before != 1)
+    {
+        m_opening.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    auto openFn = [this](Context*)
+    {
+        Open();
+        m_opening.fetch_sub(1, std::memory_order_release);
+    };
+    bool submitted = self ? m_home->Cooperate(std::move(openFn)) : m_home->Submit(std::move(openFn));
+
+    // Only a home cooperator shutting down refuses; its teardown abandons the waiters
+    //
+    if (!submitted)
+    {
+        m_opening.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void WaitGroup::Wait(Context* ctx)
+{
+    WaitWith(ctx);
+}
+
+void WaitGroup::Open()
+{
+    if (m_count.load(std::memory_order_acquire) == 0)
+    {
+        m_done.Release(nullptr, false);
+    }
+}
+
+// Winning m_done hands it to this waiter; pass it on -- to the next waiter, or back to released --
+// unless a new round has started since, in which case it is that round's to hold. A wait that lost
+// to another argument with m_done handed to it too has had it released behind it; a new round
+// takes it back.
+//
+void WaitGroup::Passed(CoordinationResult const& result)
+{
+    bool idle = m_count.load(std::memory_order_acquire) == 0;
+    if (result.coordinator == &m_done)
+    {
+        if (idle)
+        {
+            m_done.Release(nullptr, false);
+        }
+    }
+    else if (!idle && !m_done.IsHeld())
+    {
+        m_done.TryAcquire();
+    }
+}
+
+} // end namespace coop
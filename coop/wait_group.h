@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "cooperator.h"
+#include "cooperator.hpp"
+#include "coordinate_with.h"
+#include "coordination_result.h"
+#include "coordinator.h"
+
+namespace coop
+{
+
+// WaitGroup joins a fan-out: Add counts work in, Done counts it out, and Wait blocks until the
+// count is back to zero. The group lives on the caller's frame, so a scatter-gather needs no
+// heap-allocated bookkeeping.
+//
+//  coop::WaitGroup wg;
+//  for (auto& shard : shards)
+//  {
+//      wg.Spawn([&](coop::Context* child) { Query(child, shard); });
+//  }
+//  if (wg.WaitWithKill(ctx, std::chrono::milliseconds(200)).TimedOut()) { ... }
+//
+// A group belongs to the cooperator that built it (its home): Add, Wait and destruction happen
+// there. Done may be called from anywhere -- a spawned context, a detached continuation, an Erg
+// run by a Grid stealer on another cooperator, a plain thread -- and is a single atomic decrement
+// on home; elsewhere it brackets that with a count the destructor waits out. The last Done opens
+// the group on its home: inline when it runs there, otherwise as a Cooperate (Submit from a plain
+// thread) that does nothing else.
+//
+// Add may also come from work the group is already counting, wherever it runs: the count cannot
+// reach zero in between. A group can be reused once its Wait has returned. It must not go out of
+// scope with work still counted -- after a wait that timed out or was killed, Wait again.
+//
+// WaitWith and WaitWithKill wait as CoordinateWith and CoordinateWithKill do, taking the same
+// extra arguments -- more coordinators or signals, and a trailing time::Interval -- after the
+// group. A result equal to the group's coordinator (index 0) means the count reached zero.
+//
+struct WaitGroup
+{
+    WaitGroup(WaitGroup const&) = delete;
+    WaitGroup(WaitGroup&&) = delete;
+
+    WaitGroup();
+
+    // Lets a last Done still on its way from another cooperator land first. From a context.
+    //
+    ~WaitGroup();
+
+    void Add(int64_t n = 1);
+    void Done();
+
+    // Add one and spawn fn on this cooperator, with its Done when it returns
+    //
+    template<typename Fn>
+    bool Spawn(Fn const& fn);
+
+    // Block until the count is zero. Not kill-aware, like Coordinator::Acquire.
+    //
+    void Wait(Context* ctx);
+
+    template<typename... Args>
+    CoordinationResult WaitWith(Context* ctx, Args... args);
+
+    template<typename... Args>
+    CoordinationResult WaitWithKill(Context* ctx, Args... args);
+
+    int64_t Count() const { return m_count.load(std::memory_order_acquire); }
+
+  private:
+    // On home: release the waiters, unless Add has opened a new round since the last Done
+    //
+    void Open();
+    void Passed(CoordinationResult const& result);
+
+    Cooperator*             m_home;
+    Coordinator             m_done;             // held <-> count above zero (or opening)
+    std::atomic<int64_t>    m_count{0};
+    std::atomic<int>        m_opening{0};       // remote last Dones not yet landed
+};
+
+template<typename Fn>
+bool WaitGroup::Spawn(Fn const& fn)
+{
+    Add();
+    bool spawned = Cooperator::thread_cooperator->Spawn([this, fn](Context* ctx)
+    {
+        fn(ctx);
+        Done();
+    });
+    if (!spawned)
+    {
+        Done();
+    }
+    return spawned;
+}
+
+template<typename... Args>
+CoordinationResult WaitGroup::WaitWith(Context* ctx, Args... args)
+{
+    auto result = CoordinateWith(ctx, &m_done, args...);
+    Passed(result);
+    return result;
+}
+
+template<typename... Args>
+CoordinationResult WaitGroup::WaitWithKill(Context* ctx, Args... args)
+{
+    auto result = CoordinateWithKill(ctx, &m_done, args...);
+    Passed(result);
+    return result;
+}
+
+} // end namespace coop
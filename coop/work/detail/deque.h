@@ -24,10 +24,18 @@ namespace detail
 // (run the task inline, or push to a shared injector) rather than the deque reallocating. T must be
 // trivially copyable -- a task pointer.
 //
-template<typename T, size_t CAP = 256>
+// BATCH is the most items one StealBatch may claim with its single CAS. A batch claim covers
+// [top, top + k) from a bottom the thief read before the CAS, and the owner may have popped past that
+// bottom in the meantime, so the owner can no longer take the bottom item without a CAS whenever it is
+// within BATCH of the top: instead it takes the top item with the same CAS the thieves use (FIFO for
+// the oldest BATCH items). Above that depth the owner path is the plain uncontended LIFO pop. With
+// the default BATCH = 1 this is exactly the classic last-element rule and StealBatch is Steal.
+//
+template<typename T, size_t CAP = 256, int BATCH = 1>
 class Deque
 {
     static_assert((CAP & (CAP - 1)) == 0, "CAP must be a power of two");
+    static_assert(BATCH >= 1 && (size_t)BATCH <= CAP, "BATCH must be in [1, CAP]");
     static constexpr int64_t kMask = (int64_t)CAP - 1;
 
   public:
@@ -51,38 +59,46 @@ class Deque
         return true;
     }
 
-    // Owner only. Take from the bottom (LIFO). Returns false if empty or if the last element was
-    // stolen out from under us in the race.
+    // Owner only. Take from the bottom (LIFO), or from the top within BATCH of it (see above).
+    // Returns false if empty, including when the last element was stolen out from under us.
     //
     bool PopBottom(T& out)
     {
-        const int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
-        m_bottom.store(b, std::memory_order_relaxed);
-        std::atomic_thread_fence(std::memory_order_seq_cst);    // order bottom store vs top load
-        int64_t t = m_top.load(std::memory_order_relaxed);
-
-        if (t > b)
+        for (;;)
         {
-            m_bottom.store(b + 1, std::memory_order_relaxed);   // empty: restore
-            return false;
-        }
+            const int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+            m_bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);    // order bottom store vs top load
+            int64_t t = m_top.load(std::memory_order_relaxed);
 
-        T v = m_buf[b & kMask];
-        if (t == b)
-        {
-            // Last element: a thief may be reading the same slot. Whoever wins the CAS on top
-            // takes it.
+            if (t > b)
+            {
+                m_bottom.store(b + 1, std::memory_order_relaxed);   // empty: restore
+                return false;
+            }
+
+            if (b - t >= BATCH)
+            {
+                // No thief claim that could still succeed reaches this far down: one from t stops
+                // short of t + BATCH, and one from a later top saw our bottom store.
+                //
+                out = m_buf[b & kMask];
+                return true;
+            }
+
+            // Near the top: a thief may be reading these slots. Leave the bottom item in place and
+            // race for the top one; whoever wins the CAS on top takes it.
             //
-            const bool won = m_top.compare_exchange_strong(
-                t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
             m_bottom.store(b + 1, std::memory_order_relaxed);
-            if (!won)
+            T v = m_buf[t & kMask];
+            if (m_top.compare_exchange_strong(
+                    t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
             {
-                return false;                                   // a thief took it
+                out = v;
+                return true;
             }
+            // A thief advanced top; retry against the new state (usually empty)
         }
-        out = v;
-        return true;
     }
 
     // Any thief. Take from the top (FIFO). Returns false on empty or on losing the steal race; the
@@ -107,6 +123,34 @@ class Deque
         return true;
     }
 
+    // Any thief. Take up to min(maxN, BATCH) items from the top -- half the items present, rounded
+    // up -- with one CAS, oldest first into out[]. Returns the number taken; 0 on empty or on losing
+    // the race. A flooded victim then costs a thief one contended CAS per batch rather than per item.
+    //
+    int StealBatch(T* out, int maxN)
+    {
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);    // order top load vs bottom load
+        const int64_t b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b || maxN <= 0)
+        {
+            return 0;                                           // empty
+        }
+        int64_t n = (b - t + 1) / 2;
+        if (n > maxN) n = maxN;
+        if (n > BATCH) n = BATCH;
+        for (int64_t i = 0; i < n; i++)
+        {
+            out[i] = m_buf[(t + i) & kMask];
+        }
+        if (!m_top.compare_exchange_strong(
+                t, t + n, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return 0;                                           // lost the race
+        }
+        return (int)n;
+    }
+
     // Owner's approximate view of the size. Exact when no steal is in flight; for idle/steal
     // heuristics only, never for correctness.
     //
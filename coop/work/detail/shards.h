@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <deque>
 #include <memory>
 
 #include "deque.h"
@@ -22,34 +23,155 @@ namespace detail
 // pointer to avoid a per-shed allocation. This is the steal mechanism; the Grid layers the
 // cooperator participation, stealers, and the Shed verb on top.
 //
+// Steals are batched: a thief claims up to half a victim's items (at most kStealBatch) with one CAS,
+// returns the oldest and pushes the rest onto its own shard. When one shard floods, each thief pays
+// one contended CAS per batch instead of per item and then runs the batch from its own, uncontended
+// shard -- where it is in turn stealable by the next idle worker.
+//
+// A shard never refuses work. Once its Deque is full, Shed appends to the shard's unbounded spill
+// list instead, and the owner's next Pull tops the Deque back up from the spill (oldest first, at
+// most kRefill per pull) before popping. The spill is owner-only -- no thief reads it -- which is
+// safe because a shard only spills while its Deque is full, i.e. while thieves have plenty to take.
+//
+// What one Pull did, for instrumentation: how many victims it tried to steal from, and how many
+// items its successful batch steal (if any) claimed. A local hit leaves both zero and sets local.
+//
+struct PullStats
+{
+    int  attempts = 0;
+    int  stolen   = 0;
+    bool local    = false;
+};
+
 template<typename T>
 class Shards
 {
-    using Deque = detail::Deque<T, 8192>;
+  public:
+    static constexpr int kStealBatch = 16;
+    static constexpr int kRefill     = 256;
+
+  private:
+    using Deque = detail::Deque<T, 8192, kStealBatch>;
 
   public:
-    void Init(int n) { m_n = n; m_shards.reset(new Deque[n]); }
+    void Init(int n)
+    {
+        m_n = n;
+        m_shards.reset(new Deque[n]);
+        m_spill.reset(new Overflow[n]);
+    }
     int  Workers() const { return m_n; }
 
-    // Owner of shard w only. Returns false if the shard is full (caller overflows out of band).
+    // Owner of shard w only. Always accepts t: a full Deque spills it to the overflow list, and
+    // *spilled, if given, says which it was for a caller that accounts for overflow. Returns true
+    // (kept as bool so callers written against the bounded shard still compile unchanged).
     //
-    bool Shed(int w, T t) { return m_shards[w].PushBottom(t); }
+    bool Shed(int w, T t, bool* spilled = nullptr)
+    {
+        bool full = !m_shards[w].PushBottom(t);
+        if (full) m_spill[w].items.push_back(t);
+        if (spilled) *spilled = full;
+        return true;
+    }
+
+    // Owner of shard w only: items waiting on w's overflow list.
+    //
+    size_t Spilled(int w) const { return m_spill[w].items.size(); }
+
+    // Owner of shard w's approximate queue depth (heuristics only, see Deque::SizeApprox).
+    //
+    int64_t SizeApprox(int w) const { return m_shards[w].SizeApprox(); }
 
     // Worker w: take local work (LIFO), else steal from another shard (FIFO). nullptr if all empty.
     //
     T Pull(int w)
     {
         T t;
-        if (m_shards[w].PopBottom(t)) return t;
+        if (PopLocal(w, t)) return t;
         for (int i = 1; i < m_n; i++)
         {
-            if (m_shards[(w + i) % m_n].Steal(t)) return t;
+            if (StealInto(w, m_shards[(w + i) % m_n], kStealBatch, t)) return t;
+        }
+        return nullptr;
+    }
+
+    // Worker w with an explicit victim order, nearest first (the Grid's topology-aware order).
+    // victims[0, remoteFrom) are near and stolen from whenever non-empty; victims[remoteFrom, count)
+    // are remote and only stolen from once they hold at least remoteMin items, so a remote victim's
+    // working set crosses the interconnect only when it has backlog its own node is not absorbing.
+    // A remote batch is capped to that excess, leaving the victim remoteMin - 1 items of its own.
+    // stats, if given, must start zeroed.
+    //
+    T Pull(int w, int const* victims, int count, int remoteFrom, int64_t remoteMin,
+           PullStats* stats = nullptr)
+    {
+        T t;
+        if (PopLocal(w, t))
+        {
+            if (stats) stats->local = true;
+            return t;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            Deque& victim = m_shards[victims[i]];
+            int maxN = kStealBatch;
+            if (i >= remoteFrom)
+            {
+                const int64_t depth = victim.SizeApprox();
+                if (depth < remoteMin) continue;
+                if (depth - remoteMin + 1 < maxN) maxN = (int)(depth - remoteMin + 1);
+            }
+            if (stats) stats->attempts++;
+            if (int n = StealInto(w, victim, maxN, t))
+            {
+                if (stats) stats->stolen = n;
+                return t;
+            }
         }
         return nullptr;
     }
 
   private:
+    // Owner-only overflow tier, padded so neighbouring shards' owners do not false-share.
+    //
+    struct alignas(64) Overflow
+    {
+        std::deque<T> items;
+    };
+
+    // Worker w's local take: refill the Deque from the spill (if any), then pop it. A refill leaves
+    // the Deque non-empty, so an empty Deque below still means the whole shard is empty.
+    //
+    bool PopLocal(int w, T& t)
+    {
+        std::deque<T>& spill = m_spill[w].items;
+        for (int i = 0; i < kRefill && !spill.empty(); i++)
+        {
+            if (!m_shards[w].PushBottom(spill.front())) break;
+            spill.pop_front();
+        }
+        return m_shards[w].PopBottom(t);
+    }
+
+    // Batch-steal from victim on worker w's thread: hand back the oldest item, queue the rest on w's
+    // own shard. w's shard (Deque and spill) was just found empty and only w pushes to it, so the
+    // rest always fits. Returns the batch size, 0 if nothing was taken.
+    //
+    int StealInto(int w, Deque& victim, int maxN, T& first)
+    {
+        T batch[kStealBatch];
+        const int n = victim.StealBatch(batch, maxN);
+        if (!n) return 0;
+        for (int i = 1; i < n; i++)
+        {
+            m_shards[w].PushBottom(batch[i]);
+        }
+        first = batch[0];
+        return n;
+    }
+
     std::unique_ptr<Deque[]> m_shards;
+    std::unique_ptr<Overflow[]> m_spill;
     int m_n = 0;
 };
 
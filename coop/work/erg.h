@@ -1,9 +1,13 @@
 #pragma once
 
+#include <cstdint>
+#include <new>
 #include <type_traits>
 #include <utility>
 
 #include "coop/thunk.h"
+#include "coop/trace.h"
+#include "erg_slab.h"
 
 namespace coop
 {
@@ -14,9 +18,9 @@ namespace work
 // morsel shed into a Grid and run by a stealer on whatever cooperator pulls it. Unlike a
 // Continuation (single-cooperator, never migrates), an Erg is owned cross-thread -- run and freed on
 // a possibly different core than it was shed -- so it must run to completion without blocking the
-// stealer (hand off async follow-on via Continuations). The default Shed(fn) path uses new/delete
-// (malloc's cross-thread free is correct); a per-cooperator slab with cross-thread free is a later
-// optimization.
+// stealer (hand off async follow-on via Continuations). Shed(fn) allocates from the shedding
+// cooperator's ErgSlab, whose cross-thread free returns the block to that cooperator instead of
+// going through malloc's remote-free path; MakeErg(fn) without a slab is plain new/delete.
 //
 // Lifetime is a per-Erg property. A transient, allocated Erg (MakeErg) is stealer-owned: the stealer
 // frees it after Run(). A reusable Erg -- a stable, long-lived work item that re-sheds itself each
@@ -30,12 +34,56 @@ namespace work
 // fully retired. A re-shed lands on the running stealer's own local shard, so a peer cannot observe
 // it until the stealer returns and loops.
 //
+// Where an Erg may run, set at Shed time (see Grid::ShedErg). Any is the plain balanced Erg.
+// PreferHome keeps it on the shedding cooperator, for work whose data lives there, unless it waits
+// there past the Grid's preferHomeDelay or the cooperator holds more than preferHomeBacklog of
+// them; then thieves may take it like any other. Pinned is never stolen: it runs on the shedding
+// cooperator, for work that touches cooperator-local state.
+//
+enum class Affinity : uint8_t
+{
+    Any,
+    PreferHome,
+    Pinned,
+};
+
+// Which of a shard's two queues an Erg waits in. Every stealer takes High work -- its own, then
+// stolen from any peer -- before it looks at any Normal work, its own included.
+//
+enum class Lane : uint8_t
+{
+    Normal,
+    High,
+};
+
+// The Shed-time hints, for Shed(hints, fn); a caller-owned Erg sets its fields directly
+//
+struct ShedHints
+{
+    Affinity    affinity = Affinity::Any;
+    Lane        lane     = Lane::Normal;
+};
+
 struct Erg : Thunk
 {
     // false => caller-owned (reusable): RunErg runs but does not free. Default true => stealer frees
     // after Run() (the MakeErg path).
     //
     bool m_stealerOwned = true;
+
+    // Set by MakeErg(slab, fn): the block came from an ErgSlab and is returned there, not deleted.
+    //
+    bool m_fromSlab = false;
+
+    // Kept across re-sheds of a caller-owned Erg
+    //
+    Affinity m_affinity = Affinity::Any;
+    Lane     m_lane     = Lane::Normal;
+
+    // The shedder's trace context, captured by Shed and installed while the Erg runs, so its spans
+    // join the shedder's trace on whichever cooperator steals it (see coop/trace.h)
+    //
+    trace::SpanContext m_trace;
 };
 
 template<typename Fn>
@@ -52,16 +100,37 @@ inline Erg* MakeErg(Fn&& fn)
     return new ErgImpl<std::decay_t<Fn>>(std::forward<Fn>(fn));
 }
 
+// Allocate from a cooperator's slab (its owning thread only). Freed by RunErg on any thread.
+//
+template<typename Fn>
+inline Erg* MakeErg(ErgSlab& slab, Fn&& fn)
+{
+    using Impl = ErgImpl<std::decay_t<Fn>>;
+    static_assert(alignof(Impl) <= 16, "ErgSlab blocks are 16-byte aligned");
+    Erg* e = new (slab.Allocate(sizeof(Impl))) Impl(std::forward<Fn>(fn));
+    e->m_fromSlab = true;
+    return e;
+}
+
 inline void RunErg(Erg* e)
 {
     coop::detail::ThunkScope inThunk;    // debug: forbid suspending inside the Erg's Run
     const bool owned = e->m_stealerOwned;
-    e->Run();
+    const bool fromSlab = e->m_fromSlab;
+    {
+        trace::ContextScope traced(e->m_trace);
+        e->Run();
+    }
     // A caller-owned (reusable) Erg may have already re-shed itself during Run(); the stealer must
     // not free it. Read m_stealerOwned BEFORE Run() so a re-shed peer touching the object cannot
     // race this load.
     //
-    if (owned)
+    if (owned && fromSlab)
+    {
+        e->~Erg();
+        ErgSlab::Free(e);
+    }
+    else if (owned)
     {
         delete e;
     }
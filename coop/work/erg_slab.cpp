@@ -0,0 +1,131 @@
+#include "erg_slab.h"
+
+#include <cstddef>
+#include <cstdlib>
+
+#include "coop/cooperator.h"
+
+namespace coop
+{
+namespace work
+{
+
+constexpr size_t ErgSlab::kSizes[];
+
+static_assert(alignof(std::max_align_t) >= 16, "malloc'd blocks must be able to hold a Header");
+
+void* ErgSlab::Allocate(size_t n)
+{
+    const size_t c = ClassFor(n + sizeof(Header));
+    if (c == kClasses)
+    {
+        Header* h = static_cast<Header*>(std::malloc(n + sizeof(Header)));
+        h->owner = nullptr;                     // larger than any class: unpooled
+        h->cls = kClasses;
+        return h + 1;
+    }
+
+    if (!m_free[c])
+    {
+        DrainReturns();
+    }
+
+    Header* h = m_free[c];
+    if (h)
+    {
+        m_free[c] = Next(h);
+        --m_count[c];
+    }
+    else
+    {
+        h = static_cast<Header*>(std::malloc(kSizes[c]));
+        h->owner = this;
+        h->cls = (uint32_t)c;
+    }
+    ++m_out;
+    return h + 1;
+}
+
+void ErgSlab::Free(void* p)
+{
+    Header* h = static_cast<Header*>(p) - 1;
+    ErgSlab* owner = h->owner;
+    if (!owner)
+    {
+        std::free(h);
+        return;
+    }
+
+    Cooperator* bound = owner->m_owner.load(std::memory_order_relaxed);
+    if (bound && bound == Cooperator::thread_cooperator)
+    {
+        owner->PushLocal(h);
+        return;
+    }
+
+    // Remote: release-push so the owner's acquire exchange sees the link
+    //
+    Header* head = owner->m_returned.load(std::memory_order_relaxed);
+    do
+    {
+        Next(h) = head;
+    } while (!owner->m_returned.compare_exchange_weak(
+                 head, h, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void ErgSlab::PushLocal(Header* h)
+{
+    --m_out;
+    if (m_count[h->cls] >= kCap)
+    {
+        std::free(h);                           // bucket already full
+        return;
+    }
+    Next(h) = m_free[h->cls];
+    m_free[h->cls] = h;
+    ++m_count[h->cls];
+}
+
+void ErgSlab::DrainReturns()
+{
+    // One exchange takes every block returned so far; re-bucket them by class
+    //
+    Header* h = m_returned.exchange(nullptr, std::memory_order_acquire);
+    while (h)
+    {
+        Header* next = Next(h);
+        PushLocal(h);
+        ++m_remoteReturns;
+        h = next;
+    }
+}
+
+void ErgSlab::Trim()
+{
+    DrainReturns();
+    for (size_t c = 0; c < kClasses; ++c)
+    {
+        for (Header* h = m_free[c]; h;)
+        {
+            Header* next = Next(h);
+            std::free(h);
+            h = next;
+        }
+        m_free[c] = nullptr;
+        m_count[c] = 0;
+    }
+}
+
+bool ErgSlab::Reclaimable()
+{
+    Trim();
+    return m_out == 0;
+}
+
+ErgSlab::~ErgSlab()
+{
+    Trim();
+}
+
+} // end namespace work
+} // end namespace coop
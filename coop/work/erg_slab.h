@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace coop
+{
+
+struct Cooperator;
+
+namespace work
+{
+
+// Per-cooperator size-classed storage for transient Ergs. A shed Erg is allocated on the shedding
+// cooperator but usually freed by a stealer on another core, which is malloc's slow cross-thread free
+// path -- a visible hotspot in fan-out pipelines that shed thousands of small morsels. The slab
+// instead keeps freed blocks with the cooperator that allocated them:
+//
+//   - Allocate (owner thread only) pops the block's size-class free list; an empty list first takes
+//     the whole remote return list in one exchange and re-buckets it, then falls back to malloc.
+//   - Free (any thread) reads the owning slab from the block header. On the owner's thread it pushes
+//     the local free list, no atomics. Elsewhere it CAS-pushes the block onto the owner's lock-free
+//     MPSC return list. The single consumer only ever takes the whole list at once, so the push has
+//     no ABA hazard.
+//
+// Each class keeps at most kCap free blocks locally; the excess a drain brings back goes to free().
+// Requests larger than the biggest class are plain malloc'd blocks with no owner. The slab must
+// outlive every Erg allocated from it -- the same rule the Grid's shards already impose, since the
+// slab lives in the cooperator's Participation.
+//
+class ErgSlab
+{
+  public:
+    ErgSlab() = default;
+    ErgSlab(const ErgSlab&) = delete;
+    ErgSlab& operator=(const ErgSlab&) = delete;
+    ~ErgSlab();
+
+    // Set the owning cooperator. Frees on any other thread take the remote return path; with none
+    // bound, every free does.
+    //
+    void Bind(Cooperator* owner) { m_owner.store(owner, std::memory_order_relaxed); }
+
+    // Owner thread only. At least n bytes, 16-byte aligned.
+    //
+    void* Allocate(size_t n);
+
+    // Any thread. p must come from some slab's Allocate.
+    //
+    static void Free(void* p);
+
+    // Owner thread only. Free the blocks held for reuse, and any returned so far, for a slab whose
+    // owner is done allocating from it (work::Grid::Leave). Blocks still out keep coming back to
+    // the return list, which the destructor drains.
+    //
+    void Trim();
+
+    // For a slab bound to no owner, one caller at a time: Trim, then whether every block handed out
+    // has come back. Once it has, no Erg can reach the slab and it may be destroyed.
+    //
+    bool Reclaimable();
+
+    // Blocks that came back through the remote return list (drained so far). Owner thread only;
+    // instrumentation.
+    //
+    uint64_t RemoteReturns() const { return m_remoteReturns; }
+
+  private:
+    static constexpr size_t   kClasses = 3;
+    static constexpr size_t   kSizes[kClasses] = {64, 128, 256};
+    static constexpr uint32_t kCap = 512;       // max retained free blocks per class
+
+    // Prefix of every block; the payload starts right after it. While a block is free (on a local
+    // list or the return list) its dead payload holds the link.
+    //
+    struct alignas(16) Header
+    {
+        ErgSlab* owner;     // nullptr => unpooled
+        uint32_t cls;
+    };
+    static_assert(sizeof(Header) == 16, "Header must keep the payload 16-byte aligned");
+
+    static Header*& Next(Header* h) { return *reinterpret_cast<Header**>(h + 1); }
+
+    static size_t ClassFor(size_t n)
+    {
+        for (size_t i = 0; i < kClasses; ++i)
+        {
+            if (n <= kSizes[i])
+            {
+                return i;
+            }
+        }
+        return kClasses;
+    }
+
+    void PushLocal(Header* h);
+    void DrainReturns();
+
+    std::atomic<Cooperator*> m_owner{nullptr};
+    Header*     m_free[kClasses] = {};
+    uint32_t    m_count[kClasses] = {};
+    uint64_t    m_remoteReturns = 0;
+    uint64_t    m_out = 0;              // pooled blocks handed out and not yet back
+
+    // Remote frees land here; only the owner takes from it. Own cache line so remote pushes do not
+    // false-share with the owner's free lists.
+    //
+    alignas(64) std::atomic<Header*> m_returned{nullptr};
+};
+
+} // end namespace work
+} // end namespace coop
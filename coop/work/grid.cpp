@@ -8,27 +8,70 @@
 #include "coop/context.h"
 #include "coop/coordinate_with.h"
 #include "coop/coordinator.h"
+#include "coop/detail/timer_tag.h"
+#include "coop/detail/tsc.h"
+#include "coop/io/uring.h"
+#include "coop/perf/patch.h"
+#include "coop/perf/probe.h"
+#include "coop/perf/usdt.h"
+#include "coop/time/now.h"
 #include "coop/time/sleep.h"
+#include "coop/topology.h"
 
 namespace coop
 {
 namespace work
 {
 
-void Grid::Init(int n, time::Interval recheckMin, time::Interval recheckMax, int idleGrowAfter)
+namespace
+{
+
+// Single-writer bump of a Participation::counts field: no RMW, so no locked cache-line transfer.
+//
+void Bump(std::atomic<uint64_t>& c, uint64_t n = 1)
+{
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+} // end anonymous namespace
+
+void Grid::Init(int n, time::Interval recheckMin, time::Interval recheckMax, int idleGrowAfter,
+                int wakeThreshold, int remoteStealThreshold, time::Interval preferHomeDelay,
+                int preferHomeBacklog)
 {
     m_n = n;
     m_recheckMin = recheckMin;
     m_recheckMax = recheckMax;
     m_idleGrowAfter = idleGrowAfter;
-    m_shards.Init(n);
+    m_wakeThreshold = wakeThreshold;
+    m_remoteStealThreshold = remoteStealThreshold;
+    m_preferHomeDelay = preferHomeDelay;
+    m_preferHomeBacklog = preferHomeBacklog;
+    m_shards[0].Init(n);
+    m_shards[1].Init(n);
     m_parts.reset(new Participation[n]);
 }
 
 void Grid::Join(Cooperator* co)
 {
-    const int shard = m_joined.fetch_add(1, std::memory_order_relaxed);
-    assert(shard < m_n && "Grid::Join called more times than Init sized for");
+    // A vacant shard was given up by a Leave that has finished with it: the lock orders its last
+    // owner's pops and spill before the new owner's first push
+    //
+    int shard;
+    {
+        std::lock_guard<std::mutex> lock(m_membership);
+        Reap();
+        if (!m_vacant.empty())
+        {
+            shard = m_vacant.back();
+            m_vacant.pop_back();
+        }
+        else
+        {
+            shard = m_joined++;
+        }
+    }
+    assert(shard < m_n && "Grid::Join called with more members than Init sized for");
     m_parts[shard].grid  = this;
     m_parts[shard].shard = shard;
     Participation* p = &m_parts[shard];
@@ -38,15 +81,160 @@ void Grid::Join(Cooperator* co)
     //
     co->Submit([this, p, shard](Context* ctx)
     {
-        ctx->GetCooperator()->m_participation = p;
-        Spawn([this, shard](Context* s)
+        Cooperator* co = ctx->GetCooperator();
+        p->ring = co->GetUring();
+        p->slab = std::make_unique<ErgSlab>();
+        p->slab->Bind(co);
+        co->m_participation = p;
+
+        // Publish where this cooperator runs so every stealer (this one included) rebuilds its
+        // nearest-first victim order on its next pass.
+        //
+        p->co.store(co, std::memory_order_relaxed);
+        p->cpu.store(co->CpuId(), std::memory_order_relaxed);
+        p->node.store(co->NumaNode(), std::memory_order_relaxed);
+        p->llc.store(co->CpuId() >= 0 ? GetTopology().LlcForCpu(co->CpuId()) : -1,
+                     std::memory_order_relaxed);
+        p->live.store(true, std::memory_order_relaxed);
+        m_placed.fetch_add(1, std::memory_order_release);
+        m_members.fetch_add(1, std::memory_order_release);
+
+        // As io::FileCache's watcher: the stealer holds stealerExit for its whole run, taken
+        // inside Spawn, so Leave can wait it out
+        //
+        co->Spawn([this, p, shard](Context* s)
         {
             s->Detach();
+            p->stealerExit.Acquire(s);
             StealerLoop(s, shard);
-        });
+            p->stealerExit.Release(s, false);
+        }, &p->stealer);
     });
 }
 
+void Grid::Leave(Cooperator* co)
+{
+    co->Submit([this](Context* ctx)
+    {
+        Participation* p = ctx->GetCooperator()->m_participation;
+        if (p && p->grid == this)
+        {
+            Retire(ctx, *p);
+        }
+    });
+}
+
+void Grid::Retire(Context* ctx, Participation& self)
+{
+    // Sheds here are Spawns from now on, so nothing new lands on the shard; peers leave it out of
+    // their victim orders once they see the placement count move
+    //
+    ctx->GetCooperator()->m_participation = nullptr;
+    self.live.store(false, std::memory_order_relaxed);
+    m_placed.fetch_add(1, std::memory_order_release);
+
+    if (self.stealer)
+    {
+        self.stealer.Kill();
+    }
+    self.stealerExit.Acquire(ctx);
+    self.stealerExit.Release(ctx, false);
+
+    // The next stealer on this slot starts owning the doorbell, as the first one did
+    //
+    if (self.doorbell.IsHeld())
+    {
+        self.doorbell.Release(ctx, false);
+    }
+
+    // Pinned Ergs have nowhere else to go. The rest is taken with local pops, racing thieves that
+    // still steal from the shard the way they always do.
+    //
+    std::vector<Erg*> moved;
+    for (Lane lane : {Lane::High, Lane::Normal})
+    {
+        Participation::Held& held = self.held[static_cast<int>(lane)];
+        while (!held.pinned.empty())
+        {
+            Erg* e = held.pinned.front();
+            held.pinned.pop_front();
+            RunErg(e);
+        }
+        for (auto& [e, since] : held.home)
+        {
+            moved.push_back(e);
+        }
+        held.home.clear();
+        while (Erg* e = m_shards[static_cast<int>(lane)].Pull(self.shard, nullptr, 0, 0, 0))
+        {
+            moved.push_back(e);
+        }
+    }
+
+    if (!moved.empty())
+    {
+        RefreshVictims(self);
+        Cooperator* peer = self.victims.empty()
+            ? nullptr
+            : m_parts[self.victims[0]].co.load(std::memory_order_relaxed);
+        if (!peer || !peer->Submit([this, moved](Context*) { Adopt(moved); }))
+        {
+            for (Erg* e : moved)
+            {
+                RunErg(e);
+            }
+        }
+    }
+
+    // Unbound, the slab gets every block back through its return list, where Reap counts them
+    //
+    self.slab->Trim();
+    self.slab->Bind(nullptr);
+    self.co.store(nullptr, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_membership);
+        m_retired.push_back(std::move(self.slab));
+        m_vacant.push_back(self.shard);
+        Reap();
+    }
+    m_members.fetch_sub(1, std::memory_order_release);
+}
+
+// Under m_membership. A retired slab goes once every block it handed out is back: an Erg still out
+// is one some shard, peer or inline run holds, and its free is its last touch of the slab.
+//
+void Grid::Reap()
+{
+    std::erase_if(m_retired, [](std::unique_ptr<ErgSlab> const& slab)
+    {
+        return slab->Reclaimable();
+    });
+}
+
+// On the cooperator a leaving member handed its shard to. It may have left since; then the Ergs
+// simply run here.
+//
+void Grid::Adopt(std::vector<Erg*> const& ergs)
+{
+    Participation* p = GetCooperator()->m_participation;
+    const bool member = p && p->grid == this;
+    for (Erg* e : ergs)
+    {
+        if (member)
+        {
+            ShedErg(p->shard, e);
+        }
+        else
+        {
+            RunErg(e);
+        }
+    }
+    if (member)
+    {
+        p->doorbell.Release(Self(), /*schedule=*/false);
+    }
+}
+
 void Grid::StealerLoop(Context* ctx, int shard)
 {
     // Adaptive park interval: start aggressive, coast up to the cap only while persistently idle.
@@ -56,14 +244,31 @@ void Grid::StealerLoop(Context* ctx, int shard)
     time::Interval interval = m_recheckMin;
     int idleRun = 0;
 
-    Coordinator& doorbell = m_parts[shard].doorbell;
+    Participation& part = m_parts[shard];
+    Coordinator& doorbell = part.doorbell;
+
+    // Indefinite parking needs a wake that can reach this thread; without MSG_RING keep the timer.
+    //
+    const bool canSleep = m_wakeThreshold > 0 && part.ring->SupportsMessages();
 
     while (!ctx->IsKilled())
     {
-        if (Erg* e = m_shards.Pull(shard))
+        if (m_placed.load(std::memory_order_acquire) != part.placedSeen)
         {
-            RunErg(e);                                       // run-to-completion on this stealer
-            m_pulls.fetch_add(1, std::memory_order_relaxed);
+            RefreshVictims(part);
+        }
+
+        // This stealer is the only one that sees its PreferHome Ergs, so it is the one to notice
+        // they have waited long enough -- between the Ergs it runs, which is when they wait
+        //
+        if (!part.held[0].home.empty() || !part.held[1].home.empty())
+        {
+            ExposeAged(part);
+        }
+
+        if (Erg* e = PullNearest(part))
+        {
+            RunTimed(part, e);                               // run-to-completion on this stealer
             interval = m_recheckMin;                         // work found: snap back to aggressive
             idleRun = 0;
             continue;
@@ -91,12 +296,41 @@ void Grid::StealerLoop(Context* ctx, int shard)
         {
             interval = std::min(interval * 2, m_recheckMax);
         }
-        m_parks.fetch_add(1, std::memory_order_relaxed);
-        for (uint64_t prev = m_maxIdleRun.load(std::memory_order_relaxed);
-             (uint64_t)idleRun > prev &&
-             !m_maxIdleRun.compare_exchange_weak(prev, (uint64_t)idleRun,
-                                                 std::memory_order_relaxed);)
+        Bump(part.counts.parks);
+        COOP_PERF_INC(ctx->GetCooperator()->GetPerfCounters(), perf::Counter::WorkPark);
+
+        // Fully backed off: stop polling altogether. Advertise as a sleeper, then look once more so a
+        // peer that shed before it could see the flag is not missed, and park on the doorbell alone.
+        // Either a peer's wake (which clears the flag itself) or a local Shed releases it.
+        //
+        if (canSleep && interval >= m_recheckMax)
         {
+            part.sleeping.store(true, std::memory_order_seq_cst);
+            m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+
+            if (Erg* e = PullNearest(part))
+            {
+                ClearSleeping(part);
+                RunTimed(part, e);
+                interval = m_recheckMin;
+                idleRun = 0;
+                continue;
+            }
+
+            // A peer's wake has already cleared the flag; a local wake (or kill) clears it here. A
+            // peer that claims it a moment too late only leaves the doorbell released for the next
+            // pre-check.
+            //
+            CoordinateWithKill(ctx, &doorbell);
+            ClearSleeping(part);
+            idleRun = 0;
+            interval = m_recheckMin;
+            continue;
+        }
+
+        if ((uint64_t)idleRun > part.counts.maxIdleRun.load(std::memory_order_relaxed))
+        {
+            part.counts.maxIdleRun.store((uint64_t)idleRun, std::memory_order_relaxed);
         }
 
         // Park on the shared per-cooperator timer queue instead of arming a private
@@ -113,6 +347,287 @@ void Grid::StealerLoop(Context* ctx, int shard)
         //
         CoordinateWithKill(ctx, &doorbell, sleeper.GetCoordinator());
     }
+
+    ClearSleeping(part);
+}
+
+bool Grid::ClearSleeping(Participation& p)
+{
+    // Whoever flips the flag back owns the sleeper count: the stealer itself (woken locally, found
+    // work on its last look, or killed) or the peer that claimed it to send a wake.
+    //
+    if (!p.sleeping.exchange(false, std::memory_order_acq_rel))
+    {
+        return false;
+    }
+    m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void Grid::RefreshVictims(Participation& self)
+{
+    // Distance tiers: 0 shares our LLC, 1 shares our node (or either placement is unknown), 2 is a
+    // remote node. Within a tier keep the round-robin rotation from our own shard, so thieves on one
+    // node still fan out across their victims instead of all hitting the lowest index first.
+    //
+    self.placedSeen = m_placed.load(std::memory_order_acquire);
+
+    const int node = self.node.load(std::memory_order_relaxed);
+    const int llc = self.llc.load(std::memory_order_relaxed);
+    auto tier = [&](int v)
+    {
+        const int vNode = m_parts[v].node.load(std::memory_order_relaxed);
+        const int vLlc = m_parts[v].llc.load(std::memory_order_relaxed);
+        if (llc >= 0 && vLlc == llc) return 0;
+        if (node < 0 || vNode < 0 || vNode == node) return 1;
+        return 2;
+    };
+
+    self.victims.clear();
+    for (int i = 1; i < m_n; i++)
+    {
+        const int v = (self.shard + i) % m_n;
+        if (m_parts[v].live.load(std::memory_order_relaxed))
+        {
+            self.victims.push_back(v);
+        }
+    }
+    std::stable_sort(self.victims.begin(), self.victims.end(),
+                     [&](int a, int b) { return tier(a) < tier(b); });
+
+    self.victimsNear = 0;
+    while (self.victimsNear < (int)self.victims.size() && tier(self.victims[self.victimsNear]) < 2)
+    {
+        self.victimsNear++;
+    }
+}
+
+void Grid::ShedHinted(int shard, Erg* e)
+{
+    const Lane lane = e->m_lane;
+    if (lane == Lane::High && !m_highLaneUsed.load(std::memory_order_relaxed))
+    {
+        m_highLaneUsed.store(true, std::memory_order_relaxed);
+    }
+
+    Participation& self = m_parts[shard];
+    Participation::Held& held = self.held[static_cast<int>(lane)];
+    switch (e->m_affinity)
+    {
+    case Affinity::Pinned:
+        held.pinned.push_back(e);
+        return;
+
+    case Affinity::PreferHome:
+        held.home.emplace_back(e, time::MonotonicMicros());
+        if ((int)held.home.size() > m_preferHomeBacklog)
+        {
+            Expose(self, lane);
+        }
+        return;
+
+    case Affinity::Any:
+        Push(lane, shard, e);
+        return;
+    }
+}
+
+void Grid::ExposeAged(Participation& self)
+{
+    const int64_t cutoff = time::MonotonicMicros() - m_preferHomeDelay.count();
+    for (Lane lane : {Lane::High, Lane::Normal})
+    {
+        auto& home = self.held[static_cast<int>(lane)].home;
+        while (!home.empty() && home.front().second <= cutoff)
+        {
+            Expose(self, lane);
+        }
+    }
+}
+
+// Move the oldest PreferHome Erg of lane where thieves can see it. It may still come back to its
+// own stealer by the deque's local pop.
+//
+void Grid::Expose(Participation& self, Lane lane)
+{
+    auto& home = self.held[static_cast<int>(lane)].home;
+    Erg* e = home.front().first;
+    home.pop_front();
+    Bump(self.counts.exposed);
+    Push(lane, self.shard, e);
+}
+
+// High before Normal, each lane in full -- held, local, then stolen -- so a High Erg anywhere in
+// reach runs before this stealer's own Normal work
+//
+Erg* Grid::PullNearest(Participation& self)
+{
+    if (m_highLaneUsed.load(std::memory_order_relaxed))
+    {
+        if (Erg* e = PullLane(self, Lane::High))
+        {
+            return e;
+        }
+    }
+    return PullLane(self, Lane::Normal);
+}
+
+Erg* Grid::PullLane(Participation& self, Lane lane)
+{
+    auto& counters = Cooperator::thread_cooperator->GetPerfCounters();
+    (void)counters;
+
+    // Held work first: Pinned has nowhere else to run, and PreferHome is here because it is
+    // cheapest here
+    //
+    Participation::Held& held = self.held[static_cast<int>(lane)];
+    if (!held.pinned.empty() || !held.home.empty())
+    {
+        Erg* e;
+        if (!held.pinned.empty())
+        {
+            e = held.pinned.front();
+            held.pinned.pop_front();
+        }
+        else
+        {
+            e = held.home.front().first;
+            held.home.pop_front();
+        }
+        COOP_PERF_INC(counters, perf::Counter::WorkLocalPull);
+        return e;
+    }
+
+    detail::PullStats stats;
+    Erg* e = m_shards[static_cast<int>(lane)].Pull(self.shard, self.victims.data(),
+                                                   (int)self.victims.size(), self.victimsNear,
+                                                   m_remoteStealThreshold, &stats);
+    if (stats.local)
+    {
+        COOP_PERF_INC(counters, perf::Counter::WorkLocalPull);
+    }
+    if (stats.attempts)
+    {
+        COOP_PERF_ADD(counters, perf::Counter::WorkStealAttempt, (uint64_t)stats.attempts);
+    }
+    if (stats.stolen)
+    {
+        COOP_PERF_INC(counters, perf::Counter::WorkSteal);
+        COOP_PERF_ADD(counters, perf::Counter::WorkStolen, (uint64_t)stats.stolen);
+        COOP_USDT(grid_steal, self.shard, stats.stolen, e);
+    }
+    return e;
+}
+
+// Run a pulled Erg on this stealer. While Family::Work is enabled, also bucket its run time by
+// timestamp ticks; the two counter reads are skipped otherwise, so a disabled mode-2 build pays
+// one family check per Erg.
+//
+void Grid::RunTimed(Participation& self, Erg* e)
+{
+    Bump(self.counts.pulls);
+
+#if COOP_PERF_MODE > 0
+    if (perf::HasFamily(perf::EnabledFamilies(), perf::Family::Work))
+    {
+        const int64_t t0 = coop::detail::ReadTsc();
+        RunErg(e);
+        const uint64_t ticks = static_cast<uint64_t>(coop::detail::ReadTsc() - t0);
+
+        auto& counters = Cooperator::thread_cooperator->GetPerfCounters();
+        if (ticks < (1u << 10))
+        {
+            COOP_PERF_INC(counters, perf::Counter::WorkErgRun1K);
+        }
+        else if (ticks < (1u << 14))
+        {
+            COOP_PERF_INC(counters, perf::Counter::WorkErgRun16K);
+        }
+        else if (ticks < (1u << 18))
+        {
+            COOP_PERF_INC(counters, perf::Counter::WorkErgRun256K);
+        }
+        else
+        {
+            COOP_PERF_INC(counters, perf::Counter::WorkErgRunLong);
+        }
+        return;
+    }
+#endif
+
+    RunErg(e);
+}
+
+uint64_t Grid::Sum(std::atomic<uint64_t> Participation::Counts::*field) const
+{
+    uint64_t total = 0;
+    for (int i = 0; i < m_n; i++)
+    {
+        total += (m_parts[i].counts.*field).load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t Grid::MaxIdleRun() const
+{
+    uint64_t best = 0;
+    for (int i = 0; i < m_n; i++)
+    {
+        best = std::max(best, m_parts[i].counts.maxIdleRun.load(std::memory_order_relaxed));
+    }
+    return best;
+}
+
+// Off the common ShedErg path: the deque is full, so the Erg goes to the shard's owner-only spill
+// list and the owner's stealer refills from it as it drains. A full shard is far past any wake
+// threshold, so recruit a parked peer here too -- the spill itself is invisible to thieves, and the
+// sooner they thin the deque the sooner the spill moves back into stealable reach.
+//
+void Grid::Overflowed(int shard)
+{
+    COOP_PERF_INC(Cooperator::thread_cooperator->GetPerfCounters(), perf::Counter::WorkOverflow);
+
+    if (m_sleepers.load(std::memory_order_relaxed) > 0)
+    {
+        WakeSleeper(shard);
+    }
+}
+
+void Grid::WakeSleeper(int shard)
+{
+    // Claim the nearest sleeper, in the same order this cooperator steals in, and post it a wake.
+    // The claim is the exchange in ClearSleeping, so two shedders racing for one sleeper send one
+    // wake. A remote sleeper is only worth waking once our backlog would clear its steal threshold.
+    //
+    Participation& self = m_parts[shard];
+    if (m_placed.load(std::memory_order_acquire) != self.placedSeen)
+    {
+        RefreshVictims(self);
+    }
+
+    const int64_t depth = Depth(shard);
+    for (int i = 0; i < (int)self.victims.size(); i++)
+    {
+        if (i >= self.victimsNear && depth < m_remoteStealThreshold)
+        {
+            break;
+        }
+
+        Participation& peer = m_parts[self.victims[i]];
+        if (!peer.sleeping.load(std::memory_order_relaxed) || !ClearSleeping(peer))
+        {
+            continue;
+        }
+        // SendMessage only fails here if the SQ ring is exhausted even after a flush. The claimed
+        // peer then stays parked until its own next local Shed -- delayed balancing, no lost work.
+        //
+        if (self.ring->SendMessage(*peer.ring, coop::detail::kWakeTag, coop::detail::kWakeAckTag))
+        {
+            Bump(self.counts.wakes);
+            COOP_PERF_INC(Cooperator::thread_cooperator->GetPerfCounters(), perf::Counter::WorkWake);
+        }
+        return;
+    }
 }
 
 } // end namespace work
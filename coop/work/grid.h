@@ -2,8 +2,11 @@
 
 #include <atomic>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <utility>
+#include <vector>
 
 #include "coop/cooperator.h"
 #include "coop/cooperator.hpp"
@@ -37,11 +40,72 @@ class Grid;
 // the stealer's next idle pre-check picks it up without sleeping and re-takes ownership -- the
 // doorbell is a single-bit "work may be local, do not sleep" latch, not a count.
 //
+// The same doorbell doubles as the cross-thread wake. A stealer that has backed off all the way to
+// recheckMax stops arming its timer and parks on the doorbell alone, advertising itself through
+// `sleeping`. A peer whose own shard has grown past the Grid's wake threshold claims one sleeper by
+// clearing its flag and posts an IORING_OP_MSG_RING onto that sleeper's `ring`; the CQE lands on the
+// sleeper's own thread (Cooperator::OnPeerWake), which releases the doorbell the ordinary same-thread
+// way. `sleeping` is the wake path's only cross-thread field and sits on its own cache line.
+//
+// `slab` backs this cooperator's Shed(fn) Ergs; stealers anywhere in the grid free into it (see
+// ErgSlab), and only this cooperator's thread allocates from it. Each Join makes a fresh one: a
+// slot outlives its cooperator's membership (Grid::Leave), and Ergs from the old slab may still be
+// out, so a left slab is retired to the Grid rather than rebound.
+//
+// `live` is set while a cooperator holds the slot; a vacant slot is left out of victim orders.
+// `stealer` and `stealerExit` let Leave stop the stealer and wait for it to be gone.
+//
+// Placement (cpu / numa node / LLC of the joined cooperator, -1 while unknown) is published once by
+// the cooperator's own thread at Join; peers read it when rebuilding their victim order. `victims` is
+// this participant's steal order over the other shards, nearest first, with victims[0, victimsNear)
+// on the same node; it is owned by this cooperator's thread and rebuilt whenever a new placement has
+// been published (placedSeen lags Grid::m_placed).
+//
+// `held` is the work this cooperator's thieves cannot see, by Lane: Pinned Ergs, and PreferHome
+// Ergs with the MonotonicMicros they were shed at, until they age out into the stealable deque.
+// Owner-only, like the shard's spill, and drained ahead of the lane's deque.
+//
+// `counts` is this stealer's share of the Grid's summed instrumentation (Grid::Parks and friends).
+// Only this cooperator's thread writes it -- a relaxed load and store, never a shared RMW -- so the
+// stealers do not contend on the counters that exist to measure their contention.
+//
 struct Participation
 {
     Grid*       grid  = nullptr;
     int         shard = -1;
+    io::Uring*  ring  = nullptr;
     Coordinator doorbell;
+
+    std::unique_ptr<ErgSlab>    slab;
+    std::atomic<Cooperator*>    co{nullptr};
+    std::atomic<bool>           live{false};
+    Context::Handle             stealer;
+    Coordinator                 stealerExit;
+
+    std::atomic<int> cpu{-1};
+    std::atomic<int> node{-1};
+    std::atomic<int> llc{-1};
+
+    std::vector<int> victims;
+    int              victimsNear = 0;
+    int              placedSeen  = -1;
+
+    struct Held
+    {
+        std::deque<Erg*>                        pinned;
+        std::deque<std::pair<Erg*, int64_t>>    home;
+    } held[2];
+
+    struct alignas(64) Counts
+    {
+        std::atomic<uint64_t> parks{0};
+        std::atomic<uint64_t> pulls{0};
+        std::atomic<uint64_t> maxIdleRun{0};
+        std::atomic<uint64_t> wakes{0};
+        std::atomic<uint64_t> exposed{0};
+    } counts;
+
+    alignas(64) std::atomic<bool> sleeping{false};
 };
 
 // A Grid is the work-sharing domain: a set of cooperators that balance Ergs among themselves by
@@ -57,8 +121,9 @@ class Grid
     Grid(const Grid&) = delete;
     Grid& operator=(const Grid&) = delete;
 
-    // Size for n cooperators. The remaining parameters tune the idle stealer's park/re-check
-    // policy, which trades idle-core wakeup rate against worst-case rebalancing latency.
+    // Size for up to n cooperators at once. The remaining parameters tune the idle stealer's
+    // park/re-check policy, which trades idle-core wakeup rate against worst-case rebalancing
+    // latency.
     //
     // An idle stealer parks on an io_uring timer, wakes, re-checks for stealable work, and parks
     // again. A short interval notices clustered work quickly (tight rebalancing tail) but a fully
@@ -71,45 +136,198 @@ class Grid
     // while load is present; recheckMax bounds it after the core has gone fully idle -- the worst
     // case a cross-thread steal-wake would address.
     //
+    // wakeThreshold enables that cross-thread wake (see Participation): once a stealer has coasted to
+    // recheckMax it parks indefinitely instead, and a cooperator whose shard holds at least
+    // wakeThreshold Ergs after a Shed wakes one such sleeper to come steal. Idle cores then cost
+    // nothing, and cold cross-cooperator pickup is one MSG_RING hop instead of up to recheckMax. 0
+    // disables it, as does a kernel without MSG_RING (the timer park is kept). The wake is best
+    // effort: a missed one delays balancing but never strands work, since every shard is still
+    // drained by its own stealer.
+    //
+    // Steal order follows the machine topology (coop::GetTopology): a stealer tries shards whose
+    // cooperator shares its last-level cache, then the rest of its NUMA node, then remote nodes.
+    // remoteStealThreshold is the backlog a remote-node shard must hold before it is stolen from, so
+    // an Erg's working set is dragged across the interconnect only when the victim's own node is not
+    // keeping up; 1 steals remotely whenever there is anything to take. Cooperators whose placement is
+    // unknown (pinning disabled) count as same-node.
+    //
+    // A PreferHome Erg (erg.h) is hidden from thieves until it has waited preferHomeDelay, as the
+    // home stealer sees between the Ergs it runs, or until its cooperator holds more than
+    // preferHomeBacklog of them in its lane; the oldest goes first. Its own stealer takes them
+    // ahead of the lane's stealable work, so they only age while that stealer is busy.
+    //
     void Init(int n,
-              time::Interval recheckMin    = std::chrono::microseconds(10),
-              time::Interval recheckMax    = std::chrono::microseconds(200),
-              int            idleGrowAfter = 8);
+              time::Interval recheckMin           = std::chrono::microseconds(10),
+              time::Interval recheckMax           = std::chrono::microseconds(200),
+              int            idleGrowAfter        = 8,
+              int            wakeThreshold        = 16,
+              int            remoteStealThreshold = 4,
+              time::Interval preferHomeDelay      = std::chrono::microseconds(100),
+              int            preferHomeBacklog    = 32);
 
-    // Opt the cooperator into this grid: assign it the next shard, set its participation field, and
-    // spawn its stealer. Call once per cooperator, after Init, before sheddding to it.
+    // Opt the cooperator into this grid: assign it a vacant shard -- one a Leave gave up, else the
+    // next never used -- set its participation field, and spawn its stealer. n in Init is the most
+    // members at once; Join and Leave may come at any time after Init, while stealers run. Any
+    // thread; the join itself runs on co, so Sheds there stay Spawns until it has.
     //
     void Join(Cooperator* co);
 
+    // Take the cooperator back out, on its own thread: its Sheds become Spawns again, its stealer
+    // stops, its Pinned Ergs run there, and the rest of its shard -- both lanes, held and spilled
+    // -- moves to the nearest member, or runs there too when none is left. Peers drop the shard
+    // from their victim orders on their next pass; a thief still working from the old order only
+    // finds it empty, and the shard's storage stays valid for the next Join to reuse. Any thread;
+    // returns at once, the leave done once Members() drops.
+    //
+    void Leave(Cooperator* co);
+
+    // Cooperators currently joined
+    //
+    int Members() const { return m_members.load(std::memory_order_acquire); }
+
+    // Slabs of members that left still held for Ergs that were out at the last Join or Leave.
+    // Instrumentation.
+    //
+    size_t RetiredSlabs()
+    {
+        std::lock_guard<std::mutex> lock(m_membership);
+        return m_retired.size();
+    }
+
     // Owner of shard's cooperator only (the local stealer, or in-cooperator code that ran there).
-    // Returns false if the shard is full (the caller decides how to absorb the overflow).
+    // Never drops e: past a full shard deque it spills to the shard's overflow list (see Overflowed).
+    // e's m_affinity and m_lane (erg.h) pick where it waits; a plain Erg takes the inline path.
+    // Returns true; the bool is kept for the Shed(Erg*) contract.
     //
-    bool ShedErg(int shard, Erg* e) { return m_shards.Shed(shard, e); }
+    bool ShedErg(int shard, Erg* e)
+    {
+        if (e->m_affinity != Affinity::Any || e->m_lane != Lane::Normal)
+        {
+            ShedHinted(shard, e);
+            return true;
+        }
+        Push(Lane::Normal, shard, e);
+        return true;
+    }
 
-    // Stealer instrumentation, summed across all shards. Written only by the idle daemon stealers
-    // (off the in-cooperator Shed hot path); meant to be read after quiescence. Parks counts idle
-    // timer arms -- one per idle-core wakeup, the cost the backoff exists to cut. Pulls counts work
-    // units a stealer ran. MaxIdleRun is the longest observed run of consecutive empty re-checks.
-    // A production build would route these through the perf system rather than carry the atomics.
+    // Owner of shard's approximate queue depth, both lanes' stealable Ergs. For producers that
+    // pace their own splitting (ParallelFor splits only while its shard is empty); heuristics only.
     //
-    uint64_t Parks() const { return m_parks.load(std::memory_order_relaxed); }
-    uint64_t Pulls() const { return m_pulls.load(std::memory_order_relaxed); }
-    uint64_t MaxIdleRun() const { return m_maxIdleRun.load(std::memory_order_relaxed); }
+    int64_t Depth(int shard) const
+    {
+        return m_shards[0].SizeApprox(shard) + m_shards[1].SizeApprox(shard);
+    }
+
+    // Owner of shard's cooperator only. Wake one indefinitely parked stealer, nearest first, if any
+    // is parked. For producers that deliberately keep their shard shallow and so never reach
+    // ShedErg's wakeThreshold: each exposed piece can recruit one sleeper.
+    //
+    void WakeIdle(int shard)
+    {
+        if (m_sleepers.load(std::memory_order_relaxed) > 0)
+        {
+            WakeSleeper(shard);
+        }
+    }
+
+    // Stealer instrumentation, summed across all shards' Participation::counts (each written only
+    // by its own cooperator); meant to be read after quiescence. Parks counts idle timer arms --
+    // one per idle-core wakeup, the cost the backoff exists to cut. Pulls counts work units a
+    // stealer ran. MaxIdleRun is the longest observed run of consecutive empty re-checks. The
+    // per-cooperator breakdown, with steal attempts and Erg run times, is the perf system's
+    // Family::Work (see coop/perf/CLAUDE.md).
+    //
+    uint64_t Parks() const { return Sum(&Participation::Counts::parks); }
+    uint64_t Pulls() const { return Sum(&Participation::Counts::pulls); }
+    uint64_t MaxIdleRun() const;
+
+    // Cross-thread wakes sent to indefinitely parked stealers (see wakeThreshold). Same caveats.
+    //
+    uint64_t Wakes() const { return Sum(&Participation::Counts::wakes); }
+
+    // PreferHome Ergs made stealable, by age or backlog. Same caveats.
+    //
+    uint64_t Exposed() const { return Sum(&Participation::Counts::exposed); }
 
   private:
+    // Into lane's stealable deque, spilling when it is full. A High Erg recruits a parked peer
+    // whenever one is queued: it is latency-critical, so it does not wait for a backlog to form.
+    //
+    void Push(Lane lane, int shard, Erg* e)
+    {
+        auto& shards = m_shards[static_cast<int>(lane)];
+        bool spilled;
+        shards.Shed(shard, e, &spilled);
+        if (spilled)
+        {
+            Overflowed(shard);
+            return;
+        }
+
+        // One relaxed load of a rarely-written counter while no peer sleeps; the shard-size check
+        // and the wake itself only run once someone is parked indefinitely.
+        //
+        if (m_wakeThreshold > 0 && m_sleepers.load(std::memory_order_relaxed) > 0 &&
+            shards.SizeApprox(shard) >= (lane == Lane::High ? 1 : m_wakeThreshold))
+        {
+            WakeSleeper(shard);
+        }
+    }
+
+    void Retire(Context* ctx, Participation& self);
+    void Adopt(std::vector<Erg*> const& ergs);
+    void Reap();
+    void ShedHinted(int shard, Erg* e);
+    void ExposeAged(Participation& self);
+    void Expose(Participation& self, Lane lane);
     void StealerLoop(Context* ctx, int shard);
+    void WakeSleeper(int shard);
+    void Overflowed(int shard);
+    bool ClearSleeping(Participation& p);
+    void RefreshVictims(Participation& self);
+    Erg* PullNearest(Participation& self);
+    Erg* PullLane(Participation& self, Lane lane);
+    void RunTimed(Participation& self, Erg* e);
+    uint64_t Sum(std::atomic<uint64_t> Participation::Counts::*field) const;
 
-    detail::Shards<Erg*>             m_shards;
+    detail::Shards<Erg*>             m_shards[2];    // by Lane
     std::unique_ptr<Participation[]> m_parts;
-    std::atomic<int>                 m_joined{0};
     int                              m_n = 0;
+
+    // Join and Leave only: the shards never used (m_joined counts those used) and those given up,
+    // and the slabs of cooperators that left, kept while their Ergs may still be out. Each Join
+    // and Leave reaps those that have all theirs back, so they are bounded by the slabs with Ergs
+    // outstanding, not the membership changes. Membership changes are rare; a plain mutex keeps
+    // them off every other path.
+    //
+    std::mutex                       m_membership;
+    int                              m_joined = 0;
+    std::vector<int>                 m_vacant;
+    std::vector<std::unique_ptr<ErgSlab>> m_retired;
+    std::atomic<int>                 m_members{0};
     time::Interval                   m_recheckMin    = std::chrono::microseconds(10);
     time::Interval                   m_recheckMax    = std::chrono::microseconds(200);
     int                              m_idleGrowAfter = 8;
+    int                              m_wakeThreshold = 16;
+    int                              m_remoteStealThreshold = 4;
+    time::Interval                   m_preferHomeDelay = std::chrono::microseconds(100);
+    int                              m_preferHomeBacklog = 32;
+
+    // Set once the first High Erg is shed; until then stealers skip the High lane, so a grid that
+    // never uses it pulls exactly as before. Relaxed: a thief that sees it late only finds the
+    // High work a pass late.
+    //
+    std::atomic<bool>                m_highLaneUsed{false};
+
+    // Count of participants that have published their placement. Bumped once per Join (release);
+    // stealers compare it against Participation::placedSeen to rebuild their victim order.
+    //
+    std::atomic<int>                 m_placed{0};
 
-    std::atomic<uint64_t>            m_parks{0};
-    std::atomic<uint64_t>            m_pulls{0};
-    std::atomic<uint64_t>            m_maxIdleRun{0};
+    // Number of stealers currently parked indefinitely (Participation::sleeping set). Lets ShedErg
+    // skip the wake path with one load while the whole grid is busy.
+    //
+    alignas(64) std::atomic<int>     m_sleepers{0};
 };
 
 } // end namespace work
@@ -120,18 +338,20 @@ class Grid
 // on the Grid path, where the Erg runs on a shared stealer; the Spawn fallback gives fn its own
 // context and may block.
 //
-// Constrained off any pointer convertible to work::Erg* so a caller passing its own (reusable) Erg
-// subclass pointer binds the zero-allocation Shed(Erg*) overload below, not this allocating closure
-// path -- without the constraint the exact-match pointer would outrank the base-pointer overload.
+// hints (erg.h) keep the Erg at home or move it up to the High lane. The Spawn fallback runs fn on
+// this cooperator anyway and ignores them.
 //
 template<typename Fn>
-    requires (!std::is_convertible_v<std::decay_t<Fn>, work::Erg*>)
-inline void Shed(Fn&& fn)
+inline void Shed(work::ShedHints hints, Fn&& fn)
 {
     Cooperator* co = GetCooperator();
     if (work::Participation* p = co->m_participation)
     {
-        p->grid->ShedErg(p->shard, work::MakeErg(std::forward<Fn>(fn)));
+        work::Erg* e = work::MakeErg(*p->slab, std::forward<Fn>(fn));
+        e->m_trace = trace::Capture();
+        e->m_affinity = hints.affinity;
+        e->m_lane = hints.lane;
+        p->grid->ShedErg(p->shard, e);
 
         // Ring the doorbell so an idle local stealer drains this Erg on the next scheduler pass
         // instead of waiting out its backed-off recheck timer. schedule=false: do not switch to
@@ -150,22 +370,35 @@ inline void Shed(Fn&& fn)
     }
 }
 
+// Shed with no hints. Constrained off any pointer convertible to work::Erg* so a caller passing its
+// own (reusable) Erg subclass pointer binds the zero-allocation Shed(Erg*) overload below, not this
+// allocating closure path -- without the constraint the exact-match pointer would outrank the
+// base-pointer overload.
+//
+template<typename Fn>
+    requires (!std::is_convertible_v<std::decay_t<Fn>, work::Erg*>)
+inline void Shed(Fn&& fn)
+{
+    Shed(work::ShedHints{}, std::forward<Fn>(fn));
+}
+
 // Shed an existing, caller-owned Erg -- the zero-allocation companion to Shed(fn). A stable pipeline
 // stage subclasses Erg once and re-sheds the same object each stage (typically from its async op's
 // completion continuation), so there is no per-stage malloc/free: the work item IS the long-lived
 // Erg, not a freshly allocated closure. The Erg must have m_stealerOwned=false so the stealer runs
-// it without freeing it.
+// it without freeing it. Its m_affinity and m_lane apply to every shed of it.
 //
 // Only meaningful on a cooperator that has joined a Grid (a reusable Erg is a Grid concept); returns
-// false if this cooperator does not participate, or if its shard is full. Like Shed(int,Erg*) on the
-// Grid, this pushes to the caller's own shard, so it must run on the owning cooperator's thread --
-// which the in-cooperator re-shed (stealer Run or completion continuation) always does.
+// false if this cooperator does not participate. A full shard spills rather than refusing. Like
+// Grid::ShedErg, this pushes to the caller's own shard, so it must run on the owning cooperator's
+// thread -- which the in-cooperator re-shed (stealer Run or completion continuation) always does.
 //
 inline bool Shed(work::Erg* e)
 {
     Cooperator* co = GetCooperator();
     if (work::Participation* p = co->m_participation)
     {
+        e->m_trace = trace::Capture();
         return p->grid->ShedErg(p->shard, e);
     }
     return false;
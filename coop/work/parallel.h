@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "coop/continuation.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator.hpp"
+#include "coop/coordinator.h"
+#include "coop/preempt.h"
+#include "coop/self.h"
+#include "grid.h"
+
+namespace coop
+{
+namespace work
+{
+
+// A half-open index range [begin, end) handed to ParallelFor / ParallelReduce bodies.
+//
+struct Range
+{
+    int64_t begin = 0;
+    int64_t end   = 0;
+
+    int64_t Size() const { return end - begin; }
+};
+
+namespace detail
+{
+
+// Partial result of one task of a ParallelReduce: the reduction of the contiguous iterations
+// [begin, ...) that task ran. Pushed onto the job's lock-free list by whichever cooperator ran it.
+//
+template<typename T>
+struct Partial
+{
+    T        value;
+    int64_t  begin;
+    Partial* next;
+};
+
+// ParallelFor is ParallelReduce over nothing; its partials are never materialized.
+//
+struct NoPartial {};
+
+// Shared state of one ParallelFor / ParallelReduce call, alive until `done` is released on the
+// origin cooperator. `pending` counts the iterations not yet run; the task that retires the last of
+// them releases `done` on the origin -- directly if it is already there, otherwise via Cooperate.
+// Nothing waits on the tasks themselves: every split is a free-standing Erg, and the join is a
+// single counter plus whatever waits on `done` (a detached continuation, or the blocking caller).
+//
+template<typename T, typename Fn, typename Combine>
+struct ParallelJob
+{
+    static constexpr bool kVoid = std::is_same_v<T, NoPartial>;
+
+    ParallelJob(Range r, int64_t grain, T identity, Fn fn, Combine combine)
+    : pending(r.Size())
+    , origin(Cooperator::thread_cooperator)
+    , done(static_cast<Context*>(nullptr))
+    , grain(grain < 1 ? 1 : grain)
+    , identity(std::move(identity))
+    , fn(std::move(fn))
+    , combine(std::move(combine))
+    {
+    }
+
+    void Run(Range chunk, T& acc)
+    {
+        acc = fn(chunk, std::move(acc));
+    }
+
+    // Any cooperator. Retire n iterations starting at begin, reduced to acc. Must be the task's last
+    // touch of the job: once the count reaches zero the origin may free it.
+    //
+    void Retire(int64_t begin, int64_t n, T&& acc)
+    {
+        if constexpr (!kVoid)
+        {
+            auto* node = new Partial<T>{std::move(acc), begin, nullptr};
+            Partial<T>* head = partials.load(std::memory_order_relaxed);
+            do
+            {
+                node->next = head;
+            } while (!partials.compare_exchange_weak(
+                         head, node, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        if (pending.fetch_sub(n, std::memory_order_acq_rel) != n)
+        {
+            return;
+        }
+
+        if (Cooperator::thread_cooperator == origin)
+        {
+            done.Release(Self(), /*schedule=*/false);
+            return;
+        }
+
+        // The origin must still be accepting work (a job must not straddle its shutdown), so this
+        // only fails on misuse; then the waiter is abandoned with the cooperator.
+        //
+        origin->Cooperate([this](Context* ctx) { done.Release(ctx, /*schedule=*/false); });
+    }
+
+    // Origin only, after `done` is released: fold the partials left to right (ordered by the range
+    // each one covered), so combine need only be associative.
+    //
+    T Collect()
+    {
+        if constexpr (kVoid)
+        {
+            return identity;
+        }
+        else
+        {
+            std::vector<Partial<T>*> nodes;
+            for (Partial<T>* n = partials.exchange(nullptr, std::memory_order_acquire); n; n = n->next)
+            {
+                nodes.push_back(n);
+            }
+            std::sort(nodes.begin(), nodes.end(),
+                      [](Partial<T>* a, Partial<T>* b) { return a->begin < b->begin; });
+
+            T result = identity;
+            for (Partial<T>* n : nodes)
+            {
+                result = combine(std::move(result), std::move(n->value));
+                delete n;
+            }
+            return result;
+        }
+    }
+
+    std::atomic<int64_t>     pending;
+    Cooperator*              origin;
+    Coordinator              done;
+    int64_t                  grain;
+    T                        identity;
+    Fn                       fn;
+    Combine                  combine;
+    std::atomic<Partial<T>*> partials{nullptr};
+};
+
+// Run r for job on the current (participating) cooperator, splitting lazily: before each grain-sized
+// chunk, if this cooperator's own shard is empty -- nothing is left here for an idle peer to steal --
+// the upper half of what remains is shed as a new task and one parked stealer is woken for it.
+// Otherwise the next chunk runs in place. A range is therefore only split as fast as peers take the
+// pieces: an uncontended run stays one sequential, cache-friendly sweep, and a busy grid splits down
+// the recursion only where thieves are actually waiting. The iterations a task runs stay contiguous
+// (it always keeps the lower part), which is what lets Collect order the partials.
+//
+// A slice that has used up its timeSliceUs (preempt.h) sheds the same way, whether or not the shard
+// is empty, so the remainder halves down to one chunk and this returns: an Erg cannot yield, but it
+// can stop holding its cooperator.
+//
+// A piece can also run where there is no participation to shed into: a leaving member runs what it
+// cannot hand on inline, after it has cleared its own. Then the rest goes in chunks, unsplit.
+//
+template<typename Job>
+void Execute(Job& job, Range r)
+{
+    Participation* p = Cooperator::thread_cooperator->m_participation;
+    const int64_t begin = r.begin;
+    int64_t ran = 0;
+    auto acc = job.identity;
+
+    while (r.Size() > job.grain)
+    {
+        if (p && (p->grid->Depth(p->shard) == 0 || SliceExpired()))
+        {
+            const Range upper{r.begin + r.Size() / 2, r.end};
+            Erg* piece = MakeErg(*p->slab, [&job, upper] { Execute(job, upper); });
+            piece->m_trace = trace::Capture();
+            p->grid->ShedErg(p->shard, piece);
+
+            // As in Shed: ring our own stealer so the piece is not stranded here behind a backed-off
+            // timer if no peer takes it, then recruit a parked peer.
+            //
+            p->doorbell.Release(Self(), /*schedule=*/false);
+            p->grid->WakeIdle(p->shard);
+            r.end = upper.begin;
+            continue;
+        }
+
+        job.Run(Range{r.begin, r.begin + job.grain}, acc);
+        r.begin += job.grain;
+        ran += job.grain;
+    }
+    job.Run(r, acc);
+    ran += r.Size();
+
+    job.Retire(begin, ran, std::move(acc));
+}
+
+// The non-participant (or nothing-to-split) path: grain-sized chunks in order, on this context.
+// yieldable is set by the blocking forms, which run on a context and so may yield between chunks
+// once the slice has expired.
+//
+template<typename T, typename Fn>
+T RunInline(Range r, int64_t grain, T acc, Fn& fn, bool yieldable)
+{
+    if (grain < 1)
+    {
+        grain = 1;
+    }
+    while (r.begin < r.end)
+    {
+        const Range chunk{r.begin, std::min(r.end, r.begin + grain)};
+        acc = fn(chunk, std::move(acc));
+        r.begin = chunk.end;
+        if (yieldable && r.begin < r.end)
+        {
+            MaybeYield();
+        }
+    }
+    return acc;
+}
+
+} // end namespace detail
+
+// Data-parallel reduction over [r.begin, r.end): fn(Range chunk, T acc) -> T folds one chunk of at
+// most grain iterations into acc, and combine(T left, T right) -> T joins two partials covering
+// adjacent ranges (left before right). combine must be associative; identity must be its identity.
+// fn runs inside Ergs on any participating cooperator, so it must be thread-safe and is bound by the
+// Erg contract: run to completion, never suspend. combine runs on the calling cooperator at the join.
+//
+// Work is split lazily (see detail::Execute) rather than cut N ways up front, and the calling
+// cooperator runs the first piece itself. On a cooperator that has not joined a Grid, the whole range
+// runs inline here in grain-sized chunks -- the "shed = spawn" analogue.
+//
+// This form blocks the calling context (uninterruptibly: the tasks borrow this frame) until every
+// iteration has run. It may not be called from inside an Erg or continuation -- use the
+// continuation form there.
+//
+template<typename T, typename Fn, typename Combine>
+T ParallelReduce(Range r, int64_t grain, T identity, Fn const& fn, Combine const& combine)
+{
+    Participation* p = GetCooperator()->m_participation;
+    if (!p || r.Size() <= grain)
+    {
+        return detail::RunInline(r, grain, std::move(identity), fn, /*yieldable=*/true);
+    }
+
+    detail::ParallelJob<T, Fn const&, Combine const&> job(r, grain, std::move(identity), fn, combine);
+    detail::Execute(job, r);
+    job.done.Acquire(Self());
+    return job.Collect();
+}
+
+// Continuation form: returns once this cooperator's share is done (or immediately split off), and
+// done(T result) runs later on this cooperator as a detached continuation once every iteration has
+// run -- no context is parked for the join. fn, combine and done are moved into the job. On a
+// non-participant, or when there is nothing to split, done runs inline before this returns.
+//
+template<typename T, typename Fn, typename Combine, typename Done>
+void ParallelReduce(Range r, int64_t grain, T identity, Fn fn, Combine combine, Done done)
+{
+    Participation* p = GetCooperator()->m_participation;
+    if (!p || r.Size() <= grain)
+    {
+        done(detail::RunInline(r, grain, std::move(identity), fn, /*yieldable=*/false));
+        return;
+    }
+
+    using Job = detail::ParallelJob<T, Fn, Combine>;
+    Job* job = new Job(r, grain, std::move(identity), std::move(fn), std::move(combine));
+    job->done.ContinueDetached([job, d = std::move(done)](Coordinator*) mutable
+    {
+        T result = job->Collect();
+        delete job;
+        d(std::move(result));
+    });
+    detail::Execute(*job, r);
+}
+
+// Run fn(Range chunk) over [r.begin, r.end) in chunks of at most grain iterations, spread across the
+// Grid. Same splitting, fallback and blocking rules as ParallelReduce.
+//
+template<typename Fn>
+void ParallelFor(Range r, int64_t grain, Fn const& fn)
+{
+    ParallelReduce(r, grain, detail::NoPartial{},
+        [&fn](Range chunk, detail::NoPartial) { fn(chunk); return detail::NoPartial{}; },
+        [](detail::NoPartial, detail::NoPartial) { return detail::NoPartial{}; });
+}
+
+// Continuation form of ParallelFor: done() runs on this cooperator once every chunk has run.
+//
+template<typename Fn, typename Done>
+void ParallelFor(Range r, int64_t grain, Fn fn, Done done)
+{
+    ParallelReduce(r, grain, detail::NoPartial{},
+        [f = std::move(fn)](Range chunk, detail::NoPartial) mutable
+        {
+            f(chunk);
+            return detail::NoPartial{};
+        },
+        [](detail::NoPartial, detail::NoPartial) { return detail::NoPartial{}; },
+        [d = std::move(done)](detail::NoPartial) mutable { d(); });
+}
+
+} // end namespace work
+} // end namespace coop
@@ -0,0 +1,442 @@
+#include "broadcast.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "connection.h"
+#include "deflate.h"
+#include "coop/coordinate_with.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator_var.h"
+#include "coop/cooperator_var.hpp"
+#include "coop/self.h"
+
+namespace coop
+{
+namespace ws
+{
+
+namespace
+{
+
+// Control frames a subscriber holds for its writer: a burst of pongs, not a stream of them
+//
+constexpr size_t kMaxControl = 4096;
+
+// Batches held by writers blocked in a send are out of the pool; a cooperator keeps this many
+// idle ones.
+//
+struct BatchPool
+{
+    static constexpr size_t MAX_CACHED = 16;
+
+    ~BatchPool()
+    {
+        for (char* buffer : m_free)
+        {
+            delete[] buffer;
+        }
+    }
+
+    char* Acquire()
+    {
+        if (m_free.empty())
+        {
+            return new char[Subscriber::BATCH_SIZE];
+        }
+        char* buffer = m_free.back();
+        m_free.pop_back();
+        return buffer;
+    }
+
+    void Release(char* buffer)
+    {
+        if (m_free.size() < MAX_CACHED)
+        {
+            m_free.push_back(buffer);
+            return;
+        }
+        delete[] buffer;
+    }
+
+    std::vector<char*> m_free;
+};
+
+CooperatorVar<BatchPool> s_batches;
+
+struct Batch
+{
+    Batch()
+    : data(Cooperator::thread_cooperator ? s_batches->Acquire()
+                                         : new char[Subscriber::BATCH_SIZE])
+    {
+    }
+
+    ~Batch()
+    {
+        if (Cooperator::thread_cooperator)
+        {
+            s_batches->Release(data);
+            return;
+        }
+        delete[] data;
+    }
+
+    Batch(Batch const&) = delete;
+    Batch& operator=(Batch const&) = delete;
+
+    char* data;
+};
+
+} // end anonymous namespace
+
+// ---------------------------------------------------------------------------
+// SharedFrame
+// ---------------------------------------------------------------------------
+
+namespace detail
+{
+
+SharedFrame* SharedFrame::Make(Opcode opcode, const void* payload, size_t size, bool rsv1)
+{
+    uint8_t header[10];
+    size_t headerSize = EncodeFrameHeader(header, opcode, true, size, rsv1);
+
+    void* memory = ::operator new(sizeof(SharedFrame) + headerSize + size);
+    auto* frame = new (memory) SharedFrame;
+    frame->m_opcode = opcode;
+    frame->m_compressed = rsv1;
+    frame->m_headerSize = static_cast<uint8_t>(headerSize);
+    frame->m_size = headerSize + size;
+    memcpy(frame->m_data, header, headerSize);
+    if (size > 0)
+    {
+        memcpy(frame->m_data + headerSize, payload, size);
+    }
+    return frame;
+}
+
+SharedFrame::~SharedFrame()
+{
+    for (auto* variant : m_variants)
+    {
+        if (variant)
+        {
+            variant->Release();
+        }
+    }
+}
+
+void SharedFrame::Release()
+{
+    assert(m_refs > 0);
+    if (--m_refs == 0)
+    {
+        this->~SharedFrame();
+        ::operator delete(this);
+    }
+}
+
+SharedFrame* SharedFrame::ForWindow(int windowBits, int level, int memLevel, size_t minSize)
+{
+    size_t payloadSize = m_size - m_headerSize;
+    if (windowBits < 9 || windowBits > 15 || m_compressed || payloadSize < minSize)
+    {
+        return this;
+    }
+
+    size_t slot = static_cast<size_t>(windowBits - 9);
+    if (m_variants[slot])
+    {
+        return m_variants[slot];
+    }
+    if (m_incompressible & (1u << slot))
+    {
+        return this;
+    }
+
+    // An empty window on a borrowed stream, so the message refers to nothing before it
+    //
+    MessageDeflater deflater;
+    deflater.Configure(windowBits, level, memLevel, true);
+    std::string compressed;
+    if (!deflater.Compress(m_data + m_headerSize, payloadSize, &compressed) ||
+        compressed.size() >= payloadSize)
+    {
+        m_incompressible |= static_cast<uint16_t>(1u << slot);
+        return this;
+    }
+    m_variants[slot] = Make(m_opcode, compressed.data(), compressed.size(), true);
+    return m_variants[slot];
+}
+
+} // end namespace coop::ws::detail
+
+// ---------------------------------------------------------------------------
+// Subscriber
+// ---------------------------------------------------------------------------
+
+Subscriber::Subscriber(Context* ctx, ConnectionBase& conn, SubscriberOptions const& options)
+: m_conn(conn)
+, m_options(options)
+, m_wake(ctx)
+{
+}
+
+Subscriber::~Subscriber()
+{
+    if (m_broadcast)
+    {
+        m_broadcast->Unsubscribe(this);
+    }
+    DropQueue();
+}
+
+int Subscriber::Run(Context* ctx)
+{
+    for (;;)
+    {
+        if (m_overflowed)
+        {
+            m_control.clear();
+            m_conn.Close(1008);
+            return -ENOBUFS;
+        }
+        if (m_closeCode)
+        {
+            DropQueue();
+            m_control.clear();
+            m_conn.Close(m_closeCode);
+            return 0;
+        }
+        if (!m_control.empty() || !m_queue.empty())
+        {
+            if (!Drain()) return -EIO;
+            continue;
+        }
+        if (m_stopping)
+        {
+            return 0;
+        }
+        if (CoordinateWithKill(ctx, &m_wake).Killed())
+        {
+            return -ECANCELED;
+        }
+    }
+}
+
+void Subscriber::Stop()
+{
+    m_stopping = true;
+    Wake();
+}
+
+void Subscriber::Close(uint16_t code)
+{
+    if (m_closeCode) return;
+    m_closeCode = code;
+    Wake();
+}
+
+bool Subscriber::SendControl(Opcode opcode, const void* data, size_t size)
+{
+    assert(opcode == Opcode::Ping || opcode == Opcode::Pong);
+    assert(size <= 125);
+    if (m_closeCode || m_overflowed || m_control.size() + 2 + size > kMaxControl)
+    {
+        return false;
+    }
+
+    uint8_t header[10];
+    size_t headerSize = detail::EncodeFrameHeader(header, opcode, true, size);
+    m_control.append(reinterpret_cast<const char*>(header), headerSize);
+    if (size > 0)
+    {
+        m_control.append(static_cast<const char*>(data), size);
+    }
+    Wake();
+    return true;
+}
+
+bool Subscriber::Offer(detail::SharedFrame* frame, uint64_t key)
+{
+    if (m_stopping || m_overflowed || m_closeCode)
+    {
+        return false;
+    }
+
+    // A keyed update replaces the one still waiting, in its place; the writer is already due
+    //
+    if (key && m_options.policy == SlowConsumer::Conflate)
+    {
+        for (auto& entry : m_queue)
+        {
+            if (entry.key != key) continue;
+            m_queuedBytes = m_queuedBytes - entry.frame->Size() + frame->Size();
+            frame->AddRef();
+            entry.frame->Release();
+            entry.frame = frame;
+            m_dropped++;
+            return true;
+        }
+    }
+
+    auto full = [&]
+    {
+        return !m_queue.empty() && (m_queue.size() >= m_options.maxFrames ||
+                                    m_queuedBytes + frame->Size() > m_options.maxBytes);
+    };
+    if (full())
+    {
+        switch (m_options.policy)
+        {
+        case SlowConsumer::Drop:
+            m_dropped++;
+            return false;
+        case SlowConsumer::Disconnect:
+            m_dropped += m_queue.size() + 1;
+            m_overflowed = true;
+            DropQueue();
+            Wake();
+            return false;
+        case SlowConsumer::Conflate:
+            while (full())
+            {
+                Evict();
+                m_dropped++;
+            }
+            break;
+        }
+    }
+
+    frame->AddRef();
+    m_queue.push_back({frame, key});
+    m_queuedBytes += frame->Size();
+    Wake();
+    return true;
+}
+
+void Subscriber::Evict()
+{
+    auto* frame = m_queue.front().frame;
+    m_queuedBytes -= frame->Size();
+    m_queue.pop_front();
+    frame->Release();
+}
+
+void Subscriber::DropQueue()
+{
+    for (auto& entry : m_queue)
+    {
+        entry.frame->Release();
+    }
+    m_queue.clear();
+    m_queuedBytes = 0;
+}
+
+// The wake coordinator is a binary semaphore: held while the writer has nothing to do, released
+// by whoever gives it something
+//
+void Subscriber::Wake()
+{
+    if (m_wake.IsHeld())
+    {
+        m_wake.Release(Self(), false);
+    }
+}
+
+// One send: the pending control frames and as many queued frames as fit a batch. Frames leave the
+// queue before the send blocks, so publishes meanwhile queue behind them.
+//
+bool Subscriber::Drain()
+{
+    if (m_control.empty() &&
+        (m_queue.size() == 1 || m_queue.front().frame->Size() >= BATCH_SIZE))
+    {
+        auto* frame = m_queue.front().frame;
+        m_queuedBytes -= frame->Size();
+        m_queue.pop_front();
+        bool ok = m_conn.SendEncoded(frame->Data(), frame->Size(), frame->Compressed());
+        frame->Release();
+        return ok;
+    }
+
+    Batch batch;
+    size_t len = m_control.size();
+    memcpy(batch.data, m_control.data(), len);
+    m_control.clear();
+
+    bool compressed = false;
+    while (!m_queue.empty())
+    {
+        auto* frame = m_queue.front().frame;
+        if (len + frame->Size() > BATCH_SIZE) break;
+        memcpy(batch.data + len, frame->Data(), frame->Size());
+        len += frame->Size();
+        compressed |= frame->Compressed();
+        Evict();
+    }
+    return m_conn.SendEncoded(batch.data, len, compressed);
+}
+
+// ---------------------------------------------------------------------------
+// Broadcast
+// ---------------------------------------------------------------------------
+
+Broadcast::Broadcast(BroadcastOptions const& options)
+: m_options(options)
+{
+}
+
+Broadcast::~Broadcast()
+{
+    while (auto* subscriber = m_subscribers.Pop())
+    {
+        subscriber->m_broadcast = nullptr;
+        subscriber->Stop();
+    }
+}
+
+void Broadcast::Subscribe(Subscriber* subscriber)
+{
+    assert(!subscriber->m_broadcast);
+    subscriber->m_broadcast = this;
+    subscriber->m_windowBits = subscriber->m_conn.DeflateWindowBits();
+    m_subscribers.Push(subscriber);
+    m_count++;
+}
+
+void Broadcast::Unsubscribe(Subscriber* subscriber)
+{
+    if (subscriber->m_broadcast != this) return;
+    m_subscribers.Remove(subscriber);
+    subscriber->m_broadcast = nullptr;
+    m_count--;
+}
+
+size_t Broadcast::Publish(Opcode opcode, const void* data, size_t size, uint64_t key)
+{
+    auto* frame = detail::SharedFrame::Make(opcode, data, size);
+
+    // Offer never yields, so the walk sees a list no one else is changing
+    //
+    size_t queued = 0;
+    m_subscribers.Visit([&](Subscriber* subscriber)
+    {
+        auto* send = frame->ForWindow(subscriber->m_windowBits, m_options.level,
+                                      m_options.memLevel, m_options.minSize);
+        if (subscriber->Offer(send, key))
+        {
+            queued++;
+        }
+        return true;
+    });
+    frame->Release();
+    return queued;
+}
+
+} // namespace coop::ws
+} // namespace coop
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+#include "types.h"
+#include "coop/coordinator.h"
+#include "coop/detail/embedded_list.h"
+
+namespace coop
+{
+
+struct Context;
+
+namespace ws
+{
+
+struct Broadcast;
+struct ConnectionBase;
+
+// What a Subscriber does when a publish finds its queue full
+//
+enum class SlowConsumer : uint8_t
+{
+    Drop,           // lose the new frame
+    Disconnect,     // drop the queue and close the connection with 1008 (policy violation)
+    Conflate,       // lose the oldest queued frame; a keyed frame replaces its queued namesake
+};
+
+namespace detail
+{
+
+// One encoded frame -- header and payload -- shared by every queue it sits in. Counted by hand:
+// a Broadcast and its subscribers live on one cooperator. A frame also owns the compressed forms
+// built for subscribers with permessage-deflate, one per window size asked for, each compressed
+// from an empty window so that any connection's inflater takes it.
+//
+struct SharedFrame
+{
+    static SharedFrame* Make(Opcode opcode, const void* payload, size_t size, bool rsv1 = false);
+
+    void AddRef() { m_refs++; }
+    void Release();
+
+    const char* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+    bool Compressed() const { return m_compressed; }
+
+    // The frame for a connection whose compressed messages may use windowBits (0 for none): the
+    // compressed form, or this frame where compression does not pay (or fails).
+    //
+    SharedFrame* ForWindow(int windowBits, int level, int memLevel, size_t minSize);
+
+  private:
+    SharedFrame() = default;
+    ~SharedFrame();
+
+    uint32_t        m_refs = 1;
+    Opcode          m_opcode = Opcode::Text;
+    bool            m_compressed = false;
+    uint8_t         m_headerSize = 0;
+    uint16_t        m_incompressible = 0;   // bit per window size that compression did not shrink
+    SharedFrame*    m_variants[7] = {};     // compressed forms, windows of 9 to 15 bits
+    size_t          m_size = 0;
+    char            m_data[0];
+};
+
+} // end namespace coop::ws::detail
+
+struct SubscriberOptions
+{
+    // A queue past either bound is full. One frame is always accepted into an empty queue,
+    // however big.
+    //
+    size_t          maxFrames = 256;
+    size_t          maxBytes = 1 << 20;
+    SlowConsumer    policy = SlowConsumer::Drop;
+};
+
+// Subscriber is one connection's place in a Broadcast: a bounded queue of shared frames and the
+// writer that drains it: Subscribe it, then call Run from the context that is to do the sending.
+// Run waits for frames and sends everything queued at once, coalescing small frames into one send
+// of up to BATCH_SIZE bytes; a lone frame, or one that fills a batch alone, goes out straight
+// from the shared buffer.
+//
+// While Run is live it is the connection's only sender. The context reading the connection
+// routes its pongs and its close through SendControl and Close, which the writer sends ahead of
+// (and in place of) queued data.
+//
+struct Subscriber : EmbeddedListHookups<Subscriber>
+{
+    static constexpr size_t BATCH_SIZE = 64 << 10;
+
+    Subscriber(Context* ctx, ConnectionBase& conn, SubscriberOptions const& options = {});
+    ~Subscriber();
+
+    Subscriber(Subscriber const&) = delete;
+    Subscriber& operator=(Subscriber const&) = delete;
+
+    // Send queued frames until stopped. Returns 0 after Stop or Close, -ECANCELED when the
+    // context is killed, -EIO when a send fails, or -ENOBUFS once a Disconnect subscriber
+    // overflowed and was closed.
+    //
+    int Run(Context* ctx);
+
+    // Finish sending what is queued, then return from Run
+    //
+    void Stop();
+
+    // Drop the queue, send a close frame with code, and return from Run
+    //
+    void Close(uint16_t code = 1000);
+
+    // Queue a Ping or Pong (payload up to 125 bytes) ahead of any data. False when the
+    // subscriber is closing.
+    //
+    bool SendControl(Opcode opcode, const void* data = nullptr, size_t size = 0);
+
+    size_t Queued() const { return m_queue.size(); }
+    size_t QueuedBytes() const { return m_queuedBytes; }
+    uint64_t Dropped() const { return m_dropped; }
+
+  private:
+    friend struct Broadcast;
+
+    struct Entry
+    {
+        detail::SharedFrame*    frame;
+        uint64_t                key;
+    };
+
+    // Queue frame under the subscriber's policy (taking a reference if it keeps it). True if it
+    // was queued.
+    //
+    bool Offer(detail::SharedFrame* frame, uint64_t key);
+    void Evict();   // the oldest queued frame
+    void DropQueue();
+    void Wake();
+    bool Drain();
+
+    ConnectionBase&     m_conn;
+    SubscriberOptions   m_options;
+    Broadcast*          m_broadcast = nullptr;
+    int                 m_windowBits = 0;
+
+    std::deque<Entry>   m_queue;
+    size_t              m_queuedBytes = 0;
+    uint64_t            m_dropped = 0;
+    std::string         m_control;          // encoded control frames, sent first
+
+    bool                m_stopping = false;
+    bool                m_overflowed = false;
+    uint16_t            m_closeCode = 0;
+
+    Coordinator         m_wake;
+};
+
+// Compression of the shared frames for subscribers whose connections negotiated it
+//
+struct BroadcastOptions
+{
+    size_t  minSize = 256;
+    int     level = 5;
+    int     memLevel = 8;
+};
+
+// Broadcast fans one message out to many connections. Publish encodes the frame once -- and
+// compresses it once per distinct window among deflate subscribers -- then queues a reference to
+// every subscriber and wakes its writer, so the cost per subscriber is a queue push; the bytes
+// are formatted once and only copied when a writer coalesces them into a batch.
+//
+// Single cooperator: subscribers, publishers, and the Broadcast share one. Destroying it detaches
+// the subscribers, whose writers return from Run once their queues drain.
+//
+struct Broadcast
+{
+    explicit Broadcast(BroadcastOptions const& options = {});
+    ~Broadcast();
+
+    Broadcast(Broadcast const&) = delete;
+    Broadcast& operator=(Broadcast const&) = delete;
+
+    void Subscribe(Subscriber* subscriber);
+    void Unsubscribe(Subscriber* subscriber);
+
+    // Queue one message to every subscriber. A nonzero key names what the message updates
+    // (a ticker symbol, say) for Conflate subscribers. Returns how many subscribers queued it.
+    //
+    size_t Publish(Opcode opcode, const void* data, size_t size, uint64_t key = 0);
+    size_t PublishText(const void* data, size_t size, uint64_t key = 0)
+    {
+        return Publish(Opcode::Text, data, size, key);
+    }
+    size_t PublishBinary(const void* data, size_t size, uint64_t key = 0)
+    {
+        return Publish(Opcode::Binary, data, size, key);
+    }
+
+    size_t Subscribers() const { return m_count; }
+
+  private:
+    BroadcastOptions                m_options;
+    EmbeddedList<Subscriber>        m_subscribers;
+    size_t                          m_count = 0;
+};
+
+} // namespace coop::ws
+} // namespace coop
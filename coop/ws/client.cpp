@@ -0,0 +1,286 @@
+#include "client.h"
+#include "sha1.h"
+
+#include "coop/self.h"
+#include "coop/http/transport.h"
+#include "coop/http/tls_transport.h"
+#include "coop/io/connect.h"
+#include "coop/io/ssl/context.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <new>
+#include <string>
+#include <strings.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+
+#include <spdlog/spdlog.h>
+
+namespace coop
+{
+namespace ws
+{
+
+namespace
+{
+
+bool CaseInsensitiveEq(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+std::string_view Trim(std::string_view s)
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+bool ContainsToken(std::string_view list, std::string_view token)
+{
+    while (!list.empty())
+    {
+        size_t comma = list.find(',');
+        if (CaseInsensitiveEq(Trim(list.substr(0, comma)), token)) return true;
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+// The opening handshake's request (RFC 6455 4.1). Host carries the port unless it is the
+// scheme's default, and brackets an IPv6 literal.
+//
+std::string HandshakeRequest(const char* host, int port, bool tls, const char* path,
+                             const char* key, ClientOptions const& options)
+{
+    std::string request;
+    request.reserve(256 + options.headers.size());
+    request += "GET ";
+    request += path[0] ? path : "/";
+    request += " HTTP/1.1\r\nHost: ";
+    bool literal6 = strchr(host, ':') != nullptr;
+    if (literal6) request += '[';
+    request += host;
+    if (literal6) request += ']';
+    if (port != (tls ? 443 : 80))
+    {
+        request += ':';
+        request += std::to_string(port);
+    }
+    request += "\r\n"
+               "Upgrade: websocket\r\n"
+               "Connection: Upgrade\r\n"
+               "Sec-WebSocket-Version: 13\r\n"
+               "Sec-WebSocket-Key: ";
+    request += key;
+    request += "\r\n";
+    if (!options.protocol.empty())
+    {
+        request += "Sec-WebSocket-Protocol: ";
+        request += options.protocol;
+        request += "\r\n";
+    }
+    request += options.headers;
+    request += "\r\n";
+    return request;
+}
+
+// The 101 in response[0, size), its headers ending there: upgraded to websocket, accepting key,
+// with no extension, and a subprotocol only if one was asked for
+//
+bool CheckHandshakeResponse(std::string_view response, const char* key, bool askedProtocol,
+                            std::string* protocol)
+{
+    size_t eol = response.find("\r\n");
+    std::string_view status = response.substr(0, eol);
+    if (status.size() < 12 || status.substr(0, 5) != "HTTP/" || status.substr(8, 4) != " 101")
+    {
+        spdlog::warn("ws client: upgrade refused: {}", status);
+        return false;
+    }
+
+    char expected[32];
+    detail::ComputeAcceptKey(key, strlen(key), expected);
+
+    bool upgrade = false;
+    bool connection = false;
+    bool accepted = false;
+    response.remove_prefix(eol + 2);
+    while ((eol = response.find("\r\n")) != 0 && eol != std::string_view::npos)
+    {
+        std::string_view line = response.substr(0, eol);
+        response.remove_prefix(eol + 2);
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view name = line.substr(0, colon);
+        std::string_view value = Trim(line.substr(colon + 1));
+
+        if (CaseInsensitiveEq(name, "upgrade"))
+            upgrade = CaseInsensitiveEq(value, "websocket");
+        else if (CaseInsensitiveEq(name, "connection"))
+            connection = ContainsToken(value, "upgrade");
+        else if (CaseInsensitiveEq(name, "sec-websocket-accept"))
+            accepted = value == expected;
+        else if (CaseInsensitiveEq(name, "sec-websocket-extensions"))
+        {
+            spdlog::warn("ws client: server chose an extension not offered: {}", value);
+            return false;
+        }
+        else if (CaseInsensitiveEq(name, "sec-websocket-protocol"))
+        {
+            if (!askedProtocol) return false;
+            protocol->assign(value);
+        }
+    }
+
+    if (!upgrade || !connection || !accepted)
+    {
+        spdlog::warn("ws client: bad handshake response (upgrade {} connection {} accept {})",
+                     upgrade, connection, accepted);
+        return false;
+    }
+    return true;
+}
+
+// Send the request and read the response up to the blank line into buf. Returns the headers'
+// length; the bytes after them, to *received, are the first of the WebSocket stream.
+//
+template<typename Transport>
+size_t Handshake(Transport& transport, std::string const& request, char* buf, size_t* received,
+                 time::Interval timeout)
+{
+    if (transport.SendAll(request.data(), request.size()) < 0) return 0;
+
+    size_t len = 0;
+    while (len < Client::MAX_HANDSHAKE)
+    {
+        int n = transport.Recv(buf + len, Client::MAX_HANDSHAKE - len, 0, timeout);
+        if (n <= 0) return 0;
+
+        // The end may straddle the previous read
+        //
+        size_t from = len >= 3 ? len - 3 : 0;
+        len += static_cast<size_t>(n);
+        std::string_view seen(buf + from, len - from);
+        size_t end = seen.find("\r\n\r\n");
+        if (end != std::string_view::npos)
+        {
+            *received = len;
+            return from + end + 4;
+        }
+    }
+    spdlog::warn("ws client: handshake response over {} bytes", Client::MAX_HANDSHAKE);
+    return 0;
+}
+
+template<typename Transport>
+ConnectionBase* Upgrade(Transport transport, const char* host, int port, bool tls,
+                        const char* path, ClientOptions const& options, std::string* protocol)
+{
+    uint8_t nonce[16];
+    if (getrandom(nonce, sizeof(nonce), 0) != sizeof(nonce))
+    {
+        spdlog::warn("ws client: getrandom: {}", strerror(errno));
+        return nullptr;
+    }
+    char key[32];
+    detail::Base64Encode(nonce, sizeof(nonce), key);
+
+    std::string request = HandshakeRequest(host, port, tls, path, key, options);
+    std::string response(Client::MAX_HANDSHAKE, '\0');
+    size_t received = 0;
+    size_t headers = Handshake(transport, request, response.data(), &received, options.timeout);
+    if (headers == 0 ||
+        !CheckHandshakeResponse(std::string_view(response.data(), headers), key,
+                                !options.protocol.empty(), protocol))
+    {
+        return nullptr;
+    }
+
+    size_t leftover = received - headers;
+    if (leftover > options.recvBufSize)
+    {
+        spdlog::warn("ws client: {} bytes behind the 101 exceed the recv buffer", leftover);
+        return nullptr;
+    }
+
+    using Conn = Connection<Transport>;
+    void* mem = std::malloc(sizeof(Conn) + Conn::ExtraBytes(options.recvBufSize,
+                                                            options.sendBufSize));
+    auto* conn = new (mem) Conn(transport, Self(), options.recvBufSize, options.sendBufSize,
+                                options.timeout, response.data() + headers, leftover);
+    conn->SetClient();
+    conn->SetMaxMessageSize(options.maxMessageSize);
+    return conn;
+}
+
+} // anonymous namespace
+
+bool Client::Connect(const char* host, int port, const char* path, ClientOptions const& options)
+{
+    Reset();
+
+    int fd = io::ConnectAny(host, port, options.connectTimeout, {.noDelay = true});
+    if (fd < 0)
+    {
+        spdlog::warn("ws client: connect {}:{}: {}", host, port, strerror(-fd));
+        return false;
+    }
+    m_desc.emplace(fd);
+
+    if (options.tls)
+    {
+        m_ssl.emplace(*options.tls, *m_desc, io::ssl::SocketBio{});
+
+        // SNI only for names: RFC 6066 rules out literal addresses
+        //
+        in6_addr addr;
+        if (::inet_pton(AF_INET, host, &addr) != 1 && ::inet_pton(AF_INET6, host, &addr) != 1)
+        {
+            SSL_set_tlsext_host_name(m_ssl->m_ssl, host);
+        }
+        if (m_ssl->HandshakeKill() != 0)
+        {
+            spdlog::warn("ws client: TLS handshake {}:{} failed", host, port);
+            Reset();
+            return false;
+        }
+        m_conn = Upgrade(http::TlsTransport(*m_ssl, *m_desc), host, port, true, path, options,
+                         &m_protocol);
+    }
+    else
+    {
+        m_conn = Upgrade(http::PlaintextTransport(*m_desc), host, port, false, path, options,
+                         &m_protocol);
+    }
+
+    if (!m_conn)
+    {
+        Reset();
+        return false;
+    }
+    return true;
+}
+
+void Client::Reset()
+{
+    if (m_conn)
+    {
+        m_conn->~ConnectionBase();
+        std::free(m_conn);
+        m_conn = nullptr;
+    }
+    m_ssl.reset();
+    m_desc.reset();
+    m_protocol.clear();
+}
+
+} // namespace coop::ws
+} // namespace coop
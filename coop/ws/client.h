@@ -0,0 +1,118 @@
+#pragma once
+
+// ws::Client — an outbound WebSocket connection: connect, opening handshake, then the same
+// ws::Connection the server side uses, in the client role.
+//
+// Usage:
+//
+//     ws::ClientOptions options;
+//     options.tls = &clientContext;              // ssl::Mode::Client, for wss://
+//     options.headers = "Authorization: Bearer ...\r\n";
+//
+//     ws::Client client;
+//     if (!client.Connect("feed.example.com", 443, "/v1/stream", options)) return;
+//
+//     client->SendText(subscribe.data(), subscribe.size());
+//     while (auto* msg = client->NextMessage())
+//     {
+//         if (msg->IsPing()) { client->SendPong(msg->data, msg->size); continue; }
+//         if (msg->IsClose()) break;
+//         Handle(msg->View());
+//     }
+//
+// The handshake (RFC 6455 4.1) sends a random Sec-WebSocket-Key and checks the 101 against it:
+// Upgrade, Connection and Sec-WebSocket-Accept, and no extension the client did not offer. It
+// offers none -- permessage-deflate stays server-side. Bytes the server sent behind the 101 are
+// handed to the connection, as Upgrade() does with a request's leftovers.
+//
+// The connection then masks every frame it sends (ConnectionImpl::SetClient) and reads frames
+// through the shared codec. NextMessage is the intended read for feeds: a message that arrives
+// as one frame is a view of the recv buffer, so size recvBufSize to the feed's usual message.
+//
+// Like the connection it wraps, a Client belongs to the cooperator that connected it.
+//
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "connection.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/ssl/connection.h"
+#include "coop/time/interval.h"
+
+namespace coop
+{
+
+namespace io { namespace ssl { struct Context; } }
+
+namespace ws
+{
+
+struct ClientOptions
+{
+    // Client context (ssl::Mode::Client) for wss; null for plain ws. SNI is set for names.
+    //
+    io::ssl::Context* tls = nullptr;
+
+    // Extra request header lines, each a complete "Name: value\r\n"
+    //
+    std::string_view headers;
+
+    // Sec-WebSocket-Protocol to ask for, if any; the server's pick is Protocol()
+    //
+    std::string_view protocol;
+
+    size_t recvBufSize = ConnectionBase::DEFAULT_RECV_BUFFER_SIZE;
+    size_t sendBufSize = ConnectionBase::DEFAULT_SEND_BUFFER_SIZE;
+
+    // How long opening the connection may take, raced across the host's addresses
+    // (io::ConnectAny), and the recv timeout of the handshake and the connection after it
+    //
+    time::Interval connectTimeout = std::chrono::seconds(10);
+    time::Interval timeout = std::chrono::seconds(30);
+
+    // ConnectionImpl::SetMaxMessageSize; 0 for no limit
+    //
+    size_t maxMessageSize = 0;
+};
+
+struct Client
+{
+    // The largest 101 response read, headers and all
+    //
+    static constexpr size_t MAX_HANDSHAKE = 8192;
+
+    Client() = default;
+    ~Client() { Reset(); }
+
+    Client(Client const&) = delete;
+    Client& operator=(Client const&) = delete;
+
+    // Connect to host:port and upgrade on path (with its query, if any). False, with a warning
+    // logged and nothing left open, when the connect, TLS handshake or upgrade fails.
+    //
+    bool Connect(const char* host, int port, const char* path, ClientOptions const& options = {});
+
+    ConnectionBase* Get() const { return m_conn; }
+    ConnectionBase* operator->() const { return m_conn; }
+    explicit operator bool() const { return m_conn != nullptr; }
+
+    // The subprotocol the server picked, empty when none was asked for or given
+    //
+    std::string_view Protocol() const { return m_protocol; }
+
+    // Drop the connection without a closing handshake; Close(code) on it first for one
+    //
+    void Reset();
+
+  private:
+    std::optional<io::Descriptor>       m_desc;
+    std::optional<io::ssl::Connection>  m_ssl;
+    ConnectionBase*                     m_conn = nullptr;
+    std::string                         m_protocol;
+};
+
+} // namespace coop::ws
+} // namespace coop
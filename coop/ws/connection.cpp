@@ -1,11 +1,16 @@
 #include "connection.h"
+#include "mask.h"
 
 #include "coop/http/transport.h"
 #include "coop/http/tls_transport.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstring>
+#include <endian.h>
+#include <sys/random.h>
+#include <time.h>
 
 namespace coop
 {
@@ -38,6 +43,47 @@ ConnectionImpl<Derived>::ConnectionImpl(io::Descriptor& desc, Context* ctx,
 {
 }
 
+template<typename Derived>
+void ConnectionImpl<Derived>::EnableDeflate(DeflateParams const& params,
+                                            DeflateOptions const& options)
+{
+    m_deflate = params.enabled;
+    if (!m_deflate) return;
+
+    m_deflateWindowBits = params.serverMaxWindowBits;
+    m_deflateMinSize = options.minSize;
+    m_maxMessageSize = options.maxMessageSize;
+    m_deflater.Configure(params.serverMaxWindowBits, options.level, options.memLevel,
+                         params.serverNoContextTakeover);
+    m_inflater.Configure(params.clientMaxWindowBits, params.clientNoContextTakeover);
+}
+
+// The key only has to be unpredictable to whatever drives the payload (RFC 6455 10.3), so a
+// generator seeded once per connection serves; xorshift64* is never zero once seeded nonzero.
+//
+template<typename Derived>
+void ConnectionImpl<Derived>::SetClient()
+{
+    m_client = true;
+    if (getrandom(&m_maskState, sizeof(m_maskState), 0) != sizeof(m_maskState))
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        m_maskState = static_cast<uint64_t>(ts.tv_nsec) ^ reinterpret_cast<uintptr_t>(this);
+    }
+    m_maskState |= 1;
+}
+
+template<typename Derived>
+void ConnectionImpl<Derived>::NextMaskKey(uint8_t key[4])
+{
+    m_maskState ^= m_maskState >> 12;
+    m_maskState ^= m_maskState << 25;
+    m_maskState ^= m_maskState >> 27;
+    uint32_t k = static_cast<uint32_t>((m_maskState * 0x2545f4914f6cdd1dull) >> 32);
+    memcpy(key, &k, 4);
+}
+
 // ---------------------------------------------------------------------------
 // Buffer management
 // ---------------------------------------------------------------------------
@@ -108,6 +154,35 @@ bool ConnectionImpl<Derived>::Append(const void* data, size_t size)
     return true;
 }
 
+// A client's payload is masked on its way into the send buffer: one copy, as unmasked, with the
+// XOR done on bytes already in cache. The key runs on across buffer flushes.
+//
+template<typename Derived>
+bool ConnectionImpl<Derived>::AppendMasked(const void* data, size_t size, const uint8_t key[4])
+{
+    auto* p = static_cast<const char*>(data);
+    size_t offset = 0;
+
+    while (size > 0)
+    {
+        size_t space = SendBufSize() - m_sendLen;
+        if (space == 0)
+        {
+            if (!Flush()) return false;
+            space = SendBufSize();
+        }
+
+        size_t n = std::min(size, space);
+        char* out = SendBuf() + m_sendLen;
+        memcpy(out, p, n);
+        offset = detail::Unmask(out, n, key, offset);
+        m_sendLen += n;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
 template<typename Derived>
 bool ConnectionImpl<Derived>::Flush()
 {
@@ -135,7 +210,7 @@ Frame* ConnectionImpl<Derived>::NextFrame()
     // If mid-payload delivery, continue with the next chunk.
     //
     if (m_parseState == PAYLOAD && m_payloadRemaining > 0)
-        return DeliverPayloadChunk();
+        return m_frameCompressed ? DeliverInflatedChunk() : DeliverPayloadChunk();
 
     // Parse frame header. Need at least 2 bytes.
     //
@@ -148,6 +223,7 @@ Frame* ConnectionImpl<Derived>::NextFrame()
     uint8_t b1 = static_cast<uint8_t>(RecvBuf()[m_parsePos + 1]);
 
     bool fin    = (b0 & 0x80) != 0;
+    bool rsv1   = (b0 & 0x40) != 0;
     Opcode op   = static_cast<Opcode>(b0 & 0x0F);
     bool masked = (b1 & 0x80) != 0;
     size_t len7 = b1 & 0x7F;
@@ -174,20 +250,16 @@ Frame* ConnectionImpl<Derived>::NextFrame()
     }
     else if (len7 == 126)
     {
-        m_payloadLen = (static_cast<size_t>(
-                            static_cast<uint8_t>(RecvBuf()[m_parsePos])) << 8)
-                     | static_cast<size_t>(
-                            static_cast<uint8_t>(RecvBuf()[m_parsePos + 1]));
+        uint16_t len16;
+        memcpy(&len16, RecvBuf() + m_parsePos, sizeof(len16));
+        m_payloadLen = be16toh(len16);
         m_parsePos += 2;
     }
     else // 127
     {
-        m_payloadLen = 0;
-        for (int i = 0; i < 8; i++)
-        {
-            m_payloadLen = (m_payloadLen << 8)
-                         | static_cast<uint8_t>(RecvBuf()[m_parsePos + i]);
-        }
+        uint64_t len64;
+        memcpy(&len64, RecvBuf() + m_parsePos, sizeof(len64));
+        m_payloadLen = static_cast<size_t>(be64toh(len64));
         m_parsePos += 8;
     }
 
@@ -206,8 +278,18 @@ Frame* ConnectionImpl<Derived>::NextFrame()
     m_payloadRemaining = m_payloadLen;
     m_maskOffset = 0;
 
-    // Track opcode for continuation frames.
+    // Control frames carry at most 125 bytes and are never fragmented (RFC 6455 5.5)
     //
+    bool control = op != Opcode::Continuation && op != Opcode::Text && op != Opcode::Binary;
+    if (m_wholeFrames && control && (m_payloadLen > 125 || !fin))
+        return ProtocolError(1002);
+
+    // Track opcode for continuation frames. RSV1 marks a compressed message on its first frame
+    // only (RFC 7692 6), and only once permessage-deflate was negotiated.
+    //
+    if (rsv1 && (!m_deflate || control || op == Opcode::Continuation))
+        return ProtocolError(1002);
+
     if (op == Opcode::Continuation)
     {
         m_frame.opcode = m_continuationOpcode;
@@ -216,17 +298,27 @@ Frame* ConnectionImpl<Derived>::NextFrame()
     {
         m_frame.opcode = op;
         if (!fin) m_continuationOpcode = op;
+        m_messageCompressed = rsv1;
     }
     else
     {
         m_frame.opcode = op;
     }
+    m_frameCompressed = !control && m_messageCompressed;
 
     m_frame.fin = fin;
 
     if (op == Opcode::Close)
         m_gotClose = true;
 
+    // A compressed frame inflates even when empty: the final one feeds the stripped tail.
+    //
+    if (m_frameCompressed)
+    {
+        m_parseState = PAYLOAD;
+        return DeliverInflatedChunk();
+    }
+
     // Zero-length payload — return immediately.
     //
     if (m_payloadLen == 0)
@@ -249,6 +341,12 @@ Frame* ConnectionImpl<Derived>::NextFrame()
 template<typename Derived>
 Frame* ConnectionImpl<Derived>::DeliverPayloadChunk()
 {
+    if (!ReadWholeFrame())
+    {
+        m_parseState = DONE;
+        return nullptr;
+    }
+
     size_t avail = Available();
     if (avail == 0)
     {
@@ -264,11 +362,11 @@ Frame* ConnectionImpl<Derived>::DeliverPayloadChunk()
     size_t toDeliver = std::min(avail, m_payloadRemaining);
     char* data = RecvBuf() + m_parsePos;
 
-    // Unmask in-place (client frames are masked; server recv must unmask).
+    // Unmask in-place (client frames are masked; server recv must unmask). An unmasked frame
+    // leaves a zero key, which XORs to nothing.
     //
-    for (size_t i = 0; i < toDeliver; i++)
-        data[i] ^= static_cast<char>(m_maskKey[(m_maskOffset + i) & 3]);
-    m_maskOffset = (m_maskOffset + toDeliver) & 3;
+    if (m_maskKey[0] | m_maskKey[1] | m_maskKey[2] | m_maskKey[3])
+        m_maskOffset = detail::Unmask(data, toDeliver, m_maskKey, m_maskOffset);
 
     m_frame.data = data;
     m_frame.size = toDeliver;
@@ -282,6 +380,165 @@ Frame* ConnectionImpl<Derived>::DeliverPayloadChunk()
     return &m_frame;
 }
 
+// Compressed frames: each chunk of payload is unmasked and inflated into m_inflated, and the frame
+// points there. A chunk that inflates to nothing (a deflate block split across reads) is not
+// delivered; the next is read instead.
+//
+template<typename Derived>
+Frame* ConnectionImpl<Derived>::DeliverInflatedChunk()
+{
+    if (m_inflated.capacity() > 4 * RecvBufSize())
+        std::string().swap(m_inflated);
+    m_inflated.clear();
+
+    if (!ReadWholeFrame())
+    {
+        m_parseState = DONE;
+        return nullptr;
+    }
+
+    for (;;)
+    {
+        char* data = nullptr;
+        size_t n = 0;
+        if (m_payloadRemaining > 0)
+        {
+            if (Available() == 0)
+            {
+                Compact();
+                if (RecvMore() <= 0)
+                {
+                    m_parseState = DONE;
+                    return nullptr;
+                }
+            }
+            n = std::min(Available(), m_payloadRemaining);
+            data = RecvBuf() + m_parsePos;
+            if (m_maskKey[0] | m_maskKey[1] | m_maskKey[2] | m_maskKey[3])
+                m_maskOffset = detail::Unmask(data, n, m_maskKey, m_maskOffset);
+            m_payloadRemaining -= n;
+            m_parsePos += n;
+        }
+
+        bool frameDone = m_payloadRemaining == 0;
+        bool last = frameDone && m_frame.fin;
+        int err = m_inflater.Inflate(data, n, last, &m_inflated, m_maxMessageSize);
+        if (err < 0)
+            return ProtocolError(err == -EMSGSIZE ? 1009 : 1007);
+        if (last)
+            m_messageCompressed = false;
+
+        if (frameDone || !m_inflated.empty())
+        {
+            m_frame.data = m_inflated.data();
+            m_frame.size = m_inflated.size();
+            m_frame.complete = frameDone;
+            if (frameDone)
+                m_parseState = HEADER;
+            return &m_frame;
+        }
+    }
+}
+
+// Message mode: the rest of a frame that fits the recv buffer is read in before any of it is
+// delivered, moving what is buffered to the front first if the frame would run off the end. A
+// frame bigger than the buffer is delivered as it comes, as in frame mode.
+//
+template<typename Derived>
+bool ConnectionImpl<Derived>::ReadWholeFrame()
+{
+    if (!m_wholeFrames || m_payloadRemaining > RecvBufSize())
+        return true;
+
+    while (Available() < m_payloadRemaining)
+    {
+        if (m_parsePos + m_payloadRemaining > RecvBufSize())
+            Compact();
+        if (RecvMore() <= 0)
+            return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Message mode — NextMessage()
+// ---------------------------------------------------------------------------
+
+template<typename Derived>
+Message* ConnectionImpl<Derived>::DeliverMessage(Opcode opcode, const void* data, size_t size)
+{
+    m_messageView.opcode = opcode;
+    m_messageView.data = data;
+    m_messageView.size = size;
+    return &m_messageView;
+}
+
+// A data message that arrives as one frame, read whole, is a view of that frame where it lies:
+// the recv buffer, or m_inflated when compressed. Anything else -- fragments, or a frame longer
+// than the recv buffer -- is appended to m_message chunk by chunk. m_message grows to the size
+// of the frame being appended at once, doubling at least, and keeps its capacity from message to
+// message unless a large buffer is left mostly idle by the next one.
+//
+template<typename Derived>
+Message* ConnectionImpl<Derived>::NextMessage()
+{
+    m_wholeFrames = true;
+    if (!m_assembling)
+    {
+        if (m_message.capacity() > 4 * RecvBufSize() && m_message.size() < m_message.capacity() / 4)
+            std::string().swap(m_message);
+        m_message.clear();
+    }
+
+    while (Frame* frame = NextFrame())
+    {
+        if (frame->IsClose() || frame->IsPing() || frame->IsPong())
+            return DeliverMessage(frame->opcode, frame->data, frame->size);
+
+        // Compressed, what is left of the frame says little about what it inflates to
+        //
+        size_t total = m_assembling ? m_message.size() + frame->size : frame->size;
+        size_t need = total + (m_frameCompressed ? 0 : m_payloadRemaining);
+        if (m_maxMessageSize && need > m_maxMessageSize)
+        {
+            m_assembling = false;
+            ProtocolError(1009);
+            return nullptr;
+        }
+
+        if (!m_assembling && frame->fin && frame->complete)
+            return DeliverMessage(frame->opcode, frame->data, frame->size);
+
+        if (!m_assembling)
+        {
+            m_assembling = true;
+            m_message.clear();
+        }
+        if (need > m_message.capacity())
+            m_message.reserve(std::max(need, 2 * m_message.capacity()));
+        m_message.append(static_cast<const char*>(frame->data), frame->size);
+
+        if (frame->fin && frame->complete)
+        {
+            m_assembling = false;
+            return DeliverMessage(frame->opcode, m_message.data(), m_message.size());
+        }
+    }
+    m_assembling = false;
+    return nullptr;
+}
+
+// Close with code and stop parsing: the peer broke the protocol (1002), sent data that would not
+// inflate (1007), or a message too big to inflate (1009)
+//
+template<typename Derived>
+Frame* ConnectionImpl<Derived>::ProtocolError(uint16_t code)
+{
+    Close(code);
+    m_parseState = DONE;
+    return nullptr;
+}
+
 // ---------------------------------------------------------------------------
 // SkipPayload
 // ---------------------------------------------------------------------------
@@ -289,6 +546,13 @@ Frame* ConnectionImpl<Derived>::DeliverPayloadChunk()
 template<typename Derived>
 void ConnectionImpl<Derived>::SkipPayload()
 {
+    // A compressed frame must still pass through the inflater, whose window later messages
+    // may refer back into
+    //
+    while (m_parseState == PAYLOAD && m_frameCompressed && m_payloadRemaining > 0)
+    {
+        if (!DeliverInflatedChunk()) return;
+    }
     while (m_parseState == PAYLOAD && m_payloadRemaining > 0)
     {
         size_t avail = Available();
@@ -313,34 +577,24 @@ void ConnectionImpl<Derived>::SkipPayload()
 
 template<typename Derived>
 bool ConnectionImpl<Derived>::SendFrame(Opcode opcode, bool fin,
-                                         const void* payload, size_t size)
+                                         const void* payload, size_t size, bool rsv1)
 {
     if (m_sendError) return false;
 
-    // Server frames are unmasked (RFC 6455 Section 5.1).
+    // Server frames are unmasked, client frames masked (RFC 6455 Section 5.1).
     //
-    uint8_t header[10];
-    size_t headerLen = 2;
+    uint8_t header[14];
+    size_t headerLen = detail::EncodeFrameHeader(header, opcode, fin, size, rsv1);
 
-    header[0] = (fin ? 0x80 : 0x00) | static_cast<uint8_t>(opcode);
-
-    if (size <= 125)
-    {
-        header[1] = static_cast<uint8_t>(size);
-    }
-    else if (size <= 65535)
-    {
-        header[1] = 126;
-        header[2] = static_cast<uint8_t>(size >> 8);
-        header[3] = static_cast<uint8_t>(size);
-        headerLen = 4;
-    }
-    else
+    if (m_client)
     {
-        header[1] = 127;
-        for (int i = 0; i < 8; i++)
-            header[2 + i] = static_cast<uint8_t>(size >> (56 - 8 * i));
-        headerLen = 10;
+        uint8_t key[4];
+        NextMaskKey(key);
+        header[1] |= 0x80;
+        memcpy(header + headerLen, key, 4);
+        if (!Append(header, headerLen + 4)) return false;
+        if (size > 0 && !AppendMasked(payload, size, key)) return false;
+        return Flush();
     }
 
     if (!Append(header, headerLen)) return false;
@@ -348,16 +602,57 @@ bool ConnectionImpl<Derived>::SendFrame(Opcode opcode, bool fin,
     return Flush();
 }
 
+// A whole data message, compressed when negotiated, big enough, and smaller for it. A message
+// compressed and then sent as is leaves history the peer never saw, so the deflater forgets it.
+//
+template<typename Derived>
+bool ConnectionImpl<Derived>::SendMessage(Opcode opcode, const void* data, size_t size)
+{
+    if (m_deflate && size >= m_deflateMinSize && !m_sendError)
+    {
+        m_compressed.clear();
+        if (m_deflater.Compress(data, size, &m_compressed))
+        {
+            if (m_compressed.size() < size)
+            {
+                bool ok = SendFrame(opcode, true, m_compressed.data(), m_compressed.size(), true);
+                if (m_compressed.capacity() > 4 * SendBufSize())
+                    std::string().swap(m_compressed);
+                return ok;
+            }
+            m_deflater.Reset();
+        }
+    }
+    return SendFrame(opcode, true, data, size);
+}
+
+// Frames encoded elsewhere go out behind anything already buffered, in one send
+//
+template<typename Derived>
+bool ConnectionImpl<Derived>::SendEncoded(const void* data, size_t size, bool compressed)
+{
+    assert(!m_client);  // shared frames are unmasked: server to client only
+    if (m_sendError || !Flush()) return false;
+    if (compressed)
+        m_deflater.Reset();
+    if (TransportSendAll(data, size) < 0)
+    {
+        m_sendError = true;
+        return false;
+    }
+    return true;
+}
+
 template<typename Derived>
 bool ConnectionImpl<Derived>::SendText(const void* data, size_t size)
 {
-    return SendFrame(Opcode::Text, true, data, size);
+    return SendMessage(Opcode::Text, data, size);
 }
 
 template<typename Derived>
 bool ConnectionImpl<Derived>::SendBinary(const void* data, size_t size)
 {
-    return SendFrame(Opcode::Binary, true, data, size);
+    return SendMessage(Opcode::Binary, data, size);
 }
 
 template<typename Derived>
@@ -3,8 +3,11 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <string>
 
+#include "deflate.h"
 #include "types.h"
+#include "coop/memory_accounting.h"
 #include "coop/io/descriptor.h"
 #include "coop/time/interval.h"
 
@@ -38,6 +41,16 @@ struct ConnectionBase
     //
     virtual Frame* NextFrame() = 0;
 
+    // Message mode, in place of NextFrame: the next whole message, fragments joined, or a
+    // control frame (which may arrive between a message's fragments, and comes first). A frame
+    // that fits the recv buffer is read into it whole, so an unfragmented message of up to
+    // recvBufSize bytes is a view of the buffer, never copied. Longer or fragmented messages are
+    // copied once, as they arrive, into a buffer the connection keeps from message to message,
+    // reserved once to a long frame's length. Null as NextFrame, or when a message outgrows
+    // SetMaxMessageSize (closed with 1009). Do not mix with NextFrame within a message.
+    //
+    virtual Message* NextMessage() = 0;
+
     // Skip the remaining payload of the current frame (if partially consumed).
     //
     virtual void SkipPayload() = 0;
@@ -52,6 +65,15 @@ struct ConnectionBase
 
     virtual bool SendError() const = 0;
     virtual io::Descriptor& GetDescriptor() = 0;
+
+    // For ws::Broadcast, which encodes a frame once for many connections: the LZ77 window our
+    // compressed messages may use (0 without permessage-deflate), and a send of whole frames
+    // already encoded. compressed says one of them is a message compressed from an empty window
+    // elsewhere, after which our own deflater forgets its history -- the peer's window now holds
+    // bytes it never saw.
+    //
+    virtual int DeflateWindowBits() const = 0;
+    virtual bool SendEncoded(const void* data, size_t size, bool compressed) = 0;
 };
 
 // ConnectionImpl<Derived> is the CRTP frame parser. All parsing state lives here; buffer and
@@ -65,6 +87,7 @@ struct ConnectionImpl : ConnectionBase
     ConnectionImpl(io::Descriptor& desc, Context* ctx, time::Interval timeout);
 
     Frame* NextFrame() override;
+    Message* NextMessage() override;
     void SkipPayload() override;
     bool SendText(const void* data, size_t size) override;
     bool SendBinary(const void* data, size_t size) override;
@@ -73,11 +96,31 @@ struct ConnectionImpl : ConnectionBase
     bool Close(uint16_t code) override;
     bool SendError() const override { return m_sendError; }
     io::Descriptor& GetDescriptor() override { return m_desc; }
+    int DeflateWindowBits() const override { return m_deflate ? m_deflateWindowBits : 0; }
+    bool SendEncoded(const void* data, size_t size, bool compressed) override;
 
     // Called by Upgrade() to seed the recv buffer with leftover HTTP data.
     //
     void SetInitialRecvData(size_t n) { m_bufLen = n; }
 
+    // Apply the permessage-deflate parameters Upgrade negotiated (nothing if !params.enabled),
+    // with the options it negotiated them under. Compressed messages then arrive inflated: a
+    // Frame's data is the inflated bytes of its chunk, held until the next NextFrame. SendText
+    // and SendBinary compress messages of options.minSize and up; control frames never are.
+    //
+    void EnableDeflate(DeflateParams const& params, DeflateOptions const& options = {});
+
+    // The client's side of the protocol (client.h): every frame sent is masked (RFC 6455 5.3),
+    // with a key drawn per frame from a generator seeded from getrandom, and the payload masked
+    // as it is copied into the send buffer. Frames received are expected unmasked.
+    //
+    void SetClient();
+
+    // The largest message NextMessage assembles, and permessage-deflate inflates; 0 for no
+    // limit. EnableDeflate sets its options.maxMessageSize, so call this after it.
+    //
+    void SetMaxMessageSize(size_t size) { m_maxMessageSize = size; }
+
   private:
     // CRTP buffer access
     //
@@ -110,12 +153,19 @@ struct ConnectionImpl : ConnectionBase
     // Write buffer
     //
     bool Append(const void* data, size_t size);
+    bool AppendMasked(const void* data, size_t size, const uint8_t key[4]);
     bool Flush();
+    void NextMaskKey(uint8_t key[4]);
 
     // Frame parser
     //
     Frame* DeliverPayloadChunk();
-    bool SendFrame(Opcode opcode, bool fin, const void* payload, size_t size);
+    Frame* DeliverInflatedChunk();
+    bool ReadWholeFrame();
+    Message* DeliverMessage(Opcode opcode, const void* data, size_t size);
+    bool SendFrame(Opcode opcode, bool fin, const void* payload, size_t size, bool rsv1 = false);
+    bool SendMessage(Opcode opcode, const void* data, size_t size);
+    Frame* ProtocolError(uint16_t code);
 
     io::Descriptor& m_desc;
     Context*        m_ctx;
@@ -144,6 +194,32 @@ struct ConnectionImpl : ConnectionBase
     bool            m_gotClose;
     bool            m_sentClose;
     bool            m_sendError;
+
+    // Client role
+    //
+    bool            m_client = false;
+    uint64_t        m_maskState = 0;
+
+    // Message mode: m_wholeFrames reads a frame that fits whole before delivering it; a message
+    // being assembled is in m_message
+    //
+    bool            m_wholeFrames = false;
+    bool            m_assembling = false;
+    Message         m_messageView{};
+    std::string     m_message;
+
+    // permessage-deflate
+    //
+    bool                    m_deflate = false;
+    bool                    m_messageCompressed = false;    // the data message in progress
+    bool                    m_frameCompressed = false;      // the frame being delivered
+    int                     m_deflateWindowBits = 15;
+    size_t                  m_deflateMinSize = 0;
+    size_t                  m_maxMessageSize = 0;
+    detail::MessageDeflater m_deflater;
+    detail::MessageInflater m_inflater;
+    std::string             m_inflated;     // the current compressed chunk, inflated
+    std::string             m_compressed;   // the message being sent, compressed
 };
 
 // Connection<Transport> is the final concrete WebSocket connection. The transport parameter
@@ -172,6 +248,7 @@ struct Connection final : ConnectionImpl<Connection<Transport>>
     , m_recvBufSize(recvBufSize)
     , m_sendBufSize(sendBufSize)
     {
+        AccountMemory(MemoryTag::WsConnection, Bytes(), 1);
         if (initialData && initialDataSize > 0 && initialDataSize <= recvBufSize)
         {
             memcpy(m_buf, initialData, initialDataSize);
@@ -179,6 +256,13 @@ struct Connection final : ConnectionImpl<Connection<Transport>>
         }
     }
 
+    ~Connection()
+    {
+        AccountMemory(MemoryTag::WsConnection, -Bytes(), -1);
+    }
+
+    int64_t Bytes() const { return sizeof(Connection) + m_recvBufSize + m_sendBufSize; }
+
     int DoRecv(void* buf, size_t size, int flags, time::Interval timeout)
     {
         return m_transport.Recv(buf, size, flags, timeout);
@@ -0,0 +1,531 @@
+#include "deflate.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <strings.h>
+#include <vector>
+
+#include <zlib.h>
+
+#include "coop/cooperator.h"
+#include "coop/cooperator_var.h"
+#include "coop/cooperator_var.hpp"
+
+namespace coop
+{
+namespace ws
+{
+
+namespace
+{
+
+// Idle streams kept per cooperator and direction. A burst beyond this frees its extras.
+//
+constexpr size_t kPoolMax = 16;
+
+// The empty stored block a sync flush ends on, which the sender strips (RFC 7692 7.2.1)
+//
+constexpr unsigned char kTail[4] = {0x00, 0x00, 0xff, 0xff};
+
+struct Deflater
+{
+    z_stream    strm{};
+    int         windowBits = 15;
+    int         memLevel = 8;
+    int         level = 5;
+};
+
+struct StreamPool
+{
+    ~StreamPool()
+    {
+        for (auto* d : deflaters)
+        {
+            deflateEnd(&d->strm);
+            delete d;
+        }
+        for (auto* strm : inflaters)
+        {
+            inflateEnd(strm);
+            delete strm;
+        }
+    }
+
+    std::vector<Deflater*>  deflaters;
+    std::vector<z_stream*>  inflaters;
+};
+
+CooperatorVar<StreamPool> s_streams;
+
+// The calling cooperator's pool, or none off-cooperator: streams are then created and freed per
+// use
+//
+StreamPool* Pool()
+{
+    return Cooperator::thread_cooperator ? &*s_streams : nullptr;
+}
+
+Deflater* AcquireDeflater(int windowBits, int level, int memLevel)
+{
+    if (auto* pool = Pool())
+    {
+        auto& idle = pool->deflaters;
+        for (size_t i = idle.size(); i-- > 0;)
+        {
+            Deflater* d = idle[i];
+            if (d->windowBits != windowBits || d->memLevel != memLevel)
+            {
+                continue;
+            }
+            idle.erase(idle.begin() + static_cast<ptrdiff_t>(i));
+            if (deflateReset(&d->strm) == Z_OK &&
+                (d->level == level ||
+                 deflateParams(&d->strm, level, Z_DEFAULT_STRATEGY) == Z_OK))
+            {
+                d->level = level;
+                return d;
+            }
+            deflateEnd(&d->strm);
+            delete d;
+            break;
+        }
+    }
+
+    auto* d = new Deflater;
+    if (deflateInit2(&d->strm, level, Z_DEFLATED, -windowBits, memLevel,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        delete d;
+        return nullptr;
+    }
+    d->windowBits = windowBits;
+    d->memLevel = memLevel;
+    d->level = level;
+    return d;
+}
+
+void ReleaseDeflater(Deflater* d)
+{
+    auto* pool = Pool();
+    if (pool && pool->deflaters.size() < kPoolMax)
+    {
+        pool->deflaters.push_back(d);
+        return;
+    }
+    deflateEnd(&d->strm);
+    delete d;
+}
+
+z_stream* AcquireInflater(int windowBits)
+{
+    auto* pool = Pool();
+    if (pool && !pool->inflaters.empty())
+    {
+        z_stream* strm = pool->inflaters.back();
+        pool->inflaters.pop_back();
+        if (inflateReset2(strm, -windowBits) == Z_OK)
+        {
+            return strm;
+        }
+        inflateEnd(strm);
+        delete strm;
+    }
+
+    auto* strm = new z_stream{};
+    if (inflateInit2(strm, -windowBits) != Z_OK)
+    {
+        delete strm;
+        return nullptr;
+    }
+    return strm;
+}
+
+void ReleaseInflater(z_stream* strm)
+{
+    auto* pool = Pool();
+    if (pool && pool->inflaters.size() < kPoolMax)
+    {
+        pool->inflaters.push_back(strm);
+        return;
+    }
+    inflateEnd(strm);
+    delete strm;
+}
+
+std::string_view Trim(std::string_view s)
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+    {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+    {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+bool TokenIs(std::string_view token, const char* name)
+{
+    return token.size() == strlen(name) && strncasecmp(token.data(), name, token.size()) == 0;
+}
+
+// A window-bits value, 8 to 15, possibly quoted (RFC 7692 7.1.2); -1 if malformed
+//
+int WindowBits(std::string_view value)
+{
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+    {
+        value = value.substr(1, value.size() - 2);
+    }
+    if (value.size() == 1 && value[0] >= '8' && value[0] <= '9')
+    {
+        return value[0] - '0';
+    }
+    if (value.size() == 2 && value[0] == '1' && value[1] >= '0' && value[1] <= '5')
+    {
+        return 10 + (value[1] - '0');
+    }
+    return -1;
+}
+
+// One offer's parameters, after "permessage-deflate". False if malformed (a repeated or unknown
+// parameter, a bad value) or beyond what we can do.
+//
+bool NegotiateOffer(std::string_view params, DeflateOptions const& options,
+                    DeflateParams* out)
+{
+    bool serverNoContext = false;
+    bool clientNoContext = false;
+    int serverBits = 0;         // 0 = not offered
+    int clientBits = 0;         // 0 = not offered, -1 = offered without a value
+
+    while (!params.empty())
+    {
+        size_t semi = params.find(';');
+        auto param = Trim(params.substr(0, semi));
+        params = semi == std::string_view::npos ? std::string_view() : params.substr(semi + 1);
+        if (param.empty())
+        {
+            continue;
+        }
+
+        size_t eq = param.find('=');
+        auto name = Trim(param.substr(0, eq));
+        auto value = eq == std::string_view::npos ? std::string_view()
+                                                  : Trim(param.substr(eq + 1));
+        bool hasValue = eq != std::string_view::npos;
+
+        if (TokenIs(name, "server_no_context_takeover"))
+        {
+            if (serverNoContext || hasValue) return false;
+            serverNoContext = true;
+        }
+        else if (TokenIs(name, "client_no_context_takeover"))
+        {
+            if (clientNoContext || hasValue) return false;
+            clientNoContext = true;
+        }
+        else if (TokenIs(name, "server_max_window_bits"))
+        {
+            if (serverBits != 0) return false;
+            serverBits = WindowBits(value);
+            if (serverBits < 0) return false;
+        }
+        else if (TokenIs(name, "client_max_window_bits"))
+        {
+            if (clientBits != 0) return false;
+            clientBits = hasValue ? WindowBits(value) : -1;
+            if (hasValue && clientBits < 0) return false;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    int ours = std::clamp(options.serverMaxWindowBits, 9, 15);
+    if (serverBits != 0)
+    {
+        if (serverBits < 9)
+        {
+            return false;
+        }
+        ours = std::min(ours, serverBits);
+    }
+
+    *out = DeflateParams{};
+    out->enabled = true;
+    out->serverNoContextTakeover = serverNoContext || options.serverNoContextTakeover;
+    out->clientNoContextTakeover = clientNoContext || options.clientNoContextTakeover;
+    out->serverMaxWindowBits = static_cast<uint8_t>(ours);
+    if (clientBits != 0)
+    {
+        int theirs = std::clamp(options.clientMaxWindowBits, 8, 15);
+        if (clientBits > 0)
+        {
+            theirs = std::min(theirs, clientBits);
+        }
+        out->clientMaxWindowBits = static_cast<uint8_t>(theirs);
+        out->clientMaxWindowBitsSent = true;
+    }
+    return true;
+}
+
+} // end anonymous namespace
+
+bool NegotiateDeflate(std::string_view offers, DeflateOptions const& options,
+                      DeflateParams* params)
+{
+    while (!offers.empty())
+    {
+        size_t comma = offers.find(',');
+        auto offer = offers.substr(0, comma);
+        offers = comma == std::string_view::npos ? std::string_view() : offers.substr(comma + 1);
+
+        size_t semi = offer.find(';');
+        if (!TokenIs(Trim(offer.substr(0, semi)), "permessage-deflate"))
+        {
+            continue;
+        }
+        auto rest = semi == std::string_view::npos ? std::string_view() : offer.substr(semi + 1);
+        if (NegotiateOffer(rest, options, params))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string DeflateResponse(DeflateParams const& params)
+{
+    std::string out = "permessage-deflate";
+    if (params.serverNoContextTakeover)
+    {
+        out += "; server_no_context_takeover";
+    }
+    if (params.clientNoContextTakeover)
+    {
+        out += "; client_no_context_takeover";
+    }
+    if (params.serverMaxWindowBits < 15)
+    {
+        out += "; server_max_window_bits=" + std::to_string(params.serverMaxWindowBits);
+    }
+    if (params.clientMaxWindowBitsSent)
+    {
+        out += "; client_max_window_bits=" + std::to_string(params.clientMaxWindowBits);
+    }
+    return out;
+}
+
+namespace detail
+{
+
+// -----------------------------------------------------------------------------
+// MessageDeflater
+// -----------------------------------------------------------------------------
+
+void MessageDeflater::Configure(int windowBits, int level, int memLevel, bool noContextTakeover)
+{
+    End();
+    m_windowBits = std::clamp(windowBits, 9, 15);
+    m_level = std::clamp(level, 0, 9);
+    m_memLevel = std::clamp(memLevel, 1, 9);
+    m_noContextTakeover = noContextTakeover;
+}
+
+bool MessageDeflater::Compress(const void* data, size_t size, std::string* out)
+{
+    if (!m_stream)
+    {
+        m_stream = AcquireDeflater(m_windowBits, m_level, m_memLevel);
+        if (!m_stream)
+        {
+            return false;
+        }
+    }
+
+    auto* strm = &static_cast<Deflater*>(m_stream)->strm;
+    strm->next_in = static_cast<Bytef*>(const_cast<void*>(data));
+    strm->avail_in = static_cast<uInt>(size);
+    size_t start = out->size();
+    bool ok = true;
+    for (;;)
+    {
+        size_t chunk = deflateBound(strm, strm->avail_in) + 64;
+        size_t at = out->size();
+        out->resize(at + chunk);
+        strm->next_out = reinterpret_cast<Bytef*>(out->data() + at);
+        strm->avail_out = static_cast<uInt>(chunk);
+        int result = deflate(strm, Z_SYNC_FLUSH);
+        out->resize(at + chunk - strm->avail_out);
+        if (result == Z_STREAM_ERROR)
+        {
+            ok = false;
+            break;
+        }
+        if (strm->avail_in == 0 && strm->avail_out > 0)
+        {
+            break;
+        }
+    }
+
+    if (ok && out->size() - start >= sizeof(kTail) &&
+        memcmp(out->data() + out->size() - sizeof(kTail), kTail, sizeof(kTail)) == 0)
+    {
+        out->resize(out->size() - sizeof(kTail));
+    }
+    else
+    {
+        ok = false;
+    }
+
+    if (!ok || m_noContextTakeover)
+    {
+        Reset();
+    }
+    return ok;
+}
+
+void MessageDeflater::Reset()
+{
+    if (!m_stream)
+    {
+        return;
+    }
+    if (m_noContextTakeover)
+    {
+        End();
+        return;
+    }
+    deflateReset(&static_cast<Deflater*>(m_stream)->strm);
+}
+
+void MessageDeflater::End()
+{
+    if (m_stream)
+    {
+        ReleaseDeflater(static_cast<Deflater*>(m_stream));
+        m_stream = nullptr;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// MessageInflater
+// -----------------------------------------------------------------------------
+
+void MessageInflater::Configure(int windowBits, bool noContextTakeover)
+{
+    End();
+
+    // An inflater with a wider window reads anything a narrower one wrote; zlib's raw inflate
+    // starts at 9 bits
+    //
+    m_windowBits = std::clamp(windowBits, 9, 15);
+    m_noContextTakeover = noContextTakeover;
+}
+
+int MessageInflater::Inflate(const void* data, size_t size, bool last, std::string* out,
+                             size_t limit)
+{
+    if (!m_stream)
+    {
+        m_stream = AcquireInflater(m_windowBits);
+        if (!m_stream)
+        {
+            return -ENOMEM;
+        }
+    }
+
+    int result = Run(data, size, out, limit);
+    if (result == 0 && last)
+    {
+        result = Run(kTail, sizeof(kTail), out, limit);
+    }
+    if (result < 0)
+    {
+        // The stream is mid-message and useless: drop it rather than pool it
+        //
+        auto* strm = static_cast<z_stream*>(m_stream);
+        inflateEnd(strm);
+        delete strm;
+        m_stream = nullptr;
+        m_messageSize = 0;
+        return result;
+    }
+    if (last)
+    {
+        m_messageSize = 0;
+        if (m_noContextTakeover)
+        {
+            End();
+        }
+    }
+    return 0;
+}
+
+int MessageInflater::Run(const void* data, size_t size, std::string* out, size_t limit)
+{
+    auto* strm = static_cast<z_stream*>(m_stream);
+    strm->next_in = static_cast<Bytef*>(const_cast<void*>(data));
+    strm->avail_in = static_cast<uInt>(size);
+    for (;;)
+    {
+        size_t chunk = std::max<size_t>(size * 4, 4096);
+        size_t at = out->size();
+        out->resize(at + chunk);
+        strm->next_out = reinterpret_cast<Bytef*>(out->data() + at);
+        strm->avail_out = static_cast<uInt>(chunk);
+        int result = inflate(strm, Z_SYNC_FLUSH);
+        size_t produced = chunk - strm->avail_out;
+        out->resize(at + produced);
+
+        m_messageSize += produced;
+        if (m_messageSize > limit)
+        {
+            return -EMSGSIZE;
+        }
+
+        if (result == Z_STREAM_END)
+        {
+            // A final block: whatever follows starts a fresh stream with no history
+            //
+            if (inflateReset(strm) != Z_OK)
+            {
+                return -EINVAL;
+            }
+            if (strm->avail_in == 0)
+            {
+                return 0;
+            }
+            continue;
+        }
+        if (result != Z_OK && result != Z_BUF_ERROR)
+        {
+            return -EINVAL;
+        }
+        if (strm->avail_in == 0 && strm->avail_out > 0)
+        {
+            return 0;
+        }
+        if (result == Z_BUF_ERROR && strm->avail_out > 0)
+        {
+            return -EINVAL;
+        }
+    }
+}
+
+void MessageInflater::End()
+{
+    if (m_stream)
+    {
+        ReleaseInflater(static_cast<z_stream*>(m_stream));
+        m_stream = nullptr;
+    }
+}
+
+} // end namespace coop::ws::detail
+} // namespace coop::ws
+} // namespace coop
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace coop
+{
+namespace ws
+{
+
+// permessage-deflate (RFC 7692) policy for the server side of Upgrade. Each side keeps a zlib
+// stream across messages unless it runs without context takeover: a deflater at the defaults
+// holds about 256KB, an inflater about 44KB (the window plus zlib's own). Without context
+// takeover a side borrows its stream from a per-cooperator pool for one message at a time, so an
+// idle connection holds none -- at some cost in ratio on small, repetitive messages.
+//
+struct DeflateOptions
+{
+    // Ask the client to begin every message with an empty window, so its messages inflate on a
+    // borrowed stream (granted regardless when the client offers it)
+    //
+    bool clientNoContextTakeover = false;
+
+    // Compress each of our messages with an empty window on a borrowed stream (forced when the
+    // client asks for server_no_context_takeover)
+    //
+    bool serverNoContextTakeover = false;
+
+    // LZ77 window for our messages, 9 to 15: a deflater costs 4 << bits bytes plus 512 << memLevel.
+    // zlib has no raw 8-bit window, so an offer capping us at 8 is declined.
+    //
+    int serverMaxWindowBits = 15;
+
+    // Window asked of the client when its offer carries client_max_window_bits (without it the
+    // client may use 15). Shrinks the inflater we keep by the same measure.
+    //
+    int clientMaxWindowBits = 15;
+
+    // Messages smaller than this go out uncompressed, as do those compression would not shrink
+    //
+    size_t minSize = 256;
+
+    int level = 5;
+    int memLevel = 8;
+
+    // Largest inflated message we accept; past it the connection closes with 1009 (message too
+    // big). A deflate stream inflates up to about 1000:1.
+    //
+    size_t maxMessageSize = 16 << 20;
+};
+
+// What Upgrade settled on, and what Connection::EnableDeflate applies
+//
+struct DeflateParams
+{
+    bool        enabled = false;
+    bool        serverNoContextTakeover = false;
+    bool        clientNoContextTakeover = false;
+    bool        clientMaxWindowBitsSent = false;    // the response carries client_max_window_bits
+    uint8_t     serverMaxWindowBits = 15;
+    uint8_t     clientMaxWindowBits = 15;
+};
+
+// Accept the first permessage-deflate offer in a Sec-WebSocket-Extensions value that is well
+// formed and within options. True, filling *params, if one was; offers of other extensions and
+// malformed or unsatisfiable ones are skipped.
+//
+bool NegotiateDeflate(std::string_view offers, DeflateOptions const& options,
+                      DeflateParams* params);
+
+// The Sec-WebSocket-Extensions response value for params: "permessage-deflate; ..."
+//
+std::string DeflateResponse(DeflateParams const& params);
+
+namespace detail
+{
+
+// Our side of a connection's compression. The stream is drawn from the cooperator's pool on the
+// first message compressed, and returned after each message without context takeover, or at End.
+//
+struct MessageDeflater
+{
+    MessageDeflater() = default;
+    ~MessageDeflater() { End(); }
+
+    MessageDeflater(MessageDeflater const&) = delete;
+    MessageDeflater& operator=(MessageDeflater const&) = delete;
+
+    void Configure(int windowBits, int level, int memLevel, bool noContextTakeover);
+
+    // Compress one whole message, appending it to *out without the trailing 00 00 ff ff (RFC 7692
+    // 7.2.1). False on a coder error.
+    //
+    bool Compress(const void* data, size_t size, std::string* out);
+
+    // Forget the history: the next message refers to nothing before it. For a compressed message
+    // that was then sent uncompressed, which the peer's window never saw.
+    //
+    void Reset();
+
+    void End();
+
+  private:
+    void*   m_stream = nullptr;
+    int     m_windowBits = 15;
+    int     m_level = 5;
+    int     m_memLevel = 8;
+    bool    m_noContextTakeover = false;
+};
+
+// The peer's side: inflates a compressed message chunk by chunk as NextFrame delivers it
+//
+struct MessageInflater
+{
+    MessageInflater() = default;
+    ~MessageInflater() { End(); }
+
+    MessageInflater(MessageInflater const&) = delete;
+    MessageInflater& operator=(MessageInflater const&) = delete;
+
+    void Configure(int windowBits, bool noContextTakeover);
+
+    // Inflate a chunk of the current message, appending to *out. last marks the message's final
+    // chunk, after which the stripped tail is fed and the message ends. Returns 0, -EINVAL on
+    // corrupt data, or -EMSGSIZE once the message inflates past limit.
+    //
+    int Inflate(const void* data, size_t size, bool last, std::string* out, size_t limit);
+
+    void End();
+
+  private:
+    int Run(const void* data, size_t size, std::string* out, size_t limit);
+
+    void*   m_stream = nullptr;
+    size_t  m_messageSize = 0;
+    int     m_windowBits = 15;
+    bool    m_noContextTakeover = false;
+};
+
+} // end namespace coop::ws::detail
+} // namespace coop::ws
+} // namespace coop
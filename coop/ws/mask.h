@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace coop
+{
+namespace ws
+{
+namespace detail
+{
+
+// Payload unmasking (RFC 6455 5.3): XOR [p, p + n) in place with the 4-byte masking key, the first
+// byte taking key[offset & 3]. Returns the offset for the byte after, so a payload delivered in
+// chunks unmasks chunk by chunk.
+//
+// The vector path rotates the key to the chunk's phase once and broadcasts it: every stride is a
+// multiple of four, so the phase never changes inside the loop. 64 bytes per iteration (two AVX2
+// registers when the build targets it, else four SSE2/NEON ones -- both are the baseline of their
+// architectures), then 16 at a time, then 8 in a word, then the scalar tail. Loads and stores are
+// unaligned: a chunk starts wherever the frame header left it in the receive buffer.
+//
+inline size_t UnmaskScalar(char* p, size_t n, const uint8_t key[4], size_t offset)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        p[i] ^= static_cast<char>(key[(offset + i) & 3]);
+    }
+    return (offset + n) & 3;
+}
+
+inline size_t Unmask(char* p, size_t n, const uint8_t key[4], size_t offset)
+{
+    uint8_t rotated[4];
+    for (size_t i = 0; i < 4; i++)
+    {
+        rotated[i] = key[(offset + i) & 3];
+    }
+    uint32_t k32;
+    memcpy(&k32, rotated, sizeof(k32));
+
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    __m256i k256 = _mm256_set1_epi32(static_cast<int>(k32));
+    for (; i + 64 <= n; i += 64)
+    {
+        __m256i* v = reinterpret_cast<__m256i*>(p + i);
+        _mm256_storeu_si256(v, _mm256_xor_si256(_mm256_loadu_si256(v), k256));
+        _mm256_storeu_si256(v + 1, _mm256_xor_si256(_mm256_loadu_si256(v + 1), k256));
+    }
+    __m128i k128 = _mm256_castsi256_si128(k256);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i* v = reinterpret_cast<__m128i*>(p + i);
+        _mm_storeu_si128(v, _mm_xor_si128(_mm_loadu_si128(v), k128));
+    }
+#elif defined(__SSE2__)
+    __m128i k128 = _mm_set1_epi32(static_cast<int>(k32));
+    for (; i + 64 <= n; i += 64)
+    {
+        __m128i* v = reinterpret_cast<__m128i*>(p + i);
+        _mm_storeu_si128(v, _mm_xor_si128(_mm_loadu_si128(v), k128));
+        _mm_storeu_si128(v + 1, _mm_xor_si128(_mm_loadu_si128(v + 1), k128));
+        _mm_storeu_si128(v + 2, _mm_xor_si128(_mm_loadu_si128(v + 2), k128));
+        _mm_storeu_si128(v + 3, _mm_xor_si128(_mm_loadu_si128(v + 3), k128));
+    }
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i* v = reinterpret_cast<__m128i*>(p + i);
+        _mm_storeu_si128(v, _mm_xor_si128(_mm_loadu_si128(v), k128));
+    }
+#elif defined(__ARM_NEON)
+    uint8x16_t k128 = vreinterpretq_u8_u32(vdupq_n_u32(k32));
+    for (; i + 64 <= n; i += 64)
+    {
+        uint8_t* v = reinterpret_cast<uint8_t*>(p + i);
+        vst1q_u8(v, veorq_u8(vld1q_u8(v), k128));
+        vst1q_u8(v + 16, veorq_u8(vld1q_u8(v + 16), k128));
+        vst1q_u8(v + 32, veorq_u8(vld1q_u8(v + 32), k128));
+        vst1q_u8(v + 48, veorq_u8(vld1q_u8(v + 48), k128));
+    }
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8_t* v = reinterpret_cast<uint8_t*>(p + i);
+        vst1q_u8(v, veorq_u8(vld1q_u8(v), k128));
+    }
+#endif
+
+    uint64_t k64 = (static_cast<uint64_t>(k32) << 32) | k32;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint64_t w;
+        memcpy(&w, p + i, sizeof(w));
+        w ^= k64;
+        memcpy(p + i, &w, sizeof(w));
+    }
+    return UnmaskScalar(p + i, n - i, key, offset + i);
+}
+
+} // end namespace coop::ws::detail
+} // end namespace coop::ws
+} // end namespace coop
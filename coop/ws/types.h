@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <string_view>
 
 namespace coop
 {
@@ -40,5 +41,54 @@ struct Frame
     bool IsBinary() const { return opcode == Opcode::Binary; }
 };
 
+// A whole message from NextMessage(): every fragment of a Text or Binary message, or a control
+// frame, in one view. Valid until the next NextMessage() or NextFrame().
+//
+struct Message
+{
+    Opcode      opcode;
+    const void* data;
+    size_t      size;
+
+    std::string_view View() const { return {static_cast<const char*>(data), size}; }
+
+    bool IsClose()  const { return opcode == Opcode::Close; }
+    bool IsPing()   const { return opcode == Opcode::Ping; }
+    bool IsPong()   const { return opcode == Opcode::Pong; }
+    bool IsText()   const { return opcode == Opcode::Text; }
+    bool IsBinary() const { return opcode == Opcode::Binary; }
+};
+
+namespace detail
+{
+
+// Encode an unmasked (server) frame header for a payload of size into out, returning its length:
+// 2, 4, or 10 bytes (RFC 6455 Section 5.2). rsv1 marks a permessage-deflate compressed message. A
+// client's header sets the mask bit in out[1] and follows with the key.
+//
+inline size_t EncodeFrameHeader(uint8_t out[10], Opcode opcode, bool fin, size_t size,
+                                bool rsv1 = false)
+{
+    out[0] = (fin ? 0x80 : 0x00) | (rsv1 ? 0x40 : 0x00) | static_cast<uint8_t>(opcode);
+    if (size <= 125)
+    {
+        out[1] = static_cast<uint8_t>(size);
+        return 2;
+    }
+    if (size <= 65535)
+    {
+        out[1] = 126;
+        out[2] = static_cast<uint8_t>(size >> 8);
+        out[3] = static_cast<uint8_t>(size);
+        return 4;
+    }
+    out[1] = 127;
+    for (int i = 0; i < 8; i++)
+        out[2 + i] = static_cast<uint8_t>(size >> (56 - 8 * i));
+    return 10;
+}
+
+} // end namespace coop::ws::detail
+
 } // namespace coop::ws
 } // namespace coop
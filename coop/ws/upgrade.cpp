@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <cstdio>
 #include <cstring>
+#include <string>
 
 namespace coop
 {
@@ -60,6 +61,13 @@ bool ContainsToken(const char* haystack, size_t hayLen,
 
 bool Upgrade(http::ConnectionBase& conn)
 {
+    return Upgrade(conn, DeflateOptions{}, nullptr);
+}
+
+bool Upgrade(http::ConnectionBase& conn, DeflateOptions const& options, DeflateParams* deflate)
+{
+    if (deflate) *deflate = DeflateParams{};
+
     // Scan HTTP headers for WebSocket upgrade indicators.
     //
     bool hasUpgrade = false;
@@ -97,6 +105,11 @@ bool Upgrade(http::ConnectionBase& conn)
             if (vLen == 2 && vData[0] == '1' && vData[1] == '3')
                 hasVersion13 = true;
         }
+        else if (deflate && !deflate->enabled &&
+                 CaseInsensitiveEq(name, nameLen, "sec-websocket-extensions", 24))
+        {
+            NegotiateDeflate(std::string_view(vData, vLen), options, deflate);
+        }
     }
 
     if (!hasUpgrade || !hasConnection || wsKeyLen == 0 || !hasVersion13)
@@ -112,13 +125,20 @@ bool Upgrade(http::ConnectionBase& conn)
 
     // Send 101 Switching Protocols.
     //
-    char response[256];
+    std::string extensions;
+    if (deflate && deflate->enabled)
+    {
+        extensions = "Sec-WebSocket-Extensions: " + DeflateResponse(*deflate) + "\r\n";
+    }
+
+    char response[384];
     int respLen = snprintf(response, sizeof(response),
         "HTTP/1.1 101 Switching Protocols\r\n"
         "Upgrade: websocket\r\n"
         "Connection: Upgrade\r\n"
         "Sec-WebSocket-Accept: %s\r\n"
-        "\r\n", acceptKey);
+        "%s"
+        "\r\n", acceptKey, extensions.c_str());
 
     return conn.SendRawBytes(response, static_cast<size_t>(respLen));
 }
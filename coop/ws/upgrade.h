@@ -27,6 +27,7 @@
 //
 
 #include "coop/http/connection.h"
+#include "deflate.h"
 
 namespace coop
 {
@@ -43,5 +44,17 @@ namespace ws
 //
 bool Upgrade(http::ConnectionBase& conn);
 
+// As above, also accepting permessage-deflate (RFC 7692) when the client offers it within
+// options. *deflate says what was agreed; pass it, with options, to the connection's
+// EnableDeflate:
+//
+//     ws::DeflateOptions options;
+//     ws::DeflateParams deflate;
+//     if (!ws::Upgrade(conn, options, &deflate)) return;
+//     auto ws = ...;
+//     ws->EnableDeflate(deflate, options);
+//
+bool Upgrade(http::ConnectionBase& conn, DeflateOptions const& options, DeflateParams* deflate);
+
 } // namespace coop::ws
 } // namespace coop
@@ -292,7 +292,7 @@ void SpawningTask(coop::Context* ctx, void*)
     //
     while (!coop::IsShuttingDown())
     {
-        ctx->Yield(true);
+        ctx->Yield();
     }
     spdlog::info("shutting down...");
 
@@ -73,7 +73,7 @@ void ClientTask(coop::Context* ctx, void* arg)
     //
     while (!coop::IsShuttingDown())
     {
-        ctx->Yield(true);
+        ctx->Yield();
     }
     spdlog::info("shutting down...");
 }
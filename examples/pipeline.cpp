@@ -1,5 +1,6 @@
 #include <cstdint>
 #include <cstdio>
+#include <span>
 #include <vector>
 
 #include "coop/chan/channel.h"
@@ -13,10 +14,12 @@ using namespace coop::chan;
 // ---------------------------------------------------------------------------
 // Channel pipeline example
 //
-// Demonstrates chaining Channel<int64_t> stages where each stage drains its
-// input in batches (Drain), transforms values, and pushes to the next stage
-// (SendAll). Shutdown propagates naturally: when a stage's input is exhausted
-// it shuts down its output, signalling the next stage to do the same.
+// Demonstrates chaining Channel<int64_t> stages where each stage receives its
+// input in batches (RecvBatch), transforms values, and pushes them to the next
+// stage in batches (SendBatch), so a channel's coordinators change hands once
+// per batch rather than once per item. Shutdown propagates naturally: when a
+// stage's input is exhausted it shuts down its output, signalling the next
+// stage to do the same.
 //
 //   Source ──ch0──► [×2] ──ch1──► [+100] ──ch2──► Sink
 //
@@ -26,7 +29,20 @@ static constexpr int64_t N     = 100'000;
 static constexpr int     DEPTH = 64;    // channel buffer depth
 static constexpr int     BATCH = 256;   // stage working batch size
 
-// Run one pipeline stage: drain from `in`, apply `fn` to each item, send to
+// Send every item, one SendBatch per stretch of free buffer. False on shutdown.
+//
+static bool SendEvery(Channel<int64_t>& ch, std::span<int64_t> items)
+{
+    while (!items.empty())
+    {
+        size_t n = ch.SendBatch(items);
+        if (n == 0) return false;
+        items = items.subspan(n);
+    }
+    return true;
+}
+
+// Run one pipeline stage: receive from `in`, apply `fn` to each item, send to
 // `out`. Shuts down `out` when `in` is exhausted.
 //
 template<typename Fn>
@@ -34,23 +50,12 @@ static void RunStage(Channel<int64_t>& in, Channel<int64_t>& out, Fn fn)
 {
     std::vector<int64_t> buf(BATCH);
 
-    while (true)
+    while (size_t n = in.RecvBatch(buf))
     {
-        size_t n = in.Drain(buf.data(), BATCH);
-        if (n == 0)
-        {
-            int64_t v;
-            if (!in.Recv(v)) break;
-            buf[0] = fn(v);
-            n = 1;
-        }
-        else
-        {
-            for (size_t i = 0; i < n; i++)
-                buf[i] = fn(buf[i]);
-        }
+        for (size_t i = 0; i < n; i++)
+            buf[i] = fn(buf[i]);
 
-        if (!out.SendAll(buf.data(), n)) break;
+        if (!SendEvery(out, std::span(buf.data(), n))) break;
     }
 
     out.Shutdown();
@@ -88,7 +93,7 @@ int main()
                 int64_t count = std::min((int64_t)BATCH, N - base);
                 for (int64_t i = 0; i < count; i++)
                     src[i] = base + i;
-                if (!ch0.SendAll(src.data(), count)) return;
+                if (!SendEvery(ch0, std::span(src.data(), count))) return;
             }
             ch0.Shutdown();
         });
@@ -99,21 +104,10 @@ int main()
         int64_t count = 0;
         {
             std::vector<int64_t> buf(BATCH);
-            while (true)
+            while (size_t n = ch2.RecvBatch(buf))
             {
-                size_t n = ch2.Drain(buf.data(), BATCH);
-                if (n == 0)
-                {
-                    int64_t v;
-                    if (!ch2.Recv(v)) break;
-                    sum += v;
-                    count++;
-                }
-                else
-                {
-                    for (size_t i = 0; i < n; i++) sum += buf[i];
-                    count += (int64_t)n;
-                }
+                for (size_t i = 0; i < n; i++) sum += buf[i];
+                count += (int64_t)n;
             }
         }
 
@@ -0,0 +1,121 @@
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <spdlog/spdlog.h>
+
+#include "coop/cooperator.h"
+#include "coop/deadline_scope.h"
+#include "coop/shutdown.h"
+#include "coop/thread.h"
+#include "coop/time/sleep.h"
+#include "coop/rpc/pool.h"
+#include "coop/rpc/server.h"
+
+// RPC echo example
+//
+// A coop::rpc server with two methods, and a pool of clients calling it. ECHO answers inline,
+// from the connection's recv buffer; SLOW_ECHO waits first, on a context of its own, so the
+// calls behind it on the same connection are not held up. Sixteen callers share the pool's
+// connections, their calls multiplexed and answered in whatever order they finish.
+//
+//   rpc_echo             server and clients in one process
+//   rpc_echo --server    the server alone, until SIGINT
+//
+
+static constexpr int PORT = 7000;
+
+enum : uint16_t
+{
+    ECHO = 1,
+    SLOW_ECHO = 2,
+};
+
+static void Echo(coop::rpc::Call& call)
+{
+    call.Reply(call.Request().data(), call.Request().size());
+}
+
+static void SlowEcho(coop::rpc::Call& call)
+{
+    coop::time::Sleep(call.GetContext(), std::chrono::milliseconds(10));
+    call.Reply(call.Request().data(), call.Request().size());
+}
+
+static constexpr coop::rpc::MethodTable s_methods = {
+    {ECHO, &Echo},
+    {SLOW_ECHO, &SlowEcho, coop::rpc::SPAWN},
+};
+
+static void Clients(coop::Context* ctx)
+{
+    coop::rpc::Pool pool;
+    int finished = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        ctx->GetCooperator()->Spawn([&pool, &finished, i](coop::Context* child)
+        {
+            // The server sees what is left of this budget, and gives up when the caller would
+            //
+            coop::DeadlineScope scope(child, std::chrono::seconds(1));
+
+            std::string request = "hello " + std::to_string(i);
+            std::string response;
+            uint16_t method = i % 2 ? SLOW_ECHO : ECHO;
+            int rc = pool.Call(child, "127.0.0.1", PORT, method, request.data(), request.size(),
+                               &response);
+            if (rc == 0)
+            {
+                spdlog::info("call {} echo: {}", i, response);
+            }
+            else
+            {
+                spdlog::warn("call {} failed: {}", i, rc < 0 ? strerror(-rc) : "server status");
+            }
+            finished++;
+        });
+    }
+    while (finished < 16)
+    {
+        ctx->Yield();
+    }
+    spdlog::info("{} calls over {} connections", finished, pool.Connections());
+    pool.Close(ctx);
+}
+
+static void Main(coop::Context* ctx, void* arg)
+{
+    ctx->SetName("RpcEcho");
+    bool serverOnly = arg != nullptr;
+
+    coop::Context::Handle server;
+    ctx->GetCooperator()->Spawn([](coop::Context* serverCtx)
+    {
+        coop::rpc::RunServer(serverCtx, PORT, s_methods);
+    }, &server);
+
+    if (!serverOnly)
+    {
+        Clients(ctx);
+        ctx->GetCooperator()->Shutdown();
+        return;
+    }
+
+    while (!coop::IsShuttingDown())
+    {
+        ctx->Yield();
+    }
+    spdlog::info("shutting down...");
+}
+
+int main(int argc, char* argv[])
+{
+    bool serverOnly = argc > 1 && strcmp(argv[1], "--server") == 0;
+
+    coop::InstallShutdownHandler();
+    coop::Cooperator cooperator;
+    coop::Thread mt(&cooperator);
+
+    cooperator.Submit(&Main, serverOnly ? reinterpret_cast<void*>(1) : nullptr);
+    return 0;
+}
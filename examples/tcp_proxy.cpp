@@ -11,11 +11,12 @@
 #include "coop/launchable.h"
 #include "coop/thread.h"
 #include "coop/io/io.h"
-#include "coop/io/shutdown.h"
 #include "coop/shutdown.h"
 
 // TCP proxy that accepts client connections and relays bytes bidirectionally to an upstream server.
-// Uses splice for zero-copy relay — data moves between sockets entirely in-kernel.
+// Relays through io::Proxy: zero-copy splice — data moves between sockets entirely in-kernel —
+// issued as one linked io_uring chain per hop (poll, splice in, splice out), so each hop is a
+// single wake.
 //
 // Usage: tcp_proxy <listen-port> <upstream-ip> <upstream-port>
 //
@@ -53,75 +54,17 @@ struct ProxyHandler : coop::Launchable
             return;
         }
 
-        auto* ctx = GetContext();
         spdlog::info("proxy: connected fd={} -> upstream fd={}", m_client.m_fd, upstream.m_fd);
-        coop::io::ShutdownOnKillGuard parentClientShutdown(ctx, m_client);
-        coop::io::ShutdownOnKillGuard parentUpstreamShutdown(ctx, upstream);
 
-        // Flag set by the child relay when it exits, so the parent knows to half-close
+        // Both directions, half-close propagation and kill handling live in io::Proxy; chained
+        // hops cost one wake each
         //
-        bool childDone = false;
-
-        coop::Context::Handle childHandle;
-
-        auto* upstreamPtr = &upstream;
-        auto* clientPtr = &m_client;
-        auto* childDonePtr = &childDone;
-
-        // Child context: relay client -> upstream (zero-copy via splice)
-        //
-        coop::Spawn([=](coop::Context* childCtx)
-        {
-            childCtx->SetName("ClientToUpstream");
-            coop::io::ShutdownOnKillGuard childClientShutdown(childCtx, *clientPtr);
-            coop::io::ShutdownOnKillGuard childUpstreamShutdown(childCtx, *upstreamPtr);
-            int pipefd[2];
-            pipe2(pipefd, O_NONBLOCK);
-
-            while (!childCtx->IsKilled())
-            {
-                int n = coop::io::Splice(*clientPtr, *upstreamPtr, pipefd, 65536);
-                if (n <= 0) break;
-            }
-
-            close(pipefd[0]);
-            close(pipefd[1]);
-            *childDonePtr = true;
-        }, &childHandle);
-
-        // Parent context: relay upstream -> client (zero-copy via splice)
-        //
-        int pipefd[2];
-        pipe2(pipefd, O_NONBLOCK);
-
-        while (!ctx->IsKilled())
-        {
-            int n = coop::io::Splice(upstream, m_client, pipefd, 65536);
-            if (n <= 0) break;
-
-            // If the child exited (client closed its write side), propagate the half-close
-            // to upstream so it knows no more data is coming, then keep draining.
-            //
-            if (childDone)
-            {
-                coop::io::Shutdown(upstream, SHUT_WR);
-                childDone = false;
-            }
-        }
-
-        close(pipefd[0]);
-        close(pipefd[1]);
-
-        // Parent is done — kill the child if it's still running. RAII closes both descriptors.
-        //
-        if (childHandle)
-        {
-            childHandle.Kill();
-            while (!childDone)
-            {
-                ctx->Yield(true);
-            }
-        }
+        coop::io::ProxyOptions options;
+        options.chained = true;
+        coop::io::ProxyStats stats;
+        int result = coop::io::Proxy(m_client, upstream, options, &stats);
+        spdlog::info("proxy: closed fd={} result={} client->upstream={} upstream->client={}",
+            m_client.m_fd, result, stats.aToB, stats.bToA);
     }
 
     coop::io::Descriptor    m_client;
@@ -193,7 +136,7 @@ void SpawningTask(coop::Context* ctx, void* arg)
 
     while (!coop::IsShuttingDown())
     {
-        ctx->Yield(true);
+        ctx->Yield();
     }
     spdlog::info("shutting down...");
 }
@@ -1,10 +1,13 @@
 #include <cstring>
+#include <map>
+#include <string>
 
 #include <gtest/gtest.h>
 
 #include "coop/alloc.h"
 #include "coop/cooperator.h"
 #include "coop/self.h"
+#include "coop/thread.h"
 #include "test_helpers.h"
 
 namespace
@@ -209,3 +212,63 @@ TEST(AllocTest, HeapDoesNotOverlapStack)
         EXPECT_LT(pc + sizeof(Widget), top);
     });
 }
+
+// With a bump reserve, an allocation that would cut into the stack's share of the segment spills
+// to an overflow chunk. LIFO frees release it and the segment heap picks up where it was; a chunk
+// still held at exit is released with the context.
+//
+TEST(AllocTest, CheckedHeapOverflowsToChunk)
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.bumpReserve = 4096;
+    cfg.trackStackDepth = true;
+
+    coop::Cooperator co(cfg);
+    coop::Thread t(&co);
+
+    co.SubmitSync([](coop::Context* ctx)
+    {
+        auto* cooperator = ctx->GetCooperator();
+        coop::SpawnConfiguration config = {.priority = 0, .stackSize = 16384};
+        cooperator->Spawn(config, [](coop::Context* child)
+        {
+            child->SetName("spill");
+            uintptr_t bottom = reinterpret_cast<uintptr_t>(child->m_segment.Bottom());
+            uintptr_t top = reinterpret_cast<uintptr_t>(child->m_segment.Top());
+            auto inSegment = [&](void* p)
+            {
+                auto addr = reinterpret_cast<uintptr_t>(p);
+                return addr >= bottom && addr < top;
+            };
+
+            auto small = child->AllocateBuffer(64);
+            EXPECT_TRUE(inSegment(small.data()));
+            {
+                auto big = child->AllocateBuffer(16384);
+                EXPECT_FALSE(inSegment(big.data()));
+                memset(big.data(), 0xab, big.size());
+
+                auto after = child->AllocateBuffer(64);
+                EXPECT_EQ(after.data(), small.data() + 64);
+            }
+            EXPECT_EQ(child->m_bumpOverflow, nullptr);
+
+            auto again = child->AllocateBuffer(64);
+            EXPECT_EQ(again.data(), small.data() + 64);
+
+            void* held = coop::detail::BumpAlloc(child, 16384);
+            EXPECT_FALSE(inSegment(held));
+            EXPECT_NE(child->m_bumpOverflow, nullptr);
+        });
+
+        std::map<std::string, coop::Cooperator::StackDepth> seen;
+        cooperator->VisitStackDepths([&](const char* name, coop::Cooperator::StackDepth const& d)
+        {
+            seen[name] = d;
+        });
+        ASSERT_EQ(seen.count("spill"), 1u);
+        EXPECT_EQ(seen["spill"].bumpOverflows, 2u);
+        EXPECT_LT(seen["spill"].maxHeapBytes, 16384u);
+    });
+    co.Shutdown();
+}
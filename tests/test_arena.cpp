@@ -0,0 +1,151 @@
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "coop/arena.h"
+#include "coop/cooperator.h"
+#include "coop/size_class_allocator.h"
+#include "test_helpers.h"
+
+namespace
+{
+
+bool Within(void* p, void* base, size_t bytes)
+{
+    auto addr = reinterpret_cast<uintptr_t>(p);
+    auto begin = reinterpret_cast<uintptr_t>(base);
+    return addr >= begin && addr < begin + bytes;
+}
+
+} // end anon namespace
+
+// Small allocations come from the heap region, then from pooled chunks; Reset gives the chunks
+// back and rewinds the region
+//
+TEST(ArenaTest, HeapRegionThenChunks)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::Arena arena(ctx, 1024);
+        ASSERT_EQ(arena.HeapBytes(), 1024u);
+
+        void* first = arena.Allocate(64);
+        ASSERT_NE(first, nullptr);
+        for (int i = 0; i < 15; i++)
+        {
+            EXPECT_TRUE(Within(arena.Allocate(64), first, 1024));
+        }
+        EXPECT_EQ(arena.ChunkCount(), 0u);
+
+        void* spilled = arena.Allocate(64);
+        ASSERT_NE(spilled, nullptr);
+        EXPECT_FALSE(Within(spilled, first, 1024));
+        EXPECT_EQ(arena.ChunkCount(), 1u);
+
+        arena.Reset();
+        EXPECT_EQ(arena.ChunkCount(), 0u);
+        EXPECT_EQ(arena.Allocate(64), first);
+    });
+}
+
+// An allocation too large for a shared chunk gets its own, and the current chunk keeps serving
+//
+TEST(ArenaTest, LargeAllocationGetsOwnChunk)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::Arena arena(ctx, 0);
+        EXPECT_EQ(arena.HeapBytes(), 0u);
+
+        auto* a = static_cast<char*>(arena.Allocate(32));
+        ASSERT_NE(a, nullptr);
+        EXPECT_EQ(arena.ChunkCount(), 1u);
+
+        void* large = arena.Allocate(coop::Arena::kChunkBytes * 4);
+        ASSERT_NE(large, nullptr);
+        EXPECT_EQ(arena.ChunkCount(), 2u);
+
+        auto* b = static_cast<char*>(arena.Allocate(32));
+        EXPECT_EQ(b, a + 32);
+        EXPECT_EQ(arena.ChunkCount(), 2u);
+    });
+}
+
+TEST(ArenaTest, Alignment)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::Arena arena(ctx);
+        arena.Allocate(1, 1);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(arena.Allocate(8, 8)) % 8, 0u);
+        arena.Allocate(3, 1);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(arena.Allocate(1, 64)) % 64, 0u);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(arena.Allocate(8000, 256)) % 256, 0u);
+
+        struct Pair { int64_t a, b; };
+        Pair* pair = arena.New<Pair>(Pair{1, 2});
+        ASSERT_NE(pair, nullptr);
+        EXPECT_EQ(pair->b, 2);
+    });
+}
+
+// The heap region leaves the stack room: on a small segment the arena takes less than asked
+//
+TEST(ArenaTest, HeapRegionCappedByHeadroom)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::SpawnConfiguration config = {.priority = 0, .stackSize = 16384};
+        ctx->GetCooperator()->Spawn(config, [](coop::Context* child)
+        {
+            coop::Arena arena(child, 1 << 20);
+            EXPECT_LT(arena.HeapBytes(), 8192u);
+
+            // Nested arenas: the inner one's region is carved after the outer's, and released first
+            //
+            {
+                coop::Arena inner(child);
+                EXPECT_LE(inner.HeapBytes(), arena.HeapBytes());
+                EXPECT_NE(inner.Allocate(16), nullptr);
+            }
+            EXPECT_NE(arena.Allocate(16), nullptr);
+        });
+    });
+}
+
+// pmr containers grow and free out of order; everything comes back at Reset
+//
+TEST(ArenaTest, PmrContainers)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto& allocator = ctx->GetCooperator()->GetAllocator();
+        const size_t freeBefore = allocator.FreeCount(coop::Arena::kChunkBytes);
+
+        coop::Arena arena(ctx);
+        coop::ArenaResource resource(arena);
+        {
+            std::pmr::vector<int> numbers(&resource);
+            std::pmr::map<int, std::pmr::string> names(&resource);
+            const char* name = "a name too long for the small buffer";
+            for (int i = 0; i < 1000; i++)
+            {
+                numbers.push_back(i);
+                names.emplace(i, std::pmr::string(name, &resource));
+            }
+            names.erase(names.begin(), names.find(500));
+
+            EXPECT_EQ(numbers[999], 999);
+            EXPECT_EQ(names.size(), 500u);
+            EXPECT_EQ(names.begin()->first, 500);
+        }
+        EXPECT_GT(arena.ChunkCount(), 1u);
+
+        arena.Reset();
+        EXPECT_GT(allocator.FreeCount(coop::Arena::kChunkBytes), freeBefore);
+    });
+}
@@ -1,8 +1,11 @@
 #include <cerrno>
 #include <cstring>
 #include <string>
+#include <netinet/in.h>
 #include <sys/socket.h>
+#include <net/if.h>
 #include <unistd.h>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -15,7 +18,11 @@
 #include "coop/io/armed_handle.h"
 #include "coop/io/buffer_ring.h"
 #include "coop/io/descriptor.h"
+#include "coop/io/recv.h"
+#include "coop/io/send.h"
+#include "coop/io/udp.h"
 #include "coop/io/uring.h"
+#include "coop/io/zcrx.h"
 
 #include "test_helpers.h"
 
@@ -40,6 +47,36 @@ struct SocketPair
     }
 };
 
+// A loopback TCP listener on an ephemeral port.
+//
+struct Listener
+{
+    int fd;
+    sockaddr_in addr{};
+
+    Listener()
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        int ret = bind(fd, (sockaddr*)&addr, sizeof(addr));
+        ret |= listen(fd, 128);
+        ret |= getsockname(fd, (sockaddr*)&addr, &len);
+        assert(ret == 0);
+        std::ignore = ret;
+    }
+
+    int Connect() const
+    {
+        int c = socket(AF_INET, SOCK_STREAM, 0);
+        int ret = connect(c, (sockaddr const*)&addr, sizeof(addr));
+        assert(ret == 0);
+        std::ignore = ret;
+        return c;
+    }
+};
+
 // A round-tripped stream drained through a single armed multishot recv. Each round writes a
 // batch and drains exactly that many bytes, recycling each kernel-selected buffer back to the
 // pool. A pool far smaller than the total bytes moved proves the recycle path: the same 16
@@ -97,6 +134,163 @@ TEST(ArmedHandleTest, MultishotRecvDrainsStreamWithRecycle)
     });
 }
 
+// With bundles, a burst queued before the recv is armed lands in far fewer CQEs than buffers, each
+// chunk's pieces reassemble the stream in order, and the recycled runs keep serving later rounds.
+//
+TEST(ArmedHandleTest, MultishotRecvBundlesBurst)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        if (!coop::GetUring()->SupportsRecvBundles())
+        {
+            GTEST_SKIP() << "kernel lacks IORING_RECVSEND_BUNDLE";
+        }
+
+        coop::io::BufferRing br(/*group=*/9, /*entries=*/32, /*bufSize=*/256);
+        ASSERT_EQ(br.Register(*coop::GetUring()), 0);
+
+        SocketPair sp;
+        coop::io::Descriptor reader(sp.fds[0], coop::GetUring());
+
+        coop::Coordinator coord;
+        coop::io::ArmedHandle ah(ctx, reader, &br, &coord, /*bundle=*/true);
+
+        constexpr int kBurst = 4096;                 // 16 buffers' worth
+        std::string expected;
+        std::string received;
+        int chunks = 0;
+
+        for (int round = 0; round < 8; round++)
+        {
+            std::string burst(kBurst, '\0');
+            for (int i = 0; i < kBurst; i++) burst[i] = char('a' + (round * 7 + i) % 26);
+            ASSERT_EQ(::write(sp.fds[1], burst.data(), kBurst), (ssize_t)kBurst);
+            expected += burst;
+
+            if (round == 0) ah.Arm();
+
+            size_t target = expected.size();
+            while (received.size() < target)
+            {
+                coop::io::ArmedHandle::Chunk c;
+                int n = ah.Next(&c);
+                ASSERT_GT(n, 0);
+                chunks++;
+                int total = 0;
+                for (auto piece : ah.Pieces(c))
+                {
+                    received.append(piece.data, piece.len);
+                    total += piece.len;
+                }
+                EXPECT_EQ(total, n);
+            }
+        }
+
+        EXPECT_EQ(received, expected);
+        EXPECT_LT(chunks, 8 * 16) << "bundles cover several buffers per CQE";
+        EXPECT_EQ(ah.Enobufs(), 0u);
+    });
+}
+
+// On an incremental ring, small messages are carved back to back out of one large buffer, which
+// is only recycled once the kernel has moved past it.
+//
+TEST(ArmedHandleTest, IncrementalRingPacksSmallMessages)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::io::BufferRing br(/*group=*/14, /*entries=*/4, /*bufSize=*/65536, /*incremental=*/true);
+        ASSERT_EQ(br.Register(*coop::GetUring()), 0);
+        if (!br.Incremental())
+        {
+            GTEST_SKIP() << "kernel lacks IOU_PBUF_RING_INC";
+        }
+
+        SocketPair sp;
+        coop::io::Descriptor reader(sp.fds[0], coop::GetUring());
+
+        coop::Coordinator coord;
+        coop::io::ArmedHandle ah(ctx, reader, &br, &coord);
+        ah.Arm();
+
+        std::vector<int32_t> bids;
+        char* prevEnd = nullptr;
+        for (int i = 0; i < 32; i++)
+        {
+            std::string msg(100, char('a' + i % 26));
+            ASSERT_EQ(::write(sp.fds[1], msg.data(), msg.size()), (ssize_t)msg.size());
+
+            coop::io::ArmedHandle::Chunk c;
+            ASSERT_EQ(ah.Next(&c), 100);
+            EXPECT_EQ(std::string(c.data, c.len), msg);
+            if (prevEnd && c.bid == bids.back())
+            {
+                EXPECT_EQ(c.data, prevEnd) << "carved right after the previous message";
+            }
+            bids.push_back(c.bid);
+            prevEnd = c.data + c.len;
+        }
+
+        EXPECT_EQ(bids.front(), bids.back()) << "3200 bytes fit one 64KB buffer";
+        EXPECT_EQ(ah.Enobufs(), 0u);
+    });
+}
+
+// On a BufferRingSet, a connection starts on the smallest class, moves up once its messages
+// outgrow it, and decays back down when they shrink again; the byte stream is intact across every
+// switch.
+//
+TEST(ArmedHandleTest, BufferRingSetFollowsMessageSize)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::io::BufferRingSet set;
+        ASSERT_TRUE(set.Add(/*group=*/11, /*entries=*/16, /*bufSize=*/512));
+        ASSERT_TRUE(set.Add(/*group=*/12, /*entries=*/16, /*bufSize=*/16384));
+        EXPECT_FALSE(set.Add(13, 16, 4096)) << "classes are added smallest first";
+        ASSERT_EQ(set.Register(*coop::GetUring()), 0);
+        EXPECT_EQ(set.ClassFor(100), 0);
+        EXPECT_EQ(set.ClassFor(513), 1);
+        EXPECT_EQ(set.ClassFor(1 << 20), 1);
+
+        SocketPair sp;
+        coop::io::Descriptor reader(sp.fds[0], coop::GetUring());
+
+        coop::Coordinator coord;
+        coop::io::ArmedHandle ah(ctx, reader, &set, &coord);
+        ah.Arm();
+
+        // One message at a time, so the stream's CQEs follow message boundaries
+        //
+        auto roundTrip = [&](int size, char fill)
+        {
+            std::string msg(size, fill);
+            ASSERT_EQ(::write(sp.fds[1], msg.data(), size), (ssize_t)size);
+            std::string got;
+            while ((int)got.size() < size)
+            {
+                coop::io::ArmedHandle::Chunk c;
+                int n = ah.Next(&c);
+                ASSERT_GT(n, 0);
+                got.append(c.data, n);
+            }
+            EXPECT_EQ(got, msg);
+        };
+
+        for (int i = 0; i < 4; i++) roundTrip(200, 'a' + i);
+        EXPECT_EQ(ah.Ring(), set.Class(0));
+        EXPECT_EQ(ah.Regroups(), 0u);
+
+        for (int i = 0; i < 4; i++) roundTrip(6000, 'k' + i);
+        EXPECT_EQ(ah.Ring(), set.Class(1)) << "large messages move to the large class";
+
+        for (int i = 0; i < 20; i++) roundTrip(100, 'A' + i);
+        EXPECT_EQ(ah.Ring(), set.Class(0)) << "and small ones bring it back";
+        EXPECT_EQ(ah.Regroups(), 2u);
+        EXPECT_EQ(ah.Enobufs(), 0u);
+    });
+}
+
 // Peer close surfaces as a zero-length terminal chunk; the stream is then finished.
 //
 TEST(ArmedHandleTest, MultishotRecvReportsEof)
@@ -132,6 +326,90 @@ TEST(ArmedHandleTest, MultishotRecvReportsEof)
     });
 }
 
+// A GSO train of four 100-byte segments arrives through one armed multishot recvmsg as datagrams
+// that reassemble the train, each naming the sender. With GRO on, the receiver may get several
+// coalesced into one buffer, reported by its segment size.
+//
+TEST(ArmedHandleTest, MultishotRecvMsgReceivesGsoTrain)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto* uring = coop::GetUring();
+        coop::io::BufferRing br(9, 16, 2048);
+        ASSERT_EQ(br.Register(*uring), 0);
+
+        auto bindLoopback = [](int fd, sockaddr_in* addr)
+        {
+            addr->sin_family = AF_INET;
+            addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr->sin_port = 0;
+            socklen_t len = sizeof(*addr);
+            return bind(fd, (sockaddr*)addr, sizeof(*addr))
+                 | getsockname(fd, (sockaddr*)addr, &len);
+        };
+        sockaddr_in rxAddr{}, txAddr{};
+        coop::io::Descriptor rx(socket(AF_INET, SOCK_DGRAM, 0), uring);
+        coop::io::Descriptor tx(socket(AF_INET, SOCK_DGRAM, 0), uring);
+        ASSERT_EQ(bindLoopback(rx.m_fd, &rxAddr), 0);
+        ASSERT_EQ(bindLoopback(tx.m_fd, &txAddr), 0);
+
+        // Best effort: without GRO every segment simply arrives as its own datagram
+        //
+        std::ignore = coop::io::SetUdpGro(rx);
+
+        coop::Coordinator coord;
+        coop::io::ArmedHandle ah(coop::io::datagrams, ctx, rx, &br, &coord,
+            sizeof(sockaddr_in6), coop::io::UDP_GRO_CONTROL);
+        ah.Arm();
+
+        std::string train;
+        for (int i = 0; i < 400; i++) train.push_back(char('a' + i % 26));
+        iovec iov{train.data(), train.size()};
+        msghdr msg{};
+        msg.msg_name = &rxAddr;
+        msg.msg_namelen = sizeof(rxAddr);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        coop::io::UdpSegmentControl control;
+        coop::io::SetUdpSegment(&msg, &control, 100);
+
+        int sent = coop::io::SendMsg(tx, &msg);
+        if (sent == -EIO || sent == -EINVAL || sent == -ENOPROTOOPT)
+        {
+            GTEST_SKIP() << "UDP GSO unavailable";
+        }
+        ASSERT_EQ(sent, 400);
+
+        std::string received;
+        while (received.size() < train.size())
+        {
+            coop::io::ArmedHandle::Chunk c;
+            int n = ah.Next(&c);
+            if (n == -EINVAL && received.empty())
+            {
+                GTEST_SKIP() << "multishot recvmsg unavailable";
+            }
+            ASSERT_GT(n, 0);
+
+            coop::io::ArmedHandle::Datagram d;
+            ASSERT_TRUE(ah.ParseDatagram(c, &d));
+            EXPECT_FALSE(d.truncated);
+            ASSERT_NE(d.name, nullptr);
+            EXPECT_EQ(reinterpret_cast<sockaddr_in const*>(d.name)->sin_port, txAddr.sin_port);
+            if (d.segment)
+            {
+                EXPECT_EQ(d.segment, 100);
+            }
+            else
+            {
+                EXPECT_EQ(d.payloadLen, 100u);
+            }
+            received.append(d.payload, d.payloadLen);
+        }
+        EXPECT_EQ(received, train);
+    });
+}
+
 // Calibration (the RED case): with a pool smaller than the in-flight bytes and no recycling, the
 // kernel exhausts the pool and the armed recv surfaces -ENOBUFS. This is the negative control
 // that proves the enobufs==0 assertion above is real, not green-by-construction.
@@ -215,4 +493,125 @@ TEST(ArmedHandleTest, InitRegistersDefaultBufferRing)
     cooperator.Shutdown();
 }
 
+// One armed multishot accept serves a whole burst of connections: every client connected before
+// the first Accept() is delivered, in order, from a single submission, and accepted-but-untaken
+// connections are closed with the handle.
+//
+TEST(ArmedHandleTest, MultishotAcceptDeliversBurst)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        Listener listener;
+        coop::io::Descriptor desc(listener.fd, coop::GetUring());
+
+        constexpr int kClients = 20;
+        std::vector<int> clients;
+        for (int i = 0; i < kClients; i++) clients.push_back(listener.Connect());
+
+        {
+            coop::Coordinator coord;
+            coop::io::ArmedHandle accepts(coop::io::accepting, ctx, desc, &coord);
+            accepts.Arm();
+
+            for (int i = 0; i < kClients - 2; i++)
+            {
+                int fd = accepts.Accept();
+                ASSERT_GE(fd, 0);
+                close(fd);
+            }
+            EXPECT_TRUE(accepts.Armed());
+
+            // Let the last two land in the queue untaken
+            //
+            while (accepts.Delivered() < (uint64_t)kClients) ctx->Yield();
+        }
+
+        // The untaken connections were closed: their clients read EOF
+        //
+        char b;
+        EXPECT_EQ(::read(clients[kClients - 1], &b, 1), 0);
+        for (int c : clients) close(c);
+    });
+}
+
+// With installDirect the accepted socket lands in the ring's reserved direct range, with no process
+// fd, and is driven through a Descriptor(direct, slot).
+//
+TEST(ArmedHandleTest, MultishotAcceptInstallsDirectDescriptors)
+{
+    coop::CooperatorConfiguration cfg;
+    cfg.uring.registeredSlots = 16;
+    cfg.uring.directSlots = 8;
+
+    coop::Cooperator cooperator(cfg);
+    coop::Thread thread(&cooperator);
+
+    cooperator.SubmitSync([](coop::Context* ctx)
+    {
+        auto* uring = coop::GetUring();
+        if (!uring->SupportsDirectDescriptors())
+        {
+            GTEST_SKIP() << "kernel lacks IORING_REGISTER_FILE_ALLOC_RANGE";
+        }
+
+        Listener listener;
+        coop::io::Descriptor desc(listener.fd, uring);
+        int client = listener.Connect();
+
+        coop::Coordinator coord;
+        coop::io::ArmedHandle accepts(coop::io::accepting, ctx, desc, &coord, /*installDirect=*/true);
+        accepts.Arm();
+
+        int slot = accepts.Accept();
+        ASSERT_GE(slot, 8);
+        ASSERT_LT(slot, 16);
+
+        coop::io::Descriptor conn(coop::io::direct, slot, uring);
+        ASSERT_EQ(::write(client, "direct", 6), 6);
+        char buf[16] = {};
+        EXPECT_EQ(coop::io::Recv(conn, buf, sizeof(buf)), 6);
+        EXPECT_STREQ(buf, "direct");
+
+        conn.Close();
+        char b;
+        EXPECT_EQ(::read(client, &b, 1), 0) << "clearing the slot closed the socket";
+        close(client);
+    });
+
+    cooperator.Shutdown();
+}
+
+// A ring set up for zero-copy receive reaps its 32-byte CQEs like any other. Loopback has no
+// header-split rx queue, so a zcrx queue on it refuses to register and maps nothing; the kernel's
+// error is the caller's cue to receive the usual way.
+//
+TEST(ArmedHandleTest, ZeroCopyQueueNeedsAHeaderSplitNic)
+{
+    coop::CooperatorConfiguration cfg;
+    cfg.uring.cqe32 = true;
+    cfg.uring.deferTaskrun = true;
+
+    coop::Cooperator cooperator(cfg);
+    coop::Thread thread(&cooperator);
+
+    cooperator.SubmitSync([](coop::Context*)
+    {
+        auto* uring = coop::GetUring();
+
+        SocketPair sp;
+        coop::io::Descriptor reader(dup(sp.fds[0]), uring);
+        ASSERT_EQ(::write(sp.fds[1], "wide", 4), 4);
+        char buf[16] = {};
+        EXPECT_EQ(coop::io::Recv(reader, buf, sizeof(buf)), 4);
+        EXPECT_STREQ(buf, "wide");
+
+        coop::io::ZcrxQueue queue(if_nametoindex("lo"), 0, 1 << 20);
+        EXPECT_LT(queue.Register(*uring), 0);
+        EXPECT_FALSE(queue.Registered());
+        EXPECT_EQ(queue.Area(), nullptr);
+    });
+
+    cooperator.Shutdown();
+}
+
 } // namespace
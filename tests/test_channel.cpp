@@ -1,9 +1,18 @@
 #include <gtest/gtest.h>
 
 #include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
 #include <memory>
+#include <string>
+#include <sys/wait.h>
 #include <thread>
+#include <unistd.h>
+#include <vector>
 
+#include "coop/chan/batcher.h"
+#include "coop/chan/broadcast.h"
 #include "coop/chan/channel.h"
 #include "coop/chan/select.h"
 #include "coop/self.h"
@@ -12,7 +21,12 @@
 #include "coop/chan/merge.h"
 #include "coop/chan/filter.h"
 #include "coop/chan/passage.h"
+#include "coop/chan/shared_channel.h"
+#include "coop/chan/shm_passage.h"
+#include "coop/chan/slab.h"
 #include "coop/chan/subscribe.h"
+#include "coop/time/now.h"
+#include "coop/time/sleep.h"
 #include "test_helpers.h"
 
 TEST(ChannelTest, SendRecv)
@@ -250,7 +264,7 @@ TEST(ChannelTest, SendAllBlocks)
         ch.Shutdown();
 
         while (nRecvd < 4)
-            ctx->Yield(true);
+            ctx->Yield();
 
         for (int i = 0; i < 4; i++)
             EXPECT_EQ(recvd[i], data[i]);
@@ -311,6 +325,103 @@ TEST(ChannelTest, DrainPartial)
     });
 }
 
+// SendBatch sends what fits and RecvBatch takes what is there, both in order.
+//
+TEST(ChannelTest, SendBatchRecvBatch)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::FixedChannel<int, 4> ch(ctx);
+
+        int data[] = { 1, 2, 3, 4, 5, 6 };
+        EXPECT_EQ(ch.SendBatch(data), 4u);
+        EXPECT_TRUE(ch.IsFull());
+
+        int out[3];
+        EXPECT_EQ(ch.RecvBatch(out), 3u);
+        EXPECT_EQ(out[0], 1);
+        EXPECT_EQ(out[2], 3);
+
+        EXPECT_EQ(ch.SendBatch(std::span<int>(data + 4, 2)), 2u);
+
+        int rest[8];
+        EXPECT_EQ(ch.RecvBatch(rest), 3u);
+        EXPECT_EQ(rest[0], 4);
+        EXPECT_EQ(rest[1], 5);
+        EXPECT_EQ(rest[2], 6);
+        EXPECT_TRUE(ch.IsEmpty());
+
+        ch.Shutdown();
+        EXPECT_EQ(ch.RecvBatch(rest), 0u);
+        EXPECT_EQ(ch.SendBatch(data), 0u);
+    });
+}
+
+// A full channel blocks SendBatch and an empty one blocks RecvBatch; batches on both sides move
+// every item across once each.
+//
+TEST(ChannelTest, BatchBlocking)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        int buf[4];
+        coop::chan::Channel<int> ch(ctx, buf, 4);
+
+        constexpr int N = 100;
+        std::vector<int> recvd;
+
+        ctx->GetCooperator()->Spawn([&](coop::Context*)
+        {
+            int out[3];
+            while (size_t n = ch.RecvBatch(out))
+                recvd.insert(recvd.end(), out, out + n);
+        });
+
+        std::vector<int> data(N);
+        for (int i = 0; i < N; i++)
+            data[i] = i;
+
+        std::span<int> pending(data);
+        while (!pending.empty())
+        {
+            size_t n = ch.SendBatch(pending);
+            ASSERT_GT(n, 0u);
+            pending = pending.subspan(n);
+        }
+        ch.Shutdown();
+
+        while (recvd.size() < N)
+            ctx->Yield();
+
+        for (int i = 0; i < N; i++)
+            EXPECT_EQ(recvd[i], i);
+    });
+}
+
+// Move-only items survive a partial batch: the ones that did not fit are left in place.
+//
+TEST(ChannelTest, SendBatchMoveOnly)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::FixedChannel<std::unique_ptr<int>, 2> ch(ctx);
+
+        std::unique_ptr<int> items[3];
+        for (int i = 0; i < 3; i++)
+            items[i] = std::make_unique<int>(i);
+
+        EXPECT_EQ(ch.SendBatch(items), 2u);
+        EXPECT_FALSE(items[0]);
+        ASSERT_TRUE(items[2]);
+        EXPECT_EQ(*items[2], 2);
+
+        std::unique_ptr<int> out[2];
+        EXPECT_EQ(ch.RecvBatch(out), 2u);
+        EXPECT_EQ(*out[0], 0);
+        EXPECT_EQ(*out[1], 1);
+    });
+}
+
 // Multiple senders and receivers operating concurrently on the same channel.
 //
 TEST(ChannelTest, MultipleProducersConsumers)
@@ -363,7 +474,7 @@ TEST(ChannelTest, MultipleProducersConsumers)
         //
         while (produced < TOTAL_ITEMS)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         // Shut down the channel so consumers exit their Recv loops
@@ -374,7 +485,7 @@ TEST(ChannelTest, MultipleProducersConsumers)
         //
         while (consumed < TOTAL_ITEMS)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(produced, TOTAL_ITEMS);
@@ -1607,6 +1718,29 @@ TEST(PassageTest, TryRecvAndDrain)
     });
 }
 
+// SendBatch pushes what the ring has room for; RecvBatch takes the rest of what arrived.
+//
+TEST(PassageTest, SendBatchRecvBatch)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::Passage<int, 4> passage(ctx, ctx->GetCooperator());
+
+        int data[] = { 1, 2, 3, 4, 5, 6 };
+        EXPECT_EQ(passage.SendBatch(data), 4u);
+        EXPECT_EQ(passage.SendBatch(std::span<int>(data + 4, 2)), 0u);  // ring full
+
+        int out[8]{};
+        EXPECT_EQ(passage.RecvBatch(out), 4u);
+        for (int i = 0; i < 4; i++)
+            EXPECT_EQ(out[i], i + 1);
+
+        passage.Shutdown();
+        EXPECT_EQ(passage.SendBatch(data), 0u);
+        EXPECT_EQ(passage.RecvBatch(out), 0u);
+    });
+}
+
 // Recv tuning parameters should be configurable at construction.
 //
 TEST(PassageTest, CustomRecvTuning)
@@ -1718,6 +1852,47 @@ TEST(PassageTest, SendRaceWithShutdown)
     });
 }
 
+// A producer on another cooperator posts its wakes onto the receiver's ring. With no yield phase
+// and a long timed wait, the items arrive promptly only if those wakes release the receiver.
+//
+TEST(PassageTest, CrossCooperatorProducer)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        constexpr int N = 256;
+        coop::chan::Passage<int, 64>::RecvTuning tuning;
+        tuning.yieldThreshold = 0;
+        tuning.timeoutInitialUs = 1000000;
+        tuning.timeoutMaxUs = 1000000;
+        coop::chan::Passage<int, 64> passage(ctx, ctx->GetCooperator(), tuning);
+
+        coop::Cooperator producer;
+        coop::Thread producerThread(&producer);
+        producer.Submit([&](coop::Context* sender)
+        {
+            for (int i = 0; i < N; i++)
+            {
+                while (!passage.Send(i))
+                {
+                    sender->Yield();
+                }
+            }
+            producer.Shutdown();
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        int sum = 0;
+        for (int i = 0; i < N; i++)
+        {
+            int v;
+            ASSERT_TRUE(passage.Recv(v));
+            sum += v;
+        }
+        EXPECT_EQ(sum, N * (N - 1) / 2);
+        EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    });
+}
+
 // Target cooperator shutdown should make Send fail fast.
 //
 TEST(PassageTest, SendFailsWhenTargetShuttingDown)
@@ -1786,6 +1961,44 @@ TEST(PassageTest, AdaptiveRecvShutdown)
     });
 }
 
+// Recv's wait estimate falls while items are waiting for it and jumps after an idle stretch, which
+// is what moves it between spinning and parking.
+//
+TEST(PassageTest, WaitPolicyTracksArrivals)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::Passage<int, 64> passage(ctx, ctx->GetCooperator());
+        coop::chan::Passage<int, 64>::RecvTuning tuning;
+
+        std::thread burst([&]
+        {
+            for (int i = 0; i < 32; i++)
+                EXPECT_TRUE(passage.Send(i));
+        });
+        burst.join();
+
+        int v = 0;
+        for (int i = 0; i < 32; i++)
+        {
+            ASSERT_TRUE(passage.Recv(v));
+            EXPECT_EQ(v, i);
+        }
+        EXPECT_LE(passage.ExpectedWaitUs(), tuning.spinMaxUs);
+
+        std::thread sender([&]
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            while (!passage.Send(99)) {}
+        });
+
+        ASSERT_TRUE(passage.Recv(v));
+        EXPECT_EQ(v, 99);
+        EXPECT_GT(passage.ExpectedWaitUs(), tuning.spinMaxUs);
+        sender.join();
+    });
+}
+
 // ---------------------------------------------------------------------------
 // SpscPassage tests
 // ---------------------------------------------------------------------------
@@ -1842,6 +2055,46 @@ TEST(SpscPassageTest, TryRecvAndDrain)
     });
 }
 
+// An external producer sending in batches; the receiver collects in batches, in order.
+//
+TEST(SpscPassageTest, SendBatchRecvBatch)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::SpscPassage<int, 16> passage(ctx, ctx->GetCooperator());
+
+        constexpr int N = 1000;
+        std::thread sender([&]
+        {
+            std::vector<int> data(N);
+            for (int i = 0; i < N; i++)
+                data[i] = i;
+
+            std::span<int> pending(data);
+            while (!pending.empty())
+            {
+                size_t n = passage.SendBatch(pending.first(std::min<size_t>(pending.size(), 7)));
+                if (n == 0)
+                    std::this_thread::yield();
+                pending = pending.subspan(n);
+            }
+        });
+
+        std::vector<int> recvd;
+        int out[5];
+        while (recvd.size() < N)
+        {
+            size_t n = passage.RecvBatch(out);
+            ASSERT_GT(n, 0u);
+            recvd.insert(recvd.end(), out, out + n);
+        }
+
+        sender.join();
+        for (int i = 0; i < N; i++)
+            EXPECT_EQ(recvd[i], i);
+    });
+}
+
 TEST(SpscPassageTest, ShutdownFromExternalThread)
 {
     test::RunInCooperator([](coop::Context* ctx)
@@ -1859,6 +2112,134 @@ TEST(SpscPassageTest, ShutdownFromExternalThread)
     });
 }
 
+// ---------------------------------------------------------------------------
+// ShmPassage -- the passage rings in a memfd mapping, for producers in other processes
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+struct ShmItem
+{
+    int producer;
+    int seq;
+};
+
+} // namespace
+
+// A forked producer maps the passage from the inherited fd and sends through it; the receiver
+// sees every item in order, then the producer's shutdown
+//
+TEST(ShmPassageTest, CrossProcessSendRecv)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        constexpr int COUNT = 1000;
+
+        coop::chan::ShmPassage<ShmItem, 64> passage(ctx, {.name = "test-passage"});
+        ASSERT_TRUE(passage.IsOpen()) << passage.Error();
+
+        pid_t pid = fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0)
+        {
+            coop::chan::ShmPassage<ShmItem, 64>::Sender sender(dup(passage.Fd()));
+            if (!sender.IsOpen())
+            {
+                _exit(1);
+            }
+            for (int i = 0; i < COUNT; i++)
+            {
+                while (!sender.Send(ShmItem{1, i}))
+                {
+                    usleep(10);
+                }
+            }
+            sender.Shutdown();
+            _exit(0);
+        }
+
+        int expected = 0;
+        ShmItem item{};
+        while (passage.Recv(item))
+        {
+            EXPECT_EQ(item.producer, 1);
+            EXPECT_EQ(item.seq, expected);
+            expected++;
+        }
+        EXPECT_EQ(expected, COUNT);
+
+        int status = 0;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    });
+}
+
+// A second mapping of the same memfd in this process stands in for another process: threads send
+// through it while the receiver parks
+//
+TEST(ShmPassageTest, ThreadsSendThroughSecondMapping)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        constexpr int PRODUCERS = 3;
+        constexpr int PER = 500;
+
+        coop::chan::ShmPassage<ShmItem, 128> passage(ctx);
+        ASSERT_TRUE(passage.IsOpen());
+        coop::chan::ShmPassage<ShmItem, 128>::Sender sender(dup(passage.Fd()));
+        ASSERT_TRUE(sender.IsOpen()) << sender.Error();
+
+        std::vector<std::thread> producers;
+        for (int p = 0; p < PRODUCERS; p++)
+        {
+            producers.emplace_back([&, p]
+            {
+                for (int i = 0; i < PER; i++)
+                {
+                    while (!sender.Send(ShmItem{p, i}))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        int next[PRODUCERS] = {};
+        ShmItem item{};
+        for (int n = 0; n < PRODUCERS * PER; n++)
+        {
+            ASSERT_TRUE(passage.Recv(item));
+            EXPECT_EQ(item.seq, next[item.producer]++);
+        }
+        for (auto& t : producers)
+        {
+            t.join();
+        }
+
+        passage.Shutdown();
+        EXPECT_FALSE(passage.Recv(item));
+    });
+}
+
+// A sender built for another passage type refuses the mapping
+//
+TEST(ShmPassageTest, SenderRejectsMismatchedLayout)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::ShmPassage<ShmItem, 64> passage(ctx);
+        ASSERT_TRUE(passage.IsOpen());
+
+        coop::chan::ShmPassage<ShmItem, 128>::Sender wrongCapacity(dup(passage.Fd()));
+        EXPECT_FALSE(wrongCapacity.IsOpen());
+        EXPECT_EQ(wrongCapacity.Error(), -EPROTO);
+
+        coop::chan::ShmSpscPassage<ShmItem, 64>::Sender wrongRing(dup(passage.Fd()));
+        EXPECT_FALSE(wrongRing.IsOpen());
+    });
+}
+
 // ---------------------------------------------------------------------------
 // Subscribe / Drain -- object-hosted, continuation-dispatched fan-in. The handlers are
 // run-to-completion thunks; each Drain case re-arms IN PLACE (no per-fire heap). See
@@ -1918,7 +2299,7 @@ TEST(ChannelTest, SubscribeDeliversInOrder)
             });
         }
 
-        while (total < 2 * PER) ctx->Yield(true);
+        while (total < 2 * PER) ctx->Yield();
 
         EXPECT_EQ(outOfOrder, 0);
         EXPECT_EQ(total, 2 * PER);
@@ -1964,7 +2345,7 @@ TEST(ChannelTest, SubscribeDrainsBurstInOneFire)
             for (int i = 0; i < BURST; i++) ch.Send(SubMsg{0, i});
         });
 
-        while (received < BURST) ctx->Yield(true);
+        while (received < BURST) ctx->Yield();
 
         EXPECT_EQ(outOfOrder, 0);
         EXPECT_EQ(received, BURST);
@@ -1994,7 +2375,7 @@ TEST(ChannelTest, SubscribeShutdownRetiresArm)
             ch.Send(SubMsg{0, 1});
         });
 
-        while (received < 2) ctx->Yield(true);
+        while (received < 2) ctx->Yield();
 
         ch.Shutdown();
         sub.Wait();              // join returns once the shut-down arm retires
@@ -2032,7 +2413,7 @@ TEST(ChannelTest, SubscribeControlStopRetiresOneArm)
         {
             chStop.Send(SubMsg{0, 0});
         });
-        while (stopReceived < 1) ctx->Yield(true);
+        while (stopReceived < 1) ctx->Yield();
         EXPECT_EQ(stopReceived, 1);
 
         // Subsequent sends to the stopped channel are NOT delivered; the live arm still is.
@@ -2043,7 +2424,7 @@ TEST(ChannelTest, SubscribeControlStopRetiresOneArm)
             chLive.Send(SubMsg{1, 0});
             chLive.Send(SubMsg{1, 1});
         });
-        while (liveReceived < 2) ctx->Yield(true);
+        while (liveReceived < 2) ctx->Yield();
 
         EXPECT_EQ(stopReceived, 1);         // never advanced past the Stop
         EXPECT_EQ(liveReceived, 2);
@@ -2081,7 +2462,7 @@ TEST(ChannelTest, SubscribeControlCancelAllRetiresSubscription)
         {
             ch0.Send(SubMsg{0, 0});
         });
-        while (r0 < 1) ctx->Yield(true);
+        while (r0 < 1) ctx->Yield();
         EXPECT_EQ(r0, 1);
 
         // Whole subscription is retired now: further sends to EITHER channel are not delivered.
@@ -2091,8 +2472,8 @@ TEST(ChannelTest, SubscribeControlCancelAllRetiresSubscription)
             ch0.Send(SubMsg{0, 1});
             ch1.Send(SubMsg{1, 0});
         });
-        ctx->Yield(true);
-        ctx->Yield(true);
+        ctx->Yield();
+        ctx->Yield();
 
         EXPECT_EQ(r0, 1);
         EXPECT_EQ(r1, 0);
@@ -2127,16 +2508,16 @@ TEST(ChannelTest, SubscribeWaitJoinsOnAllShutdown)
             joined = true;
         }, &waiterHandle);
 
-        ctx->Yield(true);
+        ctx->Yield();
         EXPECT_FALSE(joined);               // nothing shut down yet
 
         ch0.Shutdown();
-        ctx->Yield(true);
+        ctx->Yield();
         EXPECT_FALSE(joined);               // one arm still live
 
         ch1.Shutdown();
-        ctx->Yield(true);
-        ctx->Yield(true);
+        ctx->Yield();
+        ctx->Yield();
         EXPECT_TRUE(joined);                // both retired -> join completed
     });
 }
@@ -2180,7 +2561,7 @@ TEST(ChannelTest, SubscribeAdoptsBufferedItems)
         {
             ch.Send(SubMsg{0, 3});
         });
-        while (received < 4) ctx->Yield(true);
+        while (received < 4) ctx->Yield();
         EXPECT_EQ(received, 4);
         EXPECT_EQ(outOfOrder, 0);
 
@@ -2258,7 +2639,7 @@ TEST(ChannelTest, SubscribeDrivenThroughBaseInterface)
             ch0.Send(SubMsg{0, 0});
             ch1.Send(SubMsg{1, 0});
         });
-        while (r < 2) ctx->Yield(true);
+        while (r < 2) ctx->Yield();
         EXPECT_EQ(r, 2);
 
         // Cancel both through the base interface (no knowledge of the concrete arm types).
@@ -2275,8 +2656,8 @@ TEST(ChannelTest, SubscribeDrivenThroughBaseInterface)
             ch0.Send(SubMsg{0, 1});
             ch1.Send(SubMsg{1, 1});
         });
-        ctx->Yield(true);
-        ctx->Yield(true);
+        ctx->Yield();
+        ctx->Yield();
         EXPECT_EQ(r, 2);
 
         // Wait through a base reference -- already complete (cancelled), returns at once.
@@ -2285,3 +2666,618 @@ TEST(ChannelTest, SubscribeDrivenThroughBaseInterface)
         base.Wait();
     });
 }
+
+// ---------------------------------------------------------------------------
+// SharedChannel -- bounded MPMC across cooperators, one Receiver per consumer cooperator
+// ---------------------------------------------------------------------------
+
+// A parked Receiver is woken per item, longest-parked first: two idle Receivers and one Send
+// leave the second still parked.
+//
+TEST(SharedChannelTest, SendWakesOneParkedReceiver)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::SharedChannel<int, 8> shared;
+        coop::chan::SharedChannel<int, 8>::Receiver a(ctx, shared);
+        coop::chan::SharedChannel<int, 8>::Receiver b(ctx, shared);
+
+        EXPECT_TRUE(shared.Send(1));
+        EXPECT_FALSE(a.IsEmpty());
+        EXPECT_TRUE(b.IsEmpty());
+
+        EXPECT_TRUE(shared.Send(2));
+        EXPECT_FALSE(b.IsEmpty());
+
+        // Both buffers are full: the next item waits in the ring until a recv frees a slot
+        //
+        EXPECT_TRUE(shared.Send(3));
+        int v = 0;
+        ASSERT_TRUE(a.TryRecv(v));
+        EXPECT_EQ(v, 1);
+        ctx->Yield();
+        ASSERT_TRUE(a.TryRecv(v));
+        EXPECT_EQ(v, 3);
+        ASSERT_TRUE(b.TryRecv(v));
+        EXPECT_EQ(v, 2);
+    });
+}
+
+// Workers on three cooperators share one queue fed by a plain thread. Every item is taken
+// exactly once, and each worker sees shutdown once the queue drains.
+//
+TEST(SharedChannelTest, WorkerPool)
+{
+    constexpr int WORKERS = 3;
+    constexpr int N = 3000;
+
+    coop::chan::SharedChannel<int, 64> shared;
+    std::atomic<int64_t> sum{0};
+    std::atomic<int> taken{0};
+    std::atomic<int> ready{0};
+    int perWorker[WORKERS] = {};
+
+    std::vector<std::unique_ptr<coop::Cooperator>> cooperators;
+    std::vector<std::unique_ptr<coop::Thread>> threads;
+    for (int w = 0; w < WORKERS; w++)
+    {
+        cooperators.push_back(std::make_unique<coop::Cooperator>());
+        threads.push_back(std::make_unique<coop::Thread>(cooperators.back().get()));
+        int* count = &perWorker[w];
+        cooperators.back()->Submit([&, count](coop::Context* ctx)
+        {
+            {
+                coop::chan::SharedChannel<int, 64>::Receiver rx(ctx, shared);
+                ready.fetch_add(1);
+                int v;
+                while (rx.Recv(v))
+                {
+                    sum.fetch_add(v, std::memory_order_relaxed);
+                    taken.fetch_add(1, std::memory_order_relaxed);
+                    (*count)++;
+                }
+            }
+            ctx->GetCooperator()->Shutdown();
+        });
+    }
+
+    while (ready.load() < WORKERS)
+    {
+        std::this_thread::yield();
+    }
+    for (int i = 0; i < N; i++)
+    {
+        while (!shared.Send(i))
+        {
+            std::this_thread::yield();
+        }
+    }
+    while (taken.load() < N)
+    {
+        std::this_thread::yield();
+    }
+    shared.Shutdown();
+    threads.clear();
+
+    EXPECT_EQ(taken.load(), N);
+    EXPECT_EQ(sum.load(), int64_t(N) * (N - 1) / 2);
+    EXPECT_EQ(perWorker[0] + perWorker[1] + perWorker[2], N);
+}
+
+// A Receiver is a RecvChannel: it selects against a local channel, and a continuation fan-in
+// drains it with items sent from another cooperator.
+//
+TEST(SharedChannelTest, SelectAndSubscribe)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::SharedChannel<int, 16> shared;
+        coop::chan::SharedChannel<int, 16>::Receiver rx(ctx, shared, 4);
+        coop::chan::FixedChannel<int, 2> local(ctx);
+
+        ctx->GetCooperator()->Spawn([&](coop::Context*)
+        {
+            shared.Send(7);
+        });
+
+        int got = 0;
+        EXPECT_TRUE(coop::chan::Select(ctx,
+            coop::chan::On(rx, [&](int v) { got = v; }),
+            coop::chan::On(local, [&](int) { ADD_FAILURE(); })));
+        EXPECT_EQ(got, 7);
+
+        constexpr int N = 100;
+        int received = 0;
+        int64_t sum = 0;
+        auto sub = coop::chan::Subscribe(ctx,
+            coop::chan::Drain(rx, [&](int&& v) { received++; sum += v; }));
+
+        coop::Cooperator producer;
+        coop::Thread producerThread(&producer);
+        producer.Submit([&](coop::Context* sender)
+        {
+            for (int i = 0; i < N; i++)
+            {
+                while (!shared.Send(i))
+                {
+                    sender->Yield();
+                }
+            }
+            shared.Shutdown();
+            producer.Shutdown();
+        });
+
+        sub.Wait();
+        EXPECT_EQ(received, N);
+        EXPECT_EQ(sum, int64_t(N) * (N - 1) / 2);
+    });
+}
+
+// Items queued before Shutdown are still received; then Recv reports it
+//
+TEST(SharedChannelTest, ShutdownDrainsQueue)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::SharedChannel<int, 8> shared;
+        for (int i = 0; i < 5; i++)
+        {
+            EXPECT_TRUE(shared.Send(i));
+        }
+        shared.Shutdown();
+        EXPECT_FALSE(shared.Send(5));
+
+        coop::chan::SharedChannel<int, 8>::Receiver rx(ctx, shared, 2);
+        int v;
+        for (int i = 0; i < 5; i++)
+        {
+            ASSERT_TRUE(rx.Recv(v));
+            EXPECT_EQ(v, i);
+        }
+        EXPECT_FALSE(rx.Recv(v));
+    });
+}
+
+// ---------------------------------------------------------------------------
+// Broadcast tests
+// ---------------------------------------------------------------------------
+
+// Every reader and listener sees every item, in order, from the one copy in the ring
+//
+TEST(BroadcastTest, EveryCursorSeesEveryItem)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        using Ticks = coop::chan::Broadcast<int, 8>;
+        Ticks ticks;
+
+        constexpr int N = 100;
+        std::vector<int> seen[2];
+        for (auto& readerSeen : seen)
+        {
+            ctx->GetCooperator()->Spawn([&](coop::Context*)
+            {
+                Ticks::Reader rx(ticks);
+                int v;
+                while (rx.Recv(v))
+                    readerSeen.push_back(v);
+            });
+        }
+
+        std::vector<int> heard;
+        auto listener = coop::chan::Listen(ctx, ticks, [&](int const& v) { heard.push_back(v); },
+                                           coop::chan::Lag::Block);
+        EXPECT_EQ(ticks.Readers(), 3u);
+
+        for (int i = 0; i < N; i++)
+            EXPECT_TRUE(ticks.Send(i));
+        ticks.Shutdown();
+        EXPECT_FALSE(ticks.Send(N));
+
+        listener.Wait();
+        while (seen[0].size() < N || seen[1].size() < N)
+            ctx->Yield();
+
+        for (int i = 0; i < N; i++)
+        {
+            EXPECT_EQ(seen[0][i], i);
+            EXPECT_EQ(seen[1][i], i);
+            EXPECT_EQ(heard[i], i);
+        }
+    });
+}
+
+// A Block reader holds the writer N items ahead of it: TrySend fails and Send waits for a read
+//
+TEST(BroadcastTest, BlockHoldsWriter)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::Broadcast<int, 4> b;
+        coop::chan::Broadcast<int, 4>::Reader rx(b, coop::chan::Lag::Block);
+
+        for (int i = 0; i < 4; i++)
+            EXPECT_TRUE(b.TrySend(i));
+        EXPECT_FALSE(b.TrySend(4));
+
+        bool sent = false;
+        ctx->GetCooperator()->Spawn([&](coop::Context*)
+        {
+            sent = b.Send(4);
+        });
+        EXPECT_FALSE(sent);
+
+        int v;
+        EXPECT_TRUE(rx.TryRecv(v));
+        EXPECT_EQ(v, 0);
+        while (!sent)
+            ctx->Yield();
+
+        for (int i = 1; i <= 4; i++)
+        {
+            EXPECT_TRUE(rx.TryRecv(v));
+            EXPECT_EQ(v, i);
+        }
+        EXPECT_EQ(rx.Dropped(), 0u);
+    });
+}
+
+// A DropOldest reader that falls behind keeps the newest N items; the writer never waits
+//
+TEST(BroadcastTest, DropOldestSkipsAhead)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        coop::chan::Broadcast<int, 4> b;
+        coop::chan::Broadcast<int, 4>::Reader slow(b, coop::chan::Lag::DropOldest);
+        coop::chan::Broadcast<int, 4>::Reader fast(b, coop::chan::Lag::Block);
+
+        int v;
+        for (int i = 0; i < 10; i++)
+        {
+            EXPECT_TRUE(b.TrySend(i));
+            EXPECT_TRUE(fast.TryRecv(v));
+            EXPECT_EQ(v, i);
+        }
+
+        EXPECT_EQ(slow.Dropped(), 6u);
+        EXPECT_EQ(slow.Pending(), 4u);
+        for (int i = 6; i < 10; i++)
+        {
+            EXPECT_TRUE(slow.TryRecv(v));
+            EXPECT_EQ(v, i);
+        }
+        EXPECT_FALSE(slow.TryRecv(v));
+    });
+}
+
+// A Disconnect reader that falls behind is cut off; the others carry on
+//
+TEST(BroadcastTest, DisconnectCutsOffLaggard)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        coop::chan::Broadcast<int, 4> b;
+        coop::chan::Broadcast<int, 4>::Reader laggard(b, coop::chan::Lag::Disconnect);
+        coop::chan::Broadcast<int, 4>::Reader other(b, coop::chan::Lag::DropOldest);
+
+        for (int i = 0; i < 5; i++)
+            EXPECT_TRUE(b.TrySend(i));
+
+        EXPECT_TRUE(laggard.IsDisconnected());
+        EXPECT_EQ(b.Readers(), 1u);
+
+        int v;
+        EXPECT_FALSE(laggard.Recv(v));
+        EXPECT_TRUE(other.TryRecv(v));
+        EXPECT_EQ(v, 1);
+    });
+}
+
+// RecvKill gets what is sent, and gives up when its context is killed
+//
+TEST(BroadcastTest, RecvKillEndsOnKill)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::Broadcast<int, 4> b;
+        coop::chan::Broadcast<int, 4>::Reader rx(b);
+
+        int got = -1;
+        bool done = false;
+        coop::Context::Handle reader;
+        ctx->GetCooperator()->Spawn([&](coop::Context*)
+        {
+            while (rx.RecvKill(got)) {}
+            done = true;
+        }, &reader);
+
+        EXPECT_TRUE(b.Send(7));
+        ctx->Yield();
+        EXPECT_EQ(got, 7);
+        EXPECT_FALSE(done);
+
+        reader.Kill();
+        ctx->Yield();
+        EXPECT_TRUE(done);
+        EXPECT_FALSE(b.IsShutdown());
+    });
+}
+
+// A listener's handler may Stop it; Wait returns, and the stopped listener no longer counts
+//
+TEST(BroadcastTest, ListenerStop)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::Broadcast<int, 8> b;
+
+        int heard = 0;
+        auto listener = coop::chan::Listen(ctx, b,
+            [&](int const& v, coop::chan::Control& ctl)
+            {
+                heard++;
+                if (v == 2) ctl.Stop();
+            });
+
+        for (int i = 0; i < 6; i++)
+            EXPECT_TRUE(b.Send(i));
+
+        listener.Wait();
+        EXPECT_TRUE(listener.IsRetired());
+        EXPECT_EQ(heard, 3);
+        EXPECT_EQ(b.Readers(), 0u);
+    });
+}
+
+// ---------------------------------------------------------------------------
+// Slab tests
+// ---------------------------------------------------------------------------
+
+// Acquire hands out each buffer once; a dropped message's buffer is the next one handed out
+//
+TEST(SlabTest, AcquireAndReuse)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        coop::chan::Slab slab(1024, 2);
+
+        auto a = slab.Acquire();
+        auto b = slab.Acquire();
+        ASSERT_TRUE(a);
+        ASSERT_TRUE(b);
+        EXPECT_NE(a.Data(), b.Data());
+        EXPECT_EQ(a.Capacity(), 1024u);
+        EXPECT_FALSE(slab.Acquire());
+        EXPECT_EQ(slab.Outstanding(), 2u);
+
+        const char* data = a.Data();
+        a.Reset();
+        EXPECT_FALSE(a);
+        EXPECT_EQ(slab.Outstanding(), 1u);
+
+        auto c = slab.Acquire();
+        ASSERT_TRUE(c);
+        EXPECT_EQ(c.Data(), data);
+        EXPECT_EQ(c.Size(), 0u);
+    });
+}
+
+// Copies share one buffer, which goes back when the last of them does
+//
+TEST(SlabTest, SharedUntilLastReference)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        coop::chan::Slab slab(64, 1);
+
+        auto m = slab.Acquire();
+        memcpy(m.Data(), "hello", 5);
+        m.SetSize(5);
+        EXPECT_FALSE(m.IsShared());
+
+        coop::chan::Message copy = m;
+        EXPECT_TRUE(m.IsShared());
+        EXPECT_EQ(copy.Data(), m.Data());
+        EXPECT_EQ(copy.Size(), 5u);
+
+        m.Reset();
+        EXPECT_FALSE(copy.IsShared());
+        EXPECT_EQ(slab.Outstanding(), 1u);
+
+        copy = coop::chan::Message();
+        EXPECT_EQ(slab.Outstanding(), 0u);
+        EXPECT_TRUE(slab.Acquire());
+    });
+}
+
+// A message moves through a Channel, a Pipe stage, and a Passage as a pointer: the bytes a
+// stage sees are the ones the producer wrote, in the same buffer
+//
+TEST(SlabTest, ZeroCopyThroughPipeline)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::Slab slab(4096, 4);
+        coop::chan::FixedChannel<coop::chan::Message, 2> src(ctx);
+        coop::chan::Passage<coop::chan::Message, 4> passage(ctx, ctx->GetCooperator());
+
+        auto upper = coop::chan::Pipe(ctx, src, [](coop::chan::Message m)
+        {
+            for (size_t i = 0; i < m.Size(); i++)
+                m.Data()[i] = static_cast<char>(toupper(m.Data()[i]));
+            return m;
+        });
+
+        auto m = slab.Acquire();
+        const char* data = m.Data();
+        memcpy(m.Data(), "payload", 7);
+        m.SetSize(7);
+        EXPECT_TRUE(src.Send(std::move(m)));
+
+        coop::chan::Message out;
+        ASSERT_TRUE(upper.Chan().Recv(out));
+        EXPECT_EQ(out.Data(), data);
+        EXPECT_TRUE(passage.Send(std::move(out)));
+
+        coop::chan::Message last;
+        ASSERT_TRUE(passage.Recv(last));
+        EXPECT_EQ(last.Data(), data);
+        EXPECT_EQ(std::string(last.Data(), last.Size()), "PAYLOAD");
+        EXPECT_EQ(slab.Outstanding(), 1u);
+
+        src.Shutdown();
+    });
+}
+
+// The last reference dropping on another thread returns the buffer to the home cooperator
+//
+TEST(SlabTest, CrossThreadRelease)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        coop::chan::Slab slab(256, 1);
+
+        auto m = slab.Acquire();
+        const char* data = m.Data();
+        EXPECT_FALSE(slab.Acquire());
+
+        std::thread consumer([m = std::move(m)]() mutable
+        {
+            m.Reset();
+        });
+        consumer.join();
+
+        EXPECT_EQ(slab.Outstanding(), 0u);
+        auto again = slab.Acquire();
+        ASSERT_TRUE(again);
+        EXPECT_EQ(again.Data(), data);
+    });
+}
+
+// A batch of N goes to flush as soon as it fills, without waiting for the deadline
+//
+TEST(BatcherTest, FlushesWhenFull)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        std::vector<std::vector<int>> batches;
+        coop::chan::Batcher<int, 4> batcher(ctx, std::chrono::seconds(10),
+            [&](coop::Context*, std::span<int> batch)
+            {
+                batches.emplace_back(batch.begin(), batch.end());
+            });
+
+        for (int i = 0; i < 8; i++)
+        {
+            EXPECT_TRUE(batcher.Add(ctx, i));
+            coop::Yield();
+        }
+        ASSERT_EQ(batches.size(), 2u);
+        EXPECT_EQ(batches[0], std::vector<int>({0, 1, 2, 3}));
+        EXPECT_EQ(batches[1], std::vector<int>({4, 5, 6, 7}));
+        EXPECT_EQ(batcher.GetStats().full, 2u);
+        EXPECT_EQ(batcher.GetStats().expired, 0u);
+        batcher.Stop();
+    });
+}
+
+// A partial batch goes to flush once maxDelay has passed since its first item
+//
+TEST(BatcherTest, FlushesAtDeadline)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        std::vector<int> flushed;
+        int64_t firstUs = 0;
+        int64_t flushedUs = 0;
+        coop::chan::Batcher<int, 64> batcher(ctx, std::chrono::milliseconds(5),
+            [&](coop::Context*, std::span<int> batch)
+            {
+                flushedUs = coop::time::MonotonicMicros();
+                flushed.assign(batch.begin(), batch.end());
+            });
+
+        firstUs = coop::time::MonotonicMicros();
+        batcher.Add(ctx, 1);
+        batcher.Add(ctx, 2);
+        batcher.Add(ctx, 3);
+        coop::time::Sleep(ctx, std::chrono::milliseconds(30));
+
+        EXPECT_EQ(flushed, std::vector<int>({1, 2, 3}));
+        EXPECT_GE(flushedUs - firstUs, 5000);
+        EXPECT_EQ(batcher.GetStats().expired, 1u);
+        EXPECT_EQ(batcher.Buffered(), 0u);
+        batcher.Stop();
+    });
+}
+
+// While flush is busy the second buffer fills; past that, TryAdd refuses and Add waits
+//
+TEST(BatcherTest, SlowFlushHoldsProducersBack)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::Coordinator gate(ctx);
+        std::vector<int> flushed;
+        coop::chan::Batcher<int, 2> batcher(ctx, std::chrono::seconds(10),
+            [&](coop::Context* flushCtx, std::span<int> batch)
+            {
+                gate.Acquire(flushCtx);
+                gate.Release(flushCtx, false);
+                flushed.insert(flushed.end(), batch.begin(), batch.end());
+            });
+
+        batcher.Add(ctx, 0);
+        batcher.Add(ctx, 1);
+        coop::Yield();
+        EXPECT_TRUE(batcher.TryAdd(2));
+        EXPECT_TRUE(batcher.TryAdd(3));
+        EXPECT_FALSE(batcher.TryAdd(4));
+
+        bool added = false;
+        ctx->GetCooperator()->Spawn([&](coop::Context* producer)
+        {
+            added = batcher.Add(producer, 4);
+        });
+        EXPECT_FALSE(added);
+
+        gate.Release(ctx);
+        for (int i = 0; i < 4 && !added; i++)
+        {
+            coop::Yield();
+        }
+        EXPECT_TRUE(added);
+
+        batcher.Stop();
+        EXPECT_EQ(flushed, std::vector<int>({0, 1, 2, 3, 4}));
+    });
+}
+
+// Flush() and Stop() hand over a partial batch at once; a stopped batcher refuses items
+//
+TEST(BatcherTest, FlushAndStopHandOverPartialBatch)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        std::vector<size_t> sizes;
+        coop::chan::Batcher<int, 64> batcher(ctx, std::chrono::seconds(10),
+            [&](coop::Context*, std::span<int> batch)
+            {
+                sizes.push_back(batch.size());
+            });
+
+        batcher.Add(ctx, 1);
+        batcher.Flush();
+        coop::Yield();
+        EXPECT_EQ(sizes, std::vector<size_t>({1}));
+
+        batcher.Add(ctx, 2);
+        batcher.Add(ctx, 3);
+        batcher.Stop();
+        EXPECT_EQ(sizes, std::vector<size_t>({1, 2}));
+        EXPECT_FALSE(batcher.Add(ctx, 4));
+        EXPECT_FALSE(batcher.TryAdd(4));
+        EXPECT_EQ(batcher.GetStats().items, 3u);
+    });
+}
@@ -0,0 +1,150 @@
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "coop/concurrent_hash_map.h"
+#include "coop/cooperator.h"
+#include "coop/epoch/domain.h"
+#include "coop/thread.h"
+#include "test_helpers.h"
+
+using Map = coop::ConcurrentHashMap<uint64_t, std::string>;
+
+TEST(ConcurrentHashMapTest, InsertFindAssignErase)
+{
+    coop::epoch::Domain domain;
+    Map map(domain);
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        coop::epoch::Participant participant(domain);
+
+        EXPECT_TRUE(map.Insert(participant, 1, "one"));
+        EXPECT_FALSE(map.Insert(participant, 1, "uno"));        // present: left alone
+        EXPECT_EQ(map.Get(participant, 1), "one");
+        EXPECT_FALSE(map.Get(participant, 2).has_value());
+
+        {
+            coop::epoch::DomainGuard guard(participant);
+            std::string const* before = map.Find(guard, 1);
+            ASSERT_NE(before, nullptr);
+
+            // Replacing retires the node, but a reader pinned on it still sees the old value
+            //
+            EXPECT_FALSE(map.InsertOrAssign(participant, 1, "uno"));
+            EXPECT_EQ(*before, "one");
+            EXPECT_EQ(*map.Find(guard, 1), "uno");
+        }
+
+        EXPECT_TRUE(map.InsertOrAssign(participant, 2, "two"));
+        EXPECT_EQ(map.Size(), 2u);
+        EXPECT_TRUE(map.Erase(participant, 1));
+        EXPECT_FALSE(map.Erase(participant, 1));
+        EXPECT_EQ(map.Size(), 1u);
+
+        // The retired nodes drain as the scheduler loop quiesces
+        //
+        for (int i = 0; i < 100 && participant.PendingCount(); i++)
+        {
+            ctx->Yield();
+        }
+        EXPECT_EQ(participant.PendingCount(), 0u);
+    });
+}
+
+TEST(ConcurrentHashMapTest, GrowKeepsEveryEntry)
+{
+    coop::epoch::Domain domain;
+    Map map(domain, Map::kStripes);
+    test::RunInCooperator([&](coop::Context*)
+    {
+        coop::epoch::Participant participant(domain);
+        const uint64_t N = 10000;
+        for (uint64_t k = 0; k < N; k++)
+        {
+            ASSERT_TRUE(map.Insert(participant, k, std::to_string(k)));
+        }
+        EXPECT_GT(map.BucketCount(), Map::kStripes);
+        EXPECT_EQ(map.Size(), N);
+
+        coop::epoch::DomainGuard guard(participant);
+        for (uint64_t k = 0; k < N; k++)
+        {
+            std::string const* value = map.Find(guard, k);
+            ASSERT_NE(value, nullptr);
+            EXPECT_EQ(*value, std::to_string(k));
+        }
+    });
+}
+
+// Readers on several cooperators race a writer that keeps replacing, erasing and re-adding every
+// key, through several grows. A reader must only ever see a whole, matching value.
+//
+TEST(ConcurrentHashMapTest, ReadersAcrossCooperatorsSeeWholeValues)
+{
+    coop::epoch::Domain domain;
+    Map map(domain, Map::kStripes);
+    constexpr int kReaders = 3;
+    constexpr uint64_t kKeys = 2000;
+    std::atomic<bool> done{false};
+    std::atomic<int> bad{0};
+
+    {
+        std::vector<std::unique_ptr<coop::Cooperator>> coops;
+        std::vector<std::unique_ptr<coop::Thread>> threads;
+        for (int i = 0; i < kReaders + 1; i++)
+        {
+            coops.push_back(std::make_unique<coop::Cooperator>());
+            threads.push_back(std::make_unique<coop::Thread>(coops.back().get()));
+        }
+
+        for (int i = 0; i < kReaders; i++)
+        {
+            coops[i]->Submit([&](coop::Context* ctx)
+            {
+                coop::epoch::Participant participant(domain);
+                uint64_t k = 0;
+                while (!done.load(std::memory_order_acquire))
+                {
+                    {
+                        coop::epoch::DomainGuard guard(participant);
+                        for (int j = 0; j < 64; j++, k = (k + 1) % kKeys)
+                        {
+                            std::string const* value = map.Find(guard, k);
+                            if (value && *value != std::to_string(k))
+                            {
+                                bad++;
+                            }
+                        }
+                    }
+                    ctx->Yield();
+                }
+                ctx->GetCooperator()->Shutdown();
+            });
+        }
+
+        coops[kReaders]->Submit([&](coop::Context* ctx)
+        {
+            coop::epoch::Participant participant(domain);
+            for (size_t round = 0; round < 20; round++)
+            {
+                for (size_t k = 0; k < kKeys; k++)
+                {
+                    map.InsertOrAssign(participant, k, std::to_string(k));
+                    if (k % 3 == round % 3)
+                    {
+                        map.Erase(participant, k);
+                    }
+                }
+                ctx->Yield();
+            }
+            done.store(true, std::memory_order_release);
+            ctx->GetCooperator()->Shutdown();
+        });
+    }
+
+    EXPECT_EQ(bad.load(), 0);
+    EXPECT_EQ(domain.ParticipantCount(), 0u);
+}
@@ -107,7 +107,7 @@ TEST(ContinuationTest, DropWhilePendingCancels)
             coord.Release(a, /*schedule=*/false);   // enqueues; does not fire synchronously
         }                                           // dropped while pending -> cancelled
 
-        a->Yield(true);                             // let the loop drain -- nothing should fire
+        a->Yield();                             // let the loop drain -- nothing should fire
         EXPECT_FALSE(ran);
     });
 }
@@ -132,10 +132,10 @@ TEST(ContinuationTest, MixedContextAndContinuationWaiters)
             coord.Acquire(b);                               // blocks behind the continuation
             ctxWoke = true;
         });
-        a->Yield(true);                                     // let b run and block on coord
+        a->Yield();                                     // let b run and block on coord
 
         coord.Release(a, /*schedule=*/false);               // fires continuation (head)
-        a->Yield(true);                                     // drain -> continuation runs
+        a->Yield();                                     // drain -> continuation runs
         EXPECT_TRUE(contRan);
         EXPECT_FALSE(ctxWoke);                              // b still blocked: no handoff
 
@@ -161,7 +161,7 @@ TEST(ContinuationTest, DetachedFiresAndFrees)
         EXPECT_EQ(token.use_count(), 2);    // the detached continuation holds a copy of fn
 
         coord.Release(a, /*schedule=*/false);
-        a->Yield(true);                     // drain -> fire -> delete this
+        a->Yield();                     // drain -> fire -> delete this
 
         EXPECT_EQ(*token, 42);
         EXPECT_EQ(token.use_count(), 1);    // continuation freed itself
@@ -188,11 +188,124 @@ TEST(ContinuationTest, DetachedChain)
         });
 
         c1.Release(a, /*schedule=*/false);
-        a->Yield(true);
+        a->Yield();
         EXPECT_EQ(stage, 2);
     });
 }
 
+// Then chains stages off one continuation: each runs on the previous result as soon as it fires,
+// within the same drain, and Await on the last collects the end of the chain.
+//
+TEST(ContinuationTest, ThenChains)
+{
+    test::RunInCooperator([](Context* a)
+    {
+        Coordinator coord;
+        coord.Acquire(a);
+
+        auto read = coord.Continue([](Coordinator*) { return 20; });
+        auto doubled = Then(read, [](int n) { return n * 2; });
+        bool logged = false;
+        auto last = Then(doubled, [&](int n) { logged = true; return n + 2; });
+        EXPECT_FALSE(last.Fired());
+
+        coord.Release(a, /*schedule=*/false);
+        EXPECT_EQ(last.Await(), 42);
+        EXPECT_TRUE(logged);
+        EXPECT_TRUE(read.Fired());
+        EXPECT_TRUE(doubled.Fired());
+    });
+}
+
+// WhenAll fires only once every input has, in whatever order they complete; each input's result
+// is then collected without waiting.
+//
+TEST(ContinuationTest, WhenAllWaitsForEveryInput)
+{
+    test::RunInCooperator([](Context* a)
+    {
+        Coordinator c1, c2;
+        c1.Acquire(a);
+        c2.Acquire(a);
+
+        auto first = c1.Continue([](Coordinator*) { return 1; });
+        auto second = c2.Continue([](Coordinator*) { return 2; });
+        auto both = WhenAll(first, second);
+
+        c2.Release(a, /*schedule=*/false);
+        a->Yield();
+        EXPECT_TRUE(second.Fired());
+        EXPECT_FALSE(both.Fired());
+
+        c1.Release(a, /*schedule=*/false);
+        both.Await();
+        EXPECT_EQ(first.Take() + second.Take(), 3);
+    });
+}
+
+// WhenAny fires with the first input and cancels the rest: a loser's coordinator released later
+// finds nothing registered, and its continuation never runs.
+//
+TEST(ContinuationTest, WhenAnyCancelsLosers)
+{
+    test::RunInCooperator([](Context* a)
+    {
+        Coordinator io, timer;
+        io.Acquire(a);
+        timer.Acquire(a);
+
+        bool timedOut = false;
+        auto done = io.Continue([](Coordinator*) { return 7; });
+        auto expired = timer.Continue([&](Coordinator*) { timedOut = true; });
+        auto first = WhenAny(done, expired);
+
+        io.Release(a, /*schedule=*/false);
+        EXPECT_EQ(first.Await(), 0u);
+        EXPECT_EQ(done.Take(), 7);
+
+        timer.Release(a, /*schedule=*/false);
+        a->Yield();
+        EXPECT_FALSE(timedOut);
+        EXPECT_FALSE(expired.Fired());
+    });
+}
+
+// Combinators compose: a WhenAll racing a Then-stage, with the inner WhenAll cancelled (and its
+// inputs with it) when the other side wins.
+//
+TEST(ContinuationTest, NestedCombinatorsCancelThrough)
+{
+    test::RunInCooperator([](Context* a)
+    {
+        Coordinator c1, c2, c3;
+        c1.Acquire(a);
+        c2.Acquire(a);
+        c3.Acquire(a);
+
+        int fired = 0;
+        auto x = c1.Continue([&](Coordinator*) { fired++; });
+        auto y = c2.Continue([&](Coordinator*) { fired++; });
+        auto pair = WhenAll(x, y);
+        auto z = c3.Continue([](Coordinator*) { return 5; });
+        auto plusOne = Then(z, [](int n) { return n + 1; });
+        auto race = WhenAny(pair, plusOne);
+
+        c1.Release(a, /*schedule=*/false);
+        a->Yield();
+        EXPECT_EQ(fired, 1);
+        EXPECT_FALSE(race.Fired());
+
+        c3.Release(a, /*schedule=*/false);
+        EXPECT_EQ(race.Await(), 1u);
+        EXPECT_EQ(plusOne.Take(), 6);
+
+        c2.Release(a, /*schedule=*/false);          // y was cancelled with pair
+        a->Yield();
+        EXPECT_EQ(fired, 1);
+        EXPECT_FALSE(pair.Fired());
+    });
+}
+
 #ifndef NDEBUG
 // Red calibration for the ~Coordinator leak assert (the green case is
 // ShutdownTest.ShutdownWithBlockedContexts, where a waiter at teardown is tolerated). On a live,
@@ -230,9 +343,9 @@ TEST(ContinuationDeathTest, SuspendInsideThunkAsserts)
         {
             Coordinator coord;
             coord.Acquire(a);
-            coord.ContinueDetached([a](Coordinator*) { a->Yield(true); });   // forbidden inside Run
+            coord.ContinueDetached([a](Coordinator*) { a->Yield(); });   // forbidden inside Run
             coord.Release(a, /*schedule=*/false);                            // enqueue
-            a->Yield(true);                                                  // drain -> fire -> assert
+            a->Yield();                                                  // drain -> fire -> assert
         }),
         "must not suspend");
 }
@@ -1,7 +1,13 @@
 #include <gtest/gtest.h>
+#include <atomic>
 #include <cstdint>
+#include <string>
+#include <thread>
 
+#include "coop/cooperator_group.h"
 #include "coop/cooperator_var.hpp"
+#include "coop/http/metrics.h"
+#include "coop/sharded_counter.h"
 #include "test_helpers.h"
 
 namespace
@@ -166,4 +172,92 @@ TEST(CooperatorVarTest, IndependentAcrossCooperators)
     EXPECT_EQ(value2, 42);  // fresh default, not 111
 }
 
+// ---- ShardedCounter / ShardedGauge -----------------------------------------
+
+static coop::ShardedCounter s_hits("test_sharded_hits", "Hits counted by the sharded tests");
+static coop::ShardedGauge s_level("test_sharded_level", "Level moved by the sharded tests");
+
+// Run fn once on every member of a fresh group and wait for all of them
+//
+template<typename Fn>
+void OnEveryMember(coop::CooperatorGroup& group, Fn const& fn)
+{
+    std::atomic<int> done{0};
+    group.Broadcast([&](coop::Context*)
+    {
+        fn();
+        done.fetch_add(1);
+    });
+    while (done.load() < group.Size())
+    {
+        std::this_thread::yield();
+    }
+}
+
+// Each cooperator adds into its own slot; the total survives the cooperators exiting
+//
+TEST(ShardedCounterTest, SumsAcrossCooperators)
+{
+    uint64_t base = s_hits.Value();
+    {
+        coop::CooperatorGroup group(3);
+        OnEveryMember(group, []
+        {
+            for (int i = 0; i < 1000; i++)
+            {
+                s_hits.Add();
+            }
+            EXPECT_EQ(s_hits.Value(coop::Cooperator::thread_cooperator), 1000u);
+        });
+        EXPECT_EQ(s_hits.Value(), base + 3000);
+    }
+    EXPECT_EQ(s_hits.Value(), base + 3000);
+
+    s_hits.Add(5);
+    EXPECT_EQ(s_hits.Value(), base + 3005) << "off a cooperator, the shared fallback";
+}
+
+// A gauge raised on one cooperator and lowered on another nets out, though each share does not
+//
+TEST(ShardedCounterTest, GaugeAcrossCooperators)
+{
+    int64_t base = s_level.Value();
+    coop::CooperatorGroup group(2);
+    std::atomic<int> done{0};
+    group.SubmitTo(0, [&](coop::Context*)
+    {
+        s_level.Add(7);
+        done.fetch_add(1);
+    });
+    group.SubmitTo(1, [&](coop::Context*)
+    {
+        s_level.Sub(7);
+        s_level.Add(2);
+        done.fetch_add(1);
+    });
+    while (done.load() < 2)
+    {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(s_level.Value(), base + 2);
+}
+
+// Both are exported under their own names, one sample per cooperator
+//
+TEST(ShardedCounterTest, OpenMetricsExposition)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        s_hits.Add();
+        s_level.Add(-3);
+        std::string text = coop::http::GenerateOpenMetrics();
+        EXPECT_NE(text.find("# TYPE test_sharded_hits counter\n"), std::string::npos);
+        EXPECT_NE(text.find("# HELP test_sharded_hits Hits counted by the sharded tests\n"),
+                  std::string::npos);
+        EXPECT_NE(text.find("test_sharded_hits_total{cooperator=\""), std::string::npos);
+        EXPECT_NE(text.find("# TYPE test_sharded_level gauge\n"), std::string::npos);
+        EXPECT_NE(text.find("} -3\n"), std::string::npos) << "a gauge share may be negative";
+    });
+}
+
 } // namespace
@@ -44,7 +44,7 @@ TEST(CooperateTest, BasicCooperate)
             while (!workRan.load(std::memory_order_acquire)
                    && std::chrono::steady_clock::now() < deadline)
             {
-                ctx->Yield(true);
+                ctx->Yield();
             }
             EXPECT_TRUE(workRan.load(std::memory_order_acquire));
 
@@ -84,7 +84,7 @@ TEST(CooperateTest, CooperateFireAndForget)
             while (!workRan.load(std::memory_order_acquire)
                    && std::chrono::steady_clock::now() < deadline)
             {
-                ctx->Yield(true);
+                ctx->Yield();
             }
             EXPECT_TRUE(workRan.load(std::memory_order_acquire));
 
@@ -181,7 +181,7 @@ TEST(CooperateTest, CooperateSpawnBeforeWorkCompletes)
                     // still running when the handle fires.
                     //
                     while (!releaseGate.load(std::memory_order_acquire))
-                        wCtx->Yield(true);
+                        wCtx->Yield();
 
                     workDone.store(true, std::memory_order_release);
                 }, &handle);
@@ -199,7 +199,7 @@ TEST(CooperateTest, CooperateSpawnBeforeWorkCompletes)
             while (!workStarted.load(std::memory_order_acquire)
                    && std::chrono::steady_clock::now() < deadline)
             {
-                ctx->Yield(true);
+                ctx->Yield();
             }
             EXPECT_TRUE(workStarted.load(std::memory_order_acquire));
             EXPECT_FALSE(workDone.load(std::memory_order_acquire));
@@ -213,7 +213,7 @@ TEST(CooperateTest, CooperateSpawnBeforeWorkCompletes)
             while (!workDone.load(std::memory_order_acquire)
                    && std::chrono::steady_clock::now() < deadline)
             {
-                ctx->Yield(true);
+                ctx->Yield();
             }
             EXPECT_TRUE(workDone.load(std::memory_order_acquire));
 
@@ -223,3 +223,49 @@ TEST(CooperateTest, CooperateSpawnBeforeWorkCompletes)
 
     target.Shutdown();
 }
+
+TEST(CooperateTest, CooperateBurstCoalescesDoorbell)
+{
+    // A burst from a peer cooperator rings the target's ring doorbell once per drain rather than
+    // once per submission. Every submission must still run.
+    //
+    constexpr int N = 1000;
+
+    coop::Cooperator target;
+    coop::Thread targetThread(&target);
+
+    std::atomic<int> ran{0};
+
+    {
+        coop::Cooperator caller;
+        coop::Thread callerThread(&caller);
+
+        caller.Submit([&](coop::Context* ctx)
+        {
+            for (int i = 0; i < N; i++)
+            {
+                EXPECT_TRUE(target.Cooperate([&ran](coop::Context*)
+                {
+                    ran.fetch_add(1, std::memory_order_relaxed);
+                }));
+                if (i % 64 == 0)
+                {
+                    ctx->Yield();
+                }
+            }
+
+            auto deadline = std::chrono::steady_clock::now()
+                + std::chrono::milliseconds(2000);
+            while (ran.load(std::memory_order_acquire) < N
+                   && std::chrono::steady_clock::now() < deadline)
+            {
+                ctx->Yield();
+            }
+            EXPECT_EQ(ran.load(std::memory_order_acquire), N);
+
+            caller.Shutdown();
+        });
+    }
+
+    target.Shutdown();
+}
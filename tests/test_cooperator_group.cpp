@@ -0,0 +1,161 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "coop/cooperator.h"
+#include "coop/cooperator_group.h"
+#include "coop/context.h"
+#include "coop/time/sleep.h"
+#include "coop/topology.h"
+
+// Broadcast runs once on every member, SubmitTo on the member asked for, and the destructor shuts
+// the group down as a unit.
+//
+TEST(CooperatorGroupTest, BroadcastAndSubmitTo)
+{
+    std::atomic<int> ran{0};
+    std::atomic<int> onTarget{0};
+    {
+        coop::CooperatorGroupConfiguration config;
+        config.name = "Members";
+        coop::CooperatorGroup group(3, config);
+        ASSERT_EQ(group.Size(), 3);
+
+        EXPECT_EQ(group.Broadcast([&](coop::Context*)
+        {
+            ran.fetch_add(1);
+        }), 3);
+
+        auto* target = group.At(2);
+        EXPECT_STREQ(target->GetName(), "Members-2");
+        EXPECT_TRUE(group.SubmitTo(2, [&, target](coop::Context* ctx)
+        {
+            onTarget.fetch_add(ctx->GetCooperator() == target);
+        }));
+
+        while (ran.load() < 3 || onTarget.load() < 1)
+        {
+            std::this_thread::yield();
+        }
+    }
+    EXPECT_EQ(ran.load(), 3);
+    EXPECT_EQ(onTarget.load(), 1);
+}
+
+// With one member held busy, SubmitAny sends new work to the others.
+//
+TEST(CooperatorGroupTest, SubmitAnyAvoidsLoadedMember)
+{
+    coop::CooperatorGroup group(2);
+    std::atomic<bool> release{false};
+    std::atomic<int> started{0};
+
+    // Contexts that keep yielding keep member 0's runnable list longer than everything SubmitAny
+    // queues below
+    //
+    for (int i = 0; i < 64; i++)
+    {
+        group.SubmitTo(0, [&](coop::Context* ctx)
+        {
+            started.fetch_add(1);
+            while (!release.load() && !ctx->IsKilled())
+            {
+                ctx->Yield();
+            }
+        });
+    }
+    while (started.load() < 64)
+    {
+        std::this_thread::yield();
+    }
+
+    // The busy member republishes its load every iteration; give it one
+    //
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_GT(group.Load(0), group.Load(1));
+
+    std::atomic<int> onIdle{0};
+    std::atomic<int> done{0};
+    auto* idle = group.At(1);
+    for (int i = 0; i < 16; i++)
+    {
+        EXPECT_TRUE(group.SubmitAny([&, idle](coop::Context* ctx)
+        {
+            onIdle.fetch_add(ctx->GetCooperator() == idle);
+            done.fetch_add(1);
+        }));
+    }
+    while (done.load() < 16)
+    {
+        std::this_thread::yield();
+    }
+    release.store(true);
+
+    EXPECT_EQ(onIdle.load(), 16);
+}
+
+// Idle members share SubmitAny's work instead of all of it landing on the first.
+//
+TEST(CooperatorGroupTest, SubmitAnySpreadsAcrossIdleMembers)
+{
+    coop::CooperatorGroup group(4);
+    std::atomic<int> done{0};
+    std::set<coop::Cooperator*> used;
+    std::mutex lock;
+
+    for (int i = 0; i < 64; i++)
+    {
+        group.SubmitAny([&](coop::Context* ctx)
+        {
+            coop::time::Sleep(ctx, std::chrono::milliseconds(1));
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                used.insert(ctx->GetCooperator());
+            }
+            done.fetch_add(1);
+        });
+    }
+    while (done.load() < 64)
+    {
+        std::this_thread::yield();
+    }
+
+    EXPECT_EQ(used.size(), 4u);
+}
+
+// Members are constructed on bootstrap threads pinned where they will run, and launch on the same
+// cpus; WaitReady reports the group's time-to-ready, covering every member's own startup
+//
+TEST(CooperatorGroupTest, ParallelBootstrapWaitReady)
+{
+    coop::CooperatorGroup group(3);
+    auto ready = group.WaitReady();
+    EXPECT_GT(ready.count(), 0);
+
+    std::set<int> cpus;
+    for (int i = 0; i < group.Size(); i++)
+    {
+        auto* co = group.At(i);
+        EXPECT_GT(co->ReadyNanos(), 0);
+        EXPECT_GT(co->StartupNanos(), 0);
+        EXPECT_LE(co->StartupNanos() / 1000, ready.count());
+        if (co->CpuId() >= 0)
+        {
+            cpus.insert(co->CpuId());
+        }
+    }
+    if (!cpus.empty() && coop::GetTopology().cpus.size() >= 3)
+    {
+        EXPECT_EQ(cpus.size(), 3u) << "each member pinned to the cpu placed for it";
+    }
+
+    coop::CooperatorGroupConfiguration serial;
+    serial.parallelBootstrap = false;
+    coop::CooperatorGroup other(2, serial);
+    EXPECT_GT(other.WaitReady().count(), 0);
+}
@@ -1,7 +1,20 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "coop/barging_coordinator.h"
+#include "coop/continuation.h"
 #include "coop/coordinator.h"
+#include "coop/remote_coordinator.h"
+#include "coop/semaphore.h"
+#include "coop/shared_coordinator.h"
 #include "coop/self.h"
+#include "coop/wait_group.h"
 #include "test_helpers.h"
 
 TEST(CoordinatorTest, StartsUnheld)
@@ -100,3 +113,639 @@ TEST(CoordinatorTest, Flash)
         EXPECT_TRUE(flashed);
     });
 }
+
+// ---------------------------------------------------------------------------
+// Semaphore
+// ---------------------------------------------------------------------------
+
+TEST(SemaphoreTest, TryAcquireCounts)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::Semaphore sem(2);
+        EXPECT_TRUE(sem.TryAcquire());
+        EXPECT_TRUE(sem.TryAcquire());
+        EXPECT_FALSE(sem.TryAcquire());
+        EXPECT_EQ(sem.Available(), 0u);
+
+        sem.Release(2);
+        EXPECT_FALSE(sem.TryAcquire(3));
+        EXPECT_TRUE(sem.TryAcquire(2));
+        sem.Release(2);
+    });
+}
+
+// A batch at the head of the line holds back a smaller request behind it
+//
+TEST(SemaphoreTest, BatchServedInOrder)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::Semaphore sem(3);
+        ASSERT_TRUE(sem.TryAcquire(3));
+
+        std::vector<int> order;
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            sem.Acquire(child, 2);
+            order.push_back(2);
+        });
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            sem.Acquire(child, 1);
+            order.push_back(1);
+        });
+        EXPECT_EQ(sem.Waiting(), 2u);
+
+        sem.Release(1);
+        coop::Yield();
+        EXPECT_TRUE(order.empty());
+        EXPECT_EQ(sem.Available(), 1u);
+
+        sem.Release(1);
+        coop::Yield();
+        EXPECT_EQ(order, std::vector<int>({2}));
+        EXPECT_EQ(sem.Waiting(), 1u);
+
+        sem.Release(1);
+        coop::Yield();
+        EXPECT_EQ(order, std::vector<int>({2, 1}));
+        EXPECT_EQ(sem.Waiting(), 0u);
+        EXPECT_EQ(sem.Available(), 0u);
+    });
+}
+
+// A killed waiter leaves the line, letting the request behind it through
+//
+TEST(SemaphoreTest, KilledWaiterLeavesLine)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::Semaphore sem(1);
+        ASSERT_TRUE(sem.TryAcquire());
+
+        coop::Context::Handle handle;
+        bool killed = false;
+        bool acquired = false;
+
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            killed = sem.AcquireWithKill(child, 2).Killed();
+        }, &handle);
+
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            sem.Acquire(child);
+            acquired = true;
+        });
+
+        sem.Release();
+        coop::Yield();
+        EXPECT_FALSE(acquired);
+
+        handle.Kill();
+        coop::Yield();
+        EXPECT_TRUE(killed);
+        EXPECT_TRUE(acquired);
+        EXPECT_EQ(sem.Available(), 0u);
+        EXPECT_EQ(sem.Waiting(), 0u);
+    });
+}
+
+TEST(SemaphoreTest, AcquireWithTimeout)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::Semaphore sem(0);
+
+        auto result = sem.AcquireWith(ctx, 1, std::chrono::milliseconds(5));
+        EXPECT_TRUE(result.TimedOut());
+        EXPECT_EQ(sem.Waiting(), 0u);
+
+        sem.Release();
+        result = sem.AcquireWithKill(ctx, 1, std::chrono::milliseconds(5));
+        EXPECT_EQ(result.index, 0u);
+        EXPECT_EQ(sem.Available(), 0u);
+    });
+}
+
+// ---------------------------------------------------------------------------
+// BargingCoordinator
+// ---------------------------------------------------------------------------
+
+// The releaser takes the lock straight back with a waiter queued; the waiter, finding it held
+// when it runs, waits again and gets it at the next release
+//
+TEST(BargingCoordinatorTest, ReleaserBargesAheadOfWaiter)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::BargingCoordinator lock;
+        lock.Acquire(ctx);
+
+        bool got = false;
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            lock.Acquire(child);
+            got = true;
+            lock.Release();
+        });
+
+        lock.Release();
+        EXPECT_TRUE(lock.TryAcquire());
+        ctx->Yield();
+        EXPECT_FALSE(got);
+        EXPECT_EQ(lock.Barges(), 1u);
+
+        lock.Release();
+        ctx->Yield();
+        EXPECT_TRUE(got);
+        EXPECT_FALSE(lock.IsHeld());
+        EXPECT_EQ(lock.Handoffs(), 0u);
+    });
+}
+
+// A waiter that has lost starvationLimit times is handed the lock at the next release; 0 hands
+// it over every time, as Coordinator does
+//
+TEST(BargingCoordinatorTest, StarvationLimitHandsOver)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        for (uint32_t limit : {0u, 2u})
+        {
+            coop::BargingCoordinator lock(limit);
+            lock.Acquire(ctx);
+
+            bool got = false;
+            ctx->GetCooperator()->Spawn([&](coop::Context* child)
+            {
+                lock.Acquire(child);
+                got = true;
+                lock.Release();
+            });
+
+            for (uint32_t i = 0; i < limit; i++)
+            {
+                lock.Release();
+                EXPECT_TRUE(lock.TryAcquire());
+                ctx->Yield();
+            }
+            EXPECT_EQ(lock.Barges(), limit);
+
+            lock.Release();
+            EXPECT_TRUE(lock.IsHeld());
+            EXPECT_FALSE(lock.TryAcquire());
+            ctx->Yield();
+            EXPECT_TRUE(got);
+            EXPECT_EQ(lock.Handoffs(), 1u);
+        }
+    });
+}
+
+// Contexts yielding inside and outside the lock never overlap in it, and all finish
+//
+TEST(BargingCoordinatorTest, MutualExclusion)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::BargingCoordinator lock;
+        int inside = 0;
+        int total = 0;
+        int finished = 0;
+
+        constexpr int kContexts = 8;
+        constexpr int kRounds = 500;
+        for (int c = 0; c < kContexts; c++)
+        {
+            ctx->GetCooperator()->Spawn([&, c](coop::Context* self)
+            {
+                for (int i = 0; i < kRounds; i++)
+                {
+                    lock.Acquire(self);
+                    EXPECT_EQ(++inside, 1);
+                    if ((i + c) % 3 == 0)
+                    {
+                        self->Yield();
+                    }
+                    total++;
+                    inside--;
+                    lock.Release();
+                    if (i % 2)
+                    {
+                        self->Yield();
+                    }
+                }
+                finished++;
+            });
+        }
+        while (finished < kContexts)
+        {
+            ctx->Yield();
+        }
+
+        EXPECT_EQ(total, kContexts * kRounds);
+        EXPECT_FALSE(lock.IsHeld());
+    });
+}
+
+// ---------------------------------------------------------------------------
+// SharedCoordinator
+// ---------------------------------------------------------------------------
+
+TEST(SharedCoordinatorTest, ReadersShare)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::SharedCoordinator rw;
+        EXPECT_TRUE(rw.TryAcquireShared());
+        EXPECT_TRUE(rw.TryAcquireShared());
+        EXPECT_EQ(rw.Readers(), 2u);
+        EXPECT_FALSE(rw.TryAcquire());
+
+        rw.ReleaseShared();
+        rw.ReleaseShared();
+        EXPECT_TRUE(rw.TryAcquire());
+        EXPECT_TRUE(rw.IsHeld());
+        EXPECT_FALSE(rw.TryAcquireShared());
+        rw.Release();
+    });
+}
+
+TEST(SharedCoordinatorTest, WriterWaitsForReaders)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::SharedCoordinator rw;
+        rw.AcquireShared(ctx);
+
+        bool wrote = false;
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            rw.Acquire(child);
+            wrote = true;
+            rw.Release();
+        });
+        EXPECT_FALSE(wrote);
+        EXPECT_EQ(rw.Waiting(), 1u);
+
+        rw.ReleaseShared();
+        coop::Yield();
+        EXPECT_TRUE(wrote);
+        EXPECT_FALSE(rw.IsHeld());
+    });
+}
+
+// Preferring writers, a reader arriving behind a waiting writer queues rather than joining in
+//
+TEST(SharedCoordinatorTest, WriterPreferenceQueuesReaders)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::SharedCoordinator rw;
+        rw.AcquireShared(ctx);
+
+        std::string order;
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            rw.Acquire(child);
+            order += 'w';
+            rw.Release();
+        });
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            rw.AcquireShared(child);
+            order += 'r';
+            rw.ReleaseShared();
+        });
+        EXPECT_EQ(rw.Waiting(), 2u);
+        EXPECT_FALSE(rw.TryAcquireShared());
+
+        rw.ReleaseShared();
+        while (order.size() < 2)
+            coop::Yield();
+        EXPECT_EQ(order, "wr");
+    });
+}
+
+// Preferring readers, readers keep joining while a writer waits; it goes in once they are out
+//
+TEST(SharedCoordinatorTest, ReaderPreferenceAdmitsReaders)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::SharedCoordinator rw(coop::SharedCoordinator::Preference::Readers);
+        rw.AcquireShared(ctx);
+
+        bool wrote = false;
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            rw.Acquire(child);
+            wrote = true;
+            rw.Release();
+        });
+        EXPECT_EQ(rw.Waiting(), 1u);
+
+        bool read = false;
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            rw.AcquireShared(child);
+            read = true;
+            rw.ReleaseShared();
+        });
+        EXPECT_TRUE(read);
+        EXPECT_FALSE(wrote);
+
+        rw.ReleaseShared();
+        coop::Yield();
+        EXPECT_TRUE(wrote);
+    });
+}
+
+// Waiting alongside another coordinator: when that one wins, the shared hold is not taken
+//
+TEST(SharedCoordinatorTest, AcquireSharedWithOtherCoordinator)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::SharedCoordinator rw;
+        coop::Coordinator other(ctx);
+        rw.Acquire(ctx);
+
+        bool woke = false;
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            auto result = rw.AcquireSharedWith(child, &other);
+            EXPECT_TRUE(result == &other);
+            EXPECT_EQ(result.index, 1u);
+            other.Release(child, false);
+            woke = true;
+        });
+        EXPECT_EQ(rw.Waiting(), 1u);
+
+        other.Release(ctx, false);
+        coop::Yield();
+        EXPECT_TRUE(woke);
+        EXPECT_EQ(rw.Waiting(), 0u);
+        EXPECT_EQ(rw.Readers(), 0u);
+        rw.Release();
+    });
+}
+
+// ---------------------------------------------------------------------------
+// RemoteCoordinator
+// ---------------------------------------------------------------------------
+
+TEST(RemoteCoordinatorTest, TryAcquireRelease)
+{
+    coop::RemoteCoordinator coord;
+    EXPECT_TRUE(coord.TryAcquire());
+    EXPECT_TRUE(coord.IsHeld());
+    EXPECT_FALSE(coord.TryAcquire());
+    coord.Release();
+    EXPECT_FALSE(coord.IsHeld());
+}
+
+// Release hands the coordinator to the waiter, so it is still held until the waiter lets go
+//
+TEST(RemoteCoordinatorTest, ReleaseHandsOff)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::RemoteCoordinator coord;
+        coord.Acquire(ctx);
+
+        bool acquired = false;
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            coord.Acquire(child);
+            acquired = true;
+            coop::Yield();
+            coord.Release();
+        });
+        EXPECT_FALSE(acquired);
+
+        coord.Release();
+        EXPECT_TRUE(coord.IsHeld());
+        EXPECT_FALSE(coord.TryAcquire());
+
+        coop::Yield();
+        EXPECT_TRUE(acquired);
+        coop::Yield();
+        EXPECT_FALSE(coord.IsHeld());
+    });
+}
+
+TEST(RemoteCoordinatorTest, KilledWaiterLeavesLine)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::RemoteCoordinator coord;
+        coord.Acquire(ctx);
+
+        coop::Context::Handle handle;
+        bool killed = false;
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            killed = coord.AcquireWithKill(child).Killed();
+        }, &handle);
+
+        handle.Kill();
+        EXPECT_TRUE(killed);
+
+        // Nobody left in line: the release is the uncontended one
+        //
+        coord.Release();
+        EXPECT_FALSE(coord.IsHeld());
+    });
+}
+
+// Contexts on several cooperators take turns on one counter, each yielding while it holds the
+// coordinator. Every increment survives.
+//
+TEST(RemoteCoordinatorTest, AcrossCooperators)
+{
+    constexpr int COOPERATORS = 3;
+    constexpr int CONTEXTS = 4;
+    constexpr int ROUNDS = 200;
+
+    coop::RemoteCoordinator coord;
+    int counter = 0;
+
+    std::vector<std::unique_ptr<coop::Cooperator>> cooperators;
+    std::vector<std::unique_ptr<coop::Thread>> threads;
+    for (int c = 0; c < COOPERATORS; c++)
+    {
+        cooperators.push_back(std::make_unique<coop::Cooperator>());
+        threads.push_back(std::make_unique<coop::Thread>(cooperators.back().get()));
+        cooperators.back()->Submit([&](coop::Context* ctx)
+        {
+            int done = 0;
+            for (int i = 0; i < CONTEXTS; i++)
+            {
+                ctx->GetCooperator()->Spawn([&](coop::Context* child)
+                {
+                    for (int r = 0; r < ROUNDS; r++)
+                    {
+                        coord.Acquire(child);
+                        int seen = counter;
+                        coop::Yield();
+                        counter = seen + 1;
+                        coord.Release();
+                    }
+                    done++;
+                });
+            }
+            while (done < CONTEXTS)
+            {
+                coop::Yield();
+            }
+            ctx->GetCooperator()->Shutdown();
+        });
+    }
+
+    threads.clear();
+    EXPECT_EQ(counter, COOPERATORS * CONTEXTS * ROUNDS);
+    EXPECT_FALSE(coord.IsHeld());
+}
+
+// ---------------------------------------------------------------------------
+// WaitGroup
+// ---------------------------------------------------------------------------
+
+TEST(WaitGroupTest, JoinsSpawnedContexts)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::WaitGroup wg;
+        int finished = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            EXPECT_TRUE(wg.Spawn([&](coop::Context*)
+            {
+                coop::Yield();
+                finished++;
+            }));
+        }
+        EXPECT_EQ(wg.Count(), 4);
+
+        wg.Wait(ctx);
+        EXPECT_EQ(finished, 4);
+        EXPECT_EQ(wg.Count(), 0);
+    });
+}
+
+// An empty group does not block, and a joined one can count a new round
+//
+TEST(WaitGroupTest, EmptyAndReused)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::WaitGroup wg;
+        wg.Wait(ctx);
+
+        wg.Add(2);
+        wg.Done();
+        wg.Done();
+        wg.Wait(ctx);
+
+        wg.Add();
+        coop::Coordinator gate;
+        gate.Acquire(ctx);
+        gate.ContinueDetached([&](coop::Coordinator*) { wg.Done(); });
+        gate.Release(ctx, false);
+        wg.Wait(ctx);
+        EXPECT_EQ(wg.Count(), 0);
+    });
+}
+
+TEST(WaitGroupTest, WaitWithTimeout)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::WaitGroup wg;
+        wg.Add();
+
+        auto result = wg.WaitWithKill(ctx, std::chrono::milliseconds(5));
+        EXPECT_TRUE(result.TimedOut());
+
+        wg.Done();
+        result = wg.WaitWithKill(ctx, std::chrono::milliseconds(5));
+        EXPECT_FALSE(result.TimedOut());
+        EXPECT_FALSE(result.Killed());
+    });
+}
+
+// The last Done may land on another cooperator or a plain thread; the group opens on its home
+//
+TEST(WaitGroupTest, DoneFromElsewhere)
+{
+    constexpr int N = 16;
+
+    coop::Cooperator other;
+    coop::Thread otherThread(&other);
+
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        coop::WaitGroup wg;
+        std::atomic<int> ran{0};
+
+        wg.Add(N + 1);
+        for (int i = 0; i < N; i++)
+        {
+            ASSERT_TRUE(other.Cooperate([&](coop::Context*)
+            {
+                ran.fetch_add(1, std::memory_order_relaxed);
+                wg.Done();
+            }));
+        }
+        std::thread plain([&] { wg.Done(); });
+
+        wg.Wait(ctx);
+        EXPECT_EQ(ran.load(), N);
+        plain.join();
+    });
+
+    other.Shutdown();
+}
+
+// Home may destroy a group as soon as it sees the count at zero, with the last Done -- from
+// another cooperator or a plain thread -- still on its way to open it: the destructor waits it out
+//
+TEST(WaitGroupTest, DestroyedRightAfterRemoteDone)
+{
+    constexpr int ROUNDS = 2000;
+
+    coop::Cooperator other;
+    coop::Thread otherThread(&other);
+
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        for (int round = 0; round < ROUNDS; round++)
+        {
+            auto wg = std::make_unique<coop::WaitGroup>();
+            wg->Add();
+            coop::WaitGroup* group = wg.get();
+            std::thread plain;
+            if (round % 2)
+            {
+                ASSERT_TRUE(other.Cooperate([group](coop::Context*) { group->Done(); }));
+            }
+            else
+            {
+                plain = std::thread([group] { group->Done(); });
+            }
+            while (wg->Count() != 0)
+            {
+                ctx->Yield();
+            }
+            wg.reset();
+            if (plain.joinable())
+            {
+                plain.join();
+            }
+        }
+    });
+
+    other.Shutdown();
+}
@@ -13,10 +13,14 @@
 // times, and they would hang (not merely assert) if the bound were broken -- so a regression that
 // removes the poll fallback surfaces as a timeout.
 //
+// The handoffs (Context::YieldTo, Coordinator::ReleaseTo) share the budget, and are pinned by the
+// order in which they run their target.
+//
 
 #include <atomic>
 #include <chrono>
 #include <functional>
+#include <vector>
 
 #include <cerrno>
 #include <poll.h>
@@ -67,7 +71,7 @@ void SpawnSpinners(coop::Context* ctx, int count, std::atomic<bool>* stop)
         {
             while (!stop->load(std::memory_order_relaxed) && !c->IsKilled())
             {
-                c->Yield(true /* force */);
+                c->Yield();
             }
         });
     }
@@ -97,7 +101,7 @@ TEST(DirectYieldTest, AllContextsMakeProgress)
                 for (int r = 0; r < kRounds; ++r)
                 {
                     ++*myCount;
-                    c->Yield(true /* force */);
+                    c->Yield();
                 }
                 ++doneCount;
             });
@@ -105,7 +109,7 @@ TEST(DirectYieldTest, AllContextsMakeProgress)
 
         while (doneCount < kWorkers)
         {
-            ctx->Yield(true /* force */);
+            ctx->Yield();
         }
 
         for (int i = 0; i < kWorkers; ++i)
@@ -128,7 +132,7 @@ TEST(DirectYieldTest, BoundedPollServicesTimerUnderSpinners)
 
         // Let the spinners reach their yield loops.
         //
-        for (int i = 0; i < 16; ++i) ctx->Yield(true);
+        for (int i = 0; i < 16; ++i) ctx->Yield();
 
         const auto t0 = std::chrono::steady_clock::now();
         coop::time::SleepResult res = coop::time::Sleep(ctx, std::chrono::milliseconds(50));
@@ -182,7 +186,7 @@ TEST(DirectYieldTest, KilledInflightRecvTearsDownUnderSpinners)
         childHandle.Kill();
         while (!done)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         stop.store(true, std::memory_order_relaxed);
@@ -192,3 +196,91 @@ TEST(DirectYieldTest, KilledInflightRecvTearsDownUnderSpinners)
         close(fds[1]);
     });
 }
+
+// YieldTo switches into the named context ahead of those queued before it, with directYield off:
+// the handoff is the caller's request, not the scheduler's policy.
+//
+TEST(DirectYieldTest, YieldToRunsTargetFirst)
+{
+    coop::Cooperator co;
+    coop::Thread t(&co);
+
+    co.SubmitSync([](coop::Context* ctx)
+    {
+        constexpr int kWorkers = 3;
+        coop::Context* workers[kWorkers] = {};
+        std::vector<int> order;
+        bool stop = false;
+
+        for (int i = 0; i < kWorkers; ++i)
+        {
+            ctx->GetCooperator()->Spawn([&, i](coop::Context* c)
+            {
+                workers[i] = c;
+                while (!stop)
+                {
+                    order.push_back(i);
+                    c->Yield();
+                }
+            });
+        }
+        ctx->Yield();
+
+        order.clear();
+        ctx->YieldTo(workers[kWorkers - 1]);
+        ASSERT_FALSE(order.empty());
+        EXPECT_EQ(order.front(), kWorkers - 1);
+
+        // Not runnable: a plain yield
+        //
+        ctx->YieldTo(ctx);
+
+        stop = true;
+        ctx->Yield();
+    });
+    co.Shutdown();
+}
+
+// ReleaseTo hands the coordinator to its waiter and runs it next, ahead of a spinner that was
+// runnable first
+//
+TEST(DirectYieldTest, ReleaseToHandsOffToWaiter)
+{
+    RunWithDirectYield(64, [](coop::Context* ctx)
+    {
+        coop::Coordinator coord;
+        coord.TryAcquire(ctx);
+
+        std::vector<int> order;
+        bool done = false;
+        ctx->GetCooperator()->Spawn([&](coop::Context* c)
+        {
+            coord.Acquire(c);
+            order.push_back(1);
+            coord.Release(c, false);
+            done = true;
+        });
+
+        std::atomic<bool> stop{false};
+        ctx->GetCooperator()->Spawn([&](coop::Context* c)
+        {
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                order.push_back(2);
+                c->Yield();
+            }
+        });
+        ctx->Yield();
+
+        order.clear();
+        coord.ReleaseTo(ctx);
+        ASSERT_FALSE(order.empty());
+        EXPECT_EQ(order.front(), 1);
+
+        stop.store(true, std::memory_order_relaxed);
+        while (!done)
+        {
+            ctx->Yield();
+        }
+    });
+}
@@ -1,9 +1,19 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <semaphore>
+#include <vector>
 
+#include "coop/cooperate.h"
 #include "coop/coordinator.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator.hpp"
+#include "coop/epoch/domain.h"
 #include "coop/epoch/epoch.h"
+#include "coop/epoch/hazard.h"
 #include "coop/self.h"
+#include "coop/time/sleep.h"
 #include "test_helpers.h"
 
 namespace
@@ -40,6 +50,23 @@ inline void RunWithEpoch(std::function<void(coop::Context*, coop::epoch::Manager
     });
 }
 
+// As RunWithEpoch, on a cooperator that reclaims its manager itself, up to maxEntries entries
+// per pass
+//
+inline void RunWithEpochReclaim(uint32_t maxEntries, size_t watermark,
+                                std::function<void(coop::Context*, coop::epoch::Manager&)> fn)
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.epochReclaim.maxEntries = maxEntries;
+    cfg.epochReclaim.maxNanos = 0;
+    cfg.epochReclaim.watermark = watermark;
+
+    coop::Cooperator co(cfg);
+    coop::Thread t(&co);
+    co.SubmitSync([&](coop::Context* ctx) { fn(ctx, *coop::epoch::GetManager()); });
+    co.Shutdown();
+}
+
 } // end anon namespace
 
 // ---- Epoch counter ----
@@ -245,6 +272,120 @@ TEST(EpochTest, PartialReclaimAtEpochBoundary)
     });
 }
 
+TEST(EpochTest, BudgetedReclaimStopsAtMaxEntries)
+{
+    RunWithEpoch([](coop::Context*, coop::epoch::Manager& mgr)
+    {
+        bool reclaimed[5] = {};
+        TestEntry entries[5];
+        for (int i = 0; i < 5; i++)
+        {
+            entries[i].Init(&reclaimed[i]);
+            mgr.Retire(&entries[i]);
+        }
+
+        // Oldest first, and the remainder stays queued in order
+        //
+        EXPECT_EQ(mgr.Reclaim(2, 0), 2u);
+        EXPECT_TRUE(reclaimed[0]);
+        EXPECT_TRUE(reclaimed[1]);
+        EXPECT_FALSE(reclaimed[2]);
+        EXPECT_EQ(mgr.PendingCount(), 3u);
+
+        EXPECT_EQ(mgr.Reclaim(10, 1000000000), 3u);
+        EXPECT_TRUE(reclaimed[4]);
+        EXPECT_EQ(mgr.PendingCount(), 0u);
+        EXPECT_EQ(mgr.Reclaim(10, 0), 0u);
+    });
+}
+
+// ---- Scheduler-driven reclamation ----
+
+// Off by default: the cooperator leaves its manager alone, idle or not
+//
+TEST(EpochReclaimTest, OffByDefault)
+{
+    RunWithEpoch([](coop::Context* ctx, coop::epoch::Manager& mgr)
+    {
+        bool reclaimed = false;
+        TestEntry entry;
+        entry.Init(&reclaimed);
+        mgr.Retire(&entry);
+
+        coop::time::Sleep(ctx, std::chrono::milliseconds(1));
+        EXPECT_FALSE(reclaimed);
+        EXPECT_EQ(mgr.Reclaim(), 1u);
+    });
+}
+
+// Nothing is reclaimed while the cooperator stays busy; each time it is about to sleep it reclaims
+// one budget's worth
+//
+TEST(EpochReclaimTest, IdlePassesAreBudgeted)
+{
+    RunWithEpochReclaim(4, 0, [](coop::Context* ctx, coop::epoch::Manager& mgr)
+    {
+        bool reclaimed[10] = {};
+        TestEntry entries[10];
+        for (int i = 0; i < 10; i++)
+        {
+            entries[i].Init(&reclaimed[i]);
+            mgr.Retire(&entries[i]);
+        }
+
+        for (int i = 0; i < 20; i++)
+        {
+            ctx->Yield();
+        }
+        EXPECT_EQ(mgr.PendingCount(), 10u);
+
+        // At least one pass ran before the sleep; a spurious wake may have run another
+        //
+        coop::time::Sleep(ctx, std::chrono::milliseconds(1));
+        size_t pending = mgr.PendingCount();
+        EXPECT_TRUE(pending == 6 || pending == 2 || pending == 0) << pending;
+        EXPECT_TRUE(reclaimed[0]);
+
+        for (int i = 0; i < 10 && mgr.PendingCount() > 0; i++)
+        {
+            coop::time::Sleep(ctx, std::chrono::milliseconds(1));
+        }
+        EXPECT_EQ(mgr.PendingCount(), 0u);
+        EXPECT_TRUE(reclaimed[9]);
+    });
+}
+
+// A cooperator that never sleeps: at the watermark, every batch boundary reclaims one budget, until
+// the backlog is back below it
+//
+TEST(EpochReclaimTest, WatermarkForcesPassesWhileBusy)
+{
+    RunWithEpochReclaim(4, 8, [](coop::Context* ctx, coop::epoch::Manager& mgr)
+    {
+        bool reclaimed[20] = {};
+        TestEntry entries[20];
+        for (int i = 0; i < 20; i++)
+        {
+            entries[i].Init(&reclaimed[i]);
+            mgr.Retire(&entries[i]);
+        }
+
+        ctx->Yield();
+        EXPECT_EQ(mgr.PendingCount(), 16u);
+
+        for (int i = 0; i < 20; i++)
+        {
+            ctx->Yield();
+        }
+        EXPECT_EQ(mgr.PendingCount(), 4u);
+        EXPECT_TRUE(reclaimed[15]);
+        EXPECT_FALSE(reclaimed[16]);
+
+        coop::time::Sleep(ctx, std::chrono::milliseconds(1));
+        EXPECT_EQ(mgr.PendingCount(), 0u);
+    });
+}
+
 // ---- Cross-context pin visibility ----
 
 TEST(EpochTest, BlockedContextPinVisibleInSafeEpoch)
@@ -277,7 +418,7 @@ TEST(EpochTest, BlockedContextPinVisibleInSafeEpoch)
         EXPECT_FALSE(reclaimed);
 
         go.Release(ctx, false /* schedule */);
-        ctx->Yield(true);  // let child unpin and exit
+        ctx->Yield();  // let child unpin and exit
 
         EXPECT_EQ(mgr.Reclaim(), 1u);
         EXPECT_TRUE(reclaimed);
@@ -360,3 +501,246 @@ TEST(EpochTest, CrossCooperatorPinBlocksReclaim)
         ctx->GetCooperator()->Shutdown();
     });
 }
+
+// ---- Cross-cooperator domains ----
+
+// One cooperator, no pins: the scheduler's per-iteration Quiesce moves the domain's epoch on and
+// reclaims the entry with no explicit call
+//
+TEST(EpochDomainTest, SchedulerLoopAdvancesAndReclaims)
+{
+    coop::epoch::Domain domain;
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        coop::epoch::Participant participant(domain);
+        EXPECT_EQ(domain.ParticipantCount(), 1u);
+
+        bool reclaimed = false;
+        TestEntry entry;
+        entry.Init(&reclaimed);
+        participant.Retire(&entry);
+        EXPECT_EQ(participant.PendingCount(), 1u);
+
+        for (int i = 0; i < 100 && !reclaimed; i++)
+        {
+            ctx->Yield();
+        }
+        EXPECT_TRUE(reclaimed);
+        EXPECT_EQ(participant.PendingCount(), 0u);
+        EXPECT_GE(domain.Current(), Epoch{3});
+    });
+    EXPECT_EQ(domain.ParticipantCount(), 0u);
+}
+
+// A guard nested inside another does not move the published epoch; only the oldest pin counts
+//
+TEST(EpochDomainTest, PublishesOldestPin)
+{
+    coop::epoch::Domain domain;
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        coop::epoch::Participant participant(domain);
+        EXPECT_TRUE(participant.Published().IsAlive());
+        {
+            coop::epoch::DomainGuard outer(participant);
+            EXPECT_EQ(participant.Published(), outer.PinnedEpoch());
+            {
+                coop::epoch::DomainGuard inner(participant);
+                EXPECT_EQ(participant.Published(), outer.PinnedEpoch());
+            }
+            EXPECT_EQ(participant.Published(), outer.PinnedEpoch());
+        }
+        EXPECT_TRUE(participant.Published().IsAlive());
+    });
+}
+
+// The case a per-cooperator Manager cannot order: a reader on cooperator B holds a guard while the
+// writer on A retires. A's loop keeps quiescing, but the epoch cannot pass B's pin, so nothing is
+// reclaimed until B lets go.
+//
+TEST(EpochDomainTest, CrossCooperatorPinBlocksReclaim)
+{
+    coop::epoch::Domain domain;
+    bool reclaimed = false;
+    std::binary_semaphore pinned{0}, checked{0}, released{0};
+
+    coop::Cooperator coopA;
+    coop::Thread threadA(&coopA);
+    coop::Cooperator coopB;
+    coop::Thread threadB(&coopB);
+
+    coopB.Submit([&](coop::Context* ctx)
+    {
+        coop::epoch::Participant participant(domain);
+        {
+            coop::epoch::DomainGuard guard(participant);
+            pinned.release();
+            checked.acquire();
+        }
+        released.release();
+
+        // Stay joined until A is done, as a reader of a live structure would
+        //
+        checked.acquire();
+        ctx->GetCooperator()->Shutdown();
+    });
+
+    coopA.Submit([&](coop::Context* ctx)
+    {
+        coop::epoch::Participant participant(domain);
+        pinned.acquire();
+
+        TestEntry entry;
+        entry.Init(&reclaimed);
+        participant.Retire(&entry);
+
+        for (int i = 0; i < 100; i++)
+        {
+            ctx->Yield();
+        }
+        EXPECT_FALSE(reclaimed);
+        EXPECT_EQ(participant.PendingCount(), 1u);
+
+        checked.release();
+        released.acquire();
+
+        for (int i = 0; i < 100 && !reclaimed; i++)
+        {
+            ctx->Yield();
+        }
+        EXPECT_TRUE(reclaimed);
+
+        checked.release();
+        ctx->GetCooperator()->Shutdown();
+    });
+}
+
+// ---- Hazard pointers ----
+
+// Only the entry a hazard names is held back; the rest of the queue frees around it
+//
+TEST(HazardTest, ReclaimSkipsProtected)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::epoch::HazardDomain domain;
+        bool reclaimedA = false, reclaimedB = false;
+        TestEntry a, b;
+        a.Init(&reclaimedA);
+        b.Init(&reclaimedB);
+        std::atomic<TestEntry*> head{&a};
+
+        {
+            coop::epoch::HazardGuard hazard(ctx);
+            EXPECT_EQ(hazard.Protect(head), &a);
+            EXPECT_GE(coop::epoch::HazardDomain::RegisteredSlots(), coop::epoch::HAZARD_SLOTS);
+
+            head.store(nullptr);
+            domain.Retire(&a);
+            domain.Retire(&b);
+            EXPECT_EQ(domain.Reclaim(), 1u);
+            EXPECT_FALSE(reclaimedA);
+            EXPECT_TRUE(reclaimedB);
+            EXPECT_EQ(domain.PendingCount(), 1u);
+        }
+
+        EXPECT_EQ(domain.Reclaim(), 1u);
+        EXPECT_TRUE(reclaimedA);
+        EXPECT_EQ(domain.GetStats().deferred, 1u);
+    });
+}
+
+// The case an application pin cannot bound: a reader parks for the whole run holding one node,
+// while the writer keeps retiring. Retire scans as the queue fills, so the backlog stays at the
+// threshold instead of growing with the retirements.
+//
+TEST(HazardTest, SlowReaderBoundsBacklog)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        coop::epoch::HazardDomain domain(16);
+        coop::Coordinator parked(ctx);
+
+        constexpr size_t kEntries = 1000;
+        std::vector<TestEntry> entries(kEntries);
+        bool reclaimed[kEntries] = {};
+        for (size_t i = 0; i < kEntries; i++)
+        {
+            entries[i].Init(&reclaimed[i]);
+        }
+        std::atomic<TestEntry*> head{&entries[0]};
+
+        bool held = false;
+        co->Spawn([&](coop::Context* reader)
+        {
+            coop::epoch::HazardGuard hazard(reader);
+            held = hazard.Protect(head) == &entries[0];
+            parked.Acquire(reader);
+            parked.Release(reader);
+        });
+        EXPECT_TRUE(held);
+
+        size_t bound = std::max<size_t>(16, 2 * coop::epoch::HazardDomain::RegisteredSlots());
+        head.store(nullptr);
+        for (auto& entry : entries)
+        {
+            domain.Retire(&entry);
+            EXPECT_LE(domain.PendingCount(), bound);
+        }
+        domain.Reclaim();
+        EXPECT_EQ(domain.PendingCount(), 1u);
+        EXPECT_FALSE(reclaimed[0]);
+
+        parked.Release(ctx);
+        coop::Yield();
+        EXPECT_EQ(domain.Reclaim(), 1u);
+        EXPECT_TRUE(reclaimed[0]);
+        EXPECT_EQ(domain.GetStats().reclaimed, kEntries);
+    });
+}
+
+// A reader on another cooperator protects a node retired here
+//
+TEST(HazardTest, CrossCooperatorReaderProtects)
+{
+    bool reclaimed = false;
+    TestEntry entry;
+    entry.Init(&reclaimed);
+    std::atomic<TestEntry*> head{&entry};
+    std::binary_semaphore protectedEntry{0}, checked{0};
+
+    coop::Cooperator coopA;
+    coop::Thread threadA(&coopA);
+    coop::Cooperator coopB;
+    coop::Thread threadB(&coopB);
+
+    coopB.Submit([&](coop::Context* ctx)
+    {
+        {
+            coop::epoch::HazardGuard hazard(ctx);
+            EXPECT_EQ(hazard.Protect(head), &entry);
+            protectedEntry.release();
+            checked.acquire();
+        }
+        protectedEntry.release();
+        ctx->GetCooperator()->Shutdown();
+    });
+
+    coopA.Submit([&](coop::Context* ctx)
+    {
+        coop::epoch::HazardDomain domain;
+        protectedEntry.acquire();
+
+        head.store(nullptr);
+        domain.Retire(&entry);
+        EXPECT_EQ(domain.Reclaim(), 0u);
+        EXPECT_FALSE(reclaimed);
+
+        checked.release();
+        protectedEntry.acquire();
+        EXPECT_EQ(domain.Reclaim(), 1u);
+        EXPECT_TRUE(reclaimed);
+        ctx->GetCooperator()->Shutdown();
+    });
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -6,10 +7,13 @@
 
 #include <gtest/gtest.h>
 
+#include "coop/chan/channel.h"
+#include "coop/chan/parallel_pipe.h"
 #include "coop/context.h"
 #include "coop/self.h"
 #include "coop/thread.h"
 #include "coop/work/grid.h"
+#include "coop/work/parallel.h"
 
 using namespace coop;
 using Clock = std::chrono::steady_clock;
@@ -133,3 +137,568 @@ TEST(GridTest, ShedReusableErgNotFreed)
         EXPECT_EQ(ergs[i].runs.load(std::memory_order_relaxed), 1)
             << "caller-owned Erg " << i << " must run exactly once and survive (not be freed)";
 }
+
+// With the cross-thread wake enabled, fully backed-off stealers stop arming timers and park on their
+// doorbell; a clustered burst on one shard must still reach them (one MSG_RING wake) and spread.
+// On a kernel without MSG_RING the grid keeps the timer park, so only the balancing is asserted.
+//
+TEST(GridTest, IdleStealerWokenAcrossThreads)
+{
+    const int M = 2, N = 200;
+    std::vector<Cooperator*> coops(M);
+    std::vector<Thread*> threads(M);
+    for (int m = 0; m < M; m++) { coops[m] = new Cooperator(); threads[m] = new Thread(coops[m]); }
+
+    work::Grid grid;
+    grid.Init(M, std::chrono::microseconds(10), std::chrono::microseconds(20),
+              /*idleGrowAfter=*/1, /*wakeThreshold=*/4);
+    for (int m = 0; m < M; m++) grid.Join(coops[m]);
+
+    bool supported = false;
+    coops[0]->SubmitSync([&](Context* ctx)
+    {
+        supported = ctx->GetCooperator()->GetUring()->SupportsMessages();
+    });
+
+    // Let both stealers coast to the cap and go to sleep; once asleep, the park count stops moving.
+    //
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const uint64_t parksAsleep = grid.Parks();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    if (supported)
+    {
+        EXPECT_EQ(grid.Parks(), parksAsleep) << "deep-idle stealers must park without a timer";
+    }
+
+    std::atomic<int> remaining{N};
+    std::vector<std::atomic<int>> ranOn(M);
+    for (int m = 0; m < M; m++) ranOn[m].store(0, std::memory_order_relaxed);
+
+    coops[0]->Submit([&](Context*)
+    {
+        for (int i = 0; i < N; i++)
+        {
+            Shed([&]
+            {
+                BusyFor(5000);
+                Cooperator* me = GetCooperator();
+                for (int m = 0; m < M; m++)
+                    if (coops[m] == me) { ranOn[m].fetch_add(1, std::memory_order_relaxed); break; }
+                remaining.fetch_sub(1, std::memory_order_acq_rel);
+            });
+        }
+    });
+
+    for (int spins = 0; remaining.load(std::memory_order_acquire) > 0 && spins < 200000; spins++)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+    for (int m = 0; m < M; m++) coops[m]->Shutdown();
+    for (int m = 0; m < M; m++) { delete threads[m]; delete coops[m]; }
+
+    EXPECT_EQ(remaining.load(), 0);
+    EXPECT_GT(ranOn[1].load(std::memory_order_relaxed), 0) << "the sleeping peer must steal";
+    if (supported)
+    {
+        EXPECT_GE(grid.Wakes(), 1u);
+    }
+}
+
+// Clustered Pinned and long-patient PreferHome Ergs never leave the shedding cooperator, however
+// busy it is; with a PreferHome backlog cap of 4, the excess is exposed and idle peers steal it.
+//
+TEST(GridTest, AffinityHintsKeepErgsHome)
+{
+    const int M = 3, N = 120;
+    auto run = [&](work::Affinity affinity, int preferHomeBacklog, work::Grid& grid)
+    {
+        std::vector<Cooperator*> coops(M);
+        std::vector<Thread*> threads(M);
+        for (int m = 0; m < M; m++)
+        {
+            coops[m] = new Cooperator();
+            threads[m] = new Thread(coops[m]);
+        }
+        grid.Init(M, std::chrono::microseconds(10), std::chrono::microseconds(200), 8, 16, 4,
+                  std::chrono::seconds(10), preferHomeBacklog);
+        for (int m = 0; m < M; m++) grid.Join(coops[m]);
+
+        std::atomic<int> remaining{N};
+        std::atomic<int> away{0};
+        coops[0]->Submit([&](Context*)
+        {
+            for (int i = 0; i < N; i++)
+            {
+                Shed({.affinity = affinity}, [&]
+                {
+                    BusyFor(5000);
+                    if (GetCooperator() != coops[0]) away.fetch_add(1, std::memory_order_relaxed);
+                    remaining.fetch_sub(1, std::memory_order_acq_rel);
+                });
+            }
+        });
+
+        for (int spins = 0; remaining.load(std::memory_order_acquire) > 0 && spins < 200000;
+             spins++)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+
+        for (int m = 0; m < M; m++) coops[m]->Shutdown();
+        for (int m = 0; m < M; m++) { delete threads[m]; delete coops[m]; }
+        EXPECT_EQ(remaining.load(), 0);
+        return away.load();
+    };
+
+    work::Grid pinned;
+    EXPECT_EQ(run(work::Affinity::Pinned, 4, pinned), 0) << "a Pinned Erg is never stolen";
+
+    work::Grid patient;
+    EXPECT_EQ(run(work::Affinity::PreferHome, 1000, patient), 0);
+    EXPECT_EQ(patient.Exposed(), 0u) << "nothing aged out or overflowed the backlog";
+
+    work::Grid capped;
+    EXPECT_GT(run(work::Affinity::PreferHome, 4, capped), 0) << "the exposed excess is stolen";
+    EXPECT_GE(capped.Exposed(), (uint64_t)(N - 4));
+}
+
+// On one cooperator, High Ergs shed after a burst of Normal ones all run before any of them: the
+// stealer drains the High lane first.
+//
+TEST(GridTest, HighLaneRunsFirst)
+{
+    const int N = 50;
+    Cooperator co;
+    Thread t(&co);
+
+    work::Grid grid;
+    grid.Init(1);
+    grid.Join(&co);
+
+    std::vector<int> order;
+    std::atomic<int> remaining{2 * N};
+    co.Submit([&](Context*)
+    {
+        for (int i = 0; i < N; i++)
+        {
+            Shed([&] { order.push_back(0); remaining.fetch_sub(1, std::memory_order_release); });
+        }
+        for (int i = 0; i < N; i++)
+        {
+            Shed({.lane = work::Lane::High}, [&]
+            {
+                order.push_back(1);
+                remaining.fetch_sub(1, std::memory_order_release);
+            });
+        }
+    });
+
+    for (int spins = 0; remaining.load(std::memory_order_acquire) > 0 && spins < 200000; spins++)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    co.Shutdown();
+
+    ASSERT_EQ((int)order.size(), 2 * N);
+    for (int i = 0; i < 2 * N; i++) EXPECT_EQ(order[i], i < N ? 1 : 0) << i;
+}
+
+// A member leaving with a backlog runs its Pinned Ergs itself and hands the rest on, so every Erg
+// runs once; off the grid its Sheds are Spawns, and it can join again into the vacated shard. The
+// last member to leave runs what is left itself.
+//
+TEST(GridTest, LeaveHandsWorkOnAndRejoins)
+{
+    const int M = 3, N = 300, P = 10;
+    std::vector<Cooperator*> coops(M);
+    std::vector<Thread*> threads(M);
+    for (int m = 0; m < M; m++) { coops[m] = new Cooperator(); threads[m] = new Thread(coops[m]); }
+
+    work::Grid grid;
+    grid.Init(M);
+    for (int m = 0; m < M; m++) grid.Join(coops[m]);
+    auto waitMembers = [&](int n)
+    {
+        for (int spins = 0; grid.Members() != n && spins < 200000; spins++)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        EXPECT_EQ(grid.Members(), n);
+    };
+    waitMembers(M);
+
+    std::atomic<int> remaining{N + P};
+    std::atomic<int> pinnedAway{0};
+    auto shedFrom = [&](Cooperator* co, int n, int pinned)
+    {
+        co->Submit([&, n, pinned](Context*)
+        {
+            for (int i = 0; i < pinned; i++)
+            {
+                Shed({.affinity = work::Affinity::Pinned}, [&]
+                {
+                    if (GetCooperator() != coops[2]) pinnedAway.fetch_add(1);
+                    remaining.fetch_sub(1, std::memory_order_acq_rel);
+                });
+            }
+            for (int i = 0; i < n; i++)
+            {
+                Shed([&] { BusyFor(2000); remaining.fetch_sub(1, std::memory_order_acq_rel); });
+            }
+        });
+    };
+    auto waitDrained = [&]
+    {
+        for (int spins = 0; remaining.load(std::memory_order_acquire) > 0 && spins < 200000;
+             spins++)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        EXPECT_EQ(remaining.load(), 0);
+    };
+
+    // The shedding context runs to completion before the leave's, so the whole backlog is there
+    //
+    shedFrom(coops[2], N, P);
+    grid.Leave(coops[2]);
+    waitMembers(M - 1);
+    waitDrained();
+    EXPECT_EQ(pinnedAway.load(), 0) << "Pinned Ergs run on the leaving cooperator";
+
+    bool participating = true;
+    coops[2]->SubmitSync([&](Context* ctx)
+    {
+        participating = ctx->GetCooperator()->m_participation != nullptr;
+    });
+    EXPECT_FALSE(participating);
+
+    grid.Join(coops[2]);
+    waitMembers(M);
+    remaining.store(N);
+    shedFrom(coops[2], N, 0);
+    waitDrained();
+
+    remaining.store(N);
+    shedFrom(coops[0], N, 0);
+    for (int m = 0; m < M; m++) grid.Leave(coops[m]);
+    waitMembers(0);
+    waitDrained();
+
+    for (int m = 0; m < M; m++) coops[m]->Shutdown();
+    for (int m = 0; m < M; m++) { delete threads[m]; delete coops[m]; }
+}
+
+// A member leaving while a ParallelFor split is still on its shard, with no peer to hand it to,
+// runs the piece itself after it has given up its participation: the piece finishes unsplit, and
+// the job still covers its range once and completes on the origin.
+//
+TEST(GridTest, LeaveRunsOutstandingSplitInline)
+{
+    const int64_t N = 1 << 16;
+    Cooperator co;
+    Thread t(&co);
+
+    work::Grid grid;
+    grid.Init(1);
+    grid.Join(&co);
+    for (int spins = 0; grid.Members() != 1 && spins < 200000; spins++)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    ASSERT_EQ(grid.Members(), 1);
+
+    std::vector<std::atomic<int>> hits(N);
+    for (auto& h : hits) h.store(0, std::memory_order_relaxed);
+    std::atomic<bool> done{false};
+
+    // The leave is queued first, so it runs before the stealer gets to the shed upper half
+    //
+    co.SubmitSync([&](Context*)
+    {
+        grid.Leave(&co);
+        work::ParallelFor(work::Range{0, N}, 64, [&](work::Range r)
+        {
+            for (int64_t i = r.begin; i < r.end; i++) hits[i].fetch_add(1);
+        }, [&] { done.store(true, std::memory_order_release); });
+    });
+
+    for (int spins = 0; !done.load(std::memory_order_acquire) && spins < 200000; spins++)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    EXPECT_TRUE(done.load());
+    for (int spins = 0; grid.Members() != 0 && spins < 200000; spins++)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    EXPECT_EQ(grid.Members(), 0);
+    for (int64_t i = 0; i < N; i++) ASSERT_EQ(hits[i].load(std::memory_order_relaxed), 1) << i;
+
+    co.Shutdown();
+}
+
+// Slab-allocated Ergs freed on another thread go back to the owning cooperator's slab through its
+// return list, and the owner reuses those blocks once its local free list runs dry. Owner-thread frees
+// are reused immediately; oversized requests bypass the slab.
+//
+TEST(GridTest, ErgSlabReusesRemoteFrees)
+{
+    const int N = 8;
+    Cooperator co;
+    Thread t(&co);
+    work::ErgSlab slab;
+
+    int runs = 0;
+    std::vector<work::Erg*> ergs;
+    co.SubmitSync([&](Context*)
+    {
+        slab.Bind(&co);
+
+        void* p = slab.Allocate(32);
+        work::ErgSlab::Free(p);
+        EXPECT_EQ(slab.Allocate(32), p) << "an owner-thread free is reused directly";
+        work::ErgSlab::Free(p);
+        EXPECT_EQ(slab.Allocate(32), p);
+        work::ErgSlab::Free(p);
+
+        for (int i = 0; i < N; i++) ergs.push_back(work::MakeErg(slab, [&] { runs++; }));
+        work::ErgSlab::Free(slab.Allocate(4096));
+    });
+
+    // This thread is not the owner: every free takes the remote return path
+    //
+    for (work::Erg* e : ergs) work::RunErg(e);
+    EXPECT_EQ(runs, N);
+
+    co.SubmitSync([&](Context*)
+    {
+        EXPECT_EQ(slab.RemoteReturns(), 0u);
+        std::vector<work::Erg*> again;
+        for (int i = 0; i < N; i++) again.push_back(work::MakeErg(slab, [] {}));
+        EXPECT_EQ(slab.RemoteReturns(), (uint64_t)N) << "one drain brings the whole batch back";
+        for (work::Erg* e : again)
+        {
+            EXPECT_NE(std::find(ergs.begin(), ergs.end(), e), ergs.end());
+            work::RunErg(e);
+        }
+    });
+
+    co.Shutdown();
+}
+
+// An unbound slab -- one a leaving member retired -- is reclaimable once every block it handed out
+// has come back, however it came back
+//
+TEST(GridTest, RetiredErgSlabReclaimsWhenAllBack)
+{
+    Cooperator co;
+    Thread t(&co);
+    work::ErgSlab slab;
+
+    std::vector<work::Erg*> ergs;
+    co.SubmitSync([&](Context*)
+    {
+        slab.Bind(&co);
+        for (int i = 0; i < 4; i++) ergs.push_back(work::MakeErg(slab, [] {}));
+        work::RunErg(ergs.back());                           // back on the owner, locally
+        ergs.pop_back();
+        slab.Bind(nullptr);
+        EXPECT_FALSE(slab.Reclaimable());
+        work::RunErg(ergs.back());                           // on the owner's thread, but unbound
+        ergs.pop_back();
+    });
+    EXPECT_FALSE(slab.Reclaimable());
+
+    std::thread elsewhere([&] { work::RunErg(ergs.back()); });
+    elsewhere.join();
+    ergs.pop_back();
+    EXPECT_FALSE(slab.Reclaimable());
+    work::RunErg(ergs.back());
+    EXPECT_TRUE(slab.Reclaimable());
+
+    co.Shutdown();
+}
+
+// Members joining and leaving over and over while work is shed leave no slabs behind once it has
+// all run
+//
+TEST(GridTest, JoinLeaveCyclesReapSlabs)
+{
+    const int M = 2, ROUNDS = 50, N = 32;
+    std::vector<Cooperator*> coops(M);
+    std::vector<Thread*> threads(M);
+    for (int m = 0; m < M; m++) { coops[m] = new Cooperator(); threads[m] = new Thread(coops[m]); }
+
+    work::Grid grid;
+    grid.Init(M);
+    grid.Join(coops[0]);
+    std::atomic<int> remaining{0};
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        // All the last round's Ergs have run, so this Join reaps its slab
+        //
+        for (int spins = 0; remaining.load() > 0 && spins < 200000; spins++)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        grid.Join(coops[1]);
+        for (int spins = 0; grid.Members() != M && spins < 200000; spins++)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        remaining.fetch_add(N);
+        coops[1]->SubmitSync([&](Context*)
+        {
+            for (int i = 0; i < N; i++) Shed([&] { remaining.fetch_sub(1); });
+        });
+        grid.Leave(coops[1]);
+        for (int spins = 0; grid.Members() != 1 && spins < 200000; spins++)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    for (int spins = 0; remaining.load() > 0 && spins < 200000; spins++)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    EXPECT_EQ(remaining.load(), 0);
+    EXPECT_LE(grid.RetiredSlabs(), 1u) << "only the last leave's slab may still be waiting";
+
+    for (int m = 0; m < M; m++) coops[m]->Shutdown();
+    for (int m = 0; m < M; m++) { delete threads[m]; delete coops[m]; }
+}
+
+// ParallelFor covers every index exactly once across the grid, for both the blocking form and the
+// continuation form (whose done runs back on the calling cooperator).
+//
+TEST(GridTest, ParallelForCoversRangeOnce)
+{
+    const int M = 3;
+    const int64_t N = 50000;
+    std::vector<Cooperator*> coops(M);
+    std::vector<Thread*> threads(M);
+    for (int m = 0; m < M; m++) { coops[m] = new Cooperator(); threads[m] = new Thread(coops[m]); }
+
+    work::Grid grid;
+    grid.Init(M);
+    for (int m = 0; m < M; m++) grid.Join(coops[m]);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::vector<std::atomic<int>> hits(N);
+    for (auto& h : hits) h.store(0, std::memory_order_relaxed);
+    auto body = [&](work::Range r)
+    {
+        for (int64_t i = r.begin; i < r.end; i++) hits[i].fetch_add(1, std::memory_order_relaxed);
+    };
+
+    bool doneOnOrigin = false;
+    coops[0]->SubmitSync([&](Context* ctx)
+    {
+        work::ParallelFor(work::Range{0, N}, 64, body);
+        for (int64_t i = 0; i < N; i++) ASSERT_EQ(hits[i].load(std::memory_order_relaxed), 1) << i;
+
+        bool done = false;
+        work::ParallelFor(work::Range{0, N}, 64, body, [&]
+        {
+            doneOnOrigin = GetCooperator() == coops[0];
+            done = true;
+        });
+        while (!done) ctx->Yield();
+    });
+
+    for (int64_t i = 0; i < N; i++) ASSERT_EQ(hits[i].load(std::memory_order_relaxed), 2) << i;
+    EXPECT_TRUE(doneOnOrigin);
+
+    for (int m = 0; m < M; m++) coops[m]->Shutdown();
+    for (int m = 0; m < M; m++) { delete threads[m]; delete coops[m]; }
+}
+
+// ParallelReduce folds partials in range order, so a non-commutative (but associative) combine --
+// concatenation -- reproduces the sequential result. Off-grid it runs inline.
+//
+TEST(GridTest, ParallelReduceKeepsRangeOrder)
+{
+    const int M = 3;
+    const int64_t N = 20000;
+    std::vector<Cooperator*> coops(M);
+    std::vector<Thread*> threads(M);
+    for (int m = 0; m < M; m++) { coops[m] = new Cooperator(); threads[m] = new Thread(coops[m]); }
+
+    work::Grid grid;
+    grid.Init(M);
+    for (int m = 0; m < M; m++) grid.Join(coops[m]);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    using Seq = std::vector<int64_t>;
+    auto fold = [](work::Range r, Seq acc)
+    {
+        for (int64_t i = r.begin; i < r.end; i++) acc.push_back(i);
+        return acc;
+    };
+    auto concat = [](Seq a, Seq b)
+    {
+        a.insert(a.end(), b.begin(), b.end());
+        return a;
+    };
+
+    Seq onGrid;
+    coops[0]->SubmitSync([&](Context*)
+    {
+        onGrid = work::ParallelReduce(work::Range{0, N}, 32, Seq{}, fold, concat);
+    });
+    ASSERT_EQ((int64_t)onGrid.size(), N);
+    for (int64_t i = 0; i < N; i++) ASSERT_EQ(onGrid[i], i);
+
+    for (int m = 0; m < M; m++) coops[m]->Shutdown();
+    for (int m = 0; m < M; m++) { delete threads[m]; delete coops[m]; }
+
+    Cooperator solo;
+    Thread soloThread(&solo);
+    Seq offGrid;
+    solo.SubmitSync([&](Context*)
+    {
+        offGrid = work::ParallelReduce(work::Range{0, 100}, 8, Seq{}, fold, concat);
+    });
+    ASSERT_EQ(offGrid.size(), 100u);
+    EXPECT_EQ(offGrid.back(), 99);
+    solo.Shutdown();
+}
+
+// A ParallelPipe sheds its transforms across the grid, and its reorder buffer hands the results on
+// in source order even though the items take uneven time. Off-grid it runs the same stage on the
+// one cooperator.
+//
+TEST(GridTest, ParallelPipeKeepsSourceOrder)
+{
+    const int M = 3, N = 200;
+    std::vector<Cooperator*> coops(M);
+    std::vector<Thread*> threads(M);
+    for (int m = 0; m < M; m++) { coops[m] = new Cooperator(); threads[m] = new Thread(coops[m]); }
+
+    work::Grid grid;
+    grid.Init(M);
+    for (int m = 0; m < M; m++) grid.Join(coops[m]);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    auto square = [](int v)
+    {
+        BusyFor((v % 7) * 20000);                           // later items often finish first
+        return v * v;
+    };
+
+    auto run = [&](Cooperator* co, size_t parallelism)
+    {
+        std::vector<int> out;
+        co->SubmitSync([&](Context* ctx)
+        {
+            chan::FixedChannel<int, 8> src(ctx);
+            auto pipe = chan::ParallelPipe<4>(ctx, src, square, parallelism);
+            EXPECT_EQ(pipe.Parallelism(), parallelism);
+
+            ctx->GetCooperator()->Spawn([&](Context*)
+            {
+                for (int i = 0; i < N; i++) src.Send(i);
+                src.Shutdown();
+            });
+
+            int v = 0;
+            while (pipe.Chan().Recv(v)) out.push_back(v);
+        });
+        return out;
+    };
+
+    std::vector<int> onGrid = run(coops[0], 8);
+    ASSERT_EQ((int)onGrid.size(), N);
+    for (int i = 0; i < N; i++) ASSERT_EQ(onGrid[i], i * i) << i;
+
+    for (int m = 0; m < M; m++) coops[m]->Shutdown();
+    for (int m = 0; m < M; m++) { delete threads[m]; delete coops[m]; }
+
+    Cooperator solo;
+    Thread soloThread(&solo);
+    std::vector<int> offGrid = run(&solo, 4);
+    ASSERT_EQ((int)offGrid.size(), N);
+    EXPECT_EQ(offGrid.back(), (N - 1) * (N - 1));
+    solo.Shutdown();
+}
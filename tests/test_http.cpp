@@ -1,18 +1,51 @@
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <limits>
+#include <netinet/in.h>
 #include <sys/socket.h>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 #include <gtest/gtest.h>
+#include <zlib.h>
 
 #include "coop/alloc.h"
 #include "coop/cooperator.h"
 #include "coop/self.h"
+#include "coop/topology.h"
+#include "coop/io/buffer_ring.h"
 #include "coop/io/descriptor.h"
+#include "coop/io/pass_fds.h"
 #include "coop/io/recv.h"
 #include "coop/io/send.h"
+#include "coop/time/sleep.h"
+#include "coop/http/admission.h"
+#include "coop/http/asset_cache.h"
 #include "coop/http/connection.h"
+#include "coop/http/hpack.h"
+#include "coop/http/http2.h"
+#include "coop/http/http2_client.h"
+#include "coop/http/json_writer.h"
+#include "coop/http/percent.h"
+#include "coop/http/response_cache.h"
+#include "coop/http/response_template.h"
 #include "coop/http/client.h"
+#include "coop/http/client_pool.h"
+#include "coop/http/common_headers.h"
+#include "coop/http/compression.h"
+#include "coop/http/event_stream.h"
+#include "coop/http/file_response.h"
+#include "coop/http/header_set.h"
+#include "coop/http/proxy.h"
+#include "coop/http/route_metrics.h"
+#include "coop/http/router.h"
+#include "coop/http/scan.h"
+#include "coop/http/server.h"
 #include "coop/http/transport.h"
 
 using HttpConn = coop::http::Connection<coop::http::PlaintextTransport>;
@@ -314,6 +347,117 @@ TEST(HttpTest, ChunkedBody)
     });
 }
 
+TEST(HttpTest, ChunkedBodyFraming)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto readBody = [&](const char* chunks, bool* keepAlive)
+        {
+            SocketPair sp;
+            auto* uring = coop::GetUring();
+            coop::io::Descriptor client(sp.fds[0], uring);
+            coop::io::Descriptor server(sp.fds[1], uring);
+            std::string request = std::string("POST /upload HTTP/1.1\r\n"
+                                              "Transfer-Encoding: chunked\r\n\r\n") + chunks;
+            SendString(client, request.c_str());
+
+            coop::http::PlaintextTransport transport(server);
+            auto conn = ctx->Allocate<HttpConn>(HTTP_EXTRA,
+                transport, ctx, ctx->GetCooperator());
+            EXPECT_NE(conn->GetRequestLine(), nullptr);
+            std::string body;
+            while (auto* chunk = conn->ReadBody())
+            {
+                body.append(static_cast<const char*>(chunk->data), chunk->size);
+            }
+            *keepAlive = conn->KeepAlive();
+            return body;
+        };
+
+        // Extensions, whitespace before them, either case of hex, leading zeros
+        //
+        bool keepAlive = false;
+        EXPECT_EQ(readBody("5;name=v\r\nHello\r\nA \t;x\r\n0123456789\r\n"
+                           "0000000000000002\r\nab\r\n0\r\n\r\n", &keepAlive),
+                  "Hello0123456789ab");
+        EXPECT_TRUE(keepAlive);
+
+        // Not hex, no digits, more than 16 digits, data without its CRLF: the body ends there
+        // and the connection is not kept
+        //
+        for (const char* bad : {"5x\r\nHello\r\n0\r\n\r\n", ";x\r\nHello\r\n0\r\n\r\n",
+                                "00000000000000005\r\nHello\r\n0\r\n\r\n",
+                                "5\r\nHelloXX0\r\n\r\n"})
+        {
+            std::string body = readBody(bad, &keepAlive);
+            EXPECT_FALSE(keepAlive) << bad;
+            EXPECT_TRUE(body.empty() || body == "Hello") << bad;
+        }
+    });
+}
+
+// -------------------------------------------------------------------------------------
+// Request body straight to a file
+// -------------------------------------------------------------------------------------
+
+// A Content-Length body and a chunked one, each larger than the recv buffer, so most of both goes
+// by splice; what the first recv buffered is copied. The file ends up with both, framing stripped.
+//
+TEST(HttpTest, ReceivesBodyToFile)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        fcntl(sp.fds[1], F_SETFL, fcntl(sp.fds[1], F_GETFL) | O_NONBLOCK);
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        std::string plain(200000, '\0');
+        std::string chunked(100000, '\0');
+        for (size_t i = 0; i < plain.size(); i++) plain[i] = char('a' + i % 26);
+        for (size_t i = 0; i < chunked.size(); i++) chunked[i] = char('0' + i % 10);
+
+        std::string wire = "POST /a HTTP/1.1\r\nContent-Length: 200000\r\n\r\n" + plain
+            + "POST /b HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nxyz\r\n186a0\r\n"
+            + chunked + "\r\n0\r\n\r\n";
+        std::thread writer([&]
+        {
+            for (size_t at = 0; at < wire.size();)
+            {
+                ssize_t n = ::send(sp.fds[0], wire.data() + at, wire.size() - at, 0);
+                if (n <= 0) break;
+                at += size_t(n);
+            }
+        });
+
+        char path[] = "/tmp/coop_upload_XXXXXX";
+        int fd = mkstemp(path);
+        unlink(path);
+        coop::io::Descriptor file(fd, uring);
+
+        coop::http::PlaintextTransport transport(server);
+        auto conn = ctx->Allocate<HttpConn>(HTTP_EXTRA,
+            transport, ctx, ctx->GetCooperator());
+
+        bool first = conn->GetRequestLine() != nullptr;
+        int64_t plainBytes = first ? conn->ReceiveBodyToFile(file) : -1;
+        conn->Reset();
+        bool second = conn->GetRequestLine() != nullptr;
+        int64_t chunkedBytes = second ? conn->ReceiveBodyToFile(file) : -1;
+        writer.join();
+
+        EXPECT_EQ(plainBytes, 200000);
+        EXPECT_EQ(chunkedBytes, 100003);
+        EXPECT_TRUE(conn->KeepAlive()) << "both bodies read to the end";
+
+        std::string expected = plain + "xyz" + chunked;
+        std::string written(expected.size() + 1, '\0');
+        EXPECT_EQ(pread(fd, written.data(), written.size(), 0), ssize_t(expected.size()));
+        written.resize(expected.size());
+        EXPECT_TRUE(written == expected);
+    });
+}
+
 // -------------------------------------------------------------------------------------
 // Skip APIs — skip args, go straight to headers
 // -------------------------------------------------------------------------------------
@@ -383,6 +527,77 @@ TEST(HttpTest, SkipHeadersToBody)
     });
 }
 
+TEST(HttpTest, CapturesHeaderSet)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        SendString(client,
+            "POST /data HTTP/1.1\r\n"
+            "Host: example.com\r\n"
+            "user-AGENT: test/1.0\r\n"
+            "Cookie: a=1\r\n"
+            "Content-Length: 4\r\n"
+            "X-Extra: ignored\r\n"
+            "COOKIE: b=2\r\n"
+            "\r\n"
+            "test"
+            "GET /next HTTP/1.1\r\n"
+            "Host: other.com\r\n"
+            "\r\n");
+
+        static const coop::http::HeaderSet wanted = {
+            coop::http::header::USER_AGENT,
+            coop::http::header::COOKIE,
+            coop::http::header::HOST,
+            coop::http::header::AUTHORIZATION,
+        };
+
+        coop::http::PlaintextTransport transport(server);
+        auto conn = ctx->Allocate<HttpConn>(HTTP_EXTRA,
+            transport, ctx, ctx->GetCooperator());
+        conn->GetRequestLine();
+        conn->CaptureHeaders(wanted);
+
+        // The handler may read headers itself too: the ones it reads are still captured
+        //
+        const char* name = conn->NextHeaderName();
+        ASSERT_NE(name, nullptr);
+        EXPECT_STREQ(name, "Host");
+        auto* value = conn->ReadHeaderValue();
+        ASSERT_NE(value, nullptr);
+        EXPECT_EQ(std::string(static_cast<const char*>(value->data), value->size), "example.com");
+
+        EXPECT_EQ(conn->Header(coop::http::header::USER_AGENT), "test/1.0");
+        EXPECT_EQ(conn->Header(coop::http::header::HOST), "example.com");
+        EXPECT_EQ(conn->Header(coop::http::header::COOKIE), "a=1, b=2");
+        EXPECT_FALSE(conn->Header(coop::http::header::AUTHORIZATION).has_value());
+        EXPECT_FALSE(conn->Header(coop::http::header::ACCEPT).has_value());
+        EXPECT_EQ(conn->ContentLength(), 4);
+
+        std::string body;
+        while (auto* chunk = conn->ReadBody())
+        {
+            body.append(static_cast<const char*>(chunk->data), chunk->size);
+            if (chunk->complete) break;
+        }
+        EXPECT_EQ(body, "test");
+
+        // Reset forgets the set: the next request captures nothing unless asked again
+        //
+        conn->Reset();
+        EXPECT_EQ(conn->GetRequestLine()->path, "/next");
+        EXPECT_FALSE(conn->Header(coop::http::header::HOST).has_value());
+        conn->CaptureHeaders(wanted);
+        EXPECT_EQ(conn->Header(coop::http::header::HOST), "other.com");
+        EXPECT_FALSE(conn->Header(coop::http::header::COOKIE).has_value());
+    });
+}
+
 // -------------------------------------------------------------------------------------
 // Send response
 // -------------------------------------------------------------------------------------
@@ -417,6 +632,49 @@ TEST(HttpTest, SendResponse)
     });
 }
 
+TEST(HttpTest, DateAndCommonHeaders)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        EXPECT_FALSE(coop::http::response::RegisterCommonHeaders("X-Frame-Options: DENY"));
+        ASSERT_TRUE(coop::http::response::RegisterCommonHeaders(
+            "X-Frame-Options: DENY\r\nAccess-Control-Allow-Origin: *\r\n"));
+
+        // A ticking clock and the on-demand path agree on the format
+        //
+        std::string onDemand(coop::http::response::DateHeader().data,
+                             coop::http::response::DateHeader().size);
+        coop::http::response::DateClock clock(ctx);
+        auto date = coop::http::response::DateHeader();
+        std::string ticked(date.data, date.size);
+        EXPECT_EQ(ticked.size(), onDemand.size());
+        EXPECT_EQ(ticked.size(), strlen("Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"));
+        EXPECT_EQ(ticked.substr(ticked.size() - 6), " GMT\r\n");
+        EXPECT_EQ(ticked[9], ',');
+
+        SendString(client, "GET / HTTP/1.1\r\n\r\n");
+
+        coop::http::PlaintextTransport transport(server);
+        auto conn = ctx->Allocate<HttpConn>(HTTP_EXTRA,
+            transport, ctx, ctx->GetCooperator());
+        conn->GetRequestLine();
+        conn->Send(200, "text/plain", "OK!\n");
+        server.Close();
+
+        std::string resp = RecvAll(client);
+        EXPECT_EQ(resp.find("HTTP/1.1 200 OK\r\nDate: "), 0u);
+        EXPECT_NE(resp.find(" GMT\r\nX-Frame-Options: DENY\r\nAccess-Control-Allow-Origin: *\r\n"
+                            "Content-Type: text/plain\r\n"), std::string::npos);
+
+        coop::http::response::ClearCommonHeaders();
+    });
+}
+
 // -------------------------------------------------------------------------------------
 // Chunked response
 // -------------------------------------------------------------------------------------
@@ -452,6 +710,51 @@ TEST(HttpTest, ChunkedResponse)
     });
 }
 
+// A body too large for the send buffer goes out behind the headers in one gather write, as does
+// a chunk too large for it with its closing CRLF, or the last chunk with the terminator too
+//
+TEST(HttpTest, GatherSendsMediumBodies)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        SendString(client, "GET / HTTP/1.1\r\n\r\n");
+
+        coop::http::PlaintextTransport transport(server);
+        auto conn = ctx->Allocate<HttpConn>(HTTP_EXTRA,
+            transport, ctx, ctx->GetCooperator());
+        conn->GetRequestLine();
+
+        std::string body(4096, 'b');
+        size_t submits = ctx->m_statistics.ioSubmits;
+        ASSERT_TRUE(conn->Send(200, "application/json", body));
+        EXPECT_EQ(ctx->m_statistics.ioSubmits - submits, 1u) << "headers and body in one writev";
+
+        std::string resp = RecvAll(client, 4096 + 256);
+        size_t headerEnd = resp.find("\r\n\r\n");
+        ASSERT_NE(headerEnd, std::string::npos);
+        EXPECT_NE(resp.find("Content-Length: 4096\r\n"), std::string::npos);
+        EXPECT_EQ(resp.substr(headerEnd + 4), body);
+
+        std::string chunk(2048, 'c');
+        std::string last(1024, 'l');
+        ASSERT_TRUE(conn->BeginChunked(200, "text/plain"));
+        ASSERT_TRUE(conn->SendChunk(chunk.data(), chunk.size()));
+        ASSERT_TRUE(conn->EndChunked(last.data(), last.size()));
+        server.Close();
+
+        resp = RecvAll(client, 16384);
+        headerEnd = resp.find("\r\n\r\n");
+        ASSERT_NE(headerEnd, std::string::npos);
+        EXPECT_EQ(resp.substr(headerEnd + 4),
+                  "800\r\n" + chunk + "\r\n400\r\n" + last + "\r\n0\r\n\r\n");
+    });
+}
+
 // -------------------------------------------------------------------------------------
 // Malformed request
 // -------------------------------------------------------------------------------------
@@ -503,6 +806,163 @@ TEST(HttpTest, RecvTimeout)
     });
 }
 
+// -------------------------------------------------------------------------------------
+// Multishot recv: parser fed from provided buffers
+// -------------------------------------------------------------------------------------
+
+// Pipelined requests parse out of one provided buffer; once both are answered nothing is left
+// buffered (the point where the server drops the Connection), and an idle wait times out with the
+// multishot still armed.
+//
+TEST(HttpTest, ArmedTransportParsesPipelinedRequests)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::io::BufferRing br(/*group=*/21, /*entries=*/16, /*bufSize=*/4096);
+        ASSERT_EQ(br.Register(*coop::GetUring()), 0);
+
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        coop::http::ArmedStream stream(ctx, server, &br);
+        EXPECT_FALSE(stream.Wait(std::chrono::milliseconds(20))) << "idle: times out";
+
+        SendString(client, "GET /one HTTP/1.1\r\nHost: localhost\r\n\r\n"
+                           "GET /two HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        ASSERT_TRUE(stream.Wait(std::chrono::seconds(1)));
+
+        using ArmedConn = coop::http::Connection<coop::http::ArmedTransport>;
+        auto conn = ctx->Allocate<ArmedConn>(ArmedConn::ExtraBytes(),
+            coop::http::ArmedTransport(server, stream), ctx, ctx->GetCooperator());
+
+        auto* req = conn->GetRequestLine();
+        ASSERT_NE(req, nullptr);
+        EXPECT_EQ(req->path, "/one");
+        conn->SkipHeaders();
+        conn->Reset();
+        EXPECT_TRUE(conn->LeftoverSize() > 0 || stream.Buffered());
+
+        req = conn->GetRequestLine();
+        ASSERT_NE(req, nullptr);
+        EXPECT_EQ(req->path, "/two");
+        conn->SkipHeaders();
+        conn->Reset();
+        EXPECT_EQ(conn->LeftoverSize(), 0u);
+        EXPECT_FALSE(stream.Buffered());
+    });
+}
+
+// Batching: responses to pipelined requests stay in the send buffer until the loop flushes, and
+// the last one, with nothing buffered behind it, goes at once
+//
+TEST(HttpTest, BatchesPipelinedResponses)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        SendString(client, "GET /1 HTTP/1.1\r\n\r\nGET /2 HTTP/1.1\r\n\r\nGET /3 HTTP/1.1\r\n\r\n");
+
+        coop::http::PlaintextTransport transport(server);
+        auto conn = ctx->Allocate<HttpConn>(HTTP_EXTRA,
+            transport, ctx, ctx->GetCooperator());
+        conn->SetResponseBatching(true);
+
+        const char* paths[] = {"/1", "/2", "/3"};
+        for (int i = 0; i < 3; i++)
+        {
+            auto* req = conn->GetRequestLine();
+            ASSERT_NE(req, nullptr);
+            EXPECT_EQ(req->path, paths[i]);
+            conn->SkipHeaders();
+            ASSERT_TRUE(conn->Send(200, "text/plain", std::string(req->path)));
+            conn->Reset();
+            EXPECT_EQ(conn->PipelinedRequestReady(), i < 2);
+            if (i < 2)
+            {
+                char byte;
+                EXPECT_LE(coop::io::Recv(client, &byte, 1, 0, std::chrono::milliseconds(10)), 0)
+                    << "response " << i << " is held back";
+            }
+        }
+
+        std::string resp = RecvAll(client);
+        EXPECT_NE(resp.find("\r\n\r\n/1HTTP/1.1 200 OK\r\n"), std::string::npos);
+        EXPECT_NE(resp.find("\r\n\r\n/2HTTP/1.1 200 OK\r\n"), std::string::npos);
+        EXPECT_EQ(resp.substr(resp.size() - 6), "\r\n\r\n/3");
+    });
+}
+
+TEST(HttpTest, GrowsRecvBufferForLargeHeads)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        std::string path = "/" + std::string(3000, 'p');
+        std::string cookie(6000, 'c');
+        std::string requests = "GET " + path + "?q=1 HTTP/1.1\r\n"
+                               "Cookie: " + cookie + "\r\n"
+                               "Host: localhost\r\n"
+                               "\r\n"
+                               "GET /next HTTP/1.1\r\n\r\n"
+                               "GET /" + std::string(70 * 1024, 'x') + " HTTP/1.1\r\n\r\n";
+        coop::io::SendAll(client, requests.data(), requests.size());
+
+        coop::http::PlaintextTransport transport(server);
+        auto conn = ctx->Allocate<HttpConn>(HTTP_EXTRA,
+            transport, ctx, ctx->GetCooperator());
+
+        // A request line past the inline buffer
+        //
+        auto* req = conn->GetRequestLine();
+        ASSERT_NE(req, nullptr);
+        EXPECT_EQ(req->path, path);
+        EXPECT_EQ(req->query, "q=1");
+
+        // A header value past it too, and the request line still intact after reading it
+        //
+        const char* name = conn->NextHeaderName();
+        ASSERT_NE(name, nullptr);
+        EXPECT_STREQ(name, "Cookie");
+        std::string value;
+        while (auto* chunk = conn->ReadHeaderValue())
+        {
+            value.append(static_cast<const char*>(chunk->data), chunk->size);
+            if (chunk->complete) break;
+        }
+        EXPECT_EQ(value, cookie);
+
+        name = conn->NextHeaderName();
+        ASSERT_NE(name, nullptr);
+        EXPECT_STREQ(name, "Host");
+        conn->SkipHeaders();
+        EXPECT_EQ(req->path, path);
+        EXPECT_EQ(req->query, "q=1");
+
+        // The pipelined request after it parses as usual
+        //
+        conn->Reset();
+        req = conn->GetRequestLine();
+        ASSERT_NE(req, nullptr);
+        EXPECT_EQ(req->path, "/next");
+        conn->SkipHeaders();
+
+        // A head past the largest class still fails
+        //
+        conn->Reset();
+        EXPECT_EQ(conn->GetRequestLine(), nullptr);
+    });
+}
+
 // ====================================================================================
 // HTTP Client tests
 // ====================================================================================
@@ -867,6 +1327,61 @@ TEST(HttpClientTest, KeepAlive)
     });
 }
 
+// -------------------------------------------------------------------------------------
+// Client: pipelined requests, responses matched in order
+// -------------------------------------------------------------------------------------
+
+TEST(HttpClientTest, PipelinesRequests)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        coop::http::PlaintextTransport transport(client);
+        auto conn = ctx->Allocate<HttpClient>(CLIENT_EXTRA,
+            transport, "localhost");
+        conn->SetPipelining(true);
+
+        ASSERT_TRUE(conn->Get("/a"));
+        ASSERT_TRUE(conn->Get("/b"));
+        ASSERT_TRUE(conn->Post("/c", "text/plain", "xy", 2));
+        EXPECT_EQ(conn->Outstanding(), 3u);
+        ASSERT_TRUE(conn->FlushRequests());
+
+        std::string requests = RecvAll(server);
+        EXPECT_EQ(requests.find("GET /a HTTP/1.1\r\n"), 0u);
+        EXPECT_NE(requests.find("GET /b HTTP/1.1\r\n"), std::string::npos);
+        EXPECT_NE(requests.find("\r\n\r\nxy"), std::string::npos);
+
+        // All three answers in one write, the middle one chunked
+        //
+        SendResponse(server,
+            "HTTP/1.1 200 OK\r\nContent-Length: 1\r\n\r\na"
+            "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n1\r\nb\r\n0\r\n\r\n"
+            "HTTP/1.1 201 Created\r\nContent-Length: 1\r\n\r\nc");
+
+        std::string bodies;
+        for (int expected : {200, 200, 201})
+        {
+            auto* resp = conn->GetResponseLine();
+            ASSERT_NE(resp, nullptr);
+            EXPECT_EQ(resp->status, expected);
+            conn->SkipHeaders();
+            while (auto* chunk = conn->ReadBody())
+            {
+                bodies.append(static_cast<const char*>(chunk->data), chunk->size);
+            }
+            conn->Reset();
+        }
+        EXPECT_EQ(bodies, "abc");
+        EXPECT_EQ(conn->Outstanding(), 0u);
+        EXPECT_TRUE(conn->Recycle());
+    });
+}
+
 // -------------------------------------------------------------------------------------
 // Client: Connection: close detection
 // -------------------------------------------------------------------------------------
@@ -944,3 +1459,2310 @@ TEST(HttpClientTest, MalformedResponseReturnsNull)
         EXPECT_EQ(conn->GetResponseLine(), nullptr);
     });
 }
+
+// -------------------------------------------------------------------------------------
+// Client pool: reuse, per-host limit, replacement of closed connections
+// -------------------------------------------------------------------------------------
+
+namespace
+{
+
+// A loopback server on a blocking thread, one connection at a time. Answers each request with
+// "ok"; /close answers with Connection: close and hangs up, /drop hangs up after a keep-alive
+// answer -- the idle connection a server times out.
+//
+struct PoolTestServer
+{
+    PoolTestServer()
+    {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        bind(listenFd, (sockaddr*)&addr, sizeof(addr));
+        listen(listenFd, 8);
+        getsockname(listenFd, (sockaddr*)&addr, &len);
+        port = ntohs(addr.sin_port);
+        thread = std::thread([this] { Run(); });
+    }
+
+    ~PoolTestServer()
+    {
+        shutdown(listenFd, SHUT_RDWR);
+        thread.join();
+        close(listenFd);
+    }
+
+    void Run()
+    {
+        int fd;
+        while ((fd = accept(listenFd, nullptr, nullptr)) >= 0)
+        {
+            accepts++;
+            std::string in;
+            char buf[1024];
+            ssize_t n;
+            while ((n = ::read(fd, buf, sizeof(buf))) > 0)
+            {
+                in.append(buf, n);
+                size_t end;
+                bool hangUp = false;
+                while ((end = in.find("\r\n\r\n")) != std::string::npos)
+                {
+                    bool closing = in.compare(0, 11, "GET /close ") == 0;
+                    hangUp = closing || in.compare(0, 10, "GET /drop ") == 0;
+                    const char* response = closing
+                        ? "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok"
+                        : "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+                    std::ignore = ::write(fd, response, strlen(response));
+                    in.erase(0, end + 4);
+                }
+                if (hangUp) break;
+            }
+            close(fd);
+        }
+    }
+
+    int                 listenFd;
+    int                 port;
+    std::atomic<int>    accepts{0};
+    std::thread         thread;
+};
+
+template<typename Lease>
+std::string PooledGet(Lease& lease, const char* path)
+{
+    if (!lease->Get(path)) return "";
+    auto* resp = lease->GetResponseLine();
+    if (!resp) return "";
+    lease->SkipHeaders();
+    std::string body;
+    while (auto* chunk = lease->ReadBody())
+    {
+        body.append(static_cast<const char*>(chunk->data), chunk->size);
+    }
+    return body;
+}
+
+} // end anonymous namespace
+
+TEST(ClientPoolTest, ReusesLimitsAndReplaces)
+{
+    PoolTestServer server;
+
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        coop::http::ClientPoolOptions options;
+        options.maxPerHost = 1;
+        options.checkoutTimeout = std::chrono::milliseconds(20);
+        coop::http::ClientPool pool(options);
+
+        {
+            auto lease = pool.Checkout("127.0.0.1", server.port);
+            ASSERT_TRUE(lease);
+            EXPECT_EQ(PooledGet(lease, "/a"), "ok");
+        }
+        {
+            auto lease = pool.Checkout("127.0.0.1", server.port);
+            ASSERT_TRUE(lease);
+            EXPECT_EQ(PooledGet(lease, "/b"), "ok");
+        }
+        EXPECT_EQ(server.accepts.load(), 1);
+        EXPECT_EQ(pool.Connects(), 1u);
+        EXPECT_EQ(pool.Reuses(), 1u);
+        EXPECT_EQ(pool.Idle(), 1u);
+
+        // At maxPerHost a checkout waits for a lease to come back, or times out
+        //
+        {
+            auto held = pool.Checkout("127.0.0.1", server.port);
+            ASSERT_TRUE(held);
+            EXPECT_FALSE(pool.Checkout("127.0.0.1", server.port)) << "timed out";
+
+            std::string waited;
+            ctx->GetCooperator()->Spawn([&](coop::Context*)
+            {
+                auto lease = pool.Checkout("127.0.0.1", server.port);
+                if (lease) waited = PooledGet(lease, "/c");
+            });
+            EXPECT_EQ(waited, "");
+
+            // Left mid-response: the rest is drained before it is handed on
+            //
+            ASSERT_TRUE(held->Get("/d"));
+            ASSERT_NE(held->GetResponseLine(), nullptr);
+            held.Release();
+            coop::time::Sleep(ctx, std::chrono::milliseconds(10));
+            EXPECT_EQ(waited, "ok");
+        }
+        EXPECT_EQ(server.accepts.load(), 1);
+
+        // Connection: close is not kept; a connection the server dropped while idle is replaced
+        //
+        {
+            auto lease = pool.Checkout("127.0.0.1", server.port);
+            EXPECT_EQ(PooledGet(lease, "/close"), "ok");
+        }
+        EXPECT_EQ(pool.Idle(), 0u);
+        {
+            auto lease = pool.Checkout("127.0.0.1", server.port);
+            EXPECT_EQ(PooledGet(lease, "/drop"), "ok");
+        }
+        EXPECT_EQ(pool.Idle(), 1u);
+        coop::time::Sleep(ctx, std::chrono::milliseconds(10));
+        {
+            auto lease = pool.Checkout("127.0.0.1", server.port);
+            EXPECT_EQ(PooledGet(lease, "/e"), "ok");
+        }
+        EXPECT_EQ(server.accepts.load(), 3);
+        EXPECT_EQ(pool.Connects(), 3u);
+    });
+}
+
+// -------------------------------------------------------------------------------------
+// Server group: one SO_REUSEPORT listener per cooperator, CPU-steered
+// -------------------------------------------------------------------------------------
+
+namespace
+{
+
+std::atomic<int> s_groupRequests{0};
+
+void HandleGroupHello(coop::http::ConnectionBase& conn)
+{
+    s_groupRequests.fetch_add(1, std::memory_order_relaxed);
+    conn.Send(200, "text/plain", "hello", 5);
+}
+
+// Requests served by a member that is not the first on its cpu ("Name-i", i >= the cpu count)
+//
+std::atomic<int> s_handoffStrays{0};
+
+void HandleHandoffHello(coop::http::ConnectionBase& conn)
+{
+    const char* name = coop::Cooperator::thread_cooperator->GetName();
+    const char* dash = strrchr(name, '-');
+    if (dash && atoi(dash + 1) >= static_cast<int>(coop::GetTopology().cpus.size()))
+    {
+        s_handoffStrays.fetch_add(1, std::memory_order_relaxed);
+    }
+    HandleGroupHello(conn);
+}
+
+// An ephemeral port, released so the group can bind it
+//
+int FreePort()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(fd, (sockaddr*)&addr, sizeof(addr));
+    getsockname(fd, (sockaddr*)&addr, &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+// One blocking request with Connection: close; returns the whole response, or "" if the group
+// never came up.
+//
+std::string BlockingGet(int port, const char* path)
+{
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (int attempt = 0; attempt < 200; attempt++)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0)
+        {
+            close(fd);
+            usleep(10000);
+            continue;
+        }
+
+        char req[128];
+        int n = snprintf(req, sizeof(req),
+                         "GET %s HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n", path);
+        std::ignore = ::write(fd, req, n);
+
+        std::string response;
+        char buf[512];
+        ssize_t r;
+        while ((r = ::read(fd, buf, sizeof(buf))) > 0) response.append(buf, r);
+        close(fd);
+        return response;
+    }
+    return {};
+}
+
+} // end anonymous namespace
+
+TEST(HttpServerGroupTest, ServesOnEveryCooperator)
+{
+    static const coop::http::Route routes[] = {{"/hello", HandleGroupHello}};
+    int port = FreePort();
+    constexpr int kRequests = 16;
+
+    std::thread client([port]
+    {
+        for (int i = 0; i < kRequests; i++)
+        {
+            std::string response = BlockingGet(port, "/hello");
+            EXPECT_EQ(response.compare(0, 15, "HTTP/1.1 200 OK"), 0) << response;
+        }
+        coop::Cooperator::ShutdownAll();
+    });
+
+    coop::http::ServerGroupConfiguration config;
+    config.name = "GroupServer";
+    EXPECT_TRUE(coop::http::RunServerGroup(port, routes, 1, 2, config));
+
+    client.join();
+    coop::Cooperator::ResetGlobalShutdown();
+    EXPECT_EQ(s_groupRequests.load(), kRequests);
+}
+
+TEST(HttpServerGroupTest, HandsOffByIncomingCpu)
+{
+    auto const& topo = coop::GetTopology();
+    if (topo.cpus.empty() || coop::PinningDisabled()) GTEST_SKIP();
+
+    // Two members per cpu, and the reuseport hash instead of the steering program, so the
+    // second member on a cpu accepts connections it has to pass to the first
+    //
+    static const coop::http::Route routes[] = {{"/hello", HandleHandoffHello}};
+    int port = FreePort();
+    constexpr int kRequests = 32;
+    s_groupRequests.store(0);
+    s_handoffStrays.store(0);
+
+    std::thread client([port]
+    {
+        for (int i = 0; i < kRequests; i++)
+        {
+            std::string response = BlockingGet(port, "/hello");
+            EXPECT_EQ(response.compare(0, 15, "HTTP/1.1 200 OK"), 0) << response;
+        }
+        coop::Cooperator::ShutdownAll();
+    });
+
+    coop::http::ServerGroupConfiguration config;
+    config.name = "HandoffServer";
+    config.steerByCpu = false;
+    config.handoffByIncomingCpu = true;
+    EXPECT_TRUE(coop::http::RunServerGroup(port, routes, 1,
+                                           2 * static_cast<int>(topo.cpus.size()), config));
+
+    client.join();
+    coop::Cooperator::ResetGlobalShutdown();
+    EXPECT_EQ(s_groupRequests.load(), kRequests);
+    EXPECT_EQ(s_handoffStrays.load(), 0);
+}
+
+namespace
+{
+
+void HandleStackless(coop::http::ConnectionBase& conn)
+{
+    conn.Send(200, "text/plain", "stackless\n");
+}
+
+// Read one response to HandleStackless off a blocking socket
+//
+bool ReadStacklessResponse(int fd)
+{
+    std::string response;
+    char buf[512];
+    while (response.size() < 10 || response.compare(response.size() - 10, 10, "stackless\n") != 0)
+    {
+        ssize_t r = ::read(fd, buf, sizeof(buf));
+        if (r <= 0) return false;
+        response.append(buf, r);
+    }
+    return response.compare(0, 15, "HTTP/1.1 200 OK") == 0;
+}
+
+} // end anonymous namespace
+
+TEST(HttpServerTest, StacklessServerIdlesWithoutContexts)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        static const coop::http::Route routes[] = {{"/stackless", HandleStackless}};
+        int port = FreePort();
+        auto* co = ctx->GetCooperator();
+
+        coop::Context::Handle server;
+        co->Spawn([port](coop::Context* serverCtx)
+        {
+            coop::http::RunStacklessServer(serverCtx, port, routes, 1);
+        }, &server);
+        coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+        size_t baseline = co->ContextsCount();
+
+        // Keep-alive clients, each sending a request, going idle, and sending another
+        //
+        constexpr int kClients = 8;
+        std::atomic<int> phase{0};
+        std::atomic<int> served{0};
+        std::thread client([&]
+        {
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            const char req[] = "GET /stackless HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+            int fds[kClients];
+            for (int& fd : fds)
+            {
+                fd = socket(AF_INET, SOCK_STREAM, 0);
+                EXPECT_EQ(connect(fd, (sockaddr*)&addr, sizeof(addr)), 0);
+            }
+            for (int round = 0; round < 2; round++)
+            {
+                for (int fd : fds)
+                {
+                    std::ignore = ::write(fd, req, sizeof(req) - 1);
+                    if (ReadStacklessResponse(fd)) served.fetch_add(1);
+                }
+                phase.store(2 * round + 1);
+                while (phase.load() == 2 * round + 1) usleep(1000);
+            }
+            for (int fd : fds) close(fd);
+        });
+
+        for (int round = 0; round < 2; round++)
+        {
+            while (phase.load() != 2 * round + 1)
+            {
+                coop::time::Sleep(ctx, std::chrono::milliseconds(5));
+            }
+
+            // Every response is out, so every connection is back on its poll
+            //
+            coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+            EXPECT_EQ(co->ContextsCount(), baseline);
+            phase.store(2 * round + 2);
+        }
+
+        client.join();
+        EXPECT_EQ(served.load(), 2 * kClients);
+        server.Kill();
+        coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+        EXPECT_FALSE(server);
+    });
+}
+
+namespace
+{
+
+std::atomic<bool> s_slowStarted{false};
+
+void HandleSlowHello(coop::http::ConnectionBase& conn)
+{
+    s_slowStarted.store(true);
+    coop::time::Sleep(std::chrono::milliseconds(100));
+    conn.Send(200, "text/plain", "hello", 5);
+}
+
+} // end anonymous namespace
+
+// A request in flight when the drain starts is answered, with Connection: close, and the group
+// then exits without waiting out the grace
+//
+TEST(HttpServerGroupTest, DrainFinishesInFlightRequests)
+{
+    static const coop::http::Route routes[] = {{"/slow", HandleSlowHello}};
+    int port = FreePort();
+    s_slowStarted.store(false);
+
+    std::string response;
+    std::thread client([port, &response]
+    {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        int fd = -1;
+        for (int attempt = 0; attempt < 200 && fd < 0; attempt++)
+        {
+            fd = socket(AF_INET, SOCK_STREAM, 0);
+            if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0)
+            {
+                close(fd);
+                fd = -1;
+                usleep(10000);
+            }
+        }
+        ASSERT_GE(fd, 0);
+
+        const char req[] = "GET /slow HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        std::ignore = ::write(fd, req, sizeof(req) - 1);
+        while (!s_slowStarted.load())
+        {
+            usleep(1000);
+        }
+        coop::Cooperator::DrainAll(std::chrono::seconds(30));
+
+        char buf[512];
+        ssize_t r;
+        while ((r = ::read(fd, buf, sizeof(buf))) > 0) response.append(buf, r);
+        close(fd);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    coop::http::ServerGroupConfiguration config;
+    config.name = "DrainServer";
+    EXPECT_TRUE(coop::http::RunServerGroup(port, routes, 1, 2, config));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    client.join();
+    coop::Cooperator::ResetGlobalShutdown();
+    EXPECT_EQ(response.compare(0, 15, "HTTP/1.1 200 OK"), 0) << response;
+    EXPECT_NE(response.find("Connection: close"), std::string::npos) << response;
+    EXPECT_LT(elapsed, std::chrono::seconds(10));
+}
+
+// A group serves listeners it inherited -- here over a socketpair, as a restart would pass them
+// -- instead of binding its own
+//
+TEST(HttpServerGroupTest, ServesInheritedListeners)
+{
+    static const coop::http::Route routes[] = {{"/hello", HandleGroupHello}};
+    int port = FreePort();
+    s_groupRequests.store(0);
+
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    int on = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listener, (sockaddr*)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(listener, 64), 0);
+
+    int pair[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+    ASSERT_EQ(coop::io::SendFds(pair[0], &listener, 1), 0);
+    close(listener);
+
+    int inherited = -1;
+    ASSERT_EQ(coop::io::ReceiveFds(pair[1], &inherited, 1), 1);
+    close(pair[0]);
+    close(pair[1]);
+
+    std::thread client([port]
+    {
+        std::string response = BlockingGet(port, "/hello");
+        EXPECT_EQ(response.compare(0, 15, "HTTP/1.1 200 OK"), 0) << response;
+        coop::Cooperator::ShutdownAll();
+    });
+
+    std::vector<int> bound;
+    coop::http::ServerGroupConfiguration config;
+    config.name = "InheritServer";
+    config.listeners = {inherited};
+    config.boundListeners = &bound;
+    EXPECT_TRUE(coop::http::RunServerGroup(port, routes, 1, 4, config));
+
+    client.join();
+    coop::Cooperator::ResetGlobalShutdown();
+    EXPECT_EQ(bound, std::vector<int>{inherited});
+    EXPECT_EQ(s_groupRequests.load(), 1);
+}
+
+// -------------------------------------------------------------------------------------
+// Router
+// -------------------------------------------------------------------------------------
+
+namespace
+{
+
+void RouteNop(coop::http::ConnectionBase&) {}
+
+} // end anonymous namespace
+
+TEST(RouterTest, MatchesLiteralsParamsAndWildcards)
+{
+    static const coop::http::Route routes[] = {
+        {"/", RouteNop},
+        {"/users", RouteNop},
+        {"/users/me", RouteNop},
+        {"/users/:id", RouteNop},
+        {"/users/:id/posts/:post", RouteNop},
+        {"/static/*path", RouteNop},
+        {"/users/", RouteNop},
+    };
+    coop::http::Router router(routes, std::size(routes));
+    EXPECT_EQ(router.Size(), std::size(routes));
+
+    coop::http::RouteParams params;
+    EXPECT_EQ(router.Match("/", &params), &routes[0]);
+    EXPECT_EQ(router.Match("/users", &params), &routes[1]);
+    EXPECT_EQ(router.Match("/users/", &params), &routes[6]) << "trailing slash is its own path";
+    EXPECT_EQ(router.Match("/users/me", &params), &routes[2]) << "literal beats parameter";
+    EXPECT_EQ(params.count, 0);
+
+    EXPECT_EQ(router.Match("/users/42", &params), &routes[3]);
+    EXPECT_EQ(params.Get("id"), "42");
+
+    EXPECT_EQ(router.Match("/users/me/posts/7", &params), &routes[4])
+        << "a dead-end literal falls back to the parameter";
+    EXPECT_EQ(params.Get("id"), "me");
+    EXPECT_EQ(params.Get("post"), "7");
+    EXPECT_EQ(params.Get("missing"), "");
+
+    EXPECT_EQ(router.Match("/static/css/site.css", &params), &routes[5]);
+    EXPECT_EQ(params.Get("path"), "css/site.css");
+    EXPECT_EQ(router.Match("/static/", &params), &routes[5]);
+    EXPECT_EQ(params.Get("path"), "");
+
+    EXPECT_EQ(router.Match("/static", &params), nullptr);
+    EXPECT_EQ(router.Match("/users/42/posts", &params), nullptr);
+    EXPECT_EQ(params.count, 0);
+    EXPECT_EQ(router.Match("/nope", &params), nullptr);
+    EXPECT_EQ(router.Match("", &params), nullptr);
+}
+
+TEST(RouterTest, RejectsMalformedAndKeepsFirstDuplicate)
+{
+    static const coop::http::Route routes[] = {
+        {"nope", RouteNop},
+        {"/a/*rest/more", RouteNop},
+        {"/a/:", RouteNop},
+        {"/b/:x", RouteNop},
+        {"/b/:y", RouteNop},
+    };
+    coop::http::Router router(routes, std::size(routes));
+    EXPECT_EQ(router.Size(), 1u);
+
+    coop::http::RouteParams params;
+    EXPECT_EQ(router.Match("/b/1", &params), &routes[3]);
+    EXPECT_EQ(params.Get("x"), "1");
+}
+
+TEST(RouterTest, MetricsSlotsAndSlowRequests)
+{
+    static const coop::http::Route routes[] = {
+        {"/metrics-test/a", RouteNop},
+        {"/metrics-test/:id", RouteNop},
+    };
+    coop::http::Router router(routes, std::size(routes));
+    ASSERT_EQ(router.Metrics().Size(), 2u);
+    EXPECT_STREQ(router.Metrics().Path(1), "/metrics-test/:id");
+
+    coop::http::RouteParams params;
+    int slot = -2;
+    EXPECT_EQ(router.Match("/metrics-test/7", &params, &slot), &routes[1]);
+    EXPECT_EQ(slot, 1);
+    EXPECT_EQ(router.Match("/nope", &params, &slot), nullptr);
+    EXPECT_EQ(slot, -1);
+
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        auto& metrics = router.Metrics();
+        coop::http::SetSlowRequestCapture(2, std::chrono::milliseconds(1));
+
+        // Three requests in one interval keep the two slowest; the first request of the next
+        // interval publishes them, slowest first
+        //
+        const uint64_t nanos[] = {100, 300, 200};
+        for (uint64_t n : nanos)
+        {
+            coop::http::SlowRequest sample;
+            coop::http::RequestLine line{"GET", "/metrics-test/7"};
+            ASSERT_TRUE(metrics.BeginSample(line, sample));
+            metrics.Record(co, 1, &sample, n == 300 ? 503 : 200, 10, 20, n);
+        }
+        coop::time::Sleep(std::chrono::milliseconds(2));
+        coop::http::SlowRequest sample;
+        ASSERT_TRUE(metrics.BeginSample(coop::http::RequestLine{"POST", "/nope"}, sample));
+        metrics.Record(co, -1, &sample, 404, 1, 2, 50);
+        coop::http::SetSlowRequestCapture(0, std::chrono::seconds(10));
+        EXPECT_FALSE(metrics.BeginSample(coop::http::RequestLine{"GET", "/"}, sample));
+
+        coop::http::SlowRequest slow[coop::http::kSlowRequestHistory];
+        size_t n = coop::http::ReadSlowRequests(slow, std::size(slow));
+        ASSERT_GE(n, 2u);
+        EXPECT_EQ(slow[n - 2].nanos, 300u);
+        EXPECT_EQ(slow[n - 2].status, 503);
+        EXPECT_STREQ(slow[n - 2].route, "/metrics-test/:id");
+        EXPECT_STREQ(slow[n - 2].path, "/metrics-test/7");
+        EXPECT_STREQ(slow[n - 2].method, "GET");
+        EXPECT_EQ(slow[n - 1].nanos, 200u);
+    });
+
+    coop::http::RouteMetrics byId, unmatched;
+    coop::http::VisitRouteMetrics([&](const char* path, coop::http::RouteMetrics const& m)
+    {
+        if (!path)
+        {
+            unmatched = m;
+        }
+        else if (!strcmp(path, "/metrics-test/:id"))
+        {
+            byId = m;
+        }
+    });
+    EXPECT_EQ(byId.requests, 3u);
+    EXPECT_EQ(byId.statusClass[2], 2u);
+    EXPECT_EQ(byId.statusClass[5], 1u);
+    EXPECT_EQ(byId.bytesIn, 30u);
+    EXPECT_EQ(byId.bytesOut, 60u);
+    EXPECT_EQ(byId.latency.count, 3u);
+    EXPECT_GE(unmatched.requests, 1u);
+}
+
+// -------------------------------------------------------------------------------------
+// Reverse proxy
+// -------------------------------------------------------------------------------------
+
+namespace
+{
+
+// "METHOD target|host|x-test|body", or the body's length for /echo/size
+//
+void HandleProxyEcho(coop::http::ConnectionBase& conn)
+{
+    auto* req = conn.GetRequestLine();
+    std::string out(req->method);
+    out += ' ';
+    out.append(req->path);
+    if (!req->query.empty())
+    {
+        out += '?';
+        out.append(req->query);
+    }
+    const bool size = req->path == "/echo/size";
+
+    std::string host, test;
+    while (auto* name = conn.NextHeaderName())
+    {
+        auto* value = conn.ReadHeaderValue();
+        if (!value) continue;
+        std::string v(static_cast<const char*>(value->data), value->size);
+        if (!strcasecmp(name, "host")) host = v;
+        if (!strcasecmp(name, "x-test")) test = v;
+    }
+    std::string body;
+    while (auto* chunk = conn.ReadBody())
+    {
+        body.append(static_cast<const char*>(chunk->data), chunk->size);
+    }
+    out += '|' + host + '|' + test + '|' + (size ? std::to_string(body.size()) : body);
+    conn.SetResponseHeaders("X-Upstream: 1\r\n");
+    conn.Send(200, "text/plain", out);
+}
+
+void HandleProxyChunked(coop::http::ConnectionBase& conn)
+{
+    conn.BeginChunked(200, "text/plain");
+    conn.SendChunk("ab", 2);
+    conn.SendChunk("cd", 2);
+    conn.EndChunked();
+}
+
+void HandleProxyBig(coop::http::ConnectionBase& conn)
+{
+    std::string body(300 * 1024, 'x');
+    conn.Send(200, "application/octet-stream", body);
+}
+
+coop::http::ProxyUpstream s_proxyUpstreams[2] = {};
+coop::http::Proxy s_testProxy({.upstreams = s_proxyUpstreams, .upstreamCount = 2,
+                               .failuresToEject = 1});
+
+template<typename Lease>
+std::string ReadProxied(Lease& lease, int* status, std::string* upstreamHeader = nullptr)
+{
+    auto* line = lease->GetResponseLine();
+    *status = line ? line->status : 0;
+    while (auto* name = lease->NextHeaderName())
+    {
+        auto* value = lease->ReadHeaderValue();
+        if (upstreamHeader && value && !strcasecmp(name, "x-upstream"))
+        {
+            upstreamHeader->assign(static_cast<const char*>(value->data), value->size);
+        }
+    }
+    std::string body;
+    while (auto* chunk = lease->ReadBody())
+    {
+        body.append(static_cast<const char*>(chunk->data), chunk->size);
+    }
+    return body;
+}
+
+} // end anonymous namespace
+
+// A dead upstream ahead of a live one: the first request to pick it fails over and ejects it,
+// and every request is answered by the live one -- query, headers, bodies of either framing in
+// both directions, and bodies big enough to go by splice
+//
+TEST(ProxyTest, ForwardsStreamsAndFailsOver)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        static const coop::http::Route upstreamRoutes[] = {
+            {"/echo", HandleProxyEcho},
+            {"/echo/size", HandleProxyEcho},
+            {"/chunked", HandleProxyChunked},
+            {"/big", HandleProxyBig},
+        };
+        static const coop::http::Route proxyRoutes[] = {
+            coop::http::ProxyRoute<s_testProxy>("/*rest"),
+        };
+        const int upstreamPort = FreePort();
+        const int proxyPort = FreePort();
+        s_proxyUpstreams[0] = {"127.0.0.1", FreePort()};
+        s_proxyUpstreams[1] = {"127.0.0.1", upstreamPort};
+
+        auto* co = ctx->GetCooperator();
+        coop::Context::Handle upstream, proxy;
+        co->Spawn([&](coop::Context* serverCtx)
+        {
+            coop::http::RunServer(serverCtx, upstreamPort, upstreamRoutes, 4, "Upstream");
+        }, &upstream);
+        co->Spawn([&](coop::Context* serverCtx)
+        {
+            coop::http::RunServer(serverCtx, proxyPort, proxyRoutes, 1, "Proxy");
+        }, &proxy);
+        coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+
+        coop::http::ClientPool pool;
+        auto lease = pool.Checkout("127.0.0.1", proxyPort);
+        ASSERT_TRUE(lease);
+        int status = 0;
+
+        for (int i = 0; i < 2; i++)
+        {
+            ASSERT_TRUE(lease->SendRequestHead("GET", "/echo?x=1&y=2", "X-Test: yes\r\n", 0,
+                                               "example.com"));
+            std::string upstreamHeader;
+            EXPECT_EQ(ReadProxied(lease, &status, &upstreamHeader),
+                      "GET /echo?x=1&y=2|example.com|yes|");
+            EXPECT_EQ(status, 200);
+            EXPECT_EQ(upstreamHeader, "1");
+            ASSERT_TRUE(lease->Recycle());
+        }
+        EXPECT_TRUE(s_testProxy.Stats(0).ejected);
+        EXPECT_EQ(s_testProxy.Stats(0).failures, 1u);
+
+        ASSERT_TRUE(lease->Post("/echo", "text/plain", "hello", 5));
+        EXPECT_EQ(ReadProxied(lease, &status), "POST /echo|127.0.0.1||hello");
+        ASSERT_TRUE(lease->Recycle());
+
+        ASSERT_TRUE(lease->SendRequestHead("PUT", "/echo", "", -1));
+        ASSERT_TRUE(lease->SendBody("ab", 2));
+        ASSERT_TRUE(lease->SendBody("cd", 2));
+        ASSERT_TRUE(lease->EndBody());
+        EXPECT_EQ(ReadProxied(lease, &status), "PUT /echo|127.0.0.1||abcd");
+        ASSERT_TRUE(lease->Recycle());
+
+        ASSERT_TRUE(lease->Get("/chunked"));
+        EXPECT_EQ(ReadProxied(lease, &status), "abcd");
+        ASSERT_TRUE(lease->Recycle());
+
+        std::string upload(200 * 1024, 'u');
+        ASSERT_TRUE(lease->Post("/echo/size", "application/octet-stream", upload.data(),
+                                upload.size()));
+        EXPECT_EQ(ReadProxied(lease, &status), "POST /echo/size|127.0.0.1||204800");
+        ASSERT_TRUE(lease->Recycle());
+
+        ASSERT_TRUE(lease->Get("/big"));
+        EXPECT_EQ(ReadProxied(lease, &status), std::string(300 * 1024, 'x'));
+        ASSERT_TRUE(lease->Recycle());
+
+        EXPECT_EQ(s_testProxy.Stats(1).requests, 7u);
+        EXPECT_EQ(s_testProxy.Stats(1).outstanding, 0u);
+
+        // With the live one gone too, the answer is the proxy's own
+        //
+        upstream.Kill();
+        coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+        ASSERT_TRUE(lease->Get("/echo"));
+        ReadProxied(lease, &status);
+        EXPECT_EQ(status, 502);
+
+        lease.Discard();
+        proxy.Kill();
+        coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+    });
+}
+
+// -------------------------------------------------------------------------------------
+// Server-Sent Events
+// -------------------------------------------------------------------------------------
+
+namespace
+{
+
+coop::http::EventTopic* s_eventTopic = nullptr;
+
+void HandleEvents(coop::http::ConnectionBase& conn)
+{
+    coop::http::EventStream stream(conn, *s_eventTopic);
+    stream.Run();
+}
+
+// Body bytes until until has arrived, or the body ends
+//
+template<typename Lease>
+std::string ReadEvents(Lease& lease, std::string_view until)
+{
+    std::string body;
+    while (body.find(until) == std::string::npos)
+    {
+        auto* chunk = lease->ReadBody();
+        if (!chunk) break;
+        body.append(static_cast<const char*>(chunk->data), chunk->size);
+    }
+    return body;
+}
+
+} // end anonymous namespace
+
+// Two streams on one topic: each gets every event as formatted once, a heartbeat once the topic
+// goes quiet, and a properly ended response when the topic shuts down
+//
+TEST(EventStreamTest, FansOutEventsAndHeartbeats)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::http::EventTopic topic(ctx, {.heartbeat = std::chrono::milliseconds(200)});
+        s_eventTopic = &topic;
+
+        static const coop::http::Route routes[] = {{"/events", HandleEvents}};
+        const int port = FreePort();
+        coop::Context::Handle server;
+        ctx->GetCooperator()->Spawn([&](coop::Context* serverCtx)
+        {
+            coop::http::RunServer(serverCtx, port, routes, 1, "EventServer");
+        }, &server);
+        coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+
+        coop::http::ClientPool pool;
+        auto a = pool.Checkout("127.0.0.1", port);
+        auto b = pool.Checkout("127.0.0.1", port);
+        ASSERT_TRUE(a && b);
+        for (auto* lease : {&a, &b})
+        {
+            ASSERT_TRUE((*lease)->Get("/events"));
+            auto* line = (*lease)->GetResponseLine();
+            ASSERT_NE(line, nullptr);
+            EXPECT_EQ(line->status, 200);
+            std::string type;
+            while (auto* name = (*lease)->NextHeaderName())
+            {
+                auto* value = (*lease)->ReadHeaderValue();
+                if (value && !strcasecmp(name, "content-type"))
+                {
+                    type.assign(static_cast<const char*>(value->data), value->size);
+                }
+            }
+            EXPECT_EQ(type, "text/event-stream");
+        }
+        EXPECT_EQ(topic.Subscribers(), 2u);
+
+        ASSERT_TRUE(topic.Publish("a\nb", "tick", "7\nignored"));
+        ASSERT_TRUE(topic.Publish("c"));
+        for (auto* lease : {&a, &b})
+        {
+            EXPECT_EQ(ReadEvents(*lease, "data: c\n\n"),
+                      ":\n\nid: 7\nevent: tick\ndata: a\ndata: b\n\ndata: c\n\n");
+        }
+
+        for (auto* lease : {&a, &b})
+        {
+            EXPECT_EQ(ReadEvents(*lease, ":\n\n"), ":\n\n");
+        }
+
+        topic.Shutdown();
+        EXPECT_FALSE(topic.Publish("late"));
+        for (auto* lease : {&a, &b})
+        {
+            EXPECT_EQ(ReadEvents(*lease, "never"), "");
+            EXPECT_TRUE((*lease)->BodyComplete());
+        }
+
+        server.Kill();
+        coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+        s_eventTopic = nullptr;
+    });
+}
+
+// -------------------------------------------------------------------------------------
+// Response templates
+// -------------------------------------------------------------------------------------
+
+namespace
+{
+
+using UserReply = coop::http::ResponseTemplate<
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: {}\r\n"
+    "\r\n"
+    "{\"id\":{},\"ok\":{},\"name\":\"{}\"}">;
+
+using MovedReply = coop::http::ResponseTemplate<
+    "HTTP/1.1 302 Found\r\n"
+    "Location: /users/{}\r\n"
+    "\r\n">;
+
+static_assert(UserReply::STATUS == 200 && UserReply::SLOTS == 3);
+static_assert(UserReply::STATIC_BODY_SIZE == sizeof("{\"id\":,\"ok\":,\"name\":\"\"}") - 1);
+static_assert(MovedReply::STATUS == 302 && MovedReply::SLOTS == 1);
+static_assert(MovedReply::STATIC_BODY_SIZE == 0);
+
+void HandleTemplated(coop::http::ConnectionBase& conn)
+{
+    if (conn.GetRequestLine()->path == "/moved")
+    {
+        MovedReply::Send(conn, -7);
+        return;
+    }
+    UserReply::Send(conn, 12345, true, std::string_view("ann"));
+}
+
+} // end anonymous namespace
+
+// Rendered responses carry the connection's own lines and a Content-Length it computed, and keep
+// the connection alive like any other
+//
+TEST(ResponseTemplateTest, RendersSlotsAndLength)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        static const coop::http::Route routes[] = {
+            {"/user", HandleTemplated},
+            {"/moved", HandleTemplated},
+        };
+        const int port = FreePort();
+        coop::Context::Handle server;
+        ctx->GetCooperator()->Spawn([&](coop::Context* serverCtx)
+        {
+            coop::http::RunServer(serverCtx, port, routes, 2, "TemplateServer");
+        }, &server);
+        coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+
+        coop::http::ClientPool pool;
+        auto lease = pool.Checkout("127.0.0.1", port);
+        ASSERT_TRUE(lease);
+
+        ASSERT_TRUE(lease->Get("/user"));
+        auto* line = lease->GetResponseLine();
+        ASSERT_NE(line, nullptr);
+        EXPECT_EQ(line->status, 200);
+        std::string type, date;
+        while (auto* name = lease->NextHeaderName())
+        {
+            auto* value = lease->ReadHeaderValue();
+            if (!value) continue;
+            std::string v(static_cast<const char*>(value->data), value->size);
+            if (!strcasecmp(name, "content-type")) type = v;
+            if (!strcasecmp(name, "date")) date = v;
+        }
+        EXPECT_EQ(type, "application/json");
+        EXPECT_FALSE(date.empty());
+        const std::string expected = "{\"id\":12345,\"ok\":true,\"name\":\"ann\"}";
+        EXPECT_EQ(lease->ContentLength(), static_cast<int64_t>(expected.size()));
+        std::string body;
+        while (auto* chunk = lease->ReadBody())
+        {
+            body.append(static_cast<const char*>(chunk->data), chunk->size);
+        }
+        EXPECT_EQ(body, expected);
+        ASSERT_TRUE(lease->Recycle());
+
+        ASSERT_TRUE(lease->Get("/moved"));
+        line = lease->GetResponseLine();
+        ASSERT_NE(line, nullptr);
+        EXPECT_EQ(line->status, 302);
+        std::string location;
+        while (auto* name = lease->NextHeaderName())
+        {
+            auto* value = lease->ReadHeaderValue();
+            if (value && !strcasecmp(name, "location"))
+            {
+                location.assign(static_cast<const char*>(value->data), value->size);
+            }
+        }
+        EXPECT_EQ(location, "/users/-7");
+        EXPECT_EQ(lease->ContentLength(), 0);
+        EXPECT_EQ(lease->ReadBody(), nullptr);
+        EXPECT_TRUE(lease->Recycle());
+
+        lease.Discard();
+        server.Kill();
+        coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+    });
+}
+
+TEST(JsonWriterTest, EscapesAndFormats)
+{
+    std::string out;
+    coop::http::JsonWriter w(out);
+    w.BeginObject();
+    w.Key("s");
+    w.String(std::string_view("q\"b\\n\n\t\x01\x1f\xc3\xa9", 11));
+    w.Key("i");
+    w.Int(-9223372036854775807 - 1);
+    w.Key("u");
+    w.UInt(18446744073709551615ull);
+    w.Key("d");
+    w.BeginArray();
+    w.Double(0.1);
+    w.Double(1e21);
+    w.Double(2.5, 3);
+    w.Double(1e300, 3);
+    w.Double(std::numeric_limits<double>::quiet_NaN());
+    w.EndArray();
+    w.Key("e");
+    w.BeginArray();
+    w.BeginObject();
+    w.EndObject();
+    w.BeginArray();
+    w.EndArray();
+    w.Bool(false);
+    w.Null();
+    w.Raw("[1,2]");
+    w.EndArray();
+    w.EndObject();
+    EXPECT_TRUE(w.Finish());
+    EXPECT_EQ(out, "{\"s\":\"q\\\"b\\\\n\\n\\t\\u0001\\u001f\xc3\xa9\","
+                   "\"i\":-9223372036854775808,\"u\":18446744073709551615,"
+                   "\"d\":[0.1,1e+21,2.500,1e+300,null],"
+                   "\"e\":[{},[],false,null,[1,2]]}");
+
+    // Past the buffer, in string mode, the pieces land in order
+    //
+    std::string big;
+    coop::http::JsonWriter b(big);
+    b.BeginArray();
+    for (int i = 0; i < 1000; i++)
+    {
+        b.String("abcdefghij\n");
+    }
+    b.EndArray();
+    EXPECT_TRUE(b.Finish());
+    EXPECT_EQ(big.size(), 2 + 1000 * 15 - 1);
+    EXPECT_EQ(big.substr(0, 17), "[\"abcdefghij\\n\",\"");
+}
+
+void HandleJsonSmall(coop::http::ConnectionBase& conn)
+{
+    coop::http::JsonWriter w(conn);
+    w.BeginObject();
+    w.Key("ok");
+    w.Bool(true);
+    w.EndObject();
+    w.Finish();
+}
+
+void HandleJsonLarge(coop::http::ConnectionBase& conn)
+{
+    coop::http::JsonWriter w(conn, 201);
+    w.BeginArray();
+    for (int i = 0; i < 5000; i++)
+    {
+        w.Int(i);
+    }
+    w.EndArray();
+    EXPECT_TRUE(w.Chunked());
+    w.Finish();
+}
+
+TEST(JsonWriterTest, SendsLengthOrChunked)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        static const coop::http::Route routes[] = {
+            {"/small", HandleJsonSmall},
+            {"/large", HandleJsonLarge},
+        };
+        const int port = FreePort();
+        coop::Context::Handle server;
+        ctx->GetCooperator()->Spawn([&](coop::Context* serverCtx)
+        {
+            coop::http::RunServer(serverCtx, port, routes, 2, "JsonServer");
+        }, &server);
+        coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+
+        coop::http::ClientPool pool;
+        auto lease = pool.Checkout("127.0.0.1", port);
+        ASSERT_TRUE(lease);
+
+        auto fetch = [&](const char* path, int status, std::string* type)
+        {
+            std::string body;
+            EXPECT_TRUE(lease->Get(path));
+            auto* line = lease->GetResponseLine();
+            EXPECT_NE(line, nullptr);
+            if (!line) return body;
+            EXPECT_EQ(line->status, status);
+            while (auto* name = lease->NextHeaderName())
+            {
+                auto* value = lease->ReadHeaderValue();
+                if (value && !strcasecmp(name, "content-type"))
+                {
+                    type->assign(static_cast<const char*>(value->data), value->size);
+                }
+            }
+            while (auto* chunk = lease->ReadBody())
+            {
+                body.append(static_cast<const char*>(chunk->data), chunk->size);
+            }
+            return body;
+        };
+
+        std::string type;
+        EXPECT_EQ(fetch("/small", 200, &type), "{\"ok\":true}");
+        EXPECT_EQ(type, "application/json");
+        EXPECT_FALSE(lease->ChunkedBody());
+        ASSERT_TRUE(lease->Recycle());
+
+        std::string expected = "[";
+        for (int i = 0; i < 5000; i++)
+        {
+            expected += (i ? "," : "") + std::to_string(i);
+        }
+        expected += "]";
+        EXPECT_EQ(fetch("/large", 201, &type), expected);
+        EXPECT_TRUE(lease->ChunkedBody());
+        EXPECT_TRUE(lease->Recycle());
+
+        lease.Discard();
+        server.Kill();
+        coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+    });
+}
+
+TEST(HttpScanTest, FindJsonEscapeMatchesScalar)
+{
+    char buf[160];
+    for (size_t len = 0; len <= 100; len++)
+    {
+        for (size_t start = 0; start < 4; start++)
+        {
+            for (size_t at = 0; at <= len; at++)
+            {
+                memset(buf, 'x', sizeof(buf));
+                char* p = buf + start;
+                if (at < len)
+                {
+                    p[at] = "\"\\\n\x1f"[at % 4];
+                }
+                p[len] = '"';
+
+                auto expected = coop::http::detail::FindJsonEscapeScalar(p, len);
+                ASSERT_EQ(expected, at);
+                ASSERT_EQ(coop::http::detail::FindJsonEscape(p, len), expected)
+                    << "len=" << len << " start=" << start << " at=" << at;
+            }
+        }
+    }
+
+    // UTF-8 continuation bytes, DEL and space need no escape
+    //
+    char text[64];
+    memset(text, '\x80', sizeof(text));
+    text[20] = '\x7f';
+    text[30] = ' ';
+    text[50] = '\x1f';
+    EXPECT_EQ(coop::http::detail::FindJsonEscape(text, sizeof(text)), 50u);
+}
+
+TEST(HttpScanTest, ParseHexMatchesScalar)
+{
+    // Every digit count up to past 16, either case, at each length around the 16-byte load,
+    // ended by each kind of byte that borders the hex ranges
+    //
+    const char digits[] = "0123456789abcdefABCDEF";
+    char buf[48];
+    for (size_t count = 0; count <= 18; count++)
+    {
+        for (char end : {'\r', ';', ' ', 'g', 'G', '/', ':', '@', '`', '\x80', '\xff'})
+        {
+            for (size_t n = 0; n <= 20; n++)
+            {
+                for (size_t i = 0; i < sizeof(buf); i++)
+                {
+                    buf[i] = i < count ? digits[(i * 7 + count) % 22] : end;
+                }
+                uint64_t expected = 0;
+                uint64_t value = 0;
+                size_t scalar = coop::http::detail::ParseHexScalar(buf, n, &expected);
+                ASSERT_EQ(scalar, std::min(std::min(count, n), size_t(17)));
+                ASSERT_EQ(coop::http::detail::ParseHex(buf, n, &value), scalar)
+                    << "count=" << count << " n=" << n << " end=" << int(end);
+                ASSERT_EQ(value, expected) << "count=" << count << " n=" << n;
+            }
+        }
+    }
+
+    uint64_t value = 0;
+    EXPECT_EQ(coop::http::detail::ParseHex("FfFfFfFfFfFfFfFf\r\n........", 26, &value), 16u);
+    EXPECT_EQ(value, ~uint64_t(0));
+    EXPECT_EQ(coop::http::detail::ParseHex("00001a2B\r\n................", 26, &value), 8u);
+    EXPECT_EQ(value, 0x1a2bu);
+}
+
+TEST(PercentDecodeTest, DecodesInPlace)
+{
+    auto decode = [](std::string s, bool plus = true)
+    {
+        s.resize(coop::http::PercentDecode(s.data(), s.size(), plus));
+        return s;
+    };
+    EXPECT_EQ(decode(""), "");
+    EXPECT_EQ(decode("plain"), "plain");
+    EXPECT_EQ(decode("a%20b+c"), "a b c");
+    EXPECT_EQ(decode("a%20b+c", false), "a b+c");
+    EXPECT_EQ(decode("%e6%97%A5%E6%9C%AC"), "\xe6\x97\xa5\xe6\x9c\xac");
+    EXPECT_EQ(decode("100%"), "100%");
+    EXPECT_EQ(decode("%4"), "%4");
+    EXPECT_EQ(decode("%zz%41"), "%zzA");
+    EXPECT_EQ(decode("%%41"), "%A");
+    EXPECT_EQ(decode("%00x"), std::string("\0x", 2));
+
+    char value[] = "x%3Dy";
+    coop::http::Chunk chunk{value, 5, true};
+    coop::http::PercentDecode(&chunk);
+    EXPECT_EQ(std::string(value, chunk.size), "x=y");
+
+    // Runs either side of the vector strides, escapes anywhere, against the byte loop
+    //
+    const char alphabet[] = "ab%+4F%2";
+    uint32_t seed = 1;
+    for (int round = 0; round < 20000; round++)
+    {
+        std::string s(round % 90, ' ');
+        for (auto& c : s)
+        {
+            seed = seed * 1103515245 + 12345;
+            c = (seed >> 16) % 4 ? 'x' : alphabet[(seed >> 8) % 8];
+        }
+        std::string expected = s;
+        expected.resize(coop::http::detail::PercentDecodeScalar(expected.data(), expected.size(),
+                                                                round % 2));
+        ASSERT_EQ(decode(s, round % 2), expected) << s;
+    }
+}
+
+TEST(HeaderSetTest, FindsNamesByHash)
+{
+    using coop::http::HeaderName;
+    namespace header = coop::http::header;
+
+    static constexpr coop::http::HeaderSet set = {
+        header::USER_AGENT, header::HOST, HeaderName("x-a"), HeaderName("X-Request-Id"),
+    };
+    static_assert(set.Size() == 4);
+    static_assert(set.Find(header::HOST) == 1);
+    static_assert(set.Find(header::X_REQUEST_ID) == 3);
+    static_assert(set.Find(header::ACCEPT) == -1);
+
+    // Names as scanned hash at run time the way constants do at compile time, in any case
+    //
+    auto find = [](const char* name)
+    {
+        size_t size = strlen(name);
+        return set.Find(coop::http::detail::HeaderNameHash(name, size), name, size);
+    };
+    EXPECT_EQ(find("User-Agent"), 0);
+    EXPECT_EQ(find("HOST"), 1);
+    EXPECT_EQ(find("X-A"), 2);
+    EXPECT_EQ(find("x-request-ID"), 3);
+    EXPECT_EQ(find("user-agen"), -1);
+    EXPECT_EQ(find("user-agent2"), -1);
+    EXPECT_EQ(find("x-b"), -1);
+    EXPECT_EQ(find(""), -1);
+
+    // Names alike at both ends, told apart by the compare
+    //
+    static constexpr coop::http::HeaderSet similar = {
+        HeaderName("x-custom-aa-my-header"), HeaderName("x-custom-bb-my-header"),
+    };
+    EXPECT_EQ(similar.Find(HeaderName("X-Custom-BB-My-Header")), 1);
+    EXPECT_EQ(similar.Find(HeaderName("x-custom-cc-my-header")), -1);
+}
+
+TEST(HttpScanTest, FindFirstOfMatchesScalar)
+{
+    // Every length and delimiter position either side of the 16 and 32 byte vector strides, at
+    // both aligned and unaligned starts
+    //
+    char buf[160];
+    for (size_t len = 0; len <= 100; len++)
+    {
+        for (size_t start = 0; start < 4; start++)
+        {
+            for (size_t at = 0; at <= len; at++)
+            {
+                memset(buf, 'x', sizeof(buf));
+                char* p = buf + start;
+                if (at < len)
+                {
+                    p[at] = "=& \r"[at % 4];
+                }
+                p[len] = '&';
+
+                auto expected = coop::http::detail::FindFirstOfScalar(p, len, '=', '&', ' ', '\r');
+                ASSERT_EQ(expected, at);
+                ASSERT_EQ(coop::http::detail::FindFirstOf(p, len, '=', '&', ' ', '\r'), expected)
+                    << "len=" << len << " start=" << start << " at=" << at;
+            }
+        }
+    }
+
+    // High bytes must not sign-extend into a match
+    //
+    char high[64];
+    memset(high, '\xff', sizeof(high));
+    high[50] = ':';
+    EXPECT_EQ(coop::http::detail::FindFirstOf(high, sizeof(high), ':', '\r', '\r', '\r'), 50u);
+}
+
+// -------------------------------------------------------------------------------------
+// HPACK
+// -------------------------------------------------------------------------------------
+
+namespace
+{
+
+std::string FromHex(const char* hex)
+{
+    std::string out;
+    for (; hex[0] && hex[1]; hex += 2)
+    {
+        out.push_back(static_cast<char>(std::stoi(std::string(hex, 2), nullptr, 16)));
+    }
+    return out;
+}
+
+} // end anonymous namespace
+
+TEST(HpackTest, DecodesRfcHuffmanRequests)
+{
+    // RFC 7541 C.4: three requests on one connection, Huffman-coded, sharing the dynamic table
+    //
+    const char* blocks[] = {
+        "828684418cf1e3c2e5f23a6ba0ab90f4ff",
+        "828684be5886a8eb10649cbf",
+        "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf",
+    };
+    const size_t tableSizes[] = {57, 110, 164};
+
+    coop::http::hpack::Decoder decoder;
+    coop::http::hpack::HeaderList headers;
+    for (size_t i = 0; i < std::size(blocks); i++)
+    {
+        auto block = FromHex(blocks[i]);
+        headers.Clear();
+        ASSERT_EQ(decoder.Decode(reinterpret_cast<const uint8_t*>(block.data()), block.size(),
+                                 &headers), 0) << "block " << i;
+        EXPECT_EQ(decoder.Table().Size(), tableSizes[i]);
+        EXPECT_EQ(headers.Find(":authority"), "www.example.com");
+    }
+
+    ASSERT_EQ(headers.Count(), 5u);
+    EXPECT_EQ(headers.Find(":method"), "GET");
+    EXPECT_EQ(headers.Find(":scheme"), "https");
+    EXPECT_EQ(headers.Find(":path"), "/index.html");
+    EXPECT_EQ(headers.Find("custom-key"), "custom-value");
+    EXPECT_STREQ(headers.Name(4), "custom-key");
+
+    // Truncated input and references past the tables are malformed
+    //
+    auto bad = FromHex("828684418cf1e3c2e5f23a6b");
+    EXPECT_EQ(coop::http::hpack::Decoder().Decode(
+        reinterpret_cast<const uint8_t*>(bad.data()), bad.size(), &headers), -EBADMSG);
+    uint8_t pastEnd[] = {0xff, 0x00};
+    EXPECT_EQ(coop::http::hpack::Decoder().Decode(pastEnd, sizeof(pastEnd), &headers), -EBADMSG);
+}
+
+TEST(HpackTest, EncodeRoundTrips)
+{
+    std::string block;
+    coop::http::hpack::Encode(":status", "200", &block);
+    coop::http::hpack::Encode(":status", "418", &block);
+    coop::http::hpack::Encode("content-type", "text/plain", &block);
+    coop::http::hpack::Encode("x-long", std::string(300, 'v'), &block);
+
+    // Fully indexed static entry, then indexed names with literal values
+    //
+    EXPECT_EQ(static_cast<uint8_t>(block[0]), 0x88);
+
+    coop::http::hpack::Decoder decoder;
+    coop::http::hpack::HeaderList headers;
+    ASSERT_EQ(decoder.Decode(reinterpret_cast<const uint8_t*>(block.data()), block.size(),
+                             &headers), 0);
+    ASSERT_EQ(headers.Count(), 4u);
+    EXPECT_EQ(headers.Get(0).value, "200");
+    EXPECT_EQ(headers.Get(1).value, "418");
+    EXPECT_EQ(headers.Find("content-type"), "text/plain");
+    EXPECT_EQ(headers.Find("x-long"), std::string(300, 'v'));
+    EXPECT_EQ(decoder.Table().Count(), 0u) << "the encoder never indexes";
+}
+
+// -------------------------------------------------------------------------------------
+// HTTP/2
+// -------------------------------------------------------------------------------------
+
+namespace
+{
+
+std::string H2Frame(uint8_t type, uint8_t flags, uint32_t stream, std::string const& payload)
+{
+    std::string out;
+    out.push_back(static_cast<char>(payload.size() >> 16));
+    out.push_back(static_cast<char>(payload.size() >> 8));
+    out.push_back(static_cast<char>(payload.size()));
+    out.push_back(static_cast<char>(type));
+    out.push_back(static_cast<char>(flags));
+    out.push_back(static_cast<char>(stream >> 24));
+    out.push_back(static_cast<char>(stream >> 16));
+    out.push_back(static_cast<char>(stream >> 8));
+    out.push_back(static_cast<char>(stream));
+    return out + payload;
+}
+
+struct H2Received
+{
+    uint8_t     type;
+    uint8_t     flags;
+    uint32_t    stream;
+    std::string payload;
+};
+
+// Read frames off desc until one on stream carries END_STREAM (or the peer goes quiet)
+//
+std::vector<H2Received> H2ReadUntilEnd(coop::io::Descriptor& desc, uint32_t stream)
+{
+    std::vector<H2Received> frames;
+    std::string buf;
+    char tmp[4096];
+    while (true)
+    {
+        while (buf.size() >= 9)
+        {
+            auto* p = reinterpret_cast<const uint8_t*>(buf.data());
+            size_t len = (size_t(p[0]) << 16) | (size_t(p[1]) << 8) | p[2];
+            if (buf.size() < 9 + len)
+            {
+                break;
+            }
+            H2Received frame{p[3], p[4],
+                (uint32_t(p[5] & 0x7f) << 24) | (uint32_t(p[6]) << 16) | (uint32_t(p[7]) << 8)
+                    | p[8],
+                buf.substr(9, len)};
+            buf.erase(0, 9 + len);
+            frames.push_back(frame);
+            bool ended = (frame.type == coop::http::http2::DATA
+                          || frame.type == coop::http::http2::HEADERS)
+                && (frame.flags & coop::http::http2::END_STREAM);
+            if (frame.stream == stream
+                && (ended || frame.type == coop::http::http2::RST_STREAM))
+            {
+                return frames;
+            }
+        }
+        int n = coop::io::Recv(desc, tmp, sizeof(tmp), 0, std::chrono::milliseconds(1000));
+        if (n <= 0)
+        {
+            return frames;
+        }
+        buf.append(tmp, n);
+    }
+}
+
+} // end anonymous namespace
+
+TEST(Http2Test, ServesRequestWithPriorKnowledge)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        namespace h2 = coop::http::http2;
+
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        std::string method, path, arg, host, body;
+        std::function<void(coop::http::ConnectionBase&)> handler =
+            [&](coop::http::ConnectionBase& conn)
+        {
+            auto* req = conn.GetRequestLine();
+            method = req->method;
+            path = req->path;
+            while (auto* name = conn.NextArgName())
+            {
+                auto* value = conn.ReadArgValue();
+                if (!strcmp(name, "x") && value)
+                {
+                    arg.assign(static_cast<const char*>(value->data), value->size);
+                }
+            }
+            while (auto* name = conn.NextHeaderName())
+            {
+                auto* value = conn.ReadHeaderValue();
+                if (!strcmp(name, "host") && value)
+                {
+                    host.assign(static_cast<const char*>(value->data), value->size);
+                }
+            }
+            while (auto* chunk = conn.ReadBody())
+            {
+                body.append(static_cast<const char*>(chunk->data), chunk->size);
+            }
+            conn.Send(200, "text/plain", "hello");
+        };
+
+        coop::Coordinator done;
+        coop::Context::Handle handle;
+        ctx->GetCooperator()->Spawn([&](coop::Context* serverCtx)
+        {
+            done.Acquire(serverCtx);
+            coop::http::ServeHttp2(serverCtx, coop::http::PlaintextTransport(server), handler);
+            done.Release(serverCtx, false);
+        }, &handle);
+
+        std::string headers;
+        coop::http::hpack::Encode(":method", "POST", &headers);
+        coop::http::hpack::Encode(":scheme", "http", &headers);
+        coop::http::hpack::Encode(":path", "/echo?x=1", &headers);
+        coop::http::hpack::Encode(":authority", "localhost", &headers);
+
+        std::string out(h2::PREFACE, h2::PREFACE_SIZE);
+        out += H2Frame(h2::SETTINGS, 0, 0, "");
+        out += H2Frame(h2::HEADERS, h2::END_HEADERS, 1, headers);
+        out += H2Frame(h2::DATA, 0, 1, "ab");
+        out += H2Frame(h2::DATA, h2::END_STREAM, 1, "cd");
+        coop::io::SendAll(client, out.data(), out.size());
+
+        auto frames = H2ReadUntilEnd(client, 1);
+        ASSERT_GE(frames.size(), 3u);
+        EXPECT_EQ(frames[0].type, h2::SETTINGS) << "the server's SETTINGS come first";
+        EXPECT_EQ(frames[0].stream, 0u);
+
+        coop::http::hpack::Decoder decoder;
+        coop::http::hpack::HeaderList response;
+        std::string data;
+        bool acked = false;
+        for (auto& frame : frames)
+        {
+            acked |= frame.type == h2::SETTINGS && (frame.flags & h2::ACK);
+            if (frame.stream != 1)
+            {
+                continue;
+            }
+            if (frame.type == h2::HEADERS)
+            {
+                ASSERT_EQ(decoder.Decode(reinterpret_cast<const uint8_t*>(frame.payload.data()),
+                                         frame.payload.size(), &response), 0);
+            }
+            if (frame.type == h2::DATA)
+            {
+                data += frame.payload;
+            }
+        }
+        EXPECT_TRUE(acked);
+        EXPECT_EQ(response.Find(":status"), "200");
+        EXPECT_EQ(response.Find("content-type"), "text/plain");
+        EXPECT_EQ(response.Find("content-length"), "5");
+        EXPECT_EQ(data, "hello");
+        EXPECT_EQ(frames.back().type, h2::DATA);
+
+        EXPECT_EQ(method, "POST");
+        EXPECT_EQ(path, "/echo");
+        EXPECT_EQ(arg, "1");
+        EXPECT_EQ(host, "localhost");
+        EXPECT_EQ(body, "abcd");
+
+        // The session ends when the client goes away
+        //
+        client.Close();
+        done.Acquire(ctx);
+        done.Release(ctx, false);
+    });
+}
+
+// Concurrent requests from several contexts share one connection as streams; a body larger than
+// the server's stream window goes out as the server hands window back
+//
+TEST(Http2ClientTest, MultiplexesRequests)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        int inFlight = 0;
+        int maxInFlight = 0;
+        std::function<void(coop::http::ConnectionBase&)> handler =
+            [&](coop::http::ConnectionBase& conn)
+        {
+            inFlight++;
+            maxInFlight = std::max(maxInFlight, inFlight);
+            std::string path(conn.GetRequestLine()->path);
+            size_t body = 0;
+            while (auto* chunk = conn.ReadBody())
+            {
+                body += chunk->size;
+            }
+            coop::time::Sleep(coop::Self(), std::chrono::milliseconds(5));
+            inFlight--;
+            conn.Send(200, "text/plain", path + ":" + std::to_string(body));
+        };
+
+        coop::Coordinator done;
+        coop::Context::Handle handle;
+        ctx->GetCooperator()->Spawn([&](coop::Context* serverCtx)
+        {
+            done.Acquire(serverCtx);
+            coop::http::ServeHttp2(serverCtx, coop::http::PlaintextTransport(server), handler);
+            done.Release(serverCtx, false);
+        }, &handle);
+
+        {
+            coop::http::Http2Client<coop::http::PlaintextTransport> h2(
+                coop::http::PlaintextTransport(client), "localhost");
+            ASSERT_TRUE(h2.Start(ctx));
+
+            constexpr int kRequests = 8;
+            std::vector<std::string> bodies(kRequests);
+            int finished = 0;
+            for (int i = 0; i < kRequests; i++)
+            {
+                ctx->GetCooperator()->Spawn([&, i](coop::Context* child)
+                {
+                    coop::http::Http2Response response;
+                    std::string path = "/r" + std::to_string(i);
+                    if (h2.Get(child, path.c_str(), &response) == 0 && response.status == 200)
+                    {
+                        bodies[i] = response.body;
+                    }
+                    finished++;
+                });
+            }
+            for (int spin = 0; finished < kRequests && spin < 200; spin++)
+            {
+                coop::time::Sleep(ctx, std::chrono::milliseconds(5));
+            }
+            ASSERT_EQ(finished, kRequests);
+            for (int i = 0; i < kRequests; i++)
+            {
+                EXPECT_EQ(bodies[i], "/r" + std::to_string(i) + ":0");
+            }
+            EXPECT_GT(maxInFlight, 1) << "requests overlapped on the one connection";
+
+            std::string upload(100000, 'u');
+            coop::http::Http2Response response;
+            ASSERT_EQ(h2.Request(ctx, "POST", "/up", &response, "Content-Type: text/plain\r\n",
+                                 upload.data(), upload.size()), 0);
+            EXPECT_EQ(response.status, 200);
+            EXPECT_EQ(response.headers.Find("content-type"), "text/plain");
+            EXPECT_EQ(response.body, "/up:100000");
+            EXPECT_EQ(h2.Active(), 0u);
+
+            h2.Close(ctx);
+            EXPECT_FALSE(h2.Usable());
+            EXPECT_EQ(h2.Get(ctx, "/late", &response), -EAGAIN);
+        }
+
+        client.Close();
+        done.Acquire(ctx);
+        done.Release(ctx, false);
+    });
+}
+
+// -------------------------------------------------------------------------------------
+// Response cache
+// -------------------------------------------------------------------------------------
+
+TEST(ResponseCacheTest, HitsExpiresAndVersions)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        std::atomic<uint64_t> version{1};
+        coop::http::ResponseCache cache({.capacity = 2, .version = &version});
+
+        EXPECT_FALSE(cache.Lookup("GET", "/flags"));
+        auto inserted = cache.Insert("GET", "/flags", {}, 200, "application/json", "{}");
+        ASSERT_TRUE(inserted);
+        EXPECT_EQ(inserted->Body(), "{}");
+        std::string_view tail = "\r\nContent-Type: application/json\r\nContent-Length: 2\r\n"
+                                "Connection: keep-alive\r\n\r\n{}";
+        EXPECT_EQ(inserted->bytes.find("HTTP/1.1 200 OK\r\nDate: "), 0u);
+        EXPECT_EQ(inserted->bytes.substr(inserted->bytes.size() - tail.size()), tail);
+
+        EXPECT_TRUE(cache.Lookup("GET", "/flags"));
+        EXPECT_FALSE(cache.Lookup("HEAD", "/flags"));
+        EXPECT_FALSE(cache.Lookup("GET", "/flags", "gzip")) << "vary is part of the key";
+
+        // A pinned entry survives eviction and invalidation
+        //
+        auto pinned = cache.Lookup("GET", "/flags");
+        cache.Insert("GET", "/a", {}, 200, "text/plain", "a");
+        cache.Insert("GET", "/b", {}, 200, "text/plain", "b");
+        EXPECT_EQ(cache.Size(), 2u);
+        EXPECT_FALSE(cache.Lookup("GET", "/flags")) << "least recently used goes first";
+        EXPECT_EQ(pinned->Body(), "{}");
+
+        version++;
+        EXPECT_FALSE(cache.Lookup("GET", "/a")) << "a version bump outdates every entry";
+
+        cache.Insert("GET", "/short", {}, 200, "text/plain", "s", std::chrono::microseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        EXPECT_FALSE(cache.Lookup("GET", "/short"));
+
+        EXPECT_EQ(cache.Stats().hits, 2u);
+        EXPECT_GE(cache.Stats().expirations, 2u);
+    });
+}
+
+TEST(ResponseCacheTest, SendMatchesFormattedResponse)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        coop::http::ResponseCache cache;
+        auto entry = cache.Insert("GET", "/", {}, 200, "text/plain", "OK!\n");
+
+        SendString(client, "GET / HTTP/1.1\r\n\r\nGET / HTTP/1.1\r\nConnection: close\r\n\r\n");
+
+        coop::http::PlaintextTransport transport(server);
+        auto conn = ctx->Allocate<HttpConn>(HTTP_EXTRA,
+            transport, ctx, ctx->GetCooperator());
+        conn->GetRequestLine();
+        conn->SkipHeaders();
+        ASSERT_TRUE(coop::http::ResponseCache::Send(*conn, *entry));
+        conn->Reset();
+
+        conn->GetRequestLine();
+        conn->SkipHeaders();
+        ASSERT_TRUE(coop::http::ResponseCache::Send(*conn, *entry));
+        server.Close();
+
+        // The stored bytes as they are, then the same response formatted for Connection: close
+        //
+        std::string resp = RecvAll(client);
+        ASSERT_EQ(resp.substr(0, entry->bytes.size()), entry->bytes);
+        std::string closed = resp.substr(entry->bytes.size());
+        EXPECT_EQ(closed.find("HTTP/1.1 200 OK\r\nDate: "), 0u);
+        EXPECT_NE(closed.find("Connection: close\r\n\r\nOK!\n"), std::string::npos);
+    });
+}
+
+// -------------------------------------------------------------------------------------
+// Compression
+// -------------------------------------------------------------------------------------
+
+namespace
+{
+
+// Inflate a gzip or zlib stream (windowBits + 32 detects which). Empty on a corrupt stream.
+//
+std::string Inflate(std::string const& coded)
+{
+    z_stream strm{};
+    EXPECT_EQ(inflateInit2(&strm, 15 + 32), Z_OK);
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(coded.data()));
+    strm.avail_in = static_cast<uInt>(coded.size());
+
+    std::string out;
+    char buf[4096];
+    int result = Z_OK;
+    while (result == Z_OK)
+    {
+        strm.next_out = reinterpret_cast<Bytef*>(buf);
+        strm.avail_out = sizeof(buf);
+        result = inflate(&strm, Z_NO_FLUSH);
+        out.append(buf, sizeof(buf) - strm.avail_out);
+    }
+    inflateEnd(&strm);
+    return result == Z_STREAM_END ? out : std::string();
+}
+
+std::string Dechunk(std::string_view body)
+{
+    std::string out;
+    while (true)
+    {
+        size_t eol = body.find("\r\n");
+        size_t size = strtoul(std::string(body.substr(0, eol)).c_str(), nullptr, 16);
+        if (eol == std::string_view::npos || size == 0)
+        {
+            return out;
+        }
+        out.append(body.substr(eol + 2, size));
+        body.remove_prefix(eol + 2 + size + 2);
+    }
+}
+
+std::string TextBody()
+{
+    std::string body;
+    for (int i = 0; body.size() < 8000; i++)
+    {
+        body += "line " + std::to_string(i) + " of a compressible response body\n";
+    }
+    return body;
+}
+
+} // end anonymous namespace
+
+TEST(CompressionTest, NegotiatesAcceptEncoding)
+{
+    using coop::http::AcceptEncoding;
+    using coop::http::ContentEncoding;
+    using coop::http::EncodingBit;
+
+    AcceptEncoding none;
+    EXPECT_EQ(none.Negotiate(), ContentEncoding::IDENTITY);
+
+    AcceptEncoding ae;
+    ae.Parse("deflate, GZIP;q=0.8, br");
+    EXPECT_EQ(ae.Negotiate(), ContentEncoding::DEFLATE);
+    EXPECT_EQ(ae.Negotiate(EncodingBit(ContentEncoding::GZIP)), ContentEncoding::GZIP);
+    EXPECT_FALSE(ae.Accepts(ContentEncoding::ZSTD));
+
+    ae.Clear();
+    ae.Parse("gzip;q=0.5, deflate;q=0.5");
+    EXPECT_EQ(ae.Negotiate(), ContentEncoding::GZIP) << "ties go to gzip over deflate";
+
+    ae.Clear();
+    ae.Parse("*;q=0.1, gzip;q=0");
+    EXPECT_FALSE(ae.Accepts(ContentEncoding::GZIP)) << "q=0 refuses even with a wildcard";
+    EXPECT_TRUE(ae.Accepts(ContentEncoding::ZSTD));
+    EXPECT_EQ(ae.Negotiate(EncodingBit(ContentEncoding::GZIP)), ContentEncoding::IDENTITY);
+    EXPECT_EQ(ae.Negotiate(EncodingBit(ContentEncoding::DEFLATE)), ContentEncoding::DEFLATE);
+
+    // Whole-body coding round-trips, and refuses a body that would not shrink
+    //
+    auto body = TextBody();
+    std::string coded;
+    coop::http::CompressionOptions options;
+    ASSERT_TRUE(coop::http::Compressor::CompressAll(ContentEncoding::DEFLATE, options,
+                                                    body.data(), body.size(), &coded));
+    EXPECT_LT(coded.size(), body.size() / 4);
+    EXPECT_EQ(Inflate(coded), body);
+    EXPECT_FALSE(coop::http::Compressor::CompressAll(ContentEncoding::GZIP, options, "x", 1,
+                                                     &coded));
+}
+
+TEST(CompressionTest, SendAndChunkedCompressNegotiatedBodies)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        SendString(client,
+            "GET /a HTTP/1.1\r\nAccept-Encoding: gzip, deflate\r\n\r\n"
+            "GET /b HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n"
+            "GET /c HTTP/1.1\r\nAccept-Encoding: gzip\r\nConnection: close\r\n\r\n");
+
+        auto body = TextBody();
+        coop::http::CompressionOptions options;
+        options.encodings = coop::http::EncodingBit(coop::http::ContentEncoding::GZIP);
+
+        coop::http::PlaintextTransport transport(server);
+        auto conn = ctx->Allocate<HttpConn>(HTTP_EXTRA,
+            transport, ctx, ctx->GetCooperator());
+
+        // The header is read by Send itself; the handler never looked
+        //
+        conn->GetRequestLine();
+        conn->EnableCompression(&options);
+        ASSERT_TRUE(conn->Send(200, "text/plain", body));
+        conn->Reset();
+
+        conn->GetRequestLine();
+        conn->EnableCompression(&options);
+        ASSERT_TRUE(conn->BeginChunked(200, "text/plain"));
+        ASSERT_TRUE(conn->SendChunk(body.data(), body.size() / 2));
+        ASSERT_TRUE(conn->EndChunked(body.data() + body.size() / 2,
+                                     body.size() - body.size() / 2));
+        conn->Reset();
+
+        // Reset turned compression off again
+        //
+        conn->GetRequestLine();
+        ASSERT_TRUE(conn->Send(200, "text/plain", body));
+        server.Close();
+
+        std::string resp = RecvAll(client, 64 * 1024);
+
+        size_t headersEnd = resp.find("\r\n\r\n");
+        ASSERT_NE(headersEnd, std::string::npos);
+        std::string headers = resp.substr(0, headersEnd + 2);
+        EXPECT_NE(headers.find("Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n"),
+                  std::string::npos);
+        size_t lengthAt = headers.find("Content-Length: ");
+        ASSERT_NE(lengthAt, std::string::npos);
+        size_t length = strtoul(headers.c_str() + lengthAt + 16, nullptr, 10);
+        EXPECT_LT(length, body.size());
+        EXPECT_EQ(Inflate(resp.substr(headersEnd + 4, length)), body);
+
+        resp = resp.substr(headersEnd + 4 + length);
+        headersEnd = resp.find("\r\n\r\n");
+        ASSERT_NE(headersEnd, std::string::npos);
+        headers = resp.substr(0, headersEnd + 2);
+        EXPECT_NE(headers.find("Content-Encoding: gzip\r\n"), std::string::npos);
+        EXPECT_NE(headers.find("Transfer-Encoding: chunked\r\n"), std::string::npos);
+        size_t chunkedEnd = resp.find("\r\n0\r\n\r\n", headersEnd);
+        ASSERT_NE(chunkedEnd, std::string::npos);
+        EXPECT_EQ(Inflate(Dechunk(resp.substr(headersEnd + 4, chunkedEnd + 2 - headersEnd - 4))),
+                  body);
+
+        resp = resp.substr(chunkedEnd + 7);
+        EXPECT_EQ(resp.find("HTTP/1.1 200 OK\r\n"), 0u);
+        EXPECT_EQ(resp.find("Content-Encoding"), std::string::npos);
+        EXPECT_EQ(resp.substr(resp.size() - body.size()), body);
+    });
+}
+
+// -------------------------------------------------------------------------------------
+// File responses: conditional GET and ranges
+// -------------------------------------------------------------------------------------
+
+TEST(FileResponseTest, ConditionalAndRangeRequests)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        namespace http = coop::http;
+
+        EXPECT_EQ(http::response::ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT"), 784111777);
+        EXPECT_EQ(http::response::ParseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT"), -1);
+        char date[http::response::HTTP_DATE_SIZE];
+        http::response::FormatHttpDate(784111777, date);
+        EXPECT_EQ(std::string(date, sizeof(date)), "Sun, 06 Nov 1994 08:49:37 GMT");
+
+        char path[] = "/tmp/coop_file_response_XXXXXX";
+        int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        unlink(path);
+        ASSERT_EQ(write(fd, "0123456789", 10), 10);
+
+        http::FileInfo file{.fd = fd, .size = 10, .mtimeNs = 784111777'000000000LL,
+                            .contentType = "text/plain"};
+        char etagBuf[http::ETAG_MAX];
+        std::string etag(etagBuf, http::FormatETag(file, etagBuf));
+        EXPECT_EQ(etag, "\"a-ae1b981bc490a00\"");
+
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        std::string requests =
+            "GET /f HTTP/1.1\r\n\r\n"
+            "GET /f HTTP/1.1\r\nIf-None-Match: W/\"x\", " + etag + "\r\n\r\n"
+            "GET /f HTTP/1.1\r\nIf-Modified-Since: Sun, 06 Nov 1994 08:49:36 GMT\r\n"
+            "Range: bytes=2-4\r\n\r\n"
+            "GET /f HTTP/1.1\r\nRange: bytes=0-1, -2\r\n\r\n"
+            "GET /f HTTP/1.1\r\nRange: bytes=0-1\r\nIf-Range: \"stale\"\r\n\r\n"
+            "GET /f HTTP/1.1\r\nRange: bytes=10-\r\nConnection: close\r\n\r\n";
+        SendString(client, requests.c_str());
+
+        http::PlaintextTransport transport(server);
+        auto conn = ctx->Allocate<HttpConn>(HTTP_EXTRA,
+            transport, ctx, ctx->GetCooperator());
+        for (int i = 0; i < 6; i++)
+        {
+            ASSERT_TRUE(conn->GetRequestLine());
+            http::FileConditions conditions;
+            conditions.Read(*conn);
+            ASSERT_TRUE(http::SendFileResponse(*conn, conditions, file));
+            conn->Reset();
+        }
+        server.Close();
+        close(fd);
+
+        std::string resp = RecvAll(client);
+        auto next = [&](const char* status)
+        {
+            size_t at = resp.find("HTTP/1.1 ", 1);
+            std::string one = resp.substr(0, at);
+            resp = at == std::string::npos ? std::string() : resp.substr(at);
+            EXPECT_EQ(one.find(status), 0u) << one;
+            EXPECT_NE(one.find("ETag: " + etag + "\r\n"), std::string::npos);
+            return one;
+        };
+
+        auto full = next("HTTP/1.1 200 OK\r\n");
+        EXPECT_NE(full.find("Last-Modified: Sun, 06 Nov 1994 08:49:37 GMT\r\n"), std::string::npos);
+        EXPECT_NE(full.find("Accept-Ranges: bytes\r\n"), std::string::npos);
+        EXPECT_EQ(full.substr(full.size() - 14), "\r\n\r\n0123456789");
+
+        auto notModified = next("HTTP/1.1 304 Not Modified\r\n");
+        EXPECT_EQ(notModified.substr(notModified.size() - 4), "\r\n\r\n") << "304 has no body";
+
+        auto part = next("HTTP/1.1 206 Partial Content\r\n");
+        EXPECT_NE(part.find("Content-Range: bytes 2-4/10\r\n"), std::string::npos);
+        EXPECT_NE(part.find("Content-Length: 3\r\n"), std::string::npos);
+        EXPECT_EQ(part.substr(part.size() - 7), "\r\n\r\n234");
+
+        auto multi = next("HTTP/1.1 206 Partial Content\r\n");
+        EXPECT_NE(multi.find("Content-Type: multipart/byteranges; boundary="), std::string::npos);
+        EXPECT_NE(multi.find("Content-Range: bytes 0-1/10\r\n\r\n01\r\n--"), std::string::npos);
+        EXPECT_NE(multi.find("Content-Range: bytes 8-9/10\r\n\r\n89\r\n--"), std::string::npos);
+        size_t bodyAt = multi.find("\r\n\r\n") + 4;
+        size_t lengthAt = multi.find("Content-Length: ") + 16;
+        EXPECT_EQ(strtoul(multi.c_str() + lengthAt, nullptr, 10), multi.size() - bodyAt);
+
+        auto stale = next("HTTP/1.1 200 OK\r\n");
+        EXPECT_EQ(stale.substr(stale.size() - 10), "0123456789") << "If-Range mismatch: all";
+
+        auto unsatisfiable = next("HTTP/1.1 416 Range Not Satisfiable\r\n");
+        EXPECT_NE(unsatisfiable.find("Content-Range: bytes */10\r\n"), std::string::npos);
+    });
+}
+
+// The index is served gzipped from its precomputed variant and revalidated by its own ETag, a
+// Range goes through SendFileResponse on the memfd, and the watcher picks up a file renamed into
+// place and drops one removed.
+//
+TEST(AssetCacheTest, ServesVariantsAndReloads)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        namespace http = coop::http;
+
+        char root[] = "/tmp/coop_assets_XXXXXX";
+        ASSERT_NE(mkdtemp(root), nullptr);
+        auto put = [&](const char* name, std::string const& content)
+        {
+            std::string tmp = std::string(root) + "/." + name;
+            int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            ASSERT_GE(fd, 0);
+            ASSERT_EQ(write(fd, content.data(), content.size()), ssize_t(content.size()));
+            close(fd);
+            ASSERT_EQ(rename(tmp.c_str(), (std::string(root) + "/" + name).c_str()), 0);
+        };
+        std::string index = TextBody();
+        put("index.html", index);
+        put("app.bin", "0123456789");
+
+        http::AssetCacheOptions options;
+        options.compression.gzipLevel = 1;
+        options.compression.zstdLevel = 1;
+        options.classify = [](const char* path) -> const char*
+        {
+            return strstr(path, ".html") ? "text/html" : nullptr;
+        };
+        http::AssetCache cache(root, options, ctx);
+        ASSERT_EQ(cache.Load(), 2);
+        EXPECT_GT(cache.Bytes(), index.size());
+
+        auto page = cache.Lookup("/");
+        ASSERT_TRUE(page);
+        EXPECT_EQ(page->path, "/index.html");
+        EXPECT_TRUE(page->encodings & http::EncodingBit(http::ContentEncoding::GZIP));
+        auto const& gzipped = page->Get(http::ContentEncoding::GZIP);
+        auto const& plain = page->Get(http::ContentEncoding::IDENTITY);
+        EXPECT_LT(gzipped.size, plain.size);
+        EXPECT_FALSE(cache.Lookup("/missing.js"));
+
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        std::string requests =
+            "GET / HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n"
+            "GET / HTTP/1.1\r\nIf-None-Match: " + plain.etag + "\r\n\r\n"
+            "GET /app.bin HTTP/1.1\r\nRange: bytes=2-4\r\nConnection: close\r\n\r\n";
+        SendString(client, requests.c_str());
+
+        http::PlaintextTransport transport(server);
+        auto conn = ctx->Allocate<HttpConn>(HTTP_EXTRA,
+            transport, ctx, ctx->GetCooperator());
+        for (int i = 0; i < 3; i++)
+        {
+            auto* line = conn->GetRequestLine();
+            ASSERT_TRUE(line);
+            http::FileConditions conditions;
+            conditions.Read(*conn);
+            auto asset = cache.Lookup(line->path);
+            ASSERT_TRUE(asset);
+            ASSERT_TRUE(http::AssetCache::Send(*conn, conditions, *asset));
+            conn->Reset();
+        }
+        server.Close();
+
+        std::string resp = RecvAll(client);
+        size_t second = resp.find("HTTP/1.1 304 Not Modified\r\n");
+        size_t third = resp.find("HTTP/1.1 206 Partial Content\r\n");
+        ASSERT_NE(second, std::string::npos);
+        ASSERT_NE(third, std::string::npos);
+
+        std::string full = resp.substr(0, second);
+        EXPECT_EQ(full.find("HTTP/1.1 200 OK\r\n"), 0u);
+        EXPECT_NE(full.find("ETag: " + gzipped.etag + "\r\n"), std::string::npos);
+        EXPECT_NE(full.find("Content-Encoding: gzip\r\n"), std::string::npos);
+        EXPECT_EQ(Inflate(full.substr(full.find("\r\n\r\n") + 4)), index);
+
+        std::string notModified = resp.substr(second, third - second);
+        EXPECT_EQ(notModified.substr(notModified.size() - 4), "\r\n\r\n") << "304 has no body";
+        EXPECT_EQ(resp.substr(resp.size() - 7), "\r\n\r\n234");
+
+        // Replaced while a Ref holds the old asset, which stays readable
+        //
+        auto old = cache.Lookup("/app.bin");
+        put("app.bin", "abc");
+        for (int i = 0; i < 100 && cache.Lookup("/app.bin")->Get(
+                 http::ContentEncoding::IDENTITY).size != 3; i++)
+        {
+            coop::time::Sleep(ctx, std::chrono::milliseconds(10));
+        }
+        auto fresh = cache.Lookup("/app.bin");
+        ASSERT_TRUE(fresh);
+        EXPECT_EQ(std::string(fresh->Get(http::ContentEncoding::IDENTITY).data, 3), "abc");
+        EXPECT_EQ(std::string(old->Get(http::ContentEncoding::IDENTITY).data, 10), "0123456789");
+        EXPECT_GE(cache.Stats().reloads, 1u);
+
+        unlink((std::string(root) + "/app.bin").c_str());
+        for (int i = 0; i < 100 && cache.Size() != 1; i++)
+        {
+            coop::time::Sleep(ctx, std::chrono::milliseconds(10));
+        }
+        EXPECT_FALSE(cache.Lookup("/app.bin"));
+
+        unlink((std::string(root) + "/index.html").c_str());
+        rmdir(root);
+    });
+}
+
+// -------------------------------------------------------------------------------------
+// Admission control
+// -------------------------------------------------------------------------------------
+
+// Requests past the in-flight limit queue in order, up to maxQueued; the rest, and a waiter that
+// times out, are shed. Connections past maxConnections are refused.
+//
+TEST(AdmissionTest, LimitsQueuesAndSheds)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::http::AdmissionConfiguration config;
+        config.maxConnections = 1;
+        config.maxInFlight = 2;
+        config.maxQueued = 1;
+        config.queueTimeout = std::chrono::milliseconds(20);
+        coop::http::AdmissionControl admission(config);
+
+        EXPECT_TRUE(admission.AdmitConnection());
+        EXPECT_FALSE(admission.AdmitConnection());
+        admission.ConnectionClosed();
+        EXPECT_TRUE(admission.AdmitConnection());
+        EXPECT_EQ(admission.RejectedConnections(), 1u);
+
+        ASSERT_TRUE(admission.BeginRequest(ctx));
+        ASSERT_TRUE(admission.BeginRequest(ctx));
+
+        int admittedWaiter = -1;
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            admittedWaiter = admission.BeginRequest(child);
+        });
+        EXPECT_EQ(admission.Queued(), 1u);
+        EXPECT_FALSE(admission.BeginRequest(ctx)) << "queue full: shed at once";
+
+        admission.EndRequest(std::chrono::microseconds(100));
+        ctx->Yield();
+        EXPECT_EQ(admittedWaiter, 1);
+        EXPECT_EQ(admission.InFlight(), 2u) << "the freed slot went to the waiter";
+        EXPECT_EQ(admission.Queued(), 0u);
+
+        int timedOutWaiter = -1;
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            timedOutWaiter = admission.BeginRequest(child);
+        });
+        coop::time::Sleep(ctx, std::chrono::milliseconds(50));
+        EXPECT_EQ(timedOutWaiter, 0);
+        EXPECT_EQ(admission.Queued(), 0u);
+        EXPECT_EQ(admission.ShedRequests(), 2u);
+
+        admission.EndRequest(std::chrono::microseconds(100));
+        admission.EndRequest(std::chrono::microseconds(100));
+        EXPECT_EQ(admission.InFlight(), 0u);
+    });
+}
+
+// AIMD backs off on a slow request and creeps back up while the limit is in use; the gradient
+// limit falls when latency climbs over its long-term average
+//
+TEST(AdmissionTest, AdaptiveLimits)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::http::AdmissionConfiguration config;
+        config.maxInFlight = 100;
+        config.minInFlight = 10;
+        config.limit = coop::http::AdmissionConfiguration::Limit::AIMD;
+        config.latencyTarget = std::chrono::milliseconds(10);
+        coop::http::AdmissionControl aimd(config);
+
+        ASSERT_TRUE(aimd.BeginRequest(ctx));
+        aimd.EndRequest(std::chrono::milliseconds(20));
+        EXPECT_EQ(aimd.Limit(), 90u);
+        for (int i = 0; i < 30; i++)
+        {
+            ASSERT_TRUE(aimd.BeginRequest(ctx));
+            aimd.EndRequest(std::chrono::milliseconds(20));
+        }
+        EXPECT_EQ(aimd.Limit(), 10u) << "held at minInFlight";
+
+        for (int round = 0; round < 5; round++)
+        {
+            size_t limit = aimd.Limit();
+            for (size_t i = 0; i < limit; i++)
+            {
+                ASSERT_TRUE(aimd.BeginRequest(ctx));
+            }
+            for (size_t i = 0; i < limit; i++)
+            {
+                aimd.EndRequest(std::chrono::milliseconds(1));
+            }
+        }
+        EXPECT_GT(aimd.Limit(), 10u) << "grows while in use";
+
+        config.limit = coop::http::AdmissionConfiguration::Limit::GRADIENT;
+        coop::http::AdmissionControl gradient(config);
+        for (int i = 0; i < 200; i++)
+        {
+            ASSERT_TRUE(gradient.BeginRequest(ctx));
+            gradient.EndRequest(std::chrono::milliseconds(1));
+        }
+        size_t steady = gradient.Limit();
+        for (int i = 0; i < 20; i++)
+        {
+            ASSERT_TRUE(gradient.BeginRequest(ctx));
+            gradient.EndRequest(std::chrono::milliseconds(10));
+        }
+        EXPECT_LT(gradient.Limit(), steady);
+        EXPECT_GE(gradient.Limit(), 10u);
+    });
+}
@@ -1,33 +1,61 @@
 #include <arpa/inet.h>
 #include <cerrno>
+#include <chrono>
 #include <cstring>
 #include <fcntl.h>
+#include <filesystem>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <poll.h>
+#include <string>
 #include <sys/socket.h>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include "coop/continuation.h"
 #include "coop/coordinator.h"
 #include "coop/coordinate_with.h"
+#include "coop/deadline_scope.h"
 #include "coop/self.h"
 #include "coop/signal.h"
 
 #include "coop/io/accept.h"
+#include "coop/io/busy_poll.h"
+#include "coop/io/chain.h"
+#include "coop/io/completion.h"
 #include "coop/io/connect.h"
+#include "coop/io/cork.h"
 #include "coop/io/descriptor.h"
+#include "coop/io/detached.h"
+#include "coop/io/direct_file.h"
+#include "coop/io/file_cache.h"
+#include "coop/io/file_reader.h"
+#include "coop/io/fixed.h"
 #include "coop/io/handle.h"
+#include "coop/io/nvme.h"
 #include "coop/io/poll.h"
+#include "coop/io/proxy.h"
+#include "coop/io/read.h"
+#include "coop/io/read_file.h"
 #include "coop/io/recv.h"
 #include "coop/io/resolve.h"
 #include "coop/io/send.h"
 #include "coop/io/sendfile.h"
 #include "coop/io/splice.h"
+#include "coop/io/sqpoll_pool.h"
+#include "coop/io/stream_stack.h"
 #include "coop/io/shutdown_on_kill.h"
+#include "coop/io/socket.h"
+#include "coop/io/uring.h"
+#include "coop/io/wal.h"
+#include "coop/io/write.h"
 
 #include "coop/time/interval.h"
+#include "coop/time/now.h"
+#include "coop/time/sleep.h"
 
 #include "test_helpers.h"
 
@@ -106,6 +134,64 @@ TEST(IoTest, RecvCompletes)
     });
 }
 
+// With trackContextIo, each context is charged the ops it finalized, as reads and writes, with
+// their bytes and wait; without it only the submit and complete counts move
+//
+TEST(IoTest, ContextIoAccounting)
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.trackContextIo = true;
+    coop::Cooperator co(cfg);
+    coop::Thread t(&co);
+
+    co.SubmitSync([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        coop::io::Descriptor reader(sp.fds[0]);
+        coop::io::Descriptor writer(sp.fds[1]);
+
+        size_t readerBytes = 0;
+        size_t readerWait = 0;
+        bool done = false;
+        ctx->GetCooperator()->Spawn([&](coop::Context* c)
+        {
+            c->SetName("io-reader");
+            char buf[64];
+            int received = coop::io::Recv(reader, buf, sizeof(buf));
+            EXPECT_EQ(received, 5);
+            EXPECT_EQ(c->m_statistics.ioReads, 1u);
+            EXPECT_EQ(c->m_statistics.ioWrites, 0u);
+            readerBytes = c->m_statistics.ioReadBytes;
+            readerWait = c->m_statistics.ioWaitTicks;
+            done = true;
+        });
+
+        const auto before = ctx->m_statistics;
+        EXPECT_EQ(coop::io::Send(writer, "hello", 5), 5);
+        while (!done)
+        {
+            ctx->Yield();
+        }
+        EXPECT_EQ(coop::io::Write(writer, " world", 6), 6);
+        EXPECT_EQ(ctx->m_statistics.ioWrites - before.ioWrites, 2u);
+        EXPECT_EQ(ctx->m_statistics.ioWriteBytes - before.ioWriteBytes, 11u);
+        EXPECT_EQ(ctx->m_statistics.ioReads, before.ioReads);
+        EXPECT_EQ(readerBytes, 5u);
+        EXPECT_GT(readerWait, 0u);
+    });
+    co.Shutdown();
+
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        coop::io::Descriptor writer(sp.fds[1]);
+        EXPECT_EQ(coop::io::Send(writer, "hello", 5), 5);
+        EXPECT_EQ(ctx->m_statistics.ioSubmits, 1u);
+        EXPECT_EQ(ctx->m_statistics.ioWrites, 0u);
+        EXPECT_EQ(ctx->m_statistics.ioWriteBytes, 0u);
+    });
+}
+
 TEST(IoTest, RecvTimesOut)
 {
     test::RunInCooperator([](coop::Context* ctx)
@@ -150,6 +236,105 @@ TEST(IoTest, RecvCompletesBeforeTimeout)
     });
 }
 
+// A coarse timeout puts the deadline in the cooperator's timer queue instead of a linked timeout
+// SQE; expiry cancels the recv and the result is the same -ETIMEDOUT, never early
+//
+TEST(IoTest, RecvCoarseTimesOut)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor reader(sp.fds[0], uring);
+
+        char buf[64] = {};
+        auto start = std::chrono::steady_clock::now();
+        int result = coop::io::Recv(
+            reader, buf, sizeof(buf), 0,
+            coop::io::CoarseTimeout(std::chrono::milliseconds(50)));
+
+        EXPECT_EQ(result, -ETIMEDOUT);
+        EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+    });
+}
+
+TEST(IoTest, RecvCoarseCompletesBeforeTimeout)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor reader(sp.fds[0], uring);
+        coop::io::Descriptor writer(sp.fds[1], uring);
+
+        coop::Coordinator coord;
+        coop::io::Handle handle(ctx, reader, &coord);
+
+        char buf[64] = {};
+        ASSERT_TRUE(coop::io::Recv(
+            handle, buf, sizeof(buf), 0,
+            coop::io::CoarseTimeout(std::chrono::milliseconds(5000))));
+
+        const char* msg = "world";
+        ASSERT_EQ(coop::io::Send(writer, msg, strlen(msg)), 5);
+
+        // Completion unlinks the deadline, so nothing fires after the handle is gone
+        //
+        ASSERT_EQ(handle.Wait(), 5);
+        EXPECT_FALSE(handle.TimedOut());
+        EXPECT_EQ(memcmp(buf, "world", 5), 0);
+    });
+}
+
+// A DeadlineScope bounds the untimed Recv, the explicit timeout of a longer one, and the IO of a
+// context spawned inside it; leaving the scope lifts the bound again
+//
+TEST(IoTest, DeadlineScopeBoundsIo)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor reader(sp.fds[0], uring);
+        coop::io::Descriptor writer(sp.fds[1], uring);
+        char buf[64] = {};
+
+        {
+            coop::DeadlineScope scope(ctx, std::chrono::milliseconds(30));
+            EXPECT_FALSE(coop::DeadlineScope::Expired(ctx));
+
+            // A looser scope inside keeps the tighter deadline
+            //
+            coop::DeadlineScope loose(ctx, std::chrono::seconds(10));
+            EXPECT_LE(coop::DeadlineScope::Remaining(ctx), std::chrono::milliseconds(30));
+
+            int childResult = 0;
+            ctx->GetCooperator()->Spawn([&](coop::Context* child)
+            {
+                char childBuf[8];
+                childResult = coop::io::Recv(reader, childBuf, sizeof(childBuf));
+            });
+
+            auto start = std::chrono::steady_clock::now();
+            EXPECT_EQ(coop::io::Recv(reader, buf, sizeof(buf), 0, std::chrono::seconds(5)),
+                      -ETIMEDOUT);
+            EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+            EXPECT_EQ(coop::io::Recv(reader, buf, sizeof(buf)), -ETIMEDOUT);
+            EXPECT_TRUE(coop::DeadlineScope::Expired(ctx));
+
+            while (childResult == 0)
+            {
+                ctx->Yield();
+            }
+            EXPECT_EQ(childResult, -ETIMEDOUT);
+        }
+
+        EXPECT_EQ(coop::DeadlineScope::Remaining(ctx), coop::time::Interval::max());
+        ASSERT_EQ(coop::io::Send(writer, "hi", 2), 2);
+        EXPECT_EQ(coop::io::Recv(reader, buf, sizeof(buf)), 2);
+    });
+}
+
 TEST(IoTest, CancelPendingRecv)
 {
     test::RunInCooperator([](coop::Context* ctx)
@@ -174,6 +359,105 @@ TEST(IoTest, CancelPendingRecv)
     });
 }
 
+// Several operations in flight on one descriptor -- two async recvs and a context blocked in a
+// third -- all end with one CancelAndDrain, and Close drains whatever is left the same way
+//
+TEST(IoTest, CancelAndDrainTakesEveryHandle)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor reader(sp.fds[0], uring);
+        char buf[3][16];
+
+        coop::Coordinator first, second;
+        coop::io::Handle a(ctx, reader, &first);
+        coop::io::Handle b(ctx, reader, &second);
+        ASSERT_TRUE(coop::io::Recv(a, buf[0], sizeof(buf[0])));
+        ASSERT_TRUE(coop::io::Recv(b, buf[1], sizeof(buf[1])));
+
+        int blocked = 0;
+        ctx->GetCooperator()->Spawn([&](coop::Context*)
+        {
+            blocked = coop::io::Recv(reader, buf[2], sizeof(buf[2]));
+        });
+        EXPECT_FALSE(reader.m_handles.IsEmpty());
+
+        reader.CancelAndDrain(ctx);
+        EXPECT_TRUE(reader.m_handles.IsEmpty());
+        EXPECT_EQ(a.Result(), -ECANCELED);
+        EXPECT_EQ(b.Result(), -ECANCELED);
+        ctx->Yield();
+        EXPECT_EQ(blocked, -ECANCELED);
+
+        // Nothing in flight: a no-op
+        //
+        reader.CancelAndDrain(ctx);
+
+        coop::io::Descriptor other(dup(sp.fds[1]), uring);
+        coop::Coordinator third;
+        coop::io::Handle c(ctx, other, &third);
+        ASSERT_TRUE(coop::io::Recv(c, buf[0], sizeof(buf[0])));
+        EXPECT_EQ(other.Close(), 0);
+        EXPECT_EQ(c.Result(), -ECANCELED);
+    });
+}
+
+// Detached ops queue and return: the peer sees the send and the shutdown, the file goes, and only
+// the failure is heard of -- through the ring's counter and error callback
+//
+static int s_detachedError = 0;
+
+TEST(IoTest, DetachedOpsReportOnlyFailures)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor reader(dup(sp.fds[0]), uring);
+        coop::io::Descriptor writer(dup(sp.fds[1]), uring);
+        coop::io::SetDetachedErrorCallback([](uint8_t, int result) { s_detachedError = result; });
+        auto const before = coop::io::GetDetachedStatistics();
+
+        static const char kReply[] = "bye";
+        ASSERT_TRUE(coop::io::SendDetached(writer, kReply, 3));
+        ASSERT_TRUE(coop::io::ShutdownDetached(writer, SHUT_WR));
+        char buf[16] = {};
+        ASSERT_EQ(coop::io::Recv(reader, buf, sizeof(buf)), 3);
+        EXPECT_EQ(memcmp(buf, kReply, 3), 0);
+        EXPECT_EQ(coop::io::Recv(reader, buf, sizeof(buf)), 0);
+
+        char tmpPath[] = "/tmp/coop_detached_XXXXXX";
+        int fileFd = mkstemp(tmpPath);
+        ASSERT_GE(fileFd, 0);
+        ASSERT_TRUE(coop::io::UnlinkDetached(tmpPath));
+        for (int i = 0; i < 1000 && std::filesystem::exists(tmpPath); i++)
+        {
+            ctx->Yield();
+        }
+        EXPECT_FALSE(std::filesystem::exists(tmpPath));
+
+        // Not a socket
+        //
+        coop::io::Descriptor file(fileFd, uring);
+        ASSERT_TRUE(coop::io::ShutdownDetached(file, SHUT_RDWR));
+        for (int i = 0; i < 1000 && !s_detachedError; i++)
+        {
+            ctx->Yield();
+        }
+        EXPECT_EQ(s_detachedError, -ENOTSOCK);
+
+        ASSERT_TRUE(coop::io::CloseDetached(writer));
+        EXPECT_EQ(writer.m_fd, -1);
+
+        auto const& after = coop::io::GetDetachedStatistics();
+        EXPECT_EQ(after.submitted - before.submitted, 5u);
+        EXPECT_EQ(after.failed - before.failed, 1u);
+        coop::io::SetDetachedErrorCallback(nullptr);
+    });
+}
+
 // A continuation registered on a Handle's coordinator fires straight from the io_uring CQE: the
 // completion runs Finalize -> coord.Release(ctx, false), which drains the continuation as a
 // function call (no extra context). This is the async IO decomposition the continuation work is
@@ -249,6 +533,86 @@ TEST(IoTest, DetachedContinuationFiresFromCqe)
     });
 }
 
+// A continuation-driven handle runs its owner inline from the reap loop: here a stackless echo,
+// Recv -> Send -> Recv on one Completion, serves a peer with no context of its own, and sees the
+// peer's shutdown as a zero-length recv.
+//
+TEST(IoTest, CompletionDrivesStacklessEcho)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        coop::io::Descriptor server(sp.fds[0]);
+        coop::io::Descriptor peer(sp.fds[1]);
+
+        char buf[64];
+        bool receiving = true;
+        int echoed = 0;
+        bool closed = false;
+        coop::io::Completion echo(server, [&](coop::io::Handle& handle, int n)
+        {
+            if (n <= 0)
+            {
+                closed = true;
+                return;
+            }
+            if (receiving)
+            {
+                EXPECT_TRUE(coop::io::Send(handle, buf, n));
+                echoed++;
+            }
+            else
+            {
+                EXPECT_TRUE(coop::io::Recv(handle, buf, sizeof(buf)));
+            }
+            receiving = !receiving;
+        });
+        ASSERT_TRUE(coop::io::Recv(echo, buf, sizeof(buf)));
+
+        for (int i = 0; i < 3; i++)
+        {
+            const char msg[] = "ping";
+            char reply[sizeof(msg)] = {};
+            ASSERT_EQ(coop::io::Send(peer, msg, sizeof(msg)), (int)sizeof(msg));
+            ASSERT_EQ(coop::io::Recv(peer, reply, sizeof(reply)), (int)sizeof(msg));
+            EXPECT_STREQ(reply, "ping");
+        }
+
+        ::shutdown(sp.fds[1], SHUT_WR);
+        while (!closed)
+        {
+            ctx->Yield();
+        }
+        EXPECT_EQ(echoed, 3);
+    });
+}
+
+// Cancelling a continuation-driven handle's operation completes it through the same callback,
+// with -ECANCELED, after which the handle may be destroyed
+//
+TEST(IoTest, CompletionSeesCancel)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        coop::io::Descriptor reader(sp.fds[0]);
+
+        char buf[16];
+        int result = 1;
+        coop::io::Completion recv(reader, [&](coop::io::Handle&, int n) { result = n; });
+        ASSERT_TRUE(coop::io::Recv(recv, buf, sizeof(buf)));
+        ctx->Yield();
+        EXPECT_EQ(result, 1);
+
+        recv.GetHandle().Cancel();
+        while (result == 1)
+        {
+            ctx->Yield();
+        }
+        EXPECT_EQ(result, -ECANCELED);
+    });
+}
+
 TEST(IoTest, RAIICancelOnDestroy)
 {
     test::RunInCooperator([](coop::Context* ctx)
@@ -322,7 +686,7 @@ TEST(IoTest, AsyncAcceptCanBeKilledWithoutInboundConnection)
         childHandle.Kill();
         while (!done)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_TRUE(killed);
@@ -365,7 +729,7 @@ TEST(IoTest, WaitKillCancelsBlockedRecv)
         childHandle.Kill();
         while (!done)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(result, -ECANCELED);
@@ -400,7 +764,7 @@ TEST(IoTest, RecvKillReturnsCanceledWithoutInboundData)
         childHandle.Kill();
         while (!done)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(result, -ECANCELED);
@@ -434,7 +798,7 @@ TEST(IoTest, PollKillReturnsCanceledWithoutReadiness)
         childHandle.Kill();
         while (!done)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(result, -ECANCELED);
@@ -471,7 +835,7 @@ TEST(IoTest, ShutdownOnKillGuardWakesBlockingRecv)
         childHandle.Kill();
         while (!done)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_LE(result, 0);
@@ -624,7 +988,7 @@ TEST(IoTest, SendfileAllKillReturnsCanceledWhenOutputNotWritable)
         childHandle.Kill();
         while (!done)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         ::close(fileFd);
@@ -753,60 +1117,1098 @@ TEST(IoTest, SpliceKillReturnsCanceledWhileWaitingForInput)
         childHandle.Kill();
         while (!done)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(result, -ECANCELED);
     });
 }
 
-// -------------------------------------------------------------------------------------
-// Resolve tests
-// -------------------------------------------------------------------------------------
-
-TEST(ResolveTest, Localhost)
+// A zero-copy send completes only after its notification: SendAllZc returns with every byte
+// delivered, and the Handle counted both CQEs. Without SEND_ZC it falls back to a copying send.
+//
+TEST(IoTest, SendAllZcDeliversLargeBody)
 {
     test::RunInCooperator([](coop::Context* ctx)
     {
-        struct in_addr result;
-        int ret = coop::io::Resolve4("localhost", &result);
-        ASSERT_EQ(ret, 0);
-        EXPECT_EQ(result.s_addr, htonl(INADDR_LOOPBACK));
+        ListeningSocket listener;
+        struct sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        getsockname(listener.fd, reinterpret_cast<struct sockaddr*>(&addr), &len);
+
+        int client = socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_EQ(connect(client, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+        int server = -1;
+        while ((server = accept(listener.fd, nullptr, nullptr)) < 0)
+        {
+            ctx->Yield();
+        }
+
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor reader(client, uring);
+        coop::io::Descriptor writer(server, uring);
+
+        constexpr size_t kSize = 1 << 20;
+        std::vector<char> body(kSize);
+        for (size_t i = 0; i < kSize; i++) body[i] = static_cast<char>(i * 7);
+
+        size_t received = 0;
+        bool match = true;
+        ctx->GetCooperator()->Spawn([&](coop::Context*)
+        {
+            char buf[65536];
+            while (received < kSize)
+            {
+                int n = coop::io::Recv(reader, buf, sizeof(buf));
+                if (n <= 0) break;
+                match = match && memcmp(buf, body.data() + received, n) == 0;
+                received += n;
+            }
+        });
+
+        EXPECT_EQ(coop::io::SendAllZc(writer, body.data(), kSize), (int)kSize);
+        while (received < kSize)
+        {
+            ctx->Yield();
+        }
+        EXPECT_TRUE(match);
+
+        if (uring->SupportsSendZc())
+        {
+            coop::Coordinator coord;
+            coop::io::Handle handle(ctx, writer, &coord);
+            ASSERT_TRUE(coop::io::SendZc(handle, body.data(), 4096));
+            EXPECT_EQ(handle.Wait(), 4096);
+            EXPECT_EQ(handle.Result(), 4096) << "both CQEs accounted for";
+
+            char buf[4096];
+            EXPECT_EQ(coop::io::Recv(reader, buf, sizeof(buf), MSG_WAITALL), 4096);
+        }
     });
 }
 
-TEST(ResolveTest, NumericPassthrough)
+// A Cork holds a turn's sends and writes them as one when the context yields or blocks: a
+// blocking Recv is enough to put them on the wire. A send too large for the buffer goes straight
+// through behind what was queued, and the destructor flushes the rest.
+//
+TEST(IoTest, CorkCoalescesSends)
 {
     test::RunInCooperator([](coop::Context* ctx)
     {
-        struct in_addr result;
-        int ret = coop::io::Resolve4("127.0.0.1", &result);
-        ASSERT_EQ(ret, 0);
-        EXPECT_EQ(result.s_addr, htonl(INADDR_LOOPBACK));
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor reader(sp.fds[0], uring);
+        coop::io::Descriptor writer(sp.fds[1], uring);
+        char buf[256] = {};
+
+        {
+            coop::io::Cork cork(writer, 64);
+            EXPECT_EQ(coop::io::Send(writer, "head:", 5), 5);
+            EXPECT_EQ(coop::io::SendAll(writer, "body:", 5), 5);
+            EXPECT_EQ(coop::io::SendFastpath(writer, "tail", 4, MSG_MORE), 4);
+            EXPECT_EQ(cork.Pending(), 14u);
+            EXPECT_EQ(recv(sp.fds[0], buf, sizeof(buf), MSG_DONTWAIT), -1) << "nothing sent yet";
+
+            EXPECT_EQ(coop::io::Recv(reader, buf, 14, MSG_WAITALL), 14);
+            EXPECT_EQ(memcmp(buf, "head:body:tail", 14), 0);
+            EXPECT_EQ(cork.GetStatistics().sends, 3u);
+            EXPECT_EQ(cork.GetStatistics().flushes, 1u);
+            EXPECT_EQ(cork.GetStatistics().bytes, 14u);
+
+            std::string big(100, 'x');
+            EXPECT_EQ(coop::io::Send(writer, "abc", 3), 3);
+            EXPECT_EQ(coop::io::Send(writer, big.data(), big.size()), (int)big.size());
+            EXPECT_EQ(cork.GetStatistics().bypassed, 1u);
+            EXPECT_EQ(cork.Pending(), 0u);
+            EXPECT_EQ(coop::io::Recv(reader, buf, 103, MSG_WAITALL), 103);
+            EXPECT_EQ(memcmp(buf, "abc", 3), 0);
+            EXPECT_EQ(std::string(buf + 3, 100), big);
+
+            EXPECT_EQ(coop::io::Send(writer, "end", 3), 3);
+        }
+        EXPECT_EQ(writer.m_cork, nullptr);
+        EXPECT_EQ(ctx->m_corks, nullptr);
+        EXPECT_EQ(coop::io::Recv(reader, buf, 3, MSG_WAITALL), 3);
+        EXPECT_EQ(memcmp(buf, "end", 3), 0);
     });
 }
 
-TEST(ResolveTest, PublicHostname)
+// A composed stack sends nothing until Flush, then all of it in one write, and reads lines in
+// place -- one longer than the reader's buffer in pieces -- the same through the Stream adapter.
+//
+TEST(IoTest, ComposedStreamBuffersAndReadsLines)
 {
-    test::RunInCooperator([](coop::Context* ctx)
+    test::RunInCooperator([](coop::Context*)
     {
-        struct in_addr result;
-        int ret = coop::io::Resolve4("dns.google", &result,
-            std::chrono::seconds(10));
-        ASSERT_EQ(ret, 0);
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor peer(sp.fds[0], uring);
+        coop::io::Descriptor desc(sp.fds[1], uring);
+        char buf[256] = {};
+
+        using Stack = coop::io::Compose<coop::io::BufferedReader<16>, coop::io::Buffered<64>,
+                                        coop::io::Plain>;
+        coop::io::StreamAdapter<Stack> adapter(desc);
+        Stack& stack = adapter.Get();
+
+        EXPECT_EQ(stack.SendAll("one ", 4), 4);
+        EXPECT_EQ(stack.Send("two", 3), 3);
+        EXPECT_EQ(stack.Next().Pending(), 7u);
+        EXPECT_EQ(recv(sp.fds[0], buf, sizeof(buf), MSG_DONTWAIT), -1) << "nothing sent yet";
+        coop::io::Stream& stream = adapter;
+        EXPECT_EQ(stream.Flush(), 0);
+        EXPECT_EQ(stack.Next().Pending(), 0u);
+        EXPECT_EQ(coop::io::Recv(peer, buf, 7, MSG_WAITALL), 7);
+        EXPECT_EQ(memcmp(buf, "one two", 7), 0);
+
+        const char* lines = "GET a\r\nshort\nthis line is longer than sixteen\r\ntail";
+        coop::io::SendAll(peer, lines, strlen(lines));
+        shutdown(sp.fds[0], SHUT_WR);
+
+        std::string_view line;
+        bool complete;
+        EXPECT_EQ(stack.ReadLine(&line, &complete), 7);
+        EXPECT_EQ(line, "GET a");
+        EXPECT_TRUE(complete);
+
+        EXPECT_EQ(stack.ReadLine(&line, &complete), 6);
+        EXPECT_EQ(line, "short");
+        EXPECT_TRUE(complete);
+
+        std::string joined;
+        int pieces = 0;
+        do
+        {
+            ASSERT_GT(stack.ReadLine(&line, &complete), 0);
+            joined.append(line);
+            pieces++;
+        } while (!complete);
+        EXPECT_EQ(joined, "this line is longer than sixteen");
+        EXPECT_GT(pieces, 1);
+
+        EXPECT_EQ(stream.Recv(buf, sizeof(buf)), 4);
+        EXPECT_EQ(memcmp(buf, "tail", 4), 0);
+        EXPECT_EQ(stack.ReadLine(&line, &complete), 0);
+    });
+}
 
-        // dns.google resolves to 8.8.8.8 or 8.8.4.4
+// The registered buffer pool hands out each buffer once, maps pointers back to their index only
+// when the range stays inside one buffer, and WriteFixed/ReadFixed round-trip a file through it.
+//
+TEST(IoTest, FixedBuffersReadWrite)
+{
+    coop::CooperatorConfiguration cfg;
+    cfg.uring.fixedBuffers = 2;
+    cfg.uring.fixedBufferSize = 8192;
+
+    coop::Cooperator cooperator(cfg);
+    coop::Thread thread(&cooperator);
+
+    cooperator.SubmitSync([](coop::Context*)
+    {
+        auto* uring = coop::GetUring();
+        if (!uring->SupportsFixedBuffers())
+        {
+            GTEST_SKIP() << "io_uring_register_buffers unavailable";
+        }
+        ASSERT_EQ(uring->FixedBufferSize(), 8192u);
+
+        auto a = uring->AcquireFixedBuffer();
+        auto b = uring->AcquireFixedBuffer();
+        ASSERT_NE(a.data, nullptr);
+        ASSERT_NE(b.data, nullptr);
+        EXPECT_EQ(uring->AcquireFixedBuffer().index, -1) << "pool exhausted";
+
+        EXPECT_EQ(uring->FixedBufferIndex(static_cast<char*>(a.data) + 100, 1000), a.index);
+        EXPECT_EQ(uring->FixedBufferIndex(static_cast<char*>(a.data) + 8000, 1000), -1)
+            << "range straddles two buffers";
+        char outside[16];
+        EXPECT_EQ(uring->FixedBufferIndex(outside, sizeof(outside)), -1);
+
+        char tmpPath[] = "/tmp/coop_fixed_XXXXXX";
+        int fileFd = mkstemp(tmpPath);
+        ASSERT_GE(fileFd, 0);
+        unlink(tmpPath);
+        coop::io::Descriptor file(fileFd, uring);
+
+        memset(a.data, 'x', 8192);
+        ASSERT_EQ(coop::io::WriteFixed(file, a.data, 8192, a.index), 8192);
+
+        memset(b.data, 0, 8192);
+        ASSERT_EQ(coop::io::ReadFixed(file, static_cast<char*>(b.data) + 4096, 4096, b.index, 4096),
+                  4096);
+        EXPECT_EQ(memcmp(static_cast<char*>(b.data) + 4096, a.data, 4096), 0);
+        EXPECT_EQ(static_cast<char*>(b.data)[0], 0);
+
+        uring->ReleaseFixedBuffer(b.index);
+        EXPECT_EQ(uring->AcquireFixedBuffer().index, b.index) << "LIFO reuse";
+        uring->ReleaseFixedBuffer(b.index);
+        uring->ReleaseFixedBuffer(a.index);
+    });
+
+    cooperator.Shutdown();
+}
+
+// A busy-polling cooperator still sleeps and wakes correctly: the spin (in the kernel with NAPI,
+// here without) gives up after its bound and the wait falls through to blocking, and a completion
+// that arrives during or after the spin is delivered either way.
+//
+TEST(IoTest, BusyPollWaitDeliversCompletions)
+{
+    coop::CooperatorConfiguration cfg;
+    cfg.uring.busyPollUs = 50;
+
+    coop::Cooperator cooperator(cfg);
+    coop::Thread thread(&cooperator);
+
+    cooperator.SubmitSync([](coop::Context* ctx)
+    {
+        auto* uring = coop::GetUring();
+        SocketPair sp;
+        coop::io::Descriptor reader(sp.fds[0], uring);
+        coop::io::Descriptor writer(sp.fds[1], uring);
+        sp.fds[0] = sp.fds[1] = -1;
+
+        // One reply inside the spin budget, one well past it
         //
-        struct in_addr expected1, expected2;
-        inet_pton(AF_INET, "8.8.8.8", &expected1);
-        inet_pton(AF_INET, "8.8.4.4", &expected2);
-        EXPECT_TRUE(result.s_addr == expected1.s_addr || result.s_addr == expected2.s_addr);
+        for (auto delay : {std::chrono::microseconds(10), std::chrono::microseconds(5000)})
+        {
+            ctx->GetCooperator()->Spawn([&](coop::Context* child)
+            {
+                coop::time::Sleep(child, delay);
+                coop::io::Send(writer, "x", 1);
+            });
+            char c = 0;
+            EXPECT_EQ(coop::io::Recv(reader, &c, 1), 1);
+            EXPECT_EQ(c, 'x');
+        }
+
+        // The socket option needs CAP_NET_ADMIN above net.core.busy_poll
+        //
+        int tcp = socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_GE(tcp, 0);
+        coop::io::Descriptor sock(tcp, uring);
+        int err = coop::io::SetBusyPoll(sock);
+        EXPECT_TRUE(err == 0 || err == -EPERM || err == -ENOPROTOOPT) << err;
     });
+
+    cooperator.Shutdown();
 }
 
-TEST(ResolveTest, NonExistent)
+// The adaptive spin follows the traffic: waits far longer than the cap switch it off, and short
+// ones bring it back. Completions are delivered either way.
+//
+TEST(IoTest, AdaptiveSpinTracksWaitGaps)
 {
-    test::RunInCooperator([](coop::Context* ctx)
+    coop::CooperatorConfiguration cfg;
+    cfg.uring.adaptiveSpinMaxUs = 1000;
+
+    coop::Cooperator cooperator(cfg);
+    coop::Thread thread(&cooperator);
+
+    cooperator.SubmitSync([](coop::Context* ctx)
+    {
+        auto* uring = coop::GetUring();
+        EXPECT_EQ(uring->AdaptiveSpinWindowNs(), 1000000) << "starts at the cap";
+
+        SocketPair sp;
+        coop::io::Descriptor reader(sp.fds[0], uring);
+        coop::io::Descriptor writer(sp.fds[1], uring);
+        sp.fds[0] = sp.fds[1] = -1;
+
+        auto roundTrips = [&](int n, std::chrono::microseconds delay)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                ctx->GetCooperator()->Spawn([&](coop::Context* child)
+                {
+                    coop::time::Sleep(child, delay);
+                    coop::io::Send(writer, "x", 1);
+                });
+                char c = 0;
+                ASSERT_EQ(coop::io::Recv(reader, &c, 1), 1);
+            }
+        };
+
+        roundTrips(12, std::chrono::microseconds(10000));
+        EXPECT_EQ(uring->AdaptiveSpinWindowNs(), 0);
+
+        roundTrips(100, std::chrono::microseconds(1));
+        EXPECT_GT(uring->AdaptiveSpinWindowNs(), 0);
+    });
+
+    cooperator.Shutdown();
+}
+
+// A burst of submissions on a small ring finds the SQ full; the Poll after it grows the ring where
+// the kernel can resize (6.13+), and otherwise leaves it at its size with the warning. The sends
+// all land either way.
+//
+TEST(IoTest, RingGrowsUnderSubmissionPressure)
+{
+    coop::CooperatorConfiguration cfg;
+    cfg.uring.entries = 8;
+    cfg.uring.deferTaskrun = true;
+    cfg.uring.maxEntries = 64;
+
+    coop::Cooperator cooperator(cfg);
+    coop::Thread thread(&cooperator);
+
+    cooperator.SubmitSync([](coop::Context* ctx)
+    {
+        auto* uring = coop::GetUring();
+        const uint32_t entries = uring->SqEntries();
+        SocketPair sp;
+        coop::io::Descriptor reader(sp.fds[0], uring);
+        coop::io::Descriptor writer(sp.fds[1], uring);
+        sp.fds[0] = sp.fds[1] = -1;
+
+        constexpr int kBurst = 40;
+        for (int i = 0; i < kBurst; i++)
+        {
+            ASSERT_TRUE(coop::io::SendDetached(writer, "x", 1));
+        }
+        EXPECT_GT(uring->GetRingStatistics().sqFull, 0u);
+
+        char buf[kBurst];
+        int received = 0;
+        while (received < kBurst)
+        {
+            int n = coop::io::Recv(reader, buf, sizeof(buf) - received);
+            ASSERT_GT(n, 0);
+            received += n;
+        }
+        ctx->Yield();
+
+        auto const& stats = uring->GetRingStatistics();
+        if (stats.resizes == 0)
+        {
+            EXPECT_EQ(uring->SqEntries(), entries);
+            GTEST_SKIP() << "kernel or liburing cannot resize rings";
+        }
+        EXPECT_GT(uring->SqEntries(), entries);
+        EXPECT_LE(uring->SqEntries(), 64u);
+    });
+
+    cooperator.Shutdown();
+}
+
+// A chain runs its steps in order with one wait: the write lands before the read that follows it.
+// A short read fails a soft link, so the step behind it is skipped with -ECANCELED; behind a hard
+// link the next step runs anyway.
+//
+TEST(IoTest, ChainLinksSteps)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        char tmpPath[] = "/tmp/coop_chain_XXXXXX";
+        int fileFd = mkstemp(tmpPath);
+        ASSERT_GE(fileFd, 0);
+        unlink(tmpPath);
+        coop::io::Descriptor file(fileFd);
+
+        char buf[16] = {};
+        {
+            coop::io::Chain chain;
+            coop::io::Write(chain.Then(file), "hello", 5, 0);
+            coop::io::Read(chain.Last(file), buf, 5, 0);
+            EXPECT_EQ(chain.Wait(), 5);
+            EXPECT_EQ(chain.Result(0), 5);
+            EXPECT_STREQ(buf, "hello");
+        }
+
+        char rest[16] = {};
+        {
+            coop::io::Chain chain;
+            coop::io::Read(chain.Then(file), buf, sizeof(buf), 0);
+            coop::io::Read(chain.Last(file), rest, 2, 3);
+            chain.Wait();
+            EXPECT_EQ(chain.Result(0), 5) << "short read";
+            EXPECT_EQ(chain.Result(1), -ECANCELED);
+        }
+        {
+            coop::io::Chain chain;
+            coop::io::Read(chain.Then(file, coop::io::Link::Hard), buf, sizeof(buf), 0);
+            coop::io::Read(chain.Last(file), rest, 2, 3);
+            EXPECT_EQ(chain.Wait(), 2);
+            EXPECT_STREQ(rest, "lo");
+        }
+    });
+}
+
+// ReadFile opens, reads and probes a file in one chain through a reserved registered slot, and
+// returns the slot when done; a file larger than the buffer is an overflow.
+//
+TEST(IoTest, ReadFileChained)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        char tmpPath[] = "/tmp/coop_readfile_XXXXXX";
+        int fd = mkstemp(tmpPath);
+        ASSERT_GE(fd, 0);
+        std::string content(3000, 'r');
+        ASSERT_EQ(::write(fd, content.data(), content.size()), (ssize_t)content.size());
+        close(fd);
+
+        auto* uring = coop::GetUring();
+        int slot = uring->ReserveSlot();
+        if (slot >= 0)
+        {
+            coop::io::Descriptor release(coop::io::direct, slot, uring);   // hand it straight back
+        }
+
+        char buf[4096];
+        EXPECT_EQ(coop::io::ReadFile(tmpPath, buf, sizeof(buf)), 3000);
+        EXPECT_EQ(memcmp(buf, content.data(), content.size()), 0);
+        EXPECT_EQ(coop::io::ReadFile(tmpPath, buf, 3000), 3000) << "exact fit probes EOF";
+        EXPECT_EQ(coop::io::ReadFile(tmpPath, buf, 1000), -EOVERFLOW);
+        EXPECT_EQ(coop::io::ReadFile("/nonexistent/coop", buf, sizeof(buf)), -ENOENT);
+
+        if (slot >= 0)
+        {
+            EXPECT_EQ(uring->ReserveSlot(), slot) << "ReadFile returned its slot";
+            coop::io::Descriptor release(coop::io::direct, slot, uring);
+        }
+        unlink(tmpPath);
+    });
+}
+
+// The chained splice relays a hop with the same results as Splice, and reports EOF as 0.
+//
+TEST(IoTest, SpliceChained)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        SocketPair sp, sp2;
+        fcntl(sp.fds[0], F_SETFL, fcntl(sp.fds[0], F_GETFL) | O_NONBLOCK);
+        fcntl(sp2.fds[1], F_SETFL, fcntl(sp2.fds[1], F_GETFL) | O_NONBLOCK);
+
+        coop::io::Descriptor in(sp.fds[0]);
+        coop::io::Descriptor out(sp2.fds[1]);
+
+        int pipefd[2];
+        ASSERT_EQ(pipe2(pipefd, O_NONBLOCK), 0);
+
+        const char* msg = "hello chained splice!";
+        size_t msgLen = strlen(msg);
+        ASSERT_EQ(::write(sp.fds[1], msg, msgLen), (ssize_t)msgLen);
+        EXPECT_EQ(coop::io::SpliceChained(in, out, pipefd, 65536), (int)msgLen);
+
+        char buf[64] = {};
+        ASSERT_EQ(::read(sp2.fds[0], buf, sizeof(buf)), (ssize_t)msgLen);
+        EXPECT_EQ(memcmp(buf, msg, msgLen), 0);
+
+        shutdown(sp.fds[1], SHUT_WR);
+        EXPECT_EQ(coop::io::SpliceChained(in, out, pipefd, 65536), 0);
+
+        close(pipefd[0]);
+        close(pipefd[1]);
+    });
+}
+
+// Proxy relays both directions through pooled pipes, turns an EOF on one side into a half-close of
+// the other while the reverse direction keeps flowing, and returns once both have closed.
+//
+TEST(IoTest, ProxyRelaysAndPropagatesHalfClose)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair client, upstream;
+        fcntl(client.fds[1], F_SETFL, fcntl(client.fds[1], F_GETFL) | O_NONBLOCK);
+        fcntl(upstream.fds[0], F_SETFL, fcntl(upstream.fds[0], F_GETFL) | O_NONBLOCK);
+
+        coop::io::Descriptor a(coop::io::borrowed, client.fds[1]);
+        coop::io::Descriptor b(coop::io::borrowed, upstream.fds[0]);
+        coop::io::Descriptor clientEnd(coop::io::borrowed, client.fds[0]);
+        coop::io::Descriptor upstreamEnd(coop::io::borrowed, upstream.fds[1]);
+
+        coop::io::ProxyStats stats;
+        int result = 1;
+        ctx->GetCooperator()->Spawn([&](coop::Context*)
+        {
+            result = coop::io::Proxy(a, b, {}, &stats);
+        });
+
+        char buf[64] = {};
+        ASSERT_EQ(coop::io::Send(clientEnd, "ping", 4), 4);
+        ASSERT_EQ(coop::io::Recv(upstreamEnd, buf, sizeof(buf)), 4);
+        EXPECT_EQ(memcmp(buf, "ping", 4), 0);
+
+        shutdown(client.fds[0], SHUT_WR);
+        EXPECT_EQ(coop::io::Recv(upstreamEnd, buf, sizeof(buf)), 0) << "half-close propagated";
+
+        ASSERT_EQ(coop::io::Send(upstreamEnd, "pong!", 5), 5);
+        ASSERT_EQ(coop::io::Recv(clientEnd, buf, sizeof(buf)), 5) << "reverse direction still open";
+        EXPECT_EQ(memcmp(buf, "pong!", 5), 0);
+        EXPECT_EQ(result, 1);
+
+        shutdown(upstream.fds[1], SHUT_WR);
+        EXPECT_EQ(coop::io::Recv(clientEnd, buf, sizeof(buf)), 0);
+        while (result == 1)
+        {
+            ctx->Yield();
+        }
+        EXPECT_EQ(result, 0);
+        EXPECT_EQ(stats.aToB, 4u);
+        EXPECT_EQ(stats.bToA, 5u);
+    });
+}
+
+// A DirectFile on a dedicated storage ring writes a batch of registered blocks at scattered
+// offsets in one submission and reads them back the same way. The ring is not IOPOLL here -- that
+// needs a pollable block device -- but it is driven exactly as one would be.
+//
+TEST(IoTest, DirectFileBatchedBlocks)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::io::UringConfiguration config;
+        config.fixedBuffers = 8;
+        config.fixedBufferSize = 4096;
+        coop::io::Uring storage(config);
+
+        coop::Context::Handle driver;
+        ctx->GetCooperator()->Spawn([&](coop::Context* c) { storage.Run(c); }, &driver);
+        if (!storage.SupportsFixedBuffers())
+        {
+            driver.Kill();
+            GTEST_SKIP() << "io_uring_register_buffers unavailable";
+        }
+
+        char tmpPath[] = "/var/tmp/coop_direct_XXXXXX";
+        int fd = mkstemp(tmpPath);
+        ASSERT_GE(fd, 0);
+        close(fd);
+
+        {
+            coop::io::DirectFile file(tmpPath, O_RDWR, 0, &storage);
+            if (!file.IsOpen())
+            {
+                unlink(tmpPath);
+                driver.Kill();
+                GTEST_SKIP() << "O_DIRECT unsupported here err=" << file.Error();
+            }
+            ASSERT_EQ(file.BlockSize(), 4096u);
+
+            constexpr int N = 4;
+            coop::io::Uring::FixedBuffer blocks[N];
+            coop::io::DirectFile::BlockIo ops[N];
+            for (int i = 0; i < N; i++)
+            {
+                blocks[i] = file.AcquireBlock();
+                ASSERT_NE(blocks[i].data, nullptr);
+                memset(blocks[i].data, 'a' + i, 4096);
+                uint64_t offset = static_cast<uint64_t>(N - i) * 8192;
+                ops[i] = {blocks[i].data, 4096, offset, blocks[i].index};
+            }
+            EXPECT_EQ(file.WriteAt(ops, N), N);
+
+            for (int i = 0; i < N; i++)
+            {
+                memset(blocks[i].data, 0, 4096);
+            }
+            EXPECT_EQ(file.ReadAt(ops, N), N);
+            for (int i = 0; i < N; i++)
+            {
+                EXPECT_EQ(ops[i].result, 4096);
+                EXPECT_EQ(static_cast<char*>(blocks[i].data)[4095], 'a' + i);
+                file.ReleaseBlock(blocks[i]);
+            }
+
+            auto hole = file.AcquireBlock();
+            EXPECT_EQ(file.ReadAt(hole.data, 4096, 8192 * 5, hole.index), 0) << "past EOF";
+            file.ReleaseBlock(hole);
+            EXPECT_EQ(file.Close(), 0);
+        }
+
+        unlink(tmpPath);
+        driver.Kill();
+    });
+}
+
+// A cooperator configured with a storage ring drives it from its own loop: DirectFile lands on it
+// by default, with no driver context, and its IO round-trips. IOPOLL is off for the same reason as
+// above.
+//
+TEST(IoTest, CooperatorStorageRing)
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.storage.entries = 64;
+    cfg.storage.iopoll = false;
+    cfg.storage.fixedBuffers = 4;
+    cfg.storage.fixedBufferSize = 4096;
+    coop::Cooperator co(cfg);
+    coop::Thread t(&co);
+
+    co.SubmitSync([](coop::Context* ctx)
+    {
+        auto* storage = ctx->GetCooperator()->GetStorageUring();
+        ASSERT_NE(storage, nullptr);
+        EXPECT_EQ(coop::GetStorageUring(), storage);
+        EXPECT_NE(storage, coop::GetUring());
+        if (!storage->SupportsFixedBuffers())
+        {
+            GTEST_SKIP() << "io_uring_register_buffers unavailable";
+        }
+
+        char tmpPath[] = "/var/tmp/coop_storage_XXXXXX";
+        int fd = mkstemp(tmpPath);
+        ASSERT_GE(fd, 0);
+        close(fd);
+
+        {
+            coop::io::DirectFile file(tmpPath, O_RDWR);
+            if (!file.IsOpen())
+            {
+                unlink(tmpPath);
+                GTEST_SKIP() << "O_DIRECT unsupported here err=" << file.Error();
+            }
+
+            auto block = file.AcquireBlock();
+            ASSERT_NE(block.data, nullptr);
+            memset(block.data, 'z', 4096);
+            EXPECT_EQ(file.WriteAt(block.data, 4096, 4096, block.index), 4096);
+            memset(block.data, 0, 4096);
+            EXPECT_EQ(file.ReadAt(block.data, 4096, 4096, block.index), 4096);
+            EXPECT_EQ(static_cast<char*>(block.data)[0], 'z');
+            EXPECT_EQ(storage->PendingOps(), 0);
+            file.ReleaseBlock(block);
+        }
+        unlink(tmpPath);
+    });
+    co.Shutdown();
+}
+
+// NVMe passthrough wants a storage ring with big SQEs and CQEs and a namespace's char device; each
+// is refused without the other. COOP_TEST_NVME names a /dev/ngXnY to read its first block from --
+// a read only, nothing on the device is written.
+//
+TEST(IoTest, NvmeDeviceOnPassthroughRing)
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.storage.entries = 64;
+    cfg.storage.iopoll = false;
+    cfg.storage.cqe32 = true;
+    cfg.storage.sqe128 = true;
+    cfg.storage.fixedBuffers = 2;
+    cfg.storage.fixedBufferSize = 64 * 1024;
+    coop::Cooperator co(cfg);
+    coop::Thread t(&co);
+
+    co.SubmitSync([](coop::Context*)
+    {
+        auto* storage = coop::GetStorageUring();
+        ASSERT_NE(storage, nullptr);
+        EXPECT_FALSE(coop::GetUring()->SupportsPassthrough());
+        if (!storage->SupportsPassthrough())
+        {
+            GTEST_SKIP() << "kernel lacks IORING_SETUP_SQE128";
+        }
+
+        coop::io::NvmeDevice plainRing("/dev/null", coop::GetUring());
+        EXPECT_FALSE(plainRing.IsOpen());
+        EXPECT_EQ(plainRing.Error(), -EINVAL);
+
+        coop::io::NvmeDevice notNvme("/dev/null");
+        EXPECT_FALSE(notNvme.IsOpen());
+        EXPECT_EQ(notNvme.Error(), -ENOTTY);
+
+        const char* path = getenv("COOP_TEST_NVME");
+        if (!path)
+        {
+            return;
+        }
+        coop::io::NvmeDevice device(path);
+        ASSERT_TRUE(device.IsOpen()) << "err=" << device.Error();
+        EXPECT_GT(device.Blocks(), 0u);
+
+        auto buffer = device.AcquireBuffer();
+        ASSERT_NE(buffer.data, nullptr);
+        EXPECT_EQ(device.ReadAt(buffer.data, device.BlockSize(), 0, buffer.index),
+            static_cast<int>(device.BlockSize()));
+        EXPECT_EQ(storage->PendingOps(), 0);
+        device.ReleaseBuffer(buffer);
+    });
+    co.Shutdown();
+}
+
+// An SqpollPool hands out poller roles per node up to its limit, holds a joiner back until a poller
+// publishes, attaches the rest round robin, and passes a refused poller's role on
+//
+TEST(IoTest, SqpollPoolAssignsPollers)
+{
+    coop::io::SqpollPool pool(2);
+    EXPECT_EQ(pool.Join(0), -1);
+    EXPECT_EQ(pool.Join(0), -1);
+
+    int attached = -2;
+    std::thread waiter([&] { attached = pool.Join(0); });
+    pool.Publish(0, 10);
+    waiter.join();
+    EXPECT_EQ(attached, 10);
+
+    EXPECT_EQ(pool.Join(1), -1) << "nodes are separate";
+    pool.Publish(1, -1);
+    EXPECT_EQ(pool.Join(1), -1) << "a refused poller's role goes to the next ring";
+
+    pool.Publish(0, 11);
+    EXPECT_EQ(pool.Pollers(), 2u);
+    int a = pool.Join(0);
+    int b = pool.Join(0);
+    EXPECT_NE(a, b);
+    EXPECT_TRUE((a == 10 || a == 11) && (b == 10 || b == 11));
+    EXPECT_GE(pool.Join(-1), 10) << "an unknown node counts as 0";
+}
+
+// Cooperators configured through a pool share one SQPOLL thread: the second ring attaches to the
+// first's, and IO flows on both. Skips where SQPOLL is not granted.
+//
+TEST(IoTest, SqpollPoolSharesPoller)
+{
+    coop::io::SqpollPool pool(1);
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    pool.Configure(cfg.uring);
+
+    coop::Cooperator first(cfg);
+    coop::Thread t1(&first);
+    first.SubmitSync([](coop::Context*) {});
+    if (pool.Pollers() == 0)
+    {
+        first.Shutdown();
+        GTEST_SKIP() << "SQPOLL not granted";
+    }
+
+    coop::Cooperator second(cfg);
+    coop::Thread t2(&second);
+    for (auto* co : {&first, &second})
+    {
+        co->SubmitSync([](coop::Context*)
+        {
+            SocketPair sp;
+            coop::io::Descriptor a(sp.fds[0]);
+            coop::io::Descriptor b(sp.fds[1]);
+            char buf[8];
+            EXPECT_EQ(coop::io::Send(a, "ping", 4), 4);
+            EXPECT_EQ(coop::io::Recv(b, buf, sizeof(buf)), 4);
+        });
+    }
+
+    EXPECT_EQ(pool.Pollers(), 1u);
+    EXPECT_EQ(first.GetUring()->GetConfiguration().attachSqFd, -1);
+    EXPECT_EQ(second.GetUring()->GetConfiguration().attachSqFd, first.GetUring()->RingFd());
+    first.Shutdown();
+    second.Shutdown();
+}
+
+// Registered descriptors claim slots of the sparse table from its free list and give them back on
+// close, an explicit Close included (IORING_OP_CLOSE refuses a fixed file).
+//
+TEST(IoTest, RegisteredTableFreeList)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        auto* ring = coop::GetUring();
+        size_t free = ring->FreeSlots();
+        if (free < 2)
+        {
+            GTEST_SKIP() << "no registered file table";
+        }
+
+        SocketPair sp;
+        {
+            coop::io::Descriptor a(coop::io::registered, sp.fds[0]);
+            coop::io::Descriptor b(coop::io::registered, sp.fds[1]);
+            ASSERT_GE(a.m_registeredIndex, 0);
+            ASSERT_GE(b.m_registeredIndex, 0);
+            EXPECT_NE(a.m_registeredIndex, b.m_registeredIndex);
+            EXPECT_EQ(ring->FreeSlots(), free - 2);
+
+            char buf[8];
+            EXPECT_EQ(coop::io::Send(a, "fixed", 5), 5);
+            EXPECT_EQ(coop::io::Recv(b, buf, sizeof(buf)), 5);
+
+            EXPECT_EQ(a.Close(), 0);
+            EXPECT_EQ(a.m_registeredIndex, -1);
+            EXPECT_EQ(ring->FreeSlots(), free - 1);
+        }
+        sp.fds[0] = sp.fds[1] = -1;
+        EXPECT_EQ(ring->FreeSlots(), free);
+    });
+}
+
+// SocketDirect and AcceptDirect put both ends of a connection in the ring's direct range, with no
+// process fd on either, and the connection works through Descriptor(direct, slot).
+//
+TEST(IoTest, SocketAndAcceptDirect)
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.uring.registeredSlots = 16;
+    cfg.uring.directSlots = 8;
+    coop::Cooperator co(cfg);
+    coop::Thread t(&co);
+
+    co.SubmitSync([](coop::Context*)
+    {
+        auto* ring = coop::GetUring();
+        if (!ring->SupportsDirectDescriptors())
+        {
+            GTEST_SKIP() << "kernel lacks IORING_REGISTER_FILE_ALLOC_RANGE";
+        }
+
+        ListeningSocket listener;
+        struct sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        getsockname(listener.fd, reinterpret_cast<struct sockaddr*>(&addr), &len);
+        coop::io::Descriptor ldesc(coop::io::borrowed, listener.fd);
+
+        int clientSlot = coop::io::SocketDirect(AF_INET, SOCK_STREAM);
+        if (clientSlot == -EINVAL)
+        {
+            GTEST_SKIP() << "kernel lacks direct socket creation";
+        }
+        ASSERT_GE(clientSlot, 8);
+        coop::io::Descriptor client(coop::io::direct, clientSlot);
+        ASSERT_EQ(coop::io::Connect(client, reinterpret_cast<struct sockaddr*>(&addr), len), 0);
+
+        int serverSlot = coop::io::AcceptDirect(ldesc);
+        ASSERT_GE(serverSlot, 8);
+        ASSERT_LT(serverSlot, 16);
+        EXPECT_NE(serverSlot, clientSlot);
+        coop::io::Descriptor server(coop::io::direct, serverSlot);
+
+        char buf[8] = {};
+        EXPECT_EQ(coop::io::Send(client, "direct", 6), 6);
+        EXPECT_EQ(coop::io::Recv(server, buf, sizeof(buf)), 6);
+        EXPECT_STREQ(buf, "direct");
+        EXPECT_EQ(ring->FreeSlots(), 8u) << "the direct range is the kernel's, not the free list's";
+    });
+    co.Shutdown();
+}
+
+// FileReader streams a file larger than any one buffer in order, chunk by chunk, through a
+// pipeline of reads; the tail is a short chunk and then EOF. It can start mid-file, and reports a
+// failed open.
+//
+TEST(IoTest, FileReaderStreamsInOrder)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        char tmpPath[] = "/tmp/coop_reader_XXXXXX";
+        int fd = mkstemp(tmpPath);
+        ASSERT_GE(fd, 0);
+        std::string content(5 * 4096 + 100, 0);
+        for (size_t i = 0; i < content.size(); i++)
+        {
+            content[i] = static_cast<char>('a' + i % 23);
+        }
+        ASSERT_EQ(::write(fd, content.data(), content.size()), (ssize_t)content.size());
+        close(fd);
+
+        {
+            coop::io::FileReader reader(tmpPath, {.chunkSize = 4096, .depth = 3});
+            ASSERT_TRUE(reader.IsOpen());
+
+            std::string out;
+            coop::io::FileReader::Chunk chunk;
+            int chunks = 0;
+            int n;
+            while ((n = reader.Next(&chunk)) > 0)
+            {
+                EXPECT_EQ(chunk.offset, out.size());
+                out.append(chunk.data, chunk.len);
+                chunks++;
+            }
+            EXPECT_EQ(n, 0);
+            EXPECT_EQ(chunks, 6);
+            EXPECT_EQ(out, content);
+            EXPECT_EQ(reader.Next(&chunk), 0) << "EOF sticks";
+        }
+        {
+            coop::io::FileReader reader(tmpPath, {.chunkSize = 4096, .depth = 2, .offset = 8192});
+            std::string out;
+            coop::io::FileReader::Chunk chunk;
+            while (reader.Next(&chunk) > 0)
+            {
+                out.append(chunk.data, chunk.len);
+            }
+            EXPECT_EQ(out, content.substr(8192));
+        }
+
+        coop::io::FileReader missing("/nonexistent/coop");
+        EXPECT_FALSE(missing.IsOpen());
+        EXPECT_EQ(missing.Error(), -ENOENT);
+        coop::io::FileReader::Chunk chunk;
+        EXPECT_EQ(missing.Next(&chunk), -ENOENT);
+        unlink(tmpPath);
+    });
+}
+
+// FileCache serves a repeated path from one open file, drops the entry once inotify reports a
+// write to it -- while a lease taken before the write keeps its fd -- and refuses directories.
+//
+TEST(IoTest, FileCacheHitsAndInvalidates)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        char tmpPath[] = "/tmp/coop_cache_XXXXXX";
+        int fd = mkstemp(tmpPath);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(::write(fd, "hello", 5), 5);
+
+        coop::io::FileCache cache({.classify = [](const char*) { return "text/plain"; }});
+        int error = 0;
+        auto first = cache.Open(tmpPath, &error);
+        ASSERT_TRUE(first) << "error=" << error;
+        EXPECT_EQ(first->size, 5u);
+        EXPECT_STREQ(first->contentType, "text/plain");
+
+        auto second = cache.Open(tmpPath);
+        ASSERT_TRUE(second);
+        EXPECT_EQ(&*second, &*first) << "one entry, one fd";
+        EXPECT_EQ(cache.Stats().hits, 1u);
+        EXPECT_EQ(cache.Stats().misses, 1u);
+        second.Reset();
+
+        ASSERT_EQ(::write(fd, " world", 6), 6);
+        for (int i = 0; i < 1000 && cache.Stats().invalidations == 0; i++)
+        {
+            ctx->Yield();
+        }
+        EXPECT_EQ(cache.Stats().invalidations, 1u);
+        EXPECT_EQ(cache.Size(), 0u);
+
+        char buf[16] = {};
+        EXPECT_EQ(::pread(first->desc.m_fd, buf, sizeof(buf), 0), 11) << "lease kept its fd";
+
+        auto fresh = cache.Open(tmpPath);
+        ASSERT_TRUE(fresh);
+        EXPECT_EQ(fresh->size, 11u);
+        EXPECT_NE(&*fresh, &*first);
+
+        EXPECT_FALSE(cache.Open("/tmp", &error));
+        EXPECT_EQ(error, -EISDIR);
+        EXPECT_FALSE(cache.Open("/nonexistent/coop", &error));
+        EXPECT_EQ(error, -ENOENT);
+
+        close(fd);
+        unlink(tmpPath);
+    });
+}
+
+// Appends from many contexts at once share commits, get dense LSNs in arrival order, and land in
+// segment files named for their first LSN; a batch past the segment size starts the next one
+//
+TEST(IoTest, WalGroupCommitsAndRotates)
+{
+    char dir[] = "/var/tmp/coop_wal_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), nullptr);
+
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        coop::io::WalConfiguration config;
+        config.segmentSize = 64;
+        {
+            coop::io::Wal wal(dir, 0, config);
+            ASSERT_TRUE(wal.IsOpen()) << wal.Error();
+
+            constexpr int N = 8;
+            int64_t lsns[N];
+            int done = 0;
+            for (int i = 0; i < N; i++)
+            {
+                ctx->GetCooperator()->Spawn([&, i](coop::Context* c)
+                {
+                    char record[8];
+                    memset(record, 'a' + i, sizeof(record));
+                    lsns[i] = wal.Append(c, record, sizeof(record));
+                    done++;
+                });
+            }
+            while (done < N)
+            {
+                ctx->Yield();
+            }
+            for (int i = 0; i < N; i++)
+            {
+                EXPECT_EQ(lsns[i], 8 * i);
+            }
+            EXPECT_EQ(wal.DurableLsn(), 8u * N);
+            EXPECT_LT(wal.GetStatistics().batches, uint64_t(N));
+
+            // 64 bytes in: the next batch goes to a new segment
+            //
+            std::string big(40, 'z');
+            EXPECT_EQ(wal.Append(ctx, big.data(), big.size()), 64);
+            EXPECT_EQ(wal.GetStatistics().rotations, 1u);
+        }
+
+        std::string first(64, '\0');
+        int fd = open((std::string(dir) + "/0000000000000000.wal").c_str(), O_RDONLY);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(pread(fd, first.data(), first.size(), 0), 64);
+        close(fd);
+        for (int i = 0; i < 8; i++)
+        {
+            EXPECT_EQ(first.substr(8 * i, 8), std::string(8, 'a' + i));
+        }
+        EXPECT_TRUE(std::filesystem::exists(std::string(dir) + "/0000000000000040.wal"));
+
+        // A Wal never writes over an existing segment
+        //
+        coop::io::Wal again(dir, 0, config);
+        EXPECT_EQ(again.Error(), -EEXIST);
+    });
+
+    std::filesystem::remove_all(dir);
+}
+
+// -------------------------------------------------------------------------------------
+// Resolve tests
+// -------------------------------------------------------------------------------------
+
+TEST(ResolveTest, Localhost)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        struct in_addr result;
+        int ret = coop::io::Resolve4("localhost", &result);
+        ASSERT_EQ(ret, 0);
+        EXPECT_EQ(result.s_addr, htonl(INADDR_LOOPBACK));
+    });
+}
+
+TEST(ResolveTest, NumericPassthrough)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        struct in_addr result;
+        int ret = coop::io::Resolve4("127.0.0.1", &result);
+        ASSERT_EQ(ret, 0);
+        EXPECT_EQ(result.s_addr, htonl(INADDR_LOOPBACK));
+    });
+}
+
+TEST(ResolveTest, PublicHostname)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        struct in_addr result;
+        int ret = coop::io::Resolve4("dns.google", &result,
+            std::chrono::seconds(10));
+        ASSERT_EQ(ret, 0);
+
+        // dns.google resolves to 8.8.8.8 or 8.8.4.4
+        //
+        struct in_addr expected1, expected2;
+        inet_pton(AF_INET, "8.8.8.8", &expected1);
+        inet_pton(AF_INET, "8.8.4.4", &expected2);
+        EXPECT_TRUE(result.s_addr == expected1.s_addr || result.s_addr == expected2.s_addr);
+    });
+}
+
+TEST(ResolveTest, NonExistent)
+{
+    test::RunInCooperator([](coop::Context* ctx)
     {
         struct in_addr result;
         int ret = coop::io::Resolve4("this.does.not.exist.example.", &result,
@@ -815,6 +2217,226 @@ TEST(ResolveTest, NonExistent)
     });
 }
 
+TEST(ResolveTest, NumericIpv6)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        struct in6_addr result;
+        ASSERT_EQ(coop::io::Resolve6("::1", &result), 0);
+        EXPECT_TRUE(IN6_IS_ADDR_LOOPBACK(&result));
+
+        struct sockaddr_storage addr;
+        socklen_t addrLen = 0;
+        ASSERT_EQ(coop::io::Resolve("::1", 8080, &addr, &addrLen), 0);
+        EXPECT_EQ(addr.ss_family, AF_INET6);
+        EXPECT_EQ(addrLen, sizeof(struct sockaddr_in6));
+        EXPECT_EQ(ntohs(reinterpret_cast<struct sockaddr_in6*>(&addr)->sin6_port), 8080);
+
+        ASSERT_EQ(coop::io::Resolve("127.0.0.1", 80, &addr, &addrLen), 0);
+        EXPECT_EQ(addr.ss_family, AF_INET);
+        EXPECT_EQ(addrLen, sizeof(struct sockaddr_in));
+    });
+}
+
+TEST(ResolveTest, CachesPositiveAndNegative)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::io::FlushResolverCache();
+        auto before = coop::io::GetResolverStats();
+
+        struct in_addr first, second;
+        ASSERT_EQ(coop::io::Resolve4("dns.google", &first, std::chrono::seconds(10)), 0);
+        ASSERT_EQ(coop::io::Resolve4("DNS.google.", &second, std::chrono::seconds(10)), 0);
+        EXPECT_EQ(first.s_addr, second.s_addr);
+
+        struct in_addr missing;
+        EXPECT_EQ(coop::io::Resolve4("this.does.not.exist.example.", &missing,
+                                     std::chrono::seconds(10)), -ENOENT);
+        EXPECT_EQ(coop::io::Resolve4("this.does.not.exist.example.", &missing,
+                                     std::chrono::seconds(10)), -ENOENT);
+
+        auto after = coop::io::GetResolverStats();
+        EXPECT_EQ(after.misses - before.misses, 2u);
+        EXPECT_EQ(after.hits - before.hits, 2u);
+        EXPECT_EQ(after.entries, 2u);
+
+        coop::io::FlushResolverCache();
+        EXPECT_EQ(coop::io::GetResolverStats().entries, 0u);
+    });
+}
+
+TEST(ResolveTest, ConcurrentLookupsCoalesce)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::io::FlushResolverCache();
+        auto before = coop::io::GetResolverStats();
+
+        constexpr int N = 8;
+        int results[N];
+        coop::Context::Handle handles[N];
+        for (int i = 0; i < N; i++)
+        {
+            results[i] = 1;
+            ctx->GetCooperator()->Spawn([&results, i](coop::Context*)
+            {
+                struct in_addr addr;
+                results[i] = coop::io::Resolve4("dns.google", &addr, std::chrono::seconds(10));
+            }, &handles[i]);
+        }
+        for (auto& handle : handles)
+        {
+            while (handle)
+            {
+                ctx->Yield();
+            }
+        }
+
+        for (int i = 0; i < N; i++)
+        {
+            EXPECT_EQ(results[i], 0);
+        }
+        auto after = coop::io::GetResolverStats();
+        EXPECT_EQ(after.misses - before.misses, 1u);
+        EXPECT_EQ(after.coalesced - before.coalesced, uint64_t(N - 1));
+    });
+}
+
+TEST(ResolveTest, ResolveAllInterleavesFamilies)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        struct sockaddr_storage addrs[8];
+        int n = coop::io::ResolveAll("localhost", 80, addrs, 8);
+        ASSERT_GE(n, 1);
+        for (int i = 1; i < n; i++)
+        {
+            EXPECT_NE(addrs[i].ss_family, addrs[i - 1].ss_family) << "at " << i;
+        }
+
+        ASSERT_EQ(coop::io::ResolveAll("127.0.0.1", 80, addrs, 8), 1);
+        EXPECT_EQ(addrs[0].ss_family, AF_INET);
+        ASSERT_EQ(coop::io::ResolveAll("::1", 80, addrs, 8), 1);
+        EXPECT_EQ(addrs[0].ss_family, AF_INET6);
+        EXPECT_EQ(coop::io::ResolveAll("::1", 80, addrs, 8, AF_INET), -ENOENT);
+    });
+}
+
+TEST(ResolveTest, ConnectAnyReachesListener)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        // Listening on IPv4 loopback only: if localhost has an IPv6 address, that attempt is
+        // refused and the race moves straight on to the IPv4 one
+        //
+        ListeningSocket listener;
+        struct sockaddr_in bound{};
+        socklen_t len = sizeof(bound);
+        ASSERT_EQ(getsockname(listener.fd, reinterpret_cast<struct sockaddr*>(&bound), &len), 0);
+        const int port = ntohs(bound.sin_port);
+
+        const int64_t start = coop::time::MonotonicMicros();
+        int fd = coop::io::ConnectAny("localhost", port, std::chrono::seconds(5));
+        ASSERT_GE(fd, 0);
+        EXPECT_LT(coop::time::MonotonicMicros() - start, 200000);
+
+        struct sockaddr_storage peer{};
+        len = sizeof(peer);
+        ASSERT_EQ(getpeername(fd, reinterpret_cast<struct sockaddr*>(&peer), &len), 0);
+        EXPECT_EQ(peer.ss_family, AF_INET);
+        close(fd);
+    });
+}
+
+// The options go on before the connect, through the ring where the kernel takes socket commands,
+// and a Fast Open socket carries its first send whether or not a cookie let it ride the SYN
+//
+TEST(ResolveTest, ConnectAnySetsSocketOptions)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        ListeningSocket listener;
+        struct sockaddr_in bound{};
+        socklen_t len = sizeof(bound);
+        ASSERT_EQ(getsockname(listener.fd, reinterpret_cast<struct sockaddr*>(&bound), &len), 0);
+        const int port = ntohs(bound.sin_port);
+
+        for (int round = 0; round < 2; round++)
+        {
+            int fd = coop::io::ConnectAny("127.0.0.1", port, std::chrono::seconds(5),
+                                          {.noDelay = true, .fastOpen = true});
+            ASSERT_GE(fd, 0);
+
+            int noDelay = 0;
+            len = sizeof(noDelay);
+            ASSERT_EQ(getsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, &len), 0);
+            EXPECT_EQ(noDelay, 1);
+
+            coop::io::Descriptor client(fd);
+            ASSERT_EQ(coop::io::Send(client, "tfo", 3), 3);
+
+            coop::io::Descriptor ldesc(coop::io::borrowed, listener.fd);
+            int accepted = coop::io::Accept(ldesc);
+            ASSERT_GE(accepted, 0);
+            coop::io::Descriptor server(accepted);
+            char buf[4] = {};
+            EXPECT_EQ(coop::io::Recv(server, buf, 3), 3);
+            EXPECT_STREQ(buf, "tfo");
+        }
+    });
+}
+
+// io::Socket and io::SetSockOpt on their own, where the kernel has them
+//
+TEST(IoTest, SocketAndSetSockOptThroughTheRing)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        auto* ring = coop::GetUring();
+        if (!ring->SupportsSocket())
+        {
+            GTEST_SKIP() << "kernel lacks IORING_OP_SOCKET";
+        }
+        int fd = coop::io::Socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC);
+        ASSERT_GE(fd, 0);
+        coop::io::Descriptor desc(fd);
+
+        if (!ring->SupportsSocketCommands())
+        {
+            GTEST_SKIP() << "kernel lacks SOCKET_URING_OP_SETSOCKOPT";
+        }
+        int one = 1;
+        EXPECT_EQ(coop::io::SetSockOpt(desc, IPPROTO_TCP, TCP_NODELAY, &one,
+                                       socklen_t(sizeof(one))), 0);
+        int value = 0;
+        socklen_t len = sizeof(value);
+        ASSERT_EQ(getsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, &len), 0);
+        EXPECT_EQ(value, 1);
+    });
+}
+
+TEST(ResolveTest, ConnectAnyReportsRefusal)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        // A port nothing listens on: bind one, then close it
+        //
+        int port;
+        {
+            ListeningSocket listener;
+            struct sockaddr_in bound{};
+            socklen_t len = sizeof(bound);
+            ASSERT_EQ(getsockname(listener.fd, reinterpret_cast<struct sockaddr*>(&bound), &len),
+                      0);
+            port = ntohs(bound.sin_port);
+        }
+
+        EXPECT_EQ(coop::io::ConnectAny("127.0.0.1", port, std::chrono::seconds(5)),
+                  -ECONNREFUSED);
+    });
+}
+
 TEST(ResolveTest, ConnectWithHostname)
 {
     test::RunInCooperator([](coop::Context* ctx)
@@ -0,0 +1,92 @@
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <spdlog/logger.h>
+
+#include "coop/cooperator.h"
+#include "coop/log_sink.h"
+#include "coop/time/sleep.h"
+#include "test_helpers.h"
+
+using namespace coop;
+
+namespace
+{
+
+std::string ReadAvailable(int fd)
+{
+    std::string out;
+    char buf[4096];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0)
+    {
+        out.append(buf, static_cast<size_t>(n));
+    }
+    return out;
+}
+
+} // end anon namespace
+
+// Records from the cooperator go through its ring to the flusher's writev, in order, cut to the
+// record size when too long; after the flusher exits the same sink writes synchronously
+//
+TEST(LogSinkTest, FlusherWritesRingRecords)
+{
+    int fds[2];
+    ASSERT_EQ(::pipe2(fds, O_CLOEXEC), 0);
+    ASSERT_EQ(::fcntl(fds[0], F_SETFL, O_NONBLOCK), 0);
+
+    test::RunInCooperator([&](Context* ctx)
+    {
+        Context::Handle flusher;
+        log::SinkConfiguration config;
+        config.recordSize = 32;
+        config.interval = std::chrono::milliseconds(1);
+        auto sink = log::StartSink(fds[1], config, &flusher);
+        ASSERT_TRUE(sink);
+        EXPECT_FALSE(log::StartSink(fds[1]));
+
+        spdlog::logger logger("test", sink);
+        logger.set_pattern("%v");
+        for (int i = 0; i < 10; i++)
+        {
+            logger.info("line {}", i);
+        }
+        logger.info(std::string(100, 'x'));
+
+        // Nothing is written on the logging thread
+        //
+        EXPECT_EQ(ReadAvailable(fds[0]), "");
+        while (log::GetSinkStatistics().written < 11)
+        {
+            time::Sleep(ctx, std::chrono::milliseconds(1));
+        }
+
+        std::string expected;
+        for (int i = 0; i < 10; i++)
+        {
+            expected += "line " + std::to_string(i) + "\n";
+        }
+        expected += std::string(31, 'x') + "\n";
+        EXPECT_EQ(ReadAvailable(fds[0]), expected);
+
+        auto stats = log::GetSinkStatistics();
+        EXPECT_EQ(stats.truncated, 1u);
+        EXPECT_EQ(stats.dropped, 0u);
+        EXPECT_EQ(stats.failed, 0u);
+        EXPECT_EQ(stats.pending, 0u);
+
+        flusher.Kill();
+        while (flusher)
+        {
+            ctx->Yield();
+        }
+        logger.info("after");
+        EXPECT_EQ(ReadAvailable(fds[0]), "after\n");
+    });
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
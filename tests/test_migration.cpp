@@ -0,0 +1,174 @@
+// Tests for Context::MigrateTo / Rebalance: moving a running context between cooperators, the
+// migratability rules, and carrying descriptors across the move.
+//
+
+#include <atomic>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator.hpp"
+#include "coop/self.h"
+#include "coop/thread.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/read.h"
+#include "coop/io/write.h"
+
+namespace
+{
+
+// A submitted context may be spawned as a child of the cooperator's submission drainer; cut it loose
+// so it is migratable.
+//
+void DetachFromParent(coop::Context* ctx)
+{
+    if (ctx->Parent())
+    {
+        ctx->Detach();
+    }
+}
+
+} // namespace
+
+// A detached context moves to the target cooperator and keeps running there, yields included.
+//
+TEST(MigrationTest, MigrateToMovesContext)
+{
+    coop::Cooperator source;
+    coop::Cooperator target;
+    coop::Thread sourceThread(&source);
+    coop::Thread targetThread(&target);
+
+    source.SubmitSync([&](coop::Context* ctx)
+    {
+        DetachFromParent(ctx);
+        EXPECT_EQ(ctx->GetCooperator(), &source);
+        EXPECT_TRUE(ctx->CanMigrate());
+
+        EXPECT_TRUE(ctx->MigrateTo(&target));
+        EXPECT_EQ(ctx->GetCooperator(), &target);
+        EXPECT_EQ(coop::Cooperator::thread_cooperator, &target);
+
+        ctx->Yield();
+        EXPECT_EQ(coop::Cooperator::thread_cooperator, &target);
+    });
+
+    source.Shutdown();
+    target.Shutdown();
+}
+
+// A context still attached to its parent cannot move; once detached it can.
+//
+TEST(MigrationTest, AttachedContextIsNotMigratable)
+{
+    coop::Cooperator source;
+    coop::Cooperator target;
+    coop::Thread sourceThread(&source);
+    coop::Thread targetThread(&target);
+
+    std::atomic<bool> refused{false};
+    std::atomic<bool> moved{false};
+    std::atomic<bool> done{false};
+
+    source.SubmitSync([&](coop::Context* ctx)
+    {
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            refused = !child->MigrateTo(&target);
+            EXPECT_EQ(child->GetCooperator(), &source);
+
+            child->Detach();
+            moved = child->MigrateTo(&target);
+            done = true;
+        });
+
+        // The child has moved off (or finished), so the parent has no children left
+        //
+        while (!done)
+        {
+            ctx->Yield();
+        }
+    });
+
+    EXPECT_TRUE(refused);
+    EXPECT_TRUE(moved);
+
+    source.Shutdown();
+    target.Shutdown();
+}
+
+// A carried descriptor is rebound to the target cooperator's ring and usable there.
+//
+TEST(MigrationTest, CarriedDescriptorFollowsContext)
+{
+    coop::Cooperator source;
+    coop::Cooperator target;
+    coop::Thread sourceThread(&source);
+    coop::Thread targetThread(&target);
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    source.SubmitSync([&](coop::Context* ctx)
+    {
+        DetachFromParent(ctx);
+        coop::io::Descriptor rd(fds[0]);
+        coop::io::Descriptor wr(fds[1]);
+        EXPECT_EQ(rd.m_ring, source.GetUring());
+
+        ASSERT_TRUE(ctx->MigrateTo(&target, {&rd, &wr}));
+        EXPECT_EQ(rd.m_ring, target.GetUring());
+        EXPECT_EQ(wr.m_ring, target.GetUring());
+
+        char out = 'x';
+        char in = 0;
+        EXPECT_EQ(coop::io::Write(wr, &out, 1), 1);
+        EXPECT_EQ(coop::io::Read(rd, &in, 1), 1);
+        EXPECT_EQ(in, 'x');
+    });
+
+    source.Shutdown();
+    target.Shutdown();
+}
+
+namespace
+{
+
+std::atomic<coop::Cooperator*> s_rebalanceTarget{nullptr};
+
+coop::Cooperator* RebalanceToTarget(coop::Context*)
+{
+    return s_rebalanceTarget.load();
+}
+
+} // namespace
+
+// Rebalance consults the configured policy and migrates to the cooperator it names.
+//
+TEST(MigrationTest, RebalanceFollowsPolicy)
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.migrationPolicy = &RebalanceToTarget;
+
+    coop::Cooperator source(cfg);
+    coop::Cooperator target;
+    coop::Thread sourceThread(&source);
+    coop::Thread targetThread(&target);
+
+    source.SubmitSync([&](coop::Context* ctx)
+    {
+        DetachFromParent(ctx);
+        EXPECT_FALSE(ctx->Rebalance());
+        EXPECT_EQ(ctx->GetCooperator(), &source);
+
+        s_rebalanceTarget = &target;
+        EXPECT_TRUE(ctx->Rebalance());
+        EXPECT_EQ(ctx->GetCooperator(), &target);
+    });
+    s_rebalanceTarget = nullptr;
+
+    source.Shutdown();
+    target.Shutdown();
+}
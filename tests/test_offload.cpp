@@ -0,0 +1,85 @@
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "coop/cooperator.h"
+#include "coop/offload.h"
+#include "test_helpers.h"
+
+using namespace coop;
+
+// fn runs on a pool thread, not the cooperator's, and Run returns after it
+//
+TEST(OffloadTest, RunsOnPoolThread)
+{
+    test::RunInCooperator([](Context* ctx)
+    {
+        std::thread::id ran;
+        int value = 0;
+        EXPECT_TRUE(Offload(ctx, [&]
+        {
+            ran = std::this_thread::get_id();
+            value = 42;
+        }));
+        EXPECT_EQ(value, 42);
+        EXPECT_NE(ran, std::this_thread::get_id());
+    });
+}
+
+// While one call blocks the only thread and another waits behind it, the cooperator keeps running
+// contexts, and a call beyond the queue depth is refused without running
+//
+TEST(OffloadTest, BlockedCallsLeaveCooperatorRunning)
+{
+    OffloadPoolConfiguration config;
+    config.threads = 1;
+    config.queueDepth = 1;
+    OffloadPool pool(config);
+
+    test::RunInCooperator([&](Context* ctx)
+    {
+        std::atomic<bool> release{false};
+        int finished = 0;
+        for (int i = 0; i < 2; i++)
+        {
+            ctx->GetCooperator()->Spawn([&](Context* child)
+            {
+                EXPECT_TRUE(pool.Run(child, [&]
+                {
+                    while (!release.load())
+                    {
+                        std::this_thread::yield();
+                    }
+                }));
+                finished++;
+            });
+            for (;;)
+            {
+                auto stats = pool.GetStatistics();
+                if (stats.running == 1 && stats.queued == size_t(i))
+                {
+                    break;
+                }
+                ctx->Yield();
+            }
+        }
+
+        bool ran = false;
+        EXPECT_FALSE(pool.Run(ctx, [&] { ran = true; }));
+        EXPECT_FALSE(ran);
+        EXPECT_EQ(finished, 0);
+
+        release.store(true);
+        while (finished < 2)
+        {
+            ctx->Yield();
+        }
+
+        auto stats = pool.GetStatistics();
+        EXPECT_EQ(stats.submitted, 2u);
+        EXPECT_EQ(stats.rejected, 1u);
+        EXPECT_EQ(stats.queued, 0u);
+        EXPECT_EQ(stats.run.count, stats.completed);
+    });
+}
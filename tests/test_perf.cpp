@@ -1,12 +1,31 @@
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
 #include <gtest/gtest.h>
+#include <zlib.h>
 
 #include "coop/cooperator.h"
+#include "coop/http/metrics.h"
 #include "coop/self.h"
 #include "coop/io/descriptor.h"
 #include "coop/io/recv.h"
 #include "coop/io/send.h"
 #include "coop/perf/counters.h"
+#include "coop/perf/histogram.h"
 #include "coop/perf/patch.h"
+#include "coop/perf/pmu.h"
+#include "coop/perf/pprof.h"
+#include "coop/perf/sampler.h"
+#include "coop/perf/usdt.h"
+#include "coop/perf/watchdog.h"
+#include "coop/status_snapshot.h"
+#include "coop/thread.h"
+#include "coop/time/now.h"
+#include "coop/time/sleep.h"
 
 #include "test_helpers.h"
 
@@ -35,6 +54,28 @@ TEST(PerfTest, AlwaysOnCounters)
     });
 }
 
+TEST(PerfTest, AlwaysOnHistograms)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto& histograms = ctx->GetCooperator()->GetPerfHistograms();
+        histograms.Reset();
+
+        ctx->GetCooperator()->Spawn([](coop::Context* child)
+        {
+            child->Yield();
+            child->Yield();
+        });
+        ctx->Yield();
+        ctx->Yield();
+
+        using H = coop::perf::Hist;
+        EXPECT_GT(histograms.Get(H::RunSlice).count, 0u);
+        EXPECT_GT(histograms.Get(H::RunQueueWait).count, 0u);
+        EXPECT_EQ(histograms.Get(H::HttpHandler).count, 0u);
+    });
+}
+
 #elif COOP_PERF_MODE == 2
 
 TEST(PerfTest, DynamicPatchToggle)
@@ -177,6 +218,32 @@ TEST(PerfTest, SetFamilies)
     });
 }
 
+// Histogram sites patch with their family like counter sites do
+//
+TEST(PerfTest, HistogramsFollowFamilies)
+{
+    coop::perf::Disable();
+
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        using H = coop::perf::Hist;
+        auto& histograms = ctx->GetCooperator()->GetPerfHistograms();
+        histograms.Reset();
+
+        ctx->Yield();
+        EXPECT_EQ(histograms.Get(H::RunSlice).count, 0u);
+
+        coop::perf::Enable(coop::perf::Family::Scheduler);
+        ctx->Yield();
+        ctx->Yield();
+        EXPECT_GT(histograms.Get(H::RunSlice).count, 0u);
+        EXPECT_GT(histograms.Get(H::RunQueueWait).count, 0u);
+        EXPECT_EQ(histograms.Get(H::IoLatency).count, 0u);
+
+        coop::perf::Disable();
+    });
+}
+
 #else
 
 TEST(PerfTest, DisabledMode)
@@ -204,10 +271,18 @@ TEST(PerfTest, CounterFamilyMapping)
     //
     EXPECT_EQ(coop::perf::CounterFamily(C::SchedulerLoop), F::Scheduler);
     EXPECT_EQ(coop::perf::CounterFamily(C::ContextResume), F::Scheduler);
+    EXPECT_EQ(coop::perf::CounterFamily(C::BumpOverflow), F::Scheduler);
     EXPECT_EQ(coop::perf::CounterFamily(C::IoSubmit), F::IO);
     EXPECT_EQ(coop::perf::CounterFamily(C::PollCqe), F::IO);
+    EXPECT_EQ(coop::perf::CounterFamily(C::WaitSpinMiss), F::IO);
     EXPECT_EQ(coop::perf::CounterFamily(C::EpochAdvance), F::Epoch);
     EXPECT_EQ(coop::perf::CounterFamily(C::DrainReclaimed), F::Epoch);
+    EXPECT_EQ(coop::perf::CounterFamily(C::EpochBacklog), F::Epoch);
+    EXPECT_EQ(coop::perf::CounterFamily(C::WorkSteal), F::Work);
+    EXPECT_EQ(coop::perf::CounterFamily(C::WorkOverflow), F::Work);
+    EXPECT_EQ(coop::perf::CounterFamily(C::WorkErgRunLong), F::Work);
+    EXPECT_EQ(coop::perf::CounterFamily(C::PassageSpin), F::Chan);
+    EXPECT_EQ(coop::perf::CounterFamily(C::PassageParkTimeout), F::Chan);
 }
 
 TEST(PerfTest, FamilyNames)
@@ -216,6 +291,9 @@ TEST(PerfTest, FamilyNames)
     EXPECT_STREQ(coop::perf::FamilyName(F::Scheduler), "scheduler");
     EXPECT_STREQ(coop::perf::FamilyName(F::IO), "io");
     EXPECT_STREQ(coop::perf::FamilyName(F::Epoch), "epoch");
+    EXPECT_STREQ(coop::perf::FamilyName(F::Work), "work");
+    EXPECT_STREQ(coop::perf::FamilyName(F::Chan), "chan");
+    EXPECT_STREQ(coop::perf::FamilyName(F::Http), "http");
 }
 
 TEST(PerfTest, CounterNames)
@@ -225,6 +303,12 @@ TEST(PerfTest, CounterNames)
     //
     EXPECT_STREQ(coop::perf::CounterName(C::EpochAdvance), "epoch_advance");
     EXPECT_STREQ(coop::perf::CounterName(C::DrainReclaimed), "drain_reclaimed");
+    EXPECT_STREQ(coop::perf::CounterName(C::EpochReclaimForced), "epoch_reclaim_forced");
+    EXPECT_STREQ(coop::perf::CounterName(C::WorkStealAttempt), "work_steal_attempt");
+    EXPECT_STREQ(coop::perf::CounterName(C::WorkErgRunLong), "work_erg_run_long");
+    EXPECT_STREQ(coop::perf::CounterName(C::WaitSpinHit), "wait_spin_hit");
+    EXPECT_STREQ(coop::perf::CounterName(C::PassageSpin), "passage_spin");
+    EXPECT_STREQ(coop::perf::CounterName(C::PassageParkTimeout), "passage_park_timeout");
 }
 
 TEST(PerfTest, FamilyBitmaskOps)
@@ -252,6 +336,410 @@ TEST(PerfTest, AllCountersHaveFamily)
     }
 }
 
+TEST(PerfTest, AllHistogramsHaveFamily)
+{
+    for (uint32_t i = 0; i < static_cast<uint32_t>(coop::perf::Hist::COUNT); i++)
+    {
+        auto h = static_cast<coop::perf::Hist>(i);
+        EXPECT_NE(coop::perf::HistFamily(h), coop::perf::Family::All)
+            << "Histogram " << coop::perf::HistName(h) << " has no family assignment";
+    }
+    EXPECT_STREQ(coop::perf::HistName(coop::perf::Hist::IoLatency), "io_latency_ns");
+}
+
+// Buckets tile the value range with no gaps, each within 1/16 of its low end
+//
+TEST(PerfTest, HistogramBuckets)
+{
+    using Histogram = coop::perf::Histogram;
+    for (size_t i = 0; i + 1 < Histogram::kBuckets; i++)
+    {
+        const uint64_t low = Histogram::BucketLow(i);
+        const uint64_t high = Histogram::BucketHigh(i);
+        ASSERT_EQ(Histogram::BucketFor(low), i);
+        ASSERT_EQ(Histogram::BucketFor(high), i);
+        ASSERT_EQ(Histogram::BucketLow(i + 1), high + 1);
+        ASSERT_LE(high - low, low / Histogram::kSubBuckets);
+    }
+    EXPECT_EQ(Histogram::BucketFor(UINT64_MAX), Histogram::kBuckets - 1);
+}
+
+TEST(PerfTest, HistogramQuantilesAndMerge)
+{
+    coop::perf::Histogram a, b;
+    EXPECT_EQ(a.Quantile(0.99), 0u);
+
+    for (uint64_t v = 1; v <= 10000; v++)
+    {
+        a.Record(v);
+    }
+    EXPECT_EQ(a.count, 10000u);
+    EXPECT_EQ(a.max, 10000u);
+    EXPECT_EQ(a.Mean(), 5000u);
+
+    auto near = [](uint64_t got, uint64_t want)
+    {
+        return got >= want && got <= want + want / coop::perf::Histogram::kSubBuckets;
+    };
+    EXPECT_TRUE(near(a.Quantile(0.5), 5000)) << a.Quantile(0.5);
+    EXPECT_TRUE(near(a.Quantile(0.99), 9900)) << a.Quantile(0.99);
+    EXPECT_EQ(a.Quantile(1.0), 10000u);
+
+    // A slow tail on another cooperator shows up in the merged p999
+    //
+    for (int i = 0; i < 100; i++)
+    {
+        b.Record(1000000);
+    }
+    a.Merge(b);
+    EXPECT_EQ(a.count, 10100u);
+    EXPECT_EQ(a.max, 1000000u);
+    EXPECT_TRUE(near(a.Quantile(0.999), 1000000)) << a.Quantile(0.999);
+    EXPECT_TRUE(near(a.Quantile(0.5), 5050)) << a.Quantile(0.5);
+}
+
+// ---- Off-CPU profiler (mode-independent) ----
+
+// A context blocked on a Coordinator another context holds for a millisecond records one sample:
+// its stack from the block, the holder's coordinator as the waker, and the held time as its
+// weight, which is charged to the context too.
+//
+TEST(PerfTest, OffCpuRecordsBlockedTime)
+{
+    coop::perf::ResetOffCpuSamples();
+    coop::perf::StartOffCpuProfiling();
+
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        coop::Coordinator coord;
+        coord.Acquire(ctx);
+
+        size_t blockedTicks = 0;
+        co->Spawn([&](coop::Context* waiter)
+        {
+            waiter->SetName("offcpu-waiter");
+            coord.Acquire(waiter);
+            blockedTicks = waiter->m_statistics.blockedTicks;
+            coord.Release(waiter);
+        });
+
+        const int64_t until = coop::time::MonotonicMicros() + 1000;
+        while (coop::time::MonotonicMicros() < until) {}
+        coord.Release(ctx);
+
+        coop::perf::StopOffCpuProfiling();
+
+        coop::perf::OffCpuSample samples[8];
+        size_t count = coop::perf::ReadOffCpuSamples(samples, 8);
+        const coop::perf::OffCpuSample* found = nullptr;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (samples[i].name && std::string(samples[i].name) == "offcpu-waiter")
+            {
+                found = &samples[i];
+            }
+        }
+        ASSERT_NE(found, nullptr);
+        EXPECT_EQ(found->coordinator, &coord);
+        EXPECT_EQ(found->cooperator, co);
+        EXPECT_GE(found->depth, 1u);
+        EXPECT_GE(static_cast<double>(found->blockedTicks) * co->NanosPerTick(), 500000.0);
+        EXPECT_EQ(blockedTicks, found->blockedTicks);
+    });
+}
+
+// ---- Hardware PMU ----
+
+namespace
+{
+
+// Enough retired instructions to dwarf a switch's worth of noise
+//
+uint64_t BurnInstructions(int n)
+{
+    volatile uint64_t acc = 0;
+    for (int i = 0; i < n; i++)
+    {
+        acc = acc + static_cast<uint64_t>(i) * 7;
+    }
+    return acc;
+}
+
+} // namespace
+
+// A group opened on this thread counts forward across a stretch of work. No PMU (most CI VMs) or
+// a restrictive perf_event_paranoid skips.
+//
+TEST(PerfTest, PmuGroupCountsThisThread)
+{
+    coop::perf::PmuGroup pmu;
+    int err = pmu.Open();
+    if (err < 0)
+    {
+        GTEST_SKIP() << "perf_event_open: " << err;
+    }
+
+    coop::perf::PmuSample before, after;
+    pmu.Read(before);
+    BurnInstructions(1000000);
+    pmu.Read(after);
+
+    using coop::perf::PmuEvent;
+    EXPECT_GT(after[PmuEvent::Cycles], before[PmuEvent::Cycles]);
+    EXPECT_GE(after[PmuEvent::Instructions] - before[PmuEvent::Instructions], 1000000u);
+    EXPECT_STREQ(coop::perf::PmuEventName(PmuEvent::Instructions), "instructions");
+}
+
+// trackContextPmu charges a context for the work it did, and folds it into its name's aggregate
+// when it exits; a context that did nothing is charged far less
+//
+TEST(PerfTest, TrackContextPmuChargesByName)
+{
+    auto config = coop::s_defaultCooperatorConfiguration;
+    config.trackContextPmu = true;
+    coop::Cooperator cooperator(config);
+    coop::Thread t(&cooperator);
+
+    cooperator.Submit([](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        if (!co->TracksContextPmu())
+        {
+            EXPECT_LT(co->PmuError(), 0);
+            co->Shutdown();
+            return;
+        }
+
+        co->Spawn([](coop::Context* busy)
+        {
+            busy->SetName("pmu-busy");
+            BurnInstructions(1000000);
+        });
+        co->Spawn([](coop::Context* idle)
+        {
+            idle->SetName("pmu-idle");
+        });
+
+        uint64_t busy = 0;
+        uint64_t idle = 0;
+        co->VisitContextPmu([&](const char* name, coop::Cooperator::ContextPmu const& p)
+        {
+            if (std::string(name) == "pmu-busy")
+            {
+                EXPECT_EQ(p.exits, 1u);
+                busy = p.instructions;
+            }
+            if (std::string(name) == "pmu-idle")
+            {
+                idle = p.instructions;
+            }
+        });
+        EXPECT_GE(busy, 1000000u);
+        EXPECT_LT(idle, busy / 10);
+        co->Shutdown();
+    });
+}
+
+// ---- OpenMetrics exposition ----
+
+// /metrics renders every live cooperator under its name label (escaped), closes with "# EOF", and
+// carries the perf counters and histograms whenever the build has them.
+//
+TEST(PerfTest, OpenMetricsExposition)
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.SetName("metrics-\"q\"");
+    coop::Cooperator co(cfg);
+    coop::Thread t(&co);
+
+    co.SubmitSync([](coop::Context* ctx)
+    {
+        ctx->Yield();
+        const std::string text = coop::http::GenerateOpenMetrics();
+        const std::string label = "{cooperator=\"metrics-\\\"q\\\"\"";
+
+        EXPECT_NE(text.find("coop_contexts" + label + ",state=\"live\"} "), std::string::npos);
+        EXPECT_NE(text.find("# TYPE coop_stack_pool_hits counter\n"), std::string::npos);
+        EXPECT_NE(text.find("coop_stack_pool_hits_total" + label + "} "), std::string::npos);
+        ASSERT_GE(text.size(), 6u);
+        EXPECT_EQ(text.substr(text.size() - 6), "# EOF\n");
+
+#if COOP_PERF_MODE > 0
+        EXPECT_NE(text.find("coop_ctx_resume_total" + label + "} "), std::string::npos);
+        EXPECT_NE(text.find("# TYPE coop_run_queue_wait_seconds histogram\n"), std::string::npos);
+        EXPECT_NE(text.find("coop_run_queue_wait_seconds_bucket" + label + ",le=\"+Inf\"} "),
+                  std::string::npos);
+        EXPECT_NE(text.find("coop_run_queue_wait_seconds_sum" + label + "} "), std::string::npos);
+#endif
+    });
+    co.Shutdown();
+}
+
+// With no tracer attached a USDT site does not evaluate its arguments, built in or not
+//
+TEST(PerfTest, UsdtSiteIdleWithoutTracer)
+{
+    EXPECT_FALSE(COOP_USDT_ACTIVE(context_yield));
+
+    int evaluated = 0;
+    COOP_USDT(context_yield, (evaluated++, nullptr), "test");
+    EXPECT_EQ(evaluated, 0);
+}
+
+// ---- Off-host export ----
+
+namespace
+{
+
+// A gzip file, every member of it, as text
+//
+std::string ReadGzip(std::string const& path)
+{
+    std::string text;
+    gzFile file = gzopen(path.c_str(), "rb");
+    if (!file)
+    {
+        return text;
+    }
+    char buf[4096];
+    int n;
+    while ((n = gzread(file, buf, sizeof(buf))) > 0)
+    {
+        text.append(buf, static_cast<size_t>(n));
+    }
+    gzclose(file);
+    return text;
+}
+
+std::string Gunzip(std::string const& data)
+{
+    char path[] = "/tmp/coop_pprof_XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT_GE(fd, 0);
+    EXPECT_EQ(write(fd, data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    close(fd);
+    std::string text = ReadGzip(path);
+    unlink(path);
+    return text;
+}
+
+} // end anon namespace
+
+// Exported stacks carry raw addresses against the objects holding them: the test binary is a
+// mapping, its frames resolve to <binary>+0x<offset>, and identical stacks fold into one count
+//
+TEST(PerfTest, PprofAndCollapsedExport)
+{
+    auto mappings = coop::perf::ReadMappings();
+    const auto here = reinterpret_cast<uintptr_t>(&Gunzip);
+    const coop::perf::Mapping* self = nullptr;
+    for (auto const& m : mappings)
+    {
+        if (here >= m.start && here < m.limit)
+        {
+            self = &m;
+        }
+    }
+    ASSERT_NE(self, nullptr);
+    EXPECT_FALSE(self->path.empty());
+
+    coop::perf::StackSample samples[3] = {};
+    for (auto& s : samples)
+    {
+        s.frames[0] = here;
+        s.frames[1] = here + 16;
+        s.depth = 2;
+        s.name = "export-test";
+    }
+    samples[2].depth = 1;
+
+    std::string collapsed;
+    coop::perf::AppendCollapsed(collapsed, samples, 3);
+    const char* base = strrchr(self->path.c_str(), '/');
+    base = base ? base + 1 : self->path.c_str();
+    char frame[128];
+    snprintf(frame, sizeof(frame), "%s+0x%lx", base, here - self->bias);
+    EXPECT_EQ(collapsed.rfind("# coop stacks: 3 samples, 0 lost", 0), 0u);
+    EXPECT_NE(collapsed.find("# object "), std::string::npos);
+    EXPECT_NE(collapsed.find(";export-test;" + std::string(frame) + " 1\n"), std::string::npos);
+    EXPECT_NE(collapsed.find(";" + std::string(frame) + " 2\n"), std::string::npos);
+
+    std::string pprof;
+    ASSERT_TRUE(coop::perf::AppendPprof(pprof, samples, 3, 1.0, 10000000));
+    ASSERT_GE(pprof.size(), 2u);
+    EXPECT_EQ(static_cast<uint8_t>(pprof[0]), 0x1f);
+    EXPECT_EQ(static_cast<uint8_t>(pprof[1]), 0x8b);
+    const std::string profile = Gunzip(pprof);
+    EXPECT_NE(profile.find("nanoseconds"), std::string::npos);
+    EXPECT_NE(profile.find("export-test"), std::string::npos);
+    EXPECT_NE(profile.find(self->path), std::string::npos);
+    if (!self->buildId.empty())
+    {
+        EXPECT_NE(profile.find(self->buildId), std::string::npos);
+    }
+}
+
+// The continuous writer drains new stack samples into gzip members of collapsed text, and
+// ReadStackSamplesSince hands each sample over once
+//
+TEST(PerfTest, ContinuousProfileWritesBatches)
+{
+    char dir[] = "/tmp/coop_profile_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), nullptr);
+    const std::string path = std::string(dir) + "/cpu.collapsed.gz";
+
+    coop::perf::ResetSamples();
+    coop::perf::SetStackSubsample(1);
+    ASSERT_TRUE(coop::perf::StartSampling(997, true));
+
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        coop::perf::ContinuousProfileOptions options;
+        options.path = path;
+        options.interval = std::chrono::milliseconds(5);
+        coop::Context::Handle writer;
+        ASSERT_TRUE(coop::perf::StartContinuousProfile(options, &writer));
+        EXPECT_FALSE(coop::perf::StartContinuousProfile(options));
+
+        // Burn CPU until the profiling timer has taken a few stacks, with sleeps between so
+        // the writer gets its turns
+        //
+        const int64_t deadline = coop::time::MonotonicMicros() + 5000000;
+        while (coop::perf::TotalStackSamples() < 8 && coop::time::MonotonicMicros() < deadline)
+        {
+            const int64_t until = coop::time::MonotonicMicros() + 2000;
+            while (coop::time::MonotonicMicros() < until) {}
+            coop::time::Sleep(ctx, std::chrono::milliseconds(1));
+        }
+        coop::perf::StopSampling();
+
+        writer.Kill();
+        while (writer)
+        {
+            ctx->Yield();
+        }
+    });
+    coop::perf::SetStackSubsample(10);
+
+    uint64_t cursor = 0;
+    coop::perf::StackSample one;
+    EXPECT_EQ(coop::perf::ReadStackSamplesSince(cursor, &one, 1), 1u);
+    EXPECT_EQ(cursor, 1u);
+    cursor = coop::perf::TotalStackSamples();
+    EXPECT_EQ(coop::perf::ReadStackSamplesSince(cursor, &one, 1), 0u);
+
+    const std::string text = ReadGzip(path);
+    EXPECT_EQ(text.rfind("# coop stacks: ", 0), 0u);
+    EXPECT_NE(text.find("# object "), std::string::npos);
+    unlink(path.c_str());
+    for (int n = 1; n <= 4; n++)
+    {
+        unlink((path + "." + std::to_string(n)).c_str());
+    }
+    rmdir(dir);
+}
+
 // ---- Multi-cooperator tests (mode-independent) ----
 
 TEST(PerfTest, CooperatorName)
@@ -293,7 +781,7 @@ TEST(PerfTest, VisitRegistryMultipleCooperators)
             running->fetch_add(1, std::memory_order_relaxed);
             while (!ctx->IsKilled())
             {
-                ctx->Yield(true);
+                ctx->Yield();
             }
         }, &running);
     }
@@ -330,3 +818,160 @@ TEST(PerfTest, VisitRegistryMultipleCooperators)
     threads.clear();
     coop::Cooperator::ResetGlobalShutdown();
 }
+
+// Readers walk the registry while cooperators launch and exit under them
+//
+TEST(PerfTest, VisitRegistryThroughLaunchAndExit)
+{
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> visited{0};
+    std::atomic<size_t> contexts{0};
+    std::thread reader([&]
+    {
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            coop::Cooperator::VisitRegistry([&](coop::Cooperator* co) -> bool
+            {
+                contexts.store(co->ContextsCount(), std::memory_order_relaxed);
+                visited.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            });
+        }
+    });
+
+    for (int i = 0; i < 20; i++)
+    {
+        coop::Cooperator cooperator;
+        std::atomic<bool> started{false};
+        {
+            coop::Thread thread(&cooperator);
+            cooperator.Submit([&](coop::Context* ctx)
+            {
+                started.store(true, std::memory_order_relaxed);
+                coop::time::Sleep(ctx, std::chrono::milliseconds(1));
+            });
+            while (!started.load(std::memory_order_relaxed))
+            {
+                std::this_thread::yield();
+            }
+            cooperator.Shutdown();
+        }
+    }
+
+    stop.store(true, std::memory_order_relaxed);
+    reader.join();
+    EXPECT_GT(visited.load(), 0u);
+}
+
+// A published snapshot shows another thread the cooperator's tree, children after their parent
+//
+TEST(PerfTest, StatusSnapshotCarriesTheTree)
+{
+    coop::CooperatorConfiguration config;
+    config.SetName("snapshotter");
+    config.statusSnapshot.maxContexts = 16;
+    config.statusSnapshot.intervalMicros = 1000;
+    coop::Cooperator cooperator(config);
+    ASSERT_TRUE(cooperator.PublishesStatus());
+
+    coop::CooperatorSnapshot snapshot;
+    EXPECT_FALSE(cooperator.ReadStatusSnapshot(snapshot));
+
+    {
+        coop::Thread thread(&cooperator);
+        cooperator.Submit([](coop::Context* ctx)
+        {
+            ctx->SetName("SnapshotParent");
+            ctx->GetCooperator()->Spawn([](coop::Context* child)
+            {
+                child->SetName("SnapshotChild");
+                while (!child->IsKilled())
+                {
+                    coop::time::Sleep(child, std::chrono::milliseconds(1));
+                }
+            });
+            while (!ctx->IsKilled())
+            {
+                coop::time::Sleep(ctx, std::chrono::milliseconds(1));
+            }
+        });
+
+        bool found = false;
+        for (int i = 0; i < 5000 && !found; i++)
+        {
+            if (cooperator.ReadStatusSnapshot(snapshot))
+            {
+                for (size_t j = 0; j + 1 < snapshot.contexts.size(); j++)
+                {
+                    auto const& parent = snapshot.contexts[j];
+                    auto const& child = snapshot.contexts[j + 1];
+                    if (!strcmp(parent.name, "SnapshotParent")
+                        && !strcmp(child.name, "SnapshotChild")
+                        && child.depth == parent.depth + 1)
+                    {
+                        found = true;
+                    }
+                }
+            }
+            if (!found)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        EXPECT_TRUE(found);
+        EXPECT_GE(snapshot.version, 1u);
+        EXPECT_FALSE(snapshot.truncated);
+        EXPECT_GE(snapshot.contextsCount, 2u);
+        EXPECT_LE(snapshot.contexts.size(), 16u);
+
+        cooperator.Shutdown();
+    }
+}
+
+TEST(PerfTest, WatchdogReportsLongSlice)
+{
+    coop::perf::WatchdogConfiguration config;
+    config.threshold = std::chrono::milliseconds(20);
+    config.poll = std::chrono::milliseconds(2);
+    ASSERT_TRUE(coop::perf::StartWatchdog(config));
+    EXPECT_FALSE(coop::perf::StartWatchdog(config));
+    EXPECT_TRUE(coop::perf::IsWatchdogRunning());
+
+    const uint64_t before = coop::perf::TotalStalls();
+    uint64_t stalls = 0;
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        coop::Context::Handle spinner;
+        co->Spawn([](coop::Context* c)
+        {
+            c->SetName("spinner");
+            const int64_t until = coop::time::MonotonicMicros() + 100000;
+            while (coop::time::MonotonicMicros() < until) {}
+        }, &spinner);
+        while (spinner)
+        {
+            ctx->Yield();
+        }
+        stalls = co->Stalls();
+    });
+    coop::perf::StopWatchdog();
+    EXPECT_FALSE(coop::perf::IsWatchdogRunning());
+
+    EXPECT_GE(stalls, 1u);
+    EXPECT_GT(coop::perf::TotalStalls(), before);
+
+    coop::perf::StallReport reports[coop::perf::kStallHistory];
+    size_t count = coop::perf::ReadStalls(reports, coop::perf::kStallHistory);
+    const coop::perf::StallReport* found = nullptr;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (reports[i].name && std::string(reports[i].name) == "spinner")
+        {
+            found = &reports[i];
+        }
+    }
+    ASSERT_NE(found, nullptr);
+    EXPECT_GE(found->elapsedNs, 20000000);
+    EXPECT_GE(found->depth, 1);
+}
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <map>
+#include <semaphore>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "coop/cooperator.h"
+#include "coop/pool.h"
+#include "coop/size_class_allocator.h"
+#include "coop/thread.h"
+#include "test_helpers.h"
+
+namespace
+{
+
+struct Request
+{
+    explicit Request(int i) : id(i) {}
+
+    int     id;
+    char    body[40];
+};
+
+using Allocator = coop::SizeClassAllocator;
+
+} // end anon namespace
+
+TEST(PoolTest, SizeClasses)
+{
+    static_assert(Allocator::ClassFor(1) == 0);
+    static_assert(Allocator::ClassFor(16) == 0);
+    static_assert(Allocator::ClassFor(17) == 1);
+    static_assert(Allocator::ClassFor(4096) == Allocator::kClasses - 1);
+    static_assert(Allocator::ClassFor(4097) == Allocator::kClasses);
+    EXPECT_EQ(Allocator::ClassSize(Allocator::ClassFor(100)), 128u);
+}
+
+// A freed block is the next one handed out for its class; sizes past the last class do not touch
+// the slabs
+//
+TEST(PoolTest, ReusesFreedBlocks)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        Allocator& allocator = ctx->GetCooperator()->GetAllocator();
+        EXPECT_EQ(Allocator::Current(), &allocator);
+
+        Request* first = coop::Pool<Request>::New(1);
+        ASSERT_NE(first, nullptr);
+        EXPECT_EQ(first->id, 1);
+        EXPECT_EQ(allocator.SlabCount(), 1u);
+
+        coop::Pool<Request>::Delete(first);
+        EXPECT_EQ(allocator.FreeCount(sizeof(Request)), 1u);
+        Request* second = coop::Pool<Request>::New(2);
+        EXPECT_EQ(second, first);
+        EXPECT_EQ(allocator.FreeCount(sizeof(Request)), 0u);
+
+        {
+            auto owned = coop::Pool<Request>::Make(3);
+            EXPECT_EQ(owned->id, 3);
+        }
+        EXPECT_EQ(allocator.FreeCount(sizeof(Request)), 1u);
+        coop::Pool<Request>::Delete(second);
+
+        void* large = allocator.Allocate(Allocator::kMaxClass + 1);
+        ASSERT_NE(large, nullptr);
+        EXPECT_EQ(allocator.SlabCount(), 1u);
+        Allocator::Release(large, Allocator::kMaxClass + 1);
+    });
+}
+
+TEST(PoolTest, StlAdaptor)
+{
+    test::RunInCooperator([](coop::Context*)
+    {
+        using String = std::basic_string<char, std::char_traits<char>, coop::PoolAllocator<char>>;
+        std::vector<int, coop::PoolAllocator<int>> numbers;
+        std::map<int, String, std::less<int>,
+                 coop::PoolAllocator<std::pair<const int, String>>> names;
+        for (int i = 0; i < 1000; i++)
+        {
+            numbers.push_back(i);
+            names.emplace(i, String(64, 'a' + i % 26));
+        }
+        EXPECT_EQ(numbers[999], 999);
+        EXPECT_EQ(names.at(27)[0], 'b');
+        EXPECT_GT(Allocator::Current()->SlabCount(), 0u);
+    });
+}
+
+// Objects built on A and freed on B go back onto A's remote queue, and A reuses them
+//
+TEST(PoolTest, RemoteFreeReturnsToOwner)
+{
+    constexpr int kCount = 16;
+    Request* requests[kCount] = {};
+    std::binary_semaphore built{0}, freed{0};
+
+    coop::Cooperator coopA;
+    coop::Thread threadA(&coopA);
+    coop::Cooperator coopB;
+    coop::Thread threadB(&coopB);
+
+    coopB.Submit([&](coop::Context* ctx)
+    {
+        built.acquire();
+        for (auto* request : requests)
+        {
+            coop::Pool<Request>::Delete(request);
+        }
+        EXPECT_EQ(ctx->GetCooperator()->GetAllocator().FreeCount(sizeof(Request)), 0u);
+        freed.release();
+        ctx->GetCooperator()->Shutdown();
+    });
+
+    coopA.Submit([&](coop::Context* ctx)
+    {
+        Allocator& allocator = ctx->GetCooperator()->GetAllocator();
+        for (int i = 0; i < kCount; i++)
+        {
+            requests[i] = coop::Pool<Request>::New(i);
+        }
+        built.release();
+        freed.acquire();
+
+        EXPECT_EQ(allocator.FreeCount(sizeof(Request)), 0u);
+        allocator.DrainRemote();
+        EXPECT_EQ(allocator.FreeCount(sizeof(Request)), size_t(kCount));
+
+        Request* again = coop::Pool<Request>::New(0);
+        EXPECT_NE(std::find(std::begin(requests), std::end(requests), again), std::end(requests));
+        coop::Pool<Request>::Delete(again);
+        EXPECT_EQ(allocator.SlabCount(), 1u);
+        ctx->GetCooperator()->Shutdown();
+    });
+}
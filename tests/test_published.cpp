@@ -0,0 +1,163 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "coop/cooperator.h"
+#include "coop/epoch/domain.h"
+#include "coop/published.h"
+#include "coop/thread.h"
+#include "coop/time/sleep.h"
+#include "test_helpers.h"
+
+namespace
+{
+
+// A snapshot that counts how many of its kind are alive
+//
+struct Config
+{
+    Config(std::string n, std::atomic<int>* l)
+    : name(std::move(n))
+    , live(l)
+    {
+        (*live)++;
+    }
+
+    ~Config()
+    {
+        (*live)--;
+    }
+
+    std::string         name;
+    std::atomic<int>*   live;
+};
+
+} // end anon namespace
+
+// A reader keeps its cached snapshot for as long as its context runs, and picks up the new one
+// once the scheduler has quiesced; the replaced snapshot is then freed
+//
+TEST(PublishedTest, ReaderSeesPublishAfterQuiesce)
+{
+    coop::epoch::Domain domain;
+    std::atomic<int> live{0};
+    {
+        coop::Published<Config> published(domain, "v1", &live);
+        test::RunInCooperator([&](coop::Context* ctx)
+        {
+            coop::epoch::Participant participant(domain);
+            coop::Published<Config>::Reader reader(published, participant);
+
+            Config const& before = reader.Get();
+            EXPECT_EQ(before.name, "v1");
+            EXPECT_EQ(reader.Version(), 1u);
+
+            EXPECT_EQ(published.Publish(participant, "v2", &live), 2u);
+            EXPECT_EQ(published.Version(), 2u);
+            EXPECT_EQ(live.load(), 2);
+
+            // No yield since the Get: still the cached snapshot, still alive
+            //
+            EXPECT_EQ(&reader.Get(), &before);
+            EXPECT_EQ(before.name, "v1");
+
+            ctx->Yield();
+            EXPECT_EQ(reader->name, "v2");
+            EXPECT_EQ(reader.Version(), 2u);
+
+            for (int i = 0; i < 100 && participant.PendingCount(); i++)
+            {
+                ctx->Yield();
+            }
+            EXPECT_EQ(participant.PendingCount(), 0u);
+            EXPECT_EQ(live.load(), 1);
+        });
+    }
+    EXPECT_EQ(live.load(), 0);
+}
+
+// A DomainGuard keeps the snapshot it read alive across yields, while readers move on
+//
+TEST(PublishedTest, GuardHoldsSnapshotAcrossYields)
+{
+    coop::epoch::Domain domain;
+    std::atomic<int> live{0};
+    coop::Published<Config> published(domain, "v1", &live);
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        coop::epoch::Participant participant(domain);
+        coop::Published<Config>::Reader reader(published, participant);
+        {
+            coop::epoch::DomainGuard guard(participant);
+            Config const& held = published.Get(guard);
+            published.Publish(participant, "v2", &live);
+
+            for (int i = 0; i < 100; i++)
+            {
+                ctx->Yield();
+            }
+            EXPECT_EQ(held.name, "v1");
+            EXPECT_EQ(reader->name, "v2");
+            EXPECT_EQ(participant.PendingCount(), 1u);
+        }
+
+        for (int i = 0; i < 100 && participant.PendingCount(); i++)
+        {
+            ctx->Yield();
+        }
+        EXPECT_EQ(live.load(), 1);
+    });
+}
+
+// A reader on a cooperator asleep in the kernel lets its pin go, so the writer on another
+// cooperator reclaims the old snapshot without waiting for it to wake
+//
+TEST(PublishedTest, IdleReaderDoesNotHoldReclaimBack)
+{
+    coop::epoch::Domain domain;
+    std::atomic<int> live{0};
+    std::atomic<bool> ready{false}, reclaimed{false};
+    coop::Published<Config> published(domain, "v1", &live);
+
+    coop::Cooperator coopA;
+    coop::Thread threadA(&coopA);
+    coop::Cooperator coopB;
+    coop::Thread threadB(&coopB);
+
+    coopB.Submit([&](coop::Context* ctx)
+    {
+        coop::epoch::Participant participant(domain);
+        coop::Published<Config>::Reader reader(published, participant);
+        EXPECT_EQ(reader->name, "v1");
+        ready = true;
+
+        for (int i = 0; i < 100 && !reclaimed; i++)
+        {
+            coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+        }
+        EXPECT_TRUE(reclaimed);
+        EXPECT_EQ(reader->name, "v2");
+        ctx->GetCooperator()->Shutdown();
+    });
+
+    coopA.Submit([&](coop::Context* ctx)
+    {
+        coop::epoch::Participant participant(domain);
+        while (!ready)
+        {
+            ctx->Yield();
+        }
+
+        published.Publish(participant, "v2", &live);
+        for (int i = 0; i < 1000 && participant.PendingCount(); i++)
+        {
+            coop::time::Sleep(ctx, std::chrono::milliseconds(1));
+        }
+        EXPECT_EQ(participant.PendingCount(), 0u);
+        EXPECT_EQ(live.load(), 1);
+        reclaimed = true;
+        ctx->GetCooperator()->Shutdown();
+    });
+}
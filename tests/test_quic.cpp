@@ -0,0 +1,373 @@
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "coop/cooperator.h"
+#include "coop/self.h"
+#include "coop/wait_group.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/recv.h"
+#include "coop/quic/endpoint.h"
+#include "coop/quic/packet.h"
+#include "coop/time/now.h"
+
+#include "test_helpers.h"
+
+namespace
+{
+
+std::vector<uint8_t> ShortPacket(uint8_t firstCidByte, size_t size)
+{
+    std::vector<uint8_t> packet(size, 0xab);
+    packet[0] = 0x40;
+    for (size_t i = 0; i < 8; i++) packet[1 + i] = uint8_t(firstCidByte + i);
+    return packet;
+}
+
+std::vector<uint8_t> LongPacket(uint32_t version, size_t size)
+{
+    std::vector<uint8_t> packet(size, 0);
+    packet[0] = 0xc0;
+    packet[1] = uint8_t(version >> 24);
+    packet[2] = uint8_t(version >> 16);
+    packet[3] = uint8_t(version >> 8);
+    packet[4] = uint8_t(version);
+    packet[5] = 8;
+    for (int i = 0; i < 8; i++) packet[6 + i] = uint8_t(0x10 + i);
+    packet[14] = 4;
+    for (int i = 0; i < 4; i++) packet[15 + i] = uint8_t(0x70 + i);
+    return packet;
+}
+
+sockaddr_in Loopback()
+{
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+// A steered group of endpoints on the test's cooperator, each on a context of its own, echoing
+// every datagram back and recording the index that received it
+//
+struct EchoGroup
+{
+    EchoGroup(coop::Context* ctx, uint32_t count, coop::quic::EndpointOptions options = {})
+    {
+        sockaddr_in addr = Loopback();
+        int err = coop::quic::OpenSteered((sockaddr*)&addr, sizeof(addr), count, &m_fds);
+        if (err < 0)
+        {
+            return;
+        }
+        socklen_t len = sizeof(m_addr);
+        getsockname(m_fds[0], (sockaddr*)&m_addr, &len);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            m_descs.push_back(std::make_unique<coop::io::Descriptor>(m_fds[i]));
+            coop::quic::EndpointOptions mine = options;
+            mine.bufferGroup = uint16_t(options.bufferGroup + i);
+            m_endpoints.push_back(
+                std::make_unique<coop::quic::Endpoint>(ctx, *m_descs[i], i, count, mine));
+        }
+        for (auto& endpoint : m_endpoints)
+        {
+            coop::quic::Endpoint* e = endpoint.get();
+            m_running.Spawn([this, e](coop::Context*)
+            {
+                m_results.push_back(e->Run([](coop::quic::Endpoint& self,
+                                              coop::quic::Datagram const& d, void* arg)
+                {
+                    static_cast<EchoGroup*>(arg)->m_receivedBy.push_back(self.Index());
+                    self.Send(d.peer, d.peerLength, d.data, d.size);
+                }, this));
+            });
+        }
+    }
+
+    ~EchoGroup()
+    {
+        for (auto& endpoint : m_endpoints)
+        {
+            endpoint->Stop();
+        }
+        m_running.Wait(coop::Self());
+        m_endpoints.clear();
+    }
+
+    bool Ok() const { return !m_endpoints.empty(); }
+
+    std::vector<int>                                    m_fds;
+    std::vector<std::unique_ptr<coop::io::Descriptor>>  m_descs;
+    std::vector<std::unique_ptr<coop::quic::Endpoint>>  m_endpoints;
+    std::vector<uint32_t>                               m_receivedBy;
+    std::vector<int>                                    m_results;
+    sockaddr_in                                         m_addr{};
+    coop::WaitGroup                                     m_running;
+};
+
+struct Client
+{
+    Client()
+    : m_desc(socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0))
+    {
+        sockaddr_in addr = Loopback();
+        bind(m_desc.m_fd, (sockaddr*)&addr, sizeof(addr));
+    }
+
+    void Send(sockaddr_in const& to, std::vector<uint8_t> const& packet)
+    {
+        ::sendto(m_desc.m_fd, packet.data(), packet.size(), 0, (sockaddr const*)&to, sizeof(to));
+    }
+
+    // The next datagram back, or an empty one after a quiet half second
+    //
+    std::vector<uint8_t> Receive()
+    {
+        std::vector<uint8_t> buf(65536);
+        int n = coop::io::Recv(m_desc, buf.data(), buf.size(), 0, std::chrono::milliseconds(500));
+        buf.resize(n > 0 ? size_t(n) : 0);
+        return buf;
+    }
+
+    coop::io::Descriptor m_desc;
+};
+
+} // end anonymous namespace
+
+TEST(QuicPacketTest, ParsesInvariantHeaders)
+{
+    coop::quic::Header header;
+    auto shortPacket = ShortPacket(0x21, 40);
+    ASSERT_TRUE(coop::quic::ParseHeader(shortPacket.data(), shortPacket.size(), 8, &header));
+    EXPECT_FALSE(header.isLong);
+    EXPECT_EQ(header.dcid.length, 8);
+    EXPECT_EQ(header.dcid.bytes[0], 0x21);
+    EXPECT_EQ(header.dcid.bytes[7], 0x28);
+    EXPECT_FALSE(coop::quic::ParseHeader(shortPacket.data(), 8, 8, &header)) << "short of its CID";
+
+    auto longPacket = LongPacket(coop::quic::VERSION_1, 1200);
+    ASSERT_TRUE(coop::quic::ParseHeader(longPacket.data(), longPacket.size(), 8, &header));
+    EXPECT_TRUE(header.isLong);
+    EXPECT_EQ(header.version, coop::quic::VERSION_1);
+    EXPECT_EQ(header.dcid.length, 8);
+    EXPECT_EQ(header.dcid.bytes[0], 0x10);
+    EXPECT_EQ(header.scid.length, 4);
+    EXPECT_EQ(header.scid.bytes[3], 0x73);
+
+    for (size_t len = 0; len < 19; len++)
+    {
+        EXPECT_FALSE(coop::quic::ParseHeader(longPacket.data(), len, 8, &header)) << len;
+    }
+    longPacket[5] = 21;
+    EXPECT_FALSE(coop::quic::ParseHeader(longPacket.data(), longPacket.size(), 8, &header));
+}
+
+TEST(QuicPacketTest, WritesVersionNegotiation)
+{
+    auto packet = LongPacket(0x1a2a3a4a, 1200);
+    coop::quic::Header header;
+    ASSERT_TRUE(coop::quic::ParseHeader(packet.data(), packet.size(), 8, &header));
+
+    std::vector<uint32_t> versions = {coop::quic::VERSION_1};
+    EXPECT_TRUE(coop::quic::NeedsVersionNegotiation(header, versions));
+
+    uint8_t out[128];
+    size_t n = coop::quic::WriteVersionNegotiation(out, sizeof(out), header, versions);
+    ASSERT_EQ(n, 1u + 4 + 1 + 4 + 1 + 8 + 4);
+    EXPECT_TRUE(out[0] & 0x80);
+
+    coop::quic::Header reply;
+    ASSERT_TRUE(coop::quic::ParseHeader(out, n, 8, &reply));
+    EXPECT_EQ(reply.version, coop::quic::VERSION_NEGOTIATION);
+    EXPECT_EQ(reply.dcid, header.scid) << "the IDs come back swapped";
+    EXPECT_EQ(reply.scid, header.dcid);
+    EXPECT_EQ(memcmp(out + n - 4, "\x00\x00\x00\x01", 4), 0);
+
+    EXPECT_FALSE(coop::quic::NeedsVersionNegotiation(reply, versions)) << "never answered";
+    EXPECT_EQ(coop::quic::WriteVersionNegotiation(out, n - 1, header, versions), 0u);
+}
+
+TEST(QuicPacketTest, ConnectionIdsSteerToTheirIssuer)
+{
+    for (uint32_t count = 1; count <= 7; count++)
+    {
+        for (uint32_t index = 0; index < count; index++)
+        {
+            for (int round = 0; round < 16; round++)
+            {
+                coop::quic::ConnectionId cid;
+                ASSERT_TRUE(coop::quic::NewConnectionId(8, index, count, &cid));
+                EXPECT_EQ(cid.length, 8);
+                EXPECT_EQ(coop::quic::SteeringIndex(cid, count), index);
+            }
+        }
+    }
+    coop::quic::ConnectionId cid;
+    EXPECT_FALSE(coop::quic::NewConnectionId(21, 0, 1, &cid));
+    EXPECT_FALSE(coop::quic::NewConnectionId(8, 2, 2, &cid));
+}
+
+// A burst of datagrams is echoed back whole, the replies leaving in fewer sends than datagrams
+// where the kernel takes GSO trains
+//
+TEST(QuicEndpointTest, EchoesInBatches)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        EchoGroup group(ctx, 1);
+        if (!group.Ok())
+        {
+            GTEST_SKIP() << "SO_REUSEPORT group unavailable";
+        }
+        Client client;
+        constexpr int kPackets = 32;
+        for (int i = 0; i < kPackets; i++)
+        {
+            client.Send(group.m_addr, ShortPacket(uint8_t(i), 1200));
+        }
+
+        int echoed = 0;
+        while (echoed < kPackets)
+        {
+            auto reply = client.Receive();
+            if (reply.empty())
+            {
+                break;
+            }
+            EXPECT_EQ(reply.size(), 1200u);
+            echoed++;
+        }
+        if (echoed == 0 && !group.m_results.empty() && group.m_results[0] == -EINVAL)
+        {
+            GTEST_SKIP() << "multishot recvmsg unavailable";
+        }
+        EXPECT_EQ(echoed, kPackets);
+
+        auto const& stats = group.m_endpoints[0]->GetStats();
+        EXPECT_EQ(stats.received, uint64_t(kPackets));
+        EXPECT_EQ(stats.sent, uint64_t(kPackets));
+        EXPECT_LE(stats.completions, stats.received);
+        EXPECT_LE(stats.sends, stats.sent);
+    });
+}
+
+// An unknown version is answered with Version Negotiation, but only from a datagram big enough
+// to be a client's first; garbage is dropped
+//
+TEST(QuicEndpointTest, NegotiatesVersion)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        EchoGroup group(ctx, 1);
+        if (!group.Ok())
+        {
+            GTEST_SKIP() << "SO_REUSEPORT group unavailable";
+        }
+        Client client;
+        client.Send(group.m_addr, LongPacket(0x1a2a3a4a, 100));
+        client.Send(group.m_addr, std::vector<uint8_t>{0x40, 1, 2});
+        client.Send(group.m_addr, LongPacket(0x1a2a3a4a, 1200));
+
+        auto reply = client.Receive();
+        if (reply.empty() && !group.m_results.empty())
+        {
+            GTEST_SKIP() << "multishot recvmsg unavailable";
+        }
+        coop::quic::Header header;
+        ASSERT_TRUE(coop::quic::ParseHeader(reply.data(), reply.size(), 8, &header));
+        EXPECT_EQ(header.version, coop::quic::VERSION_NEGOTIATION);
+        EXPECT_EQ(header.dcid.length, 4);
+
+        auto const& stats = group.m_endpoints[0]->GetStats();
+        EXPECT_EQ(stats.negotiated, 1u);
+        EXPECT_EQ(stats.dropped, 2u);
+        EXPECT_EQ(stats.received, 0u);
+    });
+}
+
+// Every datagram lands on the socket its connection ID's first byte names
+//
+TEST(QuicEndpointTest, SteersByConnectionId)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        EchoGroup group(ctx, 3);
+        if (!group.Ok())
+        {
+            GTEST_SKIP() << "reuseport steering unavailable";
+        }
+        Client client;
+        constexpr int kPackets = 30;
+        std::vector<uint32_t> expected;
+        for (int i = 0; i < kPackets; i++)
+        {
+            client.Send(group.m_addr, ShortPacket(uint8_t(i * 7), 64));
+            expected.push_back(uint32_t(i * 7 % 3));
+        }
+        int echoed = 0;
+        while (echoed < kPackets && !client.Receive().empty())
+        {
+            echoed++;
+        }
+        if (echoed == 0)
+        {
+            GTEST_SKIP() << "multishot recvmsg unavailable";
+        }
+        ASSERT_EQ(echoed, kPackets);
+
+        std::vector<int> perIndex(3, 0), expectedPerIndex(3, 0);
+        for (uint32_t index : group.m_receivedBy) perIndex[index]++;
+        for (uint32_t index : expected) expectedPerIndex[index]++;
+        EXPECT_EQ(perIndex, expectedPerIndex);
+    });
+}
+
+// Paced, a burst past pacingBurst is spread over time by the timer queue
+//
+TEST(QuicEndpointTest, PacesSends)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::quic::EndpointOptions options;
+        options.pacingRate = 1000 * 1000;       // 1MB/s: a 1000-byte datagram per millisecond
+        options.pacingBurst = 2000;
+        EchoGroup group(ctx, 1, options);
+        if (!group.Ok())
+        {
+            GTEST_SKIP() << "SO_REUSEPORT group unavailable";
+        }
+        Client client;
+        constexpr int kPackets = 20;
+        int64_t start = coop::time::MonotonicMicros();
+        for (int i = 0; i < kPackets; i++)
+        {
+            client.Send(group.m_addr, ShortPacket(uint8_t(i), 1000));
+        }
+        int echoed = 0;
+        while (echoed < kPackets && !client.Receive().empty())
+        {
+            echoed++;
+        }
+        if (echoed == 0)
+        {
+            GTEST_SKIP() << "multishot recvmsg unavailable";
+        }
+        ASSERT_EQ(echoed, kPackets);
+        int64_t elapsed = coop::time::MonotonicMicros() - start;
+
+        // 20KB at 1MB/s, less the 2KB burst: at least 18ms
+        //
+        EXPECT_GE(elapsed, 17000);
+        EXPECT_GT(group.m_endpoints[0]->GetStats().paced, 0u);
+    });
+}
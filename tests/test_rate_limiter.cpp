@@ -0,0 +1,201 @@
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "coop/cooperator.h"
+#include "coop/cooperator_group.h"
+#include "coop/cooperate.h"
+#include "coop/rate_limiter.h"
+#include "coop/self.h"
+#include "coop/wait_group.h"
+#include "coop/time/now.h"
+
+#include "test_helpers.h"
+
+namespace
+{
+
+coop::RateLimiter::Stats Stats(coop::RateLimiter const& limiter)
+{
+    return limiter.GetStats();
+}
+
+} // end anonymous namespace
+
+// A full bucket lets the burst through, a lease's worth per trip to the pool, then refuses
+//
+TEST(RateLimiterTest, BurstThenRefuse)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::RateLimiter limiter(std::vector<coop::Cooperator*>{ctx->GetCooperator()},
+                                  {.rate = 10, .burst = 100, .lease = 10});
+        EXPECT_EQ(limiter.LeaseSize(), 10u);
+
+        int admitted = 0;
+        for (int i = 0; i < 200; i++)
+        {
+            admitted += limiter.TryAcquire();
+        }
+        EXPECT_GE(admitted, 100);
+        EXPECT_LE(admitted, 101) << "ten a second: at most one more while the loop runs";
+
+        auto stats = Stats(limiter);
+        EXPECT_EQ(stats.admitted, uint64_t(admitted));
+        EXPECT_EQ(stats.refused, uint64_t(200 - admitted));
+        EXPECT_LE(stats.leases, 11u) << "the pool is visited once per lease, not per token";
+        EXPECT_FALSE(limiter.TryAcquire(101)) << "past the burst";
+    });
+}
+
+// A zero lease picks a share of the burst per owner
+//
+TEST(RateLimiterTest, DefaultLease)
+{
+    coop::CooperatorGroup group(2);
+    coop::RateLimiter limiter(group, {.rate = 1000, .burst = 800});
+    EXPECT_EQ(limiter.LeaseSize(), 100u);
+
+    coop::RateLimiter tiny(group, {.rate = 1, .burst = 1});
+    EXPECT_EQ(tiny.LeaseSize(), 1u);
+}
+
+// Acquire waits for the pool to earn the tokens, or fails at once when it cannot in time
+//
+TEST(RateLimiterTest, AcquireWaitsForTokens)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::RateLimiter limiter(std::vector<coop::Cooperator*>{ctx->GetCooperator()},
+                                  {.rate = 1000, .burst = 1, .lease = 1});
+        ASSERT_TRUE(limiter.TryAcquire());
+
+        int64_t start = coop::time::MonotonicMicros();
+        EXPECT_EQ(limiter.Acquire(ctx, 1, std::chrono::milliseconds(100)), 0);
+        EXPECT_EQ(limiter.Acquire(ctx), 0);
+        EXPECT_GE(coop::time::MonotonicMicros() - start, 1000) << "one token per millisecond";
+
+        EXPECT_EQ(limiter.Acquire(ctx, 2), -EINVAL);
+
+        coop::RateLimiter slow(std::vector<coop::Cooperator*>{ctx->GetCooperator()},
+                               {.rate = 10, .burst = 5, .lease = 5});
+        ASSERT_TRUE(slow.TryAcquire(5));
+        start = coop::time::MonotonicMicros();
+        EXPECT_EQ(slow.Acquire(ctx, 5, std::chrono::milliseconds(50)), -ETIMEDOUT);
+        EXPECT_LT(coop::time::MonotonicMicros() - start, 40000) << "half a second away: no wait";
+    });
+}
+
+// Waiters are served in arrival order, and TryAcquire does not overtake them
+//
+TEST(RateLimiterTest, WaitersServedInOrder)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::RateLimiter limiter(std::vector<coop::Cooperator*>{ctx->GetCooperator()},
+                                  {.rate = 2000, .burst = 2, .lease = 1});
+        ASSERT_TRUE(limiter.TryAcquire(2));
+
+        std::vector<int> order;
+        coop::WaitGroup wg;
+        for (int i = 0; i < 4; i++)
+        {
+            wg.Spawn([&, i](coop::Context* child)
+            {
+                EXPECT_EQ(limiter.Acquire(child, 1, std::chrono::seconds(1)), 0);
+                order.push_back(i);
+            });
+        }
+        EXPECT_FALSE(limiter.TryAcquire()) << "the line is ahead";
+        wg.Wait(ctx);
+        EXPECT_EQ(order, std::vector<int>({0, 1, 2, 3}));
+    });
+}
+
+// A killed waiter leaves the line; the one behind it is still served
+//
+TEST(RateLimiterTest, KilledWaiterLeavesLine)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::RateLimiter limiter(std::vector<coop::Cooperator*>{ctx->GetCooperator()},
+                                  {.rate = 20, .burst = 1, .lease = 1});
+        ASSERT_TRUE(limiter.TryAcquire());
+
+        coop::Context::Handle handle;
+        int killed = 0;
+        int served = -1;
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            killed = limiter.Acquire(child);
+        }, &handle);
+        coop::WaitGroup wg;
+        wg.Spawn([&](coop::Context* child)
+        {
+            served = limiter.Acquire(child, 1, std::chrono::seconds(1));
+        });
+
+        handle.Kill();
+        coop::Yield();
+        EXPECT_EQ(killed, -ECANCELED);
+        wg.Wait(ctx);
+        EXPECT_EQ(served, 0);
+    });
+}
+
+// Off the owners, the limiter spends from the pool directly
+//
+TEST(RateLimiterTest, NonOwnerUsesPool)
+{
+    coop::CooperatorGroup group(1);
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        coop::RateLimiter limiter(group, {.rate = 1000, .burst = 10});
+        int admitted = 0;
+        for (int i = 0; i < 20; i++)
+        {
+            admitted += limiter.TryAcquire();
+        }
+        EXPECT_GE(admitted, 10);
+        EXPECT_LE(admitted, 11);
+        EXPECT_EQ(limiter.Acquire(ctx, 5, std::chrono::milliseconds(100)), 0);
+        EXPECT_EQ(Stats(limiter).leases, 0u);
+    });
+}
+
+// Owners on several threads spending as fast as they can never get past rate and burst together
+//
+TEST(RateLimiterTest, GlobalLimitAcrossCooperators)
+{
+    coop::CooperatorGroup group(3);
+    coop::RateLimiter limiter(group, {.rate = 20000, .burst = 200, .lease = 16});
+
+    std::atomic<uint64_t> admitted{0};
+    std::atomic<int> done{0};
+    int64_t start = coop::time::MonotonicMicros();
+    group.Broadcast([&](coop::Context*)
+    {
+        uint64_t mine = 0;
+        while (coop::time::MonotonicMicros() - start < 50000)
+        {
+            mine += limiter.TryAcquire();
+            coop::Yield();
+        }
+        admitted.fetch_add(mine);
+        done.fetch_add(1);
+    });
+    while (done.load() < group.Size())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    int64_t elapsed = coop::time::MonotonicMicros() - start;
+
+    uint64_t ceiling = 200 + uint64_t(elapsed) * 20000 / 1000000 + 1;
+    EXPECT_LE(admitted.load(), ceiling);
+    EXPECT_GE(admitted.load(), 200u + 20000 * 50 / 1000 / 2) << "most of the rate is used";
+    EXPECT_EQ(Stats(limiter).admitted, admitted.load());
+}
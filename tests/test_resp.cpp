@@ -0,0 +1,270 @@
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <sys/socket.h>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "coop/cooperator.h"
+#include "coop/cooperator_group.h"
+#include "coop/coordinator.h"
+#include "coop/self.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/recv.h"
+#include "coop/io/send.h"
+#include "coop/http/transport.h"
+#include "coop/resp/protocol.h"
+#include "coop/resp/server.h"
+
+#include "test_helpers.h"
+
+namespace
+{
+
+struct SocketPair
+{
+    int fds[2];
+
+    SocketPair()
+    {
+        int ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+        assert(ret == 0);
+        std::ignore = ret;
+    }
+
+    ~SocketPair()
+    {
+        if (fds[0] >= 0) close(fds[0]);
+        if (fds[1] >= 0) close(fds[1]);
+    }
+};
+
+// Send request whole, then read until `expected` bytes have come back or the peer stops
+//
+std::string RoundTrip(coop::io::Descriptor& client, std::string const& request, size_t expected)
+{
+    coop::io::SendAll(client, request.data(), request.size());
+    std::string reply;
+    char buf[4096];
+    while (reply.size() < expected)
+    {
+        int n = coop::io::Recv(client, buf, sizeof(buf), 0, std::chrono::milliseconds(500));
+        if (n <= 0) break;
+        reply.append(buf, size_t(n));
+    }
+    return reply;
+}
+
+std::string Encode(std::vector<std::string> const& args)
+{
+    std::string out = "*" + std::to_string(args.size()) + "\r\n";
+    for (auto const& arg : args)
+    {
+        out += "$" + std::to_string(arg.size()) + "\r\n" + arg + "\r\n";
+    }
+    return out;
+}
+
+// Serve the server end of a socket pair on its own context until the peer closes
+//
+struct TestServer
+{
+    TestServer(coop::Context* ctx, coop::io::Descriptor& desc, coop::resp::Cache& cache)
+    {
+        ctx->GetCooperator()->Spawn([this, &desc, &cache](coop::Context* serverCtx)
+        {
+            m_done.Acquire(serverCtx);
+            coop::resp::Serve(serverCtx, coop::http::PlaintextTransport(desc), cache);
+            m_done.Release(serverCtx, false);
+        });
+    }
+
+    void Wait(coop::Context* ctx)
+    {
+        m_done.Acquire(ctx);
+        m_done.Release(ctx, false);
+    }
+
+    coop::Coordinator   m_done;
+};
+
+} // end anonymous namespace
+
+TEST(RespProtocolTest, ParsesPipelinedCommandsInPlace)
+{
+    std::string wire = Encode({"SET", "key", "a\r\nb"}) + Encode({"GET", "key"}) + "ping\r\n";
+    coop::resp::Command command;
+    const char* error = nullptr;
+
+    const char* at = wire.data();
+    size_t left = wire.size();
+    ptrdiff_t n = coop::resp::ParseCommand(at, left, &command, &error);
+    ASSERT_GT(n, 0);
+    ASSERT_EQ(command.Size(), 3u);
+    EXPECT_TRUE(command.Is("SET"));
+    EXPECT_EQ(command[2], "a\r\nb");
+    EXPECT_EQ(command[1].data(), wire.data() + 17) << "arguments are views of the buffer";
+
+    at += n;
+    left -= size_t(n);
+    n = coop::resp::ParseCommand(at, left, &command, &error);
+    ASSERT_GT(n, 0);
+    EXPECT_TRUE(command.Is("GET"));
+
+    at += n;
+    left -= size_t(n);
+    n = coop::resp::ParseCommand(at, left, &command, &error);
+    EXPECT_EQ(size_t(n), left);
+    ASSERT_EQ(command.Size(), 1u);
+    EXPECT_TRUE(command.Is("PING")) << "inline, and case-insensitive";
+}
+
+TEST(RespProtocolTest, IncompleteAndMalformed)
+{
+    coop::resp::Command command;
+    const char* error = nullptr;
+
+    std::string wire = Encode({"SET", "key", "value"});
+    for (size_t len = 0; len < wire.size(); len++)
+    {
+        EXPECT_EQ(coop::resp::ParseCommand(wire.data(), len, &command, &error), 0) << len;
+    }
+
+    for (std::string bad : {"*2\r\n:3\r\n", "*x\r\n", "*1\r\n$-5\r\n", "*1\r\n$2\r\nabc\r\n",
+                            "*1\r\n$3\r\nabc\n\n", "*1\rx"})
+    {
+        error = nullptr;
+        EXPECT_EQ(coop::resp::ParseCommand(bad.data(), bad.size(), &command, &error), -1) << bad;
+        EXPECT_NE(error, nullptr);
+    }
+
+    std::string empty = "*0\r\n";
+    EXPECT_EQ(coop::resp::ParseCommand(empty.data(), empty.size(), &command, &error), 4);
+    EXPECT_EQ(command.Size(), 0u);
+}
+
+TEST(RespProtocolTest, EncodesReplies)
+{
+    std::string out;
+    coop::resp::AppendSimple(&out, "OK");
+    coop::resp::AppendError(&out, "ERR no");
+    coop::resp::AppendInteger(&out, -12);
+    coop::resp::AppendArray(&out, 2);
+    coop::resp::AppendBulk(&out, "hi");
+    coop::resp::AppendNull(&out);
+    EXPECT_EQ(out, "+OK\r\n-ERR no\r\n:-12\r\n*2\r\n$2\r\nhi\r\n$-1\r\n");
+}
+
+// A pipeline sent in one write is answered in order, reads batched around the writes between them
+//
+TEST(RespServerTest, AnswersPipelineInOrder)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::resp::Cache cache(ctx, std::vector<coop::Cooperator*>{ctx->GetCooperator()});
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+        TestServer ts(ctx, server, cache);
+
+        std::string request = Encode({"GET", "a"})
+            + Encode({"SET", "a", "1"})
+            + Encode({"set", "b", "two"})
+            + Encode({"GET", "a"})
+            + Encode({"MGET", "a", "missing", "b"})
+            + Encode({"EXISTS", "a", "b", "c"})
+            + Encode({"DEL", "a", "c"})
+            + Encode({"GET", "a"})
+            + "PING\r\n"
+            + Encode({"ECHO", "hey"})
+            + Encode({"GET"})
+            + Encode({"NOPE"});
+        std::string expected = "$-1\r\n"
+            "+OK\r\n"
+            "+OK\r\n"
+            "$1\r\n1\r\n"
+            "*3\r\n$1\r\n1\r\n$-1\r\n$3\r\ntwo\r\n"
+            ":2\r\n"
+            ":1\r\n"
+            "$-1\r\n"
+            "+PONG\r\n"
+            "$3\r\nhey\r\n"
+            "-ERR wrong number of arguments for 'GET' command\r\n"
+            "-ERR unknown command 'NOPE'\r\n";
+        EXPECT_EQ(RoundTrip(client, request, expected.size()), expected);
+
+        // A command split across reads, and one bigger than the first recv buffer
+        //
+        std::string big(100000, 'v');
+        std::string set = Encode({"SET", "big", big});
+        coop::io::SendAll(client, set.data(), 7);
+        EXPECT_EQ(RoundTrip(client, set.substr(7) + Encode({"GET", "big"}),
+                            5 + 9 + big.size()),
+                  "+OK\r\n$100000\r\n" + big + "\r\n");
+
+        EXPECT_EQ(RoundTrip(client, Encode({"QUIT"}), 5), "+OK\r\n");
+        ts.Wait(ctx);
+    });
+}
+
+TEST(RespServerTest, ProtocolErrorCloses)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::resp::Cache cache(ctx, std::vector<coop::Cooperator*>{ctx->GetCooperator()});
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+        TestServer ts(ctx, server, cache);
+
+        std::string reply = RoundTrip(client, "PING\r\n*1\r\n!3\r\n", 1000);
+        EXPECT_EQ(reply, "+PONG\r\n-Protocol error: expected '$'\r\n");
+        ts.Wait(ctx);
+    });
+}
+
+// Shards on other cooperators: a pipeline's GETs go out as one batch per shard
+//
+TEST(RespServerTest, BatchesReadsAcrossShards)
+{
+    coop::CooperatorGroup group(2);
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        coop::resp::Cache cache(ctx, group);
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+        TestServer ts(ctx, server, cache);
+
+        constexpr int kKeys = 64;
+        std::string sets;
+        std::string gets;
+        std::string expected;
+        for (int i = 0; i < kKeys; i++)
+        {
+            sets += Encode({"SET", "k" + std::to_string(i), std::to_string(i)});
+            gets += Encode({"GET", "k" + std::to_string(i)});
+            expected += "$" + std::to_string(std::to_string(i).size()) + "\r\n"
+                + std::to_string(i) + "\r\n";
+        }
+        std::string ok;
+        for (int i = 0; i < kKeys; i++) ok += "+OK\r\n";
+        EXPECT_EQ(RoundTrip(client, sets, ok.size()), ok);
+
+        auto before = cache.GetStats();
+        EXPECT_EQ(RoundTrip(client, gets, expected.size()), expected);
+        auto after = cache.GetStats();
+        EXPECT_EQ(after.remote - before.remote, uint64_t(kKeys));
+        EXPECT_LE(after.batches - before.batches, 2u * 2u) << "one send per shard per pipeline";
+
+        client.Close();
+        ts.Wait(ctx);
+    });
+}
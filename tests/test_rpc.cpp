@@ -0,0 +1,371 @@
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <sys/socket.h>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "coop/cooperator.h"
+#include "coop/coordinator.h"
+#include "coop/deadline_scope.h"
+#include "coop/self.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/recv.h"
+#include "coop/io/send.h"
+#include "coop/time/sleep.h"
+#include "coop/http/transport.h"
+#include "coop/rpc/client.h"
+#include "coop/rpc/frame.h"
+#include "coop/rpc/server.h"
+
+#include "test_helpers.h"
+
+namespace
+{
+
+using RpcClient = coop::rpc::Client<coop::http::PlaintextTransport>;
+
+struct SocketPair
+{
+    int fds[2];
+
+    SocketPair()
+    {
+        int ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+        assert(ret == 0);
+        std::ignore = ret;
+    }
+
+    ~SocketPair()
+    {
+        if (fds[0] >= 0) close(fds[0]);
+        if (fds[1] >= 0) close(fds[1]);
+    }
+};
+
+enum : uint16_t
+{
+    ECHO = 1,
+    SILENT = 2,
+    REFUSE = 3,
+    SLOW = 4,
+    BUDGET = 5,
+};
+
+int64_t s_budgetSeen = 0;
+bool s_slowKilled = false;
+
+void Echo(coop::rpc::Call& call)
+{
+    call.Reply(call.Request().data(), call.Request().size());
+}
+
+void Silent(coop::rpc::Call&)
+{
+}
+
+void Refuse(coop::rpc::Call& call)
+{
+    call.Fail(coop::rpc::APPLICATION + 7);
+}
+
+// Sleeps for as many milliseconds as the request says, then echoes it
+//
+void Slow(coop::rpc::Call& call)
+{
+    int ms = std::stoi(std::string(call.Request()));
+    coop::time::Sleep(call.GetContext(), std::chrono::milliseconds(ms));
+    s_slowKilled = call.GetContext()->IsKilled();
+    call.Reply(call.Request().data(), call.Request().size());
+}
+
+void Budget(coop::rpc::Call& call)
+{
+    s_budgetSeen = coop::DeadlineScope::Remaining(call.GetContext()).count();
+    call.Reply(nullptr, 0);
+}
+
+constexpr coop::rpc::MethodTable s_methods = {
+    {ECHO, &Echo},
+    {SILENT, &Silent},
+    {REFUSE, &Refuse},
+    {SLOW, &Slow, coop::rpc::SPAWN},
+    {BUDGET, &Budget},
+};
+
+static_assert(s_methods.Size() == 5);
+static_assert(s_methods.Find(SLOW)->dispatch == coop::rpc::SPAWN);
+static_assert(s_methods.Find(99) == nullptr);
+
+// Serve the server end of a socket pair on its own context; Stop closes the client end and waits
+// for the server to see it
+//
+struct TestServer
+{
+    TestServer(coop::Context* ctx, coop::io::Descriptor& desc,
+               coop::rpc::ServerOptions const& options = {})
+    : m_options(options)
+    {
+        ctx->GetCooperator()->Spawn([this, &desc](coop::Context* serverCtx)
+        {
+            m_done.Acquire(serverCtx);
+            coop::rpc::Serve(serverCtx, coop::http::PlaintextTransport(desc), s_methods,
+                             m_options);
+            m_done.Release(serverCtx, false);
+        }, &m_handle);
+    }
+
+    void Stop(coop::Context* ctx, coop::io::Descriptor& client)
+    {
+        client.Close();
+        m_done.Acquire(ctx);
+        m_done.Release(ctx, false);
+    }
+
+    coop::rpc::ServerOptions    m_options;
+    coop::Coordinator           m_done;
+    coop::Context::Handle       m_handle;
+};
+
+} // end anonymous namespace
+
+TEST(RpcFrameTest, HeaderRoundTrips)
+{
+    coop::rpc::FrameHeader in;
+    in.length = 0x01020304;
+    in.type = coop::rpc::REQUEST;
+    in.code = 0xBEEF;
+    in.id = 0xA0B0C0D0;
+    in.budget = 1500000;
+
+    uint8_t wire[coop::rpc::FRAME_HEADER_SIZE];
+    coop::rpc::WriteFrameHeader(wire, in);
+    EXPECT_EQ(wire[0], 0x01);
+    EXPECT_EQ(wire[3], 0x04);
+    EXPECT_EQ(wire[6], 0xBE);
+
+    coop::rpc::FrameHeader out;
+    coop::rpc::ReadFrameHeader(wire, &out);
+    EXPECT_EQ(out.length, in.length);
+    EXPECT_EQ(out.type, in.type);
+    EXPECT_EQ(out.flags, 0);
+    EXPECT_EQ(out.code, in.code);
+    EXPECT_EQ(out.id, in.id);
+    EXPECT_EQ(out.budget, in.budget);
+}
+
+TEST(RpcMethodTableTest, FindsCollidingIds)
+{
+    // 1 and 129 share a slot in the 128-entry index
+    //
+    static constexpr coop::rpc::MethodTable table = {{1, &Echo}, {129, &Silent}, {2, &Refuse}};
+    static_assert(table.Find(1)->handler == &Echo);
+    static_assert(table.Find(129)->handler == &Silent);
+    static_assert(table.Find(2)->handler == &Refuse);
+    static_assert(table.Find(257) == nullptr);
+    EXPECT_EQ(table.Size(), 3u);
+}
+
+TEST(RpcTest, CallsAndStatuses)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+        TestServer ts(ctx, server);
+
+        {
+            RpcClient rpc{coop::http::PlaintextTransport(client)};
+            ASSERT_TRUE(rpc.Start(ctx));
+
+            std::string response;
+            EXPECT_EQ(rpc.Call(ctx, ECHO, "hello", 5, &response), 0);
+            EXPECT_EQ(response, "hello");
+            EXPECT_EQ(rpc.Call(ctx, ECHO, nullptr, 0, &response), 0);
+            EXPECT_EQ(response, "");
+
+            EXPECT_EQ(rpc.Call(ctx, 99, "x", 1, &response), coop::rpc::UNKNOWN_METHOD);
+            EXPECT_EQ(rpc.Call(ctx, SILENT, "x", 1, &response), coop::rpc::NO_REPLY);
+            EXPECT_EQ(rpc.Call(ctx, REFUSE, "x", 1, nullptr), coop::rpc::APPLICATION + 7);
+
+            // Bigger than either recv buffer: copied out whole on both sides
+            //
+            std::string large(300000, 'L');
+            large[12345] = 'x';
+            EXPECT_EQ(rpc.Call(ctx, ECHO, large.data(), large.size(), &response), 0);
+            EXPECT_EQ(response, large);
+            EXPECT_EQ(rpc.Active(), 0u);
+
+            rpc.Close(ctx);
+            EXPECT_FALSE(rpc.Usable());
+            EXPECT_EQ(rpc.Call(ctx, ECHO, "late", 4, &response), -EAGAIN);
+        }
+
+        ts.Stop(ctx, client);
+    });
+}
+
+// A SPAWN call does not hold up the calls behind it, which are answered first
+//
+TEST(RpcTest, SpawnedCallsAnswerOutOfOrder)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+        TestServer ts(ctx, server);
+
+        {
+            RpcClient rpc{coop::http::PlaintextTransport(client)};
+            ASSERT_TRUE(rpc.Start(ctx));
+
+            std::vector<std::string> order;
+            int finished = 0;
+            auto call = [&](uint16_t method, std::string request)
+            {
+                ctx->GetCooperator()->Spawn([&, method, request](coop::Context* child)
+                {
+                    std::string response;
+                    if (rpc.Call(child, method, request.data(), request.size(), &response) == 0)
+                    {
+                        order.push_back(response);
+                    }
+                    finished++;
+                });
+            };
+            call(SLOW, "50");
+            call(SLOW, "20");
+            call(ECHO, "fast");
+
+            for (int spin = 0; finished < 3 && spin < 200; spin++)
+            {
+                coop::time::Sleep(ctx, std::chrono::milliseconds(5));
+            }
+            ASSERT_EQ(finished, 3);
+            ASSERT_EQ(order.size(), 3u);
+            EXPECT_EQ(order[0], "fast");
+            EXPECT_EQ(order[1], "20");
+            EXPECT_EQ(order[2], "50");
+            EXPECT_FALSE(s_slowKilled);
+        }
+
+        ts.Stop(ctx, client);
+    });
+}
+
+// The caller's deadline travels with the request; a call that outlives it is cancelled on the
+// server as well
+//
+TEST(RpcTest, DeadlinePropagates)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+        TestServer ts(ctx, server);
+
+        {
+            RpcClient rpc{coop::http::PlaintextTransport(client)};
+            ASSERT_TRUE(rpc.Start(ctx));
+
+            {
+                coop::DeadlineScope scope(ctx, std::chrono::milliseconds(200));
+                s_budgetSeen = 0;
+                EXPECT_EQ(rpc.Call(ctx, BUDGET, nullptr, 0, nullptr), 0);
+                EXPECT_GT(s_budgetSeen, 0);
+                EXPECT_LE(s_budgetSeen, 200000);
+            }
+
+            s_slowKilled = false;
+            {
+                coop::DeadlineScope scope(ctx, std::chrono::milliseconds(20));
+                std::string response;
+                EXPECT_EQ(rpc.Call(ctx, SLOW, "500", 3, &response), -ETIMEDOUT);
+            }
+            coop::time::Sleep(ctx, std::chrono::milliseconds(50));
+            EXPECT_TRUE(s_slowKilled) << "the CANCEL, or the budget, stopped the handler";
+
+            std::string response;
+            EXPECT_EQ(rpc.Call(ctx, ECHO, "after", 5, &response), 0);
+            EXPECT_EQ(response, "after");
+        }
+
+        ts.Stop(ctx, client);
+    });
+}
+
+// Requests written in one send are dispatched as a batch: every answer comes back, in order, and
+// a request past maxRequestSize is refused without losing the frames behind it
+//
+TEST(RpcTest, PipelinedRequestsBatch)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+        TestServer ts(ctx, server, {.maxRequestSize = 16});
+
+        std::string wire;
+        auto request = [&](uint32_t id, uint16_t method, std::string const& payload)
+        {
+            coop::rpc::FrameHeader header;
+            header.length = static_cast<uint32_t>(payload.size());
+            header.type = coop::rpc::REQUEST;
+            header.code = method;
+            header.id = id;
+            uint8_t out[coop::rpc::FRAME_HEADER_SIZE];
+            coop::rpc::WriteFrameHeader(out, header);
+            wire.append(reinterpret_cast<char*>(out), sizeof(out));
+            wire += payload;
+        };
+        request(1, ECHO, "one");
+        request(2, ECHO, std::string(64, 'x'));
+        request(3, 99, "");
+        request(4, ECHO, "four");
+        ASSERT_EQ(coop::io::SendAll(client, wire.data(), wire.size()), int(wire.size()));
+
+        std::string got;
+        char buf[1024];
+        size_t expected = 4 * coop::rpc::FRAME_HEADER_SIZE + 3 + 4;
+        while (got.size() < expected)
+        {
+            int n = coop::io::Recv(client, buf, sizeof(buf), 0, std::chrono::milliseconds(500));
+            ASSERT_GT(n, 0);
+            got.append(buf, n);
+        }
+        ASSERT_EQ(got.size(), expected);
+
+        const uint8_t* at = reinterpret_cast<const uint8_t*>(got.data());
+        uint16_t codes[] = {coop::rpc::OK, coop::rpc::TOO_LARGE, coop::rpc::UNKNOWN_METHOD,
+                            coop::rpc::OK};
+        const char* payloads[] = {"one", "", "", "four"};
+        for (uint32_t id = 1; id <= 4; id++)
+        {
+            coop::rpc::FrameHeader header;
+            coop::rpc::ReadFrameHeader(at, &header);
+            at += coop::rpc::FRAME_HEADER_SIZE;
+            EXPECT_EQ(header.id, id);
+            EXPECT_EQ(header.code, codes[id - 1]);
+            EXPECT_EQ(header.type, codes[id - 1] == coop::rpc::OK ? coop::rpc::RESPONSE
+                                                                  : coop::rpc::ERROR);
+            EXPECT_EQ(std::string(reinterpret_cast<const char*>(at), header.length),
+                      payloads[id - 1]);
+            at += header.length;
+        }
+
+        ts.Stop(ctx, client);
+    });
+}
@@ -0,0 +1,544 @@
+// Tests for run-queue ordering policy: priority classes (SpawnConfiguration::priority) and the
+// starvation guard that bounds how long a lower class can be passed over, and the scheduling-delay
+// accounting over the run queue, fair-share scheduling groups, and time-slice preemption
+// checkpoints.
+//
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator.hpp"
+#include "coop/preempt.h"
+#include "coop/scheduling_group.h"
+#include "coop/self.h"
+#include "coop/thread.h"
+#include "coop/time/now.h"
+#include "coop/time/sleep.h"
+
+namespace
+{
+
+void RunWithConfig(coop::CooperatorConfiguration const& cfg, std::function<void(coop::Context*)> fn)
+{
+    coop::Cooperator co(cfg);
+    coop::Thread t(&co);
+
+    co.SubmitSync([&](coop::Context* ctx) { fn(ctx); });
+    co.Shutdown();
+}
+
+coop::CooperatorConfiguration StrictPriority()
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.priorityStarvationLimit = 0;
+    return cfg;
+}
+
+} // namespace
+
+// Runnable high-priority contexts are resumed before runnable background contexts, regardless of
+// the order in which they became runnable.
+//
+TEST(SchedulingTest, HigherPriorityClassRunsFirst)
+{
+    RunWithConfig(StrictPriority(), [](coop::Context* ctx)
+    {
+        std::vector<int> order;
+        int done = 0;
+
+        auto spawnRecorder = [&](int priority)
+        {
+            coop::SpawnConfiguration cfg = coop::s_defaultConfiguration;
+            cfg.priority = priority;
+            ctx->GetCooperator()->Spawn(cfg, [&order, &done, priority](coop::Context* c)
+            {
+                c->Yield();
+                order.push_back(priority);
+                ++done;
+            });
+        };
+
+        spawnRecorder(coop::PRIORITY_BACKGROUND);
+        spawnRecorder(coop::PRIORITY_HIGH);
+        spawnRecorder(coop::PRIORITY_BACKGROUND);
+        spawnRecorder(coop::PRIORITY_HIGH);
+
+        while (done < 4)
+        {
+            ctx->Yield();
+        }
+
+        ASSERT_EQ(order.size(), 4u);
+        EXPECT_EQ(order[0], coop::PRIORITY_HIGH);
+        EXPECT_EQ(order[1], coop::PRIORITY_HIGH);
+        EXPECT_EQ(order[2], coop::PRIORITY_BACKGROUND);
+        EXPECT_EQ(order[3], coop::PRIORITY_BACKGROUND);
+    });
+}
+
+// A high-priority context that never stops yielding cannot starve the background class: the guard
+// serves it after priorityStarvationLimit pass-overs.
+//
+TEST(SchedulingTest, StarvationGuardLetsLowerClassRun)
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.priorityStarvationLimit = 4;
+
+    RunWithConfig(cfg, [](coop::Context* ctx)
+    {
+        bool backgroundRan = false;
+        int spins = 0;
+
+        coop::SpawnConfiguration bg = coop::s_defaultConfiguration;
+        bg.priority = coop::PRIORITY_BACKGROUND;
+        ctx->GetCooperator()->Spawn(bg, [&](coop::Context* c)
+        {
+            c->Yield();
+            backgroundRan = true;
+        });
+
+        coop::SpawnConfiguration hi = coop::s_defaultConfiguration;
+        hi.priority = coop::PRIORITY_HIGH;
+        ctx->GetCooperator()->Spawn(hi, [&](coop::Context* c)
+        {
+            while (!backgroundRan)
+            {
+                ++spins;
+                c->Yield();
+            }
+        });
+
+        while (!backgroundRan)
+        {
+            ctx->Yield();
+        }
+
+        EXPECT_TRUE(backgroundRan);
+        EXPECT_GE(spins, 1);
+    });
+}
+
+// Out-of-range priorities clamp to the nearest class, and a child spawned without an explicit
+// configuration inherits its parent's class.
+//
+TEST(SchedulingTest, PriorityClampsAndIsInherited)
+{
+    RunWithConfig(coop::s_defaultCooperatorConfiguration, [](coop::Context* ctx)
+    {
+        int childPriority = 0;
+        int done = 0;
+
+        coop::SpawnConfiguration hi = coop::s_defaultConfiguration;
+        hi.priority = coop::PRIORITY_HIGH;
+        ctx->GetCooperator()->Spawn(hi, [&](coop::Context* parent)
+        {
+            parent->GetCooperator()->Spawn([&](coop::Context* child)
+            {
+                childPriority = child->GetPriority();
+                ++done;
+            });
+            ++done;
+        });
+
+        coop::SpawnConfiguration huge = coop::s_defaultConfiguration;
+        huge.priority = 100;
+        ctx->GetCooperator()->Spawn(huge, [&](coop::Context* c)
+        {
+            EXPECT_EQ(c->m_runClass, coop::detail::PriorityClassIndex(coop::PRIORITY_HIGH));
+            ++done;
+        });
+
+        while (done < 3)
+        {
+            ctx->Yield();
+        }
+
+        EXPECT_EQ(childPriority, coop::PRIORITY_HIGH);
+    });
+}
+
+namespace
+{
+
+coop::CooperatorConfiguration EarliestDeadline()
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.schedulingMode = coop::SchedulingMode::EarliestDeadline;
+    cfg.priorityStarvationLimit = 0;
+    return cfg;
+}
+
+} // namespace
+
+// Under EarliestDeadline, runnable contexts resume in deadline order ahead of deadline-less ones. The
+// driving context holds the earliest deadline while it spawns so each child queues rather than
+// running to completion immediately, then clears it to let the queue drain.
+//
+TEST(SchedulingTest, EarliestDeadlineRunsFirst)
+{
+    RunWithConfig(EarliestDeadline(), [](coop::Context* ctx)
+    {
+        const int64_t base = coop::time::MonotonicMicros() + 1000000;
+        ctx->SetDeadline(1);
+
+        std::vector<int64_t> order;
+        int done = 0;
+
+        auto spawnRecorder = [&](int64_t deadline)
+        {
+            coop::SpawnConfiguration cfg = coop::s_defaultConfiguration;
+            cfg.deadlineUs = deadline;
+            ctx->GetCooperator()->Spawn(cfg, [&order, &done](coop::Context* c)
+            {
+                c->Yield();
+                order.push_back(c->GetDeadline());
+                ++done;
+            });
+        };
+
+        spawnRecorder(0);
+        spawnRecorder(base + 300);
+        spawnRecorder(base + 100);
+        spawnRecorder(base + 200);
+
+        ctx->SetDeadline(0);
+        while (done < 4)
+        {
+            ctx->Yield();
+        }
+
+        ASSERT_EQ(order.size(), 4u);
+        EXPECT_EQ(order[0], base + 100);
+        EXPECT_EQ(order[1], base + 200);
+        EXPECT_EQ(order[2], base + 300);
+        EXPECT_EQ(order[3], 0);
+    });
+}
+
+// SetDeadline on a context already waiting in the run queue re-keys it, and a child spawned without
+// an explicit configuration inherits its parent's deadline.
+//
+TEST(SchedulingTest, SetDeadlineRekeysQueuedContext)
+{
+    RunWithConfig(EarliestDeadline(), [](coop::Context* ctx)
+    {
+        const int64_t base = coop::time::MonotonicMicros() + 1000000;
+        ctx->SetDeadline(1);
+
+        std::vector<char> order;
+        coop::Context* late = nullptr;
+        int64_t inherited = 0;
+        int done = 0;
+
+        coop::SpawnConfiguration a = coop::s_defaultConfiguration;
+        a.deadlineUs = base + 300;
+        ctx->GetCooperator()->Spawn(a, [&](coop::Context* c)
+        {
+            late = c;
+            c->Yield();
+            order.push_back('a');
+            ++done;
+        });
+
+        coop::SpawnConfiguration b = coop::s_defaultConfiguration;
+        b.deadlineUs = base + 200;
+        ctx->GetCooperator()->Spawn(b, [&](coop::Context* c)
+        {
+            c->GetCooperator()->Spawn([&](coop::Context* child)
+            {
+                inherited = child->GetDeadline();
+            });
+            c->Yield();
+            order.push_back('b');
+            ++done;
+        });
+
+        ASSERT_NE(late, nullptr);
+        late->SetDeadline(base + 100);
+
+        ctx->SetDeadline(0);
+        while (done < 2)
+        {
+            ctx->Yield();
+        }
+
+        ASSERT_EQ(order.size(), 2u);
+        EXPECT_EQ(order[0], 'a');
+        EXPECT_EQ(order[1], 'b');
+        EXPECT_EQ(inherited, base + 200);
+    });
+}
+
+// With trackSchedulingDelay, a context queued behind one that runs long between yields records
+// that run as delay, and schedulingDelayByName keeps it under its own name.
+//
+TEST(SchedulingTest, SchedulingDelayRecordsTimeRunnable)
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.trackSchedulingDelay = true;
+    cfg.schedulingDelayByName = true;
+
+    RunWithConfig(cfg, [](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        int done = 0;
+
+        co->Spawn([&done](coop::Context* c)
+        {
+            c->SetName("spinner");
+            for (int i = 0; i < 5; i++)
+            {
+                const int64_t until = coop::time::MonotonicMicros() + 1000;
+                while (coop::time::MonotonicMicros() < until) {}
+                c->Yield();
+            }
+            ++done;
+        });
+        co->Spawn([&done](coop::Context* c)
+        {
+            c->SetName("waiter");
+            for (int i = 0; i < 5; i++)
+            {
+                c->Yield();
+            }
+            ++done;
+        });
+
+        while (done < 2)
+        {
+            ctx->Yield();
+        }
+
+        ASSERT_TRUE(co->TracksSchedulingDelay());
+        EXPECT_GE(co->GetSchedulingDelay().count, 10u);
+
+        uint64_t waiterCount = 0;
+        double waiterMaxNs = 0;
+        co->VisitSchedulingDelays([&](const char* name, coop::perf::Histogram const& h)
+        {
+            if (std::string(name) == "waiter")
+            {
+                waiterCount = h.count;
+                waiterMaxNs = static_cast<double>(h.max) * co->NanosPerTick();
+            }
+        });
+        EXPECT_GE(waiterCount, 5u);
+        EXPECT_GE(waiterMaxNs, 500000.0);
+    });
+}
+
+namespace
+{
+
+// Run for about the given nanoseconds, as a slice of CPU-bound work
+//
+void Burn(int64_t nanos)
+{
+    const int64_t until = coop::time::MonotonicNanos() + nanos;
+    while (coop::time::MonotonicNanos() < until)
+    {
+    }
+}
+
+// Spawn count contexts into group that each burn a slice and yield until stop, counting slices
+//
+void SpawnBurners(coop::Context* ctx, coop::SchedulingGroup* group, int count, bool const* stop,
+                  int* slices)
+{
+    coop::SpawnConfiguration cfg = coop::s_defaultConfiguration;
+    cfg.group = group;
+    for (int i = 0; i < count; i++)
+    {
+        ctx->GetCooperator()->Spawn(cfg, [stop, slices](coop::Context* c)
+        {
+            while (!*stop)
+            {
+                Burn(5000);
+                ++*slices;
+                c->Yield();
+            }
+        });
+    }
+}
+
+// Yield for about the given nanoseconds, leaving the loop to the burners
+//
+void YieldFor(coop::Context* ctx, int64_t nanos)
+{
+    const int64_t until = coop::time::MonotonicNanos() + nanos;
+    while (coop::time::MonotonicNanos() < until)
+    {
+        ctx->Yield();
+    }
+}
+
+void Drain(coop::Context* ctx, coop::SchedulingGroup const& group)
+{
+    while (group.GetStatistics().contexts)
+    {
+        ctx->Yield();
+    }
+}
+
+} // namespace
+
+// Two groups of CPU-bound contexts split the loop by weight, however many contexts each has: the
+// heavier group's single context outruns the lighter group's four.
+//
+TEST(SchedulingTest, GroupsShareByWeight)
+{
+    RunWithConfig(coop::s_defaultCooperatorConfiguration, [](coop::Context* ctx)
+    {
+        coop::SchedulingGroup heavy({.name = "heavy",
+                                     .weight = 3 * coop::SCHEDULING_WEIGHT_DEFAULT});
+        coop::SchedulingGroup light({.name = "light"});
+
+        bool stop = false;
+        int heavySlices = 0;
+        int lightSlices = 0;
+        SpawnBurners(ctx, &heavy, 1, &stop, &heavySlices);
+        SpawnBurners(ctx, &light, 4, &stop, &lightSlices);
+
+        // The driver is ungrouped: a third entity, whose slices are too short to matter
+        //
+        YieldFor(ctx, 200 * 1000 * 1000);
+        stop = true;
+        Drain(ctx, heavy);
+        Drain(ctx, light);
+
+        ASSERT_GT(lightSlices, 0);
+        const double ratio = double(heavySlices) / double(lightSlices);
+        EXPECT_GT(ratio, 2.0) << heavySlices << " vs " << lightSlices;
+        EXPECT_LT(ratio, 4.5) << heavySlices << " vs " << lightSlices;
+        EXPECT_GT(heavy.GetStatistics().runTicks, light.GetStatistics().runTicks);
+    });
+}
+
+// Spawns inherit the group, so a tenant's fan-out is charged to the tenant
+//
+TEST(SchedulingTest, GroupIsInherited)
+{
+    RunWithConfig(coop::s_defaultCooperatorConfiguration, [](coop::Context* ctx)
+    {
+        coop::SchedulingGroup tenant({.name = "tenant"});
+        coop::SpawnConfiguration cfg = coop::s_defaultConfiguration;
+        cfg.group = &tenant;
+
+        coop::SchedulingGroup* grandchild = nullptr;
+        bool done = false;
+        ctx->GetCooperator()->Spawn(cfg, [&](coop::Context* child)
+        {
+            EXPECT_EQ(child->m_group, &tenant);
+            child->GetCooperator()->Spawn([&](coop::Context* c)
+            {
+                grandchild = c->m_group;
+                EXPECT_EQ(tenant.GetStatistics().contexts, 2u);
+                done = true;
+            });
+        });
+        while (!done)
+        {
+            ctx->Yield();
+        }
+        Drain(ctx, tenant);
+
+        EXPECT_EQ(grandchild, &tenant);
+        EXPECT_EQ(ctx->m_group, nullptr);
+    });
+}
+
+// A budget caps a group under contention, throttling it for the rest of its period, but a
+// throttled group still runs on cycles nothing else wants
+//
+TEST(SchedulingTest, GroupBudgetCapsShare)
+{
+    RunWithConfig(coop::s_defaultCooperatorConfiguration, [](coop::Context* ctx)
+    {
+        coop::SchedulingGroup capped({.name = "capped", .budgetUs = 1000, .periodUs = 10000});
+        coop::SchedulingGroup open({.name = "open"});
+
+        bool stop = false;
+        int cappedSlices = 0;
+        int openSlices = 0;
+        SpawnBurners(ctx, &capped, 1, &stop, &cappedSlices);
+        SpawnBurners(ctx, &open, 1, &stop, &openSlices);
+
+        YieldFor(ctx, 200 * 1000 * 1000);
+        stop = true;
+        Drain(ctx, capped);
+        Drain(ctx, open);
+
+        EXPECT_GT(capped.GetStatistics().throttledPeriods, 0u);
+        ASSERT_GT(openSlices, 0);
+        EXPECT_LT(double(cappedSlices) / double(openSlices), 0.3)
+            << cappedSlices << " vs " << openSlices;
+
+        // Alone -- the driver asleep -- the capped group runs past its budget
+        //
+        stop = false;
+        cappedSlices = 0;
+        SpawnBurners(ctx, &capped, 1, &stop, &cappedSlices);
+        coop::time::Sleep(ctx, std::chrono::milliseconds(50));
+        stop = true;
+        Drain(ctx, capped);
+        EXPECT_GT(cappedSlices, 3000);
+    });
+}
+
+// A CPU-bound loop calling MaybeYield gives way once its slice has run timeSliceUs, so a context
+// queued behind it runs without the loop ever yielding on its own
+//
+TEST(SchedulingTest, MaybeYieldPreemptsExpiredSlice)
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.timeSliceUs = 1000;
+    RunWithConfig(cfg, [](coop::Context* ctx)
+    {
+        // The spawn runs the child first; its yield queues it behind this context
+        //
+        bool ran = false;
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            child->Yield();
+            ran = true;
+        });
+
+        const int64_t start = coop::time::MonotonicNanos();
+        int yields = 0;
+        while (!ran && coop::time::MonotonicNanos() - start < 2000 * 1000 * 1000)
+        {
+            yields += coop::MaybeYield();
+        }
+        const int64_t elapsed = coop::time::MonotonicNanos() - start;
+
+        EXPECT_TRUE(ran);
+        EXPECT_EQ(yields, 1);
+        EXPECT_GE(elapsed, 1000 * 1000);
+        EXPECT_LT(elapsed, 500 * 1000 * 1000);
+        EXPECT_EQ(ctx->GetCooperator()->Preemptions(), 1u);
+        EXPECT_FALSE(coop::SliceExpired());
+    });
+}
+
+// With no time slice there is no ticker, and the checkpoint never fires
+//
+TEST(SchedulingTest, MaybeYieldIsInertWithoutTimeSlice)
+{
+    RunWithConfig(coop::s_defaultCooperatorConfiguration, [](coop::Context* ctx)
+    {
+        const int64_t start = coop::time::MonotonicNanos();
+        int yields = 0;
+        while (coop::time::MonotonicNanos() - start < 20 * 1000 * 1000)
+        {
+            yields += coop::MaybeYield();
+        }
+        EXPECT_EQ(yields, 0);
+        EXPECT_EQ(ctx->GetCooperator()->Preemptions(), 0u);
+    });
+}
@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "coop/chan/channel.h"
+#include "coop/chan/select.h"
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/handle.h"
+#include "coop/io/recv.h"
+#include "coop/io/send.h"
+#include "coop/selector.h"
+#include "coop/self.h"
+#include "coop/signal.h"
+#include "coop/time/sleep.h"
+#include "test_helpers.h"
+
+// Selector -- a reusable wait whose arms stay registered across Waits. See coop/selector.h.
+//
+
+namespace
+{
+
+struct SocketPair
+{
+    int fds[2];
+
+    SocketPair()
+    {
+        int ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+        EXPECT_EQ(ret, 0);
+    }
+
+    ~SocketPair()
+    {
+        close(fds[0]);
+        close(fds[1]);
+    }
+};
+
+} // namespace
+
+// A channel and a periodic timer multiplexed by one selector: every value and every expiry is
+// handled, each case re-arming in place while the other waits
+//
+TEST(SelectorTest, ChannelAndTimerAcrossIterations)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        constexpr int VALUES = 5;
+        constexpr int TICKS = 3;
+
+        coop::chan::FixedChannel<int, 4> ch(ctx);
+        coop::time::Sleeper ping(ctx, std::chrono::milliseconds(1));
+        ASSERT_TRUE(ping.Arm());
+
+        int sum = 0;
+        int values = 0;
+        int ticks = 0;
+
+        auto sel = coop::MakeSelector(ctx,
+            coop::chan::On(ch, [&](int v) { sum += v; values++; }),
+            coop::OnExpired(ping, [&]
+            {
+                if (++ticks < TICKS) ping.Arm();
+            }));
+
+        ctx->GetCooperator()->Spawn([&](coop::Context*)
+        {
+            for (int i = 1; i <= VALUES; i++) ch.Send(i);
+        });
+
+        int fired[2] = {0, 0};
+        while (values < VALUES || ticks < TICKS)
+        {
+            int index = sel.Wait();
+            ASSERT_GE(index, 0);
+            fired[index]++;
+        }
+
+        EXPECT_EQ(sum, VALUES * (VALUES + 1) / 2);
+        EXPECT_EQ(fired[0], VALUES);
+        EXPECT_EQ(fired[1], TICKS);
+        EXPECT_TRUE(sel.Live(0));
+        EXPECT_TRUE(sel.Live(1));
+    });
+}
+
+// An IO completion case fires with the operation's result; resubmitting from the handler arms it
+// for the next one
+//
+TEST(SelectorTest, CompletionResubmittedFromHandler)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor reader(sp.fds[0], uring);
+        coop::io::Descriptor writer(sp.fds[1], uring);
+
+        coop::Coordinator coord;
+        coop::io::Handle handle(ctx, reader, &coord);
+
+        char buf[16] = {};
+        ASSERT_TRUE(coop::io::Recv(handle, buf, sizeof(buf)));
+
+        int messages = 0;
+        int bytes = 0;
+        auto sel = coop::MakeSelector(ctx,
+            coop::OnComplete(handle, [&](int result)
+            {
+                ASSERT_GT(result, 0);
+                bytes += result;
+                if (++messages < 2) coop::io::Recv(handle, buf, sizeof(buf));
+            }));
+
+        ASSERT_EQ(coop::io::Send(writer, "ping", 4), 4);
+        EXPECT_EQ(sel.Wait(), 0);
+        EXPECT_EQ(memcmp(buf, "ping", 4), 0);
+
+        ASSERT_EQ(coop::io::Send(writer, "pong!", 5), 5);
+        EXPECT_EQ(sel.Wait(), 0);
+        EXPECT_EQ(memcmp(buf, "pong!", 5), 0);
+
+        EXPECT_EQ(messages, 2);
+        EXPECT_EQ(bytes, 9);
+    });
+}
+
+// A signal case is one-shot: it retires after its handler. A channel shutdown retires its case;
+// with nothing live, Wait returns DONE.
+//
+TEST(SelectorTest, RetiredCasesEndInDone)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::FixedChannel<int, 4> ch(ctx);
+        coop::Signal stop(ctx);
+
+        bool stopped = false;
+        bool shutdown = false;
+        auto sel = coop::MakeSelector(ctx,
+            coop::chan::On(ch, [&](int) {}, [&] { shutdown = true; }),
+            coop::OnSignal(stop, [&] { stopped = true; }));
+
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            stop.Notify(child, false);
+        });
+
+        EXPECT_EQ(sel.Wait(), 1);
+        EXPECT_TRUE(stopped);
+        EXPECT_FALSE(sel.Live(1));
+
+        ch.Shutdown();
+        EXPECT_EQ(sel.Wait(), 0);
+        EXPECT_TRUE(shutdown);
+        EXPECT_FALSE(sel.Live(0));
+
+        EXPECT_EQ(sel.Wait(), coop::Selector::DONE);
+    });
+}
+
+// Cases that are ready when the selector is built fire leftmost first, one per Wait
+//
+TEST(SelectorTest, ReadyCasesFireLeftmostFirst)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::FixedChannel<int, 4> a(ctx);
+        coop::chan::FixedChannel<int, 4> b(ctx);
+        ASSERT_TRUE(b.TrySend(2));
+        ASSERT_TRUE(a.TrySend(1));
+
+        int last = 0;
+        auto sel = coop::MakeSelector(ctx,
+            coop::chan::On(a, [&](int v) { last = v; }),
+            coop::chan::On(b, [&](int v) { last = v; }));
+
+        EXPECT_EQ(sel.Wait(), 0);
+        EXPECT_EQ(last, 1);
+        EXPECT_EQ(sel.Wait(), 1);
+        EXPECT_EQ(last, 2);
+    });
+}
+
+// WaitKill returns KILLED for a context killed while parked, and the selector tears down cleanly
+// from there
+//
+TEST(SelectorTest, WaitKillReturnsKilled)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::chan::FixedChannel<int, 4> ch(ctx);
+        coop::Context::Handle handle;
+        int result = 0;
+
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            auto sel = coop::MakeSelector(child, coop::chan::On(ch, [](int) {}));
+            result = sel.WaitKill();
+        }, &handle);
+
+        handle.Kill();
+        ctx->Yield();
+        EXPECT_EQ(result, coop::Selector::KILLED);
+    });
+}
@@ -0,0 +1,161 @@
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "coop/cooperator.h"
+#include "coop/cooperator_group.h"
+#include "coop/sharded_cache.h"
+#include "test_helpers.h"
+
+using Cache = coop::ShardedCache<uint64_t, std::string>;
+
+// One owner: every call is local, straight into the table
+//
+TEST(ShardedCacheTest, LocalGetPutErase)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        Cache cache(ctx, std::vector<coop::Cooperator*>{ctx->GetCooperator()});
+        EXPECT_EQ(cache.ShardCount(), 1u);
+
+        cache.Put(ctx, 1, "one");
+        cache.Put(ctx, 2, "two");
+        EXPECT_EQ(cache.Get(ctx, 1), "one");
+        EXPECT_FALSE(cache.Get(ctx, 3).has_value());
+
+        cache.Put(ctx, 1, "uno");                       // replaced in place
+        EXPECT_EQ(cache.Get(ctx, 1), "uno");
+
+        EXPECT_TRUE(cache.Erase(ctx, 2));
+        EXPECT_FALSE(cache.Erase(ctx, 2));
+        EXPECT_FALSE(cache.Get(ctx, 2).has_value());
+
+        auto stats = cache.GetStats();
+        EXPECT_EQ(stats.entries, 1u);
+        EXPECT_EQ(stats.inserts, 2u);
+        EXPECT_EQ(stats.remote, 0u);
+    });
+}
+
+// One bucket of kWays: the entries read since the hand last passed outlive the one that was not
+//
+TEST(ShardedCacheTest, ClockKeepsReferencedEntries)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        coop::ShardedCacheConfiguration config;
+        config.capacity = Cache::kWays;
+        Cache cache(ctx, std::vector<coop::Cooperator*>{ctx->GetCooperator()}, config);
+
+        for (uint64_t key = 0; key < Cache::kWays; key++)
+        {
+            cache.Put(ctx, key, std::to_string(key));
+        }
+        for (uint64_t key = 1; key < Cache::kWays; key++)
+        {
+            EXPECT_TRUE(cache.Get(ctx, key).has_value());
+        }
+
+        cache.Put(ctx, 100, "new");
+        EXPECT_FALSE(cache.Get(ctx, 0).has_value());
+        for (uint64_t key = 1; key < Cache::kWays; key++)
+        {
+            EXPECT_TRUE(cache.Get(ctx, key).has_value()) << key;
+        }
+        EXPECT_EQ(cache.Get(ctx, 100), "new");
+        EXPECT_EQ(cache.GetStats().evictions, 1u);
+        EXPECT_EQ(cache.GetStats().entries, Cache::kWays);
+    });
+}
+
+// Shards on a group's members, used from a cooperator outside it: every call is a request to
+// the key's owner, and GetMany batches them per shard
+//
+TEST(ShardedCacheTest, RemoteCallsReachEveryShard)
+{
+    coop::CooperatorGroup group(3);
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        Cache cache(ctx, group);
+        EXPECT_EQ(cache.ShardCount(), 3u);
+
+        constexpr uint64_t kKeys = 256;
+        std::vector<int> perShard(3);
+        for (uint64_t key = 0; key < kKeys; key++)
+        {
+            cache.Put(ctx, key, std::to_string(key));
+            perShard[cache.ShardOf(key)]++;
+        }
+        for (int count : perShard)
+        {
+            EXPECT_GT(count, 0);
+        }
+
+        EXPECT_EQ(cache.Get(ctx, 7), "7");
+        EXPECT_FALSE(cache.Get(ctx, kKeys).has_value());
+        EXPECT_TRUE(cache.Erase(ctx, 7));
+        EXPECT_FALSE(cache.Get(ctx, 7).has_value());
+
+        std::vector<uint64_t> keys;
+        for (uint64_t key = 0; key < kKeys + 8; key++)
+        {
+            keys.push_back(key);
+        }
+        std::vector<std::optional<std::string>> out(keys.size());
+        cache.GetMany(ctx, keys, out.data());
+        for (uint64_t key = 0; key < keys.size(); key++)
+        {
+            if (key == 7 || key >= kKeys)
+            {
+                EXPECT_FALSE(out[key].has_value()) << key;
+            }
+            else
+            {
+                EXPECT_EQ(out[key], std::to_string(key));
+            }
+        }
+
+        auto stats = cache.GetStats();
+        EXPECT_EQ(stats.entries, kKeys - 1);
+        EXPECT_EQ(stats.remote, kKeys + 4 + keys.size());
+        EXPECT_LE(stats.batches, stats.remote);
+    });
+}
+
+// The members use their own shards directly and each other's through the inbox, all at once
+//
+TEST(ShardedCacheTest, MembersShareTheCache)
+{
+    coop::CooperatorGroup group(2);
+    std::atomic<int> done{0};
+    test::RunInCooperator([&](coop::Context* ctx)
+    {
+        Cache cache(ctx, group);
+        constexpr uint64_t kKeys = 512;
+
+        group.Broadcast([&](coop::Context* member)
+        {
+            for (uint64_t key = 0; key < kKeys; key++)
+            {
+                cache.Put(member, key, std::to_string(key));
+                EXPECT_EQ(cache.Get(member, key), std::to_string(key));
+            }
+            done.fetch_add(1);
+        });
+        while (done.load() < 2)
+        {
+            ctx->Yield();
+            std::this_thread::yield();
+        }
+
+        auto stats = cache.GetStats();
+        EXPECT_EQ(stats.entries, kKeys);
+        EXPECT_GT(stats.remote, 0u);
+        EXPECT_LT(stats.remote, 2 * 2 * kKeys);
+    });
+}
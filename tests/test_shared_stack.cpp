@@ -0,0 +1,412 @@
+// Tests for shared-stack contexts (SpawnConfiguration::sharedStack, see coop/shared_stack.h).
+//
+// Every test checks the same thing at heart: frames parked while another shared context ran on
+// the stack come back exactly as they were left. The contexts keep a few frames of locals and
+// compare them after each park, and the copy counters show the stack really changed hands.
+//
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "coop/alloc.h"
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator.hpp"
+#include "coop/coordinate_with.h"
+#include "coop/coordinator.h"
+#include "coop/cooperate.h"
+#include "coop/remote_coordinator.h"
+#include "coop/self.h"
+#include "coop/semaphore.h"
+#include "coop/shared_stack.h"
+#include "coop/thread.h"
+#include "coop/detail/bump.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/recv.h"
+#include "coop/io/send.h"
+#include "coop/time/sleep.h"
+
+#include "test_helpers.h"
+
+namespace
+{
+
+coop::SpawnConfiguration Shared()
+{
+    coop::SpawnConfiguration config = coop::s_defaultConfiguration;
+    config.stackSize = 4096;
+    config.sharedStack = true;
+    return config;
+}
+
+void RunWith(coop::CooperatorConfiguration const& cfg, std::function<void(coop::Context*)> fn)
+{
+    coop::Cooperator co(cfg);
+    coop::Thread t(&co);
+    co.SubmitSync([&](coop::Context* ctx) { fn(ctx); });
+    co.Shutdown();
+}
+
+// depth frames of locals derived from seed, with park() run at the bottom; true if every local
+// still holds its value afterwards
+//
+[[gnu::noinline]] bool ParkDeep(int depth, uint64_t seed, std::function<void()> const& park)
+{
+    volatile uint64_t local[8];
+    for (int i = 0; i < 8; i++)
+    {
+        local[i] = seed * 131 + depth * 17 + i;
+    }
+
+    bool ok = true;
+    if (depth > 0)
+    {
+        ok = ParkDeep(depth - 1, seed, park);
+    }
+    else
+    {
+        park();
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+        ok = ok && local[i] == seed * 131 + depth * 17 + i;
+    }
+    return ok;
+}
+
+} // end anonymous namespace
+
+// A chain of shared contexts parked on one coordinator, each handing it to the next: every hand
+// switches between two shared contexts, and each one's frames were copied out while it waited
+//
+TEST(SharedStackTest, FramesSurviveParking)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        coop::Coordinator gate(ctx);
+
+        constexpr int kContexts = 32;
+        int intact = 0;
+        int done = 0;
+        for (int i = 0; i < kContexts; i++)
+        {
+            ASSERT_TRUE(co->Spawn(Shared(), [&, i](coop::Context* child)
+            {
+                EXPECT_TRUE(child->IsSharedStack());
+                intact += ParkDeep(4, i, [&]
+                {
+                    gate.Acquire(child);
+                    gate.Release(child);
+                });
+                done++;
+            }));
+        }
+
+        auto parked = co->GetSharedStackStats();
+        EXPECT_EQ(parked.savedContexts, uint64_t(kContexts - 1)) << "all but the holder copied out";
+        EXPECT_GT(parked.savedBytes, 0u);
+        EXPECT_LT(parked.savedBytes / parked.savedContexts, 4096u) << "live frames only";
+
+        gate.Release(ctx);
+        while (done < kContexts)
+        {
+            coop::Yield();
+        }
+        EXPECT_EQ(intact, kContexts);
+
+        auto stats = co->GetSharedStackStats();
+        EXPECT_GE(stats.saves, uint64_t(kContexts - 1));
+        EXPECT_EQ(stats.restores, stats.saves);
+        EXPECT_EQ(stats.savedContexts, 0u);
+        EXPECT_EQ(stats.savedBytes, 0u);
+    });
+}
+
+// With the direct-yield fastpath on, ordinary contexts switch straight into shared ones and copy
+// the stack over from their own; shared to shared still goes through the loop
+//
+TEST(SharedStackTest, DirectSwitchesFromOrdinaryContexts)
+{
+    coop::CooperatorConfiguration cfg;
+    cfg.directYield = true;
+    cfg.directYieldBudget = 8;
+
+    RunWith(cfg, [](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        int intact = 0;
+        int done = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            co->Spawn(i % 2 ? Shared() : coop::s_defaultConfiguration,
+                      [&, i](coop::Context* child)
+            {
+                intact += ParkDeep(3, i, [&]
+                {
+                    for (int n = 0; n < 50; n++)
+                    {
+                        child->Yield();
+                    }
+                });
+                done++;
+            });
+        }
+        while (done < 8)
+        {
+            coop::Yield();
+        }
+        EXPECT_EQ(intact, 8);
+        EXPECT_EQ(co->GetSharedStackStats().savedContexts, 0u);
+    });
+}
+
+// Sleeps and timed waits keep their timer nodes and handles off the shared stack
+//
+TEST(SharedStackTest, SleepsAndTimeouts)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        int intact = 0;
+        int timedOut = 0;
+        int done = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            co->Spawn(Shared(), [&, i](coop::Context* child)
+            {
+                coop::Coordinator never(child);
+                intact += ParkDeep(2, i, [&]
+                {
+                    EXPECT_EQ(coop::time::Sleep(child, std::chrono::milliseconds(1 + i)),
+                              coop::time::SleepResult::Ok);
+                    auto r = coop::CoordinateWith(child, &never, std::chrono::milliseconds(2));
+                    timedOut += r.TimedOut();
+                });
+                never.Release(child);
+                done++;
+            });
+        }
+        while (done < 4)
+        {
+            coop::time::Sleep(ctx, std::chrono::milliseconds(1));
+        }
+        EXPECT_EQ(intact, 4);
+        EXPECT_EQ(timedOut, 4);
+    });
+}
+
+// Blocking Recv and Send keep their Handle and Coordinator off the shared stack: the contexts all
+// park on a recv at once, so each one's frames are copied out while its completion is pending.
+// The buffers are bump-allocated, and the descriptors live in the ordinary parent's frame.
+//
+TEST(SharedStackTest, BlockingRecvAndSend)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        constexpr int kContexts = 4;
+        std::vector<std::unique_ptr<coop::io::Descriptor>> inner, outer;
+        for (int i = 0; i < kContexts; i++)
+        {
+            int fds[2];
+            ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+            inner.push_back(std::make_unique<coop::io::Descriptor>(fds[0]));
+            outer.push_back(std::make_unique<coop::io::Descriptor>(fds[1]));
+        }
+
+        int intact = 0;
+        int echoed = 0;
+        int done = 0;
+        for (int i = 0; i < kContexts; i++)
+        {
+            co->Spawn(Shared(), [&, i](coop::Context* child)
+            {
+                auto buf = child->AllocateBuffer(16);
+                int got = 0;
+                intact += ParkDeep(3, i, [&]
+                {
+                    got = coop::io::Recv(*inner[i], buf.data(), buf.size());
+                });
+                if (got == 1 && buf[0] == char('a' + i))
+                {
+                    echoed += coop::io::Send(*inner[i], buf.data(), 1) == 1;
+                }
+                done++;
+            });
+        }
+        EXPECT_EQ(co->GetSharedStackStats().savedContexts, uint64_t(kContexts - 1));
+
+        for (int i = 0; i < kContexts; i++)
+        {
+            char c = char('a' + i);
+            EXPECT_EQ(coop::io::Send(*outer[i], &c, 1), 1);
+        }
+        for (int i = 0; i < kContexts; i++)
+        {
+            char c = 0;
+            EXPECT_EQ(coop::io::Recv(*outer[i], &c, 1), 1);
+            EXPECT_EQ(c, char('a' + i));
+        }
+        while (done < kContexts)
+        {
+            coop::Yield();
+        }
+        EXPECT_EQ(intact, kContexts);
+        EXPECT_EQ(echoed, kContexts);
+    });
+}
+
+// Semaphore waiters live in the bump heap: the contexts all park for a permit, and the permits
+// come back from another thread, submitted onto the cooperator while every frame is copied out
+//
+TEST(SharedStackTest, ParkedOnSemaphore)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        constexpr int kContexts = 4;
+        coop::Semaphore slots(0);
+        int intact = 0;
+        int done = 0;
+        for (int i = 0; i < kContexts; i++)
+        {
+            co->Spawn(Shared(), [&, i](coop::Context* child)
+            {
+                intact += ParkDeep(3, i, [&] { slots.Acquire(child); });
+                done++;
+            });
+        }
+        EXPECT_EQ(co->GetSharedStackStats().savedContexts, uint64_t(kContexts - 1));
+
+        std::thread releaser([&]
+        {
+            co->Submit([&](coop::Context*) { slots.Release(kContexts); });
+        });
+        while (done < kContexts)
+        {
+            coop::Yield();
+        }
+        releaser.join();
+        EXPECT_EQ(intact, kContexts);
+    });
+}
+
+// RemoteCoordinator waiters are linked into its queue and woken by whichever thread releases it;
+// here a plain thread holds it while the shared contexts park, and each hands it on in turn
+//
+TEST(SharedStackTest, ParkedOnRemoteCoordinator)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        constexpr int kContexts = 4;
+        coop::RemoteCoordinator registry;
+        ASSERT_TRUE(registry.TryAcquire());
+        int intact = 0;
+        int done = 0;
+        for (int i = 0; i < kContexts; i++)
+        {
+            co->Spawn(Shared(), [&, i](coop::Context* child)
+            {
+                intact += ParkDeep(3, i, [&]
+                {
+                    registry.Acquire(child);
+                    registry.Release();
+                });
+                done++;
+            });
+        }
+        EXPECT_EQ(co->GetSharedStackStats().savedContexts, uint64_t(kContexts - 1));
+
+        std::thread releaser([&] { registry.Release(); });
+        releaser.join();
+        while (done < kContexts)
+        {
+            coop::Yield();
+        }
+        EXPECT_EQ(intact, kContexts);
+        EXPECT_TRUE(registry.TryAcquire());
+        registry.Release();
+    });
+}
+
+// A kill wakes a shared context parked on a kill-aware wait
+//
+TEST(SharedStackTest, KilledWhileParked)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        coop::Coordinator held(ctx);
+        coop::Context::Handle first, second;
+        int killed = 0;
+        for (auto* handle : {&first, &second})
+        {
+            co->Spawn(Shared(), [&](coop::Context* child)
+            {
+                killed += coop::CoordinateWithKill(child, &held).Killed();
+            }, handle);
+        }
+
+        first.Kill();
+        second.Kill();
+        coop::Yield();
+        EXPECT_EQ(killed, 2);
+        held.Release(ctx);
+    });
+}
+
+// A shared context spawning another hands the stack over through the loop, child first as with
+// any spawn; children spawned without a configuration get stacks of their own
+//
+TEST(SharedStackTest, ChildrenAndLimits)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        std::vector<int> order;
+        bool finished = false;
+        co->Spawn(Shared(), [&](coop::Context* parent)
+        {
+            EXPECT_FALSE(parent->CanMigrate());
+            EXPECT_LE(coop::detail::BumpHeadroom(parent), parent->m_segment.Size());
+
+            auto heap = parent->AllocateBuffer(256);
+            heap[0] = 'x';
+
+            co->Spawn(Shared(), [&](coop::Context* child)
+            {
+                order.push_back(1);
+                coop::Yield();
+                order.push_back(3);
+            });
+            order.push_back(2);
+
+            co->Spawn([&](coop::Context* child)
+            {
+                EXPECT_FALSE(child->IsSharedStack());
+                EXPECT_GE(child->m_segment.Size(), coop::s_defaultConfiguration.stackSize);
+            });
+
+            coop::Yield();
+            coop::Yield();
+            EXPECT_EQ(heap[0], 'x');
+            finished = true;
+        });
+
+        while (!finished)
+        {
+            coop::Yield();
+        }
+        EXPECT_EQ(order, std::vector<int>({1, 2, 3}));
+    });
+}
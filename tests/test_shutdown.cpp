@@ -1,17 +1,23 @@
 #include <atomic>
+#include <cerrno>
 #include <chrono>
+#include <sys/socket.h>
 #include <thread>
+#include <unistd.h>
 #include <vector>
 
 #include <gtest/gtest.h>
 
 #include "coop/cooperator.h"
+#include "coop/cooperator_configuration.h"
 #include "coop/context.h"
 #include "coop/coordinator.h"
 #include "coop/signal.h"
 #include "coop/thread.h"
 #include "coop/time/sleep.h"
 #include "coop/time/interval.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/recv.h"
 #include "test_helpers.h"
 
 // Spawn several contexts that yield in loops. Call Shutdown() and verify that the cooperator
@@ -35,7 +41,7 @@ TEST(ShutdownTest, ShutdownKillsAllContexts)
                 running->fetch_add(1, std::memory_order_relaxed);
                 while (!child->IsKilled())
                 {
-                    child->Yield(true);
+                    child->Yield();
                 }
             });
         }
@@ -45,7 +51,7 @@ TEST(ShutdownTest, ShutdownKillsAllContexts)
         //
         while (running->load(std::memory_order_relaxed) < 5)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         ctx->GetCooperator()->Shutdown();
@@ -91,6 +97,90 @@ TEST(ShutdownTest, ShutdownWithBlockedContexts)
     }, nullptr);
 }
 
+// The kill sweep fires its kills a batch at a time, letting the loop run in between, and still
+// reaches every context
+//
+TEST(ShutdownTest, KillSweepRunsInBatches)
+{
+    coop::CooperatorConfiguration config;
+    config.shutdownKillBatch = 8;
+    coop::Cooperator cooperator(config);
+
+    std::atomic<int> exited{0};
+    {
+        coop::Thread t(&cooperator);
+
+        cooperator.Submit([](coop::Context* ctx, void* arg)
+        {
+            auto* exited = static_cast<std::atomic<int>*>(arg);
+            for (int i = 0; i < 100; i++)
+            {
+                ctx->GetCooperator()->Spawn([exited](coop::Context* child)
+                {
+                    coop::time::Sleep(child, std::chrono::hours(1));
+                    exited->fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+            ctx->GetCooperator()->Shutdown();
+        }, &exited);
+    }
+
+    EXPECT_EQ(exited.load(std::memory_order_relaxed), 100);
+
+    auto stats = cooperator.GetShutdownStats();
+    EXPECT_GT(stats.startNs, 0);
+    EXPECT_GE(stats.killed, 100u);
+    EXPECT_GE(stats.batches, 100u / 8);
+    EXPECT_GE(stats.passes, 2u);
+    EXPECT_LE(stats.killNs, stats.drainNs);
+}
+
+// A recv that is not kill-aware outlives the kill sweep; the bulk cancel ends it
+//
+TEST(ShutdownTest, BulkCancelEndsWaitsThatIgnoreKill)
+{
+    coop::CooperatorConfiguration config;
+    config.shutdownBulkCancel = true;
+    coop::Cooperator cooperator(config);
+
+    struct Shared
+    {
+        int     fds[2];
+        bool    supported = false;
+        int     result = 0;
+    } shared;
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, shared.fds), 0);
+
+    {
+        coop::Thread t(&cooperator);
+
+        cooperator.Submit([](coop::Context* ctx, void* arg)
+        {
+            auto* shared = static_cast<Shared*>(arg);
+            shared->supported = ctx->GetCooperator()->GetUring()->SupportsCancelOp();
+            if (shared->supported)
+            {
+                ctx->GetCooperator()->Spawn([shared](coop::Context*)
+                {
+                    coop::io::Descriptor desc(coop::io::borrowed, shared->fds[0]);
+                    char byte;
+                    shared->result = coop::io::Recv(desc, &byte, 1);
+                });
+            }
+            ctx->GetCooperator()->Shutdown();
+        }, &shared);
+    }
+
+    close(shared.fds[0]);
+    close(shared.fds[1]);
+    if (!shared.supported)
+    {
+        GTEST_SKIP() << "IORING_ASYNC_CANCEL_OP unavailable";
+    }
+    EXPECT_EQ(shared.result, -ECANCELED);
+    EXPECT_GE(cooperator.GetShutdownStats().bulkCancelled, 1u);
+}
+
 // Call Shutdown() multiple times on the same cooperator — should not crash.
 //
 TEST(ShutdownTest, ShutdownIdempotent)
@@ -185,6 +275,78 @@ TEST(ShutdownTest, SubmitSyncReturnsFalseWhenSpawnFails)
     cooperator.Shutdown();
 }
 
+// Drain tells the hooks, waits for the last hold to go -- well inside the grace -- and then shuts
+// the cooperator down.
+//
+TEST(ShutdownTest, DrainWaitsForHolds)
+{
+    struct Hook : coop::DrainHook
+    {
+        using DrainHook::DrainHook;
+        void OnDrain() override { told = true; }
+        bool told = false;
+    };
+
+    bool told = false;
+    bool killedWhileHeld = false;
+    auto start = std::chrono::steady_clock::now();
+    {
+        coop::Cooperator cooperator;
+        coop::Thread t(&cooperator);
+
+        cooperator.Submit([&](coop::Context* ctx)
+        {
+            auto* co = ctx->GetCooperator();
+            Hook hook(co);
+            {
+                coop::DrainHold hold(co);
+                EXPECT_TRUE(co->Drain(std::chrono::seconds(30)));
+                while (!co->IsDraining())
+                {
+                    ctx->Yield();
+                }
+                told = hook.told;
+                coop::time::Sleep(ctx, std::chrono::milliseconds(20));
+                killedWhileHeld = ctx->IsKilled();
+            }
+            while (!ctx->IsKilled())
+            {
+                ctx->Yield();
+            }
+        });
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_TRUE(told);
+    EXPECT_FALSE(killedWhileHeld);
+    EXPECT_LT(elapsed, std::chrono::seconds(10));
+}
+
+// A hold that never goes is cut off by the grace: the drain shuts down regardless.
+//
+TEST(ShutdownTest, DrainGraceBoundsHolds)
+{
+    auto start = std::chrono::steady_clock::now();
+    {
+        coop::Cooperator cooperator;
+        coop::Thread t(&cooperator);
+
+        cooperator.Submit([](coop::Context* ctx)
+        {
+            coop::DrainHold hold(ctx->GetCooperator());
+            ctx->GetCooperator()->Drain(std::chrono::milliseconds(50));
+            while (!ctx->IsKilled())
+            {
+                coop::time::Sleep(ctx, std::chrono::milliseconds(5));
+            }
+        });
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_GE(elapsed, std::chrono::milliseconds(50));
+    EXPECT_LT(elapsed, std::chrono::seconds(10));
+}
+
 // Create 3 cooperators on separate threads, call ShutdownAll(), verify all exit cleanly.
 //
 TEST(ShutdownTest, ShutdownAllMultipleCooperators)
@@ -207,7 +369,7 @@ TEST(ShutdownTest, ShutdownAllMultipleCooperators)
 
             while (!ctx->IsKilled())
             {
-                ctx->Yield(true);
+                ctx->Yield();
             }
         }, &running);
     }
@@ -252,7 +414,7 @@ TEST(ShutdownTest, ShutdownAllThenReset)
         {
             while (!ctx->IsKilled())
             {
-                ctx->Yield(true);
+                ctx->Yield();
             }
         }, nullptr);
 
@@ -334,7 +496,7 @@ TEST(SleepTest, SleepReturnsFalseOnKill)
         //
         while (!completed)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(sleepResult, coop::time::SleepResult::Killed);
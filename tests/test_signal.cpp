@@ -81,7 +81,7 @@ TEST(SignalTest, KillSignalWorks)
 
             // Yield back so parent can kill us
             //
-            child->Yield(true);
+            child->Yield();
 
             // Resumed — should now be killed
             //
@@ -94,7 +94,7 @@ TEST(SignalTest, KillSignalWorks)
 
         // Yield to let child run its killed check
         //
-        ctx->Yield(true);
+        ctx->Yield();
     });
 }
 
@@ -135,7 +135,7 @@ TEST(SignalTest, CoordinateWithKillReturnsKilled)
 
             // Yield so the parent can kill us
             //
-            child->Yield(true);
+            child->Yield();
 
             auto result = coop::CoordinateWithKill(child, &coord);
             EXPECT_TRUE(result.Killed());
@@ -146,7 +146,7 @@ TEST(SignalTest, CoordinateWithKillReturnsKilled)
         }, &handle);
 
         handle.Kill();
-        ctx->Yield(true);
+        ctx->Yield();
         EXPECT_TRUE(completed);
     });
 }
@@ -183,7 +183,7 @@ TEST(SignalTest, CoordinateWithKillRepeated)
 
             // Yield so the parent can kill us before we call CoordinateWithKill
             //
-            child->Yield(true);
+            child->Yield();
             EXPECT_TRUE(child->IsKilled());
 
             // First CoordinateWithKill — signal already fired, so TryAcquire succeeds on the
@@ -205,7 +205,7 @@ TEST(SignalTest, CoordinateWithKillRepeated)
         // Kill the child, then yield to let it resume and run both CoordinateWithKill calls
         //
         handle.Kill();
-        ctx->Yield(true);
+        ctx->Yield();
 
         EXPECT_TRUE(completed);
     });
@@ -1,14 +1,22 @@
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include "coop/cooperator.h"
 #include "coop/context.h"
+#include "coop/context_var.h"
 #include "coop/coordinate_with.h"
 #include "coop/coordinator.h"
 #include "coop/launchable.h"
 #include "coop/self.h"
+#include "coop/spawn_template.h"
+#include "coop/thread.h"
 #include "test_helpers.h"
 
 TEST(SpawnTest, BasicSpawn)
@@ -34,7 +42,7 @@ TEST(SpawnTest, SpawnYield)
         {
             EXPECT_EQ(step, 0);
             step = 1;
-            child->Yield(true);
+            child->Yield();
             // Resumed
             //
             EXPECT_EQ(step, 2);
@@ -45,7 +53,7 @@ TEST(SpawnTest, SpawnYield)
         //
         EXPECT_EQ(step, 1);
         step = 2;
-        ctx->Yield(true);
+        ctx->Yield();
 
         EXPECT_EQ(step, 3);
     });
@@ -73,7 +81,7 @@ TEST(SpawnTest, KillChild)
 
             // Yield back so parent can kill us
             //
-            child->Yield(true);
+            child->Yield();
 
             // Resumed — should now be killed
             //
@@ -86,7 +94,7 @@ TEST(SpawnTest, KillChild)
 
         // Yield to let child run its killed check
         //
-        ctx->Yield(true);
+        ctx->Yield();
     });
 }
 
@@ -148,7 +156,7 @@ TEST(SpawnTest, ManyContexts)
             ctx->GetCooperator()->Spawn([&](coop::Context* child)
             {
                 count++;
-                child->Yield(true);
+                child->Yield();
                 count++;
             });
         }
@@ -158,7 +166,7 @@ TEST(SpawnTest, ManyContexts)
         //
         while (count < 200)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(count, 200);
@@ -195,7 +203,7 @@ TEST(SpawnTest, DeepNesting)
 
                 // Yield to let parent verify
                 //
-                child->Yield(true);
+                child->Yield();
             });
         };
 
@@ -223,7 +231,7 @@ TEST(SpawnTest, SpawnFromKilledContextFails)
         {
             // Yield back so parent can kill us
             //
-            child->Yield(true);
+            child->Yield();
 
             // We're now killed — try to spawn
             //
@@ -237,7 +245,7 @@ TEST(SpawnTest, SpawnFromKilledContextFails)
         }, &handle);
 
         handle.Kill();
-        ctx->Yield(true);
+        ctx->Yield();
 
         EXPECT_FALSE(spawnResult);
     });
@@ -279,7 +287,7 @@ TEST(SpawnTest, BoundaryCrossingKill)
         //
         while (!ctx->IsKilled())
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
     }, &state);
 
@@ -352,6 +360,50 @@ TEST(SpawnTest, StackPoolReuseDifferentSizes)
     });
 }
 
+// With trackStackDepth, each exit folds the context's stack high-water mark into a per-name
+// aggregate: a handler that touched 8KB of locals reports at least that, one that touched almost
+// nothing reports far less, and both stay within their segment.
+//
+TEST(SpawnTest, StackDepthTelemetry)
+{
+    coop::CooperatorConfiguration cfg = coop::s_defaultCooperatorConfiguration;
+    cfg.trackStackDepth = true;
+
+    coop::Cooperator co(cfg);
+    coop::Thread t(&co);
+
+    co.SubmitSync([](coop::Context* ctx)
+    {
+        auto* cooperator = ctx->GetCooperator();
+        coop::SpawnConfiguration config = {.priority = 0, .stackSize = 32768};
+        for (int i = 0; i < 3; i++)
+        {
+            cooperator->Spawn(config, [](coop::Context* child)
+            {
+                child->SetName("deep");
+                volatile char buf[8192];
+                for (size_t j = 0; j < sizeof(buf); j++) buf[j] = 1;
+            });
+        }
+        cooperator->Spawn(config, [](coop::Context* child) { child->SetName("shallow"); });
+
+        std::map<std::string, coop::Cooperator::StackDepth> seen;
+        cooperator->VisitStackDepths([&](const char* name, coop::Cooperator::StackDepth const& d)
+        {
+            seen[name] = d;
+        });
+
+        ASSERT_EQ(seen.count("deep"), 1u);
+        ASSERT_EQ(seen.count("shallow"), 1u);
+        EXPECT_EQ(seen["deep"].exits, 3u);
+        EXPECT_EQ(seen["deep"].stackSize, 32768u);
+        EXPECT_GE(seen["deep"].maxStackBytes, 8192u);
+        EXPECT_LT(seen["deep"].maxUsedBytes, 32768u);
+        EXPECT_LT(seen["shallow"].maxStackBytes, seen["deep"].maxStackBytes);
+    });
+    co.Shutdown();
+}
+
 TEST(SpawnTest, KillParentKillsChildren)
 {
     test::RunInCooperator([](coop::Context* ctx)
@@ -366,17 +418,17 @@ TEST(SpawnTest, KillParentKillsChildren)
             {
                 child->GetCooperator()->Spawn([&](coop::Context* grandchild)
                 {
-                    grandchild->Yield(true);
+                    grandchild->Yield();
                     grandchildKilled = grandchild->IsKilled();
                 });
 
-                child->Yield(true);
+                child->Yield();
                 childKilled = child->IsKilled();
             });
 
             // All children are yielded. Yield back so outer context can kill us.
             //
-            parent->Yield(true);
+            parent->Yield();
         }, &parentHandle);
 
         // Kill the parent — children should also be killed
@@ -387,10 +439,214 @@ TEST(SpawnTest, KillParentKillsChildren)
         //
         for (int i = 0; i < 5; i++)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_TRUE(childKilled);
         EXPECT_TRUE(grandchildKilled);
     });
 }
+
+// Producer threads race Submit into one cooperator. A small slab runs dry under the burst and
+// the big closures never fit a slot, so slab entries and heap entries share the queue; every
+// submission has to arrive exactly once.
+//
+TEST(SpawnTest, SubmitFromManyProducers)
+{
+    constexpr int PRODUCERS = 8;
+    constexpr int PER_PRODUCER = 5000;
+
+    auto config = coop::s_defaultCooperatorConfiguration;
+    config.submissionSlots = 16;
+    coop::Cooperator cooperator(config);
+    coop::Thread t(&cooperator);
+
+    std::atomic<int> small{0};
+    std::atomic<int> big{0};
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++)
+    {
+        producers.emplace_back([&cooperator, &small, &big]
+        {
+            for (int i = 0; i < PER_PRODUCER; i++)
+            {
+                if (i & 1)
+                {
+                    std::array<char, 256> padding{};
+                    padding[0] = 1;
+                    EXPECT_TRUE(cooperator.Submit([&big, padding](coop::Context*)
+                    {
+                        big.fetch_add(padding[0], std::memory_order_relaxed);
+                    }));
+                    continue;
+                }
+                EXPECT_TRUE(cooperator.Submit([&small](coop::Context*)
+                {
+                    small.fetch_add(1, std::memory_order_relaxed);
+                }));
+            }
+        });
+    }
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+
+    constexpr int HALF = PRODUCERS * PER_PRODUCER / 2;
+    while (small.load(std::memory_order_relaxed) + big.load(std::memory_order_relaxed) < 2 * HALF)
+    {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(small.load(), HALF);
+    EXPECT_EQ(big.load(), HALF);
+
+    cooperator.Shutdown();
+}
+
+// futexWake: each Submit lands on a loop that has gone back to sleep, so every one has to come
+// through the futex word (or the eventfd, on a kernel without the opcode); then a burst, and a
+// shutdown that has to end the drainer's wait
+//
+TEST(SpawnTest, SubmitWakesParkedLoopThroughFutex)
+{
+    constexpr int ROUNDS = 50;
+    constexpr int BURST = 1000;
+
+    auto config = coop::s_defaultCooperatorConfiguration;
+    config.futexWake = true;
+    coop::Cooperator cooperator(config);
+    coop::Thread t(&cooperator);
+
+    std::atomic<int> ran{0};
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        ASSERT_TRUE(cooperator.Submit([&ran](coop::Context*)
+        {
+            ran.fetch_add(1, std::memory_order_relaxed);
+        }));
+        while (ran.load(std::memory_order_relaxed) <= i)
+        {
+            std::this_thread::yield();
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    for (int i = 0; i < BURST; i++)
+    {
+        ASSERT_TRUE(cooperator.Submit([&ran](coop::Context*)
+        {
+            ran.fetch_add(1, std::memory_order_relaxed);
+        }));
+    }
+    while (ran.load(std::memory_order_relaxed) < ROUNDS + BURST)
+    {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(ran.load(), ROUNDS + BURST);
+
+    cooperator.Shutdown();
+}
+
+namespace
+{
+
+struct LazyTally
+{
+    static inline int s_constructed = 0;
+    static inline int s_destructed = 0;
+
+    LazyTally()  { s_constructed++; }
+    ~LazyTally() { s_destructed++; }
+
+    int uses{0};
+};
+
+static coop::LazyContextVar<LazyTally> s_lazyTally;
+
+} // end namespace
+
+TEST(SpawnTest, LazyContextVarConstructsOnlyWhenTouched)
+{
+    LazyTally::s_constructed = 0;
+    LazyTally::s_destructed = 0;
+
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            ctx->GetCooperator()->Spawn([i](coop::Context* child)
+            {
+                EXPECT_EQ(s_lazyTally.Peek(), nullptr);
+                if (i % 4 == 0)
+                {
+                    s_lazyTally->uses++;
+                    s_lazyTally.Get(child)->uses++;
+                    EXPECT_EQ(s_lazyTally.Peek()->uses, 2);
+                }
+            });
+        }
+        EXPECT_EQ(s_lazyTally.Peek(ctx), nullptr);
+    });
+
+    // Two of the eight children touched the slot; each of those destructs its T exactly once
+    //
+    EXPECT_EQ(LazyTally::s_constructed, 2);
+    EXPECT_EQ(LazyTally::s_destructed, 2);
+}
+
+namespace
+{
+
+struct Tally : coop::Launchable
+{
+    Tally(coop::Context* ctx, int* launched, size_t* segment)
+    : coop::Launchable(ctx)
+    , m_launched(launched)
+    , m_segment(segment)
+    {
+    }
+
+    void Launch() final
+    {
+        (*m_launched)++;
+        *m_segment = reinterpret_cast<size_t>(GetContext());
+        GetContext()->Yield();
+    }
+
+    int* m_launched;
+    size_t* m_segment;
+};
+
+} // end namespace
+
+TEST(SpawnTest, SpawnTemplateLaunchReusesSegments)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        auto* co = ctx->GetCooperator();
+        coop::SpawnTemplate<Tally> site(co, {.priority = 0, .stackSize = 20000});
+        EXPECT_EQ(site.GetConfiguration().stackSize, 32768u);
+
+        int launched = 0;
+        size_t first = 0;
+        size_t again = 0;
+        ASSERT_NE(site.Launch(&launched, &first), nullptr);
+        ctx->Yield();
+        ctx->Yield();
+
+        // The first context has exited: its segment is the top of the class's free list
+        //
+        auto before = co->GetStackPoolStats();
+        coop::Context::Handle handle;
+        ASSERT_NE(site.Launch(&handle, &launched, &again), nullptr);
+        EXPECT_EQ(co->GetStackPoolStats().hits, before.hits + 1);
+        EXPECT_TRUE(handle);
+        ctx->Yield();
+        ctx->Yield();
+
+        EXPECT_EQ(launched, 2);
+        EXPECT_NE(first, 0u);
+        EXPECT_EQ(first, again);
+    });
+}
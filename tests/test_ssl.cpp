@@ -0,0 +1,1097 @@
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <csignal>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/memory_accounting.h"
+#include "coop/self.h"
+#include "coop/thread.h"
+#include "coop/io/descriptor.h"
+#include "coop/io/ssl/ssl.h"
+#include "coop/time/sleep.h"
+#include "coop/work/grid.h"
+
+#include "test_helpers.h"
+
+using namespace coop;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+
+// A self-signed P-256 certificate for localhost, made once per run so the tests need no files
+//
+struct TestCert
+{
+    std::string cert;
+    std::string key;
+};
+
+TestCert const& Cert()
+{
+    static TestCert const s_cert = []
+    {
+        EVP_PKEY* key = EVP_EC_gen("P-256");
+        X509* x509 = X509_new();
+        ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+        X509_gmtime_adj(X509_getm_notBefore(x509), 0);
+        X509_gmtime_adj(X509_getm_notAfter(x509), 3600);
+        X509_set_pubkey(x509, key);
+        X509_NAME* name = X509_get_subject_name(x509);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(x509, name);
+        X509_sign(x509, key, EVP_sha256());
+
+        auto pem = [](auto write)
+        {
+            BIO* bio = BIO_new(BIO_s_mem());
+            write(bio);
+            char* data;
+            long n = BIO_get_mem_data(bio, &data);
+            std::string out(data, static_cast<size_t>(n));
+            BIO_free(bio);
+            return out;
+        };
+        TestCert made{
+            pem([&](BIO* bio) { PEM_write_bio_X509(bio, x509); }),
+            pem([&](BIO* bio)
+            {
+                PEM_write_bio_PrivateKey(bio, key, nullptr, nullptr, 0, nullptr, nullptr);
+            })};
+        X509_free(x509);
+        EVP_PKEY_free(key);
+        return made;
+    }();
+    return s_cert;
+}
+
+// Handshake steps the server took off the cooperator its connection runs on, counted from
+// OpenSSL's info callback, which runs wherever SSL_do_handshake does
+//
+std::atomic<Cooperator*> s_serverCooperator{nullptr};
+std::atomic<int>         s_stepsAway{0};
+
+void CountSteps(const SSL*, int where, int)
+{
+    if ((where & SSL_CB_LOOP) && Cooperator::thread_cooperator != s_serverCooperator.load())
+    {
+        s_stepsAway.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+template<typename Pred>
+bool WaitFor(Pred pred)
+{
+    const auto deadline = Clock::now() + std::chrono::seconds(10);
+    while (!pred() && Clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return pred();
+}
+
+// A TLS handshake and a four-byte echo over a socketpair: the server on server, the client on
+// client. With hold set, a context on the server's cooperator spins whenever its shard has work,
+// so an offloaded step can only be taken by a peer's stealer. Returns true when both ends
+// handshook and the echo came back; s_stepsAway then says where the server's steps ran.
+//
+bool Echo(Cooperator* server, Cooperator* client, bool offload, work::Grid* hold = nullptr)
+{
+    io::ssl::Context serverTls(io::ssl::Mode::Server);
+    io::ssl::Context clientTls(io::ssl::Mode::Client);
+    TestCert const& cert = Cert();
+    if (!serverTls.LoadCertificate(cert.cert.data(), cert.cert.size()) ||
+        !serverTls.LoadPrivateKey(cert.key.data(), cert.key.size()))
+    {
+        return false;
+    }
+    serverTls.OffloadHandshakes(offload);
+    SSL_CTX_set_info_callback(serverTls.m_ctx, CountSteps);
+    s_serverCooperator.store(server);
+    s_stepsAway.store(0);
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        return false;
+    }
+
+    std::atomic<bool> serverOk{false}, serverDone{false};
+    std::atomic<bool> clientOk{false}, clientDone{false};
+    std::atomic<bool> holdDone{hold == nullptr};
+    if (hold)
+    {
+        server->Submit([&](Context* ctx)
+        {
+            work::Participation* p = ctx->GetCooperator()->m_participation;
+            while (!serverDone.load())
+            {
+                // Until the peer's stealer has taken the step -- or, past the deadline, ours may
+                //
+                const auto deadline = Clock::now() + std::chrono::seconds(2);
+                while (p && hold->Depth(p->shard) > 0 && Clock::now() < deadline);
+                ctx->Yield();
+            }
+            holdDone = true;
+        });
+    }
+    server->Submit([&](Context*)
+    {
+        {
+            io::Descriptor desc(fds[0]);
+            io::ssl::Connection conn(serverTls, desc);
+            char buf[16];
+            int n = conn.Handshake() == 0 ? io::ssl::Recv(conn, buf, sizeof(buf)) : -1;
+            serverOk = n == 4 && io::ssl::SendAll(conn, buf, n) == n;
+        }
+        serverDone = true;
+    });
+    client->Submit([&](Context*)
+    {
+        {
+            io::Descriptor desc(fds[1]);
+            io::ssl::Connection conn(clientTls, desc);
+            char buf[16] = {};
+            clientOk = conn.Handshake() == 0 && io::ssl::SendAll(conn, "ping", 4) == 4 &&
+                       io::ssl::Recv(conn, buf, sizeof(buf)) == 4 && memcmp(buf, "ping", 4) == 0;
+        }
+        clientDone = true;
+    });
+
+    bool done = WaitFor([&] { return serverDone && clientDone && holdDone; });
+    return done && serverOk.load() && clientOk.load();
+}
+
+bool LoadCert(io::ssl::Context& tls)
+{
+    TestCert const& cert = Cert();
+    return tls.LoadCertificate(cert.cert.data(), cert.cert.size()) &&
+           tls.LoadPrivateKey(cert.key.data(), cert.key.size());
+}
+
+// A connected loopback TCP pair, for kTLS, which AF_UNIX cannot carry
+//
+bool TcpPair(int fds[2])
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bool ok = listener >= 0 &&
+              bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+              listen(listener, 1) == 0 &&
+              getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len) == 0;
+    fds[0] = fds[1] = -1;
+    if (ok)
+    {
+        fds[1] = socket(AF_INET, SOCK_STREAM, 0);
+        ok = fds[1] >= 0 && connect(fds[1], reinterpret_cast<sockaddr*>(&addr), len) == 0 &&
+             (fds[0] = accept(listener, nullptr, nullptr)) >= 0;
+    }
+    if (listener >= 0)
+    {
+        close(listener);
+    }
+    return ok;
+}
+
+// Handshake a server end on fds[0] and a client end on fds[1], each on its own cooperator, then
+// run serverFn and clientFn on the connections there. True when both ends handshook and both
+// functions returned true.
+//
+template<typename ServerFn, typename ClientFn>
+bool Connected(Cooperator* server, Cooperator* client, io::ssl::Context& serverTls,
+               io::ssl::Context& clientTls, int fds[2], bool socketBio, ServerFn serverFn,
+               ClientFn clientFn)
+{
+    std::atomic<bool> serverOk{false}, serverDone{false};
+    std::atomic<bool> clientOk{false}, clientDone{false};
+    auto run = [&](Cooperator* co, io::ssl::Context& tls, int fd, auto& fn, auto& ok, auto& done)
+    {
+        co->Submit([&, fd](Context*)
+        {
+            {
+                io::Descriptor desc(fd);
+                auto conn = socketBio ? std::make_unique<io::ssl::Connection>(tls, desc,
+                                                                              io::ssl::SocketBio{})
+                                      : std::make_unique<io::ssl::Connection>(tls, desc);
+                ok = conn->Handshake() == 0 && fn(*conn);
+            }
+            done = true;
+        });
+    };
+    run(server, serverTls, fds[0], serverFn, serverOk, serverDone);
+    run(client, clientTls, fds[1], clientFn, clientOk, clientDone);
+
+    bool done = WaitFor([&] { return serverDone && clientDone; });
+    return done && serverOk.load() && clientOk.load();
+}
+
+// Application data record lengths the server read, from OpenSSL's message callback, counted
+// once s_countRecords is set
+//
+std::atomic<bool>   s_countRecords{false};
+std::vector<size_t> s_records;
+
+void CountRecords(int write, int, int type, const void* buf, size_t len, SSL*, void*)
+{
+    auto* header = static_cast<const unsigned char*>(buf);
+    if (!write && type == SSL3_RT_HEADER && len == 5 && s_countRecords.load() &&
+        header[0] == SSL3_RT_APPLICATION_DATA)
+    {
+        s_records.push_back(size_t(header[3]) << 8 | header[4]);
+    }
+}
+
+// The peer's end goes away right after the handshake: a send then fails with the socket's errno,
+// and a memory BIO recv with nothing left before the close reports -ECONNRESET (no close_notify
+// came)
+//
+void PeerClosed(bool socketBio)
+{
+    std::signal(SIGPIPE, SIG_IGN);
+    Cooperator server, client;
+    Thread serverThread(&server), clientThread(&client);
+
+    io::ssl::Context serverTls(io::ssl::Mode::Server);
+    io::ssl::Context clientTls(io::ssl::Mode::Client);
+    ASSERT_TRUE(LoadCert(serverTls));
+    if (socketBio)
+    {
+        serverTls.EnableKTLS();
+        clientTls.EnableKTLS();
+    }
+
+    int fds[2];
+    if (socketBio)
+    {
+        ASSERT_TRUE(TcpPair(fds));
+    }
+    else
+    {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    }
+    std::atomic<int> sent{1}, received{1};
+
+    EXPECT_TRUE(Connected(&server, &client, serverTls, clientTls, fds, socketBio,
+        [&](io::ssl::Connection&) { return true; },
+        [&](io::ssl::Connection& conn)
+        {
+            // The first sends after the close may still land in the socket buffer
+            //
+            int r = 1;
+            for (int i = 0; i < 1000 && r > 0; i++)
+            {
+                r = io::ssl::Send(conn, "x", 1);
+                time::Sleep(std::chrono::milliseconds(1));
+            }
+            sent = r;
+
+            char buf[16];
+            while ((r = io::ssl::Recv(conn, buf, sizeof(buf))) > 0);
+            received = r;
+            return true;
+        }));
+
+    // Which of the two the send sees depends on whether the reset beat it. With the error
+    // already reported there, a socket BIO's read finds a bare EOF: 0 from kTLS, which cannot
+    // tell, an unexpected-EOF -EPROTO from OpenSSL.
+    //
+    EXPECT_TRUE(sent == -EPIPE || sent == -ECONNRESET) << sent;
+    if (socketBio)
+    {
+        EXPECT_TRUE(received == -ECONNRESET || received == -EPROTO || received == 0) << received;
+    }
+    else
+    {
+        EXPECT_EQ(received.load(), -ECONNRESET);
+    }
+
+    server.Shutdown();
+    client.Shutdown();
+}
+
+// Neither end ever sees EAGAIN: a recv with nothing buffered parks until the data lands, and a
+// send into a full socket buffer parks until the peer drains it
+//
+void WouldBlock(bool socketBio)
+{
+    Cooperator server, client;
+    Thread serverThread(&server), clientThread(&client);
+
+    io::ssl::Context serverTls(io::ssl::Mode::Server);
+    io::ssl::Context clientTls(io::ssl::Mode::Client);
+    ASSERT_TRUE(LoadCert(serverTls));
+    if (socketBio)
+    {
+        serverTls.EnableKTLS();
+        clientTls.EnableKTLS();
+    }
+
+    int fds[2];
+    if (socketBio)
+    {
+        ASSERT_TRUE(TcpPair(fds));
+    }
+    else
+    {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    }
+    std::string bulk(4 << 20, 0);
+    for (size_t i = 0; i < bulk.size(); i++)
+    {
+        bulk[i] = char(i * 7);
+    }
+
+    EXPECT_TRUE(Connected(&server, &client, serverTls, clientTls, fds, socketBio,
+        [&](io::ssl::Connection& conn)
+        {
+            char ping[4];
+            if (io::ssl::Recv(conn, ping, sizeof(ping)) != 4 || memcmp(ping, "ping", 4) != 0)
+            {
+                return false;
+            }
+
+            time::Sleep(std::chrono::milliseconds(50));
+            std::string got(bulk.size(), 0);
+            size_t done = 0;
+            while (done < got.size())
+            {
+                int n = io::ssl::Recv(conn, got.data() + done, got.size() - done);
+                if (n <= 0)
+                {
+                    return false;
+                }
+                done += size_t(n);
+            }
+            return got == bulk;
+        },
+        [&](io::ssl::Connection& conn)
+        {
+            time::Sleep(std::chrono::milliseconds(20));
+            return io::ssl::SendAll(conn, "ping", 4) == 4 &&
+                   io::ssl::SendAll(conn, bulk.data(), bulk.size()) == int(bulk.size());
+        }));
+
+    server.Shutdown();
+    client.Shutdown();
+}
+
+// A resumable session with a one-byte id, made age seconds ago and good for lifetime
+//
+SSL_SESSION* Session(unsigned char id, long age = 0, long lifetime = 300)
+{
+    SSL_SESSION* session = SSL_SESSION_new();
+    if (!SSL_SESSION_set1_id(session, &id, 1) ||
+        !SSL_SESSION_set_time(session, static_cast<long>(::time(nullptr)) - age) ||
+        !SSL_SESSION_set_timeout(session, lifetime))
+    {
+        SSL_SESSION_free(session);
+        return nullptr;
+    }
+    return session;
+}
+
+} // end anonymous namespace
+
+// An offloaded handshake step stolen by a peer hands back to the connection's cooperator through
+// Cooperate; the connection completes there and then carries data
+//
+TEST(SslTest, OffloadedHandshakeOnPeer)
+{
+    Cooperator server, peer, client;
+    work::Grid grid;
+    Thread serverThread(&server), peerThread(&peer), clientThread(&client);
+
+    // Timer rechecks only, so the peer's stealer finds the step without a wake
+    //
+    grid.Init(2, std::chrono::microseconds(10), std::chrono::microseconds(200), 8, 0);
+    grid.Join(&server);
+    grid.Join(&peer);
+    EXPECT_TRUE(WaitFor([&] { return grid.Members() == 2; }));
+
+    EXPECT_TRUE(Echo(&server, &client, true, &grid));
+    EXPECT_GT(s_stepsAway.load(), 0) << "a peer took at least one handshake step";
+
+    server.Shutdown();
+    peer.Shutdown();
+    client.Shutdown();
+}
+
+// On a sole member its own stealer takes the steps, and releases the connection directly
+//
+TEST(SslTest, OffloadedHandshakeOnOrigin)
+{
+    Cooperator server, client;
+    work::Grid grid;
+    Thread serverThread(&server), clientThread(&client);
+
+    grid.Init(1);
+    grid.Join(&server);
+    EXPECT_TRUE(WaitFor([&] { return grid.Members() == 1; }));
+
+    EXPECT_TRUE(Echo(&server, &client, true));
+    EXPECT_EQ(s_stepsAway.load(), 0);
+
+    server.Shutdown();
+    client.Shutdown();
+}
+
+// Off a grid, an offloading context handshakes inline
+//
+TEST(SslTest, OffloadedHandshakeWithoutGrid)
+{
+    Cooperator server, client;
+    Thread serverThread(&server), clientThread(&client);
+
+    EXPECT_TRUE(Echo(&server, &client, true));
+    EXPECT_EQ(s_stepsAway.load(), 0);
+
+    server.Shutdown();
+    client.Shutdown();
+}
+
+// Past capacity the least recently used session goes; a Find counts as a use
+//
+TEST(SslTest, SessionCacheEvictsLeastRecentlyUsed)
+{
+    io::ssl::SessionCache cache(2);
+    SSL_SESSION* a = Session(1);
+    SSL_SESSION* b = Session(2);
+    SSL_SESSION* c = Session(3);
+    cache.Insert("a", a);
+    cache.Insert("b", b);
+    EXPECT_EQ(cache.Find("a"), a);
+
+    cache.Insert("c", c);
+    EXPECT_EQ(cache.Size(), 2u);
+    EXPECT_EQ(cache.Find("b"), nullptr);
+    EXPECT_EQ(cache.Find("a"), a);
+    EXPECT_EQ(cache.Find("c"), c);
+}
+
+// A key keeps its PER_KEY newest sessions, and hands them out newest first
+//
+TEST(SslTest, SessionCacheCapsSessionsPerKey)
+{
+    io::ssl::SessionCache cache(64);
+    std::vector<SSL_SESSION*> sessions;
+    for (size_t i = 0; i <= io::ssl::SessionCache::PER_KEY; i++)
+    {
+        sessions.push_back(Session(static_cast<unsigned char>(i)));
+        cache.Insert("k", sessions.back());
+    }
+    cache.Insert("other", Session(100));
+    EXPECT_EQ(cache.Size(), io::ssl::SessionCache::PER_KEY + 1);
+
+    for (size_t i = io::ssl::SessionCache::PER_KEY; i > 0; i--)
+    {
+        SSL_SESSION* taken = cache.Take("k");
+        EXPECT_EQ(taken, sessions[i]);
+        SSL_SESSION_free(taken);
+    }
+    EXPECT_EQ(cache.Take("k"), nullptr) << "the oldest went at the cap";
+    EXPECT_NE(cache.Find("other"), nullptr);
+}
+
+// Expired sessions are dropped as a lookup finds them, falling back to the key's older live one
+//
+TEST(SslTest, SessionCacheDropsExpired)
+{
+    io::ssl::SessionCache cache(8);
+    SSL_SESSION* live = Session(1);
+    cache.Insert("k", live);
+    cache.Insert("k", Session(2, 600, 60));
+    cache.Insert("gone", Session(3, 600, 60));
+    EXPECT_EQ(cache.Size(), 3u);
+
+    EXPECT_EQ(cache.Find("k"), live);
+    EXPECT_EQ(cache.Find("gone"), nullptr);
+    EXPECT_EQ(cache.Size(), 1u);
+}
+
+// Take passes the reference to the caller and leaves the key's other sessions; Erase drops them
+// all and leaves other keys alone
+//
+TEST(SslTest, SessionCacheTakeAndErase)
+{
+    io::ssl::SessionCache cache(8);
+    SSL_SESSION* older = Session(1);
+    SSL_SESSION* newer = Session(2);
+    SSL_SESSION* kept = Session(3);
+    cache.Insert("k", older);
+    cache.Insert("k", newer);
+    cache.Insert("kept", kept);
+
+    SSL_SESSION* taken = cache.Take("k");
+    EXPECT_EQ(taken, newer);
+    EXPECT_EQ(cache.Size(), 2u);
+    SSL_SESSION_free(taken);
+    EXPECT_EQ(cache.Find("k"), older);
+
+    cache.Insert("k", Session(4));
+    cache.Erase("k");
+    EXPECT_EQ(cache.Find("k"), nullptr);
+    EXPECT_EQ(cache.Take("k"), nullptr);
+    EXPECT_EQ(cache.Size(), 1u);
+    EXPECT_EQ(cache.Find("kept"), kept);
+    cache.Erase("missing");
+    EXPECT_EQ(cache.Size(), 1u);
+}
+
+// A rotation puts a fresh key first and keeps the previous ones up to keep, dropping the oldest
+//
+TEST(SslTest, TicketKeysRotate)
+{
+    test::RunInCooperator([](Context*)
+    {
+        io::ssl::TicketKeys keys(2);
+        EXPECT_EQ(keys.Generation(), 0u);
+        ASSERT_EQ(keys.Local().size(), 1u);
+        io::ssl::TicketKeys::Key first = keys.Local()[0];
+
+        ASSERT_TRUE(keys.Rotate());
+        EXPECT_EQ(keys.Generation(), 1u);
+        ASSERT_EQ(keys.Local().size(), 2u);
+        io::ssl::TicketKeys::Key second = keys.Local()[0];
+        EXPECT_NE(memcmp(second.name, first.name, sizeof(first.name)), 0);
+        EXPECT_EQ(memcmp(keys.Local()[1].name, first.name, sizeof(first.name)), 0);
+
+        ASSERT_TRUE(keys.Rotate());
+        ASSERT_EQ(keys.Local().size(), 2u);
+        EXPECT_EQ(memcmp(keys.Local()[1].name, second.name, sizeof(second.name)), 0);
+        for (auto const& key : keys.Local())
+        {
+            EXPECT_NE(memcmp(key.name, first.name, sizeof(first.name)), 0) << "retired";
+        }
+    });
+}
+
+// Each cooperator reads its own copy of the keys, refreshed the next time it looks after a
+// rotation made on any thread
+//
+TEST(SslTest, TicketKeysCopiedPerCooperator)
+{
+    io::ssl::TicketKeys keys(2);
+    Cooperator one, two;
+    Thread oneThread(&one), twoThread(&two);
+
+    auto look = [&](Cooperator* co)
+    {
+        std::vector<io::ssl::TicketKeys::Key> const* local = nullptr;
+        std::vector<io::ssl::TicketKeys::Key> copy;
+        co->SubmitSync([&](Context*)
+        {
+            local = &keys.Local();
+            copy = *local;
+        });
+        return std::make_pair(local, copy);
+    };
+
+    auto [oneLocal, oneKeys] = look(&one);
+    auto [twoLocal, twoKeys] = look(&two);
+    EXPECT_NE(oneLocal, twoLocal);
+    ASSERT_EQ(oneKeys.size(), 1u);
+    ASSERT_EQ(twoKeys.size(), 1u);
+    EXPECT_EQ(memcmp(oneKeys[0].name, twoKeys[0].name, sizeof(oneKeys[0].name)), 0);
+
+    std::thread rotator([&] { EXPECT_TRUE(keys.Rotate()); });
+    rotator.join();
+
+    for (auto* co : {&one, &two})
+    {
+        auto [local, now] = look(co);
+        EXPECT_EQ(local, co == &one ? oneLocal : twoLocal) << "the same copy, refreshed";
+        ASSERT_EQ(now.size(), 2u);
+        EXPECT_EQ(memcmp(now[1].name, oneKeys[0].name, sizeof(now[1].name)), 0);
+        EXPECT_NE(memcmp(now[0].name, oneKeys[0].name, sizeof(now[0].name)), 0);
+    }
+
+    one.Shutdown();
+    two.Shutdown();
+}
+
+// The first smallBytes of a connection go out in small records, a write at a time; a write past
+// the budget makes full records, and sizing off never limits
+//
+TEST(SslTest, RecordLimitSplitsFirstBytes)
+{
+    test::RunInCooperator([](Context*)
+    {
+        io::ssl::Context tls(io::ssl::Mode::Client);
+        tls.SetRecordSizing(1000, 2500);
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        io::Descriptor desc(fds[0]), peer(fds[1]);
+        io::ssl::Connection conn(tls, desc);
+
+        EXPECT_EQ(conn.RecordLimit(), 1000u);
+        conn.Wrote(1000);
+        EXPECT_EQ(conn.RecordLimit(), 1000u);
+        conn.Wrote(1000);
+        EXPECT_EQ(conn.RecordLimit(), 1000u) << "500 left, still a small record";
+        conn.Wrote(4000);
+        EXPECT_EQ(conn.RecordLimit(), SIZE_MAX) << "budget spent";
+        conn.Wrote(16384);
+        EXPECT_EQ(conn.RecordLimit(), SIZE_MAX);
+
+        io::ssl::Context off(io::ssl::Mode::Client);
+        off.SetRecordSizing(0);
+        io::ssl::Connection unsized(off, desc);
+        EXPECT_EQ(unsized.RecordLimit(), SIZE_MAX);
+    });
+}
+
+// An idle spell starts the small-record budget over; writes closer together than idle do not
+//
+TEST(SslTest, RecordLimitResetsAfterIdle)
+{
+    test::RunInCooperator([](Context* ctx)
+    {
+        io::ssl::Context tls(io::ssl::Mode::Client);
+        tls.SetRecordSizing(1000, 1000, std::chrono::milliseconds(50));
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        io::Descriptor desc(fds[0]), peer(fds[1]);
+        io::ssl::Connection conn(tls, desc);
+
+        EXPECT_EQ(conn.RecordLimit(), 1000u);
+        conn.Wrote(1000);
+        time::Sleep(ctx, std::chrono::milliseconds(5));
+        EXPECT_EQ(conn.RecordLimit(), SIZE_MAX);
+
+        time::Sleep(ctx, std::chrono::milliseconds(120));
+        EXPECT_EQ(conn.RecordLimit(), 1000u) << "small records again after idle";
+        conn.Wrote(1000);
+        EXPECT_EQ(conn.RecordLimit(), SIZE_MAX);
+    });
+}
+
+// On the wire: a client's first bytes arrive as budget-many small records, the rest as one
+//
+TEST(SslTest, RecordSizingOnTheWire)
+{
+    Cooperator server, client;
+    Thread serverThread(&server), clientThread(&client);
+
+    io::ssl::Context serverTls(io::ssl::Mode::Server);
+    io::ssl::Context clientTls(io::ssl::Mode::Client);
+    ASSERT_TRUE(LoadCert(serverTls));
+    clientTls.SetRecordSizing(1000, 3000);
+    SSL_CTX_set_msg_callback(serverTls.m_ctx, CountRecords);
+    s_records.clear();
+    s_countRecords = false;
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    constexpr size_t kSize = 8000;
+    std::string sent(kSize, 0);
+    for (size_t i = 0; i < kSize; i++)
+    {
+        sent[i] = char('a' + i % 26);
+    }
+
+    EXPECT_TRUE(Connected(&server, &client, serverTls, clientTls, fds, false,
+        [&](io::ssl::Connection& conn)
+        {
+            s_countRecords = true;
+            std::string got(kSize, 0);
+            size_t done = 0;
+            while (done < kSize)
+            {
+                int n = io::ssl::Recv(conn, got.data() + done, kSize - done);
+                if (n <= 0)
+                {
+                    return false;
+                }
+                done += size_t(n);
+            }
+            return got == sent;
+        },
+        [&](io::ssl::Connection& conn)
+        {
+            return io::ssl::SendAll(conn, sent.data(), kSize) == int(kSize);
+        }));
+
+    // A record's length covers its AEAD tag and inner type too
+    //
+    ASSERT_EQ(s_records.size(), 4u);
+    for (size_t i = 0; i < 3; i++)
+    {
+        EXPECT_GT(s_records[i], 1000u);
+        EXPECT_LE(s_records[i], 1064u);
+    }
+    EXPECT_GT(s_records[3], 5000u);
+
+    server.Shutdown();
+    client.Shutdown();
+}
+
+// Without kTLS underneath, the kernel cannot be told to cut records: the connection says so once
+// and splits the writes itself from then on
+//
+TEST(SslTest, KernelRecordLimitFallsBack)
+{
+    test::RunInCooperator([](Context*)
+    {
+        io::ssl::Context tls(io::ssl::Mode::Client);
+        tls.SetRecordSizing(1000, 3000);
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        io::Descriptor desc(fds[0]), peer(fds[1]);
+        io::ssl::Connection conn(tls, desc);
+
+        conn.m_ktlsTx = true;
+        EXPECT_EQ(conn.RecordLimit(), 1000u);
+        conn.Wrote(1000);
+        EXPECT_EQ(conn.RecordLimit(), 1000u);
+        conn.Wrote(2000);
+        EXPECT_EQ(conn.RecordLimit(), SIZE_MAX);
+        conn.m_ktlsTx = false;
+    });
+}
+
+// With kTLS TX the kernel cuts the small records where it can, so one write may carry the whole
+// budget; else a record's worth goes per write. Either way data flows, and full records follow.
+//
+TEST(SslTest, KernelRecordLimit)
+{
+    Cooperator server, client;
+    Thread serverThread(&server), clientThread(&client);
+
+    io::ssl::Context serverTls(io::ssl::Mode::Server);
+    io::ssl::Context clientTls(io::ssl::Mode::Client);
+    ASSERT_TRUE(LoadCert(serverTls));
+    serverTls.EnableKTLS();
+    clientTls.EnableKTLS();
+    clientTls.SetRecordSizing(1000, 3000);
+
+    int fds[2];
+    ASSERT_TRUE(TcpPair(fds));
+    std::atomic<bool> ktls{false};
+    std::atomic<size_t> first{0}, spent{0};
+    std::string sent(6000, 'x');
+
+    EXPECT_TRUE(Connected(&server, &client, serverTls, clientTls, fds, true,
+        [&](io::ssl::Connection& conn)
+        {
+            std::string got(sent.size(), 0);
+            size_t done = 0;
+            while (done < got.size())
+            {
+                int n = io::ssl::Recv(conn, got.data() + done, got.size() - done);
+                if (n <= 0)
+                {
+                    return false;
+                }
+                done += size_t(n);
+            }
+            return got == sent;
+        },
+        [&](io::ssl::Connection& conn)
+        {
+            ktls = conn.m_ktlsTx;
+            first = conn.RecordLimit();
+            conn.Wrote(3000);
+            spent = conn.RecordLimit();
+            return io::ssl::SendAll(conn, sent.data(), sent.size()) == int(sent.size());
+        }));
+
+    server.Shutdown();
+    client.Shutdown();
+    if (!ktls)
+    {
+        GTEST_SKIP() << "kTLS TX unavailable (tls module not loaded?)";
+    }
+    EXPECT_TRUE(first == 3000u || first == 1000u) << first;
+    EXPECT_EQ(spent.load(), SIZE_MAX);
+}
+
+// Control records kTLS RX hands over: close_notify ends the connection cleanly, any other alert
+// or record type fails it, session tickets are dropped even split across records, and any other
+// handshake message -- or a KeyUpdate with no traffic secret to step -- fails it
+//
+TEST(SslTest, KtlsControlRecords)
+{
+    test::RunInCooperator([](Context*)
+    {
+        io::ssl::Context tls(io::ssl::Mode::Client);
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        io::Descriptor desc(fds[0]), peer(fds[1]);
+        constexpr uint8_t kAlert = 21, kHandshake = 22, kChangeCipherSpec = 20;
+
+        {
+            io::ssl::Connection conn(tls, desc);
+            EXPECT_EQ(conn.KtlsControl(kAlert, "\x01\x00", 2, false), 0);
+            EXPECT_EQ(conn.KtlsControl(kAlert, "\x02\x28", 2, false), -1);
+            EXPECT_EQ(conn.KtlsControl(kAlert, "\x01", 1, false), -1);
+            EXPECT_EQ(conn.KtlsControl(kChangeCipherSpec, "\x01", 1, false), -1);
+        }
+        {
+            io::ssl::Connection conn(tls, desc);
+            const char ticket[] = "\x04\x00\x00\x03" "abc";
+            EXPECT_EQ(conn.KtlsControl(kHandshake, ticket, 2, false), 1);
+            EXPECT_EQ(conn.KtlsControl(kHandshake, ticket + 2, 5, false), 1);
+
+            std::string two = std::string(ticket, 7) + std::string(ticket, 7);
+            EXPECT_EQ(conn.KtlsControl(kHandshake, two.data(), two.size(), false), 1);
+
+            EXPECT_EQ(conn.KtlsControl(kHandshake, "\x02\x00\x00\x00", 4, false), -1);
+        }
+        {
+            io::ssl::Connection conn(tls, desc);
+            EXPECT_EQ(conn.KtlsControl(kHandshake, "\x18\x00\x00\x01\x00", 5, false), -1);
+        }
+        {
+            io::ssl::Connection conn(tls, desc);
+            EXPECT_EQ(conn.KtlsControl(kHandshake, "\x04\x02\x00\x00", 4, false), -1)
+                << "a message past 64KB";
+        }
+    });
+}
+
+// Over kTLS RX the server's session tickets reach the client as handshake records: a plain recv
+// fails with EIO on them, the recvmsg fallback drops them and returns the data behind, and the
+// server's close_notify comes through the same way as a clean end
+//
+TEST(SslTest, KtlsRxFallsBackOnControlRecords)
+{
+    Cooperator server, client;
+    Thread serverThread(&server), clientThread(&client);
+
+    io::ssl::Context serverTls(io::ssl::Mode::Server);
+    io::ssl::Context clientTls(io::ssl::Mode::Client);
+    ASSERT_TRUE(LoadCert(serverTls));
+    serverTls.EnableKTLS();
+    clientTls.EnableKTLS();
+
+    int fds[2];
+    ASSERT_TRUE(TcpPair(fds));
+    std::atomic<bool> ktls{false}, read{false};
+
+    EXPECT_TRUE(Connected(&server, &client, serverTls, clientTls, fds, true,
+        [&](io::ssl::Connection& conn)
+        {
+            bool ok = io::ssl::SendAll(conn, "pong", 4) == 4 && SSL_shutdown(conn.m_ssl) >= 0;
+            while (!read)
+            {
+                coop::Yield();
+            }
+            return ok;
+        },
+        [&](io::ssl::Connection& conn)
+        {
+            ktls = conn.m_ktlsRx;
+            char buf[16] = {};
+            size_t got = 0;
+            int n;
+            while (got < 4 && (n = io::ssl::Recv(conn, buf + got, sizeof(buf) - got)) > 0)
+            {
+                got += size_t(n);
+            }
+            bool ok = got == 4 && memcmp(buf, "pong", 4) == 0 &&
+                      io::ssl::Recv(conn, buf, sizeof(buf)) == 0;
+            read = true;
+            return ok;
+        }));
+
+    server.Shutdown();
+    client.Shutdown();
+    if (!ktls)
+    {
+        GTEST_SKIP() << "kTLS RX unavailable (tls module not loaded?)";
+    }
+}
+
+// Send and Recv report errors as negative errnos, and never surface a would-block
+//
+TEST(SslTest, PeerClosedMemoryBio)
+{
+    PeerClosed(false);
+}
+
+TEST(SslTest, PeerClosedSocketBio)
+{
+    PeerClosed(true);
+}
+
+TEST(SslTest, WouldBlockMemoryBio)
+{
+    WouldBlock(false);
+}
+
+TEST(SslTest, WouldBlockSocketBio)
+{
+    WouldBlock(true);
+}
+
+// Pooled connections parked on a recv hold no staging buffer: the cooperator's pool stays at the
+// few one borrow at a time needs, not one per connection
+//
+TEST(SslTest, StagingReturnedWhileParked)
+{
+    Cooperator server, client;
+    Thread serverThread(&server), clientThread(&client);
+
+    io::ssl::Context serverTls(io::ssl::Mode::Server);
+    io::ssl::Context clientTls(io::ssl::Mode::Client);
+    ASSERT_TRUE(LoadCert(serverTls));
+
+    constexpr int kConnections = 16;
+    std::atomic<int> parked{0}, echoed{0}, finished{0};
+    std::atomic<bool> go{false};
+    for (int i = 0; i < kConnections; i++)
+    {
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        server.Submit([&, fd = fds[0]](Context*)
+        {
+            {
+                io::Descriptor desc(fd);
+                io::ssl::Connection conn(serverTls, desc);
+                char buf[16];
+                if (conn.Handshake() == 0)
+                {
+                    parked++;
+                    int n = io::ssl::Recv(conn, buf, sizeof(buf));
+                    echoed += n == 4 && io::ssl::SendAll(conn, buf, 4) == 4;
+                }
+            }
+            finished++;
+        });
+        client.Submit([&, fd = fds[1]](Context*)
+        {
+            {
+                io::Descriptor desc(fd);
+                io::ssl::Connection conn(clientTls, desc);
+                char buf[16];
+                if (conn.Handshake() == 0)
+                {
+                    while (!go)
+                    {
+                        time::Sleep(std::chrono::milliseconds(1));
+                    }
+                    if (io::ssl::SendAll(conn, "ping", 4) == 4)
+                    {
+                        io::ssl::Recv(conn, buf, sizeof(buf));
+                    }
+                }
+            }
+            finished++;
+        });
+    }
+
+    ASSERT_TRUE(WaitFor([&] { return parked == kConnections; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    auto staging = GetTaggedMemory(MemoryTag::TlsStaging, &server);
+    EXPECT_LT(staging.objects, kConnections);
+    EXPECT_EQ(staging.bytes, staging.objects * int64_t(io::ssl::Connection::BUFFER_SIZE));
+
+    go = true;
+    EXPECT_TRUE(WaitFor([&] { return finished == 2 * kConnections; }));
+    EXPECT_EQ(echoed.load(), kConnections);
+
+    server.Shutdown();
+    client.Shutdown();
+}
+
+// A pooled buffer goes from one connection to the next with the last one's ciphertext still in
+// it: a short message after a long one reads back as exactly itself, and the pool does not grow
+// from one connection to the next
+//
+TEST(SslTest, StagingReusedWithoutStaleData)
+{
+    Cooperator co;
+    Thread thread(&co);
+
+    io::ssl::Context serverTls(io::ssl::Mode::Server);
+    io::ssl::Context clientTls(io::ssl::Mode::Client);
+    ASSERT_TRUE(LoadCert(serverTls));
+
+    auto round = [&](std::string const& message)
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        {
+            return false;
+        }
+        return Connected(&co, &co, serverTls, clientTls, fds, false,
+            [&](io::ssl::Connection& conn)
+            {
+                std::string got(64 << 10, 0);
+                size_t done = 0;
+                while (done < message.size())
+                {
+                    int n = io::ssl::Recv(conn, got.data() + done, got.size() - done);
+                    if (n <= 0)
+                    {
+                        return false;
+                    }
+                    done += size_t(n);
+                }
+                got.resize(done);
+                return got == message &&
+                       io::ssl::SendAll(conn, got.data(), got.size()) == int(got.size());
+            },
+            [&](io::ssl::Connection& conn)
+            {
+                if (io::ssl::SendAll(conn, message.data(), message.size()) != int(message.size()))
+                {
+                    return false;
+                }
+                std::string got(64 << 10, 0);
+                size_t done = 0;
+                while (done < message.size())
+                {
+                    int n = io::ssl::Recv(conn, got.data() + done, got.size() - done);
+                    if (n <= 0)
+                    {
+                        return false;
+                    }
+                    done += size_t(n);
+                }
+                return done == message.size() && got.compare(0, done, message) == 0;
+            });
+    };
+
+    std::string large(40000, 0);
+    for (size_t i = 0; i < large.size(); i++)
+    {
+        large[i] = char('A' + i % 23);
+    }
+    ASSERT_TRUE(round(large));
+    int64_t pooled = GetTaggedMemory(MemoryTag::TlsStaging, &co).objects;
+    EXPECT_GT(pooled, 0);
+
+    for (int i = 0; i < 10; i++)
+    {
+        EXPECT_TRUE(round("hello " + std::to_string(i)));
+        EXPECT_TRUE(round(large));
+    }
+    // Twenty more connections, each borrowing for every flush and feed; a buffer not given back
+    // would show as one more each time. The slack is for a borrow the first round did not overlap.
+    //
+    EXPECT_LE(GetTaggedMemory(MemoryTag::TlsStaging, &co).objects, pooled + 2);
+
+    co.Shutdown();
+}
@@ -0,0 +1,467 @@
+#include <algorithm>
+#include <cerrno>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "coop/alloc.h"
+#include "coop/continuation_pool.h"
+#include "coop/cooperate.h"
+#include "coop/cooperator.h"
+#include "coop/cooperator.hpp"
+#include "coop/coordinator.h"
+#include "coop/memory_accounting.h"
+#include "coop/memory_pressure.h"
+#include "coop/stack_pool.h"
+
+#include "test_helpers.h"
+
+using namespace coop;
+
+namespace
+{
+
+StackPoolConfiguration TwoClasses(uint32_t cap, uint32_t prewarm, int64_t trimIntervalUs = 0)
+{
+    StackPoolConfiguration config;
+    config.classes[0] = {16384, cap, prewarm};
+    config.classes[1] = {262144, cap, prewarm};
+    config.classCount = 2;
+    config.trimIntervalUs = trimIntervalUs;
+    return config;
+}
+
+// An application pool of count items, keeping none back
+//
+struct CountingHook : PressureHook
+{
+    CountingHook(Cooperator* co, size_t n) : PressureHook(co), count(n) {}
+
+    size_t OnPressure(size_t batch) override
+    {
+        size_t n = std::min(batch, count);
+        count -= n;
+        calls++;
+        return n;
+    }
+
+    size_t count;
+    int calls = 0;
+};
+
+} // end anonymous namespace
+
+// Requests round up to the configured classes, not to powers of two, and a 256KB class is pooled
+// like any other.
+//
+TEST(StackPoolTest, ConfiguredClassesRoundAndReuse)
+{
+    StackPool pool(TwoClasses(4, 0));
+    EXPECT_EQ(pool.RoundUpStackSize(1), 16384u);
+    EXPECT_EQ(pool.RoundUpStackSize(20000), 262144u);
+    EXPECT_EQ(pool.RoundUpStackSize(524288), 524288u) << "above the largest class is unpooled";
+
+    void* a = pool.Allocate(262144);
+    ASSERT_NE(a, nullptr);
+    pool.Free(a, 262144);
+    EXPECT_EQ(pool.Allocate(262144), a);
+    pool.Free(a, 262144);
+
+    auto stats = pool.GetStats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+}
+
+// Each class caches at most cap segments; a size that matches no class (a migrated-in stack from a
+// different layout) is never cached.
+//
+TEST(StackPoolTest, CapAndForeignSizes)
+{
+    StackPool pool(TwoClasses(3, 0));
+    std::vector<void*> segs;
+    for (int i = 0; i < 5; i++) segs.push_back(pool.Allocate(16384));
+    for (void* p : segs) pool.Free(p, 16384);
+    EXPECT_EQ(pool.GetStats().cached, 3u);
+
+    void* foreign = pool.Allocate(32768);
+    ASSERT_NE(foreign, nullptr);
+    pool.Free(foreign, 32768);
+    EXPECT_EQ(pool.GetStats().cached, 3u);
+}
+
+// Prewarm fills each class so the first spawns are cache hits.
+//
+TEST(StackPoolTest, PrewarmFillsClasses)
+{
+    StackPool pool(TwoClasses(8, 2));
+    pool.Prewarm();
+    EXPECT_EQ(pool.GetStats().cached, 4u);
+
+    void* a = pool.Allocate(16384);
+    void* b = pool.Allocate(16384);
+    void* c = pool.Allocate(16384);
+    EXPECT_EQ(pool.GetStats().hits, 2u);
+    EXPECT_EQ(pool.GetStats().misses, 1u);
+    pool.Free(a, 16384);
+    pool.Free(b, 16384);
+    pool.Free(c, 16384);
+}
+
+// Trim frees half of what sat idle for a whole interval, decaying to the prewarm floor, and leaves
+// segments that were in use during the interval alone.
+//
+TEST(StackPoolTest, TrimDecaysIdleSegmentsToPrewarm)
+{
+    StackPool pool(TwoClasses(32, 2, 1000));
+    pool.Prewarm();
+
+    std::vector<void*> segs;
+    for (int i = 0; i < 10; i++) segs.push_back(pool.Allocate(16384));
+    for (void* p : segs) pool.Free(p, 16384);
+    EXPECT_EQ(pool.GetStats().cached, 12u);           // 10 at 16KB (8 above the floor), 2 at 256KB
+
+    EXPECT_EQ(pool.Trim(500), 0u) << "interval has not elapsed";
+    EXPECT_EQ(pool.Trim(1000), 0u) << "every 16KB segment was taken during the interval";
+
+    EXPECT_EQ(pool.Trim(2000), 5u);
+    EXPECT_EQ(pool.Trim(3000), 3u);
+    EXPECT_EQ(pool.Trim(4000), 0u);
+    EXPECT_EQ(pool.GetStats().cached, 4u);
+    EXPECT_EQ(pool.GetStats().trimmed, 8u);
+}
+
+// Pressure relief frees the largest class first, a batch at a time, down to each class's
+// pressureFloor rather than its prewarm
+//
+TEST(StackPoolTest, RelieveStopsAtPressureFloor)
+{
+    StackPoolConfiguration config = TwoClasses(16, 4);
+    config.classes[0].pressureFloor = 2;
+    config.classes[1].pressureFloor = 1;
+    StackPool pool(config);
+
+    std::vector<void*> small, large;
+    for (int i = 0; i < 8; i++) small.push_back(pool.Allocate(16384));
+    for (int i = 0; i < 6; i++) large.push_back(pool.Allocate(262144));
+    for (void* p : small) pool.Free(p, 16384);
+    for (void* p : large) pool.Free(p, 262144);
+    EXPECT_EQ(pool.GetStats().cached, 14u);
+
+    EXPECT_EQ(pool.Relieve(4), 4u);
+    EXPECT_EQ(pool.GetStats().cached, 10u) << "all four from the 256KB class";
+    EXPECT_EQ(pool.Relieve(4), 4u) << "one more large, then three small";
+    EXPECT_EQ(pool.Relieve(100), 3u);
+    EXPECT_EQ(pool.Relieve(100), 0u) << "both classes at their floors";
+    EXPECT_EQ(pool.GetStats().cached, 3u);
+    EXPECT_EQ(pool.GetStats().trimmed, 11u);
+
+    void* a = pool.Allocate(16384);
+    EXPECT_EQ(pool.GetStats().hits, 1u) << "the floor stays warm";
+    pool.Free(a, 16384);
+}
+
+// The continuation pool keeps at most cap blocks per class and relieves down to its floor
+//
+TEST(StackPoolTest, ContinuationPoolRelieve)
+{
+    ContinuationPool pool(4, 1);
+    std::vector<void*> blocks;
+    for (int i = 0; i < 6; i++) blocks.push_back(pool.Allocate(100));
+    for (void* p : blocks) pool.Free(p, 100);
+
+    EXPECT_EQ(pool.Relieve(2), 2u);
+    EXPECT_EQ(pool.Relieve(10), 1u) << "four kept by the cap, one by the floor";
+    EXPECT_EQ(pool.Relieve(10), 0u);
+    pool.Free(pool.Allocate(100), 100);
+}
+
+// Cached blocks are counted at their class size
+//
+TEST(StackPoolTest, ContinuationPoolRetainedBytes)
+{
+    ContinuationPool pool;
+    void* small = pool.Allocate(40);
+    void* large = pool.Allocate(200);
+    EXPECT_EQ(pool.RetainedBytes(), 0u);
+    pool.Free(small, 40);
+    pool.Free(large, 200);
+    EXPECT_EQ(pool.RetainedBytes(), 64u + 256u);
+}
+
+// Live contexts are grouped by name: segments reserved and resident, and the bump heap's use and
+// high water, which stays where a freed allocation took it
+//
+TEST(MemoryAccountingTest, ContextsByName)
+{
+    test::RunInCooperator([](Context* ctx)
+    {
+        Cooperator* co = ctx->GetCooperator();
+        Coordinator parked(ctx);
+        for (int i = 0; i < 3; i++)
+        {
+            co->Spawn([&](Context* child)
+            {
+                child->SetName("MemoryAccounted");
+                {
+                    auto buffer = child->AllocateBuffer(8192);
+                    buffer[0] = 1;
+                }
+                parked.Acquire(child);
+                parked.Release(child);
+            });
+        }
+
+        auto total = AccountCooperatorMemory(co);
+        EXPECT_GE(total.contexts.contexts, 4u);
+
+        bool found = false;
+        for (auto const& named : ContextMemoryByName(co))
+        {
+            if (named.name != "MemoryAccounted")
+            {
+                continue;
+            }
+            found = true;
+            auto const& m = named.memory;
+            EXPECT_EQ(m.contexts, 3u);
+            EXPECT_GE(m.stackReserved, 3 * s_defaultConfiguration.stackSize);
+            EXPECT_GT(m.stackCommitted, 0u);
+            EXPECT_LE(m.stackCommitted, m.stackReserved);
+            EXPECT_GE(m.heapHighWater, m.heapBytes + 3 * 8192);
+            EXPECT_LE(m.heapHighWater, total.contexts.heapHighWater);
+        }
+        EXPECT_TRUE(found);
+
+        parked.Release(ctx);
+        Yield();
+    });
+}
+
+// Tagged charges land on the calling cooperator and in the process total
+//
+TEST(MemoryAccountingTest, TaggedCharges)
+{
+    test::RunInCooperator([](Context* ctx)
+    {
+        Cooperator* co = ctx->GetCooperator();
+        auto before = GetTaggedMemory(MemoryTag::TlsConnection, co);
+        auto beforeTotal = GetTaggedMemory(MemoryTag::TlsConnection);
+
+        AccountMemory(MemoryTag::TlsConnection, 1000, 2);
+        auto during = AccountCooperatorMemory(co).tagged[size_t(MemoryTag::TlsConnection)];
+        EXPECT_EQ(during.bytes, before.bytes + 1000);
+        EXPECT_EQ(during.objects, before.objects + 2);
+        EXPECT_EQ(GetTaggedMemory(MemoryTag::TlsConnection).bytes, beforeTotal.bytes + 1000);
+
+        AccountMemory(MemoryTag::TlsConnection, -1000, -2);
+        EXPECT_EQ(GetTaggedMemory(MemoryTag::TlsConnection, co).bytes, before.bytes);
+        EXPECT_STREQ(MemoryTagName(MemoryTag::TlsConnection), "tlsConnection");
+    });
+}
+
+// Cooperator::Relieve reaches application pools after its own, and a trim drives it to the floor
+// a batch at a time on each cooperator's thread
+//
+TEST(MemoryPressureTest, TrimReachesHooks)
+{
+    test::RunInCooperator([](Context* ctx)
+    {
+        Cooperator* co = ctx->GetCooperator();
+        {
+            CountingHook hook(co, 100);
+            size_t freed = 0;
+            while (size_t n = co->Relieve(16))
+            {
+                EXPECT_LE(n, 16u);
+                freed += n;
+            }
+            EXPECT_EQ(hook.count, 0u);
+            EXPECT_GE(freed, 100u);
+        }
+
+        CountingHook hook(co, 50);
+        uint64_t trims = GetMemoryPressureStats().trims;
+        TrimAllCooperators(8);
+        while (GetMemoryPressureStats().trims == trims)
+        {
+            Yield();
+        }
+        EXPECT_EQ(hook.count, 0u);
+        EXPECT_GE(hook.calls, 7) << "eight items a step";
+    });
+}
+
+// The monitor reports what arming the trigger failed with, and runs one at a time
+//
+TEST(MemoryPressureTest, StartPressureMonitor)
+{
+    test::RunInCooperator([](Context*)
+    {
+        EXPECT_EQ(StartPressureMonitor({.path = "/nonexistent/memory.pressure"}), -ENOENT);
+
+        Context::Handle handle;
+        int r = StartPressureMonitor({}, &handle);
+        if (r < 0)
+        {
+            GTEST_SKIP() << "PSI trigger unavailable: " << r;
+        }
+        EXPECT_EQ(StartPressureMonitor(), -EALREADY);
+        handle.Kill();
+
+        // The kill cancels the monitor's poll; it is gone once the cancel completes
+        //
+        MemoryPressureConfiguration missing{.path = "/nonexistent/memory.pressure"};
+        int again;
+        while ((again = StartPressureMonitor(missing)) == -EALREADY)
+        {
+            Yield();
+        }
+        EXPECT_EQ(again, -ENOENT) << "a stopped monitor can be started again";
+    });
+}
+
+// A mapped 1MB class: the stack is a guarded mapping, returning it to the pool drops the pages below
+// the resident window (they read back as zero), and the pool's free-list link and the top window
+// survive the advice.
+//
+TEST(StackPoolTest, MappedStacksReleaseDeepPages)
+{
+    StackPoolConfiguration config;
+    config.classes[0] = {1 << 20, 4, 0};
+    config.classCount = 1;
+    config.mappedStacks = true;
+    config.releaseAdvice = StackAdvice::DontNeed;
+    config.residentKeep = 65536;
+
+    StackPool pool(config);
+    ASSERT_EQ(pool.Backing(1 << 20), StackBacking::Mapped);
+
+    auto* seg = static_cast<uint8_t*>(pool.Allocate(1 << 20));
+    ASSERT_NE(seg, nullptr);
+    uint8_t* deep = seg + (512 << 10);
+    uint8_t* shallow = seg + (1 << 20);             // inside the top 64KB window
+    *deep = 0xAB;
+    *shallow = 0xCD;
+
+    pool.Free(seg, 1 << 20);
+    EXPECT_EQ(*deep, 0) << "deep page released on return to the pool";
+    EXPECT_EQ(*shallow, 0xCD) << "resident window kept";
+
+    EXPECT_EQ(pool.Allocate(1 << 20), seg) << "free-list link survives the advice";
+    pool.Free(seg, 1 << 20);
+}
+
+// populateBytes faults in the top of each prewarmed segment and leaves the rest on demand
+//
+TEST(StackPoolTest, PrewarmPopulatesTop)
+{
+    StackPoolConfiguration config;
+    config.classes[0] = {1 << 20, 2, 1};
+    config.classCount = 1;
+    config.mappedStacks = true;
+    config.populateBytes = 65536;
+
+    StackPool pool(config);
+    pool.Prewarm();
+    auto* seg = static_cast<uint8_t*>(pool.Allocate(1 << 20));
+    ASSERT_NE(seg, nullptr);
+    EXPECT_EQ(pool.GetStats().hits, 1u);
+
+    const size_t page = sysconf(_SC_PAGESIZE);
+    auto resident = [&](uint8_t* at)
+    {
+        unsigned char vec = 0;
+        auto* pageStart = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(at) & ~(page - 1));
+        EXPECT_EQ(mincore(pageStart, page, &vec), 0);
+        return (vec & 1) != 0;
+    };
+    EXPECT_TRUE(resident(seg + (1 << 20) - 4096)) << "inside the populated top";
+    EXPECT_TRUE(resident(seg + (1 << 20) - 60000));
+    EXPECT_FALSE(resident(seg + (256 << 10))) << "deep pages still fault on demand";
+    pool.Free(seg, 1 << 20);
+}
+
+// The page below a mapped segment is a guard
+//
+TEST(StackPoolDeathTest, MappedStackGuardPage)
+{
+    StackPoolConfiguration config;
+    config.classes[0] = {65536, 1, 0};
+    config.classCount = 1;
+    config.mappedStacks = true;
+
+    StackPool pool(config);
+    auto* seg = static_cast<volatile uint8_t*>(pool.Allocate(65536));
+    ASSERT_NE(seg, nullptr);
+    EXPECT_DEATH({ seg[-1] = 1; }, "");
+    pool.Free((void*)seg, 65536);
+}
+
+// A huge-page arena class packs consecutive segments back to back inside one 2MB-aligned arena,
+// keeps every freed segment regardless of cap, and is left alone by trim. A class above
+// hugePageMaxClass keeps the ordinary backing.
+//
+TEST(StackPoolTest, HugePageArenaCarvesSmallClasses)
+{
+    StackPoolConfiguration config = TwoClasses(2, 0, 1000);
+    config.hugePages = HugePages::Transparent;
+    config.hugePageMaxClass = 65536;
+
+    StackPool pool(config);
+    EXPECT_EQ(pool.Backing(16384), StackBacking::Arena);
+    EXPECT_NE(pool.Backing(262144), StackBacking::Arena);
+
+    std::vector<void*> segs;
+    for (int i = 0; i < 8; i++) segs.push_back(pool.Allocate(16384));
+    ASSERT_NE(segs[0], nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(segs[0]) & ((2u << 20) - 1), 0u) << "arena is 2MB aligned";
+    for (int i = 1; i < 8; i++)
+    {
+        auto gap = static_cast<uint8_t*>(segs[i]) - static_cast<uint8_t*>(segs[i - 1]);
+        EXPECT_GT(gap, 16384);
+        EXPECT_LT(gap, 16384 + 4096) << "segments are adjacent, not page-per-stack";
+    }
+    EXPECT_EQ(pool.GetStats().arenaBytes, size_t(2) << 20);
+
+    for (void* p : segs) pool.Free(p, 16384);
+    EXPECT_EQ(pool.GetStats().cached, 8u) << "arena classes ignore cap";
+    EXPECT_EQ(pool.Trim(2000), 0u);
+    EXPECT_EQ(pool.Trim(3000), 0u);
+    EXPECT_EQ(pool.Allocate(16384), segs.back()) << "recycled through the free list";
+    pool.Free(segs.back(), 16384);
+}
+
+// numaLocal: once bound to a node, a heap-backed class becomes mapped and each raw segment carries
+// a preferred-node policy for that node. Without numaLocal, BindToNode changes nothing.
+//
+TEST(StackPoolTest, NumaLocalBindsSegments)
+{
+    StackPool plain(TwoClasses(4, 0));
+    plain.BindToNode(0);
+    EXPECT_EQ(plain.Backing(16384), StackPool(TwoClasses(4, 0)).Backing(16384));
+
+    StackPoolConfiguration config = TwoClasses(4, 0);
+    config.numaLocal = true;
+    StackPool pool(config);
+    pool.BindToNode(0);
+    ASSERT_EQ(pool.Backing(16384), StackBacking::Mapped);
+
+    void* seg = pool.Allocate(16384);
+    ASSERT_NE(seg, nullptr);
+
+    int mode = -1;
+    unsigned long mask[16] = {};
+    if (syscall(SYS_get_mempolicy, &mode, mask, sizeof(mask) * 8 + 1, seg, MPOL_F_ADDR) != 0)
+    {
+        pool.Free(seg, 16384);
+        GTEST_SKIP() << "get_mempolicy unavailable";
+    }
+    EXPECT_EQ(mode, MPOL_PREFERRED);
+    EXPECT_EQ(mask[0] & 1, 1u);
+    pool.Free(seg, 16384);
+}
@@ -23,11 +23,11 @@ TEST(StressTest, RapidSpawnKill)
             coop::Context::Handle handle;
             ctx->GetCooperator()->Spawn([](coop::Context* child)
             {
-                child->Yield(true);
+                child->Yield();
             }, &handle);
 
             handle.Kill();
-            ctx->Yield(true);
+            ctx->Yield();
         }
     });
 }
@@ -84,7 +84,7 @@ TEST(StressTest, WideFanoutKill)
         //
         while (killCount < NUM_CHILDREN)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(killCount, NUM_CHILDREN);
@@ -149,7 +149,7 @@ TEST(StressTest, DeepRecursiveKill)
 
         while (deepestKilled < DEPTH)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(deepestKilled, DEPTH);
@@ -180,7 +180,7 @@ TEST(StressTest, WideFanoutKillYielded)
                 {
                     while (!child->IsKilled())
                     {
-                        child->Yield(true);
+                        child->Yield();
                     }
                     killCount++;
                 });
@@ -197,7 +197,7 @@ TEST(StressTest, WideFanoutKillYielded)
 
         while (killCount < NUM_CHILDREN)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(killCount, NUM_CHILDREN);
@@ -257,7 +257,7 @@ TEST(StressTest, ChannelShutdownManyReceivers)
 
         while (wakeCount < NUM_RECEIVERS)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(wakeCount, NUM_RECEIVERS);
@@ -298,7 +298,7 @@ TEST(StressTest, ChannelShutdownManySenders)
 
         while (wakeCount < NUM_SENDERS)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(wakeCount, NUM_SENDERS);
@@ -351,14 +351,14 @@ TEST(StressTest, ChannelHighThroughput)
 
         while (produced.load(std::memory_order_relaxed) < TOTAL_ITEMS)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         ch.Shutdown();
 
         while (consumed.load(std::memory_order_relaxed) < TOTAL_ITEMS)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(produced.load(), TOTAL_ITEMS);
@@ -409,7 +409,7 @@ TEST(StressTest, MixedTreeKill)
                         {
                             while (!child->IsKilled())
                             {
-                                child->Yield(true);
+                                child->Yield();
                             }
                         }
                         killCount.fetch_add(1, std::memory_order_relaxed);
@@ -430,7 +430,7 @@ TEST(StressTest, MixedTreeKill)
 
         while (killCount.load(std::memory_order_relaxed) < EXPECTED_KILLS)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(killCount.load(), EXPECTED_KILLS);
@@ -455,14 +455,14 @@ TEST(StressTest, RepeatedShutdownCycles)
             {
                 ctx->GetCooperator()->Spawn([&](coop::Context* child)
                 {
-                    child->Yield(true);
+                    child->Yield();
                     count++;
                 });
             }
 
             while (count < CONTEXTS_PER_CYCLE)
             {
-                ctx->Yield(true);
+                ctx->Yield();
             }
 
             EXPECT_EQ(count, CONTEXTS_PER_CYCLE);
@@ -2,6 +2,7 @@
 #include <atomic>
 #include <chrono>
 #include <random>
+#include <string>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -11,15 +12,17 @@
 #include "coop/context.h"
 #include "coop/coordinator.h"
 #include "coop/thread.h"
+#include "coop/time/now.h"
 #include "coop/time/sleep.h"
 #include "coop/time/timer_queue.h"
+#include "coop/time/timer_wheel.h"
 #include "test_helpers.h"
 
 using namespace std::chrono_literals;
 
 // Run a test body inside a cooperator configured with a specific TimerMode. The integration tests
-// run their assertions under BOTH modes so the userspace queue is proven to match the proven
-// kernel-per-timer path, not merely to pass on its own.
+// run their assertions under EVERY mode so the userspace queue and wheel are proven to match the
+// proven kernel-per-timer path, not merely to pass on their own.
 //
 static void RunWithTimerMode(coop::TimerMode mode, std::function<void(coop::Context*)> fn)
 {
@@ -167,20 +170,164 @@ TEST(TimerQueueTest, RandomizedStress)
     EXPECT_EQ(drained, static_cast<int>(linked.size()));
 }
 
+// ---------------------------------------------------------------------------
+// TimerWheel unit tests: the structure in isolation, no cooperator.
+// ---------------------------------------------------------------------------
+
+// Deadlines on every level, past the whole wheel, and shared between nodes all pop in order, none
+// before the 'now' it is popped at, and the next expiry never runs past the nearest deadline.
+//
+TEST(TimerWheelTest, PopsInDeadlineOrderAcrossLevels)
+{
+    coop::time::TimerWheel w(1000);
+    coop::Coordinator dummy;
+
+    std::vector<int64_t> deadlines = {
+        1005, 1070, 5000, 5000, 301'000, 20'001'000, 2'000'001'000,
+        1000 + coop::time::TimerWheel::kRangeUs + 5, 1001, 1000, 64'000'000'000,
+    };
+    std::vector<coop::time::TimerNode> nodes(deadlines.size());
+    for (size_t i = 0; i < deadlines.size(); i++)
+    {
+        w.Insert(&nodes[i], deadlines[i], &dummy);
+        ASSERT_TRUE(w.Validate());
+    }
+    EXPECT_EQ(w.Size(), deadlines.size());
+
+    auto sorted = deadlines;
+    std::sort(sorted.begin(), sorted.end());
+
+    std::vector<int64_t> popped;
+    for (int64_t now = 1000; !w.Empty(); now += now / 3)
+    {
+        EXPECT_LE(w.NextExpiryUs(), std::max(sorted[popped.size()], w.ElapsedUs()));
+        while (auto* n = w.PopExpired(now))
+        {
+            EXPECT_LE(n->DeadlineUs(), now);
+            popped.push_back(n->DeadlineUs());
+        }
+        ASSERT_TRUE(w.Validate());
+        if (!w.Empty())
+        {
+            EXPECT_GT(sorted[popped.size()], now);
+        }
+    }
+    EXPECT_EQ(popped, sorted);
+}
+
+// Remove unlinks from any level or the overflow list, and, like the queue's, is idempotent.
+//
+TEST(TimerWheelTest, ArbitraryRemove)
+{
+    coop::time::TimerWheel w;
+    coop::Coordinator dummy;
+
+    std::vector<coop::time::TimerNode> nodes(8);
+    for (int i = 0; i < 8; i++)
+    {
+        w.Insert(&nodes[i], int64_t(1) << (i * 6), &dummy);
+    }
+    ASSERT_TRUE(w.Validate());
+
+    for (int i : {0, 3, 7, 3})
+    {
+        w.Remove(&nodes[i]);
+        EXPECT_FALSE(nodes[i].Linked());
+        EXPECT_TRUE(w.Validate());
+    }
+    EXPECT_EQ(w.Size(), 5u);
+
+    int remaining = 0;
+    while (w.PopExpired(int64_t(1) << 48)) remaining++;
+    EXPECT_EQ(remaining, 5);
+    EXPECT_TRUE(w.Empty());
+}
+
+// Random inserts, removes and clock advances, checked against the pairing heap: both pop the same
+// deadlines at every 'now', and the wheel stays valid throughout.
+//
+TEST(TimerWheelTest, RandomizedAgainstQueue)
+{
+    coop::time::TimerWheel w(1'000'000);
+    coop::time::TimerQueue q;
+    coop::Coordinator dummy;
+
+    constexpr int N = 512;
+    std::vector<coop::time::TimerNode> wheelNodes(N);
+    std::vector<coop::time::TimerNode> queueNodes(N);
+    std::mt19937_64 rng(0xC007);
+
+    int64_t now = 1'000'000;
+    for (int step = 0; step < 20000; step++)
+    {
+        int i = static_cast<int>(rng() % N);
+        switch (rng() % 4)
+        {
+        case 0:
+        case 1:
+            if (!wheelNodes[i].Linked())
+            {
+                // Mostly near deadlines, some far enough to climb the levels or overflow
+                //
+                int64_t span = int64_t(1) << ((rng() % 8) * 5 + 1);
+                int64_t deadline = now + static_cast<int64_t>(rng() % span);
+                w.Insert(&wheelNodes[i], deadline, &dummy);
+                q.Insert(&queueNodes[i], deadline, &dummy);
+            }
+            break;
+        case 2:
+            w.Remove(&wheelNodes[i]);
+            q.Remove(&queueNodes[i]);
+            break;
+        default:
+        {
+            now += static_cast<int64_t>(rng() % (int64_t(1) << ((rng() % 7) * 6)));
+            std::vector<int64_t> fromWheel, fromQueue;
+            while (auto* n = w.PopExpired(now)) fromWheel.push_back(n->DeadlineUs());
+            while (auto* n = q.PopExpired(now)) fromQueue.push_back(n->DeadlineUs());
+            std::sort(fromWheel.begin(), fromWheel.end());
+            ASSERT_EQ(fromWheel, fromQueue);
+            break;
+        }
+        }
+        ASSERT_EQ(w.Size() == 0, q.Empty());
+        if (!q.Empty())
+        {
+            ASSERT_LE(w.NextExpiryUs(), std::max(q.MinDeadlineUs(), w.ElapsedUs()));
+        }
+        if (step % 64 == 0)
+        {
+            ASSERT_TRUE(w.Validate());
+        }
+    }
+
+    for (int i = 0; i < N; i++)
+    {
+        w.Remove(&wheelNodes[i]);
+        q.Remove(&queueNodes[i]);
+    }
+}
+
 // ---------------------------------------------------------------------------
 // Integration: sleeps running on a real cooperator.
 // ---------------------------------------------------------------------------
 
-// The integration tests run under both timer modes via a value-parameterized fixture.
+// The integration tests run under every timer mode via a value-parameterized fixture.
 //
 class TimerIntegrationTest : public ::testing::TestWithParam<coop::TimerMode> {};
 
 INSTANTIATE_TEST_SUITE_P(
     Modes, TimerIntegrationTest,
-    ::testing::Values(coop::TimerMode::KernelPerTimer, coop::TimerMode::UserspaceQueue),
-    [](const ::testing::TestParamInfo<coop::TimerMode>& info)
+    ::testing::Values(coop::TimerMode::KernelPerTimer, coop::TimerMode::UserspaceQueue,
+                      coop::TimerMode::Wheel),
+    [](const ::testing::TestParamInfo<coop::TimerMode>& info) -> std::string
     {
-        return info.param == coop::TimerMode::UserspaceQueue ? "UserspaceQueue" : "KernelPerTimer";
+        switch (info.param)
+        {
+        case coop::TimerMode::UserspaceQueue:   return "UserspaceQueue";
+        case coop::TimerMode::Wheel:            return "Wheel";
+        default:                                return "KernelPerTimer";
+        }
     });
 
 // Many concurrent sleeps each wake no earlier than their requested interval, and complete in
@@ -222,7 +369,7 @@ TEST_P(TimerIntegrationTest, ConcurrentSleepsFireInOrderNotEarly)
 
         while (completed < N)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         ASSERT_EQ(static_cast<int>(done.size()), N);
@@ -290,7 +437,7 @@ TEST_P(TimerIntegrationTest, MixedSlackAndExact)
 
         while (completed < N)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
         EXPECT_EQ(failures.load(), 0);
     });
@@ -328,16 +475,36 @@ TEST_P(TimerIntegrationTest, KillMidSleepRemovesFromQueue)
 
         // Let everything register and block.
         //
-        for (int i = 0; i < 4; i++) ctx->Yield(true);
+        for (int i = 0; i < 4; i++) ctx->Yield();
 
         victim.Kill();
 
         while (!victimDone || bgCompleted < 4)
         {
-            ctx->Yield(true);
+            ctx->Yield();
         }
 
         EXPECT_EQ(victimResult, coop::time::SleepResult::Killed);
         EXPECT_EQ(bgCompleted, 4);          // the kill did not disturb the other sleeps
     });
 }
+
+// NowCoarse trails the clock by at most a scheduler pass: never ahead of it, refreshed by the
+// wait a sleep brings, and a plain clock read off a cooperator thread
+//
+TEST_P(TimerIntegrationTest, NowCoarseIsNeverAheadAndRefreshes)
+{
+    EXPECT_LE(coop::time::MonotonicMicros() - coop::time::NowCoarse(), 0);
+
+    RunWithTimerMode(GetParam(), [](coop::Context* ctx)
+    {
+        int64_t before = coop::time::NowCoarse();
+        EXPECT_LE(before, coop::time::MonotonicMicros());
+
+        coop::time::Sleep(ctx, 20ms);
+
+        int64_t after = coop::time::NowCoarse();
+        EXPECT_GE(after - before, 20000);
+        EXPECT_LE(after, coop::time::MonotonicMicros());
+    });
+}
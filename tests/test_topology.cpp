@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <sched.h>
 #include <sys/wait.h>
@@ -108,6 +109,151 @@ TEST(TopologyTest, NumaNodeForCpu)
     EXPECT_EQ(topo.NumaNodeForCpu(99999), -1);
 }
 
+TEST(TopologyTest, LlcForCpu)
+{
+    auto const& topo = coop::GetTopology();
+    if (topo.cpus.empty()) GTEST_SKIP();
+
+    // The LLC id is the lowest cpu sharing the cache, so it never exceeds the cpu's own id
+    //
+    for (auto const& info : topo.cpus)
+    {
+        EXPECT_EQ(topo.LlcForCpu(info.cpu_id), info.llc_id);
+        if (info.llc_id >= 0)
+        {
+            EXPECT_LE(info.llc_id, info.cpu_id);
+        }
+    }
+    EXPECT_EQ(topo.LlcForCpu(99999), -1);
+}
+
+TEST(TopologyTest, CoreForCpu)
+{
+    auto const& topo = coop::GetTopology();
+    if (topo.cpus.empty()) GTEST_SKIP();
+
+    // Like the LLC id, the core id is the lowest cpu on the core, and SMT siblings share an LLC
+    //
+    for (auto const& info : topo.cpus)
+    {
+        EXPECT_EQ(topo.CoreForCpu(info.cpu_id), info.core_id);
+        if (info.core_id >= 0)
+        {
+            EXPECT_LE(info.core_id, info.cpu_id);
+        }
+        for (auto const& other : topo.cpus)
+        {
+            if (info.core_id >= 0 && other.core_id == info.core_id && info.llc_id >= 0)
+            {
+                EXPECT_EQ(other.llc_id, info.llc_id);
+            }
+        }
+    }
+    EXPECT_EQ(topo.CoreForCpu(99999), -1);
+}
+
+// Two LLCs of two SMT2 cores each, sibling ids interleaved the way Linux numbers them: cpus
+// 0-3 are the cores' first threads and 4-7 their second
+//
+static coop::Topology SyntheticSmtTopology()
+{
+    coop::Topology topo;
+    for (int cpu = 0; cpu < 8; cpu++)
+    {
+        const int core = cpu % 4;
+        topo.cpus.push_back({cpu, 0, core < 2 ? 0 : 2, core, false});
+    }
+    topo.nodes.push_back({0, {0, 1, 2, 3, 4, 5, 6, 7}});
+    return topo;
+}
+
+TEST(TopologyTest, SiblingsOf)
+{
+    auto topo = SyntheticSmtTopology();
+    EXPECT_EQ(topo.SiblingsOf(1), (std::vector<int>{1, 5}));
+    EXPECT_EQ(topo.SiblingsOf(6), (std::vector<int>{2, 6}));
+    EXPECT_TRUE(topo.SiblingsOf(99).empty());
+
+    topo.cpus[3].core_id = -1;
+    EXPECT_EQ(topo.SiblingsOf(3), (std::vector<int>{3}));
+}
+
+TEST(TopologyTest, PlacementOrderSpreadsThenPacks)
+{
+    auto topo = SyntheticSmtTopology();
+
+    using coop::PlacementPolicy;
+    EXPECT_EQ(topo.PlacementOrder(PlacementPolicy::RoundRobin),
+              (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}));
+
+    // Every core's first thread before any second one; Spread alternates LLCs, Pack fills one
+    //
+    EXPECT_EQ(topo.PlacementOrder(PlacementPolicy::SpreadPhysicalFirst),
+              (std::vector<int>{0, 2, 1, 3, 4, 6, 5, 7}));
+    EXPECT_EQ(topo.PlacementOrder(PlacementPolicy::PackLLC),
+              (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}));
+}
+
+TEST(TopologyTest, PlacementOrderSkipsIsolated)
+{
+    auto topo = SyntheticSmtTopology();
+    topo.cpus[2].isolated = true;
+
+    auto order = topo.PlacementOrder(coop::PlacementPolicy::SpreadPhysicalFirst);
+    EXPECT_EQ(order.size(), 7u);
+    EXPECT_EQ(std::count(order.begin(), order.end(), 2), 0);
+
+    // With every cpu isolated there is nothing else to use
+    //
+    for (auto& info : topo.cpus) info.isolated = true;
+    EXPECT_EQ(topo.PlacementOrder(coop::PlacementPolicy::PackLLC).size(), 8u);
+}
+
+TEST(TopologyTest, PickCpuAvoidsBusyCores)
+{
+    auto topo = SyntheticSmtTopology();
+    using coop::PlacementPolicy;
+
+    std::vector<int> load;
+    EXPECT_EQ(topo.PickCpu(PlacementPolicy::SpreadPhysicalFirst, load), 0);
+
+    // Cpu 0 busy: its sibling 4 is as loaded as a core, so the next idle core wins
+    //
+    load = {1};
+    EXPECT_EQ(topo.PickCpu(PlacementPolicy::SpreadPhysicalFirst, load), 2);
+    EXPECT_EQ(topo.PickCpu(PlacementPolicy::PackLLC, load), 1);
+    EXPECT_EQ(topo.PickCpu(PlacementPolicy::RoundRobin, load), 1);
+
+    // One cooperator on every core: second threads, in policy order
+    //
+    load = {1, 1, 1, 1};
+    EXPECT_EQ(topo.PickCpu(PlacementPolicy::SpreadPhysicalFirst, load), 4);
+    load = {1, 1, 1, 1, 1};
+    EXPECT_EQ(topo.PickCpu(PlacementPolicy::SpreadPhysicalFirst, load), 6);
+    EXPECT_EQ(topo.PickCpu(PlacementPolicy::PackLLC, load), 5);
+
+    EXPECT_EQ(coop::Topology{}.PickCpu(PlacementPolicy::PackLLC, load), -1);
+}
+
+TEST(TopologyTest, PlaceCpuCountsLoad)
+{
+    auto const& topo = coop::GetTopology();
+    if (topo.cpus.empty()) GTEST_SKIP();
+
+    // An explicit cpu is taken as is, and counts against its core for the policies that look
+    //
+    const int cpu = topo.cpus[0].cpu_id;
+    EXPECT_EQ(coop::PlaceCpu(coop::PlacementPolicy::SpreadPhysicalFirst, cpu), cpu);
+    if (topo.cpus.size() > 1 && topo.SiblingsOf(cpu).size() < topo.cpus.size())
+    {
+        int next = coop::PlaceCpu(coop::PlacementPolicy::SpreadPhysicalFirst);
+        EXPECT_GE(next, 0);
+        EXPECT_FALSE(topo.CoreForCpu(cpu) >= 0 && topo.CoreForCpu(next) == topo.CoreForCpu(cpu));
+        coop::ReleaseCpu(next);
+    }
+    coop::ReleaseCpu(cpu);
+}
+
 TEST(TopologyTest, NextRoundRobinCycles)
 {
     auto const& topo = coop::GetTopology();
@@ -0,0 +1,173 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "coop/continuation.h"
+#include "coop/coordinator.h"
+#include "coop/cooperator.h"
+#include "coop/self.h"
+#include "coop/time/sleep.h"
+#include "coop/trace.h"
+#include "test_helpers.h"
+
+using namespace coop;
+
+namespace
+{
+
+// Tracing is process-wide: each test turns it on for itself and off again on the way out
+//
+struct TracingOn
+{
+    explicit TracingOn(double rate) { trace::SetSampleRate(rate); }
+    ~TracingOn() { trace::Disable(); }
+};
+
+} // end anon namespace
+
+// A traceparent survives a parse and a format unchanged; malformed ones are refused
+//
+TEST(TraceTest, TraceParentRoundTrip)
+{
+    const char* text = "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01";
+    trace::SpanContext parsed;
+    ASSERT_TRUE(trace::ParseTraceParent(text, parsed));
+    EXPECT_EQ(parsed.traceHi, 0x4bf92f3577b34da6ull);
+    EXPECT_EQ(parsed.traceLo, 0xa3ce929d0e0e4736ull);
+    EXPECT_EQ(parsed.spanId, 0x00f067aa0ba902b7ull);
+    EXPECT_TRUE(parsed.Sampled());
+
+    char out[trace::kTraceParentSize];
+    EXPECT_EQ(trace::FormatTraceParent(parsed, out), trace::kTraceParentSize);
+    EXPECT_EQ(std::string(out, sizeof(out)), text);
+
+    trace::SpanContext ignored;
+    EXPECT_TRUE(trace::ParseTraceParent(
+        " 01-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00-future ", ignored));
+    EXPECT_FALSE(ignored.Sampled());
+    EXPECT_FALSE(trace::ParseTraceParent(
+        "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01-extra", ignored));
+    EXPECT_FALSE(trace::ParseTraceParent(
+        "ff-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01", ignored));
+    EXPECT_FALSE(trace::ParseTraceParent(
+        "00-00000000000000000000000000000000-00f067aa0ba902b7-01", ignored));
+    EXPECT_FALSE(trace::ParseTraceParent(
+        "00-4BF92F3577B34DA6A3CE929D0E0E4736-00f067aa0ba902b7-01", ignored));
+    EXPECT_FALSE(trace::ParseTraceParent("", ignored));
+}
+
+// A spawned child and a continuation carry the trace context they were created under, and the
+// exporter hands every sampled span over, linked to its parent
+//
+TEST(TraceTest, ContextFollowsSpawnAndContinuation)
+{
+    TracingOn on(1.0);
+    std::vector<trace::SpanData> exported;
+
+    test::RunInCooperator([&](Context* ctx)
+    {
+        Context::Handle exporter;
+        ASSERT_TRUE(trace::StartExporter([&](trace::SpanData const* spans, size_t n)
+        {
+            exported.insert(exported.end(), spans, spans + n);
+        }, std::chrono::milliseconds(1), &exporter));
+        EXPECT_FALSE(trace::StartExporter([](trace::SpanData const*, size_t) {}));
+
+        Coordinator coord;
+        coord.Acquire(ctx);
+
+        trace::SpanContext root;
+        trace::SpanContext inChild;
+        trace::SpanContext inContinuation;
+        {
+            trace::Span span("root");
+            EXPECT_TRUE(span.Sampled());
+            root = *trace::Current();
+
+            ctx->GetCooperator()->Spawn([&](Context*)
+            {
+                trace::Span child("child");
+                inChild = *trace::Current();
+            });
+
+            coord.ContinueDetached([&](Coordinator*)
+            {
+                inContinuation = *trace::Current();
+            });
+        }
+        EXPECT_FALSE(trace::Current()->Valid());
+
+        coord.Release(ctx);
+        while (trace::PendingSpans() > 0)
+        {
+            time::Sleep(ctx, std::chrono::milliseconds(1));
+        }
+        exporter.Kill();
+        while (exporter)
+        {
+            ctx->Yield();
+        }
+
+        EXPECT_EQ(inChild.traceHi, root.traceHi);
+        EXPECT_EQ(inChild.traceLo, root.traceLo);
+        EXPECT_EQ(inChild.parentId, root.spanId);
+        EXPECT_EQ(inContinuation.traceLo, root.traceLo);
+        EXPECT_EQ(inContinuation.spanId, root.spanId);
+    });
+
+    ASSERT_EQ(exported.size(), 2u);
+    trace::SpanData const& child = exported[0];
+    trace::SpanData const& root = exported[1];
+    EXPECT_STREQ(child.name, "child");
+    EXPECT_STREQ(root.name, "root");
+    EXPECT_EQ(child.parentId, root.spanId);
+    EXPECT_EQ(root.parentId, 0u);
+    EXPECT_LE(root.startNs, child.startNs);
+    EXPECT_LE(child.endNs, root.endNs);
+    EXPECT_EQ(trace::DroppedSpans(), 0u);
+
+    std::string json;
+    trace::AppendOtlpJson(json, exported.data(), exported.size(), "svc");
+    EXPECT_NE(json.find("\"stringValue\":\"svc\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"child\""), std::string::npos);
+    EXPECT_NE(json.find("\"parentSpanId\""), std::string::npos);
+}
+
+// Unsampled traces propagate ids but record nothing; a server span adopts the upstream caller's
+// trace and sampling decision until it opens a child
+//
+TEST(TraceTest, UnsampledAndAdopted)
+{
+    TracingOn on(0.0);
+
+    test::RunInCooperator([&](Context*)
+    {
+        {
+            trace::Span span("unsampled");
+            EXPECT_TRUE(trace::Current()->Valid());
+            EXPECT_FALSE(span.Sampled());
+        }
+        EXPECT_EQ(trace::PendingSpans(), 0u);
+
+        trace::SpanContext remote;
+        ASSERT_TRUE(trace::ParseTraceParent(
+            "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01", remote));
+        {
+            trace::Span server("http.server", trace::Kind::Server);
+            EXPECT_FALSE(server.Sampled());
+            trace::Adopt(remote);
+            EXPECT_TRUE(server.Sampled());
+            EXPECT_EQ(trace::Current()->traceLo, remote.traceLo);
+            EXPECT_EQ(trace::Current()->parentId, remote.spanId);
+
+            {
+                trace::Span child("child");
+            }
+            trace::SpanContext before = *trace::Current();
+            trace::Adopt(trace::SpanContext{1, 2, 3, 0, 0});
+            EXPECT_EQ(trace::Current()->traceLo, before.traceLo);
+        }
+        EXPECT_EQ(trace::PendingSpans(), 2u);
+    });
+}
@@ -0,0 +1,183 @@
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "coop/context.h"
+#include "coop/cooperator.h"
+#include "coop/coordinator.h"
+#include "coop/self.h"
+#include "coop/time/sleep.h"
+
+#include "coop/io/watcher.h"
+
+#include "test_helpers.h"
+
+namespace
+{
+
+struct SocketPair
+{
+    int fds[2];
+
+    SocketPair()
+    {
+        int ret = socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds);
+        assert(ret == 0);
+        std::ignore = ret;
+    }
+
+    ~SocketPair()
+    {
+        if (fds[0] >= 0) close(fds[0]);
+        if (fds[1] >= 0) close(fds[1]);
+    }
+};
+
+// Counts the edges a continuation-driven watcher delivers
+//
+struct EdgeCounter : coop::Continuation
+{
+    void Run() override
+    {
+        runs++;
+        seen |= watcher->Take();
+    }
+
+    coop::io::Watcher*  watcher = nullptr;
+    int                 runs = 0;
+    uint32_t            seen = 0;
+};
+
+} // end anonymous namespace
+
+// One armed poll serves every round: each write is an edge, taken by the next Wait
+//
+TEST(WatcherTest, OneArmDeliversEveryEdge)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        coop::io::Watcher watcher(ctx, sp.fds[0], POLLIN);
+
+        for (int i = 0; i < 3; i++)
+        {
+            ASSERT_EQ(::write(sp.fds[1], "x", 1), 1);
+            int ev = watcher.Wait();
+            ASSERT_GT(ev, 0);
+            EXPECT_TRUE(ev & POLLIN);
+
+            char c;
+            ASSERT_EQ(::read(sp.fds[0], &c, 1), 1);
+        }
+
+        EXPECT_TRUE(watcher.Armed());
+        EXPECT_GE(watcher.Edges(), 3u);
+        EXPECT_EQ(watcher.Rearms(), 0u);
+    });
+}
+
+TEST(WatcherTest, WaitTimesOutWhileIdle)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        coop::io::Watcher watcher(ctx, sp.fds[0], POLLIN);
+
+        EXPECT_EQ(watcher.Wait(std::chrono::milliseconds(10)), -ETIMEDOUT);
+        EXPECT_TRUE(watcher.Armed());
+
+        // Still watching after the timeout
+        //
+        ASSERT_EQ(::write(sp.fds[1], "x", 1), 1);
+        EXPECT_TRUE(watcher.Wait(std::chrono::seconds(5)) & POLLIN);
+    });
+}
+
+// The mask changes in place: an idle socket turns out writable once POLLOUT is asked for
+//
+TEST(WatcherTest, SetEventsUpdatesTheArmedPoll)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        coop::io::Watcher watcher(ctx, sp.fds[0], POLLIN);
+        EXPECT_EQ(watcher.Wait(std::chrono::milliseconds(10)), -ETIMEDOUT);
+
+        watcher.SetEvents(POLLIN | POLLOUT);
+        int ev = watcher.Wait(std::chrono::seconds(5));
+        ASSERT_GT(ev, 0);
+        EXPECT_TRUE(ev & POLLOUT);
+        EXPECT_EQ(watcher.Events(), uint32_t(POLLIN | POLLOUT));
+        EXPECT_EQ(watcher.Rearms(), 0u);
+    });
+}
+
+TEST(WatcherTest, ReportsHangup)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        coop::io::Watcher watcher(ctx, sp.fds[0], POLLIN);
+
+        close(sp.fds[1]);
+        sp.fds[1] = -1;
+
+        int ev = watcher.Wait(std::chrono::seconds(5));
+        ASSERT_GT(ev, 0);
+        EXPECT_TRUE(ev & POLLHUP);
+    });
+}
+
+TEST(WatcherTest, WaitKillReturnsCanceled)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        coop::Context::Handle childHandle;
+        int result = 0;
+        bool done = false;
+
+        ctx->GetCooperator()->Spawn([&](coop::Context* child)
+        {
+            coop::io::Watcher watcher(child, sp.fds[0], POLLIN);
+            result = watcher.WaitKill();
+            done = true;
+        }, &childHandle);
+
+        childHandle.Kill();
+        while (!done)
+        {
+            ctx->Yield();
+        }
+        EXPECT_EQ(result, -ECANCELED);
+    });
+}
+
+// Continuation mode runs inline per edge; destroying the watcher on a context drains its poll
+//
+TEST(WatcherTest, ContinuationRunsOnEdges)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        EdgeCounter counter;
+        {
+            coop::io::Watcher watcher(sp.fds[0], POLLIN, &counter);
+            counter.watcher = &watcher;
+
+            ASSERT_EQ(::write(sp.fds[1], "x", 1), 1);
+            for (int i = 0; i < 500 && counter.runs == 0; i++)
+            {
+                coop::time::Sleep(ctx, std::chrono::milliseconds(1));
+            }
+            EXPECT_GE(counter.runs, 1);
+            EXPECT_TRUE(counter.seen & POLLIN);
+            EXPECT_EQ(watcher.Pending(), 0u);
+        }
+    });
+}
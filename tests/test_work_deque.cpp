@@ -85,7 +85,9 @@ struct StressResult { bool anyZero; bool anyDup; bool stalled; };
 // cooperator launched on this thread sets CPU affinity that outlives it — and spawned threads
 // inherit that single-core mask, collapsing the race to preemption timing. Reset to all cores.
 //
-template<typename Deque>
+// With BatchThieves the thieves claim with StealBatch instead of Steal.
+//
+template<typename Deque, bool BatchThieves = false>
 static StressResult RunStress(int items, int thieves)
 {
     cpu_set_t all;
@@ -107,8 +109,19 @@ static StressResult RunStress(int items, int thieves)
     for (int k = 0; k < thieves; k++)
         thiefs.emplace_back([&] {
             void* v;
+            void* batch[16];
             while (total.load(std::memory_order_acquire) < items)
-                if (dq.Steal(v)) record(v);
+            {
+                if constexpr (BatchThieves)
+                {
+                    const int n = dq.StealBatch(batch, 16);
+                    for (int i = 0; i < n; i++) record(batch[i]);
+                }
+                else if (dq.Steal(v))
+                {
+                    record(v);
+                }
+            }
         });
 
     int produced = 0;
@@ -185,6 +198,49 @@ TEST(WorkDequeTest, ConcurrentExactlyOnce)
     }
 }
 
+// A batch steal takes half the items (rounded up), oldest first, capped by maxN and by BATCH; the
+// owner still pops LIFO above BATCH items and FIFO within it.
+//
+TEST(WorkDequeTest, StealBatchTakesHalf)
+{
+    work::detail::Deque<void*, 256, 4> dq;
+    for (int i = 0; i < 20; i++) dq.PushBottom(Item(i));
+    void* out[8];
+
+    ASSERT_EQ(dq.StealBatch(out, 8), 4) << "capped by BATCH";
+    for (int i = 0; i < 4; i++) EXPECT_EQ(Index(out[i]), i);
+    ASSERT_EQ(dq.StealBatch(out, 2), 2) << "capped by maxN";
+    EXPECT_EQ(Index(out[0]), 4);
+    EXPECT_EQ(Index(out[1]), 5);
+
+    void* v;
+    for (int i = 19; i >= 10; i--) { ASSERT_TRUE(dq.PopBottom(v)); EXPECT_EQ(Index(v), i); }
+
+    // Four left (6..9): within BATCH of the top, so the owner now takes from the top
+    //
+    ASSERT_EQ(dq.StealBatch(out, 8), 2) << "half of four";
+    EXPECT_EQ(Index(out[0]), 6);
+    ASSERT_TRUE(dq.PopBottom(v));
+    EXPECT_EQ(Index(v), 8);
+    ASSERT_EQ(dq.StealBatch(out, 8), 1) << "half of one, rounded up";
+    EXPECT_EQ(Index(out[0]), 9);
+    EXPECT_EQ(dq.StealBatch(out, 8), 0);
+    EXPECT_FALSE(dq.PopBottom(v));
+}
+
+// Green: the same exactly-once guarantee with every thief claiming batches.
+//
+TEST(WorkDequeTest, ConcurrentBatchExactlyOnce)
+{
+    for (int rep = 0; rep < 20; rep++)
+    {
+        StressResult r = RunStress<work::detail::Deque<void*, 256, 16>, true>(200000, 3);
+        ASSERT_FALSE(r.stalled) << "rep " << rep << ": under-count stall (lost item)";
+        EXPECT_FALSE(r.anyZero) << "rep " << rep << ": an item was never consumed";
+        EXPECT_FALSE(r.anyDup)  << "rep " << rep << ": an item was consumed twice";
+    }
+}
+
 // Red calibration: the same harness detects the broken deque's duplication. Proves the stress test
 // has detection power (red/green), not just that the correct deque happens to pass.
 //
@@ -21,6 +21,36 @@ TEST(WorkPoolTest, LocalShedPull)
     EXPECT_EQ(runs, 16);
 }
 
+// Ordered pull: near victims are tried first, and a remote victim is stolen from only once its
+// backlog reaches the remote threshold.
+//
+TEST(WorkPoolTest, OrderedPullPrefersNearAndGatesRemote)
+{
+    work::detail::Shards<work::Erg*> pool;
+    pool.Init(3);
+    int ran[3] = {0, 0, 0};
+    ASSERT_TRUE(pool.Shed(1, work::MakeErg([&] { ran[1]++; })));
+    ASSERT_TRUE(pool.Shed(2, work::MakeErg([&] { ran[2]++; })));
+    ASSERT_TRUE(pool.Shed(2, work::MakeErg([&] { ran[2]++; })));
+
+    // Worker 0 sees shard 1 as near and shard 2 as remote (needs >= 3 queued)
+    //
+    const int victims[] = {1, 2};
+    work::Erg* e = pool.Pull(0, victims, 2, 1, 3);
+    ASSERT_NE(e, nullptr);
+    work::RunErg(e);
+    EXPECT_EQ(ran[1], 1);
+
+    EXPECT_EQ(pool.Pull(0, victims, 2, 1, 3), nullptr) << "remote backlog below threshold";
+
+    ASSERT_TRUE(pool.Shed(2, work::MakeErg([&] { ran[2]++; })));
+    while (work::Erg* t = pool.Pull(0, victims, 2, 1, 3)) work::RunErg(t);
+    EXPECT_EQ(ran[2], 1) << "remote stealing stops again once the backlog drops below threshold";
+
+    while (work::Erg* t = pool.Pull(2)) work::RunErg(t);
+    EXPECT_EQ(ran[2], 3);
+}
+
 // Clustered seed (all work shed to shard 0) must be drained by ALL workers via stealing, with every
 // task run exactly once. This is the balancing the substrate exists for, at the mechanism level.
 //
@@ -143,3 +173,56 @@ TEST(WorkPoolTest, ReusableErgReshedSingleOwner)
                                          << " did not run every stage exactly once";
     }
 }
+
+// A shedding burst past the 8192-entry deque spills to the shard's overflow list instead of being
+// refused, and every item still comes back exactly once: locally (the owner refills from the spill
+// as it drains) and through thieves stealing what each refill exposes.
+//
+TEST(WorkPoolTest, OverflowSpillsPastCapacity)
+{
+    const int M = 4, N = 20000;
+
+    {
+        work::detail::Shards<int*> pool;
+        pool.Init(1);
+        std::vector<int> items(N);
+        for (int i = 0; i < N; i++) ASSERT_TRUE(pool.Shed(0, &items[i]));
+        EXPECT_EQ(pool.Spilled(0), (size_t)(N - 8192));
+        int pulled = 0;
+        while (int* t = pool.Pull(0)) { ++*t; pulled++; }
+        EXPECT_EQ(pulled, N);
+        EXPECT_EQ(pool.Spilled(0), 0u);
+        for (int i = 0; i < N; i++) ASSERT_EQ(items[i], 1) << "item " << i;
+    }
+
+    for (int rep = 0; rep < 5; rep++)
+    {
+        work::detail::Shards<work::Erg*> pool;
+        pool.Init(M);
+        std::vector<std::atomic<int>> ran(N);
+        for (int i = 0; i < N; i++) ran[i].store(0, std::memory_order_relaxed);
+        std::atomic<int> remaining{N};
+
+        std::vector<std::thread> workers;
+        for (int w = 0; w < M; w++)
+            workers.emplace_back([&, w] {
+                if (w == 0)
+                {
+                    // Thieves are already pulling while shard 0 fills, spills and refills
+                    //
+                    for (int i = 0; i < N; i++)
+                    {
+                        ASSERT_TRUE(pool.Shed(0, work::MakeErg([&ran, i] { ran[i].fetch_add(1, std::memory_order_relaxed); })));
+                    }
+                }
+                while (remaining.load(std::memory_order_acquire) > 0)
+                {
+                    if (work::Erg* t = pool.Pull(w)) { work::RunErg(t); remaining.fetch_sub(1, std::memory_order_acq_rel); }
+                }
+            });
+        for (auto& t : workers) t.join();
+
+        for (int i = 0; i < N; i++)
+            ASSERT_EQ(ran[i].load(std::memory_order_relaxed), 1) << "rep " << rep << " task " << i;
+    }
+}
@@ -1,7 +1,12 @@
+#include <algorithm>
+#include <arpa/inet.h>
 #include <cerrno>
 #include <cstring>
+#include <netinet/in.h>
 #include <sys/socket.h>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -14,7 +19,11 @@
 #include "coop/http/connection.h"
 #include "coop/http/transport.h"
 #include "coop/ws/types.h"
+#include "coop/ws/broadcast.h"
+#include "coop/ws/client.h"
 #include "coop/ws/connection.h"
+#include "coop/ws/deflate.h"
+#include "coop/ws/mask.h"
 #include "coop/ws/upgrade.h"
 #include "coop/ws/sha1.h"
 
@@ -610,3 +619,579 @@ TEST(WsTest, MediumPayload)
         EXPECT_EQ(received, payload);
     });
 }
+
+TEST(WsTest, UnmaskMatchesScalar)
+{
+    // Every length either side of the 8, 16 and 64 byte strides, at every start alignment and key
+    // phase, and a payload unmasked in uneven chunks must match one pass
+    //
+    const uint8_t key[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+    char expected[200];
+    char actual[200];
+    for (size_t len = 0; len <= 150; len++)
+    {
+        for (size_t start = 0; start < 4; start++)
+        {
+            for (size_t offset = 0; offset < 4; offset++)
+            {
+                for (size_t i = 0; i < sizeof(expected); i++)
+                {
+                    expected[i] = actual[i] = static_cast<char>(i * 7 + 3);
+                }
+                size_t want = coop::ws::detail::UnmaskScalar(expected + start, len, key, offset);
+                size_t got = coop::ws::detail::Unmask(actual + start, len, key, offset);
+                ASSERT_EQ(got, want);
+                ASSERT_EQ(memcmp(expected, actual, sizeof(expected)), 0)
+                    << "len=" << len << " start=" << start << " offset=" << offset;
+            }
+        }
+    }
+
+    char chunked[1000];
+    char whole[1000];
+    for (size_t i = 0; i < sizeof(whole); i++)
+    {
+        chunked[i] = whole[i] = static_cast<char>(i);
+    }
+    coop::ws::detail::UnmaskScalar(whole, sizeof(whole), key, 0);
+    size_t at = 0;
+    size_t offset = 0;
+    for (size_t step = 1; at < sizeof(chunked); step = step * 3 + 1)
+    {
+        size_t n = std::min(step, sizeof(chunked) - at);
+        offset = coop::ws::detail::Unmask(chunked + at, n, key, offset);
+        at += n;
+    }
+    EXPECT_EQ(memcmp(chunked, whole, sizeof(whole)), 0);
+}
+
+// -------------------------------------------------------------------------------------
+// permessage-deflate — negotiated in the upgrade, compressed both ways
+// -------------------------------------------------------------------------------------
+
+TEST(WsTest, PermessageDeflate)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        SendString(client,
+            "GET /ws HTTP/1.1\r\n"
+            "Host: localhost\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "Sec-WebSocket-Extensions: x-webkit-deflate-frame, "
+            "permessage-deflate; client_max_window_bits\r\n"
+            "\r\n");
+
+        coop::http::PlaintextTransport httpTransport(server);
+        auto httpConn = ctx->Allocate<HttpConn>(HTTP_EXTRA,
+            httpTransport, ctx, ctx->GetCooperator());
+        httpConn->GetRequestLine();
+
+        coop::ws::DeflateOptions options;
+        options.serverNoContextTakeover = true;
+        coop::ws::DeflateParams params;
+        ASSERT_TRUE(coop::ws::Upgrade(*httpConn, options, &params));
+        EXPECT_TRUE(params.enabled);
+
+        std::string response = RecvAll(client);
+        EXPECT_NE(response.find("Sec-WebSocket-Extensions: permessage-deflate; "
+                                "server_no_context_takeover; client_max_window_bits=15\r\n"),
+                  std::string::npos);
+
+        coop::http::PlaintextTransport wsTransport(server);
+        auto ws = ctx->Allocate<WsConn>(WS_EXTRA,
+            wsTransport, ctx,
+            WsConn::DEFAULT_RECV_BUFFER_SIZE,
+            WsConn::DEFAULT_SEND_BUFFER_SIZE,
+            std::chrono::seconds(5),
+            httpConn->LeftoverData(), httpConn->LeftoverSize());
+        ws->EnableDeflate(params, options);
+
+        std::string json;
+        for (int i = 0; i < 2000; i++)
+        {
+            json += "{\"sym\":\"ABC\",\"px\":" + std::to_string(i % 17) + "},";
+        }
+
+        // Client to server: compressed with RSV1 on the frame, inflated on delivery
+        //
+        coop::ws::detail::MessageDeflater clientDeflater;
+        clientDeflater.Configure(15, 5, 8, false);
+        std::string compressed;
+        ASSERT_TRUE(clientDeflater.Compress(json.data(), json.size(), &compressed));
+        ASSERT_LT(compressed.size(), json.size());
+
+        uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+        auto frame = BuildWsFrame(coop::ws::Opcode::Text, true,
+                                  compressed.data(), compressed.size(), mask);
+        frame[0] = static_cast<char>(frame[0] | 0x40);
+        SendBytes(client, frame.data(), frame.size());
+
+        std::string received;
+        while (true)
+        {
+            auto* f = ws->NextFrame();
+            ASSERT_NE(f, nullptr);
+            EXPECT_TRUE(f->IsText());
+            received.append(static_cast<const char*>(f->data), f->size);
+            if (f->complete) break;
+        }
+        EXPECT_EQ(received, json);
+
+        // Server to client: large messages compress, small ones go as they are
+        //
+        EXPECT_TRUE(ws->SendText(json.data(), json.size()));
+        std::string raw = RecvAll(client);
+        ASSERT_GE(raw.size(), 2u);
+        EXPECT_TRUE(static_cast<uint8_t>(raw[0]) & 0x40);
+        auto parsed = ParseServerFrame(raw);
+        ASSERT_TRUE(parsed.valid);
+        EXPECT_LT(parsed.payload.size(), json.size());
+
+        coop::ws::detail::MessageInflater clientInflater;
+        clientInflater.Configure(15, false);
+        std::string inflated;
+        ASSERT_EQ(clientInflater.Inflate(parsed.payload.data(), parsed.payload.size(), true,
+                                         &inflated, json.size()), 0);
+        EXPECT_EQ(inflated, json);
+
+        EXPECT_TRUE(ws->SendText("hi", 2));
+        raw = RecvAll(client);
+        ASSERT_GE(raw.size(), 2u);
+        EXPECT_FALSE(static_cast<uint8_t>(raw[0]) & 0x40);
+        EXPECT_EQ(ParseServerFrame(raw).payload, "hi");
+    });
+}
+
+TEST(WsTest, DeflateNegotiation)
+{
+    coop::ws::DeflateOptions options;
+    coop::ws::DeflateParams params;
+
+    // An offer capping our window at 8 bits cannot be met; the fallback offer is taken
+    //
+    EXPECT_TRUE(coop::ws::NegotiateDeflate(
+        "permessage-deflate; server_max_window_bits=8, "
+        "permessage-deflate; server_max_window_bits=\"10\"", options, &params));
+    EXPECT_EQ(params.serverMaxWindowBits, 10);
+    EXPECT_EQ(coop::ws::DeflateResponse(params), "permessage-deflate; server_max_window_bits=10");
+
+    // Unknown or repeated parameters void an offer
+    //
+    EXPECT_FALSE(coop::ws::NegotiateDeflate("permessage-deflate; foo", options, &params));
+    EXPECT_FALSE(coop::ws::NegotiateDeflate(
+        "permessage-deflate; client_no_context_takeover; client_no_context_takeover",
+        options, &params));
+    EXPECT_FALSE(coop::ws::NegotiateDeflate("x-webkit-deflate-frame", options, &params));
+
+    options.clientNoContextTakeover = true;
+    options.clientMaxWindowBits = 12;
+    EXPECT_TRUE(coop::ws::NegotiateDeflate(
+        "permessage-deflate; client_max_window_bits=14", options, &params));
+    EXPECT_EQ(coop::ws::DeflateResponse(params),
+              "permessage-deflate; client_no_context_takeover; client_max_window_bits=12");
+}
+
+// -------------------------------------------------------------------------------------
+// Broadcast — one encoding per message, queued per subscriber under its policy
+// -------------------------------------------------------------------------------------
+
+namespace
+{
+
+// Split a server byte stream into its frames (unmasked, so the header is all there is to skip)
+//
+std::vector<ParsedFrame> ParseServerFrames(const std::string& raw)
+{
+    std::vector<ParsedFrame> frames;
+    size_t offset = 0;
+    while (offset < raw.size())
+    {
+        auto f = ParseServerFrame(raw, offset);
+        if (!f.valid) break;
+        size_t len = f.payload.size();
+        offset += 2 + (len > 65535 ? 8 : len > 125 ? 2 : 0) + len;
+        frames.push_back(std::move(f));
+    }
+    return frames;
+}
+
+} // end anonymous namespace
+
+TEST(WsTest, BroadcastFanOut)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp0, sp1, sp2;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client0(sp0.fds[0], uring);
+        coop::io::Descriptor server0(sp0.fds[1], uring);
+        coop::io::Descriptor client1(sp1.fds[0], uring);
+        coop::io::Descriptor server1(sp1.fds[1], uring);
+        coop::io::Descriptor client2(sp2.fds[0], uring);
+        coop::io::Descriptor server2(sp2.fds[1], uring);
+
+        coop::http::PlaintextTransport t0(server0), t1(server1), t2(server2);
+        auto ws0 = ctx->Allocate<WsConn>(WS_EXTRA, t0, ctx);
+        auto ws1 = ctx->Allocate<WsConn>(WS_EXTRA, t1, ctx);
+        auto ws2 = ctx->Allocate<WsConn>(WS_EXTRA, t2, ctx);
+        coop::ws::DeflateParams params;
+        params.enabled = true;
+        ws2->EnableDeflate(params);
+
+        coop::ws::SubscriberOptions conflate;
+        conflate.policy = coop::ws::SlowConsumer::Conflate;
+        conflate.maxFrames = 2;
+
+        coop::ws::Broadcast broadcast;
+        coop::ws::Subscriber sub0(ctx, *ws0);
+        coop::ws::Subscriber sub1(ctx, *ws1, conflate);
+        coop::ws::Subscriber sub2(ctx, *ws2);
+        broadcast.Subscribe(&sub0);
+        broadcast.Subscribe(&sub1);
+        broadcast.Subscribe(&sub2);
+        EXPECT_EQ(broadcast.Subscribers(), 3u);
+
+        // No writer runs yet. The conflating subscriber replaces a1 with a2 in place, then
+        // loses it as the oldest when c arrives at a full queue.
+        //
+        EXPECT_EQ(broadcast.PublishText("a1", 2, 1), 3u);
+        EXPECT_EQ(broadcast.PublishText("b1", 2, 2), 3u);
+        EXPECT_EQ(broadcast.PublishText("a2", 2, 1), 3u);
+        EXPECT_EQ(broadcast.PublishBinary("c", 1), 3u);
+        EXPECT_EQ(sub0.Queued(), 4u);
+        EXPECT_EQ(sub1.Queued(), 2u);
+        EXPECT_EQ(sub1.Dropped(), 2u);
+
+        std::string json;
+        for (int i = 0; i < 200; i++)
+        {
+            json += "{\"sym\":\"ABC\",\"px\":" + std::to_string(i % 17) + "},";
+        }
+        broadcast.Unsubscribe(&sub1);
+        EXPECT_EQ(broadcast.PublishText(json.data(), json.size()), 2u);
+        EXPECT_TRUE(sub2.SendControl(coop::ws::Opcode::Pong, "p", 1));
+
+        int results[3] = {1, 1, 1};
+        coop::ws::Subscriber* subs[3] = {&sub0, &sub1, &sub2};
+        for (int i = 0; i < 3; i++)
+        {
+            ctx->GetCooperator()->Spawn([&, i](coop::Context* writer)
+            {
+                results[i] = subs[i]->Run(writer);
+            });
+            subs[i]->Stop();
+        }
+
+        auto frames = ParseServerFrames(RecvAll(client0));
+        ASSERT_EQ(frames.size(), 5u);
+        EXPECT_EQ(frames[0].payload, "a1");
+        EXPECT_EQ(frames[2].payload, "a2");
+        EXPECT_EQ(frames[3].opcode, coop::ws::Opcode::Binary);
+        EXPECT_EQ(frames[4].payload, json);
+
+        frames = ParseServerFrames(RecvAll(client1));
+        ASSERT_EQ(frames.size(), 2u);
+        EXPECT_EQ(frames[0].payload, "b1");
+        EXPECT_EQ(frames[1].payload, "c");
+
+        // The deflate subscriber gets the control frame first and the shared compressed form,
+        // which inflates from an empty window
+        //
+        std::string raw = RecvAll(client2);
+        frames = ParseServerFrames(raw);
+        ASSERT_EQ(frames.size(), 6u);
+        EXPECT_EQ(frames[0].opcode, coop::ws::Opcode::Pong);
+        EXPECT_EQ(frames[1].payload, "a1");
+        EXPECT_LT(frames[5].payload.size(), json.size());
+        size_t header = frames[5].payload.size() > 125 ? 4 : 2;
+        EXPECT_TRUE(static_cast<uint8_t>(raw[raw.size() - frames[5].payload.size() - header])
+                    & 0x40);
+
+        coop::ws::detail::MessageInflater inflater;
+        inflater.Configure(15, false);
+        std::string inflated;
+        ASSERT_EQ(inflater.Inflate(frames[5].payload.data(), frames[5].payload.size(), true,
+                                   &inflated, json.size()), 0);
+        EXPECT_EQ(inflated, json);
+
+        while (results[0] == 1 || results[1] == 1 || results[2] == 1)
+        {
+            ctx->Yield();
+        }
+        EXPECT_EQ(results[0], 0);
+        EXPECT_EQ(results[1], 0);
+        EXPECT_EQ(results[2], 0);
+    });
+}
+
+TEST(WsTest, BroadcastSlowConsumer)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp0, sp1;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client0(sp0.fds[0], uring);
+        coop::io::Descriptor server0(sp0.fds[1], uring);
+        coop::io::Descriptor client1(sp1.fds[0], uring);
+        coop::io::Descriptor server1(sp1.fds[1], uring);
+
+        coop::http::PlaintextTransport t0(server0), t1(server1);
+        auto ws0 = ctx->Allocate<WsConn>(WS_EXTRA, t0, ctx);
+        auto ws1 = ctx->Allocate<WsConn>(WS_EXTRA, t1, ctx);
+
+        coop::ws::SubscriberOptions drop;
+        drop.maxBytes = 8;
+        coop::ws::SubscriberOptions disconnect;
+        disconnect.policy = coop::ws::SlowConsumer::Disconnect;
+        disconnect.maxFrames = 1;
+
+        coop::ws::Broadcast broadcast;
+        coop::ws::Subscriber sub0(ctx, *ws0, drop);
+        coop::ws::Subscriber sub1(ctx, *ws1, disconnect);
+        broadcast.Subscribe(&sub0);
+        broadcast.Subscribe(&sub1);
+
+        EXPECT_EQ(broadcast.PublishText("one", 3), 2u);
+        EXPECT_EQ(broadcast.PublishText("two", 3), 0u);
+        EXPECT_EQ(sub0.Dropped(), 1u);
+        EXPECT_EQ(sub1.Queued(), 0u);
+
+        int results[2] = {1, 1};
+        ctx->GetCooperator()->Spawn([&](coop::Context* writer) { results[0] = sub0.Run(writer); });
+        ctx->GetCooperator()->Spawn([&](coop::Context* writer) { results[1] = sub1.Run(writer); });
+        sub0.Stop();
+
+        auto frames = ParseServerFrames(RecvAll(client0));
+        ASSERT_EQ(frames.size(), 1u);
+        EXPECT_EQ(frames[0].payload, "one");
+
+        // The overflowed subscriber sends nothing but a 1008 close
+        //
+        frames = ParseServerFrames(RecvAll(client1));
+        ASSERT_EQ(frames.size(), 1u);
+        EXPECT_EQ(frames[0].opcode, coop::ws::Opcode::Close);
+        EXPECT_EQ(frames[0].payload, std::string("\x03\xf0", 2));
+
+        while (results[0] == 1 || results[1] == 1)
+        {
+            ctx->Yield();
+        }
+        EXPECT_EQ(results[0], 0);
+        EXPECT_EQ(results[1], -ENOBUFS);
+    });
+}
+
+// -------------------------------------------------------------------------------------
+// Message mode: fragments joined, control frames in between, whole frames as views
+// -------------------------------------------------------------------------------------
+
+TEST(WsTest, NextMessageAssemblesFragments)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor client(sp.fds[0], uring);
+        coop::io::Descriptor server(sp.fds[1], uring);
+
+        coop::http::PlaintextTransport wsTransport(server);
+        auto ws = ctx->Allocate<WsConn>(WS_EXTRA, wsTransport, ctx);
+
+        uint8_t mask[4] = {0x11, 0x22, 0x33, 0x44};
+        auto send = [&](coop::ws::Opcode opcode, bool fin, std::string const& payload)
+        {
+            auto frame = BuildWsFrame(opcode, fin, payload.data(), payload.size(), mask);
+            SendBytes(client, frame.data(), frame.size());
+        };
+
+        // A ping between the fragments comes out first, the message whole after it
+        //
+        send(coop::ws::Opcode::Text, false, "hello, ");
+        send(coop::ws::Opcode::Ping, true, "p");
+        send(coop::ws::Opcode::Continuation, true, "world");
+
+        auto* msg = ws->NextMessage();
+        ASSERT_NE(msg, nullptr);
+        EXPECT_TRUE(msg->IsPing());
+        EXPECT_EQ(msg->View(), "p");
+        msg = ws->NextMessage();
+        ASSERT_NE(msg, nullptr);
+        EXPECT_TRUE(msg->IsText());
+        EXPECT_EQ(msg->View(), "hello, world");
+
+        // One frame that fits is read whole and viewed in the recv buffer, however it arrives
+        //
+        std::string binary(3000, 'b');
+        auto frame = BuildWsFrame(coop::ws::Opcode::Binary, true, binary.data(), binary.size(),
+                                  mask);
+        SendBytes(client, frame.data(), 1000);
+        ctx->GetCooperator()->Spawn([&](coop::Context*)
+        {
+            SendBytes(client, frame.data() + 1000, frame.size() - 1000);
+        });
+        msg = ws->NextMessage();
+        ASSERT_NE(msg, nullptr);
+        EXPECT_TRUE(msg->IsBinary());
+        EXPECT_EQ(msg->View(), binary);
+        auto* base = reinterpret_cast<const char*>(ws.get());
+        auto* data = static_cast<const char*>(msg->data);
+        EXPECT_TRUE(data > base && data < base + sizeof(WsConn) + WS_EXTRA);
+
+        // One longer than the recv buffer is assembled
+        //
+        std::string big(10000, 'x');
+        for (size_t i = 0; i < big.size(); i++) big[i] = static_cast<char>('a' + i % 26);
+        frame = BuildWsFrame(coop::ws::Opcode::Text, true, big.data(), big.size(), mask);
+        ctx->GetCooperator()->Spawn([&](coop::Context*)
+        {
+            SendBytes(client, frame.data(), frame.size());
+        });
+        msg = ws->NextMessage();
+        ASSERT_NE(msg, nullptr);
+        EXPECT_EQ(msg->View(), big);
+
+        // Past the limit the connection closes with 1009
+        //
+        ws->SetMaxMessageSize(2000);
+        send(coop::ws::Opcode::Binary, false, std::string(1500, 'c'));
+        send(coop::ws::Opcode::Continuation, true, std::string(1500, 'd'));
+        EXPECT_EQ(ws->NextMessage(), nullptr);
+        auto close = ParseServerFrame(RecvAll(client));
+        ASSERT_TRUE(close.valid);
+        EXPECT_EQ(close.opcode, coop::ws::Opcode::Close);
+        EXPECT_EQ(close.payload, std::string("\x03\xf1", 2));
+    });
+}
+
+// -------------------------------------------------------------------------------------
+// Client role: masked frames out, and the handshake against a plain socket server
+// -------------------------------------------------------------------------------------
+
+TEST(WsTest, ClientMasksFrames)
+{
+    test::RunInCooperator([](coop::Context* ctx)
+    {
+        SocketPair sp;
+        auto* uring = coop::GetUring();
+        coop::io::Descriptor peer(sp.fds[0], uring);
+        coop::io::Descriptor local(sp.fds[1], uring);
+
+        coop::http::PlaintextTransport wsTransport(local);
+        auto ws = ctx->Allocate<WsConn>(WS_EXTRA, wsTransport, ctx);
+        ws->SetClient();
+
+        // Bigger than the send buffer: the key runs on across flushes
+        //
+        std::string payload(1500, '\0');
+        for (size_t i = 0; i < payload.size(); i++) payload[i] = static_cast<char>(i * 7);
+        ASSERT_TRUE(ws->SendBinary(payload.data(), payload.size()));
+        ASSERT_TRUE(ws->SendText("hi", 2));
+
+        std::string raw = RecvAll(peer);
+        ASSERT_GE(raw.size(), 8u);
+        EXPECT_EQ(static_cast<uint8_t>(raw[0]), 0x82);
+        EXPECT_EQ(static_cast<uint8_t>(raw[1]), 0x80 | 126);
+        uint8_t key[4];
+        memcpy(key, raw.data() + 4, 4);
+        std::string unmasked = raw.substr(8, payload.size());
+        coop::ws::detail::UnmaskScalar(unmasked.data(), unmasked.size(), key, 0);
+        EXPECT_EQ(unmasked, payload);
+
+        size_t next = 8 + payload.size();
+        ASSERT_EQ(raw.size(), next + 8);
+        EXPECT_EQ(static_cast<uint8_t>(raw[next + 1]), 0x80 | 2);
+        uint8_t key2[4];
+        memcpy(key2, raw.data() + next + 2, 4);
+        EXPECT_NE(memcmp(key, key2, 4), 0);
+        std::string hi = raw.substr(next + 6, 2);
+        coop::ws::detail::UnmaskScalar(hi.data(), hi.size(), key2, 0);
+        EXPECT_EQ(hi, "hi");
+    });
+}
+
+TEST(WsTest, ClientConnects)
+{
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(bind(listenFd, (sockaddr*)&addr, sizeof(addr)), 0);
+    listen(listenFd, 1);
+    getsockname(listenFd, (sockaddr*)&addr, &len);
+    int port = ntohs(addr.sin_port);
+
+    // Accepts the upgrade with a frame already behind the 101, then echoes one masked frame
+    // back unmasked
+    //
+    std::string request;
+    std::string echoed;
+    std::thread peer([&]
+    {
+        int fd = accept(listenFd, nullptr, nullptr);
+        char buf[4096];
+        ssize_t n;
+        while (request.find("\r\n\r\n") == std::string::npos &&
+               (n = ::read(fd, buf, sizeof(buf))) > 0)
+        {
+            request.append(buf, static_cast<size_t>(n));
+        }
+        size_t at = request.find("Sec-WebSocket-Key: ") + 19;
+        std::string key = request.substr(at, request.find("\r\n", at) - at);
+        char accept[32];
+        coop::ws::detail::ComputeAcceptKey(key.data(), key.size(), accept);
+        std::string response = std::string(
+            "HTTP/1.1 101 Switching Protocols\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Accept: ") + accept + "\r\n\r\n" + "\x81\x07welcome";
+        std::ignore = ::write(fd, response.data(), response.size());
+
+        std::string frame;
+        while (frame.size() < 6 ||
+               frame.size() < 6 + static_cast<size_t>(static_cast<uint8_t>(frame[1]) & 0x7f))
+        {
+            if ((n = ::read(fd, buf, sizeof(buf))) <= 0) break;
+            frame.append(buf, static_cast<size_t>(n));
+        }
+        if (frame.size() >= 6 && (static_cast<uint8_t>(frame[1]) & 0x80))
+        {
+            echoed = frame.substr(6);
+            for (size_t i = 0; i < echoed.size(); i++) echoed[i] ^= frame[2 + i % 4];
+            std::string reply = std::string("\x81") + static_cast<char>(echoed.size()) + echoed;
+            std::ignore = ::write(fd, reply.data(), reply.size());
+        }
+        while (::read(fd, buf, sizeof(buf)) > 0) {}
+        close(fd);
+    });
+
+    test::RunInCooperator([&](coop::Context*)
+    {
+        coop::ws::Client client;
+        ASSERT_TRUE(client.Connect("127.0.0.1", port, "/feed?x=1"));
+
+        auto* msg = client->NextMessage();
+        ASSERT_NE(msg, nullptr);
+        EXPECT_EQ(msg->View(), "welcome");
+
+        ASSERT_TRUE(client->SendText("echo me", 7));
+        msg = client->NextMessage();
+        ASSERT_NE(msg, nullptr);
+        EXPECT_EQ(msg->View(), "echo me");
+        client.Reset();
+    });
+    peer.join();
+    close(listenFd);
+
+    EXPECT_EQ(request.compare(0, 23, "GET /feed?x=1 HTTP/1.1\r"), 0);
+    EXPECT_NE(request.find("Host: 127.0.0.1:" + std::to_string(port) + "\r\n"), std::string::npos);
+    EXPECT_EQ(echoed, "echo me");
+}